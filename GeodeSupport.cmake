@@ -104,6 +104,14 @@ macro(ADD_GEODE_MODULE _name)
         -fPIC
     )
 
+    if (OPENMP_FOUND)
+      target_compile_options(
+        ${_name}
+        PUBLIC
+          ${OpenMP_CXX_FLAGS}
+      )
+    endif()
+
     CHECK_CXX_COMPILER_FLAG(-Wno-undefined-var-template COMPILER_CHECKS_UNDEFINED_VAR_TEMPLATE)
     if (COMPILER_CHECKS_UNDEFINED_VAR_TEMPLATE)
       target_compile_options(
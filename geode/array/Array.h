@@ -247,8 +247,7 @@ public:
     if (max_size_<source_m)
       grow_buffer(source_m);
     if (!same_array(*this,source))
-      for (int i=0;i<source_m;i++)
-        data_[i] = source[i];
+      elementwise(RawArray<T>(source_m,data_),source,ElementwiseAssign());
     m_ = source_m;
   }
 
@@ -258,8 +257,7 @@ public:
     const int source_m = source.size();
     assert(m_==source_m);
     if (!same_array(*this,source))
-      for (int i=0;i<source_m;i++)
-        data_[i] = source[i];
+      elementwise(raw(),source,ElementwiseAssign());
   }
 
 private:
@@ -274,11 +272,19 @@ private:
     data_ = (T*)new_owner->data;
     owner_ = (PyObject*)new_owner;
   }
+
+  // Grow geometrically, stopping at the int limit on sizes.  Sizes which overflowed past INT_MAX arrive here
+  // negative, since preallocate compares unsigned.
+  void grow_to_fit(const int m_new) {
+    if (m_new<0)
+      throw ValueError("Array: size exceeds the limit of 2^31-1 elements");
+    grow_buffer(int(geode::min(geode::max(4*int64_t(max_size_)/3+2,int64_t(m_new)),int64_t(INT_MAX))));
+  }
 public:
 
   void preallocate(const int m_new) GEODE_ALWAYS_INLINE {
-    if(max_size_<m_new)
-      grow_buffer(geode::max(4*max_size_/3+2,m_new));
+    if (unsigned(max_size_)<unsigned(m_new))
+      grow_to_fit(m_new);
   }
 
   void resize(const int m_new) {
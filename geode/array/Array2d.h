@@ -39,15 +39,15 @@ public:
 
   Array(const int m, const int n)
     : Base((assert(m>=0 && n>=0),
-            m*n)), m(m), n(n) {}
+            flat_size(vec(m,n)))), m(m), n(n) {}
 
   Array(const int m, const int n, Uninit)
     : Base((assert(m>=0 && n>=0),
-            m*n),uninit), m(m), n(n) {}
+            flat_size(vec(m,n))),uninit), m(m), n(n) {}
 
   Array(const int m, const int n, T* data, PyObject* owner)
     : Base((assert(m>=0 && n>=0),
-            Array<T>(m*n,data,owner)))
+            Array<T>(flat_size(vec(m,n)),data,owner)))
     , m(m), n(n) {}
 
   Array(const Vector<int,d> sizes)
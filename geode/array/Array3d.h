@@ -39,15 +39,15 @@ public:
 
   Array(const int m, const int n, const int mn)
     : Base((assert(m>=0 && n>=0 && mn>=0),
-            m*n*mn)),m(m),n(n),mn(mn) {}
+            flat_size(vec(m,n,mn)))),m(m),n(n),mn(mn) {}
 
   Array(const int m, const int n, const int mn, Uninit)
     : Base((assert(m>=0 && n>=0 && mn>=0),
-            m*n*mn),uninit),m(m),n(n),mn(mn) {}
+            flat_size(vec(m,n,mn))),uninit),m(m),n(n),mn(mn) {}
 
   Array(const int m, const int n, const int mn, T* data, PyObject* owner)
     : Base((assert(m>=0 && n>=0 && mn>=0),
-            m*n*mn),data,owner), m(m), n(n), mn(mn) {}
+            flat_size(vec(m,n,mn))),data,owner), m(m), n(n), mn(mn) {}
 
   Array(const Vector<int,d> sizes)
     : Array(sizes.x,sizes.y,sizes.z) {}
@@ -37,17 +37,17 @@ public:
 
   Array(const Vector<int,d> shape)
     : Base((assert(shape.min()>=0),
-            shape.x*shape.y*shape.z*shape.w))
+            flat_size(shape)))
     , shape(shape) {}
 
   Array(const Vector<int,d> shape, Uninit)
     : Base((assert(shape.min()>=0),
-            shape.x*shape.y*shape.z*shape.w),uninit)
+            flat_size(shape)),uninit)
     , shape(shape) {}
 
   Array(const Vector<int,d> shape, T* data, PyObject* owner)
     : Base((assert(shape.min()>=0),
-            shape.product()),data,owner)
+            flat_size(shape)),data,owner)
     , shape(shape) {}
 
   Array(const Array& source)
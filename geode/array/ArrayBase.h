@@ -11,6 +11,7 @@
 #include <geode/array/ArrayPlusScalar.h>
 #include <geode/array/ArrayProduct.h>
 #include <geode/array/ArraySum.h>
+#include <geode/array/evaluate.h>
 #include <geode/structure/forward.h>
 #include <geode/math/hash.h>
 #include <geode/math/max.h>
@@ -154,10 +155,7 @@ public:
   template<class T1,class TArray1> const TArray& operator+=(const ArrayBase<T1,TArray1>& v) const {
     STATIC_ASSERT_SAME(T,typename TArray1::Element);
     const TArray& self = derived();
-    int m = self.size();
-    const TArray1& v_ = v.derived();
-    assert(m==v_.size());
-    for (int i=0;i<m;i++) self[i] += v_[i];
+    elementwise(self,v.derived(),ElementwiseAdd());
     return self;
   }
 
@@ -178,10 +176,7 @@ public:
   template<class T1,class TArray1> const TArray& operator-=(const ArrayBase<T1,TArray1>& v) const {
     STATIC_ASSERT_SAME(T,typename TArray1::Element);
     const TArray& self = derived();
-    int m = self.size();
-    const TArray1& v_ = v.derived();
-    assert(m==v_.size());
-    for (int i=0;i<m;i++) self[i] -= v_[i];
+    elementwise(self,v.derived(),ElementwiseSubtract());
     return self;
   }
 
@@ -194,10 +189,7 @@ public:
 
   template<class T2,class TArrayT2> const TArray& operator*=(const ArrayBase<T2,TArrayT2>& v) const {
     const TArray& self = derived();
-    int m = self.size();
-    const TArrayT2& v_ = v.derived();
-    assert(m==v_.size());
-    for (int i=0;i<m;i++) self[i] *= v_[i];
+    elementwise(self,v.derived(),ElementwiseMultiply());
     return self;
   }
 
@@ -209,13 +201,7 @@ public:
 
   template<class T2,class TArrayT2> const TArray& operator/=(const ArrayBase<T2,TArrayT2>& a) const {
     const TArray& self = derived();
-    int m = self.size();
-    const TArrayT2& a_ = a.derived();
-    assert(m==a_.size());
-    for (int i=0;i<m;i++) {
-      assert(a_(i));
-      self[i] /= a_[i];
-    }
+    elementwise(self,a.derived(),ElementwiseDivide());
     return self;
   }
 
@@ -8,6 +8,17 @@
 #include <geode/utility/type_traits.h>
 namespace geode {
 
+// Flat size of an array with the given shape.  Flat arrays are indexed by int, so throw if the product overflows.
+template<int d> static inline int flat_size(const Vector<int,d>& shape) {
+  int64_t size = 1;
+  for (int i=0;i<d;i++) {
+    size *= shape[i];
+    if (size>INT_MAX)
+      throw ValueError("Array: shape has more than 2^31-1 elements");
+  }
+  return int(size);
+}
+
 template<class T,class TArray>
 class ArrayNdBase {
 public:
@@ -0,0 +1,167 @@
+//#####################################################################
+// Class BrickedArray
+//#####################################################################
+//
+// A 3D array stored as contiguous 8x8x8 bricks, for stencils over large
+// volumes.  In Array<T,3> the neighbors of (i,j,k) along the slow axis are
+// a whole slice away, so a stencil sweeping a 1024^3 volume keeps three
+// slices of tens of megabytes live and misses cache on every i neighbor.
+// In a brick all 26 neighbors of an interior cell are within 4KB of
+// doubles, and a brick together with its six face neighbors fits in L1.
+//
+// Sizes are padded up to whole bricks; padding cells exist but aren't
+// valid().  Element (i,j,k) of brick (I,J,K) lives at flat offset
+// 512*((I*nb.y+J)*nb.z+K)+64*i+8*j+k, found with one small table per axis.
+// Each brick is exposed as a RawArray<T,3>, and apply_brick_stencil below
+// evaluates stencils brick by brick in parallel over BrickedArray or plain
+// Array<T,3> inputs.
+//
+// The tables cost a little on every access.  When three slices fit in
+// cache, a row major sweep is faster (by about 1.5x for a 7 point stencil
+// over 256^3 doubles), so bricks are for volumes whose slices don't.
+//
+//#####################################################################
+#pragma once
+
+#include <geode/array/Array3d.h>
+#include <geode/utility/parallel.h>
+namespace geode {
+
+template<class T> class BrickedArray {
+public:
+  typedef typename remove_const<T>::type Element;
+  static const int brick = 8, brick_bits = 3, brick_size = brick*brick*brick;
+
+  Vector<int,3> sizes_; // Logical sizes
+  Vector<int,3> nb; // Number of bricks along each axis
+  Vector<Array<const int>,3> offsets; // The flat index of (i,j,k) is offsets.x[i]+offsets.y[j]+offsets.z[k]
+  Array<T> flat; // All bricks, including padding
+
+  BrickedArray() {}
+
+  explicit BrickedArray(const Vector<int,3> sizes)
+    : BrickedArray(sizes,uninit) {
+    flat.fill(T());
+  }
+
+  BrickedArray(const Vector<int,3> sizes, Uninit)
+    : sizes_(sizes), nb((sizes+brick-1)/brick), flat(brick_size*nb.product(),uninit) {
+    GEODE_ASSERT(sizes.min()>=0);
+    const Vector<int,3> strides(brick_size*nb.y*nb.z,brick_size*nb.z,brick_size);
+    for (int a=0;a<3;a++) {
+      Array<int> o(sizes[a],uninit);
+      for (int i=0;i<sizes[a];i++)
+        o[i] = (i>>brick_bits)*strides[a]+((i&(brick-1))<<(2-a)*brick_bits);
+      offsets[a] = o;
+    }
+  }
+
+  // Copy a row major array into bricks, in parallel
+  explicit BrickedArray(RawArray<const Element,3> a)
+    : BrickedArray(a.sizes()) {
+    for_each_brick([&](const int b) {
+      const auto lo = brick_lo(b);
+      const auto x = this->brick_array(b);
+      const auto hi = Vector<int,3>::componentwise_min(sizes_,lo+brick)-lo;
+      for (int i=0;i<hi.x;i++)
+        for (int j=0;j<hi.y;j++)
+          for (int k=0;k<hi.z;k++)
+            x(i,j,k) = a(lo.x+i,lo.y+j,lo.z+k);
+    });
+  }
+
+  template<class S> BrickedArray(const BrickedArray<S>& source)
+    : sizes_(source.sizes_), nb(source.nb), offsets(source.offsets), flat(source.flat) {}
+
+  Vector<int,3> sizes() const {
+    return sizes_;
+  }
+
+  int bricks() const {
+    return nb.product();
+  }
+
+  bool valid(const Vector<int,3>& index) const {
+    return unsigned(index.x)<unsigned(sizes_.x) && unsigned(index.y)<unsigned(sizes_.y)
+        && unsigned(index.z)<unsigned(sizes_.z);
+  }
+
+  int flat_index(const Vector<int,3>& index) const {
+    assert(valid(index));
+    return offsets.x[index.x]+offsets.y[index.y]+offsets.z[index.z];
+  }
+
+  T& operator()(const Vector<int,3>& index) const {
+    return flat[flat_index(index)];
+  }
+
+  T& operator[](const Vector<int,3>& index) const {
+    return flat[flat_index(index)];
+  }
+
+  T& operator()(const int i, const int j, const int k) const {
+    assert(valid(vec(i,j,k)));
+    return flat[offsets.x[i]+offsets.y[j]+offsets.z[k]];
+  }
+
+  // The first cell of brick b
+  Vector<int,3> brick_lo(const int b) const {
+    assert(unsigned(b)<unsigned(bricks()));
+    return brick*vec(b/(nb.y*nb.z),b/nb.z%nb.y,b%nb.z);
+  }
+
+  // Brick b as a brick^3 row major array, including any padding
+  RawArray<T,3> brick_array(const int b) const {
+    return RawArray<T,3>(brick,brick,brick,flat.data()+brick_size*b);
+  }
+
+  // Call f(b) for each brick b, in parallel
+  template<class F> void for_each_brick(const F& f) const {
+    parallel_for(bricks(),f);
+  }
+
+  // Copy back to a row major array
+  Array<Element,3> array() const {
+    Array<Element,3> a(sizes_,uninit);
+    for_each_brick([&](const int b) {
+      const auto lo = brick_lo(b);
+      const auto x = this->brick_array(b);
+      const auto hi = Vector<int,3>::componentwise_min(sizes_,lo+brick)-lo;
+      for (int i=0;i<hi.x;i++)
+        for (int j=0;j<hi.y;j++)
+          for (int k=0;k<hi.z;k++)
+            a(lo.x+i,lo.y+j,lo.z+k) = x(i,j,k);
+    });
+    return a;
+  }
+};
+
+template<class T> const int BrickedArray<T>::brick;
+template<class T> const int BrickedArray<T>::brick_bits;
+template<class T> const int BrickedArray<T>::brick_size;
+
+// Set out(i) = f(a,i) for i in [lo,hi)
+template<class F,class TA,class TO> static void apply_brick_stencil_block(const F& f, const TA& a, const TO& out,
+                                                                          const Vector<int,3> lo, const Vector<int,3> hi) {
+  for (int i=lo.x;i<hi.x;i++)
+    for (int j=lo.y;j<hi.y;j++)
+      for (int k=lo.z;k<hi.z;k++)
+        out(i,j,k) = f(a,vec(i,j,k));
+}
+
+// Set out(i) = f(a,i) for every valid index i, visiting 8^3 bricks of the index space in parallel.  a and out may each
+// be a BrickedArray or a row major Array<T,3>, and must have the same sizes.  f follows the convention of
+// apply_stencil: it takes the whole input array and an index, checking a.valid before reading neighbors.  Unlike
+// apply_stencil this isn't in place, so out must not alias a.
+template<class F,class TA,class TO> void apply_brick_stencil(const F& f, const TA& a, const TO& out) {
+  const auto sizes = a.sizes();
+  GEODE_ASSERT(sizes==out.sizes());
+  const int B = BrickedArray<int>::brick;
+  const auto nb = (sizes+B-1)/B;
+  parallel_for(nb.product(),[&](const int b) {
+    const auto lo = B*vec(b/(nb.y*nb.z),b/nb.z%nb.y,b%nb.z);
+    apply_brick_stencil_block(f,a,out,lo,Vector<int,3>::componentwise_min(sizes,lo+B));
+  });
+}
+
+}
@@ -9,9 +9,13 @@ namespace geode {
 Array<int> nested_array_offsets(RawArray<const int> lengths) {
   Array<int> offsets(lengths.size()+1,uninit);
   offsets[0] = 0;
+  int64_t total = 0;
   for (int i=0;i<lengths.size();i++) {
     GEODE_ASSERT(lengths[i]>=0);
-    offsets[i+1] = offsets[i]+lengths[i];
+    total += lengths[i];
+    if (total>INT_MAX)
+      throw ValueError("Nested: total size exceeds the limit of 2^31-1 elements");
+    offsets[i+1] = int(total);
   }
   return offsets;
 }
@@ -88,8 +88,13 @@ public:
     const int n = (int)other.size();
     Array<int> offsets(n+1,uninit);
     offsets[0] = 0;
-    for (int i=0;i<n;i++)
-      offsets[i+1] = offsets[i]+(int)other[i].size();
+    int64_t total = 0;
+    for (int i=0;i<n;i++) {
+      total += other[i].size();
+      if (total>INT_MAX)
+        throw ValueError("Nested: total size exceeds the limit of 2^31-1 elements");
+      offsets[i+1] = int(total);
+    }
     Array<Element> flat(offsets[n],uninit);
     for (int i=0;i<n;i++)
       flat.slice(offsets[i],offsets[i+1]) = other[i];
@@ -0,0 +1,146 @@
+//#####################################################################
+// Class NestedBuilder
+//#####################################################################
+//
+// Incremental construction of Nested<T> without repeated copies.
+//
+// Appending to a Nested<T,false> grows flat by reallocation, so every
+// element is copied several times before the result is frozen.  NestedBuilder
+// has the same append interface, but stores elements in chunks of doubling
+// size which never move.  freeze() allocates the result once and copies each
+// element into it exactly once, or returns the only chunk directly.
+//
+// If the size of each subarray can be counted first, NestedFill avoids even
+// that copy: count every element, call allocate(), then write elements in
+// place in any order.  For independent subarrays computed in parallel, see
+// parallel_nested.h.
+//
+//#####################################################################
+#pragma once
+
+#include <geode/array/Nested.h>
+#include <vector>
+namespace geode {
+
+template<class T> class NestedBuilder {
+  typedef typename remove_const<T>::type Element;
+  Array<int> offsets;
+  std::vector<Array<Element>> chunks; // All but the last are full
+  int64_t total;
+public:
+
+  NestedBuilder()
+    : offsets(nested_array_offsets(RawArray<const int>()))
+    , total(0) {}
+
+  int size() const {
+    return offsets.size()-1;
+  }
+
+  int total_size() const {
+    return offsets.back();
+  }
+
+  // Start a new empty subarray
+  void append_empty() {
+    offsets.append(offsets.back());
+  }
+
+  // Append a single element to the last subarray
+  void append_to_back(const Element& element) {
+    assert(size());
+    room(1);
+    chunks.back().append_assuming_enough_space(element);
+    offsets.back()++;
+  }
+
+  // Extend the last subarray
+  template<class TA> void extend_back(const TA& elements) {
+    assert(size());
+    const int n = int(elements.size());
+    room(n);
+    auto& chunk = chunks.back();
+    const int start = chunk.size();
+    chunk.resize(start+n,uninit);
+    int i = start;
+    for (const auto& x : elements)
+      chunk[i++] = x;
+    offsets.back() += n;
+  }
+
+  // Append a complete subarray
+  template<class TA> void append(const TA& elements) {
+    append_empty();
+    extend_back(elements);
+  }
+
+  // Copy all elements, in order, into flat, which must have size total_size()
+  void write(RawArray<Element> flat) const {
+    assert(flat.size()==total_size());
+    int start = 0;
+    for (const auto& chunk : chunks) {
+      flat.slice(start,start+chunk.size()) = chunk;
+      start += chunk.size();
+    }
+  }
+
+  // The result may share memory with the builder, so stop appending once frozen
+  Nested<T> freeze() const {
+    if (chunks.size()==1)
+      return Nested<T>(offsets,chunks[0]);
+    Array<Element> flat(total_size(),uninit);
+    write(flat);
+    return Nested<T>(offsets,flat);
+  }
+
+private:
+  // Make room for n more elements in the last chunk, starting a new one if necessary.  A chunk as large as everything
+  // before it keeps the number of chunks logarithmic.
+  void room(const int n) {
+    if (total+n>INT_MAX)
+      throw ValueError("NestedBuilder: total size exceeds the limit of 2^31-1 elements");
+    total += n;
+    if (!chunks.empty()) {
+      auto& chunk = chunks.back();
+      if (chunk.max_size()-chunk.size()>=n)
+        return;
+    }
+    const int capacity = int(min(max(int64_t(n),max(total-n,int64_t(256))),int64_t(INT_MAX)));
+    chunks.push_back(Array<Element>());
+    chunks.back().preallocate(capacity);
+  }
+};
+
+template<class T> class NestedFill {
+  typedef typename remove_const<T>::type Element;
+  Array<int> counts; // Sizes while counting, then the next free slot of each subarray
+  Nested<Element> result;
+public:
+
+  explicit NestedFill(const int n)
+    : counts(n) {}
+
+  // Count k elements for subarray i
+  void count(const int i, const int k=1) {
+    counts[i] += k;
+  }
+
+  // Allocate the result once counting is complete
+  void allocate() {
+    result = Nested<Element>(counts,uninit);
+    counts = result.offsets.slice(0,counts.size()).copy();
+  }
+
+  // Store the next element of subarray i
+  void fill(const int i, const Element& x) {
+    assert(counts[i]<result.offsets[i+1]);
+    result.flat[counts[i]++] = x;
+  }
+
+  // The filled result.  Every counted slot must have been filled.
+  Nested<T> finish() const {
+    return result;
+  }
+};
+
+}
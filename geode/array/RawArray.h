@@ -83,7 +83,7 @@ public:
 
   template<class TArray> const RawArray& operator=(const TArray& source) const {
     assert(size()==(int)source.size());
-    for (int i=0;i<m;i++) data_[i] = source[i];
+    elementwise(*this,source,ElementwiseAssign());
     return *this;
   }
 
@@ -40,7 +40,7 @@ public:
   // Create an initialized (zeroed) untyped array
   template<class T> UntypedArray(Types<T> t, const int size)
     : UntypedArray(t,size,uninit) {
-    memset(data_,0,t_size_*m_);
+    memset(data_,0,size_t(t_size_)*m_);
   }
 
   // Create an uninitialized untyped array
@@ -55,6 +55,18 @@ public:
     owner_ = (PyObject*)buffer;
   }
 
+  // Share ownership of existing memory, such as a memory mapped file
+  UntypedArray(const type_info* type, const int t_size, const int size, char* data, PyObject* owner)
+    : m_(size)
+    , max_size_(size)
+    , data_(data)
+    , owner_(owner)
+    , t_size_(t_size)
+    , type_(type) {
+    assert(owner_ || !data_);
+    GEODE_XINCREF(owner_);
+  }
+
   // Share ownership with an untyped array
   UntypedArray(const UntypedArray& o)
     : m_(o.m_)
@@ -74,10 +86,10 @@ public:
     , max_size_(o.m_)
     , t_size_(o.t_size_)
     , type_(o.type_) {
-    const auto buffer = Buffer::new_<char>(m_*t_size_);
+    const auto buffer = Buffer::new_<char>(size_t(m_)*t_size_);
     data_ = buffer->data;
     owner_ = (PyObject*)buffer;
-    memcpy(data_,o.data_,m_*t_size_);
+    memcpy(data_,o.data_,size_t(m_)*t_size_);
   }
 
   // Share ownership with an input field
@@ -143,9 +155,9 @@ private:
   void grow_buffer(const int max_size_new, const bool copy_existing=true) {
     if (max_size_ >= max_size_new)
       return;
-    const auto new_owner = Buffer::new_<char>(max_size_new*t_size_);
+    const auto new_owner = Buffer::new_<char>(size_t(max_size_new)*t_size_);
     if (copy_existing)
-      memcpy(new_owner->data,data_,t_size_*m_);
+      memcpy(new_owner->data,data_,size_t(t_size_)*m_);
     GEODE_XDECREF(owner_);
     max_size_ = max_size_new;
     data_ = new_owner->data;
@@ -154,14 +166,17 @@ private:
 public:
 
   void preallocate(const int m_new, const bool copy_existing=true) GEODE_ALWAYS_INLINE {
-    if (max_size_ < m_new)
-      grow_buffer(geode::max(4*max_size_/3+2,m_new),copy_existing);
+    if (unsigned(max_size_) < unsigned(m_new)) {
+      if (m_new < 0)
+        throw ValueError("UntypedArray: size exceeds the limit of 2^31-1 elements");
+      grow_buffer(int(geode::min(geode::max(4*int64_t(max_size_)/3+2,int64_t(m_new)),int64_t(INT_MAX))),copy_existing);
+    }
   }
 
   void resize(const int m_new, const bool initialize_new=true, const bool copy_existing=true) {
     preallocate(m_new,copy_existing);
     if (initialize_new && m_new>m_)
-      memset(data_+m_*t_size_,0,(m_new-m_)*t_size_);
+      memset(data_+size_t(m_)*t_size_,0,size_t(m_new-m_)*t_size_);
     m_ = m_new;
   }
 
@@ -173,32 +188,32 @@ public:
     GEODE_ASSERT(t_size_ == o.t_size_);
     const int om = o.m_, m = m_;
     preallocate(m+om);
-    memcpy(data_+m*t_size_,o.data_,om*t_size_);
+    memcpy(data_+size_t(m)*t_size_,o.data_,size_t(om)*t_size_);
     m_ += om;
   }
 
   void zero(const int i) const {
     assert(unsigned(i)<unsigned(m_));
-    memset(data_+i*t_size_,0,t_size_);
+    memset(data_+size_t(i)*t_size_,0,t_size_);
   }
 
   void swap(const int i, const int j) const {
     assert(unsigned(i)<unsigned(m_) && unsigned(j)<unsigned(m_));
-    char *p = data_+i*t_size_,
-         *q = data_+j*t_size_;
+    char *p = data_+size_t(i)*t_size_,
+         *q = data_+size_t(j)*t_size_;
     for (int k=0;k<t_size_;k++)
-      swap(p[k],q[k]);
+      std::swap(p[k],q[k]);
   }
 
   void copy(int to, int from) {
-    memcpy(data_+to*t_size_,data_+from*t_size_,t_size_);
+    memcpy(data_+size_t(to)*t_size_,data_+size_t(from)*t_size_,t_size_);
   }
 
   // copy o[j] to this[i]
   void copy_from(int i, UntypedArray const &o, int j) {
     // only allowed if types are the same
     assert(type_ == o.type_);
-    memcpy(data_+i*t_size_,o.data_+j*t_size_,t_size_);
+    memcpy(data_+size_t(i)*t_size_,o.data_+size_t(j)*t_size_,t_size_);
   }
 
   // Typed access to data
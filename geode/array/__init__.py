@@ -1,6 +1,7 @@
 from __future__ import absolute_import
 
 import platform
+import numpy
 from numpy import *
 if platform.system()=='Windows':
   from .. import geode_all as geode_wrap
@@ -120,5 +121,18 @@ class Nested(object):
     object.__setattr__(self,'offsets',offsets)
     object.__setattr__(self,'flat',flat)
 
+def mapped_array(filename,dtype,shape=None,offset=0,writable=False):
+  '''Map an array straight from a file without copying, with the page cache doing the reading.
+  shape defaults to all whole elements after offset bytes.  Read only arrays are not writeable;
+  writable arrays are private copy on write mappings whose changes never reach the file.'''
+  data = geode_wrap.map_file(filename,writable)
+  dtype = numpy.dtype(dtype)
+  if shape is None:
+    shape = (len(data)-offset)//dtype.itemsize,
+  shape = tuple(shape)
+  size = dtype.itemsize*int(prod(shape,dtype=int64))
+  assert 0<=offset and offset+size<=len(data)
+  return data[offset:offset+size].view(dtype).reshape(shape)
+
 geode_wrap._set_nested_array(Nested)
 geode_wrap._set_recarray_type(recarray)
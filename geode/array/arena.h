@@ -0,0 +1,62 @@
+//#####################################################################
+// Class ArenaScope
+//#####################################################################
+//
+// While an ArenaScope is alive, small Array and Nested allocations on its
+// thread come from a bump allocator, and the arena's memory is released
+// all at once after the scope ends.  Operations which make many short lived
+// temporaries can open a scope at the top and copy their results out with
+// escape.
+//
+// A bump allocator never reuses memory before the scope ends, so arenas pay
+// off for short scopes, such as one iteration of an outer loop.  Around a
+// long operation the arena grows out of cache, and malloc, which recycles
+// freed blocks through per-thread caches, is faster.
+//
+// Arena buffers are reference counted like any other, so a buffer which
+// outlives the scope is never freed early: it keeps the arena's chunks
+// alive until it is released.  Results should still go through escape, or
+// they pin the memory of every temporary.  Scopes nest, and only affect
+// the thread that opened them.  The arena itself is implemented alongside
+// Buffer.
+//
+//#####################################################################
+#pragma once
+
+#include <geode/array/Nested.h>
+#include <geode/utility/forward.h>
+namespace geode {
+
+struct Arena;
+
+class ArenaScope : private Noncopyable {
+  Arena* const arena;
+public:
+  GEODE_CORE_EXPORT ArenaScope();
+  GEODE_CORE_EXPORT ~ArenaScope();
+};
+
+// Suspend the current thread's arena, if any, so that allocations use ordinary memory
+class ArenaPause : private Noncopyable {
+  Arena* const arena;
+public:
+  GEODE_CORE_EXPORT ArenaPause();
+  GEODE_CORE_EXPORT ~ArenaPause();
+};
+
+// Whether an array owner is an arena buffer
+GEODE_CORE_EXPORT bool arena_owned(PyObject* owner);
+
+// Return an array or nested array which isn't arena owned, copying only if necessary
+template<class T,int d> Array<T,d> escape(const Array<T,d>& array) {
+  if (!arena_owned(array.owner()))
+    return array;
+  ArenaPause pause;
+  return array.copy();
+}
+
+template<class T,bool frozen> Nested<T,frozen> escape(const Nested<T,frozen>& nested) {
+  return Nested<T,frozen>(escape(nested.offsets),escape(nested.flat));
+}
+
+}
@@ -57,6 +57,33 @@ template<class T> PyObject* to_python(const Nested<T>& array) {
   return 0;
 }
 
+// Convert a sequence of arrays with a single allocation for flat.  Items that are contiguous numpy arrays of the right
+// type are copied straight into place, and other items (lists, strided or differently typed arrays, or anything else
+// numpy accepts) are converted by numpy first.
+template<class T> Nested<T> nested_from_sequence(PyObject* object) {
+  typedef typename remove_const<T>::type Element;
+  const auto seq = steal_ref_check(PySequence_Fast(object,"expected a Nested array or a sequence of arrays"));
+  const int n = int(PySequence_Fast_GET_SIZE(&*seq));
+  PyObject** const items = PySequence_Fast_ITEMS(&*seq);
+  const int rank = NumpyRank<Array<Element>>::value;
+  vector<Ref<>> arrays;
+  arrays.reserve(n);
+  Array<int> lengths(n,uninit);
+  for (int i=0;i<n;i++) {
+    arrays.push_back(numpy_from_any(items[i],NumpyDescr<Element>::descr(),rank,rank,NPY_ARRAY_CARRAY_RO));
+    const auto a = (PyArrayObject*)&*arrays.back();
+    if (!numpy_shape_match(Types<Array<Element>>(),rank,PyArray_DIMS(a)))
+      throw_dimension_mismatch();
+    if (PyArray_DIMS(a)[0]>std::numeric_limits<int>::max())
+      throw ValueError("Nested: total size exceeds the limit of 2^31-1 elements");
+    lengths[i] = int(PyArray_DIMS(a)[0]);
+  }
+  const Nested<Element> result(lengths,uninit);
+  for (int i=0;i<n;i++)
+    memcpy(result[i].data(),PyArray_DATA((PyArrayObject*)&*arrays[i]),sizeof(Element)*lengths[i]);
+  return Nested<T>(result.offsets,result.flat);
+}
+
 template<class T> Nested<T> FromPython<Nested<T>>::convert(PyObject* object) {
   if (is_nested_array(object)) {
     // Already a Python Nested object, so conversion is easy
@@ -65,14 +92,16 @@ template<class T> Nested<T> FromPython<Nested<T>>::convert(PyObject* object) {
     self.offsets = from_python<Array<const int>>(fields.x);
     self.flat = from_python<Array<T>>(fields.y);
     return self;
-  } else if (is_numpy_array(object)) {
-    // 2D numpy arrays can be handled more quickly than general sequences of sequences
-    const auto data = from_python<Array<T,2>>(object);
+  } else if (is_numpy_array(object) && PyArray_DESCR((PyArrayObject*)object)->type_num!=NPY_OBJECT) {
+    // 2D numpy arrays share storage with flat.  Const conversions also accept strided or differently typed arrays,
+    // which numpy copies once; nonconst conversions must share, so they require an exact match.
+    const int rank = NumpyRank<Array<T,2>>::value;
+    const auto data = from_python<Array<T,2>>(!is_const<T>::value ? object
+      : &*numpy_from_any(object,NumpyDescr<T>::descr(),rank,rank,NPY_ARRAY_CARRAY_RO));
     const auto offsets = data.n*arange(data.m+1);
     return Nested<T>(offsets.copy(),data.flat);
   } else {
-    // Convert via an array of arrays
-    return Nested<T>::copy(from_python<vector<Array<T>>>(object));
+    return nested_from_sequence<T>(object);
   }
 }
 
@@ -0,0 +1,156 @@
+//#####################################################################
+// Elementwise evaluation of array expressions
+//#####################################################################
+//
+// Assignments such as X = X+dt*V or X += dt*V evaluate the expression one
+// element at a time through operator[].  Left alone, the compiler can't
+// vectorize these loops well: operands held by reference must be reloaded
+// after every store, and it can't rule out overlap between the destination
+// and an operand at different indices.
+//
+// elementwise avoids both problems when every array in the expression is
+// contiguous.  The expression is rebuilt over RawArray views held by value,
+// and if each operand either is the destination or doesn't overlap it, the
+// elements are independent.  The loop is then vectorized without alias
+// checks, and large loops are split across threads.  Anything else (indirect
+// arrays, overlapping slices at an offset) is evaluated in order as before.
+//
+//#####################################################################
+#pragma once
+
+#include <geode/array/forward.h>
+#include <geode/array/ArrayAbs.h>
+#include <geode/array/ArrayDifference.h>
+#include <geode/array/ArrayLeftMultiple.h>
+#include <geode/array/ArrayNegation.h>
+#include <geode/array/ArrayPlusScalar.h>
+#include <geode/array/ArrayProduct.h>
+#include <geode/array/ArraySum.h>
+#include <geode/utility/openmp.h>
+#include <geode/utility/type_traits.h>
+#include <cassert>
+namespace geode {
+
+// Independent loops at least this long run in parallel
+const int elementwise_parallel_size = 1<<16;
+
+// ElementwiseRaw<TA> is defined for expressions whose arrays are all contiguous.  type is the same expression over
+// RawArray views, and independent checks whether a[i] reads only the destination element i or memory outside the
+// destination [lo,hi), which has the same length as a.
+template<class TA,class Enable=void> struct ElementwiseRaw { enum {contiguous = false}; };
+
+template<class T> struct ElementwiseRaw<RawArray<T>> {
+  enum {contiguous = true};
+  typedef RawArray<T> type;
+  static type raw(const RawArray<T>& a) { return a; }
+  static bool independent(const RawArray<T>& a, const char* lo, const char* hi) {
+    const char* alo = (const char*)a.data();
+    const char* ahi = (const char*)(a.data()+a.size());
+    return (alo==lo && ahi==hi) || ahi<=lo || hi<=alo;
+  }
+};
+
+template<class T> struct ElementwiseRaw<Array<T>> {
+  enum {contiguous = true};
+  typedef RawArray<T> type;
+  static type raw(const Array<T>& a) { return a.raw(); }
+  static bool independent(const Array<T>& a, const char* lo, const char* hi) {
+    return ElementwiseRaw<type>::independent(a.raw(),lo,hi);
+  }
+};
+
+template<template<class,class> class E,class A,class B> struct ElementwiseRawBinary {
+  typedef ElementwiseRaw<A> RA;
+  typedef ElementwiseRaw<B> RB;
+  enum {contiguous = true};
+  typedef E<typename RA::type,typename RB::type> type;
+  static type raw(const E<A,B>& a) { return type(RA::raw(a.array1),RB::raw(a.array2)); }
+  static bool independent(const E<A,B>& a, const char* lo, const char* hi) {
+    return RA::independent(a.array1,lo,hi) && RB::independent(a.array2,lo,hi);
+  }
+};
+
+template<template<class,class> class E,class C,class A> struct ElementwiseRawScalar {
+  typedef ElementwiseRaw<A> RA;
+  enum {contiguous = true};
+  typedef E<C,typename RA::type> type;
+  static type raw(const E<C,A>& a) { return type(a.c,RA::raw(a.array)); }
+  static bool independent(const E<C,A>& a, const char* lo, const char* hi) {
+    return RA::independent(a.array,lo,hi);
+  }
+};
+
+template<template<class> class E,class A> struct ElementwiseRawUnary {
+  typedef ElementwiseRaw<A> RA;
+  enum {contiguous = true};
+  typedef E<typename RA::type> type;
+  static type raw(const E<A>& a) { return type(RA::raw(a.array)); }
+  static bool independent(const E<A>& a, const char* lo, const char* hi) {
+    return RA::independent(a.array,lo,hi);
+  }
+};
+
+#define GEODE_ELEMENTWISE_RAW(Expression,Helper,X,Y,...) \
+  template<class X,class Y> struct ElementwiseRaw<Expression<X,Y>,typename enable_if_c<__VA_ARGS__>::type> \
+    : public Helper<Expression,X,Y> {};
+GEODE_ELEMENTWISE_RAW(ArraySum,ElementwiseRawBinary,A,B,ElementwiseRaw<A>::contiguous && ElementwiseRaw<B>::contiguous)
+GEODE_ELEMENTWISE_RAW(ArrayDifference,ElementwiseRawBinary,A,B,ElementwiseRaw<A>::contiguous && ElementwiseRaw<B>::contiguous)
+GEODE_ELEMENTWISE_RAW(ArrayProduct,ElementwiseRawBinary,A,B,ElementwiseRaw<A>::contiguous && ElementwiseRaw<B>::contiguous)
+GEODE_ELEMENTWISE_RAW(ArrayLeftMultiple,ElementwiseRawScalar,C,A,ElementwiseRaw<A>::contiguous)
+GEODE_ELEMENTWISE_RAW(ArrayPlusScalar,ElementwiseRawScalar,C,A,ElementwiseRaw<A>::contiguous)
+#undef GEODE_ELEMENTWISE_RAW
+
+template<class A> struct ElementwiseRaw<ArrayNegation<A>,typename enable_if_c<ElementwiseRaw<A>::contiguous>::type>
+  : public ElementwiseRawUnary<ArrayNegation,A> {};
+template<class A> struct ElementwiseRaw<ArrayAbs<A>,typename enable_if_c<ElementwiseRaw<A>::contiguous>::type>
+  : public ElementwiseRawUnary<ArrayAbs,A> {};
+
+struct ElementwiseAssign { template<class A,class B> void operator()(A&& a, const B& b) const { a = b; } };
+struct ElementwiseAdd { template<class A,class B> void operator()(A&& a, const B& b) const { a += b; } };
+struct ElementwiseSubtract { template<class A,class B> void operator()(A&& a, const B& b) const { a -= b; } };
+struct ElementwiseMultiply { template<class A,class B> void operator()(A&& a, const B& b) const { a *= b; } };
+struct ElementwiseDivide { template<class A,class B> void operator()(A&& a, const B& b) const { assert(b); a /= b; } };
+
+// Apply op(dst[i],src[i]) for each i in order
+template<class TA,class TB,class Op> static inline void elementwise(const TA& dst, const TB& src, const Op& op) {
+  const int m = dst.size();
+  assert(m==src.size());
+  for (int i=0;i<m;i++)
+    op(dst[i],src[i]);
+}
+
+// Independent elements in [lo,hi).  src is passed by value so that stores to data can't change it.
+template<class T,class TB,class Op> static inline void elementwise_independent(T* data, const TB src, const Op op,
+                                                                               const int lo, const int hi) {
+  GEODE_IVDEP
+  for (int i=lo;i<hi;i++)
+    op(data[i],src[i]);
+}
+
+template<class T,class TB,class Op> static inline typename enable_if_c<ElementwiseRaw<TB>::contiguous>::type
+elementwise(const RawArray<T>& dst, const TB& src, const Op& op) {
+  typedef ElementwiseRaw<TB> R;
+  const int m = dst.size();
+  assert(m==src.size());
+  T* const data = dst.data();
+  if (!R::independent(src,(const char*)data,(const char*)(data+m)))
+    for (int i=0;i<m;i++)
+      op(data[i],src[i]);
+  else if (m<elementwise_parallel_size || omp_in_parallel() || !is_trivially_destructible<T>::value)
+    elementwise_independent(data,R::raw(src),op,0,m);
+  else {
+    const auto raw = R::raw(src);
+    #pragma omp parallel
+    {
+      const auto r = partition_loop(m);
+      elementwise_independent(data,raw,op,r.lo,r.hi);
+    }
+  }
+}
+
+template<class T,class TB,class Op> static inline typename enable_if_c<ElementwiseRaw<TB>::contiguous>::type
+elementwise(const Array<T>& dst, const TB& src, const Op& op) {
+  elementwise(dst.raw(),src,op);
+}
+
+}
@@ -0,0 +1,99 @@
+//#####################################################################
+// Memory mapped arrays
+//#####################################################################
+#include <geode/array/mapped.h>
+#include <geode/python/numpy.h>
+#include <geode/python/wrap.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+namespace geode {
+
+MappedFile::MappedFile(const string& filename, const bool writable, const bool sequential)
+  : data(0), size(0) {
+#ifdef _WIN32
+  FILE* f = fopen(filename.c_str(),"rb");
+  if (!f)
+    throw IOError(format("can't open '%s' for reading: %s",filename,strerror(errno)));
+  char chunk[1<<16];
+  while (const size_t n = fread(chunk,1,sizeof(chunk),f))
+    buffer.insert(buffer.end(),chunk,chunk+n);
+  const bool failed = ferror(f)!=0;
+  fclose(f);
+  if (failed)
+    throw IOError(format("failed to read '%s': %s",filename,strerror(errno)));
+  data = buffer.data();
+  size = buffer.size();
+#else
+  const int fd = open(filename.c_str(),O_RDONLY);
+  if (fd < 0)
+    throw IOError(format("can't open '%s' for reading: %s",filename,strerror(errno)));
+  struct stat st;
+  if (fstat(fd,&st) < 0) {
+    const int e = errno;
+    close(fd);
+    throw IOError(format("can't stat '%s': %s",filename,strerror(e)));
+  }
+  size = size_t(st.st_size);
+  if (size) {
+    void* m = mmap(0,size,PROT_READ|(writable?PROT_WRITE:0),MAP_PRIVATE,fd,0);
+    if (m == MAP_FAILED) {
+      const int e = errno;
+      close(fd);
+      throw IOError(format("can't map '%s': %s",filename,strerror(e)));
+    }
+    if (sequential)
+      madvise(m,size,MADV_SEQUENTIAL);
+    data = (const char*)m;
+  }
+  close(fd); // The mapping stays valid after the descriptor is closed
+#endif
+}
+
+MappedFile::~MappedFile() {
+#ifndef _WIN32
+  if (size)
+    munmap((void*)data,size);
+#endif
+}
+
+MappedBuffer::MappedBuffer(const string& filename, const bool writable)
+  : file(filename,writable,false), writable(writable) {}
+
+Ref<const MappedBuffer> map_file(const string& filename, const bool writable) {
+  return new_<MappedBuffer>(filename,writable);
+}
+
+#ifdef GEODE_PYTHON
+
+// Map a file as a flat uint8 numpy array, which may exceed 2^31 bytes.  See mapped_array in array/__init__.py.
+static Ref<> map_file_py(const string& filename, const bool writable) {
+  const auto buffer = map_file(filename,writable);
+  npy_intp size = npy_intp(buffer->file.size);
+  PyObject* numpy = numpy_new_from_descr(numpy_array_type(),numpy_descr_from_type(NPY_UINT8),1,&size,0,
+                                         (void*)buffer->file.data,NPY_ARRAY_CARRAY,0);
+  if (!numpy)
+    throw_python_error();
+  if (!writable)
+    PyArray_CLEARFLAGS((PyArrayObject*)numpy,NPY_ARRAY_WRITEABLE);
+  PyObject* owner = buffer.borrow_owner();
+  Py_INCREF(owner);
+  PyArray_SetBaseObject((PyArrayObject*)numpy,owner);
+  return steal_ref(*numpy);
+}
+
+#endif
+}
+using namespace geode;
+
+void wrap_mapped() {
+#ifdef GEODE_PYTHON
+  GEODE_FUNCTION_2(map_file,map_file_py)
+#endif
+}
@@ -0,0 +1,99 @@
+//#####################################################################
+// Memory mapped arrays
+//#####################################################################
+//
+// Arrays whose storage is a memory mapped file, so that large rasters,
+// point clouds, and meshes can be used straight from disk with the page
+// cache doing the reading.  The mapping is held by a MappedBuffer, a
+// reference counted object which serves as the owner of every array into
+// it, so the file stays mapped as long as any array or numpy view does.
+//
+// Read only mappings produce const arrays, which convert to read only
+// numpy arrays.  Writable mappings are private: writes are copy on write,
+// visible only to this process, and never reach the file.  Windows has no
+// mmap support here, so the file is read into memory instead.
+//
+//#####################################################################
+#pragma once
+
+#include <geode/array/NdArray.h>
+#include <geode/python/exceptions.h>
+#include <geode/python/Object.h>
+#include <geode/python/Ref.h>
+#include <geode/utility/format.h>
+#include <vector>
+namespace geode {
+
+// The entire contents of a file.  Sizes are size_t since files can easily exceed 2^31 bytes.
+struct MappedFile {
+  const char* data;
+  size_t size;
+#ifdef _WIN32
+  std::vector<char> buffer;
+#endif
+
+  // Sequential access advice suits parsers reading front to back, but not random access
+  GEODE_CORE_EXPORT MappedFile(const string& filename, const bool writable=false, const bool sequential=true);
+  GEODE_CORE_EXPORT ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  void operator=(const MappedFile&) = delete;
+
+  const char* end() const {
+    return data+size;
+  }
+};
+
+// A mapping that owns the memory behind arrays
+class MappedBuffer : public Object {
+public:
+  GEODE_NEW_FRIEND
+  const MappedFile file;
+  const bool writable;
+protected:
+  GEODE_CORE_EXPORT MappedBuffer(const string& filename, const bool writable);
+};
+
+// Map a file for use as arrays
+GEODE_CORE_EXPORT Ref<const MappedBuffer> map_file(const string& filename, const bool writable=false);
+
+// count elements of T starting offset bytes into a mapping, or all remaining whole elements if count is -1
+template<class T> Array<T> mapped_array(const MappedBuffer& buffer, const size_t offset=0, const int count=-1) {
+  static_assert(is_trivially_destructible<T>::value,"mapped arrays never call destructors");
+  if (!is_const<T>::value && !buffer.writable)
+    throw ValueError("mapped_array: mutable arrays need a writable mapping");
+  const size_t size = buffer.file.size;
+  if (offset%alignof(T) || offset>size)
+    throw ValueError(format("mapped_array: offset %" GEODE_PRIUSIZE " is misaligned or past the end of a %"
+      GEODE_PRIUSIZE " byte file",offset,size));
+  const size_t available = (size-offset)/sizeof(T);
+  if (count<0 ? available>size_t(std::numeric_limits<int>::max()) : size_t(count)>available)
+    throw ValueError(format("mapped_array: %d elements of size %d at offset %" GEODE_PRIUSIZE
+      " don't fit in a %" GEODE_PRIUSIZE " byte file",count,int(sizeof(T)),offset,size));
+  return Array<T>(count<0 ? int(available) : count,(T*)(buffer.file.data+offset),ptr_to_python(&buffer));
+}
+
+template<class T> Array<const T> mapped_array(const string& filename, const size_t offset=0, const int count=-1) {
+  return mapped_array<const T>(*map_file(filename),offset,count);
+}
+
+// A private copy on write mapping
+template<class T> Array<T> mapped_array_private(const string& filename, const size_t offset=0, const int count=-1) {
+  return mapped_array<T>(*map_file(filename,true),offset,count);
+}
+
+// An array of the given shape starting offset bytes into a file
+template<class T> NdArray<const T> mapped_ndarray(const string& filename, RawArray<const int> shape,
+                                                  const size_t offset=0) {
+  int64_t n = 1;
+  for (const int s : shape) {
+    GEODE_ASSERT(s>=0);
+    n *= s;
+    if (n>std::numeric_limits<int>::max())
+      throw ValueError("mapped_ndarray: more than 2^31-1 elements");
+  }
+  const auto flat = mapped_array<const T>(*map_file(filename),offset,int(n));
+  return NdArray<const T>(shape.copy(),flat);
+}
+
+}
@@ -2,7 +2,15 @@
 // Module Arrays
 //#####################################################################
 #include <geode/array/Array2d.h>
+#include <geode/array/BrickedArray.h>
+#include <geode/array/Field.h>
+#include <geode/array/mapped.h>
 #include <geode/array/Nested.h>
+#include <geode/array/NestedBuilder.h>
+#include <geode/array/parallel_nested.h>
+#include <geode/array/permute.h>
+#include <geode/array/sort.h>
+#include <geode/array/UntypedArray.h>
 #include <geode/python/numpy.h>
 #include <geode/python/wrap.h>
 using namespace geode;
@@ -64,10 +72,176 @@ void nested_test() {
   GEODE_ASSERT(n2.size() == n0.size() + n1.size());
 }
 
+void nested_builder_test() {
+  // Enough elements to span several chunks
+  Nested<int,false> expected;
+  NestedBuilder<int> builder;
+  for (int i=0;i<300;i++) {
+    expected.append_empty();
+    builder.append_empty();
+    for (int j=0;j<i%7;j++) {
+      expected.append_to_back(i*j);
+      builder.append_to_back(i*j);
+    }
+    Array<int> tail;
+    for (int j=0;j<i%5;j++)
+      tail.append(j);
+    expected.extend_back(tail);
+    builder.extend_back(tail);
+  }
+  GEODE_ASSERT(builder.size()==expected.size() && builder.total_size()==expected.total_size());
+  GEODE_ASSERT(builder.freeze()==expected.freeze());
+
+  // Two pass construction, filling subarrays out of order
+  NestedFill<int> fill(expected.size());
+  for (int i=0;i<expected.size();i++)
+    for (int j=0;j<expected.size(i);j++)
+      fill.count(i);
+  fill.allocate();
+  for (int i=expected.size()-1;i>=0;i--)
+    for (const int x : expected[i])
+      fill.fill(i,x);
+  GEODE_ASSERT(fill.finish()==expected.freeze());
+
+  // Both parallel variants
+  GEODE_ASSERT(parallel_nested(expected.size(),[&](const int i) { return expected[i]; })==expected.freeze());
+  GEODE_ASSERT(parallel_nested<int>(expected.size(),
+    [&](const int i) { return expected.size(i); },
+    [&](const int i, RawArray<int> x) { x = expected[i]; })==expected.freeze());
+}
+
+// Sort with parallel_sort and radix_sort, and return both results and the stable order from radix_sort_order
+Tuple<Array<int>,Array<int>,Array<int>> parallel_sort_test(RawArray<const int> keys) {
+  const auto merged = keys.copy(),
+             radix = keys.copy();
+  parallel_sort(merged);
+  radix_sort(radix);
+  return tuple(merged,radix,radix_sort_order(keys));
+}
+
+void elementwise_test() {
+  typedef Vector<real,3> TV;
+  // Large enough to run in parallel, with the destination also an operand
+  const int n = 3*elementwise_parallel_size+7;
+  Array<TV> X(n,uninit), V(n,uninit);
+  for (int i=0;i<n;i++) {
+    X[i] = TV(i,1,-i);
+    V[i] = TV(2,i%5,3);
+  }
+  const real dt = .5;
+  X.raw() = X+dt*V;
+  X -= -V;
+  X *= X-V;
+  for (int i=0;i<n;i++) {
+    const TV x = TV(i,1,-i)+(dt+1)*TV(2,i%5,3);
+    GEODE_ASSERT(X[i]==x*(x-TV(2,i%5,3)));
+  }
+
+  // Overlapping slices at an offset must still be evaluated in order
+  Array<int> a(8);
+  a[0] = 1;
+  a.slice(1,8) = a.slice(0,7)+a.slice(0,7);
+  for (int i=0;i<8;i++)
+    GEODE_ASSERT(a[i]==1<<i);
+  a.slice(0,7) += a.slice(1,8);
+  for (int i=0;i<8;i++)
+    GEODE_ASSERT(a[i]==(i<7 ? 3<<i : 128));
+}
+
+// Check the gather, scatter, and in place permutation kernels against each other, on both the scatter and cycle
+// paths of inplace_partial_permute
+void permute_test() {
+  typedef Vector<real,3> TV;
+  const int n = 3*permute_block+5;
+  Array<TV> x(n,uninit);
+  Array<int> perm(n,uninit);
+  for (int i=0;i<n;i++) {
+    x[i] = TV(i,-i,2*i);
+    perm[i] = int(7919*int64_t(i)%n); // n isn't a multiple of the prime 7919, so this is a permutation
+  }
+  Array<TV> y(n,uninit), z(n,uninit);
+  scatter(y.raw(),x,perm);
+  gather(z.raw(),y,perm);
+  GEODE_ASSERT(z==x);
+  z = x.copy();
+  inplace_permute(z.raw(),perm);
+  GEODE_ASSERT(z==y);
+
+  // Drop every third block, and pack the rest in reverse order
+  Array<char> work;
+  for (const int cycles : vec(0,1))
+    for (const int block : vec(1,2)) {
+      const int m = n/block;
+      Array<int> p(m,uninit);
+      const int count = (m+2)/3;
+      for (int i=0;i<m;i++)
+        p[i] = i%3 ? -1 : count-1-i/3;
+      auto u = UntypedArray(Field<TV,int>(x.slice(0,block*m).copy()));
+      if (cycles)
+        inplace_partial_permute_cycles(u,p,block);
+      else
+        inplace_partial_permute(u,p,work,block);
+      const auto v = u.get<TV>();
+      GEODE_ASSERT(v.size()==block*count);
+      Array<int> inverse(count,uninit);
+      for (int i=0;i<m;i++)
+        if (p[i]>=0) {
+          inverse[p[i]] = i;
+          for (int k=0;k<block;k++)
+            GEODE_ASSERT(v[block*p[i]+k]==x[block*i+k]);
+        }
+      GEODE_ASSERT(gathered(UntypedArray(Field<TV,int>(x)),inverse,block).get<TV>()==v);
+    }
+}
+
 Nested<const int> nested_convert_test(Nested<const int> a) {
   return a;
 }
 
+// Sum of the valid face neighbors minus the center
+struct NeighborStencil {
+  template<class TA> real operator()(const TA& a, const Vector<int,3> I) const {
+    real s = -a(I);
+    for (int i=0;i<3;i++)
+      for (int e=-1;e<=1;e+=2) {
+        auto J = I;
+        J[i] += e;
+        if (a.valid(J))
+          s += a(J);
+      }
+    return s;
+  }
+};
+
+// Apply NeighborStencil to both row major and bricked storage, checking that the results agree
+Array<real,3> bricked_test(Array<const real,3> x) {
+  const BrickedArray<real> b(x);
+  GEODE_ASSERT(b.sizes()==x.sizes() && b.array().flat==x.flat);
+  for (int i=0;i<x.m;i++)
+    for (int j=0;j<x.n;j++)
+      for (int k=0;k<x.mn;k++)
+        GEODE_ASSERT(b(i,j,k)==x(i,j,k) && b.flat_index(vec(i,j,k))<b.flat.size());
+  Array<real,3> y(x.sizes(),uninit);
+  apply_brick_stencil(NeighborStencil(),x,y);
+  BrickedArray<real> by(x.sizes(),uninit);
+  apply_brick_stencil(NeighborStencil(),b,by);
+  GEODE_ASSERT(by.array().flat==y.flat);
+  return y;
+}
+
+// Map the doubles in a file, checking that private writes stay out of the file
+Array<const real> mapped_array_test(const string& filename, const int offset) {
+  const auto X = mapped_array<real>(filename,sizeof(real)*offset);
+  GEODE_ASSERT(X.size()>=1);
+  const auto Y = mapped_array_private<real>(filename);
+  GEODE_ASSERT(Y.size()==X.size()+offset && Y[offset]==X[0]);
+  Y[offset] += 1;
+  GEODE_ASSERT(mapped_array<real>(filename,sizeof(real)*offset,1)[0]==X[0]);
+  const auto Z = mapped_ndarray<real>(filename,asarray(vec(1,X.size())),sizeof(real)*offset);
+  GEODE_ASSERT(Z.shape[1]==X.size() && Z.flat==X);
+  return X;
+}
+
 #ifdef GEODE_PYTHON
 
 ssize_t base_refcnt(PyObject* array) {
@@ -88,12 +262,19 @@ Tuple<Array<uint8_t>,size_t> array_write_test(const string& filename, RawArray<c
 void wrap_array() {
   GEODE_WRAP(nested_array)
   GEODE_WRAP(stencil)
+  GEODE_WRAP(mapped)
 
   // for testing purposes
   GEODE_FUNCTION(empty_array)
   GEODE_FUNCTION(array_test)
   GEODE_FUNCTION(nested_test)
+  GEODE_FUNCTION(nested_builder_test)
+  GEODE_FUNCTION(parallel_sort_test)
+  GEODE_FUNCTION(elementwise_test)
+  GEODE_FUNCTION(permute_test)
   GEODE_FUNCTION(nested_convert_test)
+  GEODE_FUNCTION(mapped_array_test)
+  GEODE_FUNCTION(bricked_test)
   GEODE_FUNCTION(const_array_test)
 #ifdef GEODE_PYTHON
   GEODE_FUNCTION(base_refcnt)
@@ -0,0 +1,51 @@
+// Build a Nested array from independent pieces in parallel
+#pragma once
+
+#include <geode/array/NestedBuilder.h>
+#include <geode/utility/openmp.h>
+#include <vector>
+namespace geode {
+
+// Compute f(i) for i in [0,n) in parallel and collect the resulting arrays into a Nested.  Inputs are split into
+// chunks of consecutive indices, each of which appends to its own NestedBuilder.  Once all sizes are known, the
+// builders are copied into the result, which is allocated exactly once and is ordered as if computed serially.
+template<class F> static Nested<typename decltype(declval<const F&>()(0))::Element>
+parallel_nested(const int n, const F& f) {
+  typedef typename decltype(declval<const F&>()(0))::Element T;
+  const int chunks = min(n,64*omp_get_max_threads());
+  Array<int> counts(n,uninit);
+  std::vector<NestedBuilder<T>> builders(chunks);
+  #pragma omp parallel for schedule(dynamic,1)
+  for (int c=0;c<chunks;c++) {
+    auto& builder = builders[c];
+    for (const int i : partition_loop(n,chunks,c)) {
+      const auto piece = f(i);
+      counts[i] = piece.size();
+      builder.append(piece);
+    }
+  }
+  Nested<T> result(counts,uninit);
+  #pragma omp parallel for
+  for (int c=0;c<chunks;c++) {
+    const int start = result.offsets[partition_loop(n,chunks,c).lo];
+    builders[c].write(result.flat.slice(start,start+builders[c].total_size()));
+  }
+  return result;
+}
+
+// Two pass version for pieces whose sizes are cheap to compute: count(i) returns the size of piece i, and
+// fill(i,piece) writes it in place.  Both passes run in parallel, and nothing is copied.
+template<class T,class Count,class Fill> static Nested<T>
+parallel_nested(const int n, const Count& count, const Fill& fill) {
+  Array<int> counts(n,uninit);
+  #pragma omp parallel for
+  for (int i=0;i<n;i++)
+    counts[i] = count(i);
+  Nested<T> result(counts,uninit);
+  #pragma omp parallel for schedule(dynamic,64)
+  for (int i=0;i<n;i++)
+    fill(i,result[i]);
+  return result;
+}
+
+}
@@ -1,9 +1,19 @@
 // Array permutation routines
+//
+// permute and friends work on any array type with scalar loops.  gather, scatter, and the UntypedArray routines
+// below are for large contiguous arrays: they run in parallel blocks, and prefetch the indirect side of each loop a
+// few elements ahead, since random accesses into a huge field miss cache every time.  inplace_permute follows the
+// cycles of the permutation instead of copying, so permuting a field needs only one byte per element of extra memory.
 #pragma once
 
 #include <geode/array/Array.h>
+#include <geode/utility/parallel.h>
 namespace geode {
 
+// Blocks of this many elements are gathered or scattered in parallel, and indirect accesses are prefetched this far
+// ahead
+const int permute_block = 4096, permute_prefetch = 16;
+
 // dst[perm[i]] = src[i]
 template<class D,class S,class P> void permute(D& dst, const S& src, const P& perm) {
   STATIC_ASSERT_SAME(typename D::value_type,typename S::value_type);
@@ -35,12 +45,93 @@ template<class D,class S,class P> void partial_permute(D& dst, const S& src, con
   }
 }
 
+template<class T> static void gather_block(T* const dst, const T* const src, const int* const indices,
+                                           const int lo, const int hi) {
+  for (int i=lo;i<hi;i++) {
+    if (i+permute_prefetch<hi)
+      GEODE_PREFETCH(src+indices[i+permute_prefetch]);
+    dst[i] = src[indices[i]];
+  }
+}
+
+template<class T> static void scatter_block(T* const dst, const T* const src, const int* const indices,
+                                            const int lo, const int hi) {
+  for (int i=lo;i<hi;i++) {
+    if (i+permute_prefetch<hi && indices[i+permute_prefetch]>=0)
+      GEODE_PREFETCH(dst+indices[i+permute_prefetch]);
+    const int j = indices[i];
+    if (j>=0)
+      dst[j] = src[i];
+  }
+}
+
+// Call block(lo,hi) on consecutive blocks of [0,n), in parallel if there is more than one
+template<class F> static inline void permute_blocks(const int n, const F& block) {
+  if (n<=permute_block)
+    block(0,n);
+  else
+    parallel_for((n+permute_block-1)/permute_block,[&](const int b) {
+      block(permute_block*b,min(n,permute_block*(b+1)));
+    });
+}
+
+// dst[i] = src[indices[i]], in parallel.  dst must not overlap src.
+template<class T> void gather(RawArray<T> dst, typename First<RawArray<const T>>::type src,
+                              RawArray<const int> indices) {
+  GEODE_ASSERT(dst.size()==indices.size());
+  assert(!indices.size() || (indices.min()>=0 && indices.max()<src.size()));
+  T* const d = dst.data();
+  const T* const s = src.data();
+  const int* const I = indices.data();
+  permute_blocks(indices.size(),[=](const int lo, const int hi) { gather_block(d,s,I,lo,hi); });
+}
+
+// dst[indices[i]] = src[i] for each indices[i]>=0, in parallel.  Nonnegative indices must be distinct, and dst must
+// not overlap src.
+template<class T> void scatter(RawArray<T> dst, typename First<RawArray<const T>>::type src,
+                               RawArray<const int> indices) {
+  GEODE_ASSERT(src.size()==indices.size());
+  assert(!indices.size() || indices.max()<dst.size());
+  T* const d = dst.data();
+  const T* const s = src.data();
+  const int* const I = indices.data();
+  permute_blocks(indices.size(),[=](const int lo, const int hi) { scatter_block(d,s,I,lo,hi); });
+}
+
+// x[perm[i]] = x[i] for a permutation perm of [0,x.size()), following cycles in place
+template<class T> void inplace_permute(RawArray<T> x, RawArray<const int> perm) {
+  const int m = x.size();
+  GEODE_ASSERT(perm.size()==m);
+  Array<bool> done(m);
+  for (int i=0;i<m;i++)
+    if (!done[i]) {
+      // Carry x[i] around its cycle
+      T carry = x[i];
+      int j = perm[i];
+      done[i] = true;
+      GEODE_ASSERT(unsigned(j)<unsigned(m));
+      while (!done[j]) {
+        GEODE_ASSERT(unsigned(j)<unsigned(m));
+        std::swap(carry,x[j]);
+        done[j] = true;
+        j = perm[j];
+      }
+      GEODE_ASSERT(j==i,"inplace_permute: not a permutation");
+      x[i] = carry;
+    }
+}
+
 template<class A,class P,class W> void inplace_partial_permute(A& x, const P& perm, W& work) {
   partial_permute(work,x,perm);
   x.copy(work);
 }
 
-// Requires x.size()==block*perm.size()
+// x[block*perm[i]+k] = x[block*i+k] for each perm[i]>=0 and k<block, then shrink x to block*(perm.max()+1).  Requires
+// x.size()==block*perm.size(), and nonnegative entries of perm must be distinct.  Arrays smaller than
+// inplace_permute_bytes are scattered into work in parallel and copied back.  Larger arrays are permuted in place by
+// inplace_partial_permute_cycles, which is latency bound and several times slower, but doesn't need a copy.
+const size_t inplace_permute_bytes = size_t(256)<<20;
+GEODE_EXPORT void inplace_partial_permute_cycles(UntypedArray& x, RawArray<const int> perm, const int block=1);
 GEODE_EXPORT void inplace_partial_permute(UntypedArray& x, RawArray<const int> perm,
                                           Array<char>& work, const int block=1);
 template<class P> static inline void inplace_partial_permute(UntypedArray& x, const P& perm,
@@ -48,4 +139,7 @@ template<class P> static inline void inplace_partial_permute(UntypedArray& x, co
   inplace_partial_permute(x,RawArray<const int>(perm),work,block);
 }
 
+// result[block*i+k] = x[block*indices[i]+k] for k<block, in parallel
+GEODE_EXPORT UntypedArray gathered(const UntypedArray& x, RawArray<const int> indices, const int block=1);
+
 }
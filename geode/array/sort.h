@@ -1,10 +1,12 @@
-// sort and stable_sort
+// sort and stable_sort, and parallel merge and radix sorts
 #pragma once
 
 #include <geode/array/Array.h>
 #include <geode/math/min.h>
+#include <geode/utility/parallel.h>
 #include <algorithm>
 #include <functional>
+#include <vector>
 namespace geode {
 
 // Comparison function objects
@@ -89,4 +91,159 @@ template<class TArray> static inline void stable_sort(TArray& array) {
   stable_sort(array,std::less<typename TArray::value_type>());
 }
 
+// Parallel sorts for large arrays of plain data.  Both are stable, so their results are unique and don't depend on the
+// number of threads.
+
+// Number of elements of a among the first k outputs of a stable merge of sorted a and b
+template<class T,class TCompare> static inline int merge_split(RawArray<const T> a, RawArray<const T> b, const int k,
+                                                               const TCompare& comparison) {
+  int lo = max(0,k-b.size()),
+      hi = min(k,a.size());
+  while (lo<hi) {
+    const int i = (lo+hi)/2;
+    if (!comparison(b[k-i-1],a[i]))
+      lo = i+1;
+    else
+      hi = i;
+  }
+  return lo;
+}
+
+// Stable merge sort.  Chunks are sorted with std::stable_sort in parallel, then merged pairwise.  Each merge is cut
+// into independent pieces along the merge path, so the last rounds are as parallel as the first.
+template<class TArray,class TCompare> static void parallel_sort(const TArray& array, const TCompare& comparison) {
+  typedef typename TArray::Element T;
+  const RawArray<T> x = array;
+  const int n = x.size(),
+            grain = 1<<14;
+  if (n<=grain || thread_count()==1) {
+    std::stable_sort(x.begin(),x.end(),comparison);
+    return;
+  }
+  int runs = min((n-1)/grain+1,4*thread_count());
+  Array<int> bounds(runs+1,uninit);
+  for (int r=0;r<=runs;r++)
+    bounds[r] = int(int64_t(n)*r/runs);
+  parallel_for(runs,[&](const int r) {
+    std::stable_sort(x.begin()+bounds[r],x.begin()+bounds[r+1],comparison);
+  });
+
+  Array<T> buffer(n,uninit);
+  T* src = x.data();
+  T* dst = buffer.data();
+  while (runs>1) {
+    // Each task fills outputs [k0,k1) of run pair p, merging or copying a leftover odd run
+    Array<Vector<int,3>> tasks;
+    for (int p=0;2*p<runs;p++) {
+      const int size = bounds[min(2*p+2,runs)]-bounds[2*p];
+      for (int k=0;k<size;k+=grain)
+        tasks.append(vec(p,k,min(k+grain,size)));
+    }
+    parallel_for(tasks.size(),[&](const int t) {
+      const int p = tasks[t].x, k0 = tasks[t].y, k1 = tasks[t].z,
+                lo = bounds[2*p];
+      if (2*p+1==runs) {
+        std::copy(src+lo+k0,src+lo+k1,dst+lo+k0);
+        return;
+      }
+      const RawArray<const T> a(bounds[2*p+1]-lo,src+lo),
+                              b(bounds[2*p+2]-bounds[2*p+1],src+bounds[2*p+1]);
+      const int i0 = merge_split(a,b,k0,comparison),
+                i1 = merge_split(a,b,k1,comparison);
+      std::merge(a.begin()+i0,a.begin()+i1,b.begin()+(k0-i0),b.begin()+(k1-i1),dst+lo+k0,comparison);
+    });
+    const int merged = (runs+1)/2;
+    for (int r=0;r<=merged;r++)
+      bounds[r] = bounds[min(2*r,runs)];
+    runs = merged;
+    std::swap(src,dst);
+  }
+  if (src!=x.data())
+    parallel_for(n,[&](const int i) { x[i] = src[i]; },grain);
+}
+
+template<class TArray> static inline void parallel_sort(const TArray& array) {
+  parallel_sort(array,std::less<typename TArray::Element>());
+}
+
+// LSD radix sort of integer keys, such as Morton codes, permuting values along with them.  Each pass distributes one
+// byte, and bytes on which all keys agree are skipped.  Blocks of keys are counted and scattered in parallel.
+template<class K,class V> static void radix_sort_helper(RawArray<K> keys, RawArray<V> values, const bool move_values) {
+  static_assert(is_integral<K>::value,"radix_sort requires integer keys");
+  typedef typename std::make_unsigned<K>::type U;
+  const U flip = is_signed<K>::value ? U(1)<<(8*sizeof(K)-1) : U(0); // Order signed keys correctly
+  const int n = keys.size(),
+            grain = 1<<14;
+  if (n<2)
+    return;
+  const int blocks = min((n-1)/grain+1,4*thread_count());
+  const auto block = [=](const int b) { return range(int(int64_t(n)*b/blocks),int(int64_t(n)*(b+1)/blocks)); };
+  const U first = U(keys[0]);
+  const U varying = parallel_reduce<U>(n,[&](const int i) { return U(U(keys[i])^first); },
+                                       [](U& a, const U b) { a |= b; },grain);
+
+  Array<K> key_buffer(n,uninit);
+  Array<V> value_buffer(move_values?n:0,uninit);
+  K* ksrc = keys.data();
+  K* kdst = key_buffer.data();
+  V* vsrc = values.data();
+  V* vdst = value_buffer.data();
+  std::vector<int> counts(256*blocks);
+  for (int shift=0;shift<int(8*sizeof(K));shift+=8) {
+    if (!((varying>>shift)&0xff))
+      continue;
+    const auto digit = [=](const K key) { return int(((U(key)^flip)>>shift)&0xff); };
+    std::fill(counts.begin(),counts.end(),0);
+    parallel_for(blocks,[&](const int b) {
+      int* count = &counts[256*b];
+      for (const int i : block(b))
+        count[digit(ksrc[i])]++;
+    });
+    // Offsets are ordered by digit, then block, which keeps the sort stable
+    for (int d=0,offset=0;d<256;d++)
+      for (int b=0;b<blocks;b++) {
+        const int c = counts[256*b+d];
+        counts[256*b+d] = offset;
+        offset += c;
+      }
+    parallel_for(blocks,[&](const int b) {
+      int* offset = &counts[256*b];
+      for (const int i : block(b)) {
+        const int j = offset[digit(ksrc[i])]++;
+        kdst[j] = ksrc[i];
+        if (move_values)
+          vdst[j] = vsrc[i];
+      }
+    });
+    std::swap(ksrc,kdst);
+    std::swap(vsrc,vdst);
+  }
+  if (ksrc!=keys.data())
+    parallel_for(n,[&](const int i) {
+      keys[i] = ksrc[i];
+      if (move_values)
+        values[i] = vsrc[i];
+    },grain);
+}
+
+template<class TK,class TV> static inline void radix_sort(const TK& keys, const TV& values) {
+  const RawArray<typename TK::Element> k = keys;
+  const RawArray<typename TV::Element> v = values;
+  GEODE_ASSERT(k.size()==v.size());
+  radix_sort_helper(k,v,true);
+}
+
+template<class TK> static inline void radix_sort(const TK& keys) {
+  radix_sort_helper(RawArray<typename TK::Element>(keys),RawArray<int>(),false);
+}
+
+// The stable order of integer keys: indices i such that keys[order[i]] is sorted
+template<class TK> static inline Array<int> radix_sort_order(const TK& keys) {
+  auto copy = RawArray<const typename TK::Element>(keys).copy();
+  Array<int> order(copy.size(),uninit);
+  parallel_for(order.size(),[&](const int i) { order[i] = i; },1<<14);
+  radix_sort(copy,order);
+  return order;
+}
+
 }
@@ -6,6 +6,10 @@
 #include <geode/python/Class.h>
 #include <geode/python/from_python.h>
 #include <geode/python/to_python.h>
+#include <geode/math/max.h>
+#include <geode/math/min.h>
+#include <geode/math/constants.h>
+#include <geode/math/sqr.h>
 namespace geode {
 
 template<> GEODE_DEFINE_TYPE(MaxStencil<int>)
@@ -13,6 +17,147 @@ template<> GEODE_DEFINE_TYPE(MaxStencil<float>)
 template<> GEODE_DEFINE_TYPE(MaxStencil<double>)
 template<> GEODE_DEFINE_TYPE(MaxStencil<uint8_t>)
 
+namespace {
+template<class T> struct MaxOp {
+  static T identity() { return numeric_limits<T>::lowest(); }
+  static T apply(const T a, const T b) { return max(a,b); }
+};
+template<class T> struct MinOp {
+  static T identity() { return numeric_limits<T>::max(); }
+  static T apply(const T a, const T b) { return min(a,b); }
+};
+}
+
+// Length of the padded line for van Herk/Gil-Werman: room for r samples of padding on either side, rounded up to a
+// whole number of windows.
+static inline int padded_size(const int n, const int r) {
+  const int k = 2*r+1;
+  return (n+2*r+k-1)/k*k;
+}
+
+// Filter each row of a along its contiguous axis with radius r.  For windows of size k = 2r+1, the padded line is split
+// into blocks of size k, g holds prefix results and h suffix results within each block, and each window is the
+// combination of one suffix and one prefix.
+template<class Op,class T> static void filter_rows(RawArray<const T,2> a, RawArray<T,2> out, const int r) {
+  const int m = a.m, n = a.n, k = 2*r+1, N = padded_size(n,r);
+  #pragma omp parallel
+  {
+    Array<T> p(N,uninit), g(N,uninit), h(N,uninit);
+    #pragma omp for
+    for (int i=0;i<m;i++) {
+      for (int q=0;q<N;q++)
+        p[q] = unsigned(q-r)<unsigned(n) ? a(i,q-r) : Op::identity();
+      for (int b=0;b<N;b+=k) {
+        g[b] = p[b];
+        for (int q=b+1;q<b+k;q++)
+          g[q] = Op::apply(g[q-1],p[q]);
+        h[b+k-1] = p[b+k-1];
+        for (int q=b+k-2;q>=b;q--)
+          h[q] = Op::apply(h[q+1],p[q]);
+      }
+      for (int j=0;j<n;j++)
+        out(i,j) = Op::apply(h[j],g[j+2*r]);
+    }
+  }
+}
+
+// Filter each column of a with radius r, combining the result into out.  Columns are processed in chunks of adjacent
+// columns so that the inner loops are contiguous and vectorize.
+template<class Op,class T> static void filter_columns(RawArray<const T,2> a, RawArray<T,2> out, const int r) {
+  const int m = a.m, n = a.n, k = 2*r+1, N = padded_size(m,r);
+  const int width = 64;
+  #pragma omp parallel
+  {
+    Array<T,2> p(N,width,uninit), g(N,width,uninit), h(N,width,uninit);
+    #pragma omp for schedule(dynamic,1)
+    for (int c0=0;c0<n;c0+=width) {
+      const int w = min(width,n-c0);
+      for (int q=0;q<N;q++) {
+        if (unsigned(q-r)<unsigned(m))
+          for (int c=0;c<w;c++)
+            p(q,c) = a(q-r,c0+c);
+        else
+          for (int c=0;c<w;c++)
+            p(q,c) = Op::identity();
+      }
+      for (int b=0;b<N;b+=k) {
+        for (int c=0;c<w;c++)
+          g(b,c) = p(b,c);
+        for (int q=b+1;q<b+k;q++)
+          for (int c=0;c<w;c++)
+            g(q,c) = Op::apply(g(q-1,c),p(q,c));
+        for (int c=0;c<w;c++)
+          h(b+k-1,c) = p(b+k-1,c);
+        for (int q=b+k-2;q>=b;q--)
+          for (int c=0;c<w;c++)
+            h(q,c) = Op::apply(h(q+1,c),p(q,c));
+      }
+      for (int i=0;i<m;i++)
+        for (int c=0;c<w;c++)
+          out(i,c0+c) = Op::apply(out(i,c0+c),Op::apply(h(i,c),g(i+2*r,c)));
+    }
+  }
+}
+
+template<class Op,class T> static Array<T,2> rectangle_filter(RawArray<const T,2> a, const Vector<int,2> r) {
+  GEODE_ASSERT(r.min()>=0);
+  Array<T,2> rows(a.sizes(),uninit);
+  filter_rows<Op,T>(a,rows,r.y);
+  Array<T,2> out(a.sizes(),uninit);
+  out.flat.fill(Op::identity());
+  filter_columns<Op,T>(rows,out,r.x);
+  return out;
+}
+
+// The disk is the union of the rectangles [-h,h] x [-w,w] with h = floor(sqrt(r^2-w^2)), and only the rectangles not
+// contained in the next wider one are needed.
+template<class Op,class T> static Array<T,2> disk_filter(RawArray<const T,2> a, const int r) {
+  GEODE_ASSERT(r>=0);
+  const auto height = [=](const int w) {
+    int h = int(sqrt(double(sqr(r)-sqr(w))));
+    while (sqr(h+1)+sqr(w)<=sqr(r)) h++;
+    while (sqr(h)+sqr(w)>sqr(r)) h--;
+    return h;
+  };
+  Array<T,2> rows(a.sizes(),uninit);
+  Array<T,2> out(a.sizes(),uninit);
+  out.flat.fill(Op::identity());
+  for (int w=0;w<=r;w++) {
+    const int h = height(w);
+    if (w<r && height(w+1)==h)
+      continue;
+    filter_rows<Op,T>(a,rows,w);
+    filter_columns<Op,T>(rows,out,h);
+  }
+  return out;
+}
+
+template<class T> Array<T,2> rectangle_max_filter(RawArray<const T,2> a, const Vector<int,2> r) {
+  return rectangle_filter<MaxOp<T>>(a,r);
+}
+
+template<class T> Array<T,2> rectangle_min_filter(RawArray<const T,2> a, const Vector<int,2> r) {
+  return rectangle_filter<MinOp<T>>(a,r);
+}
+
+template<class T> Array<T,2> disk_max_filter(RawArray<const T,2> a, const int r) {
+  return disk_filter<MaxOp<T>>(a,r);
+}
+
+template<class T> Array<T,2> disk_min_filter(RawArray<const T,2> a, const int r) {
+  return disk_filter<MinOp<T>>(a,r);
+}
+
+#define INSTANTIATE(T) \
+  template GEODE_CORE_EXPORT Array<T,2> rectangle_max_filter(RawArray<const T,2>,const Vector<int,2>); \
+  template GEODE_CORE_EXPORT Array<T,2> rectangle_min_filter(RawArray<const T,2>,const Vector<int,2>); \
+  template GEODE_CORE_EXPORT Array<T,2> disk_max_filter(RawArray<const T,2>,const int); \
+  template GEODE_CORE_EXPORT Array<T,2> disk_min_filter(RawArray<const T,2>,const int);
+INSTANTIATE(int)
+INSTANTIATE(float)
+INSTANTIATE(double)
+INSTANTIATE(uint8_t)
+
 }
 using namespace geode;
 
@@ -27,5 +172,9 @@ void wrap_stencil() {
     .GEODE_FIELD(r)
     .GEODE_CALL(const Array<const typename Self::value_type,2>, Vector<int,2> const &)
     ;
+  GEODE_FUNCTION_2(rectangle_max_filter_uint8,rectangle_max_filter<T>)
+  GEODE_FUNCTION_2(rectangle_min_filter_uint8,rectangle_min_filter<T>)
+  GEODE_FUNCTION_2(disk_max_filter_uint8,disk_max_filter<T>)
+  GEODE_FUNCTION_2(disk_min_filter_uint8,disk_min_filter<T>)
 }
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <geode/array/Array.h>
+#include <geode/array/Array2d.h>
 
 namespace geode {
 
@@ -70,7 +71,8 @@ void apply_stencil(F &f, int w, const Array<T,d> a, const Array<T,d> b) {
 }
 
 // This is a sample stencil that computes the maximum over a spherical area of
-// radius r (on a 2D array)
+// radius r (on a 2D array).  It costs O(r^2) per sample; disk_max_filter below
+// is much faster for large r.
 template<class T>
 class MaxStencil: public Object {
 public:
@@ -98,4 +100,16 @@ public:
   }
 };
 
+// Max and min filters over the rectangles [i-r.x,i+r.x] x [j-r.y,j+r.y] of a
+// 2D array, using the van Herk/Gil-Werman algorithm.  Each pass costs O(1)
+// per sample regardless of radius, and rows or columns are processed in
+// parallel.  Samples outside the array are ignored.
+template<class T> GEODE_CORE_EXPORT Array<T,2> rectangle_max_filter(RawArray<const T,2> a, const Vector<int,2> r);
+template<class T> GEODE_CORE_EXPORT Array<T,2> rectangle_min_filter(RawArray<const T,2> a, const Vector<int,2> r);
+
+// Max and min filters over disks {(i,j) : i^2+j^2 <= r^2}, computed as the
+// union of the O(r) maximal rectangles inscribed in the disk.
+template<class T> GEODE_CORE_EXPORT Array<T,2> disk_max_filter(RawArray<const T,2> a, const int r);
+template<class T> GEODE_CORE_EXPORT Array<T,2> disk_min_filter(RawArray<const T,2> a, const int r);
+
 }
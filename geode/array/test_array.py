@@ -72,6 +72,7 @@ def test_write(filename=None):
 
 def test_nested():
   nested_test()
+  nested_builder_test()
   l = [[1,2],[3]]
   a = Nested(l,dtype=int32)
   assert a==nested_convert_test(a)==nested_convert_test(l)
@@ -80,6 +81,42 @@ def test_nested():
   print na,nested_convert_test(na),nested_convert_test(n)
   assert na==nested_convert_test(na)==nested_convert_test(n)
   assert a==pickle.loads(pickle.dumps(a))
+  # Lists of mixed arrays and lists, strided arrays, and other dtypes are converted with one allocation
+  m = [asarray([1,2],dtype=int16),[3],arange(8,dtype=int32)[::4]]
+  assert nested_convert_test(m)==Nested([[1,2],[3],[0,4]],dtype=int32)
+  assert nested_convert_test(n[:,::2])==Nested([[1,3],[4,6]],dtype=int32)
+  # Nested results share storage with their inputs
+  address = lambda x:x.__array_interface__['data'][0]
+  assert address(nested_convert_test(na).flat)==address(na.flat)
+
+def test_elementwise():
+  elementwise_test()
+
+def test_permute():
+  permute_test()
+
+def test_mapped():
+  random.seed(8121)
+  data = random.randn(100)
+  file = named_tmpfile(suffix='.bin')
+  data.tofile(file.name)
+  x = mapped_array_test(file.name,3)
+  assert all(x==data[3:])
+  assert x.base is not None and not x.flags.writeable
+  y = mapped_array(file.name,float64,shape=(9,11),offset=8)
+  assert all(y==data[1:].reshape(9,11)) and not y.flags.writeable
+  z = mapped_array(file.name,float64,writable=True)
+  z[:] = 0
+  assert all(fromfile(file.name)==data)
+
+def test_parallel_sort():
+  random.seed(1731)
+  for n in 0,1,100,100000:
+    x = random.randint(-1000,1000,size=n).astype(int32)
+    merged,radix,order = parallel_sort_test(x)
+    assert all(merged==sort(x))
+    assert all(radix==sort(x))
+    assert all(order==argsort(x,kind='mergesort'))
 
 if __name__=='__main__':
   test_write('array.npy')
@@ -23,5 +23,32 @@ def test_stencil():
         i = arange(r+1,m)
         assert all(diff[i]==-r)
 
+def test_max_filter():
+  random.seed(8131)
+  x = random.randint(0,256,size=(23,31)).astype(uint8)
+  for r in 0,1,3,8:
+    disk = [(i,j) for i in range(-r,r+1) for j in range(-r,r+1) if i*i+j*j<=r*r]
+    def brute(offsets,f):
+      y = empty_like(x)
+      for i in range(x.shape[0]):
+        for j in range(x.shape[1]):
+          y[i,j] = f([x[i+a,j+b] for a,b in offsets if 0<=i+a<x.shape[0] and 0<=j+b<x.shape[1]])
+      return y
+    assert all(disk_max_filter_uint8(x,r)==brute(disk,max))
+    assert all(disk_min_filter_uint8(x,r)==brute(disk,min))
+    rect = [(i,j) for i in range(-r,r+1) for j in range(-2,3)]
+    assert all(rectangle_max_filter_uint8(x,(r,2))==brute(rect,max))
+    assert all(rectangle_min_filter_uint8(x,(r,2))==brute(rect,min))
+
+def test_bricked():
+  random.seed(8133)
+  for shape in (1,1,1),(8,8,8),(5,17,9),(20,3,33):
+    x = random.randn(*shape)
+    p = pad(x,1,mode='constant')
+    y = -x+p[:-2,1:-1,1:-1]+p[2:,1:-1,1:-1]+p[1:-1,:-2,1:-1]+p[1:-1,2:,1:-1]+p[1:-1,1:-1,:-2]+p[1:-1,1:-1,2:]
+    assert allclose(bricked_test(x),y)
+
 if __name__ == '__main__':
   test_stencil()
+  test_max_filter()
+  test_bricked()
@@ -0,0 +1,217 @@
+// Benchmark registry and the geode_bench driver
+//
+// Usage: geode_bench [options]
+//   --list               List benchmarks and exit
+//   --filter <s>         Run only benchmarks whose names contain s
+//   --micro, --macro     Run only micro or only macro benchmarks
+//   --repetitions <n>    Repetitions per benchmark (default 5)
+//   --min-time <t>       Minimum seconds per micro benchmark repetition (default 0.2)
+//   --threads <n>        Thread count for parallel code (default: all cores)
+//   --json <file>        Write results as JSON, usable as a baseline later
+//   --baseline <file>    Compare median times against a file written by --json
+//   --tolerance <x>      Relative slowdown counted as a regression (default 0.1)
+//
+// The exit status is 1 if any benchmark threw or regressed against the baseline.
+
+#include <geode/benchmark/benchmark.h>
+#include <geode/python/exceptions.h>
+#include <geode/utility/format.h>
+#include <geode/utility/parallel.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <map>
+namespace geode {
+
+static vector<Benchmark>& registry() {
+  static vector<Benchmark> registry;
+  return registry;
+}
+
+RegisterBenchmark::RegisterBenchmark(const char* group, const char* name, const bool macro,
+                                     void (*run)(BenchmarkState&)) {
+  const Benchmark b = {format("%s/%s",group,name),macro,run};
+  registry().push_back(b);
+}
+
+vector<Benchmark> benchmarks() {
+  auto list = registry();
+  std::sort(list.begin(),list.end(),[](const Benchmark& a, const Benchmark& b) { return a.name<b.name; });
+  return list;
+}
+
+namespace {
+struct Result {
+  string name;
+  bool macro;
+  int64_t iterations; // Total over repetitions
+  int repetitions;
+  double min, median, mean, stddev; // Seconds per iteration
+  double items_per_second; // 0 if the benchmark doesn't report items
+};
+}
+
+static Result run(const Benchmark& b, const int repetitions, const double min_time) {
+  Result r;
+  r.name = b.name;
+  r.macro = b.macro;
+  r.iterations = 0;
+  r.repetitions = repetitions;
+  r.items_per_second = 0;
+  vector<double> times;
+  double total = 0;
+  for (int i=0;i<repetitions;i++) {
+    BenchmarkState state(b.macro,min_time);
+    b.run(state);
+    if (!state.iterations())
+      throw RuntimeError(format("benchmark %s never ran its loop",b.name));
+    times.push_back(state.elapsed()/state.iterations());
+    r.iterations += state.iterations();
+    if (state.items_per_iteration)
+      r.items_per_second += state.items_per_iteration/times.back()/repetitions;
+    total += times.back();
+  }
+  std::sort(times.begin(),times.end());
+  const int n = times.size();
+  r.min = times[0];
+  r.median = n&1 ? times[n/2] : (times[n/2-1]+times[n/2])/2;
+  r.mean = total/n;
+  double sqr = 0;
+  for (const double t : times)
+    sqr += (t-r.mean)*(t-r.mean);
+  r.stddev = n>1 ? sqrt(sqr/(n-1)) : 0;
+  return r;
+}
+
+static string format_time(const double t) {
+  return t<1e-6 ? format("%.1f ns",1e9*t)
+       : t<1e-3 ? format("%.2f us",1e6*t)
+       : t<1    ? format("%.2f ms",1e3*t)
+                : format("%.3f s",t);
+}
+
+static void write_json(const string& filename, const vector<Result>& results, const int repetitions,
+                       const double min_time) {
+  std::ofstream out(filename.c_str());
+  if (!out)
+    throw IOError(format("can't open '%s' for writing",filename));
+  // One benchmark per line, so that read_baseline can stay simple
+  out << format("{\n  \"context\": {\"threads\": %d, \"repetitions\": %d, \"min_time\": %g},\n  \"benchmarks\": [\n",
+                thread_count(),repetitions,min_time);
+  for (int i=0;i<int(results.size());i++) {
+    const auto& r = results[i];
+    out << format("    {\"name\": \"%s\", \"macro\": %s, \"iterations\": %lld, \"repetitions\": %d, \"min\": %.9g, "
+                  "\"median\": %.9g, \"mean\": %.9g, \"stddev\": %.9g, \"items_per_second\": %.9g}%s\n",
+                  r.name,r.macro?"true":"false",(long long)r.iterations,r.repetitions,r.min,r.median,r.mean,r.stddev,
+                  r.items_per_second,i+1<int(results.size())?",":"");
+  }
+  out << "  ]\n}\n";
+  if (!out)
+    throw IOError(format("error writing '%s'",filename));
+}
+
+// Median times by name from a file written by write_json
+static std::map<string,double> read_baseline(const string& filename) {
+  std::ifstream in(filename.c_str());
+  if (!in)
+    throw IOError(format("can't open baseline '%s'",filename));
+  std::map<string,double> medians;
+  string line;
+  while (std::getline(in,line)) {
+    const auto name = line.find("\"name\": \""), median = line.find("\"median\": ");
+    if (name==string::npos || median==string::npos)
+      continue;
+    const auto start = name+9, end = line.find('"',start);
+    medians[line.substr(start,end-start)] = atof(line.c_str()+median+10);
+  }
+  return medians;
+}
+
+static int usage(const char* program) {
+  fprintf(stderr,"usage: %s [--list] [--filter <s>] [--micro|--macro] [--repetitions <n>] [--min-time <t>]\n"
+                 "  [--threads <n>] [--json <file>] [--baseline <file>] [--tolerance <x>]\n",program);
+  return 1;
+}
+
+static int bench_main(const int argc, char** argv) {
+  bool list = false, micro = true, macro = true;
+  string filter, json, baseline;
+  int repetitions = 5;
+  double min_time = .2, tolerance = .1;
+  for (int i=1;i<argc;i++) {
+    const string arg = argv[i];
+    const bool has_value = i+1<argc;
+    if (arg=="--list") list = true;
+    else if (arg=="--micro") macro = false;
+    else if (arg=="--macro") micro = false;
+    else if (arg=="--filter" && has_value) filter = argv[++i];
+    else if (arg=="--repetitions" && has_value) repetitions = atoi(argv[++i]);
+    else if (arg=="--min-time" && has_value) min_time = atof(argv[++i]);
+    else if (arg=="--threads" && has_value) set_thread_count(atoi(argv[++i]));
+    else if (arg=="--json" && has_value) json = argv[++i];
+    else if (arg=="--baseline" && has_value) baseline = argv[++i];
+    else if (arg=="--tolerance" && has_value) tolerance = atof(argv[++i]);
+    else return usage(argv[0]);
+  }
+  if (repetitions<1 || min_time<0 || tolerance<0)
+    return usage(argv[0]);
+
+  vector<Benchmark> selected;
+  for (const auto& b : benchmarks())
+    if ((b.macro ? macro : micro) && b.name.find(filter)!=string::npos)
+      selected.push_back(b);
+  if (list) {
+    for (const auto& b : selected)
+      printf("%s%s\n",b.name.c_str(),b.macro?" (macro)":"");
+    return 0;
+  }
+  const auto base = baseline.size() ? read_baseline(baseline) : std::map<string,double>();
+
+  int status = 0;
+  vector<Result> results;
+  printf("%-40s %12s %12s %10s %12s %14s%s\n","benchmark","median","min","stddev","iterations","items/s",
+         base.size()?"   vs baseline":"");
+  for (const auto& b : selected) {
+    printf("%-40s",b.name.c_str());
+    fflush(stdout);
+    try {
+      const auto r = run(b,repetitions,min_time);
+      results.push_back(r);
+      printf(" %12s %12s %9.1f%% %12lld",format_time(r.median).c_str(),format_time(r.min).c_str(),
+             100*r.stddev/r.mean,(long long)r.iterations);
+      if (r.items_per_second)
+        printf(" %14.4g",r.items_per_second);
+      else
+        printf(" %14s","");
+      const auto it = base.find(r.name);
+      if (it!=base.end()) {
+        const double ratio = r.median/it->second;
+        const bool regressed = ratio>1+tolerance;
+        printf("   %+.1f%%%s",100*(ratio-1),regressed?" REGRESSION":"");
+        status |= regressed;
+      } else if (base.size())
+        printf("   new");
+      printf("\n");
+    } catch (const std::exception& e) {
+      printf(" failed: %s\n",e.what());
+      status = 1;
+    }
+  }
+  if (json.size())
+    write_json(json,results,repetitions,min_time);
+  return status;
+}
+
+}
+
+int main(int argc, char** argv) {
+  try {
+    return geode::bench_main(argc,argv);
+  } catch (const std::exception& e) {
+    fprintf(stderr,"geode_bench: %s\n",e.what());
+    return 1;
+  }
+}
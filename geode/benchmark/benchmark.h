@@ -0,0 +1,125 @@
+//#####################################################################
+// Benchmarks
+//#####################################################################
+//
+// geode_bench runs the benchmarks registered with GEODE_BENCHMARK, in the
+// style of Google Benchmark.  The body does its setup untimed, then times
+// the loop over state.running():
+//
+//   GEODE_BENCHMARK(structure,hashtable_insert) {
+//     const auto keys = random_keys(1<<20);
+//     while (state.running()) {
+//       Hashtable<int> table;
+//       for (const int k : keys)
+//         table.set(k);
+//     }
+//     state.items(keys.size());
+//   }
+//
+// Benchmarks are named group/name, and may be marked macro with
+// GEODE_MACRO_BENCHMARK.  Micro benchmarks run until each repetition has
+// taken min_time, macro benchmarks (whole pipelines on large inputs) run
+// once per repetition.  Per iteration times are reported as min, median,
+// mean and standard deviation over repetitions, and can be written as JSON
+// and compared against a baseline file; see benchmark.cpp for the options.
+//
+//#####################################################################
+#pragma once
+
+#include <geode/utility/config.h>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+namespace geode {
+
+using std::string;
+using std::vector;
+
+class BenchmarkState {
+  typedef std::chrono::steady_clock Clock;
+  const int64_t target; // Iterations per repetition, or 0 to run until min_time has passed
+  const double min_time;
+  int64_t done;
+  bool started, paused;
+  Clock::time_point start;
+  Clock::duration elapsed_;
+public:
+  int64_t items_per_iteration; // For throughput, set with items()
+
+  BenchmarkState(const int64_t target, const double min_time)
+    : target(target), min_time(min_time), done(0), started(false), paused(false), elapsed_(0)
+    , items_per_iteration(0) {}
+
+  // Whether to run another iteration.  The first call starts the clock.
+  bool running() {
+    if (!started) {
+      started = true;
+      start = Clock::now();
+      return true;
+    }
+    done++;
+    if (target ? done<target : (done&(done-1)) || elapsed()<min_time) // Check the clock only at powers of two
+      return true;
+    if (!paused)
+      elapsed_ += Clock::now()-start;
+    return false;
+  }
+
+  // Exclude per iteration setup from the timing
+  void pause() {
+    if (!paused) {
+      elapsed_ += Clock::now()-start;
+      paused = true;
+    }
+  }
+
+  void resume() {
+    if (paused) {
+      start = Clock::now();
+      paused = false;
+    }
+  }
+
+  // Report n items processed per iteration
+  void items(const int64_t n) {
+    items_per_iteration = n;
+  }
+
+  int64_t iterations() const {
+    return done;
+  }
+
+  // Timed seconds so far
+  double elapsed() const {
+    return std::chrono::duration<double>(paused ? elapsed_ : elapsed_+(Clock::now()-start)).count();
+  }
+};
+
+struct Benchmark {
+  string name; // group/name
+  bool macro;
+  void (*run)(BenchmarkState&);
+};
+
+// All registered benchmarks, sorted by name
+vector<Benchmark> benchmarks();
+
+struct RegisterBenchmark {
+  RegisterBenchmark(const char* group, const char* name, const bool macro, void (*run)(BenchmarkState&));
+};
+
+// Keep the compiler from optimizing away a computed value
+template<class T> static inline void do_not_optimize(const T& value) {
+  asm volatile("" : : "g"(&value) : "memory");
+}
+
+#define GEODE_BENCHMARK_HELPER(group,name,macro) \
+  static void bench_##group##_##name(::geode::BenchmarkState& state); \
+  static const ::geode::RegisterBenchmark register_##group##_##name(#group,#name,macro,bench_##group##_##name); \
+  static void bench_##group##_##name(::geode::BenchmarkState& state)
+
+#define GEODE_BENCHMARK(group,name) GEODE_BENCHMARK_HELPER(group,name,false)
+#define GEODE_MACRO_BENCHMARK(group,name) GEODE_BENCHMARK_HELPER(group,name,true)
+
+}
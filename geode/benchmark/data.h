@@ -0,0 +1,47 @@
+// Generated inputs shared by several benchmarks
+#pragma once
+
+#include <geode/array/Array.h>
+#include <geode/array/Nested.h>
+#include <geode/array/view.h>
+#include <geode/geometry/platonic.h>
+#include <geode/math/constants.h>
+#include <geode/mesh/TriangleSoup.h>
+#include <geode/random/Random.h>
+#include <geode/vector/Vector.h>
+namespace geode {
+
+// n points uniform in [-1,1]^d
+template<int d> static inline Array<Vector<real,d>> random_points(const int n, const int seed=1) {
+  Array<Vector<real,d>> X(n,uninit);
+  new_<Random>(seed)->fill_uniform(scalar_view(X),-1,1);
+  return X;
+}
+
+// A sphere mesh refined the given number of times, with vertices displaced radially by up to noise
+static inline Tuple<Ref<TriangleSoup>,Array<Vector<real,3>>> noisy_sphere(const int refinements, const real noise,
+                                                                         const int seed=1) {
+  const auto sphere = sphere_mesh(refinements);
+  const auto random = new_<Random>(seed);
+  for (auto& x : sphere.y)
+    x *= 1+random->uniform<real>(-noise,noise);
+  return sphere;
+}
+
+// count random star shaped polygons with the given number of vertices, centered in [-1,1]^2
+static inline Nested<Vector<real,2>> random_polygons(const int count, const int vertices, const int seed=1) {
+  const auto random = new_<Random>(seed);
+  Array<int> lengths(count,uninit);
+  lengths.fill(vertices);
+  const Nested<Vector<real,2>> polys(lengths,uninit);
+  for (int p=0;p<count;p++) {
+    const auto center = random->uniform(Vector<real,2>(-1,-1),Vector<real,2>(1,1));
+    for (int i=0;i<vertices;i++) {
+      const real angle = 2*pi*i/vertices;
+      polys[p][i] = center+random->uniform<real>(.05,.3)*Vector<real,2>(cos(angle),sin(angle));
+    }
+  }
+  return polys;
+}
+
+}
@@ -0,0 +1,70 @@
+// Exact geometry benchmarks: Delaunay, polygon and mesh CSG
+
+#include <geode/benchmark/benchmark.h>
+#include <geode/benchmark/data.h>
+#include <geode/exact/delaunay.h>
+#include <geode/exact/mesh_csg.h>
+#include <geode/exact/polygon_csg.h>
+#include <geode/random/workloads.h>
+namespace geode {
+
+GEODE_MACRO_BENCHMARK(exact,delaunay_points) {
+  const auto X = random_points<2>(1<<18);
+  while (state.running())
+    do_not_optimize(delaunay_points(X));
+  state.items(X.size());
+}
+
+GEODE_MACRO_BENCHMARK(exact,delaunay_points_parallel) {
+  const auto X = random_points<2>(1<<19);
+  while (state.running())
+    do_not_optimize(delaunay_points(X,Tuple<>(),false,true));
+  state.items(X.size());
+}
+
+GEODE_MACRO_BENCHMARK(exact,delaunay_clustered) {
+  const auto X = clustered_points(1<<18,64,.01,1);
+  while (state.running())
+    do_not_optimize(delaunay_points(X));
+  state.items(X.size());
+}
+
+GEODE_MACRO_BENCHMARK(exact,delaunay_lattice) {
+  const auto X = lattice_points(1<<17,512,1);
+  while (state.running())
+    do_not_optimize(delaunay_points(X));
+  state.items(X.size());
+}
+
+GEODE_MACRO_BENCHMARK(exact,split_grid_polygons) {
+  const auto polys = grid_polygons(2000,100,1);
+  while (state.running())
+    do_not_optimize(split_polygons(polys,0));
+  state.items(polys.size());
+}
+
+GEODE_MACRO_BENCHMARK(exact,split_polygons) {
+  const auto polys = random_polygons(500,20);
+  while (state.running())
+    do_not_optimize(split_polygons(polys,0));
+  state.items(polys.flat.size());
+}
+
+GEODE_MACRO_BENCHMARK(exact,split_soup) {
+  // Two overlapping noisy spheres
+  const auto a = noisy_sphere(5,.01,1), b = noisy_sphere(5,.01,2);
+  const auto faces = new_<TriangleSoup>(concatenate(a.x->elements,b.x->elements+a.y.size()));
+  const auto X = concatenate(a.y,b.y+Vector<real,3>(.7,.2,.1));
+  while (state.running())
+    do_not_optimize(split_soup(faces,X,0));
+  state.items(faces->elements.size());
+}
+
+GEODE_MACRO_BENCHMARK(exact,split_soup_coplanar_boxes) {
+  const auto boxes = near_coplanar_boxes(64,4,1e-5,1);
+  while (state.running())
+    do_not_optimize(split_soup(boxes.x,boxes.y,0));
+  state.items(boxes.x->elements.size());
+}
+
+}
@@ -0,0 +1,37 @@
+// Force evaluation benchmarks
+
+#include <geode/benchmark/benchmark.h>
+#include <geode/benchmark/data.h>
+#include <geode/force/LinearBendingElements.h>
+namespace geode {
+
+typedef Vector<real,3> TV;
+
+GEODE_BENCHMARK(force,linear_bending_force) {
+  const auto sphere = noisy_sphere(6,.01);
+  const auto bend = new_<LinearBendingElements<TV>>(*sphere.x,sphere.y);
+  bend->stiffness = 1;
+  bend->update_position(sphere.y,false);
+  Array<TV> F(sphere.y.size());
+  while (state.running()) {
+    bend->add_elastic_force(F);
+    do_not_optimize(F[0]);
+  }
+  state.items(sphere.y.size());
+}
+
+GEODE_BENCHMARK(force,linear_bending_differential) {
+  const auto sphere = noisy_sphere(6,.01);
+  const auto bend = new_<LinearBendingElements<TV>>(*sphere.x,sphere.y);
+  bend->stiffness = 1;
+  bend->update_position(sphere.y,false);
+  const auto dX = random_points<3>(sphere.y.size());
+  Array<TV> dF(sphere.y.size());
+  while (state.running()) {
+    bend->add_elastic_differential(dF,dX);
+    do_not_optimize(dF[0]);
+  }
+  state.items(sphere.y.size());
+}
+
+}
@@ -0,0 +1,49 @@
+// Bounding box tree benchmarks
+
+#include <geode/benchmark/benchmark.h>
+#include <geode/benchmark/data.h>
+#include <geode/geometry/ParticleTree.h>
+#include <geode/geometry/SimplexTree.h>
+namespace geode {
+
+typedef Vector<real,3> TV;
+
+GEODE_BENCHMARK(geometry,particle_tree_build) {
+  const auto X = random_points<3>(1<<18);
+  while (state.running())
+    do_not_optimize(new_<ParticleTree<TV>>(X,4));
+  state.items(X.size());
+}
+
+GEODE_BENCHMARK(geometry,particle_tree_closest_point) {
+  const auto X = random_points<3>(1<<18);
+  const auto queries = random_points<3>(1<<14,2);
+  const auto tree = new_<ParticleTree<TV>>(X,4);
+  while (state.running())
+    for (const auto& q : queries)
+      do_not_optimize(tree->closest_point(q));
+  state.items(queries.size());
+}
+
+GEODE_BENCHMARK(geometry,simplex_tree_build) {
+  const auto sphere = sphere_mesh(6);
+  while (state.running())
+    do_not_optimize(new_<SimplexTree<TV,2>>(*sphere.x,sphere.y,4));
+  state.items(sphere.x->elements.size());
+}
+
+GEODE_BENCHMARK(geometry,simplex_tree_closest_points) {
+  const auto sphere = sphere_mesh(6);
+  const auto tree = new_<SimplexTree<TV,2>>(*sphere.x,sphere.y,4);
+  const auto queries = random_points<3>(1<<14,2);
+  while (state.running())
+    do_not_optimize(tree->closest_points(queries));
+  state.items(queries.size());
+}
+
+GEODE_BENCHMARK(geometry,sphere_mesh) {
+  while (state.running())
+    do_not_optimize(sphere_mesh(6));
+}
+
+}
@@ -0,0 +1,34 @@
+// Mesh construction and decimation benchmarks
+
+#include <geode/benchmark/benchmark.h>
+#include <geode/benchmark/data.h>
+#include <geode/mesh/decimate.h>
+#include <geode/random/workloads.h>
+namespace geode {
+
+GEODE_BENCHMARK(mesh,topology_from_soup) {
+  const auto sphere = sphere_mesh(6);
+  while (state.running())
+    do_not_optimize(new_<TriangleTopology>(*sphere.x));
+  state.items(sphere.x->elements.size());
+}
+
+GEODE_MACRO_BENCHMARK(mesh,decimate_noisy_sphere) {
+  const auto sphere = noisy_sphere(6,.002);
+  const auto mesh = new_<TriangleTopology>(*sphere.x);
+  const Field<const Vector<real,3>,VertexId> X(sphere.y);
+  while (state.running())
+    do_not_optimize(decimate(*mesh,X,.01));
+  state.items(mesh->n_faces());
+}
+
+GEODE_MACRO_BENCHMARK(mesh,decimate_high_valence) {
+  const auto fans = high_valence_mesh(64,64,32,.01,1);
+  const auto mesh = new_<TriangleTopology>(*fans.x);
+  const Field<const Vector<real,3>,VertexId> X(fans.y);
+  while (state.running())
+    do_not_optimize(decimate(*mesh,X,.01));
+  state.items(mesh->n_faces());
+}
+
+}
@@ -0,0 +1,40 @@
+// Bulk random number generation benchmarks
+
+#include <geode/benchmark/benchmark.h>
+#include <geode/random/Random.h>
+#include <geode/random/workloads.h>
+namespace geode {
+
+GEODE_BENCHMARK(random,fill_uniform) {
+  const auto random = new_<Random>(1);
+  Array<real> x(1<<20,uninit);
+  while (state.running()) {
+    random->fill_uniform(x);
+    do_not_optimize(x[0]);
+  }
+  state.items(x.size());
+}
+
+GEODE_BENCHMARK(random,fill_normal) {
+  const auto random = new_<Random>(1);
+  Array<real> x(1<<20,uninit);
+  while (state.running()) {
+    random->fill_normal(x);
+    do_not_optimize(x[0]);
+  }
+  state.items(x.size());
+}
+
+GEODE_BENCHMARK(random,clustered_points) {
+  while (state.running())
+    do_not_optimize(clustered_points(1<<20,64,.01,1));
+  state.items(1<<20);
+}
+
+GEODE_BENCHMARK(random,high_valence_mesh) {
+  while (state.running())
+    do_not_optimize(high_valence_mesh(256,256,16,.01,1));
+  state.items(256*256*16);
+}
+
+}
@@ -0,0 +1,41 @@
+// Hashtable benchmarks
+
+#include <geode/benchmark/benchmark.h>
+#include <geode/random/Random.h>
+#include <geode/structure/Hashtable.h>
+namespace geode {
+
+static Array<int> random_keys(const int n) {
+  const auto random = new_<Random>(7);
+  Array<int> keys(n,uninit);
+  for (auto& k : keys)
+    k = random->bits<uint32_t>()>>1;
+  return keys;
+}
+
+GEODE_BENCHMARK(structure,hashtable_insert) {
+  const auto keys = random_keys(1<<20);
+  while (state.running()) {
+    Hashtable<int,int> table;
+    for (const int k : keys)
+      table.set(k,k);
+    do_not_optimize(table.size());
+  }
+  state.items(keys.size());
+}
+
+GEODE_BENCHMARK(structure,hashtable_find) {
+  const auto keys = random_keys(1<<21);
+  Hashtable<int,int> table;
+  for (const int k : keys.slice(0,keys.size()/2)) // Half the queries hit
+    table.set(k,k);
+  while (state.running()) {
+    int found = 0;
+    for (const int k : keys)
+      found += table.contains(k);
+    do_not_optimize(found);
+  }
+  state.items(keys.size());
+}
+
+}
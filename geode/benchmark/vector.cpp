@@ -0,0 +1,92 @@
+// Batched small matrix kernels versus per matrix loops
+
+#include <geode/benchmark/benchmark.h>
+#include <geode/array/view.h>
+#include <geode/random/Random.h>
+#include <geode/utility/parallel.h>
+#include <geode/vector/batch_blas.h>
+#include <geode/vector/batch_decompositions.h>
+namespace geode {
+
+typedef Matrix<real,3> TM;
+
+static Array<TM> random_matrices(const int n) {
+  Array<TM> A(n,uninit);
+  new_<Random>(1)->fill_normal(scalar_view(A));
+  return A;
+}
+
+static Array<SymmetricMatrix<real,3>> random_symmetric_matrices(const int n) {
+  const auto A = random_matrices(n);
+  Array<SymmetricMatrix<real,3>> S(n,uninit);
+  for (int i=0;i<n;i++)
+    S[i] = symmetric_part(A[i]);
+  return S;
+}
+
+GEODE_BENCHMARK(vector,eigen_scalar) {
+  const auto A = random_symmetric_matrices(1<<16);
+  Array<DiagonalMatrix<real,3>> D(A.size(),uninit);
+  Array<TM> V(A.size(),uninit);
+  while (state.running()) {
+    parallel_for(A.size(),[&](const int i) { A[i].fast_solve_eigenproblem(D[i],V[i]); },256);
+    do_not_optimize(V[0]);
+  }
+  state.items(A.size());
+}
+
+GEODE_BENCHMARK(vector,eigen_batch) {
+  const auto A = random_symmetric_matrices(1<<16);
+  Array<DiagonalMatrix<real,3>> D(A.size(),uninit);
+  Array<TM> V(A.size(),uninit);
+  while (state.running()) {
+    batch_solve_eigenproblem<real>(A,D,V);
+    do_not_optimize(V[0]);
+  }
+  state.items(A.size());
+}
+
+GEODE_BENCHMARK(vector,svd_scalar) {
+  const auto A = random_matrices(1<<16);
+  Array<DiagonalMatrix<real,3>> D(A.size(),uninit);
+  Array<TM> U(A.size(),uninit), V(A.size(),uninit);
+  while (state.running()) {
+    parallel_for(A.size(),[&](const int i) { A[i].fast_singular_value_decomposition(U[i],D[i],V[i]); },256);
+    do_not_optimize(V[0]);
+  }
+  state.items(A.size());
+}
+
+GEODE_BENCHMARK(vector,svd_batch) {
+  const auto A = random_matrices(1<<16);
+  Array<DiagonalMatrix<real,3>> D(A.size(),uninit);
+  Array<TM> U(A.size(),uninit), V(A.size(),uninit);
+  while (state.running()) {
+    batch_singular_value_decomposition<real>(A,U,D,V);
+    do_not_optimize(V[0]);
+  }
+  state.items(A.size());
+}
+
+GEODE_BENCHMARK(vector,gemm_scalar) {
+  const auto A = random_matrices(1<<16), B = random_matrices(1<<16);
+  Array<TM> C(A.size(),uninit);
+  while (state.running()) {
+    for (int i=0;i<A.size();i++)
+      C[i] = A[i]*B[i];
+    do_not_optimize(C[0]);
+  }
+  state.items(A.size());
+}
+
+GEODE_BENCHMARK(vector,gemm_batch) {
+  const auto A = random_matrices(1<<16), B = random_matrices(1<<16);
+  Array<TM> C(A.size(),uninit);
+  while (state.running()) {
+    batch_gemm(1,A,B,0,C);
+    do_not_optimize(C[0]);
+  }
+  state.items(A.size());
+}
+
+}
@@ -0,0 +1,317 @@
+// Conservative interval arithmetic on several independent intervals at once
+#pragma once
+
+// BatchInterval<n> performs the same conservative interval arithmetic as Interval, but on n independent
+// intervals at once.  It is used to filter the same predicate on many independent inputs: the predicate
+// is evaluated once on n-wide intervals, and only the inputs whose filter is ambiguous fall back to exact
+// arithmetic and symbolic perturbation (see perturbed_predicates below).
+//
+// With AVX, BatchInterval<4> packs four intervals into a pair of __m256d registers, and with AVX-512
+// BatchInterval<8> packs eight into a pair of __m512d registers.  Other widths use plain loops.
+//
+// IMPORTANT: As with Interval, all arithmetic must occur within an IntervalScope (see scope.h).
+
+#include <geode/exact/Interval.h>
+#include <geode/exact/perturb.h>
+#include <geode/array/RawArray.h>
+#include <geode/utility/IRange.h>
+#ifdef __AVX__
+#include <immintrin.h>
+#endif
+namespace geode {
+
+template<int n> struct BatchInterval;
+
+// Batches are scalars for the purposes of Vector arithmetic, just like Interval
+template<int n> struct IsScalar<BatchInterval<n>> : public mpl::true_ {};
+
+// The natural batch width for the target architecture
+#if defined(__AVX512F__)
+const int batch_interval_width = 8;
+#else
+const int batch_interval_width = 4;
+#endif
+
+// Negation which hides the identity x*-y = -(x*y) from clang (see safe_neg in Interval.h)
+static inline double batch_safe_neg(const double x) {
+#if defined(__clang__)
+  union { double x; uint64_t i; } u;
+  u.x = x;
+  u.i = u.i ^ (uint64_t(1)<<63);
+  return u.x;
+#else
+  return -x;
+#endif
+}
+
+// Portable version.  As in Interval, we store each interval [a,b] as (-a,b) so that only FE_UPWARD is needed.
+template<int n> struct BatchInterval {
+  static_assert(n>0,"");
+  typedef IntervalScope Scope;
+  typedef double T;
+
+  T nlo[n], hi[n];
+
+  BatchInterval() {
+    for (int i=0;i<n;i++)
+      nlo[i] = hi[i] = 0;
+  }
+
+  // Exact intervals for n values
+  explicit BatchInterval(const T* x) {
+    for (int i=0;i<n;i++) {
+      nlo[i] = -x[i];
+      hi[i] = x[i];
+    }
+  }
+
+  BatchInterval operator+(const BatchInterval& x) const {
+    assert(fegetround() == FE_UPWARD);
+    BatchInterval r;
+    for (int i=0;i<n;i++) {
+      r.nlo[i] = nlo[i]+x.nlo[i];
+      r.hi[i] = hi[i]+x.hi[i];
+    }
+    return r;
+  }
+
+  BatchInterval operator-(const BatchInterval& x) const {
+    assert(fegetround() == FE_UPWARD);
+    BatchInterval r;
+    for (int i=0;i<n;i++) {
+      r.nlo[i] = nlo[i]+x.hi[i];
+      r.hi[i] = hi[i]+x.nlo[i];
+    }
+    return r;
+  }
+
+  BatchInterval operator-() const {
+    BatchInterval r;
+    for (int i=0;i<n;i++) {
+      r.nlo[i] = hi[i];
+      r.hi[i] = nlo[i];
+    }
+    return r;
+  }
+
+  BatchInterval operator*(const BatchInterval& x) const {
+    assert(fegetround() == FE_UPWARD);
+    // See the SSE version of Interval::operator* for the derivation.  All products round upwards.
+    BatchInterval r;
+    for (int i=0;i<n;i++) {
+      const T na = nlo[i], b = hi[i],
+              nc = x.nlo[i], d = x.hi[i];
+      r.nlo[i] = max(max(na*d,b*nc),max(na*batch_safe_neg(nc),b*batch_safe_neg(d)));
+      r.hi[i] = max(max(na*nc,b*d),max(na*batch_safe_neg(d),b*batch_safe_neg(nc)));
+    }
+    return r;
+  }
+
+  BatchInterval& operator+=(const BatchInterval& x) { return *this = *this+x; }
+  BatchInterval& operator-=(const BatchInterval& x) { return *this = *this-x; }
+  BatchInterval& operator*=(const BatchInterval& x) { return *this = *this*x; }
+
+  // Bit i is set if interval i is certainly positive
+  int positive_mask() const {
+    int mask = 0;
+    for (int i=0;i<n;i++)
+      mask |= (nlo[i]<0)<<i;
+    return mask;
+  }
+
+  // Bit i is set if interval i is certainly negative
+  int negative_mask() const {
+    int mask = 0;
+    for (int i=0;i<n;i++)
+      mask |= (hi[i]<0)<<i;
+    return mask;
+  }
+
+  Interval operator[](const int i) const {
+    assert(unsigned(i)<unsigned(n));
+    Interval r(-nlo[i],hi[i]);
+    return r;
+  }
+};
+
+template<int n> static inline BatchInterval<n> sqr(const BatchInterval<n>& x) {
+  assert(fegetround() == FE_UPWARD);
+  BatchInterval<n> s;
+  for (int i=0;i<n;i++) {
+    const double nlo = x.nlo[i], hi = x.hi[i];
+    if (nlo < 0) { // x > 0
+      s.nlo[i] = nlo*batch_safe_neg(nlo);
+      s.hi[i] = hi*hi;
+    } else if (hi < 0) { // x < 0
+      s.nlo[i] = hi*batch_safe_neg(hi);
+      s.hi[i] = nlo*nlo;
+    } else { // 0 in x
+      s.nlo[i] = 0;
+      s.hi[i] = sqr(max(nlo,hi));
+    }
+  }
+  return s;
+}
+
+// Shifts are exact
+template<int n> static inline BatchInterval<n> operator<<(const BatchInterval<n>& x, const int p) {
+  assert(unsigned(p)<32);
+  const double y = 1<<p;
+  BatchInterval<n> s;
+  for (int i=0;i<n;i++) {
+    s.nlo[i] = y*x.nlo[i];
+    s.hi[i] = y*x.hi[i];
+  }
+  return s;
+}
+template<int n> static inline BatchInterval<n> operator>>(const BatchInterval<n>& x, const int p) {
+  assert(unsigned(p)<32);
+  const double y = 1./(1<<p);
+  BatchInterval<n> s;
+  for (int i=0;i<n;i++) {
+    s.nlo[i] = y*x.nlo[i];
+    s.hi[i] = y*x.hi[i];
+  }
+  return s;
+}
+
+// Define a register width specialization of BatchInterval.  V is the register type, and prefix the intrinsic prefix.
+// Negation flips the sign bit with xor to hide the identity x*-y = -(x*y) from clang (see safe_neg in Interval.h).
+#define GEODE_BATCH_INTERVAL(n,V,prefix,CMPLT,MASK) \
+  template<> struct BatchInterval<n> { \
+    typedef IntervalScope Scope; \
+    typedef double T; \
+    V nlo, hi; \
+    BatchInterval() : nlo(prefix##_setzero_pd()), hi(prefix##_setzero_pd()) {} \
+    BatchInterval(const V nlo, const V hi) : nlo(nlo), hi(hi) {} \
+    explicit BatchInterval(const T* x) : hi(prefix##_loadu_pd(x)) { nlo = neg(hi); } \
+    static V neg(const V x) { return prefix##_xor_pd(x,prefix##_set1_pd(-0.)); } \
+    BatchInterval operator+(const BatchInterval& x) const { \
+      assert(fegetround() == FE_UPWARD); \
+      return BatchInterval(prefix##_add_pd(nlo,x.nlo),prefix##_add_pd(hi,x.hi)); \
+    } \
+    BatchInterval operator-(const BatchInterval& x) const { \
+      assert(fegetround() == FE_UPWARD); \
+      return BatchInterval(prefix##_add_pd(nlo,x.hi),prefix##_add_pd(hi,x.nlo)); \
+    } \
+    BatchInterval operator-() const { \
+      return BatchInterval(hi,nlo); \
+    } \
+    BatchInterval operator*(const BatchInterval& x) const { \
+      assert(fegetround() == FE_UPWARD); \
+      const V nna = neg(nlo), \
+              nb = neg(hi); \
+      return BatchInterval(prefix##_max_pd(prefix##_max_pd(prefix##_mul_pd(nlo,x.hi),prefix##_mul_pd(hi,x.nlo)), \
+                                           prefix##_max_pd(prefix##_mul_pd(nna,x.nlo),prefix##_mul_pd(nb,x.hi))), \
+                           prefix##_max_pd(prefix##_max_pd(prefix##_mul_pd(nlo,x.nlo),prefix##_mul_pd(hi,x.hi)), \
+                                           prefix##_max_pd(prefix##_mul_pd(nna,x.hi),prefix##_mul_pd(nb,x.nlo)))); \
+    } \
+    BatchInterval& operator+=(const BatchInterval& x) { return *this = *this+x; } \
+    BatchInterval& operator-=(const BatchInterval& x) { return *this = *this-x; } \
+    BatchInterval& operator*=(const BatchInterval& x) { return *this = *this*x; } \
+    int positive_mask() const { return MASK(CMPLT(nlo,prefix##_setzero_pd())); } \
+    int negative_mask() const { return MASK(CMPLT(hi,prefix##_setzero_pd())); } \
+    Interval operator[](const int i) const { \
+      assert(unsigned(i)<unsigned(n)); \
+      union { V v; T d[n]; } a, b; \
+      a.v = nlo; \
+      b.v = hi; \
+      Interval r(-a.d[i],b.d[i]); \
+      return r; \
+    } \
+  }; \
+  \
+  static inline BatchInterval<n> sqr(const BatchInterval<n>& x) { \
+    assert(fegetround() == FE_UPWARD); \
+    /* Choose lo,hi magnitudes exactly as in the portable version, then square with upwards rounding.     */ \
+    /* Positive intervals square to (nlo*-nlo,hi*hi), negative to (hi*-hi,nlo*nlo), and others to (0,m*m). */ \
+    const V zero = prefix##_setzero_pd(); \
+    const auto pos = CMPLT(x.nlo,zero), \
+               negative = CMPLT(x.hi,zero); \
+    const V m = prefix##_max_pd(x.nlo,x.hi), \
+            lo = GEODE_BATCH_BLEND_##prefix(GEODE_BATCH_BLEND_##prefix(zero,x.hi,negative),x.nlo,pos), \
+            hi = GEODE_BATCH_BLEND_##prefix(GEODE_BATCH_BLEND_##prefix(m,x.nlo,negative),x.hi,pos); \
+    return BatchInterval<n>(prefix##_mul_pd(lo,BatchInterval<n>::neg(lo)),prefix##_mul_pd(hi,hi)); \
+  } \
+  \
+  static inline BatchInterval<n> operator<<(const BatchInterval<n>& x, const int p) { \
+    assert(unsigned(p)<32); \
+    const V y = prefix##_set1_pd(1<<p); \
+    return BatchInterval<n>(prefix##_mul_pd(y,x.nlo),prefix##_mul_pd(y,x.hi)); \
+  } \
+  static inline BatchInterval<n> operator>>(const BatchInterval<n>& x, const int p) { \
+    assert(unsigned(p)<32); \
+    const V y = prefix##_set1_pd(1./(1<<p)); \
+    return BatchInterval<n>(prefix##_mul_pd(y,x.nlo),prefix##_mul_pd(y,x.hi)); \
+  }
+
+#ifdef __AVX__
+#define GEODE_BATCH_CMPLT_4(a,b) _mm256_cmp_pd((a),(b),_CMP_LT_OQ)
+#define GEODE_BATCH_MASK_4(c) _mm256_movemask_pd(c)
+#define GEODE_BATCH_BLEND__mm256(a,b,c) _mm256_blendv_pd((a),(b),(c)) // c ? b : a
+GEODE_BATCH_INTERVAL(4,__m256d,_mm256,GEODE_BATCH_CMPLT_4,GEODE_BATCH_MASK_4)
+#endif
+
+#ifdef __AVX512F__
+#define GEODE_BATCH_CMPLT_8(a,b) _mm512_cmp_pd_mask((a),(b),_CMP_LT_OQ)
+#define GEODE_BATCH_MASK_8(c) int(c)
+#define GEODE_BATCH_BLEND__mm512(a,b,c) _mm512_mask_blend_pd((c),(a),(b)) // c ? b : a
+GEODE_BATCH_INTERVAL(8,__m512d,_mm512,GEODE_BATCH_CMPLT_8,GEODE_BATCH_MASK_8)
+#endif
+
+// Evaluate one perturbed predicate on a vector of arguments
+template<class F,int k,class PerturbedT,class... entries> static inline bool
+perturbed_predicate_unpack(const Vector<PerturbedT,k>& X, Types<entries...>) {
+  return perturbed_predicate<F>(X[entries::value]...);
+}
+
+// Evaluate a batch of n predicates with BatchInterval<n>, falling back to exact evaluation for ambiguous lanes
+template<class F,int n,int k,class PerturbedT,class... entries> static inline void
+perturbed_predicates_helper(bool* results, const Vector<PerturbedT,k>* inputs, Types<entries...>) {
+  const int d = PerturbedT::m;
+
+  // Transpose the inputs into n-wide intervals
+  Vector<BatchInterval<n>,d> X[k];
+  for (int a=0;a<k;a++)
+    for (int c=0;c<d;c++) {
+      double x[n];
+      for (int i=0;i<n;i++)
+        x[i] = inputs[i][a].value()[c];
+      X[a][c] = BatchInterval<n>(x);
+    }
+
+  // Filter all lanes at once
+  const auto r = F::eval(X[entries::value]...);
+  const int positive = r.positive_mask(),
+            negative = r.negative_mask();
+
+  // Ambiguous lanes fall back to exact integer evaluation with symbolic perturbation
+  for (int i=0;i<n;i++) {
+    if (positive>>i&1)
+      results[i] = true;
+    else if (negative>>i&1)
+      results[i] = false;
+    else {
+      results[i] = perturbed_predicate_exact<F>(false,inputs[i][entries::value]...);
+      continue;
+    }
+    GEODE_EXACT_COUNT_FILTERED(F);
+  }
+}
+
+// Evaluate perturbed_predicate<F> on many independent inputs, setting results[i] to the value for the arguments in inputs[i].
+// The interval filter is evaluated n inputs at a time using BatchInterval<n>.  Results are identical to calling
+// perturbed_predicate<F> on each input separately.  This must be called from within an IntervalScope.
+template<class F,int n=batch_interval_width,int k,class PerturbedT> static void
+perturbed_predicates(RawArray<bool> results, RawArray<const Vector<PerturbedT,k>> inputs) {
+  GEODE_ASSERT(results.size()==inputs.size());
+  const int count = inputs.size(),
+            batched = count-count%n;
+  for (int i=0;i<batched;i+=n)
+    perturbed_predicates_helper<F,n>(results.data()+i,inputs.data()+i,IRange<k>());
+  // Handle the remainder one at a time
+  for (int i=batched;i<count;i++)
+    results[i] = perturbed_predicate_unpack<F>(inputs[i],IRange<k>());
+}
+
+}
@@ -324,6 +324,14 @@ static inline int weak_sign(One) {
   return 1;
 }
 
+static inline int sign(One) {
+  return 1;
+}
+
+static inline bool certainly_zero(One) {
+  return false;
+}
+
 static inline int mpz_set(RawArray<mp_limb_t> x, One) {
   // We'll never reach here, since the "filter" step always succeeds for One
   GEODE_UNREACHABLE();
@@ -7,6 +7,8 @@
 #include <geode/geometry/traverse.h>
 #include <geode/mesh/ComponentData.h>
 #include <geode/utility/curry.h>
+#include <geode/utility/parallel.h>
+#include <set>
 
 namespace geode {
 
@@ -41,24 +43,201 @@ static Array<Box<exact::Vec2>> segment_boxes(RawArray<const int> next, RawArray<
   return boxes;
 }
 
-// Compute all nontrivial intersections between segments
-struct SegmentIntersections {
+// Segment endpoints in upwards order, shared by the sweeps over each strip
+struct SweepEvents {
   const ExactSegmentSet& segs;
+  Field<SegmentId,SegmentId> prev;
+  Field<bool,SegmentId> up; // Is dst above src?
+  Array<SegmentId> order; // Vertices (identified by the segment leaving them) sorted upwards
+  Field<int,SegmentId> event_of;
+
+  SweepEvents(const ExactSegmentSet& segs)
+    : segs(segs)
+    , prev(segs.size(),uninit)
+    , up(segs.size(),uninit)
+    , event_of(segs.size(),uninit) {
+    for (const SegmentId s : id_range<SegmentId>(segs.size())) {
+      prev[segs.next[s]] = s;
+      if (segs.next[s]!=s) { // Single point contours have no segments
+        up[s] = upwards(segs.src(s),segs.dst(s));
+        order.append(s);
+      }
+    }
+    parallel_sort(order,[&](const SegmentId a, const SegmentId b) {
+      return a!=b && upwards(segs.src(a),segs.src(b));
+    });
+    for (const int i : range(order.size()))
+      event_of[order[i]] = i;
+  }
+
+  SegmentId lo(const SegmentId s) const { return up[s] ? s : segs.next[s]; }
+  SegmentId hi(const SegmentId s) const { return up[s] ? segs.next[s] : s; }
+};
+
+// Compute all nontrivial intersections between segments with a Bentley-Ottmann style sweep upwards through the
+// events in [begin,end).  The status holds the segments crossing the sweep line ordered left to right, and each
+// pair of segments is tested when it becomes adjacent.  Ordering crossings against each other would require a
+// higher degree predicate, so instead each crossing is assigned to the slab between the consecutive events above
+// and below it.  Within a slab every crossing swaps two adjacent segments, and swapping adjacent pairs which cross
+// inside the slab in any order reaches the order at the top of the slab, visiting each crossing once.  A sweep
+// over n segments with k crossings takes O((n+k) log n) predicates.
+struct SegmentSweep {
+  const SweepEvents& e;
+  const ExactSegmentSet& segs;
+  const int begin, end;
+  SegmentId current; // Vertex most recently reached by the sweep line
+  int next_event; // Index of the first unprocessed event
+
+  // Status slots hold segments, so that swapping adjacent segments doesn't touch the set
+  struct SlotLess {
+    const SegmentSweep& sweep;
+    bool operator()(const int a, const int b) const {
+      return sweep.left_of(sweep.slot_segment[a],sweep.slot_segment[b]);
+    }
+  };
+  Array<SegmentId> slot_segment;
+  std::set<int,SlotLess> status;
+  Field<std::set<int,SlotLess>::iterator,SegmentId> position;
+
+  // Crossings waiting for the sweep to reach their slab, as singly linked lists per event
+  Array<int> bucket_head;
+  Array<Tuple<Vector<SegmentId,2>,int>> buckets;
+  Array<Vector<SegmentId,2>> work; // Adjacent pairs crossing below event next_event
   Array<Vector<SegmentId,2>> pairs;
 
-  SegmentIntersections(const ExactSegmentSet& _segs)
-    : segs(_segs) {}
+  // active holds the segments crossing the sweep line just above event begin-1
+  GEODE_NEVER_INLINE SegmentSweep(const SweepEvents& e, const int begin, const int end,
+                                  RawArray<const SegmentId> active)
+    : e(e)
+    , segs(e.segs)
+    , begin(begin)
+    , end(end)
+    , status(SlotLess{*this})
+    , position(segs.size(),uninit) // Only segments in the status are looked up
+    , bucket_head(end-begin) {
+    IntervalScope scope;
+    bucket_head.fill(-1);
+    if (begin) {
+      current = e.order[begin-1];
+      next_event = begin;
+      const auto sorted = active.copy();
+      sort(sorted,[&](const SegmentId a, const SegmentId b) { return a!=b && left_of(a,b); });
+      for (const auto s : sorted)
+        position[s] = status.insert(status.end(),slot_segment.append(s));
+      for (int i=1;i<sorted.size();i++)
+        check(sorted[i-1],sorted[i]);
+    }
+    for (const int i : range(begin,end)) {
+      // Finish the crossings below this event
+      next_event = i;
+      for (int b=bucket_head[i-begin];b>=0;b=buckets[b].y)
+        work.append(buckets[b].x);
+      while (work.size())
+        cross(work.pop());
+      // Remove segments ending here, then insert those starting here
+      current = e.order[i];
+      next_event = i+1;
+      vertex(current);
+    }
+  }
 
-  bool cull(const int n) const { return false; }
-  bool cull(const int n0, const int box1) const { return false; }
-  void leaf(const int n) const { assert(segs.tree->prims(n).size()==1); }
+  // Is a left of b just above the current vertex?
+  bool left_of(const SegmentId a, const SegmentId b) const {
+    const auto p = segs.src(current);
+    if (e.lo(a)==e.lo(b) && e.hi(a)==e.hi(b)) // Two segment contours are degenerate, so order them arbitrarily
+      return a<b;
+    const bool sa = e.lo(a)==current,
+               sb = e.lo(b)==current;
+    if (sa && sb) // Order segments sharing a lower endpoint by direction
+      return triangle_oriented(p,segs.src(e.hi(b)),segs.src(e.hi(a)));
+    if (sa || sb) { // Compare the other segment to the vertex, trying its x range first
+      const auto s = sa ? b : a;
+      const auto s0 = segs.src(e.lo(s)), s1 = segs.src(e.hi(s));
+      const auto x = p.value().x;
+      const bool left = x<min(s0.value().x,s1.value().x) ? true
+                      : x>max(s0.value().x,s1.value().x) ? false
+                      : triangle_oriented(s0,s1,p);
+      return left==sa;
+    }
+    return ray_intersections_rightwards(segs.src(a),segs.dst(a),segs.src(b),segs.dst(b),p);
+  }
+
+  void vertex(const SegmentId v) {
+    const Vector<SegmentId,2> touching(e.prev[v],v);
+    auto gap = status.end();
+    bool inserted = false;
+    for (const auto s : touching)
+      if (e.hi(s)==v)
+        gap = status.erase(position[s]);
+    for (const auto s : touching)
+      if (e.lo(s)==v) {
+        // A segment continuing the contour fits the gap, and the second of two starting segments is next to the first
+        gap = position[s] = status.insert(gap,slot_segment.append(s));
+        inserted = true;
+      }
+    if (inserted) {
+      for (const auto s : touching)
+        if (e.lo(s)==v) {
+          const auto it = position[s];
+          if (it!=status.begin())
+            check(slot_segment[*std::prev(it)],s);
+          const auto next = std::next(it);
+          if (next!=status.end())
+            check(s,slot_segment[*next]);
+        }
+    } else if (gap!=status.begin() && gap!=status.end())
+      check(slot_segment[*std::prev(gap)],slot_segment[*gap]);
+  }
+
+  // a is immediately left of b.  If they cross above the sweep line and within this strip, queue the crossing.
+  void check(const SegmentId a, const SegmentId b) {
+    // Segments with disjoint x ranges can't cross.  Ranges are tested strictly since perturbation may separate
+    // segments which touch.
+    const auto a0 = segs.src(a), a1 = segs.dst(a),
+               b0 = segs.src(b), b1 = segs.dst(b);
+    if (   max(a0.value().x,a1.value().x)<min(b0.value().x,b1.value().x)
+        || max(b0.value().x,b1.value().x)<min(a0.value().x,a1.value().x))
+      return;
+    if (!segs.segments_intersect(a,b))
+      return;
+    // If a turns left of b, they have already crossed
+    if (!segment_directions_oriented(segs.src(e.lo(a)),segs.src(e.hi(a)),segs.src(e.lo(b)),segs.src(e.hi(b))))
+      return;
+    // Find the first event above the crossing, which is at most the lower of the two upper endpoints
+    int first = next_event,
+        last = min(e.event_of[e.hi(a)],e.event_of[e.hi(b)],end);
+    while (first<last) {
+      const int mid = (first+last)>>1;
+      if (segment_intersection_above_point(a0,a1,b0,b1,segs.src(e.order[mid])))
+        first = mid+1;
+      else
+        last = mid;
+    }
+    if (first==next_event)
+      work.append(vec(a,b));
+    else if (first<end) { // Crossings above the strip are found by the next one
+      auto& head = bucket_head[first-begin];
+      head = buckets.append(tuple(vec(a,b),head));
+    }
+  }
 
-  void leaf(const int n0, const int n1) {
-    assert(segs.tree->prims(n0).size()==1 && segs.tree->prims(n1).size()==1);
-    const auto s0 = SegmentId(segs.tree->prims(n0)[0]),
-               s1 = SegmentId(segs.tree->prims(n1)[0]);
-    if (segs.segments_intersect(s0,s1))
-        pairs.append(vec(s0,s1));
+  // Swap a crossing pair if it is still adjacent
+  void cross(const Vector<SegmentId,2> ab) {
+    const auto a = ab.x, b = ab.y;
+    const auto ia = position[a],
+               ib = std::next(ia);
+    if (ib==status.end() || slot_segment[*ib]!=b)
+      return; // Something lies between them, and we'll see them again once it leaves
+    pairs.append(ab);
+    slot_segment[*ia] = b;
+    slot_segment[*ib] = a;
+    position[a] = ib;
+    position[b] = ia;
+    if (ia!=status.begin())
+      check(slot_segment[*std::prev(ia)],b);
+    const auto next = std::next(ib);
+    if (next!=status.end())
+      check(a,slot_segment[*next]);
   }
 };
 
@@ -150,9 +329,31 @@ uint8_t ExactSegmentSet::quadrant(const SegmentId s) const {
 }
 
 Array<Vector<SegmentId, 2>> ExactSegmentSet::intersection_pairs() const {
-  SegmentIntersections pairs(*this);
-  double_traverse(*tree,pairs);
-  return pairs.pairs;
+  // Sweep fixed size strips of events in parallel.  Each strip starts by sorting the segments crossing its bottom,
+  // so strips are large enough for that to be cheap, and their size doesn't depend on the thread count so that the
+  // order of the pairs is deterministic.
+  const SweepEvents e(*this);
+  const int n = e.order.size(),
+            strip = 1<<14,
+            strips = (n+strip-1)/strip;
+  // Collect the segments crossing the bottom of each strip, which is just above the last event of the previous one
+  Array<int> counts(strips);
+  for (const auto s : e.order)
+    for (int k=e.event_of[e.lo(s)]/strip+1;k*strip<=e.event_of[e.hi(s)];k++)
+      counts[k]++;
+  Nested<SegmentId> active(counts,uninit);
+  for (const auto s : e.order)
+    for (int k=e.event_of[e.lo(s)]/strip+1;k*strip<=e.event_of[e.hi(s)];k++)
+      active(k,--counts[k]) = s;
+
+  vector<Array<Vector<SegmentId,2>>> pairs(strips);
+  parallel_for(strips,[&](const int k) {
+    pairs[k] = SegmentSweep(e,k*strip,min((k+1)*strip,n),active[k]).pairs;
+  });
+  Array<Vector<SegmentId,2>> all;
+  for (const auto& p : pairs)
+    all.extend(p);
+  return all;
 }
 
 static VertexId src_id(const SegmentId s) { return VertexId(s.idx()); }
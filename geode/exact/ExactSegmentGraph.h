@@ -1,6 +1,7 @@
 #pragma once
 #include <geode/array/NestedField.h>
 #include <geode/exact/config.h>
+#include <geode/exact/polygon_csg.h>
 #include <geode/geometry/BoxTree.h>
 #include <geode/mesh/HalfedgeGraph.h>
 
@@ -22,6 +23,7 @@ struct ExactSegmentSet {
   bool directions_oriented(const SegmentId s0, const SegmentId s1) const;
   exact::Vec2 approx_intersection(const SegmentId s0, const SegmentId s1) const;
 
+  // Pairs of segments crossing away from shared endpoints, in deterministic order
   Array<Vector<SegmentId, 2>> intersection_pairs() const;
   uint8_t quadrant(const SegmentId s) const;
   explicit ExactSegmentSet(const Nested<const exact::Vec2> polys);
@@ -56,4 +58,11 @@ class ExactSegmentGraph {
   Array<HalfedgeId> path_from_infinity(const SegmentId hit_segment) const;
 };
 
+// Winding depth of each face of the graph, starting at 0 at infinity
+GEODE_CORE_EXPORT Field<int, FaceId> face_winding_depths(const ExactSegmentGraph& g);
+
+// Contours around the faces whose depth relative to depth is included by rule, in quantized coordinates
+GEODE_CORE_EXPORT Nested<Vec2> extract_faces(const ExactSegmentGraph& g, RawField<const int, FaceId> depths,
+                                             const int depth, const FillRule rule);
+
 } // namespace geode
\ No newline at end of file
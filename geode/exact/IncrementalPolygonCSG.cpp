@@ -0,0 +1,228 @@
+// Polygon CSG which reuses work between edits
+#include <geode/exact/IncrementalPolygonCSG.h>
+#include <geode/exact/predicates.h>
+#include <geode/exact/scope.h>
+#include <geode/array/amap.h>
+#include <geode/geometry/BoxTree.h>
+#include <geode/geometry/traverse.h>
+#include <geode/python/Class.h>
+#include <geode/structure/UnionFind.h>
+#include <geode/utility/format.h>
+#include <geode/vector/transform.h>
+namespace geode {
+
+typedef exact::Vec2 EV;
+using exact::Perturbed2;
+
+GEODE_DEFINE_TYPE(IncrementalPolygonCSG)
+
+IncrementalPolygonCSG::IncrementalPolygonCSG(const Box<Vec2>& box, const int depth, const FillRule rule)
+  : box(box)
+  , depth(depth)
+  , rule(rule)
+  , quant(box)
+  , versions(0)
+  , recomputed_parts_(0) {}
+
+IncrementalPolygonCSG::~IncrementalPolygonCSG() {}
+
+int IncrementalPolygonCSG::add(Nested<const Vec2> polys) {
+  const int id = int(parts.size());
+  parts.push_back(Part());
+  replace(id,polys);
+  return id;
+}
+
+void IncrementalPolygonCSG::replace(const int id, Nested<const Vec2> polys) {
+  GEODE_ASSERT(unsigned(id)<parts.size());
+  for (const auto& x : polys.flat)
+    if (!box.lazy_inside(x))
+      throw ValueError(format("IncrementalPolygonCSG: part %d leaves the declared box",id));
+  for (const int p : range(polys.size()))
+    GEODE_ASSERT(polys.size(p)>=3,"Degenerate polygons are not allowed");
+  auto& part = parts[id];
+  part.polys = polys;
+  part.exact = amap(quant,polys).copy();
+  part.bounds = bounding_box(part.exact.flat);
+  part.version = versions++;
+}
+
+void IncrementalPolygonCSG::remove(const int id) {
+  replace(id,Nested<const Vec2>());
+}
+
+void IncrementalPolygonCSG::transform(const int id, const Frame<Vec2>& frame) {
+  replace(id,geode::transformed(frame,part(id)));
+}
+
+Nested<const Vec2> IncrementalPolygonCSG::part(const int id) const {
+  GEODE_ASSERT(unsigned(id)<parts.size());
+  return parts[id].polys;
+}
+
+namespace {
+struct PartOverlaps {
+  const BoxTree<EV>& tree;
+  Array<Vector<int,2>> pairs;
+
+  PartOverlaps(const BoxTree<EV>& tree)
+    : tree(tree) {}
+
+  bool cull(const int n) const { return false; }
+  bool cull(const int n0, const int n1) const { return false; }
+  void leaf(const int n) const { assert(tree.prims(n).size()==1); }
+  void leaf(const int n0, const int n1) {
+    pairs.append(vec(tree.prims(n0)[0],tree.prims(n1)[0]));
+  }
+};
+}
+
+// Segments of a part, with seeds offset by base to keep both parts of a pair distinct
+static inline Vector<Perturbed2,2> part_segment(Nested<const EV> X, const int base, const int p, const int i) {
+  const int j = i+1<X.offsets[p+1] ? i+1 : X.offsets[p];
+  return vec(Perturbed2(base+i,X.flat[i]),Perturbed2(base+j,X.flat[j]));
+}
+
+// Winding number of a point with respect to a part, computed by firing a ray along the positive x axis
+static int part_winding(Nested<const EV> X, const int base, const Perturbed2 start) {
+  int winding = 0;
+  for (const int p : range(X.size()))
+    for (const int i : X.range(p)) {
+      const auto s = part_segment(X,base,p,i);
+      if (max(s.x.value().x,s.y.value().x) < start.value().x)
+        continue;
+      const bool above0 = upwards(start,s.x),
+                 above1 = upwards(start,s.y);
+      if (above0!=above1 && above1==triangle_oriented(s.x,s.y,start))
+        winding += above1 ? 1 : -1;
+    }
+  return winding;
+}
+
+// Parts interact if their boundaries cross or either lies where the other has nonzero winding.
+// Otherwise the winding number of every point comes from at most one of them.
+static bool parts_interact(Nested<const EV> A, Nested<const EV> B) {
+  const int nA = A.flat.size();
+  for (const int p : range(A.size()))
+    for (const int i : A.range(p)) {
+      const auto a = part_segment(A,0,p,i);
+      const auto box = bounding_box(a.x.value(),a.y.value());
+      for (const int q : range(B.size()))
+        for (const int j : B.range(q)) {
+          const auto b = part_segment(B,nA,q,j);
+          if (   box.intersects(bounding_box(b.x.value(),b.y.value()))
+              && segments_intersect(a.x,a.y,b.x,b.y))
+            return true;
+        }
+    }
+  // With no crossings, each contour lies entirely on one side of the other part
+  for (const int p : range(A.size()))
+    if (part_winding(B,nA,Perturbed2(A.offsets[p],A.flat[A.offsets[p]])))
+      return true;
+  for (const int q : range(B.size()))
+    if (part_winding(A,0,Perturbed2(nA+B.offsets[q],B.flat[B.offsets[q]])))
+      return true;
+  return false;
+}
+
+Nested<Vec2> IncrementalPolygonCSG::result() {
+  IntervalScope scope;
+
+  // Collect live parts
+  Array<int> live;
+  for (const int i : range(int(parts.size())))
+    if (parts[i].polys.size())
+      live.append(i);
+  const int n = live.size();
+
+  // Cluster interacting parts.  Only pairs with overlapping boxes can interact, and the exact interaction tests
+  // are cached so that an edit only retests pairs involving the edited part.  If the rule includes the unbounded
+  // face, every part interacts with every other through it, so we fall back to a single cluster.
+  UnionFind union_find(n);
+  const bool include_outside = rule==FillRule::Greater ? 0-depth > 0
+                             : rule==FillRule::Parity  ? !((0-depth)&1)
+                                                       : 0-depth != 0;
+  Hashtable<Vector<int,4>,bool> new_interactions;
+  if (include_outside) {
+    for (const int i : range(1,n))
+      union_find.merge(0,i);
+  } else if (n > 1) {
+    Array<Box<EV>> boxes(n,uninit);
+    for (const int i : range(n))
+      boxes[i] = parts[live[i]].bounds;
+    const auto tree = new_<BoxTree<EV>>(boxes,1);
+    PartOverlaps overlaps(tree);
+    double_traverse(*tree,overlaps);
+    for (const auto pair : overlaps.pairs) {
+      if (pair.x==pair.y)
+        continue;
+      const auto ij = pair.sorted();
+      const auto &a = parts[live[ij.x]],
+                 &b = parts[live[ij.y]];
+      const Vector<int,4> key(live[ij.x],a.version,live[ij.y],b.version);
+      const auto cached = interactions.get_pointer(key);
+      const bool interact = cached ? *cached : parts_interact(a.exact,b.exact);
+      new_interactions.set(key,interact);
+      if (interact)
+        union_find.merge(ij.x,ij.y);
+    }
+  }
+  interactions.swap(new_interactions);
+  Array<int> cluster(n);
+  std::vector<Array<int>> clusters;
+  for (const int i : range(n)) {
+    const int r = union_find.find(i);
+    if (r==i) {
+      clusters.push_back(Array<int>());
+      cluster[i] = int(clusters.size())-1;
+    }
+  }
+  for (const int i : range(n))
+    clusters[cluster[union_find.find(i)]].append(live[i]);
+
+  // Evaluate each cluster, reusing cached results where nothing has changed
+  std::map<std::vector<int>,Nested<const Vec2>> new_cache;
+  Nested<Vec2,false> output;
+  recomputed_parts_ = 0;
+  for (const auto& members : clusters) {
+    std::vector<int> key;
+    for (const int i : members) {
+      key.push_back(i);
+      key.push_back(parts[i].version);
+    }
+    auto it = cache.find(key);
+    Nested<const Vec2> result;
+    if (it != cache.end())
+      result = it->second;
+    else {
+      Nested<EV,false> polys;
+      for (const int i : members)
+        polys.extend(parts[i].exact);
+      result = amap(quant.inverse,exact_split_polygons_with_rule(polys.freeze(),depth,rule));
+      recomputed_parts_ += members.size();
+    }
+    output.extend(result);
+    new_cache.insert(make_pair(key,result));
+  }
+  cache.swap(new_cache);
+  return output.freeze();
+}
+
+}
+using namespace geode;
+
+void wrap_incremental_polygon_csg() {
+  typedef IncrementalPolygonCSG Self;
+  Class<Self>("IncrementalPolygonCSG")
+    .GEODE_INIT(const Box<Vec2>&,const int)
+    .GEODE_FIELD(box)
+    .GEODE_FIELD(depth)
+    .GEODE_METHOD(add)
+    .GEODE_METHOD(replace)
+    .GEODE_METHOD(remove)
+    .GEODE_METHOD(transform)
+    .GEODE_METHOD(part)
+    .GEODE_METHOD(result)
+    .GEODE_METHOD(recomputed_parts)
+    ;
+}
@@ -0,0 +1,71 @@
+// Polygon CSG which reuses work between edits
+#pragma once
+
+// IncrementalPolygonCSG holds a scene of parts, each a set of polygons, and evaluates split_polygons_with_rule on
+// their concatenation.  Two parts interact if their boundaries cross or one lies inside the other.  Clusters of
+// interacting parts are independent, so results are cached per cluster and only clusters touched by an edit are
+// recomputed, and pairwise interaction tests are cached as well.  On a nesting layout where one of thousands of
+// parts moves, re-evaluation costs about the size of the clusters the part leaves and enters.
+//
+// The quantizer is fixed by a box declared up front, so every part must stay inside it.  Within a cluster the
+// result is computed exactly as split_polygons_with_rule would, though polygon order differs from a global call.
+// Since clusters are perturbed independently, parts which touch without overlapping may stay separate polygons.
+
+#include <geode/exact/polygon_csg.h>
+#include <geode/exact/quantize.h>
+#include <geode/python/Object.h>
+#include <geode/python/Ref.h>
+#include <geode/structure/Hashtable.h>
+#include <geode/vector/Frame.h>
+#include <map>
+#include <vector>
+namespace geode {
+
+class IncrementalPolygonCSG : public Object {
+public:
+  GEODE_DECLARE_TYPE(GEODE_CORE_EXPORT)
+  typedef Object Base;
+
+  const Box<Vec2> box;
+  const int depth;
+  const FillRule rule;
+private:
+  struct Part {
+    Nested<const Vec2> polys; // Empty for removed parts
+    Nested<const exact::Vec2> exact;
+    Box<exact::Vec2> bounds;
+    int version;
+  };
+  const Quantizer<real,2> quant;
+  std::vector<Part> parts;
+  int versions;
+  Hashtable<Vector<int,4>,bool> interactions; // (part,version,part,version) -> whether the parts interact
+  std::map<std::vector<int>,Nested<const Vec2>> cache; // (part,version) pairs of a cluster -> its result
+  int recomputed_parts_;
+
+protected:
+  GEODE_CORE_EXPORT IncrementalPolygonCSG(const Box<Vec2>& box, const int depth, const FillRule rule=FillRule::Greater);
+public:
+  ~IncrementalPolygonCSG();
+
+  // Add a part, returning its id
+  GEODE_CORE_EXPORT int add(Nested<const Vec2> polys);
+
+  // Replace or remove an existing part
+  GEODE_CORE_EXPORT void replace(const int id, Nested<const Vec2> polys);
+  GEODE_CORE_EXPORT void remove(const int id);
+
+  // Move a part rigidly
+  GEODE_CORE_EXPORT void transform(const int id, const Frame<Vec2>& frame);
+
+  // The current polygons of a part
+  GEODE_CORE_EXPORT Nested<const Vec2> part(const int id) const;
+
+  // Evaluate the CSG of the whole scene, recomputing only clusters affected by edits since the last call
+  GEODE_CORE_EXPORT Nested<Vec2> result();
+
+  // Number of parts whose clusters were recomputed by the last call to result
+  int recomputed_parts() const { return recomputed_parts_; }
+};
+
+}
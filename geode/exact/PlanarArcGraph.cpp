@@ -5,6 +5,7 @@
 #include <geode/mesh/ComponentData.h>
 #include <geode/python/Class.h>
 #include <geode/utility/curry.h>
+#include <geode/utility/parallel.h>
 
 namespace geode {
 
@@ -79,21 +80,16 @@ template<Pb PS> static Vector<IncidentVertexInfo<PS>,2> get_intersections(const
   return result;
 }
 
-template<Pb PS> IncidentId VertexField<PS>::append_unique(const ExactCircle<PS>& ref, const IncidentCircle<PS>& inc) {
-  IncidentId result;
-  incidents_.preallocate(incidents_.size() + 2);
-  if(inc.side == first_iid_side) {
-    incidents_.flat.append_assuming_enough_space(inc);
-    incidents_.flat.append_assuming_enough_space(inc.reference_as_incident(ref));
-    result = IncidentId(incidents_.size() - 2);
-  }
-  else {
-    incidents_.flat.append_assuming_enough_space(inc.reference_as_incident(ref));
-    incidents_.flat.append_assuming_enough_space(inc);
-    result = IncidentId(incidents_.size() - 1);
-  }
-  assert(incidents_[result].side == inc.side);
-  assert(incidents_[opposite(result)].side == opposite(inc.side));
+template<Pb PS> IncidentId VertexSet<PS>::append_unique(const ExactCircle<PS>& ref, const IncidentCircle<PS>& inc, const CircleId ref_cid, const CircleId inc_cid) {
+  const auto opp = inc.reference_as_incident(ref);
+  const VertexId vid = approxes.append(inc.approx);
+  const IncidentId result = incident_id(vid, inc.side);
+  incident_cids.flat.extend(vec(CircleId(),CircleId()));
+  quadrants.flat.extend(vec(uint8_t(0),uint8_t(0)));
+  incident_cids[result] = inc_cid;
+  incident_cids[opposite(result)] = ref_cid;
+  quadrants[result] = inc.q;
+  quadrants[opposite(result)] = opp.q;
   assert(side(result) == inc.side);
   return result;
 }
@@ -191,45 +187,59 @@ template<Pb PS> Array<CircleId> CircleTree<PS>::circles_active_near(const Circle
 }
 
 
+// Intersections are found in parallel and inserted into vertices afterwards, in the deterministic order given by
+// merging the visitor copies
 namespace { template<Pb PS> struct IntersectionHelper {
   const CircleTree<PS>& tree;
-  VertexSet<PS>& vertices;
+  const VertexSet<PS>& vertices;
+  RawField<const bool, CircleId> unsplit; // If non-empty, only pairs with at least one unsplit circle are checked
+  Array<Tuple<IncidentCircle<PS>,CircleId,CircleId>> found;
   bool cull(const int n) const { return false; }
   bool cull(const int n0, const int n1) const { return false; }
   void leaf(const int n) const { assert(tree.tree->prims(n).size()==1); }
   void leaf(const int n0, const int n1) {
     if(n0 == n1) // Only check unique arcs
       return;
-    const auto b = Box<Vec2>::intersect(tree.tree->boxes[n0],tree.tree->boxes[n1]);
-    assert(!b.empty());
     const CircleId cid0 = tree.prim(n0);
     const CircleId cid1 = tree.prim(n1);
+    if(unsplit.size() && !unsplit[cid0] && !unsplit[cid1])
+      return; // Both circles only carry arcs that were already split against each other
+    const auto b = Box<Vec2>::intersect(tree.tree->boxes[n0],tree.tree->boxes[n1]);
+    assert(!b.empty());
     const auto& c0 = vertices.circle(cid0);
     const auto& c1 = vertices.circle(cid1);
 
     for(const auto& i : c0.intersections_if_any(c1)) {
       if(b.intersects(i.approx.box()))
-        vertices.get_or_insert(i, cid0, cid1);
+        found.append(tuple(i, cid0, cid1));
     }
   }
-
+  void merge(const IntersectionHelper& other) {
+    found.extend(other.found);
+  }
 };}
 
-template<Pb PS> static CircleTree<PS> insert_circle_intersections(VertexSet<PS>& vertices, const ArcContours& contours) {
+// The first split_contours contours must not cross each other except at existing vertices (as with boundaries of a union)
+template<Pb PS> static CircleTree<PS> insert_circle_intersections(VertexSet<PS>& vertices, const ArcContours& contours, const int split_contours) {
   const auto tree = CircleTree<PS>(vertices, contours);
-  IntersectionHelper<PS> helper({tree, vertices});
-  double_traverse(*(tree.tree), helper);
+  // Mark circles carrying arcs from the remaining contours, since these might have new intersections
+  Field<bool, CircleId> unsplit;
+  if(split_contours > 0) {
+    unsplit = Field<bool, CircleId>(vertices.n_circles());
+    for(const int i : range(split_contours, contours.size()))
+      for(const auto a : contours[i])
+        unsplit[vertices.reference_cid(a.head())] = true;
+  }
+  IntersectionHelper<PS> helper({tree, vertices, unsplit});
+  parallel_double_traverse<IntervalScope>(*(tree.tree), helper);
+  for(const auto& f : helper.found)
+    vertices.get_or_insert(f.x, f.y, f.z);
   // This doesn't ensure added intersections are on contours so some spurious vertices can be added
   // In practice, bounding boxes seem to be tight enough that it is faster to allow a few spurious vertices rather then adding a filtering step
   return tree;
 }
 
 namespace {
-template<Pb PS> ExactCircle<PS> construct_circle(const exact::Vec2 x0, const exact::Vec2 x1, const real q) {
-  const auto c_and_r = construct_circle_center_and_radius(x0,x1,q);
-  return ExactCircle<PS>(c_and_r.x, c_and_r.y);
-}
-
 static Quantized helper_circle_radius() {
   return constructed_arc_endpoint_error_bound();
 }
@@ -246,8 +256,8 @@ template<Pb PS> struct NewArc {
   IncidentId x0_inc;
   IncidentId x1_inc;
 
-  void set_circle_and_direction(VertexSet<PS>& verts, const exact::Vec2 x1) {
-    cid = verts.get_or_insert(construct_circle<PS>(x0, x1, q));
+  void set_circle_and_direction(VertexSet<PS>& verts, const Tuple<exact::Vec2,Quantized>& circle) {
+    cid = verts.get_or_insert(ExactCircle<PS>(circle.x, circle.y));
     direction = (q >= 0.) ? ArcDirection::CCW : ArcDirection::CW;
   }
 
@@ -349,36 +359,71 @@ template<Pb PS> static IncidentCircle<PS> construct_intersection_for_endpoint(co
 }
 
 
-template<Pb PS> void VertexSet<PS>::quantize_circle_arcs(const Quantizer<real,2>& quant, const RawArray<const CircleArc> src_arcs, ArcContours& result, const bool src_arcs_open) {
+// Quantize the start points of a contour's arcs, appending those worth keeping to x0 and q and returning the quantized end
+// of the contour.  Nothing is appended if the contour collapses to a point.
+template<Pb PS> static exact::Vec2 quantize_arc_starts(const Quantizer<real,2>& quant, const RawArray<const CircleArc> src_arcs,
+                                                       const bool src_arcs_open, Array<exact::Vec2>& x0, Array<real>& q) {
   const int src_n = src_arcs.size();
-  const auto src_next = make_next_i(src_n);
-
-  auto new_arcs = Array<NewArc<PS>>();
   if(src_n == 0) {
-    return; // Ignore empty input
+    return exact::Vec2(); // Ignore empty input
   }
+  const auto src_next = make_next_i(src_n);
+  const int start = x0.size();
 
   exact::Vec2 tail_point = quant(src_arcs.front().x);
   for(const int src_i : range(src_n - src_arcs_open)) {
-    const exact::Vec2 x0 = tail_point;
-    const exact::Vec2 x1 = quant(src_arcs[src_next[src_i]].x);
-    if(x0 == x1 || circles_overlap(helper_circle<PS>(x0), helper_circle<PS>(x1)))
+    const exact::Vec2 a0 = tail_point;
+    const exact::Vec2 a1 = quant(src_arcs[src_next[src_i]].x);
+    if(a0 == a1 || circles_overlap(helper_circle<PS>(a0), helper_circle<PS>(a1)))
       continue; // Skip over small degenerate arcs
-    // If we skipped arcs, x0 won't be same as src_arcs[src_i].x, but it should have changed by at most the helper circle diameter + 1 so it should be safe to use
-    new_arcs.append({x0, src_arcs[src_i].q});
-    tail_point = x1;
+    // If we skipped arcs, a0 won't be same as src_arcs[src_i].x, but it should have changed by at most the helper circle diameter + 1 so it should be safe to use
+    x0.append(a0);
+    q.append(src_arcs[src_i].q);
+    tail_point = a1;
+  }
+
+  // If after filtering we have a single point, ignore it and add nothing
+  if(x0.size() - start <= 1 - src_arcs_open) {
+    x0.resize(start);
+    q.resize(start);
   }
+  return tail_point;
+}
 
-  // If after filtering we have a single point, ignore it and return without adding anything to result
-  if(new_arcs.size() <= 1 - src_arcs_open)
+// Each arc ends where the next one starts, except for the last arc of an open contour which ends at tail_point
+static void append_arc_ends(RawArray<const exact::Vec2> x0, const exact::Vec2 tail_point, const bool src_arcs_open, Array<exact::Vec2>& x1) {
+  if(x0.empty())
     return;
+  x1.extend(x0.slice(1,x0.size()));
+  x1.append(src_arcs_open ? tail_point : x0.front());
+}
+
+template<Pb PS> void VertexSet<PS>::quantize_circle_arcs(const Quantizer<real,2>& quant, const RawArray<const CircleArc> src_arcs, ArcContours& result, const bool src_arcs_open) {
+  Array<exact::Vec2> x0, x1;
+  Array<real> q;
+  const auto tail_point = quantize_arc_starts<PS>(quant, src_arcs, src_arcs_open, x0, q);
+  if(x0.empty())
+    return;
+  append_arc_ends(x0, tail_point, src_arcs_open, x1);
+  add_quantized_contour(x0, q, construct_circle_centers_and_radii(x0, x1, q), tail_point, result, src_arcs_open);
+}
+
+template<Pb PS> void VertexSet<PS>::add_quantized_contour(RawArray<const exact::Vec2> x0, RawArray<const real> q,
+                                                          RawArray<const Tuple<exact::Vec2,Quantized>> circles,
+                                                          const exact::Vec2 tail_point, ArcContours& result, const bool src_arcs_open) {
+  const int new_n = x0.size();
+  assert(new_n > 1 - src_arcs_open && q.size() == new_n && circles.size() == new_n);
+  Array<NewArc<PS>> new_arcs;
+  new_arcs.preallocate(new_n);
+  for(const int i : range(new_n)) {
+    new_arcs.append({x0[i], q[i]});
+  }
 
-  const int new_n = new_arcs.size();
   const int before_start = src_arcs_open ? 0 : new_n-1;
   const int after_start = src_arcs_open ? 1 : 0;
 
   for(int curr_i = before_start, next_i = after_start; next_i < new_n; curr_i = next_i++) {
-    new_arcs[curr_i].set_circle_and_direction(*this, new_arcs[next_i].x0); // Construct all of the circles
+    new_arcs[curr_i].set_circle_and_direction(*this, circles[curr_i]); // Add all of the circles
   }
 
   // For open arcs need to treat front and back differently
@@ -386,7 +431,7 @@ template<Pb PS> void VertexSet<PS>::quantize_circle_arcs(const Quantizer<real,2>
     auto& first_arc = new_arcs.front();
     auto& last_arc = new_arcs.back();
 
-    last_arc.set_circle_and_direction(*this, tail_point);
+    last_arc.set_circle_and_direction(*this, circles.back());
 
     const auto first_intersection = construct_intersection_for_endpoint(this->circle(first_arc.cid), first_arc.x0);
 
@@ -483,8 +528,24 @@ template<Pb PS> void VertexSet<PS>::quantize_circle_arcs(const Quantizer<real,2>
 }
 
 template<Pb PS> void VertexSet<PS>::quantize_circle_arcs(const Quantizer<real,2>& quant, const Nested<const CircleArc> src_arcs, ArcContours& result, const bool src_arcs_open) {
-  for(const auto contour : src_arcs) {
-    quantize_circle_arcs(quant, contour, result, src_arcs_open);
+  // Quantize the endpoints of every contour, then construct all circles at once in parallel
+  Array<exact::Vec2> x0, x1;
+  Array<real> q;
+  Array<exact::Vec2> tails(src_arcs.size(), uninit);
+  Array<int> offsets(src_arcs.size()+1, uninit);
+  offsets[0] = 0;
+  for(const int c : range(src_arcs.size())) {
+    tails[c] = quantize_arc_starts<PS>(quant, src_arcs[c], src_arcs_open, x0, q);
+    append_arc_ends(x0.slice(offsets[c],x0.size()), tails[c], src_arcs_open, x1);
+    offsets[c+1] = x0.size();
+  }
+  const auto circles = construct_circle_centers_and_radii(x0, x1, q);
+
+  // Adding circles and intersections to the vertex set is serial, and proceeds in the same order as contour by contour quantization
+  for(const int c : range(src_arcs.size())) {
+    const auto r = range(offsets[c], offsets[c+1]);
+    if(r.size())
+      add_quantized_contour(x0.slice(r), q.slice(r), circles.slice(r), tails[c], result, src_arcs_open);
   }
   assert(valid_contours(*this, result));
 }
@@ -517,8 +578,8 @@ struct AlwaysOneSequence {
 };
 } // anonymous namespace
 
-template<Pb PS> void PlanarArcGraph<PS>::embed_arcs(const ArcContours& contours, const RawArray<const int8_t> weights) {
-  circle_tree = insert_circle_intersections(vertices, contours);
+template<Pb PS> void PlanarArcGraph<PS>::embed_arcs(const ArcContours& contours, const RawArray<const int8_t> weights, const int split_contours) {
+  circle_tree = insert_circle_intersections(vertices, contours, split_contours);
   incident_order = VertexSort<PS>(vertices);
   if(weights.empty()) {
     edge_srcs = init_topology_and_windings(topology, edge_windings, outgoing_edges, vertices, contours, AlwaysOneSequence{}, incident_order);
@@ -530,7 +591,7 @@ template<Pb PS> void PlanarArcGraph<PS>::embed_arcs(const ArcContours& contours,
   init_borders_and_faces();
 }
 
-template<Pb PS> PlanarArcGraph<PS>::PlanarArcGraph(const VertexSet<PS>& _vertices, const ArcContours& contours, const RawArray<const int8_t> weights)
+template<Pb PS> PlanarArcGraph<PS>::PlanarArcGraph(const VertexSet<PS>& _vertices, const ArcContours& contours, const RawArray<const int8_t> weights, const int split_contours)
  : circle_tree(uninit)
  , vertices(_vertices)
  , incident_order(uninit)
@@ -539,7 +600,7 @@ template<Pb PS> PlanarArcGraph<PS>::PlanarArcGraph(const VertexSet<PS>& _vertice
  , edge_srcs()
  , topology(new_<HalfedgeGraph>())
 {
-  embed_arcs(contours, weights);
+  embed_arcs(contours, weights, split_contours);
 }
 
 namespace { template<Pb PS> struct LeftwardRaycastHelper {
@@ -916,17 +977,14 @@ template<Pb PS> IncidentId VertexSet<PS>::try_find(const CircleId ref_cid, const
 }
 
 template<Pb PS> IncidentId VertexSet<PS>::get_or_insert(const IncidentCircle<PS>& inc, const CircleId ref_cid, const CircleId inc_cid) {
-  assert(iid_to_cid.size() == this->incidents_.size());
   assert(ref_cid.valid() && inc_cid.valid());
   assert(is_same_circle(inc.as_circle(), this->circle(inc_cid)));
   const auto ordered_cids = cl_is_reference(inc.side) ? vec(ref_cid, inc_cid) : vec(inc_cid, ref_cid);
   VertexId& vid = vid_cache.get_or_insert(ordered_cids);
   IncidentId result;
   if(!vid.valid()) {
-    result = this->append_unique(this->circle(ref_cid), inc);
+    result = append_unique(this->circle(ref_cid), inc, ref_cid, inc_cid);
     vid = to_vid(result);
-    iid_to_cid.flat.extend(ordered_cids.swap());
-    assert(iid_to_cid.size() == this->incidents_.size());
     assert(reference_cid(result) == ref_cid);
     assert(incident_cid(result) == inc_cid);
   }
@@ -937,11 +995,11 @@ template<Pb PS> IncidentId VertexSet<PS>::get_or_insert(const IncidentCircle<PS>
 }
 
 template<Pb PS> CircleId VertexSet<PS>::reference_cid(const IncidentId iid) const {
-  return iid_to_cid[opposite(iid)];
+  return incident_cids[opposite(iid)];
 }
 
 template<Pb PS> CircleId VertexSet<PS>::incident_cid(const IncidentId iid) const {
-  const auto result = iid_to_cid[iid];
+  const auto result = incident_cids[iid];
   assert(is_same_circle(this->circle(result), this->incident(iid).as_circle()));
   return result;
 }
@@ -1179,21 +1237,24 @@ template<Pb PS> Nested<CircleArc> PlanarArcGraph<PS>::unquantize_circle_arcs(con
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// Circles are sorted independently in parallel
 template<Pb PS> static void sort_circle_incidents(NestedField<IncidentId, CircleId>& circle_incidents, const VertexSet<PS>& verts) {
-  for(const auto& incidents : circle_incidents.raw) {
+  parallel_for(circle_incidents.raw.size(), [&](const int i) {
+    const auto incidents = circle_incidents.raw[i];
     if(incidents.empty())
-      continue;
+      return;
+    IntervalScope scope;
     // We radix sort quadrants first to make things easy for final sort
-    const auto start_of_q2 = std::partition(incidents.begin(), incidents.end(), [&verts](const IncidentId iid) { return verts.incident(iid).q < 2; });
-    const auto start_of_q1 = std::partition(incidents.begin(), start_of_q2,     [&verts](const IncidentId iid) { return verts.incident(iid).q == 0; });
-    const auto start_of_q3 = std::partition(start_of_q2,       incidents.end(), [&verts](const IncidentId iid) { return verts.incident(iid).q == 2; });
+    const auto start_of_q2 = std::partition(incidents.begin(), incidents.end(), [&verts](const IncidentId iid) { return verts.quadrant(iid) < 2; });
+    const auto start_of_q1 = std::partition(incidents.begin(), start_of_q2,     [&verts](const IncidentId iid) { return verts.quadrant(iid) == 0; });
+    const auto start_of_q3 = std::partition(start_of_q2,       incidents.end(), [&verts](const IncidentId iid) { return verts.quadrant(iid) == 2; });
     const ExactCircle<PS> c = verts.reference(incidents.front());
     const auto cmp = [&verts, c](const IncidentId iid0, const IncidentId iid1) { return (iid0 != iid1) && c.intersections_ccw_same_q(verts.incident(iid0),verts.incident(iid1)); };
     std::sort(incidents.begin(), start_of_q1,     cmp);
     std::sort(start_of_q1,       start_of_q2,     cmp);
     std::sort(start_of_q2,       start_of_q3,     cmp);
     std::sort(start_of_q3,       incidents.end(), cmp);
-  }
+  }, 64);
 }
 
 template<Pb PS> static NestedField<IncidentId, CircleId> get_circle_orders(const VertexSet<PS>& vertices) {
@@ -1265,6 +1326,12 @@ template<Pb PS> void ArcAccumulator<PS>::append_to_back(const SignedArcHead h) {
   contours.append_to_back(h);
 }
 
+template<Pb PS> void ArcAccumulator<PS>::copy_split_contours(const ArcContours& src_contours, const VertexSet<PS>& src_vertices) {
+  GEODE_ASSERT(split_contours == contours.size(), "copy_split_contours must be called before adding any other contours");
+  copy_contours(src_contours, src_vertices);
+  split_contours = contours.size();
+}
+
 template<Pb PS> void ArcAccumulator<PS>::copy_contours(const ArcContours& src_contours, const VertexSet<PS>& src_vertices) {
   const int base_n = contours.size();
   contours.store.extend(src_contours.store);
@@ -1277,31 +1344,41 @@ template<Pb PS> void ArcAccumulator<PS>::copy_contours(const ArcContours& src_co
   }
 }
 template<Pb PS> Ref<PlanarArcGraph<PS>> ArcAccumulator<PS>::compute_embedding() const {
-  return new_<PlanarArcGraph<PS>>(vertices, contours);
+  return new_<PlanarArcGraph<PS>>(vertices, contours, RawArray<const int8_t>(), split_contours);
 }
 
 template<Pb PS> Tuple<Ref<PlanarArcGraph<PS>>,Nested<HalfedgeId>> ArcAccumulator<PS>::split_and_union() const {
-  auto result = tuple(new_<PlanarArcGraph<PS>>(vertices, contours), Nested<HalfedgeId>());
+  auto result = tuple(new_<PlanarArcGraph<PS>>(vertices, contours, RawArray<const int8_t>(), split_contours), Nested<HalfedgeId>());
   result.y = extract_region(result.x->topology, faces_greater_than(*(result.x), 0));
   return result;
 }
 
-template<Pb PS, class Pred> Field<bool, FaceId> find_faces(const PlanarArcGraph<PS>& g, const Pred& p) {
+template<Pb PS> Field<int, FaceId> face_winding_depths(const PlanarArcGraph<PS>& g) {
   const auto& t = *(g.topology);
-  auto result = Field<bool, FaceId>(t.n_faces(), uninit);
-  if(t.n_faces() > 0) {
-    const auto depths = compute_winding_numbers(t, g.boundary_face(), g.edge_windings);
-    for(const FaceId fid : t.faces())
-      result[fid] = p(depths[fid]);
-  }
+  if(t.n_faces() == 0)
+    return Field<int, FaceId>();
+  return compute_winding_numbers(t, g.boundary_face(), g.edge_windings);
+}
+
+template<class Pred> static Field<bool, FaceId> find_faces(RawField<const int, FaceId> depths, const Pred& p) {
+  auto result = Field<bool, FaceId>(depths.size(), uninit);
+  for(const FaceId fid : depths.id_range())
+    result[fid] = p(depths[fid]);
   return result;
 }
 
+Field<bool, FaceId> faces_greater_than(RawField<const int, FaceId> depths, const int depth) {
+  return find_faces(depths, [depth](const int face_depth) { return face_depth > depth; });
+}
+Field<bool, FaceId> odd_faces(RawField<const int, FaceId> depths) {
+  return find_faces(depths, [](const int face_depth) { return (bool)(face_depth & 1); });
+}
+
 template<Pb PS> Field<bool, FaceId> faces_greater_than(const PlanarArcGraph<PS>& g, const int depth) {
-  return find_faces(g, [depth](const int face_depth) { return face_depth > depth; });
+  return faces_greater_than(face_winding_depths(g), depth);
 }
 template<Pb PS> Field<bool, FaceId> odd_faces(const PlanarArcGraph<PS>& g) {
-  return find_faces(g, [](const int face_depth) { return (bool)(face_depth & 1); });
+  return odd_faces(face_winding_depths(g));
 }
 
 template<Pb PS> Ref<PlanarArcGraph<PS>> quantize_circle_arcs(const Quantizer<real,2>& quant, const Nested<const CircleArc> arcs) {
@@ -1320,7 +1397,6 @@ template<Pb PS> Tuple<Quantizer<real,2>,Ref<PlanarArcGraph<PS>>> quantize_circle
 }
 
 #define INSTANTIATE(PS) \
-  template class VertexField<PS>; \
   template class CircleSet<PS>; \
   template class VertexSet<PS>; \
   template class CircleTree<PS>; \
@@ -1331,6 +1407,7 @@ template<Pb PS> Tuple<Quantizer<real,2>,Ref<PlanarArcGraph<PS>>> quantize_circle
   template Tuple<Quantizer<real,2>,Ref<PlanarArcGraph<PS>>> quantize_circle_arcs(const Nested<const CircleArc> arcs); \
   template Field<bool, FaceId> faces_greater_than(const PlanarArcGraph<PS>& g, const int depth); \
   template Field<bool, FaceId> odd_faces(const PlanarArcGraph<PS>& g); \
+  template Field<int, FaceId> face_winding_depths(const PlanarArcGraph<PS>& g); \
   template SmallArray<CircleArc, 2> unquantize_arc(const Quantizer<real,2>& quant, const ExactArc<PS>& unsigned_arc, const ArcDirection direction); \
 //INSTANTIATE(Pb::Explicit)
 INSTANTIATE(Pb::Implicit)
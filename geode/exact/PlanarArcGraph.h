@@ -125,24 +125,42 @@ template<Pb PS> class CircleSet {
   CircleId get_or_insert(const ExactCircle<PS>& c) { return circles.get_or_insert(c); }
 };
 
-// A wrapper that stores an array of intersections and manages conversion between ids and geometric primitives
-template<Pb PS> class VertexField {
+template<Pb PS> class VertexSort; // Forward declaration for use by VertexSet
+
+// Maintains a collection of circles and intersections with unique ids for all geometric primitives
+// Intersections are stored compactly in structure of arrays form: exact data lives only in the CircleSet, and each
+// vertex keeps its approximate location once, with a circle id and quadrant for each of its two incidents.
+// IncidentCircles are assembled from these on demand.
+template<Pb PS> class VertexSet : public CircleSet<PS> {
  protected:
-  // We store pairs of IncidentCircles instead of CircleIntersections so that we can return references for the majority of uses
-  // Size should always be even since we only add IncidentCircles in pairs
-  Field<IncidentCircle<PS>,IncidentId> incidents_;
+  // The incident circle of each IncidentId.  The reference circle of iid is the incident circle of opposite(iid).
+  // This gives the result of calling find_cid(incident(iid).as_circle()) without any expensive hashing
+  Field<CircleId, IncidentId> incident_cids;
+  Field<uint8_t, IncidentId> quadrants; // Quadrant of each intersection relative to the center of its reference circle
+  Field<ApproxIntersection, VertexId> approxes; // Shared by both incidents of each vertex
+  Hashtable<Vector<CircleId,2>,VertexId> vid_cache; // Used to avoid duplicates of the same intersection
+
+  // Adds an intersection. Caller must ensure this intersection does not already exist
+  IncidentId append_unique(const ExactCircle<PS>& ref, const IncidentCircle<PS>& inc, const CircleId ref_cid, const CircleId inc_cid); // Adds both views of the vertex
  public:
-  int n_vertices() const { assert((incidents_.size() % 2) == 0); return incidents_.size()/2; }
-  int n_incidents() const { return incidents_.size(); }
+  using CircleSet<PS>::circle;
+  using CircleSet<PS>::get_or_insert;
+  using CircleSet<PS>::find_cid;
+
+  int n_vertices() const { return approxes.size(); }
+  int n_incidents() const { return incident_cids.size(); }
   Range<IdIter<VertexId>> vertex_ids() const { return id_range<VertexId>(n_vertices()); }
   Range<IdIter<IncidentId>> incident_ids() const { return id_range<IncidentId>(n_incidents()); }
 
-  const ApproxIntersection& approx(const IncidentId iid) const { return incidents_[iid].approx; }
-  const ExactCircle<PS>& reference(const IncidentId iid) const { return incidents_[opposite(iid)].as_circle(); }
-  const IncidentCircle<PS>& incident(const IncidentId iid) const { return incidents_[iid]; }
+  const ApproxIntersection& approx(const IncidentId iid) const { return approxes[to_vid(iid)]; }
+  uint8_t quadrant(const IncidentId iid) const { return quadrants[iid]; }
+  const ExactCircle<PS>& reference(const IncidentId iid) const { return circle(incident_cids[opposite(iid)]); }
+  IncidentCircle<PS> incident(const IncidentId iid) const {
+    return IncidentCircle<PS>(circle(incident_cids[iid]), side(iid), approx(iid), quadrants[iid]);
+  }
 
-  const ExactCircle<PS>& cl(const VertexId vid) const { return incidents_[iid_cl(vid)].as_circle(); }
-  const ExactCircle<PS>& cr(const VertexId vid) const { return incidents_[iid_cr(vid)].as_circle(); }
+  const ExactCircle<PS>& cl(const VertexId vid) const { return circle(incident_cids[iid_cl(vid)]); }
+  const ExactCircle<PS>& cr(const VertexId vid) const { return circle(incident_cids[iid_cr(vid)]); }
 
   ExactArc<PS> arc(const IncidentId src, const IncidentId dst) const {
     assert(is_same_circle(reference(src), reference(dst)));
@@ -151,28 +169,6 @@ template<Pb PS> class VertexField {
 
   ExactArc<PS> arc(const UnsignedArcInfo info) const { return arc(info.src, info.dst); }
 
-  // Adds an intersection. Caller must ensure this intersection does not already exist
-  IncidentId append_unique(const ExactCircle<PS>& ref, const IncidentCircle<PS>& inc); // Adds both views of the vertex
-  void extend_unique(const RawArray<const IncidentCircle<PS>> new_incidents);
-};
-
-template<Pb PS> class VertexSort; // Forward declaration for use by VertexSet
-
-// Maintains a collection of circles and intersections with unique ids for all geometric primitives
-template<Pb PS> class VertexSet : public CircleSet<PS> , public VertexField<PS> {
- protected:
-  // Provide fast mapping between IncidentCircles in VertexField and ExactCircles in the CircleSet
-  // Provides result of calling find_cid(incident(iid).as_circle()) without any expensive hashing
-  Field<CircleId, IncidentId> iid_to_cid;
-  Hashtable<Vector<CircleId,2>,VertexId> vid_cache; // Used to avoid duplicates of the same intersection
- public:
-  using VertexField<PS>::approx;
-  using VertexField<PS>::reference;
-  using VertexField<PS>::incident;
-  using VertexField<PS>::arc;
-  using CircleSet<PS>::get_or_insert;
-  using CircleSet<PS>::find_cid;
-
   // These provide fast mapping from IncidentId to the CircleIds at that intersection
   CircleId reference_cid(const IncidentId iid) const;
   CircleId incident_cid(const IncidentId iid) const;
@@ -205,6 +201,11 @@ template<Pb PS> class VertexSet : public CircleSet<PS> , public VertexField<PS>
   void quantize_circle_arcs(const Quantizer<real,2>& quant, const Nested<const CircleArc> src_arcs, ArcContours& result, const bool src_arcs_open=false);
   ArcContours quantize_circle_arcs(const Quantizer<real,2>& quant, const Nested<const CircleArc> src_arcs, const bool src_arcs_open=false);
 
+  // Adds one contour of quantized arcs starting at x0 with circles from construct_circle_centers_and_radii, for use by quantize_circle_arcs
+  void add_quantized_contour(RawArray<const Vector<Quantized,2>> x0, RawArray<const real> q,
+                             RawArray<const Tuple<Vector<Quantized,2>,Quantized>> circles,
+                             const Vector<Quantized,2> tail_point, ArcContours& result, const bool src_arcs_open);
+
   // Converts exact contours (which currently must be closed although open contours should be handled in the future) into CircleArcs
   // This function attempts to cull artifacts introduced by quantization, but will also simplify nearly degenerate arcs or contours
   void unquantize_circle_arcs(const Quantizer<real,2>& quant, const RawArcContour& contour, Nested<CircleArc, false>& result) const;
@@ -328,12 +329,14 @@ protected:
   // This constructor splits edges and computes the embedding
   // If weights is non-empty, each edge in contour will have weight multiplied by corresponding value in weights
   // Weights use an 8 bit int since I think only -1,0, and 1 are likely to be used in practice
-  PlanarArcGraph(const VertexSet<PS>& _vertices, const ArcContours& contours, RawArray<const int8_t> weights={});
+  // If split_contours is positive, the first split_contours contours must not cross each other except at existing vertices
+  // (such as boundaries extracted from a previous union), which lets us skip intersecting their circles against each other
+  PlanarArcGraph(const VertexSet<PS>& _vertices, const ArcContours& contours, RawArray<const int8_t> weights={}, const int split_contours=0);
 
 public:
   // Initializes a PlanarArcGraph for the given contours
   // All vertices and circles must have been added to vertices
-  void embed_arcs(const ArcContours& contours, RawArray<const int8_t> weights={});
+  void embed_arcs(const ArcContours& contours, RawArray<const int8_t> weights={}, const int split_contours=0);
 
   inline CircleId circle_id(const EdgeId eid) const;
   inline IncidentId src(const EdgeId eid) const;
@@ -390,6 +393,7 @@ template<Pb PS> struct ArcAccumulator {
   // Most usage will need to directly add primitives to these
   VertexSet<PS> vertices;
   ArcContours contours;
+  int split_contours = 0; // Number of leading contours that don't cross each other (see PlanarArcGraph constructor)
 
   // Shortcut to handle turning a circle into an arc (handles construction of placeholder intersection)
   void add_full_circle(const ExactCircle<PS>& c, const ArcDirection dir);
@@ -400,6 +404,11 @@ template<Pb PS> struct ArcAccumulator {
   // Copy intersections out of a VertexSet and add contours with the new ids
   void copy_contours(const ArcContours& src_contours, const VertexSet<PS>& src_vertices);
 
+  // As copy_contours, but marks the copied contours as already split against each other so that the embedding
+  // won't intersect them again.  This is only valid for contours that don't cross (such as those of a union) and
+  // must be called before any other contours are added.
+  void copy_split_contours(const ArcContours& src_contours, const VertexSet<PS>& src_vertices);
+
   // Use vertices and contours to create a PlanarArcGraph
   Ref<PlanarArcGraph<PS>> compute_embedding() const;
 
@@ -410,6 +419,12 @@ template<Pb PS> struct ArcAccumulator {
 template<Pb PS> Field<bool, FaceId> faces_greater_than(const PlanarArcGraph<PS>& g, const int depth);
 template<Pb PS> Field<bool, FaceId> odd_faces(const PlanarArcGraph<PS>& g);
 
+// Winding number of each face.  To extract several depths or rules from one graph, compute these once and use the
+// overloads below instead of recomputing them in each query.
+template<Pb PS> Field<int, FaceId> face_winding_depths(const PlanarArcGraph<PS>& g);
+GEODE_CORE_EXPORT Field<bool, FaceId> faces_greater_than(RawField<const int, FaceId> depths, const int depth);
+GEODE_CORE_EXPORT Field<bool, FaceId> odd_faces(RawField<const int, FaceId> depths);
+
 // Performs quantization of contours and computes planar embedding
 template<Pb PS> Ref<PlanarArcGraph<PS>> quantize_circle_arcs(const Quantizer<real,2>& quant, const Nested<const CircleArc> arcs);
 // As above, but computes and returns an appropriate quantizer
@@ -0,0 +1,36 @@
+// Polygon arrangements reused across depth and fill rule queries
+
+#include <geode/exact/PolygonArrangement.h>
+#include <geode/array/amap.h>
+#include <geode/python/Class.h>
+namespace geode {
+
+GEODE_DEFINE_TYPE(PolygonArrangement)
+
+PolygonArrangement::PolygonArrangement(Nested<const Vec2> polys)
+  : quant(quantizer(bounding_box(polys)))
+  , graph(amap(quant,polys).copy())
+  , depths(face_winding_depths(graph)) {}
+
+PolygonArrangement::~PolygonArrangement() {}
+
+Nested<Vec2> PolygonArrangement::exact_split(const int depth, const FillRule rule) const {
+  return extract_faces(graph,depths,depth,rule);
+}
+
+Nested<Vec2> PolygonArrangement::split(const int depth, const FillRule rule) const {
+  return amap(quant.inverse,exact_split(depth,rule));
+}
+
+}
+using namespace geode;
+
+void wrap_polygon_arrangement() {
+  typedef PolygonArrangement Self;
+  Class<Self>("PolygonArrangement")
+    .GEODE_INIT(Nested<const Vec2>)
+    .GEODE_METHOD(split_greater)
+    .GEODE_METHOD(split_parity)
+    .GEODE_METHOD(split_neq)
+    ;
+}
@@ -0,0 +1,40 @@
+// Polygon arrangements reused across depth and fill rule queries
+#pragma once
+
+// split_polygons_with_rule quantizes its input, builds an ExactSegmentGraph, and computes face winding numbers on
+// every call.  PolygonArrangement does this once, so that unions, intersections, parity and other depth or fill rule
+// queries on the same polygons (such as the layers of a slice) each cost only a face extraction.
+
+#include <geode/exact/ExactSegmentGraph.h>
+#include <geode/exact/polygon_csg.h>
+#include <geode/exact/quantize.h>
+#include <geode/python/Object.h>
+namespace geode {
+
+class PolygonArrangement : public Object {
+public:
+  GEODE_DECLARE_TYPE(GEODE_CORE_EXPORT)
+  typedef Object Base;
+
+  const Quantizer<real,2> quant;
+  const ExactSegmentGraph graph;
+  const Field<const int,FaceId> depths; // Winding depth of each face
+
+protected:
+  GEODE_CORE_EXPORT PolygonArrangement(Nested<const Vec2> polys);
+public:
+  ~PolygonArrangement();
+
+  // Equivalent to split_polygons_with_rule(polys,depth,rule)
+  GEODE_CORE_EXPORT Nested<Vec2> split(const int depth, const FillRule rule=FillRule::Greater) const;
+
+  // As split, but in quantized coordinates
+  GEODE_CORE_EXPORT Nested<Vec2> exact_split(const int depth, const FillRule rule=FillRule::Greater) const;
+
+  // Python versions, since FillRule has no python class
+  Nested<Vec2> split_greater(const int depth) const { return split(depth,FillRule::Greater); }
+  Nested<Vec2> split_parity(const int depth) const { return split(depth,FillRule::Parity); }
+  Nested<Vec2> split_neq(const int depth) const { return split(depth,FillRule::NotEqual); }
+};
+
+}
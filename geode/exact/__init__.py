@@ -14,8 +14,12 @@ else:
 if not has_exact():
   raise ImportError('geode/exact is unavailable since geode was compiled without gmp support')
 
-def delaunay_points(X,edges=zeros((0,2),dtype=int32),validate=False):
-  return delaunay_points_py(X,edges,validate)
+def delaunay_points(X,edges=zeros((0,2),dtype=int32),validate=False,parallel=False,bulk_constraints=False):
+  return delaunay_points_py(X,edges,validate,parallel,bulk_constraints)
+
+def refine_delaunay_points(X,edges=zeros((0,2),dtype=int32),min_angle=pi/9,max_area=inf,max_steiner=2**31-1):
+  '''Quality constrained Delaunay triangulation via Ruppert refinement.  Returns mesh,positions.'''
+  return refine_delaunay_points_py(X,edges,min_angle,max_area,max_steiner)
 
 def polygon_union(*polys):
   '''The union of possibly intersecting polygons, assuming consistent ordering'''
@@ -69,6 +73,12 @@ def soup_union(*meshes):
 def soup_intersection(*meshes):
   return split_soups(meshes,depth=len(meshes)-1)
 
+def soups_union(meshes,leaf_size=4):
+  '''Union many closed meshes, grouping nearby meshes hierarchically (see union_soups)'''
+  soup,X = merge_meshes(meshes)
+  parts = concatenate([i+zeros(len(m.elements if isinstance(m,TriangleSoup) else m),dtype=int32) for i,(m,_) in enumerate(meshes)])
+  return union_soups(soup,X,parts,leaf_size)
+
 def split_mesh_with_weight(mesh, weights, depth=0):
   return meshify(*split_soup_with_weight(mesh.face_soup()[0], mesh.vertex_field(vertex_position_id), weights, depth))
 
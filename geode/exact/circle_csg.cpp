@@ -21,8 +21,18 @@
 #include <geode/python/wrap.h>
 #include <geode/random/Random.h>
 #include <geode/structure/Hashtable.h>
+#include <geode/structure/UnionFind.h>
+#include <geode/utility/openmp.h>
+#include <geode/vector/transform.h>
+#include <exception>
+#include <vector>
 namespace geode {
 
+using std::vector;
+
+// Minimum number of arcs per tile for parallel_split_circle_arcs
+static const int parallel_tile_arcs = 1<<12;
+
 Box<Vector<real,2>> approximate_bounding_box(const RawArray<const CircleArc> input) {
   Box<Vector<real,2>> result;
   for (int j=0,i=input.size()-1;j<input.size();i=j++) {
@@ -68,6 +78,136 @@ Nested<CircleArc> split_arcs_by_parity(Nested<const CircleArc> arcs) {
   return result;
 }
 
+namespace {
+struct ContourOverlaps {
+  const BoxTree<exact::Vec2>& tree;
+  UnionFind& union_find;
+
+  ContourOverlaps(const BoxTree<exact::Vec2>& tree, UnionFind& union_find)
+    : tree(tree), union_find(union_find) {}
+
+  bool cull(const int n) const { return false; }
+  bool cull(const int n0, const int n1) const { return false; }
+  void leaf(const int n) const {}
+  void leaf(const int n0, const int n1) {
+    for (const int i : tree.prims(n0))
+      for (const int j : tree.prims(n1))
+        union_find.merge(i,j);
+  }
+};
+}
+
+// Since quantization treats each contour independently, we can quantize every contour once, group contours whose
+// exact arc bounds overlap, and pack the groups into tiles.  Contours in different tiles share no points and have
+// zero winding outside their bounds, so for depth >= 0 the tiles can be split independently and concatenated.
+Nested<CircleArc> parallel_split_circle_arcs(Nested<const CircleArc> arcs, const int depth) {
+  IntervalScope scope;
+  const auto PS = Pb::Implicit;
+  auto bounds = approximate_bounding_box(arcs);
+  if (bounds.empty()) bounds = Box<Vec2>::unit_box();
+  const auto quant = make_arc_quantizer(bounds);
+  const int n = arcs.size();
+  const int threads = omp_get_max_threads();
+  const bool tiled = depth>=0 && threads>1 && arcs.flat.size()>=2*parallel_tile_arcs;
+
+  // Compute exact bounds for each contour, skipping contours that quantize away
+  Array<Box<exact::Vec2>> boxes;
+  if (tiled) {
+    boxes.resize(n);
+    const int chunks = min(n,4*threads);
+    std::exception_ptr error;
+    #pragma omp parallel for schedule(dynamic,1)
+    for (int k=0;k<chunks;k++) {
+      try {
+        IntervalScope scope;
+        VertexSet<PS> vertices;
+        ArcContours contours;
+        for (int p=n*k/chunks;p<n*(k+1)/chunks;p++) {
+          const int before = contours.size();
+          vertices.quantize_circle_arcs(quant,arcs[p],contours);
+          if (contours.size()>before)
+            for (const auto a : contours[before])
+              boxes[p].enlarge(bounding_box(vertices.arc(vertices.ccw_arc(a))));
+        }
+      } catch (...) {
+        #pragma omp critical
+        {
+          if (!error)
+            error = std::current_exception();
+        }
+      }
+    }
+    if (error)
+      std::rethrow_exception(error);
+  }
+
+  // Group contours with overlapping bounds and pack the groups into tiles of at least parallel_tile_arcs arcs
+  vector<Nested<CircleArc,false>> tiles;
+  if (tiled) {
+    Array<int> live;
+    Array<Box<exact::Vec2>> live_boxes;
+    for (const int p : range(n))
+      if (!boxes[p].empty()) {
+        live.append(p);
+        live_boxes.append(boxes[p]);
+      }
+    UnionFind union_find(live.size());
+    if (live.size()) {
+      const auto tree = new_<BoxTree<exact::Vec2>>(live_boxes,1);
+      ContourOverlaps overlaps(tree,union_find);
+      double_traverse(*tree,overlaps);
+    }
+    Array<int> group(live.size());
+    group.fill(-1);
+    vector<Array<int>> groups;
+    for (const int i : range(live.size())) {
+      int& g = group[union_find.find(i)];
+      if (g<0) {
+        g = int(groups.size());
+        groups.push_back(Array<int>());
+      }
+      groups[g].append(live[i]);
+    }
+    const int tile_arcs = max(parallel_tile_arcs,arcs.flat.size()/(4*threads));
+    for (const auto& g : groups) {
+      if (!tiles.size() || tiles.back().flat.size()>=tile_arcs)
+        tiles.push_back(Nested<CircleArc,false>());
+      for (const int p : g)
+        tiles.back().append(arcs[p]);
+    }
+  }
+  if (tiles.size()<=1) {
+    const auto g = quantize_circle_arcs<PS>(quant,arcs);
+    return g->unquantize_circle_arcs(quant,extract_region(g->topology,faces_greater_than(*g,depth)));
+  }
+
+  // Split each tile in parallel
+  vector<Nested<CircleArc>> results(tiles.size());
+  std::exception_ptr error;
+  #pragma omp parallel for schedule(dynamic,1)
+  for (int t=0;t<int(tiles.size());t++) {
+    try {
+      IntervalScope scope;
+      const auto g = quantize_circle_arcs<PS>(quant,tiles[t]);
+      results[t] = g->unquantize_circle_arcs(quant,extract_region(g->topology,faces_greater_than(*g,depth)));
+    } catch (...) {
+      #pragma omp critical
+      {
+        if (!error)
+          error = std::current_exception();
+      }
+    }
+  }
+  if (error)
+    std::rethrow_exception(error);
+
+  // Stitch the tiles together
+  Nested<CircleArc,false> result;
+  for (const auto& r : results)
+    result.extend(r);
+  return result.freeze();
+}
+
 ostream& operator<<(ostream& output, const CircleArc& arc) {
   return output << format("CircleArc([%g,%g],%g)",arc.x.x,arc.x.y,arc.q);
 }
@@ -118,6 +258,16 @@ void reverse_arcs(Nested<CircleArc> polyarcs) {
  for(auto poly : polyarcs) reverse_arcs(poly);
 }
 
+void transform(const Frame<Vector<real,2>>& f, RawArray<const CircleArc> arcs, RawArray<CircleArc> result) {
+  affine_transform(f.r.matrix(),f.t,arcs,result);
+}
+
+Nested<CircleArc> transformed(const Frame<Vector<real,2>>& f, Nested<const CircleArc> arcs) {
+  const auto result = Nested<CircleArc>::empty_like(arcs);
+  transform(f,arcs.flat,result.flat);
+  return result;
+}
+
 Nested<CircleArc> canonicalize_circle_arcs(Nested<const CircleArc> polys) {
   // Find the minimal point in each polygon under lexicographic order
   Array<int> mins(polys.size());
@@ -204,8 +354,9 @@ static Tuple<Nested<CircleArc>,Nested<CircleArc>,Nested<CircleArc>> single_circl
 
   const auto unquantized_input = acc.vertices.unquantize_circle_arcs(quant, acc.contours);
   auto graph = new_<PlanarArcGraph<Pb::Implicit>>(acc.vertices, acc.contours);
-  const auto unquantized_unions   = graph->unquantize_circle_arcs(quant, extract_region(graph->topology, faces_greater_than(*graph, 0)));
-  const auto unquantized_overlaps = graph->unquantize_circle_arcs(quant, extract_region(graph->topology, faces_greater_than(*graph, 1)));
+  const auto depths = face_winding_depths(*graph);
+  const auto unquantized_unions   = graph->unquantize_circle_arcs(quant, extract_region(graph->topology, faces_greater_than(depths, 0)));
+  const auto unquantized_overlaps = graph->unquantize_circle_arcs(quant, extract_region(graph->topology, faces_greater_than(depths, 1)));
   return tuple(unquantized_input, unquantized_unions, unquantized_overlaps);
 }
 
@@ -390,10 +541,12 @@ using namespace geode;
 void wrap_circle_csg() {
   GEODE_FUNCTION(split_circle_arcs)
   GEODE_FUNCTION(split_arcs_by_parity)
+  GEODE_FUNCTION(parallel_split_circle_arcs)
   GEODE_FUNCTION(canonicalize_circle_arcs)
   GEODE_FUNCTION_2(circle_arc_area,static_cast<real(*)(Nested<const CircleArc>)>(circle_arc_area))
   GEODE_FUNCTION(circle_arc_length)
   GEODE_FUNCTION(offset_arcs)
+  GEODE_FUNCTION(parallel_offset_arcs)
   GEODE_FUNCTION(offset_open_arcs)
   GEODE_FUNCTION(offset_shells)
   GEODE_FUNCTION(find_overlapping_offsets)
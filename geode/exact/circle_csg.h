@@ -36,6 +36,11 @@ struct CircleArc {
 GEODE_CORE_EXPORT Nested<CircleArc> split_circle_arcs(Nested<const CircleArc> arcs, const int depth);
 GEODE_CORE_EXPORT Nested<CircleArc> split_arcs_by_parity(Nested<const CircleArc> arcs);
 
+// Same as split_circle_arcs, but contours are grouped into spatial tiles which are split in parallel.  Only groups
+// of contours with disjoint bounds can be separated, so a single huge connected input gets no speedup.
+// Negative depths include the unbounded face and always fall back to a single graph.
+GEODE_CORE_EXPORT Nested<CircleArc> parallel_split_circle_arcs(Nested<const CircleArc> arcs, const int depth);
+
 // The union of possibly intersecting circular arc polygons, assuming consistent ordering
 template<class... Arcs> static inline Nested<CircleArc> circle_arc_union(const Arcs&... arcs) {
   return split_circle_arcs(concatenate(arcs...),0);
@@ -68,6 +73,12 @@ static inline CircleArc operator*(const Frame<Vector<real,2>>& a,    const Circl
 static inline CircleArc operator+(const Vector<real,2>& t, const CircleArc& c) { return CircleArc(t+c.x,c.q); }
 static inline CircleArc operator+(const CircleArc& c, const Vector<real,2>& t) { return CircleArc(t+c.x,c.q); }
 
+// Batch transforms of arcs and arc polygons, as for points in vector/transform.h
+static inline Vector<real,2>& transform_point(CircleArc& c) { return c.x; }
+static inline const Vector<real,2>& transform_point(const CircleArc& c) { return c.x; }
+GEODE_CORE_EXPORT void transform(const Frame<Vector<real,2>>& f, RawArray<const CircleArc> arcs, RawArray<CircleArc> result);
+GEODE_CORE_EXPORT Nested<CircleArc> transformed(const Frame<Vector<real,2>>& f, Nested<const CircleArc> arcs);
+
 // Hashing for circle arcs
 template<> struct is_packed_pod<CircleArc> : public mpl::true_{};
 
@@ -4,6 +4,10 @@
 #include <geode/exact/exact_circle_offsets.h>
 #include <geode/exact/PlanarArcGraph.h>
 #include <geode/exact/scope.h>
+#include <geode/geometry/BoxTree.h>
+#include <geode/geometry/traverse.h>
+#include <geode/structure/UnionFind.h>
+#include <geode/utility/parallel.h>
 
 namespace geode {
 static constexpr Pb PS = Pb::Implicit;
@@ -37,17 +41,10 @@ vector<Nested<CircleArc>> offset_shells(const Nested<const CircleArc> arcs, cons
   return result;
 }
 
-Nested<CircleArc> offset_arcs(const Nested<const CircleArc> arcs, const real d) {
-  auto bounds = approximate_bounding_box(arcs);
-  if(bounds.empty()) bounds = Box<Vec2>::unit_box(); // We generate a non-degenerate box in case input was empty
-  bounds = bounds.thickened(max(d,0.));
-  const Quantizer<real,2> quant = make_arc_quantizer(bounds);
+// Offset arcs by signed_offset, which must be nonzero, using a given quantizer
+GEODE_NEVER_INLINE static Nested<CircleArc> offset_arcs(const Quantizer<real,2>& quant, const Nested<const CircleArc> arcs,
+                                                        const Quantized signed_offset) {
   IntervalScope scope;
-  const Quantized signed_offset = quantize_offset(quant, d);
-  if(signed_offset == 0) {
-    return circle_arc_union(arcs); // Since we normally have to union inputs before we can take the offset, we do that here in case caller was relying on that union
-  }
-
   VertexSet<PS> input_verts;
   auto input_arcs = input_verts.quantize_circle_arcs(quant, arcs);
   const auto input_g = new_<PlanarArcGraph<PS>>(input_verts, input_arcs);
@@ -60,6 +57,98 @@ Nested<CircleArc> offset_arcs(const Nested<const CircleArc> arcs, const real d)
   return result;
 }
 
+static Quantizer<real,2> offset_quantizer(const Nested<const CircleArc> arcs, const real d) {
+  auto bounds = approximate_bounding_box(arcs);
+  if(bounds.empty()) bounds = Box<Vec2>::unit_box(); // We generate a non-degenerate box in case input was empty
+  bounds = bounds.thickened(max(d,0.));
+  return make_arc_quantizer(bounds);
+}
+
+Nested<CircleArc> offset_arcs(const Nested<const CircleArc> arcs, const real d) {
+  const Quantizer<real,2> quant = offset_quantizer(arcs, d);
+  IntervalScope scope;
+  const Quantized signed_offset = quantize_offset(quant, d);
+  if(signed_offset == 0) {
+    return circle_arc_union(arcs); // Since we normally have to union inputs before we can take the offset, we do that here in case caller was relying on that union
+  }
+  return offset_arcs(quant, arcs, signed_offset);
+}
+
+namespace {
+struct OffsetOverlaps {
+  const BoxTree<Vec2>& tree;
+  UnionFind& union_find;
+
+  OffsetOverlaps(const BoxTree<Vec2>& tree, UnionFind& union_find)
+    : tree(tree), union_find(union_find) {}
+
+  bool cull(const int n) const { return false; }
+  bool cull(const int n0, const int n1) const { return false; }
+  void leaf(const int n) const {}
+  void leaf(const int n0, const int n1) {
+    for (const int i : tree.prims(n0))
+      for (const int j : tree.prims(n1))
+        union_find.merge(i,j);
+  }
+};
+}
+
+// Contours whose bounds, grown by the offset, don't overlap can't interact, so as in parallel_split_circle_arcs we
+// group contours with overlapping bounds, pack the groups into tiles, and offset the tiles independently.  All tiles
+// share the quantizer offset_arcs would use, so the result matches offset_arcs up to the order of contours.
+Nested<CircleArc> parallel_offset_arcs(const Nested<const CircleArc> arcs, const real d, const int tile_arcs) {
+  GEODE_ASSERT(tile_arcs>0);
+  const Quantizer<real,2> quant = offset_quantizer(arcs, d);
+  const int n = arcs.size();
+  Quantized signed_offset;
+  {
+    IntervalScope scope;
+    signed_offset = quantize_offset(quant, d);
+  }
+  if(signed_offset == 0 || arcs.flat.size() < 2*tile_arcs)
+    return offset_arcs(arcs, d);
+
+  // Group contours whose grown bounds overlap.  The slack of a few quantization units covers rounding.
+  const real grow = max(d,0.)+8*quant.inverse.inv_scale;
+  Array<Box<Vec2>> boxes(n,uninit);
+  for (const int p : range(n))
+    boxes[p] = approximate_bounding_box(arcs[p]).thickened(grow);
+  UnionFind union_find(n);
+  {
+    const auto tree = new_<BoxTree<Vec2>>(boxes,1);
+    OffsetOverlaps overlaps(tree,union_find);
+    double_traverse(*tree,overlaps);
+  }
+  Array<int> group(n);
+  group.fill(-1);
+  vector<Array<int>> groups;
+  for (const int p : range(n)) {
+    int& g = group[union_find.find(p)];
+    if (g<0) {
+      g = int(groups.size());
+      groups.push_back(Array<int>());
+    }
+    groups[g].append(p);
+  }
+  vector<Nested<CircleArc,false>> tiles;
+  for (const auto& g : groups) {
+    if (!tiles.size() || tiles.back().flat.size()>=tile_arcs)
+      tiles.push_back(Nested<CircleArc,false>());
+    for (const int p : g)
+      tiles.back().append(arcs[p]);
+  }
+
+  // Offset each tile in parallel, and stitch the results together
+  vector<Nested<CircleArc>> results(tiles.size());
+  parallel_for(int(tiles.size()),[&](const int t) {
+    results[t] = offset_arcs(quant, tiles[t].freeze(), signed_offset);
+  },1);
+  Nested<CircleArc,false> result;
+  for (const auto& r : results)
+    result.extend(r);
+  return result.freeze();
+}
+
 Nested<CircleArc> offset_open_arcs(const Nested<const CircleArc> arcs, const real d) {
   const auto bounds = approximate_bounding_box(arcs).thickened(max(d,0));
   const auto quant = make_arc_quantizer(bounds);
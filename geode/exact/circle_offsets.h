@@ -11,6 +11,11 @@ namespace geode {
 // * If user has a way to simplify arc contours (not currently available in geode) between iterations this would avoid the issue
 Nested<CircleArc> offset_arcs(const Nested<const CircleArc> arcs, const real d);
 
+// offset_arcs, processing groups of contours that can't interact in parallel tiles of at least tile_arcs arcs.  The
+// result matches offset_arcs up to the order of contours.
+GEODE_CORE_EXPORT Nested<CircleArc> parallel_offset_arcs(const Nested<const CircleArc> arcs, const real d,
+                                                         const int tile_arcs = 1<<12);
+
 // Generate closed contours around area covered by a disk of radius d moving along open arcs
 Nested<CircleArc> offset_open_arcs(const Nested<const CircleArc> arcs, const real d);
 
@@ -5,6 +5,8 @@
 #include <geode/exact/Exact.h>
 #include <geode/exact/math.h>
 #include <geode/exact/perturb.h>
+#include <geode/math/uint128.h>
+#include <geode/utility/parallel.h>
 
 #if CHECK_CONSTRUCTIONS
 #include <geode/exact/circle_objects.h>
@@ -28,7 +30,7 @@ Quantizer<real,2> make_arc_quantizer(const Box<Vector<real,2>> arc_bounds) {
 
 // Return integers num,denom both with magnitude less than or equal to exact::bound such that num/denom approximately equals x.
 // If abs(x) is very large result may be clamped to +/- exact::bound
-static Vector<Exact<1>,2> rational_approximation(const real x) {
+static Vector<ExactInt,2> rational_approximation(const real x) {
   assert(!isnan(x));
 
   // x == x/1 == x*denom / denom == num / denom
@@ -42,14 +44,14 @@ static Vector<Exact<1>,2> rational_approximation(const real x) {
   assert(abs(approx_num) <= exact::bound);
   if(denom > 0) {
     assert(sign(approx_num) == sign(x) || approx_num == 0);
-    return vec(Exact<1>(approx_num), Exact<1>(denom));
+    return vec(ExactInt(approx_num), denom);
   }
   else {
     // If abs(x) is on the order of 0.5*exact::bound or larger, denom could have been rounded to zero
     // Compute a numerator in the valid range and use 1 for the denom
     const ExactInt safe_num = ExactInt(clamp(round(x), real(-exact::bound), real(exact::bound)));
     assert(sign(safe_num) == sign(x));
-    return vec(Exact<1>(safe_num), Exact<1>(1));
+    return vec(safe_num, ExactInt(1));
   }
 }
 
@@ -69,23 +71,20 @@ static bool test_circles_intersect(const Vector<Quantized,2> c0, const Quantized
 // a circle with radius and center as returned from construct_circle_radius_and_center(x0,x1,q)
 Quantized constructed_arc_endpoint_error_bound() { return 2; } // ceil(sqrt(2)/2)
 
-// Returns a center and radius for a circle that passes within constructed_arc_endpoint_error_bound() units of each quantized vertex and has approxamently the correct curvature
-// x0 and x1 should be integer points (from quantizer)
-// WARNING: If endpoints have been quantized to the same point, a radius of 0 (invalid for an ExactCircleArc) will be returned to indicate no arc is needed
-// As long as x0 != x1, a circle of radius constructed_arc_endpoint_error_bound() centered at x0 or x1 will always intersect the returned circle
-Tuple<Vector<Quantized,2>, Quantized> construct_circle_center_and_radius(const Vector<Quantized, 2> x0, const Vector<Quantized, 2> x1, const real q) {
-  if(x0 == x1) {
-    return tuple(x0, Quantized(0));
-  }
+static const ExactInt max_radius = exact::bound/8; // FIXME: I'm not convinced this is correct, but it will work for now
 
+// Computes the unadjusted center and radius for construct_circle_center_and_radius using exact arithmetic
+static void exact_center_and_radius(const Vector<Quantized,2> x0, const Vector<Quantized,2> x1, const real q,
+                                    Vector<Quantized,2>& center, Quantized& r, bool& must_scale_H) {
   const Vector<Exact<1>,2> ex0(x0),
                            ex1(x1);
 
   const Vector<Exact<1>,2> delta = ex1 - ex0;
 
-  const Exact<1> max_r = Exact<1>(exact::bound/8); // FIXME: I'm not convinced this is correct, but it will work for now
+  const Exact<1> max_r = Exact<1>(max_radius);
 
-  const Vector<Exact<1>,2> q_fract = rational_approximation(q);
+  const auto q_int = rational_approximation(q);
+  const Vector<Exact<1>,2> q_fract(Exact<1>(q_int.x),Exact<1>(q_int.y));
   assert(sign(q_fract.y) == 1);
   assert(sign(q_fract.x) == sign(q) || !is_nonzero(q_fract.x));
 
@@ -97,9 +96,8 @@ Tuple<Vector<Quantized,2>, Quantized> construct_circle_center_and_radius(const V
   const Exact<3> H_num_l1 = H_num.L1_Norm();
 
   // Compare length of H (using l-one norm for simplicity) and max_r to ensure we aren't going to generate a center that is out of bounds
-  const bool must_scale_H = (H_num_l1 >= max_r * abs(H_den));
+  must_scale_H = (H_num_l1 >= max_r * abs(H_den));
 
-  Vector<Quantized,2> center;
   if(must_scale_H) {
     // If H is too big, we need to scale it so that biggest component is <= max_r
     // We need: (H_num_l_inf / abs(H_den)) * s = max_r
@@ -123,9 +121,119 @@ Tuple<Vector<Quantized,2>, Quantized> construct_circle_center_and_radius(const V
   // Since C is exact up to rounding, we know that distance to endpoints will differ by at most sqrt(2)
   // Instead of multiple calls to snap_div, we just take average of squared distances to each endpoint
   // This value will be at or between the two options and is symmetric with respect to x0 and x1
-  auto ecenter = Vector<Exact<1>,2>(center);
+  const auto ecenter = Vector<Exact<1>,2>(center);
   const Exact<2> sum_dist_sqr = esqr_magnitude(ecenter - ex0) + esqr_magnitude(ecenter - ex1);
-  Quantized r = snap_div(sum_dist_sqr, Exact<1>(2), true);
+  r = snap_div(sum_dist_sqr, Exact<1>(2), true);
+}
+
+#if defined(__GNUC__) && defined(__LP64__)
+
+// Round x to the nearest integer with halfway cases away from zero (as snap_div does), given that x is accurate to within
+// error.  Returns false if the rounding direction can't be determined or the result is out of bounds.
+static inline bool certified_round(const real x, const real error, Quantized& result) {
+  const real f = abs(x)-floor(abs(x));
+  if (!(abs(f-.5) > error))
+    return false;
+  result = round(x)+0.; // Avoid negative zero
+  return abs(result) <= exact::bound;
+}
+
+// Computes the same result as exact_center_and_radius using floating point and 128-bit integers, or returns false if
+// floating point error could change the result.  The center is computed in floating point unless it must be scaled,
+// in which case the common factor of d^2-n^2 cancels and 128-bit integers suffice.  The radius is always exact.
+static bool fast_center_and_radius(const Vector<Quantized,2> x0, const Vector<Quantized,2> x1, const real q,
+                                   Vector<Quantized,2>& center, Quantized& r, bool& must_scale_H) {
+  typedef __int128_t I;
+  // Keep differences, sums, and products of coordinates exact
+  const real limit = real(ExactInt(1)<<51);
+  if (!(x0.maxabs() < limit && x1.maxabs() < limit))
+    return false;
+  const real eps = numeric_limits<real>::epsilon();
+
+  const auto q_int = rational_approximation(q);
+  const real n = real(q_int.x),
+             d = real(q_int.y);
+  const auto d_perp = (x1-x0).orthogonal_vector();
+  const real l1 = d_perp.L1_Norm(),
+             a = (d-n)*(d+n); // Relative error at most 3*eps/2
+
+  // Decide whether H must be scaled by comparing |d^2-n^2|*l1 against max_r*|4*n*d|
+  if (!n)
+    must_scale_H = true;
+  else {
+    const real lhs = abs(a)*l1,
+               rhs = real(max_radius)*(4*abs(n)*d);
+    if (lhs > rhs*(1+16*eps))
+      must_scale_H = true;
+    else if (lhs*(1+16*eps) < rhs)
+      must_scale_H = false;
+    else
+      return false;
+  }
+
+  if (must_scale_H) {
+    // C = (s*2*max_r*d_perp + l1*(x0+x1))/(2*l1), where s is the sign of q times the sign of d^2-n^2
+    const int s = (std::signbit(q) ? -1 : 1)*(a<0 ? -1 : 1);
+    const I den = 2*I(l1);
+    for (const int i : range(2)) {
+      const I num = s*2*I(max_radius)*I(d_perp[i])+I(l1)*(I(x0[i])+I(x1[i]));
+      const I mag = (2*(num<0 ? -num : num)+den)/(2*den);
+      if (mag > I(exact::bound))
+        return false;
+      center[i] = num<0 && mag ? -real(mag) : real(mag);
+    }
+  } else {
+    // C = (x0+x1)/2 + t*d_perp with t = (d^2-n^2)/(4*n*d).  t has relative error at most 3*eps, so a generous bound is
+    // 8*eps times the magnitudes of the terms.
+    const real t = a/(4*n*d);
+    for (const int i : range(2)) {
+      const real h = t*d_perp[i],
+                 m = .5*(x0[i]+x1[i]);
+      if (!certified_round(h+m,8*eps*(abs(h)+abs(m)),center[i]))
+        return false;
+    }
+  }
+
+  // r = round(sqrt(S/2)) with S the sum of squared distances to the endpoints, computed as (1+isqrt(2*S))//2 as in snap_div
+  typedef uint128_t U;
+  const auto sqr_diff = [](const real x, const real y) { const I d = I(x)-I(y); return U(d*d); };
+  const U S2 = 2*(sqr_diff(center.x,x0.x)+sqr_diff(center.y,x0.y)+sqr_diff(center.x,x1.x)+sqr_diff(center.y,x1.y));
+  U root = U(sqrt(real(S2)));
+  while (root*root > S2)
+    root--;
+  while ((root+1)*(root+1) <= S2)
+    root++;
+  const U rr = (1+root)/2;
+  if (rr > U(exact::bound))
+    return false;
+  r = Quantized(rr);
+  return true;
+}
+
+#else
+
+static bool fast_center_and_radius(const Vector<Quantized,2> x0, const Vector<Quantized,2> x1, const real q,
+                                   Vector<Quantized,2>& center, Quantized& r, bool& must_scale_H) {
+  return false;
+}
+
+#endif
+
+// Returns a center and radius for a circle that passes within constructed_arc_endpoint_error_bound() units of each quantized vertex and has approxamently the correct curvature
+// x0 and x1 should be integer points (from quantizer)
+// WARNING: If endpoints have been quantized to the same point, a radius of 0 (invalid for an ExactCircleArc) will be returned to indicate no arc is needed
+// As long as x0 != x1, a circle of radius constructed_arc_endpoint_error_bound() centered at x0 or x1 will always intersect the returned circle
+Tuple<Vector<Quantized,2>, Quantized> construct_circle_center_and_radius(const Vector<Quantized, 2> x0, const Vector<Quantized, 2> x1, const real q) {
+  if(x0 == x1) {
+    return tuple(x0, Quantized(0));
+  }
+
+  // Most arcs can be constructed with floating point, falling back to exact arithmetic near rounding boundaries
+  Vector<Quantized,2> center;
+  Quantized r;
+  bool must_scale_H;
+  if(!fast_center_and_radius(x0, x1, q, center, r, must_scale_H))
+    exact_center_and_radius(x0, x1, q, center, r, must_scale_H);
 
   // We need a circle centered at x0 or x1 with radius == constructed_arc_endpoint_error_bound() to intersect the constructed circle
   // As computed above, center and r will ensure this happens except when r is too small and the constructed arc is fully inside the endpoint error circles
@@ -133,7 +241,7 @@ Tuple<Vector<Quantized,2>, Quantized> construct_circle_center_and_radius(const V
     // For an endpoint outside the circle, it is safe to increase r since that will decrease error to that endpoint
     // We only grow radius up to the error bound so it is impossible to overshoot by too much
     // Any endpoints that start inside the circle will be ok unless they are exactly at the center of the constructed arc
-    if(ecenter == ex0 || ecenter == ex1) {
+    if(center == x0 || center == x1) {
       // Center point was exactly on the line of points equidistant to x0 and x1
       // Rounding it moved it by at most sqrt(0.5) so distance from x0 to x1 is <= 2*sqrt(0.5) == sqrt(2)
       // We move center by the orthogonal delta between x0 and x1 to ensure we don't move it on top of the other endpoint
@@ -163,5 +271,16 @@ Tuple<Vector<Quantized,2>, Quantized> construct_circle_center_and_radius(const V
   return tuple(center, r);
 }
 
+Array<Tuple<Vector<Quantized,2>,Quantized>> construct_circle_centers_and_radii(RawArray<const Vector<Quantized,2>> x0,
+                                                                               RawArray<const Vector<Quantized,2>> x1,
+                                                                               RawArray<const real> q) {
+  GEODE_ASSERT(x0.size()==x1.size() && x0.size()==q.size());
+  Array<Tuple<Vector<Quantized,2>,Quantized>> result(x0.size(),uninit);
+  parallel_for(x0.size(),[&](const int i) {
+    result[i] = construct_circle_center_and_radius(x0[i],x1[i],q[i]);
+  },64);
+  return result;
+}
+
 } // namespace geode
 
@@ -13,6 +13,11 @@ namespace geode {
 GEODE_CORE_EXPORT Tuple<Vector<Quantized,2>, Quantized> construct_circle_center_and_radius(const Vector<Quantized, 2> x0, const Vector<Quantized, 2> x1, const real q);
 GEODE_CORE_EXPORT Quantized constructed_arc_endpoint_error_bound();
 
+// Batched version of construct_circle_center_and_radius for arcs from x0[i] to x1[i] with curvature q[i], computed in parallel
+GEODE_CORE_EXPORT Array<Tuple<Vector<Quantized,2>,Quantized>> construct_circle_centers_and_radii(RawArray<const Vector<Quantized,2>> x0,
+                                                                                                 RawArray<const Vector<Quantized,2>> x1,
+                                                                                                 RawArray<const real> q);
+
 // Returns a quantizer padded to be able to approximate straight lines
 GEODE_CORE_EXPORT Quantizer<real,2> make_arc_quantizer(const Box<Vector<real,2>> arc_bounds);
 
@@ -1,9 +1,20 @@
 #include <geode/exact/collision.h>
 #include <geode/exact/Interval.h>
 #include <geode/exact/scope.h>
+#include <geode/exact/BatchInterval.h>
 #include <geode/exact/Expansion.h>
+#include <geode/array/Array.h>
+#include <geode/array/sort.h>
+#include <geode/geometry/SimplexTree.h>
+#include <geode/geometry/traverse.h>
+#include <geode/mesh/SegmentSoup.h>
+#include <geode/mesh/TriangleSoup.h>
+#include <geode/python/wrap.h>
+#include <geode/random/Random.h>
+#include <geode/utility/openmp.h>
 #include <geode/vector/magnitude.h>
 #include <geode/vector/normalize.h>
+#include <exception>
 namespace geode {
 
 namespace {
@@ -2546,6 +2557,88 @@ bool point_triangle_collision_parity(const TV& x0old, const TV& x1old, const TV&
   return test.point_triangle_collision();
 }
 
+// Candidates per parallel batch of exact tests
+static const int collision_batch = 256;
+
+// If the boxes swept out by vertices [0,a) and [a,4) are disjoint, the two primitives never meet during linear motion
+// and the parity is zero.  Box comparisons are exact in floating point, so no IntervalScope is needed.  The loop body
+// is branch free so that the compiler can vectorize it.
+template<int a> static Array<int> swept_box_survivors(RawArray<bool> results, RawArray<const TV> Xold,
+                                                      RawArray<const TV> Xnew, RawArray<const Vector<int,4>> candidates) {
+  GEODE_ASSERT(results.size()==candidates.size());
+  GEODE_ASSERT(Xold.size()==Xnew.size());
+  const int n = candidates.size(),
+            nx = Xold.size();
+  for (const auto& c : candidates)
+    for (int i=0;i<4;i++)
+      GEODE_ASSERT(unsigned(c[i])<unsigned(nx));
+  for (int i=0;i<n;i++) {
+    const auto& c = candidates[i];
+    bool disjoint = false;
+    for (int d=0;d<3;d++) {
+      double lo0 =  inf, hi0 = -inf,
+             lo1 =  inf, hi1 = -inf;
+      for (int j=0;j<4;j++) {
+        const double xo = Xold[c[j]][d],
+                     xn = Xnew[c[j]][d],
+                     lo = min(xo,xn),
+                     hi = max(xo,xn);
+        if (j<a) {
+          lo0 = min(lo0,lo);
+          hi0 = max(hi0,hi);
+        } else {
+          lo1 = min(lo1,lo);
+          hi1 = max(hi1,hi);
+        }
+      }
+      disjoint |= (hi0<lo1) | (hi1<lo0);
+    }
+    results[i] = !disjoint;
+  }
+  Array<int> survivors;
+  for (int i=0;i<n;i++)
+    if (results[i])
+      survivors.append(i);
+  return survivors;
+}
+
+template<bool edge_edge> static void collision_parities(RawArray<bool> results, RawArray<const TV> Xold,
+                                                        RawArray<const TV> Xnew, RawArray<const Vector<int,4>> candidates) {
+  const auto survivors = swept_box_survivors<edge_edge?2:1>(results,Xold,Xnew,candidates).raw();
+  const int batches = (survivors.size()+collision_batch-1)/collision_batch;
+  std::exception_ptr error;
+  #pragma omp parallel for schedule(dynamic,1)
+  for (int b=0;b<batches;b++) {
+    try {
+      for (const int i : range(b*collision_batch,min((b+1)*collision_batch,survivors.size()))) {
+        const int s = survivors[i];
+        const auto& c = candidates[s];
+        RootParityCollisionTest test(Xold[c[0]],Xold[c[1]],Xold[c[2]],Xold[c[3]],
+                                     Xnew[c[0]],Xnew[c[1]],Xnew[c[2]],Xnew[c[3]],edge_edge);
+        results[s] = edge_edge ? test.edge_edge_collision() : test.point_triangle_collision();
+      }
+    } catch (...) {
+      #pragma omp critical
+      {
+        if (!error)
+          error = std::current_exception();
+      }
+    }
+  }
+  if (error)
+    std::rethrow_exception(error);
+}
+
+void edge_edge_collision_parity(RawArray<bool> results, RawArray<const TV> Xold, RawArray<const TV> Xnew,
+                                RawArray<const Vector<int,4>> candidates) {
+  collision_parities<true>(results,Xold,Xnew,candidates);
+}
+
+void point_triangle_collision_parity(RawArray<bool> results, RawArray<const TV> Xold, RawArray<const TV> Xnew,
+                                     RawArray<const Vector<int,4>> candidates) {
+  collision_parities<false>(results,Xold,Xnew,candidates);
+}
+
 bool edge_triangle_intersection(const Vector<double,3>& x0, const Vector<double,3>& x1, const Vector<double,3>& x2, const Vector<double,3>& x3, const Vector<double,3>& x4) {
   double a0,a1,a2,a3,a4;
 
@@ -2570,4 +2663,301 @@ bool triangle_triangle_intersection(const Vector<double,3>& a0, const Vector<dou
       || edge_triangle_intersection(b2,b0,a0,a1,a2);
 }
 
+// Exact test for faces sharing at most one vertex.  If a and b share a vertex v and are not coplanar, their intersection
+// is a segment starting at v whose other end lies on the edge opposite v in one of the faces.
+static bool faces_intersect(RawArray<const TV> X, const Vector<int,3> a, const Vector<int,3> b) {
+  for (int i=0;i<3;i++)
+    for (int j=0;j<3;j++)
+      if (a[i]==b[j])
+        return edge_triangle_intersection(X[a[(i+1)%3]],X[a[(i+2)%3]],X[b.x],X[b.y],X[b.z])
+            || edge_triangle_intersection(X[b[(j+1)%3]],X[b[(j+2)%3]],X[a.x],X[a.y],X[a.z]);
+  return triangle_triangle_intersection(X[a.x],X[a.y],X[a.z],X[b.x],X[b.y],X[b.z]);
+}
+
+// Bit i is set if face pairs[i].x lies strictly on one side of the plane of face pairs[i].y, ignoring shared vertices.
+// All n lanes are filtered at once with BatchInterval<n>.
+template<int n> static int separated_lanes(RawArray<const TV> X, RawArray<const Vector<int,3>> faces,
+                                           const Vector<int,2>* pairs) {
+  typedef Vector<BatchInterval<n>,3> BV;
+  BV a[3], b[3];
+  int shared[3] = {0,0,0};
+  for (int v=0;v<3;v++) {
+    for (int d=0;d<3;d++) {
+      double xa[n], xb[n];
+      for (int i=0;i<n;i++) {
+        xa[i] = X[faces[pairs[i].x][v]][d];
+        xb[i] = X[faces[pairs[i].y][v]][d];
+      }
+      a[v][d] = BatchInterval<n>(xa);
+      b[v][d] = BatchInterval<n>(xb);
+    }
+    for (int i=0;i<n;i++)
+      shared[v] |= faces[pairs[i].y].contains(faces[pairs[i].x][v])<<i;
+  }
+  const auto normal = cross(b[1]-b[0],b[2]-b[0]);
+  int above = (1<<n)-1,
+      below = above;
+  for (int v=0;v<3;v++) {
+    const auto s = dot(normal,a[v]-b[0]);
+    above &= s.positive_mask()|shared[v];
+    below &= s.negative_mask()|shared[v];
+  }
+  return above|below;
+}
+
+// Exactly test a batch of candidate pairs, setting hits[i] if pair i intersects.  Lanes culled by the interval
+// filter in either direction skip the exact test.  The exact tests need the default rounding mode, so only the
+// filter runs inside an IntervalScope.
+static void test_face_pairs(RawArray<bool> hits, RawArray<const TV> X, RawArray<const Vector<int,3>> faces,
+                            RawArray<const Vector<int,2>> pairs) {
+  const int n = batch_interval_width,
+            count = pairs.size(),
+            batched = count-count%n;
+  int i = 0;
+  for (;i<batched;i+=n) {
+    Vector<int,2> flipped[n];
+    for (int j=0;j<n;j++)
+      flipped[j] = pairs[i+j].reversed();
+    int culled;
+    {
+      IntervalScope scope;
+      culled = separated_lanes<n>(X,faces,pairs.data()+i)
+             | separated_lanes<n>(X,faces,flipped);
+    }
+    for (int j=0;j<n;j++)
+      hits[i+j] = !(culled>>j&1) && faces_intersect(X,faces[pairs[i+j].x],faces[pairs[i+j].y]);
+  }
+  for (;i<count;i++)
+    hits[i] = faces_intersect(X,faces[pairs[i].x],faces[pairs[i].y]);
+}
+
+Array<Vector<int,2>> intersecting_face_pairs(const TriangleSoup& mesh, Array<const TV> X) {
+  GEODE_ASSERT(mesh.nodes()<=X.size());
+  const auto faces = mesh.elements;
+
+  // Collect candidate pairs with overlapping boxes which share at most one vertex
+  const auto tree = new_<SimplexTree<TV,2>>(mesh,X,1);
+  struct Visitor {
+    const SimplexTree<TV,2>& tree;
+    const RawArray<const Vector<int,3>> faces;
+    Array<Vector<int,2>> pairs;
+
+    bool cull(const int n) const { return false; }
+    bool cull(const int n0, const int n1) const { return false; }
+    void leaf(const int n) const {}
+
+    void leaf(const int n0, const int n1) {
+      const int f0 = tree.prims(n0)[0],
+                f1 = tree.prims(n1)[0];
+      const auto &a = faces[f0],
+                 &b = faces[f1];
+      if (b.contains(a.x)+b.contains(a.y)+b.contains(a.z) < 2)
+        pairs.append(vec(min(f0,f1),max(f0,f1)));
+    }
+
+    void merge(const Visitor& other) {
+      pairs.extend(other.pairs);
+    }
+  } visitor({tree,faces});
+  parallel_double_traverse(*tree,visitor);
+  const auto pairs = visitor.pairs.raw();
+
+  // Filter and exactly test the candidates in parallel
+  Array<bool> hits(pairs.size(),uninit);
+  const auto hits_ = hits.raw();
+  const int batches = (pairs.size()+collision_batch-1)/collision_batch;
+  std::exception_ptr error;
+  #pragma omp parallel for schedule(dynamic,1)
+  for (int b=0;b<batches;b++) {
+    try {
+      const auto chunk = range(b*collision_batch,min((b+1)*collision_batch,pairs.size()));
+      test_face_pairs(hits_.slice(chunk),X,faces,pairs.slice(chunk));
+    } catch (...) {
+      #pragma omp critical
+      {
+        if (!error)
+          error = std::current_exception();
+      }
+    }
+  }
+  if (error)
+    std::rethrow_exception(error);
+
+  Array<Vector<int,2>> result;
+  for (const int i : range(pairs.size()))
+    if (hits[i])
+      result.append(pairs[i]);
+  sort(result,LexicographicCompare());
+  return result;
+}
+
+namespace {
+// Visit each pair of primitives in overlapping leaves of a self traversal exactly once
+template<class Pair> struct SweptPairVisitor {
+  const BoxTree<TV>& tree;
+  Pair pair;
+
+  bool cull(const int n) const { return false; }
+  bool cull(const int n0, const int n1) const { return false; }
+
+  void leaf(const int n) {
+    const auto prims = tree.prims(n);
+    for (const int i : range(prims.size()))
+      for (const int j : range(i+1,prims.size()))
+        pair(prims[i],prims[j]);
+  }
+
+  void leaf(const int n0, const int n1) {
+    for (const int a : tree.prims(n0))
+      for (const int b : tree.prims(n1))
+        pair(a,b);
+  }
+
+  void merge(const SweptPairVisitor& other) {
+    pair.candidates.extend(other.pair.candidates);
+  }
+};
+
+struct EdgeEdgePair {
+  RawArray<const Vector<int,2>> edges;
+  Array<Vector<int,4>> candidates;
+
+  void operator()(const int e0, const int e1) {
+    const auto &a = edges[e0],
+               &b = edges[e1];
+    if (!b.contains(a.x) && !b.contains(a.y))
+      candidates.append(vec(a.x,a.y,b.x,b.y));
+  }
+};
+
+struct PointTrianglePair {
+  RawArray<const Vector<int,3>> faces;
+  Array<Vector<int,4>> candidates;
+
+  void operator()(const int f0, const int f1) {
+    const auto &a = faces[f0],
+               &b = faces[f1];
+    for (const int p : a)
+      if (!b.contains(p))
+        candidates.append(vec(p,b.x,b.y,b.z));
+    for (const int p : b)
+      if (!a.contains(p))
+        candidates.append(vec(p,a.x,a.y,a.z));
+  }
+};
+}
+
+Tuple<Array<Vector<int,4>>,Array<Vector<int,4>>>
+swept_collision_candidates(const SimplexTree<TV,1>& edges, const SimplexTree<TV,2>& faces) {
+  SweptPairVisitor<EdgeEdgePair> edge_visitor({edges,{edges.mesh->elements}});
+  parallel_double_traverse(edges,edge_visitor);
+
+  // A vertex belongs to many faces, so the same point-triangle pair can come from several face pairs
+  SweptPairVisitor<PointTrianglePair> face_visitor({faces,{faces.mesh->elements}});
+  parallel_double_traverse(faces,face_visitor);
+  auto& point_triangle = face_visitor.pair.candidates;
+  sort(point_triangle,LexicographicCompare());
+  point_triangle.resize(int(std::unique(point_triangle.begin(),point_triangle.end())-point_triangle.begin()));
+  return tuple(edge_visitor.pair.candidates,point_triangle);
+}
+
+// Compare batched collision tests against scalar versions.  Vertices live on a coarse grid and move a few
+// cells at a time, so that both culled and colliding candidates are common.
+static void collision_tests() {
+  const auto random = new_<Random>(8731);
+  const int nx = 40, n = 2000;
+  Array<TV> Xold(nx), Xnew(nx);
+  for (const int i : range(nx)) {
+    Xold[i] = TV(random->uniform<Vector<int,3>>(0,6));
+    Xnew[i] = Xold[i]+TV(random->uniform<Vector<int,3>>(-2,3));
+  }
+  Array<Vector<int,4>> candidates(n);
+  for (auto& c : candidates)
+    c = random->uniform<Vector<int,4>>(0,nx);
+  Array<bool> results(n);
+  int hits = 0;
+  edge_edge_collision_parity(results,Xold,Xnew,candidates);
+  for (const int i : range(n)) {
+    const auto& c = candidates[i];
+    GEODE_ASSERT(results[i]==edge_edge_collision_parity(Xold[c[0]],Xold[c[1]],Xold[c[2]],Xold[c[3]],
+                                                        Xnew[c[0]],Xnew[c[1]],Xnew[c[2]],Xnew[c[3]]));
+    hits += results[i];
+  }
+  point_triangle_collision_parity(results,Xold,Xnew,candidates);
+  for (const int i : range(n)) {
+    const auto& c = candidates[i];
+    GEODE_ASSERT(results[i]==point_triangle_collision_parity(Xold[c[0]],Xold[c[1]],Xold[c[2]],Xold[c[3]],
+                                                             Xnew[c[0]],Xnew[c[1]],Xnew[c[2]],Xnew[c[3]]));
+    hits += results[i];
+  }
+  const int culled = n-swept_box_survivors<2>(results,Xold,Xnew,candidates).size();
+  GEODE_ASSERT(culled>0 && hits>0);
+
+  // Compare intersecting_face_pairs against brute force on a random soup, including faces sharing vertices
+  Array<Vector<int,3>> faces;
+  while (faces.size()<300) {
+    const auto f = random->uniform<Vector<int,3>>(0,nx);
+    if (f.x!=f.y && f.y!=f.z && f.z!=f.x)
+      faces.append(f);
+  }
+  const auto mesh = new_<TriangleSoup>(faces,nx);
+  Array<Vector<int,2>> slow;
+  for (const int f0 : range(faces.size()))
+    for (const int f1 : range(f0+1,faces.size())) {
+      const auto &a = faces[f0],
+                 &b = faces[f1];
+      if (b.contains(a.x)+b.contains(a.y)+b.contains(a.z)<2 && faces_intersect(Xnew,a,b))
+        slow.append(vec(f0,f1));
+    }
+  GEODE_ASSERT(slow.size() && intersecting_face_pairs(mesh,Xnew)==slow);
+
+  // Swept candidates should find every collision between the soup's edges and faces as the vertices move
+  const auto segments = mesh->segment_soup();
+  const auto edge_tree = new_<SimplexTree<TV,1>>(*segments,Xold,4);
+  const auto face_tree = new_<SimplexTree<TV,2>>(*mesh,Xold,4);
+  edge_tree->update_swept(Xnew);
+  face_tree->update_swept(Xnew);
+  const auto swept = swept_collision_candidates(edge_tree,face_tree);
+
+  // Put the smaller edge of each edge-edge candidate first, so that candidates can be compared
+  const auto normalized = [](RawArray<const Vector<int,4>> candidates, const bool edge_edge) {
+    auto result = candidates.copy();
+    if (edge_edge)
+      for (auto& c : result)
+        if (lex_less(vec(c[2],c[3]),vec(c[0],c[1])))
+          c = vec(c[2],c[3],c[0],c[1]);
+    sort(result,LexicographicCompare());
+    return result;
+  };
+  Array<Vector<int,4>> all_edge_edge, all_point_triangle;
+  const auto edges = segments->elements;
+  for (const int e0 : range(edges.size()))
+    for (const int e1 : range(e0+1,edges.size()))
+      if (!edges[e1].contains(edges[e0].x) && !edges[e1].contains(edges[e0].y))
+        all_edge_edge.append(vec(edges[e0].x,edges[e0].y,edges[e1].x,edges[e1].y));
+  for (const int p : range(nx))
+    for (const auto& f : faces)
+      if (!f.contains(p))
+        all_point_triangle.append(vec(p,f.x,f.y,f.z));
+  for (const bool edge_edge : {true,false}) {
+    const auto all = normalized(edge_edge ? all_edge_edge : all_point_triangle,edge_edge),
+               found = normalized(edge_edge ? swept.x : swept.y,edge_edge);
+    GEODE_ASSERT(found.size()==int(std::unique(found.begin(),found.end())-found.begin()));
+    Array<bool> results(all.size(),uninit);
+    (edge_edge ? collision_parities<true> : collision_parities<false>)(results,Xold,Xnew,all);
+    int hits = 0;
+    for (const int i : range(all.size()))
+      if (results[i]) {
+        hits++;
+        GEODE_ASSERT(std::binary_search(found.begin(),found.end(),all[i],LexicographicCompare()));
+      }
+    GEODE_ASSERT(hits>0);
+  }
+}
+
+}
+using namespace geode;
+
+void wrap_collision() {
+  GEODE_FUNCTION(collision_tests)
 }
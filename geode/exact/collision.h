@@ -6,6 +6,10 @@
 #pragma once
 
 #include <geode/utility/config.h>
+#include <geode/array/Array.h>
+#include <geode/geometry/forward.h>
+#include <geode/mesh/forward.h>
+#include <geode/structure/Tuple.h>
 #include <geode/vector/Vector.h>
 namespace geode {
 
@@ -17,6 +21,23 @@ GEODE_CORE_EXPORT bool edge_edge_collision_parity(const Vector<double,3>& x0old,
 GEODE_CORE_EXPORT bool point_triangle_collision_parity(const Vector<double,3>& x0old, const Vector<double,3>& x1old, const Vector<double,3>& x2old, const Vector<double,3>& x3old,
                                                        const Vector<double,3>& x0new, const Vector<double,3>& x1new, const Vector<double,3>& x2new, const Vector<double,3>& x3new);
  
+// Batched versions of the above: results[i] is the parity for the vertices candidates[i] of the meshes with positions
+// Xold and Xnew.  Edge-edge candidates are (e0,e1,f0,f1), and point-triangle candidates are (p,t0,t1,t2).  Candidates
+// whose swept bounding boxes are disjoint are culled with a cheap vectorizable filter, and the survivors run the exact
+// tests above in parallel.  These are intended for the millions of candidate pairs produced by a broad phase.
+GEODE_CORE_EXPORT void edge_edge_collision_parity(RawArray<bool> results, RawArray<const Vector<double,3>> Xold,
+                                                  RawArray<const Vector<double,3>> Xnew, RawArray<const Vector<int,4>> candidates);
+GEODE_CORE_EXPORT void point_triangle_collision_parity(RawArray<bool> results, RawArray<const Vector<double,3>> Xold,
+                                                       RawArray<const Vector<double,3>> Xnew, RawArray<const Vector<int,4>> candidates);
+
+// Broad phase for the batched tests above: self collision candidates (edge-edge, point-triangle) among the edges and
+// faces of a moving mesh, in the same vertex order.  Both trees must have been refit with update_swept since their X
+// last changed, so that their boxes bound the motion.  Edges sharing a vertex and points in their own triangle are
+// skipped, and point-triangle candidates are sorted and unique.  For substepping, keep the trees and refit them each
+// substep rather than building new ones.
+GEODE_CORE_EXPORT Tuple<Array<Vector<int,4>>,Array<Vector<int,4>>>
+swept_collision_candidates(const SimplexTree<Vector<double,3>,1>& edges, const SimplexTree<Vector<double,3>,2>& faces);
+
 // True if edge x01 intersects triangle x234
 GEODE_CORE_EXPORT bool edge_triangle_intersection(const Vector<double,3>& x0, const Vector<double,3>& x1, const Vector<double,3>& x2, const Vector<double,3>& x3, const Vector<double,3>& x4);
 
@@ -24,4 +45,10 @@ GEODE_CORE_EXPORT bool edge_triangle_intersection(const Vector<double,3>& x0, co
 GEODE_CORE_EXPORT bool triangle_triangle_intersection(const Vector<double,3>& a0, const Vector<double,3>& a1, const Vector<double,3>& a2,
                                                       const Vector<double,3>& b0, const Vector<double,3>& b1, const Vector<double,3>& b2);
 
+// All pairs of faces (f0,f1) with f0<f1 which intersect, sorted lexicographically.  Faces sharing an edge are ignored,
+// and faces sharing a vertex are reported only if they intersect away from that vertex.  Candidates are found with a
+// parallel SimplexTree self traversal, culled with a batched interval separating plane filter, and the survivors are
+// tested exactly using edge_triangle_intersection.  This is intended for validating large meshes.
+GEODE_CORE_EXPORT Array<Vector<int,2>> intersecting_face_pairs(const TriangleSoup& mesh, Array<const Vector<double,3>> X);
+
 }
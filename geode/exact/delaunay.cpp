@@ -6,7 +6,9 @@
 #include <geode/exact/scope.h>
 #include <geode/array/amap.h>
 #include <geode/array/RawField.h>
+#include <geode/math/constants.h>
 #include <geode/math/integer_log.h>
+#include <geode/python/Class.h>
 #include <geode/python/wrap.h>
 #include <geode/random/permute.h>
 #include <geode/random/Random.h>
@@ -14,10 +16,17 @@
 #include <geode/utility/curry.h>
 #include <geode/utility/interrupts.h>
 #include <geode/utility/Log.h>
+#include <geode/utility/openmp.h>
+#include <geode/utility/parallel.h>
+#include <algorithm>
+#include <exception>
+#include <queue>
+#include <vector>
 namespace geode {
 
 using Log::cout;
 using std::endl;
+using std::vector;
 typedef Vector<real,2> TV;
 typedef Vector<Quantized,2> EV;
 using exact::Perturbed2;
@@ -26,6 +35,9 @@ const auto bound = exact::bound;
 // Whether to run extremely expensive diagnostics
 static const bool self_check = false;
 
+// Minimum number of points per piece for parallel triangulation
+static const int parallel_piece_size = 1<<14;
+
 // For interface simplicity, we use a single fixed random number as the seed.
 // This is safe unless the points are chosen maliciously (and then it's still
 // quite hard since threefry is fairly strong for a noncryptographic PRNG).
@@ -611,37 +623,78 @@ static void cavity_delaunay(MutableTriangleTopology& parent_mesh, RawField<const
   }
 }
 
+// Check if an edge exists in the triangulation.  To ensure optimal complexity, we loop
+// around both vertices interleaved so that our time is O(min(degree(v0),degree(v1))).
+static inline bool has_edge(const TriangleTopology& mesh, const VertexId v0, const VertexId v1) {
+  const auto s0 = mesh.halfedge(v0),
+             s1 = mesh.halfedge(v1);
+  auto e0 = s0,
+       e1 = s1;
+  do {
+    if (mesh.dst(e0)==v1 || mesh.dst(e1)==v0)
+      return true;
+    e0 = mesh.left(e0);
+    e1 = mesh.left(e1);
+  } while (e0!=s0 && e1!=s1);
+  return false;
+}
+
+template<class Point> static Array<Perturbed2> partially_sorted_shuffle(const int n, const Point& point, const int sentinel_seed);
+
 GEODE_NEVER_INLINE static void add_constraint_edges(MutableTriangleTopology& mesh, RawField<const EV,VertexId> X,
-                                                    RawArray<const Vector<int,2>> edges, const bool validate) {
+                                                    RawArray<const Vector<int,2>> edges, const bool validate,
+                                                    const bool bulk) {
   if (!edges.size())
     return;
   IntervalScope scope;
+
+  // Most constraints are usually already present in the unconstrained triangulation.  Mark all of these in one pass
+  // before inserting anything, so that only missing edges pay for walks and retriangulation.  Any missing edge crossing
+  // them will find them constrained and throw DelaunayConstraintConflict.  The pass visits edges in BRIO order of their
+  // midpoints, which keeps mesh accesses coherent even when there are millions of constraints.
+  const auto order = partially_sorted_shuffle(edges.size(),[&](const int i) {
+    const auto e = edges[i];
+    GEODE_ASSERT(mesh.valid(VertexId(e.x)) && mesh.valid(VertexId(e.y)));
+    return Perturbed2(i,floor((X[VertexId(e.x)]+X[VertexId(e.y)])/2));
+  },0);
   Hashtable<Vector<VertexId,2>> constrained;
+  Array<bool> present(edges.size());
+  for (const auto& o : order.slice(0,edges.size())) {
+    const auto edge = edges[o.seed()].sorted();
+    const auto vs = vec(VertexId(edge.x),VertexId(edge.y));
+    if (has_edge(mesh,vs.x,vs.y)) {
+      constrained.set(vs);
+      present[o.seed()] = true;
+    }
+  }
+
+  // Choose an order for the missing edges.  A random order ensures optimal time complexity.  In bulk mode we
+  // reuse the BRIO order, which is still random at coarse scales, so that walks and cavities stay in cache.
+  Array<int> missing;
+  if (bulk) {
+    for (const auto& o : order.slice(0,edges.size()))
+      if (!present[o.seed()])
+        missing.append(o.seed());
+  } else {
+    for_each_permuted(edges.size(),key+5,edges.size(),[&](const int i, const int j) {
+      if (!present[j])
+        missing.append(j);
+    });
+  }
+
   Array<VertexId> left_cavity, right_cavity; // List of vertices for both cavities
   const auto random = new_<Random>(key+7);
-  for (int i=0;i<edges.size();i++) {
-    // Randomly choose an edge to ensure optimal time complexity
-    const auto edge = edges[int(random_permute(edges.size(),key+5,i))].sorted();
+  for (const int j : missing) {
+    const auto edge = edges[j].sorted();
     auto v0 = VertexId(edge.x),
          v1 = VertexId(edge.y);
     const auto vs = vec(v0,v1);
-    GEODE_ASSERT(mesh.valid(v0) && mesh.valid(v1));
-
     {
-      // Check if the edge already exists in the triangulation.  To ensure optimal complexity,
-      // we loop around both vertices interleaved so that our time is O(min(degree(v0),degree(v1))).
+      // Check if an earlier insertion has already created the edge
+      if (has_edge(mesh,v0,v1))
+        goto success;
       const auto s0 = mesh.halfedge(v0),
                  s1 = mesh.halfedge(v1);
-      {
-        auto e0 = s0,
-             e1 = s1;
-        do {
-          if (mesh.dst(e0)==v1 || mesh.dst(e1)==v0)
-            goto success; // The edge already exists, so there's nothing to be done.
-          e0 = mesh.left(e0);
-          e1 = mesh.left(e1);
-        } while (e0!=s0 && e1!=s1);
-      }
 
       // Find a triangle touching v0 or v1 containing part of the v0-v1 segment.
       // As above, we loop around both vertices interleaved.
@@ -750,83 +803,807 @@ template<int axis> static inline int spatial_partition(RawArray<Perturbed2> X, R
   return mid;
 }
 
-static void spatial_sort(RawArray<Perturbed2> X, const int leaf_size, Random& random) {
-  const int n = X.size();
-  if (n<=leaf_size)
-    return;
-
+// Split X along the longer axis of its bounding box, returning the split index
+static int spatial_halve(RawArray<Perturbed2> X, Random& random) {
   // We determine the subdivision axis using inexact computation, which is okay since neither the result nor
   // the asymptotic worst case complexity depends upon any properties of the spatial_sort whatsoever.
   const Box<EV> box = bounding_box(X.project<EV,&Perturbed2::value_>());
   const int axis = box.sizes().argmax();
 
   // We use exact arithmetic to perform the partition, which is important in case many points are coincident
-  const int mid = axis==0 ? spatial_partition<0>(X,random)
-                          : spatial_partition<1>(X,random);
+  return axis==0 ? spatial_partition<0>(X,random)
+                 : spatial_partition<1>(X,random);
+}
+
+static void spatial_sort(RawArray<Perturbed2> X, const int leaf_size, Random& random) {
+  const int n = X.size();
+  if (n<=leaf_size)
+    return;
+  const int mid = spatial_halve(X,random);
 
   // Recursely sort both halves
   spatial_sort(X.slice(0,mid),leaf_size,random);
   spatial_sort(X.slice(mid,n),leaf_size,random);
 }
 
+// Largest subarray spatially sorted by a single task
+static const int spatial_piece_size = 1<<14;
+
+// Run the top levels of spatial_sort, appending subarrays of at most spatial_piece_size points to pieces, each paired
+// with a substream of random with which to finish sorting it.  Pieces can then be sorted in parallel.
+static void spatial_split(RawArray<Perturbed2> X, const int leaf_size, Random& random,
+                          vector<Tuple<RawArray<Perturbed2>,Ref<Random>>>& pieces) {
+  const int n = X.size();
+  if (n<=max(leaf_size,spatial_piece_size)) {
+    pieces.push_back(tuple(X,random.substream(pieces.size())));
+    return;
+  }
+  const int mid = spatial_halve(X,random);
+  spatial_split(X.slice(0,mid),leaf_size,random,pieces);
+  spatial_split(X.slice(mid,n),leaf_size,random,pieces);
+}
+
 // Prepare a list of points for Delaunay triangulation: randomly assign into logarithmic bins, sort within bins, and add sentinels.
-// For details, see Amenta et al., Incremental Constructions con BRIO.
-static Array<Perturbed2> partially_sorted_shuffle(RawArray<const EV> Xin) {
-  const int n = Xin.size();
+// For details, see Amenta et al., Incremental Constructions con BRIO.  point(i) returns the ith input point together with its
+// perturbation seed, and the sentinels are given seeds sentinel_seed+{0,1,2}.
+template<class Point> static Array<Perturbed2> partially_sorted_shuffle(const int n, const Point& point, const int sentinel_seed) {
   Array<Perturbed2> X(n+3,uninit);
 
   // Randomly assign input points into bins.  Bin k has 2**k = 1,2,4,8,... and starts at index 2**k-1 = 0,1,3,7,...
   // We fill points into bins as sequentially as possible to maximize cache coherence.
-  const int bins = integer_log(n);
+  const int bins = max(1,integer_log(n));
   Array<int> bin_counts(bins);
-  for (int i=0;i<n;i++) {
-    int j = (int)random_permute(n,key,i);
+  for_each_permuted(n,key,n,[&](const int i, int j) {
     const int bin = min(integer_log(j+1),bins-1);
     j = (1<<bin)-1+bin_counts[bin]++;
-    X[j] = Perturbed2(i,Xin[i]);
-  }
+    X[j] = point(i);
+  });
 
-  // Spatially sort each bin down to clusters of size 64.
+  // Spatially sort each bin down to clusters of size 64.  The top levels of each bin are split serially, and the
+  // resulting pieces sorted in parallel, each with its own substream.  The split doesn't depend on the number of
+  // threads, so neither does the order.
   const int leaf_size = 64;
+  vector<Tuple<RawArray<Perturbed2>,Ref<Random>>> pieces;
   for (int bin=0;bin<bins;bin++) {
     const int start = (1<<bin)-1,
               end = bin==bins-1?n:start+(1<<bin);
     assert(bin_counts[bin]==end-start);
-    spatial_sort(X.slice(start,end),leaf_size,new_<Random>(key+bin));
+    spatial_split(X.slice(start,end),leaf_size,new_<Random>(key+bin),pieces);
   }
+  parallel_for(int(pieces.size()),[&](const int p) {
+    spatial_sort(pieces[p].x,leaf_size,pieces[p].y);
+  });
 
   // Add 3 sentinel points at infinity
-  X[n+0] = Perturbed2(n+0,EV(-bound,-bound));
-  X[n+1] = Perturbed2(n+1,EV( bound, 0)    );
-  X[n+2] = Perturbed2(n+2,EV(-bound, bound));
+  X[n+0] = Perturbed2(sentinel_seed+0,EV(-bound,-bound));
+  X[n+1] = Perturbed2(sentinel_seed+1,EV( bound, 0)    );
+  X[n+2] = Perturbed2(sentinel_seed+2,EV(-bound, bound));
 
   return X;
 }
 
+// Under simulation of simplicity the Delaunay triangulation is unique, so it can be assembled from independently computed
+// pieces.  We recursively split the points at exact medians into pieces, each lying in an open box bounded by splitting
+// lines which no other piece's points can enter, and triangulate the pieces concurrently.  A piece triangle whose
+// circumcircle lies safely inside its box is Delaunay for the whole point set; we call these final.  Every other triangle
+// of the full triangulation has only seam vertices: piece hull vertices and vertices of nonfinal triangles.  (A piece
+// interior vertex whose triangles are all final has its entire star final.)  Thus we triangulate the seam vertices
+// serially and keep the triangles outside the final region, found by flood filling across edges not shared with final
+// triangles.  The result is the same triangulation as the serial algorithm, but faces may be ordered differently.
+
+namespace {
+struct DelaunayPiece {
+  RawArray<Perturbed2> X; // Points with seeds equal to input indices
+  Box<EV> box; // Open region containing the piece, which other pieces' points cannot enter
+};
+}
+
+static void delaunay_pieces(vector<DelaunayPiece>& pieces, RawArray<Perturbed2> X, const Box<EV>& box, const int count) {
+  if (count<=1) {
+    pieces.push_back(DelaunayPiece({X,box}));
+    return;
+  }
+
+  // Split at the exact median along the longest axis, which can be chosen inexactly
+  const int axis = bounding_box(X.project<EV,&Perturbed2::value_>()).sizes().argmax();
+  const int mid = X.size()/2;
+  if (axis==0) std::nth_element(X.begin(),X.begin()+mid,X.end(),[](const Perturbed2& a, const Perturbed2& b) { return axis_less<0>(a,b); });
+  else         std::nth_element(X.begin(),X.begin()+mid,X.end(),[](const Perturbed2& a, const Perturbed2& b) { return axis_less<1>(a,b); });
+  auto lo = box, hi = box;
+  lo.max[axis] = hi.min[axis] = X[mid].value()[axis];
+  delaunay_pieces(pieces,X.slice(0,mid),lo,count/2);
+  delaunay_pieces(pieces,X.slice(mid,X.size()),hi,count-count/2);
+}
+
+// Conservatively compute the circumcircle of a triangle, with the radius padded to absorb roundoff error.  This is
+// inexact, so we reject nearly degenerate triangles outright and use generous error margins.
+static bool safe_circumcircle(const EV x0, const EV x1, const EV x2, EV& center, double& radius) {
+  const auto a = x1-x0,
+             b = x2-x0;
+  const double D = 2*(a.x*b.y-a.y*b.x),
+               la = sqr_magnitude(a),
+               lb = sqr_magnitude(b);
+  if (!(abs(D) > 1e-4*sqrt(la*lb)))
+    return false;
+  const auto u = EV(b.y*la-a.y*lb,a.x*lb-b.x*la)/D;
+  center = x0+u;
+  const double r = magnitude(u);
+  radius = r+1e-6*(r+sqrt(la)+sqrt(lb))+1e-12*x0.maxabs()+4;
+  return true;
+}
+
+// Is the circumcircle of a triangle safely inside an open box?  False negatives only cost efficiency.
+static bool circumcircle_inside(const EV x0, const EV x1, const EV x2, const Box<EV>& box) {
+  EV c;
+  double r;
+  if (!safe_circumcircle(x0,x1,x2,c,r))
+    return false;
+  for (int i=0;i<2;i++)
+    if (!(box.min[i] < c[i]-r && c[i]+r < box.max[i]))
+      return false;
+  return true;
+}
+
+// Triangulate one piece, collecting its final triangles in input indices and marking its seam vertices
+static void delaunay_piece(const DelaunayPiece& piece, const int sentinel_seed,
+                           Array<Vector<int,3>>& final, RawArray<bool> seam) {
+  const Field<const Perturbed2,VertexId> X(partially_sorted_shuffle(piece.X.size(),
+    [&](const int i) { return piece.X[i]; },sentinel_seed));
+  const auto mesh = deterministic_exact_delaunay(X,false);
+  for (const auto e : mesh->boundary_edges())
+    seam[X[mesh->src(e)].seed()] = true;
+  for (const auto f : mesh->faces()) {
+    const auto v = mesh->vertices(f);
+    const auto x0 = X[v.x],
+               x1 = X[v.y],
+               x2 = X[v.z];
+    if (circumcircle_inside(x0.value(),x1.value(),x2.value(),piece.box))
+      final.append(vec(x0.seed(),x1.seed(),x2.seed()));
+    else
+      seam[x0.seed()] = seam[x1.seed()] = seam[x2.seed()] = true;
+  }
+}
+
+GEODE_NEVER_INLINE static Ref<MutableTriangleTopology> parallel_exact_delaunay(RawArray<const EV> Xin, const int count) {
+  const int n = Xin.size();
+  Array<Perturbed2> X(n,uninit);
+  for (int i=0;i<n;i++)
+    X[i] = Perturbed2(i,Xin[i]);
+
+  // Split into pieces and triangulate them in parallel
+  vector<DelaunayPiece> pieces;
+  delaunay_pieces(pieces,X,Box<EV>::full_box(),count);
+  vector<Array<Vector<int,3>>> finals(pieces.size());
+  Array<bool> seam(n);
+  std::exception_ptr error;
+  #pragma omp parallel for schedule(dynamic,1)
+  for (int p=0;p<int(pieces.size());p++) {
+    try {
+      delaunay_piece(pieces[p],n,finals[p],seam);
+    } catch (...) {
+      #pragma omp critical
+      {
+        if (!error)
+          error = std::current_exception();
+      }
+    }
+  }
+  if (error)
+    std::rethrow_exception(error);
+
+  // Triangulate the seam vertices
+  Array<int> seam_to_input;
+  for (int i=0;i<n;i++)
+    if (seam[i])
+      seam_to_input.append(i);
+  const int ns = seam_to_input.size();
+  const Field<const Perturbed2,VertexId> S(partially_sorted_shuffle(ns,
+    [&](const int i) { return Perturbed2(seam_to_input[i],Xin[seam_to_input[i]]); },n));
+  const auto seam_mesh = deterministic_exact_delaunay(S,false);
+  const auto input = [&](const VertexId v) { return S[v].seed(); };
+
+  // Walls are seam triangulation edges shared with final triangles.  Record the directed final halfedges between seam vertices.
+  Hashtable<Vector<int,2>> final_halfedges;
+  for (const auto& final : finals)
+    for (const auto& f : final)
+      for (int a=0;a<3;a++) {
+        const int i = f[a], j = f[(a+1)%3];
+        if (seam[i] && seam[j])
+          final_halfedges.set(vec(i,j));
+      }
+  const auto wall = [&](const HalfedgeId e) {
+    const int i = input(seam_mesh->src(e)),
+              j = input(seam_mesh->dst(e));
+    return final_halfedges.contains(vec(i,j)) || final_halfedges.contains(vec(j,i));
+  };
+
+  // Flood fill components of the seam triangulation separated by walls.  The side of a wall facing a component is
+  // final if and only if a final triangle lies on that side, and components without walls are outside the final region.
+  Field<int,FaceId> component(seam_mesh->allocated_faces());
+  component.flat.fill(-1);
+  Array<bool> keep;
+  Array<FaceId> stack;
+  for (const auto f : seam_mesh->faces())
+    if (component[f]<0) {
+      const int c = keep.append(true);
+      bool classified = false;
+      component[f] = c;
+      stack.append(f);
+      while (stack.size()) {
+        const auto g = stack.pop();
+        for (const auto e : seam_mesh->halfedges(g)) {
+          if (wall(e)) {
+            if (!classified) {
+              keep[c] = !final_halfedges.contains(vec(input(seam_mesh->src(e)),input(seam_mesh->dst(e))));
+              classified = true;
+            }
+          } else {
+            const auto h = seam_mesh->face(seam_mesh->reverse(e));
+            if (h.valid() && component[h]<0) {
+              component[h] = c;
+              stack.append(h);
+            }
+          }
+        }
+      }
+    }
+
+  // Assemble final triangles and kept seam triangles
+  Array<Vector<int,3>> tris;
+  for (const auto& final : finals)
+    tris.extend(final);
+  for (const auto f : seam_mesh->faces())
+    if (keep[component[f]]) {
+      const auto v = seam_mesh->vertices(f);
+      tris.append(vec(input(v.x),input(v.y),input(v.z)));
+    }
+  return new_<MutableTriangleTopology>(tris,n);
+}
+
 Ref<TriangleTopology> exact_delaunay_points(RawArray<const EV> X, RawArray<const Vector<int,2>> edges,
-                                            const bool validate) {
+                                            const bool validate, const bool parallel,
+                                            const bool bulk_constraints) {
   const int n = X.size();
   GEODE_ASSERT(n>=3);
 
-  // Quantize all input points, reorder, and add sentinels
-  Field<const Perturbed2,VertexId> Xp(partially_sorted_shuffle(X));
+  // Triangulate in parallel if desired and worthwhile
+  const int pieces = parallel ? min(4*omp_get_max_threads(),n/parallel_piece_size) : 1;
+  Ptr<MutableTriangleTopology> mesh;
+  if (pieces>1) {
+    mesh = parallel_exact_delaunay(X,pieces);
+    if (validate)
+      assert_delaunay("parallel delaunay validate: ",*mesh,RawField<const EV,VertexId>(X));
+  } else {
+    // Quantize all input points, reorder, and add sentinels
+    Field<const Perturbed2,VertexId> Xp(partially_sorted_shuffle(n,[=](const int i) { return Perturbed2(i,X[i]); },n));
 
-  // Compute Delaunay triangulation
-  const auto mesh = deterministic_exact_delaunay(Xp,validate);
+    // Compute Delaunay triangulation
+    mesh = deterministic_exact_delaunay(Xp,validate);
 
-  // Undo the vertex permutation
-  mesh->permute_vertices(Xp.flat.slice(0,n).project<int,&Perturbed2::seed_>().copy());
+    // Undo the vertex permutation
+    mesh->permute_vertices(Xp.flat.slice(0,n).project<int,&Perturbed2::seed_>().copy());
+  }
 
   // Insert constraint edges in random order
-  add_constraint_edges(mesh,RawField<const EV,VertexId>(X),edges,validate);
+  add_constraint_edges(*mesh,RawField<const EV,VertexId>(X),edges,validate,bulk_constraints);
 
   // All done!
-  return mesh;
+  return ref(*mesh);
 }
 
 Ref<TriangleTopology> delaunay_points(RawArray<const Vector<real,2>> X, RawArray<const Vector<int,2>> edges,
-                                      const bool validate) {
-  return exact_delaunay_points(amap(quantizer(bounding_box(X)),X).copy(),edges,validate);
+                                      const bool validate, const bool parallel, const bool bulk_constraints) {
+  return exact_delaunay_points(amap(quantizer(bounding_box(X)),X).copy(),edges,validate,parallel,bulk_constraints);
+}
+
+// Streaming construction reuses the seam logic of parallel construction.  At each finalization, the active points are
+// triangulated from scratch.  Triangles already returned form a region bounded by walls, which are edges of the active
+// triangulation since they are Delaunay for all points.  Flood filling across non-wall edges finds the live triangles
+// outside this region, and those whose circumcircles miss all unfinalized cells are final: no past or future point can
+// lie inside them.  An active point interior to the active triangulation whose triangles are all returned has its entire
+// final star returned, so it is forgotten.  Hull points are kept until the end since their stars may still grow.
+
+GEODE_DEFINE_TYPE(StreamingDelaunay)
+
+// Sentinel seeds must be distinct from the ids of all points, so we take them from the top of the range
+static const int streaming_sentinel_seed = numeric_limits<int>::max()-2;
+
+StreamingDelaunay::StreamingDelaunay(const Box<TV>& box, const Vector<int,2> cells)
+  : box(box)
+  , cells(cells)
+  , quant(box)
+  , grid(quant(box.min),quant(box.max))
+  , finalized(cells.product())
+  , unfinalized(cells.product())
+  , points(0) {
+  GEODE_ASSERT(cells.min()>0);
+}
+
+StreamingDelaunay::~StreamingDelaunay() {}
+
+static inline Vector<int,2> quantized_cell(const Box<Vector<Quantized,2>>& grid, const Vector<int,2> cells, const EV x) {
+  const auto sizes = grid.sizes();
+  Vector<int,2> c;
+  for (int i=0;i<2;i++)
+    c[i] = clamp(int(floor((x[i]-grid.min[i])/max(sizes[i],Quantized(1))*cells[i])),0,cells[i]-1);
+  return c;
+}
+
+Vector<int,2> StreamingDelaunay::cell(const TV x) const {
+  return quantized_cell(grid,cells,quant(x));
+}
+
+void StreamingDelaunay::add_points(RawArray<const TV> Xn) {
+  if (points > numeric_limits<int>::max()-3-Xn.size())
+    throw OverflowError(format("StreamingDelaunay::add_points: more than %d points",numeric_limits<int>::max()-3));
+  for (const int i : range(Xn.size())) {
+    if (!box.lazy_inside(Xn[i]))
+      throw ValueError(format("StreamingDelaunay::add_points: point %d lies outside the declared box",points+i));
+    const auto c = cell(Xn[i]);
+    if (finalized[c.x*cells.y+c.y])
+      throw ValueError(format("StreamingDelaunay::add_points: point %d lies in finalized cell (%d,%d)",
+                              points+i,c.x,c.y));
+  }
+  for (const int i : range(Xn.size())) {
+    ids.append(points+i);
+    X.append(quant(Xn[i]));
+  }
+  points += Xn.size();
+}
+
+bool StreamingDelaunay::circle_finalized(const EV x0, const EV x1, const EV x2) const {
+  if (!unfinalized)
+    return true;
+  EV c;
+  double r;
+  if (!safe_circumcircle(x0,x1,x2,c,r))
+    return false;
+
+  // Check all cells overlapping the bounding box of the circle
+  const auto sizes = grid.sizes();
+  Vector<int,2> lo, hi;
+  for (int i=0;i<2;i++) {
+    const double scale = cells[i]/max(sizes[i],Quantized(1)),
+                 a = floor((c[i]-r-grid.min[i])*scale),
+                 b = floor((c[i]+r-grid.min[i])*scale);
+    if (!(a < cells[i] && b >= 0))
+      return true;
+    lo[i] = int(max(a,0.));
+    hi[i] = int(min(b,cells[i]-1.));
+  }
+  for (int i=lo.x;i<=hi.x;i++)
+    for (int j=lo.y;j<=hi.y;j++)
+      if (!finalized[i*cells.y+j])
+        return false;
+  return true;
+}
+
+Array<Vector<int,3>> StreamingDelaunay::finalize_cells(RawArray<const Vector<int,2>> cs) {
+  for (const auto c : cs) {
+    GEODE_ASSERT(c.min()>=0 && c.x<cells.x && c.y<cells.y);
+    auto& f = finalized[c.x*cells.y+c.y];
+    unfinalized -= !f;
+    f = true;
+  }
+  return advance();
+}
+
+Array<Vector<int,3>> StreamingDelaunay::finish() {
+  finalized.fill(true);
+  unfinalized = 0;
+  const auto tris = advance();
+  ids.clean_memory();
+  X.clean_memory();
+  walls.clean_memory();
+  return tris;
+}
+
+Array<Vector<int,3>> StreamingDelaunay::advance() {
+  Array<Vector<int,3>> tris;
+  const int n = ids.size();
+  if (n<3)
+    return tris;
+
+  // Triangulate the active points
+  const Field<const Perturbed2,VertexId> Xp(partially_sorted_shuffle(n,
+    [&](const int i) { return Perturbed2(ids[i],X[i]); },streaming_sentinel_seed));
+  const auto mesh = deterministic_exact_delaunay(Xp,false);
+  const auto id = [&](const VertexId v) { return Xp[v].seed(); };
+  const auto wall = [&](const HalfedgeId e) {
+    const int i = id(mesh->src(e)),
+              j = id(mesh->dst(e));
+    return walls.contains(vec(i,j)) || walls.contains(vec(j,i));
+  };
+
+  // Flood fill components separated by walls.  A component is live if the facing sides of its walls are unreturned.
+  Field<int,FaceId> component(mesh->allocated_faces());
+  component.flat.fill(-1);
+  Array<bool> live;
+  Array<FaceId> stack;
+  for (const auto f : mesh->faces())
+    if (component[f]<0) {
+      const int c = live.append(true);
+      bool classified = false;
+      component[f] = c;
+      stack.append(f);
+      while (stack.size()) {
+        const auto g = stack.pop();
+        for (const auto e : mesh->halfedges(g)) {
+          if (wall(e)) {
+            if (!classified) {
+              live[c] = !walls.contains(vec(id(mesh->src(e)),id(mesh->dst(e))));
+              classified = true;
+            }
+          } else {
+            const auto h = mesh->face(mesh->reverse(e));
+            if (h.valid() && component[h]<0) {
+              component[h] = c;
+              stack.append(h);
+            }
+          }
+        }
+      }
+    }
+
+  // Return live triangles which can no longer change
+  Field<bool,FaceId> done(mesh->allocated_faces());
+  for (const auto f : mesh->faces()) {
+    if (!live[component[f]])
+      done[f] = true;
+    else {
+      const auto v = mesh->vertices(f);
+      if (circle_finalized(Xp[v.x].value(),Xp[v.y].value(),Xp[v.z].value())) {
+        done[f] = true;
+        tris.append(vec(id(v.x),id(v.y),id(v.z)));
+      }
+    }
+  }
+  for (const auto& t : tris)
+    for (int a=0;a<3;a++)
+      walls.set(vec(t[a],t[(a+1)%3]));
+
+  // Forget interior points whose stars are complete
+  Hashtable<int> retired;
+  Array<int> new_ids;
+  Array<EV> new_X;
+  for (const auto v : mesh->vertices()) {
+    bool complete = !mesh->is_boundary(v);
+    if (complete)
+      for (const auto e : mesh->outgoing(v))
+        if (!done[mesh->face(e)]) {
+          complete = false;
+          break;
+        }
+    if (complete)
+      retired.set(id(v));
+    else {
+      new_ids.append(id(v));
+      new_X.append(Xp[v].value());
+    }
+  }
+  if (retired.size()) {
+    ids = new_ids;
+    X = new_X;
+    Hashtable<Vector<int,2>> new_walls;
+    for (const auto& e : walls)
+      if (!retired.contains(e.x) && !retired.contains(e.y))
+        new_walls.set(e);
+    walls.swap(new_walls);
+  }
+  return tris;
+}
+
+// Quality refinement follows Ruppert's algorithm as presented by Shewchuk, "Delaunay refinement algorithms for
+// triangular mesh generation".  Constraint edges and the convex hull are segments, which are split at their midpoints
+// whenever a vertex encroaches on their diametral circles.  Bad triangles are processed worst first from a priority
+// queue and have their circumcenters inserted, unless the circumcenter would encroach on a segment, in which case the
+// segment is split instead.  Point location walks from the bad triangle itself, so no global search structure is
+// needed.  All decisions affecting topology use exact predicates on quantized points, with Steiner points rounded to
+// the integer grid.  As a consequence, split segments may bend by half a quantum, which is invisible after unquantizing.
+
+namespace {
+struct BadFace {
+  double badness;
+  FaceId f;
+  Vector<VertexId,3> v; // For detecting stale entries
+
+  bool operator<(const BadFace& b) const { return badness < b.badness; }
+};
+
+struct Refiner {
+  MutableTriangleTopology& mesh;
+  Field<Perturbed2,VertexId> X;
+  Field<Vector<VertexId,2>,VertexId> origin; // Original segment for Steiner points on segments
+  Hashtable<Vector<VertexId,2>> segments, unsplittable;
+  Array<Vector<VertexId,2>> encroached;
+  std::priority_queue<BadFace> bad;
+  const double B2; // Squared maximum ratio of circumradius to shortest edge
+  const double max_area;
+  int steiner;
+  const Ref<Random> random;
+
+  Refiner(MutableTriangleTopology& mesh, RawArray<const EV> X0, RawArray<const Vector<int,2>> edges,
+          const double min_angle, const double max_area)
+    : mesh(mesh)
+    , X(X0.size(),uninit)
+    , origin(X0.size())
+    , B2(sqr(1/(2*sin(min_angle))))
+    , max_area(max_area)
+    , steiner(0)
+    , random(new_<Random>(key+19)) {
+    for (const int i : range(X0.size()))
+      X.flat[i] = Perturbed2(i,X0[i]);
+    origin.flat.fill(vec(VertexId(),VertexId()));
+    for (const auto e : edges)
+      segments.set(vec(VertexId(e.x),VertexId(e.y)).sorted());
+    for (const auto e : mesh.boundary_edges())
+      segments.set(mesh.vertices(e).sorted());
+  }
+
+  bool is_segment(const VertexId a, const VertexId b) const {
+    return segments.contains(vec(a,b).sorted());
+  }
+
+  // Does x lie inside the diametral circle of segment ab?
+  bool encroaches(const VertexId a, const VertexId b, const EV x) const {
+    return dot(X[a].value()-x,X[b].value()-x) < 0;
+  }
+
+  // Queue a segment if either opposite vertex encroaches on it
+  void check_segment(const VertexId a, const VertexId b) {
+    const auto e = mesh.halfedge(a,b);
+    for (const auto h : vec(e,mesh.reverse(e)))
+      if (!mesh.is_boundary(h) && encroaches(a,b,X[mesh.opposite(h)].value())) {
+        encroached.append(vec(a,b));
+        return;
+      }
+  }
+
+  // Queue a face if it is too skinny or too large
+  void check_face(const FaceId f) {
+    const auto v = mesh.vertices(f);
+    const auto x0 = X[v.x].value(),
+               x1 = X[v.y].value(),
+               x2 = X[v.z].value();
+    const auto L = vec(sqr_magnitude(x2-x1),sqr_magnitude(x0-x2),sqr_magnitude(x1-x0));
+    const int shortest = L.argmin();
+    if (L[shortest] < 16) // Too close to the quantization grid to refine further
+      return;
+    const double area = .5*cross(x1-x0,x2-x0);
+    // Squared ratio of circumradius to shortest edge is L0*L1*L2/(16*area^2*Lmin)
+    double badness = area/max_area;
+    if (area > 0)
+      badness = max(badness,L.product()/(16*sqr(area)*L[shortest]*B2));
+    if (!(badness > 1))
+      return;
+    // Triangles whose shortest edge spans two segments meeting at a small input angle can never be fixed
+    const auto a = v[(shortest+1)%3],
+               b = v[(shortest+2)%3];
+    const auto oa = origin[a],
+               ob = origin[b];
+    if (   oa.x.valid() && ob.x.valid() && oa!=ob
+        && (oa.contains(ob.x) || oa.contains(ob.y)))
+      return;
+    bad.push(BadFace({badness,f,v}));
+  }
+
+  // Walk from f towards x, returning either the face containing x or the segment in the way
+  Tuple<FaceId,HalfedgeId> locate(FaceId f, const Perturbed2 x) const {
+    for (;;) {
+      const auto es = mesh.halfedges(f);
+      const int start = random->uniform<int>(0,3);
+      for (int i=0;i<3;i++) {
+        const auto e = es[(start+i)%3];
+        if (!triangle_oriented(X[mesh.src(e)],X[mesh.dst(e)],x)) {
+          const auto r = mesh.reverse(e);
+          if (mesh.is_boundary(r) || is_segment(mesh.src(e),mesh.dst(e)))
+            return tuple(f,e);
+          f = mesh.face(r);
+          goto next;
+        }
+      }
+      return tuple(f,HalfedgeId());
+      next:;
+    }
+  }
+
+  // Allocate a new vertex
+  VertexId add_vertex(const EV x, const Vector<VertexId,2> segment) {
+    const auto v = mesh.add_vertex();
+    GEODE_ASSERT(v.id==X.size());
+    X.flat.append(Perturbed2(v.id,x));
+    origin.flat.append(segment);
+    steiner++;
+    return v;
+  }
+
+  // Restore the constrained Delaunay property around a newly inserted vertex, and queue any new bad faces
+  void flip_around(const VertexId v) {
+    Array<Vector<VertexId,2>> stack;
+    for (const auto e : mesh.outgoing(v))
+      if (!mesh.is_boundary(e))
+        stack.append(mesh.vertices(mesh.next(e)));
+    while (stack.size()) {
+      const auto ab = stack.pop();
+      const auto e = mesh.halfedge(ab.x,ab.y);
+      if (!e.valid() || mesh.is_boundary(e) || mesh.opposite(e)!=v)
+        continue;
+      if (mesh.is_boundary(mesh.reverse(e)) || is_segment(ab.x,ab.y) || is_delaunay(mesh,X,e))
+        continue;
+      const auto d = mesh.opposite(mesh.reverse(e));
+      GEODE_UNUSED const auto f = mesh.unsafe_flip_edge(e);
+      stack.append(vec(ab.x,d));
+      stack.append(vec(d,ab.y));
+    }
+    for (const auto e : mesh.outgoing(v))
+      if (!mesh.is_boundary(e)) {
+        check_face(mesh.face(e));
+        const auto ab = mesh.vertices(mesh.next(e));
+        if (is_segment(ab.x,ab.y))
+          check_segment(ab.x,ab.y);
+      }
+  }
+
+  // Split a segment near its midpoint, returning false if no safe split point exists
+  bool split_segment(const VertexId a, const VertexId b) {
+    const auto e = mesh.halfedge(a,b);
+    if (!e.valid() || !is_segment(a,b))
+      return true; // Already split
+    const auto xa = X[a].value(),
+               xb = X[b].value();
+    const auto m = (xa+xb)/2;
+    // Try all roundings of the midpoint, keeping adjacent triangles positively oriented
+    for (int k=0;k<4;k++) {
+      const EV x(k&1 ? ceil(m.x) : floor(m.x),
+                 k&2 ? ceil(m.y) : floor(m.y));
+      if ((k&1 && m.x==floor(m.x)) || (k&2 && m.y==floor(m.y)) || x==xa || x==xb)
+        continue;
+      const auto p = Perturbed2(X.size(),x);
+      bool safe = true;
+      for (const auto h : vec(e,mesh.reverse(e)))
+        if (!mesh.is_boundary(h)) {
+          const auto s = X[mesh.src(h)],
+                     t = X[mesh.dst(h)],
+                     o = X[mesh.opposite(h)];
+          if (o.value()==x || !triangle_oriented(s,p,o) || !triangle_oriented(p,t,o)) {
+            safe = false;
+            break;
+          }
+        }
+      if (!safe)
+        continue;
+      const auto ab = vec(a,b).sorted();
+      // Both endpoints lie on the same original segment, which may be ab itself
+      const auto v = add_vertex(x,origin[a].x.valid() ? origin[a] : origin[b].x.valid() ? origin[b] : ab);
+      segments.erase(ab);
+      segments.set(vec(a,v).sorted());
+      segments.set(vec(v,b).sorted());
+      mesh.split_edge(e,v);
+      flip_around(v);
+      check_segment(a,v);
+      check_segment(v,b);
+      return true;
+    }
+    return false;
+  }
+
+  void split_encroached() {
+    while (encroached.size()) {
+      const auto s = encroached.pop();
+      if (!unsplittable.contains(s.sorted()) && !split_segment(s.x,s.y))
+        unsplittable.set(s.sorted());
+    }
+  }
+
+  void refine(const int max_steiner) {
+    Array<Vector<VertexId,2>> initial;
+    for (const auto& s : segments)
+      initial.append(s);
+    for (const auto s : initial)
+      check_segment(s.x,s.y);
+    for (const auto f : mesh.faces())
+      check_face(f);
+    for (;;) {
+      split_encroached();
+      if (!bad.size() || steiner>=max_steiner)
+        break;
+      check_interrupts();
+      const auto b = bad.top();
+      bad.pop();
+      if (!mesh.valid(b.f) || mesh.vertices(b.f)!=b.v)
+        continue;
+
+      // Compute the circumcenter, rounded to the quantization grid
+      const auto x0 = X[b.v.x].value();
+      EV c;
+      double r;
+      if (!safe_circumcircle(x0,X[b.v.y].value(),X[b.v.z].value(),c,r))
+        continue;
+      c = EV(round(c.x),round(c.y));
+      if (!(c.maxabs() < bound/1.01)) {
+        // Far outside the domain, so walk towards the domain boundary instead
+        c = x0+(bound/1.01-x0.maxabs())/max(1.,(c-x0).maxabs())*(c-x0);
+        c = EV(round(c.x),round(c.y));
+      }
+      const auto p = Perturbed2(X.size(),c);
+
+      // Locate the circumcenter, splitting any segment hiding it
+      const auto loc = locate(b.f,p);
+      if (loc.y.valid()) {
+        const auto s = mesh.vertices(loc.y);
+        if (!unsplittable.contains(s.sorted())) {
+          encroached.append(s);
+          bad.push(b);
+        }
+        continue;
+      }
+      const auto f = loc.x;
+      const auto fv = mesh.vertices(f);
+      if (X[fv.x].value()==c || X[fv.y].value()==c || X[fv.z].value()==c)
+        continue;
+
+      // Find the cavity of faces whose circumcircles contain the circumcenter, and check the segments on its boundary
+      bool blocked = false;
+      Hashtable<FaceId> cavity;
+      Array<FaceId> work;
+      cavity.set(f);
+      work.append(f);
+      while (work.size()) {
+        const auto g = work.pop();
+        for (const auto e : mesh.halfedges(g)) {
+          const auto ab = mesh.vertices(e);
+          const auto r = mesh.reverse(e);
+          if (is_segment(ab.x,ab.y)) {
+            if (encroaches(ab.x,ab.y,c) && !unsplittable.contains(ab.sorted())) {
+              encroached.append(ab);
+              blocked = true;
+            }
+          } else if (!mesh.is_boundary(r)) {
+            const auto h = mesh.face(r);
+            if (!cavity.contains(h) && incircle(X[ab.y],X[ab.x],X[mesh.opposite(r)],p)) {
+              cavity.set(h);
+              work.append(h);
+            }
+          }
+        }
+      }
+      if (blocked) {
+        bad.push(b);
+        continue;
+      }
+
+      // Insert the circumcenter
+      const auto v = add_vertex(c,vec(VertexId(),VertexId()));
+      mesh.split_face(f,v);
+      flip_around(v);
+    }
+  }
+};
+}
+
+Tuple<Ref<TriangleTopology>,Array<Vector<real,2>>>
+refine_delaunay_points(RawArray<const Vector<real,2>> X, RawArray<const Vector<int,2>> edges, const real min_angle,
+                       const real max_area, const int max_steiner) {
+  if (!(0<=min_angle && min_angle<=pi/180*34))
+    throw ValueError(format("refine_delaunay_points: min_angle = %g is outside the range [0,34] degrees, "
+                            "where Delaunay refinement does not terminate",min_angle*180/pi));
+  const auto quant = quantizer(bounding_box(X));
+  const auto EX = amap(quant,X).copy();
+  const auto mesh = exact_delaunay_points(EX,edges)->mutate();
+
+  // Refine
+  {
+    IntervalScope scope;
+    Refiner refiner(mesh,EX,edges,min_angle,sqr(quant.scale)*max_area);
+    refiner.refine(max_steiner);
+
+    // Unquantize Steiner points
+    Array<TV> Y(mesh->allocated_vertices(),uninit);
+    Y.slice(0,X.size()) = X;
+    for (const int i : range(X.size(),Y.size()))
+      Y[i] = quant.inverse(refiner.X.flat[i].value());
+    return tuple(ref<TriangleTopology>(mesh),Y);
+  }
 }
 
 // Greedily compute a set of nonintersecting edges in a point cloud for testing purposes
@@ -859,7 +1636,22 @@ static Array<Vector<int,2>> greedy_nonintersecting_edges(RawArray<const Vector<r
 using namespace geode;
 
 void wrap_delaunay() {
-  GEODE_FUNCTION_2(delaunay_points_py,delaunay_points)
+  GEODE_FUNCTION_2(delaunay_points_py,without_gil(delaunay_points))
   GEODE_FUNCTION(greedy_nonintersecting_edges)
   GEODE_FUNCTION(chew_fan_count)
+  GEODE_FUNCTION_2(refine_delaunay_points_py,without_gil(refine_delaunay_points))
+  {
+    typedef StreamingDelaunay Self;
+    Class<Self>("StreamingDelaunay")
+      .GEODE_INIT(const Box<TV>&,const Vector<int,2>)
+      .GEODE_FIELD(box)
+      .GEODE_FIELD(cells)
+      .GEODE_METHOD(total_points)
+      .GEODE_METHOD(active_points)
+      .GEODE_METHOD(cell)
+      .GEODE_METHOD(add_points)
+      .GEODE_METHOD(finalize_cells)
+      .GEODE_METHOD(finish)
+      ;
+  }
 }
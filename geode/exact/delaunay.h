@@ -2,21 +2,86 @@
 #pragma once
 
 #include <geode/exact/config.h>
+#include <geode/exact/quantize.h>
 #include <geode/mesh/TriangleTopology.h>
+#include <geode/structure/Hashtable.h>
 namespace geode {
 
 // Approximately Delaunay triangulate a point set, by first quantizing and performing exact Delaunay.
 // Any edges are used as constraints in constrained Delaunay.  If two edges intersect, ValueError is thrown.
+// If parallel is true, large inputs are triangulated in spatial pieces on all OpenMP threads.  If bulk_constraints
+// is true, missing constraints are inserted in spatially coherent order, which is much faster for hundreds of
+// thousands of constraints.  The triangulation is the same either way, but faces may be ordered differently.
 GEODE_CORE_EXPORT Ref<TriangleTopology> delaunay_points(RawArray<const Vector<real,2>> X,
                                                         RawArray<const Vector<int,2>> edges=Tuple<>(),
-                                                        const bool validate=false);
+                                                        const bool validate=false, const bool parallel=false,
+                                                        const bool bulk_constraints=false);
 
 // Exactly Delaunay triangulate a quantized point set.
 // Any edges are used as constraints in constrained Delaunay.  If two edges intersect, ValueError is thrown.
 GEODE_CORE_EXPORT Ref<TriangleTopology> exact_delaunay_points(RawArray<const Vector<Quantized,2>> X,
                                                               RawArray<const Vector<int,2>> edges=Tuple<>(),
-                                                              const bool validate=false);
+                                                              const bool validate=false, const bool parallel=false,
+                                                              const bool bulk_constraints=false);
 
+// Refine a constrained Delaunay triangulation by inserting Steiner points until no triangle has an angle below
+// min_angle (in radians, at most 34 degrees) or an area above max_area, using Ruppert's algorithm on the exact core.
+// Constraint edges and the convex hull are preserved as unions of mesh edges; triangles at small input angles are
+// left alone.  Returns the mesh and positions of all vertices, with the input points first.
+GEODE_CORE_EXPORT Tuple<Ref<TriangleTopology>,Array<Vector<real,2>>>
+refine_delaunay_points(RawArray<const Vector<real,2>> X, RawArray<const Vector<int,2>> edges=Tuple<>(),
+                       const real min_angle=M_PI/9, const real max_area=numeric_limits<real>::infinity(),
+                       const int max_steiner=numeric_limits<int>::max());
+
+// Streaming Delaunay triangulation of point sets too large to hold in memory at once.  The bounding box of all points
+// is declared up front and divided into a grid of cells.  Points are fed in chunks and receive sequential ids, and
+// cells are finalized once no more points will land in them.  Whenever cells are finalized, the triangles which can
+// no longer change are returned and their interior points are forgotten, so memory is proportional to the unfinished
+// frontier rather than the whole input.  The union of all returned triangles is exactly delaunay_points(X).
+class StreamingDelaunay : public Object {
+public:
+  GEODE_DECLARE_TYPE(GEODE_CORE_EXPORT)
+  typedef Object Base;
+  typedef Vector<real,2> TV;
+  typedef Vector<Quantized,2> EV;
+
+  const Box<TV> box;
+  const Vector<int,2> cells;
+private:
+  const Quantizer<real,2> quant;
+  const Box<EV> grid; // Quantized version of box
+  Array<bool> finalized; // Per cell
+  int unfinalized; // Number of unfinalized cells
+  int points; // Number of points seen so far
+  Array<int> ids; // Ids of active points
+  Array<EV> X; // Quantized positions of active points
+  Hashtable<Vector<int,2>> walls; // Halfedges of returned triangles with active endpoints
+
+protected:
+  GEODE_CORE_EXPORT StreamingDelaunay(const Box<TV>& box, const Vector<int,2> cells);
+public:
+  ~StreamingDelaunay();
+
+  // Number of points seen so far, and number currently held in memory
+  int total_points() const { return points; }
+  int active_points() const { return ids.size(); }
+
+  // Which cell contains a point?
+  GEODE_CORE_EXPORT Vector<int,2> cell(const TV x) const;
+
+  // Add points, which must lie in unfinalized cells.  Ids are assigned sequentially, starting at total_points().
+  GEODE_CORE_EXPORT void add_points(RawArray<const TV> X);
+
+  // Finalize cells, and return all newly completed triangles
+  GEODE_CORE_EXPORT Array<Vector<int,3>> finalize_cells(RawArray<const Vector<int,2>> cells);
+
+  // Finalize all remaining cells, and return the rest of the triangles
+  GEODE_CORE_EXPORT Array<Vector<int,3>> finish();
+
+private:
+  Array<Vector<int,3>> advance();
+  bool circle_finalized(const EV x0, const EV x1, const EV x2) const;
+};
 
 struct GEODE_CORE_CLASS_EXPORT DelaunayConstraintConflict : public ValueError {
   typedef ValueError Base;
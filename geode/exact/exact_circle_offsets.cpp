@@ -188,8 +188,8 @@ Tuple<Ref<PlanarArcGraph<Pb::Implicit>>, Nested<HalfedgeId>> offset_closed_exact
   const auto arc_contours = src_g.combine_concentric_arcs(src_g.edges_to_closed_contours(contours));
   ArcAccumulator<Pb::Implicit> minkowski_terms;
 
-  // Add the original contours
-  minkowski_terms.copy_contours(arc_contours, src_g.vertices);
+  // Add the original contours.  These are edges of src_g and so have already been split against each other.
+  minkowski_terms.copy_split_contours(arc_contours, src_g.vertices);
 
   for(const auto c : arc_contours) {
     for(const auto sa : c) {
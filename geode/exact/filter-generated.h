@@ -0,0 +1,118 @@
+// Autogenerated by exact/gen-exact.  Do not edit directly!
+//
+// Static floating point filters for common predicates.  Each filter returns the sign of the predicate polynomial
+// if it is certain from double precision evaluation, and 0 otherwise.  The filters are valid in any rounding mode.
+
+GEODE_PURE static inline int filter_triangle_oriented(const Vector<double,2> p0, const Vector<double,2> p1, const Vector<double,2> p2) {
+  const double t0 = p1.x - p0.x;
+  const double t1 = p1.y - p0.y;
+  const double t2 = p2.x - p0.x;
+  const double t3 = p2.y - p0.y;
+  const double t4 = t0*t3;
+  const double m5 = fabs(t0)*fabs(t3);
+  const double t6 = t1*t2;
+  const double m7 = fabs(t1)*fabs(t2);
+  const double t8 = t4 - t6;
+  const double m9 = m5 + m7;
+  const double bound = 8.881784197001266e-16*m9;
+  return t8 > bound ? 1 : t8 < -bound ? -1 : 0;
+}
+
+GEODE_PURE static inline int filter_incircle(const Vector<double,2> p0, const Vector<double,2> p1, const Vector<double,2> p2, const Vector<double,2> p3) {
+  const double t0 = p0.x - p3.x;
+  const double t1 = p0.y - p3.y;
+  const double t2 = p1.x - p3.x;
+  const double t3 = p1.y - p3.y;
+  const double t4 = p2.x - p3.x;
+  const double t5 = p2.y - p3.y;
+  const double t6 = t0*t0;
+  const double m7 = fabs(t0)*fabs(t0);
+  const double t8 = t1*t1;
+  const double m9 = fabs(t1)*fabs(t1);
+  const double t10 = t6 + t8;
+  const double m11 = m7 + m9;
+  const double t12 = t2*t2;
+  const double m13 = fabs(t2)*fabs(t2);
+  const double t14 = t3*t3;
+  const double m15 = fabs(t3)*fabs(t3);
+  const double t16 = t12 + t14;
+  const double m17 = m13 + m15;
+  const double t18 = t4*t4;
+  const double m19 = fabs(t4)*fabs(t4);
+  const double t20 = t5*t5;
+  const double m21 = fabs(t5)*fabs(t5);
+  const double t22 = t18 + t20;
+  const double m23 = m19 + m21;
+  const double t24 = t2*t5;
+  const double m25 = fabs(t2)*fabs(t5);
+  const double t26 = t3*t4;
+  const double m27 = fabs(t3)*fabs(t4);
+  const double t28 = t24 - t26;
+  const double m29 = m25 + m27;
+  const double t30 = t10*t28;
+  const double m31 = m11*m29;
+  const double t32 = t4*t1;
+  const double m33 = fabs(t4)*fabs(t1);
+  const double t34 = t5*t0;
+  const double m35 = fabs(t5)*fabs(t0);
+  const double t36 = t32 - t34;
+  const double m37 = m33 + m35;
+  const double t38 = t16*t36;
+  const double m39 = m17*m37;
+  const double t40 = t30 + t38;
+  const double m41 = m31 + m39;
+  const double t42 = t0*t3;
+  const double m43 = fabs(t0)*fabs(t3);
+  const double t44 = t1*t2;
+  const double m45 = fabs(t1)*fabs(t2);
+  const double t46 = t42 - t44;
+  const double m47 = m43 + m45;
+  const double t48 = t22*t46;
+  const double m49 = m23*m47;
+  const double t50 = t40 + t48;
+  const double m51 = m41 + m49;
+  const double bound = 2.4424906541753527e-15*m51;
+  return t50 > bound ? 1 : t50 < -bound ? -1 : 0;
+}
+
+GEODE_PURE static inline int filter_tetrahedron_oriented(const Vector<double,3> p0, const Vector<double,3> p1, const Vector<double,3> p2, const Vector<double,3> p3) {
+  const double t0 = p1.x - p0.x;
+  const double t1 = p1.y - p0.y;
+  const double t2 = p1.z - p0.z;
+  const double t3 = p2.x - p0.x;
+  const double t4 = p2.y - p0.y;
+  const double t5 = p2.z - p0.z;
+  const double t6 = p3.x - p0.x;
+  const double t7 = p3.y - p0.y;
+  const double t8 = p3.z - p0.z;
+  const double t9 = t4*t8;
+  const double m10 = fabs(t4)*fabs(t8);
+  const double t11 = t5*t7;
+  const double m12 = fabs(t5)*fabs(t7);
+  const double t13 = t9 - t11;
+  const double m14 = m10 + m12;
+  const double t15 = t0*t13;
+  const double m16 = fabs(t0)*m14;
+  const double t17 = t7*t2;
+  const double m18 = fabs(t7)*fabs(t2);
+  const double t19 = t8*t1;
+  const double m20 = fabs(t8)*fabs(t1);
+  const double t21 = t17 - t19;
+  const double m22 = m18 + m20;
+  const double t23 = t3*t21;
+  const double m24 = fabs(t3)*m22;
+  const double t25 = t15 + t23;
+  const double m26 = m16 + m24;
+  const double t27 = t1*t5;
+  const double m28 = fabs(t1)*fabs(t5);
+  const double t29 = t2*t4;
+  const double m30 = fabs(t2)*fabs(t4);
+  const double t31 = t27 - t29;
+  const double m32 = m28 + m30;
+  const double t33 = t6*t31;
+  const double m34 = fabs(t6)*m32;
+  const double t35 = t25 + t33;
+  const double m36 = m26 + m34;
+  const double bound = 1.7763568394002556e-15*m36;
+  return t35 > bound ? 1 : t35 < -bound ? -1 : 0;
+}
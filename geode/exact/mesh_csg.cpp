@@ -18,14 +18,18 @@
 #include <geode/math/mean.h>
 #include <geode/math/optimal_sort.h>
 #include <geode/mesh/TriangleSoup.h>
+#include <geode/python/Class.h>
 #include <geode/python/function.h>
 #include <geode/python/wrap.h>
 #include <geode/random/permute.h>
 #include <geode/random/Random.h>
 #include <geode/structure/Hashtable.h>
 #include <geode/structure/UnionFind.h>
+#include <geode/utility/parallel.h>
 #include <geode/utility/Unique.h>
 #include <geode/vector/Matrix.h>
+#include <exception>
+#include <vector>
 namespace geode {
 
 // Algorithm explanation:
@@ -276,7 +280,7 @@ struct Policy : public State, public Noncopyable {
   // Contiguous list of vertices for this face
   Field<int,VertexId> vertices;
 
-  Policy(State& S, const int face, const Vector<int,3> face_edges)
+  Policy(const State& S, const int face, const Vector<int,3> face_edges)
     : State(S)
     , face(face)
     , f(Xi(faces[face].x),
@@ -673,7 +677,7 @@ template<int up> struct Below : public State {
 
 // Geometry policy for triangulation within the given face, with the given axis as up
 template<int up> struct PolicyUp : public Policy {
-  PolicyUp(State& S, const int face, const Vector<int,3> face_edges)
+  PolicyUp(const State& S, const int face, const Vector<int,3> face_edges)
     : Policy(S,face,face_edges) {}
 
   // VertexIds can be either interior or boundary edge-face vertices
@@ -726,13 +730,31 @@ template<int up> struct PolicyUp : public Policy {
 };
 }
 
-// Find all intersection vertices and edges
+// Edge-face intersection status carried over from a previous call on the same topology.  Pairs where neither the
+// edge nor the face has a moved vertex keep their previous status, so only pairs touching moved vertices are
+// retested.  The node flags are true if any simplex below the tree node moved.  If both is set, only pairs where
+// both the edge and the face are flagged are tested; split_soup_cluster uses this to restrict the exact search to
+// faces that the floating point filter couldn't clear.
+struct CarriedIntersections {
+  RawArray<const bool> moved_edges, moved_faces; // Per simplex
+  RawArray<const bool> moved_edge_nodes, moved_face_nodes; // Per tree node
+  RawArray<const EdgeFaceVertex> ef_vertices; // All edge-face vertices from the previous call
+  bool both;
+
+  bool skip(const bool edge, const bool face) const {
+    return both ? !(edge && face) : !(edge || face);
+  }
+};
+
+// Find all intersection vertices and edges.  If carried is given, edge_tree must be built on the same positions.
 static Tuple<Nested<const EdgeFaceVertex>,Array<const FaceFaceEdge>>
-intersection_simplices(const SimplexTree<EV,2>& face_tree) {
+intersection_simplices(const SimplexTree<EV,2>& face_tree, Ptr<const SimplexTree<EV,1>> edge_tree=Ptr<const SimplexTree<EV,1>>(),
+                       const CarriedIntersections* carried=0) {
   const auto X = face_tree.X;
   const TriangleSoup& faces = face_tree.mesh;
   const SegmentSoup& edges = faces.segment_soup();
   GEODE_ASSERT(face_tree.leaf_size==1);
+  GEODE_ASSERT(!carried || edge_tree);
 
   // Find edge-face intersections
   Nested<EdgeFaceVertex> ef_vertices; // Edge-face intersection vertices
@@ -745,18 +767,27 @@ intersection_simplices(const SimplexTree<EV,2>& face_tree) {
     // Perhaps copy elision of a temporary passed via an initializer list to construct an anonymous struct hits a compiler bug?
     // Or perhaps I misunderstand something about lifetime of temporaries in this context?
     // Adding a seperate reference is a clean enough workaround
-    const auto helper_edge_tree = new_<SimplexTree<EV, 1>>(edges, X, 1);
-    struct {
+    const auto helper_edge_tree = edge_tree ? ref(*edge_tree) : new_<const SimplexTree<EV,1>>(edges,X,1);
+    struct Helper {
       const Ref<const SimplexTree<EV,1>> edge_tree;
       const SimplexTree<EV,2>& face_tree;
       const RawArray<const EV> X;
+      const CarriedIntersections* carried;
       Array<EdgeFaceVertex> ef_vertices;
 
-      bool cull(const int ne, const int nf) const { return false; }
+      bool cull(const int ne, const int nf) const {
+        return carried && carried->skip(carried->moved_edge_nodes[ne],carried->moved_face_nodes[nf]);
+      }
+
+      void merge(const Helper& other) {
+        ef_vertices.extend(other.ef_vertices);
+      }
 
       void leaf(const int ne, const int nf) {
         const int edge = edge_tree->prims(ne)[0],
                   face = face_tree.prims(nf)[0];
+        if (carried && carried->skip(carried->moved_edges[edge],carried->moved_faces[face]))
+          return;
         const auto ev = edge_tree->mesh->elements[edge];
         const auto fv = face_tree.mesh->elements[face];
         if (!(fv.contains(ev.x) || fv.contains(ev.y))) {
@@ -768,8 +799,14 @@ intersection_simplices(const SimplexTree<EV,2>& face_tree) {
           }
         }
       }
-    } helper({helper_edge_tree,face_tree,X});
-    double_traverse(*helper.edge_tree,face_tree,helper);
+    } helper({helper_edge_tree,face_tree,X,carried});
+    // The traversal is split into independent subtree pairs and run in parallel.  The order of ef_vertices
+    // doesn't matter here, since they are sorted along each edge below.
+    parallel_double_traverse<IntervalScope>(*helper.edge_tree,face_tree,helper);
+    if (carried)
+      for (const auto& ef : carried->ef_vertices)
+        if (carried->skip(carried->moved_edges[ef.edge],carried->moved_faces[ef.face]))
+          helper.ef_vertices.append(ef);
 
     // Bucket edge face vertices by edge
     Array<int> counts(edges.elements.size());
@@ -959,8 +996,19 @@ struct DepthUnionFind {
 };
 }
 
+namespace {
+// The result of retriangulating a single face.  Faces only read shared state while being retriangulated,
+// so they can be processed independently (and in parallel) and merged afterwards in face order.
+struct CutFace {
+  int face;
+  Array<Vector<int,3>> faces; // Cut faces, with face-face-face vertices numbered locally
+  Array<FaceFaceFaceVertex> fff_vertices; // Face-face-face vertices in order of first use by this face
+  Array<Vector<int,3>> merges; // Union-find merges (i,j,depth(j)-depth(i)).  Negative entries ~k refer to local cut face k.
+};
+}
+
 template<int up> static void
-retriangulate_face(State& S, Array<Vector<int,3>>& cut_faces, Array<int> &original_face_index, DepthUnionFind* const union_find,
+retriangulate_face(const State& S, CutFace& cut, const bool depth,
                    const int face, Vector<int,3> e, RawArray<int> interior,
                    RawArray<const FaceFaceEdge> ff_edges, RawArray<const int> ffs) {
   // Sort vertices in upwards order, keeping track of permutation parity.
@@ -1056,18 +1104,18 @@ retriangulate_face(State& S, Array<Vector<int,3>>& cut_faces, Array<int> &origin
                                 Line({ff.faces.sum()-face,ff.faces.x!=face?ffi:-ffi-1}));
   }
 
-  // Copy mesh into cut_faces
+  // Copy mesh into cut faces
+  cut.face = face;
+  cut.faces.preallocate(mesh->n_faces());
   for (const auto f : mesh->faces()) {
     const auto v = mesh->vertices(f);
-    original_face_index.append(face);
-    cut_faces.append(vec(vertices[v.x],
-                         vertices[v.y],
-                         vertices[v.z]));
+    cut.faces.append_assuming_enough_space(vec(vertices[v.x],
+                                               vertices[v.y],
+                                               vertices[v.z]));
   }
 
-  if (union_find) {
+  if (depth) {
     // Absorb depth information at the start of all three original edges
-    const int base = union_find->extend(mesh->n_faces());
     const auto h = vec(mesh->halfedge(lo),
                        mesh->halfedge(vy),
                        mesh->halfedge(hi));
@@ -1075,7 +1123,7 @@ retriangulate_face(State& S, Array<Vector<int,3>>& cut_faces, Array<int> &origin
     for (int i=0;i<3;i++) {
       const int j = (i+shift+3)%3,
                 k = (j+shift+3)%3;
-      union_find->merge(e[i],base+mesh->face(S.edges[e[i]].x==v[k] ? mesh->left(h[k]) : mesh->reverse(h[j])).id,0);
+      cut.merges.append(vec(e[i],~mesh->face(S.edges[e[i]].x==v[k] ? mesh->left(h[k]) : mesh->reverse(h[j])).id,0));
     }
 
     // Absorb depth information in the interior of the cut triangle.
@@ -1093,12 +1141,12 @@ retriangulate_face(State& S, Array<Vector<int,3>>& cut_faces, Array<int> &origin
                       start = ff_edges[ff].nodes.x,
                       face2 = ff_edges[ff].faces.x == face ? ff_edges[ff].faces.y : ff_edges[ff].faces.x;
             const int ddepth = S.depth_weight[face2];
-            union_find->merge(base+f0.id,base+f1.id,flip?-ddepth:ddepth);
+            cut.merges.append(vec(~f0.id,~f1.id,flip?-ddepth:ddepth));
             if (   start==P.vertices[mesh->src(e)]
                 || start==P.vertices[mesh->dst(e)])
-              union_find->merge(ff_base+ff,base+f0.id,flip?ddepth:0);
+              cut.merges.append(vec(ff_base+ff,~f0.id,flip?ddepth:0));
           } else {
-            union_find->merge(base+f0.id,base+f1.id,0);
+            cut.merges.append(vec(~f0.id,~f1.id,0));
           }
         }
       }
@@ -1116,6 +1164,49 @@ static inline bool oriented_with_x(const P p0, const P p1, const P p2) {
   return perturbed_predicate<OrientedWithX>(p0,p1,p2);
 }}
 
+// Retriangulate a list of cut faces independently.  Must be called from every thread of a parallel
+// region (or serially), since the loop is shared between threads.
+static GEODE_NEVER_INLINE void
+retriangulate_faces(RawArray<const EV> X, RawArray<const Vector<int,3>> faces, RawArray<const Vector<int,2>> edges,
+                    RawArray<const Vector<int,3>> face_edges, RawArray<const int> depth_weight, const bool depth,
+                    Nested<const EdgeFaceVertex> ef_vertices, const Nested<int>& face_to_ef,
+                    RawArray<const FaceFaceEdge> ff_edges, const Nested<int>& face_to_ff,
+                    std::vector<CutFace>& cuts, std::exception_ptr& error) {
+  // Rounding mode is per thread
+  IntervalScope scope;
+  const int n = int(cuts.size());
+  #pragma omp for schedule(dynamic,16)
+  for (int i=0;i<n;i++) {
+    auto& cut = cuts[i];
+    const int f = cut.face;
+    try {
+      // Face-face-face vertices are constructed locally, and deduplicated during the merge
+      Hashtable<Vector<int,3>,int> faces_to_fff;
+      const State S(X,ef_vertices,cut.fff_vertices,faces_to_fff,faces,edges,depth_weight);
+      const auto v = faces[f];
+
+      // Find the three edges bounding this face
+      const auto fe = face_edges[f]; // v01,v12,v20
+      Vector<int,3> e(fe.y,fe.z,fe.x); // e[3-i-j] connects v[i] and v[j]
+
+      // Let the longest axis be the upwards sweep axis.  This choice can be made using inexact arithmetic,
+      // since it does not affect correctness.
+      const int up = bounding_box(X[v.x],X[v.y],X[v.z]).sizes().dominant_axis();
+      const auto interior = face_to_ef[f];
+      const auto ffs = face_to_ff[f];
+      if (up==0)      retriangulate_face<0>(S,cut,depth,f,e,interior,ff_edges,ffs);
+      else if (up==1) retriangulate_face<1>(S,cut,depth,f,e,interior,ff_edges,ffs);
+      else            retriangulate_face<2>(S,cut,depth,f,e,interior,ff_edges,ffs);
+    } catch (...) {
+      #pragma omp critical
+      {
+        if (!error)
+          error = std::current_exception();
+      }
+    }
+  }
+}
+
 // Retriangulate each face w.r.t. the other faces which cut it
 static Tuple<Array<const FaceFaceFaceVertex>,Array<Vector<int,3>>,Array<int>>
 retriangulate_soup(const SimplexTree<EV,2>& face_tree, Array<const int> depth_weight, DepthUnionFind* const union_find,
@@ -1172,40 +1263,80 @@ retriangulate_soup(const SimplexTree<EV,2>& face_tree, Array<const int> depth_we
     union_find->extend(edges.elements.size()+ff_edges.size());
   }
 
-  // Retriangulate each face
+  // Retriangulate each face.  Cut faces are retriangulated independently in blocks, possibly in parallel,
+  // and then merged in face order.  Face-face-face vertices are numbered in order of first use, and
+  // union-find merges are applied in the same order as a fully serial sweep, so the result does not
+  // depend on the number of threads.
   Array<FaceFaceFaceVertex> fff_vertices;
   Hashtable<Vector<int,3>,int> faces_to_fff;
-  State S(X,ef_vertices,fff_vertices,faces_to_fff,faces.elements,edges.elements,depth_weight);
-  for (const int f : range(faces.elements.size())) {
-    const auto v = faces.elements[f];
-
-    // Find the three edges bounding this face
-    const auto fe = face_edges[f]; // v01,v12,v20
-    Vector<int,3> e(fe.y,fe.z,fe.x); // e[3-i-j] connects v[i] and v[j]
-
-    // If the face isn't cut, there's very little to do
-    const auto interior = face_to_ef[f];
-    if (!interior.size() && !ef_vertices.size(e.x)
-                         && !ef_vertices.size(e.y)
-                         && !ef_vertices.size(e.z)) {
-      original_face_index.append(f);
-      cut_faces.append(v);
-      if (union_find) {
-        const int i = union_find->append();
-        union_find->merge(i,e.x,0);
-        union_find->merge(i,e.y,0);
-        union_find->merge(i,e.z,0);
+  const int nn = X.size()+ef_vertices.flat.size();
+  const int block_size = 4096;
+  std::vector<CutFace> cuts;
+  Array<int> local_to_fff;
+  for (int start=0;start<faces.elements.size();start+=block_size) {
+    const int end = min(start+block_size,faces.elements.size());
+
+    // Collect the faces in this block which need retriangulation
+    cuts.clear();
+    for (const int f : range(start,end)) {
+      const auto fe = face_edges[f]; // v01,v12,v20
+      if (   face_to_ef.size(f) || ef_vertices.size(fe.x)
+                                || ef_vertices.size(fe.y)
+                                || ef_vertices.size(fe.z)) {
+        cuts.push_back(CutFace());
+        cuts.back().face = f;
+      }
+    }
+    std::exception_ptr error;
+    #pragma omp parallel
+    retriangulate_faces(X,faces.elements,edges.elements,face_edges,depth_weight,union_find!=0,
+                        ef_vertices,face_to_ef,ff_edges,face_to_ff,cuts,error);
+    if (error)
+      std::rethrow_exception(error);
+
+    // Merge results in face order
+    int next = 0;
+    for (const int f : range(start,end)) {
+      if (next<int(cuts.size()) && cuts[next].face==f) {
+        const auto& cut = cuts[next++];
+
+        // Assign global indices to face-face-face vertices, keeping the first construction of each
+        local_to_fff.resize(cut.fff_vertices.size(),uninit);
+        for (const int i : range(cut.fff_vertices.size())) {
+          const auto& v = cut.fff_vertices[i];
+          const int n = faces_to_fff.size();
+          local_to_fff[i] = faces_to_fff.get_or_insert(v.faces.sorted(),n);
+          if (local_to_fff[i] == n)
+            fff_vertices.append(v);
+        }
+        for (const auto& c : cut.faces) {
+          original_face_index.append(f);
+          auto g = c;
+          for (auto& v : g)
+            if (v >= nn)
+              v = nn+local_to_fff[v-nn];
+          cut_faces.append(g);
+        }
+        if (union_find) {
+          const int base = union_find->extend(cut.faces.size());
+          #define NODE(i) ((i)<0 ? base+~(i) : (i))
+          for (const auto& m : cut.merges)
+            union_find->merge(NODE(m.x),NODE(m.y),m.z);
+          #undef NODE
+        }
+      } else {
+        // If the face isn't cut, there's very little to do
+        const auto fe = face_edges[f]; // v01,v12,v20
+        original_face_index.append(f);
+        cut_faces.append(faces.elements[f]);
+        if (union_find) {
+          const int i = union_find->append();
+          union_find->merge(i,fe.y,0);
+          union_find->merge(i,fe.z,0);
+          union_find->merge(i,fe.x,0);
+        }
       }
-      continue;
     }
-
-    // Let the longest axis be the upwards sweep axis.  This choice can be made using inexact arithmetic,
-    // since it does not affect correctness.
-    const int up = bounding_box(X[v.x],X[v.y],X[v.z]).sizes().dominant_axis();
-    const auto ffs = face_to_ff[f];
-    if (up==0)      retriangulate_face<0>(S,cut_faces,original_face_index,union_find,f,e,interior,ff_edges,ffs);
-    else if (up==1) retriangulate_face<1>(S,cut_faces,original_face_index,union_find,f,e,interior,ff_edges,ffs);
-    else            retriangulate_face<2>(S,cut_faces,original_face_index,union_find,f,e,interior,ff_edges,ffs);
   }
 
   // Add one union-find node at infinity, and fire rays until everything is connected to it
@@ -1375,15 +1506,129 @@ exact_split_soup(const TriangleSoup& faces, Array<const EV> X, const int depth)
   return exact_split_soup(faces, X, depth_weight, depth);
 }
 
-Tuple<Ref<const TriangleSoup>,Array<EV>>
-exact_split_soup(const TriangleSoup& faces, Array<const EV> X, Array<const int> depth_weight, const int depth) {
-  IntervalScope scope;
+static Tuple<Ref<const TriangleSoup>,Array<EV>>
+split_soup_simplices(const SimplexTree<EV,2>& face_tree, Nested<const EdgeFaceVertex> ef_vertices,
+                     Array<const FaceFaceEdge> ff_edges, Array<const int> depth_weight, const int depth);
+
+// Flag tree nodes containing a moved simplex
+template<int d> static Array<bool> moved_nodes(const SimplexTree<EV,d>& tree, RawArray<const bool> moved) {
+  Array<bool> flags(tree.nodes());
+  for (const int n : tree.leaves)
+    for (const int s : tree.prims(n))
+      flags[n] |= moved[s];
+  for (int n=tree.leaves.lo-1;n>=0;n--) {
+    const auto c = tree.children(n);
+    flags[n] = flags[c.x] || flags[c.y];
+  }
+  return flags;
+}
+
+// Floating point orient3d with twice Shewchuk's static error bound, since we may be rounding upwards inside an
+// IntervalScope: the sign of det(a-d,b-d,c-d) if certain, otherwise 0
+static inline int filtered_orient(const EV a, const EV b, const EV c, const EV d) {
+  const auto ad = a-d, bd = b-d, cd = c-d;
+  const double m0 = bd.y*cd.z, m1 = bd.z*cd.y,
+               m2 = cd.y*ad.z, m3 = cd.z*ad.y,
+               m4 = ad.y*bd.z, m5 = ad.z*bd.y;
+  const double det = ad.x*(m0-m1)+bd.x*(m2-m3)+cd.x*(m4-m5),
+               permanent = (fabs(m0)+fabs(m1))*fabs(ad.x)+(fabs(m2)+fabs(m3))*fabs(bd.x)+(fabs(m4)+fabs(m5))*fabs(cd.x);
+  const double bound = 2*7.771561172376103e-16*permanent; // 2*(7+56*eps)*eps
+  return det>bound ? 1 : det<-bound ? -1 : 0;
+}
+
+// Conservative segment-triangle test: false only if e0,e1 certainly misses triangle f0,f1,f2
+static inline bool segment_triangle_maybe_intersect(const EV e0, const EV e1, const EV f0, const EV f1, const EV f2) {
+  const int s0 = filtered_orient(f0,f1,f2,e0),
+            s1 = filtered_orient(f0,f1,f2,e1);
+  if (s0*s1>0)
+    return false;
+  const int t0 = filtered_orient(e0,e1,f0,f1),
+            t1 = filtered_orient(e0,e1,f1,f2),
+            t2 = filtered_orient(e0,e1,f2,f0);
+  return !(t0*t1<0 || t1*t2<0 || t2*t0<0);
+}
 
-  // Find ef_vertices and ff_halfedges
+namespace {
+// Find faces which may take part in an edge-face intersection, using floating point filters on each pair of faces
+// with overlapping boxes.  As in intersection_simplices, an edge is only tested against faces not touching it.
+struct MaybeIntersecting {
+  const SimplexTree<EV,2>& face_tree;
+  RawArray<const Vector<int,3>> faces;
+  RawArray<const EV> X;
+  Array<int> dirty;
+
+  bool cull(const int n) const { return false; }
+  bool cull(const int n0, const int n1) const { return false; }
+  void leaf(const int n) const {}
+
+  void merge(const MaybeIntersecting& other) {
+    dirty.extend(other.dirty);
+  }
+
+  // Can an edge of f intersect g?
+  bool edges_maybe_hit(const Vector<int,3> f, const Vector<int,3> g) const {
+    for (int i=0;i<3;i++) {
+      const int a = f[i], b = f[(i+1)%3];
+      if (!g.contains(a) && !g.contains(b)
+          && segment_triangle_maybe_intersect(X[a],X[b],X[g.x],X[g.y],X[g.z]))
+        return true;
+    }
+    return false;
+  }
+
+  void leaf(const int n0, const int n1) {
+    const int f0 = face_tree.prims(n0)[0],
+              f1 = face_tree.prims(n1)[0];
+    if (f0==f1)
+      return;
+    const auto v0 = faces[f0], v1 = faces[f1];
+    if (v0.contains(v1.x)+v0.contains(v1.y)+v0.contains(v1.z)>=2) // Edge neighbors share no testable pairs
+      return;
+    if (edges_maybe_hit(v0,v1) || edges_maybe_hit(v1,v0)) {
+      dirty.append(f0);
+      dirty.append(f1);
+    }
+  }
+};
+}
+
+// Split a soup which is not decomposed into clusters (see soup_clusters)
+static Tuple<Ref<const TriangleSoup>,Array<EV>>
+split_soup_cluster(const TriangleSoup& faces, Array<const EV> X, Array<const int> depth_weight, const int depth) {
   const auto face_tree = new_<SimplexTree<EV,2>>(faces,X,1);
-  const auto A = intersection_simplices(face_tree);
-  const auto ef_vertices = A.x;
-  const auto ff_edges = A.y;
+
+  // Nearly clean meshes have few faces that a floating point filter can't clear.  Only those go through the exact
+  // edge-face search, and if there are none we skip straight to depth computation.
+  MaybeIntersecting filter({face_tree,faces.elements,X});
+  parallel_double_traverse(*face_tree,filter);
+  const int ne = faces.segment_soup()->elements.size();
+  if (!filter.dirty.size())
+    return split_soup_simplices(face_tree,Nested<EdgeFaceVertex>(Array<int>(ne)),Array<const FaceFaceEdge>(),
+                                depth_weight,depth);
+  Array<bool> dirty_faces(faces.elements.size()), dirty_edges(ne);
+  const auto face_edges = faces.triangle_edges();
+  for (const int f : filter.dirty) {
+    dirty_faces[f] = true;
+    for (const int e : face_edges[f])
+      dirty_edges[e] = true;
+  }
+
+  // Find ef_vertices and ff_halfedges among dirty faces
+  const auto edge_tree = new_<const SimplexTree<EV,1>>(faces.segment_soup(),X,1);
+  const auto dirty_edge_nodes = moved_nodes(*edge_tree,dirty_edges),
+             dirty_face_nodes = moved_nodes(*face_tree,dirty_faces);
+  const CarriedIntersections carried = {dirty_edges,dirty_faces,dirty_edge_nodes,dirty_face_nodes,
+                                        RawArray<const EdgeFaceVertex>(),true};
+  const auto A = intersection_simplices(face_tree,edge_tree,&carried);
+  return split_soup_simplices(face_tree,A.x,A.y,depth_weight,depth);
+}
+
+// Retriangulate a soup given its intersection simplices, and extract faces at the given depth
+static Tuple<Ref<const TriangleSoup>,Array<EV>>
+split_soup_simplices(const SimplexTree<EV,2>& face_tree, Nested<const EdgeFaceVertex> ef_vertices,
+                     Array<const FaceFaceEdge> ff_edges, Array<const int> depth_weight, const int depth) {
+  const TriangleSoup& faces = face_tree.mesh;
+  const auto X = face_tree.X;
 
   // Optionally compute depths
   Unique<DepthUnionFind> union_find;
@@ -1428,6 +1673,126 @@ exact_split_soup(const TriangleSoup& faces, Array<const EV> X, Array<const int>
   return tuple(new_<const TriangleSoup>(pruned_faces),Xs);
 }
 
+namespace {
+struct ComponentOverlaps {
+  const BoxTree<EV>& tree;
+  UnionFind& union_find;
+
+  ComponentOverlaps(const BoxTree<EV>& tree, UnionFind& union_find)
+    : tree(tree), union_find(union_find) {}
+
+  bool cull(const int n) const { return false; }
+  bool cull(const int n0, const int n1) const { return false; }
+  void leaf(const int n) const {}
+  void leaf(const int n0, const int n1) {
+    for (const int i : tree.prims(n0))
+      for (const int j : tree.prims(n1))
+        union_find.merge(i,j);
+  }
+};
+}
+
+// Group faces into clusters of connected components whose bounding boxes overlap, in order of first face.
+// Faces in different clusters cannot intersect, and a closed component has zero winding number outside its
+// bounding box, so clusters do not affect each other's depths and can be split independently.
+static Nested<const int> soup_clusters(const TriangleSoup& faces, RawArray<const EV> X) {
+  const auto elements = faces.elements;
+  UnionFind vertices(X.size());
+  for (const auto& f : elements) {
+    vertices.merge(f.x,f.y);
+    vertices.merge(f.x,f.z);
+  }
+
+  // Number components in order of first face, and compute their boxes
+  Array<int> component(X.size());
+  component.fill(-1);
+  Array<int> face_component(elements.size(),uninit);
+  Array<Box<EV>> boxes;
+  for (const int f : range(elements.size())) {
+    int& c = component[vertices.find(elements[f].x)];
+    if (c<0) {
+      c = boxes.size();
+      boxes.append(Box<EV>());
+    }
+    face_component[f] = c;
+    for (const int v : elements[f])
+      boxes[c].enlarge(X[v]);
+  }
+
+  // Merge components with overlapping boxes
+  UnionFind overlaps(boxes.size());
+  if (boxes.size()>1) {
+    const auto tree = new_<BoxTree<EV>>(boxes,1);
+    ComponentOverlaps visitor(tree,overlaps);
+    double_traverse(*tree,visitor);
+  }
+  Array<int> cluster(boxes.size());
+  cluster.fill(-1);
+  Array<int> counts, face_cluster(elements.size(),uninit);
+  for (const int f : range(elements.size())) {
+    int& k = cluster[overlaps.find(face_component[f])];
+    if (k<0) {
+      k = counts.size();
+      counts.append(0);
+    }
+    counts[k]++;
+    face_cluster[f] = k;
+  }
+  Nested<int> clusters(counts,uninit);
+  for (int f=elements.size()-1;f>=0;f--)
+    clusters(face_cluster[f],--counts[face_cluster[f]]) = f;
+  return clusters;
+}
+
+Tuple<Ref<const TriangleSoup>,Array<EV>>
+exact_split_soup(const TriangleSoup& faces, Array<const EV> X, Array<const int> depth_weight, const int depth) {
+  IntervalScope scope;
+  GEODE_ASSERT(faces.nodes()<=X.size());
+  GEODE_ASSERT(depth_weight.size()==faces.elements.size());
+
+  // Assemblies of many separated parts are split one cluster at a time, so that intersection finding and
+  // depth rays only see nearby faces.
+  const auto clusters = soup_clusters(faces,X);
+  if (clusters.size()<=1)
+    return split_soup_cluster(faces,X,depth_weight,depth);
+
+  // Original vertices keep their indices, and vertices created by each cluster are appended
+  Array<EV> Xs = X.copy();
+  Array<Vector<int,3>> result;
+  Array<int> local(X.size());
+  local.fill(-1);
+  for (const auto cluster : clusters) {
+    Array<int> global;
+    Array<EV> cluster_X;
+    Array<Vector<int,3>> cluster_faces(cluster.size(),uninit);
+    Array<int> cluster_weight(cluster.size(),uninit);
+    for (const int i : range(cluster.size())) {
+      const int f = cluster[i];
+      auto& g = cluster_faces[i];
+      g = faces.elements[f];
+      for (auto& v : g) {
+        if (local[v]<0) {
+          local[v] = global.append(v);
+          cluster_X.append(X[v]);
+        }
+        v = local[v];
+      }
+      cluster_weight[i] = depth_weight[f];
+    }
+    for (const int v : global)
+      local[v] = -1;
+
+    // Split the cluster and map its vertices back
+    const auto S = split_soup_cluster(new_<TriangleSoup>(cluster_faces,global.size()),cluster_X,cluster_weight,depth);
+    const int n = global.size();
+    for (const int v : range(n,S.y.size()))
+      global.append(Xs.append(S.y[v]));
+    for (const auto& f : S.x->elements)
+      result.append(vec(global[f.x],global[f.y],global[f.z]));
+  }
+  return tuple(new_<const TriangleSoup>(result),Xs);
+}
+
 Tuple<Ref<const TriangleSoup>,Array<TV>> split_soup(const TriangleSoup& faces, Array<const TV> X, Array<const int> depth_weight, const int depth) {
   const auto quant = quantizer(bounding_box(X));
   const auto S = exact_split_soup(faces,amap(quant,X).copy(),depth_weight,depth);
@@ -1440,6 +1805,155 @@ Tuple<Ref<const TriangleSoup>,Array<TV>> split_soup(const TriangleSoup& faces, A
   return split_soup(faces, X, depth_weight, depth);
 }
 
+// The union of a set of parts, with vertices local to the set
+namespace {
+struct PartialUnion {
+  Array<Vector<int,3>> faces;
+  Array<EV> X;
+};
+}
+
+// Union the given soup on its own, keeping only the outer boundary
+static PartialUnion union_one(RawArray<const Vector<int,3>> faces, Array<const EV> X) {
+  Array<int> weight(faces.size(),uninit);
+  weight.fill(1);
+  const auto S = exact_split_soup(new_<TriangleSoup>(faces.copy(),X.size()),X,weight,0);
+  return PartialUnion({S.x->elements.copy(),S.y});
+}
+
+Tuple<Ref<const TriangleSoup>,Array<EV>>
+exact_union_soups(const TriangleSoup& faces, Array<const EV> X, Array<const int> parts, const int leaf_size) {
+  GEODE_ASSERT(faces.nodes()<=X.size());
+  GEODE_ASSERT(parts.size()==faces.elements.size());
+  GEODE_ASSERT(leaf_size>0);
+  const int n = parts.size() ? parts.max()+1 : 0;
+  GEODE_ASSERT(!parts.size() || parts.min()>=0);
+  if (n<=leaf_size) {
+    const auto U = union_one(faces.elements,X);
+    return tuple(new_<const TriangleSoup>(U.faces),U.X);
+  }
+
+  // Collect faces and boxes of each part
+  Array<int> counts(n);
+  Array<Box<EV>> boxes(n);
+  for (const int f : range(parts.size())) {
+    counts[parts[f]]++;
+    for (const int v : faces.elements[f])
+      boxes[parts[f]].enlarge(X[v]);
+  }
+  Nested<int> part_faces(counts,uninit);
+  for (int f=parts.size()-1;f>=0;f--)
+    part_faces(parts[f],--counts[parts[f]]) = f;
+
+  // Nearby parts share subtrees of a box tree over part bounds.  Each leaf unions its parts, and each internal node
+  // unions the outer boundaries of its children, so interior geometry is dropped as early as possible.  Nodes at the
+  // same level are independent and run in parallel, and children are freed once their parent is done.
+  const auto tree = new_<BoxTree<EV>>(boxes,leaf_size);
+  GEODE_ASSERT(!tree->explicit_children.size());
+  vector<PartialUnion> results(tree->nodes());
+  for (int level=tree->depth-1;level>=0;level--) {
+    const int lo = (1<<level)-1,
+              hi = min(tree->nodes(),2*lo+1);
+    parallel_for(hi-lo,[&](const int i) {
+      const int node = lo+i;
+      Array<Vector<int,3>> node_faces;
+      Array<EV> node_X;
+      if (tree->is_leaf(node)) {
+        // Renumber the vertices used by the leaf's parts
+        Array<int> used;
+        for (const int p : tree->prims(node))
+          for (const int f : part_faces[p])
+            used.extend(faces.elements[f]);
+        sort(used);
+        used.resize(int(std::unique(used.begin(),used.end())-used.begin()));
+        for (const int p : tree->prims(node))
+          for (const int f : part_faces[p]) {
+            auto g = faces.elements[f];
+            for (auto& v : g)
+              v = int(std::lower_bound(used.begin(),used.end(),v)-used.begin());
+            node_faces.append(g);
+          }
+        node_X.resize(used.size(),uninit);
+        for (const int v : range(used.size()))
+          node_X[v] = X[used[v]];
+      } else {
+        for (const int c : tree->children(node)) {
+          auto& R = results[c];
+          const int offset = node_X.size();
+          for (const auto& f : R.faces)
+            node_faces.append(f+offset);
+          node_X.extend(R.X);
+          R = PartialUnion();
+        }
+      }
+      results[node] = union_one(node_faces,node_X);
+    });
+  }
+  return tuple(new_<const TriangleSoup>(results[0].faces),results[0].X);
+}
+
+Tuple<Ref<const TriangleSoup>,Array<TV>>
+union_soups(const TriangleSoup& faces, Array<const TV> X, Array<const int> parts, const int leaf_size) {
+  const auto quant = quantizer(bounding_box(X));
+  const auto S = exact_union_soups(faces,amap(quant,X).copy(),parts,leaf_size);
+  return tuple(S.x,amap(quant.inverse,S.y).copy());
+}
+
+GEODE_DEFINE_TYPE(MovingSoupCSG)
+
+struct MovingSoupCSG::State {
+  Array<const EV> X;
+  Ref<const SimplexTree<EV,2>> face_tree;
+  Ref<const SimplexTree<EV,1>> edge_tree;
+  Array<const EdgeFaceVertex> ef_vertices;
+};
+
+MovingSoupCSG::MovingSoupCSG(const TriangleSoup& faces, const Box<TV>& box)
+  : faces(ref(faces))
+  , box(box)
+  , quant(box)
+  , moved_faces_(0) {}
+
+MovingSoupCSG::~MovingSoupCSG() {}
+
+Tuple<Ref<const TriangleSoup>,Array<TV>>
+MovingSoupCSG::split(Array<const TV> X, Array<const int> depth_weight, const int depth) {
+  GEODE_ASSERT(faces->nodes()<=X.size());
+  GEODE_ASSERT(depth_weight.size()==faces->elements.size());
+  IntervalScope scope;
+  const Array<const EV> Q = amap(quant,X).copy();
+  const auto& edges = faces->segment_soup()->elements;
+  Tuple<Nested<const EdgeFaceVertex>,Array<const FaceFaceEdge>> A;
+  if (!state || state->X.size()!=Q.size()) {
+    const auto face_tree = new_<const SimplexTree<EV,2>>(faces,Q,1);
+    const auto edge_tree = new_<const SimplexTree<EV,1>>(faces->segment_soup(),Q,1);
+    A = intersection_simplices(face_tree,edge_tree);
+    state.reset(new State({Q,face_tree,edge_tree,A.x.flat}));
+    moved_faces_ = faces->elements.size();
+  } else {
+    // Refit the trees, and retest only pairs touching moved vertices
+    Array<bool> moved(Q.size(),uninit), moved_edges(edges.size(),uninit), moved_faces(faces->elements.size(),uninit);
+    for (const int v : range(Q.size()))
+      moved[v] = Q[v]!=state->X[v];
+    for (const int e : range(edges.size()))
+      moved_edges[e] = moved[edges[e].x] || moved[edges[e].y];
+    moved_faces_ = 0;
+    for (const int f : range(faces->elements.size())) {
+      const auto& v = faces->elements[f];
+      moved_faces_ += moved_faces[f] = moved[v.x] || moved[v.y] || moved[v.z];
+    }
+    const auto face_tree = new_<const SimplexTree<EV,2>>(*state->face_tree,Q);
+    const auto edge_tree = new_<const SimplexTree<EV,1>>(*state->edge_tree,Q);
+    const auto moved_edge_nodes = moved_nodes(*edge_tree,moved_edges),
+               moved_face_nodes = moved_nodes(*face_tree,moved_faces);
+    const CarriedIntersections carried = {moved_edges,moved_faces,moved_edge_nodes,moved_face_nodes,state->ef_vertices};
+    A = intersection_simplices(face_tree,edge_tree,&carried);
+    state.reset(new State({Q,face_tree,edge_tree,A.x.flat}));
+  }
+  const auto S = split_soup_simplices(state->face_tree,A.x,A.y,depth_weight,depth);
+  return tuple(S.x,amap(quant.inverse,S.y).copy());
+}
+
 // A random looking polynomial vector field for testing purposes.  Doing this in numpy was terribly slow.
 static TV signature(const TV p) {
   static const TV cs[20] = {{0.63579617566858204,0.9803866221230878,-1.1149781390749458},{-1.6911029843181062,0.0076849096251670494,-0.20902591156558492},{-0.32936081722995436,1.0215088816527711,-1.5612465562435749},{-0.45614229334747636,-0.70778970138794417,0.81221475328378245},{0.69508749936195235,0.36830278439721859,-0.023097745289497953},{-0.36041115257507639,0.084618397319454405,-0.62507343653099212},{-0.42001958405510559,0.58110444489126467,0.035872312121989956},{-1.0638801780427223,-1.4966105518400179,-0.46276143102821121},{-0.22713523028165017,-0.51887442706005649,-0.61617899144489152},{-0.01614627380526858,-1.0348875675622369,-2.0864245187665253},{0.34335366817123675,1.1129271600488675,0.030032754961424244},{-0.18700129596135318,0.57715102790126815,0.044064679264981095},{0.38502926178803099,0.93873127293758907,-0.024237498658405344},{0.405772588718322,0.27261261469141018,-1.3784370485864426},{0.033162792967982614,-0.53478654089645028,0.66062198865384403},{0.10747984116039729,0.50678316980726434,0.35782550032895966},{1.3356403638933552,0.01886685799296664,-0.92324588402595387},{-0.4121840452935373,0.25449626619085108,-0.1168890420360859},{-0.24743247723688286,0.6995835397565725,1.8017593723959369},{-2.1202767211585711,0.47120110220149913,0.088232150712609772}};
@@ -1484,14 +1998,26 @@ using namespace geode;
 
 void wrap_mesh_csg() {
   typedef Tuple<Ref<const TriangleSoup>,Array<Vec3>> (*split_fn)(const TriangleSoup&, Array<const Vector<double,3>>, const int);
-  GEODE_OVERLOADED_FUNCTION(split_fn,split_soup)
+  GEODE_FUNCTION_2(split_soup,without_gil((split_fn)split_soup))
   typedef Tuple<Ref<const TriangleSoup>,Array<exact::Vec3>> (*exact_split_fn)(const TriangleSoup&, Array<const exact::Vec3>, const int);
-  GEODE_OVERLOADED_FUNCTION(exact_split_fn,exact_split_soup)
+  GEODE_FUNCTION_2(exact_split_soup,without_gil((exact_split_fn)exact_split_soup))
 
   typedef Tuple<Ref<const TriangleSoup>,Array<Vec3>> (*split_depth_fn)(const TriangleSoup&, Array<const Vector<double,3>>, Array<const int>, const int);
-  GEODE_OVERLOADED_FUNCTION_2(split_depth_fn,"split_soup_with_weight",split_soup)
+  GEODE_FUNCTION_2(split_soup_with_weight,without_gil((split_depth_fn)split_soup))
   typedef Tuple<Ref<const TriangleSoup>,Array<exact::Vec3>> (*exact_split_depth_fn)(const TriangleSoup&, Array<const exact::Vec3>, Array<const int>, const int);
-  GEODE_OVERLOADED_FUNCTION_2(exact_split_depth_fn,"exact_split_soup_with_weight",exact_split_soup)
+  GEODE_FUNCTION_2(exact_split_soup_with_weight,without_gil((exact_split_depth_fn)exact_split_soup))
+  GEODE_FUNCTION_2(union_soups,without_gil(union_soups))
+  GEODE_FUNCTION_2(exact_union_soups,without_gil(exact_union_soups))
 
   GEODE_FUNCTION(mesh_signature)
+  {
+    typedef MovingSoupCSG Self;
+    Class<Self>("MovingSoupCSG")
+      .GEODE_INIT(const TriangleSoup&,const Box<TV>&)
+      .GEODE_FIELD(faces)
+      .GEODE_FIELD(box)
+      .GEODE_METHOD(split)
+      .GEODE_METHOD(moved_faces)
+      ;
+  }
 }
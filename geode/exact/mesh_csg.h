@@ -2,7 +2,9 @@
 #pragma once
 
 #include <geode/exact/config.h>
+#include <geode/exact/quantize.h>
 #include <geode/mesh/TriangleSoup.h>
+#include <geode/utility/Unique.h>
 namespace geode {
 
 // If depth is this, faces at all depths are returned
@@ -21,4 +23,45 @@ exact_split_soup(const TriangleSoup& faces, Array<const exact::Vec3> X, const in
 GEODE_CORE_EXPORT Tuple<Ref<const TriangleSoup>,Array<exact::Vec3>>
 exact_split_soup(const TriangleSoup& faces, Array<const exact::Vec3> X, Array<const int> depth_weights, const int depth);
 
+// Union many closed parts, where parts[f] is the part containing face f.  Parts are grouped by a box tree over their
+// bounds, and each tree node unions the outer boundaries of its children, in parallel across each level.  Interior
+// geometry is discarded at every level, so this is much cheaper than splitting the whole soup at once when parts are
+// numerous and overlap mostly with their neighbors.
+GEODE_CORE_EXPORT Tuple<Ref<const TriangleSoup>,Array<Vec3>>
+union_soups(const TriangleSoup& faces, Array<const Vector<double,3>> X, Array<const int> parts, const int leaf_size=4);
+
+GEODE_CORE_EXPORT Tuple<Ref<const TriangleSoup>,Array<exact::Vec3>>
+exact_union_soups(const TriangleSoup& faces, Array<const exact::Vec3> X, Array<const int> parts, const int leaf_size=4);
+
+// MovingSoupCSG runs split_soup repeatedly on a soup whose topology is fixed and whose vertices move between calls.
+// The face and edge trees are kept between calls and refit to the new positions, and edge-face intersections between
+// simplices with no moved vertices are carried forward, so intersection finding costs about the amount of motion.
+// Retriangulation and depth computation still visit the whole soup.  The quantizer is fixed by a box declared up
+// front, so every vertex must stay inside it, and a vertex counts as moved if its quantized position changes.
+class MovingSoupCSG : public Object {
+public:
+  GEODE_DECLARE_TYPE(GEODE_CORE_EXPORT)
+  typedef Object Base;
+
+  const Ref<const TriangleSoup> faces;
+  const Box<Vector<real,3>> box;
+private:
+  struct State;
+  const Quantizer<real,3> quant;
+  Unique<State> state;
+  int moved_faces_;
+
+protected:
+  GEODE_CORE_EXPORT MovingSoupCSG(const TriangleSoup& faces, const Box<Vector<real,3>>& box);
+public:
+  ~MovingSoupCSG();
+
+  // Split the soup at the given positions, as split_soup_with_weight would
+  GEODE_CORE_EXPORT Tuple<Ref<const TriangleSoup>,Array<Vector<real,3>>>
+  split(Array<const Vector<real,3>> X, Array<const int> depth_weight, const int depth);
+
+  // Number of faces with a moved vertex in the last call to split (all faces on the first call)
+  int moved_faces() const { return moved_faces_; }
+};
+
 }
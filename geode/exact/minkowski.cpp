@@ -0,0 +1,251 @@
+// Minkowski sums and no-fit polygons via polygon convolution
+
+#include <geode/exact/minkowski.h>
+#include <geode/exact/polygon_csg.h>
+#include <geode/exact/quantize.h>
+#include <geode/array/amap.h>
+#include <geode/array/Nested.h>
+#include <geode/array/sort.h>
+#include <geode/geometry/polygon.h>
+#include <geode/python/Class.h>
+#include <geode/utility/parallel.h>
+#include <geode/vector/Rotation.h>
+#include <geode/vector/transform.h>
+namespace geode {
+
+using std::vector;
+typedef Vector<ExactInt,2> IV;
+
+// A contour quantized relative to its first vertex, with repeated points removed
+static Array<IV> relative_contour(const Quantizer<real,2>& quant, RawArray<const Vec2> poly) {
+  Array<IV> X;
+  for (const auto& p : poly) {
+    const IV x(floor(quant.scale*(p-poly[0])+.5));
+    if (!X.size() || X.back()!=x)
+      X.append(x);
+  }
+  while (X.size()>1 && X.back()==X[0])
+    X.pop();
+  return X;
+}
+
+static inline __int128 cross(const IV a, const IV b) {
+  return __int128(a.x)*b.y-__int128(a.y)*b.x;
+}
+
+// Exact angular order of nonzero directions, starting from the positive x axis
+static inline bool direction_less(const IV a, const IV b) {
+  const bool ha = a.y<0 || (!a.y && a.x<0),
+             hb = b.y<0 || (!b.y && b.x<0);
+  return ha!=hb ? hb : cross(a,b)>0;
+}
+
+namespace {
+struct ConvolutionContour {
+  RawArray<const IV> X;
+  Array<int> rank; // Rank of each edge direction among both contours
+  Array<int> by_rank; // Edges sorted by rank
+
+  int n() const { return X.size(); }
+  IV edge(const int i) const { return X[(i+1)%n()]-X[i]; }
+
+  // Call f(e) for each edge e with rank in the counterclockwise open interval (r0,r1)
+  template<class F> void cyclic_range(const int r0, const int r1, const F& f) const {
+    const auto after = [&](const int r) {
+      return int(std::upper_bound(by_rank.begin(),by_rank.end(),r,[&](const int r, const int e) {
+        return r<rank[e]; })-by_rank.begin()); };
+    const int lo = after(r0), hi = after(r1);
+    if (r0<r1)
+      for (int k=lo;k<hi;k++)
+        f(by_rank[k]);
+    else {
+      for (int k=lo;k<by_rank.size();k++)
+        f(by_rank[k]);
+      for (int k=0;k<hi;k++)
+        f(by_rank[k]);
+    }
+  }
+
+  // The directions swept turning from edge i-1 to edge i at vertex i: (r0,r1) counterclockwise if sign>0,
+  // clockwise otherwise.
+  Tuple<int,int,int> sweep(const int i) const {
+    const int h = (i+n()-1)%n();
+    const IV a = edge(h), b = edge(i);
+    const auto c = cross(a,b);
+    const int r0 = rank[h], r1 = rank[i];
+    const int sign = c>0 ? 1 : c<0 ? -1 : dot(a,b)<0 ? 1 : r0<r1 ? 1 : -1;
+    return tuple(r0,r1,sign);
+  }
+};
+}
+
+// Append the closed cycles of the convolution of two contours to cycles, as quantized points offset by base
+static void convolve(const IV base, RawArray<const IV> A, RawArray<const IV> B, Nested<Vec2,false>& cycles) {
+  ConvolutionContour C[2] = {{A},{B}};
+  {
+    Array<Vector<int,2>> edges; // (contour,edge)
+    for (const int c : range(2))
+      for (const int i : range(C[c].n()))
+        edges.append(vec(c,i));
+    sort(edges,[&](const Vector<int,2> e, const Vector<int,2> f) {
+      const IV de = C[e.x].edge(e.y), df = C[f.x].edge(f.y);
+      return direction_less(de,df) || (!direction_less(df,de) && lex_less(e,f));
+    });
+    for (const int c : range(2)) {
+      C[c].rank.resize(C[c].n());
+      C[c].by_rank.preallocate(C[c].n());
+    }
+    for (const int r : range(edges.size())) {
+      const auto e = edges[r];
+      C[e.x].rank[e.y] = r;
+      C[e.x].by_rank.append(e.y);
+    }
+  }
+
+  // Convolution segments between vertices (i,j) standing for A[i]+B[j]
+  Hashtable<Vector<int,2>,int> ids;
+  Array<Vector<int,2>> verts;
+  const auto id = [&](const int i, const int j) {
+    const auto v = vec(i%C[0].n(),j%C[1].n());
+    int& k = ids.get_or_insert(v,-1);
+    if (k<0) {
+      k = verts.size();
+      verts.append(v);
+    }
+    return k;
+  };
+  Array<Vector<int,2>> segments;
+  for (const int c : range(2)) {
+    const auto& S = C[c];
+    const auto& O = C[1-c];
+    for (const int i : range(S.n())) {
+      const auto s = S.sweep(i);
+      const int r0 = s.z>0 ? s.x : s.y, r1 = s.z>0 ? s.y : s.x;
+      O.cyclic_range(r0,r1,[&](const int e) {
+        const int a = c ? id(e,i) : id(i,e),
+                  b = c ? id(e+1,i) : id(i,e+1);
+        segments.append(s.z>0 ? vec(a,b) : vec(b,a));
+      });
+    }
+  }
+
+  // Every convolution vertex is balanced, so greedily walking unused segments closes into cycles
+  const int nv = verts.size();
+  Array<int> degree(nv+1);
+  for (const auto& s : segments) {
+    degree[s.x+1]++;
+    degree[s.y+1]--;
+  }
+  for (const int v : range(nv))
+    GEODE_ASSERT(!degree[v+1],"minkowski_sum: unbalanced convolution");
+  Array<int> offsets(nv+1);
+  for (const auto& s : segments)
+    offsets[s.x+1]++;
+  for (const int v : range(nv))
+    offsets[v+1] += offsets[v];
+  Array<int> out(segments.size(),uninit), next = offsets.slice(0,nv).copy();
+  for (const auto& s : segments)
+    out[next[s.x]++] = s.y;
+  next = offsets.slice(0,nv).copy();
+  Array<Vec2> cycle;
+  for (const int start : range(nv))
+    while (next[start]<offsets[start+1]) {
+      cycle.clear();
+      int v = start;
+      do {
+        const auto ij = verts[v];
+        cycle.append(Vec2(base+A[ij.x]+B[ij.y]));
+        v = out[next[v]++];
+      } while (v!=start);
+      if (cycle.size()>2) // Two segment cycles cancel
+        cycles.append(cycle);
+    }
+}
+
+Nested<Vec2> minkowski_sum(Nested<const Vec2> A, Nested<const Vec2> B) {
+  if (!A.size() || !B.size())
+    return Nested<Vec2>();
+  for (const auto polys : {A,B})
+    for (const int p : range(polys.size()))
+      GEODE_ASSERT(polygon_area(polys[p])>=0,"minkowski_sum: polygons must be counterclockwise without holes");
+  const auto boxA = bounding_box(A.flat),
+             boxB = bounding_box(B.flat);
+  const auto quant = quantizer(Box<Vec2>(boxA.min+boxB.min,boxA.max+boxB.max));
+
+  // Convolve every pair of contours, and resolve them all in one pass
+  Nested<Vec2,false> cycles;
+  for (const int a : range(A.size()))
+    for (const int b : range(B.size())) {
+      if (A.size(a)<3 || B.size(b)<3)
+        continue;
+      const IV base(quant(A(a,0)+B(b,0)));
+      const auto ia = relative_contour(quant,A[a]),
+                 ib = relative_contour(quant,B[b]);
+      if (ia.size()>=3 && ib.size()>=3)
+        convolve(base,ia,ib,cycles);
+    }
+  return amap(quant.inverse,exact_split_polygons_with_rule(cycles.freeze(),0,FillRule::Greater));
+}
+
+Nested<Vec2> no_fit_polygon(Nested<const Vec2> fixed, Nested<const Vec2> moving) {
+  return minkowski_sum(fixed,Nested<const Vec2>(moving.offsets,(-moving.flat).copy()));
+}
+
+GEODE_DEFINE_TYPE(NoFitPolygonCache)
+
+NoFitPolygonCache::NoFitPolygonCache() {}
+
+NoFitPolygonCache::~NoFitPolygonCache() {}
+
+int NoFitPolygonCache::add(Nested<const Vec2> polys) {
+  parts.push_back(polys);
+  return size()-1;
+}
+
+Nested<Vec2> NoFitPolygonCache::compute(const Tuple<int,int,real>& key) const {
+  GEODE_ASSERT(unsigned(key.x)<parts.size() && unsigned(key.y)<parts.size());
+  const auto& moving = parts[key.y];
+  return no_fit_polygon(parts[key.x],
+    key.z ? Nested<const Vec2>(moving.offsets,transformed(Rotation<Vec2>::from_angle(key.z),moving.flat)) : moving);
+}
+
+Nested<const Vec2> NoFitPolygonCache::nfp(const int fixed, const int moving, const real angle) {
+  const auto key = tuple(fixed,moving,angle);
+  if (const auto* p = cache.get_pointer(key))
+    return *p;
+  const Nested<const Vec2> result = compute(key);
+  cache.set(key,result);
+  return result;
+}
+
+void NoFitPolygonCache::precompute(RawArray<const Vector<int,2>> pairs, RawArray<const real> angles) {
+  Hashtable<Tuple<int,int,real>> seen;
+  Array<Tuple<int,int,real>> missing;
+  for (const auto& p : pairs)
+    for (const real a : angles) {
+      const auto key = tuple(p.x,p.y,a);
+      if (!cache.contains(key) && seen.set(key))
+        missing.append(key);
+    }
+  vector<Nested<const Vec2>> results(missing.size());
+  parallel_for(missing.size(),[&](const int k) { results[k] = compute(missing[k]); },1);
+  for (const int k : range(missing.size()))
+    cache.set(missing[k],results[k]);
+}
+
+}
+using namespace geode;
+
+void wrap_minkowski() {
+  GEODE_FUNCTION(minkowski_sum)
+  GEODE_FUNCTION(no_fit_polygon)
+  typedef NoFitPolygonCache Self;
+  Class<Self>("NoFitPolygonCache")
+    .GEODE_INIT()
+    .GEODE_METHOD(add)
+    .GEODE_METHOD(size)
+    .GEODE_METHOD(cached)
+    .GEODE_METHOD(nfp)
+    .GEODE_METHOD(precompute)
+    ;
+}
@@ -0,0 +1,60 @@
+// Minkowski sums and no-fit polygons via polygon convolution
+#pragma once
+
+// The convolution of two counterclockwise polygons A and B is the set of segments a+e and e'+b for vertices a,b and
+// edges e,e' whose directions lie in the angular range swept at the other polygon's vertex, reversed at reflex
+// vertices.  These segments form closed cycles, and the winding number of the cycles at x counts the components of
+// the intersection of A and x-B, so A+B is exactly the region of positive winding.  We build the convolution with
+// exact integer direction tests on quantized edges and resolve it with one exact_split_polygons_with_rule pass,
+// instead of a union over every pair of convex pieces.
+//
+// Inputs are sets of disjoint simple counterclockwise polygons without holes, for which the winding number is never
+// negative.  With holes, the intersection can be an annulus and the winding number undercounts.
+
+#include <geode/array/Nested.h>
+#include <geode/python/Object.h>
+#include <geode/structure/Hashtable.h>
+#include <geode/structure/Triple.h>
+#include <vector>
+namespace geode {
+
+// The Minkowski sum A+B = {a+b | a in A, b in B}
+GEODE_CORE_EXPORT Nested<Vec2> minkowski_sum(Nested<const Vec2> A, Nested<const Vec2> B);
+
+// The no-fit polygon of moving against fixed: the positions of moving's origin at which moving overlaps fixed.
+// On its boundary the two touch.  Equal to minkowski_sum(fixed,-moving).
+GEODE_CORE_EXPORT Nested<Vec2> no_fit_polygon(Nested<const Vec2> fixed, Nested<const Vec2> moving);
+
+// A set of parts with cached no-fit polygons for each (fixed part, moving part, rotation of moving part)
+class NoFitPolygonCache : public Object {
+public:
+  GEODE_DECLARE_TYPE(GEODE_CORE_EXPORT)
+  typedef Object Base;
+
+private:
+  std::vector<Nested<const Vec2>> parts;
+  Hashtable<Tuple<int,int,real>,Nested<const Vec2>> cache;
+
+protected:
+  GEODE_CORE_EXPORT NoFitPolygonCache();
+public:
+  ~NoFitPolygonCache();
+
+  // Add a part, returning its id
+  GEODE_CORE_EXPORT int add(Nested<const Vec2> polys);
+
+  int size() const { return int(parts.size()); }
+  int cached() const { return cache.size(); }
+
+  // The no-fit polygon of moving rotated by angle (radians, about its origin) against the unrotated fixed part.
+  // For a fixed part placed under a rotation r, rotate the result by r and use angle = moving rotation - r.
+  GEODE_CORE_EXPORT Nested<const Vec2> nfp(const int fixed, const int moving, const real angle);
+
+  // Compute and cache all missing no-fit polygons for the given (fixed,moving) pairs and angles, in parallel
+  GEODE_CORE_EXPORT void precompute(RawArray<const Vector<int,2>> pairs, RawArray<const real> angles);
+
+private:
+  Nested<Vec2> compute(const Tuple<int,int,real>& key) const;
+};
+
+}
@@ -8,10 +8,15 @@ void wrap_exact() {
   GEODE_WRAP(interval)
   GEODE_WRAP(exact_exact)
   GEODE_WRAP(perturb)
+  GEODE_WRAP(exact_stats)
   GEODE_WRAP(predicates)
+  GEODE_WRAP(collision)
   GEODE_WRAP(constructions)
   GEODE_WRAP(delaunay)
   GEODE_WRAP(polygon_csg)
+  GEODE_WRAP(incremental_polygon_csg)
+  GEODE_WRAP(polygon_arrangement)
+  GEODE_WRAP(minkowski)
   GEODE_WRAP(circle_csg)
   GEODE_WRAP(simple_triangulate)
   GEODE_WRAP(mesh_csg)
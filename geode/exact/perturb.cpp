@@ -81,6 +81,164 @@ template<int m> inline Vector<ExactInt,m> perturbation(const int level, const ex
 template<int m> inline Vector<ExactInt,m> perturbation(const int level, const exact::Perturbed<2>::ValueType seed) { return packed_perturbation<m>(level, seed); }
 template<int m> inline Vector<ExactInt,m> perturbation(const int level, const exact::Perturbed<3>::ValueType seed) { return packed_perturbation<m>(level, seed); }
 
+/********** Scratch memory **********/
+
+// Degenerate heavy inputs (e.g., grid aligned CAD data) call perturbed_sign and perturbed_ratio constantly, so
+// instead of allocating on each call we carve scratch arrays out of a reusable per-thread arena.  Allocations are
+// released in stack order by ArenaFrame.  If a frame overflows the current block we chain a new block, and once
+// the outermost frame exits we consolidate into a single block of the high water size so that steady state use
+// never allocates.  The arena must be plain old data to be GEODE_THREAD_LOCAL, so its memory lives until exit.
+
+namespace {
+struct ArenaBlock {
+  ArenaBlock* prev; // Next older block
+  size_t size; // Usable bytes following the header
+};
+
+struct Arena {
+  ArenaBlock* block; // Newest block
+  size_t used; // Bytes used in the newest block
+  size_t below; // Bytes used in older blocks
+  size_t high_water; // Most bytes ever in use at once
+  int depth; // Number of live frames
+};
+}
+static GEODE_THREAD_LOCAL Arena arena;
+
+static const size_t arena_align = 16;
+static const size_t arena_header = (sizeof(ArenaBlock)+arena_align-1)&~(arena_align-1);
+
+static ArenaBlock* new_arena_block(ArenaBlock* prev, const size_t size) {
+  const auto block = (ArenaBlock*)malloc(arena_header+size);
+  if (!block)
+    throw std::bad_alloc();
+  block->prev = prev;
+  block->size = size;
+  return block;
+}
+
+namespace {
+struct ArenaFrame {
+  ArenaBlock* const block;
+  const size_t used, below;
+
+  ArenaFrame()
+    : block(arena.block), used(arena.used), below(arena.below) {
+    arena.depth++;
+  }
+
+  ~ArenaFrame() {
+    // Release blocks chained during this frame
+    while (arena.block != block) {
+      const auto prev = arena.block->prev;
+      free(arena.block);
+      arena.block = prev;
+    }
+    arena.used = used;
+    arena.below = below;
+    // Once the arena is idle, make sure a single block fits the high water mark
+    if (!--arena.depth && (arena.block ? arena.block->size : 0) < arena.high_water) {
+      free(arena.block);
+      arena.block = new_arena_block(0,arena.high_water);
+    }
+  }
+
+  template<class T> RawArray<T> alloc(const int n) const {
+    static_assert(alignof(T)<=arena_align && is_trivially_destructible<T>::value,"");
+    const size_t bytes = (sizeof(T)*n+arena_align-1)&~(arena_align-1);
+    if (!arena.block || arena.used+bytes > arena.block->size) {
+      arena.block = new_arena_block(arena.block,max(bytes,2*(arena.below+arena.used)));
+      arena.below += arena.used;
+      arena.used = 0;
+    }
+    const auto p = (T*)((char*)arena.block+arena_header+arena.used);
+    arena.used += bytes;
+    arena.high_water = max(arena.high_water,arena.below+arena.used);
+    return RawArray<T>(n,p);
+  }
+};
+}
+
+size_t perturb_arena_high_water() {
+  return arena.high_water;
+}
+
+/********** Memoization **********/
+
+static GEODE_THREAD_LOCAL PerturbCache* perturb_cache = 0;
+static const int cache_stride = 2+PerturbCache::max_key_words;
+
+PerturbCache::PerturbCache(const int log_size)
+  : hits(0), misses(0), outer(perturb_cache), log_size(log_size), table(cache_stride<<log_size) {
+  GEODE_ASSERT(unsigned(log_size)<=24);
+  perturb_cache = this;
+}
+
+PerturbCache::~PerturbCache() {
+  assert(perturb_cache==this);
+  perturb_cache = outer;
+}
+
+PerturbCache* PerturbCache::current() {
+  return perturb_cache;
+}
+
+static inline uint64_t cache_hash(RawArray<const uint64_t> key) {
+  uint64_t h = 0;
+  for (const auto k : key)
+    h = cast_uint128<uint64_t>(threefry(h,k));
+  return h|1; // Empty entries have hash zero
+}
+
+int PerturbCache::lookup(RawArray<const uint64_t> key) {
+  assert(key.size()<=max_key_words);
+  const auto h = cache_hash(key);
+  const auto e = &table[cache_stride*(h&((1<<log_size)-1))];
+  if (   e[0]==h && int(e[1]>>1)==key.size()
+      && !memcmp(e+2,key.data(),sizeof(uint64_t)*key.size())) {
+    hits++;
+    return e[1]&1;
+  }
+  misses++;
+  return -1;
+}
+
+void PerturbCache::insert(RawArray<const uint64_t> key, const bool sign) {
+  assert(key.size()<=max_key_words);
+  const auto h = cache_hash(key);
+  const auto e = &table[cache_stride*(h&((1<<log_size)-1))];
+  e[0] = h;
+  e[1] = uint64_t(key.size())<<1|sign;
+  memcpy(e+2,key.data(),sizeof(uint64_t)*key.size());
+}
+
+// Append the bytes of a seed or value to a cache key, zero padded to whole words
+template<class T> static inline void append_key(uint64_t*& key, const T& x) {
+  const int words = (sizeof(T)+sizeof(uint64_t)-1)/sizeof(uint64_t);
+  key[words-1] = 0;
+  memcpy(key,&x,sizeof(T));
+  key += words;
+}
+
+// Build the cache key for a perturbed_sign call, returning an empty array if it is too large to cache
+template<class PerturbedT> static RawArray<const uint64_t>
+perturbed_sign_key(RawArray<uint64_t> buffer, void(*const predicate)(RawArray<mp_limb_t>,RawArray<const Vector<Exact<1>,PerturbedT::m>>),
+                   const int degree, RawArray<const PerturbedT> X) {
+  const int per = (sizeof(X[0].seed())+7)/8+(sizeof(X[0].value())+7)/8;
+  const int words = 2+per*X.size();
+  if (words>buffer.size())
+    return RawArray<const uint64_t>();
+  auto key = buffer.data();
+  *key++ = uint64_t(uintptr_t(predicate));
+  *key++ = uint64_t(degree)<<32|X.size();
+  for (const auto& x : X) {
+    append_key(key,x.seed());
+    append_key(key,x.value());
+  }
+  assert(key==buffer.data()+words);
+  return buffer.slice(0,words);
+}
+
 /********** Symbolic perturbation **********/
 
 template<int m> static inline Vector<ExactInt,m> to_exact(const Vector<Quantized,m>& x) {
@@ -121,7 +279,7 @@ assert_last_nonzero(void(*const polynomial)(R,RawArray<const Vector<Exact<1>,Per
 }
 
 template<class PerturbedT> bool perturbed_sign(void(*const predicate)(RawArray<mp_limb_t>,RawArray<const Vector<Exact<1>,PerturbedT::m>>),
-                                                      const int degree, RawArray<const PerturbedT> X) {
+                                                      const int degree, RawArray<const PerturbedT> X, const bool known_zero) {
   const int m = PerturbedT::m;
   typedef Vector<Exact<1>,m> EV;
   if (check)
@@ -132,21 +290,44 @@ template<class PerturbedT> bool perturbed_sign(void(*const predicate)(RawArray<m
     cout << "perturbed_sign:\n  degree = "<<degree<<"\n  X = "<<X<<endl;
 
   // Check if the predicate is nonsingular without perturbation
-  const auto Z = GEODE_RAW_ALLOCA(n,EV);
+  const ArenaFrame frame;
+  const auto Z = frame.alloc<EV>(n);
   const int precision = degree*Exact<1>::ratio;
-  {
+  if (!known_zero || check) {
     for (int i=0;i<n;i++)
       Z[i] = EV(to_exact(X[i].value()));
-    const auto R = GEODE_RAW_ALLOCA(precision,mp_limb_t);
+    const auto R = frame.alloc<mp_limb_t>(precision);
     predicate(R,Z);
-    if (const int sign = mpz_sign(R))
+    const int sign = mpz_sign(R);
+    if (check && known_zero)
+      GEODE_ASSERT(!sign,"perturbed_sign: predicate claimed to be zero is not");
+    if (sign) {
+      GEODE_EXACT_STAGE(0);
       return sign>0;
+    }
+  }
+
+  // If a cache is active, look for a previous evaluation of the same degenerate configuration
+  const auto cache = perturb_cache;
+  const auto key = cache ? perturbed_sign_key(frame.alloc<uint64_t>(PerturbCache::max_key_words),predicate,degree,X)
+                         : RawArray<const uint64_t>();
+  if (key.size()) {
+    const int cached = cache->lookup(key);
+    if (cached>=0) {
+      GEODE_EXACT_STAGE(-1);
+      return cached;
+    }
   }
+  const auto remember = [=](const bool sign) {
+    if (key.size())
+      cache->insert(key,sign);
+    return sign;
+  };
 
   // Check the first perturbation level with specialized code
-  vector<Vector<ExactInt,m>> Y(n); // perturbations
   {
     // Compute the first level of perturbations
+    const auto Y = frame.alloc<Vector<ExactInt,m>>(n);
     for (int i=0;i<n;i++)
       Y[i] = perturbation<m>(1,X[i].seed());
     if (verbose)
@@ -154,7 +335,7 @@ template<class PerturbedT> bool perturbed_sign(void(*const predicate)(RawArray<m
 
     // Evaluate polynomial at epsilon = 1, ..., degree
     const int scaled_precision = precision+factorial_limbs(degree);
-    const auto values = GEODE_RAW_ALLOCA(degree*scaled_precision,mp_limb_t).reshape(degree,scaled_precision);
+    const auto values = frame.alloc<mp_limb_t>(degree*scaled_precision).reshape(degree,scaled_precision);
     memset(values.data(),0,sizeof(mp_limb_t)*values.flat.size());
     for (int j=0;j<degree;j++) {
       for (int i=0;i<n;i++)
@@ -171,8 +352,10 @@ template<class PerturbedT> bool perturbed_sign(void(*const predicate)(RawArray<m
 
     // Compute sign
     for (int j=0;j<degree;j++)
-      if (const int sign = mpz_sign(values[j]))
-        return sign>0;
+      if (const int sign = mpz_sign(values[j])) {
+        GEODE_EXACT_STAGE(1);
+        return remember(sign>0);
+      }
   }
 
   {
@@ -181,14 +364,15 @@ template<class PerturbedT> bool perturbed_sign(void(*const predicate)(RawArray<m
     for (int d=2;;d++) {
       if (verbose)
         cout << "  level "<<d<<endl;
-      // Compute the next level of perturbations
-      Y.resize(d*n);
-      for (int i=0;i<n;i++)
-        Y[(d-1)*n+i] = perturbation<m>(d,X[i].seed());
+      // Compute all perturbations up to this level
+      const auto Y = frame.alloc<Vector<ExactInt,m>>(d*n);
+      for (int v=0;v<d;v++)
+        for (int i=0;i<n;i++)
+          Y[v*n+i] = perturbation<m>(v+1,X[i].seed());
 
       // Evaluate polynomial at every point in an "easy corner"
       const auto lambda = monomials(degree,d);
-      const Array<mp_limb_t,2> values(lambda.m,precision,uninit);
+      const auto values = frame.alloc<mp_limb_t>(lambda.m*precision).reshape(lambda.m,precision);
       for (int j=0;j<lambda.m;j++) {
         for (int i=0;i<n;i++)
           Z[i] = EV(to_exact(X[i].value())+lambda(j,0)*Y[i]);
@@ -215,8 +399,10 @@ template<class PerturbedT> bool perturbed_sign(void(*const predicate)(RawArray<m
         }
 
       // If we find a nonzero sign, we're done!
-      if (sign)
-        return sign>0;
+      if (sign) {
+        GEODE_EXACT_STAGE(d);
+        return remember(sign>0);
+      }
 
       // If we get through two levels without fixing the degeneracy, run a fast, strict identity test to make sure we weren't handed an impossible problem.
       if (d==2)
@@ -331,12 +517,13 @@ template<class PerturbedT> bool perturbed_ratio(RawArray<Quantized> result, void
     cout << "perturbed_ratio:\n  degree = "<<degree<<"\n  X = "<<X<<endl;
 
   // Check if the ratio is nonsingular before perturbation
-  const auto Z = GEODE_RAW_ALLOCA(n,EV);
+  const ArenaFrame frame;
+  const auto Z = frame.alloc<EV>(n);
   const int precision = degree*Exact<1>::ratio;
   {
     for (int i=0;i<n;i++)
       Z[i] = EV(to_exact(X[i].value()));
-    const auto R = GEODE_RAW_ALLOCA((r+1)*precision,mp_limb_t).reshape(r+1,precision);
+    const auto R = frame.alloc<mp_limb_t>((r+1)*precision).reshape(r+1,precision);
     ratio(R,Z);
     if (const int sign = mpz_sign(R[r])) {
       snap_divs(result,R,take_sqrt);
@@ -345,9 +532,9 @@ template<class PerturbedT> bool perturbed_ratio(RawArray<Quantized> result, void
   }
 
   // Check the first perturbation level with specialized code
-  vector<Vector<ExactInt,m>> Y(n); // perturbations
   {
     // Compute the first level of perturbations
+    const auto Y = frame.alloc<Vector<ExactInt,m>>(n);
     for (int i=0;i<n;i++)
       Y[i] = perturbation<m>(1,X[i].seed());
     if (verbose)
@@ -355,7 +542,7 @@ template<class PerturbedT> bool perturbed_ratio(RawArray<Quantized> result, void
 
     // Evaluate polynomial at epsilon = 1, ..., degree
     const int scaled_precision = precision+factorial_limbs(degree);
-    const auto values = GEODE_RAW_ALLOCA(degree*(r+1)*scaled_precision,mp_limb_t).reshape(degree,r+1,scaled_precision);
+    const auto values = frame.alloc<mp_limb_t>(degree*(r+1)*scaled_precision).reshape(degree,r+1,scaled_precision);
     for (int j=0;j<degree;j++) {
       for (int i=0;i<n;i++)
         Z[i] = EV(to_exact(X[i].value())+(j+1)*Y[i]);
@@ -387,14 +574,15 @@ template<class PerturbedT> bool perturbed_ratio(RawArray<Quantized> result, void
     // Add one perturbation level after another until we hit a nonzero denominator.  Our current implementation duplicates
     // work from one iteration to the next for simplicity, which is fine since the first interation suffices almost always.
     for (int d=2;;d++) {
-      // Compute the next level of perturbations
-      Y.resize(d*n);
-      for (int i=0;i<n;i++)
-        Y[(d-1)*n+i] = perturbation<m>(d,X[i].seed());
+      // Compute all perturbations up to this level
+      const auto Y = frame.alloc<Vector<ExactInt,m>>(d*n);
+      for (int v=0;v<d;v++)
+        for (int i=0;i<n;i++)
+          Y[v*n+i] = perturbation<m>(v+1,X[i].seed());
 
       // Evaluate polynomial at every point in an "easy corner"
       const auto lambda = monomials(degree,d);
-      const Array<mp_limb_t,3> values(lambda.m,r+1,precision,uninit);
+      const auto values = frame.alloc<mp_limb_t>(lambda.m*(r+1)*precision).reshape(lambda.m,r+1,precision);
       for (int j=0;j<lambda.m;j++) {
         for (int i=0;i<n;i++)
           Z[i] = EV(to_exact(X[i].value())+lambda(j,0)*Y[i]);
@@ -530,6 +718,21 @@ template<int m> static void perturbed_sign_test() {
     }
 }
 
+// Rerun the degenerate tests with memoization, using caches large enough to hit and small enough to evict
+static void perturb_cache_test() {
+  for (const int log_size : vec(0,10)) {
+    PerturbCache cache(log_size);
+    GEODE_ASSERT(PerturbCache::current()==&cache);
+    for (int round=0;round<2;round++) {
+      perturbed_sign_test<1>();
+      perturbed_sign_test<2>();
+    }
+    GEODE_ASSERT(cache.misses);
+    GEODE_ASSERT(log_size ? 2*cache.hits>cache.misses : cache.hits<cache.misses);
+  }
+  GEODE_ASSERT(!PerturbCache::current());
+}
+
 // The unit tests in constructions.cpp and circle_csg.cpp are fairly rigorous checks of the geometric validity
 // perturbed ratio to levels 0 and 1, but are unlikely to ever hit perturbation level 2 or higher.  Therefore,
 // we construct and test a malicious predicate guaranteed to hit level 2.
@@ -573,9 +776,9 @@ static void perturbed_ratio_test() {
   template Vector<ExactInt,m> perturbation(const int, const int); \
   template Vector<ExactInt,m> packed_perturbation(const int, const Vector<Quantized,m>); \
   template bool perturbed_sign(void(*const)(RawArray<mp_limb_t>,RawArray<const Vector<Exact<1>,m>>), \
-                                            const int, RawArray<const exact::Perturbed<m>>); \
+                                            const int, RawArray<const exact::Perturbed<m>>, const bool); \
   template bool perturbed_sign(void(*const)(RawArray<mp_limb_t>,RawArray<const Vector<Exact<1>,m>>), \
-                                            const int, RawArray<const exact::ImplicitlyPerturbed<m>>); \
+                                            const int, RawArray<const exact::ImplicitlyPerturbed<m>>, const bool); \
   template bool perturbed_ratio(RawArray<Quantized>,void(*const)(RawArray<mp_limb_t,2>, \
                                 RawArray<const Vector<Exact<1>,m>>), const int, \
                                 RawArray<const exact::Perturbed<m>>, bool); \
@@ -587,7 +790,7 @@ INSTANTIATE(2)
 INSTANTIATE(3)
 
 template bool perturbed_sign(void(*const)(RawArray<mp_limb_t>,RawArray<const Vector<Exact<1>,2>>), const int,
-                             RawArray<const exact::ImplicitlyPerturbedCenter>);
+                             RawArray<const exact::ImplicitlyPerturbedCenter>, const bool);
 }
 using namespace geode;
 
@@ -597,4 +800,6 @@ void wrap_perturb() {
   GEODE_FUNCTION_2(perturbed_sign_test_3,perturbed_sign_test<3>)
   GEODE_FUNCTION(snap_divs_test)
   GEODE_FUNCTION(perturbed_ratio_test)
+  GEODE_FUNCTION(perturb_arena_high_water)
+  GEODE_FUNCTION(perturb_cache_test)
 }
@@ -6,11 +6,16 @@
 #include <geode/exact/Exact.h>
 #include <geode/exact/Interval.h>
 #include <geode/exact/irreducible.h>
+#include <geode/exact/stats.h>
 #include <geode/structure/Tuple.h>
 #include <geode/utility/IRange.h>
+#include <geode/utility/forward.h>
 #include <geode/vector/Vector.h>
+#include <vector>
 namespace geode {
 
+using std::vector;
+
 // sys/termios.h on Mac was defining B0 as a macro.  Don't.
 #undef B0
 
@@ -21,9 +26,11 @@ namespace geode {
 //
 // Identically zero polynomials are zero regardless of perturbation; these are detected and an exception is thrown.
 // predicate should compute a quantity of type Exact<degree>, then copy it into result with mpz_set.
+// If known_zero is true, the caller has already proven that predicate(X) = 0 exactly (e.g., via a point interval),
+// and the unperturbed exact evaluation is skipped.
 template<class PerturbedT> GEODE_CORE_EXPORT GEODE_COLD bool
 perturbed_sign(void(*const predicate)(RawArray<mp_limb_t>,RawArray<const Vector<Exact<1>,PerturbedT::m>>),
-               const int degree, RawArray<const PerturbedT> X);
+               const int degree, RawArray<const PerturbedT> X, const bool known_zero=false);
 
 // Given polynomial numerator and denominator functions, evaluate numerator(X+epsilon)/denominator(X+epsilon) rounded
 // to int for the same infinitesimal perturbation epsilon as in perturbed_sign.  The numerator and denominator must be
@@ -45,6 +52,35 @@ perturbed_ratio(RawArray<Quantized> result,
                 void(*const ratio)(RawArray<mp_limb_t,2>,RawArray<const Vector<Exact<1>,PerturbedT::m>>),
                 const int degree, RawArray<const PerturbedT> X, const bool take_sqrt=false);
 
+// perturbed_sign and perturbed_ratio draw scratch memory from a per-thread arena which is reused across calls.
+// Return the most bytes the calling thread's arena has needed at once.
+GEODE_CORE_EXPORT size_t perturb_arena_high_water();
+
+// While a PerturbCache is alive, degenerate perturbed_sign results on the constructing thread are memoized in a
+// bounded direct mapped table keyed by the predicate, degree, and exact inputs (seeds and values).  This short
+// circuits repeated evaluation of the same degenerate configuration within one operation, such as Delaunay flips.
+// Caches nest, with the innermost active, and must be destroyed on the thread that created them.  Results are
+// identical with or without a cache.
+struct PerturbCache : public Noncopyable {
+  static const int max_key_words = 48; // Larger keys are not cached
+  uint64_t hits, misses; // Lookups answered from the table, and lookups which computed the perturbation series
+
+  GEODE_CORE_EXPORT explicit PerturbCache(const int log_size=10);
+  GEODE_CORE_EXPORT ~PerturbCache();
+
+  // The active cache for the calling thread, or null
+  GEODE_CORE_EXPORT static PerturbCache* current();
+
+  // Look up a key, returning -1 if missing or the cached sign otherwise
+  GEODE_CORE_EXPORT int lookup(RawArray<const uint64_t> key);
+  GEODE_CORE_EXPORT void insert(RawArray<const uint64_t> key, const bool sign);
+
+private:
+  PerturbCache* const outer;
+  const int log_size;
+  vector<uint64_t> table; // Entries of (hash,size<<1|sign,key...) with fixed stride
+};
+
 // The levelth perturbation of point i in R^m.  This is exposed for occasional special purpose use only, or as a
 // convenient pseudorandom generator; normally this routine is called internally by perturbed_sign.  perturbation<m+1>
 // starts with perturbation<m>.
@@ -71,6 +107,33 @@ wrap_predicate(Types<entries...>) -> decltype(&wrapped_predicate<F,d,entries...>
   return &wrapped_predicate<F,d,entries...>;
 }
 
+// Predicates of at most this degree are evaluated exactly inline when the interval filter fails (see below)
+namespace exact { const int inline_exact_degree = 4; }
+
+// The exact stage of perturbed_predicate, for use once a floating point filter has failed.  Most filter failures are
+// close calls rather than true degeneracies, and are decided by the unperturbed exact value.  For low degree we
+// compute it right here: Exact<d> arithmetic for small d is unrolled into fixed width limb operations on the stack
+// (see exact-generated.h), so this skips the out of line perturbed_sign call, its arena, and the function pointer
+// dispatch.  Only degenerate cases go on to symbolic perturbation, with the unperturbed value known to be zero.
+template<class F,class... Args> GEODE_ALWAYS_INLINE static inline bool
+perturbed_predicate_exact(bool known_zero, const Args... args) {
+  typedef typename First<Args...>::type PerturbedT;
+  const int d = PerturbedT::m;
+  typedef decltype(F::eval(Vector<Exact<1>,d>(args.value())...)) Result;
+  const int degree = Result::degree;
+  if (degree<=exact::inline_exact_degree && !known_zero) {
+    if (const int s = sign(F::eval(Vector<Exact<1>,d>(args.value())...))) {
+      GEODE_EXACT_COUNT_EXACT(F);
+      return s>0;
+    }
+    known_zero = true;
+  }
+  const PerturbedT X[sizeof...(Args)] = {args...};
+  const bool r = perturbed_sign(wrap_predicate<F,d>(IRange<sizeof...(Args)>()),degree,asarray(X),known_zero);
+  GEODE_EXACT_COUNT_PERTURBED(F);
+  return r;
+}
+
 // Given F s.t. F::eval exactly computes a polynomial in its input arguments, compute the perturbed sign of F(args).
 // This is the standard way of turning an expression into a perturbed predicate.  For examples, see predicates.cpp.
 template<class F,class... Args> GEODE_ALWAYS_INLINE static inline bool perturbed_predicate(const Args... args) {
@@ -85,12 +148,15 @@ template<class F,class... Args> GEODE_ALWAYS_INLINE static inline bool perturbed
     inexact_assert_irreducible(f,degree,sizeof...(Args),typeid(F).name());
 
   // Evaluate with conservative interval arithmetic, hoping for a clear nonzero
-  if (const int s = weak_sign(F::eval(Vector<Interval,d>(args.value())...)))
+  const auto i = F::eval(Vector<Interval,d>(args.value())...);
+  if (const int s = weak_sign(i)) {
+    GEODE_EXACT_COUNT_FILTERED(F);
     return s>0;
+  }
 
-  // Fall back to exact integer evaluation with symbolic perturbation
-  const PerturbedT X[sizeof...(Args)] = {args...};
-  return perturbed_sign(f,degree,asarray(X));
+  // Fall back to exact integer evaluation with symbolic perturbation.  If every intermediate was exactly
+  // representable, a degenerate predicate gives a point interval at zero and the unperturbed value is known.
+  return perturbed_predicate_exact<F>(certainly_zero(i),args...);
 }
 
 template<class F,class... Args> struct PerturbedConstruct {
@@ -8,6 +8,7 @@
 #include <geode/exact/quantize.h>
 #include <geode/exact/scope.h>
 #include <geode/array/amap.h>
+#include <geode/array/NestedBuilder.h>
 #include <geode/array/sort.h>
 #include <geode/geometry/BoxTree.h>
 #include <geode/geometry/polygon.h>
@@ -88,10 +89,14 @@ Nested<EV> exact_split_polygons(Nested<const EV> polys, const int depth) {
           pairs.append(vec(i0,j0));
       }
     }
+
+    void merge(const Pairs& other) {
+      pairs.extend(other.pairs);
+    }
   };
   const auto tree = new_<BoxTree<EV>>(segment_boxes(next,X),1);
   Pairs pairs(tree,next,X);
-  double_traverse(*tree,pairs);
+  parallel_double_traverse<IntervalScope>(*tree,pairs);
 
   // Group intersections by segment.  Each pair is added twice: once for each order.
   Array<int> counts(X.size());
@@ -192,21 +197,21 @@ Nested<EV> exact_split_polygons(Nested<const EV> polys, const int depth) {
 
   // Walk the graph to produce output polygons
   Hashtable<Vector<int,2>> seen;
-  Nested<EV,false> output;
+  NestedBuilder<EV> output;
   for (const auto& start : graph)
     if (seen.set(start.x)) {
+      output.append_empty();
       auto ij = start.x;
       for (;;) {
         const int i = ij.x, j = ij.y, in = next[i], jn = next[j];
-        output.flat.append(j==next[i] ? X[j] : segment_segment_intersection(Perturbed2(i,X[i]),Perturbed2(in,X[in]),Perturbed2(j,X[j]),Perturbed2(jn,X[jn])));
+        output.append_to_back(j==next[i] ? X[j] : segment_segment_intersection(Perturbed2(i,X[i]),Perturbed2(in,X[in]),Perturbed2(j,X[j]),Perturbed2(jn,X[jn])));
         ij = vec(j,graph.get(ij));
         if (ij == start.x)
           break;
         seen.set(ij);
       }
-      output.offsets.append(output.flat.size());
     }
-  return output;
+  return output.freeze();
 }
 
 static inline bool include_face(const int delta, const FillRule rule) {
@@ -223,13 +228,16 @@ Nested<Vec2> split_polygons(Nested<const Vec2> polys, const int depth) {
   return amap(quant.inverse,exact_split_polygons(amap(quant,polys),depth));
 }
 
-Nested<Vec2> exact_split_polygons_with_rule(Nested<const Vec2> polys, const int depth, const FillRule rule) {
-  const auto g = ExactSegmentGraph(polys);
+Field<int, FaceId> face_winding_depths(const ExactSegmentGraph& g) {
   const auto edge_windings = Field<int, EdgeId>(constant_map(g.topology->n_edges(), 1).copy());
-  const auto face_winding_depths = compute_winding_numbers(g.topology, g.boundary_face(), edge_windings);
+  return compute_winding_numbers(g.topology, g.boundary_face(), edge_windings);
+}
+
+Nested<Vec2> extract_faces(const ExactSegmentGraph& g, RawField<const int, FaceId> depths,
+                           const int depth, const FillRule rule) {
   auto included_faces = Field<bool, FaceId>(g.topology->n_faces(), uninit);
   for(const FaceId fid : included_faces.id_range())
-    included_faces[fid] = include_face(face_winding_depths[fid] - depth, rule);
+    included_faces[fid] = include_face(depths[fid] - depth, rule);
   const auto contours = extract_region(g.topology, included_faces);
   auto result = Nested<Vec2>::empty_like(contours);
   for(int i : range(contours.flat.size())) {
@@ -239,6 +247,11 @@ Nested<Vec2> exact_split_polygons_with_rule(Nested<const Vec2> polys, const int
   return result;
 }
 
+Nested<Vec2> exact_split_polygons_with_rule(Nested<const Vec2> polys, const int depth, const FillRule rule) {
+  const auto g = ExactSegmentGraph(polys);
+  return extract_faces(g, face_winding_depths(g), depth, rule);
+}
+
 Nested<Vec2> split_polygons_with_rule(Nested<const Vec2> polys, const int depth, const FillRule rule) {
   const auto quant = quantizer(bounding_box(polys));
   return amap(quant.inverse,exact_split_polygons_with_rule(amap(quant,polys),depth,rule));
@@ -1,10 +1,12 @@
 // Exact geometric predicates
 
 #include <geode/exact/predicates.h>
+#include <geode/exact/BatchInterval.h>
 #include <geode/exact/Exact.h>
 #include <geode/exact/math.h>
 #include <geode/exact/perturb.h>
 #include <geode/exact/scope.h>
+#include <geode/array/Array.h>
 #include <geode/array/RawArray.h>
 #include <geode/python/wrap.h>
 #include <geode/random/Random.h>
@@ -15,6 +17,9 @@ typedef exact::Perturbed2 P2;
 typedef exact::Perturbed3 P3;
 using exact::ImplicitlyPerturbed;
 
+// Pull in autogenerated static filters for the most common predicates
+#include <geode/exact/filter-generated.h>
+
 // First, a trivial predicate, handled specially so that it can be partially inlined.
 
 template<int axis, class Perturbed> bool axis_less_degenerate(const Perturbed a, const Perturbed b) {
@@ -43,8 +48,15 @@ struct TriangleOriented { template<class TV> static inline PredicateType<2,TV> e
   return edet(p1-p0,p2-p0);
 }};}
 bool triangle_oriented(const P2 p0, const P2 p1, const P2 p2) {
+  if (const int s = filter_triangle_oriented(p0.value(),p1.value(),p2.value())) {
+    GEODE_EXACT_COUNT_FILTERED(TriangleOriented);
+    return s>0;
+  }
   return perturbed_predicate<TriangleOriented>(p0,p1,p2);
 }
+void triangle_oriented(RawArray<bool> results, RawArray<const Vector<P2,3>> inputs) {
+  perturbed_predicates<TriangleOriented>(results,inputs);
+}
 
 namespace {
 struct DirectionsOriented { template<class TV> static inline PredicateType<2,TV> eval(const TV d0, const TV d1) {
@@ -126,8 +138,15 @@ struct Incircle { template<class TV> static inline PredicateType<4,TV> eval(cons
   return edet(ROW(d0),ROW(d1),ROW(d2));
 }};}
 bool incircle(const P2 p0, const P2 p1, const P2 p2, const P2 p3) {
+  if (const int s = filter_incircle(p0.value(),p1.value(),p2.value(),p3.value())) {
+    GEODE_EXACT_COUNT_FILTERED(Incircle);
+    return s>0;
+  }
   return perturbed_predicate<Incircle>(p0,p1,p2,p3);
 }
+void incircle(RawArray<bool> results, RawArray<const Vector<P2,4>> inputs) {
+  perturbed_predicates<Incircle>(results,inputs);
+}
 
 bool segments_intersect(const P2 a0, const P2 a1, const P2 b0, const P2 b1) {
   return triangle_oriented(a0,a1,b0)!=triangle_oriented(a0,a1,b1)
@@ -141,8 +160,15 @@ struct TetrahedronOriented {
   }
 };}
 bool tetrahedron_oriented(const P3 p0, const P3 p1, const P3 p2, const P3 p3) {
+  if (const int s = filter_tetrahedron_oriented(p0.value(),p1.value(),p2.value(),p3.value())) {
+    GEODE_EXACT_COUNT_FILTERED(TetrahedronOriented);
+    return s>0;
+  }
   return perturbed_predicate<TetrahedronOriented>(p0,p1,p2,p3);
 }
+void tetrahedron_oriented(RawArray<bool> results, RawArray<const Vector<P3,4>> inputs) {
+  perturbed_predicates<TetrahedronOriented>(results,inputs);
+}
 
 namespace {
 struct SegmentTriangleOriented {
@@ -236,6 +262,77 @@ static void predicate_tests() {
     GEODE_ASSERT(!incircle(p0,p1,p2,p3));
     GEODE_ASSERT( incircle(p0,p1,p3,p2));
   }
+
+  // Static filters must agree with exact evaluation whenever they are certain.  Nearly degenerate inputs
+  // near the coordinate bound stress the error bounds, and small inputs are often exactly degenerate.
+  typedef Vector<Exact<1>,2> EV2;
+  typedef Vector<Exact<1>,3> EV3;
+  int certain = 0;
+  for (int step=0;step<3000;step++) {
+    const ExactInt b = step%3==0 ? 2 : exact::bound/4;
+    const auto r2 = [=](){ return TV2(random->uniform<Vector<ExactInt,2>>(-b,b)); };
+    const auto r3 = [=](){ return Vector<double,3>(random->uniform<Vector<ExactInt,3>>(-b,b)); };
+    const auto e2 = [=](){ return TV2(random->uniform<Vector<ExactInt,2>>(-1,1)); };
+    const auto e3 = [=](){ return Vector<double,3>(random->uniform<Vector<ExactInt,3>>(-1,1)); };
+    const auto q2 = [](const TV2 x){ return TV2(round(x.x),round(x.y)); };
+    const auto q3 = [](const Vector<double,3> x){ return Vector<double,3>(round(x.x),round(x.y),round(x.z)); };
+    const bool near = step&1;
+    const auto x0 = r2(), d0 = b>2 ? q2((r2()-x0)/2) : r2(),
+               x1 = x0+d0, x2 = near ? x0+2*d0+e2() : r2();
+    const double R = b>2 ? .25*b : 2, t = random->uniform<double>(0,2*pi);
+    const auto c = near ? q2(TV2(R*cos(t),R*sin(t))) : r2(),
+               x3 = near ? q2(TV2(R*cos(t+1),R*sin(t+1))) : r2(),
+               x4 = near ? q2(TV2(R*cos(t+2),R*sin(t+2))) : r2(),
+               x5 = near ? q2(TV2(R*cos(t+4),R*sin(t+4)))+e2() : r2();
+    const auto y0 = r3(), y1 = r3(), y2 = r3(),
+               y3 = near ? q3(y0+(y1-y0)/2+(y2-y0)/2)+e3() : r3();
+    if (const int s = filter_triangle_oriented(x0,x1,x2)) {
+      GEODE_ASSERT(s==sign(TriangleOriented::eval(EV2(x0),EV2(x1),EV2(x2))));
+      certain++;
+    }
+    if (const int s = filter_incircle(c,x3,x4,x5)) {
+      GEODE_ASSERT(s==sign(Incircle::eval(EV2(c),EV2(x3),EV2(x4),EV2(x5))));
+      certain++;
+    }
+    if (const int s = filter_tetrahedron_oriented(y0,y1,y2,y3)) {
+      GEODE_ASSERT(s==sign(TetrahedronOriented::eval(EV3(y0),EV3(y1),EV3(y2),EV3(y3))));
+      certain++;
+    }
+  }
+  GEODE_ASSERT(certain>3000);
+
+  // Compare batched predicates against scalar versions, including degenerate inputs which require perturbation.
+  // Small coordinates make exact ties common.  Width 3 exercises the portable BatchInterval.
+  typedef Vector<Quantized,3> QV3;
+  Array<Vector<P2,3>> tri;
+  Array<Vector<P2,4>> circ;
+  Array<Vector<P3,4>> tet;
+  for (int step=0;step<203;step++) {
+    const ExactInt b = step&1 ? exact::bound : 2;
+    Vector<P2,4> p;
+    Vector<P3,4> q;
+    for (int i=0;i<4;i++) {
+      p[i] = P2(i,QV2(random->uniform<Vector<ExactInt,2>>(-b,b)));
+      q[i] = P3(i,QV3(random->uniform<Vector<ExactInt,3>>(-b,b)));
+    }
+    tri.append(vec(p[0],p[1],p[2]));
+    circ.append(p);
+    tet.append(q);
+  }
+  Array<bool> results(tri.size()), slow(tri.size());
+  triangle_oriented(results,tri);
+  for (const int i : range(tri.size())) {
+    GEODE_ASSERT(results[i]==triangle_oriented(tri[i][0],tri[i][1],tri[i][2]));
+    slow[i] = results[i];
+  }
+  perturbed_predicates<TriangleOriented,3>(results,RawArray<const Vector<P2,3>>(tri));
+  GEODE_ASSERT(results==slow);
+  incircle(results,circ);
+  for (const int i : range(circ.size()))
+    GEODE_ASSERT(results[i]==incircle(circ[i][0],circ[i][1],circ[i][2],circ[i][3]));
+  tetrahedron_oriented(results,tet);
+  for (const int i : range(tet.size()))
+    GEODE_ASSERT(results[i]==tetrahedron_oriented(tet[i][0],tet[i][1],tet[i][2],tet[i][3]));
 }
 
 }
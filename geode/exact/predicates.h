@@ -2,6 +2,7 @@
 #pragma once
 
 #include <geode/exact/config.h>
+#include <geode/array/forward.h>
 #include <geode/vector/Vector.h>
 namespace geode {
 
@@ -94,6 +95,15 @@ GEODE_CORE_EXPORT GEODE_PURE bool triangles_oriented(const P3 a0, const P3 a1, c
                                                      const P3 b0, const P3 b1, const P3 b2,
                                                      const P3 c0, const P3 c1, const P3 c2);
 
+/*** Batched predicates ***/
+
+// Evaluate a predicate on many independent inputs at once, setting results[i] to the predicate applied to inputs[i].
+// These are equivalent to calling the scalar versions above on each input, but run the interval filter on several
+// inputs at a time (see BatchInterval.h).  They are intended for loops over many unrelated predicate instances.
+GEODE_CORE_EXPORT void triangle_oriented(RawArray<bool> results, RawArray<const Vector<P2,3>> inputs);
+GEODE_CORE_EXPORT void incircle(RawArray<bool> results, RawArray<const Vector<P2,4>> inputs);
+GEODE_CORE_EXPORT void tetrahedron_oriented(RawArray<bool> results, RawArray<const Vector<P3,4>> inputs);
+
 #undef P3
 #undef P2
 
@@ -0,0 +1,143 @@
+// Counters recording how exact predicates are decided
+
+#include <geode/exact/stats.h>
+#include <geode/python/stl.h>
+#include <geode/python/wrap.h>
+#include <geode/utility/format.h>
+#include <geode/utility/metrics.h>
+#include <geode/structure/Tuple.h>
+#include <map>
+#if GEODE_EXACT_STATS && defined(__GNUC__)
+#include <cxxabi.h>
+#include <cstdlib>
+#endif
+namespace geode {
+
+using std::vector;
+
+#if GEODE_EXACT_STATS
+
+namespace exact {
+
+// Counters are never freed, so references handed out by register_predicate_counters stay valid
+static vector<PredicateCounters*> registered_counters;
+
+PredicateCounters& register_predicate_counters(const char* name) {
+  PredicateCounters* counters = new PredicateCounters();
+  counters->name = name;
+  #pragma omp critical(exact_stats)
+  registered_counters.push_back(counters);
+  return *counters;
+}
+
+static GEODE_THREAD_LOCAL int perturbed_sign_stage = 0;
+
+void set_perturbed_sign_stage(const int stage) {
+  perturbed_sign_stage = stage;
+}
+
+void count_perturbed_sign(PredicateCounters& counters) {
+  const int stage = perturbed_sign_stage;
+  auto& c = stage<0 ? counters.cached
+          : !stage  ? counters.exact
+                    : counters.levels[min(stage,max_stats_level)-1];
+  c.fetch_add(1,std::memory_order_relaxed);
+}
+
+static string demangle(const char* name) {
+#ifdef __GNUC__
+  int status = 0;
+  if (char* s = abi::__cxa_demangle(name,0,0,&status)) {
+    const string r(s);
+    free(s);
+    return r;
+  }
+#endif
+  return name;
+}
+
+}
+
+vector<PredicateStats> exact_stats() {
+  using namespace exact;
+  vector<PredicateCounters*> all;
+  #pragma omp critical(exact_stats)
+  all = registered_counters;
+
+  // The same predicate type may be registered from several shared objects, so merge by name
+  std::map<string,PredicateStats> merged;
+  for (const auto* c : all) {
+    const auto name = demangle(c->name);
+    auto it = merged.find(name);
+    if (it == merged.end()) {
+      PredicateStats s = {name,0,0,0,Array<uint64_t>(max_stats_level)};
+      it = merged.insert(make_pair(name,s)).first;
+    }
+    auto& s = it->second;
+    s.filtered += c->filtered;
+    s.exact += c->exact;
+    s.cached += c->cached;
+    for (int k=0;k<max_stats_level;k++)
+      s.levels[k] += c->levels[k];
+  }
+  vector<PredicateStats> result;
+  for (const auto& s : merged)
+    if (s.second.filtered || s.second.exact || s.second.cached || s.second.levels.sum())
+      result.push_back(s.second);
+  return result;
+}
+
+void reset_exact_stats() {
+  using namespace exact;
+  #pragma omp critical(exact_stats)
+  for (auto* c : registered_counters) {
+    c->filtered = c->exact = c->cached = 0;
+    for (auto& l : c->levels)
+      l = 0;
+  }
+}
+
+// Export counts as one counter family, labeled by predicate and deciding stage
+static void collect_exact_stats(vector<MetricFamily>& families) {
+  const string name = "geode_exact_predicate_decisions_total";
+  MetricFamily f = {name,"Exact predicate evaluations by deciding stage",MetricType::counter,vector<MetricSample>()};
+  const auto sample = [&](const string& predicate, const string& stage, const uint64_t n) {
+    const MetricSample s = {name,{{"predicate",predicate},{"stage",stage}},double(n)};
+    f.samples.push_back(s);
+  };
+  for (const auto& s : exact_stats()) {
+    sample(s.name,"filtered",s.filtered);
+    sample(s.name,"exact",s.exact);
+    sample(s.name,"cached",s.cached);
+    for (int k=0;k<s.levels.size();k++)
+      sample(s.name,format("perturbed%d",k+1),s.levels[k]);
+  }
+  families.push_back(f);
+}
+static const bool exact_collector_added = (add_metrics_collector(collect_exact_stats),true);
+
+#else
+
+vector<PredicateStats> exact_stats() {
+  return vector<PredicateStats>();
+}
+
+void reset_exact_stats() {}
+
+#endif
+
+// Python version: a map from predicate name to (filtered,exact,cached,levels)
+static std::map<string,Tuple<uint64_t,uint64_t,uint64_t,Array<const uint64_t>>> exact_stats_py() {
+  std::map<string,Tuple<uint64_t,uint64_t,uint64_t,Array<const uint64_t>>> result;
+  for (const auto& s : exact_stats())
+    result[s.name] = tuple(s.filtered,s.exact,s.cached,s.levels.const_());
+  return result;
+}
+
+}
+using namespace geode;
+
+void wrap_exact_stats() {
+  GEODE_FUNCTION_2(exact_stats,exact_stats_py)
+  GEODE_FUNCTION(reset_exact_stats)
+}
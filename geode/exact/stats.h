@@ -0,0 +1,79 @@
+// Counters recording how exact predicates are decided
+#pragma once
+
+// If geode is configured with GEODE_EXACT_STATS, every perturbed predicate counts how often it is decided by the
+// floating point filters, by unperturbed exact evaluation, by the perturbation cache, and at each level of symbolic
+// perturbation.  Counters are global, keyed by predicate type, and updated atomically, so they can be read after a
+// parallel operation.  Without GEODE_EXACT_STATS the counting macros compile to nothing and exact_stats is empty.
+//
+// Typical use is to call reset_exact_stats before an operation and inspect exact_stats afterwards, to decide which
+// predicates would benefit from a faster path or whether the input is unusually degenerate.
+
+#include <geode/exact/config.h>
+#include <geode/array/Array.h>
+#include <string>
+#include <vector>
+#if GEODE_EXACT_STATS
+#include <atomic>
+#include <typeinfo>
+#endif
+namespace geode {
+
+using std::string;
+
+// Counts for one predicate since the last reset
+struct PredicateStats {
+  string name;
+  uint64_t filtered; // Decided by a floating point filter
+  uint64_t exact; // Decided by unperturbed exact evaluation
+  uint64_t cached; // Found in an active PerturbCache
+  Array<uint64_t> levels; // levels[k] = decided by symbolic perturbation at level k+1
+};
+
+// Counts for all predicates used since the last reset, sorted by name
+GEODE_CORE_EXPORT std::vector<PredicateStats> exact_stats();
+
+// Zero all counters
+GEODE_CORE_EXPORT void reset_exact_stats();
+
+namespace exact {
+
+// Decisions at this level or deeper share the last entry of PredicateStats::levels
+const int max_stats_level = 4;
+
+#if GEODE_EXACT_STATS
+
+struct PredicateCounters {
+  const char* name;
+  std::atomic<uint64_t> filtered, exact, cached, levels[max_stats_level];
+};
+
+// Look up the counters for a predicate type, registering them on first use
+GEODE_CORE_EXPORT PredicateCounters& register_predicate_counters(const char* name);
+template<class F> static inline PredicateCounters& predicate_counters() {
+  static PredicateCounters& counters = register_predicate_counters(typeid(F).name());
+  return counters;
+}
+
+// Count the stage at which the last call to perturbed_sign on this thread was decided
+GEODE_CORE_EXPORT void count_perturbed_sign(PredicateCounters& counters);
+
+// Record the stage at which perturbed_sign was decided: 0 for exact, -1 for cached, and k>0 for perturbation level k
+GEODE_CORE_EXPORT void set_perturbed_sign_stage(const int stage);
+
+#define GEODE_EXACT_COUNT_FILTERED(F) (exact::predicate_counters<F>().filtered.fetch_add(1,std::memory_order_relaxed))
+#define GEODE_EXACT_COUNT_EXACT(F) (exact::predicate_counters<F>().exact.fetch_add(1,std::memory_order_relaxed))
+#define GEODE_EXACT_COUNT_PERTURBED(F) (exact::count_perturbed_sign(exact::predicate_counters<F>()))
+#define GEODE_EXACT_STAGE(stage) (exact::set_perturbed_sign_stage(stage))
+
+#else
+
+#define GEODE_EXACT_COUNT_FILTERED(F) ((void)0)
+#define GEODE_EXACT_COUNT_EXACT(F) ((void)0)
+#define GEODE_EXACT_COUNT_PERTURBED(F) ((void)0)
+#define GEODE_EXACT_STAGE(stage) ((void)0)
+
+#endif
+
+}
+}
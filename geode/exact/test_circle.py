@@ -201,6 +201,29 @@ def test_single_circle(show_results=False):
         pylab.show()
 
 # Compute t such that offset_arcs(arcs,-(t+tolerance/2)) will be empty and offset_arcs(arcs,-(t-tolerance/2) will not
+def test_parallel_split():
+  random.seed(81231)
+  # Scatter small clusters so that tiling has something to separate
+  n,k = 3000,4
+  arcs = random_circle_arcs(n,k)
+  arcs.flat.x = .1*arcs.flat.x+50*random.uniform(size=(n,1,2)).repeat(k,axis=1).reshape(-1,2)
+  for depth in 0,1:
+    serial = split_circle_arcs(arcs,depth)
+    parallel = parallel_split_circle_arcs(arcs,depth)
+    assert allclose(circle_arc_area(serial),circle_arc_area(parallel))
+    assert len(serial)==len(parallel)
+
+def test_parallel_offset():
+  random.seed(81232)
+  n,k = 1000,4
+  arcs = random_circle_arcs(n,k)
+  arcs.flat.x = .1*arcs.flat.x+30*random.uniform(size=(n,1,2)).repeat(k,axis=1).reshape(-1,2)
+  for d in .2,-.05:
+    serial = offset_arcs(arcs,d)
+    parallel = parallel_offset_arcs(arcs,d,256)
+    assert allclose(circle_arc_area(serial),circle_arc_area(parallel))
+    assert len(serial)==len(parallel)
+
 def find_thickness(arcs, tolerance):
   if len(arcs) == 0:
     return 0.
@@ -13,6 +13,18 @@ def test_interval():
 def test_predicates():
   predicate_tests()
 
+def test_collision():
+  collision_tests()
+
+def test_exact_stats():
+  # Counters are only collected if geode was configured with GEODE_EXACT_STATS
+  reset_exact_stats()
+  delaunay_points(zeros((20,2)))
+  for name,(filtered,exact,cached,levels) in exact_stats().items():
+    assert filtered+exact+cached+sum(levels)>0
+  reset_exact_stats()
+  assert not exact_stats()
+
 def test_constructions():
   construction_tests()
 
@@ -56,6 +68,63 @@ def test_delaunay(benchmark=False,cgal=False,origin=True,circle=False,constrain=
             if n>0 and mesh.n_faces!=nf:
               Log.write('expected %d faces, got %d'%(mesh.n_faces,nf))
 
+def sorted_triangles(tris):
+  t = asarray(tris).reshape(-1,3)
+  t = t[arange(len(t))[:,None],(t.argmin(axis=1)[:,None]+arange(3))%3]
+  return t[lexsort(t.T[::-1])]
+
+def test_parallel_delaunay():
+  random.seed(8312)
+  n = 1<<17
+  for name,X in ('gaussian',random.randn(n,2)),('grid',indices((1<<8,1<<9)).reshape(2,-1).T.copy()):
+    with Log.scope('parallel delaunay %s %d'%(name,len(X))):
+      serial = delaunay_points(X)
+      parallel = delaunay_points(X,validate=True,parallel=True)
+      parallel.assert_consistent(True)
+      assert all(sorted_triangles(serial.elements())==sorted_triangles(parallel.elements()))
+
+def test_bulk_constraints():
+  random.seed(1213)
+  X = random.randn(1000,2)
+  edges = greedy_nonintersecting_edges(X,1000)
+  mesh = delaunay_points(X,edges)
+  bulk = delaunay_points(X,edges,validate=True,bulk_constraints=True)
+  assert all(sorted_triangles(mesh.elements())==sorted_triangles(bulk.elements()))
+
+def test_refine_delaunay():
+  random.seed(9131)
+  X = concatenate([random.uniform(-1,1,(300,2)),[(-2,-2),(2,-2),(2,2),(-2,2)]])
+  edges = asarray([(300,301),(301,302),(302,303),(303,300)],dtype=int32)
+  min_angle = 25*pi/180
+  mesh,Y = refine_delaunay_points(X,edges,min_angle=min_angle,max_area=.01)
+  mesh.assert_consistent(True)
+  assert all(Y[:len(X)]==X)
+  tris = Y[mesh.elements()]
+  e = tris[:,(1,2,0)]-tris
+  angles = arccos(clip(-sum(e*roll(e,1,axis=1),axis=-1)/(magnitudes(e)*magnitudes(roll(e,1,axis=1))),-1,1))
+  assert angles.min()>min_angle-1e-9
+  area = cross(e[:,0],-e[:,2])/2
+  assert area.min()>0 and area.max()<=.01
+
+def test_streaming_delaunay():
+  random.seed(1731)
+  n,k = 10000,8
+  X = random.randn(n,2)
+  stream = StreamingDelaunay(bounding_box(X),(k,k))
+  cells = asarray([stream.cell(x) for x in X])
+  order = lexsort(cells.T[::-1])
+  X,cells = X[order],cells[order]
+  tris = []
+  active = 0
+  for i in xrange(k):
+    for j in xrange(k):
+      stream.add_points(X[all(cells==(i,j),axis=1)])
+      tris.append(stream.finalize_cells([(i,j)]))
+      active = max(active,stream.active_points())
+  tris.append(stream.finish())
+  assert stream.total_points()==n and active<n//2
+  assert all(sorted_triangles(concatenate(tris))==sorted_triangles(delaunay_points(X).elements()))
+
 def draw_polygons(polys):
   import pylab
   for p,points in enumerate(polys):
@@ -101,6 +170,56 @@ def test_polygon():
       print 'error = %g'%error
       assert False
 
+def test_polygon_hatch():
+  # Long thin strips crossing in a grid, where every strip overlaps the bounding box of every other
+  n,w = 30,.01
+  strips = [asarray([[0,i],[n,i],[n,i+w],[0,i+w]])/n for i in xrange(n)]
+  strips += [s[::-1,::-1] for s in strips] # Transpose, keeping orientation positive
+  union = polygon_union_cmp(*[Nested([s]) for s in strips])
+  assert allclose(polygon_area(union),2*w-w*w)
+
+def test_incremental_polygon_csg():
+  random.seed(183111)
+  n = 6
+  squares = [asarray([[0,0],[1,0],[1,1],[0,1]])*.8+[i,j] for i in xrange(n) for j in xrange(n)]
+  csg = IncrementalPolygonCSG(Box((-1,-1),(n+1,n+1)),0)
+  ids = [csg.add(Nested([s])) for s in squares]
+  area = polygon_area(csg.result())
+  assert allclose(area,polygon_area(polygon_union(*[Nested([s]) for s in squares])))
+  # Sliding one square onto its neighbor should only redo that neighborhood
+  csg.replace(ids[0],Nested([squares[0]+[.5,0]]))
+  assert allclose(polygon_area(csg.result()),area-.3*.8)
+  assert 0<csg.recomputed_parts()<=3
+  csg.result()
+  assert csg.recomputed_parts()==0
+
+def test_polygon_arrangement():
+  random.seed(71311)
+  polys = Nested(list(random.randn(20,1,2)+polar(sort(random.uniform(2*pi,size=(20,5)),axis=1))))
+  arrangement = PolygonArrangement(polys)
+  for depth in 0,1,2:
+    for rule in 'greater','parity','neq':
+      a = getattr(arrangement,'split_'+rule)(depth)
+      b = globals()['split_polygons_'+rule](polys,depth)
+      assert all(a.offsets==b.offsets) and all(a.flat==b.flat)
+
+def test_minkowski():
+  square = asarray([[0,0],[1,0],[1,1],[0,1]],dtype=float)
+  L = asarray([[0,0],[2,0],[2,1],[1,1],[1,2],[0,2]],dtype=float)
+  # L+square is the union of two 3x2 rectangles
+  assert allclose(polygon_area(minkowski_sum(Nested([L]),Nested([square]))),8)
+  # A square of side 1 overlaps another exactly when its corner lies in a square of side 2
+  nfp = no_fit_polygon(Nested([square]),Nested([square]))
+  assert len(nfp)==1 and allclose(polygon_area(nfp),4)
+  assert allclose(nfp.flat.min(axis=0),(-1,-1)) and allclose(nfp.flat.max(axis=0),(1,1))
+  cache = NoFitPolygonCache()
+  s,l = cache.add(Nested([square])),cache.add(Nested([L]))
+  assert allclose(polygon_area(cache.nfp(l,s,0)),8)
+  cache.precompute([(s,l),(l,s)],[0,pi/2])
+  assert cache.cached()==4
+  assert allclose(polygon_area(cache.nfp(l,s,pi/2)),8)
+  assert cache.cached()==4
+
 if __name__=='__main__':
   Log.configure('exact tests',0,0,100)
   if '-i' in sys.argv:
@@ -53,6 +53,63 @@ def test_csg():
           assert allclose(Is[name],Is[name[4:]])
   print('Success!')
 
+def test_separated_parts():
+  # Well separated clusters are split independently, which should match splitting each cluster on its own
+  random.seed(7)
+  tet,X0 = tetrahedron_mesh()
+  X0 *= tet.volume(X0)**(-1/3)
+  pairs = [((tet,X0+(4*i,0,0)),(tet,X0+(4*i,0,0)+.3*random.randn(3))) for i in xrange(5)]
+  unions = [soup_union(*p) for p in pairs]
+  I = sum(mesh_signature(m,Z) for m,Z in unions)
+  V = sum(m.volume(Z) for m,Z in unions)
+  m,Z = soup_union(*[t for p in pairs for t in p])
+  assert allclose(I,mesh_signature(m,Z))
+  assert allclose(V,m.volume(Z))
+  assert not len(m.nonmanifold_nodes(0))
+
+def test_union_soups():
+  # A trail of overlapping tetrahedra unioned hierarchically should match a single split
+  random.seed(13)
+  tet,X0 = tetrahedron_mesh()
+  X0 *= tet.volume(X0)**(-1/3)
+  meshes = [(tet,X0+(.4*i,0,0)+.2*random.randn(3)) for i in xrange(40)]
+  m0,Z0 = soup_union(*meshes)
+  for leaf_size in 1,4:
+    m,Z = soups_union(meshes,leaf_size)
+    assert allclose(m0.volume(Z0),m.volume(Z))
+    assert allclose(mesh_signature(m0,Z0),mesh_signature(m,Z))
+    assert not len(m.nonmanifold_nodes(0))
+
+def test_moving_soup():
+  # Move one of several overlapping tetrahedra at a time, comparing against splitting from scratch
+  random.seed(11)
+  tet,X0 = tetrahedron_mesh()
+  X0 *= tet.volume(X0)**(-1/3)
+  meshes = [(tet,X0+(2*i,0,0)+.3*random.randn(3)) for i in xrange(6)]
+  soup,X = merge_meshes(meshes)
+  weight = [1]*len(soup.elements)
+  moving = MovingSoupCSG(soup,bounding_box(X).thickened(2))
+  for frame in xrange(5):
+    if frame:
+      i = random.randint(len(meshes))
+      X[4*i:4*i+4] += .1*random.randn(3)
+    m,Z = moving.split(X,weight,0)
+    assert moving.moved_faces()==(len(soup.elements) if not frame else 4)
+    m2,Z2 = split_soup_with_weight(soup,X,weight,0)
+    assert allclose(mesh_signature(m,Z),mesh_signature(m2,Z2))
+
+def test_nearly_clean():
+  # Nested, separate, and barely overlapping spheres mostly pass the floating point filter, so few faces are split exactly
+  outer = sphere_mesh(3)
+  nested = sphere_mesh(3,radius=.5)
+  separate = sphere_mesh(3,(3,0,0))
+  overlap = sphere_mesh(3,(2-1e-3,0,0))
+  for inner,I in (nested,mesh_signature(*outer)),(separate,mesh_signature(*outer)+mesh_signature(*separate)),(overlap,None):
+    m,Z = split_soups((outer,inner))
+    if I is not None:
+      assert allclose(mesh_signature(m,Z),I)
+    assert not len(m.nonmanifold_nodes(0))
+
 def test_depth_weight():
   tet,X0 = tetrahedron_mesh()
   X0 *= tet.volume(X0)**(-1/3)
@@ -79,4 +136,7 @@ def test_depth_weight():
 if __name__=='__main__':
   test_simple_triangulate()
   test_csg()
+  test_separated_parts()
+  test_moving_soup()
+  test_nearly_clean()
   test_depth_weight()
@@ -68,6 +68,14 @@ def test_perturbed_sign():
 def test_perturbed_ratio():
   perturbed_ratio_test()
 
+def test_perturb_cache():
+  perturb_cache_test()
+
+def test_perturb_arena():
+  # The degenerate tests above run through the per-thread scratch arena
+  perturbed_sign_test_2()
+  assert perturb_arena_high_water()>0
+
 def test_irreducible():
   irreducible_test()
 
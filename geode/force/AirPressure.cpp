@@ -2,7 +2,6 @@
 // Class AirPressure
 //#####################################################################
 #include <geode/force/AirPressure.h>
-#include <geode/array/ConstantMap.h>
 #include <geode/math/constants.h>
 #include <geode/mesh/TriangleSoup.h>
 #include <geode/python/Class.h>
@@ -10,6 +9,7 @@
 #include <geode/vector/SolidMatrix.h>
 #include <geode/vector/SymmetricMatrix.h>
 #include <geode/utility/Log.h>
+#include <geode/utility/parallel.h>
 namespace geode {
 
 using Log::cout;
@@ -25,7 +25,6 @@ AirPressure::AirPressure(Ref<TriangleSoup> mesh,Array<const TV> X,bool closed,in
   , side(side)
   , skip_rotation_terms(false)
   , initial_volume(side*mesh->volume(X))
-  , local_mesh(mesh->elements.size(),uninit)
   , volume(initial_volume)
 {
   GEODE_ASSERT(abs(side)==1);
@@ -35,14 +34,23 @@ AirPressure::AirPressure(Ref<TriangleSoup> mesh,Array<const TV> X,bool closed,in
     amount = pressure*initial_volume/(ideal_gas_constant*temperature);
   else
     amount = 0;
-  // Set up local mesh
+  // Collect the triangles around each touched node, so that per node sums can be gathered in parallel
   Array<const int> nodes = mesh->nodes_touched();
   Hashtable<int,int> hash;
   for (int i=0;i<nodes.size();i++)
     hash.set(nodes[i],i);
-  for (int t=0;t<mesh->elements.size();t++)
-    for(int i=0;i<3;i++)
-      local_mesh[t][i] = hash.get(mesh->elements[t][i]);
+  Array<int> counts(nodes.size());
+  for (const auto& tri : mesh->elements)
+    for (int i=0;i<3;i++)
+      counts[hash.get(tri[i])]++;
+  Nested<Vector<int,2>> rings(counts,uninit);
+  for (int t=mesh->elements.size()-1;t>=0;t--) {
+    int i,j,k;mesh->elements[t].get(i,j,k);
+    rings(hash.get(i),--counts[hash.get(i)]) = vec(j,k);
+    rings(hash.get(j),--counts[hash.get(j)]) = vec(k,i);
+    rings(hash.get(k),--counts[hash.get(k)]) = vec(i,j);
+  }
+  this->rings = rings;
 }
 
 AirPressure::~AirPressure() {}
@@ -70,16 +78,23 @@ void AirPressure::update_position(Array<const TV> X_, bool definite) {
     GEODE_NOT_IMPLEMENTED("Refusing to fix definiteness unless skip_rotation_terms is true");
   GEODE_ASSERT(X_.size()>=mesh->nodes());
   X = X_;
-  volume = side*mesh->volume(X);
+  // V = 1/6 sum_t det(a,b,c), as in TriangleSoup::volume but reduced in parallel
+  const auto tris = mesh->elements;
+  volume = side*parallel_reduce<T>(tris.size(),[&](const int t) {
+    int i,j,k;tris[t].get(i,j,k);
+    return det(X[i],X[j],X[k]);
+  },1024)/6;
   if (closed)
     pressure = amount*ideal_gas_constant*temperature/volume;
   Array<const int> nodes = mesh->nodes_touched();
-  normals.copy(constant_map(nodes.size(),TV()));
-  for (int t=0;t<local_mesh.size();t++) {
-    int i,j,k;local_mesh[t].get(i,j,k);
-    TV n = cross(X[nodes[j]]-X[nodes[i]],X[nodes[k]]-X[nodes[i]]);
-    normals[i]+=n;normals[j]+=n;normals[k]+=n;
-  }
+  normals.resize(nodes.size(),uninit);
+  parallel_for(nodes.size(),[&](const int a) {
+    const TV xa = X[nodes[a]];
+    TV n;
+    for (const auto& bc : rings[a])
+      n += cross(X[bc.x]-xa,X[bc.y]-xa);
+    normals[a] = n;
+  },256);
 }
 
 T AirPressure::elastic_energy() const {
@@ -103,8 +118,9 @@ void AirPressure::add_elastic_force(RawArray<TV> F) const {
   //   dV/da = 1/6 sum_{t on a} cross(b-a,c-a)
   // which is just the sum of area weighted triangle normals.
   Array<const int> nodes = mesh->nodes_touched();
-  for (int i=0;i<nodes.size();i++)
+  parallel_for(nodes.size(),[&](const int i) {
     F[nodes[i]] += factor*normals[i];
+  },1024);
 }
 
 void AirPressure::add_elastic_differential(RawArray<TV> dF,RawArray<const TV> dX) const {
@@ -131,22 +147,23 @@ void AirPressure::add_elastic_differential(RawArray<TV> dF,RawArray<const TV> dX
     dEdV = -pressure;
     ddE_dVdV = 0;
   }
-  if (ddE_dVdV) {
-    T dV = 0;
-    Array<const int> nodes = mesh->nodes_touched();
-    for (int i=0;i<nodes.size();i++)
-      dV += dot(normals[i],dX[nodes[i]]);
-    T factor1 = -ddE_dVdV*dV/36;
-    for (int i=0;i<nodes.size();i++)
-      dF[nodes[i]] += factor1*normals[i];}
-  const T factor2 = -side*dEdV/6;
-  if (factor2 && !skip_rotation_terms)
-    for (int t=0;t<mesh->elements.size();t++){
-      int i,j,k;mesh->elements[t].get(i,j,k);
-      dF[i] += factor2*(cross(X[j],dX[k])+cross(dX[j],X[k]));
-      dF[j] += factor2*(cross(X[k],dX[i])+cross(dX[k],X[i]));
-      dF[k] += factor2*(cross(X[i],dX[j])+cross(dX[i],X[j]));
-    }
+  // The rank one term needs dV = dV/dx . dX first.  Both terms are then applied in one gather over nodes, rather
+  // than through a SolidMatrix outer.
+  Array<const int> nodes = mesh->nodes_touched();
+  const T dV = ddE_dVdV ? parallel_reduce<T>(nodes.size(),[&](const int i) {
+    return dot(normals[i],dX[nodes[i]]);
+  },1024) : 0;
+  const T factor1 = -ddE_dVdV*dV/36,
+          factor2 = skip_rotation_terms ? 0 : -side*dEdV/6;
+  if (!factor1 && !factor2)
+    return;
+  parallel_for(nodes.size(),[&](const int a) {
+    TV rotation;
+    if (factor2)
+      for (const auto& bc : rings[a])
+        rotation += cross(X[bc.x],dX[bc.y])+cross(dX[bc.x],X[bc.y]);
+    dF[nodes[a]] += factor1*normals[a]+factor2*rotation;
+  },256);
 }
 
 void AirPressure::add_elastic_gradient(SolidMatrix<TV>& matrix) const {
@@ -177,8 +194,9 @@ void AirPressure::add_elastic_gradient_block_diagonal(RawArray<SymmetricMatrix<T
     const T factor = -ddE_dVdV/36;
     if (factor && !skip_rotation_terms) {
       Array<const int> nodes = mesh->nodes_touched();
-      for (int i=0;i<nodes.size();i++)
+      parallel_for(nodes.size(),[&](const int i) {
         dFdX[nodes[i]] += scaled_outer_product(factor,normals[i]);
+      },1024);
     }
   }
 }
@@ -24,6 +24,7 @@
 
 #include <geode/utility/config.h>
 #include <geode/array/Array.h>
+#include <geode/array/Nested.h>
 #include <geode/force/Force.h>
 #include <geode/vector/Vector.h>
 #include <geode/mesh/forward.h>
@@ -45,7 +46,7 @@ public:
   bool skip_rotation_terms;
   const T initial_volume;
 private:
-  Array<Vector<int,3>> local_mesh;
+  Nested<const Vector<int,2>> rings; // For each touched node a, (b,c) for each incident triangle abc, up to rotation
   Array<const TV> X;
   T volume;
   Array<TV> normals; // area weighted times two
@@ -23,6 +23,7 @@ public:
   virtual T elastic_energy(const DiagonalMatrix<T,d>& F,const Matrix<T,d>& V,const int simplex) const=0;
   virtual Matrix<T,d> P_From_Strain(const DiagonalMatrix<T,d>& F,const Matrix<T,d>& V,const T scale,const int simplex) const=0;
   virtual DiagonalizedStressDerivative<T,d> stress_derivative(const DiagonalMatrix<T,d>& F,const Matrix<T,d>& V,const int simplex) const=0;
+  // Called concurrently for different simplices, so it must only touch state for the given simplex
   virtual void update_position(const DiagonalMatrix<T,d>& F,const Matrix<T,d>& V,const int simplex){}
 };
 
@@ -0,0 +1,124 @@
+//#####################################################################
+// Class BackwardEuler
+//#####################################################################
+#include <geode/force/BackwardEuler.h>
+#include <geode/python/Class.h>
+#include <geode/solver/krylov.h>
+#include <geode/utility/parallel.h>
+#include <geode/vector/SymmetricMatrix.h>
+namespace geode {
+
+typedef real T;
+template<> GEODE_DEFINE_TYPE(BackwardEuler<Vector<T,2>>)
+template<> GEODE_DEFINE_TYPE(BackwardEuler<Vector<T,3>>)
+
+// Elementwise passes are small, so use large chunks
+static const int grain = 1024;
+
+// M - dt D - dt^2 K applied through the forces
+template<class TV> class BackwardEulerSystem : public SolidMatrixBase<TV> {
+public:
+  typedef SolidMatrixBase<TV> Base;
+  typedef typename TV::Scalar T;
+
+  const Ref<const Force<TV>> force;
+  const Array<const T> mass;
+  T dt;
+
+  BackwardEulerSystem(const Force<TV>& force, Array<const T> mass)
+    : Base(mass.size()), force(ref(force)), mass(mass), dt(0) {}
+
+  void multiply(RawArray<const TV> x, RawArray<TV> y) const {
+    y.zero();
+    force->add_elastic_differential(y,x);
+    parallel_for(y.size(),[&](const int i) { y[i] *= dt; },grain);
+    force->add_damping_force(y,x);
+    parallel_for(y.size(),[&](const int i) { y[i] = mass[i]*x[i]-dt*y[i]; },grain);
+  }
+};
+
+template<class TV> BackwardEuler<TV>::BackwardEuler(Force<TV>& force, Array<const T> mass, Array<const TV> X,
+                                                    Array<const TV> V, const bool matrix_free)
+  : force(ref(force)), mass(mass), X(X.copy()), V(V.copy()), matrix_free(matrix_free)
+  , tolerance(1e-6), max_iterations(1000)
+  , system(new_<BackwardEulerSystem<TV>>(force,mass))
+  , preconditioner(new_<SolidDiagonalMatrix<TV>>(mass.size(),uninit))
+  , rhs(mass.size(),uninit) {
+  GEODE_ASSERT(X.size()==mass.size() && V.size()==mass.size() && force.nodes()<=mass.size());
+  if (matrix_free)
+    const_cast_(diagonal) = Array<SymmetricMatrix<T,m>>(mass.size(),uninit);
+  else {
+    // The sparsity pattern is fixed, so build it once
+    const auto structure = new_<SolidMatrixStructure>(mass.size());
+    force.structure(structure);
+    matrix = new_<SolidMatrix<TV>>(structure);
+  }
+}
+
+template<class TV> BackwardEuler<TV>::~BackwardEuler() {}
+
+template<class TV> Tuple<int,typename TV::Scalar> BackwardEuler<TV>::step(const T dt) {
+  GEODE_ASSERT(dt>0);
+  const int n = mass.size();
+  force->update_position(X,true);
+
+  // Right hand side M V + dt F(X)
+  rhs.zero();
+  force->add_elastic_force(rhs);
+  parallel_for(n,[&](const int i) { rhs[i] = mass[i]*V[i]+dt*rhs[i]; },grain);
+
+  // Refill the system and its block Jacobi preconditioner in place
+  Ptr<const SolidMatrixBase<TV>> A;
+  if (matrix) {
+    matrix->zero();
+    force->add_elastic_gradient(*matrix);
+    matrix->scale(dt);
+    force->add_damping_gradient(*matrix);
+    matrix->scale(-dt);
+    matrix->add_diagonal_scalars(mass);
+    parallel_for(n,[&](const int i) {
+      preconditioner->A[i] = assume_symmetric(matrix->sparse_A(i,0)).inverse();
+    },grain);
+    A = matrix;
+  } else {
+    // The damping diagonal isn't available without assembly, so precondition with M - dt^2 diag(K)
+    diagonal.zero();
+    force->add_elastic_gradient_block_diagonal(diagonal);
+    parallel_for(n,[&](const int i) {
+      preconditioner->A[i] = (mass[i]-sqr(dt)*diagonal[i]).inverse();
+    },grain);
+    system->dt = dt;
+    A = system;
+  }
+
+  // Solve for the new velocity, starting from the old one
+  const auto result = conjugate_gradient<TV>(*A,rhs,V,preconditioner,tolerance,max_iterations);
+  parallel_for(n,[&](const int i) { X[i] += dt*V[i]; },grain);
+  return result;
+}
+
+template class BackwardEuler<Vector<T,2>>;
+template class BackwardEuler<Vector<T,3>>;
+}
+using namespace geode;
+
+template<int d> static void wrap_helper() {
+  typedef Vector<T,d> TV;
+  typedef BackwardEuler<TV> Self;
+  Class<Self>(d==2?"BackwardEuler2d":"BackwardEuler3d")
+    .GEODE_INIT(Force<TV>&,Array<const T>,Array<const TV>,Array<const TV>,bool)
+    .GEODE_FIELD(force)
+    .GEODE_FIELD(mass)
+    .GEODE_FIELD(X)
+    .GEODE_FIELD(V)
+    .GEODE_FIELD(matrix_free)
+    .GEODE_FIELD(tolerance)
+    .GEODE_FIELD(max_iterations)
+    .GEODE_METHOD(step)
+    ;
+}
+
+void wrap_backward_euler() {
+  wrap_helper<2>();
+  wrap_helper<3>();
+}
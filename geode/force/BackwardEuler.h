@@ -0,0 +1,65 @@
+//#####################################################################
+// Class BackwardEuler
+//#####################################################################
+//
+// Linearized backward Euler time stepping for a Force, usually a ForceSet.
+// Each step solves
+//
+//     (M - dt D - dt^2 K) V' = M V + dt F(X)
+//
+// for the new velocity V' by preconditioned conjugate gradients, where K
+// and D are the elastic and damping gradients at X, and then sets
+// X += dt V'.  Damping is taken fully implicitly, since damping forces are
+// linear in velocity.
+//
+// Everything that doesn't change between steps is kept: the SolidMatrix
+// and its structure are built once and refilled in place, the block Jacobi
+// preconditioner is updated in place, and each solve starts from the
+// previous velocity, so smooth motion needs few iterations.  With
+// matrix_free set the matrix is never assembled, and each iteration applies
+// the forces' add_elastic_differential and add_damping_force instead.  This
+// is cheaper when solves take only a few iterations, or when assembly
+// dominates.
+//
+//#####################################################################
+#pragma once
+
+#include <geode/force/Force.h>
+#include <geode/structure/Tuple.h>
+#include <geode/vector/SolidMatrix.h>
+namespace geode {
+
+template<class TV> class BackwardEulerSystem;
+
+template<class TV>
+class BackwardEuler : public Object {
+public:
+  GEODE_DECLARE_TYPE(GEODE_CORE_EXPORT)
+  typedef Object Base;
+  typedef typename TV::Scalar T;
+  enum {m=TV::m};
+
+  const Ref<Force<TV>> force;
+  const Array<const T> mass;
+  const Array<TV> X, V; // Current state, updated in place by step
+  const bool matrix_free;
+  T tolerance; // Relative residual tolerance for conjugate gradients
+  int max_iterations;
+private:
+  Ptr<SolidMatrix<TV>> matrix; // Assembled system, if not matrix free
+  const Ref<BackwardEulerSystem<TV>> system; // Matrix free system
+  const Ref<SolidDiagonalMatrix<TV>> preconditioner;
+  const Array<TV> rhs;
+  const Array<SymmetricMatrix<T,m>> diagonal;
+
+protected:
+  GEODE_CORE_EXPORT BackwardEuler(Force<TV>& force, Array<const T> mass, Array<const TV> X, Array<const TV> V,
+                                  const bool matrix_free=false);
+public:
+  ~BackwardEuler();
+
+  // Advance by dt, returning the iteration count and residual of the velocity solve
+  GEODE_CORE_EXPORT Tuple<int,T> step(const T dt);
+};
+
+}
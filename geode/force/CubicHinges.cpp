@@ -1,11 +1,13 @@
 // Cubic hinges based on Garg et al. 2007
 
 #include <geode/force/CubicHinges.h>
+#include <geode/force/color_elements.h>
 #include <geode/array/view.h>
 #include <geode/math/copysign.h>
 #include <geode/geometry/Triangle3d.h>
 #include <geode/python/Class.h>
 #include <geode/utility/Log.h>
+#include <geode/utility/parallel.h>
 #include <geode/vector/normalize.h>
 #include <geode/vector/SolidMatrix.h>
 #include <geode/vector/SymmetricMatrix.h>
@@ -118,61 +120,73 @@ template<> T CubicHinges<TV3>::slow_elastic_energy(RawArray<const T> angles, Raw
   return sum;
 }
 
-static void compute_info(RawArray<const Vector<int,3>> bends, RawArray<const T> angles, RawArray<const TV2> X, RawArray<CubicHinges<TV2>::Info> info) {
-  for (const int b : range(bends.size())) {
-    auto& I = info[b];
-    int i0,i1,i2;bends[b].get(i0,i1,i2);
-    const TV2 x0 = X[i0], x1 = X[i1], x2 = X[i2];
-    const T cos_rest = cos(angles[b]),
-            sin_rest = sin(angles[b]),
-            len0 = magnitude(x1-x0),
-            len1 = magnitude(x2-x1),
-            ratio = max(len0,len1)/min(len0,len1),
-            decay = ratio<5?1:1/sqr(ratio), // Don't explode as much if edges of very different lengths are adjacent
-            scale = 2*decay/(len0+len1);
-    I.base = scale*(1-cos_rest);
-    I.dot = scale*cos_rest;
-    I.c = vec(1/len0,-1/len0-1/len1,1/len1);
-    I.det = scale/(len0*len1)*sin_rest;
-  }
+static CubicHinges<TV2>::Info bend_info(const Vector<int,3> bend, const T angle, RawArray<const TV2> X) {
+  CubicHinges<TV2>::Info I;
+  int i0,i1,i2;bend.get(i0,i1,i2);
+  const TV2 x0 = X[i0], x1 = X[i1], x2 = X[i2];
+  const T cos_rest = cos(angle),
+          sin_rest = sin(angle),
+          len0 = magnitude(x1-x0),
+          len1 = magnitude(x2-x1),
+          ratio = max(len0,len1)/min(len0,len1),
+          decay = ratio<5?1:1/sqr(ratio), // Don't explode as much if edges of very different lengths are adjacent
+          scale = 2*decay/(len0+len1);
+  I.base = scale*(1-cos_rest);
+  I.dot = scale*cos_rest;
+  I.c = vec(1/len0,-1/len0-1/len1,1/len1);
+  I.det = scale/(len0*len1)*sin_rest;
+  return I;
 }
 
-static void compute_info(RawArray<const Vector<int,4>> bends, RawArray<const T> angles, RawArray<const TV3> X, RawArray<CubicHinges<TV3>::Info> info) {
-  for (const int b : range(bends.size())) {
-    auto& I = info[b];
-    int i0,i1,i2,i3;bends[b].get(i0,i1,i2,i3);
-    // Use our ordering for x, Garg et al.'s for e and t.
-    const TV3 x0 = X[i0], x1 = X[i1], x2 = X[i2], x3 = X[i3],
-              e0 = x2-x1,
-              e1 = x3-x1,
-              e2 = x0-x1,
-              e3 = x3-x2,
-              e4 = x0-x2;
-    const T cross01 = magnitude(cross(e0,e1)),
-            cross02 = magnitude(cross(e0,e2)),
-            cross03 = cross01,
-            cross04 = cross02,
-            dot00 = sqr_magnitude(e0),
-            dot01 =  dot(e0,e1),
-            dot02 =  dot(e0,e2),
-            dot03 = -dot(e0,e3),
-            dot04 = -dot(e0,e4),
-            cot01 = dot01/cross01,
-            cot02 = dot02/cross02,
-            cot03 = dot03/cross03,
-            cot04 = dot04/cross04,
-            max_cot = max(cot01,cot02,cot03,cot04),
-            plate = 6/(cross01+cross02),
-            beta = (cot01+cot03)*(cot02+cot04)/sqrt(dot00),
-            cos_rest = cos(angles[b]),
-            sin_rest = sin(angles[b]);
-    // Degrade gracefully for bad triangles (those with max_cot > 5)
-    const T scale = plate/sqr(max(1,max_cot/5));
-    I.base = scale*dot00*(1-cos_rest);
-    I.dot = scale*cos_rest;
-    I.det = scale*beta*sin_rest;
-    I.c.set(-cot02-cot04,cot03+cot04,cot01+cot02,-cot01-cot03); // Use our ordering for vertices
-  }
+static CubicHinges<TV3>::Info bend_info(const Vector<int,4> bend, const T angle, RawArray<const TV3> X) {
+  CubicHinges<TV3>::Info I;
+  int i0,i1,i2,i3;bend.get(i0,i1,i2,i3);
+  // Use our ordering for x, Garg et al.'s for e and t.
+  const TV3 x0 = X[i0], x1 = X[i1], x2 = X[i2], x3 = X[i3],
+            e0 = x2-x1,
+            e1 = x3-x1,
+            e2 = x0-x1,
+            e3 = x3-x2,
+            e4 = x0-x2;
+  const T cross01 = magnitude(cross(e0,e1)),
+          cross02 = magnitude(cross(e0,e2)),
+          cross03 = cross01,
+          cross04 = cross02,
+          dot00 = sqr_magnitude(e0),
+          dot01 =  dot(e0,e1),
+          dot02 =  dot(e0,e2),
+          dot03 = -dot(e0,e3),
+          dot04 = -dot(e0,e4),
+          cot01 = dot01/cross01,
+          cot02 = dot02/cross02,
+          cot03 = dot03/cross03,
+          cot04 = dot04/cross04,
+          max_cot = max(cot01,cot02,cot03,cot04),
+          plate = 6/(cross01+cross02),
+          beta = (cot01+cot03)*(cot02+cot04)/sqrt(dot00),
+          cos_rest = cos(angle),
+          sin_rest = sin(angle);
+  // Degrade gracefully for bad triangles (those with max_cot > 5)
+  const T scale = plate/sqr(max(1,max_cot/5));
+  I.base = scale*dot00*(1-cos_rest);
+  I.dot = scale*cos_rest;
+  I.det = scale*beta*sin_rest;
+  I.c.set(-cot02-cot04,cot03+cot04,cot01+cot02,-cot01-cot03); // Use our ordering for vertices
+  return I;
+}
+
+template<class TV,int s> static Array<const typename CubicHinges<TV>::Stencil>
+stencils_helper(RawArray<const Vector<int,s>> bends, const Nested<const int>& colors, RawArray<const T> angles, RawArray<const TV> X) {
+  GEODE_ASSERT(bends.size()==angles.size());
+  if (bends.size())
+    GEODE_ASSERT(X.size()>scalar_view(bends).max());
+  Array<typename CubicHinges<TV>::Stencil> stencils(bends.size(),uninit);
+  parallel_for(bends.size(),[&](const int k) {
+    const int b = colors.flat[k];
+    stencils[k].nodes = bends[b];
+    stencils[k].info = bend_info(bends[b],angles[b],X);
+  },256);
+  return stencils;
 }
 
 template<class TV> CubicHinges<TV>::CubicHinges(Array<const Vector<int,d+2>> bends, RawArray<const T> angles, RawArray<const TV> X)
@@ -181,11 +195,8 @@ template<class TV> CubicHinges<TV>::CubicHinges(Array<const Vector<int,d+2>> ben
   , damping(0)
   , simple_hessian(false)
   , nodes_(bends.size()?scalar_view(bends).max()+1:0)
-  , info(bends.size()) {
-  GEODE_ASSERT(bends.size()==angles.size());
-  GEODE_ASSERT(X.size()>=nodes_);
-  compute_info(bends,angles,X,info);
-}
+  , colors(color_elements(bends))
+  , stencils(stencils_helper<TV>(bends.raw(),colors,angles,X)) {}
 
 template<class TV> CubicHinges<TV>::~CubicHinges() {}
 
@@ -210,47 +221,45 @@ template<class TV> T CubicHinges<TV>::strain_rate(RawArray<const TV> V) const {
   return 0;
 }
 
-template<bool simple> static T energy_helper(RawArray<const Vector<int,3>> bends, RawArray<const CubicHinges<TV2>::Info> info, RawArray<const TV2> X) {
-  T sum = 0;
-  for (int b=0;b<bends.size();b++) {
-    const auto& I = info[b];
-    int i0,i1,i2;bends[b].get(i0,i1,i2);
+template<bool simple> static T energy_helper(RawArray<const CubicHinges<TV2>::Stencil> stencils, RawArray<const TV2> X) {
+  return parallel_reduce<T>(stencils.size(),[&](const int k) {
+    const auto& I = stencils[k].info;
+    int i0,i1,i2;stencils[k].nodes.get(i0,i1,i2);
     const TV2 x0 = X[i0], x1 = X[i1], x2 = X[i2],
               strain = I.c[0]*x0+I.c[1]*x1+I.c[2]*x2;
-    sum += I.base+.5*I.dot*sqr_magnitude(strain);
+    T e = I.base+.5*I.dot*sqr_magnitude(strain);
     if (!simple)
-      sum -= I.det*cross(x1-x0,x2-x1);
-  }
-  return sum;
+      e -= I.det*cross(x1-x0,x2-x1);
+    return e;
+  });
 }
 
-template<bool simple> static T energy_helper(RawArray<const Vector<int,4>> bends, RawArray<const CubicHinges<TV3>::Info> info, RawArray<const TV3> X) {
-  T sum = 0;
-  for (int b=0;b<bends.size();b++) {
-    const auto& I = info[b];
-    int i0,i1,i2,i3;bends[b].get(i0,i1,i2,i3);
+template<bool simple> static T energy_helper(RawArray<const CubicHinges<TV3>::Stencil> stencils, RawArray<const TV3> X) {
+  return parallel_reduce<T>(stencils.size(),[&](const int k) {
+    const auto& I = stencils[k].info;
+    int i0,i1,i2,i3;stencils[k].nodes.get(i0,i1,i2,i3);
     const TV3 x0 = X[i0], x1 = X[i1], x2 = X[i2], x3 = X[i3],
               strain = I.c[0]*x0+I.c[1]*x1+I.c[2]*x2+I.c[3]*x3;
-    sum += I.base+.5*I.dot*sqr_magnitude(strain);
+    T e = I.base+.5*I.dot*sqr_magnitude(strain);
     if (!simple)
-      sum += I.det*det(x2-x1,x3-x1,x0-x1);
-  }
-  return sum;
+      e += I.det*det(x2-x1,x3-x1,x0-x1);
+    return e;
+  });
 }
 
 template<class TV> T CubicHinges<TV>::elastic_energy() const {
-  return stiffness?stiffness*energy_helper<false>(bends,info,X):0;
+  return stiffness?stiffness*energy_helper<false>(stencils,X):0;
 }
 
 template<class TV> T CubicHinges<TV>::damping_energy(RawArray<const TV> V) const {
-  return damping?damping*energy_helper<true>(bends,info,V):0;
+  return damping?damping*energy_helper<true>(stencils,V):0;
 }
 
-template<bool simple> static void add_force_helper(RawArray<const Vector<int,3>> bends, RawArray<const CubicHinges<TV2>::Info> info, const T scale, RawArray<TV2> F, RawArray<const TV2> X) {
+template<bool simple> static void add_force_helper(const Nested<const int>& colors, RawArray<const CubicHinges<TV2>::Stencil> stencils, const T scale, RawArray<TV2> F, RawArray<const TV2> X) {
   if (!scale) return;
-  for (int b=0;b<bends.size();b++) {
-    const auto& I = info[b];
-    int i0,i1,i2;bends[b].get(i0,i1,i2);
+  colored_flat_for(colors,[&](const int k) {
+    const auto& I = stencils[k].info;
+    int i0,i1,i2;stencils[k].nodes.get(i0,i1,i2);
     const TV2 x0 = X[i0], x1 = X[i1], x2 = X[i2],
               stress = scale*I.dot*(I.c[0]*x0+I.c[1]*x1+I.c[2]*x2);
     TV2 f0 = I.c[0]*stress,
@@ -262,14 +271,14 @@ template<bool simple> static void add_force_helper(RawArray<const Vector<int,3>>
     F[i0] -= f0;
     F[i1] += f0+f2;
     F[i2] -= f2;
-  }
+  });
 }
 
-template<bool simple> static void add_force_helper(RawArray<const Vector<int,4>> bends, RawArray<const CubicHinges<TV3>::Info> info, const T scale, RawArray<TV3> F, RawArray<const TV3> X) {
+template<bool simple> static void add_force_helper(const Nested<const int>& colors, RawArray<const CubicHinges<TV3>::Stencil> stencils, const T scale, RawArray<TV3> F, RawArray<const TV3> X) {
   if (!scale) return;
-  for (int b=0;b<bends.size();b++) {
-    const auto& I = info[b];
-    int i0,i1,i2,i3;bends[b].get(i0,i1,i2,i3);
+  colored_flat_for(colors,[&](const int k) {
+    const auto& I = stencils[k].info;
+    int i0,i1,i2,i3;stencils[k].nodes.get(i0,i1,i2,i3);
     const TV3 x0 = X[i0], x1 = X[i1], x2 = X[i2], x3 = X[i3],
               stress = scale*I.dot*(I.c[0]*x0+I.c[1]*x1+I.c[2]*x2+I.c[3]*x3);
     if (simple) {
@@ -279,7 +288,6 @@ template<bool simple> static void add_force_helper(RawArray<const Vector<int,4>>
       F[i3] -= I.c[3]*stress;
     } else {
       const T cubic = scale*I.det;
-      const TV3 x0 = X[i0], x1 = X[i1], x2 = X[i2], x3 = X[i3];
       const TV3 ce0 = cubic*(x2-x1),
                 e1 = x3-x1,
                 e2 = x0-x1,
@@ -291,40 +299,39 @@ template<bool simple> static void add_force_helper(RawArray<const Vector<int,4>>
       F[i2] -= I.c[2]*stress+cross12;
       F[i3] -= I.c[3]*stress+cross20;
     }
-  }
+  });
 }
 
 template<class TV> void CubicHinges<TV>::add_elastic_force(RawArray<TV> F) const {
   GEODE_ASSERT(F.size()>=nodes_);
-  add_force_helper<false>(bends,info,stiffness,F,X);
+  add_force_helper<false>(colors,stencils,stiffness,F,X);
 }
 
 template<class TV> void CubicHinges<TV>::add_damping_force(RawArray<TV> F, RawArray<const TV> V) const {
   GEODE_ASSERT(F.size()>=nodes_ && V.size()>=nodes_);
-  add_force_helper<true>(bends,info,damping,F,V);
+  add_force_helper<true>(colors,stencils,damping,F,V);
 }
 
 template<> void CubicHinges<TV2>::add_elastic_differential(RawArray<TV> dF, RawArray<const TV> dX) const {
   // 2D forces are unconditionally linear, so we can always reuse force computation
   GEODE_ASSERT(dF.size()>=nodes_ && dX.size()>=nodes_);
   if (simple_hessian)
-    add_force_helper<true>(bends,info,stiffness,dF,dX);
+    add_force_helper<true>(colors,stencils,stiffness,dF,dX);
   else
-    add_force_helper<false>(bends,info,stiffness,dF,dX);
+    add_force_helper<false>(colors,stencils,stiffness,dF,dX);
 }
 
 template<> void CubicHinges<TV3>::add_elastic_differential(RawArray<TV> dF, RawArray<const TV> dX) const {
   GEODE_ASSERT(dF.size()>=nodes_ && dX.size()>=nodes_);
   if (simple_hessian) // In the simple case, the force is linear and the differential is easy
-    add_force_helper<true>(bends,info,stiffness,dF,dX);
+    add_force_helper<true>(colors,stencils,stiffness,dF,dX);
   else { // Otherwise, we need custom code
-    GEODE_ASSERT(dF.size()>=nodes_ && dX.size()>=nodes_);
     const T scale = stiffness;
     if (!scale) return;
     RawArray<const TV> X = this->X;
-    for (int b=0;b<bends.size();b++) {
-      const auto& I = info[b];
-      int i0,i1,i2,i3;bends[b].get(i0,i1,i2,i3);
+    colored_flat_for(colors,[&](const int k) {
+      const auto& I = stencils[k].info;
+      int i0,i1,i2,i3;stencils[k].nodes.get(i0,i1,i2,i3);
       const TV x0 = X[i0], x1 = X[i1], x2 = X[i2], x3 = X[i3];
       const TV dx0 = dX[i0], dx1 = dX[i1], dx2 = dX[i2], dx3 = dX[i3];
       const TV dstress = scale*I.dot*(I.c[0]*dx0+I.c[1]*dx1+I.c[2]*dx2+I.c[3]*dx3);
@@ -342,7 +349,7 @@ template<> void CubicHinges<TV3>::add_elastic_differential(RawArray<TV> dF, RawA
       dF[i1] -= I.c[1]*dstress-dcross01-dcross12-dcross20;
       dF[i2] -= I.c[2]*dstress+dcross12;
       dF[i3] -= I.c[3]*dstress+dcross20;
-    }
+    });
   }
 }
 
@@ -354,11 +361,12 @@ structure(SolidMatrixStructure& structure) const {
         structure.add_entry(bend[i],bend[j]);
 }
 
-template<bool simple> static void add_gradient_helper(RawArray<const Vector<int,3>> bends, RawArray<const CubicHinges<TV2>::Info> info, const T scale, RawArray<const TV2> X, SolidMatrix<TV2>& matrix) {
+// Bends of one color share no nodes, so they touch disjoint matrix rows and can be added in parallel
+template<bool simple> static void add_gradient_helper(const Nested<const int>& colors, RawArray<const CubicHinges<TV2>::Stencil> stencils, const T scale, RawArray<const TV2> X, SolidMatrix<TV2>& matrix) {
   if (!scale) return;
-  for (int b=0;b<bends.size();b++) {
-    const auto& I = info[b];
-    int i0,i1,i2;bends[b].get(i0,i1,i2);
+  colored_flat_for(colors,[&](const int k) {
+    const auto& I = stencils[k].info;
+    int i0,i1,i2;stencils[k].nodes.get(i0,i1,i2);
     const T quad = -scale*I.dot;
     matrix.add_entry(i0,quad*sqr(I.c[0]));
     matrix.add_entry(i1,quad*sqr(I.c[1]));
@@ -374,14 +382,14 @@ template<bool simple> static void add_gradient_helper(RawArray<const Vector<int,
       matrix.add_entry(i0,i2,quad*I.c[0]*I.c[2]+anti);
       matrix.add_entry(i1,i2,quad*I.c[1]*I.c[2]-anti);
     }
-  }
+  });
 }
 
-template<bool simple> static void add_gradient_helper(RawArray<const Vector<int,4>> bends, RawArray<const CubicHinges<TV3>::Info> info, const T scale, RawArray<const TV3> X, SolidMatrix<TV3>& matrix) {
+template<bool simple> static void add_gradient_helper(const Nested<const int>& colors, RawArray<const CubicHinges<TV3>::Stencil> stencils, const T scale, RawArray<const TV3> X, SolidMatrix<TV3>& matrix) {
   if (!scale) return;
-  for (int b=0;b<bends.size();b++) {
-    const auto& I = info[b];
-    int i0,i1,i2,i3;bends[b].get(i0,i1,i2,i3);
+  colored_flat_for(colors,[&](const int k) {
+    const auto& I = stencils[k].info;
+    int i0,i1,i2,i3;stencils[k].nodes.get(i0,i1,i2,i3);
     const T quad = -scale*I.dot;
     matrix.add_entry(i0,quad*sqr(I.c[0]));
     matrix.add_entry(i1,quad*sqr(I.c[1]));
@@ -404,35 +412,34 @@ template<bool simple> static void add_gradient_helper(RawArray<const Vector<int,
       matrix.add_entry(i1,i3,quad*I.c[1]*I.c[3]+cross_product_matrix(x0-x2)); //  e4
       matrix.add_entry(i2,i3,quad*I.c[2]*I.c[3]+cross_product_matrix(x1-x0)); // -e2
     }
-  }
+  });
 }
 
 template<class TV> void CubicHinges<TV>::
 add_elastic_gradient(SolidMatrix<TV>& matrix) const {
   GEODE_ASSERT(matrix.size()>=nodes_);
   if (simple_hessian)
-    add_gradient_helper<true>(bends,info,stiffness,X,matrix);
+    add_gradient_helper<true>(colors,stencils,stiffness,X,matrix);
   else
-    add_gradient_helper<false>(bends,info,stiffness,X,matrix);
+    add_gradient_helper<false>(colors,stencils,stiffness,X,matrix);
 }
 
 template<class TV> void CubicHinges<TV>::
 add_damping_gradient(SolidMatrix<TV>& matrix) const {
   GEODE_ASSERT(matrix.size()>=nodes_);
-  add_gradient_helper<true>(bends,info,damping,X,matrix);
+  add_gradient_helper<true>(colors,stencils,damping,X,matrix);
 }
 
 template<class TV> void CubicHinges<TV>::add_elastic_gradient_block_diagonal(RawArray<SymmetricMatrix<T,d+1>> dFdX) const {
   GEODE_ASSERT(dFdX.size()>=nodes_);
   if (!stiffness) return;
   const T scale = stiffness;
-  for (int b=0;b<bends.size();b++) {
-    const auto bend = bends[b];
-    const auto& I = info[b];
-    const T quad = scale*I.dot;
-    for (int i=0;i<bend.size();i++)
-      dFdX[bend[i]] -= quad*sqr(I.c[i]);
-  }
+  colored_flat_for(colors,[&](const int k) {
+    const auto& s = stencils[k];
+    const T quad = scale*s.info.dot;
+    for (int i=0;i<s.nodes.size();i++)
+      dFdX[s.nodes[i]] -= quad*sqr(s.info.c[i]);
+  });
 }
 
 template class CubicHinges<TV2>;
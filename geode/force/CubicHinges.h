@@ -1,6 +1,7 @@
 // Cubic hinges based on Garg et al. 2007
 #pragma once
 
+#include <geode/array/Nested.h>
 #include <geode/force/Force.h>
 #include <geode/mesh/forward.h>
 #include <geode/vector/forward.h>
@@ -26,13 +27,20 @@ public:
     T det; // scale on the determinant energy term (quadratic in 2D, cubic in 3D)
   };
 
+  // A bend's nodes together with its coefficients, so that kernels read one contiguous record per bend
+  struct Stencil {
+    Vector<int,d+2> nodes;
+    Info info;
+  };
+
   // Bends around the middle point for segments, or the middle two for triangles
   const Array<const Vector<int,d+2>> bends;
   T stiffness, damping;
   bool simple_hessian;
 private:
   const int nodes_;
-  const Array<Info> info;
+  const Nested<const int> colors; // Bends partitioned so that bends of one color share no nodes
+  const Array<const Stencil> stencils; // Stencil of each bend, stored in colors.flat order
   Array<const TV> X;
 
 protected:
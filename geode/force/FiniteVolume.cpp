@@ -1,12 +1,12 @@
 //#####################################################################
 #include <geode/force/FiniteVolume.h>
+#include <geode/force/color_elements.h>
 #include <geode/force/AnisotropicConstitutiveModel.h>
 #include <geode/force/IsotropicConstitutiveModel.h>
 #include <geode/force/DiagonalizedStressDerivative.h>
 #include <geode/force/DiagonalizedIsotropicStressDerivative.h>
 #include <geode/force/PlasticityModel.h>
 #include <geode/force/StrainMeasure.h>
-#include <geode/structure/Hashtable.h>
 #include <geode/math/Factorial.h>
 #include <geode/python/Class.h>
 #include <geode/vector/DiagonalMatrix.h>
@@ -14,7 +14,9 @@
 #include <geode/vector/SolidMatrix.h>
 #include <geode/vector/SymmetricMatrix.h>
 #include <geode/vector/UpperTriangularMatrix.h>
+#include <geode/vector/batch_decompositions.h>
 #include <geode/utility/Log.h>
+#include <geode/utility/parallel.h>
 namespace geode {
 
 using Log::cout;
@@ -31,6 +33,7 @@ template<class TV,int d> FiniteVolume<TV,d>::FiniteVolume(StrainMeasure<T,d>& st
   , model(ref(model))
   , plasticity(plasticity)
   , Be_scales(strain.elements.size(),uninit)
+  , colors(color_elements(strain.elements))
   , stress_derivatives_valid(false)
   , definite(false) {
   for (int t=0;t<Be_scales.size();t++)
@@ -62,6 +65,21 @@ template<int d> static inline typename enable_if_c<d==2,Matrix<T,3,2>>::type in_
   return Matrix<T,3,2>(U.column(0),U.column(1));
 }
 
+// Singular value decompositions of all deformation gradients at once
+template<int m,int d> static void singular_value_decompositions(RawArray<const Matrix<T,m,d>> F, RawArray<Matrix<T,m>> U,
+                                                                RawArray<DiagonalMatrix<T,d>> D,
+                                                                RawArray<Matrix<T,d>> V) {
+  parallel_for(F.size(),[&](const int t) {
+    F[t].fast_singular_value_decomposition(U[t],D[t],V[t]);
+  },64);
+}
+
+// Volume elements use the batched kernels
+template<> void singular_value_decompositions<3,3>(RawArray<const Matrix<T,3>> F, RawArray<Matrix<T,3>> U,
+                                                   RawArray<DiagonalMatrix<T,3>> D, RawArray<Matrix<T,3>> V) {
+  batch_singular_value_decomposition(F,U,D,V);
+}
+
 template<class TV,int d> void FiniteVolume<TV,d>::update_position(Array<const TV> X,bool definite_) {
   definite = definite_;
   stress_derivatives_valid = false;
@@ -74,7 +92,16 @@ template<class TV,int d> void FiniteVolume<TV,d>::update_position(Array<const TV
   V.clear();
   if (anisotropic)
     V.resize(strain->elements.size(),uninit);
-  for (int t=0;t<strain->elements.size();t++) {
+  // Without plasticity, decompose every element up front
+  Array<Matrix<T,d>> Vs;
+  if (!plasticity) {
+    Array<Matrix<T,m,d>> F(strain->elements.size(),uninit);
+    parallel_for(F.size(),[&](const int t) { F[t] = strain->F(X,t); },256);
+    Vs.resize(F.size(),uninit);
+    singular_value_decompositions<m,d>(F,U,Fe_hat,Vs);
+  }
+  // Elements are independent, and model and plasticity hooks only touch state for their own element
+  parallel_for(strain->elements.size(),[&](const int t) {
     Matrix<T,d> V_;
     if (plasticity) {
       Matrix<T,m,d> F = strain->F(X,t);
@@ -87,37 +114,35 @@ template<class TV,int d> void FiniteVolume<TV,d>::update_position(Array<const TV
       De_inverse_hat[t] = strain->Dm_inverse[t]*plasticity->Fp_inverse[t]*V_;
       Be_scales[t] = -(T)1/Factorial<d>::value/De_inverse_hat[t].determinant();
     } else {
-      strain->F(X,t).fast_singular_value_decomposition(U[t],Fe_hat[t],V_);
+      V_ = Vs[t];
       De_inverse_hat[t] = strain->Dm_inverse[t]*V_;
     }
     if (anisotropic) anisotropic->update_position(Fe_hat[t],V_,t);
     else isotropic->update_position(Fe_hat[t],t);
     if (anisotropic) V[t] = V_;
-  }
+  },64);
 }
 
 template<class TV,int d> typename TV::Scalar FiniteVolume<TV,d>::elastic_energy() const {
-  T energy = 0;
   if (anisotropic)
-    for (int t=0;t<strain->elements.size();t++)
-      energy -= Be_scales[t]*anisotropic->elastic_energy(Fe_hat[t],V[t],t);
+    return -parallel_reduce<T>(strain->elements.size(),[&](const int t) {
+      return Be_scales[t]*anisotropic->elastic_energy(Fe_hat[t],V[t],t); });
   else
-    for (int t=0;t<strain->elements.size();t++)
-      energy -= Be_scales[t]*isotropic->elastic_energy(Fe_hat[t],t);
-  return energy;
+    return -parallel_reduce<T>(strain->elements.size(),[&](const int t) {
+      return Be_scales[t]*isotropic->elastic_energy(Fe_hat[t],t); });
 }
 
 template<class TV,int d> void FiniteVolume<TV,d>::add_elastic_force(RawArray<TV> F) const {
   if (anisotropic)
-    for (int t=0;t<strain->elements.size();t++) {
+    colored_for(colors,[&](const int t) {
       Matrix<T,m,d> forces = in_plane<d>(U[t])*anisotropic->P_From_Strain(Fe_hat[t],V[t],Be_scales[t],t).times_transpose(De_inverse_hat[t]);
       strain->distribute_force(F,t,forces);
-    }
+    });
   else
-    for (int t=0;t<strain->elements.size();t++) {
+    colored_for(colors,[&](const int t) {
       Matrix<T,m,d> forces = in_plane<d>(U[t])*isotropic->P_From_Strain(Fe_hat[t],Be_scales[t],t).times_transpose(De_inverse_hat[t]);
       strain->distribute_force(F,t,forces);
-    }
+    });
 }
 
 template<int m,int d> static inline typename enable_if_c<m==d,const DiagonalizedIsotropicStressDerivative<T,m>&>::type
@@ -141,17 +166,26 @@ template<class TV,int d> void FiniteVolume<TV,d>::update_stress_derivatives() co
   if (anisotropic && !anisotropic->use_isotropic_stress_derivative()) {
     dP_dFe.clear();
     dP_dFe.resize(strain->elements.size(),uninit);
-    for (int t=0;t<strain->elements.size();t++) {
+    parallel_for(strain->elements.size(),[&](const int t) {
       dP_dFe[t] = anisotropic->stress_derivative(Fe_hat[t],V[t],t);
       if (definite) dP_dFe[t].enforce_definiteness();
-    }
+    },64);
   } else {
     dPi_dFe.clear();
     dPi_dFe.resize(strain->elements.size(),uninit);
-    for (int t=0;t<strain->elements.size();t++) {
+    differential_elements.clear();
+    differential_elements.resize(strain->elements.size(),uninit);
+    parallel_for(strain->elements.size(),[&](const int i) {
+      const int t = colors.flat[i];
       dPi_dFe[t] = add_out_of_plane<m>(*isotropic,Fe_hat[t],model->isotropic_stress_derivative(Fe_hat[t],t),t);
       if(definite) dPi_dFe[t].enforce_definiteness();
-    }
+      auto& e = differential_elements[i];
+      e.nodes = strain->elements[t];
+      e.scale = Be_scales[t];
+      e.U = U[t];
+      e.De_inverse_hat = De_inverse_hat[t];
+      e.dPi_dFe = dPi_dFe[t];
+    },64);
   }
   stress_derivatives_valid = true;
 }
@@ -159,18 +193,19 @@ template<class TV,int d> void FiniteVolume<TV,d>::update_stress_derivatives() co
 template<class TV,int d> void FiniteVolume<TV,d>::add_elastic_differential(RawArray<TV> dF, RawArray<const TV> dX) const {
   update_stress_derivatives();
   if (anisotropic && !anisotropic->use_isotropic_stress_derivative())
-    for (int t=0;t<strain->elements.size();t++) {
+    colored_for(colors,[&](const int t) {
       Matrix<T,m,d> dDs = strain->Ds(dX,t),
                     Up = in_plane<d>(U[t]),
                     dG = Up*(Be_scales[t]*dP_dFe[t].differential(Up.transpose_times(dDs)*De_inverse_hat[t]).times_transpose(De_inverse_hat[t]));
       strain->distribute_force(dF,t,dG);
-    }
+    });
   else
-    for (int t=0;t<strain->elements.size();t++) {
-      Matrix<T,m,d> dDs = strain->Ds(dX,t),
-                    dG = U[t]*(Be_scales[t]*dPi_dFe[t].differential(U[t].transpose_times(dDs)*De_inverse_hat[t]).times_transpose(De_inverse_hat[t]));
-      strain->distribute_force(dF,t,dG);
-    }
+    colored_flat_for(colors,[&](const int k) {
+      const auto& e = differential_elements[k];
+      const Matrix<T,m,d> dDs = StrainMeasure<T,d>::Ds(dX,e.nodes),
+                          dG = e.U*(e.scale*e.dPi_dFe.differential(e.U.transpose_times(dDs)*e.De_inverse_hat).times_transpose(e.De_inverse_hat));
+      StrainMeasure<T,d>::distribute_force(dF,e.nodes,dG);
+    });
 }
 
 template<class TV,int d> void FiniteVolume<TV,d>::add_elastic_gradient_block_diagonal(RawArray<SymmetricMatrix<T,m>> dFdX) const {
@@ -200,11 +235,32 @@ template<class TV,int d> void FiniteVolume<TV,d>::add_elastic_gradient_block_dia
   }
 }
 
+// Slots of each element's lower triangle of blocks, looked up again only when the matrix structure changes
+template<class TV,int d> RawArray<const int> FiniteVolume<TV,d>::update_gradient_slots(const SolidMatrix<TV>& matrix) const {
+  if (!gradient_slots.valid(matrix)) {
+    Array<Vector<int,2>> entries;
+    for (const auto& nodes : strain->elements)
+      for (int j=0;j<d+1;j++)
+        for (int i=j;i<d+1;i++)
+          entries.append(vec(nodes[i],nodes[j]));
+    gradient_slots.compute(matrix,entries);
+  }
+  return gradient_slots.slots;
+}
+
+template<class TV,int d> void FiniteVolume<TV,d>::add_gradient_blocks(SolidMatrix<TV>& matrix, RawArray<const int> slots, const int t, const Matrix<T,m> (&dGdD)[d+1][d+1]) const {
+  const Vector<int,d+1> nodes = strain->elements[t];
+  for (int j=0,b=(d+1)*(d+2)/2*t;j<d+1;j++)
+    for (int i=j;i<d+1;i++)
+      matrix.add_entry(slots[b++],nodes[i],nodes[j],dGdD[i][j]);
+}
+
 template<class TV,int d> void FiniteVolume<TV,d>::add_elastic_gradient(SolidMatrix<TV>& matrix) const {
   update_stress_derivatives();
   if (anisotropic && !anisotropic->use_isotropic_stress_derivative())
     GEODE_NOT_IMPLEMENTED();
   else {
+    const auto slots = update_gradient_slots(matrix);
     Matrix<T,m> dGdD[d+1][d+1];
     for (int t=0;t<strain->elements.size();t++) {
       for (int i=0;i<d;i++)
@@ -224,10 +280,7 @@ template<class TV,int d> void FiniteVolume<TV,d>::add_elastic_gradient(SolidMatr
         sum -= sum_i;
       }
       dGdD[0][0] = sum;
-      Vector<int,d+1> nodes = strain->elements[t];
-      for (int j=0;j<d+1;j++)
-        for (int i=j;i<d+1;i++)
-          matrix.add_entry(nodes[i],nodes[j],dGdD[i][j]);
+      add_gradient_blocks(matrix,slots,t,dGdD);
     }
   }
 }
@@ -242,15 +295,16 @@ template<class TV,int d> typename TV::Scalar FiniteVolume<TV,d>::damping_energy(
 }
 
 template<class TV,int d> void FiniteVolume<TV,d>::add_damping_force(RawArray<TV> F,RawArray<const TV> V) const {
-  for (int t=0;t<strain->elements.size();t++) {
+  colored_for(colors,[&](const int t) {
     Matrix<T,m,d> Up = in_plane<d>(U[t]);
     Matrix<T,d> Fe_dot_hat = Up.transpose_times(strain->Ds(V,t))*De_inverse_hat[t];
     Matrix<T,m,d> forces = Up*model->P_From_Strain_Rate(Fe_hat[t],Fe_dot_hat,Be_scales[t],t).times_transpose(De_inverse_hat[t]);
     strain->distribute_force(F,t,forces);
-  }
+  });
 }
 
 template<class TV,int d> void FiniteVolume<TV,d>::add_damping_gradient(SolidMatrix<TV>& matrix) const {
+  const auto slots = update_gradient_slots(matrix);
   Matrix<T,m> dGdD[d+1][d+1];
   for (int t=0;t<strain->elements.size();t++) {
     Matrix<T,m,d> Up = in_plane<d>(U[t]);
@@ -272,32 +326,20 @@ template<class TV,int d> void FiniteVolume<TV,d>::add_damping_gradient(SolidMatr
       sum -= sum_i;
     }
     dGdD[0][0] = sum;
-    Vector<int,d+1> nodes = strain->elements[t];
-    for (int j=0;j<d+1;j++)
-      for (int i=j;i<d+1;i++)
-        matrix.add_entry(nodes[i],nodes[j],dGdD[i][j]);
+    add_gradient_blocks(matrix,slots,t,dGdD);
   }
 }
 
 template<class TV,int d> void FiniteVolume<TV,d>::add_frequency_squared(RawArray<T> frequency_squared) const {
-  Hashtable<int,T> particle_frequency_squared;
-  for (int t=0;t<strain->elements.size();t++) {
-    T elastic_squared = model->maximum_elastic_stiffness(t)/(sqr(strain->rest_altitude(t))*density);
-    const Vector<int,d+1>& nodes = strain->elements(t);
-    for (int j=0;j<nodes.m;j++) {
-      T& data = particle_frequency_squared.get_or_insert(nodes[j]);
-      data = max(data,elastic_squared);
-    }
-  }
-  for (auto& it : particle_frequency_squared)
-    frequency_squared[it.x] += it.y;
+  add_colored_maxima(frequency_squared,colors,[&](const int t) { return strain->elements[t]; },[&](const int t) {
+    return model->maximum_elastic_stiffness(t)/(sqr(strain->rest_altitude(t))*density);
+  });
 }
 
 template<class TV,int d> typename TV::Scalar FiniteVolume<TV,d>::strain_rate(RawArray<const TV> V) const {
-  T strain_rate = 0;
-  for (int t=0;t<strain->elements.size();t++)
-    strain_rate = max(strain_rate,strain->F(V,t).maxabs());
-  return strain_rate;
+  return parallel_reduce<T>(strain->elements.size(),[&](const int t) {
+    return strain->F(V,t).maxabs();
+  },[](T& a, const T b) { a = max(a,b); },256);
 }
 
 template class FiniteVolume<Vector<T,2>,2>;
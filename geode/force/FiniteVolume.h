@@ -3,9 +3,11 @@
 //#####################################################################
 #pragma once
 
+#include <geode/array/Nested.h>
 #include <geode/force/Force.h>
 #include <geode/python/Ptr.h>
 #include <geode/vector/Matrix.h>
+#include <geode/vector/SolidMatrix.h>
 #include <geode/force/StrainMeasure.h>
 #include <geode/force/ConstitutiveModel.h>
 namespace geode {
@@ -29,11 +31,24 @@ protected:
   Array<Matrix<T,d>> V;
   Array<Matrix<T,d>> De_inverse_hat;
   Array<DiagonalMatrix<T,d>> Fe_hat;
+  const Nested<const int> colors; // Elements partitioned so that elements of one color share no nodes
   IsotropicConstitutiveModel<T,d>* isotropic;
   AnisotropicConstitutiveModel<T,d>* anisotropic;
   mutable bool stress_derivatives_valid,definite;
   mutable Array<DiagonalizedIsotropicStressDerivative<T,m,d>> dPi_dFe;
   mutable Array<DiagonalizedStressDerivative<T,d>> dP_dFe;
+
+  // Everything the isotropic differential needs for one element, packed in colors.flat order so that
+  // add_elastic_differential streams through a single array instead of gathering from several.
+  struct DifferentialElement {
+    Vector<int,d+1> nodes;
+    T scale;
+    Matrix<T,m> U;
+    Matrix<T,d> De_inverse_hat;
+    DiagonalizedIsotropicStressDerivative<T,m,d> dPi_dFe;
+  };
+  mutable Array<DifferentialElement> differential_elements;
+  mutable SolidMatrixSlots gradient_slots; // Slots of the element blocks added by add_elastic/damping_gradient
 public:
 
 protected:
@@ -57,6 +72,8 @@ public:
   void add_damping_gradient(SolidMatrix<TV>& matrix) const;
 private:
   void update_stress_derivatives() const;
+  RawArray<const int> update_gradient_slots(const SolidMatrix<TV>& matrix) const;
+  void add_gradient_blocks(SolidMatrix<TV>& matrix, RawArray<const int> slots, const int t, const Matrix<T,m> (&dGdD)[d+1][d+1]) const;
 };
 
 }
@@ -0,0 +1,114 @@
+//#####################################################################
+// Class ForceSet
+//#####################################################################
+#include <geode/force/ForceSet.h>
+#include <geode/python/Class.h>
+#include <geode/python/stl.h>
+#include <geode/utility/parallel.h>
+#include <geode/vector/SolidMatrix.h>
+#include <geode/vector/SymmetricMatrix.h>
+namespace geode {
+
+typedef real T;
+template<> GEODE_DEFINE_TYPE(ForceSet<Vector<T,2>>)
+template<> GEODE_DEFINE_TYPE(ForceSet<Vector<T,3>>)
+
+template<class TV> ForceSet<TV>::ForceSet(const std::vector<Ref<Force<TV>>>& forces)
+  : forces(forces) {}
+
+template<class TV> ForceSet<TV>::~ForceSet() {}
+
+template<class TV> int ForceSet<TV>::nodes() const {
+  int nodes = 0;
+  for (const auto& force : forces)
+    nodes = max(nodes,force->nodes());
+  return nodes;
+}
+
+template<class TV> void ForceSet<TV>::update_position(Array<const TV> X, bool definite) {
+  // Forces only read X and update their own state, so they can run concurrently
+  TaskGroup group;
+  for (const auto& force : forces)
+    group.run([=]() { force->update_position(X,definite); });
+  group.wait();
+}
+
+template<class TV> void ForceSet<TV>::add_frequency_squared(RawArray<T> frequency_squared) const {
+  for (const auto& force : forces)
+    force->add_frequency_squared(frequency_squared);
+}
+
+template<class TV> typename TV::Scalar ForceSet<TV>::elastic_energy() const {
+  T energy = 0;
+  for (const auto& force : forces)
+    energy += force->elastic_energy();
+  return energy;
+}
+
+template<class TV> void ForceSet<TV>::add_elastic_force(RawArray<TV> F) const {
+  for (const auto& force : forces)
+    force->add_elastic_force(F);
+}
+
+template<class TV> void ForceSet<TV>::add_elastic_differential(RawArray<TV> dF, RawArray<const TV> dX) const {
+  for (const auto& force : forces)
+    force->add_elastic_differential(dF,dX);
+}
+
+template<class TV> void ForceSet<TV>::add_elastic_gradient_block_diagonal(RawArray<SymmetricMatrix<T,m>> dFdX) const {
+  for (const auto& force : forces)
+    force->add_elastic_gradient_block_diagonal(dFdX);
+}
+
+template<class TV> typename TV::Scalar ForceSet<TV>::damping_energy(RawArray<const TV> V) const {
+  T energy = 0;
+  for (const auto& force : forces)
+    energy += force->damping_energy(V);
+  return energy;
+}
+
+template<class TV> void ForceSet<TV>::add_damping_force(RawArray<TV> F, RawArray<const TV> V) const {
+  for (const auto& force : forces)
+    force->add_damping_force(F,V);
+}
+
+template<class TV> typename TV::Scalar ForceSet<TV>::strain_rate(RawArray<const TV> V) const {
+  T rate = 0;
+  for (const auto& force : forces)
+    rate = max(rate,force->strain_rate(V));
+  return rate;
+}
+
+template<class TV> void ForceSet<TV>::structure(SolidMatrixStructure& structure) const {
+  for (const auto& force : forces)
+    force->structure(structure);
+}
+
+template<class TV> void ForceSet<TV>::add_elastic_gradient(SolidMatrix<TV>& matrix) const {
+  for (const auto& force : forces)
+    force->add_elastic_gradient(matrix);
+}
+
+template<class TV> void ForceSet<TV>::add_damping_gradient(SolidMatrix<TV>& matrix) const {
+  for (const auto& force : forces)
+    force->add_damping_gradient(matrix);
+}
+
+template class ForceSet<Vector<T,2>>;
+template class ForceSet<Vector<T,3>>;
+}
+using namespace geode;
+
+template<int d> static void wrap_helper() {
+  typedef Vector<T,d> TV;
+  typedef ForceSet<TV> Self;
+  Class<Self>(d==2?"ForceSet2d":"ForceSet3d")
+    .GEODE_INIT(const std::vector<Ref<Force<TV>>>&)
+    .GEODE_FIELD(forces)
+    ;
+}
+
+void wrap_force_set() {
+  wrap_helper<2>();
+  wrap_helper<3>();
+}
@@ -0,0 +1,46 @@
+//#####################################################################
+// Class ForceSet
+//#####################################################################
+//
+// A sum of forces acting on the same nodes, evaluated with one call per pass.
+// Forces write directly into the shared output arrays, so no per-force
+// temporaries are allocated, and the mostly serial update_position work of
+// different forces runs concurrently.
+//
+//#####################################################################
+#pragma once
+
+#include <geode/force/Force.h>
+#include <vector>
+namespace geode {
+
+template<class TV>
+class ForceSet : public Force<TV> {
+public:
+  GEODE_DECLARE_TYPE(GEODE_CORE_EXPORT)
+  typedef Force<TV> Base;
+  typedef typename TV::Scalar T;
+  enum {m=TV::m};
+
+  const std::vector<Ref<Force<TV>>> forces;
+protected:
+  ForceSet(const std::vector<Ref<Force<TV>>>& forces);
+public:
+  ~ForceSet();
+
+  void update_position(Array<const TV> X, bool definite);
+  void add_frequency_squared(RawArray<T> frequency_squared) const;
+  T elastic_energy() const;
+  void add_elastic_force(RawArray<TV> F) const;
+  void add_elastic_differential(RawArray<TV> dF, RawArray<const TV> dX) const;
+  void add_elastic_gradient_block_diagonal(RawArray<SymmetricMatrix<T,m>> dFdX) const;
+  T damping_energy(RawArray<const TV> V) const;
+  void add_damping_force(RawArray<TV> F, RawArray<const TV> V) const;
+  T strain_rate(RawArray<const TV> V) const;
+
+  int nodes() const;
+  void structure(SolidMatrixStructure& structure) const;
+  void add_elastic_gradient(SolidMatrix<TV>& matrix) const;
+  void add_damping_gradient(SolidMatrix<TV>& matrix) const;
+};
+}
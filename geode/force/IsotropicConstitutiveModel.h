@@ -17,6 +17,7 @@ public:
 
   virtual T elastic_energy(const DiagonalMatrix<T,d>& F,const int simplex) const=0;
   virtual DiagonalMatrix<T,d> P_From_Strain(const DiagonalMatrix<T,d>& F,const T scale,const int simplex) const=0;
+  // Called concurrently for different simplices, so it must only touch state for the given simplex
   virtual void update_position(const DiagonalMatrix<T,d>& F,const int simplex){}
 };
 
@@ -2,6 +2,7 @@
 #include <geode/mesh/SegmentSoup.h>
 #include <geode/mesh/TriangleSoup.h>
 #include <geode/utility/Log.h>
+#include <geode/utility/parallel.h>
 #include <geode/vector/SparseMatrix.h>
 #include <geode/vector/SolidMatrix.h>
 #include <geode/vector/SymmetricMatrix.h>
@@ -62,11 +63,27 @@ template<class TV> static Ref<SparseMatrix> matrix_helper(const TriangleSoup& me
   return new_<SparseMatrix>(entries);
 }
 
+// Locate the strictly upper entries by column, so that force computation can gather by row
+static Nested<const Vector<int,2>> transpose_upper(const SparseMatrix& A) {
+  Array<int> counts(A.rows());
+  for (int p=0;p<A.rows();p++)
+    for (int a=1;a<A.J.size(p);a++)
+      counts[A.J(p,a)]++;
+  Nested<Vector<int,2>> lower(counts,uninit);
+  for (int p=A.rows()-1;p>=0;p--)
+    for (int a=A.J.size(p)-1;a>=1;a--) {
+      const int q = A.J(p,a);
+      lower.flat[lower.offsets[q]+--counts[q]] = vec(p,A.J.offsets[p]+a);
+    }
+  return lower;
+}
+
 template<class TV> LinearBendingElements<TV>::LinearBendingElements(const Mesh& mesh,Array<const TV> X)
   : mesh(ref(mesh))
   , stiffness(0)
   , damping(0)
   , A(matrix_helper(mesh,X))
+  , lower(transpose_upper(*A))
   , X(X) {
   // Print max diagonal element
   T max_diagonal = 0;
@@ -106,51 +123,53 @@ template<class TV> typename TV::Scalar LinearBendingElements<TV>::strain_rate(Ra
 
 template<class TV> static T energy_helper(const SparseMatrix& A,RawArray<const TV> X) {
   GEODE_ASSERT(A.rows()==X.size());
-  T diagonal = 0, offdiagonal = 0;
-  for (int p=0;p<A.rows();p++) {
+  return parallel_reduce<T>(A.rows(),[&](const int p) {
     RawArray<const int> J = A.J[p];
-    if (J.size())
-      diagonal += A.A(p,0)*sqr_magnitude(X[p]);
+    if (!J.size())
+      return T(0);
+    TV offdiagonal;
     for (int a=1;a<J.size();a++)
-      offdiagonal += A.A(p,a)*dot(X[p],X[J[a]]);
-  }
-  return diagonal/2+offdiagonal;
+      offdiagonal += A.A(p,a)*X[J[a]];
+    return dot(X[p],A.A(p,0)/2*X[p]+offdiagonal);
+  },256);
 }
 
 template<class TV> typename TV::Scalar LinearBendingElements<TV>::elastic_energy() const {
   return stiffness?stiffness*energy_helper<TV>(*A,X):0;
 }
 
-template<class TV> static void add_force_helper(const SparseMatrix& A,const T scale,RawArray<TV> F,RawArray<const TV> X) {
+template<class TV> static void add_force_helper(const SparseMatrix& A,const Nested<const Vector<int,2>>& lower,const T scale,RawArray<TV> F,RawArray<const TV> X) {
   GEODE_ASSERT(A.rows()<=X.size());
   if (!scale) return;
-  for (int p=0;p<A.rows();p++) {
+  // Each row gathers its stored upper entries and the transposed lower ones, so rows are independent
+  parallel_for(A.rows(),[&](const int p) {
     RawArray<const int> J = A.J[p];
+    TV f;
     if (J.size())
-      F[p] -= scale*A.A(p,0)*X[p];
-    for (int a=1;a<J.size();a++) {
-      int q = J[a];
-      T entry = scale*A.A(p,a);
-      F[p] -= entry*X[q];
-      F[q] -= entry*X[p];
-    }
-  }
+      f += A.A(p,0)*X[p];
+    for (int a=1;a<J.size();a++)
+      f += A.A(p,a)*X[J[a]];
+    for (const auto& pk : lower[p])
+      f += A.A.flat[pk.y]*X[pk.x];
+    F[p] -= scale*f;
+  },256);
 }
 
 template<class TV> void LinearBendingElements<TV>::add_elastic_force(RawArray<TV> F) const {
-  add_force_helper<TV>(*A,stiffness,F,X);
+  add_force_helper<TV>(*A,lower,stiffness,F,X);
 }
 
 template<class TV> void LinearBendingElements<TV>::add_elastic_differential(RawArray<TV> dF,RawArray<const TV> dX) const {
-  add_force_helper<TV>(*A,stiffness,dF,dX);
+  add_force_helper<TV>(*A,lower,stiffness,dF,dX);
 }
 
 template<class TV> void LinearBendingElements<TV>::add_elastic_gradient_block_diagonal(RawArray<SymmetricMatrix<T,d>> dFdX) const {
   GEODE_ASSERT(A->rows()<=dFdX.size());
   if (!stiffness) return;
-  for (int p=0;p<A->rows();p++)
+  parallel_for(A->rows(),[&](const int p) {
     if (A->A.size(p))
       dFdX[p] -= stiffness*A->A(p,0);
+  },1024);
 }
 
 template<class TV> typename TV::Scalar LinearBendingElements<TV>::damping_energy(RawArray<const TV> V) const {
@@ -158,7 +177,7 @@ template<class TV> typename TV::Scalar LinearBendingElements<TV>::damping_energy
 }
 
 template<class TV> void LinearBendingElements<TV>::add_damping_force(RawArray<TV> F,RawArray<const TV> V) const {
-  add_force_helper<TV>(*A,damping,F,V);
+  add_force_helper<TV>(*A,lower,damping,F,V);
 }
 
 template<class TV> void LinearBendingElements<TV>::structure(SolidMatrixStructure& structure) const {
@@ -173,13 +192,14 @@ template<class TV> void add_gradient_helper(const SparseMatrix& A,const T scale,
   GEODE_ASSERT(A.rows()<=matrix.size());
   if (!scale) return;
   T minus_scale = -scale;
-  for (int p=0;p<A.rows();p++) {
+  // Row p of A only touches row p of the matrix, since A stores the upper triangle
+  parallel_for(A.rows(),[&](const int p) {
     RawArray<const int> J = A.J[p];
     if (J.size())
       matrix.add_entry(p,minus_scale*A.A(p,0));
     for (int a=1;a<J.size();a++)
       matrix.add_entry(p,J[a],minus_scale*A.A(p,a));
-  }
+  },256);
 }
 
 template<class TV> void LinearBendingElements<TV>::add_elastic_gradient(SolidMatrix<TV>& matrix) const {
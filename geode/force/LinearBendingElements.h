@@ -3,6 +3,7 @@
 //#####################################################################
 #pragma once
 
+#include <geode/array/Nested.h>
 #include <geode/force/Force.h>
 #include <geode/mesh/forward.h>
 #include <geode/vector/forward.h>
@@ -20,6 +21,7 @@ public:
   T stiffness,damping;
 private:
   Ref<SparseMatrix> A; // only the upper triangle is stored
+  Nested<const Vector<int,2>> lower; // For each row q, (p,k) for the strictly upper entries A.A.flat[k] in column q of row p
   Array<const TV> X;
 
 protected:
@@ -1,8 +1,10 @@
 #include <geode/force/LinearFiniteVolume.h>
+#include <geode/force/color_elements.h>
 #include <geode/array/view.h>
 #include <geode/math/Factorial.h>
 #include <geode/python/Class.h>
 #include <geode/utility/const_cast.h>
+#include <geode/utility/parallel.h>
 #include <geode/vector/normalize.h>
 #include <geode/vector/SolidMatrix.h>
 #include <geode/vector/SymmetricMatrix.h>
@@ -28,11 +30,13 @@ template<class TV,int d> LinearFiniteVolume<TV,d>::LinearFiniteVolume(Array<cons
   , youngs_modulus(youngs_modulus)
   , poissons_ratio(poissons_ratio)
   , rayleigh_coefficient(rayleigh_coefficient)
+  , cache_stiffness(false)
   , nodes_(elements.size()?1+scalar_view(elements).max():0)
   , density(density)
   , Dm_inverse(elements.size(),uninit)
   , normals((int)m>(int)d?elements.size():0,uninit)
-  , Bm_scales(elements.size(),uninit) {
+  , Bm_scales(elements.size(),uninit)
+  , colors(color_elements(elements)) {
   update_position(X_,false);
   for (int t=0;t<elements.size();t++) {
     Matrix<T,m,d> Dm = Ds(X,t);
@@ -66,16 +70,14 @@ template<class TV,int d> Vector<typename TV::Scalar,2> LinearFiniteVolume<TV,d>:
 
 template<class TV,int d> typename TV::Scalar LinearFiniteVolume<TV,d>::elastic_energy() const {
   GEODE_ASSERT(X.size()>=nodes_);
-  T energy = 0;
   T mu,lambda;mu_lambda().get(mu,lambda);
   T half_lambda = (T).5*lambda;
-  for (int t=0;t<elements.size();t++) {
+  return -parallel_reduce<T>(elements.size(),[&](const int t) {
     SymmetricMatrix<T,m> strain = symmetric_part(Ds(X,t)*Dm_inverse[t])-1;
     if ((int)m>(int)d)
       strain += outer_product(normals[t]);
-    energy -= Bm_scales[t]*(mu*strain.sqr_frobenius_norm()+half_lambda*sqr(strain.trace()));
-  }
-  return energy;
+    return Bm_scales[t]*(mu*strain.sqr_frobenius_norm()+half_lambda*sqr(strain.trace()));
+  });
 }
 
 template<class TV,int d> void LinearFiniteVolume<TV,d>::add_elastic_force(RawArray<TV> F) const {
@@ -83,24 +85,66 @@ template<class TV,int d> void LinearFiniteVolume<TV,d>::add_elastic_force(RawArr
   T mu,lambda;mu_lambda().get(mu,lambda);
   T two_mu = 2*mu;
   T two_mu_plus_m_lambda = 2*mu+m*lambda;
-  for (int t=0;t<elements.size();t++) {
+  colored_for(colors,[&](const int t) {
     SymmetricMatrix<T,m> strain_plus_one = symmetric_part(Ds(X,t)*Dm_inverse[t]);
     if ((int)m>(int)d)
       strain_plus_one += outer_product(normals[t]);
     SymmetricMatrix<T,m> scaled_stress = Bm_scales[t]*two_mu*strain_plus_one+Bm_scales[t]*(lambda*strain_plus_one.trace()-two_mu_plus_m_lambda);
     StrainMeasure<T,d>::distribute_force(F,elements[t],scaled_stress.times_transpose(Dm_inverse[t]));
-  }
+  });
+}
+
+// Linear elasticity with displacement gradient sum_b dx_b g_b^T and stress c(2 mu strain + lambda tr(strain)) applied to
+// g_a gives node a the force sum_b K_ab dx_b with the following blocks.
+template<class T,int m> static inline Matrix<T,m> stiffness_block(const T c, const T mu, const T lambda, const Vector<T,m>& ga, const Vector<T,m>& gb) {
+  return c*(mu*(dot(ga,gb)+outer_product(gb,ga))+lambda*outer_product(ga,gb));
+}
+
+template<class TV,int d> const SolidMatrix<TV>& LinearFiniteVolume<TV,d>::cached_stiffness() const {
+  const auto mu_lambda = this->mu_lambda();
+  if (stiffness && stiffness_mu_lambda==mu_lambda)
+    return *stiffness;
+  if (!stiffness) {
+    const auto structure = new_<SolidMatrixStructure>(nodes_);
+    for (const auto& nodes : elements)
+      for (int a=0;a<d+1;a++)
+        for (int b=a+1;b<d+1;b++)
+          structure->add_entry(nodes[a],nodes[b]);
+    stiffness = new_<SolidMatrix<TV>>(*structure);
+  } else
+    stiffness->zero();
+  T mu,lambda;mu_lambda.get(mu,lambda);
+  SolidMatrix<TV>& K = *stiffness;
+  colored_for(colors,[&](const int t) {
+    const auto& nodes = elements[t];
+    Vector<TV,d+1> g;
+    for (int a=0;a<d;a++) {
+      g[a+1] = Dm_inverse[t].row(a);
+      g[0] -= g[a+1];
+    }
+    for (int a=0;a<d+1;a++)
+      for (int b=a;b<d+1;b++)
+        K.add_entry(nodes[a],nodes[b],stiffness_block(Bm_scales[t],mu,lambda,g[a],g[b]));
+  });
+  stiffness_mu_lambda = mu_lambda;
+  return K;
 }
 
 template<class TV,int d> void LinearFiniteVolume<TV,d>::add_differential_helper(RawArray<TV> dF, RawArray<const TV> dX, T scale) const {
   GEODE_ASSERT(X.size()>=nodes_ && dF.size()==X.size() && dX.size()==X.size());
+  if (cache_stiffness) {
+    Array<TV> KdX(nodes_,uninit);
+    cached_stiffness().multiply(dX.slice(0,nodes_),KdX);
+    parallel_for(nodes_,[&](const int i) { dF[i] += scale*KdX[i]; },1024);
+    return;
+  }
   T mu,lambda;(scale*mu_lambda()).get(mu,lambda);
   T two_mu = 2*mu;
-  for (int t=0;t<elements.size();t++) {
+  colored_for(colors,[&](const int t) {
     SymmetricMatrix<T,m> d_strain = symmetric_part(Ds(dX,t)*Dm_inverse[t]);
     SymmetricMatrix<T,m> d_scaled_stress = Bm_scales[t]*two_mu*d_strain+Bm_scales[t]*lambda*d_strain.trace();
     StrainMeasure<T,d>::distribute_force(dF,elements[t],d_scaled_stress.times_transpose(Dm_inverse[t]));
-  }
+  });
 }
 
 template<class TV,int d> void LinearFiniteVolume<TV,d>::add_elastic_differential(RawArray<TV> dF, RawArray<const TV> dX) const {
@@ -139,24 +183,16 @@ template<class T> inline T simplex_minimum_altitude(const Matrix<T,2,3>& Dm_inve
 template<class TV,int d> void LinearFiniteVolume<TV,d>::add_frequency_squared(RawArray<T> frequency_squared) const {
   T mu,lambda;mu_lambda().get(mu,lambda);
   T stiffness = lambda+2*mu;
-  Hashtable<int,T> particle_frequency_squared;
-  for (int t=0;t<elements.size();t++) {
-    T elastic_squared = stiffness/(sqr(simplex_minimum_altitude(Dm_inverse[t]))*density);
-    for (int i=0;i<d+1;i++) {
-      T& data = particle_frequency_squared.get_or_insert(elements[t][i]);
-      data = max(data,elastic_squared);
-    }
-  }
-  for (auto& it : particle_frequency_squared)
-    frequency_squared[it.x] += it.y;
+  add_colored_maxima(frequency_squared,colors,[&](const int t) { return elements[t]; },[&](const int t) {
+    return stiffness/(sqr(simplex_minimum_altitude(Dm_inverse[t]))*density);
+  });
 }
 
 template<class TV,int d> typename TV::Scalar LinearFiniteVolume<TV,d>::strain_rate(RawArray<const TV> V) const {
   GEODE_ASSERT(V.size()>=nodes_);
-  T strain_rate=0;
-  for (int t=0;t<elements.size();t++)
-    strain_rate=max(strain_rate,(Ds(V,t)*Dm_inverse[t]).maxabs());
-  return strain_rate;
+  return parallel_reduce<T>(elements.size(),[&](const int t) {
+    return (Ds(V,t)*Dm_inverse[t]).maxabs();
+  },[](T& a, const T b) { a = max(a,b); },256);
 }
 
 template<class TV,int d> void LinearFiniteVolume<TV,d>::structure(SolidMatrixStructure& structure) const {
@@ -187,15 +223,18 @@ void wrap_linear_finite_volume() {
   {typedef LinearFiniteVolume<Vector<T,2>,2> Self;
   Class<Self>("LinearFiniteVolume2d")
     .GEODE_INIT(Array<const Vector<int,3>>,Array<const Vector<T,2>>,T,T,T,T)
+    .GEODE_FIELD(cache_stiffness)
     ;}
 
   {typedef LinearFiniteVolume<Vector<T,3>,2> Self;
   Class<Self>("LinearFiniteVolumeS3d")
     .GEODE_INIT(Array<const Vector<int,3>>,Array<const Vector<T,3>>,T,T,T,T)
+    .GEODE_FIELD(cache_stiffness)
     ;}
 
   {typedef LinearFiniteVolume<Vector<T,3>,3> Self;
   Class<Self>("LinearFiniteVolume3d")
     .GEODE_INIT(Array<const Vector<int,4>>,Array<const Vector<T,3>>,T,T,T,T)
+    .GEODE_FIELD(cache_stiffness)
     ;}
 }
@@ -3,8 +3,10 @@
 //#####################################################################
 #pragma once
 
+#include <geode/array/Nested.h>
 #include <geode/force/Force.h>
 #include <geode/force/StrainMeasure.h>
+#include <geode/python/Ptr.h>
 namespace geode {
 
 template<class TV,int d_>
@@ -21,13 +23,17 @@ public:
   T youngs_modulus;
   T poissons_ratio;
   T rayleigh_coefficient;
+  bool cache_stiffness; // If true, differentials and damping forces apply a stiffness matrix assembled once per choice of material parameters
   const int nodes_;
   const T density;
   const Array<const Matrix<T,d,m>> Dm_inverse;
 private:
   Array<TV> normals;
   Array<T> Bm_scales; // Bm[t] = Bm_scales[t]*Dm_inverse[t].transposed()
+  const Nested<const int> colors; // Elements partitioned so that elements of one color share no nodes
   Array<const TV> X;
+  mutable Ptr<SolidMatrix<TV>> stiffness; // Cached dF/dX, valid for the mu and lambda in stiffness_mu_lambda
+  mutable Vector<T,2> stiffness_mu_lambda;
 
 protected:
   LinearFiniteVolume(Array<const Vector<int,d+1>> elements, Array<const TV> X, const T density, const T youngs_modulus, const T poissons_ratio, const T rayleigh_coefficient);
@@ -56,6 +62,7 @@ public:
   void add_damping_gradient(SolidMatrix<TV>& matrix) const;
 private:
   void add_differential_helper(RawArray<TV> dF, RawArray<const TV> dX, T scale) const;
+  const SolidMatrix<TV>& cached_stiffness() const;
 };
 
 }
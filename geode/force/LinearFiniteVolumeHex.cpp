@@ -18,6 +18,7 @@ LinearFiniteVolumeHex::LinearFiniteVolumeHex(const StrainMeasureHex& strain, con
   , youngs_modulus(youngs_modulus)
   , poissons_ratio(poissons_ratio)
   , rayleigh_coefficient(rayleigh_coefficient)
+  , cache_stiffness(false)
   , density(density) {
   X = strain.rest_X;
 }
@@ -64,8 +65,49 @@ void LinearFiniteVolumeHex::add_elastic_force(RawArray<TV> F) const {
     }
 }
 
+const SolidMatrix<TV>& LinearFiniteVolumeHex::cached_stiffness() const {
+  const auto mu_lambda = this->mu_lambda();
+  if (stiffness && stiffness_mu_lambda==mu_lambda)
+    return *stiffness;
+  if (!stiffness) {
+    const auto structure = new_<SolidMatrixStructure>(strain->nodes);
+    for (const auto& nodes : strain->elements)
+      for (int a=0;a<8;a++)
+        for (int b=a+1;b<8;b++)
+          structure->add_entry(nodes[a],nodes[b]);
+    stiffness = new_<SolidMatrix<TV>>(*structure);
+  } else
+    stiffness->zero();
+  T mu,lambda;mu_lambda.get(mu,lambda);
+  // With displacement gradient sum_b dx_b h_b^T at each gauss point, node a feels sum_b K_ab dx_b
+  SolidMatrix<TV>& K = *stiffness;
+  for (int h=0;h<strain->elements.size();h++) {
+    const auto& nodes = strain->elements[h];
+    for (int a=0;a<8;a++)
+      for (int b=a;b<8;b++) {
+        Matrix<T,m> Kab;
+        for (int g=0;g<8;g++) {
+          const TV ha = strain->H_DmH_inverse[h][g][a],
+                   hb = strain->H_DmH_inverse[h][g][b];
+          Kab -= strain->DmH_det[h][g]*(mu*(dot(ha,hb)+outer_product(hb,ha))+lambda*outer_product(ha,hb));
+        }
+        K.add_entry(nodes[a],nodes[b],Kab);
+      }
+  }
+  stiffness_mu_lambda = mu_lambda;
+  return K;
+}
+
 void LinearFiniteVolumeHex::add_differential_helper(RawArray<TV> dF, RawArray<const TV> dX, T scale) const {
   GEODE_ASSERT(X.size()>=strain->nodes && dF.size()==X.size() && dX.size()==X.size());
+  if (cache_stiffness) {
+    const int n = strain->nodes;
+    Array<TV> KdX(n,uninit);
+    cached_stiffness().multiply(dX.slice(0,n),KdX);
+    for (int i=0;i<n;i++)
+      dF[i] += scale*KdX[i];
+    return;
+  }
   T mu,lambda;(scale*mu_lambda()).get(mu,lambda);
   T two_mu = 2*mu;
   for (int h=0;h<strain->elements.size();h++)
@@ -149,5 +191,6 @@ void wrap_linear_finite_volume_hex() {
   typedef LinearFiniteVolumeHex Self;
   Class<Self>("LinearFiniteVolumeHex")
     .GEODE_INIT(const StrainMeasureHex&,T,T,T,T)
+    .GEODE_FIELD(cache_stiffness)
     ;
 }
@@ -5,6 +5,7 @@
 
 #include <geode/force/Force.h>
 #include <geode/force/StrainMeasureHex.h>
+#include <geode/python/Ptr.h>
 namespace geode {
 
 class LinearFiniteVolumeHex : public Force<Vector<real,3>>
@@ -20,9 +21,12 @@ public:
   T youngs_modulus;
   T poissons_ratio;
   T rayleigh_coefficient;
+  bool cache_stiffness; // If true, differentials and damping forces apply a stiffness matrix assembled once per choice of material parameters
   const T density;
 private:
   Array<const TV> X;
+  mutable Ptr<SolidMatrix<TV>> stiffness; // Cached dF/dX, valid for the mu and lambda in stiffness_mu_lambda
+  mutable Vector<T,2> stiffness_mu_lambda;
 
 protected:
   LinearFiniteVolumeHex(const StrainMeasureHex& strain, const T density, const T youngs_modulus, const T poissons_ratio, const T rayleigh_coefficient);
@@ -47,6 +51,7 @@ public:
   void add_damping_gradient(SolidMatrix<TV>& matrix) const;
 private:
   void add_differential_helper(RawArray<TV> dF, RawArray<const TV> dX, T scale) const;
+  const SolidMatrix<TV>& cached_stiffness() const;
 };
 
 }
@@ -21,6 +21,7 @@ public:
   virtual ~PlasticityModel() {}
 
   virtual bool project_Fe(const DiagonalMatrix<T,d>& Fe_trial,DiagonalMatrix<T,d>& Fe_project) const=0;
+  // Called concurrently for different tetrahedra, so it must only touch state for the given tetrahedron
   virtual void project_Fp(const int tetrahedron,const Matrix<T,d>& Fp_trial)=0;
 };
 
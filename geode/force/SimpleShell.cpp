@@ -1,6 +1,7 @@
 // Specialized finite volume model for in-plane, anisotropic shell forces.
 
 #include <geode/force/SimpleShell.h>
+#include <geode/force/color_elements.h>
 #include <geode/force/StrainMeasure.h>
 #include <geode/python/Class.h>
 #include <geode/utility/Log.h>
@@ -25,7 +26,8 @@ SimpleShell::SimpleShell(const TriangleSoup& mesh, RawArray<const Matrix<T,2>> D
   , F_threshold(.1)
   , nodes_(mesh.nodes())
   , definite_(false)
-  , info(mesh.elements.size(),uninit) {
+  , info(mesh.elements.size(),uninit)
+  , colors(color_elements(mesh.elements)) {
   GEODE_ASSERT(mesh.elements.size()==Dm.size());
   for (int t=0;t<mesh.elements.size();t++) {
     auto& I = info[t];
@@ -159,7 +161,8 @@ static inline Matrix<T,3,2> in_plane(const Matrix<T,3>& Q) {
 }
 
 void SimpleShell::add_elastic_force(RawArray<TV> F) const {
-  for (const auto& I : info) {
+  colored_for(colors,[&](const int t) {
+    const auto& I = info[t];
     // Evaluate force pretending that Fh stays symmetric
     const auto Phs = simple_P(I);
     // Account for rotation induced by antisymmetric components of d(Q'F).
@@ -174,7 +177,7 @@ void SimpleShell::add_elastic_force(RawArray<TV> F) const {
     // Apply force
     const auto forces = in_plane(I.Q)*Ph.times_transpose(I.inv_Dm);
     Strain::distribute_force(F,I.nodes,forces);
-  }
+  });
 }
 
 template<bool definite> inline Matrix<T,3,2> SimpleShell::force_differential(const Info& I, const Matrix<T,3,2>& dDs) const {
@@ -213,11 +216,15 @@ template<bool definite> inline Matrix<T,3,2> SimpleShell::force_differential(con
 
 void SimpleShell::add_elastic_differential(RawArray<TV> dF, RawArray<const TV> dX) const {
   if (definite_)
-    for (const auto& I : info)
+    colored_for(colors,[&](const int t) {
+      const auto& I = info[t];
       Strain::distribute_force(dF,I.nodes,force_differential<true >(I,Strain::Ds(dX,I.nodes)));
+    });
   else
-    for (const auto& I : info)
+    colored_for(colors,[&](const int t) {
+      const auto& I = info[t];
       Strain::distribute_force(dF,I.nodes,force_differential<false>(I,Strain::Ds(dX,I.nodes)));
+    });
 }
 
 void SimpleShell::add_elastic_gradient_block_diagonal(RawArray<SymmetricMatrix<T,3>> dFdX) const {
@@ -272,23 +279,15 @@ void SimpleShell::add_damping_gradient(SolidMatrix<TV>& matrix) const {
 
 void SimpleShell::add_frequency_squared(RawArray<T> frequency_squared) const {
   const T max_stiff = stiffness().maxabs();
-  Hashtable<int,T> particle_frequency_squared;
-  for (const auto& I : info) {
-    const T elastic_squared = max_stiff/(sqr(I.inv_Dm.inverse().simplex_minimum_altitude())*density);
-    for (const int n : I.nodes) {
-      T& data = particle_frequency_squared.get_or_insert(n);
-      data = max(data,elastic_squared);
-    }
-  }
-  for (auto& it : particle_frequency_squared)
-    frequency_squared[it.x] += it.y;
+  add_colored_maxima(frequency_squared,colors,[&](const int t) { return info[t].nodes; },[&](const int t) {
+    return max_stiff/(sqr(info[t].inv_Dm.inverse().simplex_minimum_altitude())*density);
+  });
 }
 
 T SimpleShell::strain_rate(RawArray<const TV> V) const {
-  T strain_rate = 0;
-  for (const auto& I : info)
-    strain_rate = max(strain_rate,(Strain::Ds(V,I.nodes)*I.inv_Dm).maxabs());
-  return strain_rate;
+  return parallel_reduce<T>(info.size(),[&](const int t) {
+    return (Strain::Ds(V,info[t].nodes)*info[t].inv_Dm).maxabs();
+  },[](T& a, const T b) { a = max(a,b); },256);
 }
 
 }
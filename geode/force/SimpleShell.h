@@ -12,6 +12,7 @@
 // Since SimpleShell is natively anisotropic, Dm cannot be QR-decomposed, and we can't
 // use StrainMeasure<T,2> directly.
 
+#include <geode/array/Nested.h>
 #include <geode/force/Force.h>
 #include <geode/mesh/TriangleSoup.h>
 #include <geode/vector/Matrix.h>
@@ -47,6 +48,7 @@ protected:
     T c0,c1; // Constants for 4x4 in-plane block due to DPhs
   };
   Array<Info> info;
+  Nested<const int> colors; // Triangles partitioned so that triangles of one color share no nodes
 
   SimpleShell(const TriangleSoup& mesh, RawArray<const Matrix<T,2>> Dm, const T density);
 public:
@@ -2,6 +2,7 @@
 // Class Springs
 //#####################################################################
 #include <geode/force/Springs.h>
+#include <geode/force/color_elements.h>
 #include <geode/array/NdArray.h>
 #include <geode/array/ProjectedArray.h>
 #include <geode/array/view.h>
@@ -22,7 +23,8 @@ template<class TV> Springs<TV>::Springs(Array<const Vector<int,2>> springs, Arra
   , off_axis_damping(0)
   , nodes_(X.size())
   , mass(mass)
-  , info(springs.size(),uninit) {
+  , info(springs.size(),uninit)
+  , colors(color_elements(springs)) {
   GEODE_ASSERT(!springs.size() || scalar_view(springs).max()<nodes_);
   GEODE_ASSERT(mass.size()==nodes_);
   GEODE_ASSERT(stiffness.rank()==0 || (stiffness.rank()==1 && stiffness.shape[0]==springs.size()));
@@ -62,7 +64,7 @@ structure(SolidMatrixStructure& structure) const {
 template<class TV> void Springs<TV>::update_position(Array<const TV> X_, const bool definite) {
   GEODE_ASSERT(X_.size()==nodes_);
   X = X_;
-  for (int s=0;s<springs.size();s++) {
+  parallel_for(springs.size(),[&](const int s) {
     int i,j;springs[s].get(i,j);
     SpringInfo<TV>& I = info[s];
     I.direction = X[j]-X[i];
@@ -78,59 +80,48 @@ template<class TV> void Springs<TV>::update_position(Array<const TV> X_, const b
         I.beta -= rotational;
       }
     }
-  }
+  },1024);
 }
 
 template<class TV> void Springs<TV>::add_frequency_squared(RawArray<T> frequency_squared) const {
   GEODE_ASSERT(frequency_squared.size()==nodes_);
-  for (int s=0;s<springs.size();s++) {
+  colored_for(colors,[&](const int s) {
     int i,j;springs[s].get(i,j);
     const SpringInfo<TV>& I=info[s];
     frequency_squared[i] += 4*I.stiffness/mass[i];
     frequency_squared[j] += 4*I.stiffness/mass[j];
-  }
+  });
 }
 
 template<class TV> T Springs<TV>::elastic_energy() const {
-  T energy = 0;
-  if (resist_compression)
-    for (int s=0;s<springs.size();s++) {
-      int i,j;springs[s].get(i,j);
-      const SpringInfo<TV>& I = info[s];
-      energy += I.stiffness*sqr(I.length-I.restlength);
-    }
-  else
-    for (int s=0;s<springs.size();s++) {
-      int i,j;springs[s].get(i,j);
-      const SpringInfo<TV>& I=info[s];
-      if (I.length>I.restlength)
-        energy += I.stiffness*sqr(I.length-I.restlength);
-    }
-  return energy/2;
+  return parallel_reduce<T>(springs.size(),[&](const int s) {
+    const SpringInfo<TV>& I = info[s];
+    return resist_compression || I.length>I.restlength ? I.stiffness*sqr(I.length-I.restlength) : 0;
+  },1024)/2;
 }
 
 template<class TV> void Springs<TV>::add_elastic_force(RawArray<TV> F) const {
   GEODE_ASSERT(F.size()==nodes_);
-  for (int s=0;s<springs.size();s++) {
+  colored_for(colors,[&](const int s) {
     int i,j;springs[s].get(i,j);
     const SpringInfo<TV>& I=info[s];
     TV f = I.stiffness*(I.length-I.restlength)*I.direction;
     F[i] += f;
     F[j] -= f;
-  }
+  });
 }
 
 template<class TV> void Springs<TV>::add_elastic_differential(RawArray<TV> dF, RawArray<const TV> dX) const {
   GEODE_ASSERT(dF.size()==nodes_);
   GEODE_ASSERT(dX.size()==nodes_);
-  for (int s=0;s<springs.size();s++) {
-    int i,j;springs[s].get(i,j); 
+  colored_for(colors,[&](const int s) {
+    int i,j;springs[s].get(i,j);
     const SpringInfo<TV>& I=info[s];
     TV dx = dX[j]-dX[i];
     TV f = I.alpha*dx+I.beta*dot(dx,I.direction)*I.direction;
     dF[i] += f;
     dF[j] -= f;
-  }
+  });
 }
 
 template<class TV> void Springs<TV>::add_elastic_gradient(SolidMatrix<TV>& matrix) const {
@@ -147,58 +138,49 @@ template<class TV> void Springs<TV>::add_elastic_gradient(SolidMatrix<TV>& matri
 
 template<class TV> void Springs<TV>::add_elastic_gradient_block_diagonal(RawArray<SymmetricMatrix<T,m>> dFdX) const {
   GEODE_ASSERT(dFdX.size()==nodes_);
-  for (int s=0;s<springs.size();s++) {
-    int i,j;springs[s].get(i,j); 
+  colored_for(colors,[&](const int s) {
+    int i,j;springs[s].get(i,j);
     const SpringInfo<TV>& I = info[s];
     SymmetricMatrix<T,m> A = scaled_outer_product(I.beta,I.direction)+I.alpha;
     dFdX[i] -= A;
     dFdX[j] -= A;
-  }
+  });
 }
 
 template<class TV> T Springs<TV>::damping_energy(RawArray<const TV> V) const {
   GEODE_ASSERT(V.size()==nodes_);
-  T energy=0;
-  if (!off_axis_damping)
-    for (int s=0;s<springs.size();s++) {
-      int i,j;springs[s].get(i,j);
-      const SpringInfo<TV>& I=info[s];
-      energy += I.damping*sqr(dot(V[j]-V[i],I.direction));
-    }
-  else {
-    const T alpha = off_axis_damping,
-            beta = 1-off_axis_damping;
-    for (int s=0;s<springs.size();s++) {
-      int i,j;springs[s].get(i,j);
-      const SpringInfo<TV>& I=info[s];
-      TV dv = V[j]-V[i];
-      energy += I.damping*(alpha*sqr_magnitude(dv)+beta*sqr(dot(dv,I.direction)));
-    }
-  }
-  return energy/2;
+  const T alpha = off_axis_damping,
+          beta = 1-off_axis_damping;
+  return parallel_reduce<T>(springs.size(),[&](const int s) {
+    int i,j;springs[s].get(i,j);
+    const SpringInfo<TV>& I=info[s];
+    TV dv = V[j]-V[i];
+    return alpha ? I.damping*(alpha*sqr_magnitude(dv)+beta*sqr(dot(dv,I.direction)))
+                 : I.damping*sqr(dot(dv,I.direction));
+  },1024)/2;
 }
 
 template<class TV> void Springs<TV>::add_damping_force(RawArray<TV> force,RawArray<const TV> V) const {
   GEODE_ASSERT(V.size()==nodes_);
   GEODE_ASSERT(force.size()==nodes_);
   if (!off_axis_damping)
-    for (int s=0;s<springs.size();s++) {
+    colored_for(colors,[&](const int s) {
       int i,j;springs[s].get(i,j);
       const SpringInfo<TV>& I=info[s];
       TV f = I.damping*dot(V[j]-V[i],I.direction)*I.direction;
       force[i]+=f;force[j]-=f;
-    }
+    });
   else {
     const T alpha = off_axis_damping,
             beta = 1-off_axis_damping;
-    for (int s=0;s<springs.size();s++) {
+    colored_for(colors,[&](const int s) {
       int i,j;springs[s].get(i,j);
       const SpringInfo<TV>& I=info[s];
       TV dv = V[j]-V[i];
       TV f = alpha*I.damping*dv+beta*I.damping*dot(dv,I.direction)*I.direction;
       force[i] += f;
       force[j] -= f;
-    }
+    });
   }
 }
 
@@ -229,14 +211,11 @@ template<class TV> void Springs<TV>::add_damping_gradient(SolidMatrix<TV>& matri
 }
 
 template<class TV> T Springs<TV>::strain_rate(RawArray<const TV> V) const {
-  T max_strain_rate = 0;
-  for (int s=0;s<springs.size();s++) {
+  return parallel_reduce<T>(springs.size(),[&](const int s) {
     int i,j;springs[s].get(i,j);
     const SpringInfo<TV>& I = info[s];
-    T strain_rate = dot(V[j]-V[i],I.direction)/I.restlength;
-    max_strain_rate = max(max_strain_rate,abs(strain_rate));
-  }
-  return max_strain_rate;
+    return abs(dot(V[j]-V[i],I.direction)/I.restlength);
+  },[](T& a, const T b) { a = max(a,b); },1024);
 }
 
 template<class TV> Box<T> Springs<TV>::limit_strain(RawArray<TV> X) const {
@@ -8,6 +8,7 @@
 #pragma once
 
 #include <geode/array/Array.h>
+#include <geode/array/Nested.h>
 #include <geode/force/Force.h>
 #include <geode/vector/Vector.h>
 #include <geode/geometry/Box.h>
@@ -37,6 +38,7 @@ private:
   Array<const T> mass;
   Array<const TV> X;
   const Array<SpringInfo<TV>> info;
+  const Nested<const int> colors; // Springs partitioned so that springs of one color share no nodes
 protected:
   Springs(Array<const Vector<int,2>> springs, Array<const T> mass, Array<const TV> X, NdArray<const T> stiffness, NdArray<const T> damping_ratio);
 public:
@@ -7,10 +7,13 @@
 #include <geode/structure/Pair.h>
 #include <geode/geometry/ParticleTree.h>
 #include <geode/geometry/SimplexTree.h>
+#include <geode/geometry/Triangle3d.h>
 #include <geode/python/Class.h>
 #include <geode/utility/Log.h>
+#include <geode/utility/parallel.h>
 #include <geode/vector/SolidMatrix.h>
 #include <geode/vector/SymmetricMatrix.h>
+#include <limits>
 namespace geode {
 
 using Log::cout;
@@ -24,12 +27,15 @@ SurfacePins::SurfacePins(Array<const int> particles, Array<const T> mass, Triang
   : particles(particles)
   , target_mesh(ref(target_mesh))
   , target_X(target_X)
+  , coherent(false)
   , mass(mass)
   , k(particles.size(),uninit)
   , kd(particles.size(),uninit)
   , node_X(particles.size(),uninit)
   , target_tree(new_<SimplexTree<TV,2>>(ref(target_mesh),target_X,10))
   , info(particles.size(),uninit)
+  , target_incident(target_mesh.incident_elements())
+  , tracked(false)
 {
   max_node = particles.size()?particles.max()+1:0;
   GEODE_ASSERT(mass.size()>=max_node);
@@ -60,12 +66,66 @@ void SurfacePins::structure(SolidMatrixStructure& structure) const {
 void SurfacePins::update_position(Array<const TV> X_, bool definite) {
   GEODE_ASSERT(X_.size()==mass.size());
   node_X.copy(X_.subset(particles));
+  if (coherent && tracked)
+    return track_closest_points();
   if (!node_tree)
     node_tree = new_<ParticleTree<TV>>(node_X,10);
   else
     node_tree->update(); // update for changes to node_X
   // Compute distances and directions
   surface_levelset<2>(*node_tree,*target_tree,info,1e10,false);
+  tracked = true;
+}
+
+// Walks longer than this fall back to a query of the whole target tree
+static const int max_walk = 32;
+
+void SurfacePins::track_closest_points() {
+  const auto& simplices = target_tree->simplices;
+  const auto triangles = target_mesh->elements;
+  // Matches the tolerance of surface_levelset for choosing normals of particles on the surface, up to using only the
+  // target's bounding box
+  const T epsilon = sqrt(std::numeric_limits<T>::epsilon())*target_tree->bounding_box().sizes().max();
+  parallel_for(particles.size(),[&](const int i) {
+    auto& I = info[i];
+    if (I.simplex<0) // Empty target
+      return;
+    const TV x = node_X[i];
+    int t = I.simplex;
+    auto close = simplices[t].closest_point(x);
+    T sqr_phi = sqr_magnitude(x-close.x);
+    for (int step=0;;step++) {
+      if (step==max_walk) {
+        const auto full = target_tree->closest_point(x,sqrt(sqr_phi));
+        if (full.y>=0 && sqr_magnitude(x-full.x)<sqr_phi) {
+          t = full.y;
+          close = tuple(full.x,full.z);
+          sqr_phi = sqr_magnitude(x-close.x);
+        }
+        break;
+      }
+      const int last = t;
+      for (const int v : triangles[last])
+        for (const int s : target_incident[v])
+          if (s!=last) {
+            const auto c = simplices[s].closest_point(x);
+            const T sd = sqr_magnitude(x-c.x);
+            if (sd<sqr_phi) {
+              t = s;
+              close = c;
+              sqr_phi = sd;
+            }
+          }
+      if (t==last)
+        break;
+    }
+    const TV delta = x-close.x;
+    I.phi = sqrt(sqr_phi);
+    I.simplex = t;
+    I.weights = close.y;
+    const TV& n = simplices[t].n;
+    I.normal = I.phi>epsilon ? delta/I.phi : dot(delta,n)>0 ? n : -n;
+  },64);
 }
 
 Array<TV> SurfacePins::closest_points(Array<const TV> X) {
@@ -156,6 +216,7 @@ void wrap_surface_pins() {
   typedef SurfacePins Self;
   Class<Self>("SurfacePins")
     .GEODE_INIT(Array<const int>,Array<const T>,TriangleSoup&,Array<const TV>,NdArray<const T>,NdArray<const T>)
+    .GEODE_FIELD(coherent)
     .GEODE_METHOD(closest_points)
     ;
 }
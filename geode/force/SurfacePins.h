@@ -5,6 +5,11 @@
 // Linear spring force between particles and their closest corresponding points on a surface.
 // The stiffness is mass proportional for resolution invariance.
 //
+// By default, each update_position finds closest points by querying the whole surface.  If coherent is set,
+// later updates instead walk from each particle's previous closest triangle to better triangles sharing a
+// vertex with it, falling back to a full query if the walk runs long.  This is much cheaper for particles
+// which move little per update, but a walk can stop at a local minimum if a particle jumps across a fold.
+//
 //#####################################################################
 #pragma once
 
@@ -26,6 +31,7 @@ public:
   const Array<const int> particles;
   Ref<TriangleSoup> target_mesh;
   const Array<const TV> target_X;
+  bool coherent; // Track closest points incrementally from the previous update_position
 private:
   int max_node;
   const Array<const T> mass;
@@ -34,6 +40,8 @@ private:
   Ptr<ParticleTree<TV>> node_tree;
   const Ref<SimplexTree<TV,2>> target_tree;
   const Array<CloseInfo<2>> info;
+  const Nested<const int> target_incident; // Triangles incident to each target vertex
+  bool tracked; // Whether info holds closest points from a previous update_position
 protected:
   SurfacePins(Array<const int> particles, Array<const T> mass, TriangleSoup& target_mesh, Array<const TV> target_X, NdArray<const T> stiffness, NdArray<const T> damping_ratio);
 public:
@@ -55,6 +63,8 @@ public:
   void structure(SolidMatrixStructure& structure) const;
   void add_elastic_gradient(SolidMatrix<TV>& matrix) const;
   void add_damping_gradient(SolidMatrix<TV>& matrix) const;
+private:
+  void track_closest_points();
 };
 
 }
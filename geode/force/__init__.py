@@ -70,6 +70,15 @@ def cubic_hinges(mesh,X,stiffness,damping,angles=None):
   hinges.damping = damping
   return hinges
 
+ForceSet = {2:ForceSet2d,3:ForceSet3d}
+def force_set(forces):
+  forces = list(forces)
+  return ForceSet[forces[0].d](forces)
+
+BackwardEuler = {2:BackwardEuler2d,3:BackwardEuler3d}
+def backward_euler(force,mass,X,V,matrix_free=False):
+  return BackwardEuler[force.d](force,mass,X,V,matrix_free)
+
 BindingSprings = {2:BindingSprings2d,3:BindingSprings3d}
 def binding_springs(nodes,parents,weights,mass,stiffness,damping_ratio):
   parents = asarray(parents,dtype=int32)
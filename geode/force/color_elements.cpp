@@ -0,0 +1,61 @@
+//#####################################################################
+// Function color_elements
+//#####################################################################
+#include <geode/force/color_elements.h>
+#include <geode/array/view.h>
+namespace geode {
+
+template<int s> Nested<const int> color_elements(RawArray<const Vector<int,s>> elements) {
+  const int n = elements.size();
+  if (!n)
+    return Nested<const int>();
+  const int nodes = scalar_view(elements).max()+1;
+
+  // Elements incident on each node
+  Array<int> counts(nodes);
+  for (const auto& e : elements)
+    for (const int i : e)
+      counts[i]++;
+  Nested<int> incident(counts,uninit);
+  for (int t=n-1;t>=0;t--)
+    for (const int i : elements[t])
+      incident.flat[incident.offsets[i]+--counts[i]] = t;
+
+  // Mark the colors of earlier neighbors, then take the first free one
+  Array<int> color(n,uninit);
+  Array<int> mark;
+  int colors = 0;
+  for (int t=0;t<n;t++) {
+    for (const int i : elements[t])
+      for (const int u : incident[i]) {
+        if (u>=t)
+          break;
+        mark[color[u]] = t;
+      }
+    int c = 0;
+    while (c<colors && mark[c]==t)
+      c++;
+    if (c==colors) {
+      colors++;
+      mark.append(-1);
+    }
+    color[t] = c;
+  }
+
+  // Group elements by color, in order within each color
+  Array<int> sizes(colors);
+  for (const int c : color)
+    sizes[c]++;
+  Nested<int> result(sizes,uninit);
+  for (int t=n-1;t>=0;t--)
+    result.flat[result.offsets[color[t]]+--sizes[color[t]]] = t;
+  return result;
+}
+
+#define INSTANTIATE(s) \
+  template GEODE_CORE_EXPORT Nested<const int> color_elements(RawArray<const Vector<int,s>>);
+INSTANTIATE(2)
+INSTANTIATE(3)
+INSTANTIATE(4)
+
+}
@@ -0,0 +1,57 @@
+//#####################################################################
+// Function color_elements
+//#####################################################################
+//
+// Forces scatter per-element contributions into per-node arrays.  To do this
+// in parallel without atomics, elements are partitioned into colors such that
+// no two elements of the same color share a node.  Each color is then
+// processed in parallel, and the colors one after another.  Since the
+// partition is fixed, results don't depend on the number of threads.
+//
+//#####################################################################
+#pragma once
+
+#include <geode/array/Nested.h>
+#include <geode/utility/parallel.h>
+#include <geode/vector/Vector.h>
+namespace geode {
+
+// Greedily color elements in order, giving each the smallest color not used by an element sharing one of its nodes
+template<int s> GEODE_CORE_EXPORT Nested<const int> color_elements(RawArray<const Vector<int,s>> elements);
+
+template<int s> inline Nested<const int> color_elements(const Array<const Vector<int,s>>& elements) {
+  return color_elements(elements.raw());
+}
+
+// Call f(t) for every element t, in parallel within each color
+template<class F> void colored_for(const Nested<const int>& colors, const F& f) {
+  for (int c=0;c<colors.size();c++) {
+    const auto color = colors[c];
+    parallel_for(color.size(),[&](const int i) { f(color[i]); },64);
+  }
+}
+
+// Add to result[i] the maximum of value(t) over elements t touching node i, where nodes(t) gives the nodes of t.  Values
+// are computed in parallel within each color.  Forces use this for the per node stiffness bounds in add_frequency_squared.
+template<class T,class N,class F> void add_colored_maxima(RawArray<T> result, const Nested<const int>& colors,
+                                                          const N& nodes, const F& value) {
+  Array<T> maxima(result.size());
+  colored_for(colors,[&](const int t) {
+    const T v = value(t);
+    const auto n = nodes(t);
+    for (int a=0;a<n.size();a++)
+      maxima[n[a]] = max(maxima[n[a]],v);
+  });
+  parallel_for(result.size(),[&](const int i) { result[i] += maxima[i]; },1024);
+}
+
+// Call f(k) for every position k in colors.flat, in parallel within each color.  For per element data stored in
+// colors.flat order, so that each color reads a contiguous range.
+template<class F> void colored_flat_for(const Nested<const int>& colors, const F& f) {
+  for (int c=0;c<colors.size();c++) {
+    const int start = colors.offsets[c];
+    parallel_for(colors.size(c),[&](const int i) { f(start+i); },64);
+  }
+}
+
+}
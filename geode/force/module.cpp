@@ -6,6 +6,8 @@ using namespace geode;
 
 void wrap_force() {
   GEODE_WRAP(Force)
+  GEODE_WRAP(force_set)
+  GEODE_WRAP(backward_euler)
   GEODE_WRAP(gravity)
   GEODE_WRAP(springs)
   GEODE_WRAP(finite_volume)
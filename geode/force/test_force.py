@@ -103,28 +103,36 @@ def test_linear_fvm_2d():
   X = random.randn(3,2)
   dX = .1*random.randn(3,2)
   fvm = linear_finite_volume([(0,1,2)],X,1000)
-  force_test(fvm,X+dX,verbose=1)
+  for cache in False,True:
+    fvm.cache_stiffness = cache
+    force_test(fvm,X+dX,verbose=1)
 
 def test_linear_fvm_s3d():
   random.seed(12872)
   X = random.randn(3,3)
   dX = .1*random.randn(3,3)
   fvm = linear_finite_volume([(0,1,2)],X,1000)
-  force_test(fvm,X+dX,verbose=1)
+  for cache in False,True:
+    fvm.cache_stiffness = cache
+    force_test(fvm,X+dX,verbose=1)
 
 def test_linear_fvm_3d():
   random.seed(12873)
   X = random.randn(4,3)
   dX = .1*random.randn(4,3)
   fvm = linear_finite_volume([(0,1,2,3)],X,1000)
-  force_test(fvm,X+dX,verbose=1)
+  for cache in False,True:
+    fvm.cache_stiffness = cache
+    force_test(fvm,X+dX,verbose=1)
 
 def test_linear_fvm_hex():
   random.seed(12873)
   X = [[0,0,0],[0,0,1],[0,1,0],[0,1,1],[1,0,0],[1,0,1],[1,1,0],[1,1,1]]+.1*random.randn(8,3)
   dX = .1*random.randn(8,3)
   fvm = linear_finite_volume([arange(8)],X,1000)
-  force_test(fvm,X+dX,verbose=1)
+  for cache in False,True:
+    fvm.cache_stiffness = cache
+    force_test(fvm,X+dX,verbose=1)
 
 def test_air_pressure():
   random.seed(2813)
@@ -172,6 +180,14 @@ def test_surface_pins():
   target_X = 100*eye(3)
   pins = SurfacePins(nodes,mass,target_mesh,target_X,7,1.1)
   force_test(pins,X,verbose=1)
+  # Coherent tracking should match full queries for small motions near a convex surface
+  target_mesh,target_X = sphere_mesh(2)
+  full = SurfacePins(nodes,mass,target_mesh,target_X,7,1.1)
+  pins = SurfacePins(nodes,mass,target_mesh,target_X,7,1.1)
+  pins.coherent = True
+  for i in xrange(4):
+    X = X+.01*random.randn(*X.shape)
+    assert relative_error(pins.closest_points(X),full.closest_points(X))<1e-10
 
 def test_binding_springs():
   random.seed(73210)
@@ -193,5 +209,47 @@ def test_particle_binding_springs():
   springs = particle_binding_springs([[1,2]],mass,7,1.2)
   force_test(springs,X,verbose=1)
 
+def test_force_set():
+  random.seed(73211)
+  X0 = random.randn(4,3)
+  X = X0+.1*random.randn(4,3)
+  springs = Springs([[0,1],[2,3]],[1.1,1.2,1.3,1.4],X0,5,7)
+  fvm = finite_volume([(0,1,2,3)],1000,X0,neo_hookean())
+  forces = force_set([springs,fvm])
+  force_test(forces,X,verbose=1)
+  # The set should match the sum of its parts
+  F = zeros_like(X)
+  forces.update_position(X,False)
+  forces.add_elastic_force(F)
+  G = zeros_like(X)
+  for f in springs,fvm:
+    f.add_elastic_force(G)
+  assert allclose(F,G)
+  assert allclose(forces.elastic_energy(),springs.elastic_energy()+fvm.elastic_energy())
+
+def test_backward_euler():
+  random.seed(73212)
+  mesh,X0 = sphere_mesh(1)
+  mass = ones(len(X0))
+  X = X0+.1*random.randn(*X0.shape)
+  V = random.randn(*X0.shape)
+  springs = Springs(mesh.segment_soup().elements,mass,X0,100,.1)
+  results = []
+  for matrix_free in False,True:
+    be = backward_euler(springs,mass,X,V,matrix_free)
+    be.tolerance = 1e-10
+    energy = lambda: springs.elastic_energy()+.5*sum(mass*sum(be.V**2,axis=-1))
+    springs.update_position(be.X,False)
+    energies = [energy()]
+    for s in xrange(10):
+      iterations,residual = be.step(.01)
+      assert residual<1e-10
+      springs.update_position(be.X,False)
+      energies.append(energy())
+    # Backward Euler only loses energy
+    assert all(diff(energies)<0)
+    results.append(be.X.copy())
+  assert allclose(*results)
+
 if __name__=='__main__':
   test_simple_shell()
@@ -31,6 +31,42 @@ phi(const TV& X) const
     return Shape::phi(X);
 }
 
+// Batched phi loops call the shape directly, so there is no virtual call per point.  Box and Cylinder phi are
+// out of line, so we inline branch free versions here to let the compiler vectorize.
+template<class Shape> static void batch_phi(const Shape& shape, RawArray<const typename Shape::VectorT> X,
+                                            RawArray<T> phi) {
+  for (int i=0;i<X.size();i++)
+    phi[i] = shape.phi(X[i]);
+}
+
+template<int d> static void batch_phi(const Box<Vector<T,d>>& box, RawArray<const Vector<T,d>> X, RawArray<T> phi) {
+  typedef Vector<T,d> TV;
+  const TV center = box.center(),
+           half = (T).5*box.sizes();
+  for (int i=0;i<X.size();i++) {
+    const TV e = abs(X[i]-center)-half;
+    phi[i] = magnitude(TV::componentwise_max(e,TV()))+min(e.max(),T(0));
+  }
+}
+
+static void batch_phi(const Cylinder& cylinder, RawArray<const Vector<T,3>> X, RawArray<T> phi) {
+  const auto& base = cylinder.base;
+  for (int i=0;i<X.size();i++) {
+    const auto v = X[i]-base.x0;
+    const T h = dot(v,base.n);
+    const T rp = magnitude(v-h*base.n)-cylinder.radius,
+            hp = max(-h,h-cylinder.height);
+    phi[i] = magnitude(vec(max(hp,T(0)),max(rp,T(0))))+min(max(hp,rp),T(0));
+  }
+}
+
+template<class Shape> void AnalyticImplicit<Shape>::
+phi(RawArray<const TV> X, RawArray<T> phi) const
+{
+    GEODE_ASSERT(X.size()==phi.size());
+    batch_phi(static_cast<const Shape&>(*this),X,phi);
+}
+
 template<class Shape> typename Shape::VectorT AnalyticImplicit<Shape>::
 normal(const TV& X) const
 {
@@ -38,6 +38,7 @@ public:
   }
 
   virtual T phi(const TV& X) const;
+  virtual void phi(RawArray<const TV> X, RawArray<T> phi) const;
   virtual TV normal(const TV& X) const;
   virtual TV surface(const TV& X) const;
   virtual bool lazy_inside(const TV& X) const;
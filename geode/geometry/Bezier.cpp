@@ -5,6 +5,7 @@
 #include <geode/python/Class.h>
 #include <geode/python/stl.h>
 #include <geode/geometry/polygon.h>
+#include <geode/geometry/Segment.h>
 #include <iostream>
 namespace geode {
 
@@ -14,30 +15,25 @@ using std::endl;
 template<> GEODE_DEFINE_TYPE(Bezier<2>)
 template<> GEODE_DEFINE_TYPE(Knot<2>)
 
-static double interpolate(double v0, double v1, double v2, double v3, double t) {
-  Vector<real,4> i(v0,v1,v2,v3);
-  Matrix<real,4> mx( -1, 3, -3, 1,
-                     3, -6, 3, 0,
-                     -3,3, 0, 0,
-                     1, 0,0, 0);
-
-  Vector<real,4> a = mx*i; // transpose because of legacy constructor
-  return a.w + t*(a.z + t*(a.y + t*a.x));
+// Power basis coefficients of a cubic segment, so that its point at t is c[0]+t*(c[1]+t*(c[2]+t*c[3]))
+template<class TV> static inline Vector<TV,4> power_basis(const TV& v0, const TV& v1, const TV& v2, const TV& v3) {
+  return Vector<TV,4>(v0,
+                      3*(v1-v0),
+                      3*(v0+v2)-6*v1,
+                      v3-v0+3*(v1-v2));
 }
 
 template<int d> static Vector<real,d> point(Vector<real,d> v0, Vector<real,d> v1, Vector<real,d> v2, Vector<real,d> v3, double t) {
-  Vector<real,d> result;
-  for (int i = 0; i < d; i++)
-    result[i] = interpolate(v0[i],v1[i],v2[i],v3[i],t);
-  return result;
+  const auto c = power_basis(v0,v1,v2,v3);
+  return c[0]+t*(c[1]+t*(c[2]+t*c[3]));
 }
 
-template<int d> Tuple<Array<Vector<real,d>>, vector<int>> Bezier<d>::evaluate_core(const InvertibleBox& range, int res) const{
-  Array<Vector<real,d>> path;
-  vector<int> forced;
-
-  if (knots.size()<=1) return tuple(path,forced);
-  Vector<real,d> p1, p2, p3, p4;
+// Control points of the nondegenerate segments overlapping range, followed by the final point
+template<int d> static Tuple<Array<Vector<Vector<real,d>,4>>,Vector<real,d>> segments(const Bezier<d>& bezier, const InvertibleBox& range) {
+  typedef Vector<real,d> TV;
+  Array<Vector<TV,4>> segs;
+  const auto& knots = bezier.knots;
+  if (knots.size()<=1) return tuple(segs,TV());
 
   auto it = knots.upper_bound(range.begin);
   auto end = knots.lower_bound(range.end);
@@ -46,41 +42,96 @@ template<int d> Tuple<Array<Vector<real,d>>, vector<int>> Bezier<d>::evaluate_co
   GEODE_ASSERT(it!=knots.end() && end!=knots.end());
   while(it!=end){
     //jump across null segment end->beginning for closed
-    if(b_closed && it->first == t_max()){
-      if(range.end == t_min() || range.end == t_max())
+    if(bezier.closed() && it->first == bezier.t_max()){
+      if(range.end == bezier.t_min() || range.end == bezier.t_max())
         break;
       it = knots.begin();
     }
 
-    p1 = it->second->pt;
-    p2 = it->second->tangent_out;
+    const TV p1 = it->second->pt;
+    const TV p2 = it->second->tangent_out;
 
     it++;
-    if(!b_closed) GEODE_ASSERT(it!=knots.end());
+    if(!bezier.closed()) GEODE_ASSERT(it!=knots.end());
     if(it == knots.end()) it = knots.begin(); // wrap around at end
 
-    p3 = it->second->tangent_in;
-    p4 = it->second->pt;
+    const TV p3 = it->second->tangent_in;
+    const TV p4 = it->second->pt;
 
     //ignore the segment if the two points are practically indistinguishable
-    if ((p4-p1).magnitude() > 1e-8 || (dot((p2-p1).normalized(),(p3-p4).normalized()) < 1-1e-7) ) {
-      // first point in this segment
-      forced.push_back(path.size());
-      path.append(geode::point(p1,p2,p3,p4,0));
-
-      for (int j=1;j<res;j++) {
-        real t = j/(real)(res); // (0,1)
-        path.append(geode::point(p1,p2,p3,p4,t));
-      }
+    if ((p4-p1).magnitude() > 1e-8 || (dot((p2-p1).normalized(),(p3-p4).normalized()) < 1-1e-7) )
+      segs.append(Vector<TV,4>(p1,p2,p3,p4));
+  }
+  return tuple(segs,end->second->pt);
+}
+
+template<int d> Tuple<Array<Vector<real,d>>, vector<int>> Bezier<d>::evaluate_core(const InvertibleBox& range, int res) const{
+  Array<Vector<real,d>> path;
+  vector<int> forced;
+  if (knots.size()<=1) return tuple(path,forced);
+  const auto segs = segments(*this,range);
+  res = std::max(res,1);
+
+  // Each segment fills a fixed block of res points, so segments are independent.  Converting to power basis once per
+  // segment leaves a short Horner loop over t for the inner loop.
+  const int count = segs.x.size();
+  path.resize(count*res+1,uninit);
+  forced.resize(count+1);
+  const real inv_res = 1./res;
+  #pragma omp parallel for if(count*res>4096)
+  for (int s=0;s<count;s++) {
+    const auto& p = segs.x[s];
+    const auto c = power_basis(p[0],p[1],p[2],p[3]);
+    const auto block = path.slice(s*res,(s+1)*res);
+    block[0] = c[0]; // first point in this segment
+    for (int j=1;j<res;j++) {
+      const real t = j*inv_res; // (0,1)
+      block[j] = c[0]+t*(c[1]+t*(c[2]+t*c[3]));
     }
+    forced[s] = s*res;
   }
   // last point
-  forced.push_back(path.size());
-  path.append(end->second->pt);
+  forced[count] = count*res;
+  path[count*res] = segs.y;
 
   return tuple(path, forced);
 }
 
+// Append a cubic segment to path, excluding its end point, splitting at the midpoint until every piece is flat.  The
+// curve lies in the convex hull of its control points, so its distance from the chord is at most the largest distance
+// of an inner control point from the chord.
+template<int d> static void adaptive_segment(Array<Vector<real,d>>& path, const Vector<Vector<real,d>,4>& p, const real tolerance, const int depth) {
+  typedef Vector<real,d> TV;
+  const Segment<TV> chord(p[0],p[3]);
+  if (!depth || max(segment_point_distance(chord,p[1]),
+                     segment_point_distance(chord,p[2])) <= tolerance) {
+    path.append(p[0]);
+    return;
+  }
+  // de Casteljau subdivision at t = 1/2
+  const TV p01 = .5*(p[0]+p[1]), p12 = .5*(p[1]+p[2]), p23 = .5*(p[2]+p[3]),
+           p012 = .5*(p01+p12), p123 = .5*(p12+p23),
+           m = .5*(p012+p123);
+  adaptive_segment(path,Vector<TV,4>(p[0],p01,p012,m),tolerance,depth-1);
+  adaptive_segment(path,Vector<TV,4>(m,p123,p23,p[3]),tolerance,depth-1);
+}
+
+template<int d> Array<Vector<real,d>> Bezier<d>::adaptive_evaluate(const InvertibleBox& range, real tolerance) const{
+  GEODE_ASSERT(tolerance>0);
+  Array<TV> path;
+  if (knots.size()<=1) return path;
+  const auto segs = segments(*this,range);
+  for (const auto& p : segs.x)
+    adaptive_segment(path,p,tolerance,20);
+  path.append(segs.y);
+  return path;
+}
+
+template<int d> Array<Vector<real,d>> Bezier<d>::adaptive_evaluate(real tolerance) const{
+  if(t_range == Box<real>(0)) return Array<Vector<real,d>>();
+  return adaptive_evaluate(InvertibleBox(t_range.min, t_range.max),tolerance);
+}
+
 template<int d> Array<Vector<real,d>> Bezier<d>::evaluate(const InvertibleBox& range, int res) const{
   return evaluate_core(range, res).x;
 }
@@ -483,6 +534,7 @@ void wrap_bezier() {
   {
     typedef Bezier<2> Self;
     typedef Array<Vector<real,2>>(Self::*eval_t)(int)const;
+    typedef Array<Vector<real,2>>(Self::*adaptive_eval_t)(real)const;
     Class<Self>("Bezier")
       .GEODE_INIT()
       .GEODE_FIELD(knots)
@@ -492,6 +544,7 @@ void wrap_bezier() {
       .GEODE_METHOD(close)
       .GEODE_METHOD(fuse_ends)
       .GEODE_OVERLOADED_METHOD(eval_t, evaluate)
+      .GEODE_OVERLOADED_METHOD(adaptive_eval_t, adaptive_evaluate)
       .GEODE_METHOD(append_knot)
       ;
   }
@@ -101,6 +101,9 @@ public:
   GEODE_CORE_EXPORT Array<TV> alen_evaluate(const InvertibleBox& range, int res) const;
   GEODE_CORE_EXPORT Array<TV> evaluate(int res) const;
   GEODE_CORE_EXPORT Array<TV> alen_evaluate(int res) const;
+  // Flatness based tessellation: segments are subdivided until every piece is within tolerance of its chord
+  GEODE_CORE_EXPORT Array<TV> adaptive_evaluate(const InvertibleBox& range, real tolerance) const;
+  GEODE_CORE_EXPORT Array<TV> adaptive_evaluate(real tolerance) const;
   GEODE_CORE_EXPORT real arclength(const InvertibleBox& range, int res) const;
   GEODE_CORE_EXPORT void append_knot(const TV& pt, TV tin = T(inf)*TV::ones(), TV tout = T(inf)*TV::ones());
   GEODE_CORE_EXPORT void insert_knot(const real t);
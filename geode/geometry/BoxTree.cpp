@@ -10,6 +10,8 @@
 #include <geode/geometry/traverse.h>
 #include <geode/math/integer_log.h>
 #include <geode/python/Class.h>
+#include <geode/utility/const_cast.h>
+#include <geode/utility/openmp.h>
 namespace geode {
 using std::cout;
 using std::endl;
@@ -75,6 +77,211 @@ build(BoxTree<TV>& self, RawArray<const Range<int>> ranges, RawArray<const Geo>
   }
 }
 
+// Below this many primitives, trees are built and refit serially
+const int parallel_threshold = 1<<14;
+
+template<class Geo,class TV> static Box<TV> parallel_bounding_box(RawArray<const Geo> geo, RawArray<const int> p) {
+  Box<TV> box = Box<TV>::empty_box();
+  #pragma omp parallel
+  {
+    Box<TV> local = Box<TV>::empty_box();
+    #pragma omp for nowait
+    for (int i=0;i<p.size();i++)
+      local.enlarge(geo[p[i]]);
+    #pragma omp critical
+    box.enlarge(local);
+  }
+  return box;
+}
+
+// Split the top levels of the tree exactly as build does, collecting the subtrees left below them
+template<class Geo,class TV> void
+build_top(BoxTree<TV>& self, RawArray<const Range<int>> ranges, RawArray<const Geo> geo, int node, int levels,
+          Array<int>& subtrees) {
+  if (!levels || self.is_leaf(node)) {
+    subtrees.append(node);
+    return;
+  }
+  const auto r = ranges[node];
+  const auto box = self.boxes[node] = parallel_bounding_box<Geo,TV>(geo,self.p.slice(r.lo,r.hi));
+  const int axis = box.sizes().argmax();
+  int* pp = const_cast<int*>(self.p.data());
+  std::nth_element(pp+r.lo,
+                   pp+ranges[2*node+1].hi,
+                   pp+r.hi,indirect_comparison(geo,CenterCompare(axis)));
+  build_top(self,ranges,geo,2*node+1,levels-1,subtrees);
+  build_top(self,ranges,geo,2*node+2,levels-1,subtrees);
+}
+
+// Build the top levels serially, then the subtrees below them in parallel.  The result is identical to build.
+template<class Geo,class TV> void
+build_parallel(BoxTree<TV>& self, RawArray<const Range<int>> ranges, RawArray<const Geo> geo) {
+  const int threads = omp_get_max_threads();
+  if (threads==1 || geo.size()<parallel_threshold)
+    return build(self,ranges,geo,0);
+  Array<int> subtrees;
+  build_top(self,ranges,geo,0,integer_log(8*threads)+1,subtrees);
+  #pragma omp parallel for schedule(dynamic,1)
+  for (int i=0;i<subtrees.size();i++)
+    build(self,ranges,geo,subtrees[i]);
+}
+
+// Area measures for the surface area heuristic
+template<class T> static inline T sah_area(const Box<Vector<T,2>>& box) {
+  return box.empty() ? 0 : box.sizes().sum();
+}
+template<class T> static inline T sah_area(const Box<Vector<T,3>>& box) {
+  return box.empty() ? 0 : box.surface_area();
+}
+
+template<class TV> static inline TV sah_center(const TV& x) { return x; }
+template<class TV> static inline TV sah_center(const Box<TV>& box) { return box.center(); }
+
+// Compute the box of a range of primitives, and either sort them as a leaf (returning -1) or partition them with a
+// binned surface area heuristic split (returning the split point).  Each range with more than leaf_size primitives
+// bins its primitive centers along each axis and splits at the bin boundary minimizing area(left)*count(left) +
+// area(right)*count(right), falling back to a median split if the centers coincide.
+template<class Geo,class TV> static int
+sah_split(BoxTree<TV>& self, RawArray<const Geo> geo, const Range<int> r, Box<TV>& box) {
+  typedef typename TV::Scalar T;
+  int* pp = const_cast<int*>(self.p.data());
+  box = Box<TV>(geo[pp[r.lo]]);
+  Box<TV> centers(sah_center(geo[pp[r.lo]]));
+  for (int i=r.lo+1;i<r.hi;i++) {
+    box.enlarge_nonempty(geo[pp[i]]);
+    centers.enlarge_nonempty(sah_center(geo[pp[i]]));
+  }
+  if (r.size() <= self.leaf_size) {
+    sort(self.p.slice(r.lo,r.hi).const_cast_());
+    return -1;
+  }
+
+  // Find the best bin boundary over all axes
+  static const int bins = 16;
+  Box<TV> bin_boxes[bins];
+  int bin_counts[bins];
+  T right_costs[bins];
+  int best_axis = -1, best_split = 0;
+  T best_cost = 0;
+  const auto extent = centers.sizes();
+  for (int axis=0;axis<TV::m;axis++) {
+    if (!(extent[axis] > 0))
+      continue;
+    const T scale = bins/extent[axis];
+    for (int b=0;b<bins;b++) {
+      bin_boxes[b] = Box<TV>::empty_box();
+      bin_counts[b] = 0;
+    }
+    for (int i=r.lo;i<r.hi;i++) {
+      const int b = min(bins-1,int(scale*(sah_center(geo[pp[i]])[axis]-centers.min[axis])));
+      bin_boxes[b].enlarge(geo[pp[i]]);
+      bin_counts[b]++;
+    }
+    Box<TV> right = Box<TV>::empty_box();
+    int right_count = 0;
+    for (int b=bins-1;b>0;b--) {
+      right.enlarge(bin_boxes[b]);
+      right_count += bin_counts[b];
+      right_costs[b] = right_count*sah_area(right);
+    }
+    Box<TV> left = Box<TV>::empty_box();
+    int left_count = 0;
+    for (int b=1;b<bins;b++) {
+      left.enlarge(bin_boxes[b-1]);
+      left_count += bin_counts[b-1];
+      const T cost = left_count*sah_area(left)+right_costs[b];
+      if (left_count && left_count<r.size() && (best_axis<0 || best_cost>cost)) {
+        best_axis = axis;
+        best_split = b;
+        best_cost = cost;
+      }
+    }
+  }
+
+  // Partition the primitives
+  if (best_axis >= 0) {
+    const T lo = centers.min[best_axis],
+            scale = bins/extent[best_axis];
+    return int(std::partition(pp+r.lo,pp+r.hi,[&](const int i) {
+      return min(bins-1,int(scale*(sah_center(geo[i])[best_axis]-lo))) < best_split;
+    })-pp);
+  } else {
+    const int mid = r.lo+r.size()/2;
+    std::nth_element(pp+r.lo,pp+mid,pp+r.hi,indirect_comparison(geo,CenterCompare(box.sizes().argmax())));
+    return mid;
+  }
+}
+
+// Build a tree with binned surface area heuristic splits.  The tree is built one level at a time into temporary
+// nodes, splitting the nodes of each level in parallel, then renumbered so that internal nodes are in preorder and
+// leaves follow in order.
+template<class Geo,class TV> void
+build_sah(BoxTree<TV>& self, RawArray<const Geo> geo) {
+  const int n = geo.size();
+  if (!n)
+    return;
+  struct Node {
+    Range<int> prims;
+    Box<TV> box;
+    int child; // Index of the first of two children, or -1 for leaves
+  };
+  Array<Node> nodes;
+  nodes.append(Node{range(n),Box<TV>(),-1});
+  Array<int> mids;
+  int leaves = 0, depth = 0;
+  for (int start=0;start<nodes.size();depth++) {
+    const int end = nodes.size();
+    mids.resize(end-start,uninit);
+    #pragma omp parallel for schedule(dynamic,1) if(n>=parallel_threshold)
+    for (int i=start;i<end;i++)
+      mids[i-start] = sah_split(self,geo,nodes[i].prims,nodes[i].box);
+    for (int i=start;i<end;i++) {
+      const int mid = mids[i-start];
+      if (mid < 0)
+        leaves++;
+      else {
+        const auto r = nodes[i].prims;
+        nodes[i].child = nodes.size();
+        nodes.append(Node{range(r.lo,mid),Box<TV>(),-1});
+        nodes.append(Node{range(mid,r.hi),Box<TV>(),-1});
+      }
+    }
+    start = end;
+  }
+
+  // Number internal nodes in preorder, then leaves in order of their primitives
+  Array<int> ids(nodes.size(),uninit);
+  {
+    int internal = 0, leaf = leaves-1;
+    Array<int> stack;
+    stack.append(0);
+    while (stack.size()) {
+      const int i = stack.pop();
+      if (nodes[i].child < 0)
+        ids[i] = leaf++;
+      else {
+        ids[i] = internal++;
+        stack.append(nodes[i].child+1);
+        stack.append(nodes[i].child);
+      }
+    }
+  }
+  const_cast_(self.leaves) = range(leaves-1,2*leaves-1);
+  const_cast_(self.depth) = depth;
+  Array<Range<int>> ranges(nodes.size(),uninit);
+  const_cast_(self.boxes) = Array<Box<TV>>(nodes.size(),uninit);
+  Array<Vector<int,2>> children(leaves-1,uninit);
+  for (const int i : range(nodes.size())) {
+    const auto& node = nodes[i];
+    ranges[ids[i]] = node.prims;
+    self.boxes[ids[i]] = node.box;
+    if (node.child >= 0)
+      children[ids[i]] = vec(ids[node.child],ids[node.child+1]);
+  }
+  const_cast_(self.ranges) = ranges;
+  const_cast_(self.explicit_children) = children;
+}
+
 }
 
 static int check_leaf_size(int leaf_size) {
@@ -97,28 +304,32 @@ static inline Range<int> leaf_range(int prims, int leaf_size) {
   return range(leaves-1,2*leaves-1);
 }
 
-template<class TV> BoxTree<TV>::BoxTree(RawArray<const TV> geo, const int leaf_size)
+template<class TV> BoxTree<TV>::BoxTree(RawArray<const TV> geo, const int leaf_size, const bool sah)
   : leaf_size(check_leaf_size(leaf_size))
-  , leaves(leaf_range(geo.size(),leaf_size))
+  , leaves(sah ? range(0) : leaf_range(geo.size(),leaf_size))
   , depth(geode::depth(leaves.size()))
   , p(arange(geo.size()).copy())
-  , ranges(geode::ranges(geo.size(),leaf_size))
+  , ranges(sah ? Array<const Range<int>>() : geode::ranges(geo.size(),leaf_size))
   , boxes(max(0,leaves.hi),uninit)
 {
-  if (leaves.size())
-    build(*this,ranges,geo,0);
+  if (sah)
+    build_sah(*this,geo);
+  else if (leaves.size())
+    build_parallel(*this,ranges,geo);
 }
 
-template<class TV> BoxTree<TV>::BoxTree(RawArray<const Box<TV>> geo, const int leaf_size)
+template<class TV> BoxTree<TV>::BoxTree(RawArray<const Box<TV>> geo, const int leaf_size, const bool sah)
   : leaf_size(check_leaf_size(leaf_size))
-  , leaves(leaf_range(geo.size(),leaf_size))
+  , leaves(sah ? range(0) : leaf_range(geo.size(),leaf_size))
   , depth(geode::depth(leaves.size()))
   , p(arange(geo.size()).copy())
-  , ranges(geode::ranges(geo.size(),leaf_size))
+  , ranges(sah ? Array<const Range<int>>() : geode::ranges(geo.size(),leaf_size))
   , boxes(max(0,leaves.hi),uninit)
 {
-  if (leaves.size())
-    build(*this,ranges,geo,0);
+  if (sah)
+    build_sah(*this,geo);
+  else if (leaves.size())
+    build_parallel(*this,ranges,geo);
 }
 
 template<class TV> BoxTree<TV>::BoxTree(const BoxTree<TV>& other)
@@ -128,13 +339,85 @@ template<class TV> BoxTree<TV>::BoxTree(const BoxTree<TV>& other)
   , p(other.p)
   , ranges(other.ranges)
   , boxes(other.boxes.copy()) // Don't share ownership with geometry
+  , explicit_children(other.explicit_children)
 {}
 
+template<class TV> BoxTree<TV>::BoxTree(const int leaf_size, const int depth, Array<const int> p,
+                                        Array<const Range<int>> ranges, Array<Box<TV>> boxes,
+                                        Array<const Vector<int,2>> explicit_children)
+  : leaf_size(check_leaf_size(leaf_size))
+  , leaves(boxes.size() ? range(boxes.size()/2,boxes.size()) : range(0))
+  , depth(depth)
+  , p(p)
+  , ranges(ranges)
+  , boxes(boxes)
+  , explicit_children(explicit_children)
+{
+  GEODE_ASSERT(   boxes.size()%2==int(p.size()>0) && ranges.size()==boxes.size()
+               && (!explicit_children.size() || explicit_children.size()==leaves.lo));
+}
+
 template<class TV> BoxTree<TV>::~BoxTree() {}
 
 template<class TV> void BoxTree<TV>::update_nonleaf_boxes() {
-  for(int n=leaves.lo-1;n>=0;n--)
-    boxes[n] = Box<TV>::combine(boxes[2*n+1],boxes[2*n+2]);
+  // Children always follow their parents, so a reverse sweep sees children first
+  const int internal = leaves.lo;
+  const int threads = omp_get_max_threads();
+  if (threads==1 || internal<parallel_threshold) {
+    for(int n=internal-1;n>=0;n--) {
+      const auto c = children(n);
+      boxes[n] = Box<TV>::combine(boxes[c.x],boxes[c.y]);
+    }
+    return;
+  }
+
+  // Split the top of the tree breadth first into many independent subtrees
+  Array<int> top, roots, next;
+  roots.append(0);
+  while (roots.size() < 64*threads) {
+    next.clear();
+    for (const int n : roots)
+      if (n < internal) {
+        const auto c = children(n);
+        top.append(n);
+        next.append(c.x);
+        next.append(c.y);
+      }
+    if (next.empty())
+      break;
+    swap(roots,next);
+  }
+
+  // Refit the subtrees in parallel.  Collecting each subtree's internal nodes in preorder puts ancestors before
+  // descendants, so sweeping the list backwards again sees children first.
+  #pragma omp parallel
+  {
+    Array<int> stack, order;
+    #pragma omp for schedule(dynamic,1)
+    for (int i=0;i<roots.size();i++) {
+      order.clear();
+      stack.append(roots[i]);
+      while (stack.size()) {
+        const int n = stack.pop();
+        if (n < internal) {
+          const auto c = children(n);
+          order.append(n);
+          stack.append(c.x);
+          stack.append(c.y);
+        }
+      }
+      for (int j=order.size()-1;j>=0;j--) {
+        const auto c = children(order[j]);
+        boxes[order[j]] = Box<TV>::combine(boxes[c.x],boxes[c.y]);
+      }
+    }
+  }
+
+  // Finish the top, which was collected breadth first
+  for (int i=top.size()-1;i>=0;i--) {
+    const auto c = children(top[i]);
+    boxes[top[i]] = Box<TV>::combine(boxes[c.x],boxes[c.y]);
+  }
 }
 
 namespace {
@@ -148,14 +431,20 @@ template<class TV> struct CheckVisitor {
     : tree(tree), X(X), culls(culls), leaves(leaves) {}
 
   bool cull(int n) const {
-    if (!tree.is_leaf(n))
-      GEODE_ASSERT(tree.boxes[n]==Box<TV>::combine(tree.boxes[2*n+1],tree.boxes[2*n+2]));
+    if (!tree.is_leaf(n)) {
+      const auto c = tree.children(n);
+      GEODE_ASSERT(n<c.x && n<c.y);
+      GEODE_ASSERT(tree.boxes[n]==Box<TV>::combine(tree.boxes[c.x],tree.boxes[c.y]));
+    }
     culls++;
     return false;
   }
 
   void leaf(int n) const {
-    GEODE_ASSERT(tree.ranges[n].hi==tree.p.size() || tree.prims(n).size()==tree.leaf_size);
+    if (tree.explicit_children.size())
+      GEODE_ASSERT(tree.prims(n).size() && tree.prims(n).size()<=tree.leaf_size);
+    else
+      GEODE_ASSERT(tree.ranges[n].hi==tree.p.size() || tree.prims(n).size()==tree.leaf_size);
     for (int i : tree.prims(n))
       GEODE_ASSERT(tree.boxes[n].lazy_inside(X[i]));
     leaves++;
@@ -177,8 +466,8 @@ check(RawArray<const TV> X) const {
 template<class TV,class Shape> static bool any_box_intersection_helper(const BoxTree<TV>& self, const Shape& shape, int node) {
   return shape.lazy_intersects(self.boxes[node])
       && (   self.is_leaf(node)
-          || any_box_intersection_helper(self,shape,2*node+1)
-          || any_box_intersection_helper(self,shape,2*node+2));
+          || any_box_intersection_helper(self,shape,self.child(node,0))
+          || any_box_intersection_helper(self,shape,self.child(node,1)));
 }
 
 template<class TV> template<class Shape> bool BoxTree<TV>::
@@ -199,7 +488,7 @@ void wrap_box_tree() {
   {typedef Vector<real,2> TV;
   typedef BoxTree<TV> Self;
   Class<Self>("BoxTree2d")
-    .GEODE_INIT(RawArray<const TV>,int)
+    .GEODE_INIT(RawArray<const TV>,int,bool)
     .GEODE_FIELD(p)
     .GEODE_METHOD(check)
     ;}
@@ -207,7 +496,7 @@ void wrap_box_tree() {
   {typedef Vector<real,3> TV;
   typedef BoxTree<TV> Self;
   Class<Self>("BoxTree3d")
-    .GEODE_INIT(RawArray<const TV>,int)
+    .GEODE_INIT(RawArray<const TV>,int,bool)
     .GEODE_FIELD(p)
     .GEODE_METHOD(check)
     ;}
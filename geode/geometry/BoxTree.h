@@ -8,6 +8,13 @@
 // We store the topology of the tree as a complete binary tree packed into
 // an array, so node n has parent (n-1)/2 and children 2n+1 and 2n+2.
 //
+// Alternatively, the tree can be built with binned surface area heuristic
+// splits, which adapt to nonuniform geometry such as a few huge triangles
+// among many tiny ones.  Such trees are unbalanced, so children are stored
+// explicitly and leaves hold at most leaf_size primitives.  In both layouts
+// internal nodes come first, then the leaves, and children have larger
+// indices than their parents.  Always walk the tree via children(n).
+//
 // For templatized visitor-based traversal, include traversal.h.
 //
 //#####################################################################
@@ -33,11 +40,16 @@ public:
   const Array<const int> p; // index permutation
   const Array<const Range<int>> ranges;
   const Array<Box<TV>> boxes;
+  const Array<const Vector<int,2>> explicit_children; // Children of internal nodes if sah, otherwise empty
 
 protected:
-  GEODE_CORE_EXPORT BoxTree(RawArray<const TV> geo, const int leaf_size);
-  GEODE_CORE_EXPORT BoxTree(RawArray<const Box<TV>> geo, const int leaf_size);
+  GEODE_CORE_EXPORT BoxTree(RawArray<const TV> geo, const int leaf_size, const bool sah=false);
+  GEODE_CORE_EXPORT BoxTree(RawArray<const Box<TV>> geo, const int leaf_size, const bool sah=false);
   GEODE_CORE_EXPORT BoxTree(const BoxTree<TV>& other); // Shares ownership with everything except boxes
+
+  // Adopt the arrays of an already built tree, such as one read by read_box_tree.  leaves is implied by boxes.size().
+  GEODE_CORE_EXPORT BoxTree(const int leaf_size, const int depth, Array<const int> p, Array<const Range<int>> ranges,
+                            Array<Box<TV>> boxes, Array<const Vector<int,2>> explicit_children);
 public:
   ~BoxTree();
 
@@ -59,18 +71,14 @@ public:
     return p.slice(ranges[leaf].lo,ranges[leaf].hi);
   }
 
-  static int parent(const int node) {
-    assert(0<node);
-    return (node-1)/2;
+  Vector<int,2> children(const int node) const {
+    assert(!is_leaf(node));
+    return explicit_children.size() ? explicit_children[node] : vec(2*node+1,2*node+2);
   }
 
-  static int child(const int node, const int i) {
+  int child(const int node, const int i) const {
     assert(unsigned(i)<2);
-    return 2*node+1+i;
-  }
-
-  static Vector<int,2> children(const int node) {
-    return vec(2*node+1,2*node+2);
+    return children(node)[i];
   }
 
   GEODE_CORE_EXPORT void update_nonleaf_boxes();
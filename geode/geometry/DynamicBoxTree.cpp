@@ -0,0 +1,303 @@
+//#####################################################################
+// Class DynamicBoxTree
+//#####################################################################
+#include <geode/geometry/DynamicBoxTree.h>
+#include <geode/python/Class.h>
+namespace geode {
+
+typedef real T;
+
+static inline T area(const Box<Vector<T,2>>& box) {
+  return box.empty() ? 0 : box.sizes().sum();
+}
+static inline T area(const Box<Vector<T,3>>& box) {
+  return box.empty() ? 0 : box.surface_area();
+}
+
+template<class TV> DynamicBoxTree<TV>::DynamicBoxTree(const T margin)
+  : margin(margin)
+  , root(-1)
+  , first_free(-1)
+  , count(0) {
+  GEODE_ASSERT(margin>=0);
+}
+
+template<class TV> DynamicBoxTree<TV>::~DynamicBoxTree() {}
+
+template<class TV> int DynamicBoxTree<TV>::allocate() {
+  if (first_free<0) {
+    Node node;
+    node.height = -1;
+    return nodes_.append(node);
+  }
+  const int n = first_free;
+  first_free = nodes_[n].parent;
+  return n;
+}
+
+template<class TV> void DynamicBoxTree<TV>::deallocate(const int n) {
+  auto& node = nodes_[n];
+  node.parent = first_free;
+  node.height = -1;
+  first_free = n;
+}
+
+template<class TV> void DynamicBoxTree<TV>::clear() {
+  nodes_.clear();
+  leaf_of.clear();
+  root = first_free = -1;
+  count = 0;
+}
+
+template<class TV> void DynamicBoxTree<TV>::insert(const int key, const Box<TV>& box) {
+  GEODE_ASSERT(key>=0 && !contains(key));
+  GEODE_ASSERT(!box.empty());
+  if (!leaf_of.valid(key)) {
+    const int old = leaf_of.size();
+    leaf_of.resize(key+1,uninit);
+    leaf_of.slice(old,key+1).fill(-1);
+  }
+  const int leaf = allocate();
+  auto& node = nodes_[leaf];
+  node.box = box.thickened(margin);
+  node.children.fill(-1);
+  node.height = 0;
+  node.key = key;
+  leaf_of[key] = leaf;
+  count++;
+  insert_leaf(leaf);
+}
+
+template<class TV> void DynamicBoxTree<TV>::remove(const int key) {
+  GEODE_ASSERT(contains(key));
+  const int leaf = leaf_of[key];
+  leaf_of[key] = -1;
+  count--;
+  remove_leaf(leaf);
+  deallocate(leaf);
+}
+
+template<class TV> bool DynamicBoxTree<TV>::update(const int key, const Box<TV>& box) {
+  GEODE_ASSERT(contains(key));
+  GEODE_ASSERT(!box.empty());
+  const int leaf = leaf_of[key];
+  const auto& fat = nodes_[leaf].box;
+  if (all_less_equal(fat.min,box.min) && all_less_equal(box.max,fat.max))
+    return false;
+  remove_leaf(leaf);
+  nodes_[leaf].box = box.thickened(margin);
+  insert_leaf(leaf);
+  return true;
+}
+
+// Pick a sibling for the new leaf by walking down from the root, descending into whichever child is cheapest
+// to extend, and stopping once it is cheaper to pair the leaf with the current node than with either child.
+template<class TV> void DynamicBoxTree<TV>::insert_leaf(const int leaf) {
+  if (root<0) {
+    root = leaf;
+    nodes_[leaf].parent = -1;
+    return;
+  }
+  const auto box = nodes_[leaf].box;
+  int sibling = root;
+  while (nodes_[sibling].height) {
+    const auto& node = nodes_[sibling];
+    const T combined = area(Box<TV>::combine(node.box,box));
+    // Pairing with node costs a new parent of area combined, and every ancestor of node grows equally in either case
+    const T here = 2*combined,
+            inherited = 2*(combined-area(node.box));
+    Vector<T,2> costs;
+    for (const int i : range(2)) {
+      const auto& child = nodes_[node.children[i]];
+      const T grown = area(Box<TV>::combine(child.box,box));
+      costs[i] = inherited + (child.height ? grown-area(child.box) : grown);
+    }
+    const int c = costs.argmin();
+    if (here<costs[c])
+      break;
+    sibling = node.children[c];
+  }
+
+  // Replace sibling with a new parent of sibling and leaf
+  const int old_parent = nodes_[sibling].parent,
+            parent = allocate();
+  auto& p = nodes_[parent];
+  p.parent = old_parent;
+  p.children = vec(sibling,leaf);
+  p.box = Box<TV>::combine(nodes_[sibling].box,box);
+  p.height = nodes_[sibling].height+1;
+  p.key = -1;
+  if (old_parent<0)
+    root = parent;
+  else {
+    auto& c = nodes_[old_parent].children;
+    c[c.y==sibling] = parent;
+  }
+  nodes_[sibling].parent = parent;
+  nodes_[leaf].parent = parent;
+  refit(old_parent);
+}
+
+// Detach a leaf, replacing its parent with its sibling
+template<class TV> void DynamicBoxTree<TV>::remove_leaf(const int leaf) {
+  if (leaf==root) {
+    root = -1;
+    return;
+  }
+  const int parent = nodes_[leaf].parent,
+            grandparent = nodes_[parent].parent;
+  const auto& pc = nodes_[parent].children;
+  const int sibling = pc[pc.x==leaf];
+  nodes_[sibling].parent = grandparent;
+  if (grandparent<0)
+    root = sibling;
+  else {
+    auto& c = nodes_[grandparent].children;
+    c[c.y==parent] = sibling;
+  }
+  deallocate(parent);
+  refit(grandparent);
+}
+
+// Rebalance and recompute boxes and heights from node up to the root
+template<class TV> void DynamicBoxTree<TV>::refit(int n) {
+  while (n>=0) {
+    n = balance(n);
+    auto& node = nodes_[n];
+    const auto &c0 = nodes_[node.children.x],
+               &c1 = nodes_[node.children.y];
+    node.height = 1+max(c0.height,c1.height);
+    node.box = Box<TV>::combine(c0.box,c1.box);
+    n = node.parent;
+  }
+}
+
+// If one child of a is at least two levels taller than the other, rotate it up to take a's place.  a adopts
+// the shorter grandchild, and the rotated child keeps the taller one.  Returns the new root of the subtree.
+template<class TV> int DynamicBoxTree<TV>::balance(const int a) {
+  const auto ac = nodes_[a].children;
+  const int diff = nodes_[ac.y].height-nodes_[ac.x].height;
+  if (abs(diff)<2)
+    return a;
+  const int i = diff>0,
+            up = ac[i];
+  const auto uc = nodes_[up].children;
+  const int t = nodes_[uc.x].height<nodes_[uc.y].height,
+            taller = uc[t],
+            shorter = uc[1-t];
+
+  // up replaces a in a's parent
+  const int parent = nodes_[a].parent;
+  nodes_[up].parent = parent;
+  if (parent<0)
+    root = up;
+  else {
+    auto& c = nodes_[parent].children;
+    c[c.y==a] = up;
+  }
+
+  // a becomes a child of up, trading up for shorter
+  auto& A = nodes_[a];
+  A.parent = up;
+  A.children[i] = shorter;
+  nodes_[shorter].parent = a;
+  const auto &a0 = nodes_[A.children.x],
+             &a1 = nodes_[A.children.y];
+  A.height = 1+max(a0.height,a1.height);
+  A.box = Box<TV>::combine(a0.box,a1.box);
+
+  auto& U = nodes_[up];
+  U.children = vec(a,taller);
+  U.height = 1+max(A.height,nodes_[taller].height);
+  U.box = Box<TV>::combine(A.box,nodes_[taller].box);
+  return up;
+}
+
+template<class TV> typename TV::Scalar DynamicBoxTree<TV>::cost() const {
+  T sum = 0;
+  for (const auto& node : nodes_)
+    if (node.height>0)
+      sum += area(node.box);
+  return sum;
+}
+
+template<class TV> Array<int> DynamicBoxTree<TV>::intersection(const Box<TV>& box) const {
+  Array<int> hits;
+  visit(box,[&](const int key) { hits.append(key); });
+  return hits;
+}
+
+template<class TV> void DynamicBoxTree<TV>::check() const {
+  int leaves = 0, internal = 0;
+  if (root>=0) {
+    GEODE_ASSERT(nodes_.valid(root) && nodes_[root].parent<0);
+    Array<int> stack;
+    stack.append(root);
+    while (stack.size()) {
+      const int n = stack.pop();
+      const auto& node = nodes_[n];
+      GEODE_ASSERT(node.height>=0);
+      if (!node.height) {
+        GEODE_ASSERT(node.children==vec(-1,-1));
+        GEODE_ASSERT(leaf_of.valid(node.key) && leaf_of[node.key]==n);
+        leaves++;
+      } else {
+        GEODE_ASSERT(node.key<0);
+        const auto &c0 = nodes_[node.children.x],
+                   &c1 = nodes_[node.children.y];
+        GEODE_ASSERT(c0.parent==n && c1.parent==n);
+        GEODE_ASSERT(node.height==1+max(c0.height,c1.height));
+        GEODE_ASSERT(node.box==Box<TV>::combine(c0.box,c1.box));
+        stack.append(node.children.x);
+        stack.append(node.children.y);
+        internal++;
+      }
+    }
+  }
+  GEODE_ASSERT(leaves==count && internal==max(0,count-1));
+  int present = 0;
+  for (const int leaf : leaf_of)
+    present += leaf>=0;
+  GEODE_ASSERT(present==count);
+  int free = 0;
+  for (int n=first_free;n>=0;n=nodes_[n].parent) {
+    GEODE_ASSERT(nodes_[n].height<0);
+    free++;
+  }
+  GEODE_ASSERT(leaves+internal+free==nodes_.size());
+}
+
+#define INSTANTIATE(d) \
+  template<> GEODE_DEFINE_TYPE(DynamicBoxTree<Vector<T,d>>) \
+  template class DynamicBoxTree<Vector<T,d>>;
+INSTANTIATE(2)
+INSTANTIATE(3)
+
+}
+using namespace geode;
+
+template<int d> static void wrap_helper() {
+  typedef Vector<T,d> TV;
+  typedef DynamicBoxTree<TV> Self;
+  Class<Self>(d==2?"DynamicBoxTree2d":"DynamicBoxTree3d")
+    .GEODE_INIT(T)
+    .GEODE_FIELD(margin)
+    .GEODE_METHOD(size)
+    .GEODE_METHOD(contains)
+    .GEODE_METHOD(box)
+    .GEODE_METHOD(bounding_box)
+    .GEODE_METHOD(height)
+    .GEODE_METHOD(insert)
+    .GEODE_METHOD(remove)
+    .GEODE_METHOD(update)
+    .GEODE_METHOD(clear)
+    .GEODE_METHOD(cost)
+    .GEODE_METHOD(intersection)
+    .GEODE_METHOD(check)
+    ;
+}
+
+void wrap_dynamic_box_tree() {
+  wrap_helper<2>();
+  wrap_helper<3>();
+}
@@ -0,0 +1,125 @@
+//#####################################################################
+// Class DynamicBoxTree
+//#####################################################################
+//
+// DynamicBoxTree is a bounding box hierarchy supporting insertion and removal of
+// individual primitives, for use when primitives come and go too often to rebuild
+// a BoxTree (e.g., the faces of a MutableTriangleTopology under interactive editing).
+//
+// Primitives are identified by nonnegative integer keys, typically FaceId.idx() or
+// VertexId.idx().  Each primitive occupies its own leaf.  New leaves are placed next
+// to the sibling minimizing the increase in total surface area, and tree rotations on
+// the way back up lift taller subtrees to keep the tree balanced.
+//
+// Leaf boxes are thickened by margin, so that update() reinserts a primitive only
+// if it has moved outside of its thickened box.  Queries may therefore return
+// primitives whose actual boxes are up to margin away; callers needing exact results
+// should test the primitives themselves.
+//
+//#####################################################################
+#pragma once
+
+#include <geode/array/Array.h>
+#include <geode/array/RawStack.h>
+#include <geode/array/alloca.h>
+#include <geode/geometry/Box.h>
+#include <geode/python/Object.h>
+#include <geode/vector/Vector.h>
+namespace geode {
+
+template<class TV> class DynamicBoxTree : public Object
+{
+  typedef typename TV::Scalar T;
+public:
+  GEODE_DECLARE_TYPE(GEODE_CORE_EXPORT)
+  typedef Object Base;
+
+  const T margin;
+
+private:
+  struct Node {
+    Box<TV> box;
+    int parent; // -1 for the root.  For free nodes, the next free node.
+    Vector<int,2> children; // Both -1 for leaves
+    int height; // 0 for leaves, -1 for free nodes
+    int key; // -1 for internal nodes
+  };
+
+  Array<Node> nodes_;
+  Array<int> leaf_of; // Key to leaf node, or -1 if absent
+  int root, first_free, count;
+
+protected:
+  GEODE_CORE_EXPORT DynamicBoxTree(const T margin=0);
+public:
+  ~DynamicBoxTree();
+
+  // Number of primitives
+  int size() const {
+    return count;
+  }
+
+  bool contains(const int key) const {
+    return leaf_of.valid(key) && leaf_of[key]>=0;
+  }
+
+  // Thickened box of a primitive
+  const Box<TV>& box(const int key) const {
+    GEODE_ASSERT(contains(key));
+    return nodes_[leaf_of[key]].box;
+  }
+
+  Box<TV> bounding_box() const {
+    return root>=0 ? nodes_[root].box : Box<TV>::empty_box();
+  }
+
+  // Number of edges on the longest path from the root to a leaf, or -1 if empty
+  int height() const {
+    return root>=0 ? nodes_[root].height : -1;
+  }
+
+  GEODE_CORE_EXPORT void insert(const int key, const Box<TV>& box);
+  GEODE_CORE_EXPORT void remove(const int key);
+
+  // Change the box of a primitive, reinserting only if it leaves its thickened box.  Returns true if reinserted.
+  GEODE_CORE_EXPORT bool update(const int key, const Box<TV>& box);
+
+  GEODE_CORE_EXPORT void clear();
+
+  // Sum of surface areas (perimeters in 2D) of internal nodes, a measure of tree quality
+  GEODE_CORE_EXPORT T cost() const;
+
+  // Keys of primitives whose thickened boxes intersect box, in no particular order
+  GEODE_CORE_EXPORT Array<int> intersection(const Box<TV>& box) const;
+
+  // Call visit(key) for each primitive whose thickened box intersects box.  visit may not modify the tree.
+  template<class Visit> void visit(const Box<TV>& box, const Visit& visit) const {
+    if (root<0)
+      return;
+    RawStack<int> stack(GEODE_RAW_ALLOCA(nodes_[root].height+2,int));
+    stack.push(root);
+    while (stack.size()) {
+      const auto& node = nodes_[stack.pop()];
+      if (!node.box.lazy_intersects(box))
+        continue;
+      if (node.height) {
+        stack.push(node.children.x);
+        stack.push(node.children.y);
+      } else
+        visit(node.key);
+    }
+  }
+
+  // Verify parent pointers, heights, balance, boxes, and the key map
+  GEODE_CORE_EXPORT void check() const;
+
+private:
+  int allocate();
+  void deallocate(const int node);
+  void insert_leaf(const int leaf);
+  void remove_leaf(const int leaf);
+  void refit(int node);
+  int balance(const int node);
+};
+
+}
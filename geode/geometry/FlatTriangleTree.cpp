@@ -0,0 +1,125 @@
+//#####################################################################
+// Class FlatTriangleTree
+//#####################################################################
+#include <geode/geometry/FlatTriangleTree.h>
+#include <geode/geometry/spatial_keys.h>
+#include <geode/python/Class.h>
+#include <geode/utility/const_cast.h>
+#include <geode/utility/openmp.h>
+#include <geode/utility/parallel.h>
+namespace geode {
+
+typedef real T;
+typedef Vector<T,3> TV;
+GEODE_DEFINE_TYPE(FlatTriangleTree)
+
+FlatTriangleTree::FlatTriangleTree(const SimplexTree<TV,2>& tree)
+  : tree(ref(tree))
+  , wide(new_<WideBoxTree<TV>>(tree))
+  , triangles(tree.mesh->elements.size(),uninit) {
+  // Leaves hold consecutive ranges of the permutation, so leaf order is permutation order
+  Array<Vector<int,2>> leaf_ranges(tree.leaves.size(),uninit);
+  for (const int n : tree.leaves)
+    leaf_ranges[n-tree.leaves.lo] = vec(tree.ranges[n].lo,tree.ranges[n].hi);
+  const_cast_(this->leaf_ranges) = leaf_ranges;
+  const_cast_(ids) = tree.p;
+  update();
+}
+
+FlatTriangleTree::~FlatTriangleTree() {}
+
+void FlatTriangleTree::update() {
+  wide->update();
+  parallel_for(triangles.size(),[&](const int i) {
+    triangles[i] = tree->simplices[ids[i]];
+  },1024);
+}
+
+Tuple<Array<int>,Array<T>> FlatTriangleTree::closest_hits(RawArray<const TV> starts, RawArray<const TV> directions,
+                                                          const T half_thickness, const T t_max) const {
+  GEODE_ASSERT(starts.size()==directions.size());
+  const int n = starts.size(),
+            leaf_lo = tree->leaves.lo;
+  Array<int> simplices(n,uninit);
+  Array<T> t(n,uninit);
+  parallel_for(n,[&](const int i) {
+    RayIntersection<TV> ray(starts[i],directions[i]);
+    ray.t_max = t_max;
+    int hit = -1;
+    wide_ray_traverse(*wide,ray,half_thickness,[&](const int leaf) {
+      const auto r = leaf_ranges[leaf-leaf_lo];
+      for (int k=r.x;k<r.y;k++)
+        if (triangles[k].intersection(ray,half_thickness))
+          hit = k;
+    });
+    simplices[i] = hit<0 ? -1 : ids[hit];
+    t[i] = ray.t_max;
+  },256);
+  return tuple(simplices,t);
+}
+
+Tuple<Array<TV>,Array<int>,Array<TV>> FlatTriangleTree::closest_points(RawArray<const TV> points,
+                                                                        const T max_distance) const {
+  const int n = points.size(),
+            leaf_lo = tree->leaves.lo;
+  const auto lanes = tree->lanes.raw();
+  const auto lane_offsets = tree->lane_offsets.raw();
+  Array<TV> X(n,uninit), weights(n,uninit);
+  Array<int> simplex(n,uninit);
+
+  // As in SimplexTree::closest_points, queries run in Morton order, and each starts with the previous query's
+  // triangle as an upper bound
+  const auto order = morton_order(points);
+  const T sqr_max_distance = sqr(max_distance);
+  const int chunks = min(n,64*omp_get_max_threads());
+  #pragma omp parallel for schedule(dynamic,1)
+  for (int c=0;c<chunks;c++) {
+    int previous = -1;
+    for (const int k : partition_loop(n,chunks,c)) {
+      const int i = order[k];
+      const TV point = points[i];
+      int best = -1;
+      T sqr_distance = sqr_max_distance;
+      if (previous >= 0) {
+        const T sqr_d = sqr_magnitude(point-triangles[previous].closest_point(point).x);
+        if (sqr_d <= sqr_distance) {
+          best = previous;
+          sqr_distance = sqr_d;
+        }
+      }
+      wide_closest_traverse(*wide,point,sqr_distance,[&](const int leaf, T& sqr_distance) {
+        const auto r = leaf_ranges[leaf-leaf_lo];
+        const int t = closest_lane(&lanes[lane_offsets[leaf-leaf_lo]],r.y-r.x,point,sqr_distance);
+        if (t >= 0)
+          best = r.x+t;
+      });
+      if (best < 0) {
+        X[i].fill(inf);
+        simplex[i] = -1;
+        weights[i] = TV();
+      } else {
+        const auto r = triangles[best].closest_point(point);
+        X[i] = r.x;
+        simplex[i] = ids[best];
+        weights[i] = r.y;
+        previous = best;
+      }
+    }
+  }
+  return tuple(X,simplex,weights);
+}
+
+}
+using namespace geode;
+
+void wrap_flat_triangle_tree() {
+  typedef FlatTriangleTree Self;
+  Class<Self>("FlatTriangleTree")
+    .GEODE_INIT(const SimplexTree<TV,2>&)
+    .GEODE_FIELD(tree)
+    .GEODE_FIELD(ids)
+    .GEODE_METHOD(update)
+    .GEODE_METHOD(closest_hits)
+    .GEODE_METHOD(closest_points)
+    ;
+}
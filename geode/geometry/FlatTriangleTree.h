@@ -0,0 +1,55 @@
+//#####################################################################
+// Class FlatTriangleTree
+//#####################################################################
+//
+// FlatTriangleTree packs a triangle SimplexTree into a few flat arrays for
+// very large query batches: the nodes of a WideBoxTree, and copies of the
+// triangles stored in leaf order, so each leaf is a contiguous range of
+// triangles and the primitive permutation is applied once at build time
+// instead of on every visit.  Closest point queries test each leaf with
+// the SimplexLanes of the underlying tree, which are in the same order.
+// Queries read nothing else, and never touch the mesh, the positions, or
+// the binary tree.  Each query runs as an independent kernel with a fixed
+// size stack, and batches run in parallel.
+//
+// The layout is built once and reused for every batch; call update() after
+// updating the underlying SimplexTree.  Results match the corresponding
+// SimplexTree queries, which remain the reference implementation, up to
+// ties between equally close triangles.
+//
+//#####################################################################
+#pragma once
+
+#include <geode/geometry/SimplexTree.h>
+#include <geode/geometry/Triangle3d.h>
+#include <geode/geometry/WideBoxTree.h>
+namespace geode {
+
+class FlatTriangleTree : public Object {
+public:
+  GEODE_DECLARE_TYPE(GEODE_CORE_EXPORT)
+  typedef Object Base;
+  typedef real T;
+  typedef Vector<T,3> TV;
+
+  const Ref<const SimplexTree<TV,2>> tree;
+  const Ref<WideBoxTree<TV>> wide;
+  const Array<const Vector<int,2>> leaf_ranges; // Triangles of each binary tree leaf, offset by tree->leaves.lo
+  const Array<Triangle<TV>> triangles; // In leaf order
+  const Array<const int> ids; // Simplex of each triangle in tree
+
+protected:
+  GEODE_CORE_EXPORT FlatTriangleTree(const SimplexTree<TV,2>& tree);
+public:
+  ~FlatTriangleTree();
+
+  GEODE_CORE_EXPORT void update(); // Call whenever tree is updated
+
+  // Same as SimplexTree::closest_hits and SimplexTree::closest_points
+  GEODE_CORE_EXPORT Tuple<Array<int>,Array<T>> closest_hits(RawArray<const TV> starts, RawArray<const TV> directions,
+                                                            const T thickness_over_two, const T t_max=inf) const;
+  GEODE_CORE_EXPORT Tuple<Array<TV>,Array<int>,Array<TV>> closest_points(RawArray<const TV> points,
+                                                                         const T max_distance=inf) const;
+};
+
+}
@@ -23,6 +23,19 @@ template<class TV> typename TV::Scalar FrameImplicit<TV>::phi(const TV& X) const
   return object->phi(frame.inverse_times(X));
 }
 
+// Transform points in chunks so that the wrapped object sees batches as well
+template<class TV> void FrameImplicit<TV>::phi(RawArray<const TV> X, RawArray<T> phi) const {
+  GEODE_ASSERT(X.size()==phi.size());
+  const int chunk = 256;
+  TV local[chunk];
+  for (int start=0;start<X.size();start+=chunk) {
+    const int n = min(chunk,X.size()-start);
+    for (int i=0;i<n;i++)
+      local[i] = frame.inverse_times(X[start+i]);
+    object->phi(RawArray<const TV>(n,local),phi.slice(start,start+n));
+  }
+}
+
 template<class TV> TV FrameImplicit<TV>::normal(const TV& X) const {
   return frame.r*object->normal(frame.inverse_times(X));
 }
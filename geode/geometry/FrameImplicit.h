@@ -22,6 +22,7 @@ public:
   virtual ~FrameImplicit();
 
   virtual T phi(const TV& X) const;
+  virtual void phi(RawArray<const TV> X, RawArray<T> phi) const;
   virtual TV normal(const TV& X) const;
   virtual TV surface(const TV& X) const;
   virtual bool lazy_inside(const TV& X) const;
@@ -20,6 +20,22 @@ template<class TV> Implicit<TV>::
 ~Implicit()
 {}
 
+template<class TV> void Implicit<TV>::
+phi(RawArray<const TV> X, RawArray<T> phi) const
+{
+  GEODE_ASSERT(X.size()==phi.size());
+  for (int i=0;i<X.size();i++)
+    phi[i] = this->phi(X[i]);
+}
+
+template<class TV> Array<typename TV::Scalar> Implicit<TV>::
+phis(Array<const TV> X) const
+{
+  Array<T> phi(X.size(),uninit);
+  this->phi(X,phi);
+  return phi;
+}
+
 template class Implicit<Vector<T,1> >;
 template class Implicit<Vector<T,2> >;
 template class Implicit<Vector<T,3> >;
@@ -33,7 +49,8 @@ template<int d> static void wrap_helper() {
 
   Class<Self>("Implicit")
     .GEODE_FIELD(d)
-    .GEODE_METHOD(phi)
+    .GEODE_OVERLOADED_METHOD(T(Self::*)(const TV&)const,phi)
+    .GEODE_METHOD(phis)
     .GEODE_METHOD(normal)
     .GEODE_METHOD(lazy_inside)
     .GEODE_METHOD(surface)
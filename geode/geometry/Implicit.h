@@ -3,6 +3,7 @@
 //#####################################################################
 #pragma once
 
+#include <geode/array/Array.h>
 #include <geode/geometry/Box.h>
 #include <geode/python/Object.h>
 #include <geode/vector/Vector.h>
@@ -20,6 +21,8 @@ public:
   virtual ~Implicit();
 
   virtual T phi(const TV& X) const=0;
+  virtual void phi(RawArray<const TV> X, RawArray<T> phi) const; // Batched phi, one virtual call for many points
+  GEODE_CORE_EXPORT Array<T> phis(Array<const TV> X) const; // Functional-style batched phi
   virtual TV normal(const TV& X) const=0;
   virtual TV surface(const TV& X) const=0;
   virtual bool lazy_inside(const TV& X) const=0;
@@ -4,9 +4,15 @@
 #include <geode/geometry/ParticleTree.h>
 #include <geode/geometry/Sphere.h>
 #include <geode/geometry/traverse.h>
+#include <geode/geometry/WideBoxTree.h>
 #include <geode/array/IndirectArray.h>
 #include <geode/python/Class.h>
 #include <geode/structure/UnionFind.h>
+#include <geode/utility/openmp.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
 namespace geode {
 using std::cout;
 using std::endl;
@@ -16,27 +22,29 @@ template<> GEODE_DEFINE_TYPE(ParticleTree<Vector<T,2>>)
 template<> GEODE_DEFINE_TYPE(ParticleTree<Vector<T,3>>)
 
 template<class TV> ParticleTree<TV>::
-ParticleTree(Array<const TV> X,int leaf_size)
-  : Base(X.raw(),leaf_size), X(X) {}
+ParticleTree(Array<const TV> X,int leaf_size,bool sah)
+  : Base(X.raw(),leaf_size,sah), X(X) {}
 
 template<class TV> ParticleTree<TV>::
 ~ParticleTree() {}
 
 template<class TV> void ParticleTree<TV>::
 update() {
-  for (int n : leaves)
+  #pragma omp parallel for
+  for (int n=leaves.lo;n<leaves.hi;n++)
     boxes[n] = geode::bounding_box(X.subset(prims(n)));
   update_nonleaf_boxes();
 }
 
 namespace {
+// Copies of the visitor made by parallel_double_traverse share one union-find, so merge has nothing to do
 template<class TV> struct DuplicatesVisitor {
   const ParticleTree<TV>& tree;
-  UnionFind components;
+  ConcurrentUnionFind& components;
   T tolerance;
 
-  DuplicatesVisitor(const ParticleTree<TV>& tree, T tolerance)
-    : tree(tree), components(tree.X.size()), tolerance(tolerance) {}
+  DuplicatesVisitor(const ParticleTree<TV>& tree, ConcurrentUnionFind& components, T tolerance)
+    : tree(tree), components(components), tolerance(tolerance) {}
 
   bool cull(int n) const { return false; }
   bool cull(int n0, int n1) const { return false; }
@@ -53,28 +61,124 @@ template<class TV> struct DuplicatesVisitor {
       if ((tree.X[i]-tree.X[j]).sqr_magnitude()<=sqr(tolerance))
         components.merge(i,j);
   }
+
+  void merge(const DuplicatesVisitor& other) {}
 };
 }
 
+// Integer cell coordinates of a point in a grid with the given cell size, or of the exact point if cell_size is zero
+template<int d> static inline Vector<int64_t,d> grid_cell(const Vector<T,d>& x, const T cell_size) {
+  Vector<int64_t,d> cell;
+  for (int a=0;a<d;a++) {
+    if (cell_size)
+      cell[a] = int64_t(floor(x[a]/cell_size));
+    else {
+      const T y = x[a]+0; // Map -0 to 0
+      memcpy(&cell[a],&y,sizeof(T));
+    }
+  }
+  return cell;
+}
+
+template<int d> static inline uint32_t grid_hash(const Vector<int64_t,d>& cell) {
+  static const uint64_t primes[3] = {73856093,19349663,83492791};
+  uint64_t h = 0;
+  for (int a=0;a<d;a++)
+    h ^= uint64_t(cell[a])*primes[a];
+  return uint32_t(h^h>>32);
+}
+
+// Merge particles within tolerance by hashing them into a uniform grid with cells of size tolerance.  Each pair
+// of neighbors then lies in the same or adjacent cells, and is checked once from the lexicographically lower cell.
+template<class TV> static void grid_duplicates(RawArray<const TV> X, const T tolerance, ConcurrentUnionFind& components) {
+  static const int d = TV::m;
+  const int n = X.size();
+  const T cell_size = abs(tolerance);
+  Array<Vector<int64_t,d>> cells(n,uninit);
+  Array<uint32_t> buckets(n,uninit);
+  const uint32_t size = uint32_t(max(1,2*n));
+  #pragma omp parallel for
+  for (int i=0;i<n;i++) {
+    cells[i] = grid_cell(X[i],cell_size);
+    buckets[i] = grid_hash(cells[i])%size;
+  }
+
+  // Sort particles by bucket
+  Array<int> offsets(size+1);
+  for (const auto b : buckets)
+    offsets[b+1]++;
+  for (uint32_t b=0;b<size;b++)
+    offsets[b+1] += offsets[b];
+  Array<int> sorted(n,uninit);
+  {
+    auto next = offsets.slice(0,size).copy();
+    for (int i=0;i<n;i++)
+      sorted[next[buckets[i]]++] = i;
+  }
+
+  // Offsets of lexicographically positive neighbor cells, or none if we only want exact duplicates
+  Array<Vector<int64_t,d>> shifts;
+  if (cell_size) {
+    const int count = int(pow(3.,d));
+    for (int k=0;k<count;k++) {
+      Vector<int64_t,d> shift;
+      for (int a=0,r=k;a<d;a++,r/=3)
+        shift[d-1-a] = r%3-1;
+      for (int a=0;a<d;a++)
+        if (shift[a]) {
+          if (shift[a]>0)
+            shifts.append(shift);
+          break;
+        }
+    }
+  }
+
+  const T sqr_tolerance = sqr(tolerance);
+  #pragma omp parallel for schedule(dynamic,1024)
+  for (int i=0;i<n;i++) {
+    const auto& cell = cells[i];
+    // Same cell
+    for (const int j : sorted.slice(offsets[buckets[i]],offsets[buckets[i]+1]))
+      if (j>i && cells[j]==cell && sqr_magnitude(X[i]-X[j])<=sqr_tolerance)
+        components.merge(i,j);
+    // Adjacent cells
+    for (const auto& shift : shifts) {
+      const auto other = cell+shift;
+      const uint32_t b = grid_hash(other)%size;
+      for (const int j : sorted.slice(offsets[b],offsets[b+1]))
+        if (cells[j]==other && sqr_magnitude(X[i]-X[j])<=sqr_tolerance)
+          components.merge(i,j);
+    }
+  }
+}
+
+// Components are numbered in order of their first point
 template<class TV> Array<int> ParticleTree<TV>::
 remove_duplicates(T tolerance) const {
-  DuplicatesVisitor<TV> visitor(*this,tolerance);
-  double_traverse(*this,visitor,tolerance);
+  ConcurrentUnionFind components(X.size());
+  // Use a hash grid unless the tolerance is too small for grid coordinates to fit in 64-bit integers
+  const auto box = geode::bounding_box(X);
+  if (!X.size() || !tolerance || max(box.min.maxabs(),box.max.maxabs())/abs(tolerance)<T(1ll<<60))
+    grid_duplicates(X.raw(),tolerance,components);
+  else {
+    DuplicatesVisitor<TV> visitor(*this,components,tolerance);
+    parallel_double_traverse(*this,visitor,tolerance);
+  }
   Array<int> map(X.size(),uninit);
   int count=0;
   for(int i=0;i<X.size();i++)
-    if(visitor.components.is_root(i))
+    if(components.is_root(i))
       map[i] = count++;
   for(int i=0;i<X.size();i++)
-    map[i] = map[visitor.components.find(i)];
+    map[i] = map[components.find(i)];
   return map;
 }
 
 template<class TV,class Shape> static void intersection_helper(const ParticleTree<TV>& self, const Shape& shape, Array<int>& hits, int node) {
   if (shape.lazy_intersects(self.boxes[node])) {
     if(!self.is_leaf(node)) {
-      intersection_helper(self,shape,hits,2*node+1);
-      intersection_helper(self,shape,hits,2*node+2);
+      intersection_helper(self,shape,hits,self.child(node,0));
+      intersection_helper(self,shape,hits,self.child(node,1));
     } else
       for (int i : self.prims(node))
         if (shape.lazy_inside(self.X[i]))
@@ -89,15 +193,27 @@ intersection(const Shape& shape, Array<int>& hits) const {
     intersection_helper(*this,shape,hits,0);
 }
 
+template<class TV> template<class Shape> void ParticleTree<TV>::
+intersection(const Shape& shape, Array<int>& hits, const WideBoxTree<TV>& wide) const {
+  GEODE_ASSERT(&*wide.tree==this);
+  hits.clear();
+  wide_intersection_traverse(wide,shape,[&](const int leaf) {
+    for (const int i : prims(leaf))
+      if (shape.lazy_inside(X[i]))
+        hits.append(i);
+  });
+}
+
 template<class TV> static void closest_point_helper(const ParticleTree<TV>& self, TV point, int& index, T& sqr_distance, int node, int ignore) {
   if (!self.is_leaf(node)) {
-    Vector<T,2> bounds(self.boxes[2*node+1].sqr_distance_bound(point),
-                       self.boxes[2*node+2].sqr_distance_bound(point));
+    const auto children = self.children(node);
+    Vector<T,2> bounds(self.boxes[children.x].sqr_distance_bound(point),
+                       self.boxes[children.y].sqr_distance_bound(point));
     int c = bounds.argmin();
     if (bounds[c]<sqr_distance)
-      closest_point_helper(self,point,index,sqr_distance,2*node+1+c,ignore);
+      closest_point_helper(self,point,index,sqr_distance,children[c],ignore);
     if (bounds[1-c]<sqr_distance)
-      closest_point_helper(self,point,index,sqr_distance,2*node+2-c,ignore);
+      closest_point_helper(self,point,index,sqr_distance,children[1-c],ignore);
   } else
     for (int t : self.prims(node)) {
       T sqr_d = sqr_magnitude(point-self.X[t]);
@@ -123,6 +239,28 @@ closest_point(TV point, int& index, T max_distance, int ignore) const {
     return X[index];
 }
 
+template<class TV> TV ParticleTree<TV>::
+closest_point(TV point, int& index, T max_distance, int ignore, const WideBoxTree<TV>& wide) const {
+  GEODE_ASSERT(&*wide.tree==this);
+  index = -1;
+  T sqr_distance = sqr(max_distance);
+  wide_closest_traverse(wide,point,sqr_distance,[&](const int leaf, T& sqr_distance) {
+    for (const int t : prims(leaf)) {
+      const T sqr_d = sqr_magnitude(point-X[t]);
+      if (sqr_distance>sqr_d && t != ignore) {
+        sqr_distance = sqr_d;
+        index = t;
+      }
+    }
+  });
+  if (index == -1) {
+    TV x;
+    x.fill(inf);
+    return x;
+  } else
+    return X[index];
+}
+
 template<class TV> TV ParticleTree<TV>::
 closest_point(TV point, T max_distance) const {
   int index;
@@ -135,10 +273,129 @@ template<class TV> Tuple<TV,int> ParticleTree<TV>::closest_point_py(TV point, T
   return tuple(p,index);
 }
 
+// Bounded max-heap of (sqr_distance,index) pairs, ordered by distance and then index
+static inline bool heap_less(const Tuple<T,int>& a, const Tuple<T,int>& b) {
+  return a.x<b.x || (a.x==b.x && a.y<b.y);
+}
+
+// Find the k nearest particles with squared distance below sqr_bound.  Once the heap is full, sqr_bound shrinks to
+// the distance of the farthest particle in the heap.
+template<class TV> static void nearest_helper(const ParticleTree<TV>& self, const TV point, const int k,
+                                              Array<Tuple<T,int>>& heap, T& sqr_bound, const int node) {
+  if (!self.is_leaf(node)) {
+    const auto children = self.children(node);
+    Vector<T,2> bounds(self.boxes[children.x].sqr_distance_bound(point),
+                       self.boxes[children.y].sqr_distance_bound(point));
+    const int c = bounds.argmin();
+    if (bounds[c]<sqr_bound)
+      nearest_helper(self,point,k,heap,sqr_bound,children[c]);
+    if (bounds[1-c]<sqr_bound)
+      nearest_helper(self,point,k,heap,sqr_bound,children[1-c]);
+  } else
+    for (const int i : self.prims(node)) {
+      const T sqr_d = sqr_magnitude(point-self.X[i]);
+      if (sqr_d<sqr_bound) {
+        if (heap.size()==k) {
+          std::pop_heap(heap.begin(),heap.end(),heap_less);
+          heap.pop();
+        }
+        heap.append(tuple(sqr_d,i));
+        std::push_heap(heap.begin(),heap.end(),heap_less);
+        if (heap.size()==k)
+          sqr_bound = heap[0].x;
+      }
+    }
+}
+
+// Append the k nearest particles to result, reusing heap as scratch space
+template<class TV> static void nearest_helper(const ParticleTree<TV>& self, const TV point, const int k,
+                                              const T max_distance, Array<Tuple<T,int>>& heap, Array<int>& result) {
+  heap.clear();
+  if (k>0 && self.nodes()) {
+    T sqr_bound = sqr(max_distance);
+    nearest_helper(self,point,k,heap,sqr_bound,0);
+  }
+  std::sort_heap(heap.begin(),heap.end(),heap_less);
+  for (const auto& h : heap)
+    result.append(h.y);
+}
+
+template<class TV> Array<int> ParticleTree<TV>::
+nearest(TV point, int k, T max_distance) const {
+  GEODE_ASSERT(k>=0);
+  Array<Tuple<T,int>> heap;
+  Array<int> result;
+  nearest_helper(*this,point,k,max_distance,heap,result);
+  return result;
+}
+
+template<class TV> static void radius_helper(const ParticleTree<TV>& self, const TV point, const T sqr_radius,
+                                             Array<int>& result, const int node) {
+  if (self.boxes[node].sqr_distance_bound(point)>sqr_radius)
+    return;
+  if (!self.is_leaf(node)) {
+    const auto children = self.children(node);
+    radius_helper(self,point,sqr_radius,result,children.x);
+    radius_helper(self,point,sqr_radius,result,children.y);
+  } else
+    for (const int i : self.prims(node))
+      if (sqr_magnitude(point-self.X[i])<=sqr_radius)
+        result.append(i);
+}
+
+// Run query(i,flat,heap) for each of n points in parallel, where query appends the results for point i to flat and
+// may use heap as scratch space.  Each chunk of points shares one flat array and heap, so there is no allocation per
+// query.  The results are then gathered in point order.
+template<class Query> static Nested<int> batch_queries(const int n, const Query& query) {
+  const int chunks = min(n,64*omp_get_max_threads());
+  Array<int> counts(n,uninit);
+  std::vector<Array<int>> flats(chunks);
+  #pragma omp parallel for schedule(dynamic,1)
+  for (int c=0;c<chunks;c++) {
+    auto& flat = flats[c];
+    Array<Tuple<T,int>> heap;
+    for (const int i : partition_loop(n,chunks,c)) {
+      const int start = flat.size();
+      query(i,flat,heap);
+      counts[i] = flat.size()-start;
+    }
+  }
+  Nested<int> result(counts,uninit);
+  #pragma omp parallel for
+  for (int c=0;c<chunks;c++) {
+    const int start = result.offsets[partition_loop(n,chunks,c).lo];
+    result.flat.slice(start,start+flats[c].size()) = flats[c];
+  }
+  return result;
+}
+
+template<class TV> Nested<int> ParticleTree<TV>::
+nearest_neighbors(RawArray<const TV> points, int k, T max_distance) const {
+  GEODE_ASSERT(k>=0);
+  return batch_queries(points.size(),[&](const int i, Array<int>& flat, Array<Tuple<T,int>>& heap) {
+    nearest_helper(*this,points[i],k,max_distance,heap,flat);
+  });
+}
+
+template<class TV> Nested<int> ParticleTree<TV>::
+radius_neighbors(RawArray<const TV> points, T radius) const {
+  const T sqr_radius = sqr(radius);
+  return batch_queries(points.size(),[&](const int i, Array<int>& flat, Array<Tuple<T,int>>& heap) {
+    const int start = flat.size();
+    if (nodes())
+      radius_helper(*this,points[i],sqr_radius,flat,0);
+    std::sort(flat.begin()+start,flat.end());
+  });
+}
+
 #define INSTANTIATE(d) \
   template class ParticleTree<Vector<T,d>>; \
   template GEODE_CORE_EXPORT void ParticleTree<Vector<T,d>>::intersection(const Box<Vector<T,d>>&,Array<int>&) const; \
-  template GEODE_CORE_EXPORT void ParticleTree<Vector<T,d>>::intersection(const Sphere<Vector<T,d>>&,Array<int>&) const;
+  template GEODE_CORE_EXPORT void ParticleTree<Vector<T,d>>::intersection(const Sphere<Vector<T,d>>&,Array<int>&) const; \
+  template GEODE_CORE_EXPORT void ParticleTree<Vector<T,d>>::intersection(const Box<Vector<T,d>>&,Array<int>&, \
+                                                                          const WideBoxTree<Vector<T,d>>&) const; \
+  template GEODE_CORE_EXPORT void ParticleTree<Vector<T,d>>::intersection(const Sphere<Vector<T,d>>&,Array<int>&, \
+                                                                          const WideBoxTree<Vector<T,d>>&) const;
 INSTANTIATE(2)
 INSTANTIATE(3)
 }
@@ -148,11 +405,14 @@ template<int d> static void wrap_helper() {
   typedef Vector<T,d> TV;
   typedef ParticleTree<TV> Self;
   Class<Self>(d==2?"ParticleTree2d":"ParticleTree3d")
-    .GEODE_INIT(Array<const TV>,int)
+    .GEODE_INIT(Array<const TV>,int,bool)
     .GEODE_FIELD(X)
     .GEODE_METHOD(update)
     .GEODE_METHOD(remove_duplicates)
     .GEODE_METHOD_2("closest_point",closest_point_py)
+    .GEODE_METHOD(nearest)
+    .GEODE_METHOD(nearest_neighbors)
+    .GEODE_METHOD(radius_neighbors)
     ;
 }
 
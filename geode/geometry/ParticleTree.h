@@ -5,6 +5,7 @@
 
 #include <geode/geometry/forward.h>
 #include <geode/geometry/BoxTree.h>
+#include <geode/array/Nested.h>
 #include <geode/math/constants.h>
 
 namespace geode {
@@ -21,7 +22,7 @@ public:
   const Array<const TV> X;
 
 protected:
-  GEODE_CORE_EXPORT ParticleTree(Array<const TV> X, int leaf_size);
+  GEODE_CORE_EXPORT ParticleTree(Array<const TV> X, int leaf_size, bool sah=false);
 public:
   ~ParticleTree();
 
@@ -34,6 +35,20 @@ public:
   GEODE_CORE_EXPORT TV closest_point(TV point, int& index, T max_distance=inf, int ignore = -1) const; // simplex=-1 if nothing is found
   GEODE_CORE_EXPORT TV closest_point(TV point, T max_distance=inf) const; // return value is infinity if nothing is found
   GEODE_CORE_EXPORT Tuple<TV,int> closest_point_py(TV point, T max_distance=inf) const;
+
+  // Indices of the k nearest particles closer than max_distance, sorted by increasing distance
+  GEODE_CORE_EXPORT Array<int> nearest(TV point, int k, T max_distance=inf) const;
+
+  // Batched parallel versions of nearest, and of sphere intersection for spheres of a fixed radius.  Neighbors of
+  // each point are sorted by distance for nearest_neighbors and by index for radius_neighbors.  If points is X,
+  // each point is its own neighbor.
+  GEODE_CORE_EXPORT Nested<int> nearest_neighbors(RawArray<const TV> points, int k, T max_distance=inf) const;
+  GEODE_CORE_EXPORT Nested<int> radius_neighbors(RawArray<const TV> points, T radius) const;
+
+  // Versions of the above queries which traverse a WideBoxTree built from this tree.  Call wide.update() after update().
+  template<class Shape>
+  GEODE_CORE_EXPORT void intersection(const Shape& box, Array<int>& hits, const WideBoxTree<TV>& wide) const;
+  GEODE_CORE_EXPORT TV closest_point(TV point, int& index, T max_distance, int ignore, const WideBoxTree<TV>& wide) const;
 };
 
 }
@@ -0,0 +1,134 @@
+// Batched polygon outline intersection against a set of placed polygons
+
+#include <geode/geometry/PolygonOutlines.h>
+#include <geode/geometry/BoxTree.h>
+#include <geode/geometry/polygon.h>
+#include <geode/geometry/RayIntersection.h>
+#include <geode/geometry/SimplexTree.h>
+#include <geode/geometry/traverse.h>
+#include <geode/array/Nested.h>
+#include <geode/array/sort.h>
+#include <geode/mesh/SegmentSoup.h>
+#include <geode/python/Class.h>
+#include <geode/utility/parallel.h>
+#include <geode/vector/transform.h>
+namespace geode {
+
+using std::vector;
+
+GEODE_DEFINE_TYPE(PolygonOutlines)
+
+PolygonOutlines::PolygonOutlines() {}
+
+PolygonOutlines::~PolygonOutlines() {}
+
+static Ref<const SimplexTree<Vec2,1>> outline_tree(RawArray<const Vec2> poly) {
+  GEODE_ASSERT(poly.size()>=2);
+  const auto mesh = to_segment_soup(make_nested(poly.copy()),false);
+  return new_<SimplexTree<Vec2,1>>(mesh.x,mesh.y,4);
+}
+
+int PolygonOutlines::add(RawArray<const Vec2> poly) {
+  const int id = size();
+  trees.push_back(outline_tree(poly));
+  boxes.append(bounding_box(poly));
+  top.clear();
+  return id;
+}
+
+void PolygonOutlines::extend(Nested<const Vec2> polys) {
+  const int n = polys.size();
+  for (const int p : range(n))
+    GEODE_ASSERT(polys.size(p)>=2);
+  vector<Ptr<const SimplexTree<Vec2,1>>> built(n);
+  parallel_for(n,[&](const int p) { built[p] = outline_tree(polys[p]); },1);
+  for (const int p : range(n)) {
+    trees.push_back(ref(*built[p]));
+    boxes.append(bounding_box(polys[p]));
+  }
+  if (n)
+    top.clear();
+}
+
+void PolygonOutlines::update_top() {
+  if (!top && size())
+    top = new_<BoxTree<Vec2>>(boxes,1);
+}
+
+namespace {
+template<class Hit> struct OutlineVisitor {
+  const BoxTree<Vec2>& top;
+  const vector<Ref<const SimplexTree<Vec2,1>>>& trees;
+  RawArray<const Box<Vec2>> boxes;
+  RawArray<const Vec2> X;
+  const Box<Vec2> box;
+  const Hit& hit;
+  bool done;
+
+  bool cull(const int n) const {
+    return done || !top.boxes[n].lazy_intersects(box);
+  }
+
+  void leaf(const int n) {
+    for (const int k : top.prims(n)) {
+      if (done || !boxes[k].lazy_intersects(box))
+        continue;
+      // Walk the closed outline of X, skipping segments which miss the placed polygon's box
+      const auto& tree = *trees[k];
+      const int m = X.size();
+      for (int i=m-1,j=0;j<m;i=j++) {
+        if (!boxes[k].lazy_intersects(bounding_box(X[i],X[j])))
+          continue;
+        const Vec2 dir = X[j]-X[i];
+        RayIntersection<Vec2> ray(X[i],dir);
+        ray.t_max = dir.magnitude();
+        if (tree.intersection(ray,1e-10)) {
+          done = hit(k);
+          break;
+        }
+      }
+    }
+  }
+};
+}
+
+// Call hit(k) for each placed polygon k whose outline X crosses, stopping once hit returns true
+template<class Hit> void PolygonOutlines::visit(RawArray<const Vec2> X, const Hit& hit) const {
+  if (!top || !X.size())
+    return;
+  OutlineVisitor<Hit> visitor = {*top,trees,boxes,X,bounding_box(X),hit,false};
+  single_traverse(*top,visitor);
+}
+
+Array<bool> PolygonOutlines::intersect(RawArray<const Vec2> poly, RawArray<const Frame<Vec2>> frames) {
+  update_top();
+  Array<bool> result(frames.size());
+  parallel_for(frames.size(),[&](const int f) {
+    const auto X = transformed(frames[f],poly);
+    visit(X,[&](const int k) { return result[f] = true; });
+  },1);
+  return result;
+}
+
+Array<int> PolygonOutlines::intersecting(RawArray<const Vec2> poly, const Frame<Vec2>& frame) {
+  update_top();
+  Array<int> hits;
+  visit(transformed(frame,poly),[&](const int k) { hits.append(k); return false; });
+  sort(hits);
+  return hits;
+}
+
+}
+using namespace geode;
+
+void wrap_polygon_outlines() {
+  typedef PolygonOutlines Self;
+  Class<Self>("PolygonOutlines")
+    .GEODE_INIT()
+    .GEODE_METHOD(size)
+    .GEODE_METHOD(add)
+    .GEODE_METHOD(extend)
+    .GEODE_METHOD(intersect)
+    .GEODE_METHOD(intersecting)
+    ;
+}
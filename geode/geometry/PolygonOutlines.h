@@ -0,0 +1,53 @@
+// Batched polygon outline intersection against a set of placed polygons
+#pragma once
+
+// PolygonOutlines holds polygons placed one at a time, such as the parts of a nesting layout, with a cached
+// SimplexTree per polygon and a BoxTree over their bounding boxes.  A query tests one polygon under many candidate
+// frames at once, in parallel across frames, with the same semantics as polygon_outlines_intersect: only crossing
+// outlines count, so a polygon completely inside another does not intersect it.
+
+#include <geode/array/Array.h>
+#include <geode/geometry/Box.h>
+#include <geode/geometry/forward.h>
+#include <geode/python/Object.h>
+#include <geode/python/Ptr.h>
+#include <geode/python/Ref.h>
+#include <geode/vector/Frame.h>
+#include <vector>
+namespace geode {
+
+class PolygonOutlines : public Object {
+public:
+  GEODE_DECLARE_TYPE(GEODE_CORE_EXPORT)
+  typedef Object Base;
+
+private:
+  std::vector<Ref<const SimplexTree<Vec2,1>>> trees;
+  Array<Box<Vec2>> boxes;
+  Ptr<const BoxTree<Vec2>> top; // Over boxes, rebuilt lazily after add
+
+protected:
+  GEODE_CORE_EXPORT PolygonOutlines();
+public:
+  ~PolygonOutlines();
+
+  int size() const { return int(trees.size()); }
+
+  // Place a closed polygon, returning its id
+  GEODE_CORE_EXPORT int add(RawArray<const Vec2> poly);
+
+  // Place several closed polygons at once, building their trees in parallel
+  GEODE_CORE_EXPORT void extend(Nested<const Vec2> polys);
+
+  // For each frame f, does the outline of f*poly cross the outline of any placed polygon?
+  GEODE_CORE_EXPORT Array<bool> intersect(RawArray<const Vec2> poly, RawArray<const Frame<Vec2>> frames);
+
+  // The placed polygons whose outlines f*poly crosses
+  GEODE_CORE_EXPORT Array<int> intersecting(RawArray<const Vec2> poly, const Frame<Vec2>& frame);
+
+private:
+  void update_top();
+  template<class Hit> void visit(RawArray<const Vec2> X, const Hit& hit) const;
+};
+
+}
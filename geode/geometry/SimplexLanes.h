@@ -0,0 +1,173 @@
+//#####################################################################
+// Class SimplexLanes
+//#####################################################################
+//
+// SimplexLanes holds w segments or triangles in structure-of-arrays form,
+// along with the per simplex terms of their closest point computations, and
+// computes squared distances from a point to all of them at once.  The
+// kernels evaluate every case of the scalar closest_point routines and pick
+// the answer with selects instead of branches, so their fixed width loops
+// compile to SIMD instructions.  Squared distances agree with closest_point
+// up to rounding, not bit for bit, so callers use them to choose the closest
+// simplex and then call closest_point once for the closest point and weights.
+//
+// Lanes are meant to be built once and reused across queries, as
+// SimplexTree does for each leaf; filling them costs more than one scalar
+// closest_point.  Other simplex types fall back to closest_point in each
+// lane, and batched is false so that callers can skip lanes entirely.
+//
+//#####################################################################
+#pragma once
+
+#include <geode/geometry/Segment.h>
+#include <geode/geometry/Triangle2d.h>
+#include <geode/geometry/Triangle3d.h>
+#include <geode/math/min.h>
+namespace geode {
+
+// Scalar fallback
+template<class Simplex,int w_> struct SimplexLanes {
+  static const bool batched = false;
+  static const int w = w_;
+  Simplex simplices[w];
+
+  void set(const int l, const Simplex& s) {
+    simplices[l] = s;
+  }
+
+  template<class TV> void sqr_distances(const TV& p, typename TV::Scalar sqr_distances[w]) const {
+    for (int l=0;l<w;l++)
+      sqr_distances[l] = sqr_magnitude(p-simplices[l].closest_point(p).x);
+  }
+};
+
+template<class T,int d,int w_> struct SimplexLanes<Segment<Vector<T,d>>,w_> {
+  typedef Vector<T,d> TV;
+  static const bool batched = true;
+  static const int w = w_;
+  T x0[d][w], v[d][w];
+  T inv_vv[w]; // Zero for degenerate segments, which reduce to x0
+
+  void set(const int l, const Segment<TV>& s) {
+    const TV v = s.x1-s.x0;
+    for (int a=0;a<d;a++) {
+      x0[a][l] = s.x0[a];
+      this->v[a][l] = v[a];
+    }
+    const T vv = sqr_magnitude(v);
+    inv_vv[l] = vv>0 ? 1/vv : 0;
+  }
+
+  // As in segment_point_sqr_distance
+  void sqr_distances(const TV& p, T sqr_distances[w]) const {
+    T u[d][w], uv[w], t[w];
+    for (int l=0;l<w;l++)
+      uv[l] = sqr_distances[l] = 0;
+    for (int a=0;a<d;a++)
+      for (int l=0;l<w;l++) {
+        u[a][l] = p[a]-x0[a][l];
+        uv[l] += u[a][l]*v[a][l];
+      }
+    for (int l=0;l<w;l++)
+      t[l] = min(max(uv[l]*inv_vv[l],T(0)),T(1));
+    for (int a=0;a<d;a++)
+      for (int l=0;l<w;l++) {
+        const T e = u[a][l]-t[l]*v[a][l];
+        sqr_distances[l] += e*e;
+      }
+  }
+};
+
+template<class T,int w_> struct SimplexLanes<Triangle<Vector<T,3>>,w_> {
+  typedef Vector<T,3> TV;
+  static const bool batched = true;
+  static const int w = w_;
+  T x0[3][w], e0[3][w], e1[3][w]; // x0, x1-x0, x2-x0
+  T d00[w], d01[w], d11[w]; // Gram matrix of e0,e1
+  T inv_denom[w]; // Inverse Gram determinant, or zero for degenerate triangles
+  T inv_d00[w], inv_d11[w], inv_d22[w]; // Inverse squared edge lengths, or zero for degenerate edges
+
+  void set(const int l, const Triangle<TV>& s) {
+    const TV e0 = s.x1-s.x0,
+             e1 = s.x2-s.x0;
+    for (int a=0;a<3;a++) {
+      x0[a][l] = s.x0[a];
+      this->e0[a][l] = e0[a];
+      this->e1[a][l] = e1[a];
+    }
+    d00[l] = sqr_magnitude(e0);
+    d01[l] = dot(e0,e1);
+    d11[l] = sqr_magnitude(e1);
+    const T denom = d00[l]*d11[l]-sqr(d01[l]),
+            d22 = sqr_magnitude(e1-e0);
+    inv_denom[l] = denom>0 ? 1/denom : 0;
+    inv_d00[l] = d00[l]>0 ? 1/d00[l] : 0;
+    inv_d11[l] = d11[l]>0 ? 1/d11[l] : 0;
+    inv_d22[l] = d22>0 ? 1/d22 : 0;
+  }
+
+  // The distance to the plane if the projection of p lies inside the triangle, otherwise the distance to the closest
+  // edge.  Every candidate is a point of the triangle, so taking the minimum of all of them is safe for nearly
+  // degenerate triangles, whose barycentric coordinates can be garbage.
+  void sqr_distances(const TV& p, T sqr_distances[w]) const {
+    T v[3][w], d20[w], d21[w];
+    for (int l=0;l<w;l++)
+      d20[l] = d21[l] = 0;
+    for (int a=0;a<3;a++)
+      for (int l=0;l<w;l++) {
+        v[a][l] = p[a]-x0[a][l];
+        d20[l] += v[a][l]*e0[a][l];
+        d21[l] += v[a][l]*e1[a][l];
+      }
+    T b1[w], b2[w], t0[w], t1[w], t2[w];
+    bool inside[w];
+    for (int l=0;l<w;l++) {
+      b1[l] = (d11[l]*d20[l]-d01[l]*d21[l])*inv_denom[l];
+      b2[l] = (d00[l]*d21[l]-d01[l]*d20[l])*inv_denom[l];
+      inside[l] = inv_denom[l]>0 && b1[l]>=0 && b2[l]>=0 && b1[l]+b2[l]<=1;
+      // Clamped parameters along x0-x1, x0-x2, and x1-x2
+      t0[l] = min(max(d20[l]*inv_d00[l],T(0)),T(1));
+      t1[l] = min(max(d21[l]*inv_d11[l],T(0)),T(1));
+      t2[l] = min(max((d21[l]-d20[l]-d01[l]+d00[l])*inv_d22[l],T(0)),T(1));
+    }
+    T plane[w], s0[w], s1[w], s2[w];
+    for (int l=0;l<w;l++)
+      plane[l] = s0[l] = s1[l] = s2[l] = 0;
+    for (int a=0;a<3;a++)
+      for (int l=0;l<w;l++) {
+        const T q = v[a][l], u0 = e0[a][l], u1 = e1[a][l],
+                r = q-b1[l]*u0-b2[l]*u1,
+                r0 = q-t0[l]*u0,
+                r1 = q-t1[l]*u1,
+                r2 = q-u0-t2[l]*(u1-u0);
+        plane[l] += r*r;
+        s0[l] += r0*r0;
+        s1[l] += r1*r1;
+        s2[l] += r2*r2;
+      }
+    for (int l=0;l<w;l++)
+      sqr_distances[l] = min(inside[l] ? plane[l] : T(inf),s0[l],s1[l],s2[l]);
+  }
+};
+
+// The closest of n simplices packed into lanes[0], lanes[1], ..., if it is closer than sqrt(sqr_distance), in which
+// case sqr_distance is lowered to its squared distance.  Otherwise -1.  Ties go to the first, as with a scalar loop.
+template<class Lanes,class TV> static inline int
+closest_lane(const Lanes* lanes, const int n, const TV& p, typename TV::Scalar& sqr_distance) {
+  typedef typename TV::Scalar T;
+  const int w = Lanes::w;
+  int closest = -1;
+  for (int i=0;i<n;i+=w) {
+    T sqr_distances[w];
+    lanes[i/w].sqr_distances(p,sqr_distances);
+    const int m = min(w,n-i);
+    for (int l=0;l<m;l++)
+      if (sqr_distance>sqr_distances[l]) {
+        sqr_distance = sqr_distances[l];
+        closest = i+l;
+      }
+  }
+  return closest;
+}
+
+}
@@ -5,12 +5,21 @@
 #include <geode/geometry/FastRay.h>
 #include <geode/geometry/Sphere.h>
 #include <geode/geometry/Segment.h>
+#include <geode/geometry/spatial_keys.h>
 #include <geode/geometry/traverse.h>
 #include <geode/geometry/Triangle2d.h>
 #include <geode/geometry/Triangle3d.h>
+#include <geode/geometry/WideBoxTree.h>
+#include <geode/math/integer_log.h>
+#include <geode/math/popcount.h>
 #include <geode/array/IndirectArray.h>
 #include <geode/python/Class.h>
 #include <geode/random/Random.h>
+#include <geode/utility/const_cast.h>
+#include <geode/utility/metrics.h>
+#include <geode/utility/openmp.h>
+#include <geode/utility/parallel.h>
+#include <algorithm>
 
 // Windows silliness
 #undef small
@@ -23,6 +32,14 @@ using std::endl;
 
 template<class TV,int d_> const int SimplexTree<TV,d_>::d;
 
+// Query counts for monitoring, shared by all dimensions
+static Counter& tree_queries(const char* query) {
+  return metrics_counter("geode_simplex_tree_queries_total","SimplexTree queries",{{"query",query}});
+}
+static Counter& ray_queries = tree_queries("ray");
+static Counter& closest_point_queries = tree_queries("closest_point");
+static Counter& inside_queries = tree_queries("inside");
+
 template<class Mesh,class TV> static Array<Box<TV>> boxes(const Mesh& mesh, Array<const TV> X) {
   GEODE_ASSERT(mesh.nodes()<=X.size());
   Array<Box<TV>> boxes(mesh.elements.size(),uninit);
@@ -31,25 +48,67 @@ template<class Mesh,class TV> static Array<Box<TV>> boxes(const Mesh& mesh, Arra
   return boxes;
 }
 
-template<class TV,int d> SimplexTree<TV,d>::SimplexTree(const Mesh& mesh, Array<const TV> X, int leaf_size)
-  : Base(RawArray<const Box<TV>>(geode::boxes(mesh,X)),leaf_size), mesh(ref(mesh)), X(X), simplices(mesh.elements.size(),uninit) {
+template<class TV,int d> SimplexTree<TV,d>::SimplexTree(const Mesh& mesh, Array<const TV> X, int leaf_size, bool sah)
+  : Base(RawArray<const Box<TV>>(geode::boxes(mesh,X)),leaf_size,sah), mesh(ref(mesh)), X(X), simplices(mesh.elements.size(),uninit) {
   for (int t=0;t<mesh.elements.size();t++)
     simplices[t] = Simplex(X.subset(mesh.elements[t]));
+  init_lanes();
+  update_lanes();
 }
 
 template<class TV,int d> SimplexTree<TV,d>::SimplexTree(const SimplexTree& other, Array<const TV> X)
   : Base(other), mesh(other.mesh), X(X), simplices(mesh->elements.size(),uninit) {
   GEODE_ASSERT(mesh->nodes()<=X.size());
+  init_lanes();
   update();
 }
 
+template<class TV,int d> SimplexTree<TV,d>::SimplexTree(const Mesh& mesh, Array<const TV> X, const BoxTree<TV>& tree,
+                                                         Array<Simplex> simplices)
+  : Base(tree), mesh(ref(mesh)), X(X), simplices(simplices) {
+  GEODE_ASSERT(   mesh.nodes()<=X.size() && tree.p.size()==mesh.elements.size()
+               && simplices.size()==mesh.elements.size());
+  init_lanes();
+  update_lanes();
+}
+
 template<class TV,int d> SimplexTree<TV,d>::~SimplexTree() {}
 
+template<class TV,int d> void SimplexTree<TV,d>::init_lanes() {
+  if (!Lanes::batched)
+    return;
+  const int w = Lanes::w;
+  Array<int> offsets(leaves.size()+1,uninit);
+  offsets[0] = 0;
+  for (const int n : leaves)
+    offsets[n-leaves.lo+1] = offsets[n-leaves.lo]+(prims(n).size()+w-1)/w;
+  const_cast_(lane_offsets) = offsets;
+  const_cast_(lanes) = Array<Lanes>(offsets.back(),uninit);
+}
+
+template<class TV,int d> void SimplexTree<TV,d>::update_lanes() {
+  if (!Lanes::batched)
+    return;
+  const int w = Lanes::w;
+  #pragma omp parallel for
+  for (int n=leaves.lo;n<leaves.hi;n++) {
+    // Pad the last group by repeating its first simplex
+    const auto prims = this->prims(n);
+    Lanes* group = &lanes[lane_offsets[n-leaves.lo]];
+    for (int i=0;i<prims.size();i+=w,group++)
+      for (int l=0;l<w;l++)
+        group->set(l,simplices[prims[i+l<prims.size() ? i+l : i]]);
+  }
+}
+
 template<class TV,int d> void SimplexTree<TV,d>::update() {
   RawArray<const Vector<int,d+1>> elements = mesh->elements;
+  #pragma omp parallel for
   for (int t=0;t<elements.size();t++)
     simplices[t] = Simplex(X.subset(elements[t]));
-  for (const int n : leaves) {
+  update_lanes();
+  #pragma omp parallel for
+  for (int n=leaves.lo;n<leaves.hi;n++) {
     Box<TV> box;
     for (const int s : prims(n))
       box.enlarge(geode::bounding_box(X.subset(elements[s])));
@@ -58,6 +117,22 @@ template<class TV,int d> void SimplexTree<TV,d>::update() {
   update_nonleaf_boxes();
 }
 
+template<class TV,int d> void SimplexTree<TV,d>::update_swept(RawArray<const TV> X_new, const T half_thickness) {
+  GEODE_ASSERT(X_new.size()==X.size());
+  RawArray<const Vector<int,d+1>> elements = mesh->elements;
+  #pragma omp parallel for
+  for (int n=leaves.lo;n<leaves.hi;n++) {
+    Box<TV> box;
+    for (const int s : prims(n))
+      for (const int i : elements[s]) {
+        box.enlarge(X[i]);
+        box.enlarge(X_new[i]);
+      }
+    boxes[n] = box.thickened(half_thickness);
+  }
+  update_nonleaf_boxes();
+}
+
 namespace {
 template<class T> struct PlaneVisitor {
   const SimplexTree<Vector<T,3>,2>& self;
@@ -90,16 +165,17 @@ template<> void SimplexTree<Vector<real,3>,2>::intersections(const Plane<real>&
   single_traverse(*this,PlaneVisitor<real>(*this,plane,results));
 }
 
-template<int signs,class TV,int d> static void intersection_helper(const SimplexTree<TV,d>& self, RayIntersection<TV>& ray, const typename TV::Scalar half_thickness) {
+// Trace a ray through the subtree rooted at start
+template<int signs,class TV,int d> static void intersection_helper(const SimplexTree<TV,d>& self, RayIntersection<TV>& ray, const typename TV::Scalar half_thickness, const int start=0) {
   typedef typename TV::Scalar T;
   FastRay<TV,signs> fast(ray);
   // If we don't intersect the root box, there's nothing to do
-  const Box<T> root = fast.range(self.boxes[0],half_thickness);
+  const Box<T> root = fast.range(self.boxes[start],half_thickness);
   if (root.min>root.max || (root.max) < 0 || root.min > fast.t_max)
     return;
   const int internal = self.leaves.lo;
   RawStack<Tuple<int,T>> stack(GEODE_RAW_ALLOCA(self.depth,Tuple<int,T>)); // Each entry is (node,t_min)
-  stack.push(tuple(0,root.min));
+  stack.push(tuple(start,root.min));
   while (stack.size()) {
     const auto node_tmin = stack.pop();
     if (node_tmin.y>fast.t_max) // Check t_min again since fast.t_max may have changed
@@ -107,8 +183,8 @@ template<int signs,class TV,int d> static void intersection_helper(const Simplex
     const int node = node_tmin.x;
     if (node < internal) {
       // Sort children by t_min
-      int child0 = 2*node+1,
-          child1 = 2*node+2;
+      int child0 = self.child(node,0),
+          child1 = self.child(node,1);
       auto range0 = fast.range(self.boxes[child0],half_thickness),
            range1 = fast.range(self.boxes[child1],half_thickness);
       if (range0.min>range1.min) {
@@ -157,7 +233,155 @@ template<> void intersection_dispatch(const SimplexTree<Vector<real,3>,2>& self,
   }
 }
 
+// Rays are traced in packets of up to packet_size rays sharing an octant.  The packet walks the tree with one stack,
+// visiting a node if any of its rays hits the node's box.  Rays are stored in structure-of-arrays form so that the
+// slab tests for a whole packet vectorize.  Once only a quarter of a packet's rays are left in a subtree, they finish
+// the subtree one at a time.
+static const int packet_size = 8;
+
+template<int signs,class TV,int d> static void packet_intersection_helper(const SimplexTree<TV,d>& self, RawArray<RayIntersection<TV>> rays, RawArray<const int> packet, const typename TV::Scalar half_thickness) {
+  typedef typename TV::Scalar T;
+  const int m = TV::m, n = packet.size();
+  assert(n <= packet_size);
+  T start[m][packet_size], inv_dx[m][packet_size], t_max[packet_size];
+  for (int l=0;l<packet_size;l++) {
+    const auto& ray = rays[packet[min(l,n-1)]];
+    for (int a=0;a<m;a++) {
+      start[a][l] = ray.start[a];
+      inv_dx[a][l] = 1/ray.direction[a];
+    }
+    t_max[l] = ray.t_max;
+  }
+
+  // Mask of rays in the packet which hit a box, and the smallest entry parameter among them
+  const auto hits = [&](const Box<TV>& box, const uint32_t mask, T& t_first) {
+    const TV bounds[2] = {box.min-half_thickness,box.max+half_thickness};
+    T lo[packet_size], hi[packet_size];
+    for (int l=0;l<packet_size;l++) {
+      lo[l] = inv_dx[0][l]*(bounds[  (signs&1)!=0][0]-start[0][l]);
+      hi[l] = inv_dx[0][l]*(bounds[1-((signs&1)!=0)][0]-start[0][l]);
+    }
+    for (int a=1;a<m;a++) {
+      const bool s = (signs&1<<a)!=0;
+      for (int l=0;l<packet_size;l++) {
+        lo[l] = max(lo[l],inv_dx[a][l]*(bounds[  s][a]-start[a][l]));
+        hi[l] = min(hi[l],inv_dx[a][l]*(bounds[1-s][a]-start[a][l]));
+      }
+    }
+    uint32_t r = 0;
+    t_first = inf;
+    for (int l=0;l<packet_size;l++)
+      if (mask&1<<l && lo[l]<=hi[l] && hi[l]>=0 && lo[l]<=t_max[l]) {
+        r |= 1<<l;
+        t_first = min(t_first,lo[l]);
+      }
+    return r;
+  };
+
+  const int internal = self.leaves.lo;
+  RawStack<Tuple<int,uint32_t,T>> stack(GEODE_RAW_ALLOCA(self.depth,Tuple<int,uint32_t,T>)); // Each entry is (node,rays,t_min)
+  T t_root;
+  const uint32_t root = hits(self.boxes[0],(1<<n)-1,t_root);
+  if (root)
+    stack.push(tuple(0,root,t_root));
+  while (stack.size()) {
+    const auto entry = stack.pop();
+    const int node = entry.x;
+    uint32_t mask = entry.y;
+    // Drop rays which have since found closer hits
+    for (uint32_t r=mask;r;r&=r-1) {
+      const int l = integer_log_exact(min_bit(r));
+      if (entry.z>t_max[l])
+        mask &= ~(1<<l);
+    }
+    if (!mask)
+      continue;
+    if (popcount(mask) <= packet_size/4) {
+      // The packet has diverged, so finish the subtree with single rays
+      for (uint32_t r=mask;r;r&=r-1) {
+        const int l = integer_log_exact(min_bit(r));
+        intersection_helper<signs>(self,rays[packet[l]],half_thickness,node);
+        t_max[l] = rays[packet[l]].t_max;
+      }
+    } else if (node < internal) {
+      int child0 = self.child(node,0),
+          child1 = self.child(node,1);
+      T t0, t1;
+      uint32_t mask0 = hits(self.boxes[child0],mask,t0),
+               mask1 = hits(self.boxes[child1],mask,t1);
+      if (t0>t1) {
+        swap(child0,child1);
+        swap(mask0,mask1);
+        swap(t0,t1);
+      }
+      // Push child with larger t_min onto the stack first, so that we check smaller t_min first
+      if (mask1)
+        stack.push(tuple(child1,mask1,t1));
+      if (mask0)
+        stack.push(tuple(child0,mask0,t0));
+    } else {
+      // Test all simplices in this leaf against each remaining ray
+      for (const int t : self.prims(node))
+        for (uint32_t r=mask;r;r&=r-1) {
+          const int l = integer_log_exact(min_bit(r));
+          auto& ray = rays[packet[l]];
+          if (self.simplices[t].intersection(ray,half_thickness)) {
+            t_max[l] = ray.t_max;
+            ray.aggregate_id = t;
+          }
+        }
+    }
+  }
+}
+
+template<class TV,int d> static void packet_intersection_dispatch(const SimplexTree<TV,d>& self, RawArray<RayIntersection<TV>> rays, RawArray<const int> packet, const typename TV::Scalar half_thickness, const int signs) {
+  GEODE_NOT_IMPLEMENTED();
+}
+
+template<> void packet_intersection_dispatch(const SimplexTree<Vector<real,2>,1>& self, RawArray<RayIntersection<Vector<real,2>>> rays, RawArray<const int> packet, const real half_thickness, const int signs) {
+  switch (signs) {
+    case 0: packet_intersection_helper<0>(self,rays,packet,half_thickness); break;
+    case 1: packet_intersection_helper<1>(self,rays,packet,half_thickness); break;
+    case 2: packet_intersection_helper<2>(self,rays,packet,half_thickness); break;
+    case 3: packet_intersection_helper<3>(self,rays,packet,half_thickness); break;
+  }
+}
+
+template<> void packet_intersection_dispatch(const SimplexTree<Vector<real,3>,2>& self, RawArray<RayIntersection<Vector<real,3>>> rays, RawArray<const int> packet, const real half_thickness, const int signs) {
+  switch (signs) {
+    case 0: packet_intersection_helper<0>(self,rays,packet,half_thickness); break;
+    case 1: packet_intersection_helper<1>(self,rays,packet,half_thickness); break;
+    case 2: packet_intersection_helper<2>(self,rays,packet,half_thickness); break;
+    case 3: packet_intersection_helper<3>(self,rays,packet,half_thickness); break;
+    case 4: packet_intersection_helper<4>(self,rays,packet,half_thickness); break;
+    case 5: packet_intersection_helper<5>(self,rays,packet,half_thickness); break;
+    case 6: packet_intersection_helper<6>(self,rays,packet,half_thickness); break;
+    case 7: packet_intersection_helper<7>(self,rays,packet,half_thickness); break;
+  }
+}
+
+template<class TV,int d> static void wide_intersection_helper(const SimplexTree<TV,d>& self, RayIntersection<TV>& ray, const typename TV::Scalar half_thickness, const WideBoxTree<TV>& wide) {
+  wide_ray_traverse(wide,ray,half_thickness,[&](const int leaf) {
+    for (const int t : self.prims(leaf))
+      if (self.simplices[t].intersection(ray,half_thickness))
+        ray.aggregate_id = t;
+  });
+}
+
+template<class TV,int d> static void wide_intersection_dispatch(const SimplexTree<TV,d>& self, RayIntersection<TV>& ray, const typename TV::Scalar half_thickness, const WideBoxTree<TV>& wide) {
+  GEODE_NOT_IMPLEMENTED();
+}
+
+template<> void wide_intersection_dispatch(const SimplexTree<Vector<real,2>,1>& self, RayIntersection<Vector<real,2>>& ray, const real half_thickness, const WideBoxTree<Vector<real,2>>& wide) {
+  wide_intersection_helper(self,ray,half_thickness,wide);
+}
+
+template<> void wide_intersection_dispatch(const SimplexTree<Vector<real,3>,2>& self, RayIntersection<Vector<real,3>>& ray, const real half_thickness, const WideBoxTree<Vector<real,3>>& wide) {
+  wide_intersection_helper(self,ray,half_thickness,wide);
+}
+
 template<class TV,int d> bool SimplexTree<TV,d>::intersection(RayIntersection<TV>& ray, const typename TV::Scalar half_thickness) const {
+  ray_queries.add();
   if (boxes.size() == 0)
     return false; // No intersections possible for empty trees
   const int aggregate_save = ray.aggregate_id;
@@ -170,6 +394,66 @@ template<class TV,int d> bool SimplexTree<TV,d>::intersection(RayIntersection<TV
   return true;
 }
 
+template<class TV,int d> Array<bool> SimplexTree<TV,d>::intersection(RawArray<RayIntersection<TV>> rays, const T half_thickness) const {
+  const int n = rays.size();
+  ray_queries.add(n);
+  Array<bool> hit(n);
+  if (!n || boxes.size()==0)
+    return hit;
+
+  // Group rays by octant, preserving their order within each octant
+  const int octants = 1<<TV::m;
+  Array<int> signs(n,uninit);
+  Array<int> offsets(octants+1);
+  for (int i=0;i<n;i++) {
+    signs[i] = fast_ray_signs(rays[i]);
+    offsets[signs[i]+1]++;
+  }
+  for (int o=0;o<octants;o++)
+    offsets[o+1] += offsets[o];
+  Array<int> order(n,uninit);
+  {
+    auto next = offsets.slice(0,octants).copy();
+    for (int i=0;i<n;i++)
+      order[next[signs[i]]++] = i;
+  }
+
+  // Split each octant into packets
+  Array<Vector<int,2>> packets;
+  for (int o=0;o<octants;o++)
+    for (int lo=offsets[o];lo<offsets[o+1];lo+=packet_size)
+      packets.append(vec(lo,min(lo+packet_size,offsets[o+1])));
+
+  Array<int> aggregate_save(n,uninit);
+  for (int i=0;i<n;i++) {
+    aggregate_save[i] = rays[i].aggregate_id;
+    rays[i].aggregate_id = -1;
+  }
+  #pragma omp parallel for schedule(dynamic,16)
+  for (int p=0;p<packets.size();p++) {
+    const auto packet = order.slice(packets[p].x,packets[p].y);
+    packet_intersection_dispatch(*this,rays,packet,half_thickness,signs[packet[0]]);
+  }
+  for (int i=0;i<n;i++) {
+    hit[i] = rays[i].aggregate_id>=0;
+    if (!hit[i])
+      rays[i].aggregate_id = aggregate_save[i];
+  }
+  return hit;
+}
+
+template<class TV,int d> bool SimplexTree<TV,d>::intersection(RayIntersection<TV>& ray, const T half_thickness, const WideBoxTree<TV>& wide) const {
+  GEODE_ASSERT(&*wide.tree==this);
+  const int aggregate_save = ray.aggregate_id;
+  ray.aggregate_id = -1;
+  wide_intersection_dispatch(*this,ray,half_thickness,wide);
+  if (ray.aggregate_id<0) {
+    ray.aggregate_id = aggregate_save;
+    return false;
+  }
+  return true;
+}
+
 namespace {
 template<class TV,int d> struct SphereVisitor {
   const SimplexTree<TV,d>& self;
@@ -197,6 +481,17 @@ intersection(const Sphere<TV>& sphere, Array<int>& hits) const {
   single_traverse(*this,SphereVisitor<TV,d>(*this,sphere,hits));
 }
 
+template<class TV,int d> void SimplexTree<TV,d>::
+intersection(const Sphere<TV>& sphere, Array<int>& hits, const WideBoxTree<TV>& wide) const {
+  GEODE_ASSERT(&*wide.tree==this);
+  hits.clear();
+  wide_intersection_traverse(wide,sphere,[&](const int leaf) {
+    for (const int t : prims(leaf))
+      if (simplices[t].distance(sphere.center)<=sphere.radius)
+        hits.append(t);
+  });
+}
+
 namespace {
 template<class TV,int signs> struct MultiRayVisitor {
   typedef typename TV::Scalar T;
@@ -256,6 +551,111 @@ template<class TV,int d> Array<RayIntersection<TV>> SimplexTree<TV,d>::intersect
 template<> Array<RayIntersection<Vector<real,2>>> SimplexTree<Vector<real,2>,2>::intersections(const RayIntersection<Vector<real,2>>& ray, const real half_thickness) const { GEODE_NOT_IMPLEMENTED(); }
 template<> Array<RayIntersection<Vector<real,3>>> SimplexTree<Vector<real,3>,1>::intersections(const RayIntersection<Vector<real,3>>& ray, const real half_thickness) const { GEODE_NOT_IMPLEMENTED(); }
 
+// Visit the simplices hit by a ray until visit returns false.  Unlike intersection_helper the ray is never shortened,
+// so there is no need to visit nodes in order.
+template<int signs,class TV,int d,class Visit> static void hits_helper(const SimplexTree<TV,d>& self, const RayIntersection<TV>& ray, const typename TV::Scalar half_thickness, const Visit& visit) {
+  const FastRay<TV,signs> fast(ray);
+  if (!fast.intersects(self.boxes[0],half_thickness))
+    return;
+  const int internal = self.leaves.lo;
+  RawStack<int> stack(GEODE_RAW_ALLOCA(self.depth,int));
+  stack.push(0);
+  while (stack.size()) {
+    const int node = stack.pop();
+    if (node < internal) {
+      for (const int i : range(2)) {
+        const int child = self.child(node,i);
+        if (fast.intersects(self.boxes[child],half_thickness))
+          stack.push(child);
+      }
+    } else
+      for (const int t : self.prims(node)) {
+        RayIntersection<TV> copy = ray;
+        if (self.simplices[t].intersection(copy,half_thickness) && !visit(t))
+          return;
+      }
+  }
+}
+
+template<class TV,int d,class Visit> static void hits_dispatch(const SimplexTree<TV,d>& self, const RayIntersection<TV>& ray, const typename TV::Scalar half_thickness, const Visit& visit) {
+  GEODE_NOT_IMPLEMENTED();
+}
+
+template<class Visit> static void hits_dispatch(const SimplexTree<Vector<real,2>,1>& self, const RayIntersection<Vector<real,2>>& ray, const real half_thickness, const Visit& visit) {
+  switch (fast_ray_signs(ray)) {
+    case 0: hits_helper<0>(self,ray,half_thickness,visit); break;
+    case 1: hits_helper<1>(self,ray,half_thickness,visit); break;
+    case 2: hits_helper<2>(self,ray,half_thickness,visit); break;
+    case 3: hits_helper<3>(self,ray,half_thickness,visit); break;
+  }
+}
+
+template<class Visit> static void hits_dispatch(const SimplexTree<Vector<real,3>,2>& self, const RayIntersection<Vector<real,3>>& ray, const real half_thickness, const Visit& visit) {
+  switch (fast_ray_signs(ray)) {
+    case 0: hits_helper<0>(self,ray,half_thickness,visit); break;
+    case 1: hits_helper<1>(self,ray,half_thickness,visit); break;
+    case 2: hits_helper<2>(self,ray,half_thickness,visit); break;
+    case 3: hits_helper<3>(self,ray,half_thickness,visit); break;
+    case 4: hits_helper<4>(self,ray,half_thickness,visit); break;
+    case 5: hits_helper<5>(self,ray,half_thickness,visit); break;
+    case 6: hits_helper<6>(self,ray,half_thickness,visit); break;
+    case 7: hits_helper<7>(self,ray,half_thickness,visit); break;
+  }
+}
+
+// Trace rays given in structure of arrays form, calling query(i,ray) for each in parallel
+template<class TV,class Query> static void batch_rays(RawArray<const TV> starts, RawArray<const TV> directions, const typename TV::Scalar t_max, const Query& query) {
+  GEODE_ASSERT(starts.size()==directions.size());
+  ray_queries.add(starts.size());
+  parallel_for(starts.size(),[&](const int i) {
+    RayIntersection<TV> ray(starts[i],directions[i]);
+    ray.t_max = t_max;
+    query(i,ray);
+  },256);
+}
+
+template<class TV,int d> Tuple<Array<int>,Array<typename TV::Scalar>> SimplexTree<TV,d>::closest_hits(RawArray<const TV> starts, RawArray<const TV> directions, const T half_thickness, const T t_max) const {
+  GEODE_ASSERT(starts.size()==directions.size());
+  const int n = starts.size();
+  Array<RayIntersection<TV>> rays(n,uninit);
+  for (int i=0;i<n;i++) {
+    rays[i] = RayIntersection<TV>(starts[i],directions[i]);
+    rays[i].t_max = t_max;
+  }
+  intersection(rays,half_thickness);
+  Array<int> simplices(n,uninit);
+  Array<T> t(n,uninit);
+  for (int i=0;i<n;i++) {
+    simplices[i] = rays[i].aggregate_id;
+    t[i] = rays[i].t_max;
+  }
+  return tuple(simplices,t);
+}
+
+template<class TV,int d> Array<bool> SimplexTree<TV,d>::any_hits(RawArray<const TV> starts, RawArray<const TV> directions, const T half_thickness, const T t_max) const {
+  Array<bool> hit(starts.size());
+  batch_rays(starts,directions,t_max,[&](const int i, const RayIntersection<TV>& ray) {
+    hits_dispatch(*this,ray,half_thickness,[&](const int t) {
+      hit[i] = true;
+      return false;
+    });
+  });
+  return hit;
+}
+
+template<class TV,int d> Array<int> SimplexTree<TV,d>::count_hits(RawArray<const TV> starts, RawArray<const TV> directions, const T half_thickness, const T t_max) const {
+  Array<int> count(starts.size());
+  batch_rays(starts,directions,t_max,[&](const int i, const RayIntersection<TV>& ray) {
+    int hits = 0;
+    hits_dispatch(*this,ray,half_thickness,[&](const int t) {
+      hits++;
+      return true;
+    });
+    count[i] = hits;
+  });
+  return count;
+}
+
 // Random directions courtesy of numpy.random.randn.
 template<class T> static RawArray<const Vector<T,2>> directions_helper_2() {
   typedef Vector<T,2> TV;
@@ -289,6 +689,7 @@ template<class T> static inline bool inside_plane(const Triangle<Vector<T,2>>& s
 
 template<class TV,int d> bool SimplexTree<TV,d>::
 inside(TV point) const {
+  inside_queries.add();
   if (!boxes.size())
     return false;
   const T small = sqrt(numeric_limits<T>::epsilon());
@@ -321,37 +722,93 @@ inside_given_closest_point(TV point, int simplex, Weights weights) const {
 template<class TV,int d> static void closest_point_helper(const SimplexTree<TV,d>& self, TV point, int& triangle, typename TV::Scalar& sqr_distance, int node) {
   typedef typename TV::Scalar T;
   if (!self.is_leaf(node)) {
-    Vector<T,2> bounds(self.boxes[2*node+1].sqr_distance_bound(point),
-                       self.boxes[2*node+2].sqr_distance_bound(point));
+    const auto children = self.children(node);
+    Vector<T,2> bounds(self.boxes[children.x].sqr_distance_bound(point),
+                       self.boxes[children.y].sqr_distance_bound(point));
     int c = bounds.argmin();
     if (bounds[c]<sqr_distance)
-      closest_point_helper<TV,d>(self,point,triangle,sqr_distance,2*node+1+c);
+      closest_point_helper<TV,d>(self,point,triangle,sqr_distance,children[c]);
     if (bounds[1-c]<sqr_distance)
-      closest_point_helper<TV,d>(self,point,triangle,sqr_distance,2*node+2-c);
-  } else
-    for (int t : self.prims(node)) {
-      T sqr_d = sqr_magnitude(point-self.simplices[t].closest_point(point).x);
-      if (sqr_distance>sqr_d) {
-        sqr_distance = sqr_d;
-        triangle = t;
-      }
-    }
+      closest_point_helper<TV,d>(self,point,triangle,sqr_distance,children[1-c]);
+  } else {
+    const int t = self.closest_leaf_simplex(node,point,sqr_distance);
+    if (t >= 0)
+      triangle = t;
+  }
+}
+
+template<class TV,int d> static Tuple<TV,int,typename SimplexTree<TV,d>::Weights> closest_point_result(const SimplexTree<TV,d>& self, const TV point, const int simplex) {
+  if (simplex == -1) {
+    TV x;
+    x.fill(inf);
+    return tuple(x,-1,typename SimplexTree<TV,d>::Weights());
+  } else {
+    const auto r = self.simplices[simplex].closest_point(point);
+    return tuple(r.x,simplex,r.y);
+  }
 }
 
 template<class TV,int d> Tuple<TV,int,typename SimplexTree<TV,d>::Weights> SimplexTree<TV,d>::closest_point(const TV point, const T max_distance) const {
+  closest_point_queries.add();
   int simplex = -1;
   if (nodes()) {
     T sqr_distance = sqr(max_distance);
     closest_point_helper(*this,point,simplex,sqr_distance,0);
   }
-  if (simplex == -1) {
-    TV x;
-    x.fill(inf);
-    return tuple(x,-1,Weights());
-  } else {
-    const auto r = simplices[simplex].closest_point(point);
-    return tuple(r.x,simplex,r.y);
+  return closest_point_result(*this,point,simplex);
+}
+
+template<class TV,int d> Tuple<Array<TV>,Array<int>,Array<typename SimplexTree<TV,d>::Weights>> SimplexTree<TV,d>::closest_points(RawArray<const TV> points, const T max_distance) const {
+  const int n = points.size();
+  closest_point_queries.add(n);
+  Array<TV> X(n,uninit);
+  Array<int> simplex(n,uninit);
+  Array<Weights> weights(n,uninit);
+
+  // Sort queries by Morton code so that consecutive queries are close together
+  const auto order = morton_order(points);
+
+  // Each chunk of consecutive queries seeds its search with the previous query's simplex
+  const T sqr_max_distance = sqr(max_distance);
+  const int chunks = min(n,64*omp_get_max_threads());
+  #pragma omp parallel for schedule(dynamic,1)
+  for (int c=0;c<chunks;c++) {
+    int previous = -1;
+    for (const int k : partition_loop(n,chunks,c)) {
+      const int i = order[k];
+      const TV point = points[i];
+      int best = -1;
+      T sqr_distance = sqr_max_distance;
+      if (previous >= 0) {
+        const T sqr_d = sqr_magnitude(point-simplices[previous].closest_point(point).x);
+        if (sqr_d <= sqr_distance) {
+          best = previous;
+          sqr_distance = sqr_d;
+        }
+      }
+      if (nodes())
+        closest_point_helper(*this,point,best,sqr_distance,0);
+      const auto r = closest_point_result(*this,point,best);
+      X[i] = r.x;
+      simplex[i] = r.y;
+      weights[i] = r.z;
+      if (best >= 0)
+        previous = best;
+    }
   }
+  return tuple(X,simplex,weights);
+}
+
+template<class TV,int d> Tuple<TV,int,typename SimplexTree<TV,d>::Weights> SimplexTree<TV,d>::closest_point(const TV point, const T max_distance, const WideBoxTree<TV>& wide) const {
+  GEODE_ASSERT(&*wide.tree==this);
+  int simplex = -1;
+  T sqr_distance = sqr(max_distance);
+  wide_closest_traverse(wide,point,sqr_distance,[&](const int leaf, T& sqr_distance) {
+    const int t = closest_leaf_simplex(leaf,point,sqr_distance);
+    if (t >= 0)
+      simplex = t;
+  });
+  return closest_point_result(*this,point,simplex);
 }
 
 template<class TV,int d> typename SimplexTree<TV,d>::T SimplexTree<TV,d>::distance(const TV point, const T max_distance) const {
@@ -389,19 +846,66 @@ template<class T, int d> static int ray_traversal_test(const SimplexTree<Vector<
   return hits;
 }
 
+// Check that packets of rays hit the same simplices as single rays
+template<class T, int d> static int packet_ray_traversal_test(const SimplexTree<Vector<T,d>,d-1>& tree, const int rays, const T half_thickness) {
+  typedef Vector<T,d> TV;
+  const auto box = tree.bounding_box();
+  const auto random = new_<Random>(819371111);
+  Array<RayIntersection<TV>> packet;
+  for (int i=0;i<rays;i++) {
+    packet.append(RayIntersection<TV>(random->uniform(box),random->direction<TV>()));
+    packet.back().t_max = 2;
+  }
+  const auto single = packet.copy();
+  const auto hit = tree.intersection(packet,half_thickness);
+  int hits = 0;
+  for (int i=0;i<rays;i++) {
+    GEODE_ASSERT(hit[i]==tree.intersection(single[i],half_thickness));
+    GEODE_ASSERT(packet[i].t_max==single[i].t_max);
+    hits += hit[i];
+  }
+  return hits;
+}
+
+// Check that rays traced through a WideBoxTree hit the same simplices as the binary tree
+template<class T, int d> static int wide_ray_traversal_test(const SimplexTree<Vector<T,d>,d-1>& tree, const int rays, const T half_thickness) {
+  typedef Vector<T,d> TV;
+  const auto wide = new_<WideBoxTree<TV>>(tree);
+  const auto box = tree.bounding_box();
+  const auto random = new_<Random>(819371111);
+  int hits = 0;
+  for (int i=0;i<rays;i++) {
+    const TV start = random->uniform(box);
+    RayIntersection<TV> ray(start,random->direction<TV>());
+    ray.t_max = 2;
+    auto copy = ray;
+    const bool hit = tree.intersection(ray,half_thickness,wide);
+    GEODE_ASSERT(hit==tree.intersection(copy,half_thickness));
+    GEODE_ASSERT(ray.t_max==copy.t_max);
+    hits += hit;
+  }
+  return hits;
+}
+
 }
 using namespace geode;
 
 template<class TV,int d> static void wrap_helper() {
   typedef SimplexTree<TV,d> Self;
+  typedef Tuple<TV,int,typename Self::Weights>(Self::*ClosestPoint)(const TV,const typename TV::Scalar)const;
   static const string name = format("%sTree%dd",(d==1?"Segment":"Triangle"),TV::m);
   Class<Self>(name.c_str())
-    .GEODE_INIT(const typename Self::Mesh&,Array<const TV>,int)
+    .GEODE_INIT(const typename Self::Mesh&,Array<const TV>,int,bool)
     .GEODE_FIELD(mesh)
     .GEODE_FIELD(X)
     .GEODE_FIELD(d)
     .GEODE_METHOD(update)
-    .GEODE_METHOD(closest_point)
+    .GEODE_METHOD(update_swept)
+    .GEODE_OVERLOADED_METHOD(ClosestPoint,closest_point)
+    .GEODE_METHOD(closest_points)
+    .GEODE_METHOD(closest_hits)
+    .GEODE_METHOD(any_hits)
+    .GEODE_METHOD(count_hits)
     .GEODE_METHOD(distance)
     ;
 }
@@ -412,4 +916,6 @@ void wrap_simplex_tree() {
   wrap_helper<Vector<real,3>,1>();
   wrap_helper<Vector<real,3>,2>();
   GEODE_FUNCTION_2(ray_traversal_test,ray_traversal_test<real,3>)
+  GEODE_FUNCTION_2(wide_ray_traversal_test,wide_ray_traversal_test<real,3>)
+  GEODE_FUNCTION_2(packet_ray_traversal_test,packet_ray_traversal_test<real,3>)
 }
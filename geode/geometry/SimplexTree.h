@@ -5,6 +5,7 @@
 #include <geode/utility/config.h>
 #include <geode/geometry/forward.h>
 #include <geode/geometry/BoxTree.h>
+#include <geode/geometry/SimplexLanes.h>
 #include <geode/mesh/SegmentSoup.h>
 #include <geode/mesh/TriangleSoup.h>
 #include <geode/math/constants.h>
@@ -20,6 +21,7 @@ public:
   typedef typename mpl::if_c<d==1,SegmentSoup,TriangleSoup>::type Mesh;
   typedef typename mpl::if_c<d==1,Segment<TV>,Triangle<TV>>::type Simplex;
   typedef typename mpl::if_c<d==1,T,Vector<T,3>>::type Weights;
+  typedef SimplexLanes<Simplex,4> Lanes;
   using Base::leaves;using Base::prims;using Base::boxes;using Base::update_nonleaf_boxes;
   using Base::bounding_box;using Base::nodes;
 
@@ -27,14 +29,28 @@ public:
   const Array<const TV> X;
   const Array<Simplex> simplices;
 
+  // Copies of the simplices of each leaf packed into SIMD lanes in prims order, with leaf n starting at
+  // lanes[lane_offsets[n-leaves.lo]] and its last group padded.  Empty if Lanes::batched is false.
+  const Array<Lanes> lanes;
+  const Array<const int> lane_offsets;
+
 protected:
-  GEODE_CORE_EXPORT SimplexTree(const Mesh& mesh, Array<const TV> X, int leaf_size);
+  GEODE_CORE_EXPORT SimplexTree(const Mesh& mesh, Array<const TV> X, int leaf_size, bool sah=false);
   GEODE_CORE_EXPORT SimplexTree(const SimplexTree& other, Array<const TV> X); // Shares ownership for topology (mesh, tree structure, etc.) but not geometry (X,boxes,simplices)
+  GEODE_CORE_EXPORT SimplexTree(const Mesh& mesh, Array<const TV> X, const BoxTree<TV>& tree, Array<Simplex> simplices); // Adopts an already built tree and simplices, such as ones read by read_simplex_tree
 public:
   ~SimplexTree();
 
   GEODE_CORE_EXPORT void update(); // Call whenever X changes
+
+  // Refit the boxes in place to bound each simplex as it moves linearly from X to X_new, thickened by
+  // thickness_over_two, for continuous collision broad phases.  simplices are left at X, so the tree is only good for
+  // box traversals until the next update().
+  GEODE_CORE_EXPORT void update_swept(RawArray<const TV> X_new, const T thickness_over_two=0);
   GEODE_CORE_EXPORT bool intersection(RayIntersection<TV>& ray, const T thickness_over_two) const;
+  // Trace many rays at once, each as in intersection(ray,thickness_over_two), and return which rays hit.  Rays sharing an
+  // octant are traced in packets, so nearby rays with similar directions should be adjacent in rays.
+  GEODE_CORE_EXPORT Array<bool> intersection(RawArray<RayIntersection<TV>> rays, const T thickness_over_two) const;
   GEODE_CORE_EXPORT Array<RayIntersection<TV> > intersections(const RayIntersection<TV>& ray, const T thickness_over_two) const;
   GEODE_CORE_EXPORT void intersection(const Sphere<TV>& sphere, Array<int>& hits) const;
   GEODE_CORE_EXPORT void intersections(const Plane<T>& plane, Array<Segment<TV>>& result) const;
@@ -44,6 +60,45 @@ public:
 
   // Returns closest_point,simplex,weights.  If nothing is found, simplex = -1 and closet_point = inf.
   GEODE_CORE_EXPORT Tuple<TV,int,Weights> closest_point(const TV point, const T max_distance=inf) const;
+
+  // Closest points for many queries at once, as in closest_point(point,max_distance).  Queries are processed in
+  // parallel in Morton order, and each starts with the previous query's simplex as an upper bound.
+  GEODE_CORE_EXPORT Tuple<Array<TV>,Array<int>,Array<Weights>> closest_points(RawArray<const TV> points, const T max_distance=inf) const;
+
+  // Batched ray queries for rays given as separate start and direction arrays, traced in parallel.  closest_hits returns
+  // the first simplex and t hit by each ray (simplex -1 and t = t_max on a miss), any_hits stops at the first simplex
+  // found, and count_hits counts every simplex hit with t <= t_max.
+  GEODE_CORE_EXPORT Tuple<Array<int>,Array<T>> closest_hits(RawArray<const TV> starts, RawArray<const TV> directions, const T thickness_over_two, const T t_max=inf) const;
+  GEODE_CORE_EXPORT Array<bool> any_hits(RawArray<const TV> starts, RawArray<const TV> directions, const T thickness_over_two, const T t_max=inf) const;
+  GEODE_CORE_EXPORT Array<int> count_hits(RawArray<const TV> starts, RawArray<const TV> directions, const T thickness_over_two, const T t_max=inf) const;
+
+  // Versions of the above queries which traverse a WideBoxTree built from this tree.  Call wide.update() after update().
+  GEODE_CORE_EXPORT bool intersection(RayIntersection<TV>& ray, const T thickness_over_two, const WideBoxTree<TV>& wide) const;
+  GEODE_CORE_EXPORT void intersection(const Sphere<TV>& sphere, Array<int>& hits, const WideBoxTree<TV>& wide) const;
+  GEODE_CORE_EXPORT Tuple<TV,int,Weights> closest_point(const TV point, const T max_distance, const WideBoxTree<TV>& wide) const;
+
+  // The closest simplex in a leaf, if it is closer than sqrt(sqr_distance), in which case sqr_distance is lowered to its
+  // squared distance.  Otherwise -1.  Uses lanes if possible.
+  int closest_leaf_simplex(const int leaf, const TV& point, T& sqr_distance) const {
+    const auto prims = this->prims(leaf);
+    if (Lanes::batched) {
+      const int i = closest_lane(&lanes[lane_offsets[leaf-leaves.lo]],prims.size(),point,sqr_distance);
+      return i<0 ? -1 : prims[i];
+    }
+    int closest = -1;
+    for (const int t : prims) {
+      const T sqr_d = sqr_magnitude(point-simplices[t].closest_point(point).x);
+      if (sqr_distance>sqr_d) {
+        sqr_distance = sqr_d;
+        closest = t;
+      }
+    }
+    return closest;
+  }
+
+private:
+  void init_lanes();
+  void update_lanes();
 };
 
 }
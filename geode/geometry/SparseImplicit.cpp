@@ -0,0 +1,216 @@
+//#####################################################################
+// Class SparseImplicit
+//#####################################################################
+#include <geode/geometry/SparseImplicit.h>
+#include <geode/python/Class.h>
+#include <geode/utility/format.h>
+#include <geode/math/pow.h>
+#include <cmath>
+namespace geode {
+
+typedef real T;
+template<> GEODE_DEFINE_TYPE(SparseImplicit<Vector<T,2>>)
+template<> GEODE_DEFINE_TYPE(SparseImplicit<Vector<T,3>>)
+
+template<class TV> const int SparseImplicit<TV>::block;
+
+static const int nodes_per_axis = SparseImplicit<Vector<T,2>>::block+1;
+
+// Offset of a node within its block
+template<int d> static inline int node_offset(const Vector<int,d>& local) {
+  int offset = 0;
+  for (int a=0;a<d;a++)
+    offset = offset*nodes_per_axis+local[a];
+  return offset;
+}
+
+template<int d> static inline Vector<int,d> block_cells(const Box<Vector<T,d>>& box, const T dx, const int block) {
+  Vector<int,d> cells;
+  for (int a=0;a<d;a++)
+    cells[a] = block*max(1,int(std::ceil(box.sizes()[a]/(block*dx))));
+  return cells;
+}
+
+template<class TV> SparseImplicit<TV>::
+SparseImplicit(const Implicit<TV>& object, const T dx, const T band)
+  : object(ref(object)), dx(dx), band(band), box(object.bounding_box().thickened(band))
+  , cells(block_cells(box,dx,block))
+{
+  GEODE_ASSERT(dx>0 && band>=0);
+  const int nodes = pow<d>(nodes_per_axis);
+
+  // Evaluate phi at all block centers at once, and keep blocks which may come within band of the zero set
+  const IV counts = cells/block;
+  const int total = counts.product();
+  Array<IV> indices(total,uninit);
+  Array<TV> centers(total,uninit);
+  for (int b=0;b<total;b++) {
+    for (int a=d-1,r=b;a>=0;r/=counts[a--])
+      indices[b][a] = r%counts[a];
+    centers[b] = box.min+dx*block*(TV(indices[b])+(T).5);
+  }
+  Array<T> center_phi(total,uninit);
+  object.phi(centers,center_phi);
+  const T radius = (T).5*sqrt(T(d))*block*dx+band;
+  Array<TV> origins;
+  for (int b=0;b<total;b++)
+    if (abs(center_phi[b])<=radius)
+      blocks.set(indices[b],nodes*origins.append(box.min+dx*block*TV(indices[b])));
+
+  // Fill in the nodes of each cached block
+  values.resize(nodes*origins.size(),uninit);
+  #pragma omp parallel for schedule(dynamic,1)
+  for (int b=0;b<origins.size();b++) {
+    Array<TV> X(nodes,uninit);
+    for (int n=0;n<nodes;n++) {
+      IV I;
+      for (int a=d-1,r=n;a>=0;r/=nodes_per_axis,a--)
+        I[a] = r%nodes_per_axis;
+      X[n] = origins[b]+dx*TV(I);
+    }
+    object.phi(X,values.slice(nodes*b,nodes*(b+1)));
+  }
+}
+
+template<class TV> SparseImplicit<TV>::
+~SparseImplicit() {}
+
+template<class TV> inline int SparseImplicit<TV>::
+locate(const TV& X, TV& f) const
+{
+  const TV u = (X-box.min)/dx;
+  IV cell, b;
+  for (int a=0;a<d;a++) {
+    if (!(0<=u[a] && u[a]<cells[a]))
+      return -1;
+    cell[a] = int(u[a]);
+    f[a] = u[a]-cell[a];
+    b[a] = cell[a]/block;
+  }
+  const int* offset = blocks.get_pointer(b);
+  return offset ? *offset+node_offset(cell-block*b) : -1;
+}
+
+template<class TV> inline typename TV::Scalar SparseImplicit<TV>::
+interpolate(const int offset, const TV& f) const
+{
+  T phi = 0;
+  for (int c=0;c<(1<<d);c++) {
+    T w = 1;
+    IV corner;
+    for (int a=0;a<d;a++) {
+      corner[a] = c>>a&1;
+      w *= corner[a] ? f[a] : 1-f[a];
+    }
+    phi += w*values[offset+node_offset(corner)];
+  }
+  return phi;
+}
+
+template<class TV> typename TV::Scalar SparseImplicit<TV>::
+phi(const TV& X) const
+{
+  TV f;
+  const int offset = locate(X,f);
+  return offset>=0 ? interpolate(offset,f) : object->phi(X);
+}
+
+template<class TV> void SparseImplicit<TV>::
+phi(RawArray<const TV> X, RawArray<T> phi) const
+{
+  GEODE_ASSERT(X.size()==phi.size());
+  // Interpolate where cached, and send the rest to the wrapped object in one batch
+  Array<int> missed;
+  Array<TV> missed_X;
+  for (int i=0;i<X.size();i++) {
+    TV f;
+    const int offset = locate(X[i],f);
+    if (offset>=0)
+      phi[i] = interpolate(offset,f);
+    else {
+      missed.append(i);
+      missed_X.append(X[i]);
+    }
+  }
+  if (missed.size()) {
+    Array<T> missed_phi(missed.size(),uninit);
+    object->phi(missed_X,missed_phi);
+    for (int i=0;i<missed.size();i++)
+      phi[missed[i]] = missed_phi[i];
+  }
+}
+
+template<class TV> TV SparseImplicit<TV>::
+normal(const TV& X) const
+{
+  TV f;
+  const int offset = locate(X,f);
+  if (offset<0)
+    return object->normal(X);
+  // Gradient of the multilinear interpolant
+  TV grad;
+  for (int c=0;c<(1<<d);c++) {
+    IV corner;
+    for (int a=0;a<d;a++)
+      corner[a] = c>>a&1;
+    const T v = values[offset+node_offset(corner)];
+    for (int a=0;a<d;a++) {
+      T w = corner[a] ? 1 : -1;
+      for (int b=0;b<d;b++)
+        if (b!=a)
+          w *= corner[b] ? f[b] : 1-f[b];
+      grad[a] += w*v;
+    }
+  }
+  return grad.normalized();
+}
+
+template<class TV> TV SparseImplicit<TV>::
+surface(const TV& X) const
+{
+  TV f;
+  const int offset = locate(X,f);
+  return offset>=0 ? X-interpolate(offset,f)*normal(X) : object->surface(X);
+}
+
+template<class TV> bool SparseImplicit<TV>::
+lazy_inside(const TV& X) const
+{
+  return phi(X)<=0;
+}
+
+template<class TV> Box<TV> SparseImplicit<TV>::
+bounding_box() const
+{
+  return object->bounding_box();
+}
+
+template<class TV> string SparseImplicit<TV>::
+repr() const
+{
+  return format("SparseImplicit(%s,%s,%s)",object->repr(),geode::repr(dx),geode::repr(band));
+}
+
+template class SparseImplicit<Vector<T,2>>;
+template class SparseImplicit<Vector<T,3>>;
+
+}
+using namespace geode;
+
+template<int d> static void wrap_helper() {
+  typedef Vector<T,d> TV;
+  typedef SparseImplicit<TV> Self;
+
+  Class<Self>(d==2?"SparseImplicit2d":"SparseImplicit3d")
+    .GEODE_INIT(const Implicit<TV>&,T,T)
+    .GEODE_FIELD(object)
+    .GEODE_FIELD(dx)
+    .GEODE_FIELD(band)
+    .GEODE_METHOD(cached_blocks)
+    ;
+}
+
+void wrap_sparse_implicit() {
+  wrap_helper<2>();
+  wrap_helper<3>();
+}
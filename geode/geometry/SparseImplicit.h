@@ -0,0 +1,62 @@
+//#####################################################################
+// Class SparseImplicit
+//#####################################################################
+//
+// SparseImplicit caches the phi of another implicit on a grid with spacing
+// dx, storing blocks of nodes only within band of the zero set.  Inside
+// cached blocks phi is multilinearly interpolated, and elsewhere the wrapped
+// object is evaluated directly.
+//
+// Blocks are culled by evaluating phi at their centers, which is correct
+// only if the wrapped phi is a distance function or otherwise 1-Lipschitz.
+//
+//#####################################################################
+#pragma once
+
+#include <geode/geometry/Implicit.h>
+#include <geode/structure/Hashtable.h>
+namespace geode {
+
+template<class TV>
+class SparseImplicit:public Implicit<TV>
+{
+  typedef typename TV::Scalar T;
+  typedef Vector<int,TV::m> IV;
+public:
+  GEODE_DECLARE_TYPE(GEODE_CORE_EXPORT)
+  typedef Implicit<TV> Base;
+  static const int d = TV::m;
+  static const int block = 8; // Cells per block along each axis
+
+  const Ref<const Implicit<TV>> object;
+  const T dx, band;
+  const Box<TV> box; // Grid nodes are at box.min+dx*I
+  const IV cells; // Number of grid cells along each axis, a multiple of block
+private:
+  Hashtable<IV,int> blocks; // Block index to offset of its first node in values
+  Array<T> values; // (block+1)^d nodes per cached block, with the last axis varying fastest
+
+protected:
+  GEODE_CORE_EXPORT SparseImplicit(const Implicit<TV>& object, const T dx, const T band);
+public:
+  ~SparseImplicit();
+
+  int cached_blocks() const {
+    return blocks.size();
+  }
+
+  virtual T phi(const TV& X) const;
+  virtual void phi(RawArray<const TV> X, RawArray<T> phi) const;
+  virtual TV normal(const TV& X) const;
+  virtual TV surface(const TV& X) const;
+  virtual bool lazy_inside(const TV& X) const;
+  virtual Box<TV> bounding_box() const;
+  virtual string repr() const;
+
+private:
+  // Node offset of the lower corner of the cell containing X and fractional coordinates within the cell, or -1 if
+  // the cell is not cached.
+  int locate(const TV& X, TV& f) const;
+  T interpolate(const int offset, const TV& f) const;
+};
+}
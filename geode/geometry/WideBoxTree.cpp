@@ -0,0 +1,124 @@
+//#####################################################################
+// Class WideBoxTree
+//#####################################################################
+#include <geode/geometry/WideBoxTree.h>
+#include <geode/python/Class.h>
+#include <geode/utility/const_cast.h>
+namespace geode {
+
+typedef real T;
+
+template<class TV,int w> const int WideBoxTree<TV,w>::width;
+
+static inline T area(const Box<Vector<T,2>>& box) {
+  return box.empty() ? 0 : box.sizes().sum();
+}
+static inline T area(const Box<Vector<T,3>>& box) {
+  return box.empty() ? 0 : box.surface_area();
+}
+
+// Each wide node is rooted at a node of the binary tree.  We start with its two children as lanes, and repeatedly
+// replace the internal lane with the largest surface area by its children until all w lanes are used.
+template<class TV,int w> WideBoxTree<TV,w>::WideBoxTree(const BoxTree<TV>& tree)
+  : tree(ref(tree)), depth(0) {
+  if (!tree.nodes())
+    return;
+  Array<Node> nodes;
+  Array<Vector<int,w>> sources;
+  Array<int> roots, depths;
+  roots.append(0);
+  depths.append(1);
+  for (int i=0;i<roots.size();i++) {
+    Vector<int,w> lanes;
+    lanes.fill(-1);
+    int k = 0;
+    const int r = roots[i];
+    if (tree.is_leaf(r))
+      lanes[k++] = r;
+    else {
+      const auto c = tree.children(r);
+      lanes[k++] = c.x;
+      lanes[k++] = c.y;
+      while (k < w) {
+        int best = -1;
+        T best_area = -1;
+        for (int j=0;j<k;j++)
+          if (!tree.is_leaf(lanes[j])) {
+            const T a = area(tree.boxes[lanes[j]]);
+            if (best_area < a) {
+              best = j;
+              best_area = a;
+            }
+          }
+        if (best < 0)
+          break;
+        const auto c = tree.children(lanes[best]);
+        lanes[best] = c.x;
+        lanes[k++] = c.y;
+      }
+    }
+    Node node;
+    for (int j=0;j<w;j++) {
+      if (j >= k)
+        node.children[j] = 0;
+      else if (tree.is_leaf(lanes[j]))
+        node.children[j] = ~lanes[j];
+      else {
+        node.children[j] = roots.append(lanes[j]);
+        depths.append(depths[i]+1);
+      }
+    }
+    nodes.append(node);
+    sources.append(lanes);
+  }
+  const_cast_(this->nodes) = nodes;
+  const_cast_(this->sources) = sources;
+  const_cast_(depth) = depths.max();
+  update();
+}
+
+template<class TV,int w> WideBoxTree<TV,w>::~WideBoxTree() {}
+
+template<class TV,int w> void WideBoxTree<TV,w>::update() {
+  GEODE_ASSERT(tree->nodes()==0 || nodes.size());
+  const auto boxes = tree->boxes.raw();
+  #pragma omp parallel for
+  for (int n=0;n<nodes.size();n++) {
+    auto& node = nodes[n];
+    for (int l=0;l<w;l++) {
+      const int s = sources[n][l];
+      const auto box = s >= 0 ? boxes[s] : Box<TV>::empty_box();
+      for (int a=0;a<d;a++) {
+        node.min[a][l] = box.min[a];
+        node.max[a][l] = box.max[a];
+      }
+    }
+  }
+}
+
+#define INSTANTIATE(d,w) \
+  template<> GEODE_DEFINE_TYPE(WideBoxTree<Vector<T,d>,w>) \
+  template class WideBoxTree<Vector<T,d>,w>;
+INSTANTIATE(2,4)
+INSTANTIATE(2,8)
+INSTANTIATE(3,4)
+INSTANTIATE(3,8)
+
+}
+using namespace geode;
+
+template<int d> static void wrap_helper() {
+  typedef Vector<T,d> TV;
+  typedef WideBoxTree<TV> Self;
+  Class<Self>(d==2?"WideBoxTree2d":"WideBoxTree3d")
+    .GEODE_INIT(const BoxTree<TV>&)
+    .GEODE_FIELD(tree)
+    .GEODE_FIELD(depth)
+    .GEODE_METHOD(update)
+    ;
+}
+
+void wrap_wide_box_tree() {
+  wrap_helper<2>();
+  wrap_helper<3>();
+}
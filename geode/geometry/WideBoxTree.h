@@ -0,0 +1,214 @@
+//#####################################################################
+// Class WideBoxTree
+//#####################################################################
+//
+// WideBoxTree collapses a binary BoxTree into a tree with up to w children
+// per node.  The boxes of a node's children are stored together in
+// structure-of-arrays form, so a box, sphere, ray, or point is tested
+// against all of them at once with fixed width loops that the compiler
+// turns into SIMD instructions.  This halves the depth of the tree for w=4
+// and replaces most of the pointer chasing of binary traversal with
+// arithmetic.
+//
+// Wide leaves are leaves of the underlying BoxTree, so primitives are found
+// via tree->prims(leaf).  The wide tree copies the boxes of the binary tree,
+// so call update() after refitting the binary tree.
+//
+// Traversal functions are templates taking leaf callbacks, and should be
+// instantiated only in .cpp files.
+//
+//#####################################################################
+#pragma once
+
+#include <geode/array/alloca.h>
+#include <geode/array/RawStack.h>
+#include <geode/geometry/forward.h>
+#include <geode/geometry/BoxTree.h>
+#include <geode/geometry/RayIntersection.h>
+#include <geode/geometry/Sphere.h>
+#include <geode/math/constants.h>
+#include <geode/math/integer_log.h>
+#include <geode/structure/Tuple.h>
+namespace geode {
+
+template<class TV,int w> class WideBoxTree : public Object {
+  typedef typename TV::Scalar T;
+  static const int d = TV::m;
+public:
+  GEODE_DECLARE_TYPE(GEODE_CORE_EXPORT)
+  typedef Object Base;
+  static const int width = w;
+
+  struct Node {
+    T min[d][w], max[d][w]; // Child boxes, empty for unused lanes
+    int children[w]; // Wide node if >= 0, otherwise ~leaf for a leaf of the binary tree
+  };
+
+  const Ref<const BoxTree<TV>> tree;
+  const Array<Node> nodes; // The root is node 0, and children come after their parents
+  const Array<const Vector<int,w>> sources; // Binary tree node of each lane, or -1 for unused lanes
+  const int depth; // Max number of wide nodes from root to leaf
+
+protected:
+  GEODE_CORE_EXPORT WideBoxTree(const BoxTree<TV>& tree);
+public:
+  ~WideBoxTree();
+
+  GEODE_CORE_EXPORT void update(); // Call whenever tree->boxes changes
+
+  // Bitmask of lanes whose boxes intersect a box
+  static int intersects(const Node& node, const Box<TV>& box) {
+    bool hit[w];
+    for (int l=0;l<w;l++)
+      hit[l] = true;
+    for (int a=0;a<d;a++)
+      for (int l=0;l<w;l++)
+        hit[l] &= (node.min[a][l]<=box.max[a]) & (box.min[a]<=node.max[a][l]);
+    return mask(hit);
+  }
+
+  // Squared distances from a point to each lane's box, or infinity for unused lanes
+  static void sqr_distance_bounds(const Node& node, const TV& X, T sqr_distances[w]) {
+    for (int l=0;l<w;l++)
+      sqr_distances[l] = 0;
+    for (int a=0;a<d;a++)
+      for (int l=0;l<w;l++) {
+        const T e = geode::max(T(0),geode::max(node.min[a][l]-X[a],X[a]-node.max[a][l]));
+        sqr_distances[l] += e*e;
+      }
+  }
+
+  // Bitmask of lanes whose boxes intersect a sphere
+  static int intersects(const Node& node, const Sphere<TV>& sphere) {
+    T sqr_distances[w];
+    sqr_distance_bounds(node,sphere.center,sqr_distances);
+    const T sqr_radius = sqr(sphere.radius);
+    bool hit[w];
+    for (int l=0;l<w;l++)
+      hit[l] = sqr_distances[l]<=sqr_radius;
+    return mask(hit);
+  }
+
+  // Ray parameter ranges [t_min[l],t_max[l]] within each lane's box enlarged by half_thickness, as in FastRay.
+  // inv_dx is the inverse ray direction, and signs has bit a set if inv_dx[a]<0.
+  static void ray_ranges(const Node& node, const TV& start, const TV& inv_dx, const int signs,
+                         const T half_thickness, T t_min[w], T t_max[w]) {
+    for (int l=0;l<w;l++) {
+      t_min[l] = -inf;
+      t_max[l] = inf;
+    }
+    for (int a=0;a<d;a++) {
+      const bool s = (signs&1<<a)!=0;
+      const T* near = s ? node.max[a] : node.min[a];
+      const T* far = s ? node.min[a] : node.max[a];
+      const T e = s ? half_thickness : -half_thickness;
+      for (int l=0;l<w;l++) {
+        t_min[l] = geode::max(t_min[l],inv_dx[a]*(near[l]+e-start[a]));
+        t_max[l] = geode::min(t_max[l],inv_dx[a]*(far[l]-e-start[a]));
+      }
+    }
+  }
+
+private:
+  static int mask(const bool hit[w]) {
+    int m = 0;
+    for (int l=0;l<w;l++)
+      m |= hit[l]<<l;
+    return m;
+  }
+};
+
+// Call leaf(n) for each leaf n of the binary tree whose box intersects shape, which is a Box or Sphere
+template<class TV,int w,class Shape,class Leaf> static void
+wide_intersection_traverse(const WideBoxTree<TV,w>& wide, const Shape& shape, Leaf&& leaf) {
+  if (!wide.nodes.size())
+    return;
+  RawStack<int> stack(GEODE_RAW_ALLOCA(wide.depth*w,int));
+  stack.push(0);
+  while (stack.size()) {
+    const auto& node = wide.nodes[stack.pop()];
+    for (uint32_t m=wide.intersects(node,shape);m;m&=m-1) {
+      const int c = node.children[integer_log_exact(min_bit(m))];
+      if (c >= 0)
+        stack.push(c);
+      else
+        leaf(~c);
+    }
+  }
+}
+
+// Visit leaves whose boxes, enlarged by half_thickness, intersect the ray in increasing order of entry.  leaf(n) may
+// shrink ray.t_max, and further leaves beyond ray.t_max are skipped.
+template<class TV,int w,class Leaf> static void
+wide_ray_traverse(const WideBoxTree<TV,w>& wide, RayIntersection<TV>& ray, const typename TV::Scalar half_thickness,
+                  Leaf&& leaf) {
+  typedef typename TV::Scalar T;
+  if (!wide.nodes.size())
+    return;
+  const TV inv_dx = 1/ray.direction;
+  int signs = 0;
+  for (int a=0;a<TV::m;a++)
+    signs |= (inv_dx[a]<0)<<a;
+  RawStack<Tuple<int,T>> stack(GEODE_RAW_ALLOCA(wide.depth*w,Tuple<int,T>)); // Each entry is (node or ~leaf,t_min)
+  stack.push(tuple(0,T(-inf)));
+  while (stack.size()) {
+    const auto entry = stack.pop();
+    if (entry.y>ray.t_max) // Check t_min again since ray.t_max may have changed
+      continue;
+    if (entry.x < 0) {
+      leaf(~entry.x);
+      continue;
+    }
+    const auto& node = wide.nodes[entry.x];
+    T t_min[w], t_max[w];
+    wide.ray_ranges(node,ray.start,inv_dx,signs,half_thickness,t_min,t_max);
+    // Sort hit lanes by decreasing t_min, so that the closest is popped first
+    Tuple<int,T> hits[w];
+    int n = 0;
+    for (int l=0;l<w;l++)
+      if (t_min[l]<=t_max[l] && t_max[l]>=0 && t_min[l]<=ray.t_max) {
+        int i = n++;
+        for (;i && hits[i-1].y<t_min[l];i--)
+          hits[i] = hits[i-1];
+        hits[i] = tuple(node.children[l],t_min[l]);
+      }
+    for (int i=0;i<n;i++)
+      stack.push(hits[i]);
+  }
+}
+
+// Visit leaves whose boxes are closer to X than sqrt(sqr_distance) in roughly increasing order of distance.
+// leaf(n,sqr_distance) may shrink sqr_distance, and further leaves beyond it are skipped.
+template<class TV,int w,class Leaf> static void
+wide_closest_traverse(const WideBoxTree<TV,w>& wide, const TV& X, typename TV::Scalar& sqr_distance, Leaf&& leaf) {
+  typedef typename TV::Scalar T;
+  if (!wide.nodes.size())
+    return;
+  RawStack<Tuple<int,T>> stack(GEODE_RAW_ALLOCA(wide.depth*w,Tuple<int,T>)); // Each entry is (node or ~leaf,bound)
+  stack.push(tuple(0,T(0)));
+  while (stack.size()) {
+    const auto entry = stack.pop();
+    if (entry.y>=sqr_distance)
+      continue;
+    if (entry.x < 0) {
+      leaf(~entry.x,sqr_distance);
+      continue;
+    }
+    const auto& node = wide.nodes[entry.x];
+    T bounds[w];
+    wide.sqr_distance_bounds(node,X,bounds);
+    Tuple<int,T> near[w];
+    int n = 0;
+    for (int l=0;l<w;l++)
+      if (bounds[l]<sqr_distance) {
+        int i = n++;
+        for (;i && near[i-1].y<bounds[l];i--)
+          near[i] = near[i-1];
+        near[i] = tuple(node.children[l],bounds[l]);
+      }
+    for (int i=0;i<n;i++)
+      stack.push(near[i]);
+  }
+}
+
+}
@@ -0,0 +1,151 @@
+//#####################################################################
+// Class WindingGrid
+//#####################################################################
+#include <geode/geometry/WindingGrid.h>
+#include <geode/geometry/polygon.h>
+#include <geode/array/parallel_nested.h>
+#include <geode/python/Class.h>
+#include <geode/utility/const_cast.h>
+#include <cmath>
+namespace geode {
+
+typedef real T;
+GEODE_DEFINE_TYPE(WindingGrid)
+
+// Signed crossing of the segment from c to p with the edge from a to b: +1 if p is left of the edge and c is not, -1
+// for the reverse, and 0 if they don't cross.  Ties are broken consistently, so that a segment passing through a vertex
+// crosses exactly one of its edges.
+static inline int crossing(const Vec2 c, const Vec2 p, const Vec2 a, const Vec2 b) {
+  const bool lc = cross(b-a,c-a)>0,
+             lp = cross(b-a,p-a)>0;
+  if (lc==lp)
+    return 0;
+  const bool la = cross(p-c,a-c)>0,
+             lb = cross(p-c,b-c)>0;
+  if (la==lb)
+    return 0;
+  return lp ? 1 : -1;
+}
+
+// Does the edge from a to b touch the box?
+static inline bool edge_touches(const Vec2 a, const Vec2 b, const Box<Vec2>& box) {
+  if (!bounding_box(a,b).intersects(box))
+    return false;
+  const Vec2 v = b-a;
+  bool left = false, right = false;
+  for (const int i : range(4)) {
+    const T s = cross(v,Vec2(i&1?box.max.x:box.min.x,i&2?box.max.y:box.min.y)-a);
+    left |= s>=0;
+    right |= s<=0;
+  }
+  return left && right;
+}
+
+WindingGrid::WindingGrid(Nested<const Vec2> polys)
+  : polys(polys)
+  , next(closed_contours_next(polys)) {
+  const auto X = polys.flat;
+  const int n = X.size();
+
+  // Choose about one cell per edge, plus a margin cell on each side
+  const auto bounds = bounding_box(X);
+  const T scale = n ? max(T(1e-10),bounds.sizes().max()) : 1;
+  const Vec2 sizes = n ? Vec2::componentwise_max(bounds.sizes(),1e-6*scale*Vec2::ones()) : Vec2(1,1);
+  Vector<int,2> inner;
+  inner.x = clamp(int(std::round(sqrt(n*sizes.x/sizes.y))),1,max(1,n));
+  inner.y = max(1,min(max(1,n),int(std::round(T(n)/inner.x))));
+  const_cast_(dx) = sizes/Vec2(inner);
+  const_cast_(box) = Box<Vec2>(bounds.min-dx,bounds.min+dx*Vec2(inner+1));
+  const_cast_(cells) = inner+2;
+  if (!n)
+    const_cast_(box) = Box<Vec2>(Vec2(),dx*Vec2(cells));
+
+  // Find the cells touched by each edge, then invert
+  const auto edge_cells = parallel_nested(n,[&](const int e) {
+    const Vec2 a = X[e], b = X[next[e]];
+    const auto lo = Vector<int,2>(floor((Vec2::componentwise_min(a,b)-box.min)/dx)),
+               hi = Vector<int,2>(floor((Vec2::componentwise_max(a,b)-box.min)/dx));
+    Array<int> touched;
+    for (int i=max(0,lo.x);i<=min(cells.x-1,hi.x);i++)
+      for (int j=max(0,lo.y);j<=min(cells.y-1,hi.y);j++)
+        if (edge_touches(a,b,Box<Vec2>(box.min+dx*Vec2(i,j),box.min+dx*Vec2(i+1,j+1))))
+          touched.append(i*cells.y+j);
+    return touched;
+  });
+  Array<int> counts(cells.product());
+  for (const int c : edge_cells.flat)
+    counts[c]++;
+  Nested<int> cell_edges(counts,uninit);
+  for (int e=n-1;e>=0;e--)
+    for (const int c : edge_cells[e])
+      cell_edges.flat[cell_edges.offsets[c]+--counts[c]] = e;
+  const_cast_(this->cell_edges) = cell_edges;
+
+  // The margin cells are outside all polygons.  Propagate winding numbers along each row from there, counting
+  // crossings of edges in either of each pair of adjacent cells.  Edge lists are sorted, so we merge them to avoid
+  // counting an edge twice.
+  Array<int,2> windings(cells);
+  #pragma omp parallel for schedule(dynamic,1)
+  for (int j=1;j<cells.y-1;j++)
+    for (int i=1;i<cells.x-1;i++) {
+      const Vec2 c = center(i-1,j), p = center(i,j);
+      const auto A = cell_edges[(i-1)*cells.y+j],
+                 B = cell_edges[i*cells.y+j];
+      int w = windings(i-1,j);
+      for (int a=0,b=0;a<A.size() || b<B.size();) {
+        const int e = b==B.size() || (a<A.size() && A[a]<B[b]) ? A[a++]
+                    : a==A.size() || B[b]<A[a]                 ? B[b++]
+                                                               : (b++,A[a++]);
+        w += crossing(c,p,X[e],X[next[e]]);
+      }
+      windings(i,j) = w;
+    }
+  const_cast_(this->windings) = windings;
+}
+
+WindingGrid::~WindingGrid() {}
+
+int WindingGrid::winding(const Vec2 p) const {
+  const Vec2 u = (p-box.min)/dx;
+  if (!(0<=u.x && u.x<cells.x && 0<=u.y && u.y<cells.y))
+    return 0;
+  const int i = int(u.x), j = int(u.y);
+  const Vec2 c = center(i,j);
+  int w = windings(i,j);
+  for (const int e : cell_edges[i*cells.y+j])
+    w += crossing(c,p,polys.flat[e],polys.flat[next[e]]);
+  return w;
+}
+
+Array<int> WindingGrid::windings_of(RawArray<const Vec2> points) const {
+  Array<int> result(points.size(),uninit);
+  #pragma omp parallel for schedule(static,1024)
+  for (int i=0;i<points.size();i++)
+    result[i] = winding(points[i]);
+  return result;
+}
+
+Array<bool> WindingGrid::inside(RawArray<const Vec2> points) const {
+  Array<bool> result(points.size(),uninit);
+  #pragma omp parallel for schedule(static,1024)
+  for (int i=0;i<points.size();i++)
+    result[i] = winding(points[i])>0;
+  return result;
+}
+
+}
+using namespace geode;
+
+void wrap_winding_grid() {
+  typedef WindingGrid Self;
+  Class<Self>("WindingGrid")
+    .GEODE_INIT(Nested<const Vec2>)
+    .GEODE_FIELD(polys)
+    .GEODE_FIELD(box)
+    .GEODE_FIELD(cells)
+    .GEODE_FIELD(windings)
+    .GEODE_METHOD(winding)
+    .GEODE_METHOD(windings_of)
+    .GEODE_METHOD(inside)
+    ;
+}
@@ -0,0 +1,62 @@
+//#####################################################################
+// Class WindingGrid
+//#####################################################################
+//
+// WindingGrid answers point in polygon queries against a fixed set of
+// closed polygons in roughly constant time per query.  A uniform grid over
+// the polygons stores the winding number at each cell center and the edges
+// crossing each cell.  The winding number of a point is that of its cell
+// center plus the signed crossings of the cell's edges by the segment from
+// the center to the point.
+//
+// The grid has about one cell per edge, and a margin of empty cells so that
+// the winding number is propagated from outside the polygons.
+//
+// WARNING: Not robust.  Points within rounding error of an edge may be
+// classified either way.
+//
+//#####################################################################
+#pragma once
+
+#include <geode/array/Array2d.h>
+#include <geode/array/Nested.h>
+#include <geode/geometry/Box.h>
+#include <geode/python/Object.h>
+#include <geode/vector/Vector2d.h>
+namespace geode {
+
+class WindingGrid : public Object {
+public:
+  GEODE_DECLARE_TYPE(GEODE_CORE_EXPORT)
+  typedef Object Base;
+  typedef real T;
+
+  const Nested<const Vec2> polys; // Closed polygons, positively oriented polygons have winding number one inside
+  const Box<Vec2> box; // Grid bounds, including one margin cell on each side
+  const Vector<int,2> cells; // Number of cells along each axis
+  const Vec2 dx; // Cell size
+  const Array<const int,2> windings; // Winding number at each cell center
+  const Nested<const int> cell_edges; // Edges crossing each cell, indexed by i*cells.y+j.  Edge e goes from polys.flat[e] to polys.flat[next[e]].
+  const Array<const int> next;
+
+protected:
+  GEODE_CORE_EXPORT WindingGrid(Nested<const Vec2> polys);
+public:
+  ~WindingGrid();
+
+  // Winding number of a point
+  GEODE_CORE_EXPORT int winding(const Vec2 p) const;
+
+  // Winding numbers of many points, computed in parallel
+  GEODE_CORE_EXPORT Array<int> windings_of(RawArray<const Vec2> points) const;
+
+  // Whether each point has positive winding number, computed in parallel
+  GEODE_CORE_EXPORT Array<bool> inside(RawArray<const Vec2> points) const;
+
+private:
+  Vec2 center(const int i, const int j) const {
+    return box.min+dx*Vec2(i+.5,j+.5);
+  }
+};
+
+}
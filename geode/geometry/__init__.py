@@ -6,19 +6,34 @@ from geode import *
 from numpy import asarray
 
 BoxTrees = {2:BoxTree2d,3:BoxTree3d}
-def BoxTree(X,leaf_size):
+def BoxTree(X,leaf_size,sah=False):
   X = asarray(X)
-  return BoxTrees[X.shape[1]](X,leaf_size)
+  return BoxTrees[X.shape[1]](X,leaf_size,sah)
 
 ParticleTrees = {2:ParticleTree2d,3:ParticleTree3d}
-def ParticleTree(X,leaf_size=1):
+def ParticleTree(X,leaf_size=1,sah=False):
   X = asarray(X)
-  return ParticleTrees[X.shape[1]](X,leaf_size)
+  return ParticleTrees[X.shape[1]](X,leaf_size,sah)
+
+DynamicBoxTrees = {2:DynamicBoxTree2d,3:DynamicBoxTree3d}
+def DynamicBoxTree(d,margin=0):
+  return DynamicBoxTrees[d](margin)
 
 SimplexTrees = {(2,1):SegmentTree2d,(3,1):SegmentTree3d,(2,2):TriangleTree2d,(3,2):TriangleTree3d}
-def SimplexTree(mesh,X,leaf_size=1):
+def SimplexTree(mesh,X,leaf_size=1,sah=False):
   X = asarray(X)
-  return SimplexTrees[X.shape[1],mesh.d](mesh,X,leaf_size)
+  return SimplexTrees[X.shape[1],mesh.d](mesh,X,leaf_size,sah)
+
+SimplexTreeWriters = {(2,1):write_segment_tree_2d,(3,1):write_segment_tree_3d,
+                      (2,2):write_triangle_tree_2d,(3,2):write_triangle_tree_3d}
+def write_simplex_tree(filename,tree):
+  return SimplexTreeWriters[tree.X.shape[1],tree.d](filename,tree)
+
+SimplexTreeReaders = {(2,1):read_segment_tree_2d,(3,1):read_segment_tree_3d,
+                      (2,2):read_triangle_tree_2d,(3,2):read_triangle_tree_3d}
+def read_simplex_tree(filename,mesh,X):
+  X = asarray(X)
+  return SimplexTreeReaders[X.shape[1],mesh.d](filename,mesh,X)
 
 Boxes = {1:Box1d,2:Box2d,3:Box3d}
 def Box(min,max):
@@ -49,6 +64,10 @@ FrameImplicits = {2:FrameImplicit2d,3:FrameImplicit3d}
 def FrameImplicit(frame,object):
   return FrameImplicits[object.d](frame,object)
 
+SparseImplicits = {2:SparseImplicit2d,3:SparseImplicit3d}
+def SparseImplicit(object,dx,band):
+  return SparseImplicits[object.d](object,dx,band)
+
 surface_levelsets = {1:surface_levelset_c3d,2:surface_levelset_s3d}
 def surface_levelset(particles,surface,max_distance=inf,compute_signs=True):
   return surface_levelsets[surface.d](particles,surface,max_distance,compute_signs)
@@ -1,4 +1,5 @@
 #include "arc_fitting.h"
+#include <geode/array/parallel_nested.h>
 #include <geode/math/constants.h>
 #include <geode/python/wrap.h>
 #include <geode/utility/prioritize.h>
@@ -98,11 +99,9 @@ Array<Vec2> discretize_arcs(const RawArray<const CircleArc> arc_points, const bo
 }
 
 Nested<Vec2> discretize_nested_arcs(const Nested<const CircleArc> arc_points, const bool closed, const real max_deviation) {
-  Nested<Vec2, false> result;
-  for(const auto& p : arc_points) {
-    result.append(discretize_arcs(p, closed, max_deviation));
-  }
-  return result.freeze();
+  return parallel_nested(arc_points.size(), [&](const int i) {
+    return discretize_arcs(arc_points[i], closed, max_deviation);
+  });
 }
 
 real fit_q(const Vec2 p0, const Vec2 p1, const Vec2 p3) {
@@ -357,11 +356,10 @@ Array<CircleArc> fit_arcs(const RawArray<const Vec2> points, real allowed_error,
 }
 
 Nested<CircleArc> fit_polyarcs(const Nested<const Vec2> polys, real allowed_error, bool closed) {
-  Nested<CircleArc, false> result;
-  for(const auto p : polys) {
-    result.append(fit_arcs(p,allowed_error,closed));
-  }
-  return result.freeze();
+  // Curves are independent, so fit them in parallel
+  return parallel_nested(polys.size(), [&](const int i) {
+    return fit_arcs(polys[i],allowed_error,closed);
+  });
 }
 } // geode namespace
 using namespace geode;
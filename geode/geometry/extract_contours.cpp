@@ -1,20 +1,15 @@
 #include "extract_contours.h"
 #include <geode/array/Array2d.h>
+#include <geode/array/parallel_nested.h>
+#include <geode/structure/Hashtable.h>
+#include <geode/structure/Tuple.h>
+#include <algorithm>
+#include <limits>
+#include <vector>
 
 namespace geode {
 
 namespace {
-struct XYIter {
-  Vec2i max;
-  Vec2i i;
-  explicit XYIter(Vec2i _max, Vec2i _i) : max(_max), i(_i) {}
-  bool operator!=(XYIter j) const { return i != j.i; } // Assumes sizes are equal
-  XYIter& operator++() { ++i.x; if(i.x == max.x) { i.x = 0; ++i.y; } return *this; }
-  XYIter& operator--() { if(i.x == 0) { i.x = max.x; --i.y; } --i.x; return *this; }
-  Vec2i operator*() const { return i; }
-};
-static Range<XYIter> xy_range(const Vec2i sizes) { return range(XYIter(sizes,Vec2i()),XYIter(sizes,Vec2i(0,sizes.y))); }
-
 typedef unsigned char FlagsData;
 
 template<FlagsData _set, FlagsData _cleared> struct FlagSubsetCondition {
@@ -75,6 +70,18 @@ struct GridVertex {
   bool is_marked() const { return marked::is_true::check(info); }
   bool is_unmarked_e_edge() const { return unmarked_e_edge::check(info); }
 
+  // Is there a contour edge leaving this vertex in direction dir?  The sample on its left must be filled, and the
+  // sample on its right empty.
+  bool has_edge(const GridDir dir) const {
+    switch(dir) {
+      case GridDir::E: return (ne::is_true() && se::is_false()).check(info);
+      case GridDir::N: return (nw::is_true() && ne::is_false()).check(info);
+      case GridDir::W: return (sw::is_true() && nw::is_false()).check(info);
+      case GridDir::S: return (se::is_true() && sw::is_false()).check(info);
+    }
+    GEODE_FATAL_ERROR("Unhandled case in switch statement");
+  }
+
 
   GridDir next_dir(const GridDir prev_dir) const {
     const FlagsData neighbors_mask = ne::mask | nw::mask | sw::mask | se::mask;
@@ -123,45 +130,210 @@ static Vec2 interpolate_vertex(const Vec2i vert_index, const GridDir dir, const
           t*rotate_left_90(dir_vec); // ...to get interpolated point (since range of t is [-0.5,0.5])
 }
 
+namespace {
+// A directed edge of the vertex grid, stored as (x,y,dir) so that it can be hashed
+typedef Vector<int,3> GridEdge;
+
+static inline GridEdge grid_edge(const Vec2i vert, const GridDir dir) {
+  return GridEdge(vert.x,vert.y,index_of(dir));
+}
+
+// A piece of a contour traced within one tile, from an edge entering the tile until the walk leaves it
+struct Fragment {
+  Array<Vec2> points;
+  int next; // Entry edge where the walk continues in another tile
+  int64_t seed; // Scan order key of the first eastward edge, or max if none
+  int seed_offset; // Index of the point on the seed edge
+};
+}
+
+// Scan order key of a vertex, matching the order in which a serial scan would find seeds
+static inline int64_t scan_key(const Vec2i vert, const Vec2i sizes) {
+  return int64_t(vert.y)*sizes.x+vert.x;
+}
+
+// Contours are traced in parallel over tiles of the vertex grid.  Each directed contour edge has a unique successor,
+// so every contour is a cycle of edges.  For each edge leaving a tile we find its successor, which is an entry edge
+// of a neighboring tile.  Each tile then traces fragments from its entry edges until they leave again, as well as
+// cycles lying entirely inside it.  Finally fragments are stitched into cycles, and all contours are rotated to
+// start at their first eastward edge in scan order and sorted by it, so that the result matches a serial scan.
 Nested<Vec2> extract_contours(const RawArray<const real, 2> samples, const real contour_edge_threshold, const real default_sample_value) {
   if(samples.total_size() == 0)
     return Nested<Vec2>();
   const Vec2i src_sizes = samples.sizes();
+  const Vec2i sizes = src_sizes + Vec2i::ones(); // expand size by 1 so we can represent all edges
 
-  // Copy samples into a buffer that includes local neighborhood and other info
-  const auto verts = Array<GridVertex, 2>(src_sizes + Vec2i::ones()); // expand size by 1 so we can represent all edges
+  // Classify vertices by gathering the 4 adjacent samples.  Each row is independent, and the interior of each row
+  // is a branch free loop.
+  const auto verts = Array<GridVertex, 2>(sizes, uninit);
+  #pragma omp parallel for
+  for(int i = 0; i < sizes.x; ++i) {
+    const RawArray<GridVertex> row = verts[i];
+    const real* above = i < src_sizes.x ? &samples(i,0) : 0; // Samples (i,j), to the east of vertex (i,j)
+    const real* below = i > 0 ? &samples(i-1,0) : 0; // Samples (i-1,j), to the west of vertex (i,j)
+    const auto classify = [=](const int j) {
+      const bool n = j < src_sizes.y, s = j > 0;
+      return FlagsData(  (above && n && above[j  ] > contour_edge_threshold) * GridVertex::ne::mask
+                       | (below && n && below[j  ] > contour_edge_threshold) * GridVertex::nw::mask
+                       | (below && s && below[j-1] > contour_edge_threshold) * GridVertex::sw::mask
+                       | (above && s && above[j-1] > contour_edge_threshold) * GridVertex::se::mask);
+    };
+    row[0].info = classify(0);
+    row[src_sizes.y].info = classify(src_sizes.y);
+    if(above && below) {
+      for(int j = 1; j < src_sizes.y; ++j)
+        row[j].info =   (above[j  ] > contour_edge_threshold) * GridVertex::ne::mask
+                      | (below[j  ] > contour_edge_threshold) * GridVertex::nw::mask
+                      | (below[j-1] > contour_edge_threshold) * GridVertex::sw::mask
+                      | (above[j-1] > contour_edge_threshold) * GridVertex::se::mask;
+    } else {
+      for(int j = 1; j < src_sizes.y; ++j)
+        row[j].info = classify(j);
+    }
+  }
 
-  for(const Vec2i src_idx : xy_range(src_sizes)) {
-    if(samples[src_idx] > contour_edge_threshold) { // Write each interior sample in source to the 4 adjacent vertices
-      verts[src_idx + Vec2i(0,0)].info |= GridVertex::ne::mask;
-      verts[src_idx + Vec2i(1,0)].info |= GridVertex::nw::mask;
-      verts[src_idx + Vec2i(1,1)].info |= GridVertex::sw::mask;
-      verts[src_idx + Vec2i(0,1)].info |= GridVertex::se::mask;
+  // Split the vertex grid into tiles
+  const int tile_size = 256;
+  const Vec2i tiles = (sizes + (tile_size-1)*Vec2i::ones()) / tile_size;
+  const int tile_count = tiles.product();
+  const auto tile_of = [=](const Vec2i vert) { return vert.x/tile_size*tiles.y + vert.y/tile_size; };
+  const auto tile_lo = [=](const int t) { return tile_size*Vec2i(t/tiles.y,t%tiles.y); };
+  const auto tile_hi = [=](const int t) { return Vec2i::componentwise_min(tile_lo(t) + tile_size*Vec2i::ones(), sizes); };
+  const auto successor = [&](const Vec2i vert, const GridDir dir) {
+    const Vec2i next = vert + dir_offset(dir);
+    return grid_edge(next,verts[next].next_dir(dir));
+  };
+
+  // Find successors of all edges leaving each tile.  These are the entry edges of their tiles.
+  std::vector<Array<GridEdge>> tile_exits(tile_count);
+  #pragma omp parallel for schedule(dynamic,1)
+  for(int t = 0; t < tile_count; ++t) {
+    const Vec2i lo = tile_lo(t), hi = tile_hi(t);
+    const auto check = [&](const Vec2i vert, const GridDir dir) {
+      const Vec2i next = vert + dir_offset(dir);
+      if(verts[vert].has_edge(dir) && verts.valid(next) && tile_of(next) != t)
+        tile_exits[t].append(successor(vert,dir));
+    };
+    for(int x = lo.x; x < hi.x; ++x) {
+      check(Vec2i(x,lo.y),GridDir::S);
+      check(Vec2i(x,hi.y-1),GridDir::N);
+    }
+    for(int y = lo.y; y < hi.y; ++y) {
+      check(Vec2i(lo.x,y),GridDir::W);
+      check(Vec2i(hi.x-1,y),GridDir::E);
+    }
+  }
+  Array<GridEdge> entries;
+  Hashtable<GridEdge,int> entry_ids;
+  std::vector<Array<int>> tile_entries(tile_count);
+  for(const auto& exits : tile_exits) {
+    for(const auto& e : exits) {
+      const int id = entries.append(e);
+      entry_ids.set(e,id);
+      tile_entries[tile_of(e.xy())].append(id);
     }
   }
 
-  Nested<Vec2, false> result;
-  for(const Vec2i seed : xy_range(verts.sizes())) {
-    if(verts[seed].is_unmarked_e_edge()) {
-      // We have found an unmarked vertex that has an edge to the east
-      result.append_empty(); // Start a new contour
-      GridDir dir = GridDir::E; // Force direction to E. Important if we are on a 'saddle' vertex with two opposite filled corners
-      Vec2i curr_index = seed;
+  // Trace each tile.  Marks are local to each tile, so verts is read only here.
+  std::vector<Fragment> fragments(entries.size());
+  std::vector<Nested<Vec2,false>> tile_loops(tile_count);
+  std::vector<Array<int64_t>> tile_loop_seeds(tile_count);
+  #pragma omp parallel for schedule(dynamic,1)
+  for(int t = 0; t < tile_count; ++t) {
+    const Vec2i lo = tile_lo(t), hi = tile_hi(t);
+    Array<bool,2> marked(hi-lo);
+    for(const int e : tile_entries[t]) {
+      auto& fragment = fragments[e];
+      fragment.seed = std::numeric_limits<int64_t>::max();
+      fragment.seed_offset = 0;
+      Vec2i curr_index = entries[e].xy();
+      GridDir dir = GridDir(entries[e].z);
       for(;;) {
-        if(dir == GridDir::E) { // We only mark eastward edges
-          auto& vert = verts[curr_index];
-          if(vert.is_marked()) // If we already marked this one we are done
-            break;
-          vert.mark(); // Mark edge so that we won't reuse it as a seed and will stop when we loop back
+        if(dir == GridDir::E) {
+          marked[curr_index-lo] = true;
+          const int64_t key = scan_key(curr_index,sizes);
+          if(fragment.seed > key) {
+            fragment.seed = key;
+            fragment.seed_offset = fragment.points.size();
+          }
         }
-        result.append_to_back(interpolate_vertex(curr_index, dir, samples, contour_edge_threshold, default_sample_value));
-        assert(result.back().size() <= 4*samples.total_size()); // Check that we aren't caught in an infinite loop
-        curr_index += dir_offset(dir); // Walk in given direction
+        fragment.points.append(interpolate_vertex(curr_index, dir, samples, contour_edge_threshold, default_sample_value));
+        const Vec2i next = curr_index + dir_offset(dir);
+        if(tile_of(next) != t) {
+          fragment.next = entry_ids.get(successor(curr_index,dir));
+          break;
+        }
+        curr_index = next;
         dir = verts[curr_index].next_dir(dir);
       }
     }
+    // Any remaining contours lie entirely inside the tile
+    auto& loops = tile_loops[t];
+    auto& loop_seeds = tile_loop_seeds[t];
+    for(int y = lo.y; y < hi.y; ++y) {
+      for(int x = lo.x; x < hi.x; ++x) {
+        const Vec2i seed(x,y);
+        if(verts[seed].is_unmarked_e_edge() && !marked[seed-lo]) {
+          loops.append_empty(); // Start a new contour
+          loop_seeds.append(scan_key(seed,sizes));
+          GridDir dir = GridDir::E; // Force direction to E. Important if we are on a 'saddle' vertex with two opposite filled corners
+          Vec2i curr_index = seed;
+          for(;;) {
+            if(dir == GridDir::E) { // We only mark eastward edges
+              if(marked[curr_index-lo]) // If we already marked this one we are done
+                break;
+              marked[curr_index-lo] = true; // Mark edge so that we won't reuse it as a seed and will stop when we loop back
+            }
+            loops.append_to_back(interpolate_vertex(curr_index, dir, samples, contour_edge_threshold, default_sample_value));
+            assert(loops.back().size() <= 4*samples.total_size()); // Check that we aren't caught in an infinite loop
+            curr_index += dir_offset(dir); // Walk in given direction
+            assert(tile_of(curr_index) == t);
+            dir = verts[curr_index].next_dir(dir);
+          }
+        }
+      }
+    }
   }
-  return result.freeze();
+
+  // Stitch fragments into contours, each rotated to start at its seed
+  Array<Tuple<int64_t,int,int>> order; // (seed,tile,loop) for loops, or (seed,-1,stitched) for stitched contours
+  std::vector<Array<Vec2>> stitched;
+  Array<bool> used(fragments.size());
+  for(const int start : range(int(fragments.size()))) {
+    if(used[start])
+      continue;
+    Array<Vec2> points;
+    int64_t seed = std::numeric_limits<int64_t>::max();
+    int seed_offset = 0;
+    for(int f = start; !used[f]; f = fragments[f].next) {
+      used[f] = true;
+      if(seed > fragments[f].seed) {
+        seed = fragments[f].seed;
+        seed_offset = points.size() + fragments[f].seed_offset;
+      }
+      points.extend(fragments[f].points);
+    }
+    Array<Vec2> rotated(points.size(),uninit);
+    for(const int i : range(points.size()))
+      rotated[i] = points[(i + seed_offset) % points.size()];
+    order.append(tuple(seed,-1,int(stitched.size())));
+    stitched.push_back(rotated);
+  }
+  for(const int t : range(tile_count))
+    for(const int l : range(tile_loops[t].size()))
+      order.append(tuple(tile_loop_seeds[t][l],t,l));
+
+  // Emit contours in order of their seeds
+  std::sort(order.begin(),order.end(),[](const Tuple<int64_t,int,int>& a, const Tuple<int64_t,int,int>& b) { return a.x < b.x; });
+  const auto contour = [&](const int i) -> RawArray<const Vec2> {
+    const auto& o = order[i];
+    if(o.y < 0)
+      return stitched[o.z];
+    return tile_loops[o.y][o.z];
+  };
+  return parallel_nested<Vec2>(order.size(),
+    [&](const int i) { return contour(i).size(); },
+    [&](const int i, RawArray<Vec2> points) { points = contour(i); });
 }
 
 } // namespace geode
@@ -0,0 +1,238 @@
+// Triangulated level sets of 3D scalar fields
+
+#include <geode/geometry/extract_isosurface.h>
+#include <geode/python/wrap.h>
+#include <vector>
+namespace geode {
+
+typedef real T;
+typedef Vector<T,3> TV;
+typedef Vector<int,3> IV;
+typedef Tuple<Ref<const TriangleTopology>,Field<const TV,VertexId>> Result;
+
+// Tiles own tile_size^3 nodes, and sample one more layer above so that every edge and cell starting at an owned
+// node can be handled locally.
+static const int tile_size = 16;
+static const int stride = tile_size+1;
+
+static inline int local_index(const IV p) {
+  return (p.x*stride+p.y)*stride+p.z;
+}
+
+static inline IV local_node(const int i) {
+  return IV(i/(stride*stride),i/stride%stride,i%stride);
+}
+
+// Offset of cell corner c, with bit a of c set for a step along axis a.  Grid edges from a node are numbered the
+// same way, by the corner they lead to.
+static inline IV corner(const int c) {
+  return IV(c&1,c>>1&1,c>>2&1);
+}
+
+// The six positively oriented tetrahedra of a cell, each a path from corner 0 to 7 along one axis at a time.
+// Every edge joins corners u and w with u a subset of w, so it is the grid edge w^u from corner u.
+static const int tetrahedra[6][4] = {{0,1,3,7},{0,5,1,7},{0,3,2,7},{0,2,6,7},{0,4,5,7},{0,6,4,7}};
+
+// Even permutations of the vertices of a tetrahedron, one starting with each vertex
+static const int even[4][4] = {{0,1,2,3},{1,0,3,2},{2,3,0,1},{3,2,1,0}};
+
+namespace {
+struct Tile {
+  Array<bool> inside; // Whether each sampled node has phi < level, kept only if they differ
+  Array<int> edges; // 8*local_index(node)+direction of each crossing edge starting at an owned node, in order
+  Array<TV> X; // Surface vertex on each crossing edge
+  int offset; // Id of the first vertex
+  Array<Vector<int,3>> faces;
+};
+}
+
+// sample(lo,sizes,values) sets values[local_index(p)] to the sample at node lo+p for p in [0,sizes), or returns
+// false if the level set cannot pass through those nodes.  Node I lies at origin+dx*I.
+template<class Sample> static Result extract(const IV nodes, const TV origin, const TV dx, const T level,
+                                             const Sample& sample) {
+  const IV tiles = (nodes+(tile_size-1)*IV::ones())/tile_size;
+  const int count = tiles.product();
+  const auto tile_index = [=](const IV t) { return (t.x*tiles.y+t.y)*tiles.z+t.z; };
+  const auto tile_at = [=](const int t) { return IV(t/(tiles.y*tiles.z),t/tiles.z%tiles.y,t%tiles.z); };
+  std::vector<Tile> data(count);
+
+  // Sample each tile and find the crossing edges it owns
+  #pragma omp parallel for schedule(dynamic,1)
+  for (int t=0;t<count;t++) {
+    const IV lo = tile_size*tile_at(t),
+             sizes = IV::componentwise_min(nodes-lo,stride*IV::ones()),
+             owned = IV::componentwise_min(sizes,tile_size*IV::ones());
+    Array<T> values(stride*stride*stride,uninit);
+    if (!sample(lo,sizes,values))
+      continue;
+    Array<bool> inside(values.size());
+    bool any_inside = false, any_outside = false;
+    for (int x=0;x<sizes.x;x++)
+      for (int y=0;y<sizes.y;y++)
+        for (int z=0;z<sizes.z;z++) {
+          const int i = local_index(IV(x,y,z));
+          inside[i] = values[i]<level;
+          (inside[i] ? any_inside : any_outside) = true;
+        }
+    if (!any_inside || !any_outside)
+      continue;
+    auto& tile = data[t];
+    tile.inside = inside;
+    for (int x=0;x<owned.x;x++)
+      for (int y=0;y<owned.y;y++)
+        for (int z=0;z<owned.z;z++) {
+          const IV p(x,y,z);
+          const int i = local_index(p);
+          for (int d=1;d<8;d++) {
+            const IV q = p+corner(d);
+            if (q.x==sizes.x || q.y==sizes.y || q.z==sizes.z)
+              continue;
+            const int j = local_index(q);
+            if (inside[i]!=inside[j]) {
+              const T s = (level-values[i])/(values[j]-values[i]);
+              tile.edges.append(8*i+d);
+              tile.X.append(origin+dx*(TV(lo+p)+s*TV(corner(d))));
+            }
+          }
+        }
+  }
+
+  // Number vertices tile by tile
+  int vertices = 0;
+  for (auto& tile : data) {
+    tile.offset = vertices;
+    vertices += tile.X.size();
+  }
+  Array<TV> X(vertices,uninit);
+  #pragma omp parallel for schedule(dynamic,1)
+  for (int t=0;t<count;t++)
+    X.slice(data[t].offset,data[t].offset+data[t].X.size()) = data[t].X;
+
+  // Triangulate the cells of each tile, looking up vertices on edges owned by this tile or the seven above it
+  #pragma omp parallel for schedule(dynamic,1)
+  for (int t=0;t<count;t++) {
+    auto& tile = data[t];
+    if (tile.inside.empty())
+      continue;
+    const IV ti = tile_at(t),
+             sizes = IV::componentwise_min(nodes-tile_size*ti,stride*IV::ones()),
+             owned = IV::componentwise_min(sizes,tile_size*IV::ones());
+    Array<int> ids(8*stride*stride*stride,uninit);
+    for (int o=0;o<8;o++) {
+      const IV n = ti+corner(o);
+      if (n.x==tiles.x || n.y==tiles.y || n.z==tiles.z)
+        continue;
+      const Tile& other = data[tile_index(n)];
+      for (int k=0;k<other.edges.size();k++) {
+        const IV p = local_node(other.edges[k]/8);
+        if (!(p*corner(o)).sum()) // Only the lowest layer of a tile above reaches into this one
+          ids[8*local_index(p+tile_size*corner(o))+other.edges[k]%8] = other.offset+k;
+      }
+    }
+    for (int x=0;x<min(owned.x,sizes.x-1);x++)
+      for (int y=0;y<min(owned.y,sizes.y-1);y++)
+        for (int z=0;z<min(owned.z,sizes.z-1);z++) {
+          const IV p(x,y,z);
+          int in = 0;
+          for (int c=0;c<8;c++)
+            in |= tile.inside[local_index(p+corner(c))]<<c;
+          if (!in || in==255)
+            continue;
+          const auto vertex = [&](const int u, const int w) {
+            return ids[8*local_index(p+corner(u&w))+(u^w)];
+          };
+          for (const auto& tet : tetrahedra) {
+            int m = 0;
+            for (int a=0;a<4;a++)
+              m |= (in>>tet[a]&1)<<a;
+            const int k = (m&1)+(m>>1&1)+(m>>2&1)+(m>>3&1);
+            if (!k || k==4)
+              continue;
+            // Reorder the tetrahedron by an even permutation to start with the lone inside or outside vertex, or
+            // with the two inside vertices
+            int first = 0;
+            while (!(m>>first&1)==(k!=3))
+              first++;
+            int v[4];
+            for (int a=0;a<4;a++)
+              v[a] = tet[even[first][a]];
+            if (k==2)
+              while (!(in>>v[1]&1)) { // Rotate the last three, which is an even permutation
+                const int s = v[1];
+                v[1] = v[2];
+                v[2] = v[3];
+                v[3] = s;
+              }
+            if (k==1)
+              tile.faces.append(vec(vertex(v[0],v[1]),vertex(v[0],v[2]),vertex(v[0],v[3])));
+            else if (k==3)
+              tile.faces.append(vec(vertex(v[0],v[1]),vertex(v[0],v[3]),vertex(v[0],v[2])));
+            else {
+              const int ac = vertex(v[0],v[2]), ad = vertex(v[0],v[3]),
+                        bc = vertex(v[1],v[2]), bd = vertex(v[1],v[3]);
+              tile.faces.append(vec(ac,ad,bd));
+              tile.faces.append(vec(ac,bd,bc));
+            }
+          }
+        }
+  }
+
+  // Gather faces and build the mesh
+  Array<int> face_offsets(count+1);
+  for (int t=0;t<count;t++)
+    face_offsets[t+1] = face_offsets[t]+data[t].faces.size();
+  Array<Vector<int,3>> faces(face_offsets.back(),uninit);
+  #pragma omp parallel for schedule(dynamic,1)
+  for (int t=0;t<count;t++)
+    faces.slice(face_offsets[t],face_offsets[t+1]) = data[t].faces;
+  return tuple(new_<const TriangleTopology>(faces,vertices),Field<const TV,VertexId>(X));
+}
+
+Result extract_isosurface(RawArray<const T,3> phi, const Box<TV>& box, const T level) {
+  const IV cells = phi.sizes();
+  const TV dx = box.sizes()/TV(cells);
+  return extract(cells,box.min+dx/2,dx,level,[=](const IV lo, const IV sizes, RawArray<T> values) {
+    for (int x=0;x<sizes.x;x++)
+      for (int y=0;y<sizes.y;y++)
+        for (int z=0;z<sizes.z;z++)
+          values[local_index(IV(x,y,z))] = phi(lo.x+x,lo.y+y,lo.z+z);
+    return true;
+  });
+}
+
+Result extract_isosurface(const Implicit<TV>& implicit, const Box<TV>& box, const IV cells, const T level) {
+  GEODE_ASSERT(cells.min()>0);
+  const TV dx = box.sizes()/TV(cells),
+           origin = box.min+dx/2;
+  return extract(cells,origin,dx,level,[&](const IV lo, const IV sizes, RawArray<T> values) {
+    // Skip tiles whose nodes are all farther from the level set than the center sample allows
+    const TV lo_X = origin+dx*TV(lo),
+             hi_X = origin+dx*TV(lo+sizes-IV::ones());
+    if (abs(implicit.phi((lo_X+hi_X)/2)-level)>magnitude(hi_X-lo_X)/2)
+      return false;
+    Array<TV> X(sizes.product(),uninit);
+    Array<T> phi(X.size(),uninit);
+    int n = 0;
+    for (int x=0;x<sizes.x;x++)
+      for (int y=0;y<sizes.y;y++)
+        for (int z=0;z<sizes.z;z++)
+          X[n++] = origin+dx*TV(lo+IV(x,y,z));
+    implicit.phi(X,phi);
+    n = 0;
+    for (int x=0;x<sizes.x;x++)
+      for (int y=0;y<sizes.y;y++)
+        for (int z=0;z<sizes.z;z++)
+          values[local_index(IV(x,y,z))] = phi[n++];
+    return true;
+  });
+}
+
+}
+using namespace geode;
+
+void wrap_extract_isosurface() {
+  GEODE_OVERLOADED_FUNCTION_2(Result(*)(RawArray<const T,3>,const Box<TV>&,const T),"extract_isosurface",
+                              extract_isosurface)
+  GEODE_OVERLOADED_FUNCTION_2(Result(*)(const Implicit<TV>&,const Box<TV>&,const IV,const T),
+                              "extract_implicit_isosurface",extract_isosurface)
+}
@@ -0,0 +1,29 @@
+// Triangulated level sets of 3D scalar fields
+#pragma once
+
+#include <geode/array/Array3d.h>
+#include <geode/geometry/Implicit.h>
+#include <geode/mesh/TriangleTopology.h>
+namespace geode {
+
+// Extract the level set phi = level as a TriangleTopology, with normals pointing toward increasing phi.
+//
+// Each grid cell is split into six tetrahedra around its main diagonal, and the level set of the linear
+// interpolant on each tetrahedron is one triangle or a quad.  Unlike marching cubes there are no ambiguous
+// cases, so the surface is always manifold (open where it leaves the grid).  Surface vertices lie on grid edges
+// and are numbered by the edge, so the mesh comes out welded without a pass to merge duplicates.  Tiles of the
+// grid are processed in parallel.
+
+// phi holds samples at the cell centers of a grid with phi.sizes() cells over box, such as the output of
+// grid_levelset.
+GEODE_CORE_EXPORT Tuple<Ref<const TriangleTopology>,Field<const Vector<real,3>,VertexId>>
+extract_isosurface(RawArray<const real,3> phi, const Box<Vector<real,3>>& box, const real level=0);
+
+// Sample implicit at the cell centers of a grid with the given number of cells over box.  Samples are taken
+// lazily: a tile is skipped if phi at its center shows that the level set cannot reach it, which is correct only
+// if phi is a distance function or otherwise 1-Lipschitz.
+GEODE_CORE_EXPORT Tuple<Ref<const TriangleTopology>,Field<const Vector<real,3>,VertexId>>
+extract_isosurface(const Implicit<Vector<real,3>>& implicit, const Box<Vector<real,3>>& box,
+                   const Vector<int,3> cells, const real level=0);
+
+}
@@ -18,6 +18,8 @@ class Cylinder;
 template<class TV> class BoxTree;
 template<class TV> class ParticleTree;
 template<class TV,int d> class SimplexTree;
+template<class TV,int w=4> class WideBoxTree;
+template<class TV> class DynamicBoxTree;
 
 template<class TV> class Implicit;
 
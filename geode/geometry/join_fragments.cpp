@@ -21,13 +21,14 @@ struct Match {
 
 static void closest_match_helper(const ParticleTree<Vec2>& tree, const Array<Match>& current_matches, const Vec2& point, const int point_id, int& match_id, real& sqr_distance, const int node) {
   if (!tree.is_leaf(node)) {
-    Vector<real,2> bounds(tree.boxes[2*node+1].sqr_distance_bound(point),
-                          tree.boxes[2*node+2].sqr_distance_bound(point));
+    const auto children = tree.children(node);
+    Vector<real,2> bounds(tree.boxes[children.x].sqr_distance_bound(point),
+                          tree.boxes[children.y].sqr_distance_bound(point));
     const int c = bounds.argmin();
     if (bounds[c]<sqr_distance)
-      closest_match_helper(tree,current_matches,point,point_id,match_id,sqr_distance,2*node+1+c);
+      closest_match_helper(tree,current_matches,point,point_id,match_id,sqr_distance,children[c]);
     if (bounds[1-c]<sqr_distance)
-      closest_match_helper(tree,current_matches,point,point_id,match_id,sqr_distance,2*node+2-c);
+      closest_match_helper(tree,current_matches,point,point_id,match_id,sqr_distance,children[1-c]);
   }
   else {
     for (int p : tree.prims(node)) {
@@ -8,6 +8,8 @@
 #include <geode/vector/SymmetricMatrix.h>
 #include <geode/force/StrainMeasure.h>
 #include <geode/math/Factorial.h>
+#include <geode/mesh/TriangleTopology.h>
+#include <geode/utility/parallel.h>
 namespace geode {
 
 namespace{
@@ -30,6 +32,21 @@ template<class T> inline SymmetricMatrix<T,3> inertia_tensor_from_covariance(con
     return covariance.trace()-covariance;
 }}
 
+namespace {
+template<class TV> struct VolumeMoment {
+  typename TV::Scalar volume;
+  TV moment;
+
+  VolumeMoment()
+    : volume(), moment() {}
+
+  void operator+=(const VolumeMoment& a) {
+    volume += a.volume;
+    moment += a.moment;
+  }
+};
+}
+
 template<bool filled,class TV,int s> static MassProperties<TV>
 helper(RawArray<const Vector<int,s> > elements, RawArray<const TV> X) {
   typedef typename TV::Scalar T;
@@ -38,29 +55,30 @@ helper(RawArray<const Vector<int,s> > elements, RawArray<const TV> X) {
 
   // Compute center and volume
   const TV base = X[elements(0)[0]];
-  T scaled_volume = 0; // (d+filled)!*volume
-  TV scaled_center_times_volume; // (d+1+filled)!*center*volume
-  for(int t=0;t<elements.size();t++){
+  // volume: (d+filled)!*volume, moment: (d+1+filled)!*center*volume
+  const auto scaled = parallel_reduce<VolumeMoment<TV>>(elements.size(),[&](const int t){
     const Vector<int,d+1>& nodes = elements[t];
     Matrix<T,TV::m,d+1> DX;
     for(int i=0;i<nodes.m;i++) DX.set_column(i,X[nodes[i]]-base);
-    T scaled_element_volume = filled?DX.parallelepiped_measure():StrainMeasure<T,d>::Ds(X,nodes).parallelepiped_measure();
-    scaled_volume += scaled_element_volume;
-    scaled_center_times_volume += scaled_element_volume*DX.column_sum();}
-  props.volume = (T)1/Factorial<d+filled>::value*scaled_volume;
+    VolumeMoment<TV> vm;
+    vm.volume = filled?DX.parallelepiped_measure():StrainMeasure<T,d>::Ds(X,nodes).parallelepiped_measure();
+    vm.moment = vm.volume*DX.column_sum();
+    return vm;});
+  props.volume = (T)1/Factorial<d+filled>::value*scaled.volume;
   if (!props.volume)
     GEODE_FATAL_ERROR("zero volume");
-  props.center = base+(T)1/(d+1+filled)/scaled_volume*scaled_center_times_volume;
+  props.center = base+(T)1/(d+1+filled)/scaled.volume*scaled.moment;
 
   // Compute inertia tensor: see http://number-none.com/blow/inertia for explanation of filled case
-  // During loop, props.inertia_tensor contains (d+2+filled)!*covariance (or trace(covariance) in 2d)
-  for(int t=0;t<elements.size();t++){
+  // The reduction computes (d+2+filled)!*covariance (or trace(covariance) in 2d)
+  typedef typename InertiaTensorPolicy<TV>::WorldSpace Inertia;
+  const auto scaled_covariance = parallel_reduce<Inertia>(elements.size(),[&](const int t){
       const Vector<int,d+1>& nodes = elements[t];
       Matrix<T,TV::m,d+1> DX;
       for(int i=0;i<nodes.m;i++) DX.set_column(i,X[nodes[i]]-props.center);
       T scaled_element_volume = filled?DX.parallelepiped_measure():StrainMeasure<T,d>::Ds(X,nodes).parallelepiped_measure();
-      props.inertia_tensor += scaled_element_covariance(scaled_element_volume,DX);}
-  props.inertia_tensor = inertia_tensor_from_covariance((T)1/Factorial<d+2+filled>::value*props.inertia_tensor);
+      return Inertia(scaled_element_covariance(scaled_element_volume,DX));});
+  props.inertia_tensor = inertia_tensor_from_covariance((T)1/Factorial<d+2+filled>::value*scaled_covariance);
   return props;
 }
 
@@ -73,6 +91,10 @@ mass_properties(RawArray<const Vector<int,s> > elements, RawArray<const TV> X, b
   return filled?helper<true>(elements,X):helper<false>(elements,X);
 }
 
+MassProperties<Vector<real,3>> mass_properties(const TriangleTopology& mesh, RawField<const Vector<real,3>,VertexId> X, bool filled) {
+  return mass_properties(RawArray<const Vector<int,3>>(mesh.elements()),X.flat,filled);
+}
+
 template<class TV,int s> Frame<TV> principal_frame(RawArray<const Vector<int,s> > elements, RawArray<const TV> X, bool filled) {
   typedef typename TV::Scalar T;
   MassProperties<TV> props = mass_properties(elements,X,filled);
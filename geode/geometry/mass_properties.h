@@ -4,6 +4,8 @@
 #pragma once
 
 #include <geode/array/forward.h>
+#include <geode/mesh/forward.h>
+#include <geode/mesh/ids.h>
 #include <geode/utility/config.h>
 #include <geode/vector/forward.h>
 namespace geode {
@@ -22,7 +24,9 @@ template<class TV> struct MassProperties {
     :volume(),center(),inertia_tensor() {}
 };
 
+// Sums are reduced in parallel in a fixed order, so results do not depend on the number of threads
 template<class TV,int s> GEODE_CORE_EXPORT MassProperties<TV> mass_properties(RawArray<const Vector<int,s> > elements, RawArray<const TV> X, bool filled);
+GEODE_CORE_EXPORT MassProperties<Vector<real,3>> mass_properties(const TriangleTopology& mesh, RawField<const Vector<real,3>,VertexId> X, bool filled);
 template<class TV,int s> GEODE_CORE_EXPORT Frame<TV> principal_frame(RawArray<const Vector<int,s> > elements, RawArray<const TV> X, bool filled);
 
 }
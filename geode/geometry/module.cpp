@@ -8,16 +8,26 @@ void wrap_geometry() {
   GEODE_WRAP(arc_fitting)
   GEODE_WRAP(box_vector)
   GEODE_WRAP(polygon)
+  GEODE_WRAP(polygon_outlines)
+  GEODE_WRAP(winding_grid)
   GEODE_WRAP(implicit)
   GEODE_WRAP(frame_implicit)
   GEODE_WRAP(analytic_implicit)
+  GEODE_WRAP(sparse_implicit)
   GEODE_WRAP(box_tree)
+  GEODE_WRAP(wide_box_tree)
+  GEODE_WRAP(flat_triangle_tree)
+  GEODE_WRAP(dynamic_box_tree)
   GEODE_WRAP(particle_tree)
   GEODE_WRAP(simplex_tree)
+  GEODE_WRAP(tree_io)
+  GEODE_WRAP(spatial_keys)
   GEODE_WRAP(platonic)
   GEODE_WRAP(thick_shell)
   GEODE_WRAP(bezier)
   GEODE_WRAP(segment)
   GEODE_WRAP(surface_levelset)
+  GEODE_WRAP(extract_isosurface)
   GEODE_WRAP(offset_mesh)
+  GEODE_WRAP(slice_mesh)
 }
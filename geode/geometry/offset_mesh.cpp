@@ -168,11 +168,19 @@ static Tuple<Array<Vector<int,3>>,Array<TV>> rough_offset_shell_helper(const Tri
   // Remove nearly degenerate faces.
   {
     const T threshold = 1e-2*offset;
-    for (const auto f : mesh->faces()) {
-      const auto v = mesh->vertices(f);
-      if (Triangle<TV>::minimum_altitude(X[v.x],X[v.y],X[v.z]) <= threshold)
-        mesh->erase(f);
+    const int nf = mesh->allocated_faces();
+    Array<bool> degenerate(nf);
+    #pragma omp parallel for
+    for (int i=0;i<nf;i++) {
+      const FaceId f(i);
+      if (!mesh->erased(f)) {
+        const auto v = mesh->vertices(f);
+        degenerate[i] = Triangle<TV>::minimum_altitude(X[v.x],X[v.y],X[v.z]) <= threshold;
+      }
     }
+    for (const int i : range(nf))
+      if (degenerate[i])
+        mesh->erase(FaceId(i));
     mesh->split_nonmanifold_vertices();
   }
 
@@ -358,12 +366,20 @@ static Tuple<Array<Vector<int,3>>,Array<TV>> rough_offset_shell_helper(const Tri
   }
 
   // Create vertices.  Vertices above and below original vertex v are 2*v and 2*v+1.
+  // Vertices and faces are contiguous, so the bulk of the output can be written in parallel.
+  const int nv = mesh->n_vertices(),
+            nf = mesh->n_faces();
+  GEODE_ASSERT(nv==mesh->allocated_vertices() && nf==mesh->allocated_faces());
   Array<TV> new_X;
-  new_X.preallocate(2*mesh->n_vertices()+mesh->n_boundary_edges());
-  for (const auto v : mesh->vertices()) {
+  new_X.preallocate(2*nv+mesh->n_boundary_edges());
+  new_X.resize(2*nv,uninit);
+  #pragma omp parallel for
+  for (int i=0;i<nv;i++) {
+    const VertexId v(i);
     const auto x = X[v],
                dx = offset*vertex_normals[v];
-    new_X.extend(vec(x+dx,x-dx));
+    new_X[2*i  ] = x+dx;
+    new_X[2*i+1] = x-dx;
   }
   Array<Vector<int,2>> boundary_v(mesh->n_boundary_edges(),uninit);
   for (const auto e : mesh->boundary_edges()) {
@@ -375,11 +391,12 @@ static Tuple<Array<Vector<int,3>>,Array<TV>> rough_offset_shell_helper(const Tri
   }
 
   // Triangulate everything
-  Array<Vector<int,3>> new_soup;
-  for (const auto f : mesh->faces()) {
-    const auto v = mesh->vertices(f);
-    new_soup.extend(vec(vec(2*v.x.id  ,2*v.y.id  ,2*v.z.id  ),
-                        vec(2*v.x.id+1,2*v.z.id+1,2*v.y.id+1)));
+  Array<Vector<int,3>> new_soup(2*nf,uninit);
+  #pragma omp parallel for
+  for (int i=0;i<nf;i++) {
+    const auto v = mesh->vertices(FaceId(i));
+    new_soup[2*i  ] = vec(2*v.x.id  ,2*v.y.id  ,2*v.z.id  );
+    new_soup[2*i+1] = vec(2*v.x.id+1,2*v.z.id+1,2*v.y.id+1);
   }
   for (const auto e : mesh->boundary_edges()) {
     const auto v0 = mesh->src(e),
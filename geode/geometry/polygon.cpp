@@ -17,8 +17,10 @@
 #include <geode/geometry/RayIntersection.h>
 #include <geode/array/RawArray.h>
 #include <geode/array/sort.h>
+#include <geode/utility/parallel.h>
 namespace geode {
 
+using std::vector;
 typedef real T;
 
 bool polygon_outlines_intersect(RawArray<const Vec2> p1, RawArray<const Vec2> p2, Ptr<SimplexTree<Vec2,1>> p2_tree) {
@@ -27,15 +29,27 @@ bool polygon_outlines_intersect(RawArray<const Vec2> p1, RawArray<const Vec2> p2
     p2_tree = new_<SimplexTree<Vec2,1>>(mesh.x, mesh.y, 4);
   }
 
-  // walk p1, check for each segment's intersection
-  for (int i = 0, j = p1.size()-1; i < (int)p1.size(); j = i++) {
+  // walk p1 in parallel, check for each segment's intersection, and stop early once any is found
+  const int n = p1.size();
+  const auto& tree = *p2_tree;
+  bool found = false;
+  #pragma omp parallel for schedule(dynamic,64)
+  for (int i = 0; i < n; i++) {
+    bool done;
+    #pragma omp atomic read
+    done = found;
+    if (done)
+      continue;
+    const int j = i ? i-1 : n-1;
     Vec2 dir = p1[i] - p1[j];
     RayIntersection<Vec2> ray(p1[j], dir);
     ray.t_max = dir.magnitude();
-    if (p2_tree->intersection(ray, 1e-10))
-      return true;
+    if (tree.intersection(ray, 1e-10)) {
+      #pragma omp atomic write
+      found = true;
+    }
   }
-  return false;
+  return found;
 }
 
 Array<Vec2> polygon_from_index_list(RawArray<const Vec2> positions, RawArray<const int> indices) {
@@ -489,6 +503,62 @@ Tuple<Array<Vec2>,Array<int>> offset_polygon_with_correspondence(RawArray<const
   return tuple(new_opoly,new_corr);
 }
 
+// Drop offset points closer than |offset| to poly.  These lie where distant parts of the offset curve cross each other,
+// which the local cleanup in offset_polygon_with_correspondence doesn't see.
+static Tuple<Array<Vec2>,Array<int>> cull_offset_self_intersections(RawArray<const Vec2> poly, const T offset,
+                                                                    const Tuple<Array<Vec2>,Array<int>>& offset_poly) {
+  const auto& X = offset_poly.x;
+  const auto& correspondence = offset_poly.y;
+  if (!X.size())
+    return offset_poly;
+  const auto mesh = to_segment_soup(make_nested(poly.copy()),false);
+  const auto tree = new_<SimplexTree<Vec2,1>>(mesh.x,mesh.y,4);
+  // Points exactly at distance |offset| are correct, so allow for rounding
+  const auto closest = tree->closest_points(X,(1-1e-8)*abs(offset));
+  Array<Vec2> culled;
+  Array<int> culled_correspondence;
+  culled.preallocate(X.size());
+  culled_correspondence.preallocate(X.size());
+  for (int i=0;i<X.size();i++)
+    if (closest.y[i]<0) {
+      culled.append_assuming_enough_space(X[i]);
+      culled_correspondence.append_assuming_enough_space(correspondence[i]);
+    }
+  return tuple(culled,culled_correspondence);
+}
+
+Tuple<Nested<Vec2>,Nested<int>> offset_polygons_with_correspondence(Nested<const Vec2> polys, const T offset,
+                                                                    const T maxangle_deg, const T minangle_deg) {
+  const int n = polys.size();
+  vector<Tuple<Array<Vec2>,Array<int>>> results(n);
+  parallel_for(n,[&](const int p) {
+    results[p] = cull_offset_self_intersections(polys[p],offset,
+      offset_polygon_with_correspondence(polys[p],offset,maxangle_deg,minangle_deg));
+  },16);
+  Array<int> lengths(n,uninit);
+  for (int p=0;p<n;p++)
+    lengths[p] = results[p].x.size();
+  const Nested<Vec2> offset_polys(lengths,uninit);
+  const Nested<int> correspondence(lengths,uninit);
+  parallel_for(n,[&](const int p) {
+    offset_polys[p] = results[p].x;
+    correspondence[p] = results[p].y;
+  },64);
+  return tuple(offset_polys,correspondence);
+}
+
+Nested<Vec2> resample_polygons(Nested<const Vec2> polys, const T maximum_edge_length) {
+  const int n = polys.size();
+  vector<Array<Vec2>> results(n);
+  parallel_for(n,[&](const int p) { results[p] = resample_polygon(polys[p],maximum_edge_length); },64);
+  Array<int> lengths(n,uninit);
+  for (int p=0;p<n;p++)
+    lengths[p] = results[p].size();
+  const Nested<Vec2> fine(lengths,uninit);
+  parallel_for(n,[&](const int p) { fine[p] = results[p]; },64);
+  return fine;
+}
+
 Ref<SegmentSoup> nested_array_offsets_to_segment_soup(RawArray<const int> offsets, bool open) {
   GEODE_ASSERT(offsets.size() && !offsets[0]); // Not a complete check, but may catch a few bugs
 
@@ -516,6 +586,9 @@ Ref<SegmentSoup> nested_array_offsets_to_segment_soup(RawArray<const int> offset
 
 Nested<const Vec2> polygons_from_python(PyObject* object) {
 #ifdef GEODE_PYTHON
+  // Nested arrays share storage, so skip the failed numpy conversion
+  if (is_nested_array(object))
+    return from_python<Nested<const Vec2>>(object);
   try {
     const auto polys = from_python<NdArray<const Vec2>>(object);
     if (!polys.rank() || polys.rank()>2)
@@ -615,4 +688,6 @@ void wrap_polygon() {
   GEODE_FUNCTION(resample_polygon)
   GEODE_FUNCTION(canonicalize_polygons)
   GEODE_FUNCTION(offset_polygon_with_correspondence)
+  GEODE_FUNCTION(offset_polygons_with_correspondence)
+  GEODE_FUNCTION(resample_polygons)
 }
@@ -39,6 +39,14 @@ GEODE_CORE_EXPORT Vec2 point_inside_polygon_component(RawArray<const Vec2> poly,
 // Warning: Not robust
 GEODE_CORE_EXPORT Tuple<Array<Vec2>,Array<int>> offset_polygon_with_correspondence(RawArray<const Vec2> poly, real offset, real maxangle_deg = 20., real minangle_deg = 10.);
 
+// offset_polygon_with_correspondence for many polygons in parallel.  Offset points closer than |offset| to their own
+// polygon, where distant parts of the offset curve cross, are also dropped.  Correspondences index into each polygon.
+// Warning: Not robust
+GEODE_CORE_EXPORT Tuple<Nested<Vec2>,Nested<int>> offset_polygons_with_correspondence(Nested<const Vec2> polys, real offset, real maxangle_deg = 20., real minangle_deg = 10.);
+
+// resample_polygon for many polygons in parallel
+GEODE_CORE_EXPORT Nested<Vec2> resample_polygons(Nested<const Vec2> polys, double maximum_edge_length);
+
 // Turn an array of polygons into a SegmentSoup.
 GEODE_CORE_EXPORT Ref<SegmentSoup> nested_array_offsets_to_segment_soup(RawArray<const int> offsets, bool open);
 template<class TV> static inline Tuple<Ref<SegmentSoup>,Array<TV>> to_segment_soup(const Nested<TV>& polys, bool open) {
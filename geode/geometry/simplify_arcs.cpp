@@ -1,5 +1,6 @@
 #include "simplify_arcs.h"
 
+#include <geode/array/parallel_nested.h>
 #include <geode/array/sort.h>
 #include <geode/exact/circle_csg.h>
 #include <geode/geometry/arc_fitting.h>
@@ -206,11 +207,10 @@ Array<CircleArc> simplify_arcs(const RawArray<const CircleArc> input, const real
 }
 
 Nested<CircleArc> simplify_arcs(const Nested<const CircleArc> input, const real max_point_movement, const bool is_closed) {
-  Nested<CircleArc, false> result;
-  for(const auto& polyarc : input) {
-    result.append(simplify_arcs(polyarc, max_point_movement, is_closed));
-  }
-  return result.freeze();
+  // Curves are independent, so simplify them in parallel
+  return parallel_nested(input.size(), [&](const int i) {
+    return simplify_arcs(input[i], max_point_movement, is_closed);
+  });
 }
 
 } // namespace geode
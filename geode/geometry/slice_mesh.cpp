@@ -0,0 +1,115 @@
+// Slice triangle meshes into polygon layers
+
+#include <geode/geometry/slice_mesh.h>
+#include <geode/mesh/TriangleSoup.h>
+#include <geode/python/stl.h>
+#include <geode/python/wrap.h>
+#include <geode/utility/parallel.h>
+#include <algorithm>
+namespace geode {
+
+typedef real T;
+
+// The point where the plane z = level crosses edge (a,b).  Faces sharing the edge compute it in the same order,
+// so they agree exactly.
+static inline Vec2 edge_point(RawArray<const Vec3> X, int a, int b, const T level) {
+  if (a>b)
+    swap(a,b);
+  const T t = (level-X[a].z)/(X[b].z-X[a].z);
+  return Vec2(X[a].x+t*(X[b].x-X[a].x),X[a].y+t*(X[b].y-X[a].y));
+}
+
+namespace {
+struct Slicer {
+  RawArray<const Vec3> X;
+  RawArray<const Vector<int,3>> faces;
+  RawArray<const Vector<int,3>> adjacent;
+
+  // A face crossing the plane passes from above to below it across edge start, and back up across edge end.
+  // Edge i of a face runs from vertex i to vertex i+1.
+  Vector<int,2> crossing(const int f, const T level) const {
+    const auto v = faces[f];
+    const Vector<bool,3> above(X[v.x].z>=level,X[v.y].z>=level,X[v.z].z>=level);
+    Vector<int,2> edges;
+    for (const int i : range(3))
+      if (above[i]!=above[(i+1)%3])
+        edges[above[(i+1)%3]] = i;
+    return edges;
+  }
+
+  // Chain the faces crossing one layer into contours.  visited must not contain layer on entry.
+  Nested<Vec2> layer(RawArray<const int> layer_faces, const int layer, const T level, RawArray<int> visited) const {
+    Nested<Vec2,false> contours;
+    // Trace open chains from their first face, then closed loops from anywhere
+    for (const bool open : {true,false})
+      for (int f : layer_faces) {
+        if (visited[f]==layer || (open && adjacent[f][crossing(f,level).x]>=0))
+          continue;
+        contours.append_empty();
+        for (;;) {
+          visited[f] = layer;
+          const auto e = crossing(f,level);
+          const auto v = faces[f];
+          contours.append_to_back(edge_point(X,v[e.x],v[(e.x+1)%3],level));
+          const int g = adjacent[f][e.y];
+          if (g<0)
+            contours.append_to_back(edge_point(X,v[e.y],v[(e.y+1)%3],level));
+          if (g<0 || visited[g]==layer)
+            break;
+          f = g;
+        }
+      }
+    return contours.freeze();
+  }
+};
+}
+
+vector<Nested<Vec2>> slice_mesh(const TriangleSoup& mesh, RawArray<const Vec3> X, RawArray<const T> levels) {
+  GEODE_ASSERT(mesh.nodes()<=X.size());
+  for (const int k : range(1,max(1,levels.size())))
+    GEODE_ASSERT(levels[k-1]<=levels[k],"slice_mesh: levels must be sorted");
+  const auto faces = mesh.elements.raw();
+  const int layers = levels.size();
+
+  // Face f crosses layers [lo,hi), those with zmin < level <= zmax
+  Array<Vector<int,2>> span(faces.size(),uninit);
+  Array<int> counts(layers+1);
+  for (const int f : range(faces.size())) {
+    const auto v = faces[f];
+    const T zmin = min(X[v.x].z,X[v.y].z,X[v.z].z),
+            zmax = max(X[v.x].z,X[v.y].z,X[v.z].z);
+    auto& s = span[f];
+    s.x = int(std::upper_bound(levels.begin(),levels.end(),zmin)-levels.begin());
+    s.y = int(std::upper_bound(levels.begin()+s.x,levels.end(),zmax)-levels.begin());
+    counts[s.x]++;
+    counts[s.y]--;
+  }
+
+  // Bucket faces by layer in a single pass
+  for (const int k : range(1,layers+1))
+    counts[k] += counts[k-1];
+  Nested<int> layer_faces(counts.slice(0,layers),uninit);
+  for (int f=faces.size()-1;f>=0;f--)
+    for (const int k : range(span[f].x,span[f].y))
+      layer_faces(k,--counts[k]) = f;
+
+  // Chain ranges of layers in parallel.  Each range marks visited faces with the layer index, so one scratch array
+  // serves all of its layers.
+  const Slicer slicer = {X,faces,mesh.adjacent_elements()};
+  vector<Nested<Vec2>> result(layers);
+  const int chunks = min(layers,8*thread_count());
+  parallel_for(chunks,[&](const int c) {
+    Array<int> visited(faces.size(),uninit);
+    visited.fill(-1);
+    for (const int k : partition_loop(layers,chunks,c))
+      result[k] = slicer.layer(layer_faces[k],k,levels[k],visited);
+  });
+  return result;
+}
+
+}
+using namespace geode;
+
+void wrap_slice_mesh() {
+  GEODE_FUNCTION(slice_mesh)
+}
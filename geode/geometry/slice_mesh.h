@@ -0,0 +1,23 @@
+// Slice triangle meshes into polygon layers
+#pragma once
+
+#include <geode/array/Nested.h>
+#include <geode/mesh/forward.h>
+#include <geode/vector/Vector.h>
+#include <vector>
+namespace geode {
+
+using std::vector;
+
+// Slice a consistently oriented mesh by the planes z = levels[k], and return the contours of each layer projected to
+// xy.  levels must be sorted.  A vertex exactly on a plane counts as above it, so every face crossing a plane produces
+// exactly one segment, and segments are chained through their shared edges.  For a closed mesh the contours are closed
+// and oriented for polygon_csg: counterclockwise around material seen from +z.  Where the mesh has boundary a contour
+// may be open, in which case its last point is the end of its last segment.
+//
+// Faces are bucketed by the range of layers they cross, so all layers are found in one pass over the mesh, and the
+// layers are then chained independently in parallel.
+GEODE_CORE_EXPORT vector<Nested<Vec2>>
+slice_mesh(const TriangleSoup& mesh, RawArray<const Vec3> X, RawArray<const real> levels);
+
+}
@@ -0,0 +1,60 @@
+// Morton and Hilbert keys for points in a box
+
+#include <geode/geometry/spatial_keys.h>
+#include <geode/array/sort.h>
+#include <geode/math/clamp.h>
+#include <geode/math/morton.h>
+#include <geode/python/wrap.h>
+#include <geode/utility/parallel.h>
+namespace geode {
+
+template<class TV,class Encode> static Array<uint64_t> keys(RawArray<const TV> X, const Box<TV>& box, const Encode& encode) {
+  typedef typename TV::Scalar T;
+  enum {d = TV::m};
+  const T cells = T((uint64_t(1)<<(d==2 ? 32 : 21))-1);
+  TV scale;
+  for (int a=0;a<d;a++)
+    scale[a] = box.max[a]>box.min[a] ? cells/(box.max[a]-box.min[a]) : 0;
+  Array<uint64_t> codes(X.size(),uninit);
+  parallel_for(X.size(),[&](const int i) {
+    Vector<uint32_t,d> q;
+    for (int a=0;a<d;a++)
+      q[a] = uint32_t(clamp((X[i][a]-box.min[a])*scale[a],T(0),cells));
+    codes[i] = encode(q);
+  },4096);
+  return codes;
+}
+
+template<class TV> Array<uint64_t> morton_keys(RawArray<const TV> X, const Box<TV>& box) {
+  return keys(X,box,[](const Vector<uint32_t,TV::m> q) { return morton(q); });
+}
+
+template<class TV> Array<uint64_t> hilbert_keys(RawArray<const TV> X, const Box<TV>& box) {
+  return keys(X,box,[](const Vector<uint32_t,TV::m> q) { return hilbert(q); });
+}
+
+template<class TV> Array<int> morton_order(RawArray<const TV> X) {
+  return radix_sort_order(morton_keys(X,bounding_box(X)));
+}
+
+template<class TV> Array<int> hilbert_order(RawArray<const TV> X) {
+  return radix_sort_order(hilbert_keys(X,bounding_box(X)));
+}
+
+#define INSTANTIATE(d) \
+  template GEODE_CORE_EXPORT Array<uint64_t> morton_keys(RawArray<const Vector<real,d>>,const Box<Vector<real,d>>&); \
+  template GEODE_CORE_EXPORT Array<uint64_t> hilbert_keys(RawArray<const Vector<real,d>>,const Box<Vector<real,d>>&); \
+  template GEODE_CORE_EXPORT Array<int> morton_order(RawArray<const Vector<real,d>>); \
+  template GEODE_CORE_EXPORT Array<int> hilbert_order(RawArray<const Vector<real,d>>);
+INSTANTIATE(2)
+INSTANTIATE(3)
+
+}
+using namespace geode;
+
+void wrap_spatial_keys() {
+  GEODE_FUNCTION_2(morton_order_2d,morton_order<Vector<real,2>>)
+  GEODE_FUNCTION_2(morton_order_3d,morton_order<Vector<real,3>>)
+  GEODE_FUNCTION_2(hilbert_order_2d,hilbert_order<Vector<real,2>>)
+  GEODE_FUNCTION_2(hilbert_order_3d,hilbert_order<Vector<real,3>>)
+}
@@ -0,0 +1,17 @@
+// Morton and Hilbert keys for points in a box
+#pragma once
+
+#include <geode/geometry/Box.h>
+namespace geode {
+
+// Quantize each point to the finest grid over box that fits in 64 bit codes (32 bits per axis in 2D, 21 in 3D), and
+// return the Morton or Hilbert code of each cell.  Points outside the box are clamped to it.  Quantization and encoding
+// run in parallel.  See math/morton.h for the codes themselves.
+template<class TV> GEODE_CORE_EXPORT Array<uint64_t> morton_keys(RawArray<const TV> X, const Box<TV>& box);
+template<class TV> GEODE_CORE_EXPORT Array<uint64_t> hilbert_keys(RawArray<const TV> X, const Box<TV>& box);
+
+// The stable order of points along the Morton or Hilbert curve over their bounding box
+template<class TV> GEODE_CORE_EXPORT Array<int> morton_order(RawArray<const TV> X);
+template<class TV> GEODE_CORE_EXPORT Array<int> hilbert_order(RawArray<const TV> X);
+
+}
@@ -1,5 +1,5 @@
 //#####################################################################
-// Evaluate signed distances between a point cloud and a mesh
+// Evaluate signed distances between a point cloud or grid and a mesh
 //#####################################################################
 #include <geode/geometry/surface_levelset.h>
 #include <geode/geometry/ParticleTree.h>
@@ -8,8 +8,11 @@
 #include <geode/geometry/Triangle3d.h>
 #include <geode/array/ProjectedArray.h>
 #include <geode/array/ConstantMap.h>
+#include <geode/array/Array3d.h>
+#include <geode/array/Nested.h>
 #include <geode/python/wrap.h>
 #include <geode/utility/Log.h>
+#include <geode/utility/openmp.h>
 #include <limits>
 namespace geode {
 
@@ -48,16 +51,19 @@ template<int d> struct Helper {
       const auto particle_prims = particles.prims(pn);
       const auto surface_prims = surface.prims(sn);
       for (const int p : particle_prims) {
-        if (info[p].phi > lower_bound_sqr_phi(particles.X[p],sbox))
-          for (const int t : surface_prims) {
-            if (profile)
-              evaluation_count++;
+        if (info[p].phi > lower_bound_sqr_phi(particles.X[p],sbox)) {
+          if (profile)
+            evaluation_count += surface_prims.size();
+          T sqr_phi = info[p].phi;
+          const int t = surface.closest_leaf_simplex(sn,particles.X[p],sqr_phi);
+          if (t >= 0) {
             const auto close = surface.simplices[t].closest_point(particles.X[p]);
             const TV delta = particles.X[p] - close.x;
             const T sd = sqr_magnitude(delta);
             if (info[p].phi > sd)
               info[p] = CloseInfo<d>({sd,delta,t,close.y});
           }
+        }
         sqr_phi_node[pn] = max(sqr_phi_node[pn],info[p].phi);
       }
     } else if (pleaf || (!sleaf && pbox.sizes().max()<=sbox.sizes().max())) {
@@ -112,8 +118,26 @@ template<int d> void surface_levelset(const ParticleTree<TV>& particles, const S
   if (profile)
     evaluation_count = 0;
   const auto sqr_phi_node = constant_map(particles.nodes(),sqr_max_distance).copy();
-  if (particles.X.size() && surface.simplices.size())
-    Helper<d>({particles,surface,sqr_phi_node,info}).eval(0,0);
+  if (particles.X.size() && surface.simplices.size()) {
+    // Split the particle tree breadth first into many more subtrees than threads, and traverse each subtree against
+    // the whole surface in parallel.  Subtrees touch disjoint nodes and particles, so no synchronization is needed.
+    const Helper<d> helper({particles,surface,sqr_phi_node,info});
+    Array<int> roots;
+    roots.append(0);
+    const int count = 64*omp_get_max_threads();
+    for (int r=0;r<roots.size() && roots.size()<count;) {
+      if (particles.is_leaf(roots[r]))
+        r++;
+      else {
+        const auto c = particles.children(roots[r]);
+        roots[r] = c.x;
+        roots.append(c.y);
+      }
+    }
+    #pragma omp parallel for schedule(dynamic,1)
+    for (int r=0;r<roots.size();r++)
+      helper.eval(roots[r],0);
+  }
   if (profile) {
     long slow_count = (long)particles.X.size()*surface.simplices.size();
     cout << "particles = "<<particles.X.size()<<", per particle "<<evaluation_count/particles.X.size()<<endl;
@@ -122,15 +146,18 @@ template<int d> void surface_levelset(const ParticleTree<TV>& particles, const S
   }
   const T epsilon = sqrt(numeric_limits<T>::epsilon())*max(particles.bounding_box().sizes().max(),
                                                              surface.bounding_box().sizes().max());
-  if (d<TV::m-1 || !compute_signs)
-    for (auto& I : info) {
+  if (d<TV::m-1 || !compute_signs) {
+    #pragma omp parallel for
+    for (int i=0;i<info.size();i++) {
+      auto& I = info[i];
       I.phi = sqrt(I.phi);
       I.normal = ((I.simplex) < 0)   ? TV()  // Parenthesis around I.simplex avoid parse error in MinGW-W64 version 4.9.2 of g++
                : (I.phi > epsilon) ? I.normal / I.phi
                                    : normal_flip(surface.simplices[I.simplex],I.normal);
     }
-  else // compute_signs
-    for (const int i : range(info.size())) {
+  } else { // compute_signs
+    #pragma omp parallel for schedule(dynamic,64)
+    for (int i=0;i<info.size();i++) {
       auto& I = info[i];
       I.phi = sqrt(I.phi);
       if ((I.simplex) < 0) // Parentheses needed for parse error in gcc 4.9
@@ -150,6 +177,7 @@ template<int d> void surface_levelset(const ParticleTree<TV>& particles, const S
         }
       }
     }
+  }
 }
 
 template<int d> Tuple<Array<T>,Array<TV>,Array<int>,Array<typename SimplexTree<TV,d>::Weights>>
@@ -170,6 +198,151 @@ surface_levelset(const ParticleTree<TV>& particles, const SimplexTree<TV,d>& sur
 INSTANTIATE(1)
 INSTANTIATE(2)
 
+// Range of cell centers box.min[a]+(i+1/2)*dx[a] in [lo,hi] along axis a, clamped to [0,n)
+static inline Vector<int,2> cell_range(const T lo, const T hi, const T min, const T dx, const int n) {
+  return vec(int(clamp(ceil((lo-min)/dx-.5),T(0),T(n))),
+             int(clamp(floor((hi-min)/dx-.5),T(-1),T(n-1))));
+}
+
+// Godunov update for |grad u| = 1 given the smallest neighbor value a[i] along each axis, each with spacing h[i]
+static inline T eikonal_update(Vector<T,3> a, Vector<T,3> h) {
+  // Sort axes by neighbor value, then add axes until the solution no longer exceeds the next neighbor
+  for (int i=0;i<3;i++)
+    for (int j=i+1;j<3;j++)
+      if (a[j] < a[i]) {
+        std::swap(a[i],a[j]);
+        std::swap(h[i],h[j]);
+      }
+  T u = a[0]+h[0];
+  T A = 0, B = 0, C = -1;
+  for (int i=0;i<3 && u>a[i];i++) {
+    const T w = 1/sqr(h[i]);
+    A += w;
+    B += w*a[i];
+    C += w*sqr(a[i]);
+    if (i)
+      u = (B+sqrt(max(T(0),sqr(B)-A*C)))/A;
+  }
+  return u;
+}
+
+Array<T,3> grid_levelset(const SimplexTree<TV,2>& surface, const Box<TV>& box, const Vector<int,3> cells, T band) {
+  GEODE_ASSERT(cells.min()>0 && !box.empty());
+  const TV dx = box.sizes()/TV(cells);
+  band = max(band,magnitude(dx)); // The band must separate inside from outside for sign propagation
+  const auto& tris = surface.simplices;
+  const auto center = [&](const int i, const int j, const int k) {
+    return box.min+dx*TV(i+.5,j+.5,k+.5);
+  };
+
+  // Bucket triangles by the x slices of cells within band of them
+  Array<Vector<int,2>> slices(tris.size(),uninit);
+  Array<int> counts(cells.x);
+  for (const int t : range(tris.size())) {
+    const auto b = tris[t].bounding_box().thickened(band);
+    slices[t] = cell_range(b.min.x,b.max.x,box.min.x,dx.x,cells.x);
+    for (int i=slices[t].x;i<=slices[t].y;i++)
+      counts[i]++;
+  }
+  Nested<int> slice_tris(counts,uninit);
+  for (const int t : range(tris.size()))
+    for (int i=slices[t].x;i<=slices[t].y;i++)
+      slice_tris.flat[slice_tris.offsets[i]+--counts[i]] = t;
+
+  // Exact signed distances within the band, one slice at a time.  Cells outside the band are left at infinity.
+  Array<T,3> phi(cells,uninit);
+  Array<bool,3> fixed(cells);
+  const T sqr_band = sqr(band);
+  const T epsilon = sqrt(numeric_limits<T>::epsilon())*max(box.sizes().max(),surface.bounding_box().sizes().max());
+  #pragma omp parallel for schedule(dynamic,1)
+  for (int i=0;i<cells.x;i++) {
+    const auto sqr_phi = phi[i];
+    sqr_phi.flat.fill(inf);
+    Array<int,2> closest(cells.y,cells.z,uninit);
+    closest.flat.fill(-1);
+    for (const int t : slice_tris[i]) {
+      const auto b = tris[t].bounding_box().thickened(band);
+      const auto js = cell_range(b.min.y,b.max.y,box.min.y,dx.y,cells.y),
+                 ks = cell_range(b.min.z,b.max.z,box.min.z,dx.z,cells.z);
+      for (int j=js.x;j<=js.y;j++)
+        for (int k=ks.x;k<=ks.y;k++) {
+          const T sd = sqr_magnitude(center(i,j,k)-tris[t].closest_point(center(i,j,k)).x);
+          if (sd<=sqr_band && sd<sqr_phi(j,k)) {
+            sqr_phi(j,k) = sd;
+            closest(j,k) = t;
+          }
+        }
+    }
+    for (int j=0;j<cells.y;j++)
+      for (int k=0;k<cells.z;k++) {
+        const int t = closest(j,k);
+        if (t >= 0) {
+          fixed(i,j,k) = true;
+          auto& p = sqr_phi(j,k);
+          p = sqrt(p);
+          try {
+            const TV X = center(i,j,k);
+            if (surface.inside_given_closest_point(X,t,tris[t].closest_point(X).y))
+              p = -p;
+          } catch (const ArithmeticError&) { // Inside test failed, assume zero
+            if (p <= epsilon)
+              p = 0;
+          }
+        }
+      }
+  }
+
+  // Fill in the rest by fast sweeping, with each far cell taking its sign from its smallest upwind neighbor.  Since
+  // straight characteristics cross each octant of directions in one sweep, 2^3 sweeps suffice for distance functions.
+  // Within a sweep, cells on the same diagonal plane i+j+k = c depend only on the previous plane, so each plane is
+  // updated in parallel.
+  const auto update = [&](const int i, const int j, const int k) {
+    if (fixed(i,j,k))
+      return;
+    Vector<T,3> a;
+    T best = inf;
+    bool negative = false;
+    for (int r=0;r<3;r++) {
+      a[r] = inf;
+      for (const int s : vec(-1,1)) {
+        auto I = vec(i,j,k);
+        I[r] += s;
+        if (unsigned(I[r])<unsigned(cells[r])) {
+          const T p = phi(I);
+          a[r] = min(a[r],abs(p));
+          if (best > abs(p)) {
+            best = abs(p);
+            negative = p<0;
+          }
+        }
+      }
+    }
+    if (best == inf)
+      return;
+    const T u = eikonal_update(a,dx);
+    if (u < abs(phi(i,j,k)))
+      phi(i,j,k) = negative ? -u : u;
+  };
+  const int planes = cells.sum()-2;
+  for (int sweep=0;sweep<8;sweep++)
+    for (int c=0;c<planes;c++) {
+      const int i_lo = max(0,c-(cells.y-1)-(cells.z-1)),
+                i_hi = min(cells.x-1,c);
+      #pragma omp parallel for
+      for (int ii=i_lo;ii<=i_hi;ii++) {
+        const int j_lo = max(0,c-ii-(cells.z-1)),
+                  j_hi = min(cells.y-1,c-ii);
+        for (int jj=j_lo;jj<=j_hi;jj++) {
+          const int kk = c-ii-jj;
+          update(sweep&1 ? cells.x-1-ii : ii,
+                 sweep&2 ? cells.y-1-jj : jj,
+                 sweep&4 ? cells.z-1-kk : kk);
+        }
+      }
+    }
+  return phi;
+}
+
 // For testing purposes
 static Tuple<Array<T>,Array<TV>,Array<int>,Array<TV>>
 slow_surface_levelset(const ParticleTree<TV>& particles, const SimplexTree<TV,2>& surface) {
@@ -205,5 +378,6 @@ void wrap_surface_levelset() {
     const ParticleTree<TV>&,const SimplexTree<TV,1>&,T,bool)>(surface_levelset))
   GEODE_FUNCTION_2(surface_levelset_s3d,static_cast<Tuple<Array<T>,Array<TV>,Array<int>,Array<TV>>(*)(
     const ParticleTree<TV>&,const SimplexTree<TV,2>&,T,bool)>(surface_levelset))
+  GEODE_FUNCTION(grid_levelset)
   GEODE_FUNCTION(slow_surface_levelset)
 }
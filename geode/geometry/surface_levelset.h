@@ -1,9 +1,10 @@
 //#####################################################################
-// Evaluate signed distances between a point cloud and a mesh
+// Evaluate signed distances between a point cloud or grid and a mesh
 //#####################################################################
 #pragma once
 
 #include <geode/array/Array.h>
+#include <geode/array/Array3d.h>
 #include <geode/geometry/SimplexTree.h>
 #include <geode/math/constants.h>
 #include <geode/structure/Tuple.h>
@@ -25,10 +26,22 @@ template<int d> GEODE_CORE_EXPORT void surface_levelset(const ParticleTree<Vecto
                                                         RawArray<typename Hide<CloseInfo<d>>::type> info,
                                                         const real max_distance=inf, const bool compute_signs=true);
 
+// Signed distances from a closed triangle mesh to the cell centers of a grid with the given number of cells over box,
+// negative inside.  Distances are exact within band of the surface, and are filled in elsewhere by fast sweeping, which
+// is first order accurate.  band is enlarged to at least one cell diagonal.
+GEODE_CORE_EXPORT Array<real,3> grid_levelset(const SimplexTree<Vector<real,3>,2>& surface, const Box<Vector<real,3>>& box,
+                                              const Vector<int,3> cells, real band);
+
 // Functional-style version: returns distance, normals, closest simplex, and barycentric weights per point.
 template<int d> GEODE_CORE_EXPORT Tuple<Array<real>,Array<Vector<real,3>>,
                                         Array<int>,Array<typename SimplexTree<Vector<real,3>,d>::Weights>>
 surface_levelset(const ParticleTree<Vector<real,3>>& particles, const SimplexTree<Vector<real,3>,d>& surface,
                  const real max_distance=inf, const bool compute_signs=true);
 
+// Signed distances from a closed triangle mesh to the cell centers of a grid with the given number of cells over box,
+// negative inside.  Distances are exact within band of the surface, and are filled in elsewhere by fast sweeping, which
+// is first order accurate.  band is enlarged to at least one cell diagonal.
+GEODE_CORE_EXPORT Array<real,3> grid_levelset(const SimplexTree<Vector<real,3>,2>& surface, const Box<Vector<real,3>>& box,
+                                              const Vector<int,3> cells, real band);
+
 }
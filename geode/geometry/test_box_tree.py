@@ -9,27 +9,245 @@ def test_box_tree():
   for n in 0,1,35,99,100,101,199,200,201:
     print
     x = random.randn(n,3).astype(real)
-    tree = BoxTree(x,10)
-    tree.check(x)
+    for sah in False,True:
+      tree = BoxTree(x,10,sah)
+      tree.check(x)
 
 def test_particle_tree():
   random.seed(10098331)
   for n in 0,1,35,99,100,101,199,200,201:
     print
-    X = random.randn(n,3).astype(real)
-    tree = ParticleTree(X,10)
-    tree.check(X)
-    X[:] = random.randn(n,3).astype(real)
-    tree.update()
-    tree.check(X)
+    for sah in False,True:
+      X = random.randn(n,3).astype(real)
+      tree = ParticleTree(X,10,sah)
+      tree.check(X)
+      X[:] = random.randn(n,3).astype(real)
+      tree.update()
+      tree.check(X)
+
+def test_particle_tree_neighbors():
+  random.seed(1831131)
+  X = random.randn(300,3).astype(real)
+  for sah in False,True:
+    tree = ParticleTree(X,4,sah)
+    D = magnitudes(X[:,None]-X[None])
+    order = argsort(D,axis=1,kind='mergesort')
+    nearest = tree.nearest_neighbors(X,5)
+    for i in xrange(len(X)):
+      assert all(nearest[i]==order[i,:5])
+      assert all(tree.nearest(X[i],5)==order[i,:5])
+    radius = tree.radius_neighbors(X,.5)
+    for i in xrange(len(X)):
+      assert all(radius[i]==nonzero(D[i]<=.5)[0])
+
+def test_remove_duplicates():
+  random.seed(7126631)
+  X = random.randn(200,3).astype(real)
+  X = concatenate([X,X[:50]+1e-4*random.randn(50,3),X[:20]])
+  for tolerance in 0,1e-3:
+    map = ParticleTree(X,4).remove_duplicates(tolerance)
+    # Nearby points share components, and components are numbered in order of their first point
+    assert all(map[:200]==arange(200))
+    assert all(map[250:]==arange(20))
+    assert all((map[200:250]==arange(50))==(tolerance>0))
 
 def test_simplex_tree():
   mesh,X = sphere_mesh(4)
+  for sah in False,True:
+    tree = SimplexTree(mesh,X,4,sah)
+    rays = 1000
+    hits = ray_traversal_test(tree,rays,1e-6)
+    print 'rays = %d, hits = %d'%(rays,hits)
+    assert hits==642
+    assert wide_ray_traversal_test(tree,rays,1e-6)==hits
+    assert packet_ray_traversal_test(tree,rays,1e-6)==hits
+
+def test_simplex_tree_closest_points():
+  random.seed(8712311)
+  mesh,X = sphere_mesh(3)
+  tree = SimplexTree(mesh,X,4)
+  points = random.randn(200,3)
+  closest,simplices,weights = tree.closest_points(points)
+  for p,c,s in zip(points,closest,simplices):
+    c1,s1,w1 = tree.closest_point(p)
+    assert allclose(magnitudes(c-p),magnitudes(c1-p))
+
+def test_simplex_tree_closest_point_brute():
+  random.seed(8712312)
+  def segment_sqr_distances(x0,x1,p):
+    v = x1-x0
+    t = clamp(dots(p-x0,v)/maximum(sqr_magnitudes(v),1e-300),0,1)
+    return sqr_magnitudes(p-x0-t[:,None]*v)
+  def triangle_sqr_distances(x0,x1,x2,p):
+    d = minimum(minimum(segment_sqr_distances(x0,x1,p),segment_sqr_distances(x1,x2,p)),segment_sqr_distances(x0,x2,p))
+    e0,e1,v = x1-x0,x2-x0,p-x0
+    d00,d01,d11,d20,d21 = dots(e0,e0),dots(e0,e1),dots(e1,e1),dots(v,e0),dots(v,e1)
+    denom = d00*d11-d01*d01
+    good = denom>1e-9*d00*d11
+    denom = where(good,denom,1)
+    b1,b2 = (d11*d20-d01*d21)/denom,(d00*d21-d01*d20)/denom
+    inside = good&(b1>=0)&(b2>=0)&(b1+b2<=1)
+    plane = sqr_magnitudes(v-b1[:,None]*e0-b2[:,None]*e1)
+    return where(inside,minimum(d,plane),d)
+  # Random soups with some degenerate simplices, in leaves of every size modulo the SIMD width
+  for m,d in (2,1),(3,1),(3,2):
+    n = 300
+    X = .1*random.randn(n,d+1,m)+random.randn(n,1,m)
+    X[::7,-1] = X[::7,0]
+    X[::11,-1] = 2*X[::11,1]-X[::11,0]
+    mesh = (SegmentSoup if d==1 else TriangleSoup)(arange((d+1)*n).reshape(-1,d+1))
+    corners = [X[:,i] for i in range(d+1)]
+    X = X.reshape(-1,m).copy()
+    for leaf_size in 1,3,4,5,8:
+      tree = SimplexTree(mesh,X,leaf_size)
+      for p in random.randn(50,m):
+        sqr_distances = (segment_sqr_distances if d==1 else triangle_sqr_distances)(*(corners+[p]))
+        c,s,w = tree.closest_point(p)
+        assert allclose(sqr_magnitude(c-p),sqr_distances.min())
+
+def test_simplex_tree_batched_rays():
+  random.seed(1731)
+  mesh,X = sphere_mesh(3)
+  tree = SimplexTree(mesh,X,4)
+  n = 500
+  starts = random.randn(n,3)
+  starts *= 3/magnitudes(starts)[:,None]
+  directions = random.randn(n,3)
+  simplices,t = tree.closest_hits(starts,directions,1e-6)
+  hit = tree.any_hits(starts,directions,1e-6)
+  count = tree.count_hits(starts,directions,1e-6)
+  assert all(hit==(simplices>=0))
+  assert all(hit==(count>0))
+  # Rays start outside the sphere, so stopping short of every first hit finds nothing
+  assert not any(tree.any_hits(starts,directions,1e-6,.5*t[hit].min()))
+
+def test_flat_triangle_tree():
+  random.seed(1734)
+  mesh,X = sphere_mesh(3)
   tree = SimplexTree(mesh,X,4)
-  rays = 1000
-  hits = ray_traversal_test(tree,rays,1e-6)
-  print 'rays = %d, hits = %d'%(rays,hits)
-  assert hits==642
+  flat = FlatTriangleTree(tree)
+  n = 500
+  starts = 3*random.randn(n,3)
+  directions = random.randn(n,3)
+  simplices,t = tree.closest_hits(starts,directions,1e-6)
+  simplices2,t2 = flat.closest_hits(starts,directions,1e-6)
+  assert all(simplices==simplices2)
+  assert allclose(t,t2)
+  points = random.randn(n,3)
+  closest = tree.closest_points(points)[0]
+  closest2,simplices2,weights2 = flat.closest_points(points)
+  assert allclose(closest,closest2)
+  assert allclose(closest2,(weights2[:,:,None]*X[mesh.elements[simplices2]]).sum(axis=1))
+  # Updates follow the tree, which shares X
+  X *= 2
+  tree.update()
+  flat.update()
+  assert allclose(2*closest,flat.closest_points(2*points)[0])
+
+def test_simplex_tree_update_swept():
+  random.seed(1732)
+  mesh,X = sphere_mesh(3)
+  tree = SimplexTree(mesh,X,4)
+  n = 500
+  starts = 3*random.randn(n,3)
+  directions = random.randn(n,3)
+  count = tree.count_hits(starts,directions,1e-6)
+  # Swept boxes only grow, and the simplices stay put, so queries are unchanged
+  tree.update_swept(X+.3*random.randn(*X.shape),.01)
+  assert all(count==tree.count_hits(starts,directions,1e-6))
+
+def test_simplex_tree_io():
+  random.seed(1733)
+  for d in 1,2:
+    mesh,X = sphere_mesh(3)
+    if d==1:
+      mesh = mesh.segment_soup()
+    for sah in False,True:
+      tree = SimplexTree(mesh,X,4,sah)
+      f = named_tmpfile(suffix='.tree')
+      write_simplex_tree(f.name,tree)
+      tree2 = read_simplex_tree(f.name,mesh,X)
+      points = random.randn(100,3)
+      assert all(tree.closest_points(points)[1]==tree2.closest_points(points)[1])
+      # Moved positions are caught
+      try:
+        read_simplex_tree(f.name,mesh,X+1e-9)
+        assert False
+      except IOError:
+        pass
+
+def overlaps(a,b):
+  return all(a.min<=b.max) and all(b.min<=a.max)
+
+def test_dynamic_box_tree():
+  random.seed(7218311)
+  n = 300
+  for margin in 0,.05:
+    tree = DynamicBoxTree(3,margin)
+    present = zeros(n,dtype=bool)
+    for i in xrange(3000):
+      k = random.randint(n)
+      x = random.rand(3)
+      if not present[k]:
+        tree.insert(k,Box(x,x+.01))
+        present[k] = True
+      elif random.rand()<.3:
+        tree.remove(k)
+        present[k] = False
+      else:
+        tree.update(k,Box(x,x+.01))
+      if i%100==0:
+        tree.check()
+        q = random.rand(3)
+        query = Box(q-.2,q+.2)
+        hits = [k for k in xrange(n) if present[k] and overlaps(tree.box(k),query)]
+        assert all(sort(tree.intersection(query))==hits)
+    assert tree.size()==present.sum()
+    assert tree.height()<=2*log2(n)
+
+def test_dynamic_face_tree():
+  random.seed(7218313)
+  soup,X = sphere_mesh(3)
+  mesh = MutableTriangleTopology(soup)
+  tree = mesh.dynamic_face_tree(X,.01)
+  tree.check()
+  assert tree.size()==mesh.n_faces
+  # Small motions stay within the margin, and larger ones reinsert
+  for scale in 1e-3,1e-1:
+    X = X+scale*random.randn(*X.shape)
+    for f in xrange(mesh.n_faces):
+      x = X[mesh.face_vertices(f)]
+      tree.update(f,Box(x.min(axis=0),x.max(axis=0)))
+    tree.check()
+    query = Box(-.5*ones(3),.5*ones(3))
+    hits = [f for f in xrange(mesh.n_faces) if overlaps(tree.box(f),query)]
+    assert all(sort(tree.intersection(query))==hits)
+
+def test_spatial_order():
+  # On a grid, consecutive points along the Hilbert curve are neighbors
+  n = 8
+  X = array([(i,j) for i in xrange(n) for j in xrange(n)],dtype=real)
+  for order in hilbert_order_2d,morton_order_2d:
+    o = order(X)
+    assert all(sort(o)==arange(n*n))
+    steps = magnitudes(diff(X[o],axis=0))
+    assert (order is morton_order_2d) or all(steps==1)
+  X = random.randn(100,3).astype(real)
+  for order in hilbert_order_3d,morton_order_3d:
+    assert all(sort(order(X))==arange(100))
+
+def test_polygon_outlines():
+  random.seed(81311)
+  square = asarray([(-1,-1),(1,-1),(1,1),(-1,1)],dtype=real)
+  outlines = PolygonOutlines()
+  outlines.add(square)
+  outlines.extend(Nested([square+(5,0),square+(10,0)]))
+  assert outlines.size()==3
+  # A small square crossing the first, inside the second, and clear of everything
+  small = square/2
+  frames = Frames([(1,0),(5,0),(2.5,3)],Rotation.from_angle(random.uniform(0,2*pi,size=3)))
+  assert all(outlines.intersect(small,frames)==[1,0,0])
+  assert all(outlines.intersecting(2*square,Frames((7.5,0),Rotation.from_angle(0)))==[1,2])
 
 if __name__=='__main__':
   test_simplex_tree()
@@ -41,5 +41,19 @@ def test_offset():
         assert all(alpha*offset <= phi+small)
         assert all(phi <= offset+small)
 
+def test_offset_polygons():
+  # Convex polygons need no culling, so the batched offsets match the serial ones
+  polys = [[(cos(t)+3*i,sin(t)) for t in linspace(0,2*pi,3+i,endpoint=False)] for i in xrange(10)]
+  X,C = offset_polygons_with_correspondence(Nested(polys),.1)
+  for p,x,c in zip(polys,X,C):
+    x1,c1 = offset_polygon_with_correspondence(p,.1)
+    assert all(x==x1) and all(c==c1)
+  # A U with a notch narrower than twice the offset loses the points inside the notch
+  u = asarray([(0,0),(3,0),(3,2),(1.55,2),(1.55,.5),(1.45,.5),(1.45,2),(0,2)])
+  X,C = offset_polygons_with_correspondence(Nested([u]),.1)
+  assert len(X[0])
+  assert not any((1.4<X[0][:,0])&(X[0][:,0]<1.6)&(X[0][:,1]<2))
+  assert all(resample_polygons(Nested(polys),.1)[3]==resample_polygon(polys[3],.1))
+
 if __name__=='__main__':
   test_offset()
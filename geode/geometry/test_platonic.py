@@ -65,6 +65,20 @@ def test_double_torus():
   assert not len(mesh.nonmanifold_nodes(False))
   assert all(mesh.segment_soup().neighbors().sizes()==7)
 
+def test_slice_mesh():
+  # Layers through vertices: the bottom plane misses the cube, and the top plane catches its sides
+  mesh,X = cube_mesh()
+  layers = slice_mesh(mesh,X,[0,.5,1])
+  assert [len(c) for c in layers]==[0,1,1]
+  for c in layers[1:]:
+    assert relative_error(polygon_area(c),1)<1e-10
+  # Each layer of a sphere is one counterclockwise circle
+  mesh,X = sphere_mesh(4)
+  levels = linspace(-.95,.95,39)
+  for z,c in zip(levels,slice_mesh(mesh,X,levels)):
+    assert len(c)==1
+    assert relative_error(polygon_area(c),pi*(1-z*z))<2e-2
+
 if __name__=='__main__':
   test_revolution()
   test_icosahedron()
@@ -72,6 +72,28 @@ def test_consistency():
       print 'box %s, sizes %s, volume %g\ninner box %s, sizes %s, volume %g'%(box,box.sizes(),box.volume(),inner_box,inner_box.sizes(),inner_box.volume())
       assert False
 
+def test_batched_phi():
+  random.seed(18311)
+  sphere = Sphere((1,2,3),2)
+  shapes = [sphere,Box((-1,-2,-3),(1,2,3)),Capsule((-.5,-.5,-.5),(1,2,3),1),Cylinder((-1,-2,-3),(4,2,1),1.5),
+            FrameImplicit(Frame.identity(3),sphere)]
+  X = 4*random.randn(1000,3)
+  for shape in shapes:
+    phi = asarray([shape.phi(x) for x in X])
+    assert relative_error(shape.phis(X),phi) < 1e-12
+
+def test_sparse_implicit():
+  random.seed(18312)
+  sphere = Sphere((1,2,3),2)
+  sparse = SparseImplicit(sphere,.05,.2)
+  assert 0 < sparse.cached_blocks() < (4.4/.4)**3
+  X = (1,2,3)+2*random.randn(1000,3)
+  phi = sparse.phis(X)
+  assert all(phi==[sparse.phi(x) for x in X])
+  assert maxabs(phi-sphere.phis(X)) < .05**2
+  near = absolute(phi)<.2
+  assert all(magnitudes([sparse.normal(x)-sphere.normal(x) for x in X[near]])<.03)
+
 """
 def test_generate_triangles():
   tolerance=1e-5
@@ -39,3 +39,31 @@ def test_surface_levelset():
     print 'i %d, phi %g, phi2 %g'%(i,phi[i],phi2[i])
   assert relative_error(abs(phi),phi2) < 1e-7
   assert all(magnitudes(cross(normal,normal2))<1e-7)
+
+def test_grid_levelset():
+  mesh,X = sphere_mesh(4)
+  surface = SimplexTree(mesh,X,10)
+  n = 40
+  box = Box((-2,-2,-2),(2,2,2))
+  phi = grid_levelset(surface,box,(n,n,n),.2)
+  x = -2+4/n*(arange(n)+.5)
+  mags = magnitudes(concatenate(broadcast_arrays(*[x[:,None,None,None],x[None,:,None,None],x[None,None,:,None]]),axis=-1))
+  phi3 = mags-1
+  band = absolute(phi3)<.15
+  assert absolute(phi-phi3)[band].max() < .002
+  assert absolute(phi-phi3).max() < .1
+  assert all((phi<0)==(phi3<0))
+
+def test_extract_isosurface():
+  n = 40
+  box = Box((-2,-2,-2),(2,2,2))
+  mesh,X = sphere_mesh(4)
+  phi = grid_levelset(SimplexTree(mesh,X,10),box,(n,n,n),.2)
+  sphere = Sphere((0,0,0),1)
+  for mesh,X in extract_isosurface(phi,box,0),extract_implicit_isosurface(sphere,box,(n,n,n),0):
+    assert mesh.is_manifold() and not mesh.has_boundary()
+    assert absolute(magnitudes(X)-1).max()<.01
+    # Normals point outwards
+    tris = X[mesh.elements()]
+    volume = dots(tris[:,0],cross(tris[:,1],tris[:,2])).sum()/6
+    assert absolute(volume-4/3*pi)<.1
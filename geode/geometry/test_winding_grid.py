@@ -0,0 +1,30 @@
+#!/usr/bin/env python
+
+from __future__ import division
+from geode import *
+
+def test_winding_grid():
+  random.seed(71821)
+  # A square with a square hole, and an overlapping triangle
+  polys = Nested([[(0,0),(4,0),(4,4),(0,4)],[(1,1),(1,3),(3,3),(3,1)],[(2,-1),(6,2),(2,5)]])
+  grid = WindingGrid(polys)
+  X = 8*random.rand(10000,2)-1
+  def brute(p):
+    w = 0
+    for poly in polys:
+      for a,b in zip(poly,roll(poly,-1,axis=0)):
+        if a[1]<=p[1]<b[1] and cross(b-a,p-a)>0:
+          w += 1
+        elif b[1]<=p[1]<a[1] and cross(b-a,p-a)<0:
+          w -= 1
+    return w
+  w = grid.windings_of(X)
+  assert all(w==[brute(p) for p in X])
+  assert all(grid.inside(X)==(w>0))
+  assert grid.winding((.5,.5))==1
+  assert grid.winding((2,2))==1
+  assert grid.winding((3.5,2))==2
+  assert grid.winding((-1,-1))==0
+
+if __name__=='__main__':
+  test_winding_grid()
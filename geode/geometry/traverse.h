@@ -7,6 +7,10 @@
 #include <geode/array/RawStack.h>
 #include <geode/array/view.h>
 #include <geode/geometry/BoxTree.h>
+#include <geode/structure/Empty.h>
+#include <geode/utility/openmp.h>
+#include <exception>
+#include <vector>
 namespace geode {
 
 // Traverse one box tree.  There is no automatic culling: the visitor is responsible for everything.
@@ -21,8 +25,9 @@ template<class Visitor,class TV> static void single_traverse(const BoxTree<TV>&
     if (visitor.cull(n))
       continue;
     if (n < internal) {
-      stack.push(2*n+1);
-      stack.push(2*n+2);
+      const auto c = tree.children(n);
+      stack.push(c.x);
+      stack.push(c.y);
     } else
       visitor.leaf(n);
   }
@@ -43,19 +48,22 @@ double_traverse_helper(const BoxTree<TV>& tree0, const BoxTree<TV>& tree1, Visit
     if (visitor.cull(n.x,n.y) || !boxes0[n.x].intersects(boxes1[n.y],thickness))
       continue;
     if (n.x < internal0) {
+      const auto c0 = tree0.children(n.x);
       if (n.y < internal1) {
-        stack.push(vec(2*n.x+1,2*n.y+1));
-        stack.push(vec(2*n.x+1,2*n.y+2));
-        stack.push(vec(2*n.x+2,2*n.y+1));
-        stack.push(vec(2*n.x+2,2*n.y+2));
+        const auto c1 = tree1.children(n.y);
+        stack.push(vec(c0.x,c1.x));
+        stack.push(vec(c0.x,c1.y));
+        stack.push(vec(c0.y,c1.x));
+        stack.push(vec(c0.y,c1.y));
       } else {
-        stack.push(vec(2*n.x+1,n.y));
-        stack.push(vec(2*n.x+2,n.y));
+        stack.push(vec(c0.x,n.y));
+        stack.push(vec(c0.y,n.y));
       }
     } else {
       if (n.y < internal1) {
-        stack.push(vec(n.x,2*n.y+1));
-        stack.push(vec(n.x,2*n.y+2));
+        const auto c1 = tree1.children(n.y);
+        stack.push(vec(n.x,c1.x));
+        stack.push(vec(n.x,c1.y));
       } else
         visitor.leaf(n.x,n.y);
     }
@@ -72,29 +80,36 @@ double_traverse_helper(const BoxTree<TV>& tree0, const BoxTree<TV>& tree1, Visit
   double_traverse_helper(tree0,tree1,visitor,stack,0,0,thickness);
 }
 
-// Helper function traversing a hierarchy against itself starting at the roots.
+// Helper function traversing a hierarchy against itself starting at a given node.  The stack must have room for 6*tree.depth entries.
 template<class Visitor,class Thickness,class TV> static void
-double_traverse_helper(const BoxTree<TV>& tree, Visitor&& visitor, Thickness thickness) {
-  if (!tree.nodes())
-    return;
+double_traverse_helper(const BoxTree<TV>& tree, Visitor&& visitor, RawStack<int> stack, const int n0, Thickness thickness) {
   const int internal = tree.leaves.lo;
-  RawStack<int> stack(GEODE_RAW_ALLOCA(6*tree.depth,int));
-  stack.push(0);
+  stack.push(n0);
   while (stack.size()) {
     const int n = stack.pop();
     if (visitor.cull(n))
       continue;
     if (n < internal) {
-      stack.push(2*n+1);
-      stack.push(2*n+2);
+      const auto c = tree.children(n);
+      stack.push(c.x);
+      stack.push(c.y);
       const int s = stack.size();
       RawStack<Vector<int,2>> rest(vector_view<2>(stack.data.slice(s,s+((stack.data.size()-s)&~1))));
-      double_traverse_helper(tree,tree,visitor,rest,2*n+1,2*n+2,thickness);
+      double_traverse_helper(tree,tree,visitor,rest,c.x,c.y,thickness);
     } else
       visitor.leaf(n);
   }
 }
 
+// Helper function traversing a hierarchy against itself starting at the roots.
+template<class Visitor,class Thickness,class TV> static void
+double_traverse_helper(const BoxTree<TV>& tree, Visitor&& visitor, Thickness thickness) {
+  if (!tree.nodes())
+    return;
+  RawStack<int> stack(GEODE_RAW_ALLOCA(6*tree.depth,int));
+  double_traverse_helper(tree,visitor,stack,0,thickness);
+}
+
 // Traverse all intersecting pairs of leaf boxes between two distinct hierarchies.  Box/box intersection culling
 // is automatic, but the visitor can provide additional culling by returning true from visitor.cull(...).
 template<class Visitor,class TV> static void
@@ -123,4 +138,155 @@ template<class Visitor,class TV> static void double_traverse(const BoxTree<TV>&
   double_traverse_helper(tree,visitor,Zero());
 }
 
+// Expand a self traversal node (n,n) during double_traverse_split.  Returns false if n was culled.
+template<class Visitor,class TV> static inline bool
+double_traverse_split_self(const BoxTree<TV>& tree, Visitor& visitor, const int n, Array<Vector<int,2>>& next, bool& expanded, mpl::true_) {
+  if (visitor.cull(n))
+    return false;
+  if (n < tree.leaves.lo) {
+    const int c0 = tree.child(n,0),
+              c1 = tree.child(n,1);
+    next.append(vec(c0,c0));
+    next.append(vec(c0,c1));
+    next.append(vec(c1,c1));
+    expanded = true;
+  } else
+    next.append(vec(n,n));
+  return true;
+}
+template<class Visitor,class TV> static inline bool
+double_traverse_split_self(const BoxTree<TV>& tree, Visitor& visitor, const int n, Array<Vector<int,2>>& next, bool& expanded, mpl::false_) {
+  GEODE_UNREACHABLE();
+}
+
+// Expand the top levels of a double traversal breadth first into independent node pairs, stopping once there
+// are at least count pairs or nothing is left to expand.  If Self is true (the trees are identical), pairs (n,n)
+// denote the self traversal of the subtree rooted at n.  Culling is applied during expansion.
+template<class Self,class Visitor,class Thickness,class TV> static Array<Vector<int,2>>
+double_traverse_split(const BoxTree<TV>& tree0, const BoxTree<TV>& tree1, Visitor& visitor,
+                      const int count, Thickness thickness) {
+  const int internal0 = tree0.leaves.lo,
+            internal1 = tree1.leaves.lo;
+  RawArray<const Box<TV>> boxes0 = tree0.boxes,
+                          boxes1 = tree1.boxes;
+  Array<Vector<int,2>> pairs, next;
+  if (tree0.nodes() && tree1.nodes())
+    pairs.append(vec(0,0));
+  while (pairs.size() < count) {
+    bool expanded = false;
+    next.clear();
+    for (const auto n : pairs) {
+      if (Self::value && n.x == n.y)
+        double_traverse_split_self(tree0,visitor,n.x,next,expanded,Self());
+      else {
+        if (visitor.cull(n.x,n.y) || !boxes0[n.x].intersects(boxes1[n.y],thickness))
+          continue;
+        if (n.x < internal0 || n.y < internal1) {
+          const auto c0 = n.x < internal0 ? tree0.children(n.x) : vec(n.x,-1),
+                     c1 = n.y < internal1 ? tree1.children(n.y) : vec(n.y,-1);
+          for (const int a0 : c0)
+            if (a0 >= 0)
+              for (const int a1 : c1)
+                if (a1 >= 0)
+                  next.append(vec(a0,a1));
+          expanded = true;
+        } else
+          next.append(n);
+      }
+    }
+    swap(pairs,next);
+    if (!expanded)
+      break;
+  }
+  return pairs;
+}
+
+// Traverse one node pair produced by double_traverse_split
+template<class Visitor,class Thickness,class TV> static inline void
+double_traverse_pair(const BoxTree<TV>& tree0, const BoxTree<TV>& tree1, Visitor& visitor, RawStack<int> stack,
+                     const Vector<int,2> n, Thickness thickness, mpl::false_) {
+  const int s = (stack.data.size())&~1;
+  double_traverse_helper(tree0,tree1,visitor,RawStack<Vector<int,2>>(vector_view<2>(stack.data.slice(0,s))),n.x,n.y,thickness);
+}
+template<class Visitor,class Thickness,class TV> static inline void
+double_traverse_pair(const BoxTree<TV>& tree0, const BoxTree<TV>& tree1, Visitor& visitor, RawStack<int> stack,
+                     const Vector<int,2> n, Thickness thickness, mpl::true_) {
+  if (n.x == n.y)
+    double_traverse_helper(tree0,visitor,stack,n.x,thickness);
+  else
+    double_traverse_pair(tree0,tree1,visitor,stack,n,thickness,mpl::false_());
+}
+
+// Traverse a list of node pairs produced by double_traverse_split, cut into consecutive chunks with one visitor per
+// chunk.  This is called from each thread of a parallel region, and shares the loop over chunks between threads.
+template<class Scope,class Self,class Visitor,class Thickness,class TV> static GEODE_NEVER_INLINE void
+parallel_double_traverse_helper(const BoxTree<TV>& tree0, const BoxTree<TV>& tree1, RawArray<const Vector<int,2>> pairs,
+                                std::vector<Visitor>& visitors, Thickness thickness, std::exception_ptr& error) {
+  // Scopes such as IntervalScope are per thread, so each thread needs its own
+  Scope scope;
+  RawStack<int> stack(GEODE_RAW_ALLOCA(6*max(tree0.depth,tree1.depth),int));
+  const int chunks = int(visitors.size());
+  #pragma omp for schedule(dynamic)
+  for (int c=0;c<chunks;c++) {
+    try {
+      const auto chunk = partition_loop(pairs.size(),chunks,c);
+      for (const int i : chunk)
+        double_traverse_pair(tree0,tree1,visitors[c],stack,pairs[i],thickness,Self());
+    } catch (...) {
+      #pragma omp critical
+      {
+        if (!error)
+          error = std::current_exception();
+      }
+    }
+  }
+}
+
+template<class Scope,class Self,class Visitor,class Thickness,class TV> static void
+parallel_double_traverse_helper(const BoxTree<TV>& tree0, const BoxTree<TV>& tree1, Visitor& visitor, Thickness thickness) {
+  // Split the top of the traversal into a few thousand pairs, so that each chunk of pairs is a mix of cheap and
+  // expensive subtraversals.  Chunks are still many more than threads so that dynamic scheduling balances the load.
+  const int threads = omp_get_max_threads();
+  const auto pairs = double_traverse_split<Self>(tree0,tree1,visitor,max(4096,256*threads),thickness);
+  std::vector<Visitor> visitors(min(pairs.size(),64*threads),visitor);
+  std::exception_ptr error;
+  #pragma omp parallel
+  parallel_double_traverse_helper<Scope,Self>(tree0,tree1,pairs,visitors,thickness,error);
+  if (error)
+    std::rethrow_exception(error);
+  // Merge in a fixed order so that results don't depend on scheduling
+  for (auto& v : visitors)
+    visitor.merge(v);
+}
+
+// Parallel versions of double_traverse.  The top levels of the traversal are split into independent node pairs, and
+// each consecutive chunk of pairs is traversed by a separate copy of visitor (possibly on a different thread).
+// Afterwards, each copy is merged back into the original in a deterministic order via visitor.merge(copy).  cull and
+// leaf must therefore be safe to call concurrently on different copies.  Scope is instantiated once per thread inside the parallel
+// region, e.g. IntervalScope for visitors that use interval arithmetic.  The default Scope does nothing.
+template<class Scope=Tuple<>,class Visitor,class TV> static void
+parallel_double_traverse(const BoxTree<TV>& tree0, const BoxTree<TV>& tree1, Visitor& visitor, typename TV::Scalar thickness) {
+  GEODE_ASSERT(&tree0 != &tree1,"Identical trees should use the dedicated routine below");
+  if (thickness)
+    parallel_double_traverse_helper<Scope,mpl::false_>(tree0,tree1,visitor,thickness);
+  else
+    parallel_double_traverse_helper<Scope,mpl::false_>(tree0,tree1,visitor,Zero());
+}
+template<class Scope=Tuple<>,class Visitor,class TV> static void
+parallel_double_traverse(const BoxTree<TV>& tree0, const BoxTree<TV>& tree1, Visitor& visitor) {
+  GEODE_ASSERT(&tree0 != &tree1,"Identical trees should use the dedicated routine below");
+  parallel_double_traverse_helper<Scope,mpl::false_>(tree0,tree1,visitor,Zero());
+}
+template<class Scope=Tuple<>,class Visitor,class TV> static void
+parallel_double_traverse(const BoxTree<TV>& tree, Visitor& visitor, typename TV::Scalar thickness) {
+  if (thickness)
+    parallel_double_traverse_helper<Scope,mpl::true_>(tree,tree,visitor,thickness);
+  else
+    parallel_double_traverse_helper<Scope,mpl::true_>(tree,tree,visitor,Zero());
+}
+template<class Scope=Tuple<>,class Visitor,class TV> static void
+parallel_double_traverse(const BoxTree<TV>& tree, Visitor& visitor) {
+  parallel_double_traverse_helper<Scope,mpl::true_>(tree,tree,visitor,Zero());
+}
+
 }
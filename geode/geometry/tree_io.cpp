@@ -0,0 +1,272 @@
+// Native binary files for BoxTree and SimplexTree
+
+#include <geode/geometry/tree_io.h>
+#include <geode/array/mapped.h>
+#include <geode/geometry/Segment.h>
+#include <geode/geometry/Triangle2d.h>
+#include <geode/geometry/Triangle3d.h>
+#include <geode/python/wrap.h>
+#include <geode/utility/parallel.h>
+#include <geode/utility/smart_ptr.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+namespace geode {
+
+using std::vector;
+
+// Tree files start with a header, followed by a table of sections, followed by the section data
+static const char tree_magic[8] = {'g','e','o','d','e','t','r','e'};
+static const uint32_t tree_version = 1;
+static const uint32_t tree_endian = 0x01020304;
+static const size_t tree_alignment = 64;
+
+namespace {
+struct TreeHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t endian; // tree_endian in the byte order of the writer
+  int32_t m; // Spatial dimension
+  int32_t d; // Simplex dimension, or zero for plain box trees
+  int32_t scalar_size;
+  int32_t leaf_size, depth;
+  int32_t sections;
+  uint64_t content_hash; // Of the mesh and positions for simplex trees, otherwise zero
+};
+
+enum TreeSectionKind { TreePrims, TreeRanges, TreeBoxes, TreeChildren, TreeSimplices };
+
+struct TreeSection {
+  int32_t t_size; // Bytes per element
+  int32_t size; // Number of elements
+  uint64_t offset; // Start of data, from the start of the file and tree_alignment aligned
+};
+}
+
+static inline uint64_t mix64(uint64_t x) {
+  x = (x^x>>33)*uint64_t(0xff51afd7ed558ccd);
+  x = (x^x>>33)*uint64_t(0xc4ceb9fe1a85ec53);
+  return x^x>>33;
+}
+
+// 64 bit hash of raw bytes.  Fixed size chunks are hashed in parallel and then combined in order, so the result
+// doesn't depend on the number of threads.
+static uint64_t content_hash(const char* data, const size_t size) {
+  const size_t chunk = 1<<16;
+  const int chunks = int((size+chunk-1)/chunk);
+  Array<uint64_t> hashes(chunks,uninit);
+  parallel_for(chunks,[&](const int c) {
+    const char* start = data+c*chunk;
+    const size_t n = min(chunk,size-c*chunk);
+    uint64_t h = mix64(c+1);
+    size_t i = 0;
+    for (;i+8<=n;i+=8) {
+      uint64_t w;
+      memcpy(&w,start+i,8);
+      h = (h^w)*uint64_t(0x9e3779b97f4a7c15);
+      h ^= h>>29;
+    }
+    uint64_t w = 0;
+    memcpy(&w,start+i,n-i);
+    hashes[c] = mix64(h^w^n);
+  },1);
+  uint64_t h = mix64(size);
+  for (const auto c : hashes)
+    h = mix64(h^c);
+  return h;
+}
+
+template<class TV,int d> static uint64_t content_hash(const typename SimplexTree<TV,d>::Mesh& mesh,
+                                                      RawArray<const TV> X) {
+  return mix64(content_hash((const char*)mesh.elements.data(),sizeof(Vector<int,d+1>)*mesh.elements.size())
+               ^ mix64(content_hash((const char*)X.data(),sizeof(TV)*X.size())));
+}
+
+template<class TV> static void write_tree(const string& filename, const BoxTree<TV>& tree, const int d,
+                                          const uint64_t hash, const char* simplices, const int simplex_size) {
+  // Collect sections
+  vector<TreeSection> sections;
+  vector<const char*> data;
+  const auto add = [&](const int t_size, const int size, const void* p) {
+    TreeSection s;
+    memset(&s,0,sizeof(s));
+    s.t_size = t_size;
+    s.size = size;
+    sections.push_back(s);
+    data.push_back((const char*)p);
+  };
+  add(sizeof(int),tree.p.size(),tree.p.data());
+  add(sizeof(Range<int>),tree.ranges.size(),tree.ranges.data());
+  add(sizeof(Box<TV>),tree.boxes.size(),tree.boxes.data());
+  add(sizeof(Vector<int,2>),tree.explicit_children.size(),tree.explicit_children.data());
+  if (d)
+    add(simplex_size,tree.p.size(),simplices);
+
+  // Lay out data
+  const auto align = [](const uint64_t n) { return (n+tree_alignment-1)/tree_alignment*tree_alignment; };
+  uint64_t offset = align(sizeof(TreeHeader)+sections.size()*sizeof(TreeSection));
+  for (auto& s : sections) {
+    s.offset = offset;
+    offset = align(offset+uint64_t(s.t_size)*s.size);
+  }
+
+  // Write
+  TreeHeader h;
+  memset(&h,0,sizeof(h));
+  memcpy(h.magic,tree_magic,sizeof(h.magic));
+  h.version = tree_version;
+  h.endian = tree_endian;
+  h.m = TV::m;
+  h.d = d;
+  h.scalar_size = sizeof(typename TV::Scalar);
+  h.leaf_size = tree.leaf_size;
+  h.depth = tree.depth;
+  h.sections = int(sections.size());
+  h.content_hash = hash;
+  const shared_ptr<FILE> f(fopen(filename.c_str(),"wb"),[](FILE* f) { if (f) fclose(f); });
+  if (!f)
+    throw IOError(format("can't open '%s' for writing: %s",filename,strerror(errno)));
+  const auto put = [&](const void* p, const size_t n) {
+    if (fwrite(p,1,n,f.get()) < n)
+      throw IOError(format("write_tree: failed to write '%s': %s",filename,strerror(errno)));
+  };
+  put(&h,sizeof(h));
+  put(sections.data(),sections.size()*sizeof(TreeSection));
+  uint64_t written = sizeof(h)+sections.size()*sizeof(TreeSection);
+  static const char zeros[tree_alignment] = {0};
+  for (const int i : range(int(sections.size()))) {
+    const auto& s = sections[i];
+    put(zeros,s.offset-written);
+    put(data[i],size_t(s.t_size)*s.size);
+    written = s.offset+uint64_t(s.t_size)*s.size;
+  }
+  put(zeros,offset-written);
+}
+
+namespace {
+// A mapped tree file, checked against the expected dimensions
+template<class TV> struct TreeFile {
+  const string filename;
+  const Ref<const MappedBuffer> buffer;
+  TreeHeader h;
+  const TreeSection* sections;
+
+  TreeFile(const string& filename, const int d)
+    : filename(filename), buffer(map_file(filename,true)) {
+    const auto& file = buffer->file;
+    if (file.size < sizeof(h))
+      throw fail("incomplete header");
+    memcpy(&h,file.data,sizeof(h));
+    if (memcmp(h.magic,tree_magic,sizeof(h.magic)))
+      throw fail("bad magic string");
+    if (h.version != tree_version)
+      throw fail(format("unsupported version %u, expected %u",h.version,tree_version));
+    if (h.endian != tree_endian)
+      throw fail("written with a different byte order");
+    if (h.m != TV::m || h.d != d || h.scalar_size != int(sizeof(typename TV::Scalar)))
+      throw fail(format("expected a %s in %d dimensions, got %s in %d dimensions",
+        d ? format("%d-simplex tree",d) : "box tree",TV::m,h.d ? format("%d-simplex tree",h.d) : "box tree",h.m));
+    if (h.sections != TreeSimplices+(d>0) || (file.size-sizeof(h))/sizeof(TreeSection) < size_t(h.sections))
+      throw fail("incomplete section table");
+    sections = (const TreeSection*)(file.data+sizeof(h));
+  }
+
+  IOError fail(const string& error) const {
+    return IOError(format("invalid tree file '%s': %s",filename,error));
+  }
+
+  // Point an array directly at a section of the mapping
+  template<class T> Array<T> section(const int i) const {
+    const auto& file = buffer->file;
+    const auto& s = sections[i];
+    if (s.t_size != int(sizeof(T)))
+      throw fail(format("section %d has element size %d, expected %d",i,s.t_size,int(sizeof(T))));
+    if (s.size < 0 || s.offset%tree_alignment || s.offset > file.size || (file.size-s.offset)/s.t_size < size_t(s.size))
+      throw fail(format("section %d is out of bounds",i));
+    return Array<T>(s.size,(T*)(file.data+s.offset),buffer.borrow_owner());
+  }
+
+  Ref<BoxTree<TV>> tree() const {
+    const auto p = section<const int>(TreePrims);
+    const auto ranges = section<const Range<int>>(TreeRanges);
+    const auto boxes = section<Box<TV>>(TreeBoxes);
+    const auto children = section<const Vector<int,2>>(TreeChildren);
+    const int n = p.size(), nodes = boxes.size();
+    if (   h.leaf_size <= 0 || h.depth < 0 || ranges.size() != nodes || nodes%2 != int(n>0)
+        || (children.size() && children.size() != nodes/2))
+      throw fail("inconsistent sizes");
+    // Check just enough for traversals to stay in bounds
+    for (const auto& r : ranges)
+      if (!(0<=r.lo && r.lo<=r.hi && r.hi<=n))
+        throw fail("prim range out of bounds");
+    for (const int i : range(children.size()))
+      if (!(i<children[i].min() && children[i].max()<nodes))
+        throw fail("child out of bounds");
+    for (const int i : p)
+      if (unsigned(i) >= unsigned(n))
+        throw fail("prim out of bounds");
+    return new_<BoxTree<TV>>(h.leaf_size,h.depth,p,ranges,boxes,children);
+  }
+};
+}
+
+template<class TV> void write_box_tree(const string& filename, const BoxTree<TV>& tree) {
+  write_tree(filename,tree,0,0,0,0);
+}
+
+template<class TV> Ref<BoxTree<TV>> read_box_tree(const string& filename) {
+  return TreeFile<TV>(filename,0).tree();
+}
+
+template<class TV,int d> void write_simplex_tree(const string& filename, const SimplexTree<TV,d>& tree) {
+  typedef typename SimplexTree<TV,d>::Simplex Simplex;
+  write_tree(filename,tree,d,content_hash<TV,d>(tree.mesh,tree.X),(const char*)tree.simplices.data(),
+             sizeof(Simplex));
+}
+
+template<class TV,int d> Ref<SimplexTree<TV,d>>
+read_simplex_tree(const string& filename, const typename SimplexTree<TV,d>::Mesh& mesh, Array<const TV> X) {
+  typedef typename SimplexTree<TV,d>::Simplex Simplex;
+  GEODE_ASSERT(mesh.nodes()<=X.size());
+  const TreeFile<TV> file(filename,d);
+  if (file.h.content_hash != content_hash<TV,d>(mesh,X))
+    throw file.fail("built for a different mesh or positions");
+  const auto tree = file.tree();
+  const auto simplices = file.template section<Simplex>(TreeSimplices);
+  if (tree->p.size() != mesh.elements.size() || simplices.size() != mesh.elements.size())
+    throw file.fail("inconsistent sizes");
+  return new_<SimplexTree<TV,d>>(mesh,X,*tree,simplices);
+}
+
+#define INSTANTIATE_BOX(m) \
+  template GEODE_CORE_EXPORT void write_box_tree(const string&,const BoxTree<Vector<real,m>>&); \
+  template GEODE_CORE_EXPORT Ref<BoxTree<Vector<real,m>>> read_box_tree(const string&);
+#define INSTANTIATE_SIMPLEX(m,d) \
+  template GEODE_CORE_EXPORT void write_simplex_tree(const string&,const SimplexTree<Vector<real,m>,d>&); \
+  template GEODE_CORE_EXPORT Ref<SimplexTree<Vector<real,m>,d>> read_simplex_tree( \
+    const string&,const SimplexTree<Vector<real,m>,d>::Mesh&,Array<const Vector<real,m>>);
+INSTANTIATE_BOX(2)
+INSTANTIATE_BOX(3)
+INSTANTIATE_SIMPLEX(2,1)
+INSTANTIATE_SIMPLEX(2,2)
+INSTANTIATE_SIMPLEX(3,1)
+INSTANTIATE_SIMPLEX(3,2)
+
+}
+using namespace geode;
+
+template<class TV,int d> static void wrap_helper() {
+  static const string suffix = format("%s_tree_%dd",d==1?"segment":"triangle",TV::m),
+                      write = "write_"+suffix,
+                      read = "read_"+suffix;
+  python::function(write.c_str(),write_simplex_tree<TV,d>);
+  python::function(read.c_str(),read_simplex_tree<TV,d>);
+}
+
+void wrap_tree_io() {
+  wrap_helper<Vector<real,2>,1>();
+  wrap_helper<Vector<real,2>,2>();
+  wrap_helper<Vector<real,3>,1>();
+  wrap_helper<Vector<real,3>,2>();
+}
@@ -0,0 +1,27 @@
+// Native binary files for BoxTree and SimplexTree
+//
+// Building a tree over a large static mesh can take much longer than loading the mesh, so trees can be saved next to
+// their meshes and reloaded without rebuilding.  Files hold the permutation, ranges, boxes, and children of the tree
+// and, for simplex trees, the simplices, each 64 byte aligned as in write_native_mesh.  Reading maps the file and
+// points the arrays directly at the mapping.  The mapping is private, so update() and friends never touch the file.
+// Like native meshes, files are specific to the byte order and C++ ABI that wrote them; use them as caches.
+//
+// A simplex tree file records a 64 bit hash of the mesh elements and positions it was built for, and
+// read_simplex_tree throws IOError if the mesh and positions it is given hash differently, so stale caches are caught
+// instead of silently returning wrong answers.  Hashing reads the mesh once, in parallel, which is far cheaper than a
+// rebuild.
+#pragma once
+
+#include <geode/geometry/SimplexTree.h>
+#include <geode/utility/format.h>
+namespace geode {
+
+template<class TV> GEODE_CORE_EXPORT void write_box_tree(const string& filename, const BoxTree<TV>& tree);
+template<class TV> GEODE_CORE_EXPORT Ref<BoxTree<TV>> read_box_tree(const string& filename);
+
+template<class TV,int d> GEODE_CORE_EXPORT void write_simplex_tree(const string& filename,
+                                                                   const SimplexTree<TV,d>& tree);
+template<class TV,int d> GEODE_CORE_EXPORT Ref<SimplexTree<TV,d>>
+read_simplex_tree(const string& filename, const typename SimplexTree<TV,d>::Mesh& mesh, Array<const TV> X);
+
+}
@@ -2,6 +2,8 @@
 #ifdef GEODE_OPENEXR
 #include <OpenEXR/ImfRgbaFile.h>
 #include <OpenEXR/ImfArray.h>
+#include <OpenEXR/ImfTestFile.h>
+#include <OpenEXR/ImfTiledRgbaFile.h>
 #endif
 
 #include <geode/image/ExrFile.h>
@@ -9,6 +11,8 @@
 #include <geode/array/Array2d.h>
 #include <geode/vector/Vector3d.h>
 #include <geode/utility/Log.h>
+#include <geode/utility/parallel.h>
+#include <vector>
 
 namespace geode {
 #ifndef GEODE_OPENEXR
@@ -28,6 +32,32 @@ namespace geode {
   template<class T> bool ExrFile<T>::
   is_supported()
   {return false;}
+
+  template<class T> Vector<int,2> ExrFile<T>::
+  size(const std::string& filename)
+  {
+    GEODE_FATAL_ERROR("Not compiled with GEODE_OPENEXR.  Cannot read exr image.");
+  }
+
+  template<class T> Array<Vector<T,3>,2> ExrFile<T>::
+  read_region(const std::string& filename, const Vector<int,2> lo, const Vector<int,2> hi)
+  {
+    GEODE_FATAL_ERROR("Not compiled with GEODE_OPENEXR.  Cannot read exr image.");
+  }
+
+  template<class T> void ExrFile<T>::
+  read_strips(const std::string& filename, const int rows,
+              const function<void(int,RawArray<const Vector<T,3>,2>)>& f)
+  {
+    GEODE_FATAL_ERROR("Not compiled with GEODE_OPENEXR.  Cannot read exr image.");
+  }
+
+  template<class T> void ExrFile<T>::
+  write_strips(const std::string& filename, const Vector<int,2> size, const int rows,
+               const function<void(int,RawArray<Vector<T,3>,2>)>& fill, const int tile_size)
+  {
+    GEODE_FATAL_ERROR("Not compiled with GEODE_OPENEXR.  Cannot write exr image.");
+  }
   
 #else
 
@@ -107,6 +137,120 @@ namespace geode {
   is_supported()
   {
     return true;
+  }
+
+  template<class T> Vector<int,2> ExrFile<T>::
+  size(const std::string& filename)
+  {
+    Imf::RgbaInputFile file(filename.c_str(),thread_count());
+    const Imath::Box2i dw = file.dataWindow();
+    return vec(dw.max.x-dw.min.x+1,dw.max.y-dw.min.y+1);
+  }
+
+  // Copy a block of rgba pixels stored row by row into an (x,y) image, in parallel over x
+  template<class T> static void from_rgba_block(const Imf::Rgba* pixels, const int stride,
+                                                RawArray<Vector<T,3>,2> image) {
+    parallel_for(image.m,[&](const int i) {
+      for (int j=0;j<image.n;j++)
+        image(i,j) = from_rgba<T>(pixels[j*stride+i]);
+    },64);
+  }
+
+  template<class T> Array<Vector<T,3>,2> ExrFile<T>::
+  read_region(const std::string& filename, const Vector<int,2> lo, const Vector<int,2> hi)
+  {
+    const auto sizes = size(filename);
+    GEODE_ASSERT(lo.min()>=0 && lo.x<=hi.x && lo.y<=hi.y && hi.x<=sizes.x && hi.y<=sizes.y);
+    Array<Vector<T,3>,2> image(hi-lo,uninit);
+    if (!image.flat.size())
+      return image;
+
+    if (Imf::isTiledOpenExrFile(filename.c_str())) {
+      // Decode only the tiles overlapping the region, into a buffer covering those tiles
+      Imf::TiledRgbaInputFile file(filename.c_str(),thread_count());
+      const Imath::Box2i dw = file.dataWindow();
+      const int tx = file.tileXSize(), ty = file.tileYSize();
+      const Vector<int,2> tlo(lo.x/tx,lo.y/ty), thi((hi.x-1)/tx,(hi.y-1)/ty), // Inclusive tile range
+                          blo(tx*tlo.x,ty*tlo.y);
+      const int width = tx*(thi.x-tlo.x+1);
+      std::vector<Imf::Rgba> pixels(size_t(width)*ty*(thi.y-tlo.y+1));
+      file.setFrameBuffer(&pixels[0]-(dw.min.x+blo.x)-ptrdiff_t(dw.min.y+blo.y)*width,1,width);
+      file.readTiles(tlo.x,thi.x,tlo.y,thi.y);
+      from_rgba_block<T>(&pixels[(lo.y-blo.y)*width+lo.x-blo.x],width,image);
+    } else {
+      // Decode only the scanlines overlapping the region
+      Imf::RgbaInputFile file(filename.c_str(),thread_count());
+      const Imath::Box2i dw = file.dataWindow();
+      const int width = sizes.x;
+      std::vector<Imf::Rgba> pixels(size_t(width)*(hi.y-lo.y));
+      file.setFrameBuffer(&pixels[0]-dw.min.x-ptrdiff_t(dw.min.y+lo.y)*width,1,width);
+      file.readPixels(dw.min.y+lo.y,dw.min.y+hi.y-1);
+      from_rgba_block<T>(&pixels[lo.x],width,image);
+    }
+    return image;
+  }
+
+  template<class T> void ExrFile<T>::
+  read_strips(const std::string& filename, const int rows,
+              const function<void(int,RawArray<const Vector<T,3>,2>)>& f)
+  {
+    GEODE_ASSERT(rows>0);
+    Imf::RgbaInputFile file(filename.c_str(),thread_count());
+    const Imath::Box2i dw = file.dataWindow();
+    const int width = dw.max.x-dw.min.x+1,
+              height = dw.max.y-dw.min.y+1;
+    std::vector<Imf::Rgba> pixels(size_t(width)*rows);
+    Array<Vector<T,3>,2> strip(width,rows,uninit);
+    for (int y0=0;y0<height;y0+=rows) {
+      const int n = min(rows,height-y0);
+      file.setFrameBuffer(&pixels[0]-dw.min.x-ptrdiff_t(dw.min.y+y0)*width,1,width);
+      file.readPixels(dw.min.y+y0,dw.min.y+y0+n-1);
+      const RawArray<Vector<T,3>,2> part(width,n,strip.data()); // The last strip may be short
+      from_rgba_block(&pixels[0],width,part);
+      f(y0,part);
+    }
+  }
+
+  template<class T> void ExrFile<T>::
+  write_strips(const std::string& filename, const Vector<int,2> size, const int rows,
+               const function<void(int,RawArray<Vector<T,3>,2>)>& fill, const int tile_size)
+  {
+    GEODE_ASSERT(size.min()>0 && rows>0);
+    GEODE_ASSERT(tile_size>=0 && (!tile_size || rows%tile_size==0));
+    const int width = size.x, height = size.y;
+    std::vector<Imf::Rgba> pixels(size_t(width)*rows);
+    Array<Vector<T,3>,2> strip(width,rows,uninit);
+
+    // Fill the strip starting at y0, and convert it to rgba in row order
+    const auto next = [&](const int y0) -> int {
+      const int n = min(rows,height-y0);
+      const RawArray<Vector<T,3>,2> part(width,n,strip.data());
+      fill(y0,part);
+      parallel_for(n,[&](const int j) {
+        for (int i=0;i<width;i++)
+          pixels[size_t(j)*width+i] = to_rgba(part(i,j));
+      },16);
+      return n;
+    };
+
+    if (tile_size) {
+      Imf::TiledRgbaOutputFile file(filename.c_str(),width,height,tile_size,tile_size,Imf::ONE_LEVEL,Imf::ROUND_DOWN,
+                                    Imf::WRITE_RGBA,1,Imath::V2f(0,0),1,Imf::INCREASING_Y,Imf::ZIP_COMPRESSION,
+                                    thread_count());
+      for (int y0=0;y0<height;y0+=rows) {
+        const int n = next(y0);
+        file.setFrameBuffer(&pixels[0]-ptrdiff_t(y0)*width,1,width);
+        file.writeTiles(0,file.numXTiles()-1,y0/tile_size,(y0+n-1)/tile_size);
+      }
+    } else {
+      Imf::RgbaOutputFile file(filename.c_str(),width,height,Imf::WRITE_RGBA,1,Imath::V2f(0,0),1,Imf::INCREASING_Y,
+                               Imf::ZIP_COMPRESSION,thread_count());
+      for (int y0=0;y0<height;y0+=rows) {
+        const int n = next(y0);
+        file.setFrameBuffer(&pixels[0]-ptrdiff_t(y0)*width,1,width);
+        file.writePixels(n);
+      }
+    }
   }  
   
 #endif
@@ -1,9 +1,17 @@
 //#####################################################################
 // Class ExrFile
 //#####################################################################
+//
+// Besides whole image read and write, images too large to hold in memory
+// can be streamed in strips of rows, and a region can be read without
+// decoding the rest of the file.  Images are indexed (x,y), with y the
+// scanline.  Compression and decompression use thread_count() threads.
+//
+//#####################################################################
 #pragma once
 
 #include <geode/array/forward.h>
+#include <geode/utility/function.h>
 #include <geode/vector/forward.h>
 #include <string>
 namespace geode {
@@ -13,6 +21,25 @@ public:
 GEODE_CORE_EXPORT static Array<Vector<T,3>,2> read(const std::string& filename);
 GEODE_CORE_EXPORT static void write(const std::string& filename,RawArray<const Vector<T,3>,2> image);
 GEODE_CORE_EXPORT static bool is_supported();
+
+// Width and height of the data window
+GEODE_CORE_EXPORT static Vector<int,2> size(const std::string& filename);
+
+// Read pixels [lo,hi) only, indexed relative to lo.  Only the scanlines (or for tiled files, the tiles) overlapping
+// the region are decoded.
+GEODE_CORE_EXPORT static Array<Vector<T,3>,2> read_region(const std::string& filename, const Vector<int,2> lo,
+                                                          const Vector<int,2> hi);
+
+// Stream an image in strips of up to rows scanlines, calling f(y0,strip) with strip indexed (x,y-y0).  Only one strip
+// is held in memory at a time.
+GEODE_CORE_EXPORT static void read_strips(const std::string& filename, const int rows,
+                                          const function<void(int,RawArray<const Vector<T,3>,2>)>& f);
+
+// Write a width x height image in strips of rows scanlines, calling fill(y0,strip) to compute each strip in turn.  If
+// tile_size is positive, the file is tiled with square tiles of that size, which rows must be a multiple of.
+GEODE_CORE_EXPORT static void write_strips(const std::string& filename, const Vector<int,2> size, const int rows,
+                                           const function<void(int,RawArray<Vector<T,3>,2>)>& fill,
+                                           const int tile_size=0);
 };
 
 }
@@ -1,18 +1,21 @@
 //#####################################################################
 // Class Image
 //#####################################################################
+#include <geode/array/view.h>
 #include <geode/geometry/Box.h>
 #include <geode/image/Image.h>
 #include <geode/image/JpgFile.h>
 #include <geode/image/PngFile.h>
 #include <geode/image/ExrFile.h>
+#include <geode/math/optimal_sort.h>
 #include <geode/python/Class.h>
 #include <geode/python/stl.h>
 #include <geode/utility/convert_case.h>
-#include <geode/random/Random.h>
 #include <geode/utility/path.h>
 #include <geode/utility/Log.h>
+#include <geode/utility/parallel.h>
 #include <cmath>
+#include <cstring>
 
 namespace geode {
 
@@ -67,53 +70,118 @@ write_png_to_memory(RawArray<const Vector<T,4>,2> image) {
   return PngFile<T>::write_to_memory(image);
 }
 
+// Uniform noise in [0,1) for pixel (x,y) and component a
+static inline float dither_noise(const int x, const int y, const int a) {
+  uint32_t h = uint32_t(x)*0x9e3779b1u^uint32_t(y)*0x85ebca77u^uint32_t(a)*0xc2b2ae3du;
+  h ^= h>>16;
+  h *= 0x7feb352du;
+  h ^= h>>15;
+  h *= 0x846ca68bu;
+  h ^= h>>16;
+  return float(h>>8)*(1.f/(1<<24));
+}
+
 template<class T> Array<Vector<T,3>,2> Image<T>::
 gamma_compress(Array<const Vector<T,3>,2> image,const real gamma)
 {
-    T one_over_gamma = T(1/gamma);
-    Array<Vector<T,3>,2> result(image.sizes());
-    for(int t=0;t<result.flat.size();t++)
-      for (int i = 0; i < 3; ++i)
-        result.flat[t][i] = pow(image.flat(t)[i],one_over_gamma);
+    const T one_over_gamma = T(1/gamma);
+    Array<Vector<T,3>,2> result(image.sizes(),uninit);
+    const RawArray<const T> in = scalar_view(image.flat);
+    const RawArray<T> out = scalar_view(result.flat);
+    // Flat blocks of components, so that the loop is a simple stream
+    const int block = 4096;
+    parallel_for((in.size()+block-1)/block,[&](const int b) {
+      const int lo = block*b, hi = min(in.size(),lo+block);
+      if (one_over_gamma==1)
+        for (int t=lo;t<hi;t++)
+          out[t] = in[t];
+      else if (one_over_gamma==T(.5))
+        for (int t=lo;t<hi;t++)
+          out[t] = sqrt(in[t]);
+      else
+        for (int t=lo;t<hi;t++)
+          out[t] = pow(in[t],one_over_gamma);
+    });
     return result;
 }
 
 template<class T> Array<Vector<T,3>,2> Image<T>::
 dither(Array<const Vector<T,3>,2> image)
 {
-    Ref<Random> random=new_<Random>(324032); // want uniform seed so noise perturbation pattern is temporally coherent
-
-    Array<Vector<T,3>,2> result(image.sizes());
-    for(int t=0;t<result.flat.size();t++){
-        result.flat(t)=image.flat(t);
-        Vector<T,3> pixel_values((T)255*result.flat(t));
-        Vector<int,3> floored_values((int)pixel_values[0],(int)pixel_values[1],(int)pixel_values[2]);
-        Vector<real,3> random_stuff=random->uniform<Vector<real,3> >(0,1);
-        Vector<T,3> normalized_values=pixel_values-Vector<T,3>(floored_values);
-        for(int k=0;k<3;k++)
-            if(random_stuff[k]>normalized_values[k]) result.flat(t)[k]=(floored_values[k]+(T).5001)/255; // use normal quantized floor
-            else result.flat(t)[k]=(floored_values[k]+(T)1.5001)/255;} // jump to next value
+    // The noise is a hash of the pixel index rather than a random stream, so the pattern is the same for every
+    // frame (temporally coherent) and pixels can be dithered independently in parallel.
+    Array<Vector<T,3>,2> result(image.sizes(),uninit);
+    const int block = 1024;
+    parallel_for((image.flat.size()+block-1)/block,[&](const int b) {
+      const int lo = block*b, hi = min(image.flat.size(),lo+block);
+      for (int t=lo;t<hi;t++)
+        for (int k=0;k<3;k++) {
+          const T v = 255*image.flat[t][k];
+          const int floored = int(v);
+          result.flat[t][k] = (floored+(dither_noise(t,0,k)>v-floored ? T(.5001) // use normal quantized floor
+                                                                        : T(1.5001)))/255; // jump to next value
+        }
+    });
     return result;
 }
 
+// Sort a[l],b[l] for each lane l.  Branch free, so it vectorizes.
+template<class T> static inline void compare_lanes(T* a, T* b, const int lanes) {
+  for (int l=0;l<lanes;l++) {
+    const T x = a[l], y = b[l];
+    a[l] = min(x,y);
+    b[l] = max(x,y);
+  }
+}
+
+// The median of n samples per lane for a block of lanes, stored as samples[k*lanes+lane].  Small n use an optimal
+// sorting network with each comparator applied to all lanes at once.
+template<class T> static void median_block(const int n, T* samples, const int lanes, T* result) {
+  #define GEODE_MEDIAN_C(i,j) compare_lanes(samples+(i)*lanes,samples+(j)*lanes,lanes);
+  #define GEODE_MEDIAN_L()
+  #define CASE(n) case n: GEODE_SORT_NETWORK(n,GEODE_MEDIAN_C,GEODE_MEDIAN_L) break;
+  switch (n) {
+    CASE(1) CASE(2) CASE(3) CASE(4) CASE(5) CASE(6) CASE(7) CASE(8) CASE(9) CASE(10)
+    default: {
+      // Too many samples for a network, so select per lane
+      vector<T> lane(n);
+      for (int l=0;l<lanes;l++) {
+        for (int k=0;k<n;k++)
+          lane[k] = samples[k*lanes+l];
+        nth_element(lane.begin(),lane.begin()+n/2,lane.end());
+        result[l] = lane[n/2];
+      }
+      return;
+    }
+  }
+  #undef CASE
+  #undef GEODE_MEDIAN_L
+  #undef GEODE_MEDIAN_C
+  memcpy(result,samples+n/2*lanes,sizeof(T)*lanes);
+}
+
 template<class T>
 Array<Vector<T,3>,2> Image<T>::median(const vector<Array<const Vector<T,3>,2> >& images) {
   GEODE_ASSERT(images.size());
-  int n = (int)images.size();
+  const int n = (int)images.size();
   for (int k=1;k<n;k++)
     GEODE_ASSERT(images[0].sizes()==images[k].sizes());
 
-  Array<T,2> pixel(3,n);
-  Array<Vector<T,3>,2> result(images[0].sizes());
-  for(int t=0; t<result.flat.size(); t++){
+  // Process blocks of components in parallel, transposing each block so that sample k of every component is
+  // contiguous.  The median of each component is sample n/2 in sorted order, the upper median if n is even.
+  vector<RawArray<const T>> flats;
+  for (const auto& image : images)
+    flats.push_back(scalar_view(image.flat));
+  Array<Vector<T,3>,2> result(images[0].sizes(),uninit);
+  const RawArray<T> out = scalar_view(result.flat);
+  const int lanes = 256, size = out.size();
+  parallel_for((size+lanes-1)/lanes,[&](const int b) {
+    const int lo = lanes*b, hi = min(size,lo+lanes), m = hi-lo;
+    vector<T> samples(n*m);
     for (int k=0;k<n;k++)
-      images[k].flat[t].get(pixel(0,k),pixel(1,k),pixel(2,k));
-    for (int a=0;a<3;a++) {
-      RawArray<T> samples = pixel[a];
-      nth_element(&samples[0],&samples[n/2],&samples[n-1]);
-      result.flat[t][a] = samples[n/2];
-    }
-  }
+      memcpy(&samples[k*m],&flats[k][lo],sizeof(T)*m);
+    median_block(n,samples.data(),m,&out[lo]);
+  });
   return result;
 }
 
@@ -127,6 +195,60 @@ is_supported(const string& filename)
     else return false;
 }
 
+template<class T,int C> Array<Vector<uint8_t,C>,2> byte_rows(RawArray<const Vector<T,C>,2> image, const double gamma,
+                                                               const bool dither) {
+  const int width = image.m, height = image.n;
+  Array<Vector<uint8_t,C>,2> rows(height,width,uninit);
+  // Blocks of rows are converted together, so that reads of each column of the image are contiguous
+  const int block = 16;
+  parallel_for((height+block-1)/block,[&](const int b) {
+    const int lo = block*b, hi = min(height,lo+block);
+    for (int x=0;x<width;x++) {
+      const auto column = image[x];
+      for (int y=lo;y<hi;y++) {
+        const auto& pixel = column[y];
+        auto& byte = rows(height-1-y,x);
+        for (int a=0;a<C;a++) {
+          if (is_same<T,uint8_t>::value) {
+            byte[a] = uint8_t(pixel[a]);
+            continue;
+          }
+          double v = double(pixel[a]);
+          if (gamma!=1 && a<3)
+            v = pow(max(v,0.),1/gamma);
+          v = 256*v;
+          if (dither)
+            v += dither_noise(x,y,a)-.5;
+          byte[a] = uint8_t(clamp(v,0.,255.));
+        }
+      }
+    }
+  });
+  return rows;
+}
+
+template<class T,int C> Array<Vector<T,C>,2> from_byte_rows(RawArray<const Vector<uint8_t,C>,2> rows) {
+  const int height = rows.m, width = rows.n;
+  Array<Vector<T,C>,2> image(height,width,uninit);
+  parallel_for(height,[&](const int j) {
+    const auto row = rows[height-1-j];
+    const auto out = image[j];
+    for (int i=0;i<width;i++)
+      out[i] = to_scalar_color<T,C>(row[i]);
+  },16);
+  return image;
+}
+
+#define INSTANTIATE_BYTES(T,C) \
+  template GEODE_CORE_EXPORT Array<Vector<uint8_t,C>,2> byte_rows(RawArray<const Vector<T,C>,2>,const double,const bool); \
+  template GEODE_CORE_EXPORT Array<Vector<T,C>,2> from_byte_rows(RawArray<const Vector<uint8_t,C>,2>);
+INSTANTIATE_BYTES(float,3)
+INSTANTIATE_BYTES(float,4)
+INSTANTIATE_BYTES(double,3)
+INSTANTIATE_BYTES(double,4)
+INSTANTIATE_BYTES(uint8_t,3)
+INSTANTIATE_BYTES(uint8_t,4)
+
 template<> uint8_t component_to_scalar_color(const uint8_t color_in) { return color_in; }
 template<> uint8_t component_to_byte_color(const uint8_t color_in) { return color_in; }
 
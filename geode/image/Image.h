@@ -38,6 +38,17 @@ template<class T, int C> Vector<uint8_t, C> to_byte_color(const Vector<T, C> col
   return result;
 }
 
+// Convert an image indexed (x,y) with y up, as taken by the write functions, to rows of bytes indexed (row,x) with
+// row 0 at the top, as stored in files.  Pixels are first gamma compressed by x^(1/gamma) if gamma isn't 1.  With
+// dither, a stateless per pixel noise is added before rounding, so the mean over many pixels is preserved and the
+// result doesn't depend on the thread count.  Rows are converted in parallel.  Byte images are copied unchanged.
+template<class T,int C> GEODE_CORE_EXPORT Array<Vector<uint8_t,C>,2>
+byte_rows(RawArray<const Vector<T,C>,2> image, const double gamma=1, const bool dither=false);
+
+// Convert rows of bytes with row 0 at the top to an image indexed (height-1-row,x), as returned by the read
+// functions, in parallel
+template<class T,int C> GEODE_CORE_EXPORT Array<Vector<T,C>,2> from_byte_rows(RawArray<const Vector<uint8_t,C>,2> rows);
+
 // Read functions return Arrays constructed from row major data that end up 'transposed' (i.e. width = sizes().y and height = sizes().x) but can be directly passed to openGL
 // The write functions currently take column major data and require a transpose() for data comeing from a read or openGL
 template<class T>
@@ -43,20 +43,19 @@ read(const std::string& filename)
     cinfo.err=jpeg_std_error(&error_manager);error_manager.error_exit=read_error;
     jpeg_create_decompress(&cinfo);jpeg_stdio_src(&cinfo,infile);jpeg_read_header(&cinfo,TRUE);jpeg_start_decompress(&cinfo);
 
+    // Entropy decoding is serial, so decode all scanlines first and convert in parallel
     row_stride=cinfo.output_width*cinfo.output_components;
-    JSAMPLE* row=new unsigned char[row_stride];JSAMPROW row_pointer[]={row};
+    GEODE_ASSERT(cinfo.output_components==3);
     Log::cerr<<"reading "<<filename<<": "<<row_stride/3<<" x "<<cinfo.output_height<<std::endl;
 
-    Array<Vector<T,3>,2> image(cinfo.output_height,cinfo.output_width,uninit);
+    Array<Vector<unsigned char,3>,2> rows(cinfo.output_height,cinfo.output_width,uninit);
     while(cinfo.output_scanline<cinfo.output_height){
-        jpeg_read_scanlines(&cinfo,row_pointer,1);int index=0;
-        for(int i=0;i<image.n;i++){
-            unsigned char r=row[index++],g=row[index++],b=row[index++];
-            image(image.m-cinfo.output_scanline,i)=Image<T>::to_scalar_color(Vector<unsigned char,3>(r,g,b));}}
-    jpeg_finish_decompress(&cinfo);jpeg_destroy_decompress(&cinfo);delete[] row;
+        JSAMPROW row_pointer[]={(JSAMPLE*)rows[cinfo.output_scanline].data()};
+        jpeg_read_scanlines(&cinfo,row_pointer,1);}
+    jpeg_finish_decompress(&cinfo);jpeg_destroy_decompress(&cinfo);
 
     fclose(infile);
-    return image;
+    return from_byte_rows<T,3>(rows);
 }
 //#####################################################################
 // Function Write
@@ -78,12 +77,11 @@ write(const std::string& filename,RawArray<const Vector<T,3>,2> image)
     jpeg_set_defaults(&cinfo);jpeg_set_quality(&cinfo,95,TRUE); // limit to baseline-Jpeg values
     jpeg_start_compress(&cinfo,TRUE);
 
-    int row_stride=cinfo.image_width*3; // JSAMPLEs per row in image_buffer
-    JSAMPLE* row=new unsigned char[row_stride];JSAMPROW row_pointer[]={row};
+    // Convert in parallel, then feed scanlines to the serial encoder
+    const auto rows=byte_rows(image);
     while(cinfo.next_scanline < cinfo.image_height){
-        int index=0;for(int i=0;i<image.m;i++){Vector<unsigned char,3> pixel=Image<T>::to_byte_color(image(i,image.n-1-cinfo.next_scanline));row[index++]=pixel.x;row[index++]=pixel.y;row[index++]=pixel.z;} // copy row
+        JSAMPROW row_pointer[]={(JSAMPLE*)rows[cinfo.next_scanline].data()};
         jpeg_write_scanlines(&cinfo,row_pointer,1);}
-    delete[] row;
     jpeg_finish_compress(&cinfo);
     fclose(outfile);
     jpeg_destroy_compress(&cinfo);
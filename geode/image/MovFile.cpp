@@ -73,73 +73,144 @@ public:
     {return start_offset;}
 };
 
+// A frame copied out of the caller's array, so the writer thread never touches python owned memory
+struct MovWriter::Frame {
+  int width,height;
+  std::vector<Vector<T,3>> pixels; // Indexed (i,j) as i*height+j, like the input array
+};
+
 MovWriter::
-MovWriter(const std::string& filename,const int frames_per_second)
-    :frames_per_second(frames_per_second),width(0),height(0)
+MovWriter(const std::string& filename,const int frames_per_second,const int max_queued)
+    :frames_per_second(frames_per_second),width(0),height(0),max_queued(max_queued),busy(false),stopping(false)
 {
     GEODE_ASSERT(enabled());
+    GEODE_ASSERT(max_queued>0);
     fp=fopen(filename.c_str(),"wb");
     if(!fp) GEODE_FATAL_ERROR(format("Failed to open %s for writing",filename));
     current_mov=new QtAtom(fp,"mdat");
+    writer=std::thread([this]() { run(); });
 }
 
 MovWriter::
 ~MovWriter()
 {
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        stopping=true;
+    }
+    changed.notify_all();
+    writer.join();
+    error=std::exception_ptr(); // Destructors can't throw, so drop any error nobody asked about
     delete current_mov;
     write_footer();
     fclose(fp);
 }
 
-void MovWriter::
-add_frame(const Array<Vector<T,3>,2>& image)
-{
 #ifdef GEODE_LIBJPEG
-/*
-    static int frame=0;
-    Image<T>::write(format("capture.%02d.jpg",frame),image);
-    frame++;
-*/
-
+// Encode one frame as a jpeg at the end of fp
+static void write_jpeg(FILE* fp, const int width, const int height, const Vector<real,3>* pixels)
+{
     struct jpeg_compress_struct cinfo;
     struct jpeg_error_mgr jerr;
-    if(width==0 && height==0){width=image.m;height=image.n;}
-    if(width!=image.m || height!=image.n) throw RuntimeError("Frame does not have same size as previous frame(s)");
-
     cinfo.err=jpeg_std_error(&jerr);
     jpeg_create_compress(&cinfo);
-    long frame_begin=ftell(fp);
     jpeg_stdio_dest(&cinfo,fp);
-    cinfo.image_width=image.m;
-    cinfo.image_height=image.n;
+    cinfo.image_width=width;
+    cinfo.image_height=height;
     cinfo.input_components=3;
     cinfo.in_color_space=JCS_RGB; // colorspace of input image
     jpeg_set_defaults(&cinfo);
     jpeg_set_quality(&cinfo,95,TRUE); // limit to baseline-Jpeg values
     jpeg_start_compress(&cinfo,TRUE);
 
-    int row_stride=cinfo.image_width*3; // JSAMPLEs per row in image_buffer
-    JSAMPLE* row=new JSAMPLE[row_stride];
-    JSAMPROW row_pointer[]={row};
+    std::vector<JSAMPLE> row(3*width); // JSAMPLEs per row in image_buffer
+    JSAMPROW row_pointer[]={row.data()};
     while(cinfo.next_scanline < cinfo.image_height){
         int index=0;
-        for(int i=0;i<image.m;i++){ // copy row
-            Vector<unsigned char,3> pixel=Image<T>::to_byte_color(image(i,image.n-cinfo.next_scanline-1));
+        for(int i=0;i<width;i++){ // copy row
+            Vector<unsigned char,3> pixel=Image<real>::to_byte_color(pixels[i*height+height-cinfo.next_scanline-1]);
             row[index++]=pixel.x;row[index++]=pixel.y;row[index++]=pixel.z;}
         jpeg_write_scanlines(&cinfo,row_pointer,1);}
-    delete[] row;
     jpeg_finish_compress(&cinfo);
     jpeg_destroy_compress(&cinfo);
-    long frame_end=ftell(fp);
-    sample_lengths.append(int(frame_end-frame_begin));
-    sample_offsets.append(int(frame_begin-current_mov->offset()));
+}
+#endif
+
+void MovWriter::
+run()
+{
+    for(;;){
+        std::unique_ptr<Frame> frame;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock,[this]() { return stopping || !queue.empty(); });
+            if(queue.empty()) return; // Stopping, and everything is written
+            frame=std::move(queue.front());
+            queue.pop_front();
+            busy=true;
+        }
+        changed.notify_all(); // Room in the queue
+        try {
+#ifdef GEODE_LIBJPEG
+            const long frame_begin=ftell(fp);
+            write_jpeg(fp,frame->width,frame->height,frame->pixels.data());
+            const long frame_end=ftell(fp);
+            sample_lengths.push_back(int(frame_end-frame_begin));
+            sample_offsets.push_back(int(frame_begin-current_mov->offset()));
 #endif
+        } catch (...) {
+            std::unique_lock<std::mutex> lock(mutex);
+            if(!error) error=std::current_exception();
+        }
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            busy=false;
+        }
+        changed.notify_all();
+    }
+}
+
+void MovWriter::
+add_frame(const Array<Vector<T,3>,2>& image)
+{
+    if(width==0 && height==0){width=image.m;height=image.n;}
+    if(width!=image.m || height!=image.n) throw RuntimeError("Frame does not have same size as previous frame(s)");
+
+    // Copy outside the lock, so the writer keeps running while we do
+    std::unique_ptr<Frame> frame(new Frame);
+    frame->width=image.m;
+    frame->height=image.n;
+    frame->pixels.assign(image.flat.data(),image.flat.data()+image.flat.size());
+
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock,[this]() { return error || int(queue.size())<max_queued; });
+    if(error){
+        const auto e=error;
+        error=std::exception_ptr();
+        std::rethrow_exception(e);
+    }
+    queue.push_back(std::move(frame));
+    lock.unlock();
+    changed.notify_all();
+}
+
+void MovWriter::
+drain()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock,[this]() { return queue.empty() && !busy; });
+    if(error){
+        const auto e=error;
+        error=std::exception_ptr();
+        std::rethrow_exception(e);
+    }
 }
 
 void MovWriter::
 write_footer()
 {
-    const int frames=sample_offsets.size();
+    drain();
+    const int frames=int(sample_offsets.size());
     GEODE_ASSERT(sample_offsets.size()==sample_lengths.size());
     QtAtom a(fp,"moov");
         {QtAtom a(fp,"mvhd");
@@ -261,11 +332,11 @@ write_footer()
                             write(fp,(uint)0); // version and flags
                             write(fp,(uint)0); // sample size (non-uniform so zero and table follows)
                             write(fp,(uint)frames); // one entry per frame
-                            for(int i=0;i<sample_lengths.size();i++) write(fp,(uint)sample_lengths(i));}
+                            for(size_t i=0;i<sample_lengths.size();i++) write(fp,(uint)sample_lengths[i]);}
                         {QtAtom a(fp,"stco");
                             write(fp,(uint)0); // version and flags
                             write(fp,(uint)frames); // one entry per frame
-                            for(int i=0;i<sample_offsets.size();i++) write(fp,(uint)sample_offsets(i));}}}}} // offset from begin of file
+                            for(size_t i=0;i<sample_offsets.size();i++) write(fp,(uint)sample_offsets[i]);}}}}} // offset from begin of file
 }
 
 bool MovWriter::
@@ -287,6 +358,7 @@ void wrap_mov()
     Class<Self>("MovWriter")
         .GEODE_INIT(const string&,int)
         .GEODE_METHOD(add_frame)
+        .GEODE_METHOD(drain)
         .GEODE_METHOD(write_footer)
         .GEODE_METHOD(enabled)
         ;
@@ -1,9 +1,23 @@
 //#####################################################################
 // Class MovFile
 //#####################################################################
+//
+// Frames are encoded as jpegs on a background thread, so recording a
+// simulation overlaps with computing it.  add_frame copies the frame into a
+// bounded queue and returns immediately unless the queue is full, in which
+// case it waits for the writer to catch up.  Errors on the writer thread
+// are rethrown by the next add_frame or write_footer.
+//
+//#####################################################################
 #pragma once
 
 #include <geode/array/Array.h>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
 namespace geode {
 
 class QtAtom;
@@ -18,14 +32,33 @@ private:
   int width,height;
   FILE* fp;
   QtAtom* current_mov;
-  Array<int> sample_offsets;
-  Array<int> sample_lengths;
+  std::vector<int> sample_offsets; // Touched only by the writer thread until drained
+  std::vector<int> sample_lengths;
+
+  // Frames waiting to be encoded, shared with the writer thread
+  struct Frame;
+  const int max_queued;
+  std::mutex mutex;
+  std::condition_variable changed;
+  std::deque<std::unique_ptr<Frame>> queue;
+  bool busy; // True while the writer is encoding a frame
+  bool stopping;
+  std::exception_ptr error;
+  std::thread writer;
+
+  void run(); // The writer thread
 
 protected:
-  GEODE_CORE_EXPORT MovWriter(const std::string& filename,const int frames_per_second=24);
+  GEODE_CORE_EXPORT MovWriter(const std::string& filename,const int frames_per_second=24,const int max_queued=4);
 public:
   GEODE_CORE_EXPORT ~MovWriter();
+
+  // Queue a frame for encoding, waiting if max_queued frames are already queued
   GEODE_CORE_EXPORT void add_frame(const Array<Vector<T,3>,2>& image);
+
+  // Wait for all queued frames to be written
+  GEODE_CORE_EXPORT void drain();
+
   GEODE_CORE_EXPORT void write_footer();
   GEODE_CORE_EXPORT static bool enabled();
 };
@@ -10,12 +10,15 @@
 #ifdef GEODE_LIBPNG
 #define PNG_SKIP_SETJMP_CHECK // Both png and python want to be included first
 #include <png.h>
+#include <zlib.h>
 #endif
 #include <geode/image/PngFile.h>
 #include <geode/image/Image.h>
 #include <geode/array/Array2d.h>
 #include <geode/vector/Vector3d.h>
 #include <geode/utility/Log.h>
+#include <geode/utility/parallel.h>
+#include <cstring>
 namespace geode {
 //#####################################################################
 // Read/Write stubs for case of no libpng
@@ -54,9 +57,8 @@ template<class T> bool PngFile<T>::is_supported() {
 //#####################################################################
 // Function Read
 //#####################################################################
-template<class T> Array<Vector<T,3>,2> PngFile<T>::
-read(const std::string& filename)
-{
+// Decode into rows of bytes with libpng.  Decoding a single zlib stream is inherently serial, but conversion isn't.
+template<int C> static Array<Vector<uint8_t,C>,2> read_rows(const std::string& filename, const int transforms) {
     FILE* file=fopen(filename.c_str(),"rb");
     if(!file) throw IOError(format("Failed to open %s for reading",filename));
 
@@ -66,90 +68,168 @@ read(const std::string& filename)
     if(!info_ptr) throw IOError(format("Error reading png file %s",filename));
     if(setjmp(png_jmpbuf(png_ptr))) throw IOError(format("Error reading png file %s",filename));
     png_init_io(png_ptr,file);
-    png_read_png(png_ptr,info_ptr,PNG_TRANSFORM_STRIP_16 | PNG_TRANSFORM_STRIP_ALPHA | PNG_TRANSFORM_PACKING | PNG_TRANSFORM_EXPAND,0);
+    png_read_png(png_ptr,info_ptr,transforms,0);
     const size_t width  = png_get_image_width(png_ptr,info_ptr),
                  height = png_get_image_height(png_ptr,info_ptr);
     GEODE_ASSERT((width+1)*(height+1)<size_t(numeric_limits<int>::max()));
 
-    Array<Vector<T,3>,2> image((int(height)),int(width));
-    Vector<unsigned char,3>** row_pointers=(Vector<unsigned char,3>**)png_get_rows(png_ptr,info_ptr);
-    for(int i=0;i<int(width);i++)
-      for(int j=0;j<int(height);j++)
-        image(j,i) = Image<T>::to_scalar_color(row_pointers[int(height)-j-1][i]);
+    Array<Vector<uint8_t,C>,2> rows((int(height)),int(width),uninit);
+    Vector<uint8_t,C>** row_pointers=(Vector<uint8_t,C>**)png_get_rows(png_ptr,info_ptr);
+    for(int j=0;j<int(height);j++)
+      memcpy(rows[j].data(),row_pointers[j],sizeof(Vector<uint8_t,C>)*width);
 
     png_destroy_read_struct(&png_ptr,&info_ptr,0);
     fclose(file);
-    return image;
+    return rows;
+}
+
+template<class T> Array<Vector<T,3>,2> PngFile<T>::
+read(const std::string& filename)
+{
+    const auto rows = read_rows<3>(filename,PNG_TRANSFORM_STRIP_16 | PNG_TRANSFORM_STRIP_ALPHA | PNG_TRANSFORM_PACKING | PNG_TRANSFORM_EXPAND);
+    return from_byte_rows<T,3>(rows);
 }
 
 template<class T> Array<Vector<T,4>,2> PngFile<T>::
 read_alpha(const std::string& filename)
 {
-    FILE* file=fopen(filename.c_str(),"rb");
-    if(!file) throw IOError(format("Failed to open %s for reading",filename));
+    const auto rows = read_rows<4>(filename,PNG_TRANSFORM_STRIP_16 | PNG_TRANSFORM_PACKING | PNG_TRANSFORM_EXPAND);
+    return from_byte_rows<T,4>(rows);
+}
+//#####################################################################
+// Function Encode
+//#####################################################################
+// Encoding is done directly with zlib so that it can run in parallel.  Rows are filtered in parallel, choosing the
+// filter per row with libpng's minimum sum of absolute differences heuristic.  The filtered data is then split into
+// strips of about 128K which are deflated in parallel, each primed with the last 32K of the previous strip as its
+// dictionary, and joined with sync flushes into a single zlib stream, as pigz does.  The result decodes with any png
+// reader, and compresses within a fraction of a percent of a single stream.
+
+static void put32(vector<uint8_t>& out, const uint32_t x) {
+  for (int s=24;s>=0;s-=8)
+    out.push_back(uint8_t(x>>s));
+}
 
-    png_structp png_ptr=png_create_read_struct(PNG_LIBPNG_VER_STRING,0,0,0);
-    if(!png_ptr) throw IOError(format("Error reading png file %s",filename));
-    png_infop info_ptr=png_create_info_struct(png_ptr);
-    if(!info_ptr) throw IOError(format("Error reading png file %s",filename));
-    if(setjmp(png_jmpbuf(png_ptr))) throw IOError(format("Error reading png file %s",filename));
-    png_init_io(png_ptr,file);
-    png_read_png(png_ptr,info_ptr,PNG_TRANSFORM_STRIP_16 | PNG_TRANSFORM_PACKING | PNG_TRANSFORM_EXPAND,0);
-    const size_t width  = png_get_image_width(png_ptr,info_ptr),
-                 height = png_get_image_height(png_ptr,info_ptr);
-    GEODE_ASSERT((width+1)*(height+1)<size_t(numeric_limits<int>::max()));
+static void put_chunk(vector<uint8_t>& out, const char* type, const uint8_t* data, const size_t size) {
+  put32(out,uint32_t(size));
+  const size_t start = out.size();
+  out.insert(out.end(),type,type+4);
+  out.insert(out.end(),data,data+size);
+  put32(out,uint32_t(crc32(0,&out[start],uInt(out.size()-start))));
+}
 
-    Array<Vector<T,4>,2> image((int(height)),int(width));
-    Vector<unsigned char,4>** row_pointers=(Vector<unsigned char,4>**)png_get_rows(png_ptr,info_ptr);
+static inline uint8_t paeth(const int a, const int b, const int c) {
+  const int p = a+b-c, pa = abs(p-a), pb = abs(p-b), pc = abs(p-c);
+  return uint8_t(pa<=pb && pa<=pc ? a : pb<=pc ? b : c);
+}
 
-    for(int i=0;i<int(width);i++){
-      for(int j=0;j<int(height);j++) {
-        Vector<unsigned char,4>& v = row_pointers[int(height)-j-1][i];
-        image(j,i) = Image<T>::to_scalar_color(v);
-      }
+// Filter one row of stride bytes with bytes per pixel bpp into out, which has room for the filter byte
+static void filter_row(const uint8_t* row, const uint8_t* prev, const int stride, const int bpp, uint8_t* out) {
+  // Try each filter, keeping the best in out.  Filter 0 goes straight to out.
+  uint64_t best_cost = numeric_limits<uint64_t>::max();
+  vector<uint8_t> trial(stride+1);
+  for (int f=0;f<5;f++) {
+    uint8_t* t = f ? trial.data() : out;
+    t[0] = uint8_t(f);
+    uint64_t cost = 0;
+    for (int i=0;i<stride;i++) {
+      const int a = i>=bpp ? row[i-bpp] : 0,
+                b = prev ? prev[i] : 0,
+                c = prev && i>=bpp ? prev[i-bpp] : 0;
+      const uint8_t x = uint8_t(row[i]-(f==0 ? 0 : f==1 ? a : f==2 ? b : f==3 ? (a+b)/2 : paeth(a,b,c)));
+      t[i+1] = x;
+      cost += x<128 ? x : 256-x;
+    }
+    if (cost<best_cost) {
+      best_cost = cost;
+      if (f)
+        memcpy(out,t,stride+1);
     }
+  }
+}
 
-    png_destroy_read_struct(&png_ptr,&info_ptr,0);
-    fclose(file);
-    return image;
+template<int C> static vector<uint8_t> encode_png(RawArray<const Vector<uint8_t,C>,2> rows) {
+  const int height = rows.m, width = rows.n, stride = C*width;
+  GEODE_ASSERT(width>0 && height>0);
+
+  // Filter rows in parallel
+  const size_t filtered_stride = size_t(stride)+1;
+  vector<uint8_t> filtered(filtered_stride*height);
+  parallel_for(height,[&](const int j) {
+    filter_row((const uint8_t*)rows[j].data(),j ? (const uint8_t*)rows[j-1].data() : 0,stride,C,
+               &filtered[filtered_stride*j]);
+  },16);
+
+  // Deflate strips in parallel
+  const size_t window = 32<<10, strip = 128<<10;
+  const int strips = int((filtered.size()+strip-1)/strip);
+  vector<vector<uint8_t>> compressed(strips);
+  vector<uLong> adlers(strips);
+  parallel_for(strips,[&](const int s) {
+    const size_t lo = strip*s, hi = min(filtered.size(),lo+strip);
+    z_stream z;
+    memset(&z,0,sizeof(z));
+    if (deflateInit2(&z,Z_DEFAULT_COMPRESSION,Z_DEFLATED,-15,8,Z_DEFAULT_STRATEGY)!=Z_OK)
+      throw std::bad_alloc();
+    if (s) {
+      const size_t dict = min(window,lo);
+      deflateSetDictionary(&z,&filtered[lo-dict],uInt(dict));
+    }
+    auto& out = compressed[s];
+    out.resize(deflateBound(&z,uLong(hi-lo))+16);
+    z.next_in = &filtered[lo];
+    z.avail_in = uInt(hi-lo);
+    z.next_out = out.data();
+    z.avail_out = uInt(out.size());
+    const int status = deflate(&z,s+1<strips ? Z_SYNC_FLUSH : Z_FINISH);
+    GEODE_ASSERT(status==(s+1<strips ? Z_OK : Z_STREAM_END) && !z.avail_in);
+    out.resize(out.size()-z.avail_out);
+    deflateEnd(&z);
+    adlers[s] = adler32(adler32(0,0,0),&filtered[lo],uInt(hi-lo));
+  });
+
+  // Assemble the zlib stream
+  vector<uint8_t> idat;
+  idat.push_back(0x78);
+  idat.push_back(0x9c);
+  uLong adler = adlers[0];
+  for (int s=0;s<strips;s++) {
+    idat.insert(idat.end(),compressed[s].begin(),compressed[s].end());
+    if (s)
+      adler = adler32_combine(adler,adlers[s],z_off_t(min(strip,filtered.size()-strip*s)));
+  }
+  put32(idat,uint32_t(adler));
+
+  // Write chunks
+  vector<uint8_t> png;
+  static const uint8_t signature[8] = {137,80,78,71,13,10,26,10};
+  png.insert(png.end(),signature,signature+8);
+  uint8_t header[13];
+  for (int i=0;i<4;i++) {
+    header[i] = uint8_t(width>>(24-8*i));
+    header[4+i] = uint8_t(height>>(24-8*i));
+  }
+  header[8] = 8; // Bit depth
+  header[9] = C==3 ? 2 : 6; // Color type: RGB or RGBA
+  header[10] = header[11] = header[12] = 0; // Deflate, adaptive filtering, no interlace
+  put_chunk(png,"IHDR",header,13);
+  const size_t max_chunk = 1<<20;
+  for (size_t lo=0;lo<idat.size();lo+=max_chunk)
+    put_chunk(png,"IDAT",&idat[lo],min(max_chunk,idat.size()-lo));
+  put_chunk(png,"IEND",0,0);
+  return png;
 }
 //#####################################################################
 // Function Write
 //#####################################################################
-template<int C> struct ColorPolicy {};
-
-template<> struct ColorPolicy<3> {
-  enum {Type = PNG_COLOR_TYPE_RGB};
-};
-template<> struct ColorPolicy<4> {
-  enum {Type = PNG_COLOR_TYPE_RGBA};
-};
-
-template<class T, int C> void
-write_helper(const std::string& filename,RawArray<const Vector<T,C>,2> image)
-{
-    FILE* file=fopen(filename.c_str(),"wb");
-    if(!file) GEODE_FATAL_ERROR(format("Failed to open %s for writing",filename));
-
-    png_structp png_ptr=png_create_write_struct(PNG_LIBPNG_VER_STRING,0,0,0);
-    if(!png_ptr) GEODE_FATAL_ERROR(format("Error writing png file %s",filename));
-    png_infop info_ptr=png_create_info_struct(png_ptr);
-    if(!info_ptr) GEODE_FATAL_ERROR(format("Error writing png file %s",filename));
-    if(setjmp(png_jmpbuf(png_ptr))) GEODE_FATAL_ERROR(format("Error writing png file %s",filename));
-    png_init_io(png_ptr,file);
-    png_set_IHDR(png_ptr,info_ptr,image.m,image.n,8,ColorPolicy<C>::Type,PNG_INTERLACE_NONE,PNG_COMPRESSION_TYPE_DEFAULT,PNG_FILTER_TYPE_DEFAULT);
-
-    Vector<unsigned char,C>* byte_data=new Vector<unsigned char,C>[image.n*image.m];
-    Vector<unsigned char,C>** row_pointers=new Vector<unsigned char,C>*[image.n];
-    for(int j=0;j<image.n;j++){
-        row_pointers[image.n-j-1]=byte_data+image.m*(image.n-j-1);
-        for(int i=0;i<image.m;i++) row_pointers[image.n-j-1][i]=Image<T>::to_byte_color(image(i,j));}
-    png_set_rows(png_ptr,info_ptr,(png_byte**)row_pointers);
-    png_write_png(png_ptr,info_ptr,PNG_TRANSFORM_IDENTITY,0);
-    delete[] row_pointers;delete[] byte_data;
-
-    png_destroy_write_struct(&png_ptr,&info_ptr);
-    fclose(file);
+template<class T,int C> static void write_helper(const std::string& filename, RawArray<const Vector<T,C>,2> image) {
+  const auto png = encode_png<C>(byte_rows(image));
+  FILE* file = fopen(filename.c_str(),"wb");
+  if (!file)
+    throw IOError(format("Failed to open %s for writing",filename));
+  const bool ok = fwrite(png.data(),1,png.size(),file)==png.size();
+  if (fclose(file) || !ok)
+    throw IOError(format("Error writing png file %s",filename));
 }
 
 template<class T> void PngFile<T>::write(const std::string& filename,RawArray<const Vector<T,3>,2> image) {
@@ -160,55 +240,10 @@ template<class T> void PngFile<T>::write(const std::string& filename,RawArray<co
   write_helper(filename, image);
 }
 
-template<class T,int C> std::vector<unsigned char> write_to_memory_helper(RawArray<const Vector<T,C>,2> image)
-{
-  const int width = image.m;
-  const int height = image.n;
-
-  typedef std::vector<unsigned char> ByteBuffer;
-  ByteBuffer result;
-  struct VecWriter {
-    static void write(png_structp png_ptr, png_bytep data, png_size_t length) {
-      std::vector<unsigned char>* buffer = (ByteBuffer*)png_get_io_ptr(png_ptr);
-      buffer->insert(buffer->end(), (unsigned char*)data, (unsigned char*)(data+length));
-    }
-    static void flush(png_structp png_ptr) { }
-  };
-
-  png_structp png_ptr=png_create_write_struct(PNG_LIBPNG_VER_STRING,0,0,0);
-  if(!png_ptr) GEODE_FATAL_ERROR("Error writing png file to buffer");
-
-  png_infop info_ptr=png_create_info_struct(png_ptr);
-  if(!info_ptr) GEODE_FATAL_ERROR("Error writing png file to buffer");
-
-  if(setjmp(png_jmpbuf(png_ptr))) GEODE_FATAL_ERROR("Error writing png file");
-
-  png_set_write_fn(png_ptr, &result, &VecWriter::write, &VecWriter::flush);
-
-  png_set_IHDR(png_ptr,info_ptr,width,height,8,ColorPolicy<C>::Type,PNG_INTERLACE_NONE,PNG_COMPRESSION_TYPE_DEFAULT,PNG_FILTER_TYPE_DEFAULT);
-
-  Vector<unsigned char,C>* byte_data=new Vector<unsigned char,C>[width*height];
-  Vector<unsigned char,C>** row_pointers=new Vector<unsigned char,C>*[height];
-  for(int j=0;j<height;j++){
-    row_pointers[j]=byte_data+width*j;
-    for(int i=0;i<width;i++) {
-      row_pointers[j][i] = Image<T>::to_byte_color(image(i,height-1-j));
-    }
-  }
-  png_set_rows(png_ptr,info_ptr,(png_byte**)row_pointers);
-  png_write_png(png_ptr,info_ptr,PNG_TRANSFORM_IDENTITY,0);
-  delete[] row_pointers;
-  delete[] byte_data;
-
-  png_destroy_write_struct(&png_ptr,&info_ptr);
-  return result;
-}
-
 template<class T> std::vector<unsigned char> PngFile<T>::
-write_to_memory(RawArray<const Vector<T,3>,2> image) { return write_to_memory_helper(image); }
+write_to_memory(RawArray<const Vector<T,3>,2> image) { return encode_png<3>(byte_rows(image)); }
 template<class T> std::vector<unsigned char> PngFile<T>::
-write_to_memory(RawArray<const Vector<T,4>,2> image) { return write_to_memory_helper(image); }
-
+write_to_memory(RawArray<const Vector<T,4>,2> image) { return encode_png<4>(byte_rows(image)); }
 
 //#####################################################################
 // Function is_supported
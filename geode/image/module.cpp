@@ -8,4 +8,5 @@ void wrap_image() {
   GEODE_WRAP(Image)
   GEODE_WRAP(mov)
   GEODE_WRAP(color_utils)
+  GEODE_WRAP(resample)
 }
@@ -0,0 +1,161 @@
+// Image resampling and mipmap pyramids
+
+#include <geode/image/resample.h>
+#include <geode/math/constants.h>
+#include <geode/python/enum.h>
+#include <geode/python/stl.h>
+#include <geode/python/wrap.h>
+#include <geode/utility/parallel.h>
+#include <cmath>
+namespace geode {
+
+GEODE_DEFINE_ENUM(ResampleFilter,GEODE_CORE_EXPORT)
+
+static double filter_radius(const ResampleFilter filter) {
+  switch (filter) {
+    case BoxFilter: return .5;
+    case BilinearFilter: return 1;
+    case LanczosFilter: return 3;
+  }
+  GEODE_FATAL_ERROR(format("resample: invalid filter %d",int(filter)));
+}
+
+static double filter_weight(const ResampleFilter filter, const double x) {
+  const double a = std::abs(x);
+  switch (filter) {
+    case BoxFilter: return a<.5 ? 1 : a==.5 ? .5 : 0; // Split ties so that halving averages pairs
+    case BilinearFilter: return max(0.,1-a);
+    case LanczosFilter: {
+      if (a>=3)
+        return 0;
+      if (a<1e-8)
+        return 1;
+      const double px = pi*a;
+      return 3*sin(px)*sin(px/3)/(px*px);
+    }
+  }
+  GEODE_FATAL_ERROR(format("resample: invalid filter %d",int(filter)));
+}
+
+namespace {
+// Output pixel i along an axis is sum_k weights(i,k)*input[start[i]+k].  Every output uses the same number of taps,
+// padded with zeros, so the loops over taps are regular.
+template<class T> struct Taps {
+  Array<int> start;
+  Array<T,2> weights;
+
+  Taps(const int in, const int out, const ResampleFilter filter)
+    : start(out,uninit) {
+    const double scale = double(in)/out,
+                 widen = max(scale,1.),
+                 support = filter_radius(filter)*widen;
+    const int width = min(in,int(2*ceil(support))+1);
+    weights = Array<T,2>(out,width);
+    for (int i=0;i<out;i++) {
+      const double center = (i+.5)*scale-.5;
+      const int lo = max(0,int(ceil(center-support))),
+                hi = min(in-1,int(floor(center+support)));
+      start[i] = min(lo,in-width);
+      double total = 0;
+      for (int j=lo;j<=hi;j++)
+        total += filter_weight(filter,(j-center)/widen);
+      // Fall back to the nearest input if the filter misses every sample
+      if (!total) {
+        weights(i,clamp(int(round(center)),0,in-1)-start[i]) = 1;
+        continue;
+      }
+      for (int j=lo;j<=hi;j++)
+        weights(i,j-start[i]) = T(filter_weight(filter,(j-center)/widen)/total);
+    }
+  }
+};
+}
+
+template<class T,int C> Array<Vector<T,C>,2>
+resample(RawArray<const Vector<T,C>,2> image, const Vector<int,2> size, const ResampleFilter filter) {
+  GEODE_ASSERT(size.min()>0 && image.sizes().min()>0,
+               format("resample: invalid sizes %s to %s",str(image.sizes()),str(size)));
+  const int m = image.m;
+
+  // Filter along y, the contiguous axis, one column x at a time
+  Array<Vector<T,C>,2> columns;
+  if (size.y==image.n)
+    columns = image.copy();
+  else {
+    const Taps<T> taps(image.n,size.y,filter);
+    const int width = taps.weights.n;
+    columns = Array<Vector<T,C>,2>(m,size.y,uninit);
+    parallel_for(m,[&](const int x) {
+      const auto in = image[x];
+      const auto out = columns[x];
+      for (int y=0;y<size.y;y++) {
+        const auto w = taps.weights[y];
+        const Vector<T,C>* p = &in[taps.start[y]];
+        Vector<T,C> sum;
+        for (int k=0;k<width;k++)
+          for (int a=0;a<C;a++)
+            sum[a] += w[k]*p[k][a];
+        out[y] = sum;
+      }
+    },16);
+  }
+  if (size.x==m)
+    return columns;
+
+  // Filter along x, accumulating whole rows as flat streams of components
+  const Taps<T> taps(m,size.x,filter);
+  const int width = taps.weights.n,
+            row = C*size.y;
+  Array<Vector<T,C>,2> result(size.x,size.y);
+  parallel_for(size.x,[&](const int x) {
+    const auto w = taps.weights[x];
+    T* out = &result(x,0)[0];
+    for (int k=0;k<width;k++) {
+      const T wk = w[k];
+      if (!wk)
+        continue;
+      const T* in = &columns(taps.start[x]+k,0)[0];
+      for (int t=0;t<row;t++)
+        out[t] += wk*in[t];
+    }
+  },4);
+  return result;
+}
+
+template<class T,int C> std::vector<Array<Vector<T,C>,2>>
+mipmaps(RawArray<const Vector<T,C>,2> image, const ResampleFilter filter) {
+  GEODE_ASSERT(image.sizes().min()>0);
+  std::vector<Array<Vector<T,C>,2>> levels;
+  levels.push_back(image.copy());
+  for (;;) {
+    const auto& last = levels.back();
+    if (last.sizes()==Vector<int,2>(1,1))
+      break;
+    const auto size = Vector<int,2>::componentwise_max(Vector<int,2>(1,1),last.sizes()/2);
+    levels.push_back(resample<T,C>(last,size,filter));
+  }
+  return levels;
+}
+
+#define INSTANTIATE(T,C) \
+  template GEODE_CORE_EXPORT Array<Vector<T,C>,2> resample(RawArray<const Vector<T,C>,2>,const Vector<int,2>, \
+                                                           const ResampleFilter); \
+  template GEODE_CORE_EXPORT std::vector<Array<Vector<T,C>,2>> mipmaps(RawArray<const Vector<T,C>,2>, \
+                                                                       const ResampleFilter);
+INSTANTIATE(float,3)
+INSTANTIATE(float,4)
+INSTANTIATE(double,3)
+INSTANTIATE(double,4)
+
+}
+using namespace geode;
+
+void wrap_resample() {
+  typedef real T;
+  GEODE_ENUM(ResampleFilter)
+  GEODE_ENUM_VALUE(BoxFilter)
+  GEODE_ENUM_VALUE(BilinearFilter)
+  GEODE_ENUM_VALUE(LanczosFilter)
+  GEODE_FUNCTION_2(resample_image,resample<T,3>)
+  GEODE_FUNCTION_2(image_mipmaps,mipmaps<T,3>)
+}
@@ -0,0 +1,26 @@
+// Image resampling and mipmap pyramids
+#pragma once
+
+#include <geode/array/Array2d.h>
+#include <geode/python/forward.h>
+#include <geode/vector/Vector.h>
+#include <vector>
+namespace geode {
+
+enum ResampleFilter { BoxFilter, BilinearFilter, LanczosFilter };
+GEODE_DECLARE_ENUM(ResampleFilter,GEODE_CORE_EXPORT)
+
+// Resample an image indexed (x,y) to the given size.  The filter is separable, and is widened by the scale factor
+// when shrinking so that it also acts as an antialiasing filter.  Weights are normalized near the edges, so the edges
+// are effectively clamped.  Lanczos uses three lobes, and can overshoot near sharp edges.  Axes whose size doesn't
+// change are copied.  Rows are filtered in parallel, and the inner loops are unit stride over pixel components so
+// that they vectorize.
+template<class T,int C> GEODE_CORE_EXPORT Array<Vector<T,C>,2>
+resample(RawArray<const Vector<T,C>,2> image, const Vector<int,2> size, const ResampleFilter filter=LanczosFilter);
+
+// All levels of a mipmap pyramid, starting with a copy of image and halving each axis (rounding down, but not below
+// one) until the image is a single pixel.  Each level is resampled from the one before.
+template<class T,int C> GEODE_CORE_EXPORT std::vector<Array<Vector<T,C>,2>>
+mipmaps(RawArray<const Vector<T,C>,2> image, const ResampleFilter filter=BoxFilter);
+
+}
@@ -0,0 +1,37 @@
+#!/usr/bin/env python
+
+from __future__ import division
+from geode import *
+
+def test_median():
+  random.seed(7)
+  for n in 1,2,3,9,10,11,25:
+    images = [random.rand(13,17,3) for _ in xrange(n)]
+    median = Image.median(images)
+    assert all(median==sort(images,axis=0)[n//2])
+
+def test_gamma_dither():
+  random.seed(8)
+  image = random.rand(30,20,3)
+  assert allclose(Image.gamma_compress(image,2.2),image**(1/2.2))
+  assert allclose(Image.gamma_compress(image,2),sqrt(image))
+  dithered = Image.dither(image)
+  assert all(abs(dithered-image)<1.01/255)
+  assert all(dithered==Image.dither(image))
+
+def test_resample():
+  random.seed(9)
+  image = random.rand(16,12,3)
+  for filter in BoxFilter,BilinearFilter,LanczosFilter:
+    # Constants are preserved, and unchanged sizes are copies
+    assert allclose(resample_image(ones((16,12,3)),(7,20),filter),1)
+    assert all(resample_image(image,(16,12),filter)==image)
+  # Box halving averages 2x2 blocks
+  levels = image_mipmaps(image,BoxFilter)
+  assert [L.shape[:2] for L in levels]==[(16,12),(8,6),(4,3),(2,1),(1,1)]
+  assert allclose(levels[1],image.reshape(8,2,6,2,3).mean(axis=(1,3)))
+
+if __name__=='__main__':
+  test_median()
+  test_gamma_dither()
+  test_resample()
@@ -25,6 +25,7 @@ if MovWriter.enabled():
       a = 4*pi*t/3
       image = c*(x*cos(a)+y*sin(a)+.5).reshape(w,h,1)
       mov.add_frame(image)
+    mov.drain()
 
 if __name__=='__main__':
   test_mov('test.mov')
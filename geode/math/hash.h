@@ -5,6 +5,7 @@
 
 #include <geode/utility/config.h>
 #include <geode/utility/type_traits.h>
+#include <cassert>
 #include <stdint.h>
 #include <cstring>
 #include <string>
@@ -35,42 +36,43 @@ GEODE_CORE_EXPORT Hash hash_reduce(const char* key);
 GEODE_CORE_EXPORT Hash hash_reduce(const string& key);
 template<class T> inline typename enable_if_c<is_packed_pod<T>::value && sizeof(T)<=4,int>::type hash_reduce(const T& key);
 template<class T> inline typename enable_if_c<(is_packed_pod<T>::value && sizeof(T)>4 && sizeof(T)<=8),Hash>::type hash_reduce(const T& key);
-template<class T> inline typename enable_if_c<(is_packed_pod<T>::value && sizeof(T)>8),Hash>::type hash_reduce(const T& key);
+template<class T> inline typename enable_if_c<(is_packed_pod<T>::value && sizeof(T)>8 && sizeof(T)<=12),Hash>::type hash_reduce(const T& key);
+template<class T> inline typename enable_if_c<(is_packed_pod<T>::value && sizeof(T)>12),Hash>::type hash_reduce(const T& key);
 
 struct Hash {
   int val;
 
-  explicit Hash()
+  constexpr explicit Hash()
     :val(32138912) {}
 
-  template<class T0> Hash(const T0& k0)
+  template<class T0> constexpr Hash(const T0& k0)
     :val(mix(k0)) {}
 
-  template<class T0,class T1> Hash(const T0& k0,const T1& k1)
+  template<class T0,class T1> constexpr Hash(const T0& k0,const T1& k1)
     :val(mix(value(k0),value(k1))) {}
 
-  template<class T0,class T1,class T2> Hash(const T0& k0,const T1& k1,const T2& k2)
+  template<class T0,class T1,class T2> constexpr Hash(const T0& k0,const T1& k1,const T2& k2)
     :val(mix(value(k0),value(k1),value(k2))) {}
 
-  template<class T0,class T1,class T2,class T3> Hash(const T0& k0,const T1& k1,const T2& k2,const T3& k3)
+  template<class T0,class T1,class T2,class T3> constexpr Hash(const T0& k0,const T1& k1,const T2& k2,const T3& k3)
     :val(mix(mix(value(k0),value(k1),value(k2)),value(k3))) {}
 
-  template<class T0,class T1,class T2,class T3,class T4> Hash(const T0& k0,const T1& k1,const T2& k2,const T3& k3,const T4& k4)
+  template<class T0,class T1,class T2,class T3,class T4> constexpr Hash(const T0& k0,const T1& k1,const T2& k2,const T3& k3,const T4& k4)
     :val(mix(mix(value(k0),value(k1),value(k2)),value(k3),value(k4))) {}
 
-  template<class T0,class T1,class T2,class T3,class T4,class T5> Hash(const T0& k0,const T1& k1,const T2& k2,const T3& k3,const T4& k4,const T5& k5)
+  template<class T0,class T1,class T2,class T3,class T4,class T5> constexpr Hash(const T0& k0,const T1& k1,const T2& k2,const T3& k3,const T4& k4,const T5& k5)
     :val(mix(mix(mix(value(k0),value(k1),value(k2)),value(k3),value(k4)),value(k5))) {}
 
 private:
-  static int value(const int key) {
+  static constexpr int value(const int key) {
     return key;
   }
 
-  static int value(const Hash key) {
+  static constexpr int value(const Hash key) {
     return key.val;
   }
 
-  static int value(const uint64_t key) {
+  static constexpr int value(const uint64_t key) {
     return mix(key);
   }
 
@@ -78,45 +80,36 @@ private:
     return value(hash_reduce(key));
   }
 
-  static int mix(unsigned key) {
-    key += ~(key << 15);
-    key ^=  (key >> 10);
-    key +=  (key << 3);
-    key ^=  (key >> 6);
-    key += ~(key << 11);
-    key ^=  (key >> 16);
-    return (int)key;
+  // The mixers alternate xorshifts, which fold high bits down, with multiplications by odd constants, which
+  // spread low bits up.  Hashtable picks slots with the high bits of the result and tags with the low bits,
+  // so both ends must depend on every input bit.  The 32 bit constants are Wellons' lowbias32.
+  static constexpr unsigned xorshift(const unsigned key,const int s) {
+    return key^(key>>s);
   }
 
-  static int mix(int key) {
+  static constexpr uint64_t xorshift(const uint64_t key,const int s) {
+    return key^(key>>s);
+  }
+
+  static constexpr int mix(unsigned key) {
+    return (int)xorshift(xorshift(xorshift(key,16)*0x7feb352du,15)*0x846ca68bu,16);
+  }
+
+  static constexpr int mix(int key) {
     return mix(unsigned(key));
   }
 
-  static int mix(uint64_t key) {
-    key = (~key) + (key << 18);
-    key = key ^ (key >> 31);
-    key = key * 21;
-    key = key ^ (key >> 11);
-    key = key + (key << 6);
-    key = key ^ (key >> 22);
-    return (int)key;
+  static constexpr int mix(uint64_t key) {
+    return (int)xorshift(xorshift(xorshift(key,32)*uint64_t(0xd6e8feb86659fd93),32)*uint64_t(0xd6e8feb86659fd93),32);
   }
 
-  static int mix(unsigned a,unsigned b) {
+  static constexpr int mix(unsigned a,unsigned b) {
     return mix(uint64_t(a)<<32|b);
   }
 
-  static int mix(unsigned a,unsigned b,unsigned c) {
-    a-=b;a-=c;a^=(c>>13);
-    b-=c;b-=a;b^=(a<<8);
-    c-=a;c-=b;c^=(b>>13);
-    a-=b;a-=c;a^=(c>>12);
-    b-=c;b-=a;b^=(a<<16);
-    c-=a;c-=b;c^=(b>>5);
-    a-=b;a-=c;a^=(c>>3);
-    b-=c;b-=a;b^=(a<<10);
-    c-=a;c-=b;c^=(b>>15);
-    return (int)c;
+  // Three words are folded into one with 32 bit multiplies, which unlike 64 bit ones vectorize well in hash_batch
+  static constexpr int mix(unsigned a,unsigned b,unsigned c) {
+    return mix(unsigned((a*0x9e3779b1u^b)*0x85ebca77u^c));
   }
 };
 
@@ -141,7 +134,14 @@ template<class T> inline typename enable_if_c<(is_packed_pod<T>::value && sizeof
   return Hash(data);
 }
 
-template<class T> inline typename enable_if_c<(is_packed_pod<T>::value && sizeof(T)>8),Hash>::type hash_reduce(const T& key) {
+// Three word keys such as Vector<int,3> faces skip the generic loop below
+template<class T> inline typename enable_if_c<(is_packed_pod<T>::value && sizeof(T)>8 && sizeof(T)<=12),Hash>::type hash_reduce(const T& key) {
+  int data[3] = {0,0,0};
+  memcpy(data,&key,sizeof(key));
+  return Hash(data[0],data[1],data[2]);
+}
+
+template<class T> inline typename enable_if_c<(is_packed_pod<T>::value && sizeof(T)>12),Hash>::type hash_reduce(const T& key) {
   const int n = (sizeof(T)+3)/4;
   int data[n];
   data[n-1] = 0;
@@ -156,4 +156,15 @@ inline int hash(const T& key) {
   return Hash(hash_reduce(key)).val;
 }
 
+// Set hashes[i] = hash(keys[i]) for two raw arrays, e.g. before a bulk or parallel hashtable build.  Iterations
+// are independent, so for packed keys the mixing of consecutive keys overlaps and may be vectorized.
+template<class TKeys,class THashes> static inline void hash_batch(const TKeys& keys, const THashes& hashes) {
+  assert(keys.size()==hashes.size());
+  const int n = keys.size();
+  const auto k = keys.data();
+  int* h = hashes.data();
+  for (int i=0;i<n;i++)
+    h[i] = hash(k[i]);
+}
+
 }
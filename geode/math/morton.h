@@ -0,0 +1,96 @@
+//#####################################################################
+// Morton and Hilbert codes
+//#####################################################################
+//
+// Space filling curve codes for quantized 2D and 3D coordinates, for
+// ordering points so that nearby points are nearby in memory.  2D codes use
+// 32 bits per axis and 3D codes 21 bits per axis, so both fit in a uint64_t.
+//
+// Morton codes interleave coordinate bits, with axis 0 least significant.
+// Hilbert codes follow Skilling, "Programming the Hilbert curve" (2004):
+// consecutive codes are always adjacent cells, which gives better locality
+// than Morton order at a few times the cost.  See geometry/spatial_keys.h
+// for codes of real points within a box.
+//
+//#####################################################################
+#pragma once
+
+#include <geode/vector/Vector.h>
+#include <stdint.h>
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+namespace geode {
+
+// Spread the low 32 bits of x to the even bits of the result
+static inline uint64_t morton_spread2(const uint32_t x) {
+#ifdef __BMI2__
+  return _pdep_u64(x,0x5555555555555555);
+#else
+  uint64_t c = x;
+  c = (c|c<<16)&0x0000ffff0000ffff;
+  c = (c|c<<8) &0x00ff00ff00ff00ff;
+  c = (c|c<<4) &0x0f0f0f0f0f0f0f0f;
+  c = (c|c<<2) &0x3333333333333333;
+  c = (c|c<<1) &0x5555555555555555;
+  return c;
+#endif
+}
+
+// Spread the low 21 bits of x to every third bit of the result
+static inline uint64_t morton_spread3(const uint32_t x) {
+#ifdef __BMI2__
+  return _pdep_u64(x,0x1249249249249249);
+#else
+  uint64_t c = x&0x1fffff;
+  c = (c|c<<32)&0x001f00000000ffff;
+  c = (c|c<<16)&0x001f0000ff0000ff;
+  c = (c|c<<8) &0x100f00f00f00f00f;
+  c = (c|c<<4) &0x10c30c30c30c30c3;
+  c = (c|c<<2) &0x1249249249249249;
+  return c;
+#endif
+}
+
+static inline uint64_t morton(const Vector<uint32_t,2> x) {
+  return morton_spread2(x[0])|morton_spread2(x[1])<<1;
+}
+
+static inline uint64_t morton(const Vector<uint32_t,3> x) {
+  return morton_spread3(x[0])|morton_spread3(x[1])<<1|morton_spread3(x[2])<<2;
+}
+
+// Hilbert code of x, each coordinate of which has the given number of bits
+template<int d> static inline uint64_t hilbert(Vector<uint32_t,d> x, const int bits=d==2?32:21) {
+  assert(bits>0 && d*bits<=64);
+  // Convert axes to the transposed Hilbert index
+  const uint32_t top = uint32_t(1)<<(bits-1);
+  for (uint32_t q=top;q>1;q>>=1) {
+    const uint32_t p = q-1;
+    for (int i=0;i<d;i++) {
+      if (x[i]&q)
+        x[0] ^= p; // Invert
+      else { // Exchange
+        const uint32_t t = (x[0]^x[i])&p;
+        x[0] ^= t;
+        x[i] ^= t;
+      }
+    }
+  }
+  // Gray encode
+  for (int i=1;i<d;i++)
+    x[i] ^= x[i-1];
+  uint32_t t = 0;
+  for (uint32_t q=top;q>1;q>>=1)
+    if (x[d-1]&q)
+      t ^= q-1;
+  for (int i=0;i<d;i++)
+    x[i] ^= t;
+  // The transposed index puts axis 0 in the most significant position of each group of d bits
+  Vector<uint32_t,d> r;
+  for (int i=0;i<d;i++)
+    r[i] = x[d-1-i];
+  return morton(r);
+}
+
+}
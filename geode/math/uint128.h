@@ -7,6 +7,9 @@
 #include <geode/utility/type_traits.h>
 #include <stdint.h>
 #include <string>
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
 namespace geode {
 
 using std::string;
@@ -71,9 +74,16 @@ public:
   }
 
   uint128_t operator*(uint128_t x) const {
+#if defined(_MSC_VER) && defined(_M_X64)
+    // The full 64x64 product is a single instruction
+    uint64_t h;
+    const uint64_t l = _umul128(lo,x.lo,&h);
+    return uint128_t(h+lo*x.hi+hi*x.lo,l);
+#else
     // Use 64-bit multiplies, since we're assuming a native uint128_t isn't available
     uint64_t mask = (uint64_t(1)<<32)-1, ll = lo&mask, xll = x.lo&mask, lh = lo>>32, xlh = x.lo>>32, m0 = xlh*ll, m1 = xll*lh;
     return uint128_t(lo*x.hi+hi*x.lo+xlh*lh,ll*xll)+uint128_t(m0>>32,m0<<32)+uint128_t(m1>>32,m1<<32);
+#endif
   }
 
   uint128_t operator<<(unsigned b) const {
@@ -0,0 +1,131 @@
+// A compact, immutable corner table for read-only triangle mesh queries
+
+#include <geode/mesh/FrozenTriangleTopology.h>
+#include <geode/python/Class.h>
+namespace geode {
+
+GEODE_DEFINE_TYPE(FrozenTriangleTopology)
+
+// Compact ids, skipping erased primitives in order
+template<class Erased> static Array<int> compact_ids(const int n, const Erased& erased) {
+  Array<int> map(n,uninit);
+  int j = 0;
+  for (int i=0;i<n;i++)
+    map[i] = erased(i) ? -1 : j++;
+  return map;
+}
+
+FrozenTriangleTopology::FrozenTriangleTopology(const TriangleTopology& mesh) {
+  const bool garbage = mesh.n_vertices()!=mesh.vertex_to_edge_.size()
+                    || mesh.n_faces()!=mesh.faces_.size()
+                    || mesh.n_boundary_edges()!=mesh.boundaries_.size();
+  const auto vmap = garbage ? compact_ids(mesh.vertex_to_edge_.size(),[&](int v) { return mesh.erased(VertexId(v)); })
+                            : Array<int>();
+  const auto fmap = garbage ? compact_ids(mesh.faces_.size(),[&](int f) { return mesh.erased(FaceId(f)); })
+                            : Array<int>();
+  const auto bmap = garbage ? compact_ids(mesh.boundaries_.size(),[&](int b) { return mesh.erased(HalfedgeId(-1-b)); })
+                            : Array<int>();
+  const auto vertex = [&](const VertexId v) {
+    return garbage && v.valid() ? VertexId(vmap[v.id]) : v;
+  };
+  const auto halfedge = [&](const HalfedgeId e) {
+    return !garbage || !e.valid() ? e
+         : e.id>=0 ? HalfedgeId(3*fmap[e.id/3]+e.id%3)
+                   : HalfedgeId(-1-bmap[-1-e.id]);
+  };
+
+  // Fill in exactly sized arrays in one pass over each primitive
+  const int nv = mesh.n_vertices(),
+            nf = mesh.n_faces(),
+            nb = mesh.n_boundary_edges();
+  Array<VertexId> vertices(3*nf,uninit);
+  Array<HalfedgeId> reverses(3*nf,uninit);
+  for (const auto f : mesh.faces()) {
+    const int g = garbage ? fmap[f.id] : f.id;
+    const auto& info = mesh.faces_[f];
+    for (int i=0;i<3;i++) {
+      vertices[3*g+i] = vertex(info.vertices[i]);
+      reverses[3*g+i] = halfedge(info.neighbors[i]);
+    }
+  }
+  Array<HalfedgeId> vertex_halfedges(nv,uninit);
+  for (const auto v : mesh.vertices())
+    vertex_halfedges[vertex(v).id] = halfedge(mesh.halfedge(v));
+  Array<VertexId> srcs(nb,uninit);
+  Array<HalfedgeId> prevs(nb,uninit), nexts(nb,uninit), boundary_reverses(nb,uninit);
+  for (const auto e : mesh.boundary_edges()) {
+    const int b = -1-halfedge(e).id;
+    const auto& info = mesh.boundaries_[-1-e.id];
+    srcs[b] = vertex(info.src);
+    prevs[b] = halfedge(info.prev);
+    nexts[b] = halfedge(info.next);
+    boundary_reverses[b] = halfedge(info.reverse);
+  }
+  const_cast_(corner_vertices) = vertices;
+  const_cast_(corner_reverses) = reverses;
+  const_cast_(this->vertex_halfedges) = vertex_halfedges;
+  const_cast_(boundary_srcs) = srcs;
+  const_cast_(boundary_prevs) = prevs;
+  const_cast_(boundary_nexts) = nexts;
+  const_cast_(this->boundary_reverses) = boundary_reverses;
+}
+
+FrozenTriangleTopology::~FrozenTriangleTopology() {}
+
+HalfedgeId FrozenTriangleTopology::halfedge(VertexId v0, VertexId v1) const {
+  assert(valid(v0));
+  for (const auto e : outgoing(v0))
+    if (dst(e)==v1)
+      return e;
+  return HalfedgeId();
+}
+
+Array<Vector<int,3>> FrozenTriangleTopology::elements() const {
+  Array<Vector<int,3>> tris(n_faces(),uninit);
+  for (const auto f : faces())
+    tris[f.id] = Vector<int,3>(vertices(f));
+  return tris;
+}
+
+size_t FrozenTriangleTopology::memory_usage() const {
+  return corner_vertices.size()*sizeof(VertexId)
+       + corner_reverses.size()*sizeof(HalfedgeId)
+       + vertex_halfedges.size()*sizeof(HalfedgeId)
+       + boundary_srcs.size()*(sizeof(VertexId)+3*sizeof(HalfedgeId));
+}
+
+void FrozenTriangleTopology::assert_consistent() const {
+  GEODE_ASSERT(corner_vertices.size()==3*n_faces() && corner_reverses.size()==3*n_faces());
+  GEODE_ASSERT(boundary_prevs.size()==n_boundary_edges() && boundary_nexts.size()==n_boundary_edges()
+               && boundary_reverses.size()==n_boundary_edges());
+  for (const auto v : vertices()) {
+    const auto e = halfedge(v);
+    if (e.valid())
+      GEODE_ASSERT(valid(e) && src(e)==v);
+  }
+  for (const auto e : halfedges()) {
+    const auto r = reverse(e);
+    GEODE_ASSERT(valid(r) && reverse(r)==e);
+    GEODE_ASSERT(!is_boundary(e) || !is_boundary(r));
+    GEODE_ASSERT(src(r)==dst(e) && dst(r)==src(e));
+    GEODE_ASSERT(prev(next(e))==e && next(prev(e))==e);
+  }
+}
+
+}
+using namespace geode;
+
+void wrap_frozen_triangle_topology() {
+  typedef FrozenTriangleTopology Self;
+  Class<Self>("FrozenTriangleTopology")
+    .GEODE_INIT(const TriangleTopology&)
+    .GEODE_GET(n_vertices)
+    .GEODE_GET(n_faces)
+    .GEODE_GET(n_boundary_edges)
+    .GEODE_GET(n_edges)
+    .GEODE_GET(chi)
+    .GEODE_METHOD(elements)
+    .GEODE_METHOD(memory_usage)
+    .GEODE_METHOD(assert_consistent)
+    ;
+}
@@ -0,0 +1,135 @@
+// A compact, immutable corner table for read-only triangle mesh queries
+#pragma once
+
+#include <geode/mesh/TriangleTopology.h>
+namespace geode {
+
+struct FrozenTriangleTopologyOutgoing;
+struct FrozenTriangleTopologyIncoming;
+
+// FrozenTriangleTopology stores the same structure as TriangleTopology in flat, exactly sized structure-of-arrays
+// form, with no erased primitives and no field bookkeeping.  It is built in one pass from a TriangleTopology, and
+// exposes the same read-only traversal API (halfedge, prev, next, reverse, src, dst, face, left, right, outgoing,
+// vertices(), faces(), etc.), so that algorithms templated on the mesh type accept either class.
+//
+// Halfedge ids follow the TriangleTopology conventions: interior halfedges are 3*f+i, and boundary halfedges are
+// -1-b.  If the source mesh has erased primitives, the remaining ones are renumbered in order exactly as
+// MutableTriangleTopology::collect_garbage would, so ids agree with the source whenever it is garbage collected.
+class FrozenTriangleTopology : public Object {
+public:
+  GEODE_DECLARE_TYPE(GEODE_CORE_EXPORT)
+  typedef Object Base;
+
+  // Corner arrays, indexed by interior halfedge 3*f+i
+  const Array<const VertexId> corner_vertices; // src of halfedge 3*f+i, i.e., vertex i of face f
+  const Array<const HalfedgeId> corner_reverses; // reverse of halfedge 3*f+i
+
+  // Vertex array: an outgoing halfedge, which is a boundary halfedge if possible, or invalid if isolated
+  const Array<const HalfedgeId> vertex_halfedges;
+
+  // Boundary arrays, indexed by b for boundary halfedge -1-b
+  const Array<const VertexId> boundary_srcs;
+  const Array<const HalfedgeId> boundary_prevs, boundary_nexts, boundary_reverses;
+
+protected:
+  GEODE_CORE_EXPORT FrozenTriangleTopology(const TriangleTopology& mesh);
+public:
+  ~FrozenTriangleTopology();
+
+  // Counts
+  int n_vertices() const { return vertex_halfedges.size(); }
+  int n_faces() const { return corner_vertices.size()/3; }
+  int n_boundary_edges() const { return boundary_srcs.size(); }
+  int n_edges() const { return (3*n_faces()+n_boundary_edges())>>1; }
+  int chi() const { return n_vertices()-n_edges()+n_faces(); }
+
+  // Walk around the mesh.  These always succeed given valid ids, but may return invalid ids as a result.
+  HalfedgeId halfedge(VertexId v) const { return vertex_halfedges[v.id]; }
+  HalfedgeId halfedge(FaceId f, int i=0) const { assert(unsigned(i)<3); return HalfedgeId(3*f.id+i); }
+  HalfedgeId prev(HalfedgeId e) const { return e.id>=0 ? HalfedgeId(e.id+(e.id%3==0?2:-1)) : boundary_prevs[-1-e.id]; }
+  HalfedgeId next(HalfedgeId e) const { return e.id>=0 ? HalfedgeId(e.id+(e.id%3==2?-2:1)) : boundary_nexts[-1-e.id]; }
+  HalfedgeId reverse(HalfedgeId e) const { return e.id>=0 ? corner_reverses[e.id] : boundary_reverses[-1-e.id]; }
+  VertexId src(HalfedgeId e) const { return e.id>=0 ? corner_vertices[e.id] : boundary_srcs[-1-e.id]; }
+  VertexId dst(HalfedgeId e) const { return src(next(e)); }
+  FaceId face(HalfedgeId e) const { return e.id>=0 ? FaceId(e.id/3) : FaceId(); }
+  int face_index(HalfedgeId e) const { return e.id>=0 ? e.id%3 : -1; }
+  VertexId vertex(FaceId f, int i=0) const { assert(unsigned(i)<3); return corner_vertices[3*f.id+i]; }
+  HalfedgeId left(HalfedgeId e) const { return reverse(prev(e)); }
+  HalfedgeId right(HalfedgeId e) const { return next(reverse(e)); }
+  VertexId opposite(HalfedgeId e) const { assert(!is_boundary(e)); return dst(next(e)); }
+
+  // The halfedge from v0 to v1, or invalid if none exists (O(degree) time)
+  GEODE_CORE_EXPORT HalfedgeId halfedge(VertexId v0, VertexId v1) const;
+
+  // Check id validity.  There are no erased ids.
+  bool valid(VertexId v) const { return unsigned(v.id)<unsigned(n_vertices()); }
+  bool valid(FaceId f) const { return unsigned(f.id)<unsigned(n_faces()); }
+  bool valid(HalfedgeId e) const { return e.id>=0 ? e.id<3*n_faces() : e.valid() && -1-e.id<n_boundary_edges(); }
+
+  // Check for boundaries
+  bool is_boundary(HalfedgeId e) const { return e.id<0; }
+  bool is_boundary(VertexId v) const { const auto e = halfedge(v); return e.valid() && is_boundary(e); }
+  bool isolated(VertexId v) const { return !halfedge(v).valid(); }
+  bool has_boundary() const { return n_boundary_edges()!=0; }
+  bool is_manifold() const { return !has_boundary(); }
+
+  // Tuples or iterable ranges of neighbors
+  Vector<HalfedgeId,3> halfedges(FaceId f) const { return vec(HalfedgeId(3*f.id),HalfedgeId(3*f.id+1),HalfedgeId(3*f.id+2)); }
+  Vector<VertexId,2> vertices(HalfedgeId e) const { return vec(src(e),dst(e)); }
+  Vector<VertexId,3> vertices(FaceId f) const { return vec(vertex(f,0),vertex(f,1),vertex(f,2)); }
+  Vector<FaceId,3> faces(FaceId f) const { const auto e = halfedges(f);
+                                           return vec(face(reverse(e.x)),face(reverse(e.y)),face(reverse(e.z))); }
+  Vector<FaceId,2> faces(HalfedgeId e) const { return vec(face(e),face(reverse(e))); }
+  inline Range<FrozenTriangleTopologyOutgoing> outgoing(VertexId v) const;
+  inline Range<FrozenTriangleTopologyIncoming> incoming(VertexId v) const;
+
+  // Iterate over vertices, faces, or halfedges.  Since nothing is erased, these are contiguous id ranges.
+  Range<IdIter<VertexId>> vertices() const { return id_range<VertexId>(n_vertices()); }
+  Range<IdIter<FaceId>> faces() const { return id_range<FaceId>(n_faces()); }
+  Range<IdIter<HalfedgeId>> halfedges() const { return id_range<HalfedgeId>(-n_boundary_edges(),3*n_faces()); }
+  Range<IdIter<HalfedgeId>> boundary_edges() const { return id_range<HalfedgeId>(-n_boundary_edges(),0); }
+  Range<IdIter<HalfedgeId>> interior_halfedges() const { return id_range<HalfedgeId>(0,3*n_faces()); }
+
+  // Triangles as vertex index triples
+  GEODE_CORE_EXPORT Array<Vector<int,3>> elements() const;
+
+  // Bytes used by the flat arrays
+  GEODE_CORE_EXPORT size_t memory_usage() const;
+
+  // Check that the structure is consistent
+  GEODE_CORE_EXPORT void assert_consistent() const;
+};
+
+struct FrozenTriangleTopologyOutgoing {
+  const FrozenTriangleTopology& mesh;
+  HalfedgeId e;
+  bool first;
+  FrozenTriangleTopologyOutgoing(const FrozenTriangleTopology& mesh, HalfedgeId e, bool first) : mesh(mesh), e(e), first(first) {}
+  void operator++() { e = mesh.left(e); first = false; }
+  bool operator!=(FrozenTriangleTopologyOutgoing o) const { return first || e!=o.e; } // For use only inside range-based for loops
+  HalfedgeId operator*() const { return e; }
+};
+
+struct FrozenTriangleTopologyIncoming {
+  const FrozenTriangleTopology& mesh;
+  HalfedgeId e;
+  bool first;
+  FrozenTriangleTopologyIncoming(const FrozenTriangleTopology& mesh, HalfedgeId e, bool first) : mesh(mesh), e(e), first(first) {}
+  void operator++() { e = mesh.left(e); first = false; }
+  bool operator!=(FrozenTriangleTopologyIncoming o) const { return first || e!=o.e; } // For use only inside range-based for loops
+  HalfedgeId operator*() const { return mesh.reverse(e); }
+};
+
+inline Range<FrozenTriangleTopologyOutgoing> FrozenTriangleTopology::outgoing(VertexId v) const {
+  const auto e = halfedge(v);
+  const FrozenTriangleTopologyOutgoing c(*this,e,e.valid());
+  return Range<FrozenTriangleTopologyOutgoing>(c,c);
+}
+
+inline Range<FrozenTriangleTopologyIncoming> FrozenTriangleTopology::incoming(VertexId v) const {
+  const auto e = halfedge(v);
+  const FrozenTriangleTopologyIncoming c(*this,e,e.valid());
+  return Range<FrozenTriangleTopologyIncoming>(c,c);
+}
+
+}
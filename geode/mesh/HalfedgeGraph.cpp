@@ -62,10 +62,8 @@ int HalfedgeGraph::degree(const VertexId v) const {
 
 Array<VertexId> HalfedgeGraph::one_ring(const VertexId v) const {
   Array<VertexId> result;
-  for(const HalfedgeId e : outgoing(v)) {
-    assert(src(e) == v);
-    result.append(dst(e));
-  }
+  for (const auto u : neighbors(v))
+    result.append(u);
   return result;
 }
 
@@ -578,7 +576,6 @@ bool has_manifold_edge_weights(const HalfedgeGraph& g, const RawField<const int,
   return true;
 }
 
-// compute_winding_numbers has a number of fragile and complicated internal interactions that proved difficult to debug
 // compute_winding_numbers_oracle is a slower but more straightforward implementation that can be used as a reference
 #define USE_WINDING_NUMBER_ORACLE 0
 
@@ -628,174 +625,66 @@ GEODE_UNUSED static Field<int, FaceId> compute_winding_numbers_oracle(const Half
   return winding_numbers;
 }
 
-namespace {
-constexpr int invalid_depth = std::numeric_limits<int>::max();
-
-class WindingDepthHelper {
-  struct DepthNode {
-    int parent_ = -1;
-    int depth_to_parent_;
-    bool is_root() const { return parent_ < 0; }
-    FaceId parent() const { assert(parent_ >= 0); return FaceId(parent_); }
-    int rank() const { assert(parent_ < 0); return parent_; }
-    int depth_to_parent() const { assert(!is_root()); return depth_to_parent_; }
-  };
-  Field<DepthNode, FaceId> nodes;
-  Field<int, FaceId> depths;
-
-#if USE_WINDING_NUMBER_ORACLE
- public:
-  Field<int, FaceId> oracle;
- private:
-  bool depth_to_parent_correct(const FaceId f) const {
-    if(nodes[f].is_root()
-     || oracle[f] + nodes[f].depth_to_parent() == oracle[nodes[f].parent()])
-      return true;
-    return false;
-  }
-  bool absolute_depth_correct(const FaceId f, const int depth) {
-    return oracle[f] == depth;
-  }
-  int oracle_depth(const FaceId f) { return oracle[f]; }
-#else
- bool depth_to_parent_correct(const FaceId a) const { return true; }
- bool absolute_depth_correct(const FaceId f, const int depth) { return true; }
- int oracle_depth(const FaceId f) { return 0; }
-#endif
-
-  void set_parent(const FaceId child, const FaceId new_parent, const int new_depth_to_parent) {
-    auto& c = nodes[child];
-    assert(c.is_root());
-    c.parent_ = new_parent.idx();
-    c.depth_to_parent_ = new_depth_to_parent;
-    assert(depth_to_parent_correct(child));
-  }
-
-  void share_grandparent(const FaceId child) {
-    assert(depth_to_parent_correct(child));
-    auto& c = nodes[child];
-    assert(!c.is_root());
-    auto& p = nodes[c.parent()];
-    assert(!p.is_root());
-    c.parent_ = p.parent_;
-    c.depth_to_parent_ += p.depth_to_parent();
-    assert(depth_to_parent_correct(child));
-  }
+Field<int, FaceId> compute_winding_numbers(const HalfedgeGraph& g, const FaceId boundary_face, const RawField<const int, EdgeId> edge_weights) {
+  assert(g.check_invariants());
+  assert(has_manifold_edge_weights(g, edge_weights));
+  GEODE_CONSTEXPR_IF_NOT_MSVC int unset_winding_number = std::numeric_limits<int>::max();
+  const int n_faces = g.n_faces();
+  Field<int, FaceId> winding_numbers(n_faces, uninit);
+  winding_numbers.flat.fill(unset_winding_number);
+  if(!n_faces)
+    return winding_numbers;
+  assert(g.valid(boundary_face));
 
-  FaceId find_root(FaceId i, int& depth_to_root) {
-    depth_to_root = 0;
-    for(;;) {
-      if(nodes[i].is_root())
-        return i;
-      depth_to_root += nodes[i].depth_to_parent();
-      const FaceId pi = nodes[i].parent();
-      if(nodes[pi].is_root())
-        return pi;
-      depth_to_root += nodes[pi].depth_to_parent();
-      share_grandparent(i);
-      i = nodes[pi].parent();
+  // Build the face adjacency dual in one sweep over the edges.  Crossing edge e from faces(e)[0] to faces(e)[1]
+  // changes the winding number by -edge_weights[e], so each dual edge stores the face it reaches and that change.
+  Array<int> offsets(n_faces+1);
+  for(const EdgeId e : g.edges()) {
+    const auto f = g.faces(e);
+    if(f[0] != f[1]) {
+      offsets[f[0].idx()+1]++;
+      offsets[f[1].idx()+1]++;
     }
   }
-
-  FaceId merge_roots(FaceId a, int a_to_b, FaceId b) {
-    assert(depth_to_parent_correct(a));
-    assert(depth_to_parent_correct(b));
-    assert(nodes[a].is_root() && nodes[b].is_root());
-    if(a != b) {
-      if(nodes[a].rank() > nodes[b].rank()) {
-        swap(a,b);
-        a_to_b = -a_to_b;
-      }
-      else if(nodes[a].rank() == nodes[b].rank()) {
-        nodes[a].parent_--;
-      }
-      nodes[b].parent_ = a.idx();
-      nodes[b].depth_to_parent_ = -a_to_b;
-      assert(depth_to_parent_correct(b));
-    }
-    else {
-      assert(a_to_b == 0);
+  for(const int i : range(n_faces))
+    offsets[i+1] += offsets[i];
+  Array<Vector<int,2>> dual(offsets.back(), uninit);
+  for(const EdgeId e : g.edges()) {
+    const auto f = g.faces(e);
+    if(f[0] != f[1]) {
+      const int w = edge_weights[e];
+      dual[offsets[f[0].idx()]++] = vec(f[1].idx(), -w);
+      dual[offsets[f[1].idx()]++] = vec(f[0].idx(), w);
     }
-    return a;
-  }
-
-  void seed_depth(FaceId seed, int seed_depth) {
-    assert(depths.valid(seed));
-    assert(depths[seed] == invalid_depth);
-    do {
-      assert(depths.valid(seed));
-      assert(depth_to_parent_correct(seed));
-      assert(absolute_depth_correct(seed, seed_depth));
-      depths[seed] = seed_depth;
-      if(nodes[seed].is_root())
-        return;
-      seed_depth += nodes[seed].depth_to_parent();
-      seed = nodes[seed].parent();
-      assert(depths.valid(seed));
-      assert(absolute_depth_correct(seed, seed_depth));
-    } while(depths[seed] == invalid_depth);
   }
-
- public:
-  WindingDepthHelper(const int n_faces)
-   : nodes(n_faces)
-   , depths(n_faces, uninit)
-  {
-    depths.flat.fill(invalid_depth);
-  }
-
-  FaceId connect(const FaceId a, const int a_to_b, const FaceId b) {
-    int a_to_root_a = 0;
-    int b_to_root_b = 0;
-    const FaceId root_a = find_root(a, a_to_root_a);
-    const FaceId root_b = find_root(b, b_to_root_b);
-    const int root_a_to_root_b = -a_to_root_a + a_to_b + b_to_root_b;
-    return merge_roots(root_a, root_a_to_root_b, root_b);
-  }
-
-  Field<int, FaceId> get_depths(const FaceId seed, const int seed_d) {
-    assert(depths.valid(seed));
-    assert(absolute_depth_correct(seed, seed_d));
-    seed_depth(seed, seed_d);
-    for(const FaceId start : depths.id_range()) {
-      if(depths[start] != invalid_depth)
-        continue;
-      FaceId i = start;
-      int start_to_i = 0;
-      do {
-        start_to_i += nodes[i].depth_to_parent();
-        i = nodes[i].parent();
-        assert(absolute_depth_correct(i, oracle_depth(start) + start_to_i));
-        assert(depth_to_parent_correct(i));
-        assert(i.valid());
-      } while(depths[i] == invalid_depth);
-      const int start_depth = depths[i] - start_to_i;
-      assert(depths.valid(seed));
-      seed_depth(start, start_depth); // Save data back ensuring that no nodes need to be traversed multiple times
-      assert(depths[i] != invalid_depth);
+  // Filling advanced each offset to the start of the next face, so shift them back
+  for(int i=n_faces;i>0;i--)
+    offsets[i] = offsets[i-1];
+  offsets[0] = 0;
+
+  // Breadth first search from the boundary face.  Manifold edge weights make every path give the same answer, so
+  // each face is visited once and the first value reached is final.
+  Array<int> queue(n_faces, uninit);
+  int head = 0, tail = 0;
+  queue[tail++] = boundary_face.idx();
+  winding_numbers.flat[boundary_face.idx()] = 0;
+  while(head < tail) {
+    const int f = queue[head++];
+    const int n = winding_numbers.flat[f];
+    for(const auto& d : dual.slice(offsets[f],offsets[f+1])) {
+      auto& opp_n = winding_numbers.flat[d.x];
+      if(opp_n == unset_winding_number) {
+        opp_n = n + d.y;
+        queue[tail++] = d.x;
+      } else
+        assert(opp_n == n + d.y);
     }
-    assert(!depths.flat.contains(invalid_depth));
-    return depths;
   }
-}; }
-
-Field<int, FaceId> compute_winding_numbers(const HalfedgeGraph& g, const FaceId boundary_face, const RawField<const int, EdgeId> edge_weights) {
-  assert(g.check_invariants());
-  assert(has_manifold_edge_weights(g, edge_weights));
-  auto helper = WindingDepthHelper(g.n_faces());
-#if USE_WINDING_NUMBER_ORACLE
-  helper.oracle = compute_winding_numbers_oracle(g, boundary_face, edge_weights);
-#endif
-  for(const EdgeId eid : g.edges()) {
-    const Vector<FaceId,2> faces = g.faces(eid);
-    if(faces[0] != faces[1])
-      helper.connect(faces[0],-edge_weights[eid],faces[1]);
-  }
-  const auto result = helper.get_depths(boundary_face, 0);
+  assert(tail == n_faces);
 #if USE_WINDING_NUMBER_ORACLE
-  assert(result.flat == helper.oracle.flat);
+  assert(winding_numbers.flat == compute_winding_numbers_oracle(g, boundary_face, edge_weights).flat);
 #endif
-  return result;
+  return winding_numbers;
 }
 
 
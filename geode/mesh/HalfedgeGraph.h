@@ -29,6 +29,7 @@ public:
   typedef Object Base;
 
   struct OutgoingCirculator;
+  struct NeighborCirculator;
   struct BorderCirculator;
   struct FaceCirculator;
 
@@ -149,6 +150,7 @@ public:
   Vector<VertexId,2> vertices(const EdgeId e) const { return vertices(halfedge(e, false)); }
 
   inline Range<OutgoingCirculator> outgoing(const VertexId v) const;
+  inline Range<NeighborCirculator> neighbors(const VertexId v) const; // dst(e) for e in outgoing(v), without allocating
   inline Range<BorderCirculator> border_edges(const HalfedgeId e) const; // This version is safe to call even without border data present
   inline Range<BorderCirculator> border_edges(const BorderId b) const { return border_edges(halfedge(b)); }
   inline Range<FaceCirculator> face_borders(const BorderId b) const; // This relies on border data, but is safe to call without face data present
@@ -157,7 +159,7 @@ public:
   // Compute the edge degree of a vertex in O(degree) time.
   GEODE_CORE_EXPORT int degree(const VertexId v) const;
 
-  // All connected edges to vertex
+  // All connected edges to vertex.  Prefer neighbors(v) in C++.
   GEODE_CORE_EXPORT Array<VertexId> one_ring(const VertexId v) const;
 
   // Add a new isolated vertex and return its id
@@ -188,6 +190,17 @@ public:
     HalfedgeId operator*() const { return e; }
   };
 
+  // Use only through HalfedgeGraph::neighbors()
+  struct NeighborCirculator {
+    const HalfedgeGraph& graph;
+    HalfedgeId e;
+    bool first;
+    NeighborCirculator(const HalfedgeGraph& graph, const HalfedgeId e, const bool first) : graph(graph), e(e), first(first) {}
+    void operator++() { e = graph.left(e); first = false; }
+    bool operator!=(const NeighborCirculator& o) { return first || e!=o.e; } // For use only inside range-based for loops
+    VertexId operator*() const { return graph.dst(e); }
+  };
+
   // Use only through HalfedgeGraph::border_edges()
   struct BorderCirculator { // Iterator to walk halfedges for a border
     const HalfedgeGraph& graph;
@@ -241,6 +254,12 @@ inline Range<HalfedgeGraph::OutgoingCirculator> HalfedgeGraph::outgoing(const Ve
   return Range<HalfedgeGraph::OutgoingCirculator>(c,c);
 }
 
+inline Range<HalfedgeGraph::NeighborCirculator> HalfedgeGraph::neighbors(const VertexId v) const {
+  const auto e = halfedge(v);
+  const HalfedgeGraph::NeighborCirculator c(*this,e,e.valid());
+  return Range<HalfedgeGraph::NeighborCirculator>(c,c);
+}
+
 inline Range<HalfedgeGraph::BorderCirculator> HalfedgeGraph::border_edges(const HalfedgeId e) const {
   const BorderCirculator iter(*this,e,e.valid());
   return Range<BorderCirculator>(iter,iter);
@@ -0,0 +1,187 @@
+// Geodesic distance on triangle meshes by the heat method
+
+#include <geode/mesh/HeatGeodesic.h>
+#include <geode/python/Class.h>
+#include <geode/structure/UnionFind.h>
+#include <geode/utility/parallel.h>
+#include <algorithm>
+#include <limits>
+namespace geode {
+
+typedef real T;
+typedef Vector<T,3> TV;
+GEODE_DEFINE_TYPE(HeatGeodesic)
+
+static T squared_mean_edge(const TriangleTopology& mesh, RawField<const TV,VertexId> X) {
+  T sum = 0;
+  for (const auto f : mesh.faces()) {
+    const auto v = mesh.vertices(f);
+    sum += magnitude(X[v.y]-X[v.x])+magnitude(X[v.z]-X[v.y])+magnitude(X[v.x]-X[v.z]);
+  }
+  return mesh.n_faces() ? sqr(sum/(3*mesh.n_faces())) : 1;
+}
+
+HeatGeodesic::HeatGeodesic(const TriangleTopology& mesh, Field<const TV,VertexId> X, const T time_scale)
+  : time(time_scale*squared_mean_edge(mesh,X))
+  , n(mesh.allocated_vertices()) {
+  GEODE_ASSERT(X.size()==n,"HeatGeodesic: need a position for every vertex id");
+  GEODE_ASSERT(time_scale>0);
+
+  // Gradients of the hat functions.  The gradient of the hat function of corner i is perpendicular to the opposite
+  // edge, with magnitude one over the height.
+  Array<Vector<int,3>> faces;
+  Array<Vector<TV,3>> gradients;
+  Array<T> areas;
+  UnionFind union_find(n);
+  for (const auto f : mesh.faces()) {
+    const auto v = mesh.vertices(f);
+    const Vector<int,3> i(v.x.id,v.y.id,v.z.id);
+    union_find.merge(i);
+    const Vector<TV,3> x(X[v.x],X[v.y],X[v.z]);
+    const auto N = cross(x.y-x.x,x.z-x.x);
+    const T area2 = magnitude(N);
+    if (!area2)
+      continue; // Degenerate faces contribute nothing
+    const auto normal = N/sqr(area2);
+    faces.append(i);
+    gradients.append(Vector<TV,3>(cross(normal,x.z-x.y),cross(normal,x.x-x.z),cross(normal,x.y-x.x)));
+    areas.append(area2/2);
+  }
+
+  // Label components, and pin the root of each to fix the constant in the Poisson problem
+  Array<int> component(n);
+  component.fill(-1);
+  for (const auto f : mesh.faces())
+    for (const auto v : mesh.vertices(f))
+      component[v.id] = union_find.find(v.id);
+
+  // Sparsity pattern: each row holds its vertex and the vertices sharing a face with it
+  Array<int> lengths(n,uninit);
+  lengths.fill(1);
+  for (const auto& v : faces)
+    for (const int a : range(3))
+      lengths[v[a]] += 3;
+  Nested<int> pattern(lengths,uninit);
+  for (const int i : range(n))
+    pattern(i,--lengths[i]) = i;
+  for (const auto& v : faces)
+    for (const int a : range(3))
+      for (const int b : range(3))
+        pattern(v[a],--lengths[v[a]]) = v[b];
+  for (const int i : range(n)) {
+    auto row = pattern[i];
+    std::sort(row.begin(),row.end());
+    lengths[i] = int(std::unique(row.begin(),row.end())-row.begin());
+  }
+  Nested<int> J(lengths,uninit);
+  for (const int i : range(n))
+    std::copy(pattern[i].begin(),pattern[i].begin()+J.size(i),J[i].begin());
+  const auto entry = [&](const int i, const int j) {
+    const auto row = J[i];
+    return J.offsets[i]+int(std::lower_bound(row.begin(),row.end(),j)-row.begin());
+  };
+
+  // Cotangent Laplacian L = G^T A G and lumped mass M
+  Array<T> L(J.flat.size()), M(n);
+  for (const int f : range(faces.size())) {
+    const auto& v = faces[f];
+    const auto& g = gradients[f];
+    for (const int a : range(3)) {
+      M[v[a]] += areas[f]/3;
+      for (const int b : range(3))
+        L[entry(v[a],v[b])] += areas[f]*dot(g[a],g[b]);
+    }
+  }
+
+  // H = M + t L, and P = L with pinned vertices decoupled.  Unused or pinned vertices get identity rows.
+  Array<T> H = L.copy(), P = L.copy();
+  H *= time;
+  for (const int i : range(n)) {
+    const int d = entry(i,i);
+    H[d] += M[i];
+    if (component[i]<0)
+      H[d] = 1;
+    for (const int p : range(J.offsets[i],J.offsets[i+1]))
+      if (component[i]==i || component[J.flat[p]]==J.flat[p])
+        P[p] = 0;
+    if (component[i]<0 || component[i]==i)
+      P[d] = 1;
+  }
+  heat = new_<SparseCholesky>(*new_<SparseMatrix>(J.copy(),H));
+  poisson = new_<SparseCholesky>(*new_<SparseMatrix>(J.copy(),P));
+  this->faces = faces;
+  this->gradients = gradients;
+  this->areas = areas;
+  this->component = component;
+}
+
+HeatGeodesic::~HeatGeodesic() {}
+
+void HeatGeodesic::solve(RawArray<const int> sources, RawArray<T> phi) const {
+  // Flow heat from the sources
+  Array<T> u(n);
+  for (const int s : sources) {
+    GEODE_ASSERT(unsigned(s)<unsigned(n),"HeatGeodesic: invalid source vertex");
+    if (component[s]>=0)
+      u[s] = 1;
+  }
+  heat->solve(u,u);
+
+  // Integrate the divergence of the normalized gradient field against each hat function: G^T A X
+  Array<T> div(n);
+  for (const int f : range(faces.size())) {
+    const auto& v = faces[f];
+    const auto& g = gradients[f];
+    const auto grad = u[v.x]*g.x+u[v.y]*g.y+u[v.z]*g.z;
+    const T norm = magnitude(grad);
+    if (!norm)
+      continue;
+    const auto Y = -areas[f]/norm*grad;
+    for (const int a : range(3))
+      div[v[a]] += dot(g[a],Y);
+  }
+  for (const int i : range(n))
+    if (component[i]<0 || component[i]==i)
+      div[i] = 0;
+  poisson->solve(div,phi);
+
+  // Shift each component so that its minimum is zero, leaving components without sources at infinity
+  const T inf = std::numeric_limits<T>::infinity();
+  Array<T> lowest(n);
+  lowest.fill(inf);
+  for (const int s : sources)
+    if (component[s]>=0)
+      lowest[component[s]] = -inf; // Mark components with sources
+  for (const int i : range(n))
+    if (component[i]>=0 && lowest[component[i]]<inf)
+      lowest[component[i]] = lowest[component[i]]==-inf ? phi[i] : min(lowest[component[i]],phi[i]);
+  for (const int i : range(n))
+    phi[i] = component[i]>=0 && lowest[component[i]]<inf ? phi[i]-lowest[component[i]] : inf;
+}
+
+Field<T,VertexId> HeatGeodesic::distance(RawArray<const int> sources) const {
+  Field<T,VertexId> phi(n,uninit);
+  solve(sources,phi.flat);
+  return phi;
+}
+
+Array<T,2> HeatGeodesic::distances(Nested<const int> sources) const {
+  Array<T,2> phi(sources.size(),n,uninit);
+  parallel_for(sources.size(),[&](const int i) {
+    solve(sources[i],phi[i]);
+  });
+  return phi;
+}
+
+}
+using namespace geode;
+
+void wrap_heat_geodesic() {
+  typedef HeatGeodesic Self;
+  Class<Self>("HeatGeodesic")
+    .GEODE_INIT(const TriangleTopology&,Field<const TV,VertexId>,T)
+    .GEODE_FIELD(time)
+    .GEODE_METHOD(distance)
+    .GEODE_METHOD(distances)
+    ;
+}
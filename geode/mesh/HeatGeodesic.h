@@ -0,0 +1,55 @@
+// Geodesic distance on triangle meshes by the heat method
+#pragma once
+
+#include <geode/array/Array2d.h>
+#include <geode/array/Field.h>
+#include <geode/array/Nested.h>
+#include <geode/mesh/TriangleTopology.h>
+#include <geode/python/Ptr.h>
+#include <geode/solver/SparseCholesky.h>
+namespace geode {
+
+// HeatGeodesic computes approximate geodesic distance from sets of source vertices, following
+//
+//   Crane, Weischedel, and Wardetzky, Geodesics in Heat: A New Approach to Computing Distance Based on Heat Flow.
+//
+// Heat flows from the sources for a short time by one backward Euler step, (M + t L) u = delta, where L is the
+// cotangent Laplacian and M the lumped mass matrix.  The normalized gradient X = -grad u / |grad u| on each face points
+// along geodesics, and the distance is the solution of the Poisson problem L phi = div X, shifted so that its minimum
+// over each connected component is zero.
+//
+// Both matrices are factored once by SparseCholesky when the solver is built, so each query costs two pairs of
+// triangular solves plus a pass over the faces.  Query many source sets at once with distances, which runs them in
+// parallel.  Vertices in components without a source, and erased or isolated vertices, get infinite distance.
+class HeatGeodesic : public Object {
+public:
+  GEODE_DECLARE_TYPE(GEODE_CORE_EXPORT)
+  typedef Object Base;
+  typedef real T;
+  typedef Vector<T,3> TV;
+
+  const T time; // Heat flow time t, time_scale times the squared mean edge length
+private:
+  const int n; // Number of vertex ids
+  Array<const Vector<int,3>> faces; // Vertices of each nondegenerate face
+  Array<const Vector<TV,3>> gradients; // Gradient of the hat function of each corner, constant over the face
+  Array<const T> areas;
+  Array<const int> component; // Component of each vertex, or -1 if erased or isolated
+  Ptr<const SparseCholesky> heat, poisson; // Factors of M + t L, and of L with one vertex of each component pinned
+
+protected:
+  GEODE_CORE_EXPORT HeatGeodesic(const TriangleTopology& mesh, Field<const TV,VertexId> X, const T time_scale=1);
+public:
+  ~HeatGeodesic();
+
+  // Distance from the nearest source vertex to every vertex
+  GEODE_CORE_EXPORT Field<T,VertexId> distance(RawArray<const int> sources) const;
+
+  // Row i is the distance from sources[i], computed in parallel
+  GEODE_CORE_EXPORT Array<T,2> distances(Nested<const int> sources) const;
+
+private:
+  void solve(RawArray<const int> sources, RawArray<T> phi) const;
+};
+
+}
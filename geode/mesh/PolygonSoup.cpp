@@ -4,9 +4,14 @@
 #include <geode/mesh/PolygonSoup.h>
 #include <geode/mesh/SegmentSoup.h>
 #include <geode/mesh/TriangleSoup.h>
+#include <geode/exact/predicates.h>
+#include <geode/exact/quantize.h>
+#include <geode/exact/scope.h>
 #include <geode/structure/Hashtable.h>
 #include <geode/utility/const_cast.h>
+#include <geode/utility/parallel.h>
 #include <geode/python/Class.h>
+#include <geode/vector/Vector3d.h>
 namespace geode {
 
 GEODE_DEFINE_TYPE(PolygonSoup)
@@ -45,20 +50,131 @@ Ref<SegmentSoup> PolygonSoup::segment_soup() const {
   return ref(segment_soup_);
 }
 
+// Call fill(state,p,poly,triangles) for each polygon p in parallel, where poly holds its vertices and triangles is the
+// slice for its counts[p]-2 triangles.  Polygon p starts at vertex offset o and triangle o-2p, so a first pass sums
+// counts in blocks, and a second fills each block from its prefix sum.  Each block gets its own State.
+template<class State,class Fill> static Array<Vector<int,3>>
+triangulate(RawArray<const int> counts, RawArray<const int> vertices, const Fill& fill) {
+  const int n = counts.size(),
+            block = 4096,
+            blocks = (n+block-1)/block;
+  Array<int> offsets(blocks+1);
+  parallel_for(blocks,[&](const int b) {
+    int sum = 0;
+    for (int p=block*b;p<min(n,block*(b+1));p++)
+      sum += counts[p];
+    offsets[b+1] = sum;
+  });
+  for (int b=0;b<blocks;b++)
+    offsets[b+1] += offsets[b];
+  Array<Vector<int,3>> triangles(vertices.size()-2*n,uninit);
+  parallel_for(blocks,[&](const int b) {
+    State state;
+    int offset = offsets[b];
+    for (int p=block*b;p<min(n,block*(b+1));p++) {
+      const int t = offset-2*p;
+      fill(state,p,vertices.slice(offset,offset+counts[p]),triangles.slice(t,t+counts[p]-2));
+      offset += counts[p];
+    }
+  });
+  return triangles;
+}
+
 Ref<TriangleSoup> PolygonSoup::triangle_mesh() const {
   if (!triangle_mesh_) {
-    Array<Vector<int,3> > triangles(half_edge_count-2*counts.size());
-    int offset=0, t=0;
-    for (int p=0;p<counts.size();p++) {
-      for (int i=0;i<counts[p]-2;i++)
-        triangles[t++].set(vertices[offset],vertices[offset+i+1],vertices[offset+i+2]);
-      offset+=counts[p];
-    }
+    const auto triangles = triangulate<Tuple<>>(counts,vertices,
+        [](Tuple<>&, const int p, RawArray<const int> poly, RawArray<Vector<int,3>> tris) {
+      for (int i=0;i<tris.size();i++)
+        tris[i] = vec(poly[0],poly[i+1],poly[i+2]);
+    });
     triangle_mesh_ = new_<TriangleSoup>(triangles,nodes());
   }
   return ref(triangle_mesh_);
 }
 
+namespace {
+// Per block scratch space for ear clipping, reused across polygons
+struct EarClipper {
+  IntervalScope scope;
+  Array<Vector<real,2>> Y;
+  Array<exact::Perturbed2> P;
+  Array<int> next, prev;
+
+  void operator()(RawArray<const Vector<real,3>> X, RawArray<const int> poly, RawArray<Vector<int,3>> tris) {
+    const int n = poly.size();
+    if (n==3) {
+      tris[0] = vec(poly[0],poly[1],poly[2]);
+      return;
+    }
+
+    // Project along the largest component of the Newell normal, flipping if necessary so that the polygon winds
+    // counterclockwise
+    Vector<real,3> normal;
+    for (int i=0,j=n-1;i<n;j=i,i++)
+      normal += cross(X[poly[j]],X[poly[i]]);
+    const int axis = normal.dominant_axis(),
+              u = (axis+1)%3, v = (axis+2)%3;
+    const bool flip = normal[axis]<0;
+    Y.resize(n,uninit);
+    Box<Vector<real,2>> box;
+    for (int i=0;i<n;i++) {
+      const auto& x = X[poly[i]];
+      Y[i] = flip ? vec(x[v],x[u]) : vec(x[u],x[v]);
+      box.enlarge(Y[i]);
+    }
+    const auto quant = quantizer(box);
+    P.resize(n,uninit);
+    next.resize(n,uninit);
+    prev.resize(n,uninit);
+    for (int i=0;i<n;i++) {
+      P[i] = exact::Perturbed2(i,quant(Y[i]));
+      next[i] = (i+1)%n;
+      prev[i] = (i+n-1)%n;
+    }
+
+    // Clip ears until a triangle remains.  If a whole lap finds no ear, the polygon is self intersecting, and we clip
+    // the current vertex anyway.
+    int t = 0, i = 0, misses = 0;
+    for (int left=n;left>3;) {
+      const int a = prev[i], c = next[i];
+      if (is_ear(a,i,c) || misses>left) {
+        tris[t++] = vec(poly[a],poly[i],poly[c]);
+        next[a] = c;
+        prev[c] = a;
+        left--;
+        misses = 0;
+        i = c;
+      } else {
+        misses++;
+        i = c;
+      }
+    }
+    tris[t] = vec(poly[prev[i]],poly[i],poly[next[i]]);
+  }
+
+  // Is a,i,c a convex corner with no other remaining vertex inside?
+  bool is_ear(const int a, const int i, const int c) const {
+    if (!triangle_oriented(P[a],P[i],P[c]))
+      return false;
+    for (int j=next[c];j!=a;j=next[j])
+      if (   triangle_oriented(P[a],P[i],P[j])
+          && triangle_oriented(P[i],P[c],P[j])
+          && triangle_oriented(P[c],P[a],P[j]))
+        return false;
+    return true;
+  }
+};
+}
+
+Ref<TriangleSoup> PolygonSoup::ear_clipped_mesh(RawArray<const Vector<real,3>> X) const {
+  GEODE_ASSERT(X.size()>=nodes());
+  const auto triangles = triangulate<EarClipper>(counts,vertices,
+      [=](EarClipper& clip, const int p, RawArray<const int> poly, RawArray<Vector<int,3>> tris) {
+    clip(X,poly,tris);
+  });
+  return new_<TriangleSoup>(triangles,nodes());
+}
+
 }
 using namespace geode;
 
@@ -70,6 +186,7 @@ void wrap_polygon_mesh() {
     .GEODE_FIELD(vertices)
     .GEODE_METHOD(segment_soup)
     .GEODE_METHOD(triangle_mesh)
+    .GEODE_METHOD(ear_clipped_mesh)
     .GEODE_METHOD(nodes)
     ;
 }
@@ -12,6 +12,7 @@
 #include <geode/array/Array.h>
 #include <geode/mesh/forward.h>
 #include <geode/python/Object.h>
+#include <geode/vector/Vector.h>
 #include <geode/python/Ptr.h>
 #include <geode/python/Ref.h>
 namespace geode {
@@ -38,6 +39,14 @@ public:
   }
 
   GEODE_CORE_EXPORT Ref<SegmentSoup> segment_soup() const;
+
+  // Fan triangulation of each polygon from its first vertex, in parallel.  Correct for convex polygons.
   GEODE_CORE_EXPORT Ref<TriangleSoup> triangle_mesh() const;
+
+  // Ear clipping triangulation of each polygon projected onto the plane of its Newell normal, in parallel, for
+  // nonconvex polygons.  Orientation tests are exact with symbolic perturbation, so degenerate polygons still give
+  // n-2 triangles.  Self intersecting polygons give some triangulation of their vertices.  Triangles keep each
+  // polygon's orientation.  Unlike triangle_mesh, the result is not cached.
+  GEODE_CORE_EXPORT Ref<TriangleSoup> ear_clipped_mesh(RawArray<const Vector<real,3>> X) const;
 };
 }
@@ -2,11 +2,12 @@
 // Class SegmentSoup
 //#####################################################################
 #include <geode/mesh/SegmentSoup.h>
-#include <geode/array/Nested.h>
+#include <geode/array/NestedBuilder.h>
 #include <geode/array/sort.h>
 #include <geode/array/view.h>
 #include <geode/python/Class.h>
 #include <geode/utility/const_cast.h>
+#include <geode/utility/parallel.h>
 #include <geode/utility/stl.h>
 #include <geode/vector/convert.h>
 #include <geode/vector/normalize.h>
@@ -42,10 +43,11 @@ int SegmentSoup::compute_node_count() const {
 SegmentSoup::~SegmentSoup() {}
 
 const Tuple<Nested<const int>,Nested<const int>>& SegmentSoup::polygons() const {
+  std::lock_guard<std::recursive_mutex> guard(lock_);
   if (nodes() && !polygons_.x.size() && !polygons_.y.size()) {
     const auto incident = incident_elements();
     // Start from each segment, compute the contour that contains it and classify as either closed or open
-    vector<vector<int>> closed, open;
+    NestedBuilder<const int> closed, open;
     vector<bool> traversed(elements.size()); // Which segments have we covered already?
     for (int seed : range(elements.size())) {
       if (traversed[seed])
@@ -57,7 +59,7 @@ const Tuple<Nested<const int>,Nested<const int>>& SegmentSoup::polygons() const
         traversed[segment] = true;
         const int other = elements[segment][elements[segment].x==node?1:0];
         if (other==start) { // Found a closed contour
-          closed.push_back(poly);
+          closed.append(poly);
           break;
         }
         if (incident[other].size()!=2) { // Found the end of a closed contour, or a nonmanifold vertex
@@ -74,7 +76,7 @@ const Tuple<Nested<const int>,Nested<const int>>& SegmentSoup::polygons() const
           }
           // If segments are oriented, preserve this order
           reverse(poly.begin(),poly.end());
-          open.push_back(poly);
+          open.append(poly);
           break;
         }
         // Node other is manifold, so continue to the next segment
@@ -84,44 +86,44 @@ const Tuple<Nested<const int>,Nested<const int>>& SegmentSoup::polygons() const
       }
     }
     // Store results
-    polygons_ = tuple(Nested<const int>::copy(closed),Nested<const int>::copy(open));
+    polygons_ = tuple(closed.freeze(),open.freeze());
   }
   return polygons_;
 }
 
 Nested<const int> SegmentSoup::neighbors() const {
+  std::lock_guard<std::recursive_mutex> guard(lock_);
   if (nodes() && !neighbors_.size()) {
     Array<int> lengths(nodes());
     for(int s=0;s<elements.size();s++)
       for(int a=0;a<2;a++)
         lengths[elements[s][a]]++;
-    neighbors_ = Nested<int>(lengths);
+    Nested<int> neighbors(lengths);
     for(int s=0;s<elements.size();s++) {
       int i,j;elements[s].get(i,j);
-      neighbors_(i,neighbors_.size(i)-lengths[i]--) = j;
-      neighbors_(j,neighbors_.size(j)-lengths[j]--) = i;
+      neighbors(i,neighbors.size(i)-lengths[i]--) = j;
+      neighbors(j,neighbors.size(j)-lengths[j]--) = i;
     }
     // Sort and remove duplicates if necessary
-    bool need_copy = false;
-    for(int i=0;i<nodes();i++) {
-      RawArray<int> n = neighbors_[i];
+    parallel_for(nodes(),[&](const int i) {
+      RawArray<int> n = neighbors[i];
       sort(n);
-      int* last = std::unique(n.begin(),n.end());
-      if(last!=n.end())
-        need_copy = true;
-      lengths[i] = int(last-n.begin());
-    }
-    if (need_copy) {
+      lengths[i] = int(std::unique(n.begin(),n.end())-n.begin());
+    },1024);
+    if (lengths.sum()<neighbors.flat.size()) {
       Nested<int> copy(lengths);
-      for(int i=0;i<nodes();i++)
-        copy[i] = neighbors_[i].slice(0,lengths[i]);
-      neighbors_ = copy;
+      parallel_for(nodes(),[&](const int i) {
+        copy[i] = neighbors[i].slice(0,lengths[i]);
+      },1024);
+      neighbors = copy;
     }
+    neighbors_ = neighbors;
   }
   return neighbors_;
 }
 
 Nested<const int> SegmentSoup::incident_elements() const {
+  std::lock_guard<std::recursive_mutex> guard(lock_);
   if (nodes() && !incident_elements_.size()) {
     Array<int> lengths(nodes());
     for (int i=0;i<vertices.size();i++)
@@ -136,21 +138,22 @@ Nested<const int> SegmentSoup::incident_elements() const {
 }
 
 Array<const Vector<int,2>> SegmentSoup::adjacent_elements() const {
+  std::lock_guard<std::recursive_mutex> guard(lock_);
   if (!adjacent_elements_.size() && nodes()) {
-    adjacent_elements_.resize(elements.size(),uninit);
+    Array<Vector<int,2>> adjacent(elements.size(),uninit);
     Nested<const int> incident = incident_elements();
-    for (int s=0;s<elements.size();s++) {
+    parallel_for(elements.size(),[&](const int s) {
       Vector<int,2> seg = elements[s];
       for (int i=0;i<2;i++) {
+        adjacent[s][i] = -1;
         for (int s2 : incident[seg[i]])
           if (elements[s2][i]!=seg[i]) {
-            adjacent_elements_[s][i] = s2;
-            goto found;
+            adjacent[s][i] = s2;
+            break;
           }
-        adjacent_elements_[s][i] = -1;
-        found:;
       }
-    }
+    },1024);
+    adjacent_elements_ = adjacent;
   }
   return adjacent_elements_;
 }
@@ -179,19 +182,36 @@ Array<int> SegmentSoup::nonmanifold_nodes(bool allow_boundary) const {
 }
 
 Array<const Vector<int,3>> SegmentSoup::bending_tuples() const {
+  std::lock_guard<std::recursive_mutex> guard(lock_);
   if (!bending_tuples_valid) {
     Nested<const int> neighbors = this->neighbors();
-    Array<Vector<int,3>> tuples;
+    Array<int> offsets(nodes()+1);
     for (const int p : range(nodes())) {
+      const int k = neighbors.size(p);
+      offsets[p+1] = offsets[p]+k*(k-1)/2;
+    }
+    Array<Vector<int,3>> tuples(offsets.back(),uninit);
+    parallel_for(nodes(),[&](const int p) {
       RawArray<const int> near = neighbors[p];
+      int n = offsets[p];
       for (int i=0;i<near.size();i++) for(int j=i+1;j<near.size();j++)
-        tuples.append(vec(near[i],p,near[j]));
-    }
+        tuples[n++] = vec(near[i],p,near[j]);
+    },1024);
     bending_tuples_ = tuples;
+    bending_tuples_valid = true;
   }
   return bending_tuples_;
 }
 
+void SegmentSoup::build_adjacency() const {
+  std::lock_guard<std::recursive_mutex> guard(lock_);
+  neighbors();
+  incident_elements();
+  adjacent_elements();
+  polygons();
+  bending_tuples();
+}
+
 }
 using namespace geode;
 
@@ -211,5 +231,6 @@ void wrap_segment_soup() {
     .GEODE_METHOD(nonmanifold_nodes)
     .GEODE_METHOD(polygons)
     .GEODE_METHOD(bending_tuples)
+    .GEODE_METHOD(build_adjacency)
     ;
 }
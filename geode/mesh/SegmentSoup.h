@@ -16,6 +16,7 @@
 #include <geode/python/Ref.h>
 #include <geode/vector/Vector.h>
 #include <geode/structure/Tuple.h>
+#include <mutex>
 namespace geode {
 
 class SegmentSoup : public Object {
@@ -35,6 +36,7 @@ private:
   mutable Tuple<Nested<const int>,Nested<const int>> polygons_;
   mutable bool bending_tuples_valid;
   mutable Array<Vector<int,3>> bending_tuples_;
+  mutable std::recursive_mutex lock_; // Guards lazy initialization, so accessors are safe to call concurrently
 
 protected:
   GEODE_CORE_EXPORT explicit SegmentSoup(Array<const Vector<int,2>> elements, const int min_nodes=0);
@@ -60,6 +62,9 @@ public:
   GEODE_CORE_EXPORT Array<TV2> element_normals(RawArray<const TV2> X) const;
   GEODE_CORE_EXPORT Array<int> nonmanifold_nodes(bool allow_boundary) const;
   GEODE_CORE_EXPORT Array<const Vector<int,3>> bending_tuples() const;
+
+  // Compute all lazily cached adjacency structures now, in parallel where possible
+  GEODE_CORE_EXPORT void build_adjacency() const;
 };
 
 }
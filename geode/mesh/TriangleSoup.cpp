@@ -5,8 +5,11 @@
 #include <geode/mesh/SegmentSoup.h>
 #include <geode/array/sort.h>
 #include <geode/array/view.h>
+#include <geode/structure/ConcurrentHashtable.h>
 #include <geode/structure/Hashtable.h>
+#include <geode/utility/parallel.h>
 #include <geode/python/Class.h>
+#include <geode/python/wrap.h>
 namespace geode {
 
 using std::cout;
@@ -35,40 +38,69 @@ TriangleSoup::TriangleSoup(Array<const Vector<int,3>> elements, const int min_no
 
 TriangleSoup::~TriangleSoup() {}
 
+// Number the undirected edges of a soup in order of first appearance, where the edges of triangle (i,j,k) appear in the
+// order ij,jk,ki.  Returns the edges and the edge ids of each triangle.  Edges are collected in parallel, and each
+// belongs to its earliest occurrence, found by an atomic min, so the numbering doesn't depend on the thread count.
+static Tuple<Array<Vector<int,2>>,Array<Vector<int,3>>> number_edges(RawArray<const Vector<int,3>> elements) {
+  const int n = elements.size();
+  const auto edge = [=](const int o) {
+    const auto t = elements[o/3];
+    return vec(t[o%3],t[(o+1)%3]).sorted();
+  };
+  // Each edge is hashed once, in blocks, and the hashes are reused by both hashtable passes
+  Array<Vector<int,2>> keys(3*n,uninit);
+  Array<int> hashes(3*n,uninit);
+  const int block = 4096;
+  parallel_for((3*n+block-1)/block,[&](const int b) {
+    const int lo = b*block,
+              hi = min(3*n,lo+block);
+    for (int o=lo;o<hi;o++)
+      keys[o] = edge(o);
+    hash_batch(keys.slice(lo,hi),hashes.slice(lo,hi));
+  });
+  ConcurrentHashtable<Vector<int,2>,int> first(3*n);
+  parallel_for(3*n,[&](const int o) { first.min(keys[o],o,hashes[o]); },1024);
+  Array<int> owner(3*n,uninit);
+  parallel_for(3*n,[&](const int o) { owner[o] = *first.get_pointer(keys[o],hashes[o]); },1024);
+  Array<int> id(3*n,uninit);
+  Array<Vector<int,2>> edges(first.size(),uninit);
+  for (int o=0,e=0;o<3*n;o++)
+    if (owner[o]==o) {
+      edges[e] = keys[o];
+      id[o] = e++;
+    }
+  Array<Vector<int,3>> triangle_edges(n,uninit);
+  parallel_for(n,[&](const int t) {
+    for (int i=0;i<3;i++)
+      triangle_edges[t][i] = id[owner[3*t+i]];
+  },1024);
+  return tuple(edges,triangle_edges);
+}
+
 Ref<const SegmentSoup> TriangleSoup::segment_soup() const {
+  std::lock_guard<std::recursive_mutex> guard(lock_);
   if (!segment_soup_) {
-    Hashtable<Vector<int,2>> hash;
-    Array<Vector<int,2>> edges;
-    for (const auto t : elements) {
-      const auto e0 = vec(t.x,t.y).sorted(),
-                 e1 = vec(t.y,t.z).sorted(),
-                 e2 = vec(t.z,t.x).sorted();
-      if (hash.set(e0)) edges.append(e0);
-      if (hash.set(e1)) edges.append(e1);
-      if (hash.set(e2)) edges.append(e2);
-    }
-    segment_soup_ = new_<SegmentSoup>(edges,nodes());
+    const auto edges = number_edges(elements);
+    segment_soup_ = new_<SegmentSoup>(edges.x,nodes());
+    triangle_edges_ = edges.y;
   }
   return ref(segment_soup_);
 }
 
 Array<const Vector<int,3>> TriangleSoup::triangle_edges() const {
+  std::lock_guard<std::recursive_mutex> guard(lock_);
   if (!triangle_edges_.size() && nodes()) {
-    // Must match the algorithm of segment_soup() exactly
-    Hashtable<Vector<int,2>,int> hash;
-    triangle_edges_.resize(elements.size(),uninit);
-    for (int i=0;i<elements.size();i++) {
-      const auto t = elements[i];
-      const int e0 = hash.get_or_insert(vec(t.x,t.y).sorted(),hash.size()),
-                e1 = hash.get_or_insert(vec(t.y,t.z).sorted(),hash.size()),
-                e2 = hash.get_or_insert(vec(t.z,t.x).sorted(),hash.size());
-      triangle_edges_[i] = vec(e0,e1,e2);
-    }
+    // Must match the numbering of segment_soup() exactly
+    const auto edges = number_edges(elements);
+    triangle_edges_ = edges.y;
+    if (!segment_soup_)
+      segment_soup_ = new_<SegmentSoup>(edges.x,nodes());
   }
   return triangle_edges_;
 }
 
 Nested<const int> TriangleSoup::incident_elements() const {
+  std::lock_guard<std::recursive_mutex> guard(lock_);
   if (!incident_elements_.size() && nodes()) {
     Array<int> lengths(nodes());
     for (int i=0;i<vertices.size();i++)
@@ -82,30 +114,51 @@ Nested<const int> TriangleSoup::incident_elements() const {
   return incident_elements_;
 }
 
+Nested<const int> TriangleSoup::edge_elements() const {
+  std::lock_guard<std::recursive_mutex> guard(lock_);
+  if (!edge_elements_.size() && nodes()) {
+    const auto edges = triangle_edges();
+    Array<int> lengths(segment_soup_->elements.size());
+    for (const auto& e : edges)
+      for (int i=0;i<3;i++)
+        lengths[e[i]]++;
+    edge_elements_ = Nested<int>(lengths);
+    for (int t=0;t<edges.size();t++) for (int i=0;i<3;i++) {
+      const int e = edges[t][i];
+      edge_elements_(e,edge_elements_.size(e)-lengths[e]--) = t;
+    }
+  }
+  return edge_elements_;
+}
+
 Array<const Vector<int,3>> TriangleSoup::adjacent_elements() const {
+  std::lock_guard<std::recursive_mutex> guard(lock_);
   if (!adjacent_elements_.size() && nodes()) {
-    adjacent_elements_.resize(elements.size(),uninit);
-    Nested<const int> incident = incident_elements();
-    for (int t=0;t<elements.size();t++) {
-      Vector<int,3> tri = elements[t];
-      for (int j=0,i=2;j<3;i=j++) {
-        for (int t2 : incident[tri[i]])
+    // The neighbor across edge (i,j) of a triangle is the first other triangle containing the edge (j,i)
+    const auto edges = triangle_edges();
+    const auto faces = edge_elements();
+    Array<Vector<int,3>> adjacent(elements.size(),uninit);
+    parallel_for(elements.size(),[&](const int t) {
+      const auto tri = elements[t];
+      for (int i=0;i<3;i++) {
+        adjacent[t][i] = -1;
+        for (const int t2 : faces[edges[t][i]])
           if (t!=t2) {
-            int a = elements[t2].find(tri[i]);
-            if (elements[t2][(a+2)%3]==tri[j])  {
-              adjacent_elements_[t][i] = t2;
-              goto found;
+            const int a = elements[t2].find(tri[i]);
+            if (elements[t2][(a+2)%3]==tri[(i+1)%3]) {
+              adjacent[t][i] = t2;
+              break;
             }
           }
-        adjacent_elements_[t][i] = -1;
-        found:;
       }
-    }
+    },1024);
+    adjacent_elements_ = adjacent;
   }
   return adjacent_elements_;
 }
 
 Ref<SegmentSoup> TriangleSoup::boundary_mesh() const {
+  std::lock_guard<std::recursive_mutex> guard(lock_);
   if (!boundary_mesh_) {
     Hashtable<Vector<int,2>,int> hash;
     for (int t=0;t<elements.size();t++)
@@ -130,37 +183,43 @@ Ref<SegmentSoup> TriangleSoup::boundary_mesh() const {
 }
 
 Array<const Vector<int,4>> TriangleSoup::bending_tuples() const {
+  std::lock_guard<std::recursive_mutex> guard(lock_);
   if (!bending_tuples_valid) {
-    Hashtable<Vector<int,2>,Array<int>> edge_to_face;
-    for (int t=0;t<elements.size();t++) {
-      Vector<int,3> nodes = elements[t];
-      for (int a=0;a<3;a++)
-        edge_to_face.get_or_insert(vec(nodes[a],nodes[(a+1)%3]).sorted()).append(t);
+    // Each pair of triangles sharing an edge gives one tuple, ordered by edge
+    const auto edges = segment_soup()->elements;
+    const auto faces = edge_elements();
+    Array<int> offsets(edges.size()+1);
+    for (int e=0;e<edges.size();e++) {
+      const int k = faces.size(e);
+      offsets[e+1] = offsets[e]+k*(k-1)/2;
     }
-    Array<int> other;
-    Array<bool> flipped;
-    for (const auto& it : edge_to_face) {
-      Vector<int,2> sn = it.x;
-      RawArray<const int> tris(it.y);
-      other.clear();
-      other.resize(tris.size(),uninit);
-      flipped.clear();
-      flipped.resize(tris.size(),uninit);
+    Array<Vector<int,4>> tuples(offsets.back(),uninit);
+    parallel_for(edges.size(),[&](const int e) {
+      const auto sn = edges[e];
+      const auto tris = faces[e];
+      // The vertex of triangle t opposite the edge, and whether t traverses the edge as sn[1],sn[0]
+      const auto opposite = [&](const int t) {
+        const auto tn = elements[t];
+        const int b = !sn.contains(tn[0])?0:!sn.contains(tn[1])?1:2;
+        const bool flipped = tn[(b+1)%3]!=sn[0];
+        assert(tn[(b+1)%3]==sn[flipped] && tn[(b+2)%3]==sn[1-flipped]);
+        return vec(tn[b],int(flipped));
+      };
+      int n = offsets[e];
       for (int a=0;a<tris.size();a++) {
-        Vector<int,3> tn = elements[tris[a]];
-        int b = !sn.contains(tn[0])?0:!sn.contains(tn[1])?1:2;
-        other[a] = tn[b];
-        flipped[a] = tn[(b+1)%3]!=sn[0];
-        assert(tn[(b+1)%3]==sn[flipped[a]] && tn[(b+2)%3]==sn[1-flipped[a]]);}
-      for (int a=0;a<tris.size();a++) for (int b=a+1;b<tris.size();b++)
-        bending_tuples_.append(vec(other[a],sn[flipped[a]],sn[1-flipped[a]],other[b]));
-    }
+        const auto oa = opposite(tris[a]);
+        for (int b=a+1;b<tris.size();b++)
+          tuples[n++] = vec(oa.x,sn[oa.y],sn[1-oa.y],opposite(tris[b]).x);
+      }
+    },256);
+    bending_tuples_ = tuples;
     bending_tuples_valid = true;
   }
   return bending_tuples_;
 }
 
 Array<const int> TriangleSoup::nodes_touched() const {
+  std::lock_guard<std::recursive_mutex> guard(lock_);
   if (!nodes_touched_.size() && elements.size()) {
     Hashtable<int> hash;
     for (int t=0;t<elements.size();t++) for (int i=0;i<3;i++)
@@ -172,55 +231,67 @@ Array<const int> TriangleSoup::nodes_touched() const {
 }
 
 Nested<const int> TriangleSoup::sorted_neighbors() const {
+  std::lock_guard<std::recursive_mutex> guard(lock_);
   if (!sorted_neighbors_.size() && elements.size()) {
-    Hashtable<Vector<int,2>,int> next; // next[(i,j)] = k if (i,j,k) is a triangle
-    Hashtable<Vector<int,2>,int> prev; // prev[(i,k)] = j if (i,j,k) is a triangle
-    for (const Vector<int,3>& tri : elements) {
-      next.set(vec(tri[0],tri[1]),tri[2]);
-      next.set(vec(tri[1],tri[2]),tri[0]);
-      next.set(vec(tri[2],tri[0]),tri[1]);
-      prev.set(vec(tri[0],tri[2]),tri[1]);
-      prev.set(vec(tri[1],tri[0]),tri[2]);
-      prev.set(vec(tri[2],tri[1]),tri[0]);
-    }
+    const auto incident = incident_elements();
     Nested<const int> neighbors = segment_soup()->neighbors();
     Nested<int> sorted_neighbors = Nested<int>::empty_like(neighbors);
-    Hashtable<Vector<int,2>> done;
-    for (int i=0;i<node_count;i++) {
+    parallel_for(node_count,[&](const int i) {
       if (!neighbors.size(i))
-        continue;
+        return;
+      // If (i,j,k) is a triangle, the one-ring of i steps from j to k.  Return k if forward, otherwise the j stepping
+      // to k, or -1 if there is none.  If several triangles match, the last wins.
+      const auto step = [&](const int j, const bool forward) {
+        int r = -1;
+        for (const int t : incident[i]) {
+          const auto tri = elements[t];
+          for (int c=0;c<3;c++)
+            if (tri[c]==i && tri[forward?(c+1)%3:(c+2)%3]==j)
+              r = tri[forward?(c+2)%3:(c+1)%3];
+        }
+        return r;
+      };
       // Find a node with no predecessor if one exists
       int j = neighbors(i,0);
       for (int a=1;a<neighbors.size(i);a++) {
-        if (int* p = prev.get_pointer(vec(i,j)))
-          j = *p;
-        else
+        const int p = step(j,false);
+        if (p<0)
           break;
+        j = p;
       }
       // Walk around boundary.  Note that we assume the mesh is manifold (possibly with boundary)
       sorted_neighbors(i,0) = j;
-      try {
-        for (int a=1;a<neighbors.size(i);a++) {
-          j = next.get(vec(i,j));
-          sorted_neighbors(i,a) = j;
-        }
-      } catch (const KeyError&) {
-        throw RuntimeError(format("TriangleSoup::sorted_neighbors failed: node %d",i));
+      for (int a=1;a<neighbors.size(i);a++) {
+        j = step(j,true);
+        if (j<0)
+          throw RuntimeError(format("TriangleSoup::sorted_neighbors failed: node %d",i));
+        sorted_neighbors(i,a) = j;
       }
-    }
+    },256);
     sorted_neighbors_ = sorted_neighbors;
   }
   return sorted_neighbors_;
 }
 
+void TriangleSoup::build_adjacency() const {
+  std::lock_guard<std::recursive_mutex> guard(lock_);
+  incident_elements();
+  adjacent_elements();
+  bending_tuples();
+  nodes_touched();
+  try {
+    sorted_neighbors();
+  } catch (const RuntimeError&) {
+    // Nonmanifold, so leave sorted_neighbors to throw when called
+  }
+}
+
 T TriangleSoup::area(RawArray<const TV2> X) const {
   GEODE_ASSERT(X.size()>=nodes());
-  T sum = 0;
-  for (int t=0;t<elements.size();t++) {
+  return (T).5*parallel_reduce<T>(elements.size(),[&](const int t) {
     int i,j,k;elements[t].get(i,j,k);
-    sum += cross(X[j]-X[i],X[k]-X[i]);
-  }
-  return (T).5*sum;
+    return cross(X[j]-X[i],X[k]-X[i]);
+  });
 }
 
 T TriangleSoup::volume(RawArray<const TV3> X) const {
@@ -233,57 +304,71 @@ T TriangleSoup::volume(RawArray<const TV3> X) const {
   //       = 1/18 sum_t det (3a, b-a, c-a)
   //       = 1/6 sum_t det (a,b,c)
   // where a,b,c are the vertices of each triangle.
-  T sum = 0;
-  for (int t=0;t<elements.size();t++) {
+  return T(1./6)*parallel_reduce<T>(elements.size(),[&](const int t) {
     int i,j,k;elements[t].get(i,j,k);
-    sum += det(X[i],X[j],X[k]);
-  }
-  return T(1./6)*sum;
+    return det(X[i],X[j],X[k]);
+  });
 }
 
 T TriangleSoup::surface_area(RawArray<const TV3> X) const {
   GEODE_ASSERT(X.size()>=nodes());
-  T sum = 0;
-  for (int t=0;t<elements.size();t++) {
+  return T(.5)*parallel_reduce<T>(elements.size(),[&](const int t) {
     int i,j,k;elements[t].get(i,j,k);
-    sum += magnitude(cross(X[j]-X[i],X[k]-X[i]));
-  }
-  return T(.5)*sum;
+    return magnitude(cross(X[j]-X[i],X[k]-X[i]));
+  });
+}
+
+// Unnormalized element normals, with magnitude twice the element area
+static Array<TV3> element_cross(RawArray<const Vector<int,3>> elements, RawArray<const TV3> X) {
+  Array<TV3> N(elements.size(),uninit);
+  parallel_for(elements.size(),[&](const int t) {
+    int i,j,k;elements[t].get(i,j,k);
+    N[t] = cross(X[j]-X[i],X[k]-X[i]);
+  },1024);
+  return N;
 }
 
+// Per vertex quantities are gathered from the incident elements of each vertex rather than scattered from each
+// element, so vertices can be processed in parallel without atomics.  Incident elements are sorted, so the sums
+// match a serial scatter exactly.
+
 Array<T> TriangleSoup::vertex_areas(RawArray<const TV3> X) const {
   GEODE_ASSERT(X.size()>=nodes());
+  const auto N = element_cross(elements,X);
+  const auto incident = incident_elements();
   Array<T> areas(X.size());
-  for (int t=0;t<elements.size();t++) {
-    int i,j,k;elements[t].get(i,j,k);
-    T area = T(1./6)*magnitude(cross(X[j]-X[i],X[k]-X[i]));
-    areas[i] += area;
-    areas[j] += area;
-    areas[k] += area;
-  }
+  parallel_for(incident.size(),[&](const int p) {
+    T sum = 0;
+    for (const int t : incident[p])
+      sum += T(1./6)*magnitude(N[t]);
+    areas[p] = sum;
+  },1024);
   return areas;
 }
 
 Array<TV3> TriangleSoup::vertex_normals(RawArray<const TV3> X) const {
   GEODE_ASSERT(X.size()>=nodes());
+  const auto N = element_cross(elements,X);
+  const auto incident = incident_elements();
   Array<TV3> normals(X.size());
-  for(int t=0;t<elements.size();t++){
-    int i,j,k;elements[t].get(i,j,k);
-    TV3 n = cross(X[j]-X[i],X[k]-X[i]);
-    normals[i]+=n;normals[j]+=n;normals[k]+=n;
-  }
-  for(int i=0;i<X.size();i++)
-    normals[i].normalize();
+  parallel_for(incident.size(),[&](const int p) {
+    TV3 sum;
+    for (const int t : incident[p])
+      sum += N[t];
+    normals[p] = sum.normalized();
+  },1024);
+  for (int p=incident.size();p<X.size();p++)
+    normals[p] = TV3(1,0,0); // What normalized() gives for unused vertices
   return normals;
 }
 
 Array<TV3> TriangleSoup::element_normals(RawArray<const TV3> X) const {
   GEODE_ASSERT(X.size()>=nodes());
   Array<TV3> normals(elements.size(),uninit);
-  for (int t=0;t<elements.size();t++) {
+  parallel_for(elements.size(),[&](const int t) {
     int i,j,k;elements[t].get(i,j,k);
     normals[t] = cross(X[j]-X[i],X[k]-X[i]).normalized();
-  }
+  },1024);
   return normals;
 }
 
@@ -353,6 +438,11 @@ Array<int> TriangleSoup::nonmanifold_nodes(bool allow_boundary) const {
   return nonmanifold;
 }
 
+// The python constructor takes only elements, so unpickling needs this to restore trailing isolated nodes
+static Ref<const TriangleSoup> triangle_soup_with_nodes(Array<const Vector<int,3>> elements, const int nodes) {
+  return new_<TriangleSoup>(elements,nodes);
+}
+
 }
 using namespace geode;
 
@@ -380,5 +470,9 @@ void wrap_triangle_mesh() {
     .GEODE_METHOD(nodes)
     .GEODE_METHOD(nonmanifold_nodes)
     .GEODE_METHOD(sorted_neighbors)
+    .GEODE_METHOD(edge_elements)
+    .GEODE_METHOD(build_adjacency)
     ;
+
+  GEODE_FUNCTION(triangle_soup_with_nodes)
 }
@@ -16,6 +16,7 @@
 #include <geode/python/Ptr.h>
 #include <geode/python/Ref.h>
 #include <geode/vector/Vector.h>
+#include <mutex>
 namespace geode {
 
 class TriangleSoup : public Object {
@@ -40,6 +41,8 @@ private:
   mutable Ptr<SegmentSoup> boundary_mesh_;
   mutable Array<int> nodes_touched_;
   mutable Nested<const int> sorted_neighbors_;
+  mutable Nested<int> edge_elements_;
+  mutable std::recursive_mutex lock_; // Guards lazy initialization, so accessors are safe to call concurrently
 
 protected:
   GEODE_CORE_EXPORT explicit TriangleSoup(Array<const Vector<int,3>> elements, const int min_nodes=0);
@@ -63,6 +66,13 @@ public:
   GEODE_CORE_EXPORT Array<const Vector<int,4>> bending_tuples() const;
   GEODE_CORE_EXPORT Array<const int> nodes_touched() const;
   GEODE_CORE_EXPORT Nested<const int> sorted_neighbors() const; // vertices to sorted one-ring
+  GEODE_CORE_EXPORT Nested<const int> edge_elements() const; // segment_soup() edges to triangles
+
+  // Compute the lazily cached adjacency (edges, incident, adjacent, and edge elements, bending tuples, nodes touched,
+  // and sorted neighbors) now, sharing one edge numbering and running each in parallel.  Force setup usually needs
+  // most of them at once.  sorted_neighbors is skipped if the mesh is nonmanifold, so that calling it later still
+  // throws.
+  GEODE_CORE_EXPORT void build_adjacency() const;
   GEODE_CORE_EXPORT T area(RawArray<const TV2> X) const;
   GEODE_CORE_EXPORT T volume(RawArray<const TV3> X) const; // assumes a closed surface
   GEODE_CORE_EXPORT T surface_area(RawArray<const TV3> X) const;
@@ -10,6 +10,7 @@
 #include <geode/math/constants.h>
 #include <geode/math/cube.h>
 #include <geode/python/Class.h>
+#include <geode/python/wrap.h>
 #include <geode/structure/Hashtable.h>
 #include <geode/utility/tr1.h>
 #include <geode/vector/SparseMatrix.h>
@@ -56,6 +57,7 @@ template<class TV> Array<TV> TriangleSubdivision::linear_subdivide(RawArray<cons
   Ref<const SegmentSoup> segments = coarse_mesh->segment_soup();
   Array<TV> fine_X(offset+segments->elements.size(),uninit);
   fine_X.slice(0,offset) = X;
+  #pragma omp parallel for schedule(static,1024)
   for (int s=0;s<segments->elements.size();s++) {
     int i,j;segments->elements[s].get(i,j);
     fine_X[offset+s]=(T).5*(X[i]+X[j]);
@@ -69,6 +71,7 @@ Array<T,2> TriangleSubdivision::linear_subdivide(RawArray<const T,2> X) const {
   Ref<const SegmentSoup> segments = coarse_mesh->segment_soup();
   Array<T,2> fine_X(offset+segments->elements.size(),X.n,uninit);
   fine_X.slice(0,offset) = X;
+  #pragma omp parallel for schedule(static,1024)
   for (int s=0;s<segments->elements.size();s++) {
     int i,j;segments->elements[s].get(i,j);
     for (int a=0;a<X.n;a++)
@@ -96,6 +99,30 @@ template GEODE_CORE_EXPORT Array<Vector<T,2> > TriangleSubdivision::linear_subdi
 template GEODE_CORE_EXPORT Array<Vector<T,3> > TriangleSubdivision::linear_subdivide(RawArray<const Vector<T,3> >) const;
 template GEODE_CORE_EXPORT Array<Vector<T,4> > TriangleSubdivision::linear_subdivide(RawArray<const Vector<T,4> >) const;
 
+Ref<SparseMatrix> TriangleSubdivision::linear_matrix() const {
+  if (linear_matrix_)
+    return ref(linear_matrix_);
+  // Coarse nodes are copied, and edge nodes average their endpoints
+  const int offset = coarse_mesh->nodes();
+  RawArray<const Vector<int,2>> segments = coarse_mesh->segment_soup()->elements;
+  Array<int> lengths(offset+segments.size(),uninit);
+  lengths.slice(0,offset).fill(1);
+  lengths.slice(offset,lengths.size()).fill(2);
+  Nested<int> J(lengths,uninit);
+  Array<T> A(J.flat.size(),uninit);
+  for (int i=0;i<offset;i++) {
+    J.flat[i] = i;
+    A[i] = 1;
+  }
+  for (int s=0;s<segments.size();s++)
+    for (int a=0;a<2;a++) {
+      J.flat[offset+2*s+a] = segments[s][a];
+      A[offset+2*s+a] = (T).5;
+    }
+  linear_matrix_ = new_<SparseMatrix>(J,A);
+  return ref(linear_matrix_);
+}
+
 static inline T new_loop_alpha(int degree) {
   // Generated by loop-helper script
   static const double alpha[10] = {0.59635416666666663,0.7957589285714286,0.4375,0.5,0.54546609462891005,0.625,0.62427255647332092,0.62242088005687379,0.62007316864426665,0.61765326579615698};
@@ -192,6 +219,10 @@ template<class TV> Array<TV> TriangleSubdivision::loop_subdivide(RawArray<const
   return fine_X;
 }
 
+template GEODE_CORE_EXPORT Array<T> TriangleSubdivision::loop_subdivide(RawArray<const T>) const;
+template GEODE_CORE_EXPORT Array<Vector<T,2> > TriangleSubdivision::loop_subdivide(RawArray<const Vector<T,2> >) const;
+template GEODE_CORE_EXPORT Array<Vector<T,3> > TriangleSubdivision::loop_subdivide(RawArray<const Vector<T,3> >) const;
+
 NdArray<T> TriangleSubdivision::loop_subdivide_python(NdArray<const T> X) const {
   if(X.rank()==1)
     return loop_subdivide(RawArray<const T>(X));
@@ -206,6 +237,34 @@ NdArray<T> TriangleSubdivision::loop_subdivide_python(NdArray<const T> X) const
     GEODE_FATAL_ERROR("expected rank 1 or 2");
 }
 
+template<class Matrix> static Tuple<Ref<const TriangleSoup>,Ref<SparseMatrix>>
+subdivision_operator(const TriangleSoup& mesh, const int levels, Array<const int> corners, Matrix matrix) {
+  GEODE_ASSERT(levels>0);
+  // Coarse nodes keep their indices at every level, so the corners carry over unchanged
+  Ref<const TriangleSoup> fine = ref(mesh);
+  Ptr<SparseMatrix> A;
+  for (int level=0;level<levels;level++) {
+    const auto sub = new_<TriangleSubdivision>(*fine);
+    sub->corners = corners;
+    const auto step = matrix(*sub);
+    A = A ? step->times(*A) : step;
+    fine = sub->fine_mesh;
+  }
+  return tuple(fine,ref(A));
+}
+
+Tuple<Ref<const TriangleSoup>,Ref<SparseMatrix>>
+linear_subdivision_operator(const TriangleSoup& mesh, const int levels) {
+  return subdivision_operator(mesh,levels,Array<const int>(),
+                              [](const TriangleSubdivision& sub) { return sub.linear_matrix(); });
+}
+
+Tuple<Ref<const TriangleSoup>,Ref<SparseMatrix>>
+loop_subdivision_operator(const TriangleSoup& mesh, const int levels, Array<const int> corners) {
+  return subdivision_operator(mesh,levels,corners,
+                              [](const TriangleSubdivision& sub) { return sub.loop_matrix(); });
+}
+
 }
 using namespace geode;
 
@@ -218,5 +277,10 @@ void wrap_triangle_subdivision() {
     .GEODE_FIELD(corners)
     .GEODE_METHOD_2("linear_subdivide",linear_subdivide_python)
     .GEODE_METHOD_2("loop_subdivide",loop_subdivide_python)
+    .GEODE_METHOD(linear_matrix)
+    .GEODE_METHOD(loop_matrix)
     ;
+
+  GEODE_FUNCTION(linear_subdivision_operator)
+  GEODE_FUNCTION(loop_subdivision_operator)
 }
@@ -11,6 +11,7 @@
 #include <geode/python/Object.h>
 #include <geode/python/Ptr.h>
 #include <geode/python/Ref.h>
+#include <geode/structure/Tuple.h>
 #include <geode/vector/Vector.h>
 namespace geode {
 
@@ -25,7 +26,7 @@ public:
   Ref<TriangleSoup> fine_mesh;
   Array<const int> corners; // Change only before subdivision functions are called
 protected:
-  mutable Ptr<SparseMatrix> loop_matrix_;
+  mutable Ptr<SparseMatrix> linear_matrix_, loop_matrix_;
 
   GEODE_CORE_EXPORT TriangleSubdivision(const TriangleSoup& coarse_mesh);
 public:
@@ -44,7 +45,17 @@ public:
   GEODE_CORE_EXPORT Array<T,2> linear_subdivide(RawArray<const T,2> X) const;
   NdArray<T> linear_subdivide_python(NdArray<const T> X) const;
   NdArray<T> loop_subdivide_python(NdArray<const T> X) const;
-  Ref<SparseMatrix> loop_matrix() const;
+
+  // Subdivision operators mapping coarse to fine positions, computed once and cached
+  GEODE_CORE_EXPORT Ref<SparseMatrix> linear_matrix() const;
+  GEODE_CORE_EXPORT Ref<SparseMatrix> loop_matrix() const;
 };
 
+// Compose several levels of subdivision into a single operator from coarse to finest positions, for subdividing the
+// same mesh many times.  Returns the finest mesh and the operator, which is applied with SparseMatrix::multiply.
+GEODE_CORE_EXPORT Tuple<Ref<const TriangleSoup>,Ref<SparseMatrix>>
+linear_subdivision_operator(const TriangleSoup& mesh, const int levels);
+GEODE_CORE_EXPORT Tuple<Ref<const TriangleSoup>,Ref<SparseMatrix>>
+loop_subdivision_operator(const TriangleSoup& mesh, const int levels, Array<const int> corners);
+
 }
@@ -3,10 +3,12 @@
 #include <geode/mesh/TriangleTopology.h>
 #include <geode/mesh/SegmentSoup.h>
 #include <geode/mesh/TriangleSoup.h>
+#include <geode/geometry/DynamicBoxTree.h>
 #include <geode/geometry/SimplexTree.h>
 #include <geode/array/convert.h>
 #include <geode/array/Nested.h>
 #include <geode/array/permute.h>
+#include <geode/array/sort.h>
 #include <geode/python/numpy.h>
 #include <geode/python/Class.h>
 #include <geode/python/wrap.h>
@@ -14,6 +16,7 @@
 #include <geode/structure/Hashtable.h>
 #include <geode/structure/Tuple.h>
 #include <geode/utility/Log.h>
+#include <geode/utility/parallel.h>
 #include <geode/vector/convert.h>
 #include <geode/structure/UnionFind.h>
 namespace geode {
@@ -36,7 +39,9 @@ static string str_halfedge(HalfedgeId e) {
 TriangleTopology::TriangleTopology()
   : n_vertices_(0)
   , n_faces_(0)
-  , n_boundary_edges_(0) {}
+  , n_boundary_edges_(0)
+  , boundary_index_valid(false)
+  , manifold_with_boundary_(false) {}
 
 TriangleTopology::TriangleTopology(const TriangleTopology& mesh, bool copy)
   : n_vertices_(mesh.n_vertices_)
@@ -45,20 +50,24 @@ TriangleTopology::TriangleTopology(const TriangleTopology& mesh, bool copy)
   , faces_(copy ? mesh.faces_.copy() : mesh.faces_)
   , vertex_to_edge_(copy ? mesh.vertex_to_edge_.copy() : mesh.vertex_to_edge_)
   , boundaries_(copy ? mesh.boundaries_.copy() : mesh.boundaries_)
-  , erased_boundaries_(mesh.erased_boundaries_) {}
+  , erased_boundaries_(mesh.erased_boundaries_)
+  , boundary_index_valid(false)
+  , manifold_with_boundary_(false) {}
 
 TriangleTopology::TriangleTopology(RawArray<const Vector<int,3>> faces, const int min_vertices)
   : TriangleTopology() {
   const int nodes = max(faces.size() ? scalar_view(faces).max()+1 : 0, min_vertices);
   internal_add_vertices(nodes);
-  internal_add_faces(faces);
+  if (!internal_bulk_add_faces(faces))
+    internal_add_faces(faces);
   internal_collect_boundary_garbage();
 }
 
 TriangleTopology::TriangleTopology(const TriangleSoup& soup)
   : TriangleTopology() {
   internal_add_vertices(soup.nodes());
-  internal_add_faces(soup.elements);
+  if (!internal_bulk_add_faces(soup.elements))
+    internal_add_faces(soup.elements);
   internal_collect_boundary_garbage();
 }
 
@@ -72,6 +81,38 @@ Ref<MutableTriangleTopology> TriangleTopology::mutate() const {
   return new_<MutableTriangleTopology>(*this,true);
 }
 
+static_assert(sizeof(TriangleTopology::FaceInfo)==6*sizeof(int),"");
+static_assert(sizeof(TriangleTopology::BoundaryInfo)==4*sizeof(int),"");
+
+TriangleTopology::RawState TriangleTopology::raw_state() const {
+  const auto& f = faces_.flat;
+  const auto& v = vertex_to_edge_.flat;
+  return RawState(Array<const int>(6*f.size(),(const int*)f.data(),f.borrow_owner()),
+                  Array<const int>(v.size(),(const int*)v.data(),v.borrow_owner()),
+                  Array<const int>(4*boundaries_.size(),(const int*)boundaries_.data(),boundaries_.borrow_owner()),
+                  vec(n_vertices_,n_faces_,n_boundary_edges_,erased_boundaries_.id));
+}
+
+Ref<TriangleTopology> TriangleTopology::from_raw_state(Array<const int> faces, Array<const int> vertex_to_edge,
+                                                       Array<const int> boundaries, const Vector<int,4> counts) {
+  if (faces.size()%6 || boundaries.size()%4 || min(counts[0],counts[1],counts[2])<0)
+    throw ValueError(format("TriangleTopology::from_raw_state: invalid sizes: faces %d, boundaries %d, counts %s",
+                            faces.size(),boundaries.size(),str(counts)));
+  const auto mesh = new_<TriangleTopology>();
+  const_cast_(mesh->n_vertices_) = counts[0];
+  const_cast_(mesh->n_faces_) = counts[1];
+  const_cast_(mesh->n_boundary_edges_) = counts[2];
+  const_cast_(mesh->erased_boundaries_) = HalfedgeId(counts[3]);
+  const_cast_(mesh->faces_) = Field<const FaceInfo,FaceId>(Array<const FaceInfo>(
+    faces.size()/6,(const FaceInfo*)faces.data(),faces.borrow_owner()));
+  const_cast_(mesh->vertex_to_edge_) = Field<const HalfedgeId,VertexId>(Array<const HalfedgeId>(
+    vertex_to_edge.size(),(const HalfedgeId*)vertex_to_edge.data(),vertex_to_edge.borrow_owner()));
+  const_cast_(mesh->boundaries_) = Array<const BoundaryInfo>(
+    boundaries.size()/4,(const BoundaryInfo*)boundaries.data(),boundaries.borrow_owner());
+  mesh->assert_consistent(false);
+  return mesh;
+}
+
 HalfedgeId TriangleTopology::halfedge(VertexId v0, VertexId v1) const {
   assert(valid(v0));
   const auto start = halfedge(v0);
@@ -161,6 +202,7 @@ static inline void fix_vertex_to_edge(TriangleTopology& mesh, const VertexId v,
 
 // Allocate a fresh boundary edge and set its src and reverse pointers
 HalfedgeId TriangleTopology::unsafe_new_boundary(const VertexId src, const HalfedgeId reverse) {
+  invalidate_boundary_index();
   const_cast_(n_boundary_edges_)++;
   HalfedgeId e;
   if (erased_boundaries_.valid()) {
@@ -272,17 +314,155 @@ FaceId TriangleTopology::internal_add_face(const Vector<VertexId,3> v) {
 }
 
 FaceId TriangleTopology::internal_add_faces(RawArray<const Vector<int,3>> vs) {
-  // TODO: We desperately need a batch insertion routine.
   if (vs.empty()) {
     return FaceId();
   } else {
     FaceId first(faces_.size());
+    const_cast_(faces_).const_cast_().flat.preallocate(faces_.size()+vs.size());
     for (auto& v : vs)
       internal_add_face(Vector<VertexId,3>(v));
     return first;
   }
 }
 
+bool TriangleTopology::internal_bulk_add_faces(RawArray<const Vector<int,3>> vs) {
+  if (vs.empty())
+    return true;
+  const int nv = vertex_to_edge_.size(),
+            nh = 3*vs.size(),
+            f0 = faces_.size(),
+            b0 = boundaries_.size();
+  const auto X = scalar_view(vs);
+  const auto next = [](const int h) { return h%3==2 ? h-2 : h+1; };
+  const auto prev = [](const int h) { return h%3 ? h-1 : h+2; };
+  const auto dst = [=](const int h) { return X[next(h)]; };
+
+  // Check for invalid faces
+  bool bad = false;
+  #pragma omp parallel for reduction(||:bad)
+  for (int f=0;f<vs.size();f++) {
+    const auto& v = vs[f];
+    for (int i=0;i<3;i++)
+      bad = bad || !valid(VertexId(v[i])) || halfedge(VertexId(v[i])).valid() || v[i]==v[(i+1)%3];
+  }
+  if (bad)
+    return false;
+
+  // Bucket (dst,halfedge) pairs by source vertex, in halfedge order so that the result is deterministic
+  Array<int> offsets(nv+1);
+  for (const int v : X)
+    offsets[v+1]++;
+  for (int v=0;v<nv;v++)
+    offsets[v+1] += offsets[v];
+  Array<Vector<int,2>> outgoing(nh,uninit);
+  {
+    auto fill = offsets.slice(0,nv).copy();
+    for (int h=0;h<nh;h++)
+      outgoing[fill[X[h]]++] = vec(dst(h),h);
+  }
+
+  // Find reverse halfedges by searching the bucket of each halfedge's destination.  A repeated oriented edge
+  // means some edge is used more than twice or inconsistently oriented.
+  Array<int> twin(nh,uninit);
+  #pragma omp parallel for reduction(||:bad)
+  for (int v=0;v<nv;v++)
+    for (int a=offsets[v];a<offsets[v+1];a++) {
+      const int u = outgoing[a].x;
+      for (int b=offsets[v];b<a;b++)
+        bad = bad || outgoing[b].x==u;
+      int t = -1;
+      for (int b=offsets[u];b<offsets[u+1];b++)
+        if (outgoing[b].x==v)
+          t = outgoing[b].y;
+      twin[outgoing[a].y] = t;
+    }
+  if (bad)
+    return false;
+
+  // Number boundary edges in order of their interior reverses
+  Array<int> boundary(nh,uninit);
+  int nb = 0;
+  for (int h=0;h<nh;h++)
+    boundary[h] = twin[h]<0 ? nb++ : -1;
+
+  // Each vertex must be surrounded by a single triangle fan, and therefore has at most one outgoing boundary edge
+  Array<int> vertex_boundary(nv,uninit);
+  #pragma omp parallel for reduction(||:bad)
+  for (int v=0;v<nv;v++) {
+    const int n = offsets[v+1]-offsets[v];
+    int out = -1;
+    for (int a=offsets[v];a<offsets[v+1];a++) {
+      const int p = prev(outgoing[a].y);
+      if (twin[p]<0) {
+        bad = bad || out>=0;
+        out = boundary[p];
+      }
+    }
+    vertex_boundary[v] = out;
+    if (n) {
+      // Count the fan containing the first outgoing halfedge by walking left, then right if the fan is open
+      const int start = outgoing[offsets[v]].y;
+      int count = 1;
+      bool closed = false;
+      for (int h=start;count<=n;) {
+        const int t = twin[prev(h)];
+        if (t<0 || t==start) {
+          closed = t==start;
+          break;
+        }
+        h = t;
+        count++;
+      }
+      if (!closed)
+        for (int h=start;count<=n;) {
+          const int t = twin[h];
+          if (t<0)
+            break;
+          h = next(t);
+          count++;
+        }
+      bad = bad || count!=n;
+    }
+  }
+  if (bad)
+    return false;
+
+  // All checks passed, so fill in the mesh
+  // All checks passed, so append to the mesh.  New faces and boundary edges go after existing ones.
+  invalidate_boundary_index();
+  const_cast_(n_faces_) += vs.size();
+  const_cast_(n_boundary_edges_) += nb;
+  const_cast_(faces_).const_cast_().flat.resize(f0+vs.size(),uninit);
+  const_cast_(boundaries_).resize(b0+nb,uninit);
+  const auto faces = faces_.const_cast_().flat.slice(f0,f0+vs.size());
+  const auto boundaries = boundaries_.const_cast_();
+  const int h0 = 3*f0;
+  #pragma omp parallel for
+  for (int h=0;h<nh;h++) {
+    auto& info = faces[h/3];
+    info.vertices[h%3] = VertexId(X[h]);
+    if (twin[h]>=0)
+      info.neighbors[h%3] = HalfedgeId(h0+twin[h]);
+    else {
+      const int b = b0+boundary[h],
+                n = b0+vertex_boundary[X[h]];
+      info.neighbors[h%3] = HalfedgeId(-1-b);
+      boundaries[b].src = VertexId(dst(h));
+      boundaries[b].reverse = HalfedgeId(h0+h);
+      boundaries[b].next = HalfedgeId(-1-n);
+      boundaries[n].prev = HalfedgeId(-1-b);
+    }
+  }
+  const auto vertex_to_edge = vertex_to_edge_.const_cast_();
+  #pragma omp parallel for
+  for (int v=0;v<nv;v++)
+    if (vertex_boundary[v]>=0)
+      vertex_to_edge[VertexId(v)] = HalfedgeId(-1-(b0+vertex_boundary[v]));
+    else if (offsets[v]<offsets[v+1])
+      vertex_to_edge[VertexId(v)] = HalfedgeId(h0+outgoing[offsets[v]].y);
+  return true;
+}
+
 bool TriangleTopology::is_flip_safe(HalfedgeId e0) const {
   if (!valid(e0) || is_boundary(e0))
     return false;
@@ -415,44 +595,17 @@ bool TriangleTopology::is_manifold() const {
 bool TriangleTopology::is_manifold_with_boundary() const {
   if (is_manifold()) // Finish in O(1) time if possible
     return true;
-  for (const auto start : boundary_edges())
-    for (auto e=start;;) {
-      e = left(e);
-      if (e==start)
-        break;
-      if (is_boundary(e)) // There are two boundary halfedges at the same vertex, which is bad.
-        return false;
-    }
-  return true;
+  if (!boundary_index_valid)
+    update_boundary_index();
+  return manifold_with_boundary_;
 }
 
 Nested<FaceId> TriangleTopology::surface_components(VertexId v) const {
-  auto incident = incident_faces(v);
-
-  // map face handles to indices in incident
-  Hashtable<FaceId, int> fmap;
-  for (auto it = incident.begin(); it != incident.end(); ++it) {
-    fmap[*it] = (int)(it-incident.begin());
-  }
-
-  UnionFind union_find((int)incident.size());
-  for (auto ohe : outgoing(v)) {
-    if (is_boundary(ohe) || is_boundary(reverse(ohe)))
-      continue;
-    auto fs = faces(ohe);
-    assert(fmap.contains(fs.x));
-    assert(fmap.contains(fs.y));
-    union_find.merge(fmap[fs.x], fmap[fs.y]);
-  }
-
-  // spit out connected components
-  Hashtable<int, Array<FaceId>> components;
-  for (auto f : incident) {
-    components[union_find.find(fmap[f])].append(f);
-  }
-  Nested<FaceId, false> result;
-  for (auto c : components) {
-    result.append(c.y);
+  Nested<FaceId,false> result;
+  for (const auto component : components(v)) {
+    result.append_empty();
+    for (const auto f : component)
+      result.append_to_back(f);
   }
   return result.freeze();
 }
@@ -472,20 +625,60 @@ int TriangleTopology::degree(VertexId v) const {
   return degree;
 }
 
-Nested<HalfedgeId> TriangleTopology::boundary_loops() const {
+void TriangleTopology::update_boundary_index() const {
   Nested<HalfedgeId> loops;
-  vector<bool> seen(boundaries_.size());
-  for (const auto start : boundary_edges())
-    if (!seen[-1-start.id]) {
+  loops.flat.preallocate(n_boundary_edges());
+  boundary_loop_.copy(constant_map(boundaries_.size(),-1));
+  manifold_with_boundary_ = true;
+  for (const auto start : boundary_edges()) {
+    if (boundary_loop_[-1-start.id] < 0) {
+      const int loop = loops.size();
       auto e = start;
       do {
         loops.flat.append(e);
-        seen[-1-e.id] = true;
+        boundary_loop_[-1-e.id] = loop;
         e = next(e);
       } while (e!=start);
       loops.offsets.const_cast_().append(loops.flat.size());
     }
-  return loops;
+    if (manifold_with_boundary_)
+      for (auto e=start;;) {
+        e = left(e);
+        if (e==start)
+          break;
+        if (is_boundary(e)) { // There are two boundary halfedges at the same vertex, which is bad.
+          manifold_with_boundary_ = false;
+          break;
+        }
+      }
+  }
+  boundary_loops_ = loops;
+  boundary_index_valid = true;
+}
+
+Nested<const HalfedgeId> TriangleTopology::boundary_loops() const {
+  if (!boundary_index_valid)
+    update_boundary_index();
+  return boundary_loops_;
+}
+
+int TriangleTopology::n_boundary_loops() const {
+  if (!boundary_index_valid)
+    update_boundary_index();
+  return boundary_loops_.size();
+}
+
+int TriangleTopology::boundary_loop(HalfedgeId e) const {
+  GEODE_ASSERT(valid(e) && is_boundary(e));
+  if (!boundary_index_valid)
+    update_boundary_index();
+  return boundary_loop_[-1-e.id];
+}
+
+int TriangleTopology::boundary_loop_length(int loop) const {
+  if (!boundary_index_valid)
+    update_boundary_index();
+  return boundary_loops_.size(loop);
 }
 
 void TriangleTopology::dump_internals() const {
@@ -540,6 +733,13 @@ MutableTriangleTopology::MutableTriangleTopology()
   , mutable_boundaries_(const_cast_(boundaries_).const_cast_())
   , mutable_erased_boundaries_(const_cast_(erased_boundaries_))
   , next_field_id(100)
+  , edge_index_enabled(false)
+  , edge_index_valid(false)
+  , normal_tracking_enabled(false)
+  , normals_all_stale(true)
+  , snapshot_taken(false)
+  , garbage_face_cursor(0)
+  , garbage_vertex_cursor(0)
 {}
 
 MutableTriangleTopology::MutableTriangleTopology(const TriangleTopology& mesh, bool copy)
@@ -552,6 +752,13 @@ MutableTriangleTopology::MutableTriangleTopology(const TriangleTopology& mesh, b
   , mutable_boundaries_(const_cast_(boundaries_).const_cast_())
   , mutable_erased_boundaries_(const_cast_(erased_boundaries_))
   , next_field_id(100)
+  , edge_index_enabled(false)
+  , edge_index_valid(false)
+  , normal_tracking_enabled(false)
+  , normals_all_stale(true)
+  , snapshot_taken(false)
+  , garbage_face_cursor(0)
+  , garbage_vertex_cursor(0)
 {}
 
 MutableTriangleTopology::MutableTriangleTopology(const MutableTriangleTopology& mesh, bool copy)
@@ -567,6 +774,13 @@ MutableTriangleTopology::MutableTriangleTopology(const MutableTriangleTopology&
   , id_to_face_field(mesh.id_to_face_field)
   , id_to_halfedge_field(mesh.id_to_halfedge_field)
   , next_field_id(mesh.next_field_id)
+  , edge_index_enabled(false)
+  , edge_index_valid(false)
+  , normal_tracking_enabled(false)
+  , normals_all_stale(true)
+  , snapshot_taken(false)
+  , garbage_face_cursor(0)
+  , garbage_vertex_cursor(0)
 {
   for (const auto& p : mesh.vertex_fields)     vertex_fields.push_back(copy ? p.copy() : p);
   for (const auto& p : mesh.face_fields)         face_fields.push_back(copy ? p.copy() : p);
@@ -583,6 +797,13 @@ MutableTriangleTopology::MutableTriangleTopology(RawArray<const Vector<int,3>> f
   , mutable_boundaries_(const_cast_(boundaries_).const_cast_())
   , mutable_erased_boundaries_(const_cast_(erased_boundaries_))
   , next_field_id(100)
+  , edge_index_enabled(false)
+  , edge_index_valid(false)
+  , normal_tracking_enabled(false)
+  , normals_all_stale(true)
+  , snapshot_taken(false)
+  , garbage_face_cursor(0)
+  , garbage_vertex_cursor(0)
 {}
 
 MutableTriangleTopology::MutableTriangleTopology(TriangleSoup const &soup)
@@ -593,6 +814,7 @@ MutableTriangleTopology::~MutableTriangleTopology() {}
 
 
 HalfedgeId MutableTriangleTopology::unsafe_new_boundary(const VertexId src, const HalfedgeId reverse) {
+  unshare();
   HalfedgeId e = TriangleTopology::unsafe_new_boundary(src, reverse);
 
   // Take care of boundary fields
@@ -602,10 +824,109 @@ HalfedgeId MutableTriangleTopology::unsafe_new_boundary(const VertexId src, cons
 }
 
 
+HalfedgeId MutableTriangleTopology::halfedge(VertexId v0, VertexId v1) const {
+  if (!edge_index_enabled)
+    return TriangleTopology::halfedge(v0,v1);
+  if (!edge_index_valid) {
+    edge_index.clear();
+    for (const auto e : halfedges())
+      edge_index.set(vertices(e),e);
+    edge_index_valid = true;
+  }
+  const auto e = edge_index.get_default(vec(v0,v1));
+  return e.valid() && valid(e) && src(e)==v0 && dst(e)==v1 ? e : HalfedgeId();
+}
+
+void MutableTriangleTopology::enable_edge_index(const bool enable) {
+  edge_index_enabled = enable;
+  edge_index_valid = false;
+  if (!enable)
+    edge_index.clean_memory();
+}
+
+void MutableTriangleTopology::update_edge_index_around(const VertexId v) {
+  if (!edge_index_enabled || !edge_index_valid || isolated(v))
+    return;
+  for (const auto e : outgoing(v)) {
+    const auto r = reverse(e);
+    edge_index.set(vertices(e),e);
+    edge_index.set(vertices(r),r);
+    if (!is_boundary(e)) {
+      const auto n = next(e);
+      edge_index.set(vertices(n),n);
+    }
+  }
+}
+
+void MutableTriangleTopology::enable_normal_tracking(const bool enable) {
+  normal_tracking_enabled = enable;
+  normals_all_stale = true;
+  stale_normals.clean_memory();
+}
+
+void MutableTriangleTopology::touch_normal(const VertexId v) {
+  if (normal_tracking_enabled && !normals_all_stale)
+    stale_normals.append(v);
+}
+
+void MutableTriangleTopology::touch_normals_around(const VertexId v) {
+  if (!normal_tracking_enabled || normals_all_stale)
+    return;
+  stale_normals.append(v);
+  if (!isolated(v))
+    for (const auto e : outgoing(v))
+      stale_normals.append(dst(e));
+}
+
+Field<TV3,VertexId> MutableTriangleTopology::update_vertex_normals(RawField<const TV3,VertexId> X,
+                                                                  Field<TV3,VertexId> normals,
+                                                                  RawArray<const VertexId> moved) {
+  GEODE_ASSERT(X.size()==vertex_to_edge_.size());
+  if (!normal_tracking_enabled || normals_all_stale || normals.size()!=X.size()) {
+    normals_all_stale = !normal_tracking_enabled;
+    stale_normals.clear();
+    return vertex_normals(X);
+  }
+  for (const auto v : moved) {
+    GEODE_ASSERT(valid(v));
+    touch_normals_around(v);
+  }
+
+  // Each stale normal depends only on the faces around it, so they can be recomputed independently
+  sort(stale_normals);
+  const int n = int(std::unique(stale_normals.begin(),stale_normals.end())-stale_normals.begin());
+  parallel_for(n,[&](const int i) {
+    const auto v = stale_normals[i];
+    normals[v] = erased(v) ? TV3() : normal(X,v);
+  },256);
+  stale_normals.clear();
+  return normals;
+}
+
 Ref<MutableTriangleTopology> MutableTriangleTopology::copy() const {
   return new_<MutableTriangleTopology>(*this, true);
 }
 
+Ref<const TriangleTopology> MutableTriangleTopology::snapshot() const {
+  const auto view = new_<TriangleTopology>(*this,false);
+  // Build the lazy boundary index now, since readers may query the view concurrently
+  view->boundary_loops();
+  snapshot_taken = true;
+  return view;
+}
+
+void MutableTriangleTopology::unshare_arrays() {
+  snapshot_taken = false;
+  // Arrays whose snapshots have all been dropped are ours again, and can be edited in place
+  const auto shared = [](const PyObject* owner) { return owner && owner->ob_refcnt>1; };
+  if (shared(mutable_faces_.flat.borrow_owner()))
+    mutable_faces_.flat = mutable_faces_.flat.copy();
+  if (shared(mutable_vertex_to_edge_.flat.borrow_owner()))
+    mutable_vertex_to_edge_.flat = mutable_vertex_to_edge_.flat.copy();
+  if (shared(mutable_boundaries_.borrow_owner()))
+    mutable_boundaries_ = mutable_boundaries_.copy();
+}
+
 VertexId MutableTriangleTopology::add_vertex() {
   return add_vertices(1);
 }
@@ -621,7 +942,22 @@ VertexId MutableTriangleTopology::copy_vertex(VertexId v) {
   return id;
 }
 
+void MutableTriangleTopology::reserve(const int vertices, const int faces, const int boundary_edges) {
+  GEODE_ASSERT(vertices>=0 && faces>=0 && boundary_edges>=0);
+  unshare();
+  mutable_vertex_to_edge_.flat.preallocate(vertices);
+  mutable_faces_.flat.preallocate(faces);
+  mutable_boundaries_.preallocate(boundary_edges);
+  for (auto& s : vertex_fields)
+    s.preallocate(vertices);
+  for (auto& s : face_fields)
+    s.preallocate(faces);
+  for (auto& s : halfedge_fields)
+    s.preallocate(3*faces);
+}
+
 VertexId MutableTriangleTopology::add_vertices(int n) {
+  unshare();
   VertexId id = internal_add_vertices(n);
   for (auto& s : vertex_fields)
     s.extend(n);
@@ -629,7 +965,11 @@ VertexId MutableTriangleTopology::add_vertices(int n) {
 }
 
 FaceId MutableTriangleTopology::add_face(Vector<VertexId,3> v) {
+  unshare();
+  edge_index_valid = false;
   const FaceId id = internal_add_face(v);
+  for (const auto u : v)
+    touch_normal(u);
 
   // Take care of halfedges that transitioned from/to boundary
   for (auto& s : face_fields)
@@ -642,7 +982,17 @@ FaceId MutableTriangleTopology::add_face(Vector<VertexId,3> v) {
 
 // Add many new faces (return the first id, new ids are contiguous)
 FaceId MutableTriangleTopology::add_faces(RawArray<const Vector<int,3>> vs) {
-  FaceId id = internal_add_faces(vs);
+  unshare();
+  edge_index_valid = false;
+  // Faces touching only isolated vertices, such as a new connected component, are linked in one pass
+  FaceId id(faces_.size());
+  if (vs.empty())
+    id = FaceId();
+  else if (!internal_bulk_add_faces(vs))
+    id = internal_add_faces(vs);
+  if (normal_tracking_enabled)
+    for (const int u : scalar_view(vs))
+      touch_normal(VertexId(u));
 
   // Take care of halfedges that transitioned from/to boundary
   for (auto& s : face_fields)
@@ -675,6 +1025,9 @@ static inline HalfedgeId offset_halfedge(HalfedgeId h, int face_offset, int boun
 }
 
 Vector<int,3> MutableTriangleTopology::add(const MutableTriangleTopology& other) {
+  unshare();
+  invalidate_edge_index();
+  invalidate_boundary_index();
   // Record first indices
   const int base_vertex = vertex_to_edge_.size();
   const int base_face = faces_.size();
@@ -759,6 +1112,9 @@ Vector<int,3> MutableTriangleTopology::add(const MutableTriangleTopology& other)
 
 
 void MutableTriangleTopology::flip() {
+  unshare();
+  invalidate_edge_index();
+  invalidate_boundary_index();
 
   // boundary
   for (auto he : boundary_edges()) {
@@ -852,44 +1208,19 @@ Tuple<Ref<MutableTriangleTopology>,
   result->id_to_face_field = id_to_face_field;
   result->id_to_halfedge_field = id_to_halfedge_field;
 
-  // add field data
-  for (auto a : vertex_fields) {
-    result->vertex_fields.push_back(UntypedArray::empty_like(a, result->n_vertices()));
-    auto field = result->vertex_fields.back();
-
-    // copy necessary data
-    for (auto v : old_to_new_vertices) {
-      VertexId vold = v.x;
-      VertexId vnew = v.y;
-      field.copy_from(vnew.idx(), a, vold.idx());
-    }
-  }
-
-  for (auto a : face_fields) {
-    result->face_fields.push_back(UntypedArray::empty_like(a, result->n_faces()));
-    auto field = result->face_fields.back();
-
-    // copy necessary data
-    for (auto f : old_to_new_faces) {
-      FaceId fold = f.x;
-      FaceId fnew = f.y;
-      field.copy_from(fnew.idx(), a, fold.idx());
-    }
-  }
-
-  for (auto a : halfedge_fields) {
-    result->halfedge_fields.push_back(UntypedArray::empty_like(a, 3*result->n_faces()));
-    auto field = result->halfedge_fields.back();
-
-    // copy necessary data
-    for (auto f : old_to_new_faces) {
-      HalfedgeId fold = HalfedgeId(3*f.x.id);
-      HalfedgeId fnew = HalfedgeId(3*f.y.id);
-      field.copy_from(fnew.idx(), a, fold.idx());
-      field.copy_from(fnew.idx()+1, a, fold.idx()+1);
-      field.copy_from(fnew.idx()+2, a, fold.idx()+2);
-    }
-  }
+  // Gather field data, in parallel for large fields
+  Array<int> vertex_sources(result->n_vertices(),uninit),
+             face_sources(result->n_faces(),uninit);
+  for (const auto v : old_to_new_vertices)
+    vertex_sources[v.y.idx()] = v.x.idx();
+  for (const auto f : old_to_new_faces)
+    face_sources[f.y.idx()] = f.x.idx();
+  for (const auto& a : vertex_fields)
+    result->vertex_fields.push_back(gathered(a,vertex_sources));
+  for (const auto& a : face_fields)
+    result->face_fields.push_back(gathered(a,face_sources));
+  for (const auto& a : halfedge_fields)
+    result->halfedge_fields.push_back(gathered(a,face_sources,3));
 
   auto new_to_old_vertices = result->create_compatible_vertex_field<VertexId>();
   for (auto v : old_to_new_vertices) {
@@ -906,6 +1237,8 @@ Tuple<Ref<MutableTriangleTopology>,
 
 
 Array<VertexId> MutableTriangleTopology::split_nonmanifold_vertex(VertexId vi) {
+  unshare();
+  invalidate_edge_index();
   auto components = surface_components(vi);
 
   Array<VertexId> verts;
@@ -968,6 +1301,8 @@ Nested<VertexId> MutableTriangleTopology::split_nonmanifold_vertices() {
 }
 
 Vector<HalfedgeId, 2> MutableTriangleTopology::split_along_edge(HalfedgeId he) {
+  unshare();
+  invalidate_edge_index();
   auto re = reverse(he);
 
   auto b_he = unsafe_new_boundary(dst(he), he);
@@ -988,6 +1323,8 @@ Vector<HalfedgeId, 2> MutableTriangleTopology::split_along_edge(HalfedgeId he) {
 }
 
 void MutableTriangleTopology::split_face(const FaceId f, const VertexId c) {
+  unshare();
+  edge_index_valid = false;
   GEODE_ASSERT(valid(f) && isolated(c));
   const auto v = faces_[f].vertices;
   const auto n = faces_[f].neighbors;
@@ -1022,6 +1359,7 @@ void MutableTriangleTopology::split_face(const FaceId f, const VertexId c) {
       s.swap(3*f.id+i,reverse(n[i]).id);
     }
   }
+  touch_normals_around(c);
 }
 
 VertexId MutableTriangleTopology::split_face(FaceId f) {
@@ -1031,6 +1369,7 @@ VertexId MutableTriangleTopology::split_face(FaceId f) {
 }
 
 Vector<HalfedgeId,2> MutableTriangleTopology::unsafe_split_halfedge(HalfedgeId h, FaceId nf, VertexId c) {
+  unshare();
   assert(!is_boundary(h));
 
   // Remember the old structure
@@ -1069,37 +1408,80 @@ Vector<HalfedgeId,2> MutableTriangleTopology::unsafe_split_halfedge(HalfedgeId h
   return vec(h,halfedge(nf,0));
 }
 
+// Add storage and fields for n faces which will be filled in by the caller
+void MutableTriangleTopology::grow_faces(const int n) {
+  mutable_n_faces_ += n;
+  mutable_faces_.flat.resize(faces_.size()+n);
+  for (auto& s : face_fields)
+    s.extend(n);
+  for (auto& s : halfedge_fields)
+    s.extend(3*n);
+}
+
 void MutableTriangleTopology::split_edge(HalfedgeId h, VertexId c) {
+  unshare();
   // Make sure h is not the boundary (if there is a boundary)
   if (is_boundary(h))
     h = reverse(h);
 
-  const auto hr = reverse(h);
-
-  // check for a boundary
-  const bool h_is_boundary = is_boundary(hr);
-
   // first, grow the storage by the right amount, so we don't do that in pieces
-  const int n_new_faces = h_is_boundary ? 1 : 2;
   const int base_faces = faces_.size();
-  mutable_n_faces_ += n_new_faces;
-  mutable_faces_.flat.resize(base_faces + n_new_faces);
-  for (auto& s : face_fields)
-    s.extend(n_new_faces);
-  for (auto& s : halfedge_fields)
-    s.extend(3*n_new_faces);
+  grow_faces(is_boundary(reverse(h)) ? 1 : 2);
+  unsafe_split_edge(h,c,FaceId(base_faces));
+}
 
-  if (h_is_boundary) {
-    // Take care of changed boundary edges
-    // ...
+Array<VertexId> MutableTriangleTopology::split_edges(RawArray<const HalfedgeId> edges) {
+  unshare();
+  // Splitting an edge renumbers other halfedges of its faces, so remember edges by their vertices
+  Array<Vector<VertexId,2>> ends(edges.size(),uninit);
+  int n_new_faces = 0;
+  for (const int i : range(edges.size())) {
+    const auto e = edges[i];
+    GEODE_ASSERT(valid(e),format("split_edges: invalid halfedge %d",e.id));
+    ends[i] = vertices(e);
+    n_new_faces += is_boundary(e) || is_boundary(reverse(e)) ? 1 : 2;
+  }
+  {
+    Array<Vector<int,2>> sorted(edges.size(),uninit);
+    for (const int i : range(edges.size()))
+      sorted[i] = vec(ends[i].x.id,ends[i].y.id).sorted();
+    sort(sorted,LexicographicCompare());
+    for (const int i : range(1,sorted.size()))
+      if (sorted[i-1]==sorted[i])
+        throw ValueError(format("split_edges: edge (%d,%d) appears more than once",sorted[i].x,sorted[i].y));
+  }
+
+  // Grow vertices, faces, and fields once for the whole batch
+  const auto c0 = add_vertices(edges.size());
+  int next_face = faces_.size();
+  grow_faces(n_new_faces);
+  Array<VertexId> result(edges.size(),uninit);
+  for (const int i : range(edges.size())) {
+    auto h = halfedge(ends[i].x,ends[i].y);
+    if (is_boundary(h))
+      h = reverse(h);
+    const VertexId c(c0.id+i);
+    const int n = is_boundary(reverse(h)) ? 1 : 2;
+    unsafe_split_edge(h,c,FaceId(next_face));
+    next_face += n;
+    result[i] = c;
   }
+  return result;
+}
 
-  const auto dangling = unsafe_split_halfedge(h,FaceId(base_faces),c);
+void MutableTriangleTopology::unsafe_split_edge(const HalfedgeId h, const VertexId c, const FaceId nf) {
+  assert(!is_boundary(h));
+  const auto hr = reverse(h);
+
+  // check for a boundary
+  const bool h_is_boundary = is_boundary(hr);
+
+  const auto dangling = unsafe_split_halfedge(h,nf,c);
 
   // Now deal with reverse(h)
   Vector<HalfedgeId,2> dangling2;
   if (!h_is_boundary)
-    dangling2 = unsafe_split_halfedge(hr,FaceId(base_faces+1),c);
+    dangling2 = unsafe_split_halfedge(hr,FaceId(nf.id+1),c);
   else {
     // Deal with a boundary edge hr
     dangling2.x = hr;
@@ -1115,6 +1497,8 @@ void MutableTriangleTopology::split_edge(HalfedgeId h, VertexId c) {
 
   // Make sure vertex is connected
   mutable_vertex_to_edge_[c] = dangling2.y;
+  update_edge_index_around(c);
+  touch_normals_around(c);
 }
 
 VertexId MutableTriangleTopology::split_edge(HalfedgeId e) {
@@ -1166,6 +1550,7 @@ bool MutableTriangleTopology::is_collapse_safe(HalfedgeId h) const {
 }
 
 void MutableTriangleTopology::unsafe_collapse(HalfedgeId h) {
+  unshare();
   GEODE_ASSERT(valid(h));
 
   HalfedgeId o = reverse(h);
@@ -1295,6 +1680,9 @@ void MutableTriangleTopology::unsafe_collapse(HalfedgeId h) {
   }
 
   assert(!erased(halfedge(v1)));
+  update_edge_index_around(v1);
+  touch_normal(v0);
+  touch_normals_around(v1);
 }
 
 void MutableTriangleTopology::collapse(HalfedgeId h) {
@@ -1305,6 +1693,8 @@ void MutableTriangleTopology::collapse(HalfedgeId h) {
 }
 
 void MutableTriangleTopology::collapse_degenerate_face_pair(const HalfedgeId e01) {
+  unshare();
+  invalidate_edge_index();
   const HalfedgeId e10 = reverse(e01);
   // The same opposite vertex on two connected faces means they are identical
   assert(opposite(e01) == opposite(e10));
@@ -1349,6 +1739,8 @@ void MutableTriangleTopology::collapse_degenerate_face_pair(const HalfedgeId e01
 }
 
 Vector<FaceId,2> MutableTriangleTopology::split_loop(HalfedgeId e01, HalfedgeId e12, HalfedgeId e20) {
+  unshare();
+  invalidate_edge_index();
   
   const VertexId v0 = src(e01);
   const VertexId v1 = src(e12);
@@ -1425,6 +1817,7 @@ HalfedgeId MutableTriangleTopology::flip_edge(HalfedgeId e) {
 }
 
 bool MutableTriangleTopology::unsafe_replace_vertex(FaceId id, VertexId oldv, VertexId newv) {
+  unshare();
   for (int i = 0; i < 3; ++i) {
     if (faces_[id].vertices[i] == oldv) {
       mutable_faces_[id].vertices[i] = newv;
@@ -1435,6 +1828,7 @@ bool MutableTriangleTopology::unsafe_replace_vertex(FaceId id, VertexId oldv, Ve
 }
 
 bool MutableTriangleTopology::ensure_boundary_halfedge(VertexId v) {
+  unshare();
   bool is_boundary_now = is_boundary(halfedge(v));
   for (auto he : outgoing(v)) {
     if (is_boundary(he) && !is_boundary_now) {
@@ -1446,6 +1840,7 @@ bool MutableTriangleTopology::ensure_boundary_halfedge(VertexId v) {
 }
 
 HalfedgeId MutableTriangleTopology::unsafe_flip_edge(HalfedgeId e0) {
+  unshare();
   const auto e1 = reverse(e0);
   const auto f0 = face(e0),
              f1 = face(e1);
@@ -1484,6 +1879,14 @@ HalfedgeId MutableTriangleTopology::unsafe_flip_edge(HalfedgeId e0) {
     s.swap(p1.id,reverse(rp1).id);
   }
 
+  // Both faces have new halfedge ids
+  if (edge_index_enabled && edge_index_valid)
+    for (const auto f : vec(f0,f1))
+      for (const auto e : halfedges(f))
+        edge_index.set(vertices(e),e);
+  for (const auto v : vec(v0,v1,o0,o1))
+    touch_normal(v);
+
   return HalfedgeId(3*f0.id);
 }
 
@@ -1504,6 +1907,11 @@ static HalfedgeId interior_prev(const HalfedgeId he)
 { return HalfedgeId{he.id+(he.id%3==0?2:-1)}; }
 
 void MutableTriangleTopology::unflip_edge(const UnflippedEdgeState u) {
+  unshare();
+  edge_index_valid = false;
+  for (const auto& f : u.old_faces)
+    for (const auto v : f.vertices)
+      touch_normal(v);
 
   // Reconstruct original ids from saved data
   const auto faces = Vector<FaceId,2>{FaceId{u.e0.id/3}, FaceId{u.e1.id/3}};
@@ -1538,6 +1946,8 @@ void MutableTriangleTopology::unflip_edge(const UnflippedEdgeState u) {
 }
 
 void MutableTriangleTopology::erase_last_vertex_with_reordering() {
+  unshare();
+  invalidate_edge_index();
   const VertexId v(vertex_to_edge_.size()-1);
   // Erase all incident faces
   while (!isolated(v))
@@ -1553,6 +1963,7 @@ void MutableTriangleTopology::erase_last_vertex_with_reordering() {
 }
 
 void MutableTriangleTopology::erase_isolated_vertices() {
+  unshare();
   auto marked = create_compatible_vertex_field<bool>();
   for (auto f : faces()) {
     for (auto v : vertices(f)) {
@@ -1568,6 +1979,8 @@ void MutableTriangleTopology::erase_isolated_vertices() {
 }
 
 void MutableTriangleTopology::erase_face_with_reordering(const FaceId f) {
+  unshare();
+  invalidate_edge_index();
   GEODE_ASSERT(f.valid());
   GEODE_ASSERT(f.id != erased_id);
 
@@ -1638,6 +2051,8 @@ void MutableTriangleTopology::erase_face_with_reordering(const FaceId f) {
 }
 
 void MutableTriangleTopology::permute_vertices(RawArray<const int> permutation, bool check) {
+  unshare();
+  invalidate_edge_index();
   GEODE_ASSERT(n_vertices()==permutation.size());
   GEODE_ASSERT(n_vertices()==vertex_to_edge_.size()); // Require no erased vertices
 
@@ -1671,11 +2086,109 @@ void MutableTriangleTopology::permute_vertices(RawArray<const int> permutation,
     inplace_partial_permute(s,permutation,work);
 }
 
+void MutableTriangleTopology::permute_faces(RawArray<const int> permutation, bool check) {
+  unshare();
+  invalidate_edge_index();
+  GEODE_ASSERT(n_faces()==permutation.size());
+  GEODE_ASSERT(n_faces()==faces_.size()); // Require no erased faces
+  if (check) {
+    Array<bool> seen(permutation.size());
+    for (const int p : permutation) {
+      GEODE_ASSERT(seen.valid(p) && !seen[p]);
+      seen[p] = true;
+    }
+  }
+  const auto move = [=](HalfedgeId& e) {
+    if (e.id>=0 && e.id!=erased_id)
+      e = HalfedgeId(3*permutation[e.id/3]+e.id%3);
+  };
+
+  // Permute faces_ out of place
+  Array<FaceInfo> new_faces(faces_.size(),uninit);
+  for (const int f : range(faces_.size())) {
+    auto& info = new_faces[permutation[f]];
+    info = faces_.flat[f];
+    for (auto& e : info.neighbors)
+      move(e);
+  }
+  mutable_faces_.flat = new_faces;
+
+  // The other arrays can be modified in place
+  for (auto& e : mutable_vertex_to_edge_.flat)
+    move(e);
+  for (auto& b : mutable_boundaries_)
+    if (b.src.id!=erased_id)
+      move(b.reverse);
+
+  // Permute fields
+  Array<char> work;
+  for (auto& s : face_fields)
+    inplace_partial_permute(s,permutation,work);
+  for (auto& s : halfedge_fields)
+    inplace_partial_permute(s,permutation,work,3);
+}
+
+Vector<Array<int>,3> MutableTriangleTopology::reorder_for_locality() {
+  auto permutations = collect_garbage();
+
+  // Number vertices in breadth first order, one connected component at a time
+  const int nv = n_vertices();
+  Array<int> vertex_permutation(nv,uninit),
+             order(nv,uninit);
+  vertex_permutation.fill(-1);
+  int n = 0;
+  for (const int start : range(nv))
+    if (vertex_permutation[start]<0) {
+      vertex_permutation[start] = n;
+      order[n++] = start;
+      for (int i=n-1;i<n;i++) {
+        const VertexId v(order[i]);
+        if (!isolated(v))
+          for (const auto e : outgoing(v)) {
+            const int u = dst(e).id;
+            if (vertex_permutation[u]<0) {
+              vertex_permutation[u] = n;
+              order[n++] = u;
+            }
+          }
+      }
+    }
+  permute_vertices(vertex_permutation);
+
+  // Stably sort faces by their lowest vertex
+  const int nf = n_faces();
+  Array<int> offsets(nv+1),
+             face_permutation(nf,uninit);
+  const auto lowest = [this](const FaceId f) {
+    const auto v = faces_[f].vertices;
+    return min(v.x.id,v.y.id,v.z.id);
+  };
+  for (const auto f : faces())
+    offsets[lowest(f)+1]++;
+  for (const int v : range(nv))
+    offsets[v+1] += offsets[v];
+  for (const auto f : faces())
+    face_permutation[f.id] = offsets[lowest(f)]++;
+  permute_faces(face_permutation);
+
+  // Compose with the garbage collection permutations
+  for (auto& p : permutations.x)
+    if (p>=0)
+      p = vertex_permutation[p];
+  for (auto& p : permutations.y)
+    if (p>=0)
+      p = face_permutation[p];
+  return permutations;
+}
+
 // erase the given vertex. erases all incident faces. If erase_isolated is true, also erase other vertices that are now isolated.
 void MutableTriangleTopology::erase(VertexId id, bool erase_isolated) {
+  unshare();
+  edge_index_valid = false;
   // TODO: Make a better version of this. For now, just erase all incident faces
   // and then our own (or have it automatically erased if erase_isolated is true)
   GEODE_ASSERT(!erased(id));
+  touch_normal(id);
 
   while (!isolated(id))
     erase(face(reverse(halfedge(id))));
@@ -1688,6 +2201,8 @@ void MutableTriangleTopology::erase(VertexId id, bool erase_isolated) {
 
 // erase the given halfedge. erases all incident faces as well. If erase_isolated is true, also erase incident vertices that are now isolated.
 void MutableTriangleTopology::erase(HalfedgeId id, bool erase_isolated) {
+  unshare();
+  edge_index_valid = false;
   auto he = faces(id);
   for (auto h : he) {
     if (valid(h)) {
@@ -1698,7 +2213,11 @@ void MutableTriangleTopology::erase(HalfedgeId id, bool erase_isolated) {
 
 // erase the given face. If erase_isolated is true, also erases incident vertices that are now isolated.
 void MutableTriangleTopology::erase(FaceId f, bool erase_isolated) {
+  unshare();
+  edge_index_valid = false;
   GEODE_ASSERT(!erased(f));
+  for (const auto v : faces_[f].vertices)
+    touch_normal(v);
 
   // Look up connectivity of neighboring boundary edges, then erase them
   const auto e = faces_[f].neighbors;
@@ -1746,6 +2265,9 @@ void MutableTriangleTopology::erase(FaceId f, bool erase_isolated) {
 // vertices, faces, and boundary halfedges, such that the old primitive i now has index permutation[i].
 // Note: non-boundary halfedges don't change order within triangles, so halfedge 3*f+i is now 3*permutation[f]+i
 Vector<Array<int>,3> MutableTriangleTopology::collect_garbage() {
+  unshare();
+  invalidate_edge_index();
+  invalidate_boundary_index();
   Array<int> vertex_permutation(vertex_to_edge_.size()), face_permutation(faces_.size()), boundary_permutation(boundaries_.size());
 
   // first, compact vertex indices (because we only ever decrease ids, we can do this in place)
@@ -1830,7 +2352,81 @@ Vector<Array<int>,3> MutableTriangleTopology::collect_garbage() {
   return vec(vertex_permutation,face_permutation,boundary_permutation);
 }
 
+Vector<Array<Vector<int,2>>,2> MutableTriangleTopology::collect_garbage_incrementally(const int work) {
+  unshare();
+  invalidate_edge_index();
+  invalidate_boundary_index();
+  Vector<Array<Vector<int,2>>,2> moves;
+
+  // Drop erased faces and vertices at the end of storage
+  const auto trim = [this]() {
+    while (faces_.size() && erased(FaceId(faces_.size()-1))) {
+      mutable_faces_.flat.pop();
+      for (auto& s : face_fields)
+        s.extend(-1);
+      for (auto& s : halfedge_fields)
+        s.extend(-3);
+    }
+    while (vertex_to_edge_.size() && erased(VertexId(vertex_to_edge_.size()-1))) {
+      mutable_vertex_to_edge_.flat.pop();
+      for (auto& s : vertex_fields)
+        s.extend(-1);
+    }
+  };
+  trim();
+
+  // Fill erased face slots with the last face
+  for (int n=0;n<work && faces_.size();n++) {
+    if (garbage_face_cursor>=faces_.size())
+      garbage_face_cursor = 0;
+    const FaceId f(garbage_face_cursor++);
+    if (!erased(f))
+      continue;
+    const FaceId f1(faces_.size()-1);
+    const auto I = faces_[f1];
+    mutable_faces_[f].vertices = I.vertices;
+    for (int i=0;i<3;i++) {
+      unsafe_set_reverse(f,i,I.neighbors[i]);
+      if (vertex_to_edge_[I.vertices[i]].id==3*f1.id+i)
+        mutable_vertex_to_edge_[I.vertices[i]].id = 3*f.id+i;
+    }
+    mutable_faces_[f1].vertices.x.id = erased_id;
+    for (auto& s : face_fields)
+      s.swap(f.id,f1.id);
+    for (auto& s : halfedge_fields)
+      for (int i=0;i<3;i++)
+        s.swap(3*f.id+i,3*f1.id+i);
+    moves.y.append(vec(f1.id,f.id));
+    trim();
+  }
+
+  // Fill erased vertex slots with the last vertex
+  for (int n=0;n<work && vertex_to_edge_.size();n++) {
+    if (garbage_vertex_cursor>=vertex_to_edge_.size())
+      garbage_vertex_cursor = 0;
+    const VertexId v(garbage_vertex_cursor++);
+    if (!erased(v))
+      continue;
+    const VertexId v1(vertex_to_edge_.size()-1);
+    if (!isolated(v1))
+      for (const auto e : outgoing(v1)) {
+        if (e.id>=0)
+          mutable_faces_.flat[e.id/3].vertices[e.id%3] = v;
+        else
+          unsafe_set_src(e,v);
+      }
+    mutable_vertex_to_edge_[v] = vertex_to_edge_[v1];
+    mutable_vertex_to_edge_[v1].id = erased_id;
+    for (auto& s : vertex_fields)
+      s.swap(v.id,v1.id);
+    moves.x.append(vec(v1.id,v.id));
+    trim();
+  }
+  return moves;
+}
+
 Array<int> TriangleTopology::internal_collect_boundary_garbage() {
+  invalidate_boundary_index();
   // Compact boundaries
   int j = 0;
   Array<int> boundary_permutation(boundaries_.size());
@@ -1864,6 +2460,8 @@ Array<int> TriangleTopology::internal_collect_boundary_garbage() {
 }
 
 Array<int> MutableTriangleTopology::collect_boundary_garbage() {
+  unshare();
+  invalidate_edge_index();
   const auto p = internal_collect_boundary_garbage();
   // Once we have boundary fields, we will need to apply p to them
   return p;
@@ -1878,21 +2476,17 @@ bool TriangleTopology::is_garbage_collected() const {
 Array<VertexId> TriangleTopology::vertex_one_ring(VertexId v) const {
   GEODE_ASSERT(valid(v));
   Array<VertexId> result;
-  for (auto h : outgoing(v)) {
-    result.append(dst(h));
-  }
+  for (const auto u : neighbors(v))
+    result.append(u);
   return result;
 }
 
 Array<FaceId> TriangleTopology::incident_faces(VertexId v) const {
   GEODE_ASSERT(valid(v));
-  Array<FaceId> faces;
-  for (const auto h : outgoing(v)) {
-    const auto f = face(h);
-    if (f.valid())
-      faces.append(f);
-  }
-  return faces;
+  Array<FaceId> result;
+  for (const auto f : faces(v))
+    result.append(f);
+  return result;
 }
 
 int TriangleTopology::valence(VertexId v) const {
@@ -2259,6 +2853,67 @@ HalfedgeId TriangleTopology::safe_halfedge_between(VertexId v0, VertexId v1) con
   return halfedge(v0,v1);
 }
 
+// Batch versions of the safe functions.  Ids are checked inside the parallel loop, so an error reports whichever
+// invalid entry is found first, not necessarily the lowest.
+static const int batch_grain = 4096;
+
+#define MAKE_BATCH_2(ff,f,Id) \
+  Array<decltype((*(const TriangleTopology*)0).f(Id()))> TriangleTopology::batch_##ff(RawArray<const Id> x) const { \
+    Array<decltype(f(Id()))> result(x.size(),uninit); \
+    parallel_for(x.size(),[&](const int i) { \
+      if (!valid(x[i])) \
+        throw ValueError(format("TriangleTopology::batch_" #ff ": entry %d: %s",i,id_error(*this,x[i]))); \
+      result[i] = f(x[i]); \
+    },batch_grain); \
+    return result; \
+  }
+#define MAKE_BATCH(f,Id) MAKE_BATCH_2(f,f,Id)
+MAKE_BATCH(halfedge,VertexId)
+MAKE_BATCH(prev,    HalfedgeId)
+MAKE_BATCH(next,    HalfedgeId)
+MAKE_BATCH(reverse, HalfedgeId)
+MAKE_BATCH(src,     HalfedgeId)
+MAKE_BATCH(dst,     HalfedgeId)
+MAKE_BATCH(face,    HalfedgeId)
+MAKE_BATCH_2(face_vertices,    vertices, FaceId)
+MAKE_BATCH_2(face_halfedges,   halfedges,FaceId)
+MAKE_BATCH_2(halfedge_vertices,vertices, HalfedgeId)
+MAKE_BATCH_2(face_faces,       faces,    FaceId)
+MAKE_BATCH_2(halfedge_faces,   faces,    HalfedgeId)
+#undef MAKE_BATCH
+#undef MAKE_BATCH_2
+
+Array<HalfedgeId> TriangleTopology::batch_halfedge_between(RawArray<const VertexId> v0,
+                                                           RawArray<const VertexId> v1) const {
+  GEODE_ASSERT(v0.size()==v1.size());
+  Array<HalfedgeId> result(v0.size(),uninit);
+  parallel_for(v0.size(),[&](const int i) {
+    const bool b0 = !valid(v0[i]),
+               b1 = !valid(v1[i]);
+    if (b0 || b1)
+      throw ValueError(format("TriangleTopology::batch_halfedge_between: entry %d: %s vertex error: %s",
+        i,b0 ? "first" : "second",id_error(*this,b0 ? v0[i] : v1[i])));
+    result[i] = halfedge(v0[i],v1[i]);
+  },batch_grain);
+  return result;
+}
+
+Nested<VertexId> TriangleTopology::batch_vertex_one_ring(RawArray<const VertexId> v) const {
+  Array<int> degrees(v.size(),uninit);
+  parallel_for(v.size(),[&](const int i) {
+    if (!valid(v[i]))
+      throw ValueError(format("TriangleTopology::batch_vertex_one_ring: entry %d: %s",i,id_error(*this,v[i])));
+    degrees[i] = degree(v[i]);
+  },batch_grain);
+  Nested<VertexId> rings(degrees,uninit);
+  parallel_for(v.size(),[&](const int i) {
+    int k = rings.offsets[i];
+    for (const auto h : outgoing(v[i]))
+      rings.flat[k++] = dst(h);
+  },batch_grain);
+  return rings;
+}
+
 Tuple<Ref<SegmentSoup>,Array<HalfedgeId>> TriangleTopology::edge_soup() const {
   Array<Vector<int,2>> edges;
   Array<HalfedgeId> indices;
@@ -2327,6 +2982,17 @@ TV3 TriangleTopology::normal(RawField<const TV3,VertexId> X, const VertexId v) c
   return n;
 }
 
+Field<TV3,VertexId> TriangleTopology::vertex_normals(RawField<const TV3,VertexId> X) const {
+  GEODE_ASSERT(X.size()==vertex_to_edge_.size());
+  Field<TV3,VertexId> normals(X.size(),uninit);
+  // Gather from the faces around each vertex, so that vertices are independent
+  parallel_for(X.size(),[&](const int i) {
+    const VertexId v(i);
+    normals[v] = erased(v) ? TV3() : normal(X,v);
+  },256);
+  return normals;
+}
+
 T TriangleTopology::dihedral(RawField<const TV3,VertexId> X, const HalfedgeId e) const {
   const auto t0 = triangle(X,face(e)),
              t1 = triangle(X,face(reverse(e)));
@@ -2374,6 +3040,18 @@ T TriangleTopology::cos_dihedral(RawField<const TV3,VertexId> X, const HalfedgeI
   Tuple<Ref<SimplexTree<TV,2>>,Array<FaceId>> TriangleTopology::face_tree(Field<const TV,VertexId> X, const int leaf_size) const { \
     const auto soup = face_soup(); \
     return tuple(new_<SimplexTree<TV,2>>(soup.x,X.flat,leaf_size),soup.y); \
+  } \
+  Ref<DynamicBoxTree<TV>> TriangleTopology::dynamic_face_tree(RawField<const TV,VertexId> X, const real margin) const { \
+    const auto tree = new_<DynamicBoxTree<TV>>(margin); \
+    for (const auto f : faces()) \
+      tree->insert(f.idx(),triangle(X,f).bounding_box()); \
+    return tree; \
+  } \
+  Ref<DynamicBoxTree<TV>> TriangleTopology::dynamic_vertex_tree(RawField<const TV,VertexId> X, const real margin) const { \
+    const auto tree = new_<DynamicBoxTree<TV>>(margin); \
+    for (const auto v : vertices()) \
+      tree->insert(v.idx(),Box<TV>(X[v])); \
+    return tree; \
   }
 PER_DIMENSION(TV2)
 PER_DIMENSION(TV3)
@@ -2390,6 +3068,18 @@ Ref<> TriangleTopology::face_tree_py(Array<const T,2> X) const {
   else if (X.n==3) return to_python_ref(face_tree(Field<const TV3,VertexId>(vector_view_own<3>(X.flat))));
   throw ValueError(format("TriangleTopology::face_tree: Expected 2D or 3D vectors, got shape %s",str(X.sizes())));
 }
+
+Ref<> TriangleTopology::dynamic_face_tree_py(Array<const T,2> X, const T margin) const {
+  if (X.n==2)      return to_python_ref(dynamic_face_tree(Field<const TV2,VertexId>(vector_view_own<2>(X.flat)),margin));
+  else if (X.n==3) return to_python_ref(dynamic_face_tree(Field<const TV3,VertexId>(vector_view_own<3>(X.flat)),margin));
+  throw ValueError(format("TriangleTopology::dynamic_face_tree: Expected 2D or 3D vectors, got shape %s",str(X.sizes())));
+}
+
+Ref<> TriangleTopology::dynamic_vertex_tree_py(Array<const T,2> X, const T margin) const {
+  if (X.n==2)      return to_python_ref(dynamic_vertex_tree(Field<const TV2,VertexId>(vector_view_own<2>(X.flat)),margin));
+  else if (X.n==3) return to_python_ref(dynamic_vertex_tree(Field<const TV3,VertexId>(vector_view_own<3>(X.flat)),margin));
+  throw ValueError(format("TriangleTopology::dynamic_vertex_tree: Expected 2D or 3D vectors, got shape %s",str(X.sizes())));
+}
 #endif
 
 #define SAFE_ERASE(prim,Id) \
@@ -2425,6 +3115,8 @@ void wrap_corner_mesh() {
       .GEODE_INIT(const TriangleSoup&)
       .GEODE_METHOD(copy)
       .GEODE_METHOD(mutate)
+      .GEODE_METHOD(raw_state)
+      .GEODE_METHOD(from_raw_state)
       .GEODE_GET(n_vertices)
       .GEODE_GET(n_boundary_edges)
       .GEODE_GET(n_edges)
@@ -2449,7 +3141,21 @@ void wrap_corner_mesh() {
       .SAFE_METHOD(outgoing)
       .SAFE_METHOD(incoming)
       .SAFE_METHOD(reverse)
+      .GEODE_METHOD(batch_halfedge)
+      .GEODE_METHOD(batch_prev)
+      .GEODE_METHOD(batch_next)
+      .GEODE_METHOD(batch_reverse)
+      .GEODE_METHOD(batch_src)
+      .GEODE_METHOD(batch_dst)
+      .GEODE_METHOD(batch_face)
+      .GEODE_METHOD(batch_face_vertices)
+      .GEODE_METHOD(batch_face_halfedges)
+      .GEODE_METHOD(batch_halfedge_vertices)
+      .GEODE_METHOD(batch_face_faces)
+      .GEODE_METHOD(batch_halfedge_faces)
+      .GEODE_METHOD(batch_halfedge_between)
       .GEODE_METHOD(vertex_one_ring)
+      .GEODE_METHOD(batch_vertex_one_ring)
       .GEODE_METHOD(incident_faces)
       .GEODE_METHOD(face_soup)
       .GEODE_OVERLOADED_METHOD_2(HalfedgeId(Self::*)(VertexId, VertexId)const, "halfedge_between", halfedge)
@@ -2467,6 +3173,9 @@ void wrap_corner_mesh() {
       .GEODE_METHOD(is_manifold_with_boundary)
       .GEODE_METHOD(has_isolated_vertices)
       .GEODE_METHOD(boundary_loops)
+      .GEODE_METHOD(n_boundary_loops)
+      .GEODE_METHOD(boundary_loop)
+      .GEODE_METHOD(boundary_loop_length)
       .GEODE_METHOD(assert_consistent)
       .GEODE_METHOD(dump_internals)
       .GEODE_METHOD(all_vertices)
@@ -2477,6 +3186,7 @@ void wrap_corner_mesh() {
       .GEODE_METHOD(area)
       .GEODE_OVERLOADED_METHOD_2(TV3(Self::*)(RawField<const TV3,VertexId> X, const FaceId f) const, "face_normal", normal)
       .GEODE_OVERLOADED_METHOD_2(TV3(Self::*)(RawField<const TV3,VertexId> X, const  VertexId v) const, "vertex_normal", normal)
+      .GEODE_METHOD(vertex_normals)
       .GEODE_OVERLOADED_METHOD(Range<TriangleTopologyIter<VertexId>>(Self::*)() const, vertices)
       .GEODE_OVERLOADED_METHOD(Range<TriangleTopologyIter<FaceId>>(Self::*)() const, faces)
       .GEODE_OVERLOADED_METHOD(Range<TriangleTopologyIter<HalfedgeId>>(Self::*)() const, halfedges)
@@ -2490,6 +3200,8 @@ void wrap_corner_mesh() {
 #ifdef GEODE_PYTHON
       .GEODE_METHOD_2("edge_tree",edge_tree_py)
       .GEODE_METHOD_2("face_tree",face_tree_py)
+      .GEODE_METHOD_2("dynamic_face_tree",dynamic_face_tree_py)
+      .GEODE_METHOD_2("dynamic_vertex_tree",dynamic_vertex_tree_py)
 #endif
       ;
   }
@@ -2503,6 +3215,7 @@ void wrap_corner_mesh() {
       .GEODE_METHOD(flipped)
       .GEODE_METHOD(add_vertex)
       .GEODE_METHOD(add_vertices)
+      .GEODE_METHOD(reserve)
       .GEODE_METHOD(add_face)
       .GEODE_METHOD(add_faces)
       .SAFE_METHOD(erase_face)
@@ -2515,9 +3228,16 @@ void wrap_corner_mesh() {
       .GEODE_METHOD(collapse)
       .GEODE_OVERLOADED_METHOD_2(VertexId(Self::*)(HalfedgeId),"split_edge",split_edge)
       .GEODE_OVERLOADED_METHOD_2(void(Self::*)(HalfedgeId,VertexId),"split_edge_with_vertex",split_edge)
+      .GEODE_METHOD(split_edges)
       .GEODE_METHOD(erase_isolated_vertices)
       .GEODE_METHOD(collect_garbage)
       .GEODE_METHOD(collect_boundary_garbage)
+      .GEODE_METHOD(collect_garbage_incrementally)
+      .GEODE_METHOD(enable_edge_index)
+      .GEODE_METHOD(enable_normal_tracking)
+      .GEODE_METHOD(snapshot)
+      .GEODE_METHOD(update_vertex_normals)
+      .GEODE_OVERLOADED_METHOD_2(HalfedgeId(Self::*)(VertexId, VertexId)const, "halfedge_between", halfedge)
       #ifdef GEODE_PYTHON
       .GEODE_METHOD_2("add_vertex_field",add_vertex_field_py)
       .GEODE_METHOD_2("add_face_field",add_face_field_py)
@@ -2536,6 +3256,8 @@ void wrap_corner_mesh() {
       .GEODE_METHOD_2("halfedge_field",halfedge_field_py)
       #endif
       .GEODE_METHOD(permute_vertices)
+      .GEODE_METHOD(permute_faces)
+      .GEODE_METHOD(reorder_for_locality)
       ;
   }
   // For testing purposes
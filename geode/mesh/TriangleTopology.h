@@ -18,6 +18,10 @@ namespace geode {
 
 struct TriangleTopologyOutgoing;
 struct TriangleTopologyIncoming;
+struct TriangleTopologyNeighbors;
+struct TriangleTopologyIncidentFaces;
+struct TriangleTopologyComponents;
+struct TriangleTopologyComponentFaces;
 template<class Id> struct TriangleTopologyIter;
 class MutableTriangleTopology;
 
@@ -65,7 +69,6 @@ class MutableTriangleTopology;
 // should go through the high level interface.
 //
 // TODO:
-// - Make add_faces that actually batch inserts.
 // - Make a more efficient version of erased(VertexId) and erase(HalfedgeId)
 // - Check in add_face/add_vertex whether we exceed the data structure limits.
 // - Make a field class for boundary halfedges
@@ -101,11 +104,21 @@ public:
 
 protected:
 
+  // Boundary loops and manifoldness, computed on demand and discarded by anything that creates, erases, links, or
+  // moves boundary halfedges (see invalidate_boundary_index).  Edits away from the boundary keep the index.
+  mutable bool boundary_index_valid;
+  mutable bool manifold_with_boundary_;
+  mutable Nested<const HalfedgeId> boundary_loops_;
+  mutable Array<int> boundary_loop_; // boundary_loop_[-1-e.id] is the loop containing e, or -1 if e is erased
+  GEODE_CORE_EXPORT void update_boundary_index() const;
+  void invalidate_boundary_index() { boundary_index_valid = false; }
+
   // These functions are needed for the constructors, but are protected because we are not publically mutable.
 
   // Link two boundary edges together (without ensuring consistency)
   void unsafe_boundary_link(HalfedgeId p, HalfedgeId n) {
     assert(p.id<0 && n.id<0);
+    invalidate_boundary_index();
     boundaries_.const_cast_()[-1-p.id].next = n;
     boundaries_.const_cast_()[-1-n.id].prev = p;
   }
@@ -159,6 +172,11 @@ protected:
   // Add many new faces (return the first id, new ids are contiguous)
   GEODE_CORE_EXPORT FaceId internal_add_faces(RawArray<const Vector<int,3>> vs);
 
+  // Add faces whose vertices are all isolated, computing connectivity in parallel.  If the faces are
+  // invalid or some vertex has more than one triangle fan, the serial result depends on insertion order, so nothing
+  // is changed and false is returned: the caller should fall back to internal_add_faces.
+  GEODE_CORE_EXPORT bool internal_bulk_add_faces(RawArray<const Vector<int,3>> vs);
+
   // Collect unused boundary halfedges.  Returns old_to_new map.  This can be called after construction
   // from triangle soup, since unordered face addition leaves behind garbage boundary halfedges.
   // The complexity is linear in the size of the boundary (including garbage).
@@ -177,6 +195,15 @@ public:
   GEODE_CORE_EXPORT Ref<TriangleTopology> copy() const;
   GEODE_CORE_EXPORT Ref<MutableTriangleTopology> mutate() const;
 
+  // The flat arrays as ints, sharing memory with the mesh, and (n_vertices,n_faces,n_boundary_edges,erased_boundaries).
+  // This is the pickled form, so that pickling a mesh copies its arrays once instead of rebuilding it from faces.
+  typedef Tuple<Array<const int>,Array<const int>,Array<const int>,Vector<int,4>> RawState;
+  GEODE_CORE_EXPORT RawState raw_state() const;
+
+  // Rebuild a mesh from raw_state.  The arrays are shared, not copied, and the result is checked for consistency.
+  GEODE_CORE_EXPORT static Ref<TriangleTopology> from_raw_state(Array<const int> faces, Array<const int> vertex_to_edge,
+                                                                Array<const int> boundaries, const Vector<int,4> counts);
+
   // Count various features, excluding erased ids.
   int n_vertices()       const { return n_vertices_; }
   int n_faces()          const { return n_faces_; }
@@ -221,7 +248,7 @@ public:
   inline bool isolated   (VertexId v)   const;
   GEODE_CORE_EXPORT bool has_boundary() const; // O(1) time
   GEODE_CORE_EXPORT bool is_manifold() const; // O(1) time
-  GEODE_CORE_EXPORT bool is_manifold_with_boundary() const; // O(boundary) time
+  GEODE_CORE_EXPORT bool is_manifold_with_boundary() const; // O(1) time once the boundary index is built
   GEODE_CORE_EXPORT bool has_isolated_vertices() const; // O(n) time
 
   // Tuples or iterable ranges of neighbors
@@ -232,7 +259,14 @@ public:
   inline Range<TriangleTopologyOutgoing> outgoing(VertexId v) const;
   inline Range<TriangleTopologyIncoming> incoming(VertexId v) const;
   inline Vector<FaceId,2> faces(HalfedgeId e) const; // vec(face(e), face(reverse(e)))
+  inline Range<TriangleTopologyNeighbors> neighbors(VertexId v) const; // dst(e) for e in outgoing(v)
+  inline Range<TriangleTopologyIncidentFaces> faces(VertexId v) const; // Valid faces around v, in outgoing order
 
+  // Edge-connected groups of faces around v, each an iterable range of faces in outgoing order.  An interior vertex
+  // has one component, and a boundary vertex has one per boundary gap.  Nothing is allocated.
+  inline Range<TriangleTopologyComponents> components(VertexId v) const;
+
+  // Allocating versions of neighbors(v) and faces(v), mainly for Python
   Array<VertexId> vertex_one_ring(VertexId v) const;
   Array<FaceId> incident_faces(VertexId v) const;
 
@@ -270,12 +304,16 @@ public:
   // Compute the edge degree of a vertex in O(degree) time.
   GEODE_CORE_EXPORT int degree(VertexId v) const;
 
-  // Compute edge-connected components around a boundary vertex, optionally
-  // ignoring a set of edges (given as halfedges outgoing from v)
+  // Compute edge-connected components around a vertex, as in components(v)
   GEODE_CORE_EXPORT Nested<FaceId> surface_components(VertexId v) const;
 
-  // Compute all boundary loops
-  GEODE_CORE_EXPORT Nested<HalfedgeId> boundary_loops() const;
+  // All boundary loops.  These and the other boundary loop queries take O(1) time, except for the first query after
+  // a boundary edit, which rebuilds the boundary index in O(boundary) time.  Rebuilding is not thread safe, so call
+  // one of them before querying from several threads at once.
+  GEODE_CORE_EXPORT Nested<const HalfedgeId> boundary_loops() const;
+  GEODE_CORE_EXPORT int n_boundary_loops() const;
+  GEODE_CORE_EXPORT int boundary_loop(HalfedgeId e) const; // The index of the loop containing boundary halfedge e
+  GEODE_CORE_EXPORT int boundary_loop_length(int loop) const;
 
   // Compute the Euler characteristic.
   inline int chi() const {
@@ -317,6 +355,24 @@ public:
   Range<TriangleTopologyIncoming> safe_incoming(VertexId v) const;
   HalfedgeId safe_halfedge_between(VertexId v0, VertexId v1) const;
 
+  // Batch versions of the safe functions, which check every id and then evaluate in parallel.  Exposed to python with
+  // a batch_ prefix (batch_face_vertices, etc.), so that loops over many elements don't cross the binding layer per id.
+  GEODE_CORE_EXPORT Array<HalfedgeId> batch_halfedge(RawArray<const VertexId> v) const;
+  GEODE_CORE_EXPORT Array<HalfedgeId> batch_prev    (RawArray<const HalfedgeId> e) const;
+  GEODE_CORE_EXPORT Array<HalfedgeId> batch_next    (RawArray<const HalfedgeId> e) const;
+  GEODE_CORE_EXPORT Array<HalfedgeId> batch_reverse (RawArray<const HalfedgeId> e) const;
+  GEODE_CORE_EXPORT Array<VertexId>   batch_src     (RawArray<const HalfedgeId> e) const;
+  GEODE_CORE_EXPORT Array<VertexId>   batch_dst     (RawArray<const HalfedgeId> e) const;
+  GEODE_CORE_EXPORT Array<FaceId>     batch_face    (RawArray<const HalfedgeId> e) const;
+  GEODE_CORE_EXPORT Array<Vector<VertexId,3>>   batch_face_vertices    (RawArray<const FaceId> f) const;
+  GEODE_CORE_EXPORT Array<Vector<HalfedgeId,3>> batch_face_halfedges   (RawArray<const FaceId> f) const;
+  GEODE_CORE_EXPORT Array<Vector<VertexId,2>>   batch_halfedge_vertices(RawArray<const HalfedgeId> e) const;
+  GEODE_CORE_EXPORT Array<Vector<FaceId,3>>     batch_face_faces       (RawArray<const FaceId> f) const;
+  GEODE_CORE_EXPORT Array<Vector<FaceId,2>>     batch_halfedge_faces   (RawArray<const HalfedgeId> e) const;
+  GEODE_CORE_EXPORT Array<HalfedgeId> batch_halfedge_between(RawArray<const VertexId> v0,
+                                                             RawArray<const VertexId> v1) const;
+  GEODE_CORE_EXPORT Nested<VertexId> batch_vertex_one_ring(RawArray<const VertexId> v) const;
+
   // make fields that fit this mesh
   #define CREATE_FIELD(prim, Id, size_expr) \
     template<class T> Field<T,Id> create_compatible_##prim##_field() const { \
@@ -366,9 +422,17 @@ public:
   GEODE_CORE_EXPORT Tuple<Ref<SimplexTree<TV2,2>>,Array<FaceId>> face_tree(Field<const TV2,VertexId> X, const int leaf_size=1) const;
   GEODE_CORE_EXPORT Tuple<Ref<SimplexTree<TV3,2>>,Array<FaceId>> face_tree(Field<const TV3,VertexId> X, const int leaf_size=1) const;
 
+  // Get dynamic trees keyed by FaceId.idx() or VertexId.idx(), to be kept in sync by the caller as the mesh changes
+  GEODE_CORE_EXPORT Ref<DynamicBoxTree<TV2>> dynamic_face_tree(RawField<const TV2,VertexId> X, const real margin=0) const;
+  GEODE_CORE_EXPORT Ref<DynamicBoxTree<TV3>> dynamic_face_tree(RawField<const TV3,VertexId> X, const real margin=0) const;
+  GEODE_CORE_EXPORT Ref<DynamicBoxTree<TV2>> dynamic_vertex_tree(RawField<const TV2,VertexId> X, const real margin=0) const;
+  GEODE_CORE_EXPORT Ref<DynamicBoxTree<TV3>> dynamic_vertex_tree(RawField<const TV3,VertexId> X, const real margin=0) const;
+
 #ifdef GEODE_PYTHON
   GEODE_CORE_EXPORT Ref<> edge_tree_py(Array<const real,2> X) const;
   GEODE_CORE_EXPORT Ref<> face_tree_py(Array<const real,2> X) const;
+  GEODE_CORE_EXPORT Ref<> dynamic_face_tree_py(Array<const real,2> X, const real margin) const;
+  GEODE_CORE_EXPORT Ref<> dynamic_vertex_tree_py(Array<const real,2> X, const real margin) const;
 #endif
 
   // Dihedral angles across edges.  Positive for convex, negative for concave.
@@ -407,6 +471,35 @@ protected:
                      id_to_halfedge_field;
   int next_field_id;
 
+  // Optional index from oriented vertex pairs to halfedges, used by halfedge(v0,v1) if enabled.  Entries may be
+  // stale, so hits are checked, but every existing halfedge has a correct entry whenever edge_index_valid is true.
+  bool edge_index_enabled;
+  mutable bool edge_index_valid;
+  mutable Hashtable<Vector<VertexId,2>,HalfedgeId> edge_index;
+
+  // Optional record of the vertices whose normals have been changed by edits since the last update_vertex_normals.
+  // If normals_all_stale is set, the record is incomplete and every normal must be recomputed.
+  bool normal_tracking_enabled;
+  bool normals_all_stale;
+  Array<VertexId> stale_normals;
+
+  // Set by snapshot, so that the next edit copies any topology arrays a snapshot still holds
+  mutable bool snapshot_taken;
+  GEODE_CORE_EXPORT void unshare_arrays();
+
+  // Where collect_garbage_incrementally resumes its scan for erased faces and vertices
+  int garbage_face_cursor, garbage_vertex_cursor;
+
+  // Native binary io (write_native_mesh and read_native_mesh in io.h) works directly on the raw arrays
+  friend struct NativeMeshIO;
+
+  // Record the current ids of all halfedges in the faces around v, and of the boundary halfedges touching v
+  void update_edge_index_around(const VertexId v);
+
+  // Record the normal of v, or the normals of v and its neighbors, as stale
+  void touch_normal(const VertexId v);
+  void touch_normals_around(const VertexId v);
+
   GEODE_CORE_EXPORT MutableTriangleTopology();
   GEODE_CORE_EXPORT MutableTriangleTopology(const TriangleTopology& mesh, bool copy = false);
   GEODE_CORE_EXPORT MutableTriangleTopology(const MutableTriangleTopology& mesh, bool copy = false);
@@ -487,6 +580,33 @@ public:
     Ref<> halfedge_field_py(int id);
   #endif
 
+  // Find the halfedge from v0 to v1 in O(1) expected time if the edge index is enabled, or by walking around v0 otherwise.
+  using TriangleTopology::halfedge;
+  GEODE_CORE_EXPORT HalfedgeId halfedge(VertexId v0, VertexId v1) const;
+
+  // Enable or disable a hash index for halfedge(v0,v1), useful when vertices have high valence.  The index is built
+  // on the next lookup.  flip_edge, split_edge, and collapse keep it up to date, and all other high level operations
+  // discard it to be rebuilt when needed.  External surgery through the unsafe_ routines must call
+  // invalidate_edge_index.
+  GEODE_CORE_EXPORT void enable_edge_index(const bool enable=true);
+  void invalidate_edge_index() { edge_index_valid = false; normals_all_stale = true; }
+
+  // Enable or disable incremental vertex normals.  While enabled, add_face(s), erase, split_face, split_edge,
+  // flip_edge, and collapse record the vertices whose normals they change, and all other high level operations (and
+  // invalidate_edge_index) mark every normal stale.
+  GEODE_CORE_EXPORT void enable_normal_tracking(const bool enable=true);
+
+  // Bring normals, the angle-weighted vertex normals of an earlier X, up to date by recomputing only the normals
+  // changed by edits since the last call, plus those around the vertices in moved, whose positions have changed.
+  // Falls back to vertex_normals(X) if tracking is disabled, if every normal is stale, or if normals has the wrong
+  // size.  Returns the updated normals, which share memory with normals unless recomputed from scratch.
+  GEODE_CORE_EXPORT Field<TV3,VertexId> update_vertex_normals(RawField<const TV3,VertexId> X, Field<TV3,VertexId> normals,
+                                                              RawArray<const VertexId> moved=RawArray<const VertexId>());
+
+  // The boundary index (see boundary_loops) is discarded automatically by the unsafe_ routines that touch the
+  // boundary.  Surgery that writes boundary info directly must call this.
+  using TriangleTopology::invalidate_boundary_index;
+
   // set the src entry of an existing boundary halfedge
   inline void unsafe_set_src(HalfedgeId he, VertexId src);
 
@@ -505,6 +625,16 @@ public:
   // return a deep copy as a new TriangleTopology
   Ref<MutableTriangleTopology> copy() const;
 
+  // Return an immutable view of the current topology, safe to query from other threads while this mesh is edited.
+  // The view shares the topology arrays, so a snapshot costs only its boundary index.  The first edit afterwards
+  // copies whichever arrays a live snapshot still holds, once no matter how many snapshots were taken.  Fields are
+  // not part of the view.  Call from the thread that edits the mesh.
+  GEODE_CORE_EXPORT Ref<const TriangleTopology> snapshot() const;
+
+  // Stop sharing topology arrays with snapshots before writing to them.  Every editing routine of this class does
+  // this itself, but surgery through the unsafe_ routines inherited from TriangleTopology must call it first.
+  void unshare() { if (snapshot_taken) unshare_arrays(); }
+
   // these methods take care of your fields for you.
 
   // Add a new isolated vertex and return its id.
@@ -516,11 +646,15 @@ public:
   // Add n isolated vertices and return the first id (new ids are contiguous)
   GEODE_CORE_EXPORT VertexId add_vertices(int n);
 
+  // Preallocate storage, including all fields, for the given total numbers of vertices, faces, and boundary edges
+  GEODE_CORE_EXPORT void reserve(int vertices, int faces, int boundary_edges=0);
+
   // Add a new face.  If the result would not be manifold, no change is made and ValueError is thrown.
   // TODO: throw a better exception.
   GEODE_CORE_EXPORT FaceId add_face(Vector<VertexId,3> v);
 
-  // Add many new faces (return the first id, new ids are contiguous)
+  // Add many new faces (return the first id, new ids are contiguous).  If all vertices of the new faces
+  // are isolated, connectivity is computed in one parallel pass instead of face by face.
   GEODE_CORE_EXPORT FaceId add_faces(RawArray<const Vector<int,3>> vs);
 
   // Flip the two triangles adjacent to a given halfedge.  The routines throw an exception if is_flip_safe fails;
@@ -531,6 +665,15 @@ public:
   // Permute vertices: vertex v becomes vertex permutation[v]
   GEODE_CORE_EXPORT void permute_vertices(RawArray<const int> permutation, bool check=false);
 
+  // Permute faces: face f becomes face permutation[f], and halfedge 3*f+i becomes 3*permutation[f]+i
+  GEODE_CORE_EXPORT void permute_faces(RawArray<const int> permutation, bool check=false);
+
+  // Renumber vertices and faces so that nearby primitives have nearby ids, improving the memory locality of field
+  // access after many local operations.  Garbage is collected first.  Vertices are numbered in breadth first order
+  // over each connected component, and faces in order of their lowest numbered vertex.  All fields are permuted, and
+  // the permutations are returned as for collect_garbage.
+  GEODE_CORE_EXPORT Vector<Array<int>,3> reorder_for_locality();
+
   // Add another TriangleTopology, assuming the vertex sets are disjoint.
   // Returns the offsets of the other vertex, face, and boundary ids in the new arrays.
   GEODE_CORE_EXPORT Vector<int,3> add(const MutableTriangleTopology& other);
@@ -552,6 +695,13 @@ public:
   // still have to be connected to the outside world with unsafe_set_reverse.
   Vector<HalfedgeId,2> unsafe_split_halfedge(HalfedgeId h, FaceId nf, VertexId c);
 
+  // Grow faces and face and halfedge fields by n, leaving the new faces for the caller to fill in
+  void grow_faces(int n);
+
+  // Split the non-boundary halfedge h and its reverse with the isolated vertex c, using the already allocated
+  // faces nf (and nf+1 if reverse(h) is not a boundary halfedge)
+  void unsafe_split_edge(HalfedgeId h, VertexId c, FaceId nf);
+
   // Split a face into three by inserting a new vertex. Two new faces are created.
   // The id of the new vertex is returned. The two new faces (added at the end)
   // have field that are newly initialized; the existing face's area changes
@@ -592,6 +742,10 @@ public:
   // If h is not a boundary halfedge, dst(h) = c afterwards.
   GEODE_CORE_EXPORT void split_edge(HalfedgeId h, VertexId c);
 
+  // Split many distinct edges at once, growing vertices, faces, and fields only once.  Returns the new vertex
+  // inserted into each edge.  Equivalent to calling split_edge(e) on each edge in order.
+  GEODE_CORE_EXPORT Array<VertexId> split_edges(RawArray<const HalfedgeId> edges);
+
   // Check whether an edge collapse is safe
   GEODE_CORE_EXPORT bool is_collapse_safe(HalfedgeId h) const;
 
@@ -633,6 +787,13 @@ public:
   // The complexity is linear in the size of the boundary (including garbage).
   GEODE_CORE_EXPORT Array<int> collect_boundary_garbage();
 
+  // Amortized version of collect_garbage for interactive use: examine at most work face slots and work vertex slots,
+  // resuming where the previous call left off, and fill each erased slot found by moving the last live face or vertex
+  // into it.  Erased slots at the end are dropped.  Fields move with their primitives.  Returns the (old,new) id pairs
+  // of moved vertices and faces.  Calling this after each small edit keeps storage dense without a full O(n) pass.
+  // Boundary halfedges need no compaction since they are already reused via a free list.
+  GEODE_CORE_EXPORT Vector<Array<Vector<int,2>>,2> collect_garbage_incrementally(const int work);
+
   // The remaining functions are mainly for internal use, or for external routines that perform direct surgery
   // on the internal structure.  Use with caution!
 
@@ -718,11 +879,14 @@ inline HalfedgeId TriangleTopology::reverse(HalfedgeId e) const {
 
 inline void MutableTriangleTopology::unsafe_set_src(HalfedgeId he, VertexId src) {
   assert(valid(he) && is_boundary(he));
+  unshare();
+  invalidate_boundary_index();
   mutable_boundaries_[-1-he.id].src = src;
 }
 
 inline void MutableTriangleTopology::unsafe_set_halfedge(VertexId v, HalfedgeId he) {
   assert(valid(v));
+  unshare();
   mutable_vertex_to_edge_[v] = he;
 }
 
@@ -798,6 +962,7 @@ inline void TriangleTopology::unsafe_set_erased(FaceId f) {
 }
 inline void TriangleTopology::unsafe_set_erased(HalfedgeId b) {
   assert(b.id < 0); // make sure this is a boundary edge
+  invalidate_boundary_index();
   boundaries_.const_cast_()[-1-b.id].src.id = erased_id;
   boundaries_.const_cast_()[-1-b.id].next = erased_boundaries_;
   const_cast_(erased_boundaries_) = b;
@@ -830,6 +995,65 @@ struct TriangleTopologyIncoming {
   HalfedgeId operator*() const { return mesh.reverse(e); }
 };
 
+// Use only through TriangleTopology::neighbors()
+struct TriangleTopologyNeighbors {
+  const TriangleTopology& mesh;
+  HalfedgeId e;
+  bool first;
+  TriangleTopologyNeighbors(const TriangleTopology& mesh, HalfedgeId e, bool first) : mesh(mesh), e(e), first(first) {}
+  void operator++() { e = mesh.left(e); first = false; }
+  bool operator!=(TriangleTopologyNeighbors o) const { return first || e!=o.e; } // For use only inside range-based for loops
+  VertexId operator*() const { return mesh.dst(e); }
+};
+
+// Use only through TriangleTopology::faces(VertexId).  Boundary halfedges are never adjacent around a vertex, so
+// one step past each suffices, and e always starts and stays on an interior halfedge.
+struct TriangleTopologyIncidentFaces {
+  const TriangleTopology& mesh;
+  HalfedgeId e;
+  bool first;
+  TriangleTopologyIncidentFaces(const TriangleTopology& mesh, HalfedgeId e, bool first) : mesh(mesh), e(e), first(first) {}
+  void operator++() {
+    e = mesh.left(e);
+    if (mesh.is_boundary(e))
+      e = mesh.left(e);
+    first = false;
+  }
+  bool operator!=(TriangleTopologyIncidentFaces o) const { return first || e!=o.e; } // For use only inside range-based for loops
+  FaceId operator*() const { return mesh.face(e); }
+};
+
+// Use only through TriangleTopology::components().  Faces run from an interior halfedge until the next boundary
+// halfedge, or all the way around.  Reaching a boundary jumps back to the start to end the loop.
+struct TriangleTopologyComponentFaces {
+  const TriangleTopology& mesh;
+  HalfedgeId e, start;
+  bool first;
+  TriangleTopologyComponentFaces(const TriangleTopology& mesh, HalfedgeId e, bool first)
+    : mesh(mesh), e(e), start(e), first(first) {}
+  void operator++() {
+    e = mesh.left(e);
+    if (mesh.is_boundary(e))
+      e = start;
+    first = false;
+  }
+  bool operator!=(TriangleTopologyComponentFaces o) const { return first || e!=o.e; } // For use only inside range-based for loops
+  FaceId operator*() const { return mesh.face(e); }
+};
+
+// Use only through TriangleTopology::components().  e is halfedge(v) or a boundary halfedge, and each component
+// starts just after it.  halfedge(v) is boundary for boundary vertices, so advancing stops at the next boundary
+// halfedge, or back at halfedge(v) for interior vertices.
+struct TriangleTopologyComponents {
+  const TriangleTopology& mesh;
+  HalfedgeId e;
+  bool first;
+  TriangleTopologyComponents(const TriangleTopology& mesh, HalfedgeId e, bool first) : mesh(mesh), e(e), first(first) {}
+  inline void operator++();
+  bool operator!=(TriangleTopologyComponents o) const { return first || e!=o.e; } // For use only inside range-based for loops
+  inline Range<TriangleTopologyComponentFaces> operator*() const;
+};
+
 // Tuples or iterable ranges of neighbors
 inline Vector<HalfedgeId,3> TriangleTopology::halfedges(FaceId f) const {
   return vec(HalfedgeId(3*f.id+0),
@@ -868,6 +1092,39 @@ inline Range<TriangleTopologyIncoming> TriangleTopology::incoming(VertexId v) co
   return Range<TriangleTopologyIncoming>(c,c);
 }
 
+inline Range<TriangleTopologyNeighbors> TriangleTopology::neighbors(VertexId v) const {
+  const auto e = halfedge(v);
+  const TriangleTopologyNeighbors c(*this,e,e.valid());
+  return Range<TriangleTopologyNeighbors>(c,c);
+}
+
+inline Range<TriangleTopologyIncidentFaces> TriangleTopology::faces(VertexId v) const {
+  auto e = halfedge(v);
+  if (e.valid() && is_boundary(e))
+    e = left(e);
+  const TriangleTopologyIncidentFaces c(*this,e,e.valid());
+  return Range<TriangleTopologyIncidentFaces>(c,c);
+}
+
+inline Range<TriangleTopologyComponents> TriangleTopology::components(VertexId v) const {
+  const auto e = halfedge(v);
+  const TriangleTopologyComponents c(*this,e,e.valid());
+  return Range<TriangleTopologyComponents>(c,c);
+}
+
+inline void TriangleTopologyComponents::operator++() {
+  const auto stop = mesh.halfedge(mesh.src(e));
+  do
+    e = mesh.left(e);
+  while (!mesh.is_boundary(e) && e!=stop);
+  first = false;
+}
+
+inline Range<TriangleTopologyComponentFaces> TriangleTopologyComponents::operator*() const {
+  const TriangleTopologyComponentFaces c(mesh,mesh.is_boundary(e) ? mesh.left(e) : e,true);
+  return Range<TriangleTopologyComponentFaces>(c,c);
+}
+
 // Use only throw vertices(), faces(), or boundary_edges()
 template<class Id> struct TriangleTopologyIter {
   const TriangleTopology& mesh;
@@ -4,6 +4,7 @@ from numpy import *
 from geode import *
 import struct
 import platform
+import copy_reg
 
 # this is getting seriously ugly, but we do need to be able to test isinstance on
 # these somehow.
@@ -19,6 +20,17 @@ def TriangleTopology(soup=TriangleSoup(empty((0,3),int32))):
     soup = TriangleSoup(soup)
   return geode_wrap.TriangleTopology(soup)
 
+# Pickle meshes as their flat arrays, which numpy pickles as raw bytes, so that sending a mesh to another
+# process copies its memory instead of rebuilding the topology from faces.
+def _unpickle_triangle_soup(elements,nodes):
+  return geode_wrap.triangle_soup_with_nodes(elements,nodes)
+
+def _unpickle_triangle_topology(faces,vertex_to_edge,boundaries,counts):
+  return CTriangleTopology.from_raw_state(faces,vertex_to_edge,boundaries,counts)
+
+copy_reg.pickle(TriangleSoup,lambda soup: (_unpickle_triangle_soup,(soup.elements,soup.nodes())))
+copy_reg.pickle(CTriangleTopology,lambda mesh: (_unpickle_triangle_topology,mesh.raw_state()))
+
 def linear_subdivide(mesh,X,steps=1):
   for _ in xrange(steps):
     subdivide = TriangleSubdivision(mesh)
@@ -0,0 +1,68 @@
+#include <geode/mesh/components.h>
+#include <geode/structure/UnionFind.h>
+#include <geode/utility/openmp.h>
+namespace geode {
+
+// Group elements by the union-find roots of their nodes.  Negative roots mark skipped elements.
+template<class E> static Nested<E> group(RawArray<const int> roots, const int nodes) {
+  // Number components in order of their first element
+  Array<int> component(nodes,uninit);
+  component.fill(-1);
+  Array<int> counts;
+  for (const int r : roots)
+    if (r >= 0) {
+      if (component[r] < 0)
+        component[r] = counts.append(0);
+      counts[component[r]]++;
+    }
+
+  // Scatter elements, which stay in order within each component
+  Nested<E> result(counts,uninit);
+  auto next = result.offsets.slice(0,counts.size()).copy();
+  for (const int e : range(roots.size()))
+    if (roots[e] >= 0)
+      result.flat[next[component[roots[e]]]++] = E(e);
+  return result;
+}
+
+NestedField<FaceId,ComponentId> face_components(const TriangleTopology& mesh) {
+  const int nf = mesh.allocated_faces();
+  ConcurrentUnionFind union_find(nf);
+  #pragma omp parallel for schedule(dynamic,1024)
+  for (int i=0;i<nf;i++) {
+    const FaceId f(i);
+    if (!mesh.erased(f))
+      for (const auto g : mesh.faces(f))
+        if (g.valid() && g<f)
+          union_find.merge(f.idx(),g.idx());
+  }
+  Array<int> roots(nf,uninit);
+  #pragma omp parallel for
+  for (int i=0;i<nf;i++)
+    roots[i] = mesh.erased(FaceId(i)) ? -1 : union_find.find(i);
+  return NestedField<FaceId,ComponentId>(group<FaceId>(roots,nf));
+}
+
+template<int d> static Nested<int> element_components(RawArray<const Vector<int,d>> elements, const int nodes) {
+  const int n = elements.size();
+  ConcurrentUnionFind union_find(nodes);
+  #pragma omp parallel for schedule(dynamic,1024)
+  for (int e=0;e<n;e++)
+    for (int i=1;i<d;i++)
+      union_find.merge(elements[e][0],elements[e][i]);
+  Array<int> roots(n,uninit);
+  #pragma omp parallel for
+  for (int e=0;e<n;e++)
+    roots[e] = union_find.find(elements[e][0]);
+  return group<int>(roots,nodes);
+}
+
+Nested<int> element_components(const TriangleSoup& soup) {
+  return element_components<3>(soup.elements,soup.nodes());
+}
+
+Nested<int> element_components(const SegmentSoup& soup) {
+  return element_components<2>(soup.elements,soup.nodes());
+}
+
+}
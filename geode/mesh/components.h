@@ -0,0 +1,19 @@
+// Parallel connected component labeling
+#pragma once
+
+#include <geode/mesh/TriangleTopology.h>
+#include <geode/mesh/SegmentSoup.h>
+#include <geode/array/NestedField.h>
+namespace geode {
+
+// Each function merges neighboring elements with a concurrent union-find in parallel, then groups elements by
+// component.  Components are numbered in order of their first element, and elements within a component are sorted.
+
+// Faces connected through shared edges.  Erased faces are skipped.
+GEODE_CORE_EXPORT NestedField<FaceId,ComponentId> face_components(const TriangleTopology& mesh);
+
+// Triangles or segments connected through shared vertices
+GEODE_CORE_EXPORT Nested<int> element_components(const TriangleSoup& soup);
+GEODE_CORE_EXPORT Nested<int> element_components(const SegmentSoup& soup);
+
+}
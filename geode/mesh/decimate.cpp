@@ -1,9 +1,12 @@
 // Quadric-based mesh decimation
 
 #include <geode/mesh/decimate.h>
+#include <geode/array/view.h>
+#include <geode/math/clamp.h>
 #include <geode/mesh/simplify.h>
 #include <geode/mesh/mesh_debug.h>
 #include <geode/mesh/quadric.h>
+#include <geode/python/Class.h>
 #include <geode/python/wrap.h>
 #include <geode/structure/Heap.h>
 
@@ -49,10 +52,9 @@ struct CollapsePriority {
   }
 };
 
-// Binary heap of potential collapses
-struct VertexHeap : public HeapBase<VertexHeap>, public Noncopyable {
-  typedef HeapBase<VertexHeap> Base;
-  Array<Tuple<VertexId,CollapsePriority,VertexId>> heap; // src,badness,dst
+// Indexed heap of potential collapses, keyed by source vertex
+typedef Tuple<VertexId,CollapsePriority,VertexId> VertexHeapEntry; // src,badness,dst
+struct VertexHeap : public IndexedHeap<VertexHeap,VertexHeapEntry>, public Noncopyable {
   Field<int,VertexId> inv_heap;
 
   VertexHeap(const int nv)
@@ -60,63 +62,48 @@ struct VertexHeap : public HeapBase<VertexHeap>, public Noncopyable {
     inv_heap.flat.fill(-1);
   }
 
-  int size() const {
-    return heap.size();
-  }
-
-  bool first(const int i, const int j) const {
+  bool first(const VertexHeapEntry& a, const VertexHeapEntry& b) const {
     // Sort by quality, but catch ties to ensure we don't get duplicates
-    return heap[i].y < heap[j].y || ((heap[i].y == heap[j].y) && (heap[i].x < heap[j].x));
+    return a.y < b.y || ((a.y == b.y) && (a.x < b.x));
   }
 
-  void swap(const int i, const int j) {
-    std::swap(heap[i],heap[j]);
-    inv_heap[heap[i].x] = i;
-    inv_heap[heap[j].x] = j;
-  }
+  VertexId key(const VertexHeapEntry& e) const { return e.x; }
 
-  Vector<VertexId,2> pop() {
-    const auto e = heap[0];
-    inv_heap[e.x] = -1;
-    const auto p = heap.pop();
-    if (size()) {
-      heap[0] = p;
-      inv_heap[heap[0].x] = 0;
-      Base::move_downward(0);
-    }
-    return vec(e.x,e.z);
+  int position(const VertexId v) const {
+    return inv_heap.valid(v) ? inv_heap[v] : -1; // Values outside the map were never set
   }
 
-  void set(const VertexId v, const CollapsePriority q, const VertexId dst) {
-    const auto entry = tuple(v,q,dst);
-    // Grow heap as needed if id is out of range
-    if(v.id >= inv_heap.size()) {
+  void set_position(const VertexId v, const int i) {
+    // Grow map as needed if id is out of range
+    if (v.id >= inv_heap.size()) {
       const int old_size = inv_heap.size();
       const int new_size = v.idx() + 1;
       inv_heap.flat.resize(new_size);
       inv_heap.flat.slice(old_size, new_size).fill(-1);
     }
-    int& i = inv_heap[v];
-    if (i < 0)
-      i = heap.append(entry);
-    else
-      heap[i] = entry;
-    Base::move_up_or_down(i);
+    inv_heap[v] = i;
   }
+};
 
-  void erase(const VertexId v) {
-    if(v.id >= inv_heap.size())
-      return; // Value was never set so we can ignore it
-    int& i = inv_heap[v];
-    if (i >= 0) {
-      const auto p = heap.pop();
-      if (i < size()) {
-        heap[i] = p;
-        inv_heap[p.x] = i;
-        Base::move_up_or_down(i);
-      }
-      i = -1;
-    }
+// Everything needed to undo each halfedge collapse of vs into vd, in order
+struct CollapseLog {
+  Array<Vector<VertexId,2>> collapses; // (vs,vd)
+  Nested<Tuple<FaceId,Vector<VertexId,3>>,false> erased; // Faces erased by each collapse, with their vertices
+  Nested<Vector<int,2>,false> corners; // (face,slot) corners moved from vs to vd by each collapse
+
+  // Call just before collapsing e
+  void record(const MutableTriangleTopology& mesh, const HalfedgeId e) {
+    const auto vs = mesh.src(e);
+    const auto gone = mesh.faces(e);
+    collapses.append(vec(vs,mesh.dst(e)));
+    erased.append_empty();
+    for (const auto f : gone)
+      if (f.valid())
+        erased.append_to_back(tuple(f,mesh.vertices(f)));
+    corners.append_empty();
+    for (const auto f : mesh.faces(vs))
+      if (f!=gone.x && f!=gone.y)
+        corners.append_to_back(vec(f.id,mesh.vertices(f).find(vs)));
   }
 };
 } // anonymous namespace
@@ -177,13 +164,26 @@ static CollapseRank collapse_rank(const MutableTriangleTopology& mesh, const Hal
 }
 
 template<ReduceMode reduce_mode, class TField> static void mesh_reduce_helper(MutableTriangleTopology& mesh, const TField& X,
-                      const T distance, const T max_angle, const int min_vertices, const T boundary_distance) {
+                      const T distance, const T max_angle, const int min_vertices, const T boundary_distance,
+                      const bool parallel=false, CollapseLog* log=0) {
   if (mesh.n_vertices() <= min_vertices)
     return;
+  GEODE_ASSERT(!parallel || !splitting_enabled(reduce_mode)); // Splits allocate vertices, so only plain decimation runs in rounds
 
   if(splitting_enabled(reduce_mode)) {
     mesh.erase_isolated_vertices();
   }
+  // Share quadrics with other passes.  Callers in splitting mode attach these before taking a reference to X.
+  const Field<Quadric,VertexId>& quadrics = mesh.field(vertex_quadrics(mesh,X));
+  const auto refresh_quadric = [&](const VertexId v) {
+    quadrics[v] = compute_quadric(mesh,X,v);
+  };
+  // After a collapse into v, the one-rings of v and its neighbors have changed
+  const auto refresh_quadrics_around = [&](const VertexId v) {
+    refresh_quadric(v);
+    for (const auto e : mesh.outgoing(v))
+      refresh_quadric(mesh.dst(e));
+  };
   // If splitting is enabled, make sure X is managed by the mesh and will be updated accordingly
   assert(!splitting_enabled(reduce_mode) || mesh_owns_field(mesh, X));
 
@@ -244,11 +244,11 @@ template<ReduceMode reduce_mode, class TField> static void mesh_reduce_helper(Mu
 
   // Finds the best edge to collapse v along.  Returns (q(e),dst(e)).
   // Best edge to collapse doesn't require splitting any vertices if possible and has smallest error cost for quadric
-  const auto best_collapse = [&mesh,&X,&collapse_changes_normal_too_much,area,boundary_distance](const VertexId v) {
+  const auto best_collapse = [&mesh,&X,&quadrics,&collapse_changes_normal_too_much,area,boundary_distance](const VertexId v) {
     if(mesh.isolated(v)) {
       return tuple(CollapsePriority{},VertexId{});
     }
-    Quadric q = compute_quadric(mesh,X,v);
+    const Quadric& q = quadrics[v];
     // Find the best edge, including normal constraints
     T min_q = inf;
     // If splitting isn't enabled, initialize min_rank to simple so that we discard any collapses that would require a split
@@ -273,6 +273,9 @@ template<ReduceMode reduce_mode, class TField> static void mesh_reduce_helper(Mu
       if(is_boundary && (   line_point_distance(boundary_edges[0],xd) > boundary_distance
                          || line_point_distance(boundary_edges[1],xd) > boundary_distance))
         continue;
+      // A frozen boundary doesn't absorb interior vertices either, so no edges between boundary vertices appear
+      if(boundary_distance < 0 && mesh.is_boundary(mesh.dst(e)))
+        continue;
       const auto new_rank = collapse_rank(mesh, e, is_boundary);
       if(new_rank < min_rank || (new_rank == min_rank && qx < min_q)) {
         min_q = qx;
@@ -284,6 +287,82 @@ template<ReduceMode reduce_mode, class TField> static void mesh_reduce_helper(Mu
                  mesh.valid(min_e) ? mesh.dst(min_e) : VertexId{}); // Catch isolated vertices and ones we can't collapse
   };
 
+  if (parallel) {
+    // Work in rounds: evaluate the best collapse of every dirty vertex in parallel, then greedily take collapses in
+    // order of cost whose one-rings don't overlap any collapse already taken this round.  Independent collapses can't
+    // change each other's costs, so each round does the work of many heap pops.  Evaluation is the expensive part;
+    // the collapses themselves are cheap and update shared counters, so they are applied serially.
+    const int nv = mesh.allocated_vertices();
+    Field<Tuple<CollapsePriority,VertexId>,VertexId> best(nv,uninit);
+    Field<bool,VertexId> dirty(nv);
+    Field<int,VertexId> locked(nv);
+    Array<VertexId> todo;
+    for (const auto v : mesh.vertices()) {
+      dirty[v] = true;
+      todo.append(v);
+    }
+    Array<VertexId> candidates;
+    for (int round=1;todo.size();round++) {
+      // Quadrics of dirty vertices are refreshed here rather than after each collapse, except on the first round
+      #pragma omp parallel for
+      for (int i=0;i<todo.size();i++) {
+        if (round>1)
+          refresh_quadric(todo[i]);
+        best[todo[i]] = best_collapse(todo[i]);
+      }
+      for (const auto v : todo)
+        dirty[v] = false;
+      todo.clear();
+
+      // Order candidates by cost, breaking ties by id for determinism
+      candidates.clear();
+      for (const auto v : mesh.vertices())
+        if (best[v].y.valid())
+          candidates.append(v);
+      std::sort(candidates.begin(),candidates.end(),[&best](const VertexId a, const VertexId b) {
+        return best[a].x.cost<best[b].x.cost || (best[a].x.cost==best[b].x.cost && a<b); });
+
+      const auto mark_dirty = [&](const VertexId v) {
+        if (!dirty[v]) {
+          dirty[v] = true;
+          todo.append(v);
+        }
+      };
+      for (const auto vs : candidates) {
+        const auto vd = best[vs].y;
+        if (locked[vs]==round || locked[vd]==round)
+          continue;
+        // Costs only see one-rings, but safety depends on the one-rings of neighbors, so recheck it here
+        const auto e = mesh.halfedge(vs,vd);
+        assert(e.valid());
+        if (!mesh.is_collapse_safe(e)) {
+          mark_dirty(vs);
+          continue;
+        }
+        for (const auto v : vec(vs,vd)) {
+          locked[v] = round;
+          for (const auto ee : mesh.outgoing(v))
+            locked[mesh.dst(ee)] = round;
+        }
+        if (log)
+          log->record(mesh,e);
+        mesh.unsafe_collapse(e);
+        best[vs].y = VertexId();
+        mark_dirty(vd);
+        for (const auto ee : mesh.outgoing(vd))
+          mark_dirty(mesh.dst(ee));
+        if (mesh.n_vertices() <= min_vertices) {
+          // Leave the shared quadrics current
+          #pragma omp parallel for
+          for (int i=0;i<todo.size();i++)
+            refresh_quadric(todo[i]);
+          return;
+        }
+      }
+    }
+    return;
+  }
+
   // TODO: Best collapse from a given vertex depends on every neighbor of every neighbor
   //   It might be faster to maintain a heap of halfedges only tracking error from quadrics so that normals and boundary distances don't get evaluated as often
   //   Need to be careful that an invalid collapse with a lower error doesn't hide another valid collapse
@@ -293,7 +372,7 @@ template<ReduceMode reduce_mode, class TField> static void mesh_reduce_helper(Mu
   for (const auto v : mesh.vertices()) {
     const auto qe = best_collapse(v);
     if (qe.y.valid())
-      heap.inv_heap[v] = heap.heap.append(tuple(v,qe.x,qe.y));
+      heap.set_position(v,heap.heap.append(tuple(v,qe.x,qe.y)));
   }
   heap.make();
 
@@ -301,7 +380,7 @@ template<ReduceMode reduce_mode, class TField> static void mesh_reduce_helper(Mu
   const auto update = [&heap,best_collapse](const VertexId v) {
     const auto qe = best_collapse(v);
     if (qe.y.valid())
-      heap.set(v,qe.x,qe.y);
+      heap.set(tuple(v,qe.x,qe.y));
     else
       heap.erase(v);
   };
@@ -313,7 +392,7 @@ template<ReduceMode reduce_mode, class TField> static void mesh_reduce_helper(Mu
     const CollapseRank rank = heap.heap[0].y.rank;
     const auto v = heap.pop();
     const auto vs = v.x;
-    const auto vd = v.y;
+    const auto vd = v.z;
     assert(mesh.valid(vs) && mesh.valid(vd)); // Heap should be kept up to date as we erase vertices
     const auto e = mesh.halfedge(vs, vd);
     assert(e.valid()); // Halfedge should still exist
@@ -322,7 +401,10 @@ template<ReduceMode reduce_mode, class TField> static void mesh_reduce_helper(Mu
     assert(rank == CollapseRank::simple || splitting_enabled(reduce_mode)); // Make sure splitting is allowed
     if(rank == CollapseRank::simple) {
       assert(mesh.is_collapse_safe(e));
+      if (log)
+        log->record(mesh,e);
       mesh.unsafe_collapse(e);
+      refresh_quadrics_around(vd);
       if (mesh.n_vertices() <= min_vertices)
         break;
       // Don't need to update vs since it should have just been popped from heap
@@ -336,6 +418,9 @@ template<ReduceMode reduce_mode, class TField> static void mesh_reduce_helper(Mu
       assert(mesh.opposite(e) == mesh.opposite(mesh.reverse(e)));
       const VertexId vo = mesh.opposite(e);
       mesh.collapse_degenerate_face_pair(e);
+      for(const VertexId v : {vo, vs, vd})
+        if(!mesh.erased(v))
+          refresh_quadric(v);
       if (mesh.n_vertices() <= min_vertices)
         break;
       for(const VertexId v : {vo, vs, vd}) {
@@ -359,6 +444,7 @@ template<ReduceMode reduce_mode, class TField> static void mesh_reduce_helper(Mu
       const auto new_faces = mesh.split_loop(loop.x, loop.y, loop.z);
       for(const FaceId f : new_faces) {
         for(const VertexId v : mesh.vertices(f)) {
+          refresh_quadric(v);
           dirty.append_unique(v);
           for(const HalfedgeId e : mesh.outgoing(v)) {
             dirty.append_unique(mesh.dst(e));
@@ -397,12 +483,122 @@ void decimate_inplace(MutableTriangleTopology& mesh,
   mesh_reduce_helper<ReduceMode::decimate_only>(mesh, X, distance, max_angle, min_vertices, boundary_distance);
 }
 
+void decimate_inplace_parallel(MutableTriangleTopology& mesh,
+                 RawField<const Vector<real,3>,VertexId> X,
+                 const real distance,
+                 const real max_angle,
+                 const int min_vertices,
+                 const real boundary_distance) {
+  mesh_reduce_helper<ReduceMode::decimate_only>(mesh, X, distance, max_angle, min_vertices, boundary_distance, true);
+}
+
+GEODE_DEFINE_TYPE(ProgressiveMesh)
+
+ProgressiveMesh::ProgressiveMesh(Array<const int> vertex_ids, Array<const TV> X, Array<const Vector<int,3>> base_faces,
+                                 Array<const int> parents, Nested<const Vector<int,3>> split_faces,
+                                 Nested<const int> split_corners)
+  : vertex_ids(vertex_ids)
+  , X(X)
+  , base_faces(base_faces)
+  , parents(parents)
+  , split_faces(split_faces)
+  , split_corners(split_corners) {
+  GEODE_ASSERT(X.size()==vertex_ids.size() && X.size()>=parents.size());
+  GEODE_ASSERT(split_faces.size()==parents.size() && split_corners.size()==parents.size());
+}
+
+ProgressiveMesh::~ProgressiveMesh() {}
+
+void ProgressiveMesh::refine(Array<Vector<int,3>>& faces, const int start, const int end) const {
+  GEODE_ASSERT(0<=start && start<=end && end<=splits());
+  GEODE_ASSERT(faces.size()==this->faces(start));
+  // Faces added by a split only see later splits, and corners only refer to earlier faces, so add all faces first
+  faces.extend(split_faces.flat.slice(split_faces.offsets[start],split_faces.offsets[end]));
+  const auto corners = scalar_view(faces);
+  for (int i=start;i<end;i++)
+    for (const int c : split_corners[i])
+      corners[c] = base_vertices()+i;
+}
+
+Array<Vector<int,3>> ProgressiveMesh::lod_faces(const int splits) const {
+  GEODE_ASSERT(0<=splits && splits<=this->splits());
+  Array<Vector<int,3>> faces;
+  faces.preallocate(this->faces(splits));
+  faces.extend(base_faces);
+  refine(faces,0,splits);
+  return faces;
+}
+
+Array<Vector<int,3>> ProgressiveMesh::lod_faces_with_vertices(const int vertices) const {
+  return lod_faces(clamp(vertices-base_vertices(),0,splits()));
+}
+
+Ref<const ProgressiveMesh> progressive_decimate(const TriangleTopology& mesh, RawField<const TV,VertexId> X,
+                                                const T distance, const T max_angle, const int min_vertices,
+                                                const T boundary_distance) {
+  GEODE_ASSERT(X.size()==mesh.allocated_vertices());
+  const auto rmesh = mesh.mutate();
+  CollapseLog log;
+  mesh_reduce_helper<ReduceMode::decimate_only>(rmesh,X,distance,max_angle,min_vertices,boundary_distance,false,&log);
+  const int n = log.collapses.size();
+
+  // The decimated vertices come first, followed by collapsed vertices in reverse order of collapse
+  Field<int,VertexId> vmap(rmesh->allocated_vertices(),uninit);
+  vmap.flat.fill(-1);
+  Array<int> vertex_ids;
+  const auto add_vertex = [&](const VertexId v) {
+    vmap[v] = vertex_ids.size();
+    vertex_ids.append(v.id);
+  };
+  for (const auto v : rmesh->vertices())
+    add_vertex(v);
+  Array<int> parents(n,uninit);
+  for (int i=0;i<n;i++) {
+    const auto c = log.collapses[n-1-i];
+    add_vertex(c.x);
+    parents[i] = vmap[c.y];
+  }
+
+  // Likewise faces: each split adds the faces its collapse erased, and moves the corners its collapse moved
+  Field<int,FaceId> fmap(rmesh->allocated_faces(),uninit);
+  fmap.flat.fill(-1);
+  int next_face = 0;
+  const auto map_face = [&](const Vector<VertexId,3> v) {
+    return vec(vmap[v.x],vmap[v.y],vmap[v.z]);
+  };
+  Array<Vector<int,3>> base_faces;
+  for (const auto f : rmesh->faces()) {
+    fmap[f] = next_face++;
+    base_faces.append(map_face(rmesh->vertices(f)));
+  }
+  Nested<Vector<int,3>,false> split_faces;
+  Nested<int,false> split_corners;
+  for (int i=0;i<n;i++) {
+    const int k = n-1-i;
+    split_faces.append_empty();
+    for (const auto& f : log.erased[k]) {
+      fmap[f.x] = next_face++;
+      split_faces.append_to_back(map_face(f.y));
+    }
+    split_corners.append_empty();
+    for (const auto& c : log.corners[k]) {
+      assert(fmap[FaceId(c.x)]>=0);
+      split_corners.append_to_back(3*fmap[FaceId(c.x)]+c.y);
+    }
+  }
+  Array<TV> PX(vertex_ids.size(),uninit);
+  for (const int i : range(vertex_ids.size()))
+    PX[i] = X[VertexId(vertex_ids[i])];
+  return new_<ProgressiveMesh>(vertex_ids,PX,base_faces,parents,split_faces.freeze(),split_corners.freeze());
+}
+
 void simplify_inplace_deprecated(MutableTriangleTopology& mesh,
                  const FieldId<Vector<real,3>,VertexId> X_id,
                  const real distance,
                  const real max_angle,
                  const int min_vertices,
                  const real boundary_distance) {
+  vertex_quadrics(mesh, mesh.field(X_id)); // Attach before referencing X, since adding a field moves the others
   mesh_reduce_helper<ReduceMode::simplify_topology>(mesh, mesh.field(X_id), distance, max_angle, min_vertices, boundary_distance);
 }
 
@@ -414,7 +610,7 @@ void simplify_inplace_deprecated_python(MutableTriangleTopology& mesh,
                  const real boundary_distance) {
   GEODE_ASSERT(X_id.prim == PyFieldId::Vertex);
   GEODE_ASSERT(X_id.type && (*X_id.type == typeid(Vector<real,3>)));
-  mesh_reduce_helper<ReduceMode::simplify_topology>(mesh, mesh.field(FieldId<Vector<real,3>,VertexId>{X_id.id}), distance, max_angle, min_vertices, boundary_distance);
+  simplify_inplace_deprecated(mesh, FieldId<Vector<real,3>,VertexId>{X_id.id}, distance, max_angle, min_vertices, boundary_distance);
 }
 
 void simplify_inplace_python(MutableTriangleTopology& mesh,
@@ -506,11 +702,29 @@ void test_simplify_helper() {
 using namespace geode;
 
 void wrap_decimate() {
-  GEODE_FUNCTION(decimate)
-  GEODE_FUNCTION(decimate_inplace)
+  GEODE_FUNCTION_WITHOUT_GIL(decimate)
+  GEODE_FUNCTION_WITHOUT_GIL(decimate_inplace)
+  GEODE_FUNCTION_WITHOUT_GIL(decimate_inplace_parallel)
+  GEODE_FUNCTION_WITHOUT_GIL(progressive_decimate)
   GEODE_FUNCTION(simplify)
   GEODE_FUNCTION_2(simplify_inplace, simplify_inplace_python)
   GEODE_FUNCTION_2(simplify_inplace_deprecated, simplify_inplace_deprecated_python)
   GEODE_FUNCTION(test_simplify_helper)
 
+  typedef ProgressiveMesh Self;
+  Class<Self>("ProgressiveMesh")
+    .GEODE_FIELD(vertex_ids)
+    .GEODE_FIELD(X)
+    .GEODE_FIELD(base_faces)
+    .GEODE_FIELD(parents)
+    .GEODE_FIELD(split_faces)
+    .GEODE_FIELD(split_corners)
+    .GEODE_METHOD(splits)
+    .GEODE_METHOD(base_vertices)
+    .GEODE_METHOD(vertices)
+    .GEODE_METHOD(faces)
+    .GEODE_METHOD(lod_faces)
+    .GEODE_METHOD(lod_faces_with_vertices)
+    ;
+
 }
@@ -2,8 +2,12 @@
 #pragma once
 
 #include <geode/mesh/TriangleTopology.h>
+#include <geode/array/Nested.h>
 namespace geode {
 
+// A negative boundary_distance freezes the boundary: boundary vertices neither move nor absorb interior vertices, so
+// the boundary curves and the edges between boundary vertices are exactly preserved.
+
 GEODE_CORE_EXPORT Tuple<Ref<const TriangleTopology>,Field<const Vector<real,3>,VertexId>>
 decimate(const TriangleTopology& mesh,
          RawField<const Vector<real,3>,VertexId> X,
@@ -20,6 +24,65 @@ decimate_inplace(MutableTriangleTopology& mesh,
                  const int min_vertices=-1,       // Stop if we decimate down to this many vertices (-1 for no limit)
                  const real boundary_distance=0); // How far we're allowed to move the boundary
 
+// As decimate_inplace, but collapses independent sets of edges in rounds, evaluating collapse costs in parallel.
+// Results differ slightly from decimate_inplace since collapses aren't taken in strict global order of cost.
+GEODE_CORE_EXPORT void
+decimate_inplace_parallel(MutableTriangleTopology& mesh,
+                 RawField<const Vector<real,3>,VertexId> X,
+                 const real distance,             // (Very) approximate distance between original and decimation
+                 const real max_angle=pi/2,       // Max normal angle change in radians for one decimation step
+                 const int min_vertices=-1,       // Stop if we decimate down to this many vertices (-1 for no limit)
+                 const real boundary_distance=0); // How far we're allowed to move the boundary
+
+// A progressive mesh: the result of a decimation plus the vertex splits that undo its collapses, coarsest first.
+// Vertices and faces are renumbered so that the level of detail after the first n splits uses exactly the first
+// vertices(n) vertices and faces(n) faces, with split i adding vertex base_vertices()+i.  Any level can be extracted
+// in time linear in its size, and a client holding one level can be sent the next splits to refine it in place.
+// parents records which vertex each split refines, giving the vertex hierarchy for view dependent refinement.
+struct ProgressiveMesh : public Object {
+  GEODE_DECLARE_TYPE(GEODE_CORE_EXPORT)
+  typedef Object Base;
+  typedef Vector<real,3> TV;
+
+  const Array<const int> vertex_ids; // Vertex of the original mesh for each progressive vertex
+  const Array<const TV> X; // Vertex positions, which decimation never moves
+  const Array<const Vector<int,3>> base_faces; // Faces of the coarsest level
+  const Array<const int> parents; // Split i splits vertex base_vertices()+i off of parents[i]
+  const Nested<const Vector<int,3>> split_faces; // Faces added by each split (at most two)
+  const Nested<const int> split_corners; // Corners 3*f+j which each split moves from its parent to the new vertex
+
+protected:
+  GEODE_CORE_EXPORT ProgressiveMesh(Array<const int> vertex_ids, Array<const TV> X, Array<const Vector<int,3>> base_faces,
+                                    Array<const int> parents, Nested<const Vector<int,3>> split_faces,
+                                    Nested<const int> split_corners);
+public:
+  ~ProgressiveMesh();
+
+  int splits() const { return parents.size(); }
+  int base_vertices() const { return X.size()-splits(); }
+  int vertices(const int splits) const { return base_vertices()+splits; }
+  int faces(const int splits) const { return base_faces.size()+split_faces.offsets[splits]; }
+
+  // Apply splits [start,end) to the faces of level start, which must have exactly faces(start) entries
+  GEODE_CORE_EXPORT void refine(Array<Vector<int,3>>& faces, const int start, const int end) const;
+
+  // The faces of the level of detail after the first splits splits
+  GEODE_CORE_EXPORT Array<Vector<int,3>> lod_faces(const int splits) const;
+
+  // The faces of the coarsest level with at least the given number of vertices
+  GEODE_CORE_EXPORT Array<Vector<int,3>> lod_faces_with_vertices(const int vertices) const;
+};
+
+// As decimate, but record every collapse, and return the whole hierarchy down to the decimated mesh.  The finest
+// level reproduces the original mesh, up to renumbering and the removal of erased vertices and faces.
+GEODE_CORE_EXPORT Ref<const ProgressiveMesh>
+progressive_decimate(const TriangleTopology& mesh,
+                     RawField<const Vector<real,3>,VertexId> X,
+                     const real distance,             // (Very) approximate distance between original and decimation
+                     const real max_angle=pi/2,       // Max normal angle change in radians for one decimation step
+                     const int min_vertices=-1,       // Stop if we decimate down to this many vertices (-1 for no limit)
+                     const real boundary_distance=0); // How far we're allowed to move the boundary
+
 GEODE_CORE_EXPORT Tuple<Ref<const TriangleTopology>,Field<const Vector<real,3>,VertexId>>
 simplify_deprecated(const TriangleTopology& mesh,
          RawField<const Vector<real,3>,VertexId> X,
@@ -0,0 +1,278 @@
+// Out-of-core decimation of mesh files
+
+#include <geode/mesh/decimate_file.h>
+#include <geode/mesh/decimate.h>
+#include <geode/mesh/io.h>
+#include <geode/geometry/Box.h>
+#include <geode/python/exceptions.h>
+#include <geode/python/wrap.h>
+#include <geode/structure/Hashtable.h>
+#include <geode/utility/format.h>
+#include <geode/utility/parallel.h>
+#include <cstdio>
+#include <errno.h>
+namespace geode {
+
+typedef real T;
+typedef Vector<T,3> TV;
+typedef Vector<int,3> IV;
+
+// Grids are at most this many cells, so their counts stay small next to a chunk
+static const int max_grid_cells = 1<<20;
+
+namespace {
+// A grid of cells over the mesh, grouped into chunks
+struct Grid {
+  TV origin;
+  T h;
+  IV dims;
+  Array<int> chunk; // Chunk of each cell, or -1 if no faces fall inside it
+
+  int cell(const TV& x) const {
+    IV i;
+    for (const int a : range(3))
+      i[a] = max(0,min(dims[a]-1,int(floor((x[a]-origin[a])/h))));
+    return (i.x*dims.y+i.y)*dims.z+i.z;
+  }
+};
+
+// A temporary file, closed (and so deleted) on destruction
+struct TempFile {
+  FILE* const f;
+
+  TempFile()
+    : f(tmpfile()) {
+    if (!f)
+      throw IOError(format("decimate_file: can't create temporary file: %s",strerror(errno)));
+  }
+
+  TempFile(const TempFile&) = delete;
+  void operator=(const TempFile&) = delete;
+
+  ~TempFile() {
+    fclose(f);
+  }
+};
+}
+
+// Visit the faces of a file in blocks, reading them and computing their centroids in parallel.  Erased faces of
+// native files are passed on as (-1,-1,-1), with garbage centroids.
+template<class F> static void face_blocks(const MeshReader& reader, const F& f) {
+  const int block = 1<<16;
+  Array<IV> tris(block,uninit);
+  Array<TV> centers(block,uninit);
+  for (int start=0;start<reader.n_faces();start+=block) {
+    const int n = min(block,reader.n_faces()-start);
+    parallel_for(n,[&](const int i) {
+      const auto t = tris[i] = reader.face(start+i);
+      if (t.x >= 0)
+        centers[i] = (reader.vertex(t.x)+reader.vertex(t.y)+reader.vertex(t.z))/3;
+    },1024);
+    f(tris.slice(0,n),centers.slice(0,n));
+  }
+}
+
+// Cells are cubes, as small as the cell budget allows
+static Grid bounding_grid(const Box<TV>& box) {
+  Grid grid;
+  grid.origin = box.min;
+  const auto sizes = box.sizes();
+  grid.h = sizes.max()>0 ? sizes.max()/1024 : 1;
+  for (;;) {
+    for (const int a : range(3))
+      grid.dims[a] = max(1,int(ceil(sizes[a]/grid.h)));
+    if (int64_t(grid.dims.x)*grid.dims.y*grid.dims.z <= max_grid_cells)
+      return grid;
+    grid.h *= T(1.25);
+  }
+}
+
+// Group the cells in [lo,hi) into chunks of at most limit faces where possible, splitting at the median along the
+// longest axis.  Cells without faces are left unassigned.
+static void split_chunks(Grid& grid, RawArray<const int> counts, const IV lo, const IV hi, const int limit,
+                         int& chunks) {
+  const auto index = [&](const IV& i) { return (i.x*grid.dims.y+i.y)*grid.dims.z+i.z; };
+  const int axis = (hi-lo).argmax();
+  Array<int64_t> slabs(hi[axis]-lo[axis]);
+  int64_t total = 0;
+  for (int i=lo.x;i<hi.x;i++)
+    for (int j=lo.y;j<hi.y;j++)
+      for (int k=lo.z;k<hi.z;k++) {
+        const IV c(i,j,k);
+        const int n = counts[index(c)];
+        slabs[c[axis]-lo[axis]] += n;
+        total += n;
+      }
+  if (!total)
+    return;
+  if (total<=limit || slabs.size()==1) {
+    for (int i=lo.x;i<hi.x;i++)
+      for (int j=lo.y;j<hi.y;j++)
+        for (int k=lo.z;k<hi.z;k++)
+          grid.chunk[index(IV(i,j,k))] = chunks;
+    chunks++;
+    return;
+  }
+  int mid = 1;
+  for (int64_t sum=slabs[0];mid<slabs.size()-1 && 2*sum<total;mid++)
+    sum += slabs[mid];
+  IV split = hi;
+  split[axis] = lo[axis]+mid;
+  split_chunks(grid,counts,lo,split,limit,chunks);
+  split = lo;
+  split[axis] = lo[axis]+mid;
+  split_chunks(grid,counts,split,hi,limit,chunks);
+}
+
+// One pass of chunked decimation from reader to writer
+static void decimate_pass(const MeshReader& reader, MeshWriter& writer, Grid& grid, const T distance,
+                          const T max_angle, const int chunk_faces) {
+  // Count faces per cell, and group cells into chunks
+  const int cells = grid.dims.product();
+  Array<int> counts(cells);
+  face_blocks(reader,[&](RawArray<const IV> tris, RawArray<const TV> centers) {
+    for (const int i : range(tris.size()))
+      if (tris[i].x >= 0)
+        counts[grid.cell(centers[i])]++;
+  });
+  grid.chunk.resize(cells,uninit);
+  grid.chunk.fill(-1);
+  int chunks = 0;
+  split_chunks(grid,counts,IV(),grid.dims,chunk_faces,chunks);
+  Array<int> offsets(chunks+1);
+  for (const int c : range(cells))
+    if (grid.chunk[c] >= 0)
+      offsets[grid.chunk[c]+1] += counts[c];
+  counts.clean_memory();
+  for (const int c : range(chunks))
+    offsets[c+1] += offsets[c];
+
+  // Sort faces by chunk into a temporary file, buffering a few faces per chunk to keep writes large
+  const TempFile spill;
+  const auto fail = [](const char* what) {
+    return IOError(format("decimate_file: failed to %s temporary file: %s",what,strerror(errno)));
+  };
+  {
+    const int buffer_size = max(256,chunk_faces/max(1,chunks));
+    vector<Array<IV>> buffers(chunks);
+    Array<int> written(chunks);
+    const auto flush = [&](const int c) {
+      if (fseek(spill.f,long(sizeof(IV))*(offsets[c]+written[c]),SEEK_SET)
+          || fwrite(buffers[c].data(),sizeof(IV),buffers[c].size(),spill.f)!=size_t(buffers[c].size()))
+        throw fail("write");
+      written[c] += buffers[c].size();
+      buffers[c].clear();
+    };
+    face_blocks(reader,[&](RawArray<const IV> tris, RawArray<const TV> centers) {
+      for (const int i : range(tris.size()))
+        if (tris[i].x >= 0) {
+          const int c = grid.chunk[grid.cell(centers[i])];
+          buffers[c].append(tris[i]);
+          if (buffers[c].size() >= buffer_size)
+            flush(c);
+        }
+    });
+    for (const int c : range(chunks))
+      flush(c);
+  }
+
+  // Decimate each chunk with its boundary locked, and stream it out.  Boundary vertices are shared with other chunks
+  // (or lie on the boundary of the mesh), so we remember their output ids.
+  Hashtable<int,int> shared;
+  for (const int c : range(chunks)) {
+    Array<IV> tris(offsets[c+1]-offsets[c],uninit);
+    if (fseek(spill.f,long(sizeof(IV))*offsets[c],SEEK_SET)
+        || fread(tris.data(),sizeof(IV),tris.size(),spill.f)!=size_t(tris.size()))
+      throw fail("read");
+
+    // Renumber vertices locally
+    Hashtable<int,int> local;
+    Array<int> globals;
+    for (auto& t : tris)
+      for (auto& v : t) {
+        int& i = local.get_or_insert(v,-1);
+        if (i < 0)
+          i = globals.append(v);
+        v = i;
+      }
+    local.clean_memory();
+    Array<TV> X(globals.size(),uninit);
+    for (const int i : range(globals.size()))
+      X[i] = reader.vertex(globals[i]);
+    const auto mesh = new_<MutableTriangleTopology>();
+    mesh->add_vertices(globals.size());
+    mesh->add_faces(tris);
+
+    // A negative boundary distance keeps boundary vertices from collapsing at all
+    decimate_inplace_parallel(*mesh,RawField<const TV,VertexId>(X),distance,max_angle,-1,-1);
+
+    // Write out new vertices, then faces
+    Array<int> ids(globals.size(),uninit);
+    Array<TV> added;
+    for (const auto v : mesh->vertices()) {
+      int* id = 0;
+      if (mesh->is_boundary(v)) {
+        id = &shared.get_or_insert(globals[v.id],-1);
+        if (*id >= 0) {
+          ids[v.id] = *id;
+          continue;
+        }
+      }
+      ids[v.id] = writer.n_vertices()+added.append(X[v.id]);
+      if (id)
+        *id = ids[v.id];
+    }
+    writer.add_vertices(added);
+    tris.clear();
+    for (const auto f : mesh->faces()) {
+      const auto v = mesh->vertices(f);
+      tris.append(IV(ids[v.x.id],ids[v.y.id],ids[v.z.id]));
+    }
+    writer.add_faces(tris);
+  }
+}
+
+void decimate_file(const string& input, const string& output, const T distance, const T max_angle,
+                   const int chunk_faces) {
+  GEODE_ASSERT(chunk_faces>0);
+  const auto reader = new_<MeshReader>(input);
+
+  // Size the grid to the mesh
+  auto box = Box<TV>::empty_box();
+  face_blocks(*reader,[&](RawArray<const IV> tris, RawArray<const TV> centers) {
+    for (const int i : range(tris.size()))
+      if (tris[i].x >= 0)
+        box.enlarge(centers[i]);
+  });
+  if (box.empty())
+    box = Box<TV>(TV());
+  auto grid = bounding_grid(box);
+
+  // Decimate chunk interiors into a temporary file
+  const string temp = output+".decimate.ply";
+  try {
+    {
+      const auto writer = new_<MeshWriter>(temp);
+      decimate_pass(*reader,*writer,grid,distance,max_angle,chunk_faces);
+      writer->close();
+    }
+
+    // Shift the grid by half a cell so that the old seams lie inside the new chunks, and decimate again
+    grid.origin -= grid.h/2;
+    grid.dims += 1;
+    const auto writer = new_<MeshWriter>(output);
+    decimate_pass(*new_<MeshReader>(temp),*writer,grid,distance,max_angle,chunk_faces);
+    writer->close();
+  } catch (...) {
+    remove(temp.c_str());
+    throw;
+  }
+  remove(temp.c_str());
+}
+
+}
+using namespace geode;
+
+void wrap_decimate_file() {
+  GEODE_FUNCTION(decimate_file)
+}
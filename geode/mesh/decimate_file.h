@@ -0,0 +1,26 @@
+// Out-of-core decimation of mesh files
+#pragma once
+
+#include <geode/utility/config.h>
+#include <geode/math/constants.h>
+#include <string>
+namespace geode {
+
+using std::string;
+
+// Decimate a manifold mesh file too large to fit in memory, writing the result to output (any format MeshWriter
+// supports; .ply or .stl keep memory bounded).  The input is read through MeshReader, so it must be a binary .ply of
+// triangles or a native .mesh file.
+//
+// Faces are split into spatially coherent chunks of about chunk_faces faces each, by a k-d split of a grid over the
+// mesh.  Each chunk is decimated as by decimate_inplace_parallel with its boundary locked, so neighboring chunks still
+// agree along their seams, and streamed to a temporary .ply next to output.  A second pass then does the same with the
+// grid shifted by half a cell, so the seams of the first pass lie inside chunks and are reduced in turn.  Memory use is
+// proportional to chunk_faces plus the seams, not the mesh.  Vertices on the boundary of the mesh never move, and since
+// the temporary file is a .ply, positions are rounded to floats.
+GEODE_CORE_EXPORT void decimate_file(const string& input, const string& output,
+                                     const real distance,       // (Very) approximate distance between original and decimation
+                                     const real max_angle=pi/2, // Max normal angle change in radians for one decimation step
+                                     const int chunk_faces=1<<20);
+
+}
@@ -13,6 +13,7 @@ class HalfedgeMesh;
 class HalfedgeGraph;
 class TriangleMesh;
 class TriangleTopology;
+class FrozenTriangleTopology;
 class TriangleSubdivision;
 
 template<int d> struct SimplexMesh;
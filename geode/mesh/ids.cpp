@@ -35,6 +35,7 @@ void wrap_ids() {
   GEODE_OBJECT(vertex_position_id);
   GEODE_OBJECT(vertex_color_id);
   GEODE_OBJECT(vertex_texcoord_id);
+  GEODE_OBJECT(vertex_quadric_id);
   GEODE_OBJECT(face_color_id);
   GEODE_OBJECT(halfedge_color_id);
   GEODE_OBJECT(halfedge_texcoord_id);
@@ -20,6 +20,7 @@ const int erased_id = numeric_limits<int>::max();
 const int vertex_position_id = 0;
 const int vertex_color_id = 1;
 const int vertex_texcoord_id = 2;
+const int vertex_quadric_id = 3; // Cached Quadric per vertex (see vertex_quadrics in quadric.h)
 
 const int face_color_id = 1;
 
@@ -17,6 +17,7 @@ struct ImproveOptions {
   , max_iter(max_iter)
   , min_relevant_area(min_relevant_area)
   , min_quality_improvement(min_quality_improvement)
+  , parallel(false)
   {}
 
   real min_quality;
@@ -26,6 +27,7 @@ struct ImproveOptions {
   int max_iter;
   real min_relevant_area;
   real min_quality_improvement;
+  bool parallel; // Evaluate operations for independent regions in parallel.  Quality and lock functors must be thread safe.
 };
 
 Quadric compute_silhouette_quadric(TriangleTopology const &mesh, Field<Vector<real,3>, VertexId> const &pos, VertexId v, real min_relevant_area) {
@@ -332,14 +334,14 @@ struct Allowed {
 
     // compute minimum quality before
     real minq_before = 1;
-    for (auto f : mesh.incident_faces(v0)) {
+    for (auto f : mesh.faces(v0)) {
       minq_before = min(minq_before, quality[f]);
     }
 
     Array<Tuple<FaceId,real>> new_faces;
     real max_normal_cost = 0;
     real old_area = 0, new_area = 0;
-    for (auto f : mesh.incident_faces(v0)) {
+    for (auto f : mesh.faces(v0)) {
       if (mesh.vertices(f).contains(v1))
         continue;
 
@@ -407,14 +409,14 @@ struct Allowed {
     // brent to optimize only along that line
     int nvertices = 0;
     Vector<real,3> target;
-    for (auto v2 : mesh.vertex_one_ring(v)) {
+    for (auto v2 : mesh.neighbors(v)) {
       target += pos[v2];
       nvertices++;
     }
     target /= nvertices;
     target = target.projected_orthogonal_to_unit_direction(mesh.normal(pos, v));
 
-    auto faces = mesh.incident_faces(v);
+    auto faces = mesh.faces(v);
     real before_min_q = 1;
     Array<real> areas;
     Array<Vector<real,3>> normals;
@@ -530,162 +532,252 @@ bool improve_mesh_inplace(MutableTriangleTopology &mesh, Field<Vector<real,3>, V
     }
   }
 
-  // cache quadrics
-  Field<Quadric,VertexId> quadrics = mesh.create_compatible_vertex_field<Quadric>();
+  // cache quadrics, reusing (and maintaining) the ones left by an earlier pass if the mesh has them.  Silhouette
+  // quadrics depend on o.min_relevant_area, so they are always local.
+  const FieldId<Quadric,VertexId> quadrics_id(vertex_quadric_id);
+  const bool shared_quadrics = mesh.has_field(quadrics_id);
+  Field<Quadric,VertexId> quadrics = shared_quadrics ? mesh.field(quadrics_id)
+                                                     : mesh.create_compatible_vertex_field<Quadric>();
   Field<Quadric,VertexId> silhouette_quadrics = mesh.create_compatible_vertex_field<Quadric>();
   for (auto v : mesh.vertices()) {
-    quadrics[v] = compute_quadric(mesh, pos, v);
+    if (!shared_quadrics)
+      quadrics[v] = compute_quadric(mesh, pos, v);
     silhouette_quadrics[v] = compute_silhouette_quadric(mesh, pos, v, o.min_relevant_area);
   }
 
   Allowed<Quality, EdgeLocked, VertexLocked> allowed(mesh, pos, quality, quadrics, silhouette_quadrics, Q, EL, VL, o);
 
-  bool improved_something = !needs_improvement.empty();
-  int iter = 0;
-  while (improved_something && iter < o.max_iter) {
-
-    GEODE_DEBUG_ONLY(real quality_before = mesh_quality(mesh, pos, Q));
-
-    improved_something = false;
-    Hashtable<FaceId> still_needs_improvement;
-
-    for (auto f : needs_improvement) {
-      // check if this face has been deleted by another operation
-      if (mesh.erased(f))
-        continue;
-
-      // check if the quality has been changed by another operation, and if it's
-      // still in need of improvement
-      real q = quality[f];
-      if (q >= o.min_quality)
-        continue;
-
-      // find best operation to perform on this triangle we can:
-      //   - flip an edge
-      //   - collapse an edge (any halfedge outgoing from any triangle vertex)
-      //   - move a vertex
-      // prioritize the operation which
-      //   - improves the quality of the mesh the most (enough)
-      //   - has the lowest impact on normals and quadrics
-      //   - changes the fewest triangles
-      // Priority:
-      //   - if there are any operations with finite cost that improve our triangle
-      //     above min_quality without pulling any other triangle below, only consider those
-      //   - if there are any operations with finite cost that improve our triangle
-      //     above min_quality without worsening other triangles, only consider those
-      //   - from the leftover operations, pick the one with lowest cost
-
-      Array<Tuple<FaceId,real>> changed_faces;
-      real best_cost = numeric_limits<real>::infinity();
-
-      GEODE_DEBUG_ONLY(std::cout << "  face " << f << " quality " << q << std::endl);
-
-      // check flips
-      HalfedgeId flip_edge;
-      for (auto he : mesh.halfedges(f)) {
-        auto r = allowed.check_flip(he);
-        if (r.x < best_cost) {
-          best_cost = r.x;
-          flip_edge = he;
-          changed_faces = r.y;
-        }
+  // The best operation found for a face.  At most one of flip_edge, collapse_edge, and move_vertex is valid.
+  struct Operation {
+    real cost;
+    HalfedgeId flip_edge, collapse_edge;
+    VertexId move_vertex;
+    Vector<real,3> move_to;
+    Array<Tuple<FaceId,real>> changed_faces;
+    Array<VertexId> footprint; // Vertices touched by the operation (only in parallel mode)
+  };
+
+  // find best operation to perform on this triangle we can:
+  //   - flip an edge
+  //   - collapse an edge (any halfedge outgoing from any triangle vertex)
+  //   - move a vertex
+  // prioritize the operation which
+  //   - improves the quality of the mesh the most (enough)
+  //   - has the lowest impact on normals and quadrics
+  //   - changes the fewest triangles
+  // Priority:
+  //   - if there are any operations with finite cost that improve our triangle
+  //     above min_quality without pulling any other triangle below, only consider those
+  //   - if there are any operations with finite cost that improve our triangle
+  //     above min_quality without worsening other triangles, only consider those
+  //   - from the leftover operations, pick the one with lowest cost
+  // This only reads the mesh, so in parallel mode it is called concurrently for different faces.
+  const auto best_operation = [&](const FaceId f) {
+    Operation op;
+    op.cost = numeric_limits<real>::infinity();
+
+    GEODE_DEBUG_ONLY(std::cout << "  face " << f << " quality " << quality[f] << std::endl);
+
+    // check flips
+    for (auto he : mesh.halfedges(f)) {
+      auto r = allowed.check_flip(he);
+      if (r.x < op.cost) {
+        op.cost = r.x;
+        op.flip_edge = he;
+        op.changed_faces = r.y;
       }
+    }
 
-      // check collapses
-      HalfedgeId collapse_edge;
-      for (auto v : mesh.vertices(f)) {
-        for (auto he : mesh.outgoing(v)) {
-          auto r = allowed.check_collapse(he);
-          if (r.x < best_cost) {
-            flip_edge = HalfedgeId();
-            best_cost = r.x;
-            collapse_edge = he;
-            changed_faces = r.y;
-          }
+    // check collapses
+    for (auto v : mesh.vertices(f)) {
+      for (auto he : mesh.outgoing(v)) {
+        auto r = allowed.check_collapse(he);
+        if (r.x < op.cost) {
+          op.flip_edge = HalfedgeId();
+          op.cost = r.x;
+          op.collapse_edge = he;
+          op.changed_faces = r.y;
         }
       }
+    }
 
-      // check vertex moves only if nothing else works (they're expensive)
-      VertexId move_vertex;
-      Vector<real,3> move_to;
-      if (!flip_edge.valid() && !collapse_edge.valid()) {
-        for (auto v : mesh.vertices(f)) {
-          auto r = allowed.check_move(v);
-          if (r.x < best_cost) {
-            collapse_edge = flip_edge = HalfedgeId();
-            best_cost = r.x;
-            move_vertex = v;
-            move_to = r.z;
-            changed_faces = r.y;
-          }
+    // check vertex moves only if nothing else works (they're expensive)
+    if (!op.flip_edge.valid() && !op.collapse_edge.valid()) {
+      for (auto v : mesh.vertices(f)) {
+        auto r = allowed.check_move(v);
+        if (r.x < op.cost) {
+          op.collapse_edge = op.flip_edge = HalfedgeId();
+          op.cost = r.x;
+          op.move_vertex = v;
+          op.move_to = r.z;
+          op.changed_faces = r.y;
         }
       }
+    }
+    return op;
+  };
 
-      GEODE_DEBUG_ONLY(real minq_before = 1);
+  // do it and update qualities and quadrics.  Returns false if there was no operation to do.
+  const auto apply = [&](const Operation& op, Hashtable<FaceId>& still_needs_improvement) {
+    GEODE_DEBUG_ONLY(real minq_before = 1);
 
-      // do it and update qualities and quadrics
-      if (flip_edge.valid()) {
-        GEODE_DEBUG_ONLY(
-          for (auto bf: mesh.faces(flip_edge)) {
-            minq_before = min(minq_before, quality[bf]);
-          }
-          std::cout << "    flip " << flip_edge << ", cost " << best_cost << std::endl;
-        )
-
-        flip_edge = mesh.flip_edge(flip_edge);
-      } else if (collapse_edge.valid()) {
-        GEODE_DEBUG_ONLY(
-          for (auto bf: mesh.incident_faces(mesh.src(collapse_edge))) {
-            minq_before = min(minq_before, quality[bf]);
-          }
-          std::cout << "    collapse " << collapse_edge << ": " << mesh.src(collapse_edge) << " -> " << mesh.dst(collapse_edge) << ", cost " << best_cost << std::endl;
-        )
-
-        mesh.collapse(collapse_edge);
-      } else if (move_vertex.valid()) {
-        GEODE_DEBUG_ONLY(
-          for (auto bf: mesh.incident_faces(move_vertex)) {
-            minq_before = min(minq_before, quality[bf]);
-          }
-          std::cout << "    move " << move_vertex << ", cost " << best_cost << std::endl;
-        )
+    if (op.flip_edge.valid()) {
+      GEODE_DEBUG_ONLY(
+        for (auto bf: mesh.faces(op.flip_edge)) {
+          minq_before = min(minq_before, quality[bf]);
+        }
+        std::cout << "    flip " << op.flip_edge << ", cost " << op.cost << std::endl;
+      )
 
-        pos[move_vertex] = move_to;
-      } else {
-        // can't remove this triangle, it's still there!
-        still_needs_improvement.set(f);
-        continue;
-      }
+      mesh.flip_edge(op.flip_edge);
+    } else if (op.collapse_edge.valid()) {
+      GEODE_DEBUG_ONLY(
+        for (auto bf: mesh.incident_faces(mesh.src(op.collapse_edge))) {
+          minq_before = min(minq_before, quality[bf]);
+        }
+        std::cout << "    collapse " << op.collapse_edge << ": " << mesh.src(op.collapse_edge) << " -> " << mesh.dst(op.collapse_edge) << ", cost " << op.cost << std::endl;
+      )
 
+      mesh.collapse(op.collapse_edge);
+    } else if (op.move_vertex.valid()) {
       GEODE_DEBUG_ONLY(
-        real minq_after = 1;
-        for (auto nf: changed_faces) {
-          minq_after = min(minq_after, nf.y);
+        for (auto bf: mesh.incident_faces(op.move_vertex)) {
+          minq_before = min(minq_before, quality[bf]);
         }
-        std::cout << "    min quality " << minq_before << " -> " << minq_after << ", improvement " << minq_after - minq_before << std::endl;
+        std::cout << "    move " << op.move_vertex << ", cost " << op.cost << std::endl;
       )
 
-      Hashtable<VertexId> update_vertices;
-      for (auto nf : changed_faces) {
-        // update quality
-        quality[nf.x] = nf.y;
+      pos[op.move_vertex] = op.move_to;
+    } else {
+      // can't remove this triangle, it's still there!
+      return false;
+    }
+
+    GEODE_DEBUG_ONLY(
+      real minq_after = 1;
+      for (auto nf: op.changed_faces) {
+        minq_after = min(minq_after, nf.y);
+      }
+      std::cout << "    min quality " << minq_before << " -> " << minq_after << ", improvement " << minq_after - minq_before << std::endl;
+    )
 
-        // remember vertices to update quadrics for
-        for (auto v : mesh.vertices(nf.x)) {
-          update_vertices.set(v);
-        }
+    Hashtable<VertexId> update_vertices;
+    for (auto nf : op.changed_faces) {
+      // update quality
+      quality[nf.x] = nf.y;
 
-        if (nf.y < o.min_quality)
-          still_needs_improvement.set(nf.x);
+      // remember vertices to update quadrics for
+      for (auto v : mesh.vertices(nf.x)) {
+        update_vertices.set(v);
       }
 
-      // update quadrics on update_vertices
-      for (auto uv : update_vertices) {
-        quadrics[uv] = compute_quadric(mesh, pos, uv);
-        silhouette_quadrics[uv] = compute_silhouette_quadric(mesh, pos, uv, o.min_relevant_area);
+      if (nf.y < o.min_quality)
+        still_needs_improvement.set(nf.x);
+    }
+
+    // update quadrics on update_vertices
+    for (auto uv : update_vertices) {
+      quadrics[uv] = compute_quadric(mesh, pos, uv);
+      silhouette_quadrics[uv] = compute_silhouette_quadric(mesh, pos, uv, o.min_relevant_area);
+    }
+    return true;
+  };
+
+  // check if a face has been deleted by another operation, or if its quality has been changed by another
+  // operation and it no longer needs improvement
+  const auto needs_work = [&](const FaceId f) {
+    return !mesh.erased(f) && quality[f] < o.min_quality;
+  };
+
+  // In parallel mode, each sweep runs in rounds.  A round evaluates every remaining face in parallel, then applies
+  // operations serially, skipping any whose footprint is within one vertex of an operation already applied that
+  // round.  The applied operations have disjoint neighborhoods, so none of them invalidates another's evaluation.
+  // Skipped faces are evaluated again in the next round.
+  Field<int,VertexId> locked;
+  if (o.parallel)
+    locked = mesh.create_compatible_vertex_field<int>();
+  int round = 0;
+  Array<FaceId> todo, deferred;
+  vector<Operation> ops;
+
+  bool improved_something = !needs_improvement.empty();
+  int iter = 0;
+  while (improved_something && iter < o.max_iter) {
+
+    GEODE_DEBUG_ONLY(real quality_before = mesh_quality(mesh, pos, Q));
+
+    improved_something = false;
+    Hashtable<FaceId> still_needs_improvement;
+
+    if (!o.parallel) {
+      for (auto f : needs_improvement) {
+        if (!needs_work(f))
+          continue;
+        if (!apply(best_operation(f), still_needs_improvement)) {
+          still_needs_improvement.set(f);
+          continue;
+        }
+        improved_something = true;
       }
+    } else {
+      todo.clear();
+      for (auto f : needs_improvement)
+        todo.append(f);
+      while (todo.size()) {
+        round++;
+        ops.resize(todo.size());
+        #pragma omp parallel for
+        for (int i=0;i<todo.size();i++) {
+          const auto f = todo[i];
+          auto& op = ops[i];
+          op.footprint.clear();
+          if (!needs_work(f))
+            continue;
+          op = best_operation(f);
+          for (auto v : mesh.vertices(f))
+            op.footprint.append(v);
+          const auto add_faces = [&](const Vector<FaceId,2> fs) {
+            for (auto ff : fs)
+              if (ff.valid())
+                op.footprint.extend(mesh.vertices(ff));
+          };
+          if (op.flip_edge.valid())
+            add_faces(mesh.faces(op.flip_edge));
+          for (auto v : {op.collapse_edge.valid() ? mesh.src(op.collapse_edge) : VertexId(),
+                         op.collapse_edge.valid() ? mesh.dst(op.collapse_edge) : VertexId(),
+                         op.move_vertex})
+            if (v.valid())
+              for (auto e : mesh.outgoing(v))
+                add_faces(mesh.faces(e));
+        }
 
-      improved_something = true;
+        deferred.clear();
+        for (int i=0;i<todo.size();i++) {
+          // an empty footprint means the face didn't need work when evaluated
+          const auto f = todo[i];
+          const auto& op = ops[i];
+          if (!op.footprint.size() || !needs_work(f))
+            continue;
+          bool free = true;
+          for (auto v : op.footprint)
+            free = free && locked[v] != round;
+          if (!free) {
+            deferred.append(f);
+            continue;
+          }
+          for (auto v : op.footprint) {
+            locked[v] = round;
+            for (auto e : mesh.outgoing(v))
+              locked[mesh.dst(e)] = round;
+          }
+          if (!apply(op, still_needs_improvement)) {
+            still_needs_improvement.set(f);
+            continue;
+          }
+          improved_something = true;
+        }
+        swap(todo, deferred);
+      }
     }
 
     GEODE_DEBUG_ONLY(real quality_after = mesh_quality(mesh, pos, Q));
@@ -2,12 +2,17 @@
 
 #include <geode/mesh/io.h>
 #include <geode/mesh/PolygonSoup.h>
+#include <geode/mesh/quadric.h>
+#include <geode/array/mapped.h>
 #include <geode/array/view.h>
 #include <geode/geometry/Triangle3d.h>
 #include <geode/python/cast.h>
+#include <geode/python/Class.h>
 #include <geode/python/wrap.h>
 #include <geode/utility/endian.h>
 #include <geode/utility/function.h>
+#include <geode/utility/openmp.h>
+#include <geode/utility/parallel.h>
 #include <geode/utility/path.h>
 #include <errno.h>
 namespace geode {
@@ -44,12 +49,10 @@ struct File {
 }
 
 // Determine whether a file is probably binary or ascii
-static bool is_binary(const string& filename) {
-  File f(filename,"rb");
-  char data[512];
-  const int n = int(fread(data,1,sizeof(data),f));
-  for (int i=0;i<n;i++)
-    if (!isascii(data[i]))
+static bool is_binary(const MappedFile& file) {
+  const size_t n = min(file.size,size_t(512));
+  for (size_t i=0;i<n;i++)
+    if (!isascii(file.data[i]))
       return true;
   return false;
 }
@@ -60,6 +63,128 @@ static const char* skip_white(const char* p) {
   return p;
 }
 
+namespace {
+// A null terminated copy of [p,end) for the C library parsers, avoiding allocation for short tokens
+struct Token {
+  char small[64];
+  string large;
+  const char* c_str;
+
+  Token(const char* p, const char* end) {
+    if (end-p < int(sizeof(small))) {
+      memcpy(small,p,end-p);
+      small[end-p] = 0;
+      c_str = small;
+    } else {
+      large.assign(p,end);
+      c_str = large.c_str();
+    }
+  }
+};
+}
+
+static const double powers_of_ten[23] = {1e0,1e1,1e2,1e3,1e4,1e5,1e6,1e7,1e8,1e9,1e10,1e11,
+                                         1e12,1e13,1e14,1e15,1e16,1e17,1e18,1e19,1e20,1e21,1e22};
+
+// Parse a number occupying exactly [p,end), which need not be null terminated.  Plain decimals are converted
+// directly: a mantissa below 2^53 scaled by an exact power of ten up to 1e22 is correctly rounded (Clinger's fast
+// path).  Anything else falls back to strtod / strtoll on a null terminated copy.  Returns false on garbage.
+static bool parse_number(const char* p, const char* end, double& x) {
+  const char* q = p;
+  const bool negative = q<end && *q=='-';
+  if (q<end && (*q=='-' || *q=='+'))
+    q++;
+  uint64_t m = 0;
+  int digits = 0, exponent = 0;
+  bool any = false;
+  for (;q<end && isdigit(*q);q++,any=true) {
+    if (m || *q!='0') {
+      m = 10*m+(*q-'0');
+      digits++;
+    }
+  }
+  if (q<end && *q=='.') {
+    for (q++;q<end && isdigit(*q);q++,any=true) {
+      if (m || *q!='0') {
+        m = 10*m+(*q-'0');
+        digits++;
+      }
+      exponent--;
+    }
+  }
+  if (any && q<end && (*q=='e' || *q=='E')) {
+    q++;
+    const bool negative_exponent = q<end && *q=='-';
+    if (q<end && (*q=='-' || *q=='+'))
+      q++;
+    int e = 0;
+    const char* start = q;
+    for (;q<end && isdigit(*q) && q-start<4;q++)
+      e = 10*e+(*q-'0');
+    if (q==start)
+      any = false;
+    exponent += negative_exponent ? -e : e;
+  }
+  if (any && q==end && digits<=15 && abs(exponent)<=22) {
+    const double y = exponent<0 ? double(m)/powers_of_ten[-exponent] : double(m)*powers_of_ten[exponent];
+    x = negative ? -y : y;
+    return true;
+  }
+
+  // Slow path
+  if (p==end)
+    return false;
+  const Token copy(p,end);
+  char* stop;
+  x = strtod(copy.c_str,&stop);
+  return !*stop;
+}
+
+static bool parse_number(const char* p, const char* end, long long& n) {
+  const char* q = p;
+  const bool negative = q<end && *q=='-';
+  if (q<end && (*q=='-' || *q=='+'))
+    q++;
+  // Leading zeros mean octal or hex to strtoll, so leave those to the slow path
+  if (q<end && end-q<=18 && (*q!='0' || end-q==1)) {
+    long long m = 0;
+    for (;q<end && isdigit(*q);q++)
+      m = 10*m+(*q-'0');
+    if (q==end) {
+      n = negative ? -m : m;
+      return true;
+    }
+  }
+  if (p==end)
+    return false;
+  const Token copy(p,end);
+  char* stop;
+  n = strtoll(copy.c_str,&stop,0);
+  return !*stop;
+}
+
+// Split [data,end) into at most n pieces starting at line boundaries, for parsing text files in parallel
+static vector<const char*> split_lines(const char* data, const char* end, const int n) {
+  vector<const char*> starts(1,data);
+  for (int k=1;k<n;k++) {
+    const char* p = data+(end-data)/n*k;
+    if (p <= starts.back())
+      continue;
+    const char* eol = (const char*)memchr(p,'\n',end-p);
+    if (!eol || eol+1==end)
+      break;
+    if (eol+1 > starts.back())
+      starts.push_back(eol+1);
+  }
+  starts.push_back(end);
+  return starts;
+}
+
+// Number of pieces to split a text file of the given size into
+static int text_chunks(const size_t size) {
+  return int(max(size_t(1),min(size_t(8*omp_get_max_threads()),size>>20)));
+}
+
 // Can't use a simple struct since StlTri has bad alignment
 struct StlTriData {
   Vector<float,3> n;
@@ -71,49 +196,79 @@ struct StlTri {
 };
 static_assert(sizeof(StlTri)==12*4+2,"");
 
+// Merge identical vertices of a binary stl, numbering them in order of first appearance.  Corners are
+// bucketed by the high bits of their hash (the per bucket tables use the low bits), and each bucket is
+// deduplicated independently in parallel.  With a single thread there is a single bucket.
+static Tuple<Ref<TriangleSoup>,Array<TV>> weld_stl(const StlTri* data, const int count) {
+  const int n = 3*count;
+  const auto corner = [=](const int c) {
+    Vector<float,3> x;
+    memcpy(&x,data[c/3].d+offsetof(StlTriData,x)+sizeof(x)*(c%3),sizeof(x));
+    return from_little_endian(x);
+  };
+  int bits = 0;
+  while ((1<<bits) < 16*omp_get_max_threads() && omp_get_max_threads()>1)
+    bits++;
+  const int buckets = 1<<bits;
+
+  // Sort corners into buckets, preserving order within each bucket
+  Array<int> first(n,uninit); // Bucket of each corner, then first corner with the same position, then vertex id
+  #pragma omp parallel for
+  for (int c=0;c<n;c++)
+    first[c] = bits ? int(unsigned(hash(corner(c)))>>(32-bits)) : 0;
+  Array<int> offsets(buckets+1);
+  for (const int b : first)
+    offsets[b+1]++;
+  for (int b=0;b<buckets;b++)
+    offsets[b+1] += offsets[b];
+  Array<int> order(n,uninit);
+  {
+    auto next = offsets.slice(0,buckets).copy();
+    for (int c=0;c<n;c++)
+      order[next[first[c]]++] = c;
+  }
+
+  // Find the first corner at each position
+  #pragma omp parallel for
+  for (int b=0;b<buckets;b++) {
+    const auto cs = order.slice(offsets[b],offsets[b+1]);
+    Hashtable<Vector<float,3>,int> id(cs.size()/6); // Closed meshes have about 6 corners per vertex
+    for (const int c : cs)
+      first[c] = id.get_or_insert(corner(c),c);
+  }
+
+  // Number vertices in order.  first[c] <= c, so earlier corners have already been converted to vertex ids.
+  int nv = 0;
+  for (int c=0;c<n;c++)
+    first[c] = first[c]==c ? nv++ : first[first[c]];
+  Array<TV> X(nv,uninit);
+  #pragma omp parallel for
+  for (int c=0;c<n;c++)
+    X[first[c]] = TV(corner(c));
+  return tuple(new_<TriangleSoup>(vector_view_own<3>(first),nv),X);
+}
+
 // See http://en.wikipedia.org/wiki/STL_file for details
 static Tuple<Ref<TriangleSoup>,Array<TV>> read_stl(const string& filename) {
-  if (is_binary(filename)) {
-    File f(filename,"rb");
-
+  const MappedFile file(filename);
+  if (is_binary(file)) {
     // Skip header
-    char header[80];
-    const auto nh = fread(header,1,sizeof(header),f);
-    if (nh < sizeof(header))
-      throw IOError(format("invalid binary stl '%s': %s",filename,
-        ferror(f) ? format("read failed: %s",strerror(errno)) : "incomplete header"));
+    if (file.size < 80)
+      throw IOError(format("invalid binary stl '%s': incomplete header",filename));
 
     // Read count
     uint32_t count;
-    const auto nc = fread(&count,sizeof(count),1,f);
-    if (nc < 1)
+    if (file.size < 80+sizeof(count))
       throw IOError(format("invalid binary stl '%s': failed to read count",filename));
+    memcpy(&count,file.data+80,sizeof(count));
+    count = from_little_endian(count);
     if (count > (1u<<31)/3-1)
       throw IOError(format("binary stl has too many triangles: %u > 2^31/3-1",count));
 
-    // Read triangles
-    Array<StlTri> data(count,uninit);
-    const auto nt = fread(data.data(),sizeof(StlTri),count,f);
-    if (nt < count)
+    // Parse triangles directly out of the mapped file
+    if (file.size < 80+sizeof(count)+size_t(count)*sizeof(StlTri))
       throw IOError(format("invalid binary stl '%s': failed to read triangles",filename));
-
-    // Deduplicate
-    Hashtable<Vector<float,3>,int> id;
-    Array<Vector<int,3>> tris;
-    Array<TV> X;
-    for (auto& t : data) {
-      StlTriData d;
-      memcpy(&d,t.d,sizeof(d));
-      Vector<int,3> tri;
-      for (int a=0;a<3;a++) {
-        const int i = id.get_or_insert(d.x[a],X.size());
-        if (i == X.size())
-          X.append(TV(d.x[a]));
-        tri[a] = i;
-      }
-      tris.append(tri);
-    }
-    return tuple(new_<TriangleSoup>(tris,X.size()),X);
+    return weld_stl((const StlTri*)(file.data+80+sizeof(count)),int(count));
   } else { // ASCII
     File f(filename,"r");
 
@@ -185,22 +340,162 @@ static Tuple<Ref<TriangleSoup>,Array<TV>> read_stl(const string& filename) {
   }
 }
 
-static void write_stl(const string& filename, RawArray<const Vector<int,3>> tris, RawArray<const TV> X) {
-  // We unconditionally write .stl files in binary.  Text formats for large data are silly.
-  File f(filename,"wb");
+// Write n elements to f, where format_element(p,i) writes element i starting at p and returns the end of what it wrote,
+// which may be at most bound(i) bytes past p.  Chunks of elements are formatted in parallel into separate buffers,
+// a batch at a time so that memory stays bounded, and the buffers are written in order with one fwrite each.
+template<class Bound,class Format> static void write_elements(FILE* f, const int n, const Bound& bound,
+                                                              const Format& format_element) {
+  const int chunk = 1<<14,
+            batch = 4*thread_count();
+  vector<vector<char>> buffers(batch);
+  vector<size_t> sizes(batch);
+  for (int start=0;start<n;start+=chunk*batch) {
+    const int chunks = min(batch,(n-start-1)/chunk+1);
+    parallel_for(chunks,[&](const int c) {
+      const int lo = start+c*chunk,
+                hi = min(n,lo+chunk);
+      size_t size = 0;
+      for (int i=lo;i<hi;i++)
+        size += bound(i);
+      auto& buffer = buffers[c];
+      if (buffer.size()<size)
+        buffer.resize(size);
+      char* p = buffer.data();
+      for (int i=lo;i<hi;i++)
+        p = format_element(p,i);
+      sizes[c] = p-buffer.data();
+    });
+    for (int c=0;c<chunks;c++)
+      if (fwrite(buffers[c].data(),1,sizes[c],f)<sizes[c])
+        throw IOError(format("write_mesh: write failed: %s",strerror(errno)));
+  }
+}
+
+// Longest output of format_int and format_double
+static const int int_size = 11,
+                 double_size = 24;
+
+static char* format_int(char* p, const int n) {
+  char digits[10];
+  int k = 0;
+  uint32_t u = n<0 ? 0u-uint32_t(n) : uint32_t(n);
+  do {
+    digits[k++] = char('0'+u%10);
+    u /= 10;
+  } while (u);
+  if (n<0)
+    *p++ = '-';
+  while (k)
+    *p++ = digits[--k];
+  return p;
+}
+
+// Write x in the shortest decimal form which reads back as exactly x.  For |x| in [1e-5,1e15), write |x| = f/2^s
+// with an integer f < 2^53.  The correctly rounded d digit decimal m/10^k is then m = round(f*10^k/2^s), and it
+// reads back as x iff it lies within half an ulp of |x|, which is 10^k/2 after scaling by 10^k*2^s.  All of this is
+// exact in 128 bit integers, and since d digits suffice whenever fewer do, the shortest d is found by bisection.
+// Everything else tries snprintf with increasing precision: 15 digits give the shortest form whenever at most 15
+// suffice, except for subnormals, so those start from 1.
+static char* format_double(char* p, const double x) {
+  const double a = fabs(x);
+#if defined(__GNUC__) && defined(__LP64__)
+  typedef __uint128_t U;
+  if (a==0 || (a>=1e-5 && a<1e15)) {
+    int e10 = 0; // floor(log10(a))
+    uint64_t f = 0;
+    int s = 0;
+    bool f_even = true, lower_gap_halved = false;
+    const auto ten = [](const int k) {
+      static const uint64_t powers[20] = {1ull,10ull,100ull,1000ull,10000ull,100000ull,1000000ull,10000000ull,
+        100000000ull,1000000000ull,10000000000ull,100000000000ull,1000000000000ull,10000000000000ull,
+        100000000000000ull,1000000000000000ull,10000000000000000ull,100000000000000000ull,1000000000000000000ull,
+        10000000000000000000ull};
+      return k<20 ? U(powers[k]) : U(powers[19])*powers[k-19];
+    };
+    if (a) {
+      int ex;
+      f = uint64_t(ldexp(frexp(a,&ex),53));
+      s = 53-ex;
+      f_even = !(f&1);
+      lower_gap_halved = f==uint64_t(1)<<52;
+      if (a>=1)
+        while (e10<14 && a>=powers_of_ten[e10+1])
+          e10++;
+      else
+        do e10--; while (U(f)*ten(-e10)<U(1)<<s);
+    }
+
+    // The correctly rounded decimal with d digits, and whether it reads back as x
+    U m;
+    int k;
+    const auto fits = [&](const int d) {
+      k = d-1-e10;
+      const U N = U(f)*ten(k);
+      m = (N+(U(1)<<s>>1))>>s;
+      const U M = m<<s,
+              error = M>=N ? 2*(M-N) : (lower_gap_halved ? 4 : 2)*(N-M);
+      return error<ten(k) || (f_even && error==ten(k));
+    };
+    int lo = max(1,e10+1)-1, hi = 17;
+    while (hi-lo>1) {
+      const int d = (lo+hi)/2;
+      (fits(d) ? hi : lo) = d;
+    }
+    fits(hi);
+    uint64_t u = uint64_t(m);
+    for (;k && !(u%10);k--) // Rounding up to a power of ten may leave trailing zeros
+      u /= 10;
+    if (std::signbit(x))
+      *p++ = '-';
+    char digits[24];
+    int n = 0;
+    for (;u || n<=k;u/=10)
+      digits[n++] = char('0'+u%10);
+    while (n>k)
+      *p++ = digits[--n];
+    if (k) {
+      *p++ = '.';
+      while (n)
+        *p++ = digits[--n];
+    }
+    return p;
+  }
+#endif
+  char buffer[32];
+  for (int digits=a<numeric_limits<double>::min() ? 1 : 15;;digits++) {
+    const int n = snprintf(buffer,sizeof(buffer),"%.*g",digits,x);
+    if (digits==17 || strtod(buffer,0)==x || x!=x) {
+      memcpy(p,buffer,n);
+      return p+n;
+    }
+  }
+}
+
+static void write_stl_header(FILE* f, const uint32_t count) {
   fprintf(f,"%-79s\n","Binary STL triangle mesh: http://en.wikipedia.org/wiki/STL_file");
-  const uint32_t count = tris.size();
-  fwrite(&count,sizeof(count),1,f);
-  for (const auto nodes : tris) {
+  fwrite(&to_little_endian(count),sizeof(count),1,f);
+}
+
+static void write_stl_tris(FILE* f, RawArray<const Vector<int,3>> tris, RawArray<const TV> X) {
+  write_elements(f,tris.size(),[](int){ return sizeof(StlTri); },[=](char* p, const int i) {
+    const auto nodes = tris[i];
     StlTriData d;
     d.n = to_little_endian(Vector<float,3>(normal(X[nodes[0]],X[nodes[1]],X[nodes[2]])));
-    for (int i=0;i<3;i++)
-      d.x[i] = to_little_endian(Vector<float,3>(X[nodes[i]]));
+    for (int j=0;j<3;j++)
+      d.x[j] = to_little_endian(Vector<float,3>(X[nodes[j]]));
     StlTri t;
     memcpy(t.d,&d,sizeof(d));
     t.c = 0;
-    fwrite(&t,sizeof(t),1,f);
-  }
+    memcpy(p,&t,sizeof(t));
+    return p+sizeof(t);
+  });
+}
+
+static void write_stl(const string& filename, RawArray<const Vector<int,3>> tris, RawArray<const TV> X) {
+  // We unconditionally write .stl files in binary.  Text formats for large data are silly.
+  File f(filename,"wb");
+  write_stl_header(f,tris.size());
+  write_stl_tris(f,tris,X);
 }
 
 static const char* white = " \t\v\f\r\n";
@@ -211,68 +506,133 @@ static char* strtok_r(char* str, const char* delim, char** saveptr) {
 }
 #endif
 
-static Tuple<Ref<PolygonSoup>,Array<TV>> read_obj(const string& filename) {
-  File f(filename,"r");
-
-  // Parse file
+namespace {
+// The parsed contents of a piece of an obj file
+struct ObjChunk {
   Array<TV> X, normals;
   Array<TV2> texcoords;
   Array<int> counts, vertices;
-  char orig[1024], line[1024];
-  int nl = 0;
-  while (fgets(orig,sizeof(orig),f)) {
-    nl++;
-    strcpy(line,orig);
-    char* save;
-    const char* cmd = strtok_r(line,white,&save);
-    if (!cmd || cmd[0] == '#')
+  int lines; // Number of lines in the chunk
+  int error_line; // Line of the first error relative to the chunk, or 0 if none
+  const char* error_kind; // "invalid" or "unsupported"
+  string error; // Message for the first error, prefixed by read_obj with the global line number
+
+  ObjChunk()
+    : lines(0), error_line(0), error_kind(0) {}
+};
+}
+
+static bool is_white(const char c) {
+  return c==' ' || c=='\t' || c=='\v' || c=='\f' || c=='\r' || c=='\n';
+}
+
+// Parse a piece of an obj file starting at a line boundary.  Errors stop parsing and are recorded rather than
+// thrown, since chunks are parsed inside OpenMP loops.
+static void read_obj_chunk(ObjChunk& chunk, const char* p, const char* const end) {
+  while (p < end) {
+    chunk.lines++;
+    const char* const start = p;
+    const char* eol = (const char*)memchr(p,'\n',end-p);
+    eol = eol ? eol : end;
+    p = eol<end ? eol+1 : end;
+    const auto fail = [&](const char* kind, const string& error) {
+      chunk.error_line = chunk.lines;
+      chunk.error_kind = kind;
+      chunk.error = error;
+    };
+    const auto line = [&]() { return repr(string(start,p)); };
+
+    // Split off whitespace delimited words without copying
+    const char* q = start;
+    const auto word = [&](const char*& w) {
+      while (q<eol && is_white(*q))
+        q++;
+      w = q;
+      while (q<eol && !is_white(*q))
+        q++;
+      return w!=q;
+    };
+    const char* cmd;
+    if (!word(cmd) || cmd[0]=='#')
       continue;
-    else if (cmd[0]=='v' && (!cmd[1] || ((cmd[1]=='n' || cmd[1]=='t') && !cmd[2]))) { // cmd = v, vn, or vt
+    const int len = int(q-cmd);
+    if (cmd[0]=='v' && (len==1 || (len==2 && (cmd[1]=='n' || cmd[1]=='t')))) { // cmd = v, vn, or vt
       int n = 0;
       double x[4];
-      for (int i=0;i<4;i++)
-        if (const char* q = strtok_r(0,white,&save)) {
-          char* end;
-          x[n++] = strtod(q,&end);
-          if (*end)
-            throw IOError(format("invalid obj file %s:%d: bad %s line: %s",filename,nl,cmd,repr(orig)));
-        }
-      const int ne = !cmd[1] ? 3 : cmd[1]=='n' ? 3 : /*cmd[1]=='t'*/ 2;
+      const char* w;
+      for (int i=0;i<4 && word(w);i++)
+        if (!parse_number(w,q,x[n++]))
+          return fail("invalid",format("bad %s line: %s",string(cmd,len),line()));
+      const int ne = len==1 ? 3 : cmd[1]=='n' ? 3 : /*cmd[1]=='t'*/ 2;
       if (n != ne)
-        throw IOError(format("invalid obj file %s:%d: %s expected %d floats, got %d. Line: %s",filename,nl,cmd,ne,n,repr(orig)));
-      if (!cmd[1]) { // v
-        if (X.size()==numeric_limits<int>::max())
-          throw IOError(format("unsupported obj file %s: too many vertices (our limit is 2^31-1)",filename));
-        X.append(TV(x[0],x[1],x[2]));
-      } else if (cmd[1]=='n') { // vn
-        if (normals.size()==numeric_limits<int>::max())
-          throw IOError(format("unsupported obj file %s: too many normals (our limit is 2^31-1)",filename));
-        normals.append(TV(x[0],x[1],x[2]));
-      } else { // vt
-        if (texcoords.size()==numeric_limits<int>::max())
-          throw IOError(format("unsupported obj file %s: too many texcoords (our limit is 2^31-1)",filename));
-        texcoords.append(TV2(x[0],x[1]));
-      }
-    } else if (cmd[0]=='f' && !cmd[1]) { // cmd = f
+        return fail("invalid",format("%s expected %d floats, got %d. Line: %s",string(cmd,len),ne,n,line()));
+      if (len==1) // v
+        chunk.X.append(TV(x[0],x[1],x[2]));
+      else if (cmd[1]=='n') // vn
+        chunk.normals.append(TV(x[0],x[1],x[2]));
+      else // vt
+        chunk.texcoords.append(TV2(x[0],x[1]));
+    } else if (cmd[0]=='f' && len==1) { // cmd = f
       int n = 0;
-      while (const char* q = strtok_r(0,white,&save)) {
+      const char* w;
+      while (word(w)) {
         n++;
-        char* end;
-        const long v = strtol(q,&end,0);
-        if (*end && *end != '/')
-          throw IOError(format("invalid obj file %s:%d: f expected ints, got %s",filename,nl,repr(orig)));
         // TODO: Don't skip face normal or face texcoord information
-        if (long(unsigned(int(v))) != v)
-          throw IOError(format("unsupported obj file %s:%d: f got invalid vertex id %ld",filename,nl,v));
-        vertices.append(int(v));
+        const char* slash = (const char*)memchr(w,'/',q-w);
+        long long v;
+        if (!parse_number(w,slash ? slash : q,v))
+          return fail("invalid",format("f expected ints, got %s",line()));
+        if ((long long)(unsigned(int(v))) != v)
+          return fail("unsupported",format("f got invalid vertex id %lld",v));
+        chunk.vertices.append(int(v));
       }
       if (n < 3)
-        throw IOError(format("invalid obj file %s:%d: f got fewer than 3 vertices",filename,nl));
-      counts.append(n);
-    } else if (strcmp(cmd,"usemtl") || strcmp(cmd,"usemat") || strcmp(cmd,"mtllib")) {
-      // TODO: Don't skip these fields?
-    } else
-      throw IOError(format("invalid obj file %s:%d: invalid command %s",filename,nl,repr(cmd)));
+        return fail("invalid","f got fewer than 3 vertices");
+      chunk.counts.append(n);
+    }
+    // TODO: Don't skip usemtl, usemat, mtllib, and other commands
+  }
+}
+
+// Obj files are split at line boundaries and the pieces parsed in parallel.  Vertex indices are global in obj, so
+// the pieces concatenate without adjustment.
+static Tuple<Ref<PolygonSoup>,Array<TV>> read_obj(const string& filename) {
+  const MappedFile file(filename);
+  const auto starts = split_lines(file.data,file.end(),text_chunks(file.size));
+  const int n = int(starts.size())-1;
+  vector<ObjChunk> chunks(n);
+  #pragma omp parallel for schedule(dynamic)
+  for (int k=0;k<n;k++)
+    read_obj_chunk(chunks[k],starts[k],starts[k+1]);
+
+  // Report the first error in the file
+  int lines = 0;
+  for (const auto& c : chunks) {
+    if (c.error_line)
+      throw IOError(format("%s obj file %s:%d: %s",c.error_kind,filename,lines+c.error_line,c.error));
+    lines += c.lines;
+  }
+
+  // Concatenate
+  int64_t nx = 0, nn = 0, nt = 0;
+  for (const auto& c : chunks) {
+    nx += c.X.size();
+    nn += c.normals.size();
+    nt += c.texcoords.size();
+  }
+  if (nx > numeric_limits<int>::max())
+    throw IOError(format("unsupported obj file %s: too many vertices (our limit is 2^31-1)",filename));
+  if (nn > numeric_limits<int>::max())
+    throw IOError(format("unsupported obj file %s: too many normals (our limit is 2^31-1)",filename));
+  if (nt > numeric_limits<int>::max())
+    throw IOError(format("unsupported obj file %s: too many texcoords (our limit is 2^31-1)",filename));
+  Array<TV> X;
+  Array<int> counts, vertices;
+  X.preallocate(int(nx));
+  for (const auto& c : chunks) {
+    X.extend(c.X);
+    counts.extend(c.counts);
+    vertices.extend(c.vertices);
   }
 
   // Adjust vertices and check consistency
@@ -280,10 +640,10 @@ static Tuple<Ref<PolygonSoup>,Array<TV>> read_obj(const string& filename) {
   for (const int v : vertices)
     if (!X.valid(v))
       throw IOError(format("invalid obj file %s: face vertex %d out of valid range [1,%d]",filename,v+1,X.size()));
-  if (normals.size() && normals.size() != X.size())
-    throw IOError(format("invalid obj file %s: %d vertices != %d normals",filename,X.size(),normals.size()));
-  if (texcoords.size() && texcoords.size() != X.size())
-    throw IOError(format("invalid obj file %s: %d vertices != %d texcoords",filename,X.size(),texcoords.size()));
+  if (nn && nn != nx)
+    throw IOError(format("invalid obj file %s: %d vertices != %d normals",filename,X.size(),int(nn)));
+  if (nt && nt != nx)
+    throw IOError(format("invalid obj file %s: %d vertices != %d texcoords",filename,X.size(),int(nt)));
 
   // TODO: Don't discard normal and texcoord information
   return tuple(new_<PolygonSoup>(counts,vertices,X.size()),X);
@@ -299,24 +659,54 @@ static void write_obj_helper(File& f, RawArray<const TV> X) {
         "#   # Vertices are indexed starting from 1\n",f);
 
   // Write vertices
-  for (const auto x : X)
-    fprintf(f,"v %g %g %g\n",x.x,x.y,x.z);
+  write_elements(f,X.size(),[](int){ return 3+3*(1+double_size); },[=](char* p, const int i) {
+    *p++ = 'v';
+    for (const auto x : X[i]) {
+      *p++ = ' ';
+      p = format_double(p,x);
+    }
+    *p++ = '\n';
+    return p;
+  });
 }
+
+// Start of each polygon in soup.vertices
+static Array<int> polygon_offsets(const PolygonSoup& soup) {
+  Array<int> offsets(soup.counts.size()+1,uninit);
+  offsets[0] = 0;
+  for (const int i : range(soup.counts.size()))
+    offsets[i+1] = offsets[i]+soup.counts[i];
+  return offsets;
+}
+
 static void write_obj(const string& filename, RawArray<const Vector<int,3>> tris, RawArray<const TV> X) {
   File f(filename,"wb");
   write_obj_helper(f,X);
-  for (const auto t : tris)
-    fprintf(f,"f %d %d %d\n",t.x+1,t.y+1,t.z+1);
+  write_elements(f,tris.size(),[](int){ return 2+3*(1+int_size); },[=](char* p, const int i) {
+    *p++ = 'f';
+    for (const int v : tris[i]) {
+      *p++ = ' ';
+      p = format_int(p,v+1);
+    }
+    *p++ = '\n';
+    return p;
+  });
 }
 static void write_obj(const string& filename, const PolygonSoup& soup, RawArray<const TV> X) {
   File f(filename,"wb");
   write_obj_helper(f,X);
-  int offset = 0;
-  for (const auto n : soup.counts) {
-    fputc('f',f);
-    for (int i=0;i<n;i++)
-      fprintf(f," %d",soup.vertices[offset++]+1);
-  }
+  const auto offsets = polygon_offsets(soup);
+  const auto& vertices = soup.vertices;
+  write_elements(f,soup.counts.size(),[&](const int i) { return 2+soup.counts[i]*(1+int_size); },
+                 [&](char* p, const int i) {
+    *p++ = 'f';
+    for (const int v : vertices.slice(offsets[i],offsets[i+1])) {
+      *p++ = ' ';
+      p = format_int(p,v+1);
+    }
+    *p++ = '\n';
+    return p;
+  });
 }
 
 namespace {
@@ -325,14 +715,21 @@ struct Line {
   Array<char> line, split;
   Array<const char*> words;
 
-  // TODO: Allow for longer lines
   Line()
-    : lineno(0), line(1024), split(1024) {}
+    : lineno(0), line(1), split(1) {}
 
-  bool read(File& f) {
+  // Read the next line of a mapped file, advancing start past it
+  bool read(const char*& start, const char* end) {
     lineno++;
-    if (!fgets(line.data(),line.size(),f))
+    if (start == end)
       return false;
+    const char* eol = (const char*)memchr(start,'\n',end-start);
+    const int n = int((eol ? eol+1 : end)-start);
+    line.resize(n+1,uninit);
+    split.resize(n+1,uninit);
+    memcpy(line.data(),start,n);
+    line[n] = 0;
+    start += n;
     strcpy(split.data(),line.data());
     char* p = split.data();
     char* save;
@@ -357,9 +754,19 @@ protected:
     : name(name) {}
 public:
   virtual void read_ascii(RawArray<const char*> words, int& i) = 0;
-  virtual void read_binary_same_endian(FILE* f) = 0;
-  virtual void read_binary_flip_endian(FILE* f) = 0;
+  virtual void read_binary_same_endian(const char*& p, const char* end) = 0;
+  virtual void read_binary_flip_endian(const char*& p, const char* end) = 0;
   virtual string type() const = 0;
+
+  // Size in bytes of a binary entry, or 0 for variable sized lists
+  virtual int fixed_size() const = 0;
+
+  // Read n binary entries at p, p+stride, ..., for elements built entirely out of fixed size properties
+  virtual void read_binary_strided(const char* p, const size_t stride, const int n, const bool flip) = 0;
+
+  // An empty property of the same type, and concatenation with one, for parsing ascii pieces in parallel
+  virtual Ref<PlyProp> empty_copy(const int count) const = 0;
+  virtual void append(const PlyProp& other) = 0;
 };
 
 template<class T> static const char* ply_type_name();
@@ -394,9 +801,8 @@ PLY_TYPE_NAME(double,double)
   f(float64,double)
 
 template<class T> static inline typename enable_if<is_integral<T>,T>::type parse(const char* s) {
-  char* end;
-  const long long n = strtoll(s,&end,0);
-  if (end[0])
+  long long n;
+  if (!parse_number(s,s+strlen(s),n))
     throw IOError(format("invalid %s value %s",ply_type_name<T>(),repr(s)));
   if ((long long)(T)n != n)
     throw IOError(format("out of range %s value %s",ply_type_name<T>(),repr(s)));
@@ -404,9 +810,8 @@ template<class T> static inline typename enable_if<is_integral<T>,T>::type parse
 }
 
 template<class T> static inline typename enable_if<is_floating_point<T>,T>::type parse(const char* s) {
-  char* end;
-  const double x = strtod(s,&end);
-  if (end[0])
+  double x;
+  if (!parse_number(s,s+strlen(s),x))
     throw IOError(format("invalid %s value %s",ply_type_name<T>(),repr(s)));
   return x;
 }
@@ -426,23 +831,51 @@ protected:
     a.append_assuming_enough_space(parse<T>(words[i++]));
   }
 
-  void read_binary_same_endian(FILE* f) {
+  void read_binary_same_endian(const char*& p, const char* end) {
     T x;
-    if (fread(&x,sizeof(T),1,f) < 1)
+    if (size_t(end-p) < sizeof(T))
       throw IOError(format("incomplete element (no %s)",name));
+    memcpy(&x,p,sizeof(T));
+    p += sizeof(T);
     a.append(x);
   }
 
-  void read_binary_flip_endian(FILE* f) {
+  void read_binary_flip_endian(const char*& p, const char* end) {
     T x;
-    if (fread(&x,sizeof(T),1,f) < 1)
+    if (size_t(end-p) < sizeof(T))
       throw IOError(format("incomplete element (no %s)",name));
+    memcpy(&x,p,sizeof(T));
+    p += sizeof(T);
     a.append(flip_endian(x));
   }
 
   string type() const {
     return ply_type_name<T>();
   }
+
+  int fixed_size() const {
+    return sizeof(T);
+  }
+
+  Ref<PlyProp> empty_copy(const int count) const {
+    return new_<PlyPropSingle>(name,count);
+  }
+
+  void append(const PlyProp& other) {
+    a.extend(static_cast<const PlyPropSingle&>(other).a);
+  }
+
+  void read_binary_strided(const char* p, const size_t stride, const int n, const bool flip) {
+    const int offset = a.size();
+    a.resize(offset+n,uninit);
+    const auto b = a.slice(offset,offset+n);
+    #pragma omp parallel for
+    for (int i=0;i<n;i++) {
+      T x;
+      memcpy(&x,p+i*stride,sizeof(T));
+      b[i] = flip ? flip_endian(x) : x;
+    }
+  }
 };
 
 template<class L,class T> struct PlyPropList : public PlyProp {
@@ -469,34 +902,49 @@ protected:
     }
   }
 
-  void read_binary_same_endian(FILE* f) {
-    L n;
-    if (fread(&n,sizeof(L),1,f) < 1)
+  void read_binary_same_endian(const char*& p, const char* end) {
+    if (size_t(end-p) < sizeof(L))
       throw IOError(format("incomplete element (no %s size)",name));
+    L n;
+    memcpy(&n,p,sizeof(L));
+    p += sizeof(L);
     counts.append_assuming_enough_space(n);
-    const int offset = flat.size();
-    flat.resize(flat.size()+n);
-    if (fread(flat.data()+offset,sizeof(T),n,f) < n)
+    if (size_t(end-p) < n*sizeof(T))
       throw IOError(format("incomplete element (incomplete %s list)",name));
+    const int offset = flat.size();
+    flat.resize(flat.size()+n,uninit);
+    memcpy(flat.data()+offset,p,n*sizeof(T));
+    p += n*sizeof(T);
   }
 
-  void read_binary_flip_endian(FILE* f) {
-    L n;
-    if (fread(&n,sizeof(L),1,f) < 1)
-      throw IOError(format("incomplete element (no %s size)",name));
-    n = flip_endian(n);
-    counts.append_assuming_enough_space(n);
+  void read_binary_flip_endian(const char*& p, const char* end) {
     const int offset = flat.size();
-    flat.resize(flat.size()+n);
-    if (fread(flat.data()+offset,sizeof(T),n,f) < n)
-      throw IOError(format("incomplete element (incomplete %s list)",name));
-    for (int i=0;i<n;i++)
-      flat[offset+i] = flip_endian(flat[offset+i]);
+    read_binary_same_endian(p,end);
+    for (int i=offset;i<flat.size();i++)
+      flat[i] = flip_endian(flat[i]);
   }
 
   string type() const {
     return ply_type_name<T>();
   }
+
+  int fixed_size() const {
+    return 0;
+  }
+
+  Ref<PlyProp> empty_copy(const int count) const {
+    return new_<PlyPropList>(name,count);
+  }
+
+  void append(const PlyProp& other) {
+    const auto& o = static_cast<const PlyPropList&>(other);
+    counts.extend(o.counts);
+    flat.extend(o.flat);
+  }
+
+  void read_binary_strided(const char* p, const size_t stride, const int n, const bool flip) {
+    GEODE_FATAL_ERROR("variable sized list properties can't be read with a fixed stride");
+  }
 };
 
 struct PlyElement : public Object {
@@ -512,91 +960,101 @@ protected:
 };
 }
 
+// Parse a .ply header, advancing p past it, and return its format: 1 for ascii, 2 for binary little endian, 3 for
+// binary big endian.  Elements are appended with their (still empty) properties.
+static int read_ply_header(Line& line, const char*& p, const char* const end, vector<Ref<PlyElement>>& elements,
+                           Hashtable<string,Ref<PlyElement>>& element_names) {
+  // Read magic string
+  if (!line.read(p,end) || line.words.size()!=1 || strcmp(line.words[0],"ply")) {
+    cout << "words = "<<line.words<<endl;
+    throw IOError(format("expected magic string 'ply', got %s",repr(line)));
+  }
+
+  // Read rest of header
+  int fmt = 0;
+  for (;;) {
+    if (!line.read(p,end))
+      throw IOError("eof before end of header");
+    const auto words = line.words.raw();
+    if (!words.size() || !strcmp(words[0],"comment"))
+      continue;
+    else if (!strcmp(words[0],"format")) {
+      if (fmt)
+        throw IOError("duplicate format line");
+      if (words.size() != 3)
+        throw IOError(format("invalid format line %s",repr(line)));
+      try {
+        const double version = parse<double>(words[2]);
+        if (version != 1)
+          throw IOError("");
+      } catch (const IOError&) {
+        throw IOError(format("unsupported version %s",repr(words[2])));
+      }
+      if      (!strcmp(words[1],"ascii"))                fmt = 1;
+      else if (!strcmp(words[1],"binary_little_endian")) fmt = 2;
+      else if (!strcmp(words[1],"binary_big_endian"))    fmt = 3;
+    } else if (!strcmp(words[0],"element")) {
+      try {
+        if (words.size() != 3)
+          throw IOError("expected 'element <name> <count>'");
+        const auto E = new_<PlyElement>(words[1],parse<int>(words[2]));
+        if (!element_names.set(E->name,E))
+          throw IOError(format("duplicate element name %s",repr(E->name)));
+        elements.push_back(E);
+      } catch (const IOError& e) {
+        throw IOError(format("invalid element declaration %s: %s",repr(line),e.what()));
+      }
+    } else if (!strcmp(words[0],"property")) {
+      if (!elements.size())
+        throw IOError("property before element");
+      PlyElement& E = elements.back();
+      if (words.size() < 3)
+        throw IOError("incomplete property declaration, expected 'property [list uchar] type name'");
+      Ptr<PlyProp> prop;
+      #define SINGLE_CASE(name,T) \
+        else if (!strcmp(words[1],#name)) \
+          prop = new_<PlyPropSingle<T>>(words[2],E.count);
+      #define LIST_CASE(name,T) \
+        else if (!strcmp(words[3],#name)) \
+          prop = new_<PlyPropList<uint8_t,T>>(words[4],E.count);
+      if (!strcmp(words[1],"list")) {
+        if (words.size() != 5)
+          throw IOError("invalid list property declaration, expected 'property list uchar type name'");
+        if (strcmp(words[2],"uchar"))
+          throw IOError(format("unsupported list property declaration, only uchar sizes are supported, got %s",
+            repr(words[2])));
+        PLY_TYPE_NAMES(LIST_CASE)
+        else
+          throw IOError(format("invalid list property type %s",repr(words[3])));
+      } else {
+        if (words.size() != 3)
+          throw IOError("invalid single property declaration, expected 'property type name'");
+        PLY_TYPE_NAMES(SINGLE_CASE)
+        else
+          throw IOError(format("invalid property type %s",repr(words[1])));
+      }
+      if (!E.prop_names.set(prop->name,ref(prop)))
+        throw IOError(format("duplicate property name %s for element %s",repr(prop->name),repr(E.name)));
+      E.props.push_back(ref(prop));
+    } else if (!strcmp(words[0],"end_header"))
+      break;
+    else
+      throw IOError(format("invalid header command %s",repr(words[0])));
+  }
+  if (!fmt)
+    throw IOError("missing format declaration");
+  return fmt;
+}
+
 static Tuple<Ref<PolygonSoup>,Array<TV>> read_ply(const string& filename) {
-  File f(filename,"rb");
+  const MappedFile file(filename);
+  const char* p = file.data;
+  const char* const end = file.end();
   Line line;
   try {
-    // Read magic string
-    if (!line.read(f) || line.words.size()!=1 || strcmp(line.words[0],"ply")) {
-      cout << "words = "<<line.words<<endl;
-      throw IOError(format("expected magic string 'ply', got %s",repr(line)));
-    }
-
-    // Read rest of header
-    int fmt = 0; // 1 for ascii, 2 for binary little endian, 3 for binary big endian
     vector<Ref<PlyElement>> elements;
     Hashtable<string,Ref<PlyElement>> element_names;
-    for (;;) {
-      if (!line.read(f))
-        throw IOError("eof before end of header");
-      const auto words = line.words.raw();
-      if (!words.size() || !strcmp(words[0],"comment"))
-        continue;
-      else if (!strcmp(words[0],"format")) {
-        if (fmt)
-          throw IOError("duplicate format line");
-        if (words.size() != 3)
-          throw IOError(format("invalid format line %s",repr(line)));
-        try {
-          const double version = parse<double>(words[2]);
-          if (version != 1)
-            throw IOError("");
-        } catch (const IOError&) {
-          throw IOError(format("unsupported version %s",repr(words[2])));
-        }
-        if      (!strcmp(words[1],"ascii"))                fmt = 1;
-        else if (!strcmp(words[1],"binary_little_endian")) fmt = 2;
-        else if (!strcmp(words[1],"binary_big_endian"))    fmt = 3;
-      } else if (!strcmp(words[0],"element")) {
-        try {
-          if (words.size() != 3)
-            throw IOError("expected 'element <name> <count>'");
-          const auto E = new_<PlyElement>(words[1],parse<int>(words[2]));
-          if (!element_names.set(E->name,E))
-            throw IOError(format("duplicate element name %s",repr(E->name)));
-          elements.push_back(E);
-        } catch (const IOError& e) {
-          throw IOError(format("invalid element declaration %s: %s",repr(line),e.what()));
-        }
-      } else if (!strcmp(words[0],"property")) {
-        if (!elements.size())
-          throw IOError("property before element");
-        PlyElement& E = elements.back();
-        if (words.size() < 3)
-          throw IOError("incomplete property declaration, expected 'property [list uchar] type name'");
-        Ptr<PlyProp> prop;
-        #define SINGLE_CASE(name,T) \
-          else if (!strcmp(words[1],#name)) \
-            prop = new_<PlyPropSingle<T>>(words[2],E.count);
-        #define LIST_CASE(name,T) \
-          else if (!strcmp(words[3],#name)) \
-            prop = new_<PlyPropList<uint8_t,T>>(words[4],E.count);
-        if (!strcmp(words[1],"list")) {
-          if (words.size() != 5)
-            throw IOError("invalid list property declaration, expected 'property list uchar type name'");
-          if (strcmp(words[2],"uchar"))
-            throw IOError(format("unsupported list property declaration, only uchar sizes are supported, got %s",
-              repr(words[2])));
-          PLY_TYPE_NAMES(LIST_CASE)
-          else
-            throw IOError(format("invalid list property type %s",repr(words[3])));
-        } else {
-          if (words.size() != 3)
-            throw IOError("invalid single property declaration, expected 'property type name'");
-          PLY_TYPE_NAMES(SINGLE_CASE)
-          else
-            throw IOError(format("invalid property type %s",repr(words[1])));
-        }
-        if (!E.prop_names.set(prop->name,ref(prop)))
-          throw IOError(format("duplicate property name %s for element %s",repr(prop->name),repr(E.name)));
-        E.props.push_back(ref(prop));
-      } else if (!strcmp(words[0],"end_header"))
-        break;
-      else
-        throw IOError(format("invalid header command %s",repr(words[0])));
-    }
-    if (!fmt)
-      throw IOError("missing format declaration");
+    const int fmt = read_ply_header(line,p,end,elements,element_names);
 
     #if GEODE_ENDIAN == GEODE_LITTLE_ENDIAN
       const int native = 2;
@@ -607,41 +1065,94 @@ static Tuple<Ref<PolygonSoup>,Array<TV>> read_ply(const string& filename) {
     // Read all elements
     if (fmt == 1) {
       for (const auto& E : elements) {
+        // Split the element's lines into pieces
+        const int pieces = max(1,min(8*omp_get_max_threads(),E->count>>14)),
+                  per = (E->count+pieces-1)/pieces;
+        vector<const char*> starts;
         for (const int i : range(E->count)) {
-          if (!line.read(f))
+          if (i%per == 0)
+            starts.push_back(p);
+          if (p == end) {
+            line.lineno += i+1;
             throw IOError(format("failed to read element %s, index %d: unexpected end of file",repr(E->name),i));
-          int n = 0;
-          for (const auto& prop : E->props) {
+          }
+          const char* eol = (const char*)memchr(p,'\n',end-p);
+          p = eol ? eol+1 : end;
+        }
+        starts.push_back(p);
+
+        // Parse pieces in parallel into empty copies of the properties, remembering the first error in each
+        const int n = int(starts.size())-1;
+        vector<vector<Ref<PlyProp>>> props(n);
+        vector<int> error_index(n,-1);
+        vector<string> errors(n);
+        #pragma omp parallel for schedule(dynamic)
+        for (int k=0;k<n;k++) {
+          for (const auto& prop : E->props)
+            props[k].push_back(prop->empty_copy(per));
+          Line piece;
+          const char* q = starts[k];
+          for (int i=k*per;q<starts[k+1];i++) {
+            piece.read(q,starts[k+1]);
+            int w = 0;
             try {
-              prop->read_ascii(line.words,n);
+              for (const auto& prop : props[k]) {
+                try {
+                  prop->read_ascii(piece.words,w);
+                } catch (const IOError& e) {
+                  throw IOError(format("failed to read element %s, index %d, prop %s: %s",
+                    repr(E->name),i,repr(prop->name),e.what()));
+                }
+              }
+              if (w != piece.words.size())
+                throw IOError(format("failed to read element %s, index %d: extra fields",repr(E->name),i));
             } catch (const IOError& e) {
-              throw IOError(format("failed to read element %s, index %d, prop %s: %s",
-                repr(E->name),i,repr(prop->name),e.what()));
+              error_index[k] = i;
+              errors[k] = e.what();
+              break;
             }
           }
-          if (n != line.words.size())
-            throw IOError(format("failed to read element %s, index %d: extra fields",repr(E->name),i));
         }
+        for (const int k : range(n))
+          if (error_index[k] >= 0) {
+            line.lineno += error_index[k]+1;
+            throw IOError(errors[k]);
+          }
+        line.lineno += E->count;
+        for (const int j : range(int(E->props.size())))
+          for (const int k : range(n))
+            E->props[j]->append(props[k][j]);
       }
-    } else if (fmt == native) {
+    } else {
+      const bool flip = fmt != native;
       for (const auto& E : elements) {
-        for (const int i : range(E->count)) {
+        // Elements made entirely of fixed size properties are records with a fixed stride, which can be read
+        // straight out of the mapped file one property at a time.
+        size_t stride = 0;
+        bool fixed = true;
+        for (const auto& prop : E->props) {
+          fixed = fixed && prop->fixed_size();
+          stride += prop->fixed_size();
+        }
+        if (fixed) {
+          if (size_t(end-p)/max(stride,size_t(1)) < size_t(E->count))
+            throw IOError(format("failed to read element %s: expected %d entries of %d bytes, file ended after %d",
+              repr(E->name),E->count,stride,(end-p)/max(stride,size_t(1))));
+          size_t offset = 0;
           for (const auto& prop : E->props) {
-            try {
-              prop->read_binary_same_endian(f);
-            } catch (const IOError& e) {
-              throw IOError(format("failed to read element %s, index %d, prop %s: %s",
-                repr(E->name),i,repr(prop->name),e.what()));
-            }
+            prop->read_binary_strided(p+offset,stride,E->count,flip);
+            offset += prop->fixed_size();
           }
+          p += stride*E->count;
+          continue;
         }
-      }
-    } else { // fmt == nonnative
-      for (const auto& E : elements) {
         for (const int i : range(E->count)) {
           for (const auto& prop : E->props) {
             try {
-              prop->read_binary_flip_endian(f);
+              if (flip)
+                prop->read_binary_flip_endian(p,end);
+              else
+                prop->read_binary_same_endian(p,end);
             } catch (const IOError& e) {
               throw IOError(format("failed to read element %s, index %d, prop %s: %s",
                 repr(E->name),i,repr(prop->name),e.what()));
@@ -686,47 +1197,68 @@ static Tuple<Ref<PolygonSoup>,Array<TV>> read_ply(const string& filename) {
   }
 }
 
+// The header of a binary .ply file with float positions and int triangles.  If pad is positive, a comment of that
+// many spaces is added, so that MeshWriter can reserve room before the counts are known.
+static string ply_header(const int nvertices, const int nfaces, const int pad=0) {
+  return format("ply\n"
+                "format binary_little_endian 1.0\n"
+                "comment Binary .ply file: http://en.wikipedia.org/wiki/PLY_(file_format)\n"
+                "%s"
+                "element vertex %d\n"
+                "property float x\n"
+                "property float y\n"
+                "property float z\n"
+                "element face %d\n"
+                "property list uchar int vertex_indices\n"
+                "end_header\n",pad>0?format("comment %s\n",string(pad,' ')):"",nvertices,nfaces);
+}
+
+// Binary .ply vertices and triangles, shared with MeshWriter
+static void write_ply_vertices(FILE* f, RawArray<const TV> X) {
+  write_elements(f,X.size(),[](int){ return sizeof(Vector<float,3>); },[=](char* p, const int i) {
+    const auto y = to_little_endian(Vector<float,3>(X[i]));
+    memcpy(p,&y,sizeof(y));
+    return p+sizeof(y);
+  });
+}
+
+static void write_ply_tris(FILE* f, RawArray<const Vector<int,3>> tris) {
+  write_elements(f,tris.size(),[](int){ return 1+sizeof(Vector<int,3>); },[=](char* p, const int i) {
+    const auto t = to_little_endian(tris[i]);
+    *p++ = 3;
+    memcpy(p,&t,sizeof(t));
+    return p+sizeof(t);
+  });
+}
+
 static void write_ply_helper(File& f, const int nfaces, RawArray<const TV> X) {
-  fprintf(f,"ply\n"
-            "format binary_little_endian 1.0\n"
-            "comment Binary .ply file: http://en.wikipedia.org/wiki/PLY_(file_format)\n"
-            "element vertex %d\n"
-            "property float x\n"
-            "property float y\n"
-            "property float z\n"
-            "element face %d\n"
-            "property list uchar int vertex_indices\n"
-            "end_header\n",X.size(),nfaces);
-  for (const auto& x : X) {
-    const auto y = to_little_endian(Vector<float,3>(x));
-    fwrite(&y,sizeof(y),1,f);
-  }
+  fputs(ply_header(X.size(),nfaces).c_str(),f);
+  write_ply_vertices(f,X);
 }
 
 static void write_ply(const string& filename, RawArray<const Vector<int,3>> tris, RawArray<const TV> X) {
   File f(filename,"wb");
   write_ply_helper(f,tris.size(),X);
-  for (const Vector<int,3>& t : tris) {
-    const uint8_t n = 3;
-    fwrite(&n,1,1,f);
-    fwrite(&to_little_endian(t),sizeof(t),1,f);
-  }
+  write_ply_tris(f,tris);
 }
 
 static void write_ply(const string& filename, const PolygonSoup& soup, RawArray<const TV> X) {
+  for (const int c : soup.counts)
+    if (uint8_t(c)!=c)
+      throw IOError(format("write_ply: can't write face with %d > 255 vertices",c));
   File f(filename,"wb");
   write_ply_helper(f,soup.counts.size(),X);
-  int offset = 0;
-  for (const int c : soup.counts) {
-    const uint8_t cb(c);
-    if (int(c)!=c)
-      throw IOError(format("write_ply: can't write face with %d > 255 vertices",c));
-    fwrite(&cb,1,1,f);
-    for (int i=0;i<c;i++) {
-      const int v = to_little_endian(soup.vertices[offset++]);
-      fwrite(&v,sizeof(v),1,f);
+  const auto offsets = polygon_offsets(soup);
+  const auto& vertices = soup.vertices;
+  write_elements(f,soup.counts.size(),[&](const int i) { return 1+4*soup.counts[i]; },[&](char* p, const int i) {
+    *p++ = char(soup.counts[i]);
+    for (const int v : vertices.slice(offsets[i],offsets[i+1])) {
+      const int w = to_little_endian(v);
+      memcpy(p,&w,sizeof(w));
+      p += sizeof(w);
     }
-  }
+    return p;
+  });
 }
 
 static void write_x3d_helper(const string& filename, const function<void(File&)>& write_topology, RawArray<const TV> X) {
@@ -745,11 +1277,14 @@ static void write_x3d_helper(const string& filename, const function<void(File&)>
   write_topology(f);
   fputs("\" solid=\"false\">\n"
         "    <Coordinate point=\"",f);
-  const auto flat = scalar_view(X);
-  if (flat.size())
-    fprintf(f,"%g",flat[0]);
-  for (int i=1;i<flat.size();i++)
-    fprintf(f," %g",flat[i]);
+  write_elements(f,X.size(),[](int){ return 3*(1+double_size); },[=](char* p, const int i) {
+    for (const int a : range(3)) {
+      if (i || a)
+        *p++ = ' ';
+      p = format_double(p,X[i][a]);
+    }
+    return p;
+  });
   fputs("\"/>\n"
         "   </IndexedFaceSet>\n"
         "  </Shape>\n"
@@ -759,26 +1294,41 @@ static void write_x3d_helper(const string& filename, const function<void(File&)>
 
 static void write_x3d(const string& filename, RawArray<const Vector<int,3>> tris, RawArray<const TV> X) {
   write_x3d_helper(filename,[=](File& f){
-    bool first = true;
-    for (const auto& t : tris) {
-      if (!first)
-        fputc(' ',f);
-      first = false;
-      fprintf(f,"%d %d %d -1",t.x,t.y,t.z);
-    }
+    write_elements(f,tris.size(),[](int){ return 4+3*(1+int_size); },[=](char* p, const int i) {
+      if (i)
+        *p++ = ' ';
+      for (const int v : tris[i]) {
+        p = format_int(p,v);
+        *p++ = ' ';
+      }
+      *p++ = '-';
+      *p++ = '1';
+      return p;
+    });
   },X);
 }
 static void write_x3d(const string& filename, const PolygonSoup& soup, RawArray<const TV> X) {
+  const auto offsets = polygon_offsets(soup);
   write_x3d_helper(filename,[&](File& f){
-    int offset = 0;
-    for (const int c : soup.counts) {
-      for (int i=0;i<c;i++)
-        fprintf(f,"%d ",soup.vertices[offset++]);
-      fputs(offset==soup.vertices.size() ? "-1" : "-1 ",f);
-    }
+    const auto& vertices = soup.vertices;
+    write_elements(f,soup.counts.size(),[&](const int i) { return 3+soup.counts[i]*(1+int_size); },
+                   [&](char* p, const int i) {
+      if (i)
+        *p++ = ' ';
+      for (const int v : vertices.slice(offsets[i],offsets[i+1])) {
+        p = format_int(p,v);
+        *p++ = ' ';
+      }
+      *p++ = '-';
+      *p++ = '1';
+      return p;
+    });
   },X);
 }
 
+static Tuple<Ref<TriangleSoup>,Array<TV>> read_gmz(const string& filename);
+static void write_gmz(const string& filename, RawArray<const Vector<int,3>> tris, RawArray<const TV> X);
+
 static Tuple<Ref<TriangleSoup>,Array<TV>> convert(const Tuple<Ref<PolygonSoup>,Array<TV>>& d) {
   return tuple(d.x->triangle_mesh(),d.y);
 }
@@ -792,8 +1342,9 @@ Tuple<Ref<TriangleSoup>,Array<TV>> read_soup(const string& filename) {
   if      (ext == ".stl") return         read_stl(filename);
   else if (ext == ".obj") return convert(read_obj(filename));
   else if (ext == ".ply") return convert(read_ply(filename));
+  else if (ext == ".gmz") return         read_gmz(filename);
   else
-    throw ValueError(format("unsupported mesh filename '%s', expected one of .stl, .obj, .ply",filename));
+    throw ValueError(format("unsupported mesh filename '%s', expected one of .stl, .obj, .ply, .gmz",filename));
 }
 
 Tuple<Ref<PolygonSoup>,Array<TV>> read_polygon_soup(const string& filename) {
@@ -801,8 +1352,9 @@ Tuple<Ref<PolygonSoup>,Array<TV>> read_polygon_soup(const string& filename) {
   if      (ext == ".stl") return convert(read_stl(filename));
   else if (ext == ".obj") return         read_obj(filename);
   else if (ext == ".ply") return         read_ply(filename);
+  else if (ext == ".gmz") return convert(read_gmz(filename));
   else
-    throw ValueError(format("unsupported mesh filename '%s', expected one of .stl, .obj, .ply",filename));
+    throw ValueError(format("unsupported mesh filename '%s', expected one of .stl, .obj, .ply, .gmz",filename));
 }
 
 Tuple<Ref<TriangleTopology>,Array<TV>> read_mesh(const string& filename) {
@@ -816,8 +1368,10 @@ static void write_helper(const string& filename, RawArray<const Vector<int,3>> t
   else if (ext == ".obj") write_obj(filename,tris,X);
   else if (ext == ".ply") write_ply(filename,tris,X);
   else if (ext == ".x3d") write_x3d(filename,tris,X);
+  else if (ext == ".gmz") write_gmz(filename,tris,X);
   else
-    throw ValueError(format("unsupported mesh filename '%s', expected one of .stl, .obj, .ply, .x3d",filename));
+    throw ValueError(format("unsupported mesh filename '%s', expected one of .stl, .obj, .ply, .x3d, .gmz",
+      filename));
 }
 
 void write_mesh(const string& filename, const TriangleSoup& soup, RawArray<const TV> X) {
@@ -845,6 +1399,858 @@ void write_mesh(const string& filename, const MutableTriangleTopology& mesh) {
   write_helper(filename,mesh.elements(),mesh.field(pos_id).flat);
 }
 
+// Native mesh files start with a header, followed by a table of sections, followed by the section data
+static const char native_magic[8] = {'g','e','o','d','e','m','s','h'};
+static const uint32_t native_version = 1;
+static const uint32_t native_endian = 0x01020304;
+static const size_t native_alignment = 64;
+
+namespace {
+struct NativeHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t endian; // native_endian in the byte order of the writer
+  int32_t n_vertices, n_faces, n_boundary_edges;
+  int32_t erased_boundaries;
+  int32_t next_field_id;
+  int32_t sections;
+};
+
+enum NativeKind { NativeFaces, NativeVertexToEdge, NativeBoundaries, NativeVertexField, NativeFaceField,
+                  NativeHalfedgeField };
+
+struct NativeSection {
+  int32_t kind; // NativeKind
+  int32_t id; // Field id
+  int32_t t_size; // Bytes per element
+  int32_t size; // Number of elements
+  uint64_t offset; // Start of data, from the start of the file and native_alignment aligned
+  char type[104]; // Mangled field type name, null terminated
+};
+static_assert(sizeof(NativeSection)==128,"");
+}
+
+// Field types by mangled name
+static Hashtable<string,const type_info*> builtin_native_field_types() {
+  Hashtable<string,const type_info*> types;
+  #define SCALAR(T) \
+    types.set(typeid(T).name(),&typeid(T)); \
+    types.set(typeid(Vector<T,2>).name(),&typeid(Vector<T,2>)); \
+    types.set(typeid(Vector<T,3>).name(),&typeid(Vector<T,3>)); \
+    types.set(typeid(Vector<T,4>).name(),&typeid(Vector<T,4>));
+  SCALAR(bool) SCALAR(char) SCALAR(unsigned char) SCALAR(short) SCALAR(unsigned short)
+  SCALAR(int) SCALAR(unsigned int) SCALAR(long) SCALAR(unsigned long) SCALAR(long long)
+  SCALAR(unsigned long long) SCALAR(float) SCALAR(double)
+  SCALAR(VertexId) SCALAR(FaceId) SCALAR(HalfedgeId)
+  #undef SCALAR
+  types.set(typeid(Quadric).name(),&typeid(Quadric));
+  return types;
+}
+
+static Hashtable<string,const type_info*>& native_field_types() {
+  static Hashtable<string,const type_info*> types = builtin_native_field_types();
+  return types;
+}
+
+void register_native_field_type(const type_info& type) {
+  native_field_types().set(type.name(),&type);
+}
+
+struct NativeMeshIO {
+  static void write(const string& filename, const MutableTriangleTopology& mesh) {
+    // Collect sections
+    vector<NativeSection> sections;
+    vector<const char*> data;
+    const auto add = [&](const NativeKind kind, const int id, const int t_size, const int size, const char* p,
+                         const char* type) {
+      NativeSection s;
+      memset(&s,0,sizeof(s));
+      s.kind = kind;
+      s.id = id;
+      s.t_size = t_size;
+      s.size = size;
+      if (strlen(type) >= sizeof(s.type))
+        throw ValueError(format("write_native_mesh: field type name %s is too long",repr(type)));
+      strcpy(s.type,type);
+      sections.push_back(s);
+      data.push_back(p);
+    };
+    typedef MutableTriangleTopology::FaceInfo FaceInfo;
+    typedef MutableTriangleTopology::BoundaryInfo BoundaryInfo;
+    add(NativeFaces,0,sizeof(FaceInfo),mesh.faces_.size(),(const char*)mesh.faces_.flat.data(),"");
+    add(NativeVertexToEdge,0,sizeof(HalfedgeId),mesh.vertex_to_edge_.size(),
+        (const char*)mesh.vertex_to_edge_.flat.data(),"");
+    add(NativeBoundaries,0,sizeof(BoundaryInfo),mesh.boundaries_.size(),(const char*)mesh.boundaries_.data(),"");
+    const auto add_fields = [&](const NativeKind kind, const Hashtable<int,int>& ids,
+                                const vector<UntypedArray>& fields) {
+      for (const auto& id : ids) {
+        const auto& f = fields[id.y];
+        add(kind,id.x,f.t_size(),f.size(),f.data(),f.type().name());
+      }
+    };
+    add_fields(NativeVertexField,mesh.id_to_vertex_field,mesh.vertex_fields);
+    add_fields(NativeFaceField,mesh.id_to_face_field,mesh.face_fields);
+    add_fields(NativeHalfedgeField,mesh.id_to_halfedge_field,mesh.halfedge_fields);
+
+    // Lay out data
+    const auto align = [](const uint64_t n) { return (n+native_alignment-1)/native_alignment*native_alignment; };
+    uint64_t offset = align(sizeof(NativeHeader)+sections.size()*sizeof(NativeSection));
+    for (auto& s : sections) {
+      s.offset = offset;
+      offset = align(offset+uint64_t(s.t_size)*s.size);
+    }
+
+    // Write
+    NativeHeader h;
+    memset(&h,0,sizeof(h));
+    memcpy(h.magic,native_magic,sizeof(h.magic));
+    h.version = native_version;
+    h.endian = native_endian;
+    h.n_vertices = mesh.n_vertices();
+    h.n_faces = mesh.n_faces();
+    h.n_boundary_edges = mesh.n_boundary_edges();
+    h.erased_boundaries = mesh.erased_boundaries_.id;
+    h.next_field_id = mesh.next_field_id;
+    h.sections = int(sections.size());
+    File f(filename,"wb");
+    const auto put = [&](const void* p, const size_t n) {
+      if (fwrite(p,1,n,f) < n)
+        throw IOError(format("write_native_mesh: failed to write '%s': %s",filename,strerror(errno)));
+    };
+    put(&h,sizeof(h));
+    put(sections.data(),sections.size()*sizeof(NativeSection));
+    uint64_t written = sizeof(h)+sections.size()*sizeof(NativeSection);
+    static const char zeros[native_alignment] = {0};
+    for (const int i : range(int(sections.size()))) {
+      const auto& s = sections[i];
+      put(zeros,s.offset-written);
+      put(data[i],size_t(s.t_size)*s.size);
+      written = s.offset+uint64_t(s.t_size)*s.size;
+    }
+    put(zeros,offset-written);
+  }
+
+  static Ref<MutableTriangleTopology> read(const string& filename) {
+    const auto buffer = map_file(filename,true);
+    const auto& file = buffer->file;
+    const auto fail = [&](const string& error) {
+      return IOError(format("invalid native mesh file '%s': %s",filename,error));
+    };
+
+    // Check header
+    NativeHeader h;
+    if (file.size < sizeof(h))
+      throw fail("incomplete header");
+    memcpy(&h,file.data,sizeof(h));
+    if (memcmp(h.magic,native_magic,sizeof(h.magic)))
+      throw fail("bad magic string");
+    if (h.version != native_version)
+      throw fail(format("unsupported version %u, expected %u",h.version,native_version));
+    if (h.endian != native_endian)
+      throw fail("written with a different byte order");
+    if (h.sections < 3 || (file.size-sizeof(h))/sizeof(NativeSection) < size_t(h.sections))
+      throw fail("incomplete section table");
+    const auto sections = (const NativeSection*)(file.data+sizeof(h));
+
+    // Point arrays directly at the mapping
+    typedef MutableTriangleTopology::FaceInfo FaceInfo;
+    typedef MutableTriangleTopology::BoundaryInfo BoundaryInfo;
+    const auto mesh = new_<MutableTriangleTopology>();
+    const auto owner = buffer.borrow_owner();
+    const auto section = [&](const int i) {
+      const auto& s = sections[i];
+      if (s.size < 0 || s.t_size <= 0 || s.offset%native_alignment
+          || s.offset > file.size || (file.size-s.offset)/s.t_size < size_t(s.size))
+        throw fail(format("section %d is out of bounds",i));
+      return (char*)(file.data+s.offset);
+    };
+    const auto expect = [&](const int i, const NativeKind kind, const int t_size) {
+      if (sections[i].kind != kind || sections[i].t_size != t_size)
+        throw fail(format("section %d has unexpected kind %d or element size %d",i,sections[i].kind,
+          sections[i].t_size));
+      return section(i);
+    };
+    const int nf = sections[NativeFaces].size,
+              nv = sections[NativeVertexToEdge].size;
+    mesh->mutable_faces_ = Field<FaceInfo,FaceId>(Array<FaceInfo>(nf,
+      (FaceInfo*)expect(NativeFaces,NativeFaces,sizeof(FaceInfo)),owner));
+    mesh->mutable_vertex_to_edge_ = Field<HalfedgeId,VertexId>(Array<HalfedgeId>(nv,
+      (HalfedgeId*)expect(NativeVertexToEdge,NativeVertexToEdge,sizeof(HalfedgeId)),owner));
+    mesh->mutable_boundaries_ = Array<BoundaryInfo>(sections[NativeBoundaries].size,
+      (BoundaryInfo*)expect(NativeBoundaries,NativeBoundaries,sizeof(BoundaryInfo)),owner);
+    mesh->mutable_n_vertices_ = h.n_vertices;
+    mesh->mutable_n_faces_ = h.n_faces;
+    mesh->mutable_n_boundary_edges_ = h.n_boundary_edges;
+    mesh->mutable_erased_boundaries_ = HalfedgeId(h.erased_boundaries);
+    if (!(0<=h.n_vertices && h.n_vertices<=nv && 0<=h.n_faces && h.n_faces<=nf
+          && 0<=h.n_boundary_edges && h.n_boundary_edges<=mesh->boundaries_.size()))
+      throw fail("inconsistent counts");
+
+    // Attach fields
+    const auto& types = native_field_types();
+    for (const int i : range(3,h.sections)) {
+      const auto& s = sections[i];
+      if (!memchr(s.type,0,sizeof(s.type)))
+        throw fail(format("section %d has an unterminated type name",i));
+      const auto type = types.get_default(s.type,0);
+      if (!type)
+        throw fail(format("unknown field type %s (see register_native_field_type)",s.type));
+      const bool vertex = s.kind==NativeVertexField,
+                 face = s.kind==NativeFaceField,
+                 halfedge = s.kind==NativeHalfedgeField;
+      if (!(vertex || face || halfedge) || s.size != (vertex ? nv : face ? nf : 3*nf))
+        throw fail(format("field section %d has unexpected kind %d or size %d",i,s.kind,s.size));
+      auto& ids = vertex ? mesh->id_to_vertex_field : face ? mesh->id_to_face_field : mesh->id_to_halfedge_field;
+      auto& fields = vertex ? mesh->vertex_fields : face ? mesh->face_fields : mesh->halfedge_fields;
+      if (!ids.set(s.id,int(fields.size())))
+        throw fail(format("duplicate field id %d",s.id));
+      fields.push_back(UntypedArray(type,s.t_size,s.size,section(i),owner));
+    }
+    mesh->next_field_id = h.next_field_id;
+    return mesh;
+  }
+};
+
+void write_native_mesh(const string& filename, const MutableTriangleTopology& mesh) {
+  NativeMeshIO::write(filename,mesh);
+}
+
+Ref<MutableTriangleTopology> read_native_mesh(const string& filename) {
+  return NativeMeshIO::read(filename);
+}
+
+// Compressed meshes start with a header, followed by the connectivity and position streams.  Each stream is a
+// sequence of varints, order 0 entropy coded with rANS (see Duda, "Asymmetric numeral systems", and Giesen's
+// byte oriented variant).
+static const char compressed_magic[8] = {'g','e','o','d','e','m','z','1'};
+static const int rans_scale_bits = 12;
+static const uint32_t rans_low = 1u<<23;
+
+namespace {
+struct CompressedHeader {
+  char magic[8];
+  int32_t n_vertices, n_faces;
+  int32_t bits;
+  int32_t pad;
+  double lower[3]; // Grid origin
+  double scale; // Grid steps per unit length
+};
+
+struct RansStream {
+  uint64_t raw_size, coded_size;
+  uint16_t freqs[256];
+};
+}
+
+static void put_varint(vector<uint8_t>& out, uint64_t n) {
+  while (n >= 0x80) {
+    out.push_back(uint8_t(n|0x80));
+    n >>= 7;
+  }
+  out.push_back(uint8_t(n));
+}
+
+static uint64_t zigzag(const int64_t n) {
+  return (uint64_t(n)<<1)^uint64_t(n>>63);
+}
+
+static int64_t unzigzag(const uint64_t n) {
+  return int64_t(n>>1)^-int64_t(n&1);
+}
+
+// Entropy code bytes, appending the stream description and data to out
+static void rans_encode(vector<uint8_t>& out, const vector<uint8_t>& raw) {
+  // Normalize frequencies to sum to 1<<rans_scale_bits, keeping every occurring byte nonzero
+  const uint32_t total = 1u<<rans_scale_bits;
+  uint64_t counts[256] = {0};
+  for (const auto c : raw)
+    counts[c]++;
+  RansStream s;
+  memset(&s,0,sizeof(s));
+  s.raw_size = raw.size();
+  if (raw.size()) {
+    int64_t sum = 0;
+    for (const int c : range(256)) {
+      if (counts[c])
+        s.freqs[c] = uint16_t(max(uint64_t(1),counts[c]*total/raw.size()));
+      sum += s.freqs[c];
+    }
+    while (sum != total) {
+      int best = 0;
+      for (const int c : range(1,256))
+        if (s.freqs[c] > s.freqs[best])
+          best = c;
+      if (sum > total) {
+        const int64_t d = min(sum-int64_t(total),int64_t(s.freqs[best]-1));
+        s.freqs[best] -= uint16_t(d);
+        sum -= d;
+      } else {
+        s.freqs[best] += uint16_t(total-sum);
+        sum = total;
+      }
+    }
+  }
+  uint32_t starts[256];
+  for (uint32_t c=0,start=0;c<256;c++) {
+    starts[c] = start;
+    start += s.freqs[c];
+  }
+
+  // Encode backwards, so that decoding runs forwards.  Each byte emits at most two bytes of output.
+  vector<uint8_t> coded(2*raw.size()+4);
+  uint8_t* p = coded.data()+coded.size();
+  uint32_t x = rans_low;
+  for (size_t i=raw.size();i--;) {
+    const uint32_t f = s.freqs[raw[i]];
+    const uint32_t x_max = ((rans_low>>rans_scale_bits)<<8)*f;
+    while (x >= x_max) {
+      *--p = uint8_t(x);
+      x >>= 8;
+    }
+    x = ((x/f)<<rans_scale_bits)+x%f+starts[raw[i]];
+  }
+  for (int i=0;i<4;i++) {
+    *--p = uint8_t(x);
+    x >>= 8;
+  }
+  s.coded_size = coded.data()+coded.size()-p;
+  const auto sp = (const uint8_t*)&s;
+  out.insert(out.end(),sp,sp+sizeof(s));
+  out.insert(out.end(),p,coded.data()+coded.size());
+}
+
+namespace {
+// Decodes a rANS stream one byte at a time, throwing on truncated or corrupt input
+struct RansDecoder {
+  const uint8_t* p;
+  const uint8_t* end;
+  uint64_t remaining;
+  uint32_t x;
+  uint16_t freqs[256], starts[256];
+  uint8_t symbols[1<<rans_scale_bits];
+
+  RansDecoder(const uint8_t*& data, const uint8_t* const data_end) {
+    RansStream s;
+    if (size_t(data_end-data) < sizeof(s))
+      throw IOError("decompress_mesh: truncated stream header");
+    memcpy(&s,data,sizeof(s));
+    data += sizeof(s);
+    if (s.coded_size < 4 || s.coded_size > uint64_t(data_end-data))
+      throw IOError("decompress_mesh: truncated stream");
+    uint32_t start = 0;
+    for (const int c : range(256)) {
+      freqs[c] = s.freqs[c];
+      starts[c] = uint16_t(start);
+      if (start+freqs[c] > (1u<<rans_scale_bits))
+        throw IOError("decompress_mesh: invalid frequency table");
+      memset(symbols+start,c,freqs[c]);
+      start += freqs[c];
+    }
+    if (s.raw_size && start != (1u<<rans_scale_bits))
+      throw IOError("decompress_mesh: invalid frequency table");
+    p = data;
+    end = data+s.coded_size;
+    data = end;
+    remaining = s.raw_size;
+    x = uint32_t(p[0])<<24|uint32_t(p[1])<<16|uint32_t(p[2])<<8|p[3];
+    p += 4;
+  }
+
+  uint8_t byte() {
+    if (!remaining--)
+      throw IOError("decompress_mesh: stream ended early");
+    const uint32_t slot = x&((1u<<rans_scale_bits)-1);
+    const uint8_t c = symbols[slot];
+    x = freqs[c]*(x>>rans_scale_bits)+slot-starts[c];
+    while (x < rans_low) {
+      if (p == end)
+        throw IOError("decompress_mesh: truncated stream");
+      x = x<<8|*p++;
+    }
+    return c;
+  }
+
+  uint64_t varint() {
+    uint64_t n = 0;
+    for (int shift=0;shift<64;shift+=7) {
+      const uint8_t c = byte();
+      n |= uint64_t(c&0x7f)<<shift;
+      if (!(c&0x80))
+        return n;
+    }
+    throw IOError("decompress_mesh: invalid varint");
+  }
+};
+
+// Predicts positions for new vertices from their first triangle, identically in the encoder and decoder.  With two
+// known corners, we use the parallelogram rule across the edge between them if the neighboring triangle on the
+// other side has already been seen, or the edge midpoint otherwise.
+struct PositionPredictor {
+  typedef Vector<int64_t,3> QV;
+
+  // Directed edges of the triangles seen so far, as a linked list of (end, opposite vertex, next) per start vertex.
+  // Valences are small, so walking these lists is much faster than hashing.
+  Array<int> head;
+  Array<Vector<int,3>> edges;
+  QV last;
+
+  PositionPredictor(const int nv, const int nf)
+    : head(nv,uninit), last() {
+    head.fill(-1);
+    edges.preallocate(3*nf);
+  }
+
+  QV predict(RawArray<const QV> Q, const Vector<int,3>& t, const int i, const int next) const {
+    const int a = t[(i+1)%3], b = t[(i+2)%3];
+    const bool ka = a<next, kb = b<next;
+    if (ka && kb) {
+      for (int e=head[b];e>=0;e=edges[e].z)
+        if (edges[e].x == a)
+          return Q[a]+Q[b]-Q[edges[e].y];
+      return (Q[a]+Q[b])/2;
+    }
+    return ka ? Q[a] : kb ? Q[b] : last;
+  }
+
+  void add(const Vector<int,3>& t) {
+    for (int i=0;i<3;i++) {
+      const int v = t[i];
+      edges.append_assuming_enough_space(vec(t[(i+1)%3],t[(i+2)%3],head[v]));
+      head[v] = edges.size()-1;
+    }
+  }
+};
+}
+
+Array<uint8_t> compress_mesh(const TriangleSoup& soup, RawArray<const TV> X, const int bits) {
+  GEODE_ASSERT(X.size()>=soup.nodes());
+  if (!(1<=bits && bits<=30))
+    throw ValueError(format("compress_mesh: expected 1 <= bits <= 30, got %d",bits));
+  const int nv = X.size(),
+            nf = soup.elements.size();
+
+  // Order triangles breadth first through shared edges, and vertices by first appearance
+  const auto adjacent = soup.adjacent_elements();
+  Array<int> faces;
+  faces.preallocate(nf);
+  Array<bool> seen(nf);
+  for (const int s : range(nf)) {
+    if (seen[s])
+      continue;
+    seen[s] = true;
+    faces.append(s);
+    for (int i=faces.size()-1;i<faces.size();i++)
+      for (const int f : adjacent[faces[i]])
+        if (f>=0 && !seen[f]) {
+          seen[f] = true;
+          faces.append(f);
+        }
+  }
+  Array<int> new_vertex(nv,uninit), old_vertex;
+  new_vertex.fill(-1);
+  old_vertex.preallocate(nv);
+  Array<Vector<int,3>> tris(nf,uninit);
+  for (const int i : range(nf)) {
+    const auto& t = soup.elements[faces[i]];
+    for (int j=0;j<3;j++) {
+      if (new_vertex[t[j]] < 0) {
+        new_vertex[t[j]] = old_vertex.size();
+        old_vertex.append(t[j]);
+      }
+      tris[i][j] = new_vertex[t[j]];
+    }
+  }
+  for (const int v : range(nv))
+    if (new_vertex[v] < 0) {
+      new_vertex[v] = old_vertex.size();
+      old_vertex.append(v);
+    }
+
+  // Quantize
+  CompressedHeader h;
+  memset(&h,0,sizeof(h));
+  memcpy(h.magic,compressed_magic,sizeof(h.magic));
+  h.n_vertices = nv;
+  h.n_faces = nf;
+  h.bits = bits;
+  const auto box = bounding_box(X);
+  const TV lower = nv ? box.min : TV();
+  for (int a=0;a<3;a++)
+    h.lower[a] = lower[a];
+  h.scale = ((int64_t(1)<<bits)-1)/max(nv ? box.sizes().max() : T(0),T(1e-30));
+  typedef PositionPredictor::QV QV;
+  Array<QV> Q(nv,uninit);
+  for (const int v : range(nv))
+    Q[v] = QV(floor(h.scale*(X[old_vertex[v]]-lower)+T(.5)));
+
+  // Delta code connectivity: 0 for a new vertex, otherwise the distance back from the next new vertex.  Residuals
+  // from the position predictor are coded in the order vertices appear.
+  vector<uint8_t> connectivity, positions;
+  PositionPredictor predictor(nv,nf);
+  int next = 0;
+  const auto put_position = [&](const QV& pred) {
+    for (int a=0;a<3;a++)
+      put_varint(positions,zigzag(Q[next][a]-pred[a]));
+    predictor.last = Q[next++];
+  };
+  for (const auto& t : tris) {
+    int n = next;
+    for (int i=0;i<3;i++) {
+      if (t[i] == n) {
+        put_varint(connectivity,0);
+        n++;
+      } else
+        put_varint(connectivity,n-t[i]);
+    }
+    for (int i=0;i<3;i++)
+      if (t[i] == next)
+        put_position(predictor.predict(Q,t,i,next));
+    predictor.add(t);
+  }
+  while (next < nv)
+    put_position(predictor.last);
+
+  // Entropy code
+  vector<uint8_t> out;
+  const auto hp = (const uint8_t*)&h;
+  out.insert(out.end(),hp,hp+sizeof(h));
+  rans_encode(out,connectivity);
+  rans_encode(out,positions);
+  Array<uint8_t> result(int(out.size()),uninit);
+  memcpy(result.data(),out.data(),out.size());
+  return result;
+}
+
+Tuple<Ref<TriangleSoup>,Array<TV>> decompress_mesh(RawArray<const uint8_t> data) {
+  CompressedHeader h;
+  if (size_t(data.size()) < sizeof(h))
+    throw IOError("decompress_mesh: truncated header");
+  memcpy(&h,data.data(),sizeof(h));
+  if (memcmp(h.magic,compressed_magic,sizeof(h.magic)))
+    throw IOError("decompress_mesh: bad magic string");
+  if (h.n_vertices < 0 || h.n_faces < 0 || !(1<=h.bits && h.bits<=30))
+    throw IOError("decompress_mesh: invalid header");
+  const int nv = h.n_vertices,
+            nf = h.n_faces;
+  const uint8_t* p = data.data()+sizeof(h);
+  RansDecoder connectivity(p,data.data()+data.size());
+  RansDecoder positions(p,data.data()+data.size());
+
+  typedef PositionPredictor::QV QV;
+  Array<Vector<int,3>> tris(nf,uninit);
+  Array<QV> Q(nv,uninit);
+  PositionPredictor predictor(nv,nf);
+  int next = 0;
+  const auto get_position = [&](const QV& pred) {
+    if (next == nv)
+      throw IOError("decompress_mesh: too many vertices");
+    for (int a=0;a<3;a++)
+      Q[next][a] = pred[a]+unzigzag(positions.varint());
+    predictor.last = Q[next++];
+  };
+  for (auto& t : tris) {
+    int n = next;
+    for (int i=0;i<3;i++) {
+      const uint64_t d = connectivity.varint();
+      if (d > uint64_t(n))
+        throw IOError("decompress_mesh: invalid vertex delta");
+      t[i] = d ? n-int(d) : n++;
+    }
+    for (int i=0;i<3;i++)
+      if (t[i] == next)
+        get_position(predictor.predict(Q,t,i,next));
+    predictor.add(t);
+  }
+  while (next < nv)
+    get_position(predictor.last);
+
+  Array<TV> X(nv,uninit);
+  const TV lower(h.lower[0],h.lower[1],h.lower[2]);
+  const T inv_scale = 1/h.scale;
+  for (const int v : range(nv))
+    X[v] = lower+inv_scale*TV(Q[v]);
+  return tuple(new_<TriangleSoup>(tris,nv),X);
+}
+
+static void write_gmz(const string& filename, RawArray<const Vector<int,3>> tris, RawArray<const TV> X) {
+  const auto data = compress_mesh(new_<TriangleSoup>(tris.copy(),X.size()),X,16);
+  File f(filename,"wb");
+  if (fwrite(data.data(),1,data.size(),f) < size_t(data.size()))
+    throw IOError(format("write_mesh: failed to write '%s': %s",filename,strerror(errno)));
+}
+
+static Tuple<Ref<TriangleSoup>,Array<TV>> read_gmz(const string& filename) {
+  const MappedFile file(filename);
+  return decompress_mesh(RawArray<const uint8_t>(int(file.size),(const uint8_t*)file.data));
+}
+
+GEODE_DEFINE_TYPE(MeshWriter)
+
+// Counts up to 2^31 have at most 10 digits, so this much padding is enough for any final .ply header
+static const int ply_pad = 2*10;
+
+MeshWriter::MeshWriter(const string& filename)
+  : filename(filename)
+  , file(0)
+  , spill(0)
+  , header_size(0)
+  , n_vertices_(0)
+  , n_faces_(0)
+  , closed_(false) {
+  const auto ext = path::extension(filename);
+  if      (ext == ".stl") kind = Stl;
+  else if (ext == ".ply") kind = Ply;
+  else if (ext == ".mesh") kind = Native;
+  else
+    throw ValueError(format("MeshWriter: unsupported mesh filename '%s', expected one of .stl, .ply, .mesh",
+      filename));
+  const auto open = [&](const string& name) {
+    FILE* f = fopen(name.c_str(),"wb");
+    if (!f)
+      throw IOError(format("MeshWriter: can't open '%s' for writing: %s",name,strerror(errno)));
+    return f;
+  };
+  if (kind == Stl) {
+    file = open(filename);
+    write_stl_header(file,0);
+  } else if (kind == Ply) {
+    spill = tmpfile();
+    if (!spill)
+      throw IOError(format("MeshWriter: can't create temporary file for '%s': %s",filename,strerror(errno)));
+    try {
+      file = open(filename);
+    } catch (...) {
+      fclose(spill);
+      throw;
+    }
+    const auto header = ply_header(0,0,ply_pad);
+    header_size = long(header.size());
+    fputs(header.c_str(),file);
+  } else {
+    mesh = new_<MutableTriangleTopology>();
+    mesh->add_vertex_field<TV>(vertex_position_id);
+  }
+}
+
+MeshWriter::~MeshWriter() {
+  if (!closed_) {
+    try {
+      close();
+    } catch (...) {}
+  }
+}
+
+int MeshWriter::add_vertices(RawArray<const TV> X) {
+  GEODE_ASSERT(!closed_,format("MeshWriter: '%s' is already closed",filename));
+  const int first = n_vertices_;
+  if (kind == Stl)
+    this->X.extend(X);
+  else if (kind == Ply)
+    write_ply_vertices(file,X);
+  else {
+    const auto v = mesh->add_vertices(X.size());
+    mesh->field(FieldId<TV,VertexId>(vertex_position_id)).flat.slice(v.id,v.id+X.size()) = X;
+  }
+  n_vertices_ += X.size();
+  return first;
+}
+
+void MeshWriter::add_faces(RawArray<const Vector<int,3>> tris) {
+  GEODE_ASSERT(!closed_,format("MeshWriter: '%s' is already closed",filename));
+  for (const auto& t : tris)
+    if (!(0<=t.min() && t.max()<n_vertices_))
+      throw ValueError(format("MeshWriter: face %s refers to a vertex not yet added (%d so far)",
+        str(t),n_vertices_));
+  if (kind == Stl)
+    write_stl_tris(file,tris,X);
+  else if (kind == Ply)
+    write_ply_tris(spill,tris);
+  else
+    mesh->add_faces(tris);
+  n_faces_ += tris.size();
+}
+
+void MeshWriter::close() {
+  if (closed_)
+    return;
+  closed_ = true;
+  if (kind == Native) {
+    write_native_mesh(filename,*mesh);
+    mesh.clear();
+    return;
+  }
+
+  // Patch the header, and append spilled faces
+  bool failed = false;
+  if (kind == Stl) {
+    failed |= fseek(file,80,SEEK_SET)!=0;
+    failed |= fwrite(&to_little_endian(uint32_t(n_faces_)),4,1,file)!=1;
+  } else {
+    const auto header = ply_header(n_vertices_,n_faces_,int(header_size-ply_header(n_vertices_,n_faces_).size())
+                                                        -int(strlen("comment \n")));
+    GEODE_ASSERT(long(header.size())==header_size);
+    failed |= fseek(file,0,SEEK_SET)!=0;
+    failed |= fputs(header.c_str(),file)<0;
+    failed |= fseek(file,0,SEEK_END)!=0;
+    rewind(spill);
+    char buffer[1<<16];
+    while (const size_t n = fread(buffer,1,sizeof(buffer),spill))
+      failed |= fwrite(buffer,1,n,file)!=n;
+    failed |= ferror(spill)!=0;
+    fclose(spill);
+    spill = 0;
+  }
+  X.clean_memory();
+  failed |= ferror(file)!=0;
+  failed |= fclose(file)!=0;
+  file = 0;
+  if (failed)
+    throw IOError(format("MeshWriter: failed to write '%s'",filename));
+}
+
+GEODE_DEFINE_TYPE(MeshReader)
+
+MeshReader::MeshReader(const string& filename)
+  : filename(filename)
+  , n_vertices_(0)
+  , n_faces_(0)
+  , vertex_data(0)
+  , face_data(0)
+  , vertex_stride(0)
+  , face_stride(0)
+  , corners_offset(0)
+  , doubles(false)
+  , flip(false) {
+  const auto ext = path::extension(filename);
+  if (ext == ".mesh") {
+    const auto mesh = read_native_mesh(filename);
+    const FieldId<TV,VertexId> pos_id(vertex_position_id);
+    if (!mesh->has_field(pos_id))
+      throw IOError(format("MeshReader: native mesh '%s' has no vertex positions",filename));
+    this->mesh = mesh;
+    X = mesh->field(pos_id).flat;
+    n_vertices_ = mesh->allocated_vertices();
+    n_faces_ = mesh->allocated_faces();
+    return;
+  } else if (ext != ".ply")
+    throw ValueError(format("MeshReader: unsupported mesh filename '%s', expected .ply or .mesh",filename));
+
+  const auto buffer = map_file(filename);
+  this->buffer = buffer;
+  const char* p = buffer->file.data;
+  const char* const end = buffer->file.end();
+  Line line;
+  try {
+    vector<Ref<PlyElement>> elements;
+    Hashtable<string,Ref<PlyElement>> element_names;
+    const int fmt = read_ply_header(line,p,end,elements,element_names);
+    if (fmt == 1)
+      throw IOError("ascii files can't be mapped");
+    #if GEODE_ENDIAN == GEODE_LITTLE_ENDIAN
+      flip = fmt != 2;
+    #elif GEODE_ENDIAN == GEODE_BIG_ENDIAN
+      flip = fmt != 3;
+    #endif
+
+    // Every element must have fixed size records, with faces fixed by being triangles
+    for (const auto& E : elements) {
+      size_t stride = 0;
+      for (const auto& prop : E->props) {
+        if (E->name == "face" && prop->name == "vertex_indices") {
+          if (   !dynamic_cast<const PlyPropList<uint8_t,int>*>(&*prop)
+              && !dynamic_cast<const PlyPropList<uint8_t,uint32_t>*>(&*prop))
+            throw IOError(format("face.vertex_indices has unsupported type %s",prop->type()));
+          corners_offset = int(stride);
+          stride += 1+3*sizeof(int);
+        } else if (!prop->fixed_size())
+          throw IOError(format("variable size property %s.%s can't be mapped",E->name,prop->name));
+        else {
+          if (E->name == "vertex" && prop->name.size()==1 && 'x'<=prop->name[0] && prop->name[0]<='z') {
+            const bool d = prop->type() == "double";
+            if (!d && prop->type() != "float")
+              throw IOError(format("vertex.%s has invalid type %s",prop->name,prop->type()));
+            doubles = d;
+            x_offsets[prop->name[0]-'x'] = int(stride);
+          }
+          stride += prop->fixed_size();
+        }
+      }
+      if (size_t(end-p)/max(stride,size_t(1)) < size_t(E->count))
+        throw IOError(format("element %s: expected %d entries of %d bytes, file ended after %d",
+          repr(E->name),E->count,stride,(end-p)/max(stride,size_t(1))));
+      if (E->name == "vertex") {
+        vertex_data = p;
+        vertex_stride = stride;
+        n_vertices_ = E->count;
+      } else if (E->name == "face") {
+        face_data = p;
+        face_stride = stride;
+        n_faces_ = E->count;
+      }
+      p += stride*E->count;
+    }
+
+    // Check that we found what we need
+    if (!vertex_data)
+      throw IOError("missing vertex element");
+    for (const int i : range(3))
+      if (!element_names.get("vertex")->prop_names.contains(string(1,"xyz"[i])))
+        throw IOError(format("vertex element missing property %c","xyz"[i]));
+    for (const auto& c : {"x","y","z"})
+      if (element_names.get("vertex")->prop_names.get(c)->type() != (doubles ? "double" : "float"))
+        throw IOError("vertex coordinates have mixed types");
+    if (!face_data)
+      throw IOError("missing face element");
+    if (!element_names.get("face")->prop_names.contains("vertex_indices"))
+      throw IOError("face element missing vertex_indices");
+  } catch (const IOError& e) {
+    throw IOError(format("MeshReader: invalid ply file %s:%d: %s",filename,line.lineno,e.what()));
+  }
+}
+
+MeshReader::~MeshReader() {}
+
+TV MeshReader::vertex(const int v) const {
+  GEODE_ASSERT(unsigned(v)<unsigned(n_vertices_));
+  if (mesh)
+    return X[v];
+  const char* p = vertex_data+v*vertex_stride;
+  TV x;
+  for (const int i : range(3)) {
+    if (doubles) {
+      double c;
+      memcpy(&c,p+x_offsets[i],sizeof(c));
+      x[i] = flip ? flip_endian(c) : c;
+    } else {
+      float c;
+      memcpy(&c,p+x_offsets[i],sizeof(c));
+      x[i] = flip ? flip_endian(c) : c;
+    }
+  }
+  return x;
+}
+
+Vector<int,3> MeshReader::face(const int f) const {
+  GEODE_ASSERT(unsigned(f)<unsigned(n_faces_));
+  if (mesh) {
+    const FaceId id(f);
+    return mesh->erased(id) ? Vector<int,3>(-1,-1,-1) : Vector<int,3>(mesh->vertices(id));
+  }
+  const char* p = face_data+f*face_stride+corners_offset;
+  if (*(const uint8_t*)p != 3)
+    throw IOError(format("MeshReader: face %d of '%s' has %d corners, expected 3",f,filename,int(*p)));
+  Vector<int,3> tri;
+  memcpy(&tri,p+1,sizeof(tri));
+  if (flip)
+    for (auto& c : tri)
+      c = flip_endian(c);
+  for (const int c : tri)
+    if (unsigned(c)>=unsigned(n_vertices_))
+      throw IOError(format("MeshReader: face %d of '%s' refers to vertex %d, but there are only %d",
+        f,filename,c,n_vertices_));
+  return tri;
+}
+
 static void write_mesh_py(const string& filename, PyObject* mesh, RawArray<const TV> X) {
   if (auto* soup = python_cast<TriangleSoup*>(mesh))
     write_mesh(filename,*soup,X);
@@ -864,4 +2270,33 @@ void wrap_mesh_io() {
   GEODE_FUNCTION(read_polygon_soup)
   GEODE_FUNCTION(read_mesh)
   GEODE_FUNCTION_2(write_mesh,write_mesh_py)
+  GEODE_FUNCTION(write_native_mesh)
+  GEODE_FUNCTION(read_native_mesh)
+  GEODE_FUNCTION(compress_mesh)
+  GEODE_FUNCTION(decompress_mesh)
+
+  {
+    typedef MeshWriter Self;
+    Class<Self>("MeshWriter")
+      .GEODE_INIT(const string&)
+      .GEODE_FIELD(filename)
+      .GEODE_GET(n_vertices)
+      .GEODE_GET(n_faces)
+      .GEODE_GET(closed)
+      .GEODE_METHOD(add_vertices)
+      .GEODE_METHOD(add_faces)
+      .GEODE_METHOD(close)
+      ;
+  }
+  {
+    typedef MeshReader Self;
+    Class<Self>("MeshReader")
+      .GEODE_INIT(const string&)
+      .GEODE_FIELD(filename)
+      .GEODE_GET(n_vertices)
+      .GEODE_GET(n_faces)
+      .GEODE_METHOD(vertex)
+      .GEODE_METHOD(face)
+      ;
+  }
 }
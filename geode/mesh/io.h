@@ -5,6 +5,8 @@
 #include <geode/mesh/TriangleTopology.h>
 namespace geode {
 
+class MappedBuffer;
+
 // Read a mesh format as triangle or polygon soup
 GEODE_EXPORT Tuple<Ref<TriangleSoup>,Array<Vector<real,3>>> read_soup(const string& filename);
 GEODE_EXPORT Tuple<Ref<PolygonSoup>,Array<Vector<real,3>>> read_polygon_soup(const string& filename);
@@ -21,4 +23,105 @@ GEODE_EXPORT void write_mesh(const string& filename, const TriangleTopology& mes
 // id and have type Vector<real,3>. 
 GEODE_EXPORT void write_mesh(const string &filename, const MutableTriangleTopology &mesh);
 
+// Native binary format for MutableTriangleTopology: the raw topology arrays and all vertex, face, and halfedge
+// fields, each 64 byte aligned, so that reading maps the file and points the arrays directly at the mapping
+// without parsing or rebuilding anything.  The mapping is private, so mutating the loaded mesh never touches the
+// file.  Files are specific to the byte order and C++ ABI that wrote them; use them as caches, not for exchange.
+GEODE_EXPORT void write_native_mesh(const string& filename, const MutableTriangleTopology& mesh);
+GEODE_EXPORT Ref<MutableTriangleTopology> read_native_mesh(const string& filename);
+
+// read_native_mesh can only restore fields of types it knows about.  The scalar and small vector types exposed to
+// Python, the id types, and Quadric are known already; register any others before reading.
+GEODE_EXPORT void register_native_field_type(const type_info& type);
+template<class T> static inline void register_native_field_type() {
+  static_assert(is_trivially_destructible<T>::value,"mesh fields must be POD-like");
+  register_native_field_type(typeid(T));
+}
+
+// Compressed meshes for archival and transfer.  Positions are quantized to a grid with 2^bits - 1 steps along the
+// longest side of the bounding box, so each coordinate moves by at most half a step.  Triangles are visited breadth
+// first through shared edges, connectivity is delta coded in that order, positions are predicted from already
+// visited neighbors, and both are entropy coded.  Vertices are renumbered in order of first use (unused vertices
+// last) and triangles in visiting order, so the geometry survives a round trip but the numbering does not.
+// read_soup and write_mesh handle .gmz files in this format, using 16 bits.
+GEODE_EXPORT Array<uint8_t> compress_mesh(const TriangleSoup& soup, RawArray<const Vector<real,3>> X,
+                                          const int bits);
+GEODE_EXPORT Tuple<Ref<TriangleSoup>,Array<Vector<real,3>>> decompress_mesh(RawArray<const uint8_t> data);
+
+// Write a mesh incrementally, as batches of vertices and faces are generated, to binary .stl, binary .ply, or the
+// native format above (any other extension is an error).  Faces may refer to any vertex already added.  Headers are
+// finalized by close, which the destructor calls if needed (ignoring errors).  Memory use depends on the format:
+// .ply keeps nothing, spilling faces to a temporary file until close; .stl keeps only the vertex positions, since
+// each triangle stores its corners inline; and native files build the topology, but hold no other copy of the mesh.
+class MeshWriter : public Object {
+public:
+  GEODE_DECLARE_TYPE(GEODE_CORE_EXPORT)
+  typedef Object Base;
+  typedef Vector<real,3> TV;
+
+  const string filename;
+private:
+  enum Kind { Stl, Ply, Native } kind;
+  FILE* file; // Output, or null for native files until close
+  FILE* spill; // Faces written so far, for .ply
+  long header_size; // Bytes reserved for the .ply header
+  int n_vertices_, n_faces_;
+  Array<TV> X; // Vertex positions, for .stl
+  Ptr<MutableTriangleTopology> mesh; // For native files
+  bool closed_;
+
+protected:
+  GEODE_CORE_EXPORT MeshWriter(const string& filename);
+public:
+  ~MeshWriter();
+
+  int n_vertices() const { return n_vertices_; }
+  int n_faces() const { return n_faces_; }
+  bool closed() const { return closed_; }
+
+  // Append vertices, returning the index of the first
+  GEODE_CORE_EXPORT int add_vertices(RawArray<const TV> X);
+
+  // Append triangles
+  GEODE_CORE_EXPORT void add_faces(RawArray<const Vector<int,3>> tris);
+
+  // Finalize the file.  Further additions are errors.
+  GEODE_CORE_EXPORT void close();
+};
+
+// Random access to the vertices and triangles of a mesh file without reading it into memory, for meshes too large to
+// load.  The file is mapped, so only the pages touched are read, and the page cache can evict them again under memory
+// pressure.  Binary .ply files whose faces are all triangles and native .mesh files are supported.  Other fixed size
+// properties and elements of .ply files are skipped.  Erased faces of native files read as (-1,-1,-1).
+class MeshReader : public Object {
+public:
+  GEODE_DECLARE_TYPE(GEODE_CORE_EXPORT)
+  typedef Object Base;
+  typedef Vector<real,3> TV;
+
+  const string filename;
+private:
+  int n_vertices_, n_faces_;
+  Ptr<const MappedBuffer> buffer; // For .ply
+  const char* vertex_data; // .ply vertex records
+  const char* face_data; // .ply face records
+  size_t vertex_stride, face_stride;
+  Vector<int,3> x_offsets; // Offsets of x, y, z in each vertex record
+  int corners_offset; // Offset of the corner count in each face record, followed by the corners
+  bool doubles, flip; // Coordinate type and byte order
+  Ptr<const MutableTriangleTopology> mesh; // For native files
+  Array<const TV> X; // For native files
+
+protected:
+  GEODE_CORE_EXPORT MeshReader(const string& filename);
+public:
+  ~MeshReader();
+
+  int n_vertices() const { return n_vertices_; }
+  int n_faces() const { return n_faces_; }
+
+  GEODE_CORE_EXPORT TV vertex(const int v) const;
+  GEODE_CORE_EXPORT Vector<int,3> face(const int f) const;
+};
+
 }
@@ -6,6 +6,8 @@
 #include <geode/array/amap.h>
 #include <geode/geometry/platonic.h>
 #include <geode/random/Random.h>
+#include <exception>
+#include <vector>
 
 namespace geode {
 
@@ -94,8 +96,6 @@ void add_vertex_fan(real division_angle, MutableTriangleTopology &mesh,
 
 Tuple<Ref<const TriangleSoup>, Array<TV>> lower_hull(TriangleSoup const &imesh, Array<TV> const &X, TV up, const T ground_offset, const T draft_angle, const T division_angle) {
 
-  auto random = new_<Random>(5349);
-
   up.normalize();
 
   Ref<MutableTriangleTopology> mesh = new_<MutableTriangleTopology>(imesh);
@@ -141,150 +141,175 @@ Tuple<Ref<const TriangleSoup>, Array<TV>> lower_hull(TriangleSoup const &imesh,
     min_ground = min(min_ground, dot(x, up));
   }
 
-  int component_idx = 0;
-  real min_z = min_ground;
-  for (auto p : component_faces) {
-    component_idx++;
-    auto faces = p.y;
-    auto extracted = mesh->extract(faces);
-    auto &component_mesh = *extracted.x;
-
-    // split non-manifold vertices
-    component_mesh.split_nonmanifold_vertices();
-
-    // compute the boundary loops (before we add the mirrored faces)
-    // store vertices because the boundary halfedges will change
-    auto boundary_loops = amap([&](HalfedgeId h){return component_mesh.src(h);}, component_mesh.boundary_loops());
-
-    // add vertices and remember the correspondence of vertices (simple offset)
-    int voffset = component_mesh.n_vertices();
-    for (int i = 0; i < voffset; ++i) {
-      VertexId nv = component_mesh.add_vertex();
-      assert(nv.idx() == i + voffset);
-      // flatten to ground_offset+epsilon*component_idx with some randomness to minimize hard cases for subsequent CSG
-      TV x = component_mesh.field(pos_id)[VertexId(i)];
-      TV ground_pos = x + (- dot(x, up) + min_ground - component_idx - .5 + random->uniform<real>(0., .5)) * up;
-      min_z = min(min_z, dot(ground_pos-up, up));
-      component_mesh.field(pos_id)[nv] = ground_pos;
-    }
-
-    // add (inverted) faces
-    auto oldfaces = component_mesh.faces();
-    GEODE_DEBUG_ONLY(const int foffset = component_mesh.n_faces();)
-    for (auto f : oldfaces) {
-      Vector<VertexId,3> verts = Vector<VertexId,3>::map([=](VertexId x){ return VertexId(x.id + voffset); }, component_mesh.vertices(f));
-      GEODE_DEBUG_ONLY(const auto nf =) component_mesh.add_face(verts.xzy());
-      assert(nf.idx() == f.idx() + foffset);
-    }
+  // Extract the components serially, since extraction shares field storage with mesh.  Everything after that
+  // touches only the component's own mesh, so components are processed in parallel.
+  std::vector<Ref<MutableTriangleTopology>> components;
+  for (auto p : component_faces)
+    components.push_back(mesh->extract(p.y).x);
+  const int n_components = int(components.size());
+  Array<real> component_min_z(n_components, uninit);
+  std::exception_ptr error;
+
+  #pragma omp parallel for schedule(dynamic,1)
+  for (int c = 0; c < n_components; ++c) {
+    try {
+      const int component_idx = c+1;
+      auto &component_mesh = *components[c];
+      // Each component gets its own generator so the result does not depend on scheduling
+      auto random = new_<Random>(5349+component_idx);
+      real min_z = min_ground;
+
+      // split non-manifold vertices
+      component_mesh.split_nonmanifold_vertices();
+
+      // compute the boundary loops (before we add the mirrored faces)
+      // store vertices because the boundary halfedges will change
+      auto boundary_loops = amap([&](HalfedgeId h){return component_mesh.src(h);}, component_mesh.boundary_loops());
+
+      // add vertices and remember the correspondence of vertices (simple offset)
+      int voffset = component_mesh.n_vertices();
+      for (int i = 0; i < voffset; ++i) {
+        VertexId nv = component_mesh.add_vertex();
+        assert(nv.idx() == i + voffset);
+        // flatten to ground_offset+epsilon*component_idx with some randomness to minimize hard cases for subsequent CSG
+        TV x = component_mesh.field(pos_id)[VertexId(i)];
+        TV ground_pos = x + (- dot(x, up) + min_ground - component_idx - .5 + random->uniform<real>(0., .5)) * up;
+        min_z = min(min_z, dot(ground_pos-up, up));
+        component_mesh.field(pos_id)[nv] = ground_pos;
+      }
 
-    // make side faces
-    for (auto loop : boundary_loops) {
-      for (int i = 0, j = loop.size()-1; i < loop.size(); j = i++) {
-        VertexId vi = loop[i];
-        VertexId vj = loop[j];
-        VertexId vim = VertexId(vi.idx()+voffset);
-        VertexId vjm = VertexId(vj.idx()+voffset);
-        component_mesh.add_face(vec(vj, vi, vjm));
-        component_mesh.add_face(vec(vjm, vi, vim));
+      // add (inverted) faces
+      auto oldfaces = component_mesh.faces();
+      GEODE_DEBUG_ONLY(const int foffset = component_mesh.n_faces();)
+      for (auto f : oldfaces) {
+        Vector<VertexId,3> verts = Vector<VertexId,3>::map([=](VertexId x){ return VertexId(x.id + voffset); }, component_mesh.vertices(f));
+        GEODE_DEBUG_ONLY(const auto nf =) component_mesh.add_face(verts.xzy());
+        assert(nf.idx() == f.idx() + foffset);
       }
-    }
 
-    // tilt side faces by ofsetting
-    if (draft_angle > 0.) {
+      // make side faces
       for (auto loop : boundary_loops) {
+        for (int i = 0, j = loop.size()-1; i < loop.size(); j = i++) {
+          VertexId vi = loop[i];
+          VertexId vj = loop[j];
+          VertexId vim = VertexId(vi.idx()+voffset);
+          VertexId vjm = VertexId(vj.idx()+voffset);
+          component_mesh.add_face(vec(vj, vi, vjm));
+          component_mesh.add_face(vec(vjm, vi, vim));
+        }
+      }
 
-        // compute all normals and store them. normals[i] is the normal of the
-        // edge x[i-1]-x[i]
-        // find an edge for which we can compute a normal. start is set to the
-        // vertex after that edge (i).
-        Array<Vector<real,3>> normals(loop.size(), uninit);
-        Array<bool> normal_valid(loop.size(), uninit);
-        normal_valid.fill(true);
-        int start = -1;
-        for (int i = 0, j = loop.size()-1; i < loop.size(); j=i++) {
-          // j___n[i]___i
-          auto vj = loop[j];
-          auto vi = loop[i];
-          auto eji = component_mesh.field(pos_id)[vi] - component_mesh.field(pos_id)[vj];
-          auto ep = eji.projected_orthogonal_to_unit_direction(up).normalized();
-          if (ep.sqr_magnitude() == 0) {
-            normals[i] = vec(0.,0.,0.);
-            normal_valid[i] = false;
-          } else {
-            normals[i] = cross(up,ep);
-            if (start == -1) {
-              start = i;
+      // tilt side faces by ofsetting
+      if (draft_angle > 0.) {
+        for (auto loop : boundary_loops) {
+
+          // compute all normals and store them. normals[i] is the normal of the
+          // edge x[i-1]-x[i]
+          // find an edge for which we can compute a normal. start is set to the
+          // vertex after that edge (i).
+          Array<Vector<real,3>> normals(loop.size(), uninit);
+          Array<bool> normal_valid(loop.size(), uninit);
+          normal_valid.fill(true);
+          int start = -1;
+          for (int i = 0, j = loop.size()-1; i < loop.size(); j=i++) {
+            // j___n[i]___i
+            auto vj = loop[j];
+            auto vi = loop[i];
+            auto eji = component_mesh.field(pos_id)[vi] - component_mesh.field(pos_id)[vj];
+            auto ep = eji.projected_orthogonal_to_unit_direction(up).normalized();
+            if (ep.sqr_magnitude() == 0) {
+              normals[i] = vec(0.,0.,0.);
+              normal_valid[i] = false;
+            } else {
+              normals[i] = cross(up,ep);
+              if (start == -1) {
+                start = i;
+              }
             }
           }
-        }
 
-        // if there is none, this loop is a point, and we can simply add a cone
-        // with no ill effects. We will therefore just set two adjacent normals to
-        // opposite values and let the regular algorithm handle the details.
-        if (start == -1) {
-          normals[0] = up.unit_orthogonal_vector();
-          normals[1] = -normals[0];
-          normal_valid[0] = normal_valid[1] = true;
-          start = 0;
-        }
+          // if there is none, this loop is a point, and we can simply add a cone
+          // with no ill effects. We will therefore just set two adjacent normals to
+          // opposite values and let the regular algorithm handle the details.
+          if (start == -1) {
+            normals[0] = up.unit_orthogonal_vector();
+            normals[1] = -normals[0];
+            normal_valid[0] = normal_valid[1] = true;
+            start = 0;
+          }
 
-        // go through the loop, starting with start. last_normal always contains
-        // the normal of the last valid edge before our current vertex (i). We try to
-        // compute the edge normal for the edge after, and decide whether to split.
-        // If the next edge normal cannot be computed, we do not split, but simply
-        // continue offsetting in last_normal direction. Once the next edge normal
-        // can be computed, we (possibly) add the required split, and reset last_normal.
-        int i = start, j = start==loop.size()-1 ? 0 : start+1;
-        bool first = true;
-        TV last_normal = normals[start];
-        while (first || i != start) {
-
-          // last___x_i___n___x_j
-          auto vj = loop[j];
-          auto vjm = VertexId(vj.idx() + voffset);
-          auto vi = loop[i];
-          auto vim = VertexId(vi.idx() + voffset);
-
-          auto xi = component_mesh.field(pos_id)[vi];
-          auto xim = component_mesh.field(pos_id)[vim];
-          auto xj = component_mesh.field(pos_id)[vj];
-
-          // see how far we have to move this point to achieve the draft angle
-          auto move_by = tan(draft_angle) * dot(xi-xim, up);
-
-          TV normal = normals[j];
-
-          if (normal_valid[j]) {
-            bool convex = Plane<real>(last_normal, xi).phi(xj) < 0;
-            bool very_convex = convex && dot(last_normal, normal) < cos_division_angle;
-
-            if (very_convex) {
-              // if normal can be computed, and it's too spiky with last_normal, add a fan
-              add_vertex_fan(division_angle, component_mesh, pos_id, vi, vim, vj, vjm, move_by, last_normal, normal);
+          // go through the loop, starting with start. last_normal always contains
+          // the normal of the last valid edge before our current vertex (i). We try to
+          // compute the edge normal for the edge after, and decide whether to split.
+          // If the next edge normal cannot be computed, we do not split, but simply
+          // continue offsetting in last_normal direction. Once the next edge normal
+          // can be computed, we (possibly) add the required split, and reset last_normal.
+          int i = start, j = start==loop.size()-1 ? 0 : start+1;
+          bool first = true;
+          TV last_normal = normals[start];
+          while (first || i != start) {
+
+            // last___x_i___n___x_j
+            auto vj = loop[j];
+            auto vjm = VertexId(vj.idx() + voffset);
+            auto vi = loop[i];
+            auto vim = VertexId(vi.idx() + voffset);
+
+            auto xi = component_mesh.field(pos_id)[vi];
+            auto xim = component_mesh.field(pos_id)[vim];
+            auto xj = component_mesh.field(pos_id)[vj];
+
+            // see how far we have to move this point to achieve the draft angle
+            auto move_by = tan(draft_angle) * dot(xi-xim, up);
+
+            TV normal = normals[j];
+
+            if (normal_valid[j]) {
+              bool convex = Plane<real>(last_normal, xi).phi(xj) < 0;
+              bool very_convex = convex && dot(last_normal, normal) < cos_division_angle;
+
+              if (very_convex) {
+                // if normal can be computed, and it's too spiky with last_normal, add a fan
+                add_vertex_fan(division_angle, component_mesh, pos_id, vi, vim, vj, vjm, move_by, last_normal, normal);
+              } else {
+                // not spiky, just move point
+                component_mesh.field(pos_id)[vim] += move_by * (last_normal+normal).normalized();
+              }
+              last_normal = normal;
             } else {
-              // not spiky, just move point
-              component_mesh.field(pos_id)[vim] += move_by * (last_normal+normal).normalized();
+              // can't be computed, just move point along last normal
+              component_mesh.field(pos_id)[vim] += move_by * last_normal.normalized();
             }
-            last_normal = normal;
-          } else {
-            // can't be computed, just move point along last normal
-            component_mesh.field(pos_id)[vim] += move_by * last_normal.normalized();
-          }
 
-          first = false;
-          i = j;
-          j++;
-          if (j == loop.size())
-            j = 0;
+            first = false;
+            i = j;
+            j++;
+            if (j == loop.size())
+              j = 0;
+          }
         }
       }
-    }
 
-    // TODO: move side faces outward (ever so slightly) to avoid slivers
-    // They are more likely to be aligned than not.
+      // TODO: move side faces outward (ever so slightly) to avoid slivers
+      // They are more likely to be aligned than not.
 
-    // add to the result mesh
-    new_mesh->add(component_mesh);
+      component_min_z[c] = min_z;
+    } catch (...) {
+      #pragma omp critical
+      {
+        if (!error)
+          error = std::current_exception();
+      }
+    }
+  }
+  if (error)
+    std::rethrow_exception(error);
+
+  // add to the result mesh
+  real min_z = min_ground;
+  for (int c = 0; c < n_components; ++c) {
+    new_mesh->add(*components[c]);
+    min_z = min(min_z, component_min_z[c]);
   }
 
   // all these faces have weight 1
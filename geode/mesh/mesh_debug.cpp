@@ -1,5 +1,6 @@
 #include <geode/array/sort.h>
 #include <geode/mesh/mesh_debug.h>
+#include <geode/mesh/components.h>
 #include <geode/geometry/ParticleTree.h>
 
 namespace geode {
@@ -56,29 +57,7 @@ Array<real> mesh_component_volumes(const TriangleTopology& mesh, const RawField<
 }
 
 NestedField<FaceId, ComponentId> get_component_faces(const TriangleTopology& mesh) {
-  Field<ComponentId, FaceId> labels{mesh.allocated_faces()};
-  Nested<FaceId,false> result;
-  result.flat.preallocate(mesh.n_faces());
-
-  Array<FaceId> queue;
-  for(const FaceId seed : mesh.faces()) {
-    if(labels[seed].valid()) continue; // Skip any that are already set
-    const ComponentId current_component = ComponentId{result.size()};
-    labels[seed] = current_component;
-    queue.append(seed);
-    result.append_empty();
-    do {
-      for(const FaceId f : mesh.faces(queue.pop())) {
-        if(!f.valid()) continue; // Watch out for boundary
-        if(!labels[f].valid()) {
-          labels[f] = current_component;
-          queue.append(f);
-          result.append_to_back(f);
-        }
-      }
-    } while(!queue.empty());
-  }
-  return {result.freeze()};
+  return face_components(mesh);
 }
 
 Nested<VertexId> get_unconnected_clusters(const TriangleTopology& mesh, const RawField<const Vector<real,3>, VertexId> X, const real epsilon) {
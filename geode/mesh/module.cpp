@@ -12,8 +12,11 @@ void wrap_mesh() {
   GEODE_WRAP(triangle_subdivision)
   GEODE_WRAP(halfedge_mesh)
   GEODE_WRAP(corner_mesh)
+  GEODE_WRAP(frozen_triangle_topology)
+  GEODE_WRAP(heat_geodesic)
   GEODE_WRAP(mesh_io)
   GEODE_WRAP(lower_hull)
   GEODE_WRAP(decimate)
+  GEODE_WRAP(decimate_file)
   GEODE_WRAP(improve_mesh)
 }
@@ -19,4 +19,17 @@ Quadric compute_quadric(TriangleTopology const &mesh, const RawField<const Vecto
   return q;
 }
 
+FieldId<Quadric,VertexId> vertex_quadrics(MutableTriangleTopology& mesh, RawField<const Vector<real,3>,VertexId> X) {
+  const FieldId<Quadric,VertexId> id(vertex_quadric_id);
+  if (!mesh.has_field(id)) {
+    mesh.add_vertex_field<Quadric>(id.id);
+    const auto& quadrics = mesh.field(id);
+    #pragma omp parallel for
+    for (int v=0;v<quadrics.size();v++)
+      if (!mesh.erased(VertexId(v)))
+        quadrics[VertexId(v)] = compute_quadric(mesh,X,VertexId(v));
+  }
+  return id;
+}
+
 }
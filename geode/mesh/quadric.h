@@ -64,4 +64,12 @@ struct Quadric {
 class TriangleTopology;
 Quadric compute_quadric(TriangleTopology const &mesh, RawField<const Vector<real,3>, VertexId> X, VertexId v);
 
+// Quadrics of every vertex, cached as a mesh field with id vertex_quadric_id so that successive passes (decimate,
+// simplify, improve_mesh) share them instead of recomputing every one-ring.  If the field doesn't exist yet, it is
+// added and filled in.  The passes keep it current for the vertices they change, but code that moves vertices or
+// edits topology by other means should remove the field.  Adding a field invalidates references to other fields,
+// so call this before taking any.
+GEODE_CORE_EXPORT FieldId<Quadric,VertexId> vertex_quadrics(MutableTriangleTopology& mesh,
+                                                            RawField<const Vector<real,3>,VertexId> X);
+
 }
@@ -195,65 +195,28 @@ template<class T> static void grow_to_fit(HalfedgeField<T>& f, const HalfedgeId
     }
 }
 
-struct SimplifyHeap : public HeapBase<SimplifyHeap>, public Noncopyable {
-  typedef HeapBase<SimplifyHeap> Base;
-  Array<SimplificationCandidate> heap;
+// Indexed heap of the next candidate simplification for each halfedge
+struct SimplifyHeap : public IndexedHeap<SimplifyHeap,SimplificationCandidate>, public Noncopyable {
   HalfedgeField<int> inv_heap;
 
   SimplifyHeap(const TriangleTopology& mesh)
    : inv_heap(mesh,-1)
   { }
 
-  int size() const { return heap.size(); }
-  bool empty() const { return size() == 0; }
-  bool contains(const HalfedgeId he) { return inv_heap.valid(he) && inv_heap[he] != -1; }
-  bool first(const int i, const int j) const {
-    return heap[i] < heap[j];
+  bool first(const SimplificationCandidate& a, const SimplificationCandidate& b) const {
+    return a < b;
   }
 
-  void swap(const int i, const int j) {
-    std::swap(heap[i],heap[j]);
-    inv_heap[heap[i].he] = i;
-    inv_heap[heap[j].he] = j;
-  }
+  HalfedgeId key(const SimplificationCandidate& candidate) const { return candidate.he; }
 
-  SimplificationCandidate pop() {
-    const auto next = heap[0];
-    inv_heap[next.he] = -1;
-    const auto p = heap.pop();
-    if (size()) {
-      heap[0] = p;
-      inv_heap[heap[0].he] = 0;
-      Base::move_downward(0);
-    }
-    return next;
+  int position(const HalfedgeId he) const {
+    return inv_heap.valid(he) ? inv_heap[he] : -1; // Values outside the map were never set
   }
 
-  void set(const SimplificationCandidate candidate) {
-    const auto he = candidate.he;
-    // Grow heap as needed if id is out of range
+  void set_position(const HalfedgeId he, const int i) {
+    // Grow map as needed if id is out of range
     grow_to_fit(inv_heap, he, -1);
-    int& i = inv_heap[he];
-    if (i < 0)
-      i = heap.append(candidate);
-    else
-      heap[i] = candidate;
-    Base::move_up_or_down(i);
-  }
-
-  void erase(const HalfedgeId he) {
-    if(!inv_heap.valid(he))
-      return; // Value was never set so we can ignore it
-    int& i = inv_heap[he];
-    if (i >= 0) {
-      const auto p = heap.pop();
-      if (i < size()) {
-        heap[i] = p;
-        inv_heap[p.he] = i;
-        Base::move_up_or_down(i);
-      }
-      i = -1;
-    }
+    inv_heap[he] = i;
   }
 };
 
@@ -301,8 +264,8 @@ struct SimplifyHelper {
   const T sqr_magnitude_n_eps = 4.*sqr(area_eps); // Threshold for testing if faces are degenerate
   const T sign_sqr_min_cos = sign_sqr(max_angle > .99*pi ? -1 : cos(max_angle));
 
-  // Quadrics for each vertex of mesh
-  Field<Quadric,VertexId> cached_quadrics{mesh.allocated_vertices()};
+  // Quadrics for each vertex of mesh, shared with other passes via vertex_quadrics
+  const Field<Quadric,VertexId>& cached_quadrics = mesh.field(FieldId<Quadric,VertexId>(vertex_quadric_id));
   // This is a heap of the next candidate simplification for each halfedge
   // Need to be careful that an invalid simplification with a lower cost doesn't hide a valid one
   SimplifyHeap heap{mesh};
@@ -327,11 +290,6 @@ struct SimplifyHelper {
   {
     mesh.erase_isolated_vertices();
 
-    // Start with an updated quadric for each vertex
-    for(const VertexId v : mesh.vertices()) {
-      cached_quadrics[v] = compute_quadric(mesh, X, v);
-    }
-
     // Compute the initial cost to simplify each edge
     for(const HalfedgeId he : mesh.halfedges()) {
       set_simplify_cost_initial(he);
@@ -675,13 +633,10 @@ struct SimplifyHelper {
       const VertexId v = dirty_quadrics.pop();
       if(mesh.erased(v)) continue;
       const auto new_quadric = compute_quadric(mesh, X, v);
-      if(cached_quadrics.valid(v) && !(cached_quadrics[v] != new_quadric)) {
+      if(!(cached_quadrics[v] != new_quadric)) {
         // Quadric didn't change so don't need to update edges that depend on it
         continue;
       }
-      if(!cached_quadrics.valid(v)) {
-        cached_quadrics.flat.resize(v.idx()+1); // Grow for a new vertex
-      }
       cached_quadrics[v] = new_quadric;
       for(const HalfedgeId he : mesh.outgoing(v)) {
         dirty_edges.append_unique(he);
@@ -700,8 +655,15 @@ struct SimplifyHelper {
 
   void run() {
     for(;;) {
-      if(mesh.n_vertices() <= min_vertices)
+      if(mesh.n_vertices() <= min_vertices) {
+        // Leave the shared quadrics current
+        while(!dirty_quadrics.empty()) {
+          const VertexId v = dirty_quadrics.pop();
+          if(!mesh.erased(v))
+            cached_quadrics[v] = compute_quadric(mesh, X, v);
+        }
         break;
+      }
       update_dirty_stuff();
       if(heap.empty())
         break;
@@ -753,6 +715,7 @@ void simplify_inplace(MutableTriangleTopology& mesh,
                  const int min_vertices,       // Stop if we decimate down to this many vertices (-1 for no limit)
                  const real boundary_distance) {
 
+  vertex_quadrics(mesh, mesh.field(X_id)); // Attach before referencing X, since adding a field moves the others
   auto&& helper = SimplifyHelper{mesh, mesh.field(X_id), distance, max_angle, min_vertices, boundary_distance};
   helper.run();
 }
@@ -35,6 +35,57 @@ def test_decimate():
     test(distance=3,boundary_distance=.1)
     test(distance=inf,boundary_distance=inf)
 
+def test_decimate_parallel():
+  mesh = TriangleSoup([(0,1,2),(0,2,3),(0,3,1)])
+  _,X = tetrahedron_mesh()
+  mesh,X = loop_subdivide(mesh,X,steps=3)
+  mesh = TriangleTopology(mesh)
+  for distance,boundary_distance in (.01,0),(.05,.02),(inf,inf):
+    md,Xd = mesh.mutate(),X.copy()
+    decimate_inplace_parallel(md,Xd,distance,pi/2,-1,boundary_distance)
+    md.assert_consistent(True)
+    assert md.n_vertices<mesh.n_vertices
+    assert hausdorff((mesh,X),(md,Xd))<=distance
+    assert hausdorff((mesh,X),(md,Xd),boundary=1)<=boundary_distance
+
+def test_decimate_file():
+  soup,X = sphere_mesh(4)
+  f = named_tmpfile(suffix='.ply')
+  g = named_tmpfile(suffix='.ply')
+  write_mesh(f.name,soup,X)
+  # Small chunks, so that seams run all over the sphere
+  decimate_file(f.name,g.name,.01,pi/2,500)
+  md,Xd = read_mesh(g.name)
+  md.assert_consistent(True)
+  assert md.n_boundary_edges==0
+  # Locked seams cost a little reduction, but the error should match decimating in core
+  mesh = TriangleTopology(soup)
+  mc,Xc = decimate(mesh,X,.01)
+  assert md.n_faces<1.5*mc.n_faces
+  assert hausdorff((mesh,X),(md,Xd))<=1.5*hausdorff((mesh,X),(mc,Xc))
+
+def test_progressive_decimate():
+  mesh = TriangleSoup([(0,1,2),(0,2,3),(0,3,1)])
+  _,X = tetrahedron_mesh()
+  mesh,X = loop_subdivide(mesh,X,steps=3)
+  mesh = TriangleTopology(mesh)
+  pm = progressive_decimate(mesh,X,.05,pi/2,-1,.02)
+  assert pm.base_vertices()<mesh.n_vertices
+  assert pm.vertices(pm.splits())==mesh.n_vertices
+  def original(faces):
+    return sorted(tuple(pm.vertex_ids[f]) for f in faces)
+  # The finest level is the original mesh, and the coarsest is the decimated mesh
+  assert original(pm.lod_faces(pm.splits()))==sorted(map(tuple,mesh.elements()))
+  md,Xd = decimate(mesh,X,.05,pi/2,-1,.02)
+  assert original(pm.lod_faces(0))==sorted(map(tuple,md.elements()))
+  for n in xrange(0,pm.splits()+1,13):
+    faces = pm.lod_faces(n)
+    assert len(faces)==pm.faces(n)
+    lod = TriangleTopology(triangle_soup_with_nodes(faces,pm.vertices(n)))
+    lod.assert_consistent(True)
+    assert hausdorff((mesh,X),(lod,pm.X[:pm.vertices(n)]))<=.05
+  assert all(pm.lod_faces_with_vertices(pm.vertices(20))==pm.lod_faces(20))
+
 def test_simplify():
   for steps in 2,3:
     mesh = TriangleSoup([(0,1,2),(0,2,3),(0,3,1)])
@@ -56,4 +107,6 @@ def test_simplify():
 
 if __name__ == '__main__':
   test_decimate()
+  test_decimate_parallel()
+  test_progressive_decimate()
   test_simplify()
@@ -32,6 +32,225 @@ def test_collect_boundary_garbage():
   mesh.assert_consistent(True)
   assert mesh.is_garbage_collected()
 
+def test_boundary_loops():
+  mesh = MutableTriangleTopology()
+  mesh.add_vertices(3*6)
+  mesh.add_faces(cylinder_topology(2,6).elements)
+  def check(lengths):
+    loops = mesh.boundary_loops()
+    assert mesh.n_boundary_loops()==len(lengths)
+    assert sorted(loops.sizes())==sorted(lengths)
+    for i,loop in enumerate(loops):
+      assert mesh.boundary_loop_length(i)==len(loop)
+      for e in loop:
+        assert mesh.boundary_loop(e)==i
+  check([6,6])
+  assert mesh.is_manifold_with_boundary()
+  # Extend one end of the cylinder, which touches the boundary and must refresh the index
+  mesh.add_vertices(6)
+  mesh.add_faces(cylinder_topology(1,6).elements+12)
+  check([6,6])
+  mesh.collect_boundary_garbage()
+  check([6,6])
+  # Pinch two loops together at a vertex
+  mesh.add_face((0,1,18))
+  assert not mesh.is_manifold_with_boundary()
+
+def test_bulk_construction():
+  # Constructing from a soup builds connectivity in bulk, which should match adding faces one at a time
+  def structure(mesh):
+    v = mesh.halfedge_vertices
+    return sorted((tuple(v(e)),tuple(v(mesh.next(e))),tuple(v(mesh.prev(e))),mesh.is_boundary_halfedge(e))
+                  for e in mesh.halfedges())
+  random.seed(81731)
+  for soup in torus_topology(4,5),grid_topology(4,5),TriangleSoup([(0,1,2),(0,3,4)]):
+    tris = soup.elements.copy()
+    random.shuffle(tris)
+    bulk = TriangleTopology(TriangleSoup(tris))
+    bulk.assert_consistent(True)
+    serial = MutableTriangleTopology()
+    serial.add_vertices(soup.nodes())
+    for t in tris:
+      serial.add_face(t)
+    serial.collect_boundary_garbage()
+    assert all(bulk.elements()==serial.elements())
+    assert structure(bulk)==structure(serial)
+
+def test_batched_mutation():
+  random.seed(7131)
+  soup = torus_topology(4,5)
+  mesh = MutableTriangleTopology(soup)
+  mesh.reserve(3*soup.nodes(),3*len(soup.elements))
+  # A second component on new vertices is added in bulk, and must match adding its faces one at a time
+  serial = mesh.copy()
+  for m in mesh,serial:
+    m.add_vertices(len(grid_topology(3,4).nodes()))
+  tris = grid_topology(3,4).elements+soup.nodes()
+  assert mesh.add_faces(tris)==len(soup.elements)
+  for t in tris:
+    serial.add_face(t)
+  mesh.assert_consistent(True)
+  assert all(mesh.elements()==serial.elements())
+  # Splitting a batch of edges matches splitting them in order
+  edges = []
+  for e in random.permutation(mesh.halfedges()):
+    if all(set(mesh.halfedge_vertices(e))!=set(mesh.halfedge_vertices(f)) for f in edges):
+      edges.append(e)
+  edges = asarray(edges[:20],dtype=int32)
+  ends = [mesh.halfedge_vertices(e) for e in edges]
+  vs = mesh.split_edges(edges)
+  for (a,b),v in zip(ends,vs):
+    assert serial.split_edge(serial.halfedge_between(a,b))==v
+  mesh.assert_consistent(True)
+  assert all(mesh.elements()==serial.elements())
+  try:
+    mesh.split_edges([edges[0],mesh.reverse(edges[0])])
+    assert False
+  except ValueError:
+    pass
+
+def test_edge_index():
+  random.seed(18131)
+  mesh = MutableTriangleTopology(torus_topology(6,7))
+  mesh.enable_edge_index()
+  for i in xrange(100):
+    e = random.choice(mesh.all_halfedges())
+    if i%3==0:
+      corner_random_edge_flips(mesh,5,i)
+    elif mesh.halfedge_valid(e):
+      if i%3==1:
+        mesh.split_edge(e)
+      elif mesh.is_collapse_safe(e):
+        mesh.collapse(e)
+    for e in mesh.halfedges():
+      assert mesh.halfedge_between(*mesh.halfedge_vertices(e))==e
+  mesh.assert_consistent(True)
+
+def test_normal_tracking():
+  random.seed(18133)
+  mesh = MutableTriangleTopology(torus_topology(6,7))
+  Xi = mesh.add_vertex_field('3d',vertex_position_id)
+  X = mesh.field(Xi)
+  X[:] = random.randn(*X.shape)
+  Ni = mesh.add_vertex_field('3d',invalid_id)
+  mesh.enable_normal_tracking()
+  mesh.field(Ni)[:] = mesh.update_vertex_normals(mesh.field(Xi),mesh.field(Ni),[])
+  for i in xrange(100):
+    e = random.choice(mesh.all_halfedges())
+    moved = []
+    if i%4==0:
+      corner_random_edge_flips(mesh,5,i)
+    elif mesh.halfedge_valid(e):
+      if i%4==1:
+        v = mesh.split_edge(e)
+        mesh.field(Xi)[v] = random.randn(3)
+      elif i%4==2 and mesh.is_collapse_safe(e):
+        mesh.collapse(e)
+      elif i%4==3:
+        v = mesh.src(e)
+        mesh.field(Xi)[v] += random.randn(3)
+        moved = [v]
+    mesh.field(Ni)[:] = mesh.update_vertex_normals(mesh.field(Xi),mesh.field(Ni),moved)
+    assert all(mesh.field(Ni)==mesh.vertex_normals(mesh.field(Xi)))
+
+def test_snapshot():
+  random.seed(18137)
+  mesh = MutableTriangleTopology(torus_topology(6,7))
+  snaps = []
+  for i in xrange(40):
+    if i%5==0:
+      s = mesh.snapshot()
+      snaps.append((s,s.elements().copy(),s.n_boundary_loops()))
+    e = random.choice(mesh.all_halfedges())
+    if mesh.halfedge_valid(e):
+      if i%3==0:
+        mesh.split_edge(e)
+      elif i%3==1 and mesh.is_collapse_safe(e):
+        mesh.collapse(e)
+      else:
+        mesh.erase_face(mesh.face(e),True)
+  mesh.assert_consistent(True)
+  for s,tris,loops in snaps:
+    s.assert_consistent(True)
+    assert all(s.elements()==tris)
+    assert s.n_boundary_loops()==loops
+
+def test_batch():
+  mesh = TriangleTopology(torus_topology(4,5))
+  F = arange(mesh.n_faces).astype(int32)
+  E = arange(3*mesh.n_faces).astype(int32)
+  V = arange(mesh.n_vertices).astype(int32)
+  assert all(mesh.batch_face_vertices(F)==[mesh.face_vertices(f) for f in F])
+  assert all(mesh.batch_face_halfedges(F)==[mesh.face_halfedges(f) for f in F])
+  assert all(mesh.batch_reverse(E)==[mesh.reverse(e) for e in E])
+  assert all(mesh.batch_src(E)==[mesh.src(e) for e in E])
+  assert all(mesh.batch_dst(E)==[mesh.dst(e) for e in E])
+  assert all(mesh.batch_halfedge_between(mesh.batch_src(E),mesh.batch_dst(E))==E)
+  rings = mesh.batch_vertex_one_ring(V)
+  for i,v in enumerate(V):
+    assert all(rings[i]==mesh.vertex_one_ring(v))
+  try:
+    mesh.batch_face_vertices([0,len(F)])
+    assert False
+  except ValueError:
+    pass
+
+def test_pickle():
+  import cPickle as pickle
+  soup = triangle_soup_with_nodes([(0,1,2),(2,1,3)],6)
+  s = pickle.loads(pickle.dumps(soup,2))
+  assert all(s.elements==soup.elements) and s.nodes()==soup.nodes()
+  mesh = TriangleTopology(grid_topology(5,6))
+  for protocol in 0,2:
+    m = pickle.loads(pickle.dumps(mesh,protocol))
+    m.assert_consistent(True)
+    assert all(m.elements()==mesh.elements())
+    assert all(m.raw_state()[1]==mesh.raw_state()[1])
+
+def test_reorder_for_locality():
+  random.seed(7131)
+  mesh = MutableTriangleTopology(grid_topology(5,6))
+  mesh.permute_vertices(random.permutation(mesh.n_vertices).astype(int32),True)
+  mesh.permute_faces(random.permutation(mesh.n_faces).astype(int32),True)
+  for f in mesh.all_faces():
+    mesh.erase_face(f,False)
+    break
+  Vi = mesh.add_vertex_field('i',invalid_id)
+  V = mesh.field(Vi)
+  for v in mesh.all_vertices():
+    V[v] = v
+  tris = mesh.elements()
+  vp,fp,bp = mesh.reorder_for_locality()
+  mesh.assert_consistent(True)
+  assert all(mesh.field(Vi)[vp]==arange(len(vp)))
+  assert all(sort(mesh.elements()[fp[fp>=0]],axis=1)==sort(vp[tris],axis=1))
+
+def test_collect_garbage_incrementally():
+  random.seed(8131)
+  mesh = MutableTriangleTopology(grid_topology(5,6))
+  Vi = mesh.add_vertex_field('i',invalid_id)
+  for v in mesh.all_vertices():
+    mesh.field(Vi)[v] = v
+  for f in random.permutation(mesh.n_faces)[:12]:
+    mesh.erase_face(f,True)
+  tris = set(tuple(sorted(t)) for t in mesh.field(Vi)[mesh.elements()])
+  for _ in xrange(100):
+    vm,fm = mesh.collect_garbage_incrementally(3)
+    mesh.assert_consistent(True)
+    assert set(tuple(sorted(t)) for t in mesh.field(Vi)[mesh.elements()])==tris
+  assert (mesh.n_vertices,mesh.n_faces)==(len(mesh.all_vertices()),len(mesh.all_faces()))
+
+def test_frozen():
+  mesh = MutableTriangleTopology(grid_topology(5,6))
+  for f in mesh.all_faces():
+    mesh.erase_face(f,False)
+    break
+  frozen = FrozenTriangleTopology(mesh)
+  frozen.assert_consistent()
+  mesh.collect_garbage()
+  assert all(frozen.elements()==mesh.elements())
+  assert (frozen.n_vertices,frozen.n_faces,frozen.n_boundary_edges)==(mesh.n_vertices,mesh.n_faces,mesh.n_boundary_edges)
+
 def test_collapse():
   random.seed(131313)
   soup = torus_topology(8,10)
@@ -188,6 +407,11 @@ def test_nonmanifold_vertices():
       mesh.split_along_edge(he)
       mesh.assert_consistent(False)
 
+  # The faces around vertex 0 now fall into two fans
+  components = mesh.surface_components(0)
+  assert len(components)==2
+  assert sorted(components.flat)==sorted(mesh.incident_faces(0))
+
   r = mesh.split_nonmanifold_vertices()
   mesh.assert_consistent(True)
 
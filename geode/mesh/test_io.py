@@ -105,5 +105,122 @@ end_header
       open(f.name,'w').write(ascii[ext])
       check_read()
 
+def test_text_precision():
+  # Text formats write the shortest decimal which reads back exactly
+  random.seed(1831)
+  X = concatenate([random.randn(300,3),around(random.randn(100,3),4),exp(30*random.randn(100,3)),[(0,-0.,1e300)]])
+  soup = TriangleSoup(arange(len(X)-len(X)%3).reshape(-1,3))
+  f = named_tmpfile(suffix='.obj')
+  write_mesh(f.name,soup,X)
+  soup2,X2 = read_soup(f.name)
+  assert all(soup.elements==soup2.elements)
+  assert all(X==X2)
+  lines = open(f.name).read().split('\n')
+  assert 'v 0 -0 1e+300' in lines
+  assert all(len(v)<=9 for line in lines[6+300:6+400] for v in line.split()[1:])
+  polys = PolygonSoup([3,4],[0,1,2,2,3,4,5])
+  write_mesh(f.name,polys,X)
+  assert open(f.name).read().split('\n')[-3:]==['f 1 2 3','f 3 4 5 6','']
+
+def test_ply_big_endian():
+  import struct
+  X = asarray([(0,.25,.5),(1,1.25,1.5),(2,2.25,2.5)])
+  f = named_tmpfile(suffix='.ply')
+  open(f.name,'wb').write(b'ply\nformat binary_big_endian 1.0\nelement vertex 3\nproperty double x\nproperty double y\n'
+    b'property double z\nproperty uchar red\nelement face 1\nproperty list uchar int vertex_indices\nend_header\n'
+    + b''.join(struct.pack('>dddB',x,y,z,7) for x,y,z in X) + struct.pack('>Biii',3,0,2,1))
+  soup,X2 = read_polygon_soup(f.name)
+  assert all(soup.counts==[3])
+  assert all(soup.vertices==[0,2,1])
+  assert all(X==X2)
+
+def test_native():
+  soup = torus_topology(4,5)
+  mesh = MutableTriangleTopology()
+  mesh.add_vertices(soup.nodes())
+  mesh.add_faces(soup.elements)
+  Xi = mesh.add_vertex_field('3d',vertex_position_id)
+  Fi = mesh.add_face_field('i',invalid_id)
+  Hi = mesh.add_halfedge_field('d',invalid_id)
+  mesh.field(Xi)[:] = random.randn(mesh.n_vertices,3)
+  mesh.field(Fi)[:] = arange(mesh.n_faces)
+  mesh.field(Hi)[:] = random.randn(3*mesh.n_faces)
+  f = named_tmpfile(suffix='.mesh')
+  write_native_mesh(f.name,mesh)
+  mesh2 = read_native_mesh(f.name)
+  mesh2.assert_consistent(True)
+  assert all(mesh.elements()==mesh2.elements())
+  for i in Xi,Fi,Hi:
+    assert all(mesh.field(i)==mesh2.field(i))
+
+  # The loaded mesh can be mutated without touching the file
+  mesh2.field(Fi)[:] = 7
+  mesh2.add_vertices(3)
+  mesh3 = read_native_mesh(f.name)
+  assert all(mesh3.field(Fi)==arange(mesh.n_faces))
+  assert mesh3.n_vertices==mesh.n_vertices
+
+def test_writer():
+  soup = torus_topology(4,5)
+  X = random.randn(soup.nodes(),3)
+  for ext in '.stl .ply .mesh'.split():
+    f = named_tmpfile(suffix=ext)
+    w = MeshWriter(f.name)
+    # Interleave batches, adding each face as soon as its vertices exist
+    for i in range(0,len(X),7):
+      assert w.add_vertices(X[i:i+7])==i
+      tris = soup.elements[(soup.elements.max(axis=1)>=i)&(soup.elements.max(axis=1)<i+7)]
+      w.add_faces(tris)
+    w.close()
+    assert w.closed and w.n_vertices==len(X) and w.n_faces==len(soup.elements)
+    if ext=='.mesh':
+      mesh = read_native_mesh(f.name)
+      mesh.assert_consistent(True)
+      assert all(mesh.field(vertex_position_id)==X)
+    else:
+      # Faces are reordered, so compare against a soup written in the same order
+      order = argsort(soup.elements.max(axis=1)//7,kind='mergesort')
+      g = named_tmpfile(suffix=ext)
+      write_mesh(g.name,TriangleSoup(soup.elements[order]),X)
+      assert open(f.name,'rb').read().split(b'end_header')[-1]==open(g.name,'rb').read().split(b'end_header')[-1]
+
+def test_reader():
+  soup = torus_topology(4,5)
+  X = random.randn(soup.nodes(),3)
+  for ext in '.ply .mesh'.split():
+    f = named_tmpfile(suffix=ext)
+    if ext=='.ply':
+      write_mesh(f.name,soup,X)
+      X = X.astype(float32).astype(float) # .ply files store floats
+    else:
+      mesh = MutableTriangleTopology()
+      mesh.add_vertices(soup.nodes())
+      mesh.add_faces(soup.elements)
+      mesh.field(mesh.add_vertex_field('3d',vertex_position_id))[:] = X
+      write_native_mesh(f.name,mesh)
+    r = MeshReader(f.name)
+    assert r.n_vertices==len(X) and r.n_faces==len(soup.elements)
+    assert all([all(r.vertex(v)==X[v]) for v in range(len(X))])
+    assert all([all(r.face(t)==soup.elements[t]) for t in range(len(soup.elements))])
+
+def test_compressed():
+  soup,X = icosahedron_mesh()
+  for bits in 8,16,24:
+    data = compress_mesh(soup,X,bits)
+    soup2,X2 = decompress_mesh(data)
+    assert len(soup2.elements)==len(soup.elements) and len(X2)==len(X)
+    # Vertices are renumbered, so match them up by position
+    step = (X.max(axis=0)-X.min(axis=0)).max()/(2**bits-1)
+    order = [argmin(magnitudes(X2-x)) for x in X]
+    assert absolute(X2[order]-X).max()<=step/2*1.0001
+    inverse = empty(len(X),int)
+    inverse[order] = arange(len(X))
+    key = lambda tris: sorted(tuple(roll(t,-argmin(t))) for t in tris)
+    assert key(inverse[soup2.elements])==key(soup.elements)
+
 if __name__=='__main__':
   test_io()
+  test_ply_big_endian()
+  test_native()
+  test_writer()
+  test_compressed()
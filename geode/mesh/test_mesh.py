@@ -3,7 +3,8 @@
 from __future__ import division
 
 from numpy import *
-from geode import Nested, PolygonSoup, SegmentSoup, TriangleSoup
+from geode import HeatGeodesic, Nested, PolygonSoup, SegmentSoup, TriangleSoup
+from geode.mesh import TriangleTopology, linear_subdivide, loop_subdivide, linear_subdivision_operator, loop_subdivision_operator
 from geode.geometry.platonic import icosahedron_mesh, sphere_mesh
 from geode.vector import relative_error
 
@@ -30,6 +31,21 @@ def test_bad():
   except AssertionError:
     pass
 
+def test_ear_clipped_mesh():
+  # A U shape in a tilted plane, which fans from its first vertex incorrectly
+  x = array([(0,0),(3,0),(3,3),(2,3),(2,1),(1,1),(1,3),(0,3)],dtype=float)
+  for flip in 0,1:
+    X = concatenate([x,x[:,:1]],axis=-1)
+    polys = PolygonSoup([3,len(x)],concatenate([[0,1,2],arange(len(x))[::-1] if flip else arange(len(x))]).astype(int32))
+    assert all(polys.triangle_mesh().elements[0]==[0,1,2])
+    tris = polys.ear_clipped_mesh(X).elements
+    assert tris.shape==(1+len(x)-2,3)
+    assert all(tris[0]==[0,1,2])
+    tris = X[tris[1:]]
+    areas = (1-2*flip)*cross(tris[:,1]-tris[:,0],tris[:,2]-tris[:,0])[:,2]/2
+    assert all(areas>0)
+    assert allclose(areas.sum(),7)
+
 def test_incident_segments():
   mesh = SegmentSoup([(0,1),(0,2)])
   incident = mesh.incident_elements()
@@ -65,6 +81,26 @@ def test_adjacent_triangles():
   mesh = TriangleSoup([(0,1,2),(2,1,3)])
   assert all(mesh.adjacent_elements()==[(-1,1,-1),(0,-1,-1)])
 
+def test_build_adjacency():
+  mesh,_ = sphere_mesh(3)
+  lazy = TriangleSoup(mesh.elements)
+  mesh.build_adjacency()
+  assert all(mesh.adjacent_elements()==lazy.adjacent_elements())
+  assert all(mesh.bending_tuples()==lazy.bending_tuples())
+  assert all(mesh.sorted_neighbors().flat==lazy.sorted_neighbors().flat)
+  assert all(mesh.edge_elements().offsets==2*arange(len(mesh.segment_soup().elements)+1))
+  # Nonmanifold meshes skip sorted_neighbors, which still throws when called
+  bowtie = TriangleSoup([(0,1,2),(0,3,4)])
+  bowtie.build_adjacency()
+  try:
+    bowtie.sorted_neighbors()
+    assert False
+  except RuntimeError:
+    pass
+  segments = SegmentSoup([(0,1),(1,2),(2,0),(2,3)])
+  segments.build_adjacency()
+  assert all(segments.adjacent_elements()==[(2,1),(0,2),(1,0),(1,-1)])
+
 def test_nodes_touched():
   mesh = TriangleSoup([(4,7,5)])
   assert all(mesh.nodes_touched()==[4,5,7])
@@ -145,3 +181,32 @@ def test_nonmanifold_triangles():
     mesh = TriangleSoup(ascontiguousarray(tris))
     assert all(mesh.nonmanifold_nodes(False)==sort(map[closed]))
     assert all(mesh.nonmanifold_nodes(True)==sort(map[open]))
+
+def test_subdivision_operator():
+  mesh,X = sphere_mesh(1)
+  corners = asarray([0,3],dtype=int32)
+  for loop in False,True:
+    if loop:
+      fine,A = loop_subdivision_operator(mesh,3,corners)
+      fine2,Y = loop_subdivide(mesh,X,steps=3,corners=corners)
+    else:
+      fine,A = linear_subdivision_operator(mesh,3)
+      fine2,Y = linear_subdivide(mesh,X,steps=3)
+    assert all(fine.elements==fine2.elements)
+    Z = empty_like(Y)
+    A.multiply(X,Z)
+    assert relative_error(Y,Z)<1e-10
+
+def test_heat_geodesic():
+  soup,X = sphere_mesh(4)
+  heat = HeatGeodesic(TriangleTopology(soup),X,1)
+  d = heat.distance(asarray([0],dtype=int32))
+  exact = arccos(clip(dot(X,X[0]),-1,1))
+  assert d[0]==0
+  assert abs(d-exact).max()<.06
+  # Parallel queries agree with single ones, and several sources take the nearest
+  sources = Nested([[0],[7],[0,7]],dtype=int32)
+  D = heat.distances(sources)
+  assert all(D[0]==d)
+  assert all(D[1]==heat.distance(asarray([7],dtype=int32)))
+  assert abs(D[2]-minimum(D[0],D[1])).max()<.1
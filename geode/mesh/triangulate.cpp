@@ -3,6 +3,12 @@
 #include <geode/exact/delaunay.h>
 #include <geode/exact/polygon_csg.h>
 #include <geode/exact/quantize.h>
+#include <geode/geometry/BoxTree.h>
+#include <geode/geometry/traverse.h>
+#include <geode/structure/UnionFind.h>
+#include <geode/utility/openmp.h>
+#include <exception>
+#include <vector>
 
 namespace geode {
 
@@ -104,14 +110,13 @@ static void erase_faces_outside_polygon(MutableTriangleTopology& topology, const
   topology.collect_garbage();
 }
 
-Tuple<Ref<TriangleTopology>,Field<Vec2,VertexId>> triangulate_polygon(const Nested<Vec2>& raw_polygons) {
-
-  const auto quant = quantizer(bounding_box(raw_polygons));
-
-
-  auto exact_union = exact_split_polygons_with_rule(amap(quant, raw_polygons), 0, FillRule::Greater);
+// Triangulate a group of quantized polygons.  If triangulation fails, the third entry is true and a mesh showing the
+// problem is returned instead.
+static Tuple<Ref<TriangleTopology>,Field<Vec2,VertexId>,bool>
+triangulate_exact_polygons(const Quantizer<real,2>& quant, const Nested<const Vector<Quantized,2>>& polygons) {
+  auto exact_union = exact_split_polygons_with_rule(polygons, 0, FillRule::Greater);
   auto edges = make_edges(exact_union);
-  
+
   constexpr int max_attempts = 10;
 
   for(int attempt = 0;; ++attempt) {
@@ -119,7 +124,7 @@ Tuple<Ref<TriangleTopology>,Field<Vec2,VertexId>> triangulate_polygon(const Nest
       Ref<MutableTriangleTopology> topology = exact_delaunay_points(exact_union.flat, edges)->mutate();
       // exact_delaunay_points triangulates the full convex hull. This functions cleans up anything that wasn't inside the actual polygons
       erase_faces_outside_polygon(topology, edges);
-      return {topology, Field<Vec2,VertexId>{amap(quant.inverse,exact_union.flat).copy()}};
+      return {topology, Field<Vec2,VertexId>{amap(quant.inverse,exact_union.flat).copy()}, false};
     } catch(const DelaunayConstraintConflict& e) {
       if(attempt < max_attempts) {
         // exact_split_polygons_with_rule should resolve most self intersections, but could create new ones when it approximates intersections
@@ -132,10 +137,107 @@ Tuple<Ref<TriangleTopology>,Field<Vec2,VertexId>> triangulate_polygon(const Nest
       }
       else {
         // Return a mesh that shows where the problem is
-        return generate_debug_mesh(quant, exact_union.flat, e);
+        const auto debug = generate_debug_mesh(quant, exact_union.flat, e);
+        return {debug.x, debug.y, true};
+      }
+    }
+  }
+}
+
+namespace {
+struct PolygonOverlaps {
+  const BoxTree<Vector<Quantized,2>>& tree;
+  UnionFind& union_find;
+
+  PolygonOverlaps(const BoxTree<Vector<Quantized,2>>& tree, UnionFind& union_find)
+    : tree(tree), union_find(union_find) {}
+
+  bool cull(const int n) const { return false; }
+  bool cull(const int n0, const int n1) const { return false; }
+  void leaf(const int n) const {}
+  void leaf(const int n0, const int n1) {
+    for (const int i : tree.prims(n0))
+      for (const int j : tree.prims(n1))
+        union_find.merge(i,j);
+  }
+};
+}
+
+// Polygons whose quantized bounding boxes are disjoint can't interact under the union, and the interior of each piece is
+// bounded by constraint edges, so its constrained Delaunay triangulation doesn't see points outside.  We therefore group
+// polygons with overlapping boxes, triangulate the groups in parallel, and concatenate the results.
+Tuple<Ref<TriangleTopology>,Field<Vec2,VertexId>> triangulate_polygon(const Nested<Vec2>& raw_polygons) {
+
+  const auto quant = quantizer(bounding_box(raw_polygons));
+  const auto polygons = amap(quant, raw_polygons).copy();
+
+  // Group polygons with overlapping boxes
+  const int n = polygons.size();
+  std::vector<Nested<const Vector<Quantized,2>>> groups;
+  if (n > 1) {
+    Array<Box<Vector<Quantized,2>>> boxes(n, uninit);
+    for (const int p : range(n))
+      boxes[p] = bounding_box(polygons[p]);
+    UnionFind union_find(n);
+    const auto tree = new_<BoxTree<Vector<Quantized,2>>>(boxes,1);
+    PolygonOverlaps overlaps(tree,union_find);
+    double_traverse(*tree,overlaps);
+    Array<int> group(n);
+    group.fill(-1);
+    std::vector<Nested<Vector<Quantized,2>,false>> pending;
+    for (const int p : range(n)) {
+      int& g = group[union_find.find(p)];
+      if (g < 0) {
+        g = int(pending.size());
+        pending.push_back(Nested<Vector<Quantized,2>,false>());
+      }
+      pending[g].append(polygons[p]);
+    }
+    if (pending.size() > 1)
+      for (auto& g : pending)
+        groups.push_back(g.freeze());
+  }
+  if (groups.size() <= 1) {
+    const auto r = triangulate_exact_polygons(quant, polygons);
+    return {r.x, r.y};
+  }
+
+  // Triangulate each group independently
+  const int count = int(groups.size());
+  std::vector<Ptr<TriangleTopology>> topologies(count);
+  std::vector<Field<Vec2,VertexId>> positions(count);
+  std::vector<char> failed(count);
+  std::exception_ptr error;
+  #pragma omp parallel for schedule(dynamic,1)
+  for (int g=0;g<count;g++) {
+    try {
+      const auto r = triangulate_exact_polygons(quant, groups[g]);
+      topologies[g] = r.x;
+      positions[g] = r.y;
+      failed[g] = r.z;
+    } catch (...) {
+      #pragma omp critical
+      {
+        if (!error)
+          error = std::current_exception();
       }
     }
   }
+  if (error)
+    std::rethrow_exception(error);
+
+  // Concatenate, or report the first failure
+  Array<Vector<int,3>> faces;
+  Field<Vec2,VertexId> X;
+  for (const int g : range(count)) {
+    if (failed[g])
+      return {ref(*topologies[g]), positions[g]};
+    const int offset = X.size();
+    for (const auto& f : topologies[g]->elements())
+      faces.append(f+offset);
+    X.flat.extend(positions[g].flat);
+  }
+  return {new_<TriangleTopology>(faces, X.size()), X};
 }
 
 } // geode namespace
\ No newline at end of file
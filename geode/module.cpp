@@ -19,8 +19,8 @@ GEODE_PYTHON_MODULE(geode_wrap) {
   GEODE_WRAP(utility)
 
 #ifdef GEODE_PYTHON
-  // Check for python exceptions in check_interrupts()
-  add_interrupt_checker(check_python_interrupts);
+  // Let ctrl-c stop long computations
+  install_interrupt_handler();
 #endif
 
   GEODE_WRAP(math)
@@ -2,14 +2,231 @@
 // Class Buffer
 //#####################################################################
 #include <geode/python/Buffer.h>
-using namespace geode;
+#include <geode/array/arena.h>
+#include <geode/utility/memory_accounting.h>
+#include <atomic>
+#include <climits>
+#include <cstdlib>
+#include <vector>
+#ifdef _WIN32
+#include <malloc.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+namespace geode {
 
-// Must match memory allocation routine in header
-#ifndef _WIN32
-#define free_buffer free
+// Every Buffer is preceded by a Header recording how its block was allocated.  Small blocks come straight from
+// malloc, whose per-thread caches are hard to beat, with data 16 byte aligned right after the Buffer head.  Larger
+// blocks are padded so that data starts 64 bytes in.
+namespace {
+enum Kind { Heap, Aligned, Mapped, InArena };
+struct Header {
+  union {
+    size_t size; // Block size in bytes, for mapped blocks
+    Arena* arena; // Owning arena, for arena blocks
+  };
+  int kind;
+  bool counted; // Whether the block was counted by memory accounting.  Arena blocks are counted with their chunks.
+};
+}
+static_assert(sizeof(Header)==16,"Header must keep Buffer 16 byte aligned");
+static const size_t heap_offset = 32, aligned_offset = 64; // Offsets of data from the start of each kind of block
+
+static std::atomic<size_t> align_threshold(1024);
+static std::atomic<size_t> map_threshold(size_t(16)<<20);
+
+BufferPolicy buffer_policy() {
+  BufferPolicy policy;
+  policy.align_threshold = align_threshold.load(std::memory_order_relaxed);
+  policy.map_threshold = map_threshold.load(std::memory_order_relaxed);
+  return policy;
+}
+
+void set_buffer_policy(const BufferPolicy& policy) {
+  align_threshold.store(policy.align_threshold,std::memory_order_relaxed);
+  map_threshold.store(policy.map_threshold,std::memory_order_relaxed);
+}
+
+static char* aligned_malloc(const size_t size) {
+#if defined(__MINGW32__)
+  // MinGW headers break declaration of _aligned_malloc unless you are very careful about include order
+  return (char*)__mingw_aligned_malloc(size,64);
+#elif defined(_WIN32)
+  return (char*)_aligned_malloc(size,64);
 #else
-#define free_buffer _aligned_free
+  void* memory;
+  return posix_memalign(&memory,64,size) ? 0 : (char*)memory;
 #endif
+}
+
+static void aligned_free(char* block) {
+#if defined(__MINGW32__)
+  __mingw_aligned_free(block);
+#elif defined(_WIN32)
+  _aligned_free(block);
+#else
+  free(block);
+#endif
+}
+
+// Arenas hand out pieces of large chunks, and are freed once their scope has ended and every buffer in them has
+// been released.  Only the owning thread allocates, so allocations are counted without atomics.  Releases may come
+// from any thread, and the scope counts as one release when it closes.  Until then, total is too large to reach.
+struct Arena {
+  Arena* const previous; // Enclosing arena on the same thread
+  int allocated;
+  std::atomic<int> released, total;
+  std::vector<char*> chunks;
+  char *next, *end; // Free space in the last chunk
+  int64_t counted; // Bytes of chunks counted by memory accounting
+
+  Arena(Arena* previous)
+    : previous(previous), allocated(0), released(0), total(INT_MAX), next(0), end(0), counted(0) {}
+
+  ~Arena() {
+    for (char* chunk : chunks)
+      aligned_free(chunk);
+    if (counted)
+      memory_detail::add(-counted);
+  }
+};
+
+static const size_t arena_chunk = 64<<10, arena_max = arena_chunk/8; // Larger blocks bypass the arena
+static std::atomic<int> arenas_open(0); // Lets allocate skip the thread local lookup when no arena is open anywhere
+static thread_local Arena* current_arena = 0;
+
+static void release(Arena* arena) {
+  if (arena->released.fetch_add(1)+1==arena->total.load())
+    delete arena;
+}
+
+ArenaScope::ArenaScope()
+  : arena(new Arena(current_arena)) {
+  current_arena = arena;
+  arenas_open++;
+}
+
+ArenaScope::~ArenaScope() {
+  GEODE_ASSERT(current_arena==arena);
+  current_arena = arena->previous;
+  arenas_open--;
+  arena->total = arena->allocated+1;
+  release(arena);
+}
+
+ArenaPause::ArenaPause()
+  : arena(current_arena) {
+  current_arena = 0;
+}
+
+ArenaPause::~ArenaPause() {
+  current_arena = arena;
+}
+
+bool arena_owned(PyObject* owner) {
+  return owner && GEODE_PY_TYPE(owner)==&Buffer::pytype && ((Header*)owner)[-1].kind==InArena;
+}
+
+// Carve a block with data at the given offset from an arena, or return null if out of memory
+static char* arena_block(Arena* const arena, const size_t offset, const size_t bytes) {
+  const size_t align = offset==aligned_offset ? 64 : 16,
+               size = (offset+bytes+15)&~size_t(15);
+  char* block = (char*)(((size_t)arena->next+align-1)&~(align-1));
+  if (!arena->next || block+size>arena->end) {
+    block = aligned_malloc(arena_chunk);
+    if (!block)
+      return 0;
+    arena->chunks.push_back(block);
+    arena->end = block+arena_chunk;
+    if (memory_accounting()) {
+      memory_detail::add(arena_chunk);
+      arena->counted += arena_chunk;
+    }
+  }
+  arena->next = block+size;
+  arena->allocated++;
+  return block;
+}
+
+Buffer* Buffer::allocate(const size_t bytes) {
+  if (bytes>SIZE_MAX-4096-aligned_offset)
+    throw std::bad_alloc();
+  Arena* arena;
+  if (bytes<=arena_max && arenas_open.load(std::memory_order_relaxed) && (arena = current_arena)) {
+    const size_t offset = bytes<align_threshold.load(std::memory_order_relaxed) ? heap_offset : aligned_offset;
+    if (char* block = arena_block(arena,offset,bytes)) {
+      Buffer* self = (Buffer*)(block+offset-offsetof(Buffer,data));
+      Header& header = ((Header*)self)[-1];
+      header.arena = arena;
+      header.kind = InArena;
+      return GEODE_PY_OBJECT_INIT(self,&pytype);
+    }
+  }
+  const size_t threshold = map_threshold.load(std::memory_order_relaxed);
+  Kind kind;
+  size_t size;
+  char* block;
+  if (bytes<align_threshold.load(std::memory_order_relaxed)) {
+    kind = Heap;
+    size = heap_offset+bytes;
+    block = (char*)malloc(size);
+  }
+#ifndef _WIN32
+  else if (threshold && aligned_offset+bytes>=threshold) {
+    kind = Mapped;
+    const size_t page = sysconf(_SC_PAGESIZE);
+    size = (aligned_offset+bytes+page-1)/page*page;
+    void* map = mmap(0,size,PROT_READ|PROT_WRITE,MAP_PRIVATE|MAP_ANONYMOUS,-1,0);
+    block = map==MAP_FAILED ? 0 : (char*)map;
+#ifdef MADV_HUGEPAGE
+    if (block)
+      madvise(block,size,MADV_HUGEPAGE);
+#endif
+  }
+#endif
+  else {
+    kind = Aligned;
+    size = aligned_offset+bytes;
+    block = aligned_malloc(size);
+  }
+  if (!block)
+    throw std::bad_alloc();
+  char* const data = block+(kind==Heap ? heap_offset : aligned_offset);
+  Buffer* self = (Buffer*)(data-offsetof(Buffer,data));
+  Header& header = ((Header*)self)[-1];
+  header.size = size;
+  header.kind = kind;
+  header.counted = memory_accounting();
+  if (header.counted)
+    memory_detail::add(size);
+  return GEODE_PY_OBJECT_INIT(self,&pytype);
+}
+
+static void free_buffer(PyObject* object) {
+  const Header& header = ((Header*)object)[-1];
+  char* const data = (char*)object+offsetof(Buffer,data);
+  if (header.kind!=InArena && header.counted)
+    memory_detail::add(-int64_t(header.size));
+  switch (header.kind) {
+    case Heap:
+      free(data-heap_offset);
+      break;
+    case InArena:
+      release(header.arena);
+      break;
+#ifndef _WIN32
+    case Mapped:
+      munmap(data-aligned_offset,header.size);
+      break;
+#endif
+    default:
+      aligned_free(data-aligned_offset);
+  }
+}
+
+}
+using namespace geode;
 
 #ifdef GEODE_PYTHON
 
@@ -19,7 +236,7 @@ PyTypeObject Buffer::pytype = {
     "geode.Buffer",             // tp_name
     sizeof(Buffer),             // tp_basicsize
     0,                          // tp_itemsize
-    (destructor)free_buffer,    // tp_dealloc
+    free_buffer,                // tp_dealloc
     0,                          // tp_print
     0,                          // tp_getattr
     0,                          // tp_setattr
@@ -62,7 +279,7 @@ PyTypeObject Buffer::pytype = {
 
 PyTypeObject Buffer::pytype = {
   "geode.Buffer",                  // tp_name
-  (void(*)(PyObject*))free_buffer, // tp_dealloc
+  free_buffer,                     // tp_dealloc
 };
 
 #endif
@@ -6,6 +6,14 @@
 // Since it's a python object, it has a reference count, and can be shared.
 // No destructors are called, so is_trivially_destructible<T> must be true.
 //
+// BufferPolicy controls how memory is obtained.  Small buffers come straight
+// from malloc with 16 byte aligned data, since mesh code creates and drops
+// many tiny arrays.  Larger buffers have 64 byte aligned data, matching cache
+// lines and the widest vector loads.  Very large buffers are mapped directly
+// and advised to use huge pages.  Mapped pages are untouched until first
+// written, so filling a large uninit array in parallel places each page on
+// the node of the thread that writes it.
+//
 //#####################################################################
 #pragma once
 
@@ -13,8 +21,9 @@
 #include <geode/python/forward.h>
 #include <geode/utility/config.h>
 #include <geode/utility/type_traits.h>
-#include <stdlib.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <new>
 namespace geode {
 
 struct Buffer {
@@ -28,24 +37,28 @@ private:
   void operator=(const Buffer&);
 public:
 
-  template<class T> static Buffer* new_(const int m) {
+  // Sizes are computed in size_t, so callers may pass element counts that don't fit in an int
+  template<class T> static Buffer* new_(const size_t m) {
     static_assert(is_trivially_destructible<T>::value,"Array<T> never calls destructors, so T cannot have any");
-
-#if defined(__MINGW32__)
-    // MinGW headers break declaration of _aligned_malloc unless you are very careful about include order
-    // We use __mingw_aligned_malloc which seems more robust
-    Buffer* self = (Buffer*)__mingw_aligned_malloc(16+m*sizeof(T),16);
-#elif defined(_WIN32)
-    // Windows doesn't guarantee 16 byte alignment, so use _aligned_malloc
-    Buffer* self = (Buffer*)_aligned_malloc(16+m*sizeof(T),16);
-#else
-    // On other platforms, malloc should be 16 byte aligned
-    Buffer* self = (Buffer*)malloc(16+m*sizeof(T));
-#endif
-    return GEODE_PY_OBJECT_INIT(self,&pytype);
+    if (m>(SIZE_MAX-64)/sizeof(T))
+      throw std::bad_alloc();
+    return allocate(m*sizeof(T));
   }
+
+  // Allocate a buffer with room for the given number of bytes, throwing std::bad_alloc on failure
+  GEODE_CORE_EXPORT static Buffer* allocate(const size_t bytes);
 };
 
+struct BufferPolicy {
+  size_t align_threshold; // Buffers of at least this many bytes have 64 byte aligned data
+  size_t map_threshold; // Map buffers of at least this many bytes directly and advise huge pages.  0 disables.
+};
+
+// The policy applies to buffers allocated after it is set.  Each buffer remembers how it was allocated, so
+// changing the policy is always safe.
+GEODE_CORE_EXPORT BufferPolicy buffer_policy();
+GEODE_CORE_EXPORT void set_buffer_policy(const BufferPolicy& policy);
+
 // Check alignment constraints
 static_assert(offsetof(Buffer,data)==16,"data must be 16 byte aligned for SSE purposes");
 
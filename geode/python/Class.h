@@ -387,6 +387,10 @@ const_field(S T::* field) {
 #define GEODE_METHOD(method_) \
   GEODE_METHOD_2(#method_,method_)
 
+// Release the GIL while the method runs.  See gil.h.
+#define GEODE_METHOD_WITHOUT_GIL(method_) \
+  method(#method_,without_gil(&Self::method_))
+
 #define GEODE_OVERLOADED_METHOD_2(type,name,method_) \
   method(name,static_cast<type>(&Self::method_))
 
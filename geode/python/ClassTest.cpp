@@ -10,6 +10,8 @@
 #include <geode/python/Object.h>
 #include <geode/python/Ptr.h>
 #include <geode/python/Ref.h>
+#include <chrono>
+#include <thread>
 namespace geode {
 namespace {
 
@@ -37,6 +39,12 @@ public:
   int normal(int x) {return 2*x;}
   virtual int virtual_(int x) {return 3*x;}
   static int static_(int x) {return 5*x;}
+
+  // Wrapped without the GIL, so that several threads can sleep at once
+  int nap(int x, double seconds) const {
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    return 6*x;
+  }
   int operator()(int x) {return 4*x;}
   int prop() const {return 17;}
   int data() const {return data_;}
@@ -136,6 +144,7 @@ void wrap_test_class() {
       .GEODE_METHOD(normal)
       .GEODE_METHOD(virtual_)
       .GEODE_METHOD(static_)
+      .GEODE_METHOD_WITHOUT_GIL(nap)
       .GEODE_CALL(int)
       .GEODE_GET(prop)
       .GEODE_GETSET(data)
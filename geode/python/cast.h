@@ -9,7 +9,7 @@ namespace geode {
 #ifdef GEODE_PYTHON
 
 template<class T> static inline bool is_instance(PyObject* object) {
-  return PyObject_IsInstance(object,(PyObject*)&T::pytype)!=0;
+  return object->ob_type==&T::pytype || PyType_IsSubtype(object->ob_type,&T::pytype);
 }
 
 #else // Non-python stub.  For now, this detects only exact matches.
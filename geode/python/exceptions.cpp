@@ -130,6 +130,7 @@ INSTANTIATE(OverflowError)
 INSTANTIATE(ZeroDivisionError)
 INSTANTIATE(ReferenceError)
 INSTANTIATE(ImportError)
+INSTANTIATE(InterruptError)
 
 }
 using namespace geode;
@@ -151,6 +152,7 @@ void wrap_exceptions() {
   register_python_exception<ZeroDivisionError>(PyExc_ZeroDivisionError);
   register_python_exception<ReferenceError>(PyExc_ReferenceError);
   register_python_exception<ImportError>(PyExc_ImportError);
+  register_python_exception<InterruptError>(PyExc_KeyboardInterrupt);
 
   GEODE_FUNCTION(redefine_assertion_error)
 #endif
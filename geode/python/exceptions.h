@@ -82,6 +82,7 @@ GEODE_SIMPLE_EXCEPTION(ArithmeticError,RuntimeError)
   GEODE_SIMPLE_EXCEPTION(ZeroDivisionError,ArithmeticError)
 GEODE_SIMPLE_EXCEPTION(ReferenceError,RuntimeError)
 GEODE_SIMPLE_EXCEPTION(ImportError,RuntimeError)
+GEODE_SIMPLE_EXCEPTION(InterruptError,RuntimeError) // Raised by check_interrupts
 
 #undef GEODE_SIMPLE_EXCEPTION
 
@@ -14,6 +14,9 @@ bool FromPython<bool>::convert(PyObject* object) {
 }
 
 long FromPython<long>::convert(PyObject* object) {
+  // Plain ints are exact, so skip the comparison below
+  if (PyInt_CheckExact(object))
+    return PyInt_AS_LONG(object);
   long i = PyInt_AsLong(object);
   if (i==-1 && PyErr_Occurred()) throw_python_error();
   // Check that we had an exact integer
@@ -109,6 +112,8 @@ float FromPython<float>::convert(PyObject* object) {
 }
 
 double FromPython<double>::convert(PyObject* object) {
+  if (PyFloat_CheckExact(object))
+    return PyFloat_AS_DOUBLE(object);
   double d = PyFloat_AsDouble(object);
   if (d==-1 && PyErr_Occurred()) // -1 either means error or that the value really was -1
     throw_python_error();
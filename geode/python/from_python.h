@@ -68,7 +68,8 @@ template<class T> struct FromPython<T&,typename enable_if<is_base_of<Object,T>>:
 convert(PyObject* object) {
   if (!is_same<T,Object>::value && &T::pytype==&T::Base::pytype)
     unregistered_python_type(object,&T::pytype,GEODE_DEBUG_FUNCTION_NAME);
-  if (!PyObject_IsInstance(object,(PyObject*)&T::pytype))
+  // Check the exact type first, and avoid the generic PyObject_IsInstance machinery since our types don't override it
+  if (object->ob_type!=&T::pytype && !PyType_IsSubtype(object->ob_type,&T::pytype))
     throw_type_error(object,&T::pytype);
   return *(T*)(object+1);
 }};
@@ -0,0 +1,65 @@
+//#####################################################################
+// Releasing the global interpreter lock
+//#####################################################################
+//
+// Wrapped functions normally run with the GIL held, so a long geometric
+// computation called from one Python thread stalls all the others.
+// Registering a function or method with GEODE_FUNCTION_WITHOUT_GIL or
+// GEODE_METHOD_WITHOUT_GIL (or passing without_gil(f) to function() or
+// Class::method) converts its arguments with the GIL held, releases it
+// for the call, and reacquires it before converting the result.
+//
+// This is opt-in because the call must not touch Python while the lock is
+// released: it must not call back into Python, raise through Python, or
+// share the argument objects with other threads, since copying or
+// dropping an Array or Ref adjusts the owner's Python reference count.
+// Pure computations on their inputs, such as split_soup, are fine.
+//
+//#####################################################################
+#pragma once
+
+#include <geode/python/config.h>
+#include <utility>
+namespace geode {
+
+// A function or method to be called without the GIL
+template<class F> struct WithoutGIL {
+  F f;
+};
+
+template<class F> static inline WithoutGIL<F> without_gil(const F f) {
+  const WithoutGIL<F> w = {f};
+  return w;
+}
+
+#ifdef GEODE_PYTHON
+
+// Release the GIL for the lifetime of this object
+struct ReleaseGIL {
+  PyThreadState* const state;
+
+  ReleaseGIL()
+    : state(PyEval_SaveThread()) {}
+
+  ~ReleaseGIL() {
+    PyEval_RestoreThread(state);
+  }
+
+  ReleaseGIL(const ReleaseGIL&) = delete;
+  void operator=(const ReleaseGIL&) = delete;
+};
+
+// Call f(args...) without the GIL.  The result is constructed before the GIL is reacquired.
+template<class R,class F,class... Args> static inline R call_without_gil(const F& f, Args&&... args) {
+  const ReleaseGIL release;
+  return f(std::forward<Args>(args)...);
+}
+
+template<class R,class T,class M,class... Args> static inline R call_method_without_gil(T* self, const M method,
+                                                                                      Args&&... args) {
+  const ReleaseGIL release;
+  return (self->*method)(std::forward<Args>(args)...);
+}
+
+#endif
+}
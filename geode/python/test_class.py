@@ -76,6 +76,19 @@ def test_methods():
   assert c.static_(3)==15
   assert c(6)==24
 
+def test_without_gil():
+  import threading,time
+  c = ClassTest(Object())
+  assert c.nap(2,0)==12
+  # Four naps of .2 seconds should overlap if the GIL is released
+  start = time.time()
+  threads = [threading.Thread(target=c.nap,args=(i,.2)) for i in xrange(4)]
+  for t in threads:
+    t.start()
+  for t in threads:
+    t.join()
+  assert time.time()-start<.6
+
 def test_prop():
   c = ClassTest(Object())
   assert c.prop==17
@@ -2,6 +2,7 @@
 #pragma once
 
 #include <geode/python/config.h>
+#include <geode/python/gil.h>
 #include <geode/utility/config.h>
 #ifdef GEODE_PYTHON
 #include <geode/python/wrap_function.h>
@@ -31,6 +32,9 @@ template<class Function> static inline void function(const char* name, Function
 #define GEODE_FUNCTION(name) ::geode::python::function(#name,name);
 #define GEODE_FUNCTION_2(name,...) ::geode::python::function(#name,__VA_ARGS__);
 
+// Release the GIL while the function runs.  See gil.h for the restrictions this places on the function.
+#define GEODE_FUNCTION_WITHOUT_GIL(name) ::geode::python::function(#name,::geode::without_gil(name));
+
 #define GEODE_OVERLOADED_FUNCTION_2(type,name,function_) ::geode::python::function(name,(type)function_);
 
 #define GEODE_OVERLOADED_FUNCTION(type,function_) GEODE_OVERLOADED_FUNCTION_2(type,#function_,function_);
@@ -15,6 +15,7 @@
 
 #include <geode/python/config.h>
 #include <geode/python/exceptions.h>
+#include <geode/python/gil.h>
 #include <geode/python/outer_wrapper.h>
 #include <geode/python/utility.h>
 #include <geode/utility/config.h>
@@ -44,6 +45,26 @@ wrap_function(const char* name,R (*function)(Args...)) {
   return wrap_function_helper(name,wrapped_function<decltype(function),R>(typename Enumerate<Args...>::type()),(void*)function);
 }
 
+// As function_inner_wrapper, but releasing the GIL for the call.  Converted arguments are temporaries of the outer
+// call, so they are destroyed after the GIL is reacquired.
+template<class F,class R,class... Args> inline R
+function_inner_wrapper_without_gil(PyObject* args,void* wrapped) {
+  Py_ssize_t size = PyTuple_GET_SIZE(args);
+  const int desired = sizeof...(Args);
+  if (size!=desired) throw_arity_mismatch(desired,size);
+  return call_without_gil<R>((F)wrapped,convert_item<Args>(args)...);
+}
+
+template<class F,class R,class... Args> static FunctionWrapper wrapped_function_without_gil(Types<Args...>) {
+  return OuterWrapper<R,PyObject*,void*>::template wrap<function_inner_wrapper_without_gil<F,R,Args...>>;
+}
+
+template<class R,class... Args> static PyObject*
+wrap_function(const char* name,WithoutGIL<R(*)(Args...)> function) {
+  return wrap_function_helper(name,wrapped_function_without_gil<decltype(function.f),R>(
+    typename Enumerate<Args...>::type()),(void*)function.f);
+}
+
 #else // Unpleasant nonvariadic versions
 
 #define GEODE_WRAP_FUNCTION(n,ARGS,Args) \
@@ -19,6 +19,7 @@
 #include <geode/python/config.h>
 #include <geode/python/exceptions.h>
 #include <geode/python/from_python.h>
+#include <geode/python/gil.h>
 #include <geode/python/to_python.h>
 #include <geode/python/outer_wrapper.h>
 #include <geode/utility/config.h>
@@ -60,6 +61,39 @@ wrap_method(const char* name,R (B::*method)(Args...) const) {
   return wrap_method_helper(&T::pytype,name,wrapped_method<T,M,R>(typename Enumerate<Args...>::type()),(void*)new M(method));
 }
 
+// As method_inner_wrapper, but releasing the GIL for the call
+template<class M,class R,class T,class... Args> R
+method_inner_wrapper_without_gil(PyObject* self,PyObject* args,void* method) {
+  Py_ssize_t size = PyTuple_GET_SIZE(args);
+  const int desired = sizeof...(Args);
+  if (size!=desired) throw_arity_mismatch(desired,size);
+  return call_method_without_gil<R>(GetSelf<T>::get(self),*(M*)method,convert_item<Args>(args)...);
+}
+
+template<class T,class M,class R,class... Args> static wrapperfunc wrapped_method_without_gil(Types<Args...>) {
+  return OuterWrapper<R,PyObject*,PyObject*,void*>::template wrap<method_inner_wrapper_without_gil<M,R,T,Args...> >;
+}
+
+// wrap_method for static, nonconst, and const methods called without the GIL
+template<class T,class W,class R,class... Args> static PyObject*
+wrap_method(const char* name,WithoutGIL<R(*)(Args...)> method) {
+  return wrap_function(name,method);
+}
+
+template<class T,class W,class R,class B,class... Args> static PyObject*
+wrap_method(const char* name,WithoutGIL<R (B::*)(Args...)> method) {
+  typedef R (B::*M)(Args...);
+  return wrap_method_helper(&T::pytype,name,wrapped_method_without_gil<T,M,R>(typename Enumerate<Args...>::type()),
+                            (void*)new M(method.f));
+}
+
+template<class T,class W,class R,class B,class... Args> static PyObject*
+wrap_method(const char* name,WithoutGIL<R (B::*)(Args...) const> method) {
+  typedef R (B::*M)(Args...) const;
+  return wrap_method_helper(&T::pytype,name,wrapped_method_without_gil<T,M,R>(typename Enumerate<Args...>::type()),
+                            (void*)new M(method.f));
+}
+
 #else // Unpleasant nonvariadic versions
 
 #define GEODE_WRAP_METHOD(n,ARGS,Args) \
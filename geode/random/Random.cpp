@@ -2,10 +2,12 @@
 // Class Random
 //#####################################################################
 #include <geode/random/Random.h>
+#include <geode/math/constants.h>
 #include <geode/python/Class.h>
 #include <geode/vector/Frame.h>
 #include <geode/vector/Rotation.h>
 #include <geode/python/stl.h>
+#include <geode/utility/parallel.h>
 namespace geode {
 
 GEODE_DEFINE_TYPE(Random)
@@ -20,6 +22,18 @@ Random::Random(uint128_t seed)
 
 Random::~Random() {}
 
+Ref<Random> Random::substream(const uint128_t i) const {
+  // Derive a key from counters which the stream itself only reaches after 2^127 blocks
+  return new_<Random>(threefry(seed,(uint128_t(1)<<127)|i));
+}
+
+void Random::skip(const uint128_t n) {
+  counter += n;
+  free_bit_count = 0;
+  free_bits = 0;
+  free_gaussian = 0;
+}
+
 template<class Int, int N> Int Random::n_bits() {
   const int width = N;
   if (free_bit_count<width) {
@@ -83,6 +97,90 @@ real Random::normal() {
   }
 }
 
+// Items per chunk of a bulk call
+static const int bulk_chunk = 4096;
+
+// Take the counters for n items with words_per_item 64 bit words each, and call f(lo,hi,words) for chunks [lo,hi) in
+// parallel, where words holds the threefry output for the chunk.  Chunk c always uses the same counters.
+template<class F> void Random::bulk(const int n, const int words_per_item, const F& f) {
+  GEODE_ASSERT(n>=0 && words_per_item>0);
+  const int chunks = (n+bulk_chunk-1)/bulk_chunk,
+            counters = (bulk_chunk*words_per_item+1)/2; // Per chunk
+  const uint128_t base = counter;
+  counter += uint128_t(uint64_t(chunks))*uint64_t(counters);
+  const uint128_t key = seed;
+  parallel_for(chunks,[&](const int c) {
+    const int lo = bulk_chunk*c, hi = min(n,lo+bulk_chunk);
+    vector<uint64_t> words(((hi-lo)*words_per_item+1)&~1); // A short last chunk skips its unused counters
+    threefry_fill(key,base+uint128_t(uint64_t(c))*uint64_t(counters),RawArray<uint64_t>(int(words.size()),words.data()));
+    f(lo,hi,words.data());
+  });
+}
+
+// Uniform in [0,1) and (0,1] with 53 bits
+static inline double unit_closed_open(const uint64_t w) { return ldexp(double(w>>11),-53); }
+static inline double unit_open_closed(const uint64_t w) { return ldexp(double((w>>11)+1),-53); }
+
+template<class T> void Random::fill_uniform_helper(RawArray<T> x, const T a, const T b) {
+  assert(a<b);
+  const double scale = double(b)-a;
+  bulk(x.size(),1,[&](const int lo, const int hi, const uint64_t* words) {
+    for (int i=lo;i<hi;i++)
+      x[i] = T(min(a+scale*unit_closed_open(words[i-lo]),double(nexttoward(b,a)))); // Rounding mustn't reach b
+  });
+}
+
+void Random::fill_uniform(RawArray<float> x, const float a, const float b) { fill_uniform_helper(x,a,b); }
+void Random::fill_uniform(RawArray<double> x, const double a, const double b) { fill_uniform_helper(x,a,b); }
+
+// Box-Muller on a pair of words
+static inline Vector<double,2> box_muller(const uint64_t w0, const uint64_t w1) {
+  const double r = sqrt(-2*log(unit_open_closed(w0))),
+               t = 2*pi*unit_closed_open(w1);
+  return r*vec(cos(t),sin(t));
+}
+
+template<class T> void Random::fill_normal_helper(RawArray<T> x) {
+  bulk(x.size(),1,[&](const int lo, const int hi, const uint64_t* words) {
+    for (int i=lo;i<hi;i+=2) {
+      const auto z = box_muller(words[i-lo],words[i-lo+1]); // words has even length, so i-lo+1 is in bounds
+      x[i] = T(z.x);
+      if (i+1<hi)
+        x[i+1] = T(z.y);
+    }
+  });
+}
+
+void Random::fill_normal(RawArray<float> x) { fill_normal_helper(x); }
+void Random::fill_normal(RawArray<double> x) { fill_normal_helper(x); }
+
+template<class TV> void Random::fill_unit_ball_helper(RawArray<TV> x) {
+  // A uniform direction from normals, scaled by a radius with density proportional to r^(d-1).  Unlike rejection,
+  // every item takes the same words, so the loop is branch free.
+  typedef typename TV::Scalar T;
+  const int d = TV::m, pairs = (d+1)/2, k = 2*pairs+1;
+  bulk(x.size(),k,[&](const int lo, const int hi, const uint64_t* words) {
+    for (int i=lo;i<hi;i++) {
+      const uint64_t* w = words+k*(i-lo);
+      Vector<double,TV::m> u;
+      for (int p=0;p<pairs;p++) {
+        const auto z = box_muller(w[2*p],w[2*p+1]);
+        u[2*p] = z.x;
+        if (2*p+1<d)
+          u[2*p+1] = z.y;
+      }
+      const double mag = u.magnitude(),
+                   r = pow(unit_closed_open(w[k-1]),1./d);
+      x[i] = mag ? TV(r/mag*u) : TV();
+    }
+  });
+}
+
+void Random::fill_unit_ball(RawArray<Vector<float,2>> x) { fill_unit_ball_helper(x); }
+void Random::fill_unit_ball(RawArray<Vector<float,3>> x) { fill_unit_ball_helper(x); }
+void Random::fill_unit_ball(RawArray<Vector<double,2>> x) { fill_unit_ball_helper(x); }
+void Random::fill_unit_ball(RawArray<Vector<double,3>> x) { fill_unit_ball_helper(x); }
+
 // The result should consist of all (dependent) binomially distributed random values
 static vector<Array<int>> random_bits_test(Random& random, int steps) {
   vector<Array<int>> all;
@@ -126,15 +224,24 @@ static vector<Array<int>> random_bits_test(Random& random, int steps) {
 
 Array<real> Random::normal_py(int size) {
   Array<real> result(size,uninit);
-  for (auto& x : result)
-    x = normal();
+  fill_normal(result);
   return result;
 }
 
 Array<real> Random::uniform_py(int size) {
   Array<real> result(size,uninit);
-  for (auto& x : result)
-    x = uniform();
+  fill_uniform(result);
+  return result;
+}
+
+Array<real> Random::unit_ball_py(int size, int d) {
+  Array<real> result(size*d,uninit);
+  if (d==2)
+    fill_unit_ball(vector_view<Vector<real,2>>(result));
+  else if (d==3)
+    fill_unit_ball(vector_view<Vector<real,3>>(result));
+  else
+    throw ValueError(format("Random.unit_ball: expected dimension 2 or 3, got %d",d));
   return result;
 }
 
@@ -179,6 +286,9 @@ void wrap_Random() {
     .GEODE_METHOD_2("normal",normal_py)
     .GEODE_METHOD_2("uniform",uniform_py)
     .GEODE_METHOD_2("uniform_int",uniform_int_py)
+    .GEODE_METHOD_2("unit_ball",unit_ball_py)
+    .GEODE_METHOD(substream)
+    .GEODE_METHOD(skip)
     ;
 
   GEODE_FUNCTION(random_bits_test)
@@ -6,6 +6,7 @@
 #include <geode/random/counter.h>
 #include <geode/array/view.h>
 #include <geode/python/Object.h>
+#include <geode/python/Ref.h>
 #include <geode/vector/Vector.h>
 #include <cmath>
 #include <ctime>
@@ -36,6 +37,14 @@ public:
 
   template<class Int> GEODE_CORE_EXPORT Int bits();
 
+  // An independent generator for work item i, determined by seed and i alone: it doesn't depend on the state of this
+  // generator or on which thread asks.  Give each item of a parallel loop its own substream and results won't depend
+  // on scheduling.  Substreams don't overlap this generator unless it runs through 2^127 counters.
+  GEODE_CORE_EXPORT Ref<Random> substream(const uint128_t i) const;
+
+  // Skip ahead n blocks of 128 bits, discarding any buffered bits
+  GEODE_CORE_EXPORT void skip(const uint128_t n);
+
   GEODE_CORE_EXPORT bool bit();
 
   template<class S> S uniform(const typename ScalarPolicy<S>::type a,const typename ScalarPolicy<S>::type b) { // in [a,b)
@@ -93,13 +102,30 @@ public:
     return ldexp((real)1,-8*(int)sizeof(real))*bits<RealBits>();
   }
 
+  // Bulk generation.  Each call takes a fresh block of counters and generates chunks of it in parallel, with threefry
+  // run over several counters at once.  Results depend only on the seed and the sequence of calls, not on threads.
+  // These take RawArrays; fill_uniform on an Array or Vector goes through the per sample template above.
+  GEODE_CORE_EXPORT void fill_uniform(RawArray<float> x, const float a=0, const float b=1); // in [a,b)
+  GEODE_CORE_EXPORT void fill_uniform(RawArray<double> x, const double a=0, const double b=1); // in [a,b)
+  GEODE_CORE_EXPORT void fill_normal(RawArray<float> x);
+  GEODE_CORE_EXPORT void fill_normal(RawArray<double> x);
+  GEODE_CORE_EXPORT void fill_unit_ball(RawArray<Vector<float,2>> x);
+  GEODE_CORE_EXPORT void fill_unit_ball(RawArray<Vector<float,3>> x);
+  GEODE_CORE_EXPORT void fill_unit_ball(RawArray<Vector<double,2>> x);
+  GEODE_CORE_EXPORT void fill_unit_ball(RawArray<Vector<double,3>> x);
+
   Array<real> normal_py(int size);
   Array<real> uniform_py(int size);
   Array<int> uniform_int_py(int lo, int hi, int size);
+  Array<real> unit_ball_py(int size, int d); // Flattened
   template<class TV> GEODE_CORE_EXPORT Rotation<TV> rotation();
   template<class TV> GEODE_CORE_EXPORT Frame<TV> frame(const TV& v0,const TV& v1);
 private:
   template<class Int, int N> Int n_bits();
+  template<class F> void bulk(const int n, const int words_per_item, const F& f);
+  template<class T> void fill_uniform_helper(RawArray<T> x, const T a, const T b);
+  template<class T> void fill_normal_helper(RawArray<T> x);
+  template<class TV> void fill_unit_ball_helper(RawArray<TV> x);
 };
 
 // In [a,b)
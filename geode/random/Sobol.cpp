@@ -7,6 +7,7 @@
 #include <geode/geometry/Box.h>
 #include <geode/math/integer_log.h>
 #include <geode/python/Class.h>
+#include <geode/utility/parallel.h>
 namespace geode {
 
 typedef real T;
@@ -45,6 +46,31 @@ template<class TV> TV Sobol<TV>::vector() {
   return offset+scales*TV(x);
 }
 
+template<class TV> void Sobol<TV>::fill(RawArray<TV> X, const TI start) const {
+  GEODE_ASSERT(start<(TI)1<<max_bits && TI(X.size())<((TI)1<<max_bits)-start,
+               "Ran out of bits (floating point precision has been exhausted)");
+  const int block = 4096;
+  parallel_for((X.size()+block-1)/block,[&](const int b) {
+    const int lo = b*block,
+              hi = min(lo+block,X.size());
+    // Jump straight to the first point of the block
+    Vector<TI,d> x;
+    TI n = start+lo;
+    for (TI g=(n+1)^((n+1)>>1),bit=0;g;g>>=1,bit++)
+      if (g&1)
+        for (int i=0;i<d;i++)
+          x[i] ^= Helper<T>::vs[i][bit];
+    X[lo] = offset+scales*TV(x);
+    // Then step as vector() does
+    for (int k=lo+1;k<hi;k++) {
+      const int bit = integer_log_exact(min_bit(~++n));
+      for (int i=0;i<d;i++)
+        x[i] ^= Helper<T>::vs[i][bit];
+      X[k] = offset+scales*TV(x);
+    }
+  });
+}
+
 #define INSTANTIATE(d) \
   template<> GEODE_DEFINE_TYPE(Sobol<Vector<T,d>>) \
   template class Sobol<Vector<T,d>>;
@@ -63,6 +89,7 @@ template<int d> static void wrap_helper() {
   Class<Self>(name)
     .GEODE_INIT(Box<Vector<T,d>>)
     .GEODE_METHOD(vector)
+    .GEODE_METHOD(fill)
     ;
 }
 
@@ -33,6 +33,11 @@ public:
   ~Sobol();
 
   GEODE_CORE_EXPORT TV vector();
+
+  // Fill X with the points that calls start, start+1, ... of vector() would return, leaving the generator alone.
+  // Point n is the xor of the direction numbers picked out by the Gray code of n+1, so any range can be started in
+  // constant time, and disjoint ranges can be generated independently.  Large ranges are split across threads.
+  GEODE_CORE_EXPORT void fill(RawArray<TV> X, const TI start) const;
 };
 
 }
@@ -1,21 +1,28 @@
 //#####################################################################
 // Counter-based random numbers
 //#####################################################################
-#define __STDC_CONSTANT_MACROS
 #include <geode/random/counter.h>
-#include <geode/random/random123/threefry.h>
+#include <geode/array/Array.h>
 #include <geode/python/wrap.h>
 namespace geode {
 
-uint128_t threefry(uint128_t key, uint128_t ctr) {
-  threefry2x64_ctr_t c,k;
-  uint64_t mask = -1;
-  c.v[0] = ctr&mask;
-  c.v[1] = (ctr>>64)&mask;
-  k.v[0] = key&mask;
-  k.v[1] = (key>>64)&mask;
-  threefry2x64_ctr_t r = threefry2x64(c,k);
-  return (uint128_t(r.v[1])<<64)|r.v[0];
+void threefry_fill(uint128_t key, uint128_t ctr, RawArray<uint64_t> x) {
+  GEODE_ASSERT(x.size()%2==0);
+  const ThreefryKey tf(key);
+  const int n = x.size()/2, lanes = threefry_lanes;
+  for (int b=0;b<n;b+=lanes) {
+    uint64_t x0[lanes], x1[lanes];
+    for (int l=0;l<lanes;l++) {
+      const uint128_t c = ctr+uint128_t(uint64_t(b+l));
+      x0[l] = cast_uint128<uint64_t>(c);
+      x1[l] = cast_uint128<uint64_t>(c>>64);
+    }
+    tf.encrypt<lanes>(x0,x1);
+    for (int l=0;l<min(lanes,n-b);l++) {
+      x[2*(b+l)] = x0[l];
+      x[2*(b+l)+1] = x1[l];
+    }
+  }
 }
 
 }
@@ -4,10 +4,71 @@
 #pragma once
 
 #include <geode/random/forward.h>
+#include <geode/array/forward.h>
 #include <geode/math/uint128.h>
 namespace geode {
 
+// Threefry2x64 with 20 rounds, as in random123/threefry.h.  Rounds are unrolled at compile time so that every rotation
+// is a constant, which lets the compiler use native rotates for one block and vector shifts for many.
+struct ThreefryKey {
+  uint64_t ks[3]; // Key schedule: the two key words and their parity
+
+  explicit ThreefryKey(const uint128_t key) {
+    ks[0] = cast_uint128<uint64_t>(key);
+    ks[1] = cast_uint128<uint64_t>(key>>64);
+    ks[2] = 0x1BD11BDAA9FC1A22ull^ks[0]^ks[1];
+  }
+
+  // Encrypt the blocks (x0[l],x1[l]) for l < lanes in place.  The rounds are a serial chain within each block, so
+  // bulk callers should run enough lanes both to fill the vector units and to hide their latency.
+  template<int lanes> inline void encrypt(uint64_t* x0, uint64_t* x1) const {
+    for (int l=0;l<lanes;l++) {
+      x0[l] += ks[0];
+      x1[l] += ks[1];
+    }
+    rounds<0,lanes>(x0,x1,mpl::true_());
+  }
+
+private:
+  template<int r,int lanes> inline void rounds(uint64_t* x0, uint64_t* x1, mpl::true_) const {
+    const int R = r%8==0 ? 16 : r%8==1 ? 42 : r%8==2 ? 12 : r%8==3 ? 31
+                : r%8==4 ? 16 : r%8==5 ? 32 : r%8==6 ? 24 : 21;
+    for (int l=0;l<lanes;l++) {
+      x0[l] += x1[l];
+      x1[l] = x1[l]<<R|x1[l]>>(64-R);
+      x1[l] ^= x0[l];
+    }
+    if (r%4==3) { // Inject key
+      const int i = (r+1)/4;
+      for (int l=0;l<lanes;l++) {
+        x0[l] += ks[i%3];
+        x1[l] += ks[(i+1)%3]+i;
+      }
+    }
+    rounds<r+1,lanes>(x0,x1,mpl::bool_<(r+1<20)>());
+  }
+
+  template<int r,int lanes> inline void rounds(uint64_t* x0, uint64_t* x1, mpl::false_) const {}
+};
+
+// Lanes per batch for bulk threefry.  With 256-bit or wider vectors 32 lanes vectorize well, but with only SSE2 the
+// lanes spill out of registers and 8 is faster.
+#ifdef __AVX2__
+const int threefry_lanes = 32;
+#else
+const int threefry_lanes = 8;
+#endif
+
 // Note that we put key first to match currying, unlike Salmon et al.
-GEODE_CORE_EXPORT uint128_t threefry(uint128_t key, uint128_t ctr) GEODE_CONST;
+static inline uint128_t threefry(const uint128_t key, const uint128_t ctr) {
+  uint64_t x0 = cast_uint128<uint64_t>(ctr),
+           x1 = cast_uint128<uint64_t>(ctr>>64);
+  ThreefryKey(key).encrypt<1>(&x0,&x1);
+  return uint128_t(x1)<<64|x0;
+}
+
+// Set x[2i],x[2i+1] to the low and high words of threefry(key,ctr+i).  Counters are run together in threefry_lanes
+// independent lanes, so that the rounds vectorize.  x.size() must be even.
+GEODE_CORE_EXPORT void threefry_fill(uint128_t key, uint128_t ctr, RawArray<uint64_t> x);
 
 }
@@ -9,4 +9,5 @@ void wrap_random() {
   GEODE_WRAP(sobol)
   GEODE_WRAP(counter)
   GEODE_WRAP(permute)
+  GEODE_WRAP(workloads)
 }
@@ -4,6 +4,7 @@
 #include <geode/random/counter.h>
 #include <geode/math/integer_log.h>
 #include <geode/python/wrap.h>
+#include <geode/utility/parallel.h>
 namespace geode {
 
 // For details, see
@@ -72,10 +73,91 @@ uint64_t random_unpermute(const uint64_t n, const uint128_t key, uint64_t x) {
   return x;
 }
 
+// fe2_encrypt or fe2_decrypt on each lane
+template<bool decrypt> static inline void fe2_lanes(const ThreefryKey& tf, const int bits, uint64_t* x) {
+  const int lanes = threefry_lanes;
+  const int a = bits>>1, b = bits-a;
+  const uint32_t ma = (uint32_t)(uint64_t(1)<<a)-1,
+                 mb = (uint32_t)(uint64_t(1)<<b)-1;
+  uint32_t L[lanes], R[lanes];
+  uint64_t c0[lanes], c1[lanes];
+  for (int l=0;l<lanes;l++) {
+    L[l] = uint32_t(x[l]>>b);
+    R[l] = x[l]&mb;
+  }
+  for (int r=0;r<3;r++) {
+    const int s = decrypt ? 3-r : 1+r;
+    for (int l=0;l<lanes;l++) {
+      c0[l] = uint64_t(s)<<32|(s==2 ? L[l] : R[l]);
+      c1[l] = 0;
+    }
+    tf.encrypt<lanes>(c0,c1);
+    // As in fe2_encrypt, keep the low 32 bits of each threefry result
+    if (s==2)
+      for (int l=0;l<lanes;l++)
+        R[l] = mb&(decrypt ? R[l]-uint32_t(c0[l]) : R[l]+uint32_t(c0[l]));
+    else
+      for (int l=0;l<lanes;l++)
+        L[l] = ma&(decrypt ? L[l]-uint32_t(c0[l]) : L[l]+uint32_t(c0[l]));
+  }
+  for (int l=0;l<lanes;l++)
+    x[l] = uint64_t(L[l])<<b|R[l];
+}
+
+// Cycle walk each of start+[0,y.size()) in lanes, refilling a lane with the next input whenever its walk ends
+template<bool inverse> static void permute_lanes(const uint64_t n, const uint128_t key, const uint64_t start,
+                                                 RawArray<uint64_t> y) {
+  const int lanes = threefry_lanes;
+  const ThreefryKey tf(key);
+  const int bits = next_log(n);
+  uint64_t x[lanes] = {0};
+  int slot[lanes];
+  for (int l=0;l<lanes;l++)
+    slot[l] = -1;
+  for (int next=0;;) {
+    bool active = false;
+    for (int l=0;l<lanes;l++) {
+      if (slot[l]<0 && next<y.size()) {
+        x[l] = start+next;
+        slot[l] = next++;
+      }
+      active |= slot[l]>=0;
+    }
+    if (!active)
+      break;
+    fe2_lanes<inverse>(tf,bits,x);
+    for (int l=0;l<lanes;l++)
+      if (slot[l]>=0 && x[l]<n) {
+        y[slot[l]] = x[l];
+        slot[l] = -1;
+      }
+  }
+}
+
+template<bool inverse> static void permute_fill(const uint64_t n, const uint128_t key, const uint64_t start,
+                                                RawArray<uint64_t> y) {
+  GEODE_ASSERT(start<=n && uint64_t(y.size())<=n-start);
+  const int block = 4096;
+  parallel_for((y.size()+block-1)/block,[&](const int b) {
+    const int lo = b*block;
+    permute_lanes<inverse>(n,key,start+lo,y.slice(lo,min(lo+block,y.size())));
+  });
+}
+
+void random_permute_fill(const uint64_t n, const uint128_t key, const uint64_t start, RawArray<uint64_t> y) {
+  permute_fill<false>(n,key,start,y);
+}
+
+void random_unpermute_fill(const uint64_t n, const uint128_t key, const uint64_t start, RawArray<uint64_t> y) {
+  permute_fill<true>(n,key,start,y);
+}
+
 }
 using namespace geode;
 
 void wrap_permute() {
   GEODE_FUNCTION(random_permute)
   GEODE_FUNCTION(random_unpermute)
+  GEODE_FUNCTION(random_permute_fill)
+  GEODE_FUNCTION(random_unpermute_fill)
 }
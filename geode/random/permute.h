@@ -1,6 +1,7 @@
 // Random access pseudorandom permutations
 #pragma once
 
+#include <geode/array/Array.h>
 #include <geode/math/uint128.h>
 #include <geode/vector/Vector.h>
 namespace geode {
@@ -9,4 +10,23 @@ namespace geode {
 GEODE_CORE_EXPORT uint64_t random_permute(uint64_t n, uint128_t key, uint64_t x) GEODE_CONST;
 GEODE_CORE_EXPORT uint64_t random_unpermute(uint64_t n, uint128_t key, uint64_t x) GEODE_CONST;
 
+// Set y[i] = random_permute(n,key,start+i) (or random_unpermute) for each i.  Several cycle walks run together in
+// independent lanes, so that the threefry rounds vectorize, and large ranges are split across threads.
+GEODE_CORE_EXPORT void random_permute_fill(uint64_t n, uint128_t key, uint64_t start, RawArray<uint64_t> y);
+GEODE_CORE_EXPORT void random_unpermute_fill(uint64_t n, uint128_t key, uint64_t start, RawArray<uint64_t> y);
+
+// Call f(i,random_permute(n,key,i)) for i in [0,count), in order, computing the permutation in batches.  The first
+// count values of a permutation are a uniformly random subset of [0,n-1], so this also serves for subsampling.
+template<class F> static inline void for_each_permuted(const uint64_t n, const uint128_t key, const uint64_t count,
+                                                       const F& f) {
+  assert(count<=n);
+  Array<uint64_t> batch(int(min(count,uint64_t(1)<<16)),uninit);
+  for (uint64_t start=0;start<count;start+=batch.size()) {
+    const auto b = batch.slice(0,int(min(count-start,uint64_t(batch.size()))));
+    random_permute_fill(n,key,start,b);
+    for (const int k : range(b.size()))
+      f(start+k,b[k]);
+  }
+}
+
 }
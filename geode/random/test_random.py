@@ -29,6 +29,20 @@ def test_sobol(filename=None):
   expected = '9b80b2a496d0bf4e5aeb001a87fd64528b712784'
   assert hash==expected
 
+def test_sobol_fill():
+  box = Box((0,-1,2),(1,3,5))
+  sobol = Sobol(box)
+  seq = array([sobol.vector() for _ in range(10000)])
+  for start in 0,1,4095,5000:
+    X = zeros((10000-start,3))
+    Sobol(box).fill(X,start)
+    assert all(X==seq[start:])
+  # fill leaves the generator where it was
+  sobol.fill(zeros((10,3)),0)
+  X = zeros((1,3))
+  Sobol(box).fill(X,10000)
+  assert all(sobol.vector()==X[0])
+
 def test_threefry():
   # Known answer test vectors for 20 round threefry2x64 from the Random123 distribution
   kat = '''0000000000000001 0000000000000000   0000000000000001 0000000000000000   76f8c465410f1b27 d44c2d67df04a330
@@ -117,6 +131,30 @@ def test_distributions():
     assert X.dtype==int32 and all(lo<=X) and all(X<hi)
     test('int %d %d'%(lo,hi),scipy.stats.randint(lo,hi),arange(lo,hi-1)+.5,X)
 
+def test_unit_ball():
+  random = Random(7)
+  n = 2**16
+  for d in 2,3:
+    X = random.unit_ball(n,d).reshape(-1,d)
+    r = magnitudes(X)
+    assert all(r<=1)
+    # The fraction within radius 1/2 is 2^-d, and the mean is zero
+    assert abs(mean(r<.5)-2**-d)<.01
+    assert all(abs(X.mean(axis=0))<.02)
+
+def test_substream():
+  random = Random(7)
+  a = random.substream(3).uniform(10)
+  random.uniform(5) # Substreams don't depend on the parent's state
+  assert all(a==random.substream(3).uniform(10))
+  assert all(a!=random.substream(4).uniform(10))
+  assert all(a!=Random(8).substream(3).uniform(10))
+  # Skipping ahead matches consuming.  Bulk uniform takes one 128 bit block per two samples, in whole chunks.
+  r0,r1 = Random(9),Random(9)
+  r0.uniform(2*4096)
+  r1.skip(4096)
+  assert all(r0.uniform(10)==r1.uniform(10))
+
 def test_permute():
   # Note: This tests only that random_permute(n,_) is a valid permutation, not for pseudorandomness.
   numpy.random.seed(7810131)
@@ -139,8 +177,39 @@ def test_permute():
       perms.add(perm)
     assert len(perms)==fac
 
+def test_permute_fill():
+  for n in 1,5,10000,2**40+3:
+    key = threefry(71,n)
+    start = max(0,n-9000)//2
+    count = min(n-start,9000)
+    y = empty(count,uint64)
+    random_permute_fill(n,key,start,y)
+    assert all(y==[random_permute(n,key,start+i) for i in xrange(count)])
+    random_unpermute_fill(n,key,start,y)
+    assert all(y==[random_unpermute(n,key,start+i) for i in xrange(count)])
+
+def test_workloads():
+  X = clustered_points(10000,5,.01,7)
+  assert X.shape==(10000,2)
+  assert all(X==clustered_points(10000,5,.01,7))
+  assert not all(X==clustered_points(10000,5,.01,8))
+  L = lattice_points(1000,40,3)
+  assert len(set(map(tuple,L)))==1000
+  assert all(abs(L)<1)
+  polys = grid_polygons(100,10,1)
+  assert len(polys)==100 and all(polys.offsets==4*arange(101))
+  assert all(polys.flat==rint(10*polys.flat)/10)
+  faces,X = near_coplanar_boxes(3,2,0,1)
+  assert faces.elements.shape==(3*6*8,3) and X.shape==(3*26,3)
+  faces,X = high_valence_mesh(3,2,8,.1,1)
+  assert faces.elements.shape==(3*2*8,3)
+  assert all(bincount(faces.elements.ravel())[-6:]==8) # Cell centers come last
+
 if __name__=='__main__':
+  test_workloads()
   test_permute()
   test_bits()
   test_distributions()
+  test_unit_ball()
+  test_substream()
   test_sobol('sobol.png')
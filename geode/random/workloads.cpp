@@ -0,0 +1,221 @@
+// Synthetic workloads for benchmarks
+
+#include <geode/random/workloads.h>
+#include <geode/random/permute.h>
+#include <geode/random/Random.h>
+#include <geode/array/view.h>
+#include <geode/python/wrap.h>
+#include <geode/python/Ref.h>
+#include <geode/structure/Hashtable.h>
+#include <geode/utility/parallel.h>
+#include <geode/vector/Rotation.h>
+#include <vector>
+namespace geode {
+
+using std::vector;
+typedef Vector<real,2> TV2;
+typedef Vector<real,3> TV3;
+
+// Call f(random,lo,hi) for blocks [lo,hi) of [0,n) in parallel.  Each block draws from its own substream of seed, so
+// the results don't depend on the thread count.
+template<class F> static void generate(const int n, const Random& random, const F& f) {
+  const int block = 1<<14, blocks = (n+block-1)/block;
+  vector<Ref<Random>> streams;
+  streams.reserve(blocks);
+  for (int b=0;b<blocks;b++)
+    streams.push_back(random.substream(b));
+  parallel_for(blocks,[&](const int b) {
+    f(*streams[b],b*block,min(n,(b+1)*block));
+  },1);
+}
+
+Array<TV2> uniform_points(const int n, const uint128_t seed) {
+  GEODE_ASSERT(n>=0);
+  Array<TV2> X(n,uninit);
+  new_<Random>(seed)->fill_uniform(scalar_view(X),-1,1);
+  return X;
+}
+
+Array<TV2> clustered_points(const int n, const int clusters, const real spread, const uint128_t seed) {
+  GEODE_ASSERT(n>=0 && clusters>0 && spread>=0);
+  const auto random = new_<Random>(seed);
+  Array<TV2> centers(clusters,uninit);
+  random->fill_uniform(scalar_view(centers),-1,1);
+  Array<TV2> X(n,uninit);
+  generate(n,*random,[&](Random& r, const int lo, const int hi) {
+    for (int i=lo;i<hi;i++) {
+      const TV2 c = centers[r.uniform<int>(0,clusters)];
+      const real x = r.normal();
+      X[i] = c+spread*TV2(x,r.normal());
+    }
+  });
+  return X;
+}
+
+Array<TV2> lattice_points(const int n, const int side, const uint128_t seed) {
+  GEODE_ASSERT(n>=0 && side>0 && uint64_t(n)<=uint64_t(side)*side);
+  const uint64_t cells = uint64_t(side)*side;
+  const real scale = real(2)/side;
+  // The first n cells of a random permutation
+  Array<uint64_t> C(n,uninit);
+  random_permute_fill(cells,seed,0,C);
+  Array<TV2> X(n,uninit);
+  parallel_for(n,[&](const int i) {
+    const uint64_t c = C[i];
+    X[i] = scale*TV2(real(c%side)+.5,real(c/side)+.5)-1;
+  },4096);
+  return X;
+}
+
+Nested<TV2> grid_polygons(const int count, const int grid, const uint128_t seed) {
+  GEODE_ASSERT(count>=0 && grid>0);
+  Array<int> lengths(count,uninit);
+  lengths.fill(4);
+  const Nested<TV2> polys(lengths,uninit);
+  const int max_side = max(1,grid/8);
+  generate(count,*new_<Random>(seed),[&](Random& r, const int lo, const int hi) {
+    for (int p=lo;p<hi;p++) {
+      const int x0 = r.uniform<int>(0,grid),
+                y0 = r.uniform<int>(0,grid),
+                x1 = min(grid,x0+r.uniform<int>(1,max_side+1)),
+                y1 = min(grid,y0+r.uniform<int>(1,max_side+1));
+      const auto poly = polys[p];
+      poly[0] = TV2(x0,y0)/grid;
+      poly[1] = TV2(x1,y0)/grid;
+      poly[2] = TV2(x1,y1)/grid;
+      poly[3] = TV2(x0,y1)/grid;
+    }
+  });
+  return polys;
+}
+
+// A closed unit cube with each face a resolution x resolution grid, outward oriented
+static Tuple<Array<const Vector<int,3>>,Array<const TV3>> cube_grid(const int resolution) {
+  const int r = resolution;
+  Hashtable<Vector<int,3>,int> ids;
+  Array<TV3> X;
+  Array<Vector<int,3>> tris;
+  const auto id = [&](const Vector<int,3> p) {
+    int& i = ids.get_or_insert(p,-1);
+    if (i<0) {
+      i = X.size();
+      X.append(TV3(p)/r);
+    }
+    return i;
+  };
+  for (int a=0;a<3;a++)
+    for (int side=0;side<2;side++) {
+      // u,v span the face so that u x v points along axis a
+      const int b = (a+1)%3, c = (a+2)%3;
+      Array<int> grid((r+1)*(r+1),uninit);
+      for (int u=0;u<=r;u++)
+        for (int v=0;v<=r;v++) {
+          Vector<int,3> p;
+          p[a] = side*r;
+          p[b] = u;
+          p[c] = v;
+          grid[u*(r+1)+v] = id(p);
+        }
+      for (int u=0;u<r;u++)
+        for (int v=0;v<r;v++) {
+          const int i00 = grid[u*(r+1)+v], i10 = grid[(u+1)*(r+1)+v],
+                    i01 = grid[u*(r+1)+v+1], i11 = grid[(u+1)*(r+1)+v+1];
+          if (side) {
+            tris.append(vec(i00,i10,i11));
+            tris.append(vec(i00,i11,i01));
+          } else {
+            tris.append(vec(i00,i11,i10));
+            tris.append(vec(i00,i01,i11));
+          }
+        }
+    }
+  return tuple(Array<const Vector<int,3>>(tris),Array<const TV3>(X));
+}
+
+Tuple<Ref<TriangleSoup>,Array<TV3>>
+near_coplanar_boxes(const int count, const int resolution, const real perturbation, const uint128_t seed) {
+  GEODE_ASSERT(count>=0 && resolution>0 && perturbation>=0);
+  const auto cube = cube_grid(resolution);
+  const int nt = cube.x.size(), nv = cube.y.size();
+  GEODE_ASSERT(uint64_t(count)*nt<=uint64_t(std::numeric_limits<int>::max()));
+  // Lattice positions in a cube about twice as wide as count^(1/3), so that most boxes overlap several others
+  const int side = max(2,2*int(ceil(cbrt(real(count)))));
+  Array<Vector<int,3>> tris(count*nt,uninit);
+  Array<TV3> X(count*nv,uninit);
+  generate(count,*new_<Random>(seed),[&](Random& r, const int lo, const int hi) {
+    for (int b=lo;b<hi;b++) {
+      const TV3 center = .5*TV3(r.uniform<int>(0,side),r.uniform<int>(0,side),r.uniform<int>(0,side))+.5,
+                shift = perturbation*r.unit_ball<TV3>();
+      const auto rotation = Rotation<TV3>::from_rotation_vector(perturbation*r.unit_ball<TV3>());
+      for (int t=0;t<nt;t++)
+        tris[b*nt+t] = cube.x[t]+b*nv;
+      for (int v=0;v<nv;v++)
+        X[b*nv+v] = center+shift+rotation*(cube.y[v]-.5);
+    }
+  });
+  return tuple(new_<TriangleSoup>(tris,count*nv),X);
+}
+
+Tuple<Ref<TriangleSoup>,Array<TV3>>
+high_valence_mesh(const int nx, const int ny, const int valence, const real amplitude, const uint128_t seed) {
+  GEODE_ASSERT(nx>0 && ny>0 && valence>=4 && valence%4==0);
+  GEODE_ASSERT(uint64_t(nx)*ny*valence<=uint64_t(std::numeric_limits<int>::max()));
+  // Vertices are corners, then interior points of horizontal edges, then of vertical edges, then cell centers
+  const int s = valence/4;
+  const int corners = (nx+1)*(ny+1),
+            horizontal = corners+nx*(ny+1)*(s-1),
+            vertical = horizontal+(nx+1)*ny*(s-1),
+            nv = vertical+nx*ny;
+  const auto corner = [=](const int i, const int j) { return i*(ny+1)+j; };
+  const auto hedge = [=](const int i, const int j, const int k) { return corners+(i*(ny+1)+j)*(s-1)+k-1; };
+  const auto vedge = [=](const int i, const int j, const int k) { return horizontal+(i*ny+j)*(s-1)+k-1; };
+
+  Array<TV3> X(nv,uninit);
+  generate(nv,*new_<Random>(seed),[&](Random& r, const int lo, const int hi) {
+    for (int v=lo;v<hi;v++) {
+      TV2 p;
+      if (v<corners)
+        p = TV2(v/(ny+1),v%(ny+1));
+      else if (v<horizontal) {
+        const int e = (v-corners)/(s-1), k = (v-corners)%(s-1)+1;
+        p = TV2(e/(ny+1)+real(k)/s,e%(ny+1));
+      } else if (v<vertical) {
+        const int e = (v-horizontal)/(s-1), k = (v-horizontal)%(s-1)+1;
+        p = TV2(e/ny,e%ny+real(k)/s);
+      } else
+        p = TV2((v-vertical)/ny,(v-vertical)%ny)+.5;
+      X[v] = TV3(p.x,p.y,amplitude*r.normal());
+    }
+  });
+
+  // Each cell is a fan around its center, over its boundary in counterclockwise order
+  Array<Vector<int,3>> tris(nx*ny*valence,uninit);
+  parallel_for(nx*ny,[&](const int cell) {
+    const int i = cell/ny, j = cell%ny;
+    const auto boundary = [=](const int k) {
+      const int t = k%s;
+      switch (k/s) {
+        case 0: return t ? hedge(i,j,t) : corner(i,j);
+        case 1: return t ? vedge(i+1,j,t) : corner(i+1,j);
+        case 2: return t ? hedge(i,j+1,s-t) : corner(i+1,j+1);
+        default: return t ? vedge(i,j,s-t) : corner(i,j+1);
+      }
+    };
+    const int center = vertical+cell;
+    for (int k=0;k<valence;k++)
+      tris[cell*valence+k] = vec(center,boundary(k),boundary((k+1)%valence));
+  },64);
+  return tuple(new_<TriangleSoup>(tris,nv),X);
+}
+
+}
+using namespace geode;
+
+void wrap_workloads() {
+  GEODE_FUNCTION(uniform_points)
+  GEODE_FUNCTION(clustered_points)
+  GEODE_FUNCTION(lattice_points)
+  GEODE_FUNCTION(grid_polygons)
+  GEODE_FUNCTION(near_coplanar_boxes)
+  GEODE_FUNCTION(high_valence_mesh)
+}
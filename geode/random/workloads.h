@@ -0,0 +1,42 @@
+// Synthetic workloads of controllable size and degeneracy, for benchmarks
+//
+// Each generator is a deterministic function of its arguments and seed, independent of the thread count, and runs
+// in parallel over blocks of items with one Random substream per block, so inputs with hundreds of millions of
+// elements take seconds rather than minutes.
+#pragma once
+
+#include <geode/array/Array.h>
+#include <geode/array/Nested.h>
+#include <geode/math/uint128.h>
+#include <geode/mesh/TriangleSoup.h>
+#include <geode/structure/Tuple.h>
+#include <geode/vector/Vector.h>
+namespace geode {
+
+// n points uniform in [-1,1]^2
+GEODE_CORE_EXPORT Array<Vector<real,2>> uniform_points(const int n, const uint128_t seed);
+
+// n points in normal clusters of standard deviation spread around centers uniform in [-1,1]^2
+GEODE_CORE_EXPORT Array<Vector<real,2>> clustered_points(const int n, const int clusters, const real spread,
+                                                          const uint128_t seed);
+
+// n distinct points of a side x side lattice filling [-1,1]^2, with many cocircular quadruples.  Requires n <= side^2.
+GEODE_CORE_EXPORT Array<Vector<real,2>> lattice_points(const int n, const int side, const uint128_t seed);
+
+// count counterclockwise rectangles with integer corners in [0,grid]^2, scaled to [0,1]^2, with sides up to
+// max(1,grid/8).  Edges overlap exactly and vertices lie on each other's edges.
+GEODE_CORE_EXPORT Nested<Vector<real,2>> grid_polygons(const int count, const int grid, const uint128_t seed);
+
+// count closed unit cubes, each face a resolution x resolution grid, placed on a half unit lattice so that their faces
+// coincide, then rotated and translated by up to perturbation so that coincident faces become nearly coplanar and
+// interpenetrate.  Returns faces and vertex positions.
+GEODE_CORE_EXPORT Tuple<Ref<TriangleSoup>,Array<Vector<real,3>>>
+near_coplanar_boxes(const int count, const int resolution, const real perturbation, const uint128_t seed);
+
+// An nx x ny grid of square cells in the plane, each triangulated as a fan around its center, so that centers have the
+// given valence (a multiple of 4).  Cell sides are subdivided to match, and vertices get normal z offsets scaled by
+// amplitude.  Returns faces and vertex positions.
+GEODE_CORE_EXPORT Tuple<Ref<TriangleSoup>,Array<Vector<real,3>>>
+high_valence_mesh(const int nx, const int ny, const int valence, const real amplitude, const uint128_t seed);
+
+}
@@ -0,0 +1,284 @@
+//#####################################################################
+// Class AlgebraicMultigrid
+//#####################################################################
+#include <geode/solver/AlgebraicMultigrid.h>
+#include <geode/solver/krylov.h>
+#include <geode/array/Nested.h>
+#include <geode/array/parallel_nested.h>
+#include <geode/python/Class.h>
+#include <geode/utility/parallel.h>
+#include <algorithm>
+#include <cmath>
+namespace geode {
+
+typedef real T;
+GEODE_DEFINE_TYPE(AlgebraicMultigrid)
+
+// Elementwise passes are small, so use large chunks
+static const int grain = 1024;
+
+static Array<T> diagonal(const SparseMatrix& A) {
+  Array<T> D(A.rows(),uninit);
+  parallel_for(A.rows(),[&](const int i) {
+    const int k = A.find_entry(i,i);
+    GEODE_ASSERT(k>=0 && A.A(i,k)>0,"multigrid requires a positive diagonal");
+    D[i] = A.A(i,k);
+  },grain);
+  return D;
+}
+
+// Damped Jacobi weights 4/(3 rho D^-1), bounding the spectral radius rho of D^-1 A by Gershgorin's theorem
+static Array<const T> jacobi_weights(const SparseMatrix& A, RawArray<const T> D) {
+  const T rho = parallel_reduce<T>(A.rows(),[&](const int i) {
+    T sum = 0;
+    for (const T a : A.A[i])
+      sum += abs(a);
+    return sum/D[i];
+  },[](T& a, const T b) { a = max(a,b); },grain);
+  Array<T> S(A.rows(),uninit);
+  parallel_for(A.rows(),[&](const int i) { S[i] = 4/(3*rho*D[i]); },grain);
+  return S;
+}
+
+// Group strongly connected unknowns into aggregates, returning the aggregate of each unknown and the number of aggregates
+static Tuple<Array<const int>,int> aggregate(const SparseMatrix& A, RawArray<const T> D, const T strength) {
+  const int n = A.rows();
+  const auto strong = parallel_nested(n,[&](const int i) {
+    Array<int> row;
+    for (int k=0;k<A.J.size(i);k++) {
+      const int j = A.J(i,k);
+      if (j!=i && sqr(A.A(i,k))>=sqr(strength)*D[i]*D[j])
+        row.append(j);
+    }
+    return row;
+  });
+
+  // Pass 1: unknowns whose strong neighbors are all free start aggregates containing those neighbors
+  Array<int> agg(n,uninit);
+  agg.fill(-1);
+  int count = 0;
+  for (int i=0;i<n;i++) {
+    if (agg[i]>=0 || !strong.size(i))
+      continue;
+    bool free = true;
+    for (const int j : strong[i])
+      free &= agg[j]<0;
+    if (free) {
+      agg[i] = count;
+      for (const int j : strong[i])
+        agg[j] = count;
+      count++;
+    }
+  }
+
+  // Pass 2: remaining unknowns join the aggregate of a strong neighbor from pass 1
+  const auto first = agg.copy();
+  for (int i=0;i<n;i++)
+    if (agg[i]<0)
+      for (const int j : strong[i])
+        if (first[j]>=0) {
+          agg[i] = first[j];
+          break;
+        }
+
+  // Pass 3: leftovers form aggregates with their free strong neighbors, or alone
+  for (int i=0;i<n;i++)
+    if (agg[i]<0) {
+      agg[i] = count;
+      for (const int j : strong[i])
+        if (agg[j]<0)
+          agg[j] = count;
+      count++;
+    }
+  return tuple(agg.const_(),count);
+}
+
+// Smoothed prolongation P = (I - S A) T, where T is constant over each aggregate with unit norm columns
+static Ref<const SparseMatrix> prolongation(const SparseMatrix& A, RawArray<const T> S, RawArray<const int> agg,
+                                            const int count) {
+  const int n = A.rows();
+  Array<int> sizes(count);
+  for (const int a : agg)
+    sizes[a]++;
+  Array<T> t(count,uninit);
+  for (int a=0;a<count;a++)
+    t[a] = 1/sqrt(T(sizes[a]));
+  const auto rows = parallel_nested(n,[&](const int i) {
+    Array<Tuple<int,T>> row;
+    row.append(tuple(agg[i],t[agg[i]]));
+    for (int k=0;k<A.J.size(i);k++) {
+      const int j = A.J(i,k);
+      row.append(tuple(agg[j],-S[i]*A.A(i,k)*t[agg[j]]));
+    }
+    // Merge duplicate columns in a fixed order
+    std::stable_sort(row.begin(),row.end(),[](const Tuple<int,T>& a, const Tuple<int,T>& b) { return a.x<b.x; });
+    int m = 0;
+    for (int k=1;k<row.size();k++) {
+      if (row[k].x==row[m].x)
+        row[m].y += row[k].y;
+      else
+        row[++m] = row[k];
+    }
+    row.resize(m+1);
+    return row;
+  });
+  Nested<int> J(rows.offsets,Array<int>(rows.flat.size(),uninit));
+  Array<T> values(rows.flat.size(),uninit);
+  parallel_for(rows.flat.size(),[&](const int k) {
+    J.flat[k] = rows.flat[k].x;
+    values[k] = rows.flat[k].y;
+  },grain);
+  return new_<SparseMatrix>(J,values);
+}
+
+static Ref<const SparseMatrix> transposed(const SparseMatrix& A, const int columns) {
+  Array<int> counts(columns);
+  for (const int j : A.J.flat)
+    counts[j]++;
+  Nested<int> J(counts,uninit);
+  Array<T> values(J.flat.size(),uninit);
+  for (int i=A.rows()-1;i>=0;i--)
+    for (int k=A.J.size(i)-1;k>=0;k--) {
+      const int j = A.J(i,k),
+                slot = J.offsets[j]+--counts[j];
+      J.flat[slot] = i;
+      values[slot] = A.A(i,k);
+    }
+  return new_<SparseMatrix>(J,values);
+}
+
+AlgebraicMultigrid::AlgebraicMultigrid(const SparseMatrix& A0, const T strength, const int coarse_size)
+  : strength(strength)
+  , coarse_size(coarse_size) {
+  GEODE_ASSERT(A0.rows()==A0.columns() && strength>=0 && coarse_size>=1);
+  A.push_back(ref(A0));
+  for (;;) {
+    const SparseMatrix& fine = *A.back();
+    const auto D = diagonal(fine);
+    smoother.push_back(jacobi_weights(fine,D));
+    if (fine.rows()<=coarse_size || A.size()>=32)
+      break;
+    const auto agg = aggregate(fine,D,strength);
+    if (10*agg.y>9*fine.rows()) // Coarsening stalled
+      break;
+    const auto p = prolongation(fine,smoother.back(),agg.x,agg.y);
+    const auto r = transposed(*p,agg.y);
+    P.push_back(p);
+    R.push_back(r);
+    A.push_back(r->times(*fine.times(*p)));
+  }
+
+  // Factor the coarsest matrix densely.  Pivots which vanish relative to the diagonal are null directions, such as the
+  // constants for pure Neumann problems, and are dropped.
+  const SparseMatrix& coarse = *A.back();
+  const int n = coarse.rows();
+  Array<T,2> L(n,n);
+  for (int i=0;i<n;i++)
+    for (int k=0;k<coarse.J.size(i);k++)
+      L(i,coarse.J(i,k)) = coarse.A(i,k);
+  T scale = 0;
+  for (int i=0;i<n;i++)
+    scale = max(scale,abs(L(i,i)));
+  const T tolerance = 1e-10*scale;
+  for (int j=0;j<n;j++) {
+    T s = L(j,j);
+    for (int k=0;k<j;k++)
+      s -= sqr(L(j,k));
+    if (s<=tolerance) {
+      for (int i=j;i<n;i++)
+        L(i,j) = 0;
+      continue;
+    }
+    L(j,j) = sqrt(s);
+    for (int i=j+1;i<n;i++) {
+      T s = L(i,j);
+      for (int k=0;k<j;k++)
+        s -= L(i,k)*L(j,k);
+      L(i,j) = s/L(j,j);
+    }
+  }
+  // Clear the upper triangle, which still holds entries of the coarse matrix
+  for (int i=0;i<n;i++)
+    for (int j=i+1;j<n;j++)
+      L(i,j) = 0;
+  this->L = L;
+}
+
+AlgebraicMultigrid::~AlgebraicMultigrid() {}
+
+Array<int> AlgebraicMultigrid::sizes() const {
+  Array<int> sizes;
+  for (const auto& a : A)
+    sizes.append(a->rows());
+  return sizes;
+}
+
+void AlgebraicMultigrid::coarse_solve(RawArray<const T> b, RawArray<T> x) const {
+  const int n = L.m;
+  for (int i=0;i<n;i++) {
+    T s = b[i];
+    for (int k=0;k<i;k++)
+      s -= L(i,k)*x[k];
+    x[i] = L(i,i) ? s/L(i,i) : 0;
+  }
+  for (int i=n-1;i>=0;i--) {
+    T s = x[i];
+    for (int k=i+1;k<n;k++)
+      s -= L(k,i)*x[k];
+    x[i] = L(i,i) ? s/L(i,i) : 0;
+  }
+}
+
+void AlgebraicMultigrid::cycle(const int l, RawArray<const T> b, RawArray<T> x) const {
+  if (l==levels()-1)
+    return coarse_solve(b,x);
+  const SparseMatrix& M = *A[l];
+  RawArray<const T> S = smoother[l];
+  const int n = M.rows();
+  Array<T> r(n,uninit), Mx(n,uninit);
+
+  // Presmooth starting from zero, and restrict the residual
+  parallel_for(n,[&](const int i) { x[i] = S[i]*b[i]; },grain);
+  M.multiply(x,Mx);
+  parallel_for(n,[&](const int i) { r[i] = b[i]-Mx[i]; },grain);
+  const int m = A[l+1]->rows();
+  Array<T> rc(m,uninit), ec(m,uninit);
+  R[l]->multiply(r,rc);
+  cycle(l+1,rc,ec);
+
+  // Correct and postsmooth
+  P[l]->multiply(ec,r);
+  parallel_for(n,[&](const int i) { x[i] += r[i]; },grain);
+  M.multiply(x,Mx);
+  parallel_for(n,[&](const int i) { x[i] += S[i]*(b[i]-Mx[i]); },grain);
+}
+
+void AlgebraicMultigrid::apply(RawArray<const T> r, RawArray<T> z) const {
+  GEODE_ASSERT(r.size()==A[0]->rows() && z.size()==r.size());
+  cycle(0,r,z);
+}
+
+Tuple<int,T> AlgebraicMultigrid::conjugate_gradient(RawArray<const T> b, RawArray<T> x, const T tolerance, const int max_iterations) const {
+  return geode::conjugate_gradient(*A[0],b,x,*this,tolerance,max_iterations);
+}
+
+Tuple<int,T> AlgebraicMultigrid::minres(RawArray<const T> b, RawArray<T> x, const T tolerance, const int max_iterations) const {
+  return geode::minres(*A[0],b,x,*this,tolerance,max_iterations);
+}
+
+}
+using namespace geode;
+
+void wrap_algebraic_multigrid() {
+  typedef AlgebraicMultigrid Self;
+  Class<Self>("AlgebraicMultigrid")
+    .GEODE_INIT(const SparseMatrix&,T,int)
+    .GEODE_FIELD(strength)
+    .GEODE_FIELD(coarse_size)
+    .GEODE_METHOD(levels)
+    .GEODE_METHOD(sizes)
+    .GEODE_METHOD(apply)
+    .GEODE_METHOD(conjugate_gradient)
+    .GEODE_METHOD(minres)
+    ;
+}
@@ -0,0 +1,65 @@
+//#####################################################################
+// Class AlgebraicMultigrid
+//#####################################################################
+//
+// A smoothed aggregation multigrid preconditioner for symmetric positive
+// (semi)definite SparseMatrix systems, such as Poisson and diffusion
+// problems.  Each level groups strongly connected unknowns into aggregates,
+// builds a tentative prolongation which is constant over each aggregate,
+// and smooths it by one damped Jacobi step.  The next coarser matrix is
+// the Galerkin product R A P with R = P^T.
+//
+// apply runs one symmetric V-cycle with damped Jacobi smoothing and an
+// exact solve on the coarsest level, so it can precondition conjugate
+// gradients.  Setup and cycles run in parallel, and results don't depend
+// on the number of threads.
+//
+//#####################################################################
+#pragma once
+
+#include <geode/array/Array2d.h>
+#include <geode/python/Object.h>
+#include <geode/structure/Tuple.h>
+#include <geode/vector/SparseMatrix.h>
+#include <vector>
+namespace geode {
+
+class AlgebraicMultigrid : public Object {
+public:
+  GEODE_DECLARE_TYPE(GEODE_CORE_EXPORT)
+  typedef Object Base;
+  typedef real T;
+
+  const T strength; // Off diagonal entries with a_ij^2 >= strength^2 |a_ii a_jj| are strong connections
+  const int coarse_size; // Coarsening stops once a level has at most this many unknowns
+private:
+  std::vector<Ref<const SparseMatrix>> A; // Matrix on each level, from finest to coarsest
+  std::vector<Ref<const SparseMatrix>> P, R; // Prolongation from level l+1 to level l, and its transpose
+  std::vector<Array<const T>> smoother; // Damped inverse diagonal of each level
+  Array<const T,2> L; // Cholesky factor of the coarsest matrix, with zero columns for null directions
+
+protected:
+  GEODE_CORE_EXPORT AlgebraicMultigrid(const SparseMatrix& A, const T strength, const int coarse_size);
+public:
+  ~AlgebraicMultigrid();
+
+  int levels() const {
+    return int(A.size());
+  }
+
+  // Number of unknowns on each level
+  GEODE_CORE_EXPORT Array<int> sizes() const;
+
+  // Set z to one V-cycle applied to r, starting from zero
+  GEODE_CORE_EXPORT void apply(RawArray<const T> r, RawArray<T> z) const;
+
+  // Solve the finest level system with conjugate gradients or MINRES, using this as the preconditioner.  See krylov.h.
+  GEODE_CORE_EXPORT Tuple<int,T> conjugate_gradient(RawArray<const T> b, RawArray<T> x, const T tolerance, const int max_iterations) const;
+  GEODE_CORE_EXPORT Tuple<int,T> minres(RawArray<const T> b, RawArray<T> x, const T tolerance, const int max_iterations) const;
+
+private:
+  void cycle(const int level, RawArray<const T> b, RawArray<T> x) const;
+  void coarse_solve(RawArray<const T> b, RawArray<T> x) const;
+};
+
+}
@@ -0,0 +1,226 @@
+//#####################################################################
+// Class SparseCholesky
+//#####################################################################
+#include <geode/solver/SparseCholesky.h>
+#include <geode/python/Class.h>
+#include <cmath>
+namespace geode {
+
+typedef real T;
+GEODE_DEFINE_TYPE(SparseCholesky)
+
+// Parts this small are ordered as they come
+static const int leaf_size = 32;
+
+namespace {
+struct Dissection {
+  const SparseMatrix& A;
+  Array<int> stamp; // Vertices of the part being split have stamp equal to its id
+  Array<int> level; // Breadth first level within the current part, or -1 if not yet reached
+  Array<int> queue;
+  Array<int> order;
+  int parts;
+
+  Dissection(const SparseMatrix& A)
+    : A(A), stamp(A.rows()), level(A.rows(),uninit), queue(A.rows(),uninit), parts(0) {
+    stamp.fill(-1);
+    order.preallocate(A.rows());
+  }
+
+  // Breadth first search within part from start, filling queue with the reached vertices in order.  Returns their
+  // count.
+  int bfs(RawArray<const int> part, const int id, const int start) {
+    for (const int v : part)
+      level[v] = -1;
+    int n = 0;
+    queue[n++] = start;
+    level[start] = 0;
+    for (int i=0;i<n;i++) {
+      const int v = queue[i];
+      for (const int w : A.J[v])
+        if (stamp[w]==id && level[w]<0) {
+          level[w] = level[v]+1;
+          queue[n++] = w;
+        }
+    }
+    return n;
+  }
+
+  void dissect(RawArray<const int> part) {
+    if (part.size()<=leaf_size) {
+      order.extend(part);
+      return;
+    }
+    const int id = parts++;
+    for (const int v : part)
+      stamp[v] = id;
+
+    // If the part is disconnected, order the component of its first vertex and the rest separately
+    int n = bfs(part,id,part[0]);
+    if (n<part.size()) {
+      const auto component = queue.slice(0,n).copy();
+      Array<int> rest;
+      for (const int v : part)
+        if (level[v]<0)
+          rest.append(v);
+      dissect(component);
+      dissect(rest);
+      return;
+    }
+
+    // Search from the end of a previous search to find a pseudo-peripheral vertex, making the levels many and thin
+    for (int i=0;i<2;i++)
+      n = bfs(part,id,queue[n-1]);
+
+    // Split at the middle vertex's level.  Edges join only adjacent levels, so it separates the rest.
+    const int s = level[queue[n/2]];
+    Array<int> left, middle, right;
+    for (const int v : queue.slice(0,n))
+      (level[v]<s ? left : level[v]==s ? middle : right).append(v);
+    if (left.empty() || right.empty()) { // Too few levels to split usefully
+      order.extend(part);
+      return;
+    }
+    dissect(left);
+    dissect(right);
+    order.extend(middle);
+  }
+};
+}
+
+static Array<const int> nested_dissection(const SparseMatrix& A) {
+  GEODE_ASSERT(A.rows()==A.columns(),"SparseCholesky: matrix must be square");
+  Dissection d(A);
+  Array<int> all(A.rows(),uninit);
+  for (const int i : range(A.rows()))
+    all[i] = i;
+  d.dissect(all);
+  GEODE_ASSERT(d.order.size()==A.rows());
+  return d.order;
+}
+
+SparseCholesky::SparseCholesky(const SparseMatrix& A)
+  : order(nested_dissection(A)) {
+  const int n = rows();
+  Array<int> inverse(n,uninit);
+  for (const int k : range(n))
+    inverse[order[k]] = k;
+
+  // Elimination tree of the permuted matrix C, from the upper triangle of each column: C(i,k) for i < k
+  Array<int> parent(n,uninit), ancestor(n,uninit);
+  for (const int k : range(n)) {
+    parent[k] = ancestor[k] = -1;
+    for (const int c : A.J[order[k]])
+      for (int i=inverse[c];i>=0 && i<k;) {
+        const int next = ancestor[i];
+        ancestor[i] = k;
+        if (next<0)
+          parent[i] = k;
+        i = next;
+      }
+  }
+
+  // The pattern of row k of L is the union of the paths up the tree from each C(i,k) to k.  Set s[top,n) to the
+  // columns of row k, marking visited columns with k.
+  Array<int> s(n,uninit), mark(n,uninit);
+  mark.fill(-1);
+  const auto reach = [&](const int k) {
+    int top = n;
+    mark[k] = k;
+    for (const int c : A.J[order[k]]) {
+      int i = inverse[c];
+      if (i>k)
+        continue;
+      int len = 0;
+      for (;mark[i]!=k;i=parent[i]) {
+        s[len++] = i; // Push the path, then move it to the top of the stack
+        mark[i] = k;
+      }
+      while (len>0)
+        s[--top] = s[--len];
+    }
+    return top;
+  };
+
+  // Count the entries of each column, then fill them in row by row
+  Array<int> counts(n);
+  for (const int k : range(n)) {
+    counts[k]++;
+    for (const int j : s.slice(reach(k),n))
+      counts[j]++;
+  }
+  Nested<int> Li(counts,uninit);
+  Array<T> Lx(Li.flat.size(),uninit);
+  Array<int> next(n,uninit); // Next free slot in each column
+  Array<T> x(n);
+  mark.fill(-1);
+  for (const int k : range(n)) {
+    const int top = reach(k);
+    const int r = order[k];
+    for (const int p : range(A.J.size(r))) {
+      const int i = inverse[A.J(r,p)];
+      if (i<=k)
+        x[i] = A.A(r,p);
+    }
+    T d = x[k];
+    x[k] = 0;
+    for (const int i : s.slice(top,n)) {
+      const T lki = x[i]/Lx[Li.offsets[i]];
+      x[i] = 0;
+      for (int p=Li.offsets[i]+1;p<next[i];p++)
+        x[Li.flat[p]] -= Lx[p]*lki;
+      d -= lki*lki;
+      const int p = next[i]++;
+      Li.flat[p] = k;
+      Lx[p] = lki;
+    }
+    GEODE_ASSERT(d>0,"SparseCholesky: matrix is not positive definite");
+    const int p = next[k] = Li.offsets[k];
+    next[k]++;
+    Li.flat[p] = k;
+    Lx[p] = sqrt(d);
+  }
+  L_rows = Li;
+  L_values = Lx;
+}
+
+SparseCholesky::~SparseCholesky() {}
+
+void SparseCholesky::solve(RawArray<const T> b, RawArray<T> x) const {
+  const int n = rows();
+  GEODE_ASSERT(b.size()==n && x.size()==n);
+  Array<T> y(n,uninit);
+  for (const int k : range(n))
+    y[k] = b[order[k]];
+  // L y = Pb, column by column
+  for (const int j : range(n)) {
+    const int lo = L_rows.offsets[j], hi = L_rows.offsets[j+1];
+    const T yj = y[j] /= L_values[lo];
+    for (int p=lo+1;p<hi;p++)
+      y[L_rows.flat[p]] -= L_values[p]*yj;
+  }
+  // L^T y = y, row by row of L^T
+  for (int j=n-1;j>=0;j--) {
+    const int lo = L_rows.offsets[j], hi = L_rows.offsets[j+1];
+    T yj = y[j];
+    for (int p=lo+1;p<hi;p++)
+      yj -= L_values[p]*y[L_rows.flat[p]];
+    y[j] = yj/L_values[lo];
+  }
+  for (const int k : range(n))
+    x[order[k]] = y[k];
+}
+
+}
+using namespace geode;
+
+void wrap_sparse_cholesky() {
+  typedef SparseCholesky Self;
+  Class<Self>("SparseCholesky")
+    .GEODE_INIT(const SparseMatrix&)
+    .GEODE_FIELD(order)
+    .GEODE_METHOD(rows)
+    .GEODE_METHOD(nonzeros)
+    .GEODE_METHOD(solve)
+    ;
+}
@@ -0,0 +1,55 @@
+//#####################################################################
+// Class SparseCholesky
+//#####################################################################
+//
+// A sparse Cholesky factorization P A P^T = L L^T of a symmetric positive
+// definite SparseMatrix, for solving many systems with the same matrix.
+//
+// Unknowns are ordered by nested dissection of the graph of A: breadth
+// first level sets from a pseudo-peripheral vertex are split at the middle
+// level, which is ordered after both halves, and the halves recurse.  For
+// meshes of surfaces this keeps the factor close to O(n log n) entries.
+// The factor is then computed row by row, finding the pattern of each row
+// from the elimination tree (the up-looking method of Davis, Direct Methods
+// for Sparse Linear Systems).  Unlike an iterative solve, the error of each
+// solve is relative to the size of the solution, so tiny values far from
+// the support of b come out accurate.
+//
+//#####################################################################
+#pragma once
+
+#include <geode/array/Nested.h>
+#include <geode/python/Object.h>
+#include <geode/vector/SparseMatrix.h>
+namespace geode {
+
+class SparseCholesky : public Object {
+public:
+  GEODE_DECLARE_TYPE(GEODE_CORE_EXPORT)
+  typedef Object Base;
+  typedef real T;
+
+  const Array<const int> order; // Row order[k] of A is eliminated k-th
+private:
+  Nested<const int> L_rows; // Rows of the nonzeros of each column of L, starting with the diagonal
+  Array<const T> L_values; // Matching L_rows.flat
+
+protected:
+  GEODE_CORE_EXPORT SparseCholesky(const SparseMatrix& A);
+public:
+  ~SparseCholesky();
+
+  int rows() const {
+    return order.size();
+  }
+
+  // Number of entries in the factor L
+  int nonzeros() const {
+    return L_values.size();
+  }
+
+  // Solve A x = b.  x and b may be the same array.
+  GEODE_CORE_EXPORT void solve(RawArray<const T> b, RawArray<T> x) const;
+};
+
+}
@@ -0,0 +1,263 @@
+//#####################################################################
+// Krylov solvers
+//#####################################################################
+#include <geode/solver/krylov.h>
+#include <geode/solver/AlgebraicMultigrid.h>
+#include <geode/python/wrap.h>
+#include <geode/utility/function.h>
+#include <geode/utility/parallel.h>
+#include <geode/vector/Vector.h>
+#include <cmath>
+#include <limits>
+namespace geode {
+
+typedef real T;
+
+// Elementwise passes are small, so use large chunks
+static const int grain = 1024;
+
+// multiply(x,y) sets y = Ax, and precondition(r,z) sets z to the preconditioner applied to r if preconditioned is true
+template<class TV,class Multiply,class Precondition> static Tuple<int,T>
+conjugate_gradient_helper(const Multiply& multiply, const Precondition& precondition, const bool preconditioned,
+                          RawArray<const TV> b, RawArray<TV> x, const T tolerance, const int max_iterations) {
+  const int n = b.size();
+  GEODE_ASSERT(x.size()==n && tolerance>=0 && max_iterations>=0);
+  Array<TV> r(n,uninit), p(n,uninit), q(n,uninit);
+  const Array<TV> z = preconditioned ? Array<TV>(n,uninit) : r;
+
+  // Compute the initial residual along with |b|^2
+  multiply(x,q);
+  const auto norms = parallel_reduce<Vector<T,2>>(n,[&](const int i) {
+    r[i] = b[i]-q[i];
+    return vec(dot(b[i],b[i]),dot(r[i],r[i]));
+  },grain);
+  const T threshold = sqr(tolerance)*norms.x;
+  T rr = norms.y;
+  if (preconditioned)
+    precondition(r,z);
+  T rz = preconditioned ? parallel_reduce<T>(n,[&](const int i) { return dot(r[i],z[i]); },grain) : rr;
+  parallel_for(n,[&](const int i) { p[i] = z[i]; },grain);
+
+  int iteration = 0;
+  while (rr>threshold && iteration<max_iterations) {
+    multiply(p,q);
+    const T pq = parallel_reduce<T>(n,[&](const int i) { return dot(p[i],q[i]); },grain);
+    if (!(pq>0)) // A isn't positive definite along p, or p vanished
+      break;
+    const T alpha = rz/pq;
+    rr = parallel_reduce<T>(n,[&](const int i) {
+      x[i] += alpha*p[i];
+      r[i] -= alpha*q[i];
+      return dot(r[i],r[i]);
+    },grain);
+    iteration++;
+    if (rr<=threshold)
+      break;
+    if (preconditioned)
+      precondition(r,z);
+    const T rz_new = preconditioned ? parallel_reduce<T>(n,[&](const int i) { return dot(r[i],z[i]); },grain) : rr,
+            beta = rz_new/rz;
+    rz = rz_new;
+    parallel_for(n,[&](const int i) { p[i] = z[i]+beta*p[i]; },grain);
+  }
+  return tuple(iteration,sqrt(rr));
+}
+
+// Preconditioned MINRES, following Paige and Saunders
+template<class TV,class Multiply,class Precondition> static Tuple<int,T>
+minres_helper(const Multiply& multiply, const Precondition& precondition, const bool preconditioned,
+              RawArray<const TV> b, RawArray<TV> x, const T tolerance, const int max_iterations) {
+  const int n = b.size();
+  GEODE_ASSERT(x.size()==n && tolerance>=0 && max_iterations>=0);
+  Array<TV> r1(n), r2(n,uninit), q(n,uninit), v(n,uninit), w(n), w1(n), w2(n);
+  Array<TV> z = preconditioned ? Array<TV>(n,uninit) : r2;
+
+  // Initial residual r2 and z = M r2
+  multiply(x,q);
+  T rr = parallel_reduce<T>(n,[&](const int i) {
+    r2[i] = b[i]-q[i];
+    return dot(r2[i],r2[i]);
+  },grain);
+  if (preconditioned) {
+    precondition(r2,z);
+    rr = parallel_reduce<T>(n,[&](const int i) { return dot(r2[i],z[i]); },grain);
+  }
+  GEODE_ASSERT(rr>=0,"preconditioner is not positive definite");
+  const T beta1 = sqrt(rr);
+  T beta = beta1, old_beta = 0, dbar = 0, epsilon = 0, phibar = beta1, cs = -1, sn = 0;
+
+  int iteration = 0;
+  while (phibar>tolerance*beta1 && beta>0 && iteration<max_iterations) {
+    // Lanczos step: q = A v - (beta/old_beta) r1 - (alpha/beta) r2
+    const T s = 1/beta;
+    parallel_for(n,[&](const int i) { v[i] = s*z[i]; },grain);
+    multiply(v,q);
+    const T c1 = iteration ? beta/old_beta : 0;
+    const T alpha = parallel_reduce<T>(n,[&](const int i) {
+      q[i] -= c1*r1[i];
+      return dot(v[i],q[i]);
+    },grain);
+    const T c2 = alpha/beta;
+    rr = parallel_reduce<T>(n,[&](const int i) {
+      q[i] -= c2*r2[i];
+      return dot(q[i],q[i]);
+    },grain);
+    r1.swap(r2);
+    r2.swap(q);
+    if (preconditioned) {
+      precondition(r2,z);
+      rr = parallel_reduce<T>(n,[&](const int i) { return dot(r2[i],z[i]); },grain);
+      GEODE_ASSERT(rr>=0,"preconditioner is not positive definite");
+    } else
+      z = r2;
+    old_beta = beta;
+    beta = sqrt(rr);
+
+    // Apply the previous rotation, then compute and apply the next one
+    const T old_epsilon = epsilon,
+            delta = cs*dbar+sn*alpha,
+            gbar = sn*dbar-cs*alpha;
+    epsilon = sn*beta;
+    dbar = -cs*beta;
+    const T gamma = max(sqrt(sqr(gbar)+sqr(beta)),std::numeric_limits<T>::min());
+    cs = gbar/gamma;
+    sn = beta/gamma;
+    const T phi = cs*phibar;
+    phibar *= sn;
+
+    // Update the search direction and the solution.  The new direction overwrites the oldest one.
+    const T denominator = 1/gamma;
+    parallel_for(n,[&](const int i) {
+      w1[i] = denominator*(v[i]-old_epsilon*w2[i]-delta*w[i]);
+      x[i] += phi*w1[i];
+    },grain);
+    w1.swap(w2);
+    w2.swap(w);
+    iteration++;
+  }
+  return tuple(iteration,phibar);
+}
+
+template<class TV> Tuple<int,T>
+conjugate_gradient(const SolidMatrixBase<TV>& A, RawArray<const TV> b, RawArray<TV> x,
+                   Ptr<const SolidMatrixBase<TV>> preconditioner, const T tolerance, const int max_iterations) {
+  GEODE_ASSERT(A.size()==b.size() && (!preconditioner || preconditioner->size()==b.size()));
+  return conjugate_gradient_helper<TV>(
+    [&](RawArray<const TV> u, RawArray<TV> y) { A.multiply(u,y); },
+    [&](RawArray<const TV> r, RawArray<TV> z) { preconditioner->multiply(r,z); },
+    bool(preconditioner),b,x,tolerance,max_iterations);
+}
+
+template<class TV> Tuple<int,T>
+mixed_conjugate_gradient(const SolidMatrix<TV>& A, RawArray<const TV> b, RawArray<TV> x,
+                         Ptr<const SolidMatrixBase<TV>> preconditioner, const T tolerance, const int max_iterations) {
+  const int n = b.size();
+  GEODE_ASSERT(A.size()==n && x.size()==n && (!preconditioner || preconditioner->size()==n));
+  GEODE_ASSERT(tolerance>=0 && max_iterations>=0);
+  // Corrections need only a few digits, since rounding the blocks to float limits each step anyway
+  const T inner_tolerance = 1e-5;
+  const auto F = A.single_precision();
+  Array<TV> r(n,uninit), e(n,uninit);
+  const auto residual = [&]() {
+    A.multiply(x,r);
+    return sqrt(parallel_reduce<T>(n,[&](const int i) {
+      r[i] = b[i]-r[i];
+      return dot(r[i],r[i]);
+    },grain));
+  };
+  const T threshold = tolerance*sqrt(parallel_reduce<T>(n,[&](const int i) { return dot(b[i],b[i]); },grain));
+  T rnorm = residual();
+  int iteration = 0;
+  while (rnorm>threshold && iteration<max_iterations) {
+    e.zero();
+    const auto inner = conjugate_gradient<TV>(*F,r,e,preconditioner,max(inner_tolerance,threshold/rnorm),
+                                              max_iterations-iteration);
+    iteration += inner.x;
+    parallel_for(n,[&](const int i) { x[i] += e[i]; },grain);
+    const T previous = rnorm;
+    rnorm = residual();
+    if (!(rnorm<previous))
+      break;
+  }
+  return tuple(iteration,rnorm);
+}
+
+template<class TV> Tuple<int,T>
+minres(const SolidMatrixBase<TV>& A, RawArray<const TV> b, RawArray<TV> x,
+       Ptr<const SolidMatrixBase<TV>> preconditioner, const T tolerance, const int max_iterations) {
+  GEODE_ASSERT(A.size()==b.size() && (!preconditioner || preconditioner->size()==b.size()));
+  return minres_helper<TV>(
+    [&](RawArray<const TV> u, RawArray<TV> y) { A.multiply(u,y); },
+    [&](RawArray<const TV> r, RawArray<TV> z) { preconditioner->multiply(r,z); },
+    bool(preconditioner),b,x,tolerance,max_iterations);
+}
+
+// Apply an incomplete Cholesky factor by forward and backward substitution
+static function<void(RawArray<const T>,RawArray<T>)> cholesky_preconditioner(const Ptr<const SparseMatrix>& cholesky, const int n) {
+  if (!cholesky)
+    return function<void(RawArray<const T>,RawArray<T>)>();
+  GEODE_ASSERT(cholesky->rows()==n);
+  const Array<T> t(n,uninit);
+  return [=](RawArray<const T> r, RawArray<T> z) {
+    cholesky->solve_forward_substitution(r,t);
+    cholesky->solve_backward_substitution(t,z);
+  };
+}
+
+Tuple<int,T> conjugate_gradient(const SparseMatrix& A, RawArray<const T> b, RawArray<T> x,
+                                Ptr<const SparseMatrix> cholesky, const T tolerance, const int max_iterations) {
+  GEODE_ASSERT(A.rows()==A.columns() && A.rows()==b.size());
+  const auto precondition = cholesky_preconditioner(cholesky,b.size());
+  return conjugate_gradient_helper<T>(
+    [&](RawArray<const T> u, RawArray<T> y) { A.multiply(u,y); },
+    precondition,bool(cholesky),b,x,tolerance,max_iterations);
+}
+
+Tuple<int,T> minres(const SparseMatrix& A, RawArray<const T> b, RawArray<T> x,
+                    Ptr<const SparseMatrix> cholesky, const T tolerance, const int max_iterations) {
+  GEODE_ASSERT(A.rows()==A.columns() && A.rows()==b.size());
+  const auto precondition = cholesky_preconditioner(cholesky,b.size());
+  return minres_helper<T>(
+    [&](RawArray<const T> u, RawArray<T> y) { A.multiply(u,y); },
+    precondition,bool(cholesky),b,x,tolerance,max_iterations);
+}
+
+Tuple<int,T> conjugate_gradient(const SparseMatrix& A, RawArray<const T> b, RawArray<T> x,
+                                const AlgebraicMultigrid& preconditioner, const T tolerance, const int max_iterations) {
+  GEODE_ASSERT(A.rows()==A.columns() && A.rows()==b.size());
+  return conjugate_gradient_helper<T>(
+    [&](RawArray<const T> u, RawArray<T> y) { A.multiply(u,y); },
+    [&](RawArray<const T> r, RawArray<T> z) { preconditioner.apply(r,z); },
+    true,b,x,tolerance,max_iterations);
+}
+
+Tuple<int,T> minres(const SparseMatrix& A, RawArray<const T> b, RawArray<T> x,
+                    const AlgebraicMultigrid& preconditioner, const T tolerance, const int max_iterations) {
+  GEODE_ASSERT(A.rows()==A.columns() && A.rows()==b.size());
+  return minres_helper<T>(
+    [&](RawArray<const T> u, RawArray<T> y) { A.multiply(u,y); },
+    [&](RawArray<const T> r, RawArray<T> z) { preconditioner.apply(r,z); },
+    true,b,x,tolerance,max_iterations);
+}
+
+#define INSTANTIATE(d) \
+  template GEODE_CORE_EXPORT Tuple<int,T> conjugate_gradient(const SolidMatrixBase<Vector<T,d>>&,RawArray<const Vector<T,d>>,RawArray<Vector<T,d>>,Ptr<const SolidMatrixBase<Vector<T,d>>>,const T,const int); \
+  template GEODE_CORE_EXPORT Tuple<int,T> mixed_conjugate_gradient(const SolidMatrix<Vector<T,d>>&,RawArray<const Vector<T,d>>,RawArray<Vector<T,d>>,Ptr<const SolidMatrixBase<Vector<T,d>>>,const T,const int); \
+  template GEODE_CORE_EXPORT Tuple<int,T> minres(const SolidMatrixBase<Vector<T,d>>&,RawArray<const Vector<T,d>>,RawArray<Vector<T,d>>,Ptr<const SolidMatrixBase<Vector<T,d>>>,const T,const int);
+INSTANTIATE(2)
+INSTANTIATE(3)
+
+}
+using namespace geode;
+
+void wrap_krylov() {
+  typedef Tuple<int,T> R;
+  GEODE_FUNCTION_2(conjugate_gradient_2d,static_cast<R(*)(const SolidMatrixBase<Vector<T,2>>&,RawArray<const Vector<T,2>>,RawArray<Vector<T,2>>,Ptr<const SolidMatrixBase<Vector<T,2>>>,const T,const int)>(conjugate_gradient))
+  GEODE_FUNCTION_2(conjugate_gradient_3d,static_cast<R(*)(const SolidMatrixBase<Vector<T,3>>&,RawArray<const Vector<T,3>>,RawArray<Vector<T,3>>,Ptr<const SolidMatrixBase<Vector<T,3>>>,const T,const int)>(conjugate_gradient))
+  GEODE_FUNCTION_2(sparse_conjugate_gradient,static_cast<R(*)(const SparseMatrix&,RawArray<const T>,RawArray<T>,Ptr<const SparseMatrix>,const T,const int)>(conjugate_gradient))
+  GEODE_FUNCTION_2(mixed_conjugate_gradient_2d,mixed_conjugate_gradient<Vector<T,2>>)
+  GEODE_FUNCTION_2(mixed_conjugate_gradient_3d,mixed_conjugate_gradient<Vector<T,3>>)
+  GEODE_FUNCTION_2(minres_2d,static_cast<R(*)(const SolidMatrixBase<Vector<T,2>>&,RawArray<const Vector<T,2>>,RawArray<Vector<T,2>>,Ptr<const SolidMatrixBase<Vector<T,2>>>,const T,const int)>(minres))
+  GEODE_FUNCTION_2(minres_3d,static_cast<R(*)(const SolidMatrixBase<Vector<T,3>>&,RawArray<const Vector<T,3>>,RawArray<Vector<T,3>>,Ptr<const SolidMatrixBase<Vector<T,3>>>,const T,const int)>(minres))
+  GEODE_FUNCTION_2(sparse_minres,static_cast<R(*)(const SparseMatrix&,RawArray<const T>,RawArray<T>,Ptr<const SparseMatrix>,const T,const int)>(minres))
+}
@@ -0,0 +1,70 @@
+//#####################################################################
+// Krylov solvers
+//#####################################################################
+//
+// Preconditioned conjugate gradients and MINRES for SolidMatrix style block
+// systems and for scalar SparseMatrix systems.  Vector updates are fused with
+// the dot products that follow them, so each iteration makes as few passes
+// over memory as possible, and all passes run in parallel.  Dot products are
+// reduced deterministically, so iterates don't depend on the thread count.
+//
+// Each solver updates x in place, starting from its initial value, and
+// returns the number of iterations and the final residual norm.  Conjugate
+// gradients stops once |b-Ax| <= tolerance |b|.  MINRES tracks the residual
+// in the norm defined by the preconditioner, and stops once it drops below
+// tolerance times its initial value.
+//
+// Preconditioners approximate the inverse of A and must be symmetric
+// positive definite.  For block systems any SolidMatrixBase works, such as
+// the SolidDiagonalMatrix returned by SolidMatrix::inverse_block_diagonal
+// (block Jacobi).  For sparse systems the preconditioner is an incomplete
+// Cholesky factor from SparseMatrix::incomplete_cholesky_factorization or
+// an AlgebraicMultigrid hierarchy.
+//
+//#####################################################################
+#pragma once
+
+#include <geode/python/Ptr.h>
+#include <geode/structure/Tuple.h>
+#include <geode/vector/SolidMatrix.h>
+#include <geode/vector/SparseMatrix.h>
+namespace geode {
+
+class AlgebraicMultigrid;
+
+// Conjugate gradients for symmetric positive definite A
+template<class TV> GEODE_CORE_EXPORT Tuple<int,real>
+conjugate_gradient(const SolidMatrixBase<TV>& A, RawArray<const TV> b, RawArray<TV> x,
+                   Ptr<const SolidMatrixBase<TV>> preconditioner, const real tolerance, const int max_iterations);
+
+GEODE_CORE_EXPORT Tuple<int,real>
+conjugate_gradient(const SparseMatrix& A, RawArray<const real> b, RawArray<real> x,
+                   Ptr<const SparseMatrix> cholesky, const real tolerance, const int max_iterations);
+
+GEODE_CORE_EXPORT Tuple<int,real>
+conjugate_gradient(const SparseMatrix& A, RawArray<const real> b, RawArray<real> x,
+                   const AlgebraicMultigrid& preconditioner, const real tolerance, const int max_iterations);
+
+// Conjugate gradients for symmetric positive definite A, iterating with a single precision copy of A's blocks
+// (see SolidFloatMatrix).  Each outer step solves for a correction against the float copy, then recomputes the
+// residual with A in double, so the result satisfies the same |b-Ax| <= tolerance |b| test as conjugate_gradient.
+// Stops early if a correction fails to reduce the residual, which happens only if A is too ill conditioned for
+// float blocks.  The returned iteration count sums the inner iterations.
+template<class TV> GEODE_CORE_EXPORT Tuple<int,real>
+mixed_conjugate_gradient(const SolidMatrix<TV>& A, RawArray<const TV> b, RawArray<TV> x,
+                         Ptr<const SolidMatrixBase<TV>> preconditioner, const real tolerance, const int max_iterations);
+
+// MINRES for symmetric, possibly indefinite A
+template<class TV> GEODE_CORE_EXPORT Tuple<int,real>
+minres(const SolidMatrixBase<TV>& A, RawArray<const TV> b, RawArray<TV> x,
+       Ptr<const SolidMatrixBase<TV>> preconditioner, const real tolerance, const int max_iterations);
+
+GEODE_CORE_EXPORT Tuple<int,real>
+minres(const SparseMatrix& A, RawArray<const real> b, RawArray<real> x,
+       Ptr<const SparseMatrix> cholesky, const real tolerance, const int max_iterations);
+
+GEODE_CORE_EXPORT Tuple<int,real>
+minres(const SparseMatrix& A, RawArray<const real> b, RawArray<real> x,
+       const AlgebraicMultigrid& preconditioner, const real tolerance, const int max_iterations);
+
+}
@@ -0,0 +1,171 @@
+// Limited memory BFGS
+
+#include <geode/solver/lbfgs.h>
+#include <geode/array/Array2d.h>
+#include <geode/math/clamp.h>
+#include <geode/python/function.h>
+#include <geode/python/wrap.h>
+#include <geode/utility/curry.h>
+#include <geode/utility/parallel.h>
+#include <cmath>
+#include <limits>
+namespace geode {
+
+typedef real T;
+
+// Elementwise passes are small, so use large chunks
+static const int grain = 4096;
+
+static T dot(RawArray<const T> a, RawArray<const T> b) {
+  return parallel_reduce<T>(a.size(),[&](const int i) { return a[i]*b[i]; },grain);
+}
+
+static Tuple<T,int> lbfgs_helper(const function<T(RawArray<const T>,RawArray<T>)>& f, RawArray<T> x,
+                                 RawArray<const T> lower, RawArray<const T> upper,
+                                 const int m, const T gtol, const T ftol, const int maxiter) {
+  const int n = x.size();
+  const bool bounded = lower.size()>0;
+  GEODE_ASSERT(m>=1 && gtol>=0 && ftol>=0 && maxiter>=0);
+  if (bounded) {
+    GEODE_ASSERT(lower.size()==n && upper.size()==n);
+    for (int i=0;i<n;i++) {
+      GEODE_ASSERT(lower[i]<=upper[i]);
+      x[i] = clamp(x[i],lower[i],upper[i]);
+    }
+  }
+  const T c1 = 1e-4, c2 = .9, inf = std::numeric_limits<T>::infinity();
+  const int max_line_search = 50;
+
+  // Correction pairs are stored circularly, with newest the most recent and pairs the number in use
+  Array<T,2> S(m,n,uninit), Y(m,n,uninit);
+  Array<T> rho(m,uninit), alpha(m,uninit), g(n,uninit), d(n,uninit), x0(n,uninit), g0(n,uninit);
+  int newest = m-1, pairs = 0;
+
+  // A variable is held if it sits at a bound and the gradient pushes it outward
+  const auto held = [&](const int i) {
+    return bounded && ((x[i]<=lower[i] && g[i]>0) || (x[i]>=upper[i] && g[i]<0));
+  };
+
+  T fx = f(x,g);
+  int iter = 0;
+  while (iter<maxiter) {
+    // Check the projected gradient, and start the two loop recursion from it
+    const T gnorm = parallel_reduce<T>(n,[&](const int i) {
+      d[i] = held(i) ? 0 : -g[i];
+      return abs(bounded ? clamp(x[i]-g[i],lower[i],upper[i])-x[i] : g[i]);
+    },[](T& a, const T b) { a = max(a,b); },grain);
+    if (gnorm<=gtol)
+      break;
+    for (int k=0;k<pairs;k++) {
+      const int j = (newest-k+m)%m;
+      alpha[j] = rho[j]*dot(S[j],d);
+      const T a = alpha[j];
+      parallel_for(n,[&](const int i) { d[i] -= a*Y[j][i]; },grain);
+    }
+    // Scale by the usual estimate of the inverse Hessian, or take a unit length first step
+    const T gamma = pairs ? 1/(rho[newest]*dot(Y[newest],Y[newest])) : 1/sqrt(dot(d,d));
+    parallel_for(n,[&](const int i) { d[i] *= gamma; },grain);
+    for (int k=pairs-1;k>=0;k--) {
+      const int j = (newest-k+m)%m;
+      const T a = alpha[j]-rho[j]*dot(Y[j],d);
+      parallel_for(n,[&](const int i) { d[i] += a*S[j][i]; },grain);
+    }
+    if (bounded)
+      parallel_for(n,[&](const int i) { if (held(i)) d[i] = 0; },grain);
+    T dg = dot(d,g);
+    if (!(dg<0)) { // The curvature pairs have gone bad, so forget them and go downhill
+      pairs = 0;
+      parallel_for(n,[&](const int i) { d[i] = held(i) ? 0 : -g[i]; },grain);
+      const T dd = dot(d,d);
+      parallel_for(n,[&](const int i) { d[i] /= sqrt(dd); },grain);
+      dg = -sqrt(dd);
+    }
+
+    // Line search.  Unbounded steps bracket a weak Wolfe point by doubling and bisection; bounded steps backtrack
+    // along the projected path until the Armijo condition holds.
+    const T f0 = fx;
+    parallel_for(n,[&](const int i) { x0[i] = x[i]; g0[i] = g[i]; },grain);
+    T t = 1, lo = 0, hi = inf;
+    int search = 0;
+    for (;;) {
+      parallel_for(n,[&](const int i) {
+        const T xi = x0[i]+t*d[i];
+        x[i] = bounded ? clamp(xi,lower[i],upper[i]) : xi;
+      },grain);
+      fx = f(x,g);
+      const T decrease = bounded ? parallel_reduce<T>(n,[&](const int i) { return g0[i]*(x[i]-x0[i]); },grain)
+                                 : t*dg;
+      if (!(fx<=f0+c1*decrease))
+        hi = t;
+      else if (!bounded && dot(g,d)<c2*dg)
+        lo = t;
+      else
+        break;
+      if (++search==max_line_search)
+        break;
+      t = bounded ? t/2 : hi<inf ? (lo+hi)/2 : 2*t;
+    }
+    if (search==max_line_search) { // No acceptable step, so restore the last iterate and give up
+      parallel_for(n,[&](const int i) { x[i] = x0[i]; g[i] = g0[i]; },grain);
+      fx = f0;
+      break;
+    }
+    iter++;
+
+    // Remember the new correction pair if it has positive curvature, overwriting the oldest
+    const int next = (newest+1)%m;
+    RawArray<T> s = S[next], y = Y[next];
+    const auto sy_yy = parallel_reduce<Vector<T,2>>(n,[&](const int i) {
+      s[i] = x[i]-x0[i];
+      y[i] = g[i]-g0[i];
+      return vec(s[i]*y[i],y[i]*y[i]);
+    },grain);
+    if (sy_yy.x>std::numeric_limits<T>::epsilon()*sy_yy.y) {
+      newest = next;
+      rho[next] = 1/sy_yy.x;
+      pairs = min(pairs+1,m);
+    } else // The slot held the oldest pair if all were in use
+      pairs = min(pairs,m-1);
+
+    if (f0-fx<=ftol)
+      break;
+  }
+  return tuple(fx,iter);
+}
+
+Tuple<T,int> lbfgs(const function<T(RawArray<const T>,RawArray<T>)>& f, RawArray<T> x,
+                   const int m, const T gtol, const T ftol, const int maxiter) {
+  return lbfgs_helper(f,x,RawArray<const T>(),RawArray<const T>(),m,gtol,ftol,maxiter);
+}
+
+Tuple<T,int> lbfgs(const function<T(RawArray<const T>,RawArray<T>)>& f, RawArray<T> x,
+                   RawArray<const T> lower, RawArray<const T> upper,
+                   const int m, const T gtol, const T ftol, const int maxiter) {
+  GEODE_ASSERT(lower.size()==x.size() && upper.size()==x.size());
+  return lbfgs_helper(f,x,lower,upper,m,gtol,ftol,maxiter);
+}
+
+// Python callers receive x and g as arrays sharing our memory, and fill in g in place
+static T f_py(const function<T(Array<const T>,Array<T>)>& f, RawArray<const T> x, RawArray<T> g) {
+  TemporaryOwner owner;
+  return f(owner.share(x),owner.share(g));
+}
+
+static Tuple<T,int> lbfgs_py(const function<T(Array<const T>,Array<T>)>& f, RawArray<T> x,
+                             const int m, const T gtol, const T ftol, const int maxiter) {
+  return lbfgs(curry(f_py,f),x,m,gtol,ftol,maxiter);
+}
+
+static Tuple<T,int> lbfgs_bounded_py(const function<T(Array<const T>,Array<T>)>& f, RawArray<T> x,
+                                     RawArray<const T> lower, RawArray<const T> upper,
+                                     const int m, const T gtol, const T ftol, const int maxiter) {
+  return lbfgs(curry(f_py,f),x,lower,upper,m,gtol,ftol,maxiter);
+}
+
+}
+using namespace geode;
+
+void wrap_lbfgs() {
+  GEODE_FUNCTION_2(lbfgs,lbfgs_py)
+  GEODE_FUNCTION_2(lbfgs_bounded,lbfgs_bounded_py)
+}
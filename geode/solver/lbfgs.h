@@ -0,0 +1,30 @@
+#pragma once
+
+// Limited memory BFGS for smooth minimization, following Nocedal and Wright, Numerical Optimization, chapter 7.
+// The bounded variant projects each step onto the box and restricts the quasi-Newton direction to the variables
+// not held at a bound, in the spirit of projected L-BFGS.
+
+#include <geode/array/RawArray.h>
+#include <geode/structure/Tuple.h>
+#include <geode/utility/function.h>
+namespace geode {
+
+// Minimize a smooth function using L-BFGS.  Like powell, all tolerances are absolute.
+// Arguments:
+//   f: f(x,g) returns the value at x and sets g to the gradient at x
+//   x: starting point, updated in place
+//   m: number of correction pairs remembered
+//   gtol: stop once the largest gradient entry is at most gtol in magnitude
+//   ftol: stop once an iteration decreases f by at most ftol
+// Steps satisfy the weak Wolfe conditions, found by expanding and bisecting a bracket.  All storage is allocated
+// up front, so iterations don't allocate.  Returns f(x) and the number of iterations.
+GEODE_CORE_EXPORT Tuple<real,int> lbfgs(const function<real(RawArray<const real>,RawArray<real>)>& f, RawArray<real> x,
+                                        int m, real gtol, real ftol, int maxiter);
+
+// Same as above, but minimize subject to lower <= x <= upper.  Bounds may be infinite.  The gradient test uses
+// the projected gradient, and steps backtrack along the projected path until f decreases sufficiently.
+GEODE_CORE_EXPORT Tuple<real,int> lbfgs(const function<real(RawArray<const real>,RawArray<real>)>& f, RawArray<real> x,
+                                        RawArray<const real> lower, RawArray<const real> upper,
+                                        int m, real gtol, real ftol, int maxiter);
+
+}
@@ -1,6 +1,10 @@
 #include <geode/python/wrap.h>
 
 void wrap_solver() {
+  GEODE_WRAP(algebraic_multigrid)
   GEODE_WRAP(brent)
+  GEODE_WRAP(krylov)
+  GEODE_WRAP(lbfgs)
   GEODE_WRAP(powell)
+  GEODE_WRAP(sparse_cholesky)
 }
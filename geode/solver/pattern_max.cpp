@@ -1,25 +1,34 @@
 #include <geode/solver/pattern_max.h>
+#include <geode/array/Array.h>
 #include <geode/math/constants.h>
+#include <geode/utility/parallel.h>
 namespace geode {
 
-real spherical_pattern_maximize(const function<real(Vector<real,3>)>& score, Vector<real,3>& n, real tol) {
+typedef real T;
+typedef Vector<T,3> TV;
+
+real spherical_pattern_maximize_batched(const function<void(RawArray<const TV>,RawArray<T>)>& scores, TV& n, real tol) {
   static const real da = 2*pi/5;
   static const Vector<real,2> dirs[5] = {polar(0.), polar(da), polar(2*da), polar(3*da), polar(4*da)};
   const real alpha = .5;
   real step = .2;
-  real dot = score(n);
+  TV candidates[5];
+  real values[5];
+  scores(RawArray<const TV>(1,&n),RawArray<T>(1,values));
+  real dot = values[0];
   while (step > tol) {
     real best_dot = dot;
     Vector<real,3> best_n = n;
     Vector<real,3> orth;
     orth[n.argmin()] = 1;
     Vector<real,3> a = cross(n,orth).normalized(), b = cross(n,a);
+    for (int i = 0; i < 5; i++)
+      candidates[i] = (n + step*dirs[i].x*a + step*dirs[i].y*b).normalized();
+    scores(RawArray<const TV>(5,candidates),RawArray<T>(5,values));
     for (int i = 0; i < 5; i++) {
-      Vector<real,3> candidate = (n + step*dirs[i].x*a + step*dirs[i].y*b).normalized();
-      real d = score(candidate);
-      if (best_dot < d) {
-        best_dot = d;
-        best_n = candidate;
+      if (best_dot < values[i]) {
+        best_dot = values[i];
+        best_n = candidates[i];
       }
     }
     if (dot < best_dot) {
@@ -31,4 +40,21 @@ real spherical_pattern_maximize(const function<real(Vector<real,3>)>& score, Vec
   return dot;
 }
 
+real spherical_pattern_maximize(const function<real(TV)>& score, TV& n, real tol) {
+  return spherical_pattern_maximize_batched([&](RawArray<const TV> ns, RawArray<T> s) {
+    for (int i=0;i<ns.size();i++)
+      s[i] = score(ns[i]);
+  },n,tol);
+}
+
+Tuple<int,real> parallel_spherical_pattern_maximize(const function<real(TV)>& score, RawArray<TV> ns, real tol) {
+  GEODE_ASSERT(ns.size());
+  Array<T> dots(ns.size(),uninit);
+  parallel_for(ns.size(),[&](const int i) {
+    dots[i] = spherical_pattern_maximize(score,ns[i],tol);
+  });
+  const int best = dots.argmax();
+  return tuple(best,dots[best]);
+}
+
 }
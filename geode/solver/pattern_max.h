@@ -1,5 +1,7 @@
 #pragma once
 
+#include <geode/array/RawArray.h>
+#include <geode/structure/Tuple.h>
 #include <geode/utility/function.h>
 #include <geode/vector/Vector.h>
 namespace geode {
@@ -7,4 +9,15 @@ namespace geode {
 // Maximize a functional over a sphere using pattern search
 GEODE_CORE_EXPORT real spherical_pattern_maximize(const function<real(Vector<real,3>)>& score, Vector<real,3>& n, real tol);
 
+// Same as above, but scores(ns,s) sets s[i] to the score of ns[i].  Each iteration's probes are scored with one call,
+// so expensive scores can evaluate them together.
+GEODE_CORE_EXPORT real spherical_pattern_maximize_batched(const function<void(RawArray<const Vector<real,3>>,RawArray<real>)>& scores,
+                                                          Vector<real,3>& n, real tol);
+
+// Run pattern search from each of the starting directions ns in parallel, updating them in place.  score must be
+// safe to call from several threads at once.  Returns the index of the best direction and its score, preferring
+// the first on ties, so the result doesn't depend on the thread count.
+GEODE_CORE_EXPORT Tuple<int,real> parallel_spherical_pattern_maximize(const function<real(Vector<real,3>)>& score,
+                                                                      RawArray<Vector<real,3>> ns, real tol);
+
 }
@@ -13,6 +13,7 @@
 #include <geode/python/function.h>
 #include <geode/python/wrap.h>
 #include <geode/utility/curry.h>
+#include <geode/utility/parallel.h>
 namespace geode {
 
 typedef real T;
@@ -93,6 +94,16 @@ Tuple<T,int> powell(const function<T(RawArray<const T>)>& f, RawArray<T> x, T sc
   return tuple(fval,iter);
 }
 
+Tuple<int,T> parallel_powell(const function<T(RawArray<const T>)>& f, RawArray<T,2> X, T scale, T xtol, T ftol, int maxiter) {
+  GEODE_ASSERT(X.m);
+  Array<T> fval(X.m,uninit);
+  parallel_for(X.m,[&](const int i) {
+    fval[i] = powell(f,X[i],scale,xtol,ftol,maxiter).x;
+  });
+  const int best = fval.argmin();
+  return tuple(best,fval[best]);
+}
+
 static T f_py(const function<T(Array<const T>)>& f, RawArray<const T> p) {
   TemporaryOwner owner;
   return f(owner.share(p));
@@ -22,4 +22,9 @@ namespace geode {
 //   ftol: absolute function value tolerance
 GEODE_CORE_EXPORT Tuple<real,int> powell(const function<real(RawArray<const real>)>& f, RawArray<real> x, real scale, real xtol, real ftol, int maxiter);
 
+// Run Powell's method from each row of X in parallel, minimizing the rows in place.  f must be safe to call from
+// several threads at once.  Returns the index of the best row and its function value, preferring the first on ties,
+// so the result doesn't depend on the thread count.
+GEODE_CORE_EXPORT Tuple<int,real> parallel_powell(const function<real(RawArray<const real>)>& f, RawArray<real,2> X, real scale, real xtol, real ftol, int maxiter);
+
 }
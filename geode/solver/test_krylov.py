@@ -0,0 +1,121 @@
+#!/usr/bin/env python
+
+from __future__ import division
+from geode import *
+from numpy import *
+
+def laplacian(m,shift):
+  J,A = [],[]
+  for i in xrange(m):
+    for j in xrange(m):
+      row = [(i*m+j,4+shift)]
+      if i: row.append(((i-1)*m+j,-1))
+      if i+1<m: row.append(((i+1)*m+j,-1))
+      if j: row.append((i*m+j-1,-1))
+      if j+1<m: row.append((i*m+j+1,-1))
+      J.append([k for k,_ in row])
+      A.extend(a for _,a in row)
+  return SparseMatrix(Nested(J,dtype=int32),array(A,dtype=real))
+
+def test_sparse_krylov():
+  random.seed(7123)
+  M = laplacian(20,.01)
+  C = M.incomplete_cholesky_factorization()
+  b = random.randn(M.rows())
+  for solve in sparse_conjugate_gradient,sparse_minres:
+    for P in None,C:
+      x = zeros_like(b)
+      iterations,residual = solve(M,b,x,P,1e-10,1000)
+      Mx = empty_like(b)
+      M.multiply(x,Mx)
+      assert iterations<1000
+      assert relative_error(Mx,b)<1e-8
+
+def test_sparse_minres_indefinite():
+  random.seed(7124)
+  M = laplacian(10,-1.5)
+  b = random.randn(M.rows())
+  x = zeros_like(b)
+  sparse_minres(M,b,x,None,1e-10,10000)
+  Mx = empty_like(b)
+  M.multiply(x,Mx)
+  assert relative_error(Mx,b)<1e-7
+
+def test_sparse_cholesky():
+  random.seed(7125)
+  M = laplacian(20,.01)
+  C = SparseCholesky(M)
+  assert all(sort(C.order)==arange(M.rows()))
+  assert C.nonzeros()<M.rows()**2//8
+  b = random.randn(M.rows())
+  x = empty_like(b)
+  C.solve(b,x)
+  Mx = empty_like(b)
+  M.multiply(x,Mx)
+  assert relative_error(Mx,b)<1e-10
+
+def test_multigrid():
+  random.seed(7126)
+  M = laplacian(40,0)
+  amg = AlgebraicMultigrid(M,.08,50)
+  assert amg.levels()>1
+  assert all(diff(amg.sizes())<0)
+  b = random.randn(M.rows())
+  x = zeros_like(b)
+  iterations,residual = amg.conjugate_gradient(b,x,1e-10,100)
+  y = zeros_like(b)
+  plain,_ = sparse_conjugate_gradient(M,b,y,None,1e-10,1000)
+  assert iterations<plain
+  Mx = empty_like(b)
+  M.multiply(x,Mx)
+  assert relative_error(Mx,b)<1e-8
+
+def test_solid_krylov():
+  random.seed(7125)
+  n = 50
+  structure = SolidMatrixStructure(n)
+  for i in xrange(n-1):
+    structure.add_entry(i,i+1)
+  A = SolidMatrix[3](structure)
+  for i in xrange(n-1):
+    A.add_entry(i,i+1,-eye(3))
+  A.add_scalar(2.5)
+  b = random.randn(n,3)
+  for solve in conjugate_gradient_3d,minres_3d:
+    for P in None,A.inverse_block_diagonal():
+      x = zeros_like(b)
+      solve(A,b,x,P,1e-10,1000)
+      Ax = empty_like(b)
+      A.multiply(x,Ax)
+      assert relative_error(Ax,b)<1e-8
+
+def test_mixed_krylov():
+  random.seed(7127)
+  n = 50
+  structure = SolidMatrixStructure(n)
+  for i in xrange(n-1):
+    structure.add_entry(i,i+1)
+  A = SolidMatrix[3](structure)
+  for i in xrange(n-1):
+    A.add_entry(i,i+1,-eye(3)+.1*random.randn(3,3))
+  A.add_scalar(3)
+  b = random.randn(n,3)
+  F = A.single_precision()
+  x = random.randn(n,3)
+  Ax,Fx = empty_like(x),empty_like(x)
+  A.multiply(x,Ax)
+  F.multiply(x,Fx)
+  assert relative_error(Fx,Ax)<1e-6
+  for P in None,A.inverse_block_diagonal():
+    x = zeros_like(b)
+    iterations,residual = mixed_conjugate_gradient_3d(A,b,x,P,1e-10,1000)
+    assert iterations<1000
+    A.multiply(x,Ax)
+    assert relative_error(Ax,b)<1e-8
+
+if __name__=='__main__':
+  test_sparse_krylov()
+  test_sparse_minres_indefinite()
+  test_multigrid()
+  test_solid_krylov()
+  test_mixed_krylov()
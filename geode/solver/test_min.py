@@ -44,6 +44,26 @@ def test_powell():
     assert maxabs(x-xc)<2*tol
     assert abs(fx-fc)<tol
 
+def test_lbfgs():
+  def f(x,g):
+    a,b = x[1::2]-x[::2]**2,1-x[::2]
+    g[::2] = -400*a*x[::2]-2*b
+    g[1::2] = 200*a
+    return sum(100*a*a+b*b)
+  x = tile((-1.2,1.),50)
+  fx,i = lbfgs(f,x,10,1e-8,0,1000)
+  assert i<1000
+  assert maxabs(x-1)<1e-6
+  assert fx<1e-12
+  # Bounds hold some variables away from the unconstrained minimum
+  lower,upper = -2*ones_like(x),ones_like(x)
+  upper[::2] = .8
+  x = zeros_like(x)
+  fx,i = lbfgs_bounded(f,x,lower,upper,10,1e-8,0,1000)
+  assert all(lower<=x) and all(x<=upper)
+  assert maxabs(x[::2]-.8)<1e-6
+  assert maxabs(x[1::2]-.64)<1e-6
+
 def test_nelder_mead():
   def f((x,y)):
     return abs((3-2*x)*x-2*y+1)**(7/3) + abs((3-2*y)*y-x+1)**(7/3)
@@ -52,5 +72,6 @@ def test_nelder_mead():
 
 if __name__=='__main__':
   test_powell()
+  test_lbfgs()
   test_bracket()
   test_brent()
@@ -0,0 +1,158 @@
+//#####################################################################
+// Class ConcurrentHashtable
+//#####################################################################
+//
+// A fixed capacity hashtable which any number of threads may insert into
+// and search at once, for parallel passes which would otherwise build one
+// Hashtable per thread and merge them serially.  Slots are claimed with a
+// single compare and swap on a state byte, so there are no locks, and a
+// reader that meets a slot still being written waits only for that slot.
+//
+// Keys and values must be trivially copyable, such as Vector<int,2>.  The
+// value stored is that of the first insert for each key; add and min update
+// integer values atomically.  Entries can't be erased.  Once the parallel
+// pass is over, freeze converts the table into a regular Hashtable.
+//
+//#####################################################################
+#pragma once
+
+#include <geode/structure/Hashtable.h>
+#include <atomic>
+#include <memory>
+namespace geode {
+
+template<class TK,class T> // T = Unit
+class ConcurrentHashtable {
+  static_assert(std::is_trivially_destructible<TK>::value && std::is_trivially_destructible<T>::value,
+                "ConcurrentHashtable requires plain old data keys and values");
+  enum State : uint8_t { Empty, Busy, Full };
+  struct Slot {
+    std::atomic<uint8_t> state;
+    TK key;
+    T value;
+  };
+
+  const int max_size_;
+  const int mask;
+  std::unique_ptr<Slot[]> table;
+  std::atomic<int> size_;
+public:
+  typedef TK Key;
+  typedef T Element;
+
+  // Room for max_size entries.  The table has at least twice that many slots, so probes stay short.
+  explicit ConcurrentHashtable(const int max_size)
+    : max_size_(max(max_size,0))
+    , mask(int(next_power_of_two(uint32_t(2*int64_t(max_size_)+1)))-1)
+    , table(new Slot[mask+1])
+    , size_(0) {
+    for (int i=0;i<=mask;i++)
+      table[i].state.store(Empty,std::memory_order_relaxed);
+  }
+
+  int size() const {
+    return size_.load(std::memory_order_relaxed);
+  }
+
+  int max_size() const {
+    return max_size_;
+  }
+
+  // Insert v if k is absent.  Returns the stored value, and whether this call inserted it.
+  Tuple<T*,bool> insert(const TK& k, const T& v) {
+    return insert(k,v,hash(k));
+  }
+
+  // Versions of insert, get_pointer, and min taking hk = hash(k), e.g. precomputed by hash_batch
+  Tuple<T*,bool> insert(const TK& k, const T& v, const int hk) {
+    for (int h=hk&mask;;h=(h+1)&mask) {
+      Slot& slot = table[h];
+      uint8_t state = slot.state.load(std::memory_order_acquire);
+      if (state==Empty) {
+        if (slot.state.compare_exchange_strong(state,Busy,std::memory_order_acquire)) {
+          if (size_.fetch_add(1,std::memory_order_relaxed)>=max_size_) {
+            slot.state.store(Empty,std::memory_order_release);
+            throw RuntimeError("ConcurrentHashtable: more than max_size entries");
+          }
+          slot.key = k;
+          slot.value = v;
+          slot.state.store(Full,std::memory_order_release);
+          return tuple(&slot.value,true);
+        }
+        // Another thread claimed the slot first, so fall through and check its key
+      }
+      while (state==Busy)
+        state = slot.state.load(std::memory_order_acquire);
+      if (state==Full && slot.key==k)
+        return tuple(&slot.value,false);
+    }
+  }
+
+  // Insert k into a set, returning whether this call inserted it
+  bool set(const TK& k) {
+    return insert(k,unit).y;
+  }
+
+  // Pointer to the value for k, or null if absent
+  T* get_pointer(const TK& k) const {
+    return get_pointer(k,hash(k));
+  }
+
+  T* get_pointer(const TK& k, const int hk) const {
+    for (int h=hk&mask;;h=(h+1)&mask) {
+      Slot& slot = table[h];
+      uint8_t state;
+      while ((state=slot.state.load(std::memory_order_acquire))==Busy);
+      if (state==Empty)
+        return 0;
+      if (slot.key==k)
+        return &slot.value;
+    }
+  }
+
+  bool contains(const TK& k) const {
+    return get_pointer(k)!=0;
+  }
+
+  T get_default(const TK& k, const T& default_=T()) const {
+    const T* v = get_pointer(k);
+    return v ? *v : default_;
+  }
+
+  // Atomically add delta to the value for k, inserting zero first if absent, and return the new value
+  T add(const TK& k, const T& delta) {
+    return atomic(*insert(k,T()).x).fetch_add(delta,std::memory_order_relaxed)+delta;
+  }
+
+  // Atomically lower the value for k to v if v is smaller, inserting v if absent, and return the new value
+  T min(const TK& k, const T& v) {
+    return min(k,v,hash(k));
+  }
+
+  T min(const TK& k, const T& v, const int hk) {
+    const auto r = insert(k,v,hk);
+    if (r.y)
+      return v;
+    auto& value = atomic(*r.x);
+    T old = value.load(std::memory_order_relaxed);
+    while (v<old && !value.compare_exchange_weak(old,v,std::memory_order_relaxed));
+    return geode::min(old,v);
+  }
+
+  // Copy into a regular Hashtable.  No inserts may be in progress.
+  Hashtable<TK,T> freeze() const {
+    Hashtable<TK,T> result(size());
+    for (int i=0;i<=mask;i++)
+      if (table[i].state.load(std::memory_order_acquire)==Full)
+        result.insert(table[i].key,table[i].value);
+    return result;
+  }
+
+private:
+  static std::atomic<T>& atomic(T& value) {
+    static_assert(std::is_integral<T>::value && sizeof(std::atomic<T>)==sizeof(T),"add and min require integer values");
+    return reinterpret_cast<std::atomic<T>&>(value);
+  }
+};
+
+}
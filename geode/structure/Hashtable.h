@@ -1,9 +1,24 @@
 //#####################################################################
 // Class Hashtable
-// This hashtable is about twice as fast as the tr1::unordered_map.
-// A wrapper class for tr1::unordered_map can be found in STLHashtable.h
-// in the STLHashtable branch. It can be used to globally replace
-// Hashtable if that is desired.
+//#####################################################################
+//
+// An open addressing hashtable with linear probing, in the style of Swiss
+// tables.  A separate array of control bytes holds a 7 bit tag from each
+// key's hash, or a marker for empty slots, so probes compare sixteen tags at
+// once with SSE2 and only touch entries whose tags match.  The control bytes
+// for the first group are mirrored past the end of the table so that groups
+// can start at any slot.
+//
+// An entry's home slot is the top bits of its hash times an odd multiplier
+// that depends on the table size.  If every size used the same bits, filling
+// one table in another's iteration order would crowd entries into one part
+// of the table as it grows, making probe runs quadratically long.
+//
+// Erasing shifts later entries of the probe run backwards, so there are no
+// tombstones and lookups stay short no matter how many entries are erased.
+// As a consequence, erasing during iteration may skip entries.  Tables grow
+// at a load of 7/8.
+//
 //#####################################################################
 #pragma once
 
@@ -15,6 +30,12 @@
 #include <geode/structure/Tuple.h>
 #include <geode/utility/type_traits.h>
 #include <vector>
+#ifdef GEODE_SSE
+#include <emmintrin.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 namespace geode {
 
 using std::vector;
@@ -22,36 +43,31 @@ using std::ostream;
 template<class TK,class T> struct HashtableIter;
 template<class TK,class T> class Hashtable;
 
-// Entries
-
-enum HashtableEntryState{EntryFree,EntryActive,EntryDeleted};
+// Entries hold uninitialized storage for a key and value.  Which entries are active is recorded in the control bytes.
 
 template<class TK,class T> struct HashtableEntry {
   typename aligned_storage<sizeof(TK),alignment_of<TK>::value>::type TKbuf;
   typename aligned_storage<sizeof(T),alignment_of<T>::value>::type Tbuf;
-  HashtableEntryState state;
 
   void init(const TK& k, const T& v) {
     new(&TKbuf) TK(k);
     new(&Tbuf) T(v);
-    state = EntryActive;
   }
 
-  void destroy() {
-    if (state == EntryActive) {
-      static_cast<const TK*>(static_cast<const void*>(&TKbuf))->~TK();
-      static_cast<const T*>(static_cast<const void*>(&Tbuf))->~T();
-    }
-    state = EntryDeleted;
+  // Move another entry here, destroying it
+  void move(HashtableEntry& e) {
+    new(&TKbuf) TK(std::move(const_cast<TK&>(e.key())));
+    new(&Tbuf) T(std::move(e.data()));
+    e.destroy();
   }
 
-  ~HashtableEntry() {
-    destroy();
+  void destroy() {
+    key().~TK();
+    data().~T();
   }
 
   const TK& key() const { return reinterpret_cast<const TK&>(TKbuf); };
   T& data() const { return reinterpret_cast<T&>(const_cast_(Tbuf)); };
-  bool active() const { return state==EntryActive; }
 
   Tuple<const TK,T>& value() { return reinterpret_cast<Tuple<const TK,T>&>(*this); }
   const Tuple<const TK,T>& value() const { return reinterpret_cast<const Tuple<const TK,T>&>(*this); }
@@ -59,31 +75,73 @@ template<class TK,class T> struct HashtableEntry {
 
 template<class TK> struct HashtableEntry<TK,Unit> : public Unit {
   typename aligned_storage<sizeof(TK), alignment_of<TK>::value>::type TKbuf;
-  HashtableEntryState state;
 
-  void destroy() {
-    if (state == EntryActive) {
-      static_cast<const TK*>(static_cast<const void*>(&TKbuf))->~TK();
-    }
-    state = EntryDeleted;
+  void init(const TK& k, Unit) {
+    new(&TKbuf) TK(k);
   }
 
-  ~HashtableEntry() {
-    destroy();
+  void move(HashtableEntry& e) {
+    new(&TKbuf) TK(std::move(const_cast<TK&>(e.key())));
+    e.destroy();
   }
 
-  void init(const TK& k, Unit) {
-    new(&TKbuf) TK(k);
-    state = EntryActive;
+  void destroy() {
+    key().~TK();
   }
 
   const TK& key() const { return reinterpret_cast<const TK&>(TKbuf); }
   Unit& data() { return *this; }
-  bool active() const { return state==EntryActive; }
+  const Unit& data() const { return *this; }
 
   const TK& value() const { return key(); }
 };
 
+// Groups of control bytes
+
+static const uint8_t hashtable_empty = 0x80; // Control byte for empty slots.  Active slots hold a tag below 0x80.
+static const int hashtable_group = 16; // Control bytes examined at once
+
+static inline int hashtable_lowest_bit(const unsigned mask) {
+  assert(mask);
+#ifdef _MSC_VER
+  unsigned long i;
+  _BitScanForward(&i,mask);
+  return int(i);
+#else
+  return __builtin_ctz(mask);
+#endif
+}
+
+// Bitmasks of the slots in a group with a given control byte
+struct HashtableGroup {
+#ifdef GEODE_SSE
+  const __m128i control;
+
+  explicit HashtableGroup(const uint8_t* control)
+    : control(_mm_loadu_si128((const __m128i*)control)) {}
+
+  unsigned match(const uint8_t c) const {
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(control,_mm_set1_epi8(char(c))));
+  }
+#else
+  const uint8_t* const control;
+
+  explicit HashtableGroup(const uint8_t* control)
+    : control(control) {}
+
+  unsigned match(const uint8_t c) const {
+    unsigned mask = 0;
+    for (int i=0;i<hashtable_group;i++)
+      mask |= unsigned(control[i]==c)<<i;
+    return mask;
+  }
+#endif
+
+  unsigned match_empty() const {
+    return match(hashtable_empty);
+  }
+};
+
 // Tables
 
 template<class TK,class T> // T = Unit
@@ -98,19 +156,54 @@ public:
   typedef typename remove_const_reference<decltype(declval<Entry>().value())>::type value_type;
 private:
   vector<Entry> table_;
+  vector<uint8_t> control_; // One byte per entry, followed by a copy of the first group
   int size_;
   int next_resize_;
+  int shift_; // Home slot of hash h is (h*multiplier_)>>shift_
+  unsigned multiplier_;
 public:
 
-  explicit Hashtable(const int estimated_max_size=5) {
+  explicit Hashtable(const int estimated_max_size=5)
+    : size_(0) {
     initialize_new_table(estimated_max_size);
   }
 
-  Hashtable(const Tuple<>&) { // Allow conversion from empty tuples
+  Hashtable(const Tuple<>&) // Allow conversion from empty tuples
+    : size_(0) {
     initialize_new_table(5);
   }
 
-  ~Hashtable() {}
+  Hashtable(const Hashtable& other)
+    : table_(other.table_.size())
+    , control_(other.control_)
+    , size_(other.size_)
+    , next_resize_(other.next_resize_)
+    , shift_(other.shift_)
+    , multiplier_(other.multiplier_) {
+    for (int i=0;i<max_size();i++)
+      if (active(i))
+        table_[i].init(other.table_[i].key(),other.table_[i].data());
+  }
+
+  Hashtable(Hashtable&& other)
+    : table_(std::move(other.table_))
+    , control_(std::move(other.control_))
+    , size_(other.size_)
+    , next_resize_(other.next_resize_)
+    , shift_(other.shift_)
+    , multiplier_(other.multiplier_) {
+    other.size_ = 0;
+    other.initialize_new_table(5);
+  }
+
+  Hashtable& operator=(Hashtable other) {
+    swap(other);
+    return *this;
+  }
+
+  ~Hashtable() {
+    destroy_all();
+  }
 
   void clean_memory() {
     initialize_new_table(5); // can't resize to zero since table_.size() must be a power of two
@@ -133,56 +226,113 @@ public:
   }
 
   void initialize_new_table(const int estimated_max_size_) {
-    next_resize_ = max(5,estimated_max_size_);
-    unsigned estimated_table_entries = (unsigned int)(next_resize_*4/3+1); // choose so load is .75
-    int number_of_lists = next_power_of_two(estimated_table_entries);
-    table_.resize(number_of_lists); // TODO: only resize if significantly reducing the size
-    clear();
+    destroy_all();
+    const int estimated_max_size = max(5,estimated_max_size_);
+    const int n = max(hashtable_group,int(next_power_of_two(uint32_t(int64_t(estimated_max_size)*8/7+1)))); // load at most 7/8
+    next_resize_ = n/8*7;
+    shift_ = 32-integer_log(uint32_t(n));
+    multiplier_ = unsigned(Hash(shift_).val)|1;
+    vector<Entry>(n).swap(table_);
+    control_.assign(n+hashtable_group,hashtable_empty);
+    size_ = 0;
   }
 
   void resize_table(const int estimated_max_size_=0) {
     int estimated_max_size = estimated_max_size_;
     if (!estimated_max_size) estimated_max_size = 3*size_/2;
     vector<Entry> old_table;
+    vector<uint8_t> old_control;
     table_.swap(old_table);
+    control_.swap(old_control);
     initialize_new_table(estimated_max_size);
-    for (int h=0;h<(int)old_table.size();h++) {
-      Entry& entry = old_table[h];
-      if (entry.active()) insert(entry.key(),entry.data());
-    }
+    for (int h=0;h<(int)old_table.size();h++)
+      if (!(old_control[h]&hashtable_empty)) {
+        const int i = free_slot(hash(old_table[h].key()));
+        table_[i].move(old_table[h]);
+        set_control(i,old_control[h]);
+        size_++;
+      }
   }
 
-  // For iterating over a hashtable in parallel
+  // For iterating over a hashtable in parallel: entry i is valid only if active(i)
   RawArray<const Entry> table() const {
     return table_;
   }
 
+  bool active(const int i) const {
+    return !(control_[i]&hashtable_empty);
+  }
+
 private:
-  int next_index(const int h) const { // Linear probing
-    return (h+1)&(table_.size()-1); // power of two so mod is dropping high order bits
+  int mask() const {
+    return int(table_.size())-1; // power of two so mod is dropping high order bits
+  }
+
+  int home(const int h) const {
+    return int(uint64_t(unsigned(h)*multiplier_)>>shift_); // 64 bits so that a shift of 32 is defined
+  }
+
+  static uint8_t tag(const int h) {
+    return uint8_t(h&0x7f); // Low bits, since high bits pick the slot
+  }
+
+  void set_control(const int i, const uint8_t c) {
+    control_[i] = c;
+    if (i<hashtable_group)
+      control_[table_.size()+i] = c;
+  }
+
+  // Index of the entry with key v, or -1 if none
+  int find(const TK& v, const int h) const {
+    const uint8_t t = tag(h);
+    for (int g=home(h);;g=(g+hashtable_group)&mask()) {
+      const HashtableGroup group(&control_[g]);
+      for (unsigned m=group.match(t);m;m&=m-1) {
+        const int i = (g+hashtable_lowest_bit(m))&mask();
+        if (table_[i].key()==v)
+          return i;
+      }
+      if (group.match_empty())
+        return -1;
+    }
   }
 
-  int hash_index(const TK& v) const {
-    return hash(v)&(table_.size()-1); // power of two so mod is dropping high order bits
+  int find(const TK& v) const {
+    return find(v,hash(v));
   }
 
-  bool contains(const TK& v,const int h) const {
-    for (int i=h;;i=next_index(i)) {
-      if (table_[i].state==EntryFree) return false;
-      else if (table_[i].active() && table_[i].key()==v) return true;
+  // Index of the first empty slot in the probe sequence for hash h
+  int free_slot(const int h) const {
+    for (int g=home(h);;g=(g+hashtable_group)&mask())
+      if (const unsigned m = HashtableGroup(&control_[g]).match_empty())
+        return (g+hashtable_lowest_bit(m))&mask();
+  }
+
+  Entry& insert_new(const TK& v, const int h, const T& value) {
+    if (size_>=next_resize_) {
+      resize_table();
+      return insert_new(v,h,value);
     }
+    const int i = free_slot(h);
+    size_++;
+    table_[i].init(v,value);
+    set_control(i,tag(h));
+    return table_[i];
+  }
+
+  void destroy_all() {
+    if (size_)
+      for (int i=0;i<max_size();i++)
+        if (active(i))
+          table_[i].destroy();
+    size_ = 0;
   }
 public:
 
   T& insert(const TK& v, const T& value) { // Assumes no entry with v exists
-    if (size_>next_resize_) resize_table();
-    size_++;
-    int h = hash_index(v);
-    assert(!contains(v,h));
-    for (;table_[h].state!=EntryFree;h=next_index(h));
-    Entry& entry = table_[h];
-    entry.init(v, value);
-    return entry.data();
+    const int h = hash(v);
+    assert(find(v,h)<0);
+    return insert_new(v,h,value).data();
   }
 
   void insert(const TK& v) { // Assumes no entry with v exists
@@ -190,15 +340,11 @@ public:
   }
 
   T& get_or_insert(const TK& v, const T& default_=T()) { // inserts the default if key not found
-    if (size_>next_resize_) resize_table();
-    int h = hash_index(v);
-    for (;table_[h].state!=EntryFree;h=next_index(h))
-      if (table_[h].active() && table_[h].key()==v)
-        return table_[h].data();
-    size_++;
-    Entry& entry = table_[h];
-    entry.init(v, default_);
-    return entry.data();
+    const int h = hash(v);
+    const int i = find(v,h);
+    if (i>=0)
+      return table_[i].data();
+    return insert_new(v,h,default_).data();
   }
 
   T& operator[](const TK& v) { // inserts the default if key not found
@@ -206,10 +352,8 @@ public:
   }
 
   T* get_pointer(const TK& v) { // returns Null if key not found
-    for (int h=hash_index(v);table_[h].state!=EntryFree;h=next_index(h))
-      if (table_[h].active() && table_[h].key()==v)
-        return &table_[h].data();
-    return 0;
+    const int i = find(v);
+    return i>=0 ? &table_[i].data() : 0;
   }
 
   const T* get_pointer(const TK& v) const { // returns 0 if key not found
@@ -233,29 +377,25 @@ public:
   }
 
   bool contains(const TK& v) const {
-    return contains(v,hash_index(v));
+    return find(v)>=0;
   }
 
   bool get(const TK& v, T& value) const {
-    for (int h=hash_index(v);table_[h].state!=EntryFree;h=next_index(h))
-       if (table_[h].active() && table_[h].key==v) {
-          value = table_[h].data();
-          return true;
-        }
+    if (const T* data=get_pointer(v)) {
+      value = *data;
+      return true;
+    }
     return false;
   }
 
   bool set(const TK& v, const T& value) { // if v doesn't exist insert value, else sets its value, returns whether it added a new entry
-    if (size_>next_resize_) resize_table(); // if over load average, have to grow (must do this before computing hash index)
-    int h = hash_index(v);
-    for (;table_[h].state!=EntryFree;h=next_index(h))
-      if (table_[h].active() && table_[h].key()==v) {
-        table_[h].data() = value;
-        return false;
-      }
-    size_++;
-    Entry& entry = table_[h];
-    entry.init(v,value);
+    const int h = hash(v);
+    const int i = find(v,h);
+    if (i>=0) {
+      table_[i].data() = value;
+      return false;
+    }
+    insert_new(v,h,value);
     return true;
   }
 
@@ -264,20 +404,27 @@ public:
   }
 
   bool erase(const TK& v) { // Erase an element if it exists, returning true if so
-    for (int h=hash_index(v);table_[h].state!=EntryFree;h=next_index(h)) // reduce as still are using entries for deletions
-      if (table_[h].active() && table_[h].key()==v) {
-        table_[h].destroy();
-        size_--;
-        next_resize_--;
-        return true;
+    int i = find(v);
+    if (i<0)
+      return false;
+    table_[i].destroy();
+    size_--;
+    // Shift later entries of the probe run back into the hole, unless that would move them before their home slot
+    for (int j=(i+1)&mask();active(j);j=(j+1)&mask()) {
+      const int h = home(hash(table_[j].key()));
+      if (((j-h)&mask())>=((j-i)&mask())) {
+        table_[i].move(table_[j]);
+        set_control(i,control_[j]);
+        i = j;
       }
-    return false;
+    }
+    set_control(i,hashtable_empty);
+    return true;
   }
 
   void clear() {
-    for (int i=0;i<(int)table_.size();i++)
-      table_[i].state = EntryFree;
-    size_ = 0;
+    destroy_all();
+    std::fill(control_.begin(),control_.end(),hashtable_empty);
   }
 
   void swap(const TK& x, const TK& y) { // Swap values at entries x and y; valid if x or y (or both) are not present; efficient for array values
@@ -291,25 +438,27 @@ public:
 
   void swap(Hashtable& other) {
     table_.swap(other.table_);
+    control_.swap(other.control_);
     std::swap(size_,other.size_);
     std::swap(next_resize_,other.next_resize_);
+    std::swap(shift_,other.shift_);
+    std::swap(multiplier_,other.multiplier_);
   }
 
   iterator begin() {
-    return iterator(table_,0);
+    return iterator(table_.data(),control_.data(),max_size(),0);
   }
 
   const_iterator begin() const {
-    return const_iterator(table_,0);
-
+    return const_iterator(table_.data(),control_.data(),max_size(),0);
   }
 
   iterator end() {
-    return iterator(table_,(int)table_.size());
+    return iterator(table_.data(),control_.data(),max_size(),max_size());
   }
 
   const_iterator end() const {
-    return const_iterator(table_,(int)table_.size());
+    return const_iterator(table_.data(),control_.data(),max_size(),max_size());
   }
 };
 
@@ -322,17 +471,19 @@ struct HashtableIter {
   typedef decltype(&(declval<ValueReference>())) ValuePointer;
   // Try to make sure we don't inadvertently start returning copied values during iteration:
   static_assert(is_reference<ValueReference>::value, "HashtableEntry::value() doesn't return a reference. This is likely a bug");
-  const RawArray<Entry> table;
+  Entry* table;
+  const uint8_t* control;
+  int size;
   int index;
 
-  HashtableIter(RawArray<Entry> table, const int index_)
-    : table(table), index(index_) {
-    while (index<table.size() && !table[index].active())
+  HashtableIter(Entry* table, const uint8_t* control, const int size, const int index_)
+    : table(table), control(control), size(size), index(index_) {
+    while (index<size && control[index]&hashtable_empty)
       index++;
   }
 
   void operator=(const HashtableIter& other) {
-    assert(table.data()==other.table.data());
+    assert(table==other.table);
     index = other.index;
   }
 
@@ -345,9 +496,8 @@ struct HashtableIter {
   }
 
   ValueReference operator*() const {
-    auto& entry = table[index];
-    assert(entry.active());
-    return entry.value();
+    assert(!(control[index]&hashtable_empty));
+    return table[index].value();
   }
 
   ValuePointer operator->() const {
@@ -356,7 +506,7 @@ struct HashtableIter {
 
   void operator++() {
     index++;
-    while (index<table.size() && !table[index].active())
+    while (index<size && control[index]&hashtable_empty)
       index++;
   }
 };
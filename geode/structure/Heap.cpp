@@ -1,4 +1,4 @@
-// A flexible binary heap template
+// Flexible d-ary heap templates
 
 #include <geode/structure/Heap.h>
 #include <geode/array/Array.h>
@@ -6,8 +6,8 @@
 namespace geode {
 
 namespace {
-struct HeapTest : public HeapBase<HeapTest> {
-  typedef HeapBase<HeapTest> Base;
+template<int arity> struct HeapTest : public HeapBase<HeapTest<arity>,arity> {
+  typedef HeapBase<HeapTest,arity> Base;
   Array<int> heap;
 
   HeapTest(Array<int> heap)
@@ -27,10 +27,24 @@ struct HeapTest : public HeapBase<HeapTest> {
     return x;
   }
 };
+
+// Entries are (key,priority) pairs
+struct IndexedHeapTest : public IndexedHeap<IndexedHeapTest,Vector<int,2>> {
+  Array<int> positions;
+
+  bool first(const Vector<int,2> a, const Vector<int,2> b) const { return a.y < b.y || (a.y == b.y && a.x < b.x); }
+  int key(const Vector<int,2> e) const { return e.x; }
+  int position(const int k) const { return positions.valid(k) ? positions[k] : -1; }
+  void set_position(const int k, const int i) {
+    while (positions.size() <= k)
+      positions.append(-1);
+    positions[k] = i;
+  }
+};
 }
 
-static Array<int> heapsort_test(RawArray<const int> input) {
-  HeapTest H(input.copy());
+template<int arity> static Array<int> heapsort(RawArray<const int> input) {
+  HeapTest<arity> H(input.copy());
   H.make();
   GEODE_ASSERT(H.is_heap());
   Array<int> order; 
@@ -41,9 +55,35 @@ static Array<int> heapsort_test(RawArray<const int> input) {
   return order;
 }
 
+static Array<int> heapsort_test(RawArray<const int> input) {
+  const auto order = heapsort<2>(input);
+  GEODE_ASSERT(heapsort<3>(input) == order);
+  GEODE_ASSERT(heapsort<4>(input) == order);
+  return order;
+}
+
+// Apply (key,priority) operations to an indexed heap, where a negative priority erases the key, then pop all keys
+static Array<int> indexed_heap_test(RawArray<const Vector<int,2>> ops) {
+  IndexedHeapTest H;
+  for (const auto& op : ops) {
+    if (op.y < 0)
+      H.erase(op.x);
+    else
+      H.set(op);
+    GEODE_ASSERT(H.is_heap());
+  }
+  Array<int> order;
+  while (H.size()) {
+    order.append(H.pop().x);
+    GEODE_ASSERT(H.is_heap() && !H.contains(order.back()));
+  }
+  return order;
+}
+
 }
 using namespace geode;
 
 void wrap_heap() {
   GEODE_FUNCTION(heapsort_test)
+  GEODE_FUNCTION(indexed_heap_test)
 }
@@ -1,55 +1,61 @@
-// A flexible binary heap template
+// Flexible d-ary heap templates
 //
 // Many times, when one wants a heap, one needs to track additional features
 // such as an inverse map.  The stl versions don't handle this case; we do.
 #pragma once
 
+#include <geode/array/Array.h>
 #include <geode/math/min.h>
 #include <geode/math/max.h>
 #include <geode/utility/range.h>
 namespace geode {
 
 // Usage: struct Heap : public HeapBase<Heap> { ... };
-// The heap has the structure of a binary heap, so
-//   parent(k) = (k-1)/2
-//   children(k) = (2k+1,2k+2)
+// The heap has the structure of a d-ary heap (binary by default), so
+//   parent(k) = (k-1)/d
+//   children(k) = (dk+1,...,dk+d)
 // first(i,j) is true if the ith entry should be above the jth entry (nonstrict comparison).
-template<class Derived> struct HeapBase {
+// Larger arity gives shallower heaps, so fewer swaps and better locality when moving nodes upward.
+template<class Derived,int arity=2> struct HeapBase {
+  static_assert(arity>=2,"heap arity must be at least 2");
+
   // Do we have a valid heap?
   bool is_heap() const {
     for (const int i : range(1,max(1,size_())))
-      if (!first_((i-1)/2,i))
+      if (!first_((i-1)/arity,i))
         return false;
     return true;
   }
 
   // Organize an invalid heap.  O(n) time.
   void make() {
-    for (int r=(size_()+1)/2-1;r>=0;r--)
+    for (int r=(size_()+arity-1)/arity-1;r>=0;r--)
       move_downward(r);
   }
 
-  // Move a node downward to restore heapness.  O(log n) time.
+  // Move a node downward to restore heapness.  O(d log_d n) time.
   int move_downward(int p) {
     const int n = size_();
     for (;;) {
-      const int c0 = 2*p+1;
+      const int c0 = arity*p+1;
       if (c0 >= n)
         break;
-      const int c1 = min(2*p+2,n-1);
-      if (first_(p,c0) && first_(p,c1))
+      int c = c0;
+      for (int i=c0+1;i<min(c0+arity,n);i++)
+        if (!first_(c,i))
+          c = i;
+      if (first_(p,c))
         break;
-      const int c = first_(c0,c1) ? c0 : c1;
       swap_(p,c);
       p = c;
     }
     return p;
   }
 
-  // Move a node upward to restore heapness.  O(log n) time.
+  // Move a node upward to restore heapness.  O(log_d n) time.
   int move_upward(int c) {
     while (c > 0) {
-      const int p = (c-1)/2;
+      const int p = (c-1)/arity;
       if (first_(p,c))
         break;
       swap_(p,c);
@@ -58,7 +64,7 @@ template<class Derived> struct HeapBase {
     return c;
   }
 
-  // Move a node in either direction to restore heapness.  O(log n) time.
+  // Move a node in either direction to restore heapness.  O(d log_d n) time.
   int move_up_or_down(const int k) {
     const int up = move_upward(k);
     return k == up ? move_downward(k) : up;
@@ -71,4 +77,79 @@ private:
   void swap_(const int i, const int j) { return static_cast<Derived&>(*this).swap(i,j); }
 };
 
+// A heap of entries which can be updated or erased by key, via an inverse map from keys to heap positions.
+// Usage: struct Heap : public IndexedHeap<Heap,Entry> { ... };
+// Derived must define
+//   bool first(const Entry& a, const Entry& b) const; // Should a be above b (nonstrict comparison)?
+//   Key key(const Entry& e) const;
+//   int position(Key k) const; // Heap position of k, or -1 if k is not in the heap
+//   void set_position(Key k, int i); // Record the position of k (-1 for none), growing the map if necessary
+// Since each key appears at most once, the heap never holds stale entries.
+template<class Derived,class Entry,int arity=4> struct IndexedHeap : public HeapBase<IndexedHeap<Derived,Entry,arity>,arity> {
+  typedef HeapBase<IndexedHeap,arity> Base;
+  Array<Entry> heap;
+
+  int size() const { return heap.size(); }
+  bool empty() const { return !heap.size(); }
+  bool first(const int i, const int j) const { return derived().first(heap[i],heap[j]); }
+
+  void swap(const int i, const int j) {
+    std::swap(heap[i],heap[j]);
+    derived().set_position(derived().key(heap[i]),i);
+    derived().set_position(derived().key(heap[j]),j);
+  }
+
+  template<class Key> bool contains(const Key k) const {
+    return derived().position(k) >= 0;
+  }
+
+  const Entry& top() const {
+    assert(size());
+    return heap[0];
+  }
+
+  // Remove and return the first entry.  O(d log_d n) time.
+  Entry pop() {
+    const auto e = heap[0];
+    derived().set_position(derived().key(e),-1);
+    const auto p = heap.pop();
+    if (size()) {
+      heap[0] = p;
+      derived().set_position(derived().key(p),0);
+      Base::move_downward(0);
+    }
+    return e;
+  }
+
+  // Insert an entry, or replace the existing entry with the same key.  This covers both decrease and increase key.
+  void set(const Entry& e) {
+    const auto k = derived().key(e);
+    int i = derived().position(k);
+    if (i < 0) {
+      i = heap.append(e);
+      derived().set_position(k,i);
+    } else
+      heap[i] = e;
+    Base::move_up_or_down(i);
+  }
+
+  // Remove the entry with the given key, if any
+  template<class Key> void erase(const Key k) {
+    const int i = derived().position(k);
+    if (i >= 0) {
+      derived().set_position(k,-1);
+      const auto p = heap.pop();
+      if (i < size()) {
+        heap[i] = p;
+        derived().set_position(derived().key(p),i);
+        Base::move_up_or_down(i);
+      }
+    }
+  }
+
+private:
+  const Derived& derived() const { return static_cast<const Derived&>(*this); }
+  Derived& derived() { return static_cast<Derived&>(*this); }
+};
+
 }
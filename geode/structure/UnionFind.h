@@ -13,6 +13,8 @@
 #include <geode/structure/Tuple.h>
 #include <geode/array/ConstantMap.h>
 #include <geode/array/Array.h>
+#include <atomic>
+#include <memory>
 namespace geode {
 
 template<class Parents> struct UnionFindBase {
@@ -172,4 +174,70 @@ struct RawUnionFind : public UnionFindBase<RawArray<int>> {
   }
 };
 
+// A fixed size union-find that is safe to merge and find from many threads at once (e.g., inside an OpenMP loop).
+// Roots are their own parents, and merge links the larger root below the smaller with a compare and swap, retrying
+// only if another thread changed one of the roots first.  Thus each set's root is its smallest element, whatever the
+// order of merges.  Parents only ever move towards the root, so find (path halving, with a single attempt at each
+// shortcut) is wait-free.  There are no ranks, so the depth bound is probabilistic rather than logarithmic; see
+//
+//   Jayanti, Tarjan (2016), "A randomized concurrent algorithm for disjoint set union".
+//
+// Memory ordering is relaxed: results of merges are guaranteed visible only after the threads synchronize.
+class ConcurrentUnionFind {
+  int n;
+  std::unique_ptr<std::atomic<int>[]> parents;
+public:
+  explicit ConcurrentUnionFind(const int entries)
+    : n(entries), parents(new std::atomic<int>[entries]) {
+    for (int i=0;i<n;i++)
+      parents[i].store(i,std::memory_order_relaxed);
+  }
+
+  int size() const {
+    return n;
+  }
+
+  bool is_root(const int i) const {
+    return parents[i].load(std::memory_order_relaxed)==i;
+  }
+
+  bool same(const int i, const int j) const {
+    return find(i)==find(j);
+  }
+
+  int find(int i) const {
+    for (;;) {
+      int p = parents[i].load(std::memory_order_relaxed);
+      if (p == i)
+        return i;
+      const int gp = parents[p].load(std::memory_order_relaxed);
+      if (gp != p) // Path halving: if another thread got here first, its update is at least as good
+        parents[i].compare_exchange_weak(p,gp,std::memory_order_relaxed);
+      i = gp;
+    }
+  }
+
+  // Returns true if i and j were in different sets
+  bool merge(int i, int j) {
+    for (;;) {
+      i = find(i);
+      j = find(j);
+      if (i == j)
+        return false;
+      if (i < j)
+        swap(i,j);
+      int root = i;
+      if (parents[i].compare_exchange_strong(root,j,std::memory_order_relaxed))
+        return true;
+    }
+  }
+
+  int roots() const {
+    int roots = 0;
+    for (int i=0;i<n;i++)
+      roots += is_root(i);
+    return roots;
+  }
+};
+
 }
@@ -24,5 +24,6 @@ template<class T> class Stack;
 
 template<class TK,class T> struct HashtableEntry;
 template<class TK,class T=Unit> class Hashtable;
+template<class TK,class T=Unit> class ConcurrentHashtable;
 
 }
@@ -1,6 +1,56 @@
+#include <geode/array/sort.h>
 #include <geode/python/wrap.h>
+#include <geode/structure/ConcurrentHashtable.h>
+#include <geode/structure/Hashtable.h>
+#include <geode/utility/parallel.h>
 using namespace geode;
 
+namespace {
+
+// Insert k for each k>=0 and erase ~k for each k<0, returning the sorted contents
+Array<int> hashtable_test(RawArray<const int> ops) {
+  Hashtable<int> set;
+  for (const int k : ops) {
+    if (k>=0)
+      set.set(k);
+    else {
+      set.erase(~k);
+      GEODE_ASSERT(!set.contains(~k));
+    }
+  }
+  Array<int> contents;
+  for (const int k : set) {
+    GEODE_ASSERT(set.contains(k));
+    contents.append(k);
+  }
+  GEODE_ASSERT(contents.size()==set.size());
+  sort(contents);
+  return contents;
+}
+
+// Count the occurrences of each key in parallel, and check against a serial count
+void concurrent_hashtable_test(RawArray<const int> keys) {
+  ConcurrentHashtable<int,int> counts(keys.size());
+  ConcurrentHashtable<int> set(keys.size());
+  parallel_for(keys.size(),[&](const int i) {
+    counts.add(keys[i],1);
+    set.set(keys[i]);
+  });
+  Hashtable<int,int> expected;
+  for (const int k : keys)
+    expected[k]++;
+  const auto frozen = counts.freeze();
+  GEODE_ASSERT(frozen.size()==expected.size() && set.size()==expected.size());
+  for (const auto& kc : expected) {
+    GEODE_ASSERT(frozen.get(kc.x)==kc.y && set.contains(kc.x));
+    GEODE_ASSERT(counts.get_default(kc.x)==kc.y);
+  }
+}
+
+}
+
 void wrap_structure() {
   GEODE_WRAP(heap)
+  GEODE_FUNCTION(hashtable_test)
+  GEODE_FUNCTION(concurrent_hashtable_test)
 }
@@ -12,5 +12,20 @@ def test_heap():
       y = heapsort_test(x)
       assert all(sort(x)==y)
 
+def test_hashtable():
+  random.seed(83132)
+  for n in 10,100,3000:
+    keys = random.randint(n//2,size=n)
+    ops = where(random.rand(n)<.4,~keys,keys).astype(int32)
+    s = set()
+    for k in ops:
+      if k>=0:
+        s.add(k)
+      else:
+        s.discard(~k)
+    assert all(hashtable_test(ops)==sorted(s))
+    concurrent_hashtable_test(keys.astype(int32))
+
 if __name__=='__main__':
   test_heap()
+  test_hashtable()
@@ -1,4 +1,7 @@
 #include <geode/svg/svg_to_bezier.h>
+#include <geode/geometry/arc_fitting.h>
+#include <geode/geometry/Box.h>
+#include <geode/utility/parallel.h>
 #include <geode/python/wrap.h>
 #include <geode/python/Class.h>
 #include <geode/python/to_python.h>
@@ -9,6 +12,7 @@
 namespace geode {
 
 GEODE_DEFINE_TYPE(SVGStyledPath)
+GEODE_DEFINE_TYPE(SVGPaths)
 
 static vector<Ref<SVGStyledPath>> svg_paths_to_beziers(const struct SVGPath* plist) {
   std::vector<Ref<SVGStyledPath>> paths;
@@ -55,6 +59,165 @@ static vector<Ref<SVGStyledPath>> svg_paths_to_beziers(const struct SVGPath* pli
   return paths;
 }
 
+typedef Vector<real,2> TV;
+
+// How svg_paths_to_beziers ends a subpath
+enum SubpathEnd { Open, Close, Fuse };
+
+static SubpathEnd subpath_end(const SVGPath* it) {
+  const int knots = (it->nbezpts+2)/3;
+  if (!(it->closed || it->hasFill) || knots<=2)
+    return Open;
+  Box<TV> box;
+  for (int i=0;i<it->nbezpts;i++)
+    box.enlarge(TV(it->bezpts[2*i],it->bezpts[2*i+1]));
+  const int n = it->nbezpts-1;
+  const TV first(it->bezpts[0],it->bezpts[1]),
+           prev(it->bezpts[2*(n-3)],it->bezpts[2*(n-3)+1]),
+           last(it->bezpts[2*n],it->bezpts[2*n+1]);
+  const real size = box.sizes().magnitude();
+  // Bezier::fuse_ends does nothing unless the ends nearly coincide, so neither do we
+  return (last-prev).magnitude()>1e-3*size ? Close : (last-first).magnitude()<1e-5*size ? Fuse : Open;
+}
+
+SVGPaths::SVGPaths(const SVGPath* plist) {
+  // Count everything first, so that all control points go in one allocation
+  vector<const SVGPath*> list;
+  vector<SubpathEnd> ends;
+  Array<int> lengths;
+  Array<int> path;
+  Array<unsigned int> fill, stroke, element;
+  Array<float> width;
+  Array<int> has_fill, rule;
+  Array<bool> has_stroke;
+  for (const SVGPath* it = plist; it; it = it->next) {
+    if (!element.size() || element.back()!=it->elementIndex) {
+      GEODE_ASSERT(!element.size() || it->elementIndex<element.back());
+      fill.append(it->fillColor);
+      stroke.append(it->strokeColor);
+      width.append(it->strokeWidth);
+      has_fill.append(it->hasFill);
+      rule.append(it->fillRule);
+      has_stroke.append(it->hasStroke);
+      CSSclass.push_back(it->CSSclass);
+      element.append(it->elementIndex);
+    }
+    list.push_back(it);
+    ends.push_back(subpath_end(it));
+    lengths.append(it->nbezpts+3*(ends.back()==Close));
+    path.append(element.size()-1);
+  }
+
+  // Fill in control points in parallel
+  const Nested<TV> points(lengths,uninit);
+  Array<bool> closed(list.size(),uninit);
+  parallel_for(int(list.size()),[&](const int s) {
+    const SVGPath* it = list[s];
+    const auto x = points[s];
+    for (int i=0;i<it->nbezpts;i++) {
+      x[i] = TV(it->bezpts[2*i],it->bezpts[2*i+1]);
+      if (i%3 && !isfinite(x[i])) { // Bezier::append_knot replaces bad tangents with their knot
+        const int k = i%3==1 ? i-1 : i+1;
+        x[i] = TV(it->bezpts[2*k],it->bezpts[2*k+1]);
+      }
+    }
+    const int n = it->nbezpts-1;
+    if (ends[s]==Close) {
+      x[n+1] = x[n];
+      x[n+2] = x[n+3] = x[0];
+    } else if (ends[s]==Fuse)
+      x[n] = x[0];
+    closed[s] = ends[s]!=Open;
+  },64);
+
+  this->subpaths = points;
+  this->closed = closed;
+  this->path = path;
+  fillColor = fill;
+  strokeColor = stroke;
+  strokeWidth = width;
+  hasFill = has_fill;
+  fillRule = rule;
+  hasStroke = has_stroke;
+  elementIndex = element;
+}
+
+// Bezier::evaluate skips segments whose ends coincide and whose tangents agree
+static inline bool degenerate(const TV p1, const TV p2, const TV p3, const TV p4) {
+  return !((p4-p1).magnitude() > 1e-8 || dot((p2-p1).normalized(),(p3-p4).normalized()) < 1-1e-7);
+}
+
+Nested<TV> SVGPaths::evaluate(int res) const {
+  res = max(res,1);
+  const int n = subpaths.size();
+  Array<int> lengths(n,uninit);
+  parallel_for(n,[&](const int s) {
+    const auto x = subpaths[s];
+    int count = 0;
+    for (int i=3;i<x.size();i+=3)
+      count += !degenerate(x[i-3],x[i-2],x[i-1],x[i]);
+    lengths[s] = x.size()>1 ? count*res+1 : 0;
+  },64);
+  const Nested<TV> samples(lengths,uninit);
+  const real inv_res = 1./res;
+  parallel_for(n,[&](const int s) {
+    const auto x = subpaths[s];
+    const auto y = samples[s];
+    if (!y.size())
+      return;
+    int k = 0;
+    for (int i=3;i<x.size();i+=3) {
+      const TV p0 = x[i-3], p1 = x[i-2], p2 = x[i-1], p3 = x[i];
+      if (degenerate(p0,p1,p2,p3))
+        continue;
+      // Power basis, as in Bezier::evaluate
+      const TV c1 = 3*(p1-p0),
+               c2 = 3*(p0+p2)-6*p1,
+               c3 = p3-p0+3*(p1-p2);
+      y[k++] = p0;
+      for (int j=1;j<res;j++) {
+        const real t = j*inv_res;
+        y[k++] = p0+t*(c1+t*(c2+t*c3));
+      }
+    }
+    y[k] = x.back();
+  },16);
+  return samples;
+}
+
+Nested<CircleArc> SVGPaths::fit_arcs(const int res, const real allowed_error) const {
+  const auto polys = evaluate(res);
+  const int n = polys.size();
+  vector<Array<CircleArc>> arcs(n);
+  Array<int> lengths(n,uninit);
+  parallel_for(n,[&](const int s) {
+    const auto poly = polys[s].slice(0,polys.size(s)-(closed[s] && polys.size(s))); // Drop any repeated first point
+    if (poly.size()>1)
+      arcs[s] = geode::fit_arcs(poly,allowed_error,closed[s]);
+    lengths[s] = arcs[s].size();
+  });
+  const Nested<CircleArc> result(lengths,uninit);
+  parallel_for(n,[&](const int s) {
+    result[s] = arcs[s];
+  },64);
+  return result;
+}
+
+Ref<SVGPaths> svgfile_to_paths(const string& filename) {
+  struct SVGPath* plist = svgParseFromFile(filename.c_str(), NULL);
+  const auto paths = new_<SVGPaths>(plist);
+  svgDelete(plist);
+  return paths;
+}
+
+Ref<SVGPaths> svgstring_to_paths(const string& svgstring) {
+  std::vector<char> str_buf(svgstring.c_str(), svgstring.c_str()+svgstring.size()+1);
+  struct SVGPath* plist = svgParse(&str_buf[0], NULL);
+  const auto paths = new_<SVGPaths>(plist);
+  svgDelete(plist);
+  return paths;
+}
+
 vector<Ref<SVGStyledPath>> svgfile_to_styled_beziers(const string& filename) {
   struct SVGPath* plist = svgParseFromFile(filename.c_str(), NULL);
   auto paths = svg_paths_to_beziers(plist);
@@ -103,6 +266,27 @@ void wrap_svg_to_bezier() {
     .GEODE_FIELD(shapes)
     ;
 
+  {
+    typedef SVGPaths Self;
+    Class<Self>("SVGPaths")
+      .GEODE_FIELD(subpaths)
+      .GEODE_FIELD(closed)
+      .GEODE_FIELD(path)
+      .GEODE_FIELD(fillColor)
+      .GEODE_FIELD(strokeColor)
+      .GEODE_FIELD(strokeWidth)
+      .GEODE_FIELD(hasFill)
+      .GEODE_FIELD(fillRule)
+      .GEODE_FIELD(hasStroke)
+      .GEODE_FIELD(CSSclass)
+      .GEODE_FIELD(elementIndex)
+      .GEODE_METHOD(evaluate)
+      .GEODE_METHOD(fit_arcs)
+      ;
+  }
+
+  GEODE_FUNCTION(svgfile_to_paths)
+  GEODE_FUNCTION(svgstring_to_paths)
   GEODE_FUNCTION(svgfile_to_styled_beziers)
   GEODE_FUNCTION(svgstring_to_styled_beziers)
   GEODE_FUNCTION(svgfile_to_beziers)
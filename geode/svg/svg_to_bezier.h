@@ -3,6 +3,8 @@
 #include <geode/svg/nanosvg/nanosvg.h>
 #include <geode/geometry/Bezier.h>
 #include <geode/array/Array.h>
+#include <geode/array/Nested.h>
+#include <geode/exact/circle_csg.h>
 #include <geode/python/Ref.h>
 #include <vector>
 namespace geode {
@@ -32,6 +34,43 @@ protected:
   {}
 };
 
+// All paths of a document in flat arrays, for importing large documents without a Bezier object per subpath.
+// Subpath s is the cubic spline with control points subpaths[s] = p0,out0,in1,p1,out1,...,pk, matching the
+// segments of the corresponding Bezier from svgstring_to_beziers.  Closed subpaths end with their first knot.
+// Styles are stored per path, as in SVGStyledPath.
+class SVGPaths: public Object {
+public:
+  GEODE_DECLARE_TYPE(GEODE_CORE_EXPORT)
+  typedef Vector<real,2> TV;
+
+  Nested<const TV> subpaths; // Control points of each subpath, in one allocation
+  Array<const bool> closed; // Whether each subpath is closed
+  Array<const int> path; // Path containing each subpath
+
+  // Per path styles
+  Array<const unsigned int> fillColor, strokeColor;
+  Array<const float> strokeWidth;
+  Array<const int> hasFill, fillRule;
+  Array<const bool> hasStroke;
+  vector<string> CSSclass;
+  Array<const unsigned int> elementIndex;
+
+protected:
+  GEODE_CORE_EXPORT SVGPaths(const struct SVGPath* plist);
+public:
+
+  int paths() const { return elementIndex.size(); }
+
+  // Sample each segment at res points, as Bezier::evaluate does, in parallel over subpaths
+  GEODE_CORE_EXPORT Nested<TV> evaluate(const int res) const;
+
+  // Fit arcs to evaluate(res) for each subpath within allowed_error, in parallel over subpaths
+  GEODE_CORE_EXPORT Nested<CircleArc> fit_arcs(const int res, const real allowed_error) const;
+};
+
+GEODE_CORE_EXPORT Ref<SVGPaths> svgfile_to_paths(const string& filename);
+GEODE_CORE_EXPORT Ref<SVGPaths> svgstring_to_paths(const string& svgstring);
+
 GEODE_CORE_EXPORT vector<Ref<SVGStyledPath>> svgfile_to_styled_beziers(const string& filename);
 GEODE_CORE_EXPORT vector<Ref<SVGStyledPath>> svgstring_to_styled_beziers(const string& svgstring);
 
@@ -206,7 +206,21 @@ def test_svg_arcs01():
 def test_svg_arcs02():
   svg_test('arcs02',*arcs02)
 
+def test_svg_paths():
+  for svg,_ in cubic02,arcs01,arcs02:
+    beziers = svgstring_to_beziers(svg)
+    paths = svgstring_to_paths(svg)
+    assert len(paths.subpaths)==len(beziers)
+    assert all(paths.closed==[b.closed() for b in beziers])
+    for res in 1,4,20:
+      X = paths.evaluate(res)
+      for x,b in zip(X,beziers):
+        assert allclose(x,b.evaluate(res))
+    arcs = paths.fit_arcs(8,.5)
+    assert len(arcs)==len(beziers)
+
 if __name__=='__main__':
+  test_svg_paths()
   test_svg_cubic02()
   test_svg_arcs01()
   test_svg_arcs02()
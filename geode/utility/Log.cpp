@@ -6,17 +6,28 @@
 #include <geode/utility/format.h>
 #include <geode/utility/LogEntry.h>
 #include <geode/utility/LogScope.h>
+#include <geode/utility/metrics.h>
+#include <geode/utility/profile.h>
 #include <geode/utility/str.h>
 #include <geode/utility/time.h>
-#include <sstream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <streambuf>
+#include <thread>
+#include <vector>
 namespace geode {
 namespace Log {
 
 using std::string;
-using std::stringbuf;
 using std::streambuf;
 using std::ostream;
+using std::unique_ptr;
+using std::vector;
 
 namespace {
 FILE* log_file=0;
@@ -35,6 +46,39 @@ LogEntry* current_entry = 0;
 
 bool suppress_timing;
 
+// Something to log, recorded by the calling thread and applied to the scope tree either immediately or by the
+// async writer
+struct Event {
+  enum Kind {Text,Error,Item,StopTime,PushScope,PopScope,Stat} kind;
+  uint64_t order; // Position in the global sequence, so that the writer can merge threads
+  double time;
+  string text; // Output text, or the name of an item or scope, or the label of a stat
+  string value; // The value of a stat
+};
+
+// The logging state of one thread.  Text written to Log::cout and Log::cerr collects here until a flush.  In async
+// mode, events go through a ring which only the owning thread pushes to and only the writer pops from, and threads
+// live until exit so that the writer never sees a ring vanish.
+struct ThreadLog {
+  static const int capacity = 1<<10;
+  string cout_text, cerr_text;
+  std::atomic<uint64_t> head, tail; // The writer pops at head, the owner pushes at tail
+  const unique_ptr<Event[]> events;
+
+  ThreadLog()
+    : head(0), tail(0), events(new Event[capacity]) {}
+};
+
+std::mutex threads_lock; // Protects threads
+vector<unique_ptr<ThreadLog>> threads;
+
+std::recursive_mutex lock; // Held while changing the scope tree or writing output.  See Lock.
+std::atomic<bool> async_enabled(false);
+std::atomic<uint64_t> next_order(0); // Order of the next async event
+std::atomic<uint64_t> applied(0); // Async events before this have been written
+std::atomic<bool> stopping(false);
+scoped_ptr<std::thread> writer;
+
 template<class T>
 struct InitializationHelper {
   scoped_ptr<T> object;
@@ -63,84 +107,252 @@ void initialize() {
   if(!private_instance) new LogClass();
 }
 
-class LogCoutBuffer : public stringbuf {
-  int sync() {
-    initialize();
-    if (!suppress_cout && current_entry->depth<verbosity_level) {
-      if (LogEntry::start_on_separate_line)
-        putchar('\n');
-      string buffer = str();
-      for (size_t start=0;start<buffer.length();) {
-        size_t end = buffer.find('\n',start);
-        if (LogEntry::needs_indent) {
-          printf("%*s",2*current_entry->depth+2,"");
-          LogEntry::needs_indent = false;
-        }
-        fputs(buffer.substr(start,end-start).c_str(),stdout);
-        if (end!=string::npos) {
-          putchar('\n');
-          LogEntry::needs_indent = true;
-          start=end+1;
-        } else
-          break;
+static GEODE_THREAD_LOCAL ThreadLog* local_thread = 0;
+static GEODE_THREAD_LOCAL int lock_depth = 0;
+
+namespace {
+// Hold lock.  Errors can be written while it's held (say, a fatal error opening a log file), so it's recursive, and
+// drain doesn't wait while this thread holds it.
+struct Lock : private Noncopyable {
+  Lock() {
+    lock.lock();
+    lock_depth++;
+  }
+
+  ~Lock() {
+    lock_depth--;
+    lock.unlock();
+  }
+};
+}
+
+static ThreadLog& thread_log() {
+  ThreadLog* t = local_thread;
+  if (!t) {
+    std::lock_guard<std::mutex> guard(threads_lock);
+    threads.emplace_back(new ThreadLog);
+    t = local_thread = threads.back().get();
+  }
+  return *t;
+}
+
+static void write_text(const string& buffer) {
+  if (!suppress_cout && current_entry->depth<verbosity_level) {
+    if (LogEntry::start_on_separate_line)
+      putchar('\n');
+    for (size_t start=0;start<buffer.length();) {
+      size_t end = buffer.find('\n',start);
+      if (LogEntry::needs_indent) {
+        printf("%*s",2*current_entry->depth+2,"");
+        LogEntry::needs_indent = false;
       }
-      LogEntry::start_on_separate_line = false;
-      current_entry->end_on_separate_line = true;
-      fflush(stdout);
+      fputs(buffer.substr(start,end-start).c_str(),stdout);
+      if (end!=string::npos) {
+        putchar('\n');
+        LogEntry::needs_indent = true;
+        start=end+1;
+      } else
+        break;
     }
-    if (log_file) {
-      if (LogEntry::log_file_start_on_separate_line)
+    LogEntry::start_on_separate_line = false;
+    current_entry->end_on_separate_line = true;
+    LogEntry::flush(stdout);
+  }
+  if (log_file) {
+    if (LogEntry::log_file_start_on_separate_line)
+      putc('\n',log_file);
+    for (size_t start=0;start<buffer.length();) {
+      size_t end = buffer.find('\n',start);
+      if (LogEntry::log_file_needs_indent) {
+        fprintf(log_file,"%*s",2*current_entry->depth+2,"");
+        LogEntry::log_file_needs_indent = false;
+      }
+      fputs(buffer.substr(start,end-start).c_str(),log_file);
+      if (end!=string::npos) {
         putc('\n',log_file);
-      string buffer=str();
-      for (size_t start=0;start<buffer.length();) {
-        size_t end = buffer.find('\n',start);
-        if (LogEntry::log_file_needs_indent) {
-          fprintf(log_file,"%*s",2*current_entry->depth+2,"");
-          LogEntry::log_file_needs_indent = false;
-        }
-        fputs(buffer.substr(start,end-start).c_str(),log_file);
-        if (end!=string::npos) {
-          putc('\n',log_file);
-          LogEntry::log_file_needs_indent = true;
-          start = end+1;
-        } else
-          break;
+        LogEntry::log_file_needs_indent = true;
+        start = end+1;
+      } else
+        break;
+    }
+    LogEntry::log_file_start_on_separate_line = false;
+    current_entry->log_file_end_on_separate_line = true;
+    LogEntry::flush(log_file);
+  }
+}
+
+static void write_error(const string& buffer) {
+  if (!suppress_cerr) {
+    if (LogEntry::start_on_separate_line)
+      putchar('\n');
+    LogEntry::start_on_separate_line = false;
+    fflush(stdout); // The writer may have batched output meant to come first
+    fputs(buffer.c_str(),stderr);
+  }
+  if (log_file) {
+    if (LogEntry::log_file_start_on_separate_line)
+      putc('\n',log_file);
+    LogEntry::log_file_start_on_separate_line = false;
+    for (size_t start=0;start<buffer.length();) {
+      size_t end = buffer.find('\n',start);
+      fputs(buffer.substr(start,end-start).c_str(),log_file);
+      putc('\n',log_file);
+      if (end!=string::npos)
+        start=end+1;
+      else
+        break;
+    }
+  }
+}
+
+static void write_stat(const string& label, const string& s) {
+  if (current_entry->depth<verbosity_level) {
+    if (LogEntry::start_on_separate_line) putchar('\n');
+    if (LogEntry::needs_indent) printf("%*s",2*current_entry->depth+2,"");
+    printf("%s = %s\n",label.c_str(),s.c_str());
+    LogEntry::start_on_separate_line = false;
+    LogEntry::needs_indent = current_entry->end_on_separate_line = true;
+  }
+  if (log_file) {
+    if (LogEntry::log_file_start_on_separate_line) putc('\n',log_file);
+    if (LogEntry::log_file_needs_indent) fprintf(log_file,"%*s",2*current_entry->depth+2,"");
+    fprintf(log_file,"%s = %s\n",label.c_str(),s.c_str());
+    LogEntry::log_file_start_on_separate_line = false;
+    LogEntry::log_file_needs_indent = current_entry->log_file_end_on_separate_line = true;
+  }
+}
+
+// Apply an event to the scope tree and write its output.  Must hold lock.
+static void apply(const Event& e) {
+  if (!current_entry && e.kind!=Event::Error)
+    return;
+  switch (e.kind) {
+    case Event::Text: write_text(e.text); break;
+    case Event::Error: write_error(e.text); break;
+    case Event::Item:
+      current_entry = current_entry->get_new_item(log_file,e.text);
+      current_entry->start(log_file);
+      break;
+    case Event::StopTime: current_entry = current_entry->get_stop_time(log_file); break;
+    case Event::PushScope:
+      current_entry = current_entry->get_new_scope(log_file,e.text);
+      current_entry->start(log_file);
+      break;
+    case Event::PopScope: current_entry = current_entry->get_pop_scope(log_file); break;
+    case Event::Stat: write_stat(e.text,e.value); break;
+  }
+}
+
+// Apply an event now, or queue it for the writer
+static void dispatch(const Event::Kind kind, string text, string value=string()) {
+  if (!async_enabled.load(std::memory_order_relaxed)) {
+    const Lock guard;
+    Event e = {kind,0,0,std::move(text),std::move(value)};
+    apply(e);
+    return;
+  }
+  auto& t = thread_log();
+  const uint64_t tail = t.tail.load(std::memory_order_relaxed);
+  while (tail-t.head.load(std::memory_order_acquire)>=uint64_t(ThreadLog::capacity))
+    std::this_thread::yield(); // Full, so wait for the writer to catch up
+  auto& e = t.events[tail&(ThreadLog::capacity-1)];
+  e.kind = kind;
+  e.time = get_time();
+  e.text = std::move(text);
+  e.value = std::move(value);
+  e.order = next_order.fetch_add(1);
+  t.tail.store(tail+1,std::memory_order_release);
+}
+
+// Drain every thread's ring and apply events in order.  An event can only be applied once all earlier ones have
+// been popped, so events that arrive ahead of a gap wait in pending.
+static void writer_loop() {
+  std::map<uint64_t,Event> pending;
+  uint64_t next = applied.load();
+  vector<ThreadLog*> snapshot;
+  for (int idle=0;;) {
+    {
+      std::lock_guard<std::mutex> guard(threads_lock);
+      snapshot.clear();
+      for (const auto& t : threads)
+        snapshot.push_back(t.get());
+    }
+    bool popped = false;
+    for (const auto t : snapshot) {
+      uint64_t head = t->head.load(std::memory_order_relaxed);
+      const uint64_t tail = t->tail.load(std::memory_order_acquire);
+      for (;head<tail;head++) {
+        auto& e = t->events[head&(ThreadLog::capacity-1)];
+        pending.insert(std::make_pair(e.order,std::move(e)));
+        popped = true;
       }
-      LogEntry::log_file_start_on_separate_line = false;
-      current_entry->log_file_end_on_separate_line = true;
-      fflush(log_file);
+      t->head.store(head,std::memory_order_release);
     }
-    str("");
-    return stringbuf::sync();
+    if (!pending.empty() && pending.begin()->first==next) {
+      const Lock guard;
+      LogEntry::replaying = true;
+      while (!pending.empty() && pending.begin()->first==next) {
+        const auto& e = pending.begin()->second;
+        LogEntry::replay_time = e.time;
+        apply(e);
+        pending.erase(pending.begin());
+        next++;
+      }
+      LogEntry::replaying = false;
+      fflush(stdout);
+      if (log_file)
+        fflush(log_file);
+      applied.store(next,std::memory_order_release);
+    }
+    if (popped)
+      idle = 0;
+    else if (stopping && next==next_order.load())
+      break;
+    else // Back off from 50 us up to 6.4 ms while there's nothing to write
+      std::this_thread::sleep_for(std::chrono::microseconds(50<<std::min(idle++,7)));
+  }
+}
+
+class LogCoutBuffer : public streambuf {
+  int_type overflow(int_type c) {
+    if (!traits_type::eq_int_type(c,traits_type::eof()))
+      thread_log().cout_text += traits_type::to_char_type(c);
+    return traits_type::not_eof(c);
+  }
+
+  std::streamsize xsputn(const char* s, std::streamsize n) {
+    thread_log().cout_text.append(s,size_t(n));
+    return n;
+  }
+
+  int sync() {
+    initialize();
+    string text;
+    text.swap(thread_log().cout_text);
+    dispatch(Event::Text,std::move(text));
+    return 0;
   }
 };
 
-class LogCerrBuffer:public stringbuf {
+class LogCerrBuffer : public streambuf {
+  int_type overflow(int_type c) {
+    if (!traits_type::eq_int_type(c,traits_type::eof()))
+      thread_log().cerr_text += traits_type::to_char_type(c);
+    return traits_type::not_eof(c);
+  }
+
+  std::streamsize xsputn(const char* s, std::streamsize n) {
+    thread_log().cerr_text.append(s,size_t(n));
+    return n;
+  }
+
   int sync() {
     initialize();
-    if (!suppress_cerr) {
-      if (LogEntry::start_on_separate_line)
-        putchar('\n');
-      LogEntry::start_on_separate_line = false;
-      fputs(str().c_str(),stderr);
-    }
-    if (log_file) {
-      if (LogEntry::log_file_start_on_separate_line)
-        putc('\n',log_file);
-      LogEntry::log_file_start_on_separate_line = false;
-      string buffer = str();
-      for (size_t start=0;start<buffer.length();) {
-        size_t end = buffer.find('\n',start);
-        fputs(buffer.substr(start,end-start).c_str(),log_file);
-        putc('\n',log_file);
-        if (end!=string::npos)
-          start=end+1;
-        else
-          break;
-      }
-    }
-    str("");
-    return stringbuf::sync();
+    string text;
+    text.swap(thread_log().cerr_text);
+    dispatch(Event::Error,std::move(text));
+    drain(); // Errors often precede a crash, so make sure they're visible
+    return 0;
   }
 };
 
@@ -155,7 +367,19 @@ LogClass::LogClass() {
   root->start(log_file);
 }
 
+static void stop_writer() {
+  if (!writer)
+    return;
+  async_enabled = false;
+  stopping = true;
+  writer->join();
+  writer.reset();
+  stopping = false;
+}
+
 LogClass::~LogClass() {
+  stop_writer();
+  const Lock guard;
   while (current_entry!=0)
     current_entry=current_entry->get_pop_scope(log_file);
   dump_log_helper();
@@ -172,6 +396,8 @@ LogClass::~LogClass() {
 }
 
 void cache_initial_output() {
+  drain();
+  const Lock guard;
   if (!log_file) {
     log_file = tmpfile();
     if (!log_file) GEODE_FATAL_ERROR("Couldn't create temporary log file");
@@ -194,16 +420,46 @@ bool initialized() {
 }
 
 void configure(const string& root_name_input, const bool suppress_cout_input, const bool suppress_timing_input, const int verbosity_level_input) {
-  root_name = root_name_input;
-  suppress_cout = suppress_cout_input;
-  suppress_cerr = false;
-  suppress_timing = suppress_timing_input;
-  verbosity_level = verbosity_level_input-1;
+  drain();
+  {
+    const Lock guard;
+    root_name = root_name_input;
+    suppress_cout = suppress_cout_input;
+    suppress_cerr = false;
+    suppress_timing = suppress_timing_input;
+    verbosity_level = verbosity_level_input-1;
+  }
   initialize();
 }
 
+void set_async(const bool async) {
+  initialize();
+  if (async==bool(writer))
+    return;
+  if (async) {
+    applied = next_order.load();
+    writer.reset(new std::thread(writer_loop));
+    async_enabled = true;
+  } else
+    stop_writer();
+}
+
+bool async() {
+  return async_enabled;
+}
+
+void drain() {
+  if (!async_enabled || lock_depth || std::this_thread::get_id()==writer->get_id())
+    return;
+  const uint64_t target = next_order.load();
+  while (applied.load(std::memory_order_acquire)<target)
+    std::this_thread::yield();
+}
+
 void copy_to_file(const string& filename,const bool append) {
   initialize();
+  drain();
+  const Lock guard;
   FILE* temporary_file = 0;
   if (log_file && log_file_temporary){
     temporary_file = log_file;
@@ -256,33 +512,19 @@ bool is_timing_suppressed() {
 
 void time_helper(const string& label) {
   // Always called after is_timing_suppressed, so no need to call initialized()
-  current_entry = current_entry->get_new_item(log_file,label);
-  current_entry->start(log_file);
+  dispatch(Event::Item,label);
 }
 
 void stop_time() {
   if(!is_timing_suppressed())
-    current_entry=current_entry->get_stop_time(log_file);
+    dispatch(Event::StopTime,string());
 }
 
 template<class TValue> void stat(const string& label, const TValue& value) {
+  metrics_gauge("geode_log_stat","Last value passed to Log::stat",{{"label",label}}).set(double(value));
   initialize();
   if (suppress_timing) return;
-  string s = str(value);
-  if (current_entry->depth<verbosity_level) {
-    if (LogEntry::start_on_separate_line) putchar('\n');
-    if (LogEntry::needs_indent) printf("%*s",2*current_entry->depth+2,"");
-    printf("%s = %s\n",label.c_str(),s.c_str());
-    LogEntry::start_on_separate_line = false;
-    LogEntry::needs_indent = current_entry->end_on_separate_line = true;
-  }
-  if (log_file) {
-    if (LogEntry::log_file_start_on_separate_line) putc('\n',log_file);
-    if (LogEntry::log_file_needs_indent) fprintf(log_file,"%*s",2*current_entry->depth+2,"");
-    fprintf(log_file,"%s = %s\n",label.c_str(),s.c_str());
-    LogEntry::log_file_start_on_separate_line = false;
-    LogEntry::log_file_needs_indent = current_entry->log_file_end_on_separate_line = true;
-  }
+  dispatch(Event::Stat,label,str(value));
 }
 
 template void stat(const string&,const int&);
@@ -291,22 +533,24 @@ template void stat(const string&,const float&);
 template void stat(const string&,const double&);
 
 void push_scope(const string& name) {
+  profile_begin(name);
   initialize();
   if (suppress_timing) return;
-  current_entry = current_entry->get_new_scope(log_file,name);
-  current_entry->start(log_file);
+  dispatch(Event::PushScope,name);
 }
 
 void pop_scope() {
-  if (!current_entry) return;
-  initialize();
+  profile_end();
+  if (!initialized()) return;
   if (suppress_timing) return;
-  current_entry = current_entry->get_pop_scope(log_file);
+  dispatch(Event::PopScope,string());
 }
 
 void reset() {
   initialize();
   if (suppress_timing) return;
+  drain();
+  const Lock guard;
   delete root;
   root = new LogScope(0,0,"simulation","simulation",verbosity_level);
   current_entry=root;
@@ -330,6 +574,8 @@ static void dump_log_helper() {
 
 void dump_log() {
   initialize();
+  drain();
+  const Lock guard;
   dump_log_helper();
 }
 
@@ -34,6 +34,17 @@ template<class TValue> GEODE_CORE_EXPORT void stat(const string& label, const TV
 GEODE_CORE_EXPORT void reset();
 GEODE_CORE_EXPORT void dump();
 
+// Write output from a background thread.  Logging calls then only append an event to a queue owned by the calling
+// thread, and the writer merges the queues in order, applies them to the scope tree, and writes in batches.  Output
+// from several threads interleaves only between whole flushes of Log::cout.  Errors written to Log::cerr still wait
+// until they are written.  Memory growth isn't reported for entries timed in async mode.  Toggle only while no other
+// thread is logging.
+GEODE_CORE_EXPORT void set_async(const bool async);
+GEODE_CORE_EXPORT bool async();
+
+// Wait until everything logged so far has been written
+GEODE_CORE_EXPORT void drain();
+
 namespace {
 struct Scope : private Noncopyable {
 public:
@@ -14,6 +14,8 @@ initialized = geode_wrap.log_initialized
 cache_initial_output = geode_wrap.log_cache_initial_output
 copy_to_file = geode_wrap.log_copy_to_file
 finish = geode_wrap.log_finish
+set_async = geode_wrap.log_set_async
+drain = geode_wrap.log_drain
 write = geode_wrap.log_print
 error = geode_wrap.log_error
 flush = geode_wrap.log_flush
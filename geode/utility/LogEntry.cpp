@@ -1,16 +1,22 @@
 #include <geode/utility/LogEntry.h>
+#include <geode/math/max.h>
+#include <geode/utility/format.h>
+#include <geode/utility/metrics.h>
 namespace geode {
 
 bool LogEntry::start_on_separate_line=false;
 bool LogEntry::log_file_start_on_separate_line=false;
 bool LogEntry::needs_indent=true;
 bool LogEntry::log_file_needs_indent=true;
+bool LogEntry::replaying=false;
+double LogEntry::replay_time=0;
 
 LogEntry::LogEntry(LogEntry* parent, const int depth, const string& name, int& verbosity_level)
-  : parent(parent), depth(depth), time(0), name(name), verbosity_level(verbosity_level) {
+  : parent(parent), depth(depth), time(0), name(name), memory_marked(false), memory_net(0), memory_peak(0),
+    memory_measured(false), verbosity_level(verbosity_level) {
   end_on_separate_line = false;
   log_file_end_on_separate_line = false;
-  timer_start_time = get_time();
+  timer_start_time = now();
 }
 
 LogEntry::~LogEntry() {}
@@ -20,19 +26,34 @@ void LogEntry::start(FILE* log_file) {
     if (start_on_separate_line) putchar('\n');
     start_on_separate_line = needs_indent = true;
     printf("%*s%-*s",2*depth,"",50-2*depth,name.c_str());
-    fflush(stdout);
+    flush(stdout);
   }
   if (log_file) {
     if (log_file_start_on_separate_line) putc('\n',log_file);
     log_file_start_on_separate_line = log_file_needs_indent = true;
     fprintf(log_file,"%*s%-*s",2*depth,"",50-2*depth,name.c_str());
-    fflush(log_file);
+    flush(log_file);
   }
-  timer_start_time = get_time();
+  timer_start_time = now();
+  memory_marked = memory_accounting() && !replaying;
+  if (memory_marked)
+    memory_mark = begin_memory_mark();
 }
 
 void LogEntry::stop(FILE* log_file) {
-  double time_since_start = get_time()-timer_start_time;
+  double time_since_start = now()-timer_start_time;
+  static const auto bounds = new vector<double>(exponential_bounds(1e-4,1e3,10)); // Leaked, since Log outlives statics
+  metrics_histogram("geode_log_scope_seconds","Durations of Log scopes and timed items",*bounds,
+                    {{"scope",identifier()}}).observe(time_since_start);
+  string memory;
+  if (memory_marked) {
+    const auto usage = end_memory_mark(memory_mark);
+    memory = memory_suffix(true,usage.live,usage.peak);
+    memory_marked = false;
+    memory_net += usage.live;
+    memory_peak = max(memory_peak,usage.peak);
+    memory_measured = true;
+  }
   if (depth<=verbosity_level) {
     if (end_on_separate_line) {
       if(start_on_separate_line) putchar('\n');
@@ -40,8 +61,8 @@ void LogEntry::stop(FILE* log_file) {
     }
     end_on_separate_line = start_on_separate_line = false;
     needs_indent = true;
-    printf("%8.4f s\n",time_since_start);
-    fflush(stdout);
+    printf("%8.4f s%s\n",time_since_start,memory.c_str());
+    flush(stdout);
   }
   if (log_file) {
     if (log_file_end_on_separate_line) {
@@ -50,8 +71,8 @@ void LogEntry::stop(FILE* log_file) {
     }
     log_file_end_on_separate_line = log_file_start_on_separate_line = false;
     log_file_needs_indent = true;
-    fprintf(log_file,"%8.4f s\n",time_since_start);
-    fflush(log_file);
+    fprintf(log_file,"%8.4f s%s\n",time_since_start,memory.c_str());
+    flush(log_file);
   }
   time += time_since_start;
 }
@@ -77,10 +98,19 @@ LogEntry* LogEntry::get_pop_scope(FILE* log_file) {
 }
 
 void LogEntry::dump_log(FILE* output) {
-  fprintf(output,"%*s%-*s%8.4f s\n",2*depth,"",50-2*depth,name.c_str(),time);
+  fprintf(output,"%*s%-*s%8.4f s%s\n",2*depth,"",50-2*depth,name.c_str(),time,
+          memory_suffix(memory_measured,memory_net,memory_peak).c_str());
   fflush(output);
 }
 
+string LogEntry::identifier() const {
+  return name;
+}
+
+string LogEntry::memory_suffix(const bool measured, const int64_t net, const int64_t peak) {
+  return measured ? format(", %s net, %s peak",memory_string(net),memory_string(peak)) : string();
+}
+
 void LogEntry::dump_names(FILE* output) {
   fprintf(output,"%*s%-*s",2*depth,"",50-2*depth,name.c_str());
   fflush(output);
@@ -6,6 +6,7 @@
 #include <geode/utility/Log.h>
 #include <geode/utility/time.h>
 #include <geode/utility/config.h>
+#include <geode/utility/memory_accounting.h>
 #include <string>
 #include <cstdio>
 namespace geode {
@@ -19,11 +20,20 @@ public:
   double time;
   double timer_start_time;
   string name;
+  MemoryMark memory_mark;
+  bool memory_marked; // Whether memory_mark was taken at start, since accounting was on
+  int64_t memory_net, memory_peak; // Total net growth and the largest peak growth over all runs, if ever measured
+  bool memory_measured;
   bool end_on_separate_line,log_file_end_on_separate_line;
   static bool start_on_separate_line,log_file_start_on_separate_line;
   static bool needs_indent,log_file_needs_indent;
   int& verbosity_level;
 
+  // Set while the async writer replays events recorded earlier by other threads.  Times then come from the events,
+  // memory isn't measured (marks belong to the thread doing the work), and the writer flushes once per batch.
+  static bool replaying;
+  static double replay_time;
+
   LogEntry(LogEntry* parent, const int depth, const string& name, int& verbosity_level);
   virtual ~LogEntry();
 
@@ -35,6 +45,23 @@ public:
   virtual LogEntry* get_pop_scope(FILE* log_file);
   virtual void dump_log(FILE* output);
   virtual void dump_names(FILE* output);
+
+  // Name without varying parts, for metrics
+  virtual string identifier() const;
+
+  // Memory growth to print after a time, or an empty string if none was measured
+  static string memory_suffix(const bool measured, const int64_t net, const int64_t peak);
+
+  // The time of the current event
+  static double now() {
+    return replaying ? replay_time : get_time();
+  }
+
+  // Flush output now unless the writer will flush the whole batch later
+  static void flush(FILE* output) {
+    if (!replaying)
+      fflush(output);
+  }
 };
 
 }
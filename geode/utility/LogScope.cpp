@@ -12,6 +12,10 @@ LogScope::~LogScope() {
     delete child;
 }
 
+string LogScope::identifier() const {
+  return scope_identifier;
+}
+
 LogEntry* LogScope::get_stop_time(FILE* log_file) {
   return this;
 }
@@ -62,7 +66,8 @@ LogEntry* LogScope::get_pop_scope(FILE* log_file) {
 }
 
 void LogScope::dump_log(FILE* output) {
-  fprintf(output,"%*s%-*s%8.4f s\n",2*depth,"",50-2*depth,scope_identifier.c_str(),time);
+  fprintf(output,"%*s%-*s%8.4f s%s\n",2*depth,"",50-2*depth,scope_identifier.c_str(),time,
+          memory_suffix(memory_measured,memory_net,memory_peak).c_str());
   fflush(output);
   for (auto child : children)
     child->dump_log(output);
@@ -23,6 +23,7 @@ public:
 
   LogEntry* get_stop_time(FILE* log_file);
   string name_to_identifier(const string& name);
+  string identifier() const;
   LogEntry* get_new_scope(FILE* log_file,const string& new_name);
   LogEntry* get_new_item(FILE* log_file,const string& new_name);
   LogEntry* get_pop_scope(FILE* log_file);
@@ -3,32 +3,104 @@
 //#####################################################################
 #include <geode/utility/ProgressIndicator.h>
 #include <geode/utility/Log.h>
+#include <geode/utility/parallel.h>
+#include <geode/utility/time.h>
+#include <geode/python/wrap.h>
+#include <limits>
+#include <vector>
 namespace geode {
 
-ProgressIndicator::ProgressIndicator(const int total, const bool brief)
-  : total(total), brief(brief), done(0), percent_done(0), print(true) {}
+const int ProgressIndicator::shards;
 
-void ProgressIndicator::initialize(const int total_input) {
+// Threads are spread over shards round robin, in order of first progress
+static std::atomic<int> next_thread(0);
+static GEODE_THREAD_LOCAL int thread_shard = -1;
+
+ProgressIndicator::ProgressIndicator(const int64_t total, const bool brief)
+  : brief(brief), print(true) {
+  initialize(total);
+}
+
+void ProgressIndicator::initialize(const int64_t total_input) {
+  GEODE_ASSERT(total_input>0);
   total = total_input;
-  done = percent_done = 0;
-}
-
-bool ProgressIndicator::progress(const int by) {
-  done += by;
-  int new_percent_done = 100*done/total;
-  if (new_percent_done>percent_done){
-    percent_done = new_percent_done;
-    if (print) {
-      if (brief)
-        Log::cout<<'.'<<std::flush;
-      else
-        Log::cout<<percent_done<<"% "<<std::flush;
-      if (percent_done==100)
-        Log::cout<<std::endl;
-    }
-    return true;
+  for (auto& s : shard)
+    s.count = 0;
+  stride = max(int64_t(1),total/(100*shards));
+  start = get_time();
+  percent = 0;
+}
+
+bool ProgressIndicator::progress(const int64_t by) {
+  if (thread_shard<0)
+    thread_shard = next_thread++%shards;
+  const int64_t n = shard[thread_shard].count.fetch_add(by,std::memory_order_relaxed);
+  if (n/stride==(n+by)/stride)
+    return false;
+  std::unique_lock<std::mutex> guard(lock,std::try_to_lock);
+  return guard && report_locked();
+}
+
+bool ProgressIndicator::flush() {
+  std::lock_guard<std::mutex> guard(lock);
+  return report_locked();
+}
+
+int64_t ProgressIndicator::done() const {
+  int64_t n = 0;
+  for (const auto& s : shard)
+    n += s.count.load(std::memory_order_relaxed);
+  return n;
+}
+
+ProgressIndicator::Report ProgressIndicator::report() const {
+  Report r;
+  r.done = done();
+  r.total = total;
+  r.percent = int(min(int64_t(100),100*r.done/total));
+  r.elapsed = get_time()-start;
+  r.rate = r.elapsed>0 ? r.done/r.elapsed : 0;
+  r.eta = r.done>=total ? 0 : r.rate>0 ? (total-r.done)/r.rate : std::numeric_limits<double>::infinity();
+  return r;
+}
+
+bool ProgressIndicator::report_locked() {
+  const Report r = report();
+  if (r.percent<=percent)
+    return false;
+  percent = r.percent;
+  if (print) {
+    if (brief)
+      Log::cout<<'.'<<std::flush;
+    else
+      Log::cout<<r.percent<<"% "<<std::flush;
+    if (r.percent==100)
+      Log::cout<<std::endl;
   }
-  return false;
+  if (sink)
+    sink(r);
+  return true;
+}
+
+// Count from many threads at once, checking that reports increase and end at 100%
+static void progress_indicator_test(const int total, const int by) {
+  ProgressIndicator progress(total);
+  progress.print = false;
+  std::vector<ProgressIndicator::Report> reports;
+  progress.sink = [&](const ProgressIndicator::Report& r) { reports.push_back(r); };
+  parallel_for(total/by,[&](const int i) { progress.progress(by); },1);
+  progress.flush();
+  GEODE_ASSERT(progress.done()==total/by*by);
+  GEODE_ASSERT(reports.size() && reports.back().percent==100*(total/by*by)/total);
+  for (int i=1;i<int(reports.size());i++)
+    GEODE_ASSERT(reports[i-1].percent<reports[i].percent && reports[i-1].done<=reports[i].done);
+  for (const auto& r : reports)
+    GEODE_ASSERT(r.total==total && r.rate>=0 && r.eta>=0);
+}
+
 }
+using namespace geode;
 
+void wrap_progress_indicator() {
+  GEODE_FUNCTION(progress_indicator_test)
 }
@@ -1,22 +1,70 @@
 //#####################################################################
 // Class ProgressIndicator
 //#####################################################################
+//
+// Reports the progress of a computation as percentages, optionally via a
+// callback.  progress() may be called from any number of threads at once:
+// counts accumulate in per thread shards without locks, and every so often
+// the thread that pushes its shard over a stride sums the shards and
+// reports if the percentage has increased.  Reports never overlap, and a
+// thread which finds another one reporting skips its turn.  Call flush()
+// after a parallel loop to report the final count.
+//
+//#####################################################################
 #pragma once
 
 #include <geode/utility/config.h>
+#include <geode/utility/function.h>
+#include <atomic>
+#include <mutex>
 namespace geode {
 
 class ProgressIndicator {
 public:
-  int total;
+  struct Report {
+    int64_t done, total;
+    int percent;
+    double elapsed; // Seconds since initialize
+    double rate; // Units per second
+    double eta; // Estimated seconds remaining, or infinity if unknown
+  };
+
+  int64_t total;
   bool brief;
-  int done;
-  int percent_done;
-  bool print;
+  bool print; // Print percentages to Log::cout
+  function<void(const Report&)> sink; // Called with each report, never concurrently
+
+  GEODE_CORE_EXPORT ProgressIndicator(const int64_t total=1, const bool brief=false);
+  GEODE_CORE_EXPORT void initialize(const int64_t total_input);
+
+  // Add by to the count.  Returns true if this call reported.  Thread safe.
+  GEODE_CORE_EXPORT bool progress(const int64_t by=1);
+
+  // Report now if the percentage has increased, waiting for any other report to finish
+  GEODE_CORE_EXPORT bool flush();
+
+  // The current count and estimates, summed over all shards
+  GEODE_CORE_EXPORT int64_t done() const;
+  GEODE_CORE_EXPORT Report report() const;
+
+  int percent_done() const {
+    return percent;
+  }
+
+private:
+  static const int shards = 16;
+  struct Shard {
+    std::atomic<int64_t> count;
+    char padding[64-sizeof(std::atomic<int64_t>)]; // Keep shards on separate cache lines
+  };
+
+  Shard shard[shards];
+  int64_t stride; // A shard reports each time its count passes a multiple of stride
+  double start; // Time of initialize
+  std::atomic<int> percent; // The last reported percentage
+  std::mutex lock; // Held while reporting
 
-  GEODE_CORE_EXPORT ProgressIndicator(const int total=1, const bool brief=false);
-  GEODE_CORE_EXPORT void initialize(const int total_input);
-  GEODE_CORE_EXPORT bool progress(const int by=1);
+  bool report_locked();
 };
 
 }
@@ -115,6 +115,16 @@ typedef double real;
 
 #define GEODE_ALIGNED(n) alignas(n)
 
+// Promise that the following loop has no dependences between iterations, so it can be vectorized without alias checks
+#ifdef __clang__
+  #define GEODE_IVDEP _Pragma("clang loop vectorize(assume_safety)")
+#else
+  #define GEODE_IVDEP _Pragma("GCC ivdep")
+#endif
+
+// Hint that memory at p will be read soon
+#define GEODE_PREFETCH(p) __builtin_prefetch(p)
+
 #else // not __GNUC__
 #define GEODE_GNUC_ONLY(...)
 
@@ -147,6 +157,8 @@ typedef double real;
 #define GEODE_FORMAT(type,fmt,list)
 #define GEODE_EXPECT(value,expect) (value)
 #define GEODE_ALIGNED(n) alignas(n)
+#define GEODE_IVDEP
+#define GEODE_PREFETCH(p) ((void)(p))
 
 #endif
 
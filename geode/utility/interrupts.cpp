@@ -2,42 +2,92 @@
 // File interrupts
 //#####################################################################
 #include <geode/utility/interrupts.h>
+#include <geode/utility/parallel.h>
 #include <geode/python/exceptions.h>
-#include <geode/python/config.h>
-#include <vector>
+#include <geode/python/wrap.h>
+#include <csignal>
 namespace geode {
 
-static std::vector<void(*)()> interrupt_checkers;
+// Bits of interrupt_detail::flags
+static const int posted_bit = 1, // Sticky until clear_interrupts
+                 signal_bit = 2; // Consumed by the checks that see it
 
-void check_interrupts() {
-  for (const auto checker : interrupt_checkers)
-    checker();
-}
+std::atomic<int> interrupt_detail::flags(0);
+GEODE_THREAD_LOCAL const std::atomic<bool>* interrupt_detail::local = 0;
 
-bool interrupted() {
-  try {
-    check_interrupts();
-    return false;
-  } catch (...) {
-    return true;
+void interrupt_detail::check_slow() {
+  const int f = flags.load();
+  if (f&signal_bit) {
+    flags.fetch_and(~signal_bit);
+    throw InterruptError("interrupted by signal");
   }
+  if (f&posted_bit)
+    throw InterruptError("interrupted");
+  if (local && *local)
+    throw InterruptError("cancelled");
+}
+
+void post_interrupt() {
+  interrupt_detail::flags.fetch_or(posted_bit);
 }
 
-void add_interrupt_checker(void (*checker)()) {
-  interrupt_checkers.push_back(checker);
+void clear_interrupts() {
+  interrupt_detail::flags.fetch_and(~posted_bit);
+}
+
+static void (*previous_handler)(int) = 0;
+
+static void interrupt_handler(const int sig) {
+  interrupt_detail::flags.fetch_or(signal_bit);
+  if (previous_handler && previous_handler!=SIG_DFL && previous_handler!=SIG_IGN && previous_handler!=SIG_ERR)
+    previous_handler(sig);
 }
 
-#ifdef GEODE_PYTHON
-void check_python_interrupts() {
-  bool error = false;
-  #pragma omp critical
+void install_interrupt_handler() {
+  const auto previous = std::signal(SIGINT,interrupt_handler);
+  if (previous!=interrupt_handler)
+    previous_handler = previous;
+}
+
+// Interrupts stop parallel loops, and per thread flags reach their workers
+static void interrupt_test(const int n) {
+  const auto count = [=]() {
+    std::atomic<int> visited(0);
+    parallel_for(n,[&](const int i) {
+      check_interrupts();
+      visited++;
+    });
+    return int(visited);
+  };
+  GEODE_ASSERT(!interrupted() && count()==n);
+  post_interrupt();
+  GEODE_ASSERT(interrupted());
+  try {
+    count();
+    GEODE_ASSERT(false);
+  } catch (const InterruptError&) {}
+  clear_interrupts();
+  GEODE_ASSERT(!interrupted() && count()==n);
+
+  std::atomic<bool> cancelled(false);
   {
-    if (PyErr_Occurred() || PyErr_CheckSignals())
-      error = true;
+    const InterruptScope scope(&cancelled);
+    GEODE_ASSERT(count()==n);
+    cancelled = true;
+    try {
+      count();
+      GEODE_ASSERT(false);
+    } catch (const InterruptError&) {}
   }
-  if (error)
-    throw_python_error();
+  GEODE_ASSERT(!interrupted() && count()==n);
+}
+
 }
-#endif
+using namespace geode;
 
+void wrap_interrupts() {
+  GEODE_FUNCTION(post_interrupt)
+  GEODE_FUNCTION(clear_interrupts)
+  GEODE_FUNCTION(interrupted)
+  GEODE_FUNCTION(interrupt_test)
 }
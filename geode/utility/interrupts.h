@@ -1,29 +1,73 @@
 //#####################################################################
 // File interrupts
 //#####################################################################
+//
+// Long computations call check_interrupts regularly, so that they can be
+// aborted from outside.  Checking costs a relaxed load of a global flag and
+// a thread local one, so it's fine to call from inner loops.
+//
+// An interrupt is requested by post_interrupt, which is safe to call from
+// any thread and from signal handlers.  Every check_interrupts on every
+// thread then throws InterruptError until clear_interrupts is called, so
+// all workers of a job stop together.  In python, SIGINT is chained to
+// post a one shot interrupt: it is consumed by the checks that observe it,
+// and python then raises KeyboardInterrupt as usual.
+//
+// A thread can also watch a flag of its own via InterruptScope, for
+// cancelling one job among many.  parallel_for passes the flag of the
+// calling thread on to its workers.
+//
+//#####################################################################
 #pragma once
 
 #include <geode/utility/config.h>
+#include <atomic>
 namespace geode {
 
-// Check if an interrupt has been posted, and throw an exception if so.
-// This function is OpenMP thread safe, but any exceptions thrown must
-// be caught if inside a parallel block (e.g., use interrupted() instead).
-GEODE_CORE_EXPORT void check_interrupts();
-
-// Check if an interrupt has been posted without throwing an exception.
-// Internally, interrupt exceptions will be caught and squelched.
-// This function is OpenMP thread safe.
-GEODE_CORE_EXPORT bool interrupted();
-
-// Add a function to call from check_interrupts.  It must be safe to call
-// this function several times for the same interrupt, and checker
-// must be thread safe.
-GEODE_CORE_EXPORT void add_interrupt_checker(void (*checker)());
-
-#ifdef GEODE_PYTHON
-// Interrupt checker for Python exceptions.  Use only from geode/module.cpp.
-void check_python_interrupts();
-#endif
+namespace interrupt_detail {
+GEODE_CORE_EXPORT extern std::atomic<int> flags; // Nonzero if an interrupt is posted
+GEODE_CORE_EXPORT extern GEODE_THREAD_LOCAL const std::atomic<bool>* local; // The flag of this thread, if any
+GEODE_CORE_EXPORT void check_slow();
+}
+
+// Is an interrupt pending for this thread?
+static inline bool interrupted() {
+  using namespace interrupt_detail;
+  return flags.load(std::memory_order_relaxed) || (local && local->load(std::memory_order_relaxed));
+}
+
+// Throw InterruptError if an interrupt is pending for this thread.  Any exceptions thrown must be caught if inside a
+// parallel block (parallel_for does this).
+static inline void check_interrupts() {
+  if (interrupted())
+    interrupt_detail::check_slow();
+}
+
+// Ask every thread to stop at its next check_interrupts.  Async signal safe.
+GEODE_CORE_EXPORT void post_interrupt();
+
+// Forget posted interrupts
+GEODE_CORE_EXPORT void clear_interrupts();
+
+// Post a one shot interrupt on SIGINT, then call the previous handler.  Used by python, so that ctrl-c stops long
+// computations even though python only notices signals between bytecodes.
+GEODE_CORE_EXPORT void install_interrupt_handler();
+
+// While this object lives, check_interrupts on this thread also throws if flag is set
+struct InterruptScope {
+  const std::atomic<bool>* const saved;
+
+  explicit InterruptScope(const std::atomic<bool>* flag)
+    : saved(interrupt_detail::local) {
+    interrupt_detail::local = flag;
+  }
+
+  ~InterruptScope() {
+    interrupt_detail::local = saved;
+  }
+
+  InterruptScope(const InterruptScope&) = delete;
+  void operator=(const InterruptScope&) = delete;
+};
 
 }
@@ -0,0 +1,131 @@
+//#####################################################################
+// Memory accounting
+//#####################################################################
+#include <geode/utility/memory_accounting.h>
+#include <geode/utility/format.h>
+#include <geode/utility/metrics.h>
+#include <geode/array/Array.h>
+#include <geode/structure/Tuple.h>
+#include <geode/python/wrap.h>
+#include <cmath>
+namespace geode {
+
+std::atomic<bool> memory_detail::enabled(false);
+
+static std::atomic<int64_t> live(0), peak(0);
+static std::atomic<int64_t> mark_peak(0); // Peak since the innermost open mark began
+static GEODE_THREAD_LOCAL int64_t thread_live = 0, thread_peak = 0;
+
+// Raise peak to at least value
+static inline void raise(std::atomic<int64_t>& peak, const int64_t value) {
+  int64_t old = peak.load(std::memory_order_relaxed);
+  while (old<value && !peak.compare_exchange_weak(old,value,std::memory_order_relaxed));
+}
+
+void memory_detail::add(const int64_t bytes) {
+  const int64_t n = live.fetch_add(bytes,std::memory_order_relaxed)+bytes;
+  thread_live += bytes;
+  if (bytes>0) {
+    raise(mark_peak,n);
+    raise(peak,n);
+    thread_peak = max(thread_peak,thread_live);
+  }
+}
+
+void set_memory_accounting(const bool enable) {
+  memory_detail::enabled = enable;
+}
+
+MemoryUsage tracked_memory() {
+  const MemoryUsage usage = {live.load(),peak.load()};
+  return usage;
+}
+
+MemoryUsage thread_tracked_memory() {
+  const MemoryUsage usage = {thread_live,thread_peak};
+  return usage;
+}
+
+void reset_memory_peaks() {
+  peak = live.load();
+  thread_peak = thread_live;
+}
+
+MemoryMark begin_memory_mark() {
+  MemoryMark mark;
+  mark.start = live.load();
+  mark.outer_peak = mark_peak.exchange(mark.start);
+  return mark;
+}
+
+MemoryUsage end_memory_mark(const MemoryMark& mark) {
+  const int64_t p = mark_peak.load();
+  raise(mark_peak,mark.outer_peak);
+  MemoryUsage usage = {live.load()-mark.start,max(int64_t(0),p-mark.start)};
+  return usage;
+}
+
+// Export the global counts as gauges
+static void collect_memory(vector<MetricFamily>& families) {
+  const auto usage = tracked_memory();
+  const MetricFamily live = {"geode_tracked_memory_bytes","Bytes held by counted buffers",MetricType::gauge,
+                             {{"geode_tracked_memory_bytes",MetricLabels(),double(usage.live)}}},
+                     peak = {"geode_tracked_memory_peak_bytes","Most bytes ever held by counted buffers",MetricType::gauge,
+                             {{"geode_tracked_memory_peak_bytes",MetricLabels(),double(usage.peak)}}};
+  families.push_back(live);
+  families.push_back(peak);
+}
+static const bool memory_collector_added = (add_metrics_collector(collect_memory),true);
+
+string memory_string(const int64_t bytes) {
+  const char* units[] = {"B","KB","MB","GB","TB"};
+  double b = double(bytes);
+  int u = 0;
+  while (u<4 && std::abs(b)>=1024) {
+    b /= 1024;
+    u++;
+  }
+  return u ? format("%.1f %s",b,units[u]) : format("%d B",int(bytes));
+}
+
+// Check that buffers are counted when allocated and released
+static void memory_accounting_test() {
+  const bool was = memory_accounting();
+  set_memory_accounting(false);
+  Array<char> uncounted(1000);
+  set_memory_accounting(true);
+  const auto before = tracked_memory();
+  const auto mark = begin_memory_mark();
+  {
+    Array<char> a(1<<20);
+    Array<char> b(100);
+    GEODE_ASSERT(tracked_memory().live>=before.live+(1<<20)+100);
+  }
+  uncounted.clean_memory(); // Releasing an uncounted buffer doesn't change the count
+  const auto usage = end_memory_mark(mark);
+  GEODE_ASSERT(tracked_memory().live==before.live);
+  GEODE_ASSERT(usage.live==0 && usage.peak>=(1<<20)+100);
+  GEODE_ASSERT(tracked_memory().peak>=before.live+usage.peak);
+  set_memory_accounting(was);
+}
+
+#ifdef GEODE_PYTHON
+
+static Tuple<int64_t,int64_t> tracked_memory_py() {
+  const auto usage = tracked_memory();
+  return tuple(usage.live,usage.peak);
+}
+
+#endif
+}
+using namespace geode;
+
+void wrap_memory_accounting() {
+  GEODE_FUNCTION(set_memory_accounting)
+  GEODE_FUNCTION(memory_accounting)
+  GEODE_FUNCTION(reset_memory_peaks)
+  GEODE_FUNCTION(memory_accounting_test)
+#ifdef GEODE_PYTHON
+  GEODE_FUNCTION_2(tracked_memory,tracked_memory_py)
+#endif
+}
@@ -0,0 +1,62 @@
+//#####################################################################
+// Memory accounting
+//#####################################################################
+//
+// Counts the bytes held by Buffers (and hence by Arrays), including the
+// chunks of arenas, so that memory can be attributed to pipeline stages.
+// process::memory_usage only knows the size of the whole process.
+//
+// Accounting is off by default and costs one relaxed load per allocation
+// while off.  While on, each allocation and release updates a global count
+// and a count for the calling thread, and raises the matching peaks.
+// Buffers remember whether they were counted, so toggling is always safe.
+// Log scopes record the net and peak growth of the global count while
+// they are open, and print them next to their times.  The profiler exports
+// the global count as a counter track.
+//
+//#####################################################################
+#pragma once
+
+#include <geode/utility/config.h>
+#include <atomic>
+#include <string>
+namespace geode {
+
+using std::string;
+
+namespace memory_detail {
+GEODE_CORE_EXPORT extern std::atomic<bool> enabled;
+GEODE_CORE_EXPORT void add(const int64_t bytes); // Negative for releases
+}
+
+// Turn accounting on or off
+GEODE_CORE_EXPORT void set_memory_accounting(const bool enable);
+
+static inline bool memory_accounting() {
+  return memory_detail::enabled.load(std::memory_order_relaxed);
+}
+
+struct MemoryUsage {
+  int64_t live; // Bytes currently held, or net growth for a MemoryMark
+  int64_t peak; // The most ever held, or peak growth above the start of a MemoryMark
+};
+
+// Counted bytes over all threads.  Buffers released by another thread than allocated them count against the
+// releasing thread, so per thread live counts may be negative.
+GEODE_CORE_EXPORT MemoryUsage tracked_memory();
+GEODE_CORE_EXPORT MemoryUsage thread_tracked_memory();
+
+// Forget old peaks, so that peaks measure from now.  Doesn't affect open marks.
+GEODE_CORE_EXPORT void reset_memory_peaks();
+
+// Measure the growth of the global count between begin_memory_mark and end_memory_mark.  Marks must nest.
+struct MemoryMark {
+  int64_t start, outer_peak;
+};
+GEODE_CORE_EXPORT MemoryMark begin_memory_mark();
+GEODE_CORE_EXPORT MemoryUsage end_memory_mark(const MemoryMark& mark);
+
+// Byte counts in human readable form, such as "1.5 MB"
+GEODE_CORE_EXPORT string memory_string(const int64_t bytes);
+
+}
@@ -0,0 +1,310 @@
+//#####################################################################
+// Metrics registry
+//#####################################################################
+#include <geode/utility/metrics.h>
+#include <geode/utility/format.h>
+#include <geode/python/exceptions.h>
+#include <geode/python/stl.h>
+#include <geode/python/wrap.h>
+#include <geode/structure/Tuple.h>
+#include <geode/vector/Vector.h>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <thread>
+namespace geode {
+
+using std::unique_ptr;
+
+GEODE_THREAD_LOCAL int metrics_detail::thread_shard = -1;
+
+int metrics_detail::assign_shard() {
+  static std::atomic<int> next(0);
+  return thread_shard = next++%shards;
+}
+
+Counter::Counter() {
+  for (auto& s : shard)
+    s.count = 0;
+}
+
+uint64_t Counter::value() const {
+  uint64_t n = 0;
+  for (const auto& s : shard)
+    n += s.count.load(std::memory_order_relaxed);
+  return n;
+}
+
+Histogram::Histogram(const vector<double>& bounds)
+  : bounds(bounds), counts(new std::atomic<uint64_t>[bounds.size()+1]), sum_(0) {
+  GEODE_ASSERT(std::is_sorted(bounds.begin(),bounds.end()));
+  for (int i=0;i<=int(bounds.size());i++)
+    counts[i] = 0;
+}
+
+void Histogram::observe(const double x) {
+  const int b = int(std::lower_bound(bounds.begin(),bounds.end(),x)-bounds.begin());
+  counts[b].fetch_add(1,std::memory_order_relaxed);
+  double old = sum_.load(std::memory_order_relaxed);
+  while (!sum_.compare_exchange_weak(old,old+x,std::memory_order_relaxed));
+}
+
+vector<uint64_t> Histogram::cumulative_counts() const {
+  vector<uint64_t> c(bounds.size()+1);
+  uint64_t n = 0;
+  for (int i=0;i<int(c.size());i++)
+    c[i] = n += counts[i].load(std::memory_order_relaxed);
+  return c;
+}
+
+vector<double> exponential_bounds(const double lo, const double hi, const double factor) {
+  GEODE_ASSERT(lo>0 && factor>1);
+  vector<double> bounds;
+  for (double b=lo;b<=hi*(1+1e-10);b*=factor)
+    bounds.push_back(b);
+  return bounds;
+}
+
+namespace {
+struct Family {
+  string help;
+  MetricType type;
+  vector<double> bounds; // For histograms
+  std::map<MetricLabels,unique_ptr<Counter>> counters;
+  std::map<MetricLabels,unique_ptr<Gauge>> gauges;
+  std::map<MetricLabels,unique_ptr<Histogram>> histograms;
+};
+
+struct Registry {
+  std::mutex lock;
+  std::map<string,Family> families;
+  vector<MetricsCollector> collectors;
+};
+}
+
+// Never destroyed, since metrics are referenced from static storage all over
+static Registry& registry() {
+  static Registry* registry = new Registry;
+  return *registry;
+}
+
+static bool valid_name(const string& name) {
+  if (name.empty() || isdigit(name[0]))
+    return false;
+  for (const char c : name)
+    if (!(isalnum(c) || c=='_' || c==':'))
+      return false;
+  return true;
+}
+
+// Check names, and sort labels so that their order doesn't matter
+static MetricLabels canonical(const string& name, MetricLabels labels) {
+  if (!valid_name(name))
+    throw ValueError(format("invalid metric name '%s'",name));
+  for (const auto& l : labels)
+    if (!valid_name(l.first) || l.first.find(':')!=string::npos)
+      throw ValueError(format("metric %s: invalid label name '%s'",name,l.first));
+  std::sort(labels.begin(),labels.end());
+  return labels;
+}
+
+static Family& family(Registry& r, const string& name, const string& help, const MetricType type) {
+  const auto it = r.families.find(name);
+  if (it==r.families.end()) {
+    Family& f = r.families[name];
+    f.help = help;
+    f.type = type;
+    return f;
+  }
+  if (it->second.type!=type)
+    throw ValueError(format("metric %s is already registered with a different type",name));
+  return it->second;
+}
+
+Counter& metrics_counter(const string& name, const string& help, const MetricLabels& labels) {
+  const auto key = canonical(name,labels);
+  auto& r = registry();
+  std::lock_guard<std::mutex> guard(r.lock);
+  auto& c = family(r,name,help,MetricType::counter).counters[key];
+  if (!c)
+    c.reset(new Counter);
+  return *c;
+}
+
+Gauge& metrics_gauge(const string& name, const string& help, const MetricLabels& labels) {
+  const auto key = canonical(name,labels);
+  auto& r = registry();
+  std::lock_guard<std::mutex> guard(r.lock);
+  auto& g = family(r,name,help,MetricType::gauge).gauges[key];
+  if (!g)
+    g.reset(new Gauge);
+  return *g;
+}
+
+Histogram& metrics_histogram(const string& name, const string& help, const vector<double>& bounds,
+                             const MetricLabels& labels) {
+  const auto key = canonical(name,labels);
+  auto& r = registry();
+  std::lock_guard<std::mutex> guard(r.lock);
+  auto& f = family(r,name,help,MetricType::histogram);
+  if (f.histograms.empty())
+    f.bounds = bounds;
+  else if (f.bounds!=bounds)
+    throw ValueError(format("metric %s is already registered with different bounds",name));
+  auto& h = f.histograms[key];
+  if (!h)
+    h.reset(new Histogram(bounds));
+  return *h;
+}
+
+void add_metrics_collector(const MetricsCollector& collector) {
+  auto& r = registry();
+  std::lock_guard<std::mutex> guard(r.lock);
+  r.collectors.push_back(collector);
+}
+
+vector<MetricFamily> collect_metrics() {
+  auto& r = registry();
+  vector<MetricFamily> all;
+  vector<MetricsCollector> collectors;
+  {
+    std::lock_guard<std::mutex> guard(r.lock);
+    for (const auto& it : r.families) {
+      const Family& f = it.second;
+      MetricFamily m = {it.first,f.help,f.type,vector<MetricSample>()};
+      for (const auto& c : f.counters) {
+        const MetricSample s = {it.first,c.first,double(c.second->value())};
+        m.samples.push_back(s);
+      }
+      for (const auto& g : f.gauges) {
+        const MetricSample s = {it.first,g.first,g.second->value()};
+        m.samples.push_back(s);
+      }
+      for (const auto& h : f.histograms) {
+        const auto counts = h.second->cumulative_counts();
+        for (int b=0;b<int(counts.size());b++) {
+          MetricSample s = {it.first+"_bucket",h.first,double(counts[b])};
+          s.labels.push_back(std::make_pair(string("le"),
+            b<int(f.bounds.size()) ? format("%.15g",f.bounds[b]) : string("+Inf")));
+          m.samples.push_back(s);
+        }
+        const MetricSample sum = {it.first+"_sum",h.first,h.second->sum()},
+                           count = {it.first+"_count",h.first,double(counts.back())};
+        m.samples.push_back(sum);
+        m.samples.push_back(count);
+      }
+      all.push_back(m);
+    }
+    collectors = r.collectors;
+  }
+  // Run collectors without the lock, so that they may look up metrics themselves
+  for (const auto& collect : collectors)
+    collect(all);
+  std::stable_sort(all.begin(),all.end(),[](const MetricFamily& a, const MetricFamily& b) { return a.name<b.name; });
+  return all;
+}
+
+static string sample_value(const double x) {
+  if (std::isnan(x))
+    return "NaN";
+  if (std::isinf(x))
+    return x>0 ? "+Inf" : "-Inf";
+  if (x==std::floor(x) && std::abs(x)<9007199254740992.)
+    return format("%lld",(long long)x);
+  return format("%.17g",x);
+}
+
+static string escape(const string& s, const bool quotes) {
+  string r;
+  for (const char c : s) {
+    if (c=='\\')
+      r += "\\\\";
+    else if (c=='\n')
+      r += "\\n";
+    else if (c=='"' && quotes)
+      r += "\\\"";
+    else
+      r += c;
+  }
+  return r;
+}
+
+string metrics_text() {
+  static const char* types[] = {"counter","gauge","histogram"};
+  string text;
+  for (const auto& f : collect_metrics()) {
+    text += format("# HELP %s %s\n# TYPE %s %s\n",f.name,escape(f.help,false),f.name,types[int(f.type)]);
+    for (const auto& s : f.samples) {
+      text += s.name;
+      if (s.labels.size()) {
+        text += '{';
+        for (int i=0;i<int(s.labels.size());i++)
+          text += format("%s%s=\"%s\"",i?",":"",s.labels[i].first,escape(s.labels[i].second,true));
+        text += '}';
+      }
+      text += ' '+sample_value(s.value)+'\n';
+    }
+  }
+  return text;
+}
+
+#ifdef GEODE_PYTHON
+
+// Python version: a list of (name,labels,value) samples
+static vector<Tuple<string,std::map<string,string>,double>> metrics_samples() {
+  vector<Tuple<string,std::map<string,string>,double>> samples;
+  for (const auto& f : collect_metrics())
+    for (const auto& s : f.samples)
+      samples.push_back(tuple(s.name,std::map<string,string>(s.labels.begin(),s.labels.end()),s.value));
+  return samples;
+}
+
+// Register a few metrics and check their samples
+static void metrics_test() {
+  auto& c = metrics_counter("geode_test_counter_total","Test counter",{{"b","2"},{"a","1"}});
+  GEODE_ASSERT(&c==&metrics_counter("geode_test_counter_total","",{{"a","1"},{"b","2"}}));
+  const auto before = c.value();
+  std::vector<std::thread> workers;
+  for (int t=0;t<4;t++)
+    workers.push_back(std::thread([&]() {
+      for (int i=0;i<1000;i++)
+        c.add();
+    }));
+  for (auto& w : workers)
+    w.join();
+  GEODE_ASSERT(c.value()==before+4000);
+
+  auto& g = metrics_gauge("geode_test_gauge","Test gauge");
+  g.set(2);
+  g.add(.5);
+  GEODE_ASSERT(g.value()==2.5);
+
+  auto& h = metrics_histogram("geode_test_histogram","Test histogram",exponential_bounds(1,100,10));
+  GEODE_ASSERT(h.bounds.size()==3);
+  const auto old = h.cumulative_counts();
+  for (const double x : {.5,1.,5.,50.,500.})
+    h.observe(x);
+  const auto counts = h.cumulative_counts();
+  GEODE_ASSERT(counts[0]==old[0]+2 && counts[1]==old[1]+3 && counts[2]==old[2]+4 && counts[3]==old[3]+5);
+
+  bool threw = false;
+  try {
+    metrics_gauge("geode_test_counter_total","");
+  } catch (const ValueError&) {
+    threw = true;
+  }
+  GEODE_ASSERT(threw);
+}
+
+#endif
+}
+using namespace geode;
+
+void wrap_metrics() {
+  GEODE_FUNCTION(metrics_text)
+#ifdef GEODE_PYTHON
+  GEODE_FUNCTION(metrics_samples)
+  GEODE_FUNCTION(metrics_test)
+#endif
+}
@@ -0,0 +1,137 @@
+//#####################################################################
+// Metrics registry
+//#####################################################################
+//
+// Counters, gauges and histograms for monitoring long running services.
+// Subsystems register metrics by name and labels, once, and keep the
+// returned reference, which stays valid forever:
+//
+//   static Counter& queries = metrics_counter("geode_queries_total","Queries answered",{{"kind","ray"}});
+//   queries.add();
+//
+// Counters are sharded across cache lines by thread, so parallel loops can
+// count without contention.  Subsystems that already keep statistics of
+// their own (exact predicate stats, memory accounting) register collectors
+// instead, which are called at collection time.  collect_metrics and
+// metrics_text pull everything at once, the latter in the Prometheus text
+// exposition format, so services only need to serve the string.
+//
+//#####################################################################
+#pragma once
+
+#include <geode/utility/config.h>
+#include <geode/utility/function.h>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+namespace geode {
+
+using std::string;
+using std::vector;
+
+typedef vector<std::pair<string,string>> MetricLabels;
+
+namespace metrics_detail {
+const int shards = 16;
+GEODE_CORE_EXPORT extern GEODE_THREAD_LOCAL int thread_shard; // -1 until assigned
+GEODE_CORE_EXPORT int assign_shard();
+
+static inline int shard() {
+  const int s = thread_shard;
+  return s>=0 ? s : assign_shard();
+}
+}
+
+// A monotonically increasing count
+class Counter {
+  struct Shard {
+    std::atomic<uint64_t> count;
+    char padding[64-sizeof(std::atomic<uint64_t>)];
+  };
+  Shard shard[metrics_detail::shards];
+public:
+  GEODE_CORE_EXPORT Counter();
+
+  void add(const uint64_t n=1) {
+    shard[metrics_detail::shard()].count.fetch_add(n,std::memory_order_relaxed);
+  }
+
+  GEODE_CORE_EXPORT uint64_t value() const;
+};
+
+// A value which may go up and down
+class Gauge {
+  std::atomic<double> value_;
+public:
+  Gauge()
+    : value_(0) {}
+
+  void set(const double x) {
+    value_.store(x,std::memory_order_relaxed);
+  }
+
+  void add(const double x) {
+    double old = value_.load(std::memory_order_relaxed);
+    while (!value_.compare_exchange_weak(old,old+x,std::memory_order_relaxed));
+  }
+
+  double value() const {
+    return value_.load(std::memory_order_relaxed);
+  }
+};
+
+// Counts of observations in buckets with the given upper bounds, plus an implicit +inf bucket
+class Histogram {
+public:
+  const vector<double> bounds; // Sorted
+private:
+  const std::unique_ptr<std::atomic<uint64_t>[]> counts; // Per bucket, not cumulative
+  std::atomic<double> sum_;
+public:
+  GEODE_CORE_EXPORT explicit Histogram(const vector<double>& bounds);
+  GEODE_CORE_EXPORT void observe(const double x);
+
+  // Cumulative counts, one per bound and one for +inf
+  GEODE_CORE_EXPORT vector<uint64_t> cumulative_counts() const;
+  double sum() const { return sum_.load(std::memory_order_relaxed); }
+};
+
+// Look up or register a metric.  Names and label names must match [a-zA-Z_:][a-zA-Z0-9_:]*, and each name must be
+// used with a single type (and for histograms, a single set of bounds).  Thread safe.
+GEODE_CORE_EXPORT Counter& metrics_counter(const string& name, const string& help,
+                                           const MetricLabels& labels=MetricLabels());
+GEODE_CORE_EXPORT Gauge& metrics_gauge(const string& name, const string& help,
+                                       const MetricLabels& labels=MetricLabels());
+GEODE_CORE_EXPORT Histogram& metrics_histogram(const string& name, const string& help, const vector<double>& bounds,
+                                               const MetricLabels& labels=MetricLabels());
+
+// Exponential histogram bounds lo, lo*factor, ..., up to at most hi
+GEODE_CORE_EXPORT vector<double> exponential_bounds(const double lo, const double hi, const double factor);
+
+enum class MetricType { counter, gauge, histogram };
+
+struct MetricSample {
+  string name; // Histograms have name_bucket, name_sum and name_count samples
+  MetricLabels labels;
+  double value;
+};
+
+struct MetricFamily {
+  string name, help;
+  MetricType type;
+  vector<MetricSample> samples;
+};
+
+// Add families to a collection.  Collectors run on the collecting thread, and must be thread safe.
+typedef function<void(vector<MetricFamily>&)> MetricsCollector;
+GEODE_CORE_EXPORT void add_metrics_collector(const MetricsCollector& collector);
+
+// All registered metrics and the output of all collectors, sorted by name
+GEODE_CORE_EXPORT vector<MetricFamily> collect_metrics();
+
+// collect_metrics in Prometheus text exposition format
+GEODE_CORE_EXPORT string metrics_text();
+
+}
@@ -5,6 +5,7 @@
 #include <geode/utility/openmp.h>
 #include <geode/python/wrap.h>
 #include <geode/random/Random.h>
+#include <thread>
 #include <vector>
 namespace geode {
 
@@ -26,6 +27,18 @@ static void log_flush() {
   Log::cout<<std::flush;
 }
 
+// Log lines from several threads at once
+static void log_async_test(const int threads, const int lines) {
+  vector<std::thread> workers;
+  for (const int t : range(threads))
+    workers.push_back(std::thread([=]() {
+      for (const int i : range(lines))
+        Log::cout<<format("thread %d line %d",t,i)<<std::endl;
+    }));
+  for (auto& w : workers)
+    w.join();
+}
+
 static void partition_loop_test(const int loop_steps, const int threads) {
   for (int i : range(loop_steps))
     GEODE_ASSERT(partition_loop(loop_steps,threads,partition_loop_inverse(loop_steps,threads,i)).contains(i));
@@ -88,12 +101,15 @@ void wrap_utility() {
   function("log_cache_initial_output",Log::cache_initial_output);
   function("log_copy_to_file",Log::copy_to_file);
   function("log_finish",Log::finish);
+  function("log_set_async",Log::set_async);
+  function("log_drain",Log::drain);
 
   function("log_push_scope",Log::push_scope);
   function("log_pop_scope",Log::pop_scope);
   GEODE_FUNCTION(log_print)
   GEODE_FUNCTION(log_flush)
   GEODE_FUNCTION(log_error)
+  GEODE_FUNCTION(log_async_test)
 
   GEODE_FUNCTION(partition_loop_test)
   GEODE_FUNCTION(large_partition_loop_test)
@@ -103,5 +119,11 @@ void wrap_utility() {
   GEODE_WRAP(base64)
   GEODE_WRAP(resource)
   GEODE_WRAP(format)
+  GEODE_WRAP(interrupts)
+  GEODE_WRAP(memory_accounting)
+  GEODE_WRAP(metrics)
   GEODE_WRAP(process)
+  GEODE_WRAP(profile)
+  GEODE_WRAP(progress_indicator)
+  GEODE_WRAP(parallel)
 }
@@ -14,6 +14,7 @@ namespace geode {
 static inline int omp_get_max_threads() { return 1; }
 static inline int omp_get_num_threads() { return 1; }
 static inline int omp_get_thread_num() { return 0; }
+static inline int omp_in_parallel() { return 0; }
 #endif
 
 // Partition a loop into chunks based on the total number of threads.  Returns a half open interval.
@@ -0,0 +1,82 @@
+//#####################################################################
+// Parallel loops, reductions, and task groups
+//#####################################################################
+#include <geode/utility/parallel.h>
+#include <geode/python/exceptions.h>
+#include <geode/python/wrap.h>
+namespace geode {
+
+int thread_count() {
+  return omp_get_max_threads();
+}
+
+void set_thread_count(const int threads) {
+  GEODE_ASSERT(threads>0);
+#ifdef _OPENMP
+  omp_set_num_threads(threads);
+#endif
+}
+
+void TaskGroup::wait() {
+  // Swap the tasks out first, so that the group can be reused even if a task throws
+  std::vector<function<void()>> pending;
+  pending.swap(tasks);
+  parallel_for(int(pending.size()),[&](const int i) { pending[i](); });
+}
+
+static void parallel_test(const int n, const int grain) {
+  // Every index is visited exactly once
+  Array<int> visits(n);
+  parallel_for(n,[&](const int i) { visits[i]++; },grain);
+  for (const int v : visits)
+    GEODE_ASSERT(v==1);
+
+  // Reductions don't depend on the thread count
+  const auto f = [](const int i) { return 1/(1+double(i)); };
+  const int threads = thread_count();
+  set_thread_count(1);
+  const double serial = parallel_reduce<double>(n,f,grain);
+  set_thread_count(threads);
+  GEODE_ASSERT(parallel_reduce<double>(n,f,grain)==serial);
+  const int largest = parallel_reduce<int>(n,[=](const int i) { return (7*i)%(n+3); },
+                                           [](int& a, const int b) { a = max(a,b); },grain);
+  int expected = 0;
+  for (int i=0;i<n;i++)
+    expected = max(expected,(7*i)%(n+3));
+  GEODE_ASSERT(largest==expected);
+
+  // Task groups run each task once, and nested loops work
+  Array<int> nested(n);
+  TaskGroup group;
+  for (int t=0;t<3;t++)
+    group.run([&,t]() {
+      parallel_for(n,[&](const int i) {
+        if (i%3==t)
+          nested[i]++;
+      });
+    });
+  group.wait();
+  for (const int v : nested)
+    GEODE_ASSERT(v==1);
+
+  // Exceptions propagate to the caller
+  bool caught = false;
+  try {
+    parallel_for(n,[](const int i) {
+      if (i==0)
+        throw ValueError("parallel_test");
+    },grain);
+  } catch (const ValueError&) {
+    caught = true;
+  }
+  GEODE_ASSERT(caught==(n>0));
+}
+
+}
+using namespace geode;
+
+void wrap_parallel() {
+  GEODE_FUNCTION(thread_count)
+  GEODE_FUNCTION(set_thread_count)
+  GEODE_FUNCTION(parallel_test)
+}
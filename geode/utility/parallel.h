@@ -0,0 +1,104 @@
+//#####################################################################
+// Parallel loops, reductions, and task groups
+//#####################################################################
+//
+// These are thin layers over OpenMP shared by the whole library, so that
+// thread counts, chunking, nesting, and interrupts are handled in one place:
+//
+// 1. Loops are split into chunks which are scheduled dynamically, so idle
+//    threads take work from busy ones.
+// 2. A parallel call made from inside another parallel region runs serially
+//    on the calling thread, so nested parallelism never oversubscribes cores.
+// 3. check_interrupts is called before each chunk, and workers observe the
+//    InterruptScope of the calling thread.  After an interrupt or
+//    any other exception, remaining chunks are skipped and the first
+//    exception is rethrown on the calling thread.
+//
+//#####################################################################
+#pragma once
+
+#include <geode/array/Array.h>
+#include <geode/utility/function.h>
+#include <geode/utility/interrupts.h>
+#include <geode/utility/openmp.h>
+#include <atomic>
+#include <exception>
+#include <vector>
+namespace geode {
+
+// Number of threads used by parallel regions
+GEODE_CORE_EXPORT int thread_count();
+
+// Set the number of threads used by parallel regions
+GEODE_CORE_EXPORT void set_thread_count(const int threads);
+
+// Call f(i) for i in [0,n) in parallel, in chunks of grain consecutive indices
+template<class F> void parallel_for(const int n, const F& f, const int grain=1) {
+  GEODE_ASSERT(grain>0);
+  const int chunks = n>0 ? (n-1)/grain+1 : 0;
+  std::atomic<bool> stop(false);
+  std::exception_ptr error;
+  const auto flag = interrupt_detail::local; // Workers watch the interrupt flag of the caller
+  #pragma omp parallel for schedule(dynamic,1) if(chunks>1 && !omp_in_parallel())
+  for (int c=0;c<chunks;c++) {
+    if (stop)
+      continue;
+    const InterruptScope scope(flag);
+    try {
+      check_interrupts();
+      for (int i=grain*c;i<min(n,grain*(c+1));i++)
+        f(i);
+    } catch (...) {
+      #pragma omp critical(geode_parallel_for)
+      {
+        if (!error)
+          error = std::current_exception();
+      }
+      stop = true;
+    }
+  }
+  if (error)
+    std::rethrow_exception(error);
+}
+
+// Combine f(i) for i in [0,n) with op(S& a, const S& b), which should replace a by the combination of a and b and must
+// be associative.  Blocks of block consecutive indices are combined in parallel, and the block results are combined by a
+// pairwise tree whose shape depends only on n and block.  The result is therefore bitwise identical for any number of
+// threads.  Returns S() if n is zero.
+template<class S,class F,class Op> S parallel_reduce(const int n, const F& f, const Op& op, const int block) {
+  GEODE_ASSERT(block>0);
+  const int blocks = n>0 ? (n-1)/block+1 : 0;
+  if (!blocks)
+    return S();
+  Array<S> partial(blocks);
+  parallel_for(blocks,[&](const int b) {
+    S result = f(block*b);
+    for (int i=block*b+1;i<min(n,block*(b+1));i++)
+      op(result,f(i));
+    partial[b] = result;
+  });
+  for (int w=1;w<blocks;w*=2)
+    for (int b=0;b+w<blocks;b+=2*w)
+      op(partial[b],partial[b+w]);
+  return partial[0];
+}
+
+// Sum f(i) for i in [0,n) deterministically, as above.  Rounding error grows only logarithmically in the number of
+// blocks.
+template<class S,class F> S parallel_reduce(const int n, const F& f, const int block=256) {
+  return parallel_reduce<S>(n,f,[](S& a, const S& b) { a += b; },block);
+}
+
+// A set of independent tasks, run in parallel by wait()
+class TaskGroup {
+  std::vector<function<void()>> tasks;
+public:
+  void run(const function<void()>& task) {
+    tasks.push_back(task);
+  }
+
+  // Run all pending tasks, returning once all are done.  Tasks may themselves call parallel functions.
+  GEODE_CORE_EXPORT void wait();
+};
+
+}
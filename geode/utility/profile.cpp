@@ -0,0 +1,305 @@
+//#####################################################################
+// Scoped profiling
+//#####################################################################
+#include <geode/utility/profile.h>
+#include <geode/utility/format.h>
+#include <geode/utility/memory_accounting.h>
+#include <geode/utility/tr1.h>
+#include <geode/python/exceptions.h>
+#include <geode/python/stl.h>
+#include <geode/python/wrap.h>
+#include <geode/structure/Tuple.h>
+#include <geode/vector/Vector.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+namespace geode {
+
+using std::unique_ptr;
+
+namespace profile_detail {
+std::atomic<bool> enabled(false);
+}
+
+namespace {
+
+struct Event {
+  int64_t time; // Nanoseconds
+  const char* name; // Zero for end events
+  int64_t memory; // Bytes counted by memory accounting, or -1 if accounting was off
+};
+
+// Events per thread.  At 24 bytes each, every thread that records costs 1.5 MB.
+const int capacity = 1<<16;
+
+// The events of one thread.  Only the owning thread writes, and buffers live until exit so that events of finished
+// threads can still be reported.
+struct EventBuffer {
+  const int thread;
+  std::atomic<uint64_t> count; // Events ever written
+  std::atomic<uint64_t> cleared; // Events before this were discarded by clear_profile
+  const unique_ptr<Event[]> events;
+
+  EventBuffer(const int thread)
+    : thread(thread), count(0), cleared(0), events(new Event[capacity]) {}
+
+  // The range of events still available
+  uint64_t lo() const {
+    const uint64_t n = count.load(std::memory_order_acquire);
+    return std::max(cleared.load(),n<uint64_t(capacity)?0:n-capacity);
+  }
+};
+
+std::mutex lock; // Protects buffers and names
+vector<unique_ptr<EventBuffer>> buffers;
+unordered_set<string> names; // Interned names of dynamic scopes
+
+}
+
+static GEODE_THREAD_LOCAL EventBuffer* local_buffer = 0;
+
+static inline int64_t now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static inline void record(const char* name) {
+  EventBuffer* buffer = local_buffer;
+  if (!buffer) {
+    std::lock_guard<std::mutex> guard(lock);
+    buffers.emplace_back(new EventBuffer(int(buffers.size())));
+    buffer = local_buffer = buffers.back().get();
+  }
+  const uint64_t n = buffer->count.load(std::memory_order_relaxed);
+  Event& e = buffer->events[n&(capacity-1)];
+  e.time = now();
+  e.name = name;
+  e.memory = memory_accounting() ? tracked_memory().live : -1;
+  buffer->count.store(n+1,std::memory_order_release);
+}
+
+void profile_detail::begin(const char* name) {
+  record(name);
+}
+
+void profile_detail::end() {
+  record(0);
+}
+
+void set_profiling(const bool enable) {
+  profile_detail::enabled = enable;
+}
+
+void clear_profile() {
+  std::lock_guard<std::mutex> guard(lock);
+  for (const auto& buffer : buffers)
+    buffer->cleared = buffer->count.load();
+}
+
+void profile_begin(const string& name) {
+  if (!profiling())
+    return;
+  const char* interned;
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    interned = names.insert(name).first->c_str();
+  }
+  record(interned);
+}
+
+void profile_end() {
+  if (profiling())
+    record(0);
+}
+
+// A snapshot of the current buffers
+static vector<EventBuffer*> all_buffers() {
+  std::lock_guard<std::mutex> guard(lock);
+  vector<EventBuffer*> all;
+  for (const auto& buffer : buffers)
+    all.push_back(buffer.get());
+  return all;
+}
+
+vector<ProfileNode> profile_tree() {
+  struct Node {
+    const char* name;
+    vector<int> children;
+    int64_t count, total, inner; // inner is the time spent in children
+  };
+  vector<ProfileNode> tree;
+  for (const auto buffer : all_buffers()) {
+    // Replay events, matching ends to begins.  Ends whose begin was lost to wraparound or a profiling toggle are
+    // ignored, as are scopes still open at the end.
+    vector<Node> nodes(1); // Node 0 is a dummy root
+    nodes[0].count = 0;
+    vector<std::pair<int,int64_t>> stack; // Open scopes and their start times
+    const uint64_t hi = buffer->count.load(std::memory_order_acquire);
+    for (uint64_t i=buffer->lo();i<hi;i++) {
+      const Event e = buffer->events[i&(capacity-1)];
+      if (e.name) {
+        const int parent = stack.size() ? stack.back().first : 0;
+        int child = -1;
+        for (const int c : nodes[parent].children)
+          if (!strcmp(nodes[c].name,e.name)) {
+            child = c;
+            break;
+          }
+        if (child<0) {
+          child = int(nodes.size());
+          nodes[parent].children.push_back(child);
+          const Node node = {e.name,vector<int>(),0,0,0};
+          nodes.push_back(node);
+        }
+        stack.push_back(std::make_pair(child,e.time));
+      } else if (stack.size()) {
+        const int n = stack.back().first;
+        const int64_t dt = e.time-stack.back().second;
+        stack.pop_back();
+        nodes[n].count++;
+        nodes[n].total += dt;
+        if (stack.size())
+          nodes[stack.back().first].inner += dt;
+      }
+    }
+
+    // Emit complete scopes in preorder
+    vector<std::pair<int,int>> todo; // Node and depth
+    for (int i=int(nodes[0].children.size())-1;i>=0;i--)
+      todo.push_back(std::make_pair(nodes[0].children[i],0));
+    while (todo.size()) {
+      const int n = todo.back().first,
+                depth = todo.back().second;
+      todo.pop_back();
+      const Node& node = nodes[n];
+      if (!node.count)
+        continue;
+      ProfileNode p = {buffer->thread,depth,node.name,node.count,1e-9*node.total,1e-9*(node.total-node.inner)};
+      tree.push_back(p);
+      for (int i=int(node.children.size())-1;i>=0;i--)
+        todo.push_back(std::make_pair(node.children[i],depth+1));
+    }
+  }
+  return tree;
+}
+
+string profile_report() {
+  string report;
+  int thread = -1;
+  for (const auto& node : profile_tree()) {
+    if (node.thread!=thread) {
+      thread = node.thread;
+      report += format("thread %d\n",thread);
+    }
+    report += format("%*s%s: count %lld, total %.6f s, self %.6f s\n",2*node.depth+2,"",node.name,
+                     (long long)node.count,node.total,node.self);
+  }
+  return report;
+}
+
+static void json_string(string& s, const char* name) {
+  s += '"';
+  for (const char* p=name;*p;p++) {
+    const unsigned char c = *p;
+    if (c=='"' || c=='\\') {
+      s += '\\';
+      s += c;
+    } else if (c<0x20)
+      s += format("\\u%04x",int(c));
+    else
+      s += c;
+  }
+  s += '"';
+}
+
+string profile_trace_json() {
+  const auto all = all_buffers();
+
+  // Timestamps are relative to the earliest event
+  int64_t start = std::numeric_limits<int64_t>::max();
+  for (const auto buffer : all) {
+    const uint64_t lo = buffer->lo();
+    if (lo<buffer->count.load(std::memory_order_acquire))
+      start = std::min(start,buffer->events[lo&(capacity-1)].time);
+  }
+
+  string s = "{\"traceEvents\":[";
+  bool first = true;
+  for (const auto buffer : all) {
+    const uint64_t hi = buffer->count.load(std::memory_order_acquire);
+    for (uint64_t i=buffer->lo();i<hi;i++) {
+      const Event e = buffer->events[i&(capacity-1)];
+      s += first ? "\n" : ",\n";
+      first = false;
+      s += "{\"ph\":";
+      s += e.name ? "\"B\",\"name\":" : "\"E\"";
+      if (e.name)
+        json_string(s,e.name);
+      const double ts = 1e-3*(e.time-start);
+      s += format(",\"pid\":0,\"tid\":%d,\"ts\":%.3f}",buffer->thread,ts);
+      if (e.memory>=0)
+        s += format(",\n{\"ph\":\"C\",\"name\":\"memory\",\"pid\":0,\"ts\":%.3f,\"args\":{\"bytes\":%lld}}",
+                    ts,(long long)e.memory);
+    }
+  }
+  s += "\n],\"displayTimeUnit\":\"ns\"}\n";
+  return s;
+}
+
+void write_profile_trace(const string& filename) {
+  const string json = profile_trace_json();
+  FILE* file = fopen(filename.c_str(),"w");
+  if (!file)
+    throw IOError(format("can't open '%s' for writing: %s",filename,strerror(errno)));
+  const bool ok = fwrite(json.c_str(),1,json.size(),file)==json.size();
+  if (fclose(file) || !ok)
+    throw IOError(format("failed to write profile trace '%s'",filename));
+}
+
+#ifdef GEODE_PYTHON
+
+static vector<Tuple<int,int,string,long long,double,double>> profile_tree_py() {
+  vector<Tuple<int,int,string,long long,double,double>> tree;
+  for (const auto& n : profile_tree())
+    tree.push_back(tuple(n.thread,n.depth,n.name,(long long)n.count,n.total,n.self));
+  return tree;
+}
+
+// Record nested scopes on several threads at once
+static void profile_test(const int threads, const int calls) {
+  vector<std::thread> workers;
+  for (int t=0;t<threads;t++)
+    workers.push_back(std::thread([=]() {
+      for (int i=0;i<calls;i++) {
+        ProfileScope outer("profile_test outer");
+        for (int j=0;j<2;j++)
+          ProfileScope inner("profile_test inner");
+      }
+    }));
+  for (auto& w : workers)
+    w.join();
+}
+
+#endif
+}
+using namespace geode;
+
+void wrap_profile() {
+  GEODE_FUNCTION(set_profiling)
+  GEODE_FUNCTION(profiling)
+  GEODE_FUNCTION(clear_profile)
+  GEODE_FUNCTION(profile_begin)
+  GEODE_FUNCTION(profile_end)
+  GEODE_FUNCTION(profile_report)
+  GEODE_FUNCTION(profile_trace_json)
+  GEODE_FUNCTION(write_profile_trace)
+#ifdef GEODE_PYTHON
+  GEODE_FUNCTION_2(profile_tree,profile_tree_py)
+  GEODE_FUNCTION(profile_test)
+#endif
+}
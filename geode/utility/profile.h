@@ -0,0 +1,89 @@
+//#####################################################################
+// Scoped profiling
+//#####################################################################
+//
+// A low overhead, thread aware profiler.  While profiling is enabled,
+// each thread records begin and end events with nanosecond timestamps into
+// its own fixed size ring buffer, so recording takes no locks and a long
+// run keeps only its most recent events.  Every Log::push_scope/pop_scope
+// pair is recorded, and hot or multithreaded code can add ProfileScope
+// guards, which cost one relaxed atomic load when profiling is off.
+//
+// Recorded events can be aggregated into a call tree per thread (with
+// counts, total and self times) or exported as Chrome trace JSON, which
+// chrome://tracing and Perfetto both load.  If memory accounting is on,
+// each event also records the counted bytes, exported as a counter track.  Aggregation and export read
+// other threads' buffers without locking, so call them once the profiled
+// work has finished; events written concurrently may be garbled.
+//
+//#####################################################################
+#pragma once
+
+#include <geode/utility/config.h>
+#include <atomic>
+#include <string>
+#include <vector>
+namespace geode {
+
+using std::string;
+using std::vector;
+
+namespace profile_detail {
+GEODE_CORE_EXPORT extern std::atomic<bool> enabled;
+GEODE_CORE_EXPORT void begin(const char* name);
+GEODE_CORE_EXPORT void end();
+}
+
+// Turn profiling on or off.  Scopes that straddle a toggle are dropped by aggregation.
+GEODE_CORE_EXPORT void set_profiling(const bool enable);
+
+static inline bool profiling() {
+  return profile_detail::enabled.load(std::memory_order_relaxed);
+}
+
+// Forget all events recorded so far
+GEODE_CORE_EXPORT void clear_profile();
+
+// Record a begin or end event on the current thread, if profiling is enabled.  The name is copied.
+GEODE_CORE_EXPORT void profile_begin(const string& name);
+GEODE_CORE_EXPORT void profile_end();
+
+// Profile the lifetime of this object.  name must outlive the profile, which string literals do.
+struct ProfileScope {
+  const bool active;
+
+  explicit ProfileScope(const char* name)
+    : active(profiling()) {
+    if (active)
+      profile_detail::begin(name);
+  }
+
+  ~ProfileScope() {
+    if (active)
+      profile_detail::end();
+  }
+
+  ProfileScope(const ProfileScope&) = delete;
+  void operator=(const ProfileScope&) = delete;
+};
+
+// One scope in the call tree of a thread.  Times are in seconds.
+struct ProfileNode {
+  int thread; // Small integer id of the recording thread
+  int depth; // Roots have depth 0
+  string name;
+  int64_t count; // Number of complete calls
+  double total, self; // Time inside the scope, and the part not inside child scopes
+};
+
+// Aggregate recorded events into call trees, one per thread, listed in preorder
+GEODE_CORE_EXPORT vector<ProfileNode> profile_tree();
+
+// The call trees as indented text, one scope per line
+GEODE_CORE_EXPORT string profile_report();
+
+// Recorded events in Chrome trace event format
+GEODE_CORE_EXPORT string profile_trace_json();
+GEODE_CORE_EXPORT void write_profile_trace(const string& filename);
+
+}
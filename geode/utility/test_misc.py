@@ -33,6 +33,88 @@ def test_partition_loop():
   for ranks in 1,2,1024,13813:
     large_partition_loop_test(1475380615039,ranks,samples)
 
+def test_parallel():
+  for n in 0,1,7,1000:
+    for grain in 1,3,256:
+      parallel_test(n,grain)
+  threads = thread_count()
+  set_thread_count(2)
+  assert thread_count()==2
+  set_thread_count(threads)
+
+def test_interrupts():
+  for n in 1,7,1000:
+    interrupt_test(n)
+  assert not interrupted()
+
+def test_progress_indicator():
+  for total,by in (1,1),(1000,1),(100000,3),(12345,7):
+    progress_indicator_test(total,by)
+
+def test_memory_accounting():
+  memory_accounting_test()
+  live,peak = tracked_memory()
+  assert 0<=live<=peak
+
+def test_metrics():
+  metrics_test()
+  samples = metrics_samples()
+  names = set(name for name,labels,value in samples)
+  for name in 'geode_test_counter_total','geode_test_histogram_bucket','geode_tracked_memory_bytes':
+    assert name in names
+  assert ('geode_test_gauge',{},2.5) in samples
+  with Log.scope('metrics scope 7'):
+    pass
+  assert any(name=='geode_log_scope_seconds_count' and labels=={'scope':'metrics scope'} and value>=1
+             for name,labels,value in metrics_samples())
+  text = metrics_text()
+  assert '# TYPE geode_test_counter_total counter\n' in text
+  assert 'geode_test_counter_total{a="1",b="2"} ' in text
+  assert 'geode_test_histogram_bucket{le="+Inf"} ' in text
+
+def test_profile():
+  import json
+  clear_profile()
+  set_profiling(True)
+  try:
+    with Log.scope('profile outer'):
+      with Log.scope('profile inner'):
+        pass
+    profile_test(3,10)
+  finally:
+    set_profiling(False)
+  tree = profile_tree()
+  names = [(depth,name,count) for thread,depth,name,count,total,self in tree]
+  assert (0,'profile outer',1) in names
+  assert (1,'profile inner',1) in names
+  assert names.count((0,'profile_test outer',10))==3
+  assert names.count((1,'profile_test inner',20))==3
+  for thread,depth,name,count,total,self in tree:
+    assert 0<=self<=total
+  events = json.loads(profile_trace_json())['traceEvents']
+  assert len(events)==2*(2+3*30)
+  assert len(set(e['tid'] for e in events))>=3
+  clear_profile()
+  assert not profile_tree()
+
+def test_log_async():
+  import tempfile
+  file = tempfile.NamedTemporaryFile(suffix='.log')
+  Log.copy_to_file(file.name,False)
+  Log.set_async(True)
+  try:
+    with Log.scope('async scope'):
+      log_async_test(4,100)
+  finally:
+    Log.set_async(False)
+    Log.copy_to_file('',False)
+  # Each line arrives whole, and each thread's lines arrive in order
+  lines = [line.strip() for line in open(file.name).read().split('\n')]
+  for t in xrange(4):
+    mine = [line for line in lines if line.startswith('thread %d '%t)]
+    assert mine==['thread %d line %d'%(t,i) for i in xrange(100)]
+  assert any(line.startswith('async scope') for line in lines)
+
 def test_format():
   format_test()
 
@@ -65,6 +147,7 @@ def test_geode_endian():
 if __name__=='__main__':
   test_cache_method()
   test_partition_loop()
+  test_parallel()
   test_base64()
   test_curry()
   test_format()
@@ -7,6 +7,7 @@ using std::cout;
 using std::endl;
 
 GEODE_THREAD_LOCAL const Action* Action::current = 0;
+GEODE_THREAD_LOCAL vector<const ValueBase*>* Action::recording = 0;
 
 Action::Action()
   : inputs_(0), executing(false) {}
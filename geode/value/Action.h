@@ -15,6 +15,11 @@ private:
   mutable ValueBase::Link* inputs_; // linked list of inputs we depend on
   GEODE_CORE_EXPORT static GEODE_THREAD_LOCAL const Action* current; // if nonzero, pulled values link themselves to this automatically
   mutable bool executing; // are we in the middle of execution?
+
+  // Set while pull_parallel evaluates a node on this thread.  Pulled values are recorded here instead of linked, and
+  // pulling a dirty value throws PullBlocked, since only the calling thread may touch the graph.
+  GEODE_CORE_EXPORT static GEODE_THREAD_LOCAL vector<const ValueBase*>* recording;
+  friend void pull_parallel(const vector<Ref<const ValueBase>>& values);
 protected:
   class Executing {
     bool& executing;
@@ -33,6 +38,10 @@ protected:
     }
   };
   friend class Executing;
+
+  bool is_executing() const {
+    return executing;
+  }
 public:
 
   GEODE_CORE_EXPORT Action();
@@ -47,10 +56,21 @@ public:
 protected:
   GEODE_CORE_EXPORT void clear_dependencies() const;
   GEODE_CORE_EXPORT void depend_on(const ValueBase& value) const;
+
+  // Pull a value as if through Value<T>::operator(), for actions that don't know its type
+  static void pull(const ValueBase& value) {
+    value.pull();
+  }
 private:
   virtual void input_changed() const = 0;
 };
 
+// Thrown out of a node evaluated by pull_parallel when it pulls a dirty input.  This deliberately doesn't derive from
+// std::exception, so that the node's own error handling doesn't catch it.
+struct PullBlocked {
+  const ValueBase* value;
+};
+
 
 // Set the ValueRef to the given value, and set its dependencies manually (instead of a cache() or other
 // automatic way of determining them. You should know what you're doing. This only works if the ValueRef
@@ -0,0 +1,128 @@
+#include <geode/value/AsyncCompute.h>
+#include <geode/value/Prop.h>
+#include <geode/python/wrap.h>
+#include <geode/utility/interrupts.h>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+namespace geode {
+
+using std::unique_ptr;
+
+// Nodes with possibly running jobs, and cancelled jobs whose threads haven't finished.  Touched only by the thread
+// owning the value graph.
+static vector<const AsyncComputeBase*> async_nodes;
+static vector<unique_ptr<AsyncJob>> cancelled_jobs;
+
+void AsyncJob::start() {
+  std::thread([this]() {
+    {
+      const InterruptScope scope(&cancelled);
+      try {
+        run();
+      } catch (...) {
+        error = std::current_exception();
+      }
+    }
+    done = true;
+  }).detach();
+}
+
+AsyncComputeBase::AsyncComputeBase() {
+  async_nodes.push_back(this);
+}
+
+AsyncComputeBase::~AsyncComputeBase() {
+  cancel();
+  async_nodes.erase(std::find(async_nodes.begin(),async_nodes.end(),this));
+}
+
+void AsyncComputeBase::launch(AsyncJob* new_job) const {
+  cancel();
+  job.reset(new_job);
+  job->start();
+}
+
+void AsyncComputeBase::cancel() const {
+  if (job) {
+    job->cancelled = true;
+    cancelled_jobs.push_back(std::move(job));
+  }
+}
+
+int poll_async() {
+  // Free cancelled jobs whose threads are done
+  cancelled_jobs.erase(std::remove_if(cancelled_jobs.begin(),cancelled_jobs.end(),
+    [](const unique_ptr<AsyncJob>& job) { return bool(job->done); }),cancelled_jobs.end());
+
+  // Install finished results one at a time, since the signals sent by each may create or destroy nodes
+  int count = 0;
+  for (;;) {
+    const AsyncComputeBase* node = 0;
+    for (const auto n : async_nodes)
+      if (n->job && n->job->done) {
+        node = n;
+        break;
+      }
+    if (!node)
+      return count;
+    const unique_ptr<AsyncJob> job(std::move(node->job));
+    node->finish(*job);
+    count++;
+  }
+}
+
+int wait_async() {
+  for (;;) {
+    bool running = false;
+    for (const auto n : async_nodes)
+      running |= n->running();
+    for (const auto& job : cancelled_jobs)
+      running |= !job->done;
+    if (!running)
+      return poll_async();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+
+#ifdef GEODE_PYTHON
+
+// For testing purposes: an async node whose work sleeps until cancelled or done
+static void async_cache_test() {
+  const auto p = PropRef<int>("p",1);
+  const auto slow = async_cache([=]() { return p(); },[](const int x) {
+    for (int i=0;i<10;i++) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+      check_interrupts();
+    }
+    if (x<0)
+      throw ValueError("negative");
+    return 10*x;
+  });
+  GEODE_ASSERT(slow()==10); // The first pull is synchronous
+  p->set(2);
+  GEODE_ASSERT(slow()==10); // Stale until polled
+  p->set(3); // Cancels the job for 2
+  GEODE_ASSERT(slow()==10);
+  GEODE_ASSERT(wait_async()==1);
+  GEODE_ASSERT(!slow->dirty() && slow()==30);
+  p->set(-1);
+  slow();
+  wait_async();
+  try {
+    slow();
+    GEODE_ASSERT(false);
+  } catch (const ValueError&) {}
+}
+
+#endif
+}
+using namespace geode;
+
+void wrap_async_compute() {
+  GEODE_FUNCTION(poll_async)
+  GEODE_FUNCTION(wait_async)
+#ifdef GEODE_PYTHON
+  GEODE_FUNCTION(async_cache_test)
+#endif
+}
@@ -0,0 +1,166 @@
+//#####################################################################
+// Class AsyncCompute
+//#####################################################################
+//
+// A Compute whose work runs on a background thread, so that expensive nodes
+// (CSG, offsets) don't block the thread driving the value graph.
+//
+// The computation is split in two.  gather() runs on the pulling thread like
+// an ordinary cache function, pulling every input it needs and returning
+// them as a snapshot.  work(snapshot) then runs on a background thread, and
+// must not touch the value graph or python.  While it runs, pulling the node
+// returns the last finished value.  The first pull has no such value, so it
+// runs work synchronously.
+//
+// When an input changes, the running computation is cancelled: the next
+// check_interrupts on its thread throws, so long computations should call
+// check_interrupts (as parallel_for does) to stop early.  Finished results
+// are installed by poll_async, which must be called regularly from the
+// thread that owns the graph, e.g. from a UI event loop.  Installing a result
+// signals dependents as if a prop had changed.  Errors thrown by work are
+// rethrown by the next pull.
+//
+// All graph updates and all destruction of snapshots and results happen on
+// the owning thread.  So in python builds, which don't use atomic
+// reference counts, a snapshot may safely share arrays with the rest of the
+// graph as long as work itself doesn't copy them.
+//
+//#####################################################################
+#pragma once
+
+#include <geode/value/Compute.h>
+#include <atomic>
+#include <exception>
+#include <memory>
+namespace geode {
+
+// A computation running on its own thread
+class GEODE_CORE_CLASS_EXPORT AsyncJob {
+public:
+  std::atomic<bool> cancelled, done;
+  std::exception_ptr error; // Set if run threw, read only once done
+
+  AsyncJob()
+    : cancelled(false), done(false) {}
+  virtual ~AsyncJob() {}
+
+  // Start run on a new detached thread.  The thread never touches the job after setting done.
+  GEODE_CORE_EXPORT void start();
+
+private:
+  virtual void run() = 0;
+};
+
+// Install the results of finished async computations, returning how many were installed.  Call only from the thread
+// which owns the value graph.
+GEODE_CORE_EXPORT int poll_async();
+
+// Wait for every running async computation to finish, then poll_async.  Mostly for tests.
+GEODE_CORE_EXPORT int wait_async();
+
+class GEODE_CORE_CLASS_EXPORT AsyncComputeBase {
+protected:
+  mutable std::unique_ptr<AsyncJob> job; // The current computation, if any
+
+  GEODE_CORE_EXPORT AsyncComputeBase();
+  GEODE_CORE_EXPORT virtual ~AsyncComputeBase();
+
+  // Cancel any current job, and start a new one
+  GEODE_CORE_EXPORT void launch(AsyncJob* job) const;
+
+  // Cancel the current job.  It is kept until its thread finishes, then destroyed by poll_async.
+  GEODE_CORE_EXPORT void cancel() const;
+
+private:
+  friend int poll_async();
+
+  // Install the result of a finished job
+  virtual void finish(AsyncJob& job) const = 0;
+
+public:
+  bool running() const {
+    return job && !job->done;
+  }
+};
+
+template<class T,class S> class GEODE_CORE_CLASS_EXPORT AsyncCompute : public Value<T>,public Action,
+                                                                       public AsyncComputeBase {
+public:
+  GEODE_NEW_FRIEND
+  typedef Value<T> Base;
+private:
+  const function<S()> gather;
+  const function<T(const S&)> work;
+  mutable std::unique_ptr<T> last; // The last finished value
+  mutable std::exception_ptr failed; // An error from the last job, to be thrown by the next pull
+
+  struct Job : public AsyncJob {
+    const function<T(const S&)> work;
+    const S inputs;
+    std::unique_ptr<T> result;
+
+    Job(const function<T(const S&)>& work, const S& inputs)
+      : work(work), inputs(inputs) {}
+
+    void run() {
+      result.reset(new T(work(inputs)));
+    }
+  };
+
+protected:
+  template<class G,class W> AsyncCompute(const G& gather, const W& work)
+    : gather(gather), work(work) {}
+public:
+
+  void input_changed() const {
+    cancel();
+    Base::set_dirty();
+  }
+
+  void update() const {
+    if (failed) {
+      const auto error = failed;
+      failed = std::exception_ptr();
+      std::rethrow_exception(error);
+    }
+    Executing e(*this);
+    const S inputs = gather();
+    e.stop(0);
+    if (!last) // Nothing to show yet, so compute synchronously
+      last.reset(new T(work(inputs)));
+    else
+      launch(new Job(work,inputs));
+    this->set_value(*last);
+  }
+
+  void dump(int indent) const {
+    printf("%*sAsyncCompute<%s>\n",2*indent,"",typeid(T).name());
+    Action::dump_dependencies(indent);
+  }
+
+  vector<Ref<const ValueBase>> dependencies() const {
+    return Action::dependencies();
+  }
+
+private:
+  void finish(AsyncJob& job) const {
+    auto& j = static_cast<Job&>(job);
+    if (j.error) {
+      failed = j.error;
+      Base::set_dirty();
+    } else {
+      last = std::move(j.result);
+      this->set_value(*last);
+    }
+  }
+};
+
+// A value computed by work(gather()), with work running in the background.  See above.
+template<class G,class W> static inline auto async_cache(const G& gather, const W& work)
+  -> ValueRef<typename remove_const_reference<decltype(work(gather()))>::type> {
+  typedef typename remove_const_reference<decltype(gather())>::type S;
+  typedef typename remove_const_reference<decltype(work(gather()))>::type T;
+  return ValueRef<T>(new_<AsyncCompute<T,S>>(gather,work));
+}
+
+}
@@ -1,9 +1,102 @@
 #include <geode/value/Compute.h>
+#include <geode/value/MemoCompute.h>
+#include <geode/value/Prop.h>
+#include <geode/value/convert.h>
 #include <geode/python/from_python.h>
 #include <geode/python/Ptr.h>
 #include <geode/python/Class.h>
+#include <geode/python/stl.h>
 #include <geode/utility/format.h>
+#include <geode/utility/parallel.h>
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
 namespace geode {
+
+using std::exception;
+using std::unordered_map;
+using std::unordered_set;
+
+static const ParallelAction* stageable(const ValueBase* value) {
+  const auto action = dynamic_cast<const ParallelAction*>(value);
+  return action && action->stageable() ? action : 0;
+}
+
+void pull_parallel(const vector<Ref<const ValueBase>>& values) {
+  vector<const ValueBase*> wave;
+  unordered_set<const ValueBase*> queued;
+  for (const auto& value : values)
+    if (stageable(&*value) && queued.insert(&*value).second)
+      wave.push_back(&*value);
+
+  unordered_map<const ValueBase*,vector<const ValueBase*>> waiting; // Nodes blocked on each dirty input
+  while (wave.size()) {
+    // Stage every node in the wave concurrently, recording inputs instead of linking them
+    wave.erase(std::remove_if(wave.begin(),wave.end(),[](const ValueBase* v) { return !stageable(v); }),wave.end());
+    const int n = int(wave.size());
+    vector<vector<const ValueBase*>> inputs(n);
+    vector<const ValueBase*> blocked(n);
+    vector<char> staged(n);
+    parallel_for(n,[&](const int i) {
+      const auto parent = Action::current;
+      Action::current = 0;
+      Action::recording = &inputs[i];
+      try {
+        dynamic_cast<const ParallelAction&>(*wave[i]).stage();
+        staged[i] = true;
+      } catch (const PullBlocked& b) {
+        blocked[i] = b.value;
+      } catch (const exception&) {
+        // Leave the node dirty so that the final pull reports the error
+      }
+      Action::recording = 0;
+      Action::current = parent;
+    });
+
+    // Commit serially, and queue blocked nodes behind their inputs
+    vector<const ValueBase*> next;
+    const auto release = [&](const ValueBase* value) {
+      const auto w = waiting.find(value);
+      if (w != waiting.end()) {
+        next.insert(next.end(),w->second.begin(),w->second.end());
+        waiting.erase(w);
+      }
+    };
+    for (int i=0;i<n;i++) {
+      if (staged[i]) {
+        dynamic_cast<const ParallelAction&>(*wave[i]).commit(inputs[i]);
+        release(wave[i]);
+      } else if (const auto b = blocked[i]) {
+        if (!b->dirty()) // Committed earlier in this wave
+          next.push_back(wave[i]);
+        else {
+          waiting[b].push_back(wave[i]);
+          if (queued.insert(b).second) {
+            if (stageable(b))
+              next.push_back(b);
+            else {
+              // Evaluate inputs we can't stage right away, so that the nodes behind them can still go in parallel
+              try {
+                Action::Executing e;
+                b->pull();
+              } catch (const exception&) {
+                // The error is cached in b, and reported when a node pulls it
+              }
+              if (!b->dirty())
+                release(b);
+            }
+          }
+        }
+      }
+    }
+    wave.swap(next);
+  }
+
+  // Evaluate whatever is left in the ordinary way
+  for (const auto& value : values)
+    value->pull();
+}
+
 #ifdef GEODE_PYTHON
 
 static PyObject* empty_tuple = 0;
@@ -72,6 +165,42 @@ static Ref<ValueBase> cache_named_inner(PyObject* f, string const &name) {
   return new_<CachePython>(f, name);
 }
 
+// For testing purposes: toggle a prop back and forth under a memo_cache node
+static void memo_cache_test() {
+  const auto p = PropRef<int>("p",1),
+             q = PropRef<int>("q",0);
+  const auto evals = std::make_shared<int>(0);
+  const auto m = memo_cache([=]() {
+    (*evals)++;
+    return q() ? 100 : 10*p();
+  },2);
+  const auto& memo = dynamic_cast<const MemoCompute<int>&>(*m);
+  GEODE_ASSERT(m()==10 && *evals==1);
+  p->set(2);
+  GEODE_ASSERT(m()==20 && *evals==2);
+  p->set(1);
+  GEODE_ASSERT(m()==10 && *evals==2 && memo.hits==1);
+  q->set(1);
+  GEODE_ASSERT(m()==100 && *evals==3 && memo.memo_entries()==2);
+  q->set(0);
+  GEODE_ASSERT(m()==10 && *evals==3 && memo.hits==2);
+  p->set(2); // Evicted
+  GEODE_ASSERT(m()==20 && *evals==4);
+}
+
+// For testing purposes: the sum of width parallel_cache nodes i*n()
+static ValueRef<int> parallel_cache_test(ValueRef<int> n, const int width) {
+  vector<ValueRef<int>> terms;
+  for (int i=0;i<width;i++)
+    terms.push_back(parallel_cache([=]() { return i*n(); }));
+  return parallel_cache([=]() {
+    int sum = 0;
+    for (const auto& t : terms)
+      sum += t();
+    return sum;
+  });
+}
+
 #endif
 }
 using namespace geode;
@@ -90,5 +219,8 @@ void wrap_compute() {
 
   GEODE_FUNCTION_2(cache,cache_py)
   GEODE_FUNCTION_2(cache_named_inner,cache_named_inner)
+  GEODE_FUNCTION(pull_parallel)
+  GEODE_FUNCTION(parallel_cache_test)
+  GEODE_FUNCTION(memo_cache_test)
 #endif
 }
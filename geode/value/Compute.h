@@ -10,19 +10,32 @@
 #include <geode/utility/format.h>
 #include <geode/utility/function.h>
 #include <geode/utility/type_traits.h>
+#include <memory>
 #include <stdio.h>
 namespace geode {
 
-template<class T> class GEODE_CORE_CLASS_EXPORT Compute : public Value<T>,public Action {
+// A node which pull_parallel may evaluate on a worker thread.  stage computes the new value off to the side, reading
+// inputs only through pull; commit is called later on the pulling thread to link the recorded inputs and set the value.
+class GEODE_CORE_CLASS_EXPORT ParallelAction {
+public:
+  virtual ~ParallelAction() {}
+  virtual bool stageable() const = 0;
+  virtual void stage() const = 0;
+  virtual void commit(const vector<const ValueBase*>& inputs) const = 0;
+};
+
+template<class T> class GEODE_CORE_CLASS_EXPORT Compute : public Value<T>,public Action,public ParallelAction {
 public:
   GEODE_NEW_FRIEND
   typedef Value<T> Base;
 private:
   const function<T()> f;
+  const bool parallel; // Created by parallel_cache
+  mutable std::unique_ptr<T> staged;
 
 protected:
-  template<class F> Compute(const F& f)
-    :f(f) {}
+  template<class F> Compute(const F& f, const bool parallel=false)
+    : f(f), parallel(parallel) {}
 public:
 
   void input_changed() const {
@@ -34,6 +47,22 @@ public:
     this->set_value(e.stop(f())); // Note that e is stopped before set_value is called
   }
 
+  bool stageable() const {
+    return parallel && this->dirty() && !is_executing();
+  }
+
+  void stage() const {
+    staged.reset(new T(f()));
+  }
+
+  void commit(const vector<const ValueBase*>& inputs) const {
+    clear_dependencies();
+    for (const auto input : inputs)
+      depend_on(*input);
+    const std::unique_ptr<T> value(staged.release());
+    this->set_value(*value);
+  }
+
   void dump(int indent) const {
     printf("%*sCompute<%s>\n",2*indent,"",typeid(T).name());
     Action::dump_dependencies(indent);
@@ -50,6 +79,21 @@ template<class F> static inline auto cache(const F& f)
   return ValueRef<T>(new_<Compute<T>>(f));
 }
 
+// As cache, but pull_parallel may evaluate the node on a worker thread concurrently with others.  f must be safe to
+// run off the main thread (no python, no shared mutable state), and should read other values only by pulling them.
+template<class F> static inline auto parallel_cache(const F& f)
+  -> ValueRef<typename remove_const_reference<decltype(f())>::type> {
+  typedef typename remove_const_reference<decltype(f())>::type T;
+  return ValueRef<T>(new_<Compute<T>>(f,true));
+}
+
+// Pull several values, evaluating independent dirty parallel_cache nodes concurrently.  Dependencies are discovered
+// by running nodes, so this proceeds in waves: each wave stages every ready node in parallel, a node that pulls a dirty
+// input is set aside until that input has been computed, and the finished nodes are committed serially.  Anything that
+// can't be staged (plain or python caches, nodes that throw, cycles) is left to an ordinary pull of each value at the
+// end, which also rethrows errors.
+GEODE_CORE_EXPORT void pull_parallel(const vector<Ref<const ValueBase>>& values);
+
 #ifdef GEODE_VARIADIC
 
 template<class A0,class A1,class... Args> static inline auto cache(const A0& a0, const A1& a1, const Args&... args)
@@ -58,6 +102,13 @@ template<class A0,class A1,class... Args> static inline auto cache(const A0& a0,
   return ValueRef<T>(new_<Compute<T>>(curry(a0,a1,args...)));
 }
 
+template<class A0,class A1,class... Args> static inline auto parallel_cache(const A0& a0, const A1& a1,
+                                                                           const Args&... args)
+  -> ValueRef<typename remove_const_reference<decltype(curry(a0,a1,args...)())>::type> {
+  typedef typename remove_const_reference<decltype(curry(a0,a1,args...)())>::type T;
+  return ValueRef<T>(new_<Compute<T>>(curry(a0,a1,args...),true));
+}
+
 #else // Unpleasant nonvariadic versions
 
 #define GEODE_CACHE(ARGS,Argsargs,args) \
@@ -65,6 +116,11 @@ template<class A0,class A1,class... Args> static inline auto cache(const A0& a0,
     -> ValueRef<typename remove_const_reference<decltype(curry args())>::type> { \
     typedef typename remove_const_reference<decltype(curry args())>::type T; \
     return ValueRef<T>(new_<Compute<T>>(curry args)); \
+  } \
+  template<GEODE_REMOVE_PARENS(ARGS)> static inline auto parallel_cache Argsargs \
+    -> ValueRef<typename remove_const_reference<decltype(curry args())>::type> { \
+    typedef typename remove_const_reference<decltype(curry args())>::type T; \
+    return ValueRef<T>(new_<Compute<T>>(curry args,true)); \
   }
 GEODE_CACHE((class A0,class A1),(const A0& a0,const A1& a1),(a0,a1))
 GEODE_CACHE((class A0,class A1,class A2),(const A0& a0,const A1& a1,const A2& a2),(a0,a1,a2))
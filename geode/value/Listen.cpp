@@ -1,6 +1,7 @@
 #include "Listen.h"
 #include <geode/python/Class.h>
 #include <geode/python/function.h>
+#include <geode/python/stl.h>
 #include <geode/python/wrap.h>
 namespace geode {
 
@@ -41,6 +42,8 @@ void BatchListen::input_changed() const {
   } catch (const exception& e) {
     print_and_clear_exception("Listen: exception in listener callback",e);
   }
+  // Drop links to the other values, which may still be pending if several changed at once (see SignalBatch)
+  clear_dependencies();
   for(const auto v : values)
     depend_on(*v);
 }
@@ -60,4 +63,8 @@ void wrap_listen() {
   typedef Listen Self;
   Class<Self>("Listen");
   GEODE_FUNCTION_2(listen, static_cast<Ref<Listen>(*)(const ValueBase&,const function<void()>&)>(listen))
+
+  typedef BatchListen BatchSelf;
+  Class<BatchSelf>("BatchListen");
+  GEODE_FUNCTION(batch_listen)
 }
@@ -0,0 +1,147 @@
+//#####################################################################
+// Class MemoCompute
+//#####################################################################
+//
+// A Compute which remembers a few previous results, so that returning to
+// earlier inputs (undo and redo, a prop toggled back and forth, parameter
+// sweeps) reuses the old result instead of recomputing it.
+//
+// Each result is stored with the inputs its computation pulled and the
+// hashes of their values at the time.  On update, entries are tried most
+// recent first: if every input of an entry still hashes the same, f would
+// pull the same inputs and return the same value, so the entry is reused.
+// This assumes f is deterministic and reads other values only by pulling
+// them, and it trusts 32 bit hashes, so a hash collision on every input of
+// an entry would return a stale result.  If some input has no hash_reduce,
+// results aren't stored and the node behaves like cache.
+//
+//#####################################################################
+#pragma once
+
+#include <geode/value/Compute.h>
+#include <geode/array/Array.h>
+#include <list>
+namespace geode {
+
+// Approximate memory held by a memoized result.  Overload for other types with large heap storage.
+template<class T> static inline size_t memo_bytes(const T& x) {
+  return sizeof(T);
+}
+
+template<class T> static inline size_t memo_bytes(const Array<T>& x) {
+  return sizeof(x)+sizeof(T)*size_t(x.size());
+}
+
+template<class T,int d> static inline size_t memo_bytes(const Array<T,d>& x) {
+  return sizeof(x)+sizeof(T)*size_t(x.flat.size());
+}
+
+template<class T> class GEODE_CORE_CLASS_EXPORT MemoCompute : public Value<T>,public Action {
+public:
+  GEODE_NEW_FRIEND
+  typedef Value<T> Base;
+private:
+  struct Entry {
+    vector<Ref<const ValueBase>> inputs;
+    vector<int> hashes; // hashes[i] is the hash of inputs[i] when value was computed
+    T value;
+    size_t bytes;
+  };
+
+  const function<T()> f;
+  const int max_entries;
+  const size_t max_bytes; // Zero for no limit
+  mutable std::list<Entry> entries; // Most recently used first
+  mutable size_t bytes;
+
+protected:
+  template<class F> MemoCompute(const F& f, const int max_entries, const size_t max_bytes)
+    : f(f), max_entries(max_entries), max_bytes(max_bytes), bytes(0), hits(0) {
+    GEODE_ASSERT(max_entries>0);
+  }
+public:
+
+  mutable int hits; // Updates answered from memory
+
+  void input_changed() const {
+    Base::set_dirty();
+  }
+
+  void update() const {
+    Executing e(*this);
+
+    // Reuse the first entry whose inputs all hash the same as before
+    for (auto it=entries.begin();it!=entries.end();++it)
+      if (matches(*it)) {
+        entries.splice(entries.begin(),entries,it);
+        clear_dependencies();
+        for (const auto& input : it->inputs)
+          depend_on(*input);
+        hits++;
+        e.stop(0);
+        this->set_value(it->value);
+        return;
+      }
+
+    // Otherwise compute from scratch, dropping the links made while checking entries
+    clear_dependencies();
+    Entry entry = {vector<Ref<const ValueBase>>(),vector<int>(),f(),0};
+    entry.inputs = Action::dependencies();
+    entry.hashes.resize(entry.inputs.size());
+    bool hashable = true;
+    for (int i=0;i<int(entry.inputs.size());i++)
+      hashable &= entry.inputs[i]->peek_hash(entry.hashes[i]);
+    e.stop(0);
+    this->set_value(entry.value);
+    if (hashable)
+      remember(entry);
+  }
+
+  void dump(int indent) const {
+    printf("%*sMemoCompute<%s>\n",2*indent,"",typeid(T).name());
+    Action::dump_dependencies(indent);
+  }
+
+  vector<Ref<const ValueBase>> dependencies() const {
+    return Action::dependencies();
+  }
+
+  int memo_entries() const {
+    return int(entries.size());
+  }
+
+private:
+  bool matches(const Entry& entry) const {
+    for (int i=0;i<int(entry.inputs.size());i++) {
+      try {
+        Action::pull(*entry.inputs[i]);
+      } catch (const exception&) {
+        return false; // f may not read this input anymore, so let it decide whether to fail
+      }
+      int hash;
+      if (!entry.inputs[i]->peek_hash(hash) || hash!=entry.hashes[i])
+        return false;
+    }
+    return true;
+  }
+
+  void remember(Entry& entry) const {
+    entry.bytes = memo_bytes(entry.value);
+    bytes += entry.bytes;
+    entries.push_front(entry);
+    while (int(entries.size())>max_entries || (max_bytes && bytes>max_bytes && entries.size()>1)) {
+      bytes -= entries.back().bytes;
+      entries.pop_back();
+    }
+  }
+};
+
+// As cache, but keeping up to max_entries previous results (and at most about max_bytes of them, if nonzero) to reuse
+// when the inputs return to earlier values.  See above for the conditions on f.
+template<class F> static inline auto memo_cache(const F& f, const int max_entries=8, const size_t max_bytes=0)
+  -> ValueRef<typename remove_const_reference<decltype(f())>::type> {
+  typedef typename remove_const_reference<decltype(f())>::type T;
+  return ValueRef<T>(new_<MemoCompute<T>>(f,max_entries,max_bytes));
+}
+
+}
@@ -94,6 +94,15 @@ PropBase& PropManager::getattr(const string& name) const {
     throw AttributeError(name);
 }
 
+void PropManager::enter_batch() {
+  ValueBase::begin_signal_batch();
+}
+
+bool PropManager::exit_batch(PyObject* type, PyObject* value, PyObject* traceback) {
+  ValueBase::end_signal_batch();
+  return false; // Don't swallow exceptions
+}
+
 #endif
 
 }
@@ -112,6 +121,8 @@ void wrap_prop_manager() {
     .GEODE_CONST_FIELD(items)
     .GEODE_CONST_FIELD(order)
     .GEODE_FIELD(frozen)
+    .GEODE_METHOD_2("__enter__",enter_batch)
+    .GEODE_METHOD_2("__exit__",exit_batch)
     .getattr()
     ;
 #endif
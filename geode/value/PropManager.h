@@ -59,6 +59,13 @@ public:
     return add(name,default_);
   }
 
+  // Set several props as one transaction: their dependents are invalidated once, when the outermost batch ends (see
+  // SignalBatch in Value.h).  In python, use "with manager:".
+  template<class F> void batch(const F& f) {
+    SignalBatch batch;
+    f();
+  }
+
   // Turn char* to string
   GEODE_CORE_EXPORT Prop<string>& add(const string& name, const char* default_);
   GEODE_CORE_EXPORT Prop<string>& get_or_add(const string& name, const char* default_);
@@ -67,6 +74,8 @@ public:
   PropBase& add_python(const string& name, PyObject* default_);
   PropBase& get_or_add_python(const string& name, PyObject* default_);
   PropBase& getattr(const string& name) const;
+  void enter_batch();
+  bool exit_batch(PyObject* type, PyObject* value, PyObject* traceback);
 #endif
 };
 
@@ -23,6 +23,7 @@ GEODE_DEFINE_TYPE(ValueBase)
 // is important, since Actions need to be able to delete their links from the pending list if they
 // destruct during dependency propagation.
 GEODE_THREAD_LOCAL ValueBase::Link* ValueBase::pending = 0;
+GEODE_THREAD_LOCAL int ValueBase::batch_depth = 0;
 
 ValueBase::ValueBase(string const &s)
   : dirty_(true), name_(s), actions(0)
@@ -93,11 +94,32 @@ void ValueBase::signal() const {
     link = next;
   }
 
-  // Send signals
-  signal_pending();
+  // Send signals, unless a batch is collecting them
+  if (!batch_depth)
+    signal_pending();
+}
+
+void ValueBase::begin_signal_batch() {
+  batch_depth++;
+}
+
+void ValueBase::end_signal_batch() {
+  GEODE_ASSERT(batch_depth>0);
+  if (!--batch_depth)
+    signal_pending();
 }
 
 void ValueBase::pull() const {
+  // Inside pull_parallel, record the input without touching the graph
+  if (const auto recording = Action::recording) {
+    if (dirty_)
+      throw PullBlocked({this});
+    recording->push_back(this);
+    if (error)
+      error.throw_();
+    return;
+  }
+
   // If there are any pending signals, send them
   signal_pending();
 
@@ -7,7 +7,9 @@
 #include <geode/python/Object.h>
 #include <geode/python/try_convert.h>
 #include <geode/python/ExceptionValue.h>
+#include <geode/math/hash.h>
 #include <geode/utility/type_traits.h>
+#include <geode/utility/validity.h>
 #include <geode/vector/Vector.h>
 extern void wrap_value_base();
 
@@ -19,6 +21,9 @@ namespace geode {
 using std::vector;
 using std::type_info;
 
+// See Compute.h
+GEODE_CORE_EXPORT void pull_parallel(const vector<Ref<const ValueBase>>& values);
+
 class GEODE_CORE_CLASS_EXPORT ValueBase : public Object, public WeakRefSupport {
 public:
   GEODE_DECLARE_TYPE(GEODE_CORE_EXPORT)
@@ -42,6 +47,7 @@ private:
   };
   mutable Link* actions; // linked list of links to actions which depend on us
   static GEODE_THREAD_LOCAL Link* pending; // linked list of pending signals
+  static GEODE_THREAD_LOCAL int batch_depth; // number of open signal batches
 
 protected:
   GEODE_CORE_EXPORT ValueBase(string const &name = string());
@@ -64,6 +70,12 @@ public:
     return dirty_;
   }
 
+  // Hash the current value without pulling it, for memo_cache.  Returns false if the value is dirty, holds an error,
+  // or has no hash_reduce.
+  virtual bool peek_hash(int& hash) const {
+    return false;
+  }
+
   template<class T> const Value<T>* cast() const {
     return is_type(typeid(T)) ? static_cast<const Value<T>*>(this) : 0;
   }
@@ -71,6 +83,13 @@ public:
   GEODE_CORE_EXPORT bool is_type(const type_info& type) const;
   GEODE_CORE_EXPORT void signal() const;
 
+  // While a batch is open on this thread, signals are queued instead of sent, and the queue is delivered when the
+  // outermost batch ends.  Setting several props in a batch therefore invalidates their dependents in one pass: a
+  // Compute depending on many of them goes dirty once, and a BatchListen is called once.  Pulling a value inside a
+  // batch delivers the queue early, since the value must see the new props.  Prefer the SignalBatch guard below.
+  GEODE_CORE_EXPORT static void begin_signal_batch();
+  GEODE_CORE_EXPORT static void end_signal_batch();
+
   virtual void dump(int indent) const = 0;
 
   // things that depend on us
@@ -88,6 +107,7 @@ public:
   const string& name() const;
 
 private:
+  friend void pull_parallel(const vector<Ref<const ValueBase>>& values);
   GEODE_CORE_EXPORT void pull() const;
 
   virtual void update() const = 0;
@@ -122,10 +142,35 @@ private:
 #endif
 };
 
+// Queue signals for the lifetime of this object
+struct SignalBatch {
+  SignalBatch() {
+    ValueBase::begin_signal_batch();
+  }
+
+  ~SignalBatch() {
+    ValueBase::end_signal_batch();
+  }
+
+  SignalBatch(const SignalBatch&) = delete;
+  void operator=(const SignalBatch&) = delete;
+};
+
 // Forward declare from Action.h for friending from Value, as this needs to call set_value
 template<class T> void set_value_and_dependencies(ValueRef<T>& value, const T& v,
                                                   const vector<const ValueBase*>& dependencies);
 
+GEODE_VALIDITY_CHECKER(has_hash_reduce,T,hash_reduce(declval<const T&>()))
+
+template<class T> static inline typename enable_if<has_hash_reduce<T>,bool>::type value_hash(const T& x, int& h) {
+  h = hash(x);
+  return true;
+}
+
+template<class T> static inline typename disable_if<has_hash_reduce<T>,bool>::type value_hash(const T& x, int& h) {
+  return false;
+}
+
 template<class T> class GEODE_CORE_CLASS_EXPORT Value : public ValueBase
 {
   static_assert(!is_const<T>::value,"T can't be const");
@@ -185,6 +230,10 @@ public:
     return typeid(T);
   }
 
+  bool peek_hash(int& hash) const {
+    return !dirty_ && !error && value_hash(*static_cast<const T*>(static_cast<const void*>(&buffer)),hash);
+  }
+
   // Look at a value without adding a dependency graph node
   const T& peek() const {
     GEODE_ASSERT(!dirty_);
@@ -6,6 +6,7 @@ void wrap_value() {
   GEODE_WRAP(prop)
   GEODE_WRAP(prop_manager)
   GEODE_WRAP(compute)
+  GEODE_WRAP(async_compute)
   GEODE_WRAP(listen)
   GEODE_WRAP(const_value)
 }
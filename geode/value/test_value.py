@@ -76,6 +76,26 @@ def test_compute():
   assert Test.__name__ == a.name
   assert b.name == "test2"
 
+def test_pull_parallel():
+  n = Prop('n',2)
+  total = parallel_cache_test(n,10)
+  def f():
+    return total()+1
+  x = cache(f) # Python caches are pulled serially
+  for k in 2,3:
+    n.set(k)
+    assert x.dirty() and total.dirty()
+    pull_parallel([x,total])
+    assert not x.dirty() and not total.dirty()
+    assert total()==45*k
+    assert x()==45*k+1
+
+def test_memo_cache():
+  memo_cache_test()
+
+def test_async_cache():
+  async_cache_test()
+
 def test_cycle():
   def f():
     return x()
@@ -176,6 +196,30 @@ def test_prop_manager():
   except:
     pass
 
+def test_prop_batch():
+  pm = PropManager()
+  a = pm.add('a',1)
+  b = pm.add('b',2)
+  counts = [0,0]
+  def f():
+    counts[0] += 1
+  listener = batch_listen([a,b],f)
+  def g():
+    counts[1] += 1
+    return a()+b()
+  s = cache(g)
+  assert s()==3
+  with pm:
+    a.set(3)
+    b.set(4)
+    assert counts==[0,1] and not s.dirty()
+  assert counts==[1,1] and s.dirty()
+  assert s()==7
+  a.set(5)
+  b.set(6)
+  assert counts==[3,2]
+  assert s()==11
+
 if __name__=='__main__':
   test_prop()
   test_compute()
@@ -184,3 +228,4 @@ if __name__=='__main__':
   test_exception()
   test_diamond()
   test_prop_manager()
+  test_prop_batch()
@@ -0,0 +1,198 @@
+//#####################################################################
+// Class SoAArray
+//#####################################################################
+//
+// Structure of arrays storage for an array of Vector<T,d>.
+//
+// Array<Vector<T,3>> interleaves coordinates, so a loop applying the same
+// operation to every element has to shuffle them into vector registers.
+// SoAArray stores each coordinate contiguously, so kernels such as frame
+// transforms, dots and cross products vectorize directly across elements.
+//
+// Public interfaces stay Array<Vector<T,d>>: convert to SoAArray once,
+// run several kernels, and convert back.  Conversions are a parallel
+// transpose, so a single kernel on data that starts and ends as AoS is no
+// faster than the AoS loop.  Each coordinate is a separate memory stream,
+// so kernels reading many arrays (cross reads six) can lose to AoS once
+// the data no longer fits in cache; in place transforms win at any size.
+//
+//#####################################################################
+#pragma once
+
+#include <geode/array/Array2d.h>
+#include <geode/vector/Frame.h>
+#include <geode/vector/Matrix.h>
+#include <geode/utility/parallel.h>
+namespace geode {
+
+template<class T,int d> class SoAArray {
+public:
+  typedef Vector<T,d> TV;
+
+  Array<T,2> data; // Coordinate a of element i is data(a,i)
+
+  SoAArray()
+    : data(d,0) {}
+
+  explicit SoAArray(const int n)
+    : data(d,n) {}
+
+  SoAArray(const int n, Uninit)
+    : data(d,n,uninit) {}
+
+  explicit SoAArray(RawArray<const TV> X)
+    : data(d,X.size(),uninit) {
+    const RawArray<T,2> y = data;
+    blocks(X.size(),[=](const int lo, const int hi) {
+      for (int a=0;a<d;a++) {
+        T* const x = y[a].data();
+        for (int i=lo;i<hi;i++)
+          x[i] = X[i][a];
+      }
+    });
+  }
+
+  int size() const {
+    return data.n;
+  }
+
+  // Coordinate a of every element
+  RawArray<T> operator[](const int a) const {
+    return data[a];
+  }
+
+  TV operator()(const int i) const {
+    TV x;
+    for (int a=0;a<d;a++)
+      x[a] = data(a,i);
+    return x;
+  }
+
+  void set(const int i, const TV& x) const {
+    for (int a=0;a<d;a++)
+      data(a,i) = x[a];
+  }
+
+  // Write all elements back into interleaved storage
+  void get(RawArray<TV> X) const {
+    GEODE_ASSERT(X.size()==size());
+    const RawArray<const T,2> y = data;
+    blocks(size(),[=](const int lo, const int hi) {
+      for (int a=0;a<d;a++) {
+        const T* const x = y[a].data();
+        for (int i=lo;i<hi;i++)
+          X[i][a] = x[i];
+      }
+    });
+  }
+
+  Array<TV> aos() const {
+    Array<TV> X(size(),uninit);
+    get(X);
+    return X;
+  }
+
+  // The start of each coordinate
+  Vector<T*,d> pointers() const {
+    Vector<T*,d> p;
+    for (int a=0;a<d;a++)
+      p[a] = data[a].data();
+    return p;
+  }
+
+  // Call f(lo,hi) on consecutive blocks of [0,n), in parallel
+  template<class F> static void blocks(const int n, const F& f) {
+    const int block = 4096;
+    parallel_for((n+block-1)/block,[&](const int b) {
+      f(block*b,min(n,block*(b+1)));
+    });
+  }
+};
+
+// Y = A*X+t for each element.  Y may be X.
+template<class T,int d> void affine(const Matrix<T,d>& A, const Vector<T,d>& t, const SoAArray<T,d>& X,
+                                    const SoAArray<T,d>& Y) {
+  GEODE_ASSERT(X.size()==Y.size());
+  const auto x = X.pointers();
+  const auto y = Y.pointers();
+  SoAArray<T,d>::blocks(X.size(),[=](const int lo, const int hi) {
+    GEODE_IVDEP
+    for (int i=lo;i<hi;i++) {
+      Vector<T,d> xi;
+      for (int b=0;b<d;b++)
+        xi[b] = x[b][i];
+      for (int a=0;a<d;a++) {
+        T ya = t[a];
+        for (int b=0;b<d;b++)
+          ya += A(a,b)*xi[b];
+        y[a][i] = ya;
+      }
+    }
+  });
+}
+
+// Y = f*X for each element.  Y may be X.
+template<class T,int d> void transform(const Frame<Vector<T,d>>& f, const SoAArray<T,d>& X, const SoAArray<T,d>& Y) {
+  affine(f.r.matrix(),f.t,X,Y);
+}
+
+template<class T,int d> SoAArray<T,d> operator*(const Matrix<T,d>& A, const SoAArray<T,d>& X) {
+  SoAArray<T,d> Y(X.size(),uninit);
+  affine(A,Vector<T,d>(),X,Y);
+  return Y;
+}
+
+template<class T,int d> SoAArray<T,d> operator*(const Rotation<Vector<T,d>>& r, const SoAArray<T,d>& X) {
+  return r.matrix()*X;
+}
+
+template<class T,int d> SoAArray<T,d> operator*(const Frame<Vector<T,d>>& f, const SoAArray<T,d>& X) {
+  SoAArray<T,d> Y(X.size(),uninit);
+  transform(f,X,Y);
+  return Y;
+}
+
+// Elementwise dot products
+template<class T,int d> void dots(const SoAArray<T,d>& X, const SoAArray<T,d>& Y, RawArray<T> r) {
+  GEODE_ASSERT(X.size()==Y.size() && X.size()==r.size());
+  const auto x = X.pointers(), y = Y.pointers();
+  T* const rd = r.data();
+  SoAArray<T,d>::blocks(X.size(),[=](const int lo, const int hi) {
+    GEODE_IVDEP
+    for (int i=lo;i<hi;i++) {
+      T s = 0;
+      for (int a=0;a<d;a++)
+        s += x[a][i]*y[a][i];
+      rd[i] = s;
+    }
+  });
+}
+
+template<class T,int d> Array<T> dots(const SoAArray<T,d>& X, const SoAArray<T,d>& Y) {
+  Array<T> r(X.size(),uninit);
+  dots(X,Y,r.raw());
+  return r;
+}
+
+// Elementwise cross products.  Z must not alias X or Y.
+template<class T> void cross(const SoAArray<T,3>& X, const SoAArray<T,3>& Y, const SoAArray<T,3>& Z) {
+  GEODE_ASSERT(X.size()==Y.size() && X.size()==Z.size());
+  const auto x = X.pointers(), y = Y.pointers();
+  const auto z = Z.pointers();
+  SoAArray<T,3>::blocks(X.size(),[=](const int lo, const int hi) {
+    GEODE_IVDEP
+    for (int i=lo;i<hi;i++) {
+      z[0][i] = x[1][i]*y[2][i]-x[2][i]*y[1][i];
+      z[1][i] = x[2][i]*y[0][i]-x[0][i]*y[2][i];
+      z[2][i] = x[0][i]*y[1][i]-x[1][i]*y[0][i];
+    }
+  });
+}
+
+template<class T> SoAArray<T,3> cross(const SoAArray<T,3>& X, const SoAArray<T,3>& Y) {
+  SoAArray<T,3> Z(X.size(),uninit);
+  cross(X,Y,Z);
+  return Z;
+}
+
+}
@@ -10,6 +10,7 @@
 #include <geode/vector/SymmetricMatrix.h>
 #include <geode/geometry/Box.h>
 #include <geode/utility/const_cast.h>
+#include <geode/utility/parallel.h>
 namespace geode {
 
 typedef real T;
@@ -21,6 +22,8 @@ template<> GEODE_DEFINE_TYPE(SolidMatrix<Vector<T,2>>)
 template<> GEODE_DEFINE_TYPE(SolidMatrix<Vector<T,3>>)
 template<> GEODE_DEFINE_TYPE(SolidDiagonalMatrix<Vector<T,2>>)
 template<> GEODE_DEFINE_TYPE(SolidDiagonalMatrix<Vector<T,3>>)
+template<> GEODE_DEFINE_TYPE(SolidFloatMatrix<Vector<T,2>>)
+template<> GEODE_DEFINE_TYPE(SolidFloatMatrix<Vector<T,3>>)
 
 SolidMatrixStructure::
 SolidMatrixStructure(int n)
@@ -85,6 +88,20 @@ SolidMatrix(const SolidMatrixStructure& structure)
   }
   const_cast_(this->sparse_j) = sparse_j;
 
+  // Locate the strictly upper entries by column, so that multiply can gather by row
+  lengths.fill(0);
+  for (const int j : sparse_j.flat)
+    lengths[j]++;
+  for (int i=0;i<sparse_j.size();i++)
+    lengths[i]--;
+  Nested<Vector<int,2>> lower(lengths,uninit);
+  for (int i=sparse_j.size()-1;i>=0;i--)
+    for (int k=sparse_j.size(i)-1;k>=1;k--) {
+      const int j = sparse_j(i,k);
+      lower.flat[lower.offsets[j]+--lengths[j]] = vec(i,sparse_j.offsets[i]+k);
+    }
+  this->lower = lower;
+
   // Allocate outers
   const_cast_(outers).resize(structure.outers.size());
   for (int o=0;o<(int)outers.size();o++) {
@@ -100,7 +117,8 @@ SolidMatrix(const SolidMatrix& A)
   : Base(A.size())
   , sparse_j(A.sparse_j)
   , sparse_A(A.sparse_A.copy())
-  , next_outer(A.next_outer) {
+  , next_outer(A.next_outer)
+  , lower(A.lower) {
   for (const auto& outer : A.outers)
     const_cast_(outers).push_back(tuple(outer.x,outer.y,outer.z.copy()));
 }
@@ -128,13 +146,21 @@ zero() {
 template<class TV> inline int SolidMatrix<TV>::
 find_entry(int i,int j) const {
   assert(i<=j);
+  // Rows are sorted, with the diagonal first
   RawArray<const int> row_j = sparse_j[i];
-  for (int k=0;k<row_j.size();k++)
-    if (row_j[k]==j)
-      return k;
+  const int k = int(std::lower_bound(row_j.begin(),row_j.end(),j)-row_j.begin());
+  if (k<row_j.size() && row_j[k]==j)
+    return k;
   throw KeyError(format("SolidMatrix::find_entry: index (%d,%d) doesn't exist",i,j));
 }
 
+template<class TV> int SolidMatrix<TV>::
+slot(int i,int j) const {
+  GEODE_ASSERT(unsigned(i)<unsigned(this->size()) && unsigned(j)<unsigned(this->size()));
+  if (i>j) swap(i,j);
+  return sparse_j.offsets[i]+find_entry(i,j);
+}
+
 template<class TV> void SolidMatrix<TV>::
 add_entry(int i,int j,const Matrix<T,d>& a) {
   if (i<=j)
@@ -226,64 +252,79 @@ entries() const {
   return tuple(J,I,C);
 }
 
-template<class TV> void SolidMatrix<TV>::
-add_multiply_outers(RawArray<const TV> x, RawArray<TV> y) const {
-  GEODE_ASSERT(valid() && x.size()==this->size() && y.size()==this->size());
-  for (int o=0;o<(int)outers.size();o++) {
+// y += sum_o U_o B_o U_o^T x
+template<class TV> static void
+multiply_outers(const std::vector<Tuple<Array<const int>,typename TV::Scalar,Array<TV>>>& outers,
+                RawArray<const TV> x, RawArray<TV> y) {
+  // Outers may share nodes, so compute their projections in parallel and scatter them in order
+  Array<T> sums(outers.size(),uninit);
+  parallel_for(sums.size(),[&](const int o) {
     RawArray<const int> nodes = outers[o].x;
-    T B = outers[o].y;
-    if (!B)
-      continue;
     RawArray<const TV> U = outers[o].z;
     T sum = 0;
+    if (outers[o].y)
+      for (int a=0;a<nodes.size();a++)
+        sum += dot(U[a],x[nodes[a]]);
+    sums[o] = outers[o].y*sum;
+  });
+  for (int o=0;o<(int)outers.size();o++) {
+    if (!outers[o].y)
+      continue;
+    RawArray<const int> nodes = outers[o].x;
+    RawArray<const TV> U = outers[o].z;
     for (int a=0;a<nodes.size();a++)
-      sum += dot(U[a],x[nodes[a]]);
-    sum *= B;
-    for (int a=0;a<nodes.size();a++)
-      y[nodes[a]] += sum*U[a];
+      y[nodes[a]] += sums[o]*U[a];
   }
 }
 
+template<class TV> void SolidMatrix<TV>::
+add_multiply_outers(RawArray<const TV> x, RawArray<TV> y) const {
+  GEODE_ASSERT(valid() && x.size()==this->size() && y.size()==this->size());
+  multiply_outers(outers,x,y);
+}
+
 template<class TV> void SolidMatrix<TV>::
 multiply(RawArray<const TV> x, RawArray<TV> y) const {
-  y.zero();
+  GEODE_ASSERT(valid() && x.size()==this->size() && y.size()==this->size());
+  // Each row gathers its stored upper entries and the transposed lower ones, so rows are independent
+  parallel_for(sparse_j.size(),[&](const int i) {
+    RawArray<const int> J = sparse_j[i];
+    TV yi = assume_symmetric(sparse_A(i,0))*x[i];
+    for (int k=1;k<J.size();k++)
+      yi += sparse_A(i,k)*x[J[k]];
+    for (const auto& ik : lower[i])
+      yi += sparse_A.flat[ik.y].transpose_times(x[ik.x]);
+    y[i] = yi;
+  },256);
   add_multiply_outers(x,y);
-  for (int i=0;i<sparse_j.size();i++) {
-    y[i] += assume_symmetric(sparse_A(i,0))*x[i];
-    for (int k=1;k<sparse_j.size(i);k++) {
-      int j = sparse_j(i,k);
-      const Matrix<T,d>& A = sparse_A(i,k);
-      y[i] += A*x[j];
-      y[j] += A.transpose_times(x[i]);
-    }
-  }
 }
 
 template<class TV> typename TV::Scalar SolidMatrix<TV>::
 inner_product(RawArray<const TV> x, RawArray<const TV> y) const {
   GEODE_ASSERT(valid() && x.size()==this->size() && y.size()==this->size());
-  T sum = 0;
-  for (int i=0;i<sparse_j.size();i++) {
-    sum += dot(x[i],assume_symmetric(sparse_A(i,0))*y[i]);
+  // Rows and outers are reduced deterministically, so the result doesn't depend on the thread count
+  T sum = parallel_reduce<T>(sparse_j.size(),[&](const int i) {
+    T row = dot(x[i],assume_symmetric(sparse_A(i,0))*y[i]);
     for (int k=1;k<sparse_j.size(i);k++){
       int j = sparse_j(i,k);
       const Matrix<T,d>& A = sparse_A(i,k);
-      sum += dot(x[i],A*y[j])+dot(y[i],A*x[j]);
+      row += dot(x[i],A*y[j])+dot(y[i],A*x[j]);
     }
-  }
-  for (int o=0;o<(int)outers.size();o++) {
+    return row;
+  });
+  sum += parallel_reduce<T>((int)outers.size(),[&](const int o) {
     RawArray<const int> nodes = outers[o].x;
     T B = outers[o].y;
     if (!B)
-      continue;
+      return T(0);
     RawArray<const TV> U = outers[o].z;
     T left = 0, right = 0;
     for (int a=0;a<nodes.size();a++) {
       left  += dot(U[a],x[nodes[a]]);
       right += dot(U[a],y[nodes[a]]);
     }
-    sum += B*dot(left,right);
-  }
+    return B*dot(left,right);
+  },1);
   return sum;
 }
 
@@ -339,6 +380,49 @@ inverse_block_diagonal() const {
   return diagonal;
 }
 
+template<class TV> Ref<SolidFloatMatrix<TV>> SolidMatrix<TV>::
+single_precision() const {
+  GEODE_ASSERT(valid());
+  return new_<SolidFloatMatrix<TV>>(*this);
+}
+
+template<class TV> static Array<const Matrix<float,TV::m>> round_blocks(RawArray<const Matrix<typename TV::Scalar,TV::m>> A) {
+  Array<Matrix<float,TV::m>> F(A.size(),uninit);
+  parallel_for(A.size(),[&](const int k) { F[k] = Matrix<float,TV::m>(A[k]); },1024);
+  return F;
+}
+
+template<class TV> SolidFloatMatrix<TV>::
+SolidFloatMatrix(const SolidMatrix<TV>& A)
+  : Base(A.size())
+  , sparse_j(A.sparse_j)
+  , sparse_A(round_blocks<TV>(A.sparse_A.flat))
+  , lower(A.lower) {
+  for (const auto& outer : A.outers)
+    const_cast_(outers).push_back(tuple(outer.x,outer.y,outer.z.copy()));
+}
+
+template<class TV> SolidFloatMatrix<TV>::
+~SolidFloatMatrix() {}
+
+template<class TV> void SolidFloatMatrix<TV>::
+multiply(RawArray<const TV> x, RawArray<TV> y) const {
+  GEODE_ASSERT(x.size()==this->size() && y.size()==this->size());
+  // Same row gather as SolidMatrix::multiply, widening each block to double as it is loaded
+  typedef Matrix<T,d> TMatrix;
+  parallel_for(sparse_j.size(),[&](const int i) {
+    const int start = sparse_j.offsets[i];
+    RawArray<const int> J = sparse_j[i];
+    TV yi = assume_symmetric(TMatrix(sparse_A[start]))*x[i];
+    for (int k=1;k<J.size();k++)
+      yi += TMatrix(sparse_A[start+k])*x[J[k]];
+    for (const auto& ik : lower[i])
+      yi += TMatrix(sparse_A[ik.y]).transpose_times(x[ik.x]);
+    y[i] = yi;
+  },256);
+  multiply_outers(outers,x,y);
+}
+
 template<class TV> SolidDiagonalMatrix<TV>::
 SolidDiagonalMatrix(const int size)
   : Base(size), A(size) {}
@@ -358,10 +442,7 @@ multiply(RawArray<const TV> x,RawArray<TV> y) const {
 
 template<class TV> typename TV::Scalar SolidDiagonalMatrix<TV>::
 inner_product(RawArray<const TV> x,RawArray<const TV> y) const {
-  T sum = 0;
-  for (int i=0;i<A.size();i++)
-    sum += dot(x[i],A[i]*y[i]);
-  return sum;
+  return parallel_reduce<T>(A.size(),[&](const int i) { return dot(x[i],A[i]*y[i]); },1024);
 }
 
 template class SolidMatrixBase<Vector<T,2>>;
@@ -370,6 +451,8 @@ template class SolidMatrix<Vector<T,2>>;
 template class SolidMatrix<Vector<T,3>>;
 template class SolidDiagonalMatrix<Vector<T,2>>;
 template class SolidDiagonalMatrix<Vector<T,3>>;
+template class SolidFloatMatrix<Vector<T,2>>;
+template class SolidFloatMatrix<Vector<T,3>>;
 
 }
 using namespace geode;
@@ -394,6 +477,7 @@ template<int d> static void wrap_helper() {
     .GEODE_METHOD(add_outer)
     .GEODE_METHOD(entries)
     .GEODE_METHOD(inverse_block_diagonal)
+    .GEODE_METHOD(single_precision)
     .GEODE_METHOD(inner_product)
     .GEODE_METHOD(diagonal_range)
     .GEODE_METHOD(dense)
@@ -403,6 +487,10 @@ template<int d> static void wrap_helper() {
   Class<Self>(d==2?"SolidDiagonalMatrix2d":"SolidDiagonalMatrix3d")
     .GEODE_METHOD(inner_product)
     ;}
+
+  {typedef SolidFloatMatrix<Vector<T,d>> Self;
+  Class<Self>(d==2?"SolidFloatMatrix2d":"SolidFloatMatrix3d")
+    ;}
 }
 
 void wrap_solid_matrix() {
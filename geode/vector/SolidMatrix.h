@@ -84,7 +84,9 @@ public:
   const Nested<TMatrix> sparse_A;
   const std::vector<Tuple<Array<const int>,T,Array<TV> > > outers; // restricted to m==1 for now
 private:
+  template<class> friend class SolidFloatMatrix;
   int next_outer;
+  Nested<const Vector<int,2>> lower; // For each row j, (i,k) for the strictly upper entries sparse_A.flat[k] in column j of row i
 
   GEODE_CORE_EXPORT SolidMatrix(const SolidMatrixStructure& structure);
   GEODE_CORE_EXPORT SolidMatrix(const SolidMatrix& A);
@@ -108,6 +110,14 @@ public:
   void add_entry(int i,T a)
   {sparse_A(i,0) += a;}
 
+  // Index into sparse_A.flat of the stored entry for (i,j) or (j,i).  Slots are valid for every matrix sharing
+  // sparse_j, including copies, so forces assembling into the same matrix each step need only look them up once.
+  GEODE_CORE_EXPORT int slot(int i,int j) const;
+
+  // Add a to entry (i,j) given its slot
+  void add_entry(int slot,int i,int j,const Matrix<T,d>& a)
+  {sparse_A.flat[slot] += i<=j ? a : a.transposed();}
+
   // Must be called in exactly the same order as on the structure
   GEODE_CORE_EXPORT void add_outer(T B,RawArray<const TV> U);
 
@@ -121,6 +131,7 @@ public:
   GEODE_CORE_EXPORT void multiply(RawArray<const TV> x,RawArray<TV> y) const ;
   GEODE_CORE_EXPORT T inner_product(RawArray<const TV> x,RawArray<const TV> y) const ;
   Ref<SolidDiagonalMatrix<TV> > inverse_block_diagonal() const;
+  GEODE_CORE_EXPORT Ref<SolidFloatMatrix<TV>> single_precision() const;
   GEODE_CORE_EXPORT Box<T> diagonal_range() const ;
   Array<T,2> dense() const;
 
@@ -129,6 +140,26 @@ private:
   int find_entry(int i,int j) const;
 };
 
+// Slots for a fixed sequence of entries, cached against the sparsity pattern they were computed for
+class SolidMatrixSlots {
+  Nested<const int> pattern; // Held so that its buffers can't be reused by a different pattern
+public:
+  Array<const int> slots;
+
+  // Whether slots were computed for A's pattern
+  template<class TV> bool valid(const SolidMatrix<TV>& A) const {
+    return pattern.flat.data()==A.sparse_j.flat.data() && pattern.offsets.data()==A.sparse_j.offsets.data();
+  }
+
+  template<class TV> void compute(const SolidMatrix<TV>& A, RawArray<const Vector<int,2>> entries) {
+    Array<int> slots(entries.size(),uninit);
+    for (int e=0;e<entries.size();e++)
+      slots[e] = A.slot(entries[e].x,entries[e].y);
+    this->slots = slots;
+    pattern = A.sparse_j;
+  }
+};
+
 template<class TV> class SolidDiagonalMatrix : public SolidMatrixBase<TV> {
   typedef typename TV::Scalar T;
   enum {d=TV::m};
@@ -149,4 +180,28 @@ public:
   GEODE_CORE_EXPORT T inner_product(RawArray<const TV> x,RawArray<const TV> y) const ;
 };
 
+// A snapshot of a SolidMatrix with its sparse blocks rounded to float, for mixed precision solves.  multiply reads
+// half as many bytes of blocks as SolidMatrix::multiply, but vectors and sums stay in double.  Outers are small, so
+// they are copied exactly.  The snapshot shares the sparsity pattern of its source but not its values.
+template<class TV> class SolidFloatMatrix : public SolidMatrixBase<TV> {
+  typedef typename TV::Scalar T;
+  enum {d=TV::m};
+public:
+  GEODE_DECLARE_TYPE(GEODE_CORE_EXPORT)
+  typedef SolidMatrixBase<TV> Base;
+
+  const Nested<const int> sparse_j;
+  const Array<const Matrix<float,d>> sparse_A; // Parallel to sparse_j.flat
+  const std::vector<Tuple<Array<const int>,T,Array<TV> > > outers;
+private:
+  Nested<const Vector<int,2>> lower; // Shared with the source matrix
+
+protected:
+  GEODE_CORE_EXPORT SolidFloatMatrix(const SolidMatrix<TV>& A);
+public:
+  GEODE_CORE_EXPORT ~SolidFloatMatrix();
+
+  GEODE_CORE_EXPORT void multiply(RawArray<const TV> x,RawArray<TV> y) const ;
+};
+
 }
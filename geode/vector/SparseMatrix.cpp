@@ -10,6 +10,7 @@
 #include <geode/structure/Hashtable.h>
 #include <geode/utility/Log.h>
 #include <geode/utility/const_cast.h>
+#include <geode/utility/parallel.h>
 namespace geode {
 
 typedef real T;
@@ -18,8 +19,8 @@ GEODE_DEFINE_TYPE(SparseMatrix)
 static void
 sort_rows(SparseMatrix& self)
 {
-    // Use insertion sort since we expect rows to be small
-    for(int i=0;i<self.rows();i++){
+    // Use insertion sort since we expect rows to be small, and sort rows in parallel
+    parallel_for(self.rows(),[&](const int i){
         RawArray<int> J = self.J[i].const_cast_();
         RawArray<T> A = self.A[i];
         for(int a=1;a<J.size();a++){
@@ -30,7 +31,7 @@ sort_rows(SparseMatrix& self)
                 J[b+1]=J[b];
                 A[b+1]=A[b];}
             J[b+1]=ja;
-            A[b+1]=aa;}}
+            A[b+1]=aa;}},256);
 }
 
 SparseMatrix::
@@ -81,8 +82,9 @@ SparseMatrix::SparseMatrix(const Hashtable<Vector<int,2>,T>& entries, const Vect
   sort_rows(*this);
 }
 
-SparseMatrix::SparseMatrix(Nested<const int> J, Nested<T> A, Array<const int> diagonal_index, const bool cholesky, Private)
-  : J(J), A(A), cholesky(cholesky), diagonal_index(diagonal_index) {}
+SparseMatrix::SparseMatrix(Nested<const int> J, Nested<T> A, Array<const int> diagonal_index, Nested<const int> forward_levels, Nested<const int> backward_levels, Private)
+  : J(J), A(A), columns_(J.size()), cholesky(true), diagonal_index(diagonal_index)
+  , forward_levels(forward_levels), backward_levels(backward_levels) {}
 
 SparseMatrix::~SparseMatrix() {}
 
@@ -116,6 +118,7 @@ multiply_helper(RawArray<const TV> x,RawArray<TV> result) const
     RawArray<const int> offsets = J.offsets;
     RawArray<const int> J_flat = J.flat;
     RawArray<const T> A_flat = A.flat;
+    #pragma omp parallel for schedule(static,1024)
     for(int i=0;i<rows;i++){
         int end=offsets[i+1];TV sum=TV();
         for(int index=offsets[i];index<end;index++) sum+=A_flat[index]*x[J_flat[index]];
@@ -127,6 +130,39 @@ template void SparseMatrix::multiply_helper(RawArray<const T>,RawArray<T>) const
 template void SparseMatrix::multiply_helper(RawArray<const Vector<T,2> >,RawArray<Vector<T,2> >) const;
 template void SparseMatrix::multiply_helper(RawArray<const Vector<T,3> >,RawArray<Vector<T,3> >) const;
 
+Ref<SparseMatrix> SparseMatrix::
+times(const SparseMatrix& B) const
+{
+    GEODE_ASSERT(columns()==B.rows());
+    // Accumulate each row of the product densely, remembering which columns were touched
+    Array<int> lengths(rows());
+    Array<int> marker(B.columns(),uninit);
+    marker.fill(-1);
+    Array<int> touched;
+    Array<int> J_flat;
+    Array<T> A_flat;
+    Array<T> row(B.columns());
+    for(int i=0;i<rows();i++){
+        touched.clear();
+        for(int a=0;a<J.size(i);a++){
+            const int k=J(i,a);
+            const T Aik=A(i,a);
+            for(int b=0;b<B.J.size(k);b++){
+                const int j=B.J(k,b);
+                if(marker[j]!=i){
+                    marker[j]=i;
+                    touched.append(j);}
+                row[j]+=Aik*B.A(k,b);}}
+        lengths[i]=touched.size();
+        for(const int j : touched){
+            J_flat.append(j);
+            A_flat.append(row[j]);
+            row[j]=0;}}
+    auto product = new_<SparseMatrix>(Nested<int>(nested_array_offsets(lengths),J_flat),A_flat);
+    product->columns_ = B.columns();
+    return product;
+}
+
 void SparseMatrix::
 multiply_python(NdArray<const T> x,NdArray<T> result) const {
   GEODE_ASSERT(x.shape==result.shape);
@@ -168,16 +204,50 @@ positive_diagonal_and_nonnegative_row_sum(const T tolerance) const
     return result;
 }
 
+// Group rows into levels such that each row depends only on rows in earlier levels.  Row i depends on the columns of
+// entries [begin(i),end(i)), which must all be earlier in the given order.
+template<class Begin,class End> static Nested<const int>
+dependency_levels(const SparseMatrix& M,const bool backward,const Begin& begin,const End& end)
+{
+    const int n=M.rows();
+    Array<int> level(n,uninit);
+    int levels=0;
+    for(int k=0;k<n;k++){
+        const int i=backward?n-1-k:k;
+        int l=0;
+        for(int index=begin(i);index<end(i);index++)
+            l=max(l,level[M.J.flat[index]]+1);
+        level[i]=l;
+        levels=max(levels,l+1);}
+    Array<int> counts(levels);
+    for(int i=0;i<n;i++) counts[level[i]]++;
+    Nested<int> rows(counts,uninit);
+    for(int i=n-1;i>=0;i--) rows.flat[rows.offsets[level[i]]+--counts[level[i]]]=i;
+    return rows;
+}
+
+// Rows within a level are independent.  Levels are often small near the ends, so we skip the parallel machinery there.
+template<class F> static void
+for_each_level(const Nested<const int>& levels,const F& f)
+{
+    for(int l=0;l<levels.size();l++){
+        RawArray<const int> rows=levels[l];
+        if(rows.size()<=256)
+            for(const int i : rows) f(i);
+        else
+            parallel_for(rows.size(),[&](const int k){f(rows[k]);},256);}
+}
+
 void SparseMatrix::
 solve_forward_substitution(RawArray<const T> b,RawArray<T> x) const
 {
     GEODE_ASSERT(cholesky && rows()<=x.size() && rows()<=b.size());
     // The result of Incomplete_Cholesky_Factorization has unit diagonals in the lower triangle.
-    for(int i=0;i<rows();i++){
+    for_each_level(forward_levels,[&](const int i){
         T sum=0;
         for(int index=J.offsets[i];index<diagonal_index[i];index++)
             sum+=A.flat[index]*x[J.flat[index]];
-        x[i]=b[i]-sum;}
+        x[i]=b[i]-sum;});
 }
 
 void SparseMatrix::
@@ -185,11 +255,11 @@ solve_backward_substitution(RawArray<const T> b,RawArray<T> x) const
 {
     GEODE_ASSERT(cholesky && rows()<=x.size() && rows()<=b.size());
     // The result of Incomplete_Cholesky_Factorization has an inverted diagonal for the upper triangle.
-    for(int i=rows()-1;i>=0;i--){
+    for_each_level(backward_levels,[&](const int i){
         T sum=0;
         for(int index=diagonal_index[i]+1;index<J.offsets[i+1];index++)
             sum+=A.flat[index]*x[J.flat[index]];
-        x[i]=(b[i]-sum)*A.flat[diagonal_index[i]];}
+        x[i]=(b[i]-sum)*A.flat[diagonal_index[i]];});
 }
 
 void SparseMatrix::
@@ -226,7 +296,9 @@ incomplete_cholesky_factorization(const T modified_coefficient,const T zero_tole
         if(i==rows()-1 && denominator<=zero_tolerance) denominator=zero_tolerance; // ensure last diagonal element is not zero
         C[row_diagonal_index]=1/denominator;} // finally, store the diagonal element in inverted form
 
-    return new_<SparseMatrix>(J,Nested<T>::reshape_like(C,J),diagonal_index,true,Private());
+    const auto forward=dependency_levels(*this,false,[&](const int i){return J.offsets[i];},[&](const int i){return diagonal_index[i];}),
+               backward=dependency_levels(*this,true,[&](const int i){return diagonal_index[i]+1;},[&](const int i){return J.offsets[i+1];});
+    return new_<SparseMatrix>(J,Nested<T>::reshape_like(C,J),diagonal_index,forward,backward,Private());
 }
 
 void SparseMatrix::
@@ -241,12 +313,66 @@ gauss_seidel_solve(RawArray<T> x,RawArray<const T> b,const T tolerance,const int
             for(int index=J.offsets[i];index<J.offsets[i+1];index++){
                 if(J.flat[index]==i) diagonal_entry=A.flat[index];
                 else rho+=A.flat[index]*x[J.flat[index]];}
-            T new_x=x[i]=(b[i]-rho)/diagonal_entry;
+            T new_x=(b[i]-rho)/diagonal_entry;
             sqr_residual+=sqr(new_x-x[i]);
             x[i]=new_x;}
         if(sqr_residual <= sqr_tolerance) break;}
 }
 
+Nested<const int> SparseMatrix::
+row_colors() const
+{
+    GEODE_ASSERT(rows()==columns());
+    // Rows i and j conflict if either reads the other, so collect both directions
+    const int n=rows();
+    Array<int> counts(n);
+    for(int i=0;i<n;i++) for(const int j : J[i]) if(j!=i){counts[i]++;counts[j]++;}
+    Nested<int> neighbors(counts,uninit);
+    for(int i=n-1;i>=0;i--) for(const int j : J[i]) if(j!=i){
+        neighbors.flat[neighbors.offsets[i]+--counts[i]]=j;
+        neighbors.flat[neighbors.offsets[j]+--counts[j]]=i;}
+
+    // Greedily give each row the smallest color not used by a neighbor
+    Array<int> color(n,uninit),mark;
+    int colors=0;
+    for(int i=0;i<n;i++){
+        for(const int j : neighbors[i]) if(j<i){
+            if(mark.size()<=color[j]) mark.resize(color[j]+1);
+            mark[color[j]]=i+1;}
+        int c=0;
+        while(c<mark.size() && mark[c]==i+1) c++;
+        color[i]=c;
+        colors=max(colors,c+1);}
+    Array<int> sizes(colors);
+    for(int i=0;i<n;i++) sizes[color[i]]++;
+    Nested<int> result(sizes,uninit);
+    for(int i=n-1;i>=0;i--) result.flat[result.offsets[color[i]]+--sizes[color[i]]]=i;
+    return result;
+}
+
+void SparseMatrix::
+multicolor_gauss_seidel_solve(RawArray<T> x,RawArray<const T> b,const T tolerance,const int max_iterations) const
+{
+    GEODE_ASSERT(rows()==columns() && x.size()==rows() && b.size()==rows());
+    const auto colors=row_colors();
+    const T sqr_tolerance=sqr(tolerance);
+    for(int iteration=0;iteration<max_iterations;iteration++){
+        T sqr_residual=0;
+        for(int c=0;c<colors.size();c++){
+            RawArray<const int> rows=colors[c];
+            sqr_residual+=parallel_reduce<T>(rows.size(),[&](const int k){
+                const int i=rows[k];
+                T rho=0;T diagonal_entry=0;
+                for(int index=J.offsets[i];index<J.offsets[i+1];index++){
+                    if(J.flat[index]==i) diagonal_entry=A.flat[index];
+                    else rho+=A.flat[index]*x[J.flat[index]];}
+                const T new_x=(b[i]-rho)/diagonal_entry,
+                        change=sqr(new_x-x[i]);
+                x[i]=new_x;
+                return change;},256);}
+        if(sqr_residual <= sqr_tolerance) break;}
+}
+
 std::ostream&
 operator<<(std::ostream& output,const SparseMatrix& A)
 {
@@ -269,9 +395,12 @@ void wrap_sparse_matrix()
         .GEODE_FIELD(J)
         .GEODE_FIELD(A)
         .GEODE_METHOD_2("multiply",multiply_python)
+        .GEODE_METHOD(times)
         .GEODE_METHOD(solve_forward_substitution)
         .GEODE_METHOD(solve_backward_substitution)
         .GEODE_METHOD(incomplete_cholesky_factorization)
         .GEODE_METHOD(gauss_seidel_solve)
+        .GEODE_METHOD(multicolor_gauss_seidel_solve)
+        .GEODE_METHOD(row_colors)
         ;
 }
@@ -26,11 +26,12 @@ private:
     int columns_;
     bool cholesky;
     mutable Array<const int> diagonal_index;
+    Nested<const int> forward_levels,backward_levels; // For Cholesky factors, rows grouped so that each group depends only on earlier groups
     struct Private{};
 
     GEODE_CORE_EXPORT SparseMatrix(Nested<int> J,Array<T> A); // entries in each row will be sorted
     GEODE_CORE_EXPORT SparseMatrix(const Hashtable<Vector<int,2>,T>& entries, const Vector<int,2>& sizes = (Vector<int,2>(-1,-1)));
-    SparseMatrix(Nested<const int> J, Nested<T> A, Array<const int> diagonal_index, const bool cholesky, Private);
+    SparseMatrix(Nested<const int> J, Nested<T> A, Array<const int> diagonal_index, Nested<const int> forward_levels, Nested<const int> backward_levels, Private);
 public:
     ~SparseMatrix();
 
@@ -52,12 +53,19 @@ public:
     T operator()(const int i,const int j) const;
     template<class TV> void multiply_helper(RawArray<const TV> x,RawArray<TV> result) const;
     void multiply_python(NdArray<const T> x,NdArray<T> result) const;
+    GEODE_CORE_EXPORT Ref<SparseMatrix> times(const SparseMatrix& B) const; // The matrix product this*B
     bool symmetric(const T tolerance=1e-7) const;
     bool positive_diagonal_and_nonnegative_row_sum(const T tolerance=1e-7) const;
+    // Triangular solves with an incomplete Cholesky factor.  Rows within each level are solved in parallel.
     void solve_forward_substitution(RawArray<const T> b,RawArray<T> x) const;
     void solve_backward_substitution(RawArray<const T> b,RawArray<T> x) const;
     Ref<SparseMatrix> incomplete_cholesky_factorization(const T modified_coefficient=.97,const T zero_tolerance=1e-8) const;
     void gauss_seidel_solve(RawArray<T> x,RawArray<const T> b,const T tolerance=1e-12,const int max_iterations=1000000) const;
+    // Gauss-Seidel with rows ordered by color, so that rows of one color share no entries and are updated in parallel.
+    // Converges like gauss_seidel_solve, but with a different ordering of the rows.
+    void multicolor_gauss_seidel_solve(RawArray<T> x,RawArray<const T> b,const T tolerance=1e-12,const int max_iterations=1000000) const;
+    // Rows grouped by color for multicolor_gauss_seidel_solve, computed greedily in row order
+    Nested<const int> row_colors() const;
 private:
     void initialize_diagonal_index() const;
 };
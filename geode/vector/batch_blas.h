@@ -0,0 +1,69 @@
+//#####################################################################
+// Header batch_blas
+//#####################################################################
+//
+// BLAS style operations on batches of small fixed size matrices, such as
+// the Matrix<T,3> and Matrix<T,3,2> arrays of finite element forces:
+//
+//   batch_gemm(alpha,A,B,beta,C): C[i] = alpha*A[i]*B[i] + beta*C[i]
+//   batch_gemv(alpha,A,x,beta,y): y[i] = alpha*A[i]*x[i] + beta*y[i]
+//
+// Each of A,B (or A,x) is either an array with one entry per output or a
+// single matrix or vector used for every output, the stride zero case of
+// strided batched BLAS.  Any matrix types with a product work, including
+// UpperTriangularMatrix and SymmetricMatrix, and sizes are compile time so
+// each product is fully unrolled.  As in BLAS, C is not read if beta is
+// zero, and C may alias A or B.
+//
+// Unlike blas.h, these don't call an external library: for matrices this
+// small, per element code unrolled by the compiler beats both BLAS calls and
+// structure of arrays kernels on array of structures data.  Batches run in
+// parallel.
+//
+//#####################################################################
+#pragma once
+
+#include <geode/array/Array.h>
+#include <geode/utility/parallel.h>
+#include <geode/vector/Matrix.h>
+namespace geode {
+
+// A batch operand: the ith element of an array, or the same value for all i
+template<class A> struct BatchOperand {
+  const A& a;
+  BatchOperand(const A& a) : a(a) {}
+  bool compatible(const int n) const { return true; }
+  const A& operator[](const int i) const { return a; }
+};
+
+template<class T> struct BatchOperand<RawArray<T>> {
+  const RawArray<T> a;
+  BatchOperand(RawArray<T> a) : a(a) {}
+  bool compatible(const int n) const { return a.size()==n; }
+  T& operator[](const int i) const { return a[i]; }
+};
+
+template<class T> struct BatchOperand<Array<T>> : public BatchOperand<RawArray<T>> {
+  BatchOperand(const Array<T>& a) : BatchOperand<RawArray<T>>(a) {}
+};
+
+template<class TA,class TB,class TC> void batch_gemm(const typename TC::Element::Scalar alpha, const TA& A, const TB& B,
+                                                      const typename TC::Element::Scalar beta, const TC& C) {
+  const BatchOperand<TA> a(A);
+  const BatchOperand<TB> b(B);
+  const RawArray<typename TC::Element> c(C);
+  GEODE_ASSERT(a.compatible(c.size()) && b.compatible(c.size()));
+  if (beta)
+    parallel_for(c.size(),[=](const int i) { c[i] = alpha*(a[i]*b[i])+beta*c[i]; },1024);
+  else if (alpha==1)
+    parallel_for(c.size(),[=](const int i) { c[i] = a[i]*b[i]; },1024);
+  else
+    parallel_for(c.size(),[=](const int i) { c[i] = alpha*(a[i]*b[i]); },1024);
+}
+
+template<class TA,class TX,class TY> void batch_gemv(const typename TY::Element::Scalar alpha, const TA& A, const TX& x,
+                                                     const typename TY::Element::Scalar beta, const TY& y) {
+  batch_gemm(alpha,A,x,beta,y);
+}
+
+}
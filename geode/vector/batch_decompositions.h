@@ -0,0 +1,46 @@
+//#####################################################################
+// Batched 3x3 decompositions
+//#####################################################################
+//
+// Eigen, singular value and polar decompositions of many 3x3 matrices at
+// once, for forces and geometry code which decomposes one matrix per
+// element or vertex.
+//
+// The scalar routines (fast_solve_eigenproblem, fast_singular_value_decomposition)
+// branch on each matrix and call atan2 and sincos, so they don't vectorize.
+// The batched versions load groups of matrices into structure of arrays
+// lanes and run a fixed number of branch free cyclic Jacobi sweeps, which
+// the compiler turns into SIMD code across matrices.  Groups run in
+// parallel.
+//
+// Conventions match the scalar routines: eigenvalues and singular values are
+// sorted in decreasing order, eigenvectors and singular vectors form
+// rotations, and the smallest singular value is negative if det A < 0.
+// Results differ from the scalar routines only in the signs of eigenvectors
+// and the choice of basis for repeated eigenvalues.
+//
+//#####################################################################
+#pragma once
+
+#include <geode/array/RawArray.h>
+#include <geode/vector/DiagonalMatrix3x3.h>
+#include <geode/vector/Matrix3x3.h>
+#include <geode/vector/SymmetricMatrix3x3.h>
+namespace geode {
+
+// A = V D V^T for each i, with eigenvalues decreasing and V a rotation
+template<class T> GEODE_CORE_EXPORT void
+batch_solve_eigenproblem(RawArray<const SymmetricMatrix<T,3>> A, RawArray<DiagonalMatrix<T,3>> eigenvalues,
+                         RawArray<Matrix<T,3>> eigenvectors);
+
+// A = U D V^T for each i, with U,V rotations and D decreasing in absolute value, only D.x22 possibly negative
+template<class T> GEODE_CORE_EXPORT void
+batch_singular_value_decomposition(RawArray<const Matrix<T,3>> A, RawArray<Matrix<T,3>> U,
+                                   RawArray<DiagonalMatrix<T,3>> singular_values, RawArray<Matrix<T,3>> V);
+
+// A = Q S for each i, with Q a rotation and S symmetric, as in fast_indefinite_polar_decomposition
+template<class T> GEODE_CORE_EXPORT void
+batch_indefinite_polar_decomposition(RawArray<const Matrix<T,3>> A, RawArray<Matrix<T,3>> Q,
+                                     RawArray<SymmetricMatrix<T,3>> S);
+
+}
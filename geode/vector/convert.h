@@ -12,7 +12,48 @@ namespace geode {
 #define GEODE_DEFINE_VECTOR_CONVERSIONS(EXPORT,d,...) \
   static_assert(NumpyIsStatic<__VA_ARGS__>::value,""); \
   PyObject* to_python(const Vector<__VA_ARGS__,d>& v) { return to_numpy(v); } \
-  Vector<__VA_ARGS__,d> FromPython<Vector<__VA_ARGS__,d>>::convert(PyObject* o) { return from_numpy<Vector<__VA_ARGS__,d>>(o); }
+  Vector<__VA_ARGS__,d> FromPython<Vector<__VA_ARGS__,d>>::convert(PyObject* o) { \
+    Vector<__VA_ARGS__,d> v; \
+    return vector_from_sequence(o,v) ? v : from_numpy<Vector<__VA_ARGS__,d>>(o); \
+  }
+
+// Plain Python ints and floats, converted without going through numpy.  These return false for anything else, including
+// out of range ints, so that numpy can produce the appropriate error or conversion.
+template<class T> static inline typename enable_if<is_integral<T>,bool>::type scalar_from_python(PyObject* o, T& x) {
+  if (!PyInt_CheckExact(o))
+    return false;
+  const long i = PyInt_AS_LONG(o);
+  x = T(i);
+  return long(x)==i;
+}
+
+template<class T> static inline typename enable_if<is_floating_point<T>,bool>::type
+scalar_from_python(PyObject* o, T& x) {
+  if (PyFloat_CheckExact(o))
+    x = T(PyFloat_AS_DOUBLE(o));
+  else if (PyInt_CheckExact(o))
+    x = T(PyInt_AS_LONG(o));
+  else
+    return false;
+  return true;
+}
+
+template<class T> static inline typename enable_if<mpl::not_<mpl::or_<is_integral<T>,is_floating_point<T>>>,bool>::type
+scalar_from_python(PyObject* o, T& x) {
+  return false;
+}
+
+// Tuples and lists of length d are common arguments to fine grained functions, and building a temporary numpy array for
+// each one costs far more than the call.  Returns false if numpy should handle the conversion.
+template<class T,int d> static inline bool vector_from_sequence(PyObject* o, Vector<T,d>& v) {
+  if (!(PyTuple_CheckExact(o) || PyList_CheckExact(o)) || PySequence_Fast_GET_SIZE(o)!=d)
+    return false;
+  PyObject** const items = PySequence_Fast_ITEMS(o);
+  for (int i=0;i<d;i++)
+    if (!scalar_from_python(items[i],v[i]))
+      return false;
+  return true;
+}
 
 // To python conversion for arbitrary vectors
 template<class T,int d> typename enable_if<has_to_python<T>, PyObject*>::type to_python(const Vector<T,d>& v) {
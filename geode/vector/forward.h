@@ -52,6 +52,7 @@ template<class T,int m,int n> struct is_packed_pod<Matrix<T,m,n> > : public mpl:
 class SolidMatrixStructure;
 template<class TV> class SolidMatrix;
 template<class TV> class SolidDiagonalMatrix;
+template<class TV> class SolidFloatMatrix;
 
 // Windows doesn't like function level SFINAE, so use template classes instead.
 template<int d,class TV,class Result,class D=mpl::int_<d>> struct EnableForSize;
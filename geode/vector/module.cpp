@@ -1,7 +1,11 @@
 //#####################################################################
 // Module Vectors
 //#####################################################################
+#include <geode/vector/batch_blas.h>
 #include <geode/vector/Matrix.h>
+#include <geode/vector/SoAArray.h>
+#include <geode/vector/transform.h>
+#include <geode/vector/UpperTriangularMatrix.h>
 #include <geode/vector/Vector.h>
 #include <geode/array/NdArray.h>
 #include <geode/python/wrap.h>
@@ -70,6 +74,67 @@ void vector_stream_test() {
   } catch (const ValueError&) {}
 }
 
+// Check SoAArray kernels against their AoS versions
+void soa_test(RawArray<const Vector<real,3>> X, RawArray<const Vector<real,3>> Y, const Frame<Vector<real,3>>& f) {
+  typedef Vector<real,3> TV;
+  GEODE_ASSERT(X.size()==Y.size());
+  SoAArray<real,3> SX(X), SY(Y);
+  GEODE_ASSERT(SX.aos()==X);
+  const auto FX = (f*SX).aos(),
+             C = cross(SX,SY).aos();
+  const auto D = dots(SX,SY);
+  transform(f,SX,SX);
+  for (int i=0;i<X.size();i++) {
+    GEODE_ASSERT(magnitude(FX[i]-f*X[i])<1e-10);
+    GEODE_ASSERT(SX(i)==FX[i]);
+    GEODE_ASSERT(magnitude(C[i]-cross(X[i],Y[i]))<1e-10);
+    GEODE_ASSERT(abs(D[i]-dot(X[i],Y[i]))<1e-10);
+  }
+}
+
+// Check batch transforms against per-point transforms
+template<class TV> void transform_test(Array<const TV> X, const Frame<TV>& f) {
+  const auto FX = transformed(f,X),
+             RX = transformed(f.r,X);
+  const Array<TV> Y = X.copy();
+  transform(f,Y,Y);
+  for (int i=0;i<X.size();i++) {
+    GEODE_ASSERT(magnitude(FX[i]-f*X[i])<1e-10);
+    GEODE_ASSERT(magnitude(RX[i]-f.r*X[i])<1e-10);
+    GEODE_ASSERT(Y[i]==FX[i]);
+  }
+  const Array<const int> offsets = asarray(vec(0,X.size()/3,X.size())).copy();
+  const auto P = transformed(f,Nested<const TV>(offsets,X));
+  GEODE_ASSERT(P.offsets==offsets && P.flat==FX);
+}
+
+// Check batched products against per element products, with and without broadcasting
+void batch_blas_test(Array<const Matrix<real,3>> A, Array<const Matrix<real,3>> B, Array<const Vector<real,3>> x) {
+  typedef Matrix<real,3> TM;
+  const int n = A.size();
+  GEODE_ASSERT(B.size()==n && x.size()==n && n>0);
+  const auto C = B.copy();
+  batch_gemm(2,A,B,-1,C);
+  Array<TM> D(n,uninit);
+  batch_gemm(1,A[0],B,0,D);
+  Array<Vector<real,3>> y(n,uninit);
+  batch_gemv(3,A,x,0,y);
+  const auto E = A.copy();
+  batch_gemm(1,E,A[n-1],0,E);
+  Array<Matrix<real,3,2>> G(n,uninit), H(n,uninit);
+  for (int i=0;i<n;i++)
+    G[i] = Matrix<real,3,2>(A[i].column(0),A[i].column(1));
+  const UpperTriangularMatrix<real,2> U(1,2,3);
+  batch_gemm(1,G,U,0,H);
+  for (int i=0;i<n;i++) {
+    GEODE_ASSERT((C[i]-(2.*A[i]*B[i]-B[i])).maxabs()<1e-10);
+    GEODE_ASSERT((D[i]-A[0]*B[i]).maxabs()<1e-10);
+    GEODE_ASSERT(magnitude(y[i]-3.*(A[i]*x[i]))<1e-10);
+    GEODE_ASSERT((E[i]-A[i]*A[n-1]).maxabs()<1e-10);
+    GEODE_ASSERT((H[i]-G[i]*U).maxabs()<1e-10);
+  }
+}
+
 #endif
 }
 
@@ -80,6 +145,7 @@ void wrap_vector() {
   GEODE_WRAP(sparse_matrix)
   GEODE_WRAP(solid_matrix)
   GEODE_WRAP(register)
+  GEODE_WRAP(batch_decompositions)
 
 #ifdef GEODE_PYTHON
   GEODE_FUNCTION_2(min_magnitude,min_magnitude_python)
@@ -89,5 +155,9 @@ void wrap_vector() {
   GEODE_FUNCTION(vector_test)
   GEODE_FUNCTION(matrix_test)
   GEODE_FUNCTION(vector_stream_test)
+  GEODE_FUNCTION(soa_test)
+  GEODE_FUNCTION(batch_blas_test)
+  GEODE_FUNCTION_2(transform_test_2d,transform_test<Vector<real,2>>)
+  GEODE_FUNCTION_2(transform_test_3d,transform_test<Vector<real,3>>)
 #endif
 }
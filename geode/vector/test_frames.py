@@ -63,6 +63,20 @@ def test_frame_3d():
     f.r.v = (8,0,0)
     assert all(f.r.v==(8,0,0))
 
+def test_soa():
+  random.seed(18313)
+  f = Frames(random.randn(3),Rotation.from_angle_axis(pi/5,(1,2,3)))
+  for n in 0,1,10000:
+    soa_test(random.randn(n,3),random.randn(n,3),f)
+
+def test_transform():
+  random.seed(18314)
+  f2 = Frames(random.randn(2),Rotation.from_angle(pi/5))
+  f3 = Frames(random.randn(3),Rotation.from_angle_axis(pi/5,(1,2,3)))
+  for n in 0,1,10000:
+    transform_test_2d(random.randn(n,2),f2)
+    transform_test_3d(random.randn(n,3),f3)
+
 if __name__=='__main__':
   test_frame_2d()
   test_frame_3d()
@@ -66,6 +66,11 @@ def test_sparse():
   assert all(abs(b-b2)<1e-6)
   b3=2*x-[x[1],x[0]+x[2],x[1]]
   assert all(abs(b2-b3)<1e-6)
+  for solve in M.gauss_seidel_solve,M.multicolor_gauss_seidel_solve:
+    y=zeros_like(b)
+    solve(y,b)
+    assert all(abs(y-x)<1e-6)
+  assert all(sort(M.row_colors().flat)==arange(3))
 
 def test_singular_values():
   from scipy.linalg import svdvals
@@ -76,5 +81,32 @@ def test_singular_values():
     for a,d in zip(A,D):
       assert allclose(svdvals(a),abs(d))
 
+def test_batch_decompositions():
+  random.seed(18181)
+  A = random.randn(37,3,3)
+  A[1] = 0
+  A[2,:,2] = A[2,:,0]+A[2,:,1]
+  A[3] = 2*eye(3)
+  A[4] = dot(diag([1e6,1,1e-6]),A[4])
+  U,D,V = batch_singular_value_decomposition(A)
+  for a,u,d,v in zip(A,U,D,V):
+    assert allclose(dot(u*d,v.T),a,atol=1e-6*abs(a).max())
+    for r in u,v:
+      assert allclose(dot(r.T,r),eye(3)) and allclose(linalg.det(r),1)
+    assert d[0]>=d[1]>=abs(d[2])
+  Q,S = batch_indefinite_polar_decomposition(A)
+  for a,q,s in zip(A,Q,S):
+    assert allclose(dot(q,s),a,atol=1e-6*abs(a).max())
+    assert allclose(s,s.T) and allclose(dot(q.T,q),eye(3))
+  D,V = batch_solve_eigenproblem(A)
+  for a,d,v in zip(A,D,V):
+    s = (a+a.T)/2
+    assert allclose(dot(v*d,v.T),s,atol=1e-10*abs(s).max())
+    assert allclose(d,sort(linalg.eigvalsh(s))[::-1],atol=1e-10*abs(s).max())
+
+def test_batch_blas():
+  random.seed(18182)
+  batch_blas_test(random.randn(100,3,3),random.randn(100,3,3),random.randn(100,3))
+
 if __name__=='__main__':
   test_conversions()
@@ -9,6 +9,15 @@ def test_basic():
   assert v.base is None
   assert all(v==(1,2,3))
   vector_stream_test()
+  # Tuples and lists of ints convert directly, and everything else still goes through numpy
+  assert all(vector_test([4,5,6])==(4,5,6))
+  assert all(vector_test(array((1,2,3),dtype=int32))==(1,2,3))
+  for bad in (1,2),(1,2,3,4):
+    try:
+      vector_test(bad)
+      assert False
+    except (TypeError,ValueError,OverflowError):
+      pass
 
 def test_misc():
   v=V(1,3,7)
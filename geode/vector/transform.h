@@ -0,0 +1,88 @@
+// Batch transforms of point arrays by matrices, rotations, and frames
+//
+// Each transform is converted to a matrix once, and the loop over points
+// is vectorized and run in parallel blocks.  On one thread this matches a
+// well inlined per-point loop, since interleaved coordinates must be
+// shuffled into vector registers; the gain is from threads.  Results can differ from
+// per-point f*x in the last bit, since Rotation<Vector<T,3>> applies its
+// quaternion directly.  Element types other than Vector<T,d> can be
+// transformed by overloading transform_point to expose their point; other
+// members are copied unchanged (see CircleArc in exact/circle_csg.h).
+#pragma once
+
+#include <geode/array/Nested.h>
+#include <geode/vector/Frame.h>
+#include <geode/vector/Matrix.h>
+#include <geode/utility/parallel.h>
+namespace geode {
+
+template<class T,int d> static inline Vector<T,d>& transform_point(Vector<T,d>& x) { return x; }
+template<class T,int d> static inline const Vector<T,d>& transform_point(const Vector<T,d>& x) { return x; }
+
+// Arguments are passed by value so that stores to y can't change them
+template<class E,class T,int d> static void affine_transform_block(const Matrix<T,d> A, const Vector<T,d> t,
+                                                                   const E* const x, E* const y, const int lo, const int hi) {
+  GEODE_IVDEP
+  for (int i=lo;i<hi;i++) {
+    // Load and store one coordinate at a time, since whole vector copies block vectorization
+    const auto& px = transform_point(x[i]);
+    T xi[d];
+    for (int b=0;b<d;b++)
+      xi[b] = px[b];
+    if (!is_same<E,Vector<T,d>>::value)
+      y[i] = x[i];
+    auto& py = transform_point(y[i]);
+    for (int a=0;a<d;a++) {
+      T s = 0;
+      for (int b=0;b<d;b++)
+        s += A(a,b)*xi[b];
+      py[a] = t[a]+s;
+    }
+  }
+}
+
+// Y[i] = A*X[i]+t.  Y may be X, but must not otherwise overlap it.
+template<class E,class T,int d> void affine_transform(const Matrix<T,d>& A, const Vector<T,d>& t,
+                                                      RawArray<const E> X, RawArray<E> Y) {
+  GEODE_ASSERT(X.size()==Y.size());
+  const int n = X.size(),
+            block = 1<<16;
+  const E* const x = X.data();
+  E* const y = Y.data();
+  if (n<=block)
+    affine_transform_block(A,t,x,y,0,n);
+  else
+    parallel_for((n+block-1)/block,[&](const int b) {
+      affine_transform_block(A,t,x,y,block*b,min(n,block*(b+1)));
+    });
+}
+
+// Y[i] = f*X[i].  Y may be X.
+template<class TV> void transform(const Frame<TV>& f, typename First<RawArray<const TV>>::type X,
+                                  typename First<RawArray<TV>>::type Y) {
+  affine_transform(f.r.matrix(),f.t,X,Y);
+}
+
+template<class TV> void transform(const Rotation<TV>& r, typename First<RawArray<const TV>>::type X,
+                                  typename First<RawArray<TV>>::type Y) {
+  affine_transform(r.matrix(),TV(),X,Y);
+}
+
+template<class TV> Array<TV> transformed(const Frame<TV>& f, typename First<RawArray<const TV>>::type X) {
+  Array<TV> Y(X.size(),uninit);
+  transform(f,X,Y);
+  return Y;
+}
+
+template<class TV> Array<TV> transformed(const Rotation<TV>& r, typename First<RawArray<const TV>>::type X) {
+  Array<TV> Y(X.size(),uninit);
+  transform(r,X,Y);
+  return Y;
+}
+
+// Transform each polygon of a nested array, sharing offsets with the input
+template<class TV> Nested<TV> transformed(const Frame<TV>& f, typename First<Nested<const TV>>::type X) {
+  return Nested<TV>(X.offsets,transformed(f,X.flat));
+}
+
+}